@@ -20,6 +20,8 @@
 #include <utils/Log.h>
 #include <utils/Errors.h>
 
+#include <algorithm>
+
 #include <binder/Parcel.h>
 #include <camera/CameraMetadata.h>
 #include <camera_metadata_hidden.h>
@@ -32,6 +34,69 @@ namespace android {
 typedef Parcel::WritableBlob WritableBlob;
 typedef Parcel::ReadableBlob ReadableBlob;
 
+CameraMetadataBufferPool::CameraMetadataBufferPool(size_t maxFreeBuffers) :
+        mMaxFreeBuffers(maxFreeBuffers) {
+}
+
+CameraMetadataBufferPool::~CameraMetadataBufferPool() {
+    for (auto buffer : mFreeBuffers) {
+        free_camera_metadata(buffer);
+    }
+}
+
+camera_metadata_t* CameraMetadataBufferPool::obtain(size_t entryCapacity, size_t dataCapacity) {
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        mEntryCapacity = std::max(mEntryCapacity, entryCapacity);
+        mDataCapacity = std::max(mDataCapacity, dataCapacity);
+        while (!mFreeBuffers.empty()) {
+            camera_metadata_t* buffer = mFreeBuffers.back();
+            mFreeBuffers.pop_back();
+            size_t bufferEntryCapacity = get_camera_metadata_entry_capacity(buffer);
+            size_t bufferDataCapacity = get_camera_metadata_data_capacity(buffer);
+            if (bufferEntryCapacity < entryCapacity || bufferDataCapacity < dataCapacity) {
+                // Outgrown by the typical size
+                free_camera_metadata(buffer);
+                continue;
+            }
+            mReuseCount++;
+            // Reset to an empty buffer with the same capacities
+            return place_camera_metadata(buffer,
+                    calculate_camera_metadata_size(bufferEntryCapacity, bufferDataCapacity),
+                    bufferEntryCapacity, bufferDataCapacity);
+        }
+        mAllocationCount++;
+        entryCapacity = mEntryCapacity;
+        dataCapacity = mDataCapacity;
+    }
+    return allocate_camera_metadata(entryCapacity, dataCapacity);
+}
+
+void CameraMetadataBufferPool::recycle(camera_metadata_t* buffer) {
+    if (buffer == NULL) return;
+
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        if (mFreeBuffers.size() < mMaxFreeBuffers &&
+                get_camera_metadata_entry_capacity(buffer) >= mEntryCapacity &&
+                get_camera_metadata_data_capacity(buffer) >= mDataCapacity) {
+            mFreeBuffers.push_back(buffer);
+            return;
+        }
+    }
+    free_camera_metadata(buffer);
+}
+
+size_t CameraMetadataBufferPool::getAllocationCount() const {
+    std::lock_guard<std::mutex> l(mLock);
+    return mAllocationCount;
+}
+
+size_t CameraMetadataBufferPool::getReuseCount() const {
+    std::lock_guard<std::mutex> l(mLock);
+    return mReuseCount;
+}
+
 CameraMetadata::CameraMetadata() :
         mBuffer(NULL), mLocked(false) {
 }
@@ -42,6 +107,16 @@ CameraMetadata::CameraMetadata(size_t entryCapacity, size_t dataCapacity) :
     mBuffer = allocate_camera_metadata(entryCapacity, dataCapacity);
 }
 
+CameraMetadata::CameraMetadata(const sp<CameraMetadataBufferPool>& pool, size_t entryCapacity,
+        size_t dataCapacity) :
+        mLocked(false), mPool(pool)
+{
+    mBuffer = allocateBuffer(entryCapacity, dataCapacity);
+    if (mBuffer == NULL) {
+        mPool.clear();
+    }
+}
+
 CameraMetadata::CameraMetadata(const CameraMetadata &other) :
         mLocked(false) {
     mBuffer = clone_camera_metadata(other.mBuffer);
@@ -110,6 +185,8 @@ camera_metadata_t* CameraMetadata::release() {
     }
     camera_metadata_t *released = mBuffer;
     mBuffer = NULL;
+    // Pool buffers are heap buffers, so the caller can free it.
+    mPool.clear();
     return released;
 }
 
@@ -119,9 +196,23 @@ void CameraMetadata::clear() {
         return;
     }
     if (mBuffer) {
-        free_camera_metadata(mBuffer);
+        freeBuffer(mBuffer);
         mBuffer = NULL;
     }
+    mPool.clear();
+}
+
+camera_metadata_t* CameraMetadata::allocateBuffer(size_t entryCapacity, size_t dataCapacity) {
+    return (mPool != nullptr) ? mPool->obtain(entryCapacity, dataCapacity) :
+            allocate_camera_metadata(entryCapacity, dataCapacity);
+}
+
+void CameraMetadata::freeBuffer(camera_metadata_t* buffer) {
+    if (mPool != nullptr) {
+        mPool->recycle(buffer);
+    } else {
+        free_camera_metadata(buffer);
+    }
 }
 
 void CameraMetadata::acquire(camera_metadata_t *buffer) {
@@ -142,7 +233,11 @@ void CameraMetadata::acquire(CameraMetadata &other) {
         ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
         return;
     }
+    sp<CameraMetadataBufferPool> pool = other.mPool;
     acquire(other.release());
+    if (mBuffer != NULL) {
+        mPool = pool;
+    }
 }
 
 status_t CameraMetadata::append(const CameraMetadata &other) {
@@ -525,8 +620,7 @@ status_t CameraMetadata::resizeIfNeeded(size_t extraEntries, size_t extraData) {
         if (newEntryCount > currentEntryCap ||
                 newDataCount > currentDataCap) {
             camera_metadata_t *oldBuffer = mBuffer;
-            mBuffer = allocate_camera_metadata(newEntryCount,
-                    newDataCount);
+            mBuffer = allocateBuffer(newEntryCount, newDataCount);
             if (mBuffer == NULL) {
                 // Maintain old buffer to avoid potential memory leak.
                 mBuffer = oldBuffer;
@@ -534,7 +628,7 @@ status_t CameraMetadata::resizeIfNeeded(size_t extraEntries, size_t extraData) {
                 return NO_MEMORY;
             }
             append_camera_metadata(mBuffer, oldBuffer);
-            free_camera_metadata(oldBuffer);
+            freeBuffer(oldBuffer);
         }
     }
     return OK;
@@ -784,6 +878,9 @@ void CameraMetadata::swap(CameraMetadata& other) {
 
     other.mBuffer = thisBuf;
     mBuffer = otherBuf;
+    sp<CameraMetadataBufferPool> thisPool = mPool;
+    mPool = other.mPool;
+    other.mPool = thisPool;
 }
 
 status_t CameraMetadata::getTagFromName(const char *name,
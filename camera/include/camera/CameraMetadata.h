@@ -19,6 +19,10 @@
 
 #include "system/camera_metadata.h"
 
+#include <mutex>
+#include <vector>
+
+#include <utils/RefBase.h>
 #include <utils/String8.h>
 #include <utils/Vector.h>
 #include <binder/Parcelable.h>
@@ -28,6 +32,48 @@ namespace android {
 
 class VendorTagDescriptor;
 
+/**
+ * Recycles camera_metadata_t buffers, for metadata of about the same size allocated at a high
+ * rate, such as capture results. Buffers are sized to the largest capacities requested so
+ * far, so that after the first few results every buffer fits the typical result.
+ *
+ * Buffers from the pool are regular heap metadata buffers, and can still be freed with
+ * free_camera_metadata() instead of being recycled.
+ */
+class CameraMetadataBufferPool : public LightRefBase<CameraMetadataBufferPool> {
+  public:
+    explicit CameraMetadataBufferPool(size_t maxFreeBuffers = kDefaultMaxFreeBuffers);
+    ~CameraMetadataBufferPool();
+
+    /**
+     * Get an empty metadata buffer with at least the given entry and data capacities.
+     * Returns NULL if the allocation fails.
+     */
+    camera_metadata_t* obtain(size_t entryCapacity, size_t dataCapacity);
+
+    /**
+     * Give a buffer back to the pool. It is freed if the pool is full, or if it's smaller
+     * than the typical size.
+     */
+    void recycle(camera_metadata_t* buffer);
+
+    size_t getAllocationCount() const;
+    size_t getReuseCount() const;
+
+  private:
+    static const size_t kDefaultMaxFreeBuffers = 8;
+
+    const size_t mMaxFreeBuffers;
+
+    mutable std::mutex mLock;
+    std::vector<camera_metadata_t*> mFreeBuffers;
+    // Largest capacities requested so far
+    size_t mEntryCapacity = 0;
+    size_t mDataCapacity = 0;
+    size_t mAllocationCount = 0;
+    size_t mReuseCount = 0;
+};
+
 /**
  * A convenience wrapper around the C-based camera_metadata_t library.
  */
@@ -40,6 +86,15 @@ class CameraMetadata: public Parcelable {
      * dataCapacity extra storage */
     CameraMetadata(size_t entryCapacity, size_t dataCapacity = 10);
 
+    /**
+     * Creates an object with space for entryCapacity entries, with dataCapacity
+     * extra storage, using a buffer from the pool. The buffer goes back to the pool
+     * when the object is cleared or destroyed, including when it grew past the
+     * initial capacities. Copies of the object don't use the pool.
+     */
+    CameraMetadata(const sp<CameraMetadataBufferPool>& pool, size_t entryCapacity,
+            size_t dataCapacity);
+
     /**
      * Move constructor, acquires other's metadata buffer
      */
@@ -250,6 +305,18 @@ class CameraMetadata: public Parcelable {
   private:
     camera_metadata_t *mBuffer;
     mutable bool       mLocked;
+    // Pool mBuffer came from, if any
+    sp<CameraMetadataBufferPool> mPool;
+
+    /**
+     * Allocate a buffer from mPool if set, or from the heap
+     */
+    camera_metadata_t* allocateBuffer(size_t entryCapacity, size_t dataCapacity);
+
+    /**
+     * Free a buffer of this object, giving it back to mPool if set
+     */
+    void freeBuffer(camera_metadata_t* buffer);
 
     /**
      * Check if tag has a given type
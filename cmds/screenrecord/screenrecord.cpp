@@ -200,6 +200,10 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
     format->setFloat(KEY_FRAME_RATE, displayFps);
     format->setInt32(KEY_I_FRAME_INTERVAL, 10);
     format->setInt32(KEY_MAX_B_FRAMES, gBframes);
+    // Ask for real time priority at the display rate, so the encoder keeps up
+    // with high refresh rate displays.
+    format->setInt32(KEY_PRIORITY, 0);
+    format->setFloat(KEY_OPERATING_RATE, displayFps);
     if (gBframes > 0) {
         format->setInt32(KEY_PROFILE, AVCProfileMain);
         format->setInt32(KEY_LEVEL, AVCLevel41);
@@ -488,8 +492,11 @@ static status_t writeWinscopeMetadata(const Vector<std::int64_t>& timestampsMono
  */
 static status_t runEncoder(const sp<MediaCodec>& encoder,
         AMediaMuxer *muxer, FILE* rawFp, const sp<IBinder>& display,
-        const sp<IBinder>& virtualDpy, ui::Rotation orientation) {
+        const sp<IBinder>& virtualDpy, ui::Rotation orientation, float displayFps) {
     static int kTimeout = 250000;   // be responsive on signal
+    // getDisplayState() is a binder call; at high refresh rates, calling it
+    // for every frame slows down draining the encoder.
+    static const nsecs_t kOrientationPollNsec = milliseconds_to_nanoseconds(100);
     status_t err;
     ssize_t trackIdx = -1;
     ssize_t metaLegacyTrackIdx = -1;
@@ -499,6 +506,16 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
     int64_t endWhenNsec = startWhenNsec + seconds_to_nanoseconds(gTimeLimitSec);
     Vector<int64_t> timestampsMonotonicUs;
     bool firstFrame = true;
+    nsecs_t lastOrientationPollNsec = 0;
+
+    // Frame latency is from the virtual display timestamp to the encoded
+    // output.  Frames later than two refresh periods are likely to have
+    // caused the virtual display to drop frames behind them.
+    const int64_t lateFrameUs = displayFps > 0 ? 2000000 / displayFps : 0;
+    uint32_t latencyFrames = 0;
+    uint32_t lateFrames = 0;
+    int64_t totalLatencyUs = 0;
+    int64_t maxLatencyUs = 0;
 
     assert((rawFp == NULL && muxer != NULL) || (rawFp != NULL && muxer == NULL));
 
@@ -547,8 +564,20 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
                 ALOGV("Got data in buffer %zu, size=%zu, pts=%" PRId64,
                         bufIndex, size, ptsUsec);
 
-                { // scope
+                nsecs_t nowNsec = systemTime(CLOCK_MONOTONIC);
+                if (ptsUsec != 0) {
+                    int64_t latencyUs = nanoseconds_to_microseconds(nowNsec) - ptsUsec;
+                    latencyFrames++;
+                    totalLatencyUs += latencyUs;
+                    maxLatencyUs = std::max(maxLatencyUs, latencyUs);
+                    if (lateFrameUs > 0 && latencyUs > lateFrameUs) {
+                        lateFrames++;
+                    }
+                }
+
+                if (nowNsec - lastOrientationPollNsec >= kOrientationPollNsec) {
                     ATRACE_NAME("orientation");
+                    lastOrientationPollNsec = nowNsec;
                     // Check orientation, update if it has changed.
                     //
                     // Polling for changes is inefficient and wrong, but the
@@ -678,6 +707,12 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
         printf("Encoder stopping; recorded %u frames in %" PRId64 " seconds\n",
                 debugNumFrames, nanoseconds_to_seconds(
                         systemTime(CLOCK_MONOTONIC) - startWhenNsec));
+        if (latencyFrames > 0) {
+            printf("Frame latency avg %" PRId64 " us, max %" PRId64 " us; "
+                    "%u of %u frames later than %" PRId64 " us\n",
+                    totalLatencyUs / latencyFrames, maxLatencyUs,
+                    lateFrames, latencyFrames, lateFrameUs);
+        }
         fflush(stdout);
     }
     if (metaLegacyTrackIdx >= 0 && metaTrackIdx >= 0 && !timestampsMonotonicUs.isEmpty()) {
@@ -854,8 +889,13 @@ static status_t recordScreen(const char* fileName) {
             fflush(stdout);
         }
     } else {
-        // Use the encoder's input surface as the virtual display surface.
+        // Use the encoder's input surface as the virtual display surface, so
+        // frames go from SurfaceFlinger to the encoder without a GLES pass.
         bufferProducer = encoderInputSurface;
+        if (gVerbose) {
+            printf("Virtual display feeds the encoder directly\n");
+            fflush(stdout);
+        }
     }
 
     // Configure virtual display.
@@ -943,7 +983,8 @@ static status_t recordScreen(const char* fileName) {
         }
     } else {
         // Main encoder loop.
-        err = runEncoder(encoder, muxer, rawFp, display, dpy, displayState.orientation);
+        err = runEncoder(encoder, muxer, rawFp, display, dpy, displayState.orientation,
+                displayMode.refreshRate);
         if (err != NO_ERROR) {
             fprintf(stderr, "Encoder failed (err=%d)\n", err);
             // fall through to cleanup
@@ -22,6 +22,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 //#define LOG_NDEBUG 0
 #define LOG_TAG "stagefright"
 #include <media/stagefright/foundation/ADebug.h>
@@ -422,6 +426,187 @@ static void playSource(sp<MediaSource> &source) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Concurrent decode mode: several decoders run the same track on their own
+// threads for a fixed duration, to measure the capacity of a codec.
+
+struct DecodeInstance {
+    sp<MediaSource> mDecoder;
+    int64_t mFrames = 0;
+    int64_t mSumDecodeUs = 0;
+    int64_t mMaxDecodeUs = 0;
+    int64_t mLateFrames = 0;
+    int64_t mElapsedUs = 0;
+    status_t mStatus = OK;
+};
+
+static sp<MediaSource> createTrackSource(const char *filename, bool audioOnly) {
+    sp<DataSource> dataSource =
+        DataSourceFactory::getInstance()->CreateFromURI(NULL /* httpService */, filename);
+    if (dataSource == NULL) {
+        return NULL;
+    }
+
+    sp<IMediaExtractor> extractor = MediaExtractorFactory::Create(dataSource);
+    if (extractor == NULL) {
+        return NULL;
+    }
+
+    const char *prefix = audioOnly ? "audio/" : "video/";
+    for (size_t i = 0; i < extractor->countTracks(); ++i) {
+        sp<MetaData> meta = extractor->getTrackMetaData(i);
+        const char *mime;
+        if (meta != NULL && meta->findCString(kKeyMIMEType, &mime)
+                && !strncasecmp(mime, prefix, 6)) {
+            return CreateMediaSourceFromIMediaSource(extractor->getTrack(i));
+        }
+    }
+    return NULL;
+}
+
+// Decodes until |deadlineUs|, looping back to the start of the track at the
+// end of stream. A frame is late if it took longer to decode than the frame
+// interval of the content, so that it would have been dropped in playback.
+static void runDecodeInstance(DecodeInstance *instance, int64_t deadlineUs,
+        int64_t frameIntervalUs) {
+    int64_t startUs = getNowUs();
+    MediaSource::ReadOptions options;
+    bool sawFrame = false;
+
+    while (getNowUs() < deadlineUs) {
+        MediaBufferBase *buffer;
+        int64_t startDecodeUs = getNowUs();
+        status_t err = instance->mDecoder->read(&buffer, &options);
+        int64_t delayDecodeUs = getNowUs() - startDecodeUs;
+        options.clearSeekTo();
+
+        if (err == INFO_FORMAT_CHANGED) {
+            continue;
+        } else if (err == ERROR_END_OF_STREAM && sawFrame) {
+            options.setSeekTo(0);
+            sawFrame = false;
+            continue;
+        } else if (err != OK) {
+            instance->mStatus = err;
+            break;
+        }
+
+        if (buffer->range_length() > 0) {
+            sawFrame = true;
+            ++instance->mFrames;
+            instance->mSumDecodeUs += delayDecodeUs;
+            instance->mMaxDecodeUs = std::max(instance->mMaxDecodeUs, delayDecodeUs);
+            if (delayDecodeUs > frameIntervalUs) {
+                ++instance->mLateFrames;
+            }
+        }
+        buffer->release();
+    }
+
+    instance->mElapsedUs = getNowUs() - startUs;
+}
+
+static void stopDecoders(std::vector<DecodeInstance> &instances, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        instances[i].mDecoder->stop();
+    }
+}
+
+static status_t decodeConcurrently(const char *filename, bool audioOnly, bool useSurface,
+        size_t numInstances, int64_t durationUs) {
+    int flags = 0;
+    if (gPreferSoftwareCodec) {
+        flags |= MediaCodecList::kPreferSoftwareCodecs;
+    }
+    if (gForceToUseHardwareCodec) {
+        CHECK(!gPreferSoftwareCodec);
+        flags |= MediaCodecList::kHardwareCodecsOnly;
+    }
+
+    std::vector<DecodeInstance> instances(numInstances);
+    std::vector<sp<GLConsumer>> textures;
+    int32_t frameRate = 30;
+    for (size_t i = 0; i < numInstances; ++i) {
+        sp<MediaSource> source = createTrackSource(filename, audioOnly);
+        if (source == NULL) {
+            fprintf(stderr, "Unable to create a %s source for instance %zu.\n",
+                    audioOnly ? "audio" : "video", i);
+            stopDecoders(instances, i);
+            return UNKNOWN_ERROR;
+        }
+        source->getFormat()->findInt32(kKeyFrameRate, &frameRate);
+
+        // Each decoder needs its own surface, consumed the same way as -T.
+        sp<Surface> surface;
+        if (useSurface && !audioOnly) {
+            sp<IGraphicBufferProducer> producer;
+            sp<IGraphicBufferConsumer> consumer;
+            BufferQueue::createBufferQueue(&producer, &consumer);
+            textures.push_back(new GLConsumer(consumer, 0 /* tex */,
+                    GLConsumer::TEXTURE_EXTERNAL, true /* useFenceSync */,
+                    false /* isControlledByApp */));
+            surface = new Surface(producer);
+        }
+
+        instances[i].mDecoder = SimpleDecodingSource::Create(
+                source, flags, surface,
+                gComponentNameOverride.isEmpty() ? nullptr : gComponentNameOverride.c_str(),
+                !gComponentNameOverride.isEmpty());
+        if (instances[i].mDecoder == NULL) {
+            fprintf(stderr, "Unable to create decoder instance %zu.\n", i);
+            stopDecoders(instances, i);
+            return UNKNOWN_ERROR;
+        }
+        status_t err = instances[i].mDecoder->start();
+        if (err != OK) {
+            fprintf(stderr, "Decoder instance %zu failed to start: %d\n", i, err);
+            stopDecoders(instances, i);
+            return err;
+        }
+    }
+
+    int64_t frameIntervalUs = 1000000ll / std::max(frameRate, 1);
+    int64_t deadlineUs = getNowUs() + durationUs;
+    std::vector<std::thread> threads;
+    for (DecodeInstance &instance : instances) {
+        threads.emplace_back(runDecodeInstance, &instance, deadlineUs, frameIntervalUs);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    stopDecoders(instances, numInstances);
+
+    status_t status = OK;
+    double totalFps = 0;
+    int64_t totalFrames = 0;
+    int64_t totalLateFrames = 0;
+    for (size_t i = 0; i < numInstances; ++i) {
+        DecodeInstance &instance = instances[i];
+
+        double fps = instance.mElapsedUs > 0 ? instance.mFrames * 1E6 / instance.mElapsedUs : 0;
+        printf("instance %zu: %.2f fps, decode avg. %.2f max %" PRId64 " usecs, "
+               "%" PRId64 " of %" PRId64 " frame(s) late",
+               i, fps, instance.mFrames > 0 ? (double)instance.mSumDecodeUs / instance.mFrames : 0,
+               instance.mMaxDecodeUs, instance.mLateFrames, instance.mFrames);
+        if (instance.mStatus != OK) {
+            printf(", stopped with error %d", instance.mStatus);
+            status = instance.mStatus;
+        }
+        printf("\n");
+
+        totalFps += fps;
+        totalFrames += instance.mFrames;
+        totalLateFrames += instance.mLateFrames;
+    }
+    printf("%zu instance(s): aggregate %.2f fps, %" PRId64 " of %" PRId64 " frame(s) late "
+           "(frame interval %" PRId64 " usecs)\n",
+           numInstances, totalFps, totalLateFrames, totalFrames, frameIntervalUs);
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct DetectSyncSource : public MediaSource {
     explicit DetectSyncSource(const sp<MediaSource> &source);
 
@@ -652,6 +837,10 @@ static void usage(const char *me) {
     fprintf(stderr, "       -d(ump) output_filename (raw stream data to a file)\n");
     fprintf(stderr, "       -D(ump) output_filename (decoded PCM data to a file)\n");
     fprintf(stderr, "       -v be more verbose\n");
+    fprintf(stderr, "       -c instances: decode with this many concurrent decoders and\n"
+                    "          report per-instance and aggregate throughput; -N, -s, -r\n"
+                    "          select the codec, and -S or -T give each decoder a surface\n");
+    fprintf(stderr, "       -u seconds to run the concurrent decoders (default 10)\n");
 }
 
 static void dumpCodecDetails(bool queryDecoders) {
@@ -796,6 +985,8 @@ int main(int argc, char **argv) {
     bool dumpStream = false;
     bool dumpPCMStream = false;
     int32_t pixelFormat = 0;        // thumbnail pixel format
+    long numInstances = 0;          // concurrent decode mode if > 0
+    long durationSecs = 10;         // duration of concurrent decode mode
     String8 dumpStreamFilename;
     gNumRepetitions = 1;
     gMaxNumFrames = 0;
@@ -809,7 +1000,7 @@ int main(int argc, char **argv) {
     sp<android::ALooper> looper;
 
     int res;
-    while ((res = getopt(argc, argv, "vhaqn:lm:b:itsrow:kN:xSTd:D:P:")) >= 0) {
+    while ((res = getopt(argc, argv, "vhaqn:lm:b:itsrow:kN:xSTd:D:P:c:u:")) >= 0) {
         switch (res) {
             case 'a':
             {
@@ -854,6 +1045,8 @@ int main(int argc, char **argv) {
             case 'm':
             case 'n':
             case 'b':
+            case 'c':
+            case 'u':
             {
                 char *end;
                 long x = strtol(optarg, &end, 10);
@@ -868,6 +1061,10 @@ int main(int argc, char **argv) {
                     gMaxNumFrames = x;
                 } else if (res == 'P') {
                     pixelFormat = x;
+                } else if (res == 'c') {
+                    numInstances = x;
+                } else if (res == 'u') {
+                    durationSecs = x;
                 } else {
                     CHECK_EQ(res, 'b');
                     gReproduceBug = x;
@@ -1143,6 +1340,13 @@ int main(int argc, char **argv) {
 
         const char *filename = argv[k];
 
+        if (numInstances > 0) {
+            err = decodeConcurrently(filename, audioOnly,
+                    useSurfaceAlloc || useSurfaceTexAlloc, numInstances,
+                    durationSecs * 1000000ll);
+            continue;
+        }
+
         sp<DataSource> dataSource =
             DataSourceFactory::getInstance()->CreateFromURI(NULL /* httpService */, filename);
 
@@ -253,6 +253,8 @@ status_t ClearKeyCasPlugin::provision(const String8 &str) {
 
     ALOGV("provision: using ClearKeyFetcher");
     mKeyFetcher = std::move(key_fetcher);
+    // keys obtained through the previous fetcher may no longer apply.
+    ClearKeySessionLibrary::get()->clearEcmKeys(this);
 
     return OK;
 }
@@ -370,6 +372,15 @@ status_t ClearKeyCasSession::updateECM(
     mEcmBuffer = ABuffer::CreateAsCopy(ecm, size);
     mEcmBuffer->setRange(kEcmHeaderLength, size - kEcmHeaderLength);
 
+    KeyInfo cachedKeyInfo[kNumKeys];
+    size_t numCachedKeys;
+    if (ClearKeySessionLibrary::get()->findEcmKeys(
+            mPlugin, ecm, size, cachedKeyInfo, &numCachedKeys)) {
+        ALOGV("updateECM: %zu cached key(s) found", numCachedKeys);
+        std::copy(cachedKeyInfo, cachedKeyInfo + numCachedKeys, mKeyInfo);
+        return OK;
+    }
+
     uint64_t asset_id;
     std::vector<KeyFetcher::KeyInfo> keys;
     status_t err = keyFetcher->ObtainKey(mEcmBuffer, &asset_id, &keys);
@@ -394,6 +405,8 @@ status_t ClearKeyCasSession::updateECM(
                     keyIndex, keys[keyIndex].key_id);
         }
     }
+    ClearKeySessionLibrary::get()->addEcmKeys(
+            mPlugin, ecm, size, mKeyInfo, std::min(keys.size(), (size_t)kNumKeys));
     return OK;
 }
 
@@ -427,29 +440,77 @@ ssize_t ClearKeyCasSession::decrypt(
     uint8_t *dst = (uint8_t*)dstPtr;
 
     for (size_t i = 0; i < numSubSamples; i++) {
+        decryptSubSample(
+                scramblingControl != DescramblerPlugin::kScrambling_Unscrambled
+                        ? &contentKey : NULL,
+                subSamples[i], src, dst);
         size_t numBytesinSubSample = subSamples[i].mNumBytesOfClearData
                 + subSamples[i].mNumBytesOfEncryptedData;
-        if (src != dst) {
-            memcpy(dst, src, numBytesinSubSample);
-        }
-        status_t err = OK;
-        // Don't decrypt if len < AES_BLOCK_SIZE.
-        // The last chunk shorter than AES_BLOCK_SIZE is not encrypted.
-        if (scramblingControl != DescramblerPlugin::kScrambling_Unscrambled
-                && subSamples[i].mNumBytesOfEncryptedData >= AES_BLOCK_SIZE) {
-            err = decryptPayload(
-                    contentKey,
-                    numBytesinSubSample,
-                    subSamples[i].mNumBytesOfClearData,
-                    (char *)dst);
-        }
+        dst += numBytesinSubSample;
+        src += numBytesinSubSample;
+    }
+    return dst - (uint8_t *)dstPtr;
+}
 
+// Decryption of a run of packets, looking up the keys once for all of them
+ssize_t ClearKeyCasSession::decryptBatch(
+        bool secure, size_t numPackets,
+        const DescramblerPlugin::ScramblingControl *scramblingControls,
+        const DescramblerPlugin::SubSample *subSamples,
+        const void *srcPtr, void *dstPtr, AString * /* errorDetailMsg */) {
+    if (secure) {
+        return ERROR_CAS_CANNOT_HANDLE;
+    }
+
+    KeyInfo keyInfo[kNumKeys];
+    {
+        Mutex::Autolock _lock(mKeyLock);
+        std::copy(mKeyInfo, mKeyInfo + kNumKeys, keyInfo);
+    }
+
+    uint8_t *src = (uint8_t*)srcPtr;
+    uint8_t *dst = (uint8_t*)dstPtr;
+
+    for (size_t i = 0; i < numPackets; i++) {
+        int32_t scramblingControl =
+                scramblingControls[i] & DescramblerPlugin::kScrambling_Mask_Key;
+        const AES_KEY *contentKey = NULL;
+        if (scramblingControl != DescramblerPlugin::kScrambling_Unscrambled) {
+            int32_t keyIndex = (scramblingControl & 1);
+            if (!keyInfo[keyIndex].valid) {
+                ALOGE("decryptBatch: key %d is invalid for packet %zu", keyIndex, i);
+                return ERROR_CAS_DECRYPT;
+            }
+            contentKey = &keyInfo[keyIndex].contentKey;
+        }
+        decryptSubSample(contentKey, subSamples[i], src, dst);
+        size_t numBytesinSubSample = subSamples[i].mNumBytesOfClearData
+                + subSamples[i].mNumBytesOfEncryptedData;
         dst += numBytesinSubSample;
         src += numBytesinSubSample;
     }
     return dst - (uint8_t *)dstPtr;
 }
 
+void ClearKeyCasSession::decryptSubSample(
+        const AES_KEY *contentKey, const DescramblerPlugin::SubSample &subSample,
+        const uint8_t *src, uint8_t *dst) const {
+    size_t numBytesinSubSample = subSample.mNumBytesOfClearData
+            + subSample.mNumBytesOfEncryptedData;
+    if (src != dst) {
+        memcpy(dst, src, numBytesinSubSample);
+    }
+    // Don't decrypt if len < AES_BLOCK_SIZE.
+    // The last chunk shorter than AES_BLOCK_SIZE is not encrypted.
+    if (contentKey != NULL && subSample.mNumBytesOfEncryptedData >= AES_BLOCK_SIZE) {
+        decryptPayload(
+                *contentKey,
+                numBytesinSubSample,
+                subSample.mNumBytesOfClearData,
+                (char *)dst);
+    }
+}
+
 // Decryption of a TS payload
 status_t ClearKeyCasSession::decryptPayload(
         const AES_KEY& key, size_t length, size_t offset, char* buffer) const {
@@ -521,6 +582,35 @@ ssize_t ClearKeyDescramblerPlugin::descramble(
             errorDetailMsg);
 }
 
+ssize_t ClearKeyDescramblerPlugin::descrambleBatch(
+        bool secure,
+        size_t numPackets,
+        const ScramblingControl *scramblingControls,
+        const SubSample *subSamples,
+        const void *srcPtr,
+        int32_t srcOffset,
+        void *dstPtr,
+        int32_t dstOffset,
+        AString *errorDetailMsg) {
+
+    ALOGV("descrambleBatch: secure=%d, packets=%zu, "
+            "srcPtr=%p, dstPtr=%p, srcOffset=%d, dstOffset=%d",
+          (int)secure, numPackets, srcPtr, dstPtr, srcOffset, dstOffset);
+
+    std::shared_ptr<ClearKeyCasSession> session = std::atomic_load(&mCASSession);
+
+    if (session.get() == nullptr) {
+        ALOGE("Uninitialized CAS session!");
+        return ERROR_CAS_DECRYPT_UNIT_NOT_INITIALIZED;
+    }
+
+    return session->decryptBatch(
+            secure, numPackets, scramblingControls, subSamples,
+            (uint8_t*)srcPtr + srcOffset,
+            dstPtr == NULL ? NULL : ((uint8_t*)dstPtr + dstOffset),
+            errorDetailMsg);
+}
+
 // Conversion utilities
 String8 ClearKeyDescramblerPlugin::arrayToString(
         uint8_t const *array, size_t len) const
@@ -137,6 +137,19 @@ public:
             int32_t dstOffset,
             AString *errorDetailMsg) override;
 
+    // Descrambles a run of |numPackets| consecutive packets, each described
+    // by one subsample with its own scrambling control, in a single call.
+    ssize_t descrambleBatch(
+            bool secure,
+            size_t numPackets,
+            const ScramblingControl *scramblingControls,
+            const SubSample *subSamples,
+            const void *srcPtr,
+            int32_t srcOffset,
+            void *dstPtr,
+            int32_t dstOffset,
+            AString *errorDetailMsg);
+
 private:
     std::shared_ptr<ClearKeyCasSession> mCASSession;
 
@@ -23,6 +23,8 @@
 
 #include "ClearKeySessionLibrary.h"
 
+#include <algorithm>
+
 namespace android {
 namespace clearkeycas {
 
@@ -101,6 +103,44 @@ void ClearKeySessionLibrary::destroyPlugin(CasPlugin *plugin) {
             mIDToSessionMap.removeItemsAt(index);
         }
     }
+    clearEcmKeys(plugin);
+}
+
+bool ClearKeySessionLibrary::findEcmKeys(
+        CasPlugin *plugin, const void *ecm, size_t size,
+        ClearKeyCasSession::KeyInfo *keyInfo, size_t *numKeys) {
+    Mutex::Autolock lock(mEcmKeysLock);
+
+    for (auto it = mEcmKeys.begin(); it != mEcmKeys.end(); ++it) {
+        if (it->plugin == plugin && it->ecm.size() == size
+                && !memcmp(it->ecm.data(), ecm, size)) {
+            std::copy(it->keyInfo, it->keyInfo + it->numKeys, keyInfo);
+            *numKeys = it->numKeys;
+            mEcmKeys.splice(mEcmKeys.begin(), mEcmKeys, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClearKeySessionLibrary::addEcmKeys(
+        CasPlugin *plugin, const void *ecm, size_t size,
+        const ClearKeyCasSession::KeyInfo *keyInfo, size_t numKeys) {
+    CHECK(numKeys <= ClearKeyCasSession::kNumKeys);
+    Mutex::Autolock lock(mEcmKeysLock);
+
+    const uint8_t *ecmBytes = (const uint8_t *)ecm;
+    mEcmKeys.push_front({plugin, std::vector<uint8_t>(ecmBytes, ecmBytes + size), {}, numKeys});
+    std::copy(keyInfo, keyInfo + numKeys, mEcmKeys.front().keyInfo);
+    if (mEcmKeys.size() > kMaxCachedEcms) {
+        mEcmKeys.pop_back();
+    }
+}
+
+void ClearKeySessionLibrary::clearEcmKeys(CasPlugin *plugin) {
+    Mutex::Autolock lock(mEcmKeysLock);
+
+    mEcmKeys.remove_if([plugin](const EcmKeys &entry) { return entry.plugin == plugin; });
 }
 
 } // namespace clearkeycas
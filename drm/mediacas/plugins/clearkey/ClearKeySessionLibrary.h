@@ -23,6 +23,9 @@
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 
+#include <list>
+#include <vector>
+
 namespace android {
 struct ABuffer;
 
@@ -44,6 +47,17 @@ public:
             void *dstPtr,
             AString * /* errorDetailMsg */);
 
+    // Decryption of a run of packets with one subsample each, which may
+    // each use a different key.
+    ssize_t decryptBatch(
+            bool secure,
+            size_t numPackets,
+            const DescramblerPlugin::ScramblingControl *scramblingControls,
+            const DescramblerPlugin::SubSample *subSamples,
+            const void *srcPtr,
+            void *dstPtr,
+            AString * /* errorDetailMsg */);
+
     status_t updateECM(KeyFetcher *keyFetcher, void *ecm, size_t size);
 
 private:
@@ -64,6 +78,9 @@ private:
     CasPlugin* getPlugin() const { return mPlugin; }
     status_t decryptPayload(
             const AES_KEY& key, size_t length, size_t offset, char* buffer) const;
+    void decryptSubSample(
+            const AES_KEY *contentKey, const DescramblerPlugin::SubSample &subSample,
+            const uint8_t *src, uint8_t *dst) const;
 
     DISALLOW_EVIL_CONSTRUCTORS(ClearKeyCasSession);
 };
@@ -80,7 +97,26 @@ public:
 
     void destroyPlugin(CasPlugin *plugin);
 
+    // Keys derived from an ECM by the key fetcher of |plugin|, so that a
+    // session seeing an ECM again (e.g. on a crypto period change back to a
+    // previous key, or after a seek) doesn't need to fetch its keys again.
+    bool findEcmKeys(CasPlugin *plugin, const void *ecm, size_t size,
+            ClearKeyCasSession::KeyInfo *keyInfo, size_t *numKeys);
+    void addEcmKeys(CasPlugin *plugin, const void *ecm, size_t size,
+            const ClearKeyCasSession::KeyInfo *keyInfo, size_t numKeys);
+    void clearEcmKeys(CasPlugin *plugin);
+
 private:
+    enum {
+        kMaxCachedEcms = 8,
+    };
+    struct EcmKeys {
+        CasPlugin *plugin;
+        std::vector<uint8_t> ecm;
+        ClearKeyCasSession::KeyInfo keyInfo[ClearKeyCasSession::kNumKeys];
+        size_t numKeys;
+    };
+
     static Mutex sSingletonLock;
     static ClearKeySessionLibrary* sSingleton;
 
@@ -88,6 +124,9 @@ private:
     uint32_t mNextSessionId;
     KeyedVector<CasSessionId, std::shared_ptr<ClearKeyCasSession>> mIDToSessionMap;
 
+    Mutex mEcmKeysLock;
+    std::list<EcmKeys> mEcmKeys; // most recently used first
+
     ClearKeySessionLibrary();
     DISALLOW_EVIL_CONSTRUCTORS(ClearKeySessionLibrary);
 };
@@ -17,15 +17,13 @@
 
 #include <utils/Log.h>
 
-#include <openssl/aes.h>
+#include <openssl/cipher.h>
 
 #include "AesCtrDecryptor.h"
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
 
-static const size_t kBlockBitCount = kBlockSize * 8;
-
 CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const Iv iv,
                                          const uint8_t* source, uint8_t* destination,
                                          const std::vector<int32_t>& clearDataLengths,
@@ -37,16 +35,23 @@ CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const
         return clearkeydrm::ERROR_DECRYPT;
     }
 
-    uint32_t blockOffset = 0;
-    uint8_t previousEncryptedCounter[kBlockSize];
-    memset(previousEncryptedCounter, 0, kBlockSize);
+    // The EVP cipher uses the AES instructions of the CPU when available. Re-keying is only
+    // needed when the key changes, otherwise setting the IV resets the counter.
+    if (key != mKey) {
+        mKey.clear();
+        if (!EVP_EncryptInit_ex(mContext.get(), EVP_aes_128_ctr(), nullptr, key.data(), iv)) {
+            ALOGE("Failed to initialize the cipher");
+            return clearkeydrm::ERROR_DECRYPT;
+        }
+        mKey = key;
+    } else if (!EVP_EncryptInit_ex(mContext.get(), nullptr, nullptr, nullptr, iv)) {
+        ALOGE("Failed to set the IV");
+        return clearkeydrm::ERROR_DECRYPT;
+    }
 
+    // The counter and the position in the current block carry over from one subsample
+    // to the next, as the encrypted parts form a single CTR stream.
     size_t offset = 0;
-    AES_KEY opensslKey;
-    AES_set_encrypt_key(key.data(), kBlockBitCount, &opensslKey);
-    Iv opensslIv;
-    memcpy(opensslIv, iv, sizeof(opensslIv));
-
     for (size_t i = 0; i < clearDataLengths.size(); ++i) {
         int32_t numBytesOfClearData = clearDataLengths[i];
         if (numBytesOfClearData > 0) {
@@ -56,9 +61,14 @@ CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const
 
         int32_t numBytesOfEncryptedData = encryptedDataLengths[i];
         if (numBytesOfEncryptedData > 0) {
-            AES_ctr128_encrypt(source + offset, destination + offset,
-                               numBytesOfEncryptedData, &opensslKey, opensslIv,
-                               previousEncryptedCounter, &blockOffset);
+            int outLength = 0;
+            if (!EVP_EncryptUpdate(mContext.get(), destination + offset, &outLength,
+                                   source + offset, numBytesOfEncryptedData) ||
+                    outLength != numBytesOfEncryptedData) {
+                ALOGE("Failed to decrypt subsample %zu", i);
+                mKey.clear();
+                return clearkeydrm::ERROR_DECRYPT;
+            }
             offset += numBytesOfEncryptedData;
         }
     }
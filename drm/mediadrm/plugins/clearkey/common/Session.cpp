@@ -75,11 +75,10 @@ CdmResponseType Session::decrypt(const KeyId keyId, const Iv iv,
         return clearkeydrm::ERROR_NO_LICENSE;
     }
 
-    clearkeydrm::AesCtrDecryptor decryptor;
-    auto status = decryptor.decrypt(itr->second /*key*/, iv, srcPtr, destPtr,
-                                    clearDataLengths,
-                                    encryptedDataLengths,
-                                    bytesDecryptedOut);
+    auto status = mDecryptor.decrypt(itr->second /*key*/, iv, srcPtr, destPtr,
+                                     clearDataLengths,
+                                     encryptedDataLengths,
+                                     bytesDecryptedOut);
     return status;
 }
 
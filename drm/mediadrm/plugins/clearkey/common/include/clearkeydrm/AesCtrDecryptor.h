@@ -15,12 +15,20 @@
  */
 #pragma once
 
+#include <openssl/cipher.h>
+
 #include <cstdint>
+#include <vector>
 
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
 
+/**
+ * Decrypts AES-CTR subsamples. The cipher context is kept across calls and only re-keyed
+ * when the key changes, so a decryptor should live as long as the session using it.
+ * Not thread safe.
+ */
 class AesCtrDecryptor {
   public:
     AesCtrDecryptor() {}
@@ -33,6 +41,9 @@ class AesCtrDecryptor {
 
   private:
     CLEARKEY_DISALLOW_COPY_AND_ASSIGN(AesCtrDecryptor);
+
+    bssl::ScopedEVP_CIPHER_CTX mContext;
+    std::vector<uint8_t> mKey;  // key mContext is initialized with, empty if none.
 };
 
 }  // namespace clearkeydrm
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <clearkeydrm/AesCtrDecryptor.h>
+
+using namespace clearkeydrm;
+
+// A sample of |state.range(0)| bytes split in subsamples as for video: a few clear bytes of
+// NAL unit header, then encrypted data which is not a multiple of the block size.
+struct Sample {
+    explicit Sample(size_t size) : key(kBlockSize, 0x2b), source(size), destination(size) {
+        for (size_t i = 0; i < size; ++i) {
+            source[i] = i * 31;
+        }
+        const size_t kSubsampleSize = 4093;
+        for (size_t offset = 0; offset < size; offset += kSubsampleSize) {
+            const size_t subsampleSize = std::min(kSubsampleSize, size - offset);
+            const size_t clearSize = std::min<size_t>(5, subsampleSize);
+            clearDataLengths.push_back(clearSize);
+            encryptedDataLengths.push_back(subsampleSize - clearSize);
+        }
+    }
+
+    std::vector<uint8_t> key;
+    Iv iv = {};
+    std::vector<uint8_t> source;
+    std::vector<uint8_t> destination;
+    std::vector<int32_t> clearDataLengths;
+    std::vector<int32_t> encryptedDataLengths;
+};
+
+// A decryptor per sample, as when it was created for each decrypt call.
+static void BM_DecryptNewDecryptor(benchmark::State& state) {
+    Sample sample(state.range(0));
+    for (auto _ : state) {
+        AesCtrDecryptor decryptor;
+        size_t bytesDecrypted;
+        decryptor.decrypt(sample.key, sample.iv, sample.source.data(),
+                          sample.destination.data(), sample.clearDataLengths,
+                          sample.encryptedDataLengths, &bytesDecrypted);
+        benchmark::DoNotOptimize(sample.destination.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sample.source.size());
+}
+
+// The decryptor of a session, keeping its cipher context from sample to sample.
+static void BM_DecryptSessionDecryptor(benchmark::State& state) {
+    Sample sample(state.range(0));
+    AesCtrDecryptor decryptor;
+    for (auto _ : state) {
+        size_t bytesDecrypted;
+        decryptor.decrypt(sample.key, sample.iv, sample.source.data(),
+                          sample.destination.data(), sample.clearDataLengths,
+                          sample.encryptedDataLengths, &bytesDecrypted);
+        benchmark::DoNotOptimize(sample.destination.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sample.source.size());
+}
+
+// From audio frames up to 4K video key frames
+BENCHMARK(BM_DecryptNewDecryptor)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20);
+BENCHMARK(BM_DecryptSessionDecryptor)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
@@ -426,10 +426,32 @@ public:
 
     virtual void stop() { }; // called by client in AudioTrack::stop()
 
+    // Opt-in adaptive wait for blocking obtainBuffer().
+    // Instead of going straight to the futex when no frames are available, spin for up to
+    // a budget that follows the recently observed futex wait times, bounded by maxSpinNs.
+    // This avoids the futex sleep and wake round trip when the server is about to release
+    // frames, such as for low latency tracks. A maxSpinNs of 0, the default, disables spinning.
+    void        setAdaptiveSpin(int64_t maxSpinNs);
+    int64_t     getSpinBudgetNs() const { return mSpinBudgetNs; }
+    // Number of waits that ended while spinning, and that slept on the futex.
+    uint64_t    getSpinWakeCount() const { return mSpinWakeCount; }
+    uint64_t    getFutexWaitCount() const { return mFutexWaitCount; }
+
 private:
+    // Spin until the server sets CBLK_FUTEX_WAKE or the spin budget is used up.
+    // Returns true if the wake was observed while spinning.
+    bool        spinForWake();
+    // Adjust the spin budget after a wait that took waitNs.
+    void        updateSpinBudget(int64_t waitNs);
+
     // This is a copy of mCblk->mBufferSizeInFrames
     uint32_t   mBufferSizeInFrames;  // effective size of the buffer
 
+    int64_t    mMaxSpinNs = 0;       // upper bound of mSpinBudgetNs, 0 to disable spinning
+    int64_t    mSpinBudgetNs = 0;    // current spin time before sleeping on the futex
+    uint64_t   mSpinWakeCount = 0;
+    uint64_t   mFutexWaitCount = 0;
+
     Modulo<uint32_t> mEpoch;
 
     // The shared buffer contents referred to by the timestamp observer
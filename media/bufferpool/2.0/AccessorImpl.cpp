@@ -166,7 +166,7 @@ ResultStatus Accessor::Impl::connect(
     sp<Connection> newConnection = new Connection();
     ResultStatus status = ResultStatus::CRITICAL_ERROR;
     {
-        std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+        ScopedLock lock(mBufferPool);
         if (newConnection) {
             int32_t pid = getpid();
             ConnectionId id = (int64_t)pid << 32 | sSeqId | kSeqIdVndkBit;
@@ -195,7 +195,7 @@ ResultStatus Accessor::Impl::connect(
 }
 
 ResultStatus Accessor::Impl::close(ConnectionId connectionId) {
-    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    ScopedLock lock(mBufferPool);
     ALOGV("connection close %lld: %u", (long long)connectionId, mBufferPool.mInvalidation.mId);
     mBufferPool.processStatusMessages();
     mBufferPool.handleClose(connectionId);
@@ -211,7 +211,7 @@ ResultStatus Accessor::Impl::close(ConnectionId connectionId) {
 ResultStatus Accessor::Impl::allocate(
         ConnectionId connectionId, const std::vector<uint8_t>& params,
         BufferId *bufferId, const native_handle_t** handle) {
-    std::unique_lock<std::mutex> lock(mBufferPool.mMutex);
+    ScopedLock lock(mBufferPool);
     mBufferPool.processStatusMessages();
     ResultStatus status = ResultStatus::OK;
     if (!mBufferPool.getFreeBuffer(mAllocator, params, bufferId, handle)) {
@@ -238,7 +238,7 @@ ResultStatus Accessor::Impl::allocate(
 ResultStatus Accessor::Impl::fetch(
         ConnectionId connectionId, TransactionId transactionId,
         BufferId bufferId, const native_handle_t** handle) {
-    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    ScopedLock lock(mBufferPool);
     mBufferPool.processStatusMessages();
     auto found = mBufferPool.mTransactions.find(transactionId);
     if (found != mBufferPool.mTransactions.end() &&
@@ -263,13 +263,13 @@ ResultStatus Accessor::Impl::fetch(
 
 void Accessor::Impl::cleanUp(bool clearCache) {
     // transaction timeout, buffer cacheing TTL handling
-    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    ScopedLock lock(mBufferPool);
     mBufferPool.processStatusMessages();
     mBufferPool.cleanUp(clearCache);
 }
 
 void Accessor::Impl::flush() {
-    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    ScopedLock lock(mBufferPool);
     mBufferPool.processStatusMessages();
     mBufferPool.flush(shared_from_this());
 }
@@ -278,7 +278,7 @@ void Accessor::Impl::handleInvalidateAck() {
     std::map<ConnectionId, const sp<IObserver>> observers;
     uint32_t invalidationId;
     {
-        std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+        ScopedLock lock(mBufferPool);
         mBufferPool.processStatusMessages();
         mBufferPool.mInvalidation.onHandleAck(&observers, &invalidationId);
     }
@@ -302,6 +302,32 @@ bool Accessor::Impl::isValid() {
     return mBufferPool.isValid();
 }
 
+Accessor::Impl::ScopedLock::ScopedLock(BufferPool &pool)
+        : mPool(pool), mLock(pool.mMutex, std::defer_lock) {
+    lock();
+}
+
+Accessor::Impl::ScopedLock::~ScopedLock() {
+    if (mLock.owns_lock()) {
+        unlock();
+    }
+}
+
+void Accessor::Impl::ScopedLock::lock() {
+    if (!mLock.try_lock()) {
+        int64_t startUs = getTimestampNow();
+        mLock.lock();
+        mPool.mStats.onLockWaited(getTimestampNow() - startUs);
+    }
+}
+
+void Accessor::Impl::ScopedLock::unlock() {
+    std::vector<std::unique_ptr<InternalBuffer>> retired;
+    retired.swap(mPool.mRetiredBuffers);
+    mLock.unlock();
+    // retired buffers are destroyed here, without the lock.
+}
+
 Accessor::Impl::Impl::BufferPool::BufferPool()
     : mTimestampUs(getTimestampNow()),
       mLastCleanUpUs(mTimestampUs),
@@ -325,12 +351,16 @@ Accessor::Impl::Impl::BufferPool::~BufferPool() {
     ALOGD("Destruction - bufferpool2 %p "
           "cached: %zu/%zuM, %zu/%d%% in use; "
           "allocs: %zu, %d%% recycled; "
-          "transfers: %zu, %d%% unfetched",
+          "evictions: %zu; "
+          "transfers: %zu, %d%% unfetched; "
+          "lock waits: %zu, %lldus",
           this, mStats.mBuffersCached, mStats.mSizeCached >> 20,
           mStats.mBuffersInUse, percentage(mStats.mBuffersInUse, mStats.mBuffersCached),
           mStats.mTotalAllocations, percentage(mStats.mTotalRecycles, mStats.mTotalAllocations),
+          mStats.mTotalEvictions,
           mStats.mTotalTransfers,
-          percentage(mStats.mTotalTransfers - mStats.mTotalFetches, mStats.mTotalTransfers));
+          percentage(mStats.mTotalTransfers - mStats.mTotalFetches, mStats.mTotalTransfers),
+          mStats.mTotalLockWaits, (long long)mStats.mLockWaitUs);
 }
 
 void Accessor::Impl::BufferPool::Invalidation::onConnect(
@@ -465,7 +495,7 @@ bool Accessor::Impl::BufferPool::handleReleaseBuffer(
             } else {
                 mStats.onBufferUnused(iter->second->mAllocSize);
                 mStats.onBufferEvicted(iter->second->mAllocSize);
-                mBuffers.erase(iter);
+                retireBuffer(iter);
                 mInvalidation.onBufferInvalidated(bufferId, mInvalidationChannel);
             }
         }
@@ -554,7 +584,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
                 } else {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
                     mStats.onBufferEvicted(bufferIter->second->mAllocSize);
-                    mBuffers.erase(bufferIter);
+                    retireBuffer(bufferIter);
                     mInvalidation.onBufferInvalidated(message.bufferId, mInvalidationChannel);
                 }
             }
@@ -570,7 +600,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
 }
 
 void Accessor::Impl::BufferPool::processStatusMessages() {
-    std::vector<BufferStatusMessage> messages;
+    std::vector<BufferStatusMessage> &messages = mStatusMessages;
     mObserver.getBufferStatusChanges(messages);
     mTimestampUs = getTimestampNow();
     for (BufferStatusMessage& message: messages) {
@@ -633,7 +663,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
-                        mBuffers.erase(bufferIter);
+                        retireBuffer(bufferIter);
                         mInvalidation.onBufferInvalidated(bufferId, mInvalidationChannel);
                     }
                 }
@@ -663,7 +693,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
-                        mBuffers.erase(bufferIter);
+                        retireBuffer(bufferIter);
                         mInvalidation.onBufferInvalidated(bufferId, mInvalidationChannel);
                     }
                 }
@@ -698,6 +728,12 @@ bool Accessor::Impl::BufferPool::getFreeBuffer(
     return false;
 }
 
+void Accessor::Impl::BufferPool::retireBuffer(
+        std::map<BufferId, std::unique_ptr<InternalBuffer>>::iterator it) {
+    mRetiredBuffers.push_back(std::move(it->second));
+    mBuffers.erase(it);
+}
+
 ResultStatus Accessor::Impl::BufferPool::addNewBuffer(
         const std::shared_ptr<BufferPoolAllocation> &alloc,
         const size_t allocSize,
@@ -734,11 +770,14 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
             mLastLogUs = mTimestampUs;
             ALOGD("bufferpool2 %p : %zu(%zu size) total buffers - "
                   "%zu(%zu size) used buffers - %zu/%zu (recycle/alloc) - "
-                  "%zu/%zu (fetch/transfer)",
+                  "%zu evicted - %zu/%zu (fetch/transfer) - "
+                  "%zu(%lldus) lock waits",
                   this, mStats.mBuffersCached, mStats.mSizeCached,
                   mStats.mBuffersInUse, mStats.mSizeInUse,
                   mStats.mTotalRecycles, mStats.mTotalAllocations,
-                  mStats.mTotalFetches, mStats.mTotalTransfers);
+                  mStats.mTotalEvictions,
+                  mStats.mTotalFetches, mStats.mTotalTransfers,
+                  mStats.mTotalLockWaits, (long long)mStats.mLockWaitUs);
         }
         for (auto freeIt = mFreeBuffers.begin(); freeIt != mFreeBuffers.end();) {
             if (!clearCache && mStats.buffersNotInUse() <= kUnusedBufferCountTarget &&
@@ -750,7 +789,7 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
             if (it != mBuffers.end() &&
                     it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
-                mBuffers.erase(it);
+                retireBuffer(it);
                 freeIt = mFreeBuffers.erase(freeIt);
             } else {
                 ++freeIt;
@@ -769,7 +808,7 @@ void Accessor::Impl::BufferPool::invalidate(
             if (it != mBuffers.end() &&
                 it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
-                mBuffers.erase(it);
+                retireBuffer(it);
                 freeIt = mFreeBuffers.erase(freeIt);
                 continue;
             } else {
@@ -18,7 +18,10 @@
 #define ANDROID_HARDWARE_MEDIA_BUFFERPOOL_V2_0_ACCESSORIMPL_H
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <vector>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -83,6 +86,27 @@ private:
 
     nsecs_t mScheduleEvictTs;
 
+    struct BufferPool;
+
+    /**
+     * Holds the buffer pool lock, and records the time spent waiting for it.
+     * Buffers removed from the pool while the lock is held are destroyed
+     * after it is released, so that freeing allocations does not hold up
+     * other clients of the pool.
+     */
+    class ScopedLock {
+    public:
+        explicit ScopedLock(BufferPool &pool);
+        ~ScopedLock();
+
+        void lock();
+        void unlock();
+
+    private:
+        BufferPool &mPool;
+        std::unique_lock<std::mutex> mLock;
+    };
+
     /**
      * Buffer pool implementation.
      *
@@ -116,6 +140,10 @@ private:
         std::map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
         std::set<BufferId> mFreeBuffers;
         std::set<ConnectionId> mConnectionIds;
+        // Buffers removed from mBuffers, to be destroyed without the lock.
+        std::vector<std::unique_ptr<InternalBuffer>> mRetiredBuffers;
+        // Buffer status messages being processed; kept to reuse the storage.
+        std::vector<BufferStatusMessage> mStatusMessages;
 
         struct Invalidation {
             static std::atomic<std::uint32_t> sInvSeqId;
@@ -188,10 +216,17 @@ private:
             size_t mTotalTransfers;
             /// # of transfers that had to be fetched.
             size_t mTotalFetches;
+            /// # of buffers evicted from the cache.
+            size_t mTotalEvictions;
+            /// # of times the pool lock was contended.
+            size_t mTotalLockWaits;
+            /// Total time spent waiting for the pool lock. (us)
+            int64_t mLockWaitUs;
 
             Stats()
                 : mSizeCached(0), mBuffersCached(0), mSizeInUse(0), mBuffersInUse(0),
-                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0) {}
+                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0),
+                  mTotalEvictions(0), mTotalLockWaits(0), mLockWaitUs(0) {}
 
             /// # of currently unused buffers
             size_t buffersNotInUse() const {
@@ -214,6 +249,8 @@ private:
             void onBufferEvicted(size_t allocSize) {
                 mSizeCached -= allocSize;
                 mBuffersCached--;
+
+                mTotalEvictions++;
             }
 
             /// A buffer is recycled on an allocation request.
@@ -240,6 +277,12 @@ private:
             void onBufferFetched() {
                 mTotalFetches++;
             }
+
+            /// The pool lock was acquired after waiting for another client.
+            void onLockWaited(int64_t waitUs) {
+                mTotalLockWaits++;
+                mLockWaitUs += waitUs;
+            }
         } mStats;
 
         bool isValid() {
@@ -251,6 +294,12 @@ private:
 
         static void createInvalidator();
 
+        /**
+         * Removes a buffer from the pool. The buffer is destroyed once the
+         * pool lock is released.
+         */
+        void retireBuffer(std::map<BufferId, std::unique_ptr<InternalBuffer>>::iterator it);
+
     public:
         /** Creates a buffer pool. */
         BufferPool();
@@ -380,6 +429,7 @@ private:
         void flush(const std::shared_ptr<Accessor::Impl> &impl);
 
         friend class Accessor::Impl;
+        friend class Accessor::Impl::ScopedLock;
     } mBufferPool;
 
     struct  AccessorInvalidator {
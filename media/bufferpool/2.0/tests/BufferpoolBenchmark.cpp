@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures how buffer allocation from a single buffer pool scales with the
+// number of concurrent clients. Each benchmark thread stands for a client
+// that allocates a buffer and releases it again, as a codec does per frame.
+
+#define LOG_TAG "BufferpoolBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <bufferpool/ClientManager.h>
+#include <hidl/HidlSupport.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+
+namespace {
+
+// Number of buffers each client holds at a time, as a codec keeps a few
+// buffers in flight.
+constexpr size_t kBuffersInFlight = 4;
+
+struct SharedPool {
+    android::sp<ClientManager> manager;
+    std::shared_ptr<BufferPoolAllocator> allocator;
+    ConnectionId connectionId;
+    bool valid = false;
+};
+
+SharedPool &GetSharedPool() {
+    static SharedPool sPool;
+    static std::once_flag sOnce;
+    std::call_once(sOnce, [] {
+        sPool.manager = ClientManager::getInstance();
+        sPool.allocator = std::make_shared<TestBufferPoolAllocator>();
+        sPool.valid = sPool.manager && sPool.manager->create(
+                sPool.allocator, &sPool.connectionId) == ResultStatus::OK;
+    });
+    return sPool;
+}
+
+void BM_AllocateRelease(benchmark::State& state) {
+    SharedPool &pool = GetSharedPool();
+    if (!pool.valid) {
+        state.SkipWithError("cannot create buffer pool");
+        return;
+    }
+    std::vector<uint8_t> params;
+    getTestAllocatorParams(&params);
+
+    std::vector<std::shared_ptr<BufferPoolData>> buffers(kBuffersInFlight);
+    size_t next = 0;
+    for (auto _ : state) {
+        native_handle_t *handle = nullptr;
+        // releasing the oldest buffer sends a status message to the pool.
+        buffers[next].reset();
+        if (pool.manager->allocate(pool.connectionId, params, &handle, &buffers[next])
+                != ResultStatus::OK) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        if (handle) {
+            native_handle_close(handle);
+            native_handle_delete(handle);
+        }
+        next = (next + 1) % kBuffersInFlight;
+    }
+    buffers.clear();
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_AllocateRelease)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
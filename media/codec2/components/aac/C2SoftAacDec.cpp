@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 #include <math.h>
+#include <algorithm>
 #include <numeric>
 
 #include <cutils/properties.h>
@@ -116,6 +117,12 @@ public:
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 8192))
                 .build());
 
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(
+                        C2SoftAacDec::kMaxAccessUnitCount))
+                .build());
+
         addParameter(
                 DefineParam(mAacFormat, C2_PARAMKEY_AAC_PACKAGING)
                 .withDefault(new C2StreamAacFormatInfo::input(0u, C2Config::AAC_PACKAGING_RAW))
@@ -250,6 +257,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
     std::shared_ptr<C2StreamAacFormatInfo::input> mAacFormat;
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamDrcCompressionModeTuning::input> mDrcCompressMode;
@@ -331,7 +339,8 @@ status_t C2SoftAacDec::initDecoder() {
     }
 
     mOutputDelayCompensated = 0;
-    mOutputDelayRingBufferSize = 2048 * MAX_CHANNEL_COUNT * kNumDelayBlocksMax;
+    mOutputDelayRingBufferSize =
+            2048 * MAX_CHANNEL_COUNT * (kNumDelayBlocksMax + kMaxAccessUnitCount);
     mOutputDelayRingBuffer.reset(new short[mOutputDelayRingBufferSize]);
     mOutputDelayRingBufferWritePos = 0;
     mOutputDelayRingBufferReadPos = 0;
@@ -500,7 +509,7 @@ void C2SoftAacDec::drainRingBuffer(
 
         std::shared_ptr<C2LinearBlock> block;
         std::function<void(const std::unique_ptr<C2Work>&)> fillWork =
-            [&block, numSamples, pool, this]()
+            [&block, &outInfo, numSamples, pool, this]()
                     -> std::function<void(const std::unique_ptr<C2Work>&)> {
                 auto fillEmptyWork = [](
                         const std::unique_ptr<C2Work> &work, c2_status_t err) {
@@ -535,8 +544,23 @@ void C2SoftAacDec::drainRingBuffer(
                     mSignalledError = true;
                     return std::bind(fillEmptyWork, _1, C2_CORRUPTED);
                 }
-                return [buffer = createLinearBuffer(block, 0, bufferSize)](
-                        const std::unique_ptr<C2Work> &work) {
+                std::shared_ptr<C2Buffer> buffer = createLinearBuffer(block, 0, bufferSize);
+                if (outInfo.accessUnits.size() > 1) {
+                    // at EOS the last access units may be cut short
+                    std::vector<C2AccessUnitInfosStruct> infos;
+                    const size_t frameBytes =
+                            mStreamInfo->frameSize * mStreamInfo->numChannels * sizeof(int16_t);
+                    size_t remaining = bufferSize;
+                    for (const Info::AccessUnit &au : outInfo.accessUnits) {
+                        const size_t auBytes = std::min(au.numFrames * frameBytes, remaining);
+                        if (auBytes > 0) {
+                            infos.emplace_back(au.flags, auBytes, au.timestamp);
+                        }
+                        remaining -= auBytes;
+                    }
+                    buffer->setInfo(C2StreamAccessUnitInfos::output::AllocShared(infos, 0u));
+                }
+                return [buffer](const std::unique_ptr<C2Work> &work) {
                     work->result = C2_OK;
                     C2FrameData &output = work->worklets.front()->output;
                     output.flags = work->input.flags;
@@ -616,315 +640,334 @@ void C2SoftAacDec::process(
         return;
     }
 
+    // The work may carry several access units. Raw access units are not self-delimiting, so
+    // the decoder is filled with one at a time, and their output is returned in one buffer.
+    std::vector<C2AccessUnitInfosStruct> accessUnits = GetInputAccessUnits(work, size);
+    if (accessUnits.empty()) {
+        mSignalledError = true;
+        work->result = C2_CORRUPTED;
+        return;
+    }
+
     Info inInfo;
     inInfo.frameIndex = work->input.ordinal.frameIndex.peeku();
     inInfo.timestamp = work->input.ordinal.timestamp.peeku();
     inInfo.bufferSize = size;
     inInfo.decodedSizes.clear();
-    while (size > 0u) {
-        ALOGV("size = %zu", size);
-        if (mIntf->isAdts()) {
-            size_t adtsHeaderSize = 0;
-            // skip 30 bits, aac_frame_length follows.
-            // ssssssss ssssiiip ppffffPc ccohCCll llllllll lll?????
-
-            const uint8_t *adtsHeader = view.data() + offset;
-
-            bool signalError = false;
-            if (size < 7) {
-                ALOGE("Audio data too short to contain even the ADTS header. "
-                        "Got %zu bytes.", size);
-                hexdump(adtsHeader, size);
-                signalError = true;
-            } else {
-                bool protectionAbsent = (adtsHeader[1] & 1);
-
-                unsigned aac_frame_length =
-                    ((adtsHeader[3] & 3) << 11)
-                    | (adtsHeader[4] << 3)
-                    | (adtsHeader[5] >> 5);
-
-                if (size < aac_frame_length) {
-                    ALOGE("Not enough audio data for the complete frame. "
-                            "Got %zu bytes, frame size according to the ADTS "
-                            "header is %u bytes.",
-                            size, aac_frame_length);
+    inInfo.accessUnits.clear();
+    size_t auOffset = offset;
+    for (const C2AccessUnitInfosStruct &au : accessUnits) {
+        offset = auOffset;
+        size = au.size;
+        auOffset += au.size;
+        const size_t framesBefore = inInfo.decodedSizes.size();
+        while (size > 0u) {
+            ALOGV("size = %zu", size);
+            if (mIntf->isAdts()) {
+                size_t adtsHeaderSize = 0;
+                // skip 30 bits, aac_frame_length follows.
+                // ssssssss ssssiiip ppffffPc ccohCCll llllllll lll?????
+
+                const uint8_t *adtsHeader = view.data() + offset;
+
+                bool signalError = false;
+                if (size < 7) {
+                    ALOGE("Audio data too short to contain even the ADTS header. "
+                            "Got %zu bytes.", size);
                     hexdump(adtsHeader, size);
                     signalError = true;
                 } else {
-                    adtsHeaderSize = (protectionAbsent ? 7 : 9);
-                    if (aac_frame_length < adtsHeaderSize) {
+                    bool protectionAbsent = (adtsHeader[1] & 1);
+
+                    unsigned aac_frame_length =
+                        ((adtsHeader[3] & 3) << 11)
+                        | (adtsHeader[4] << 3)
+                        | (adtsHeader[5] >> 5);
+
+                    if (size < aac_frame_length) {
+                        ALOGE("Not enough audio data for the complete frame. "
+                                "Got %zu bytes, frame size according to the ADTS "
+                                "header is %u bytes.",
+                                size, aac_frame_length);
+                        hexdump(adtsHeader, size);
                         signalError = true;
                     } else {
-                        // const_cast because of libAACdec method signature.
-                        inBuffer[0] = const_cast<UCHAR *>(adtsHeader + adtsHeaderSize);
-                        inBufferLength[0] = aac_frame_length - adtsHeaderSize;
-
-                        offset += adtsHeaderSize;
-                        size -= adtsHeaderSize;
+                        adtsHeaderSize = (protectionAbsent ? 7 : 9);
+                        if (aac_frame_length < adtsHeaderSize) {
+                            signalError = true;
+                        } else {
+                            // const_cast because of libAACdec method signature.
+                            inBuffer[0] = const_cast<UCHAR *>(adtsHeader + adtsHeaderSize);
+                            inBufferLength[0] = aac_frame_length - adtsHeaderSize;
+
+                            offset += adtsHeaderSize;
+                            size -= adtsHeaderSize;
+                        }
                     }
                 }
-            }
 
-            if (signalError) {
-                mSignalledError = true;
-                work->result = C2_CORRUPTED;
-                return;
+                if (signalError) {
+                    mSignalledError = true;
+                    work->result = C2_CORRUPTED;
+                    return;
+                }
+            } else {
+                // const_cast because of libAACdec method signature.
+                inBuffer[0] = const_cast<UCHAR *>(view.data() + offset);
+                inBufferLength[0] = size;
             }
-        } else {
-            // const_cast because of libAACdec method signature.
-            inBuffer[0] = const_cast<UCHAR *>(view.data() + offset);
-            inBufferLength[0] = size;
-        }
 
-        // Fill and decode
-        bytesValid[0] = inBufferLength[0];
+            // Fill and decode
+            bytesValid[0] = inBufferLength[0];
+
+            INT prevSampleRate = mStreamInfo->sampleRate;
+            INT prevNumChannels = mStreamInfo->numChannels;
+            INT prevOutLoudness = mStreamInfo->outputLoudness;
+
+            aacDecoder_Fill(mAACDecoder,
+                            inBuffer,
+                            inBufferLength,
+                            bytesValid);
+
+            // run DRC check
+            mDrcWrap.submitStreamData(mStreamInfo);
+
+            // apply runtime updates
+            //  DRC_PRES_MODE_WRAP_DESIRED_TARGET
+            int32_t targetRefLevel = mIntf->getDrcTargetRefLevel();
+            ALOGV("AAC decoder using desired DRC target reference level of %d", targetRefLevel);
+            mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_TARGET, (unsigned)targetRefLevel);
+
+            //  DRC_PRES_MODE_WRAP_DESIRED_ATT_FACTOR
+            int32_t attenuationFactor = mIntf->getDrcAttenuationFactor();
+            ALOGV("AAC decoder using desired DRC attenuation factor of %d", attenuationFactor);
+            mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_ATT_FACTOR, (unsigned)attenuationFactor);
+
+            //  DRC_PRES_MODE_WRAP_DESIRED_BOOST_FACTOR
+            int32_t boostFactor = mIntf->getDrcBoostFactor();
+            ALOGV("AAC decoder using desired DRC boost factor of %d", boostFactor);
+            mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_BOOST_FACTOR, (unsigned)boostFactor);
+
+            //  DRC_PRES_MODE_WRAP_DESIRED_HEAVY
+            int32_t compressMode = mIntf->getDrcCompressMode();
+            ALOGV("AAC decoder using desried DRC heavy compression switch of %d", compressMode);
+            mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_HEAVY, (unsigned)compressMode);
+
+            // DRC_PRES_MODE_WRAP_ENCODER_TARGET
+            int32_t encTargetLevel = mIntf->getDrcEncTargetLevel();
+            ALOGV("AAC decoder using encoder-side DRC reference level of %d", encTargetLevel);
+            mDrcWrap.setParam(DRC_PRES_MODE_WRAP_ENCODER_TARGET, (unsigned)encTargetLevel);
+
+            // AAC_UNIDRC_SET_EFFECT
+            int32_t effectType = mIntf->getDrcEffectType();
+            ALOGV("AAC decoder using MPEG-D DRC effect type %d", effectType);
+            aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_SET_EFFECT, effectType);
+
+            // AAC_UNIDRC_ALBUM_MODE
+            int32_t albumMode = mIntf->getDrcAlbumMode();
+            ALOGV("AAC decoder using MPEG-D DRC album mode %d", albumMode);
+            aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_ALBUM_MODE, albumMode);
+
+            // AAC_PCM_MAX_OUTPUT_CHANNELS
+            int32_t maxChannelCount = mIntf->getMaxChannelCount();
+            ALOGV("AAC decoder using maximum output channel count %d", maxChannelCount);
+            aacDecoder_SetParam(mAACDecoder, AAC_PCM_MAX_OUTPUT_CHANNELS, maxChannelCount);
+
+            mDrcWrap.update();
+
+            UINT inBufferUsedLength = inBufferLength[0] - bytesValid[0];
+            size -= inBufferUsedLength;
+            offset += inBufferUsedLength;
+
+            AAC_DECODER_ERROR decoderErr;
+            do {
+                if (outputDelayRingBufferSpaceLeft() <
+                        (mStreamInfo->frameSize * mStreamInfo->numChannels)) {
+                    ALOGV("skipping decode: not enough space left in ringbuffer");
+                    // discard buffer
+                    size = 0;
+                    break;
+                }
 
-        INT prevSampleRate = mStreamInfo->sampleRate;
-        INT prevNumChannels = mStreamInfo->numChannels;
-        INT prevOutLoudness = mStreamInfo->outputLoudness;
+                int numConsumed = mStreamInfo->numTotalBytes;
+                decoderErr = aacDecoder_DecodeFrame(mAACDecoder,
+                                           tmpOutBuffer,
+                                           2048 * MAX_CHANNEL_COUNT,
+                                           0 /* flags */);
 
-        aacDecoder_Fill(mAACDecoder,
-                        inBuffer,
-                        inBufferLength,
-                        bytesValid);
+                numConsumed = mStreamInfo->numTotalBytes - numConsumed;
 
-        // run DRC check
-        mDrcWrap.submitStreamData(mStreamInfo);
+                if (decoderErr == AAC_DEC_NOT_ENOUGH_BITS) {
+                    break;
+                }
+                inInfo.decodedSizes.push_back(numConsumed);
 
-        // apply runtime updates
-        //  DRC_PRES_MODE_WRAP_DESIRED_TARGET
-        int32_t targetRefLevel = mIntf->getDrcTargetRefLevel();
-        ALOGV("AAC decoder using desired DRC target reference level of %d", targetRefLevel);
-        mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_TARGET, (unsigned)targetRefLevel);
-
-        //  DRC_PRES_MODE_WRAP_DESIRED_ATT_FACTOR
-        int32_t attenuationFactor = mIntf->getDrcAttenuationFactor();
-        ALOGV("AAC decoder using desired DRC attenuation factor of %d", attenuationFactor);
-        mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_ATT_FACTOR, (unsigned)attenuationFactor);
-
-        //  DRC_PRES_MODE_WRAP_DESIRED_BOOST_FACTOR
-        int32_t boostFactor = mIntf->getDrcBoostFactor();
-        ALOGV("AAC decoder using desired DRC boost factor of %d", boostFactor);
-        mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_BOOST_FACTOR, (unsigned)boostFactor);
-
-        //  DRC_PRES_MODE_WRAP_DESIRED_HEAVY
-        int32_t compressMode = mIntf->getDrcCompressMode();
-        ALOGV("AAC decoder using desried DRC heavy compression switch of %d", compressMode);
-        mDrcWrap.setParam(DRC_PRES_MODE_WRAP_DESIRED_HEAVY, (unsigned)compressMode);
-
-        // DRC_PRES_MODE_WRAP_ENCODER_TARGET
-        int32_t encTargetLevel = mIntf->getDrcEncTargetLevel();
-        ALOGV("AAC decoder using encoder-side DRC reference level of %d", encTargetLevel);
-        mDrcWrap.setParam(DRC_PRES_MODE_WRAP_ENCODER_TARGET, (unsigned)encTargetLevel);
-
-        // AAC_UNIDRC_SET_EFFECT
-        int32_t effectType = mIntf->getDrcEffectType();
-        ALOGV("AAC decoder using MPEG-D DRC effect type %d", effectType);
-        aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_SET_EFFECT, effectType);
-
-        // AAC_UNIDRC_ALBUM_MODE
-        int32_t albumMode = mIntf->getDrcAlbumMode();
-        ALOGV("AAC decoder using MPEG-D DRC album mode %d", albumMode);
-        aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_ALBUM_MODE, albumMode);
-
-        // AAC_PCM_MAX_OUTPUT_CHANNELS
-        int32_t maxChannelCount = mIntf->getMaxChannelCount();
-        ALOGV("AAC decoder using maximum output channel count %d", maxChannelCount);
-        aacDecoder_SetParam(mAACDecoder, AAC_PCM_MAX_OUTPUT_CHANNELS, maxChannelCount);
+                if (decoderErr != AAC_DEC_OK) {
+                    ALOGW("aacDecoder_DecodeFrame decoderErr = 0x%4.4x", decoderErr);
+                }
 
-        mDrcWrap.update();
+                if (bytesValid[0] != 0) {
+                    ALOGE("bytesValid[0] != 0 should never happen");
+                    mSignalledError = true;
+                    work->result = C2_CORRUPTED;
+                    return;
+                }
 
-        UINT inBufferUsedLength = inBufferLength[0] - bytesValid[0];
-        size -= inBufferUsedLength;
-        offset += inBufferUsedLength;
-
-        AAC_DECODER_ERROR decoderErr;
-        do {
-            if (outputDelayRingBufferSpaceLeft() <
-                    (mStreamInfo->frameSize * mStreamInfo->numChannels)) {
-                ALOGV("skipping decode: not enough space left in ringbuffer");
-                // discard buffer
-                size = 0;
-                break;
-            }
+                size_t numOutBytes =
+                    mStreamInfo->frameSize * sizeof(int16_t) * mStreamInfo->numChannels;
 
-            int numConsumed = mStreamInfo->numTotalBytes;
-            decoderErr = aacDecoder_DecodeFrame(mAACDecoder,
-                                       tmpOutBuffer,
-                                       2048 * MAX_CHANNEL_COUNT,
-                                       0 /* flags */);
+                if (decoderErr == AAC_DEC_OK) {
+                    if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
+                            mStreamInfo->frameSize * mStreamInfo->numChannels)) {
+                        mSignalledError = true;
+                        work->result = C2_CORRUPTED;
+                        return;
+                    }
+                } else {
+                    ALOGW("AAC decoder returned error 0x%4.4x, substituting silence", decoderErr);
 
-            numConsumed = mStreamInfo->numTotalBytes - numConsumed;
+                    memset(tmpOutBuffer, 0, numOutBytes); // TODO: check for overflow
 
-            if (decoderErr == AAC_DEC_NOT_ENOUGH_BITS) {
-                break;
-            }
-            inInfo.decodedSizes.push_back(numConsumed);
+                    if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
+                            mStreamInfo->frameSize * mStreamInfo->numChannels)) {
+                        mSignalledError = true;
+                        work->result = C2_CORRUPTED;
+                        return;
+                    }
 
-            if (decoderErr != AAC_DEC_OK) {
-                ALOGW("aacDecoder_DecodeFrame decoderErr = 0x%4.4x", decoderErr);
-            }
+                    // Discard input buffer.
+                    size = 0;
 
-            if (bytesValid[0] != 0) {
-                ALOGE("bytesValid[0] != 0 should never happen");
-                mSignalledError = true;
-                work->result = C2_CORRUPTED;
-                return;
-            }
+                    aacDecoder_SetParam(mAACDecoder, AAC_TPDEC_CLEAR_BUFFER, 1);
 
-            size_t numOutBytes =
-                mStreamInfo->frameSize * sizeof(int16_t) * mStreamInfo->numChannels;
+                    // After an error, replace bufferSize with the sum of the
+                    // decodedSizes to resynchronize the in/out lists.
+                    inInfo.bufferSize = std::accumulate(
+                            inInfo.decodedSizes.begin(), inInfo.decodedSizes.end(), 0);
 
-            if (decoderErr == AAC_DEC_OK) {
-                if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
-                        mStreamInfo->frameSize * mStreamInfo->numChannels)) {
-                    mSignalledError = true;
-                    work->result = C2_CORRUPTED;
-                    return;
+                    // fall through
                 }
-            } else {
-                ALOGW("AAC decoder returned error 0x%4.4x, substituting silence", decoderErr);
 
-                memset(tmpOutBuffer, 0, numOutBytes); // TODO: check for overflow
-
-                if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
-                        mStreamInfo->frameSize * mStreamInfo->numChannels)) {
-                    mSignalledError = true;
-                    work->result = C2_CORRUPTED;
-                    return;
+                /*
+                 * AAC+/eAAC+ streams can be signalled in two ways: either explicitly
+                 * or implicitly, according to MPEG4 spec. AAC+/eAAC+ is a dual
+                 * rate system and the sampling rate in the final output is actually
+                 * doubled compared with the core AAC decoder sampling rate.
+                 *
+                 * Explicit signalling is done by explicitly defining SBR audio object
+                 * type in the bitstream. Implicit signalling is done by embedding
+                 * SBR content in AAC extension payload specific to SBR, and hence
+                 * requires an AAC decoder to perform pre-checks on actual audio frames.
+                 *
+                 * Thus, we could not say for sure whether a stream is
+                 * AAC+/eAAC+ until the first data frame is decoded.
+                 */
+                if (!mStreamInfo->sampleRate || !mStreamInfo->numChannels) {
+                    // if ((mInputBufferCount > 2) && (mOutputBufferCount <= 1)) {
+                        ALOGD("Invalid AAC stream");
+                        // TODO: notify(OMX_EventError, OMX_ErrorUndefined, decoderErr, NULL);
+                        // mSignalledError = true;
+                    // }
+                } else if ((mStreamInfo->sampleRate != prevSampleRate) ||
+                           (mStreamInfo->numChannels != prevNumChannels)) {
+                    ALOGI("Reconfiguring decoder: %d->%d Hz, %d->%d channels",
+                          prevSampleRate, mStreamInfo->sampleRate,
+                          prevNumChannels, mStreamInfo->numChannels);
+
+                    C2StreamSampleRateInfo::output sampleRateInfo(0u, mStreamInfo->sampleRate);
+                    C2StreamChannelCountInfo::output channelCountInfo(0u, mStreamInfo->numChannels);
+                    C2StreamChannelMaskInfo::output channelMaskInfo(0u,
+                            maskFromCount(mStreamInfo->numChannels));
+                    std::vector<std::unique_ptr<C2SettingResult>> failures;
+                    c2_status_t err = mIntf->config(
+                            { &sampleRateInfo, &channelCountInfo, &channelMaskInfo },
+                            C2_MAY_BLOCK,
+                            &failures);
+                    if (err == OK) {
+                        // TODO: this does not handle the case where the values are
+                        //       altered during config.
+                        C2FrameData &output = work->worklets.front()->output;
+                        output.configUpdate.push_back(C2Param::Copy(sampleRateInfo));
+                        output.configUpdate.push_back(C2Param::Copy(channelCountInfo));
+                        output.configUpdate.push_back(C2Param::Copy(channelMaskInfo));
+                    } else {
+                        ALOGE("Config Update failed");
+                        mSignalledError = true;
+                        work->result = C2_CORRUPTED;
+                        return;
+                    }
+                }
+                ALOGV("size = %zu", size);
+
+                if (mStreamInfo->outputLoudness != prevOutLoudness) {
+                    C2StreamDrcOutputLoudnessTuning::output
+                            drcOutLoudness(0u, (float) (mStreamInfo->outputLoudness*-0.25));
+
+                    std::vector<std::unique_ptr<C2SettingResult>> failures;
+                    c2_status_t err = mIntf->config(
+                                        { &drcOutLoudness },
+                                        C2_MAY_BLOCK,
+                                        &failures);
+                    if (err == OK) {
+                        work->worklets.front()->output.configUpdate.push_back(
+                            C2Param::Copy(drcOutLoudness));
+                    } else {
+                        ALOGE("Getting output loudness failed");
+                    }
                 }
 
-                // Discard input buffer.
-                size = 0;
-
-                aacDecoder_SetParam(mAACDecoder, AAC_TPDEC_CLEAR_BUFFER, 1);
-
-                // After an error, replace bufferSize with the sum of the
-                // decodedSizes to resynchronize the in/out lists.
-                inInfo.bufferSize = std::accumulate(
-                        inInfo.decodedSizes.begin(), inInfo.decodedSizes.end(), 0);
+                // update config with values used for decoding:
+                //    Album mode, target reference level, DRC effect type, DRC attenuation and boost
+                //    factor, DRC compression mode, encoder target level and max channel count
+                // with input values as they were not modified by decoder
 
-                // fall through
-            }
-
-            /*
-             * AAC+/eAAC+ streams can be signalled in two ways: either explicitly
-             * or implicitly, according to MPEG4 spec. AAC+/eAAC+ is a dual
-             * rate system and the sampling rate in the final output is actually
-             * doubled compared with the core AAC decoder sampling rate.
-             *
-             * Explicit signalling is done by explicitly defining SBR audio object
-             * type in the bitstream. Implicit signalling is done by embedding
-             * SBR content in AAC extension payload specific to SBR, and hence
-             * requires an AAC decoder to perform pre-checks on actual audio frames.
-             *
-             * Thus, we could not say for sure whether a stream is
-             * AAC+/eAAC+ until the first data frame is decoded.
-             */
-            if (!mStreamInfo->sampleRate || !mStreamInfo->numChannels) {
-                // if ((mInputBufferCount > 2) && (mOutputBufferCount <= 1)) {
-                    ALOGD("Invalid AAC stream");
-                    // TODO: notify(OMX_EventError, OMX_ErrorUndefined, decoderErr, NULL);
-                    // mSignalledError = true;
-                // }
-            } else if ((mStreamInfo->sampleRate != prevSampleRate) ||
-                       (mStreamInfo->numChannels != prevNumChannels)) {
-                ALOGI("Reconfiguring decoder: %d->%d Hz, %d->%d channels",
-                      prevSampleRate, mStreamInfo->sampleRate,
-                      prevNumChannels, mStreamInfo->numChannels);
-
-                C2StreamSampleRateInfo::output sampleRateInfo(0u, mStreamInfo->sampleRate);
-                C2StreamChannelCountInfo::output channelCountInfo(0u, mStreamInfo->numChannels);
-                C2StreamChannelMaskInfo::output channelMaskInfo(0u,
-                        maskFromCount(mStreamInfo->numChannels));
-                std::vector<std::unique_ptr<C2SettingResult>> failures;
-                c2_status_t err = mIntf->config(
-                        { &sampleRateInfo, &channelCountInfo, &channelMaskInfo },
-                        C2_MAY_BLOCK,
-                        &failures);
-                if (err == OK) {
-                    // TODO: this does not handle the case where the values are
-                    //       altered during config.
-                    C2FrameData &output = work->worklets.front()->output;
-                    output.configUpdate.push_back(C2Param::Copy(sampleRateInfo));
-                    output.configUpdate.push_back(C2Param::Copy(channelCountInfo));
-                    output.configUpdate.push_back(C2Param::Copy(channelMaskInfo));
-                } else {
-                    ALOGE("Config Update failed");
-                    mSignalledError = true;
-                    work->result = C2_CORRUPTED;
-                    return;
-                }
-            }
-            ALOGV("size = %zu", size);
+                C2StreamDrcAttenuationFactorTuning::input currentAttenuationFactor(0u,
+                        (C2FloatValue) (attenuationFactor/127.));
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentAttenuationFactor));
 
-            if (mStreamInfo->outputLoudness != prevOutLoudness) {
-                C2StreamDrcOutputLoudnessTuning::output
-                        drcOutLoudness(0u, (float) (mStreamInfo->outputLoudness*-0.25));
+                C2StreamDrcBoostFactorTuning::input currentBoostFactor(0u,
+                        (C2FloatValue) (boostFactor/127.));
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentBoostFactor));
 
-                std::vector<std::unique_ptr<C2SettingResult>> failures;
-                c2_status_t err = mIntf->config(
-                                    { &drcOutLoudness },
-                                    C2_MAY_BLOCK,
-                                    &failures);
-                if (err == OK) {
+                if (android_get_device_api_level() < __ANDROID_API_S__) {
+                    // We used to report DRC compression mode in the output format
+                    // in Q and R, but stopped doing that in S
+                    C2StreamDrcCompressionModeTuning::input currentCompressMode(0u,
+                            (C2Config::drc_compression_mode_t) compressMode);
                     work->worklets.front()->output.configUpdate.push_back(
-                        C2Param::Copy(drcOutLoudness));
-                } else {
-                    ALOGE("Getting output loudness failed");
+                            C2Param::Copy(currentCompressMode));
                 }
-            }
 
-            // update config with values used for decoding:
-            //    Album mode, target reference level, DRC effect type, DRC attenuation and boost
-            //    factor, DRC compression mode, encoder target level and max channel count
-            // with input values as they were not modified by decoder
-
-            C2StreamDrcAttenuationFactorTuning::input currentAttenuationFactor(0u,
-                    (C2FloatValue) (attenuationFactor/127.));
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentAttenuationFactor));
-
-            C2StreamDrcBoostFactorTuning::input currentBoostFactor(0u,
-                    (C2FloatValue) (boostFactor/127.));
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentBoostFactor));
-
-            if (android_get_device_api_level() < __ANDROID_API_S__) {
-                // We used to report DRC compression mode in the output format
-                // in Q and R, but stopped doing that in S
-                C2StreamDrcCompressionModeTuning::input currentCompressMode(0u,
-                        (C2Config::drc_compression_mode_t) compressMode);
+                C2StreamDrcEncodedTargetLevelTuning::input currentEncodedTargetLevel(0u,
+                        (C2FloatValue) (encTargetLevel*-0.25));
                 work->worklets.front()->output.configUpdate.push_back(
-                        C2Param::Copy(currentCompressMode));
-            }
-
-            C2StreamDrcEncodedTargetLevelTuning::input currentEncodedTargetLevel(0u,
-                    (C2FloatValue) (encTargetLevel*-0.25));
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentEncodedTargetLevel));
+                        C2Param::Copy(currentEncodedTargetLevel));
 
-            C2StreamDrcAlbumModeTuning::input currentAlbumMode(0u,
-                    (C2Config::drc_album_mode_t) albumMode);
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentAlbumMode));
+                C2StreamDrcAlbumModeTuning::input currentAlbumMode(0u,
+                        (C2Config::drc_album_mode_t) albumMode);
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentAlbumMode));
 
-            C2StreamDrcTargetReferenceLevelTuning::input currentTargetRefLevel(0u,
-                    (float) (targetRefLevel*-0.25));
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentTargetRefLevel));
+                C2StreamDrcTargetReferenceLevelTuning::input currentTargetRefLevel(0u,
+                        (float) (targetRefLevel*-0.25));
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentTargetRefLevel));
 
-            C2StreamDrcEffectTypeTuning::input currentEffectype(0u,
-                    (C2Config::drc_effect_type_t) effectType);
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentEffectype));
+                C2StreamDrcEffectTypeTuning::input currentEffectype(0u,
+                        (C2Config::drc_effect_type_t) effectType);
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentEffectype));
 
-            C2StreamMaxChannelCountInfo::input currentMaxChannelCnt(0u, maxChannelCount);
-            work->worklets.front()->output.configUpdate.push_back(
-                    C2Param::Copy(currentMaxChannelCnt));
+                C2StreamMaxChannelCountInfo::input currentMaxChannelCnt(0u, maxChannelCount);
+                work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(currentMaxChannelCnt));
 
-        } while (decoderErr == AAC_DEC_OK);
+            } while (decoderErr == AAC_DEC_OK);
+        }
+        inInfo.accessUnits.push_back(
+                {au.timestamp, au.flags, inInfo.decodedSizes.size() - framesBefore});
     }
 
     int32_t outputDelay = mStreamInfo->outputDelay * mStreamInfo->numChannels;
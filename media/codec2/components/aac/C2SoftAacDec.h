@@ -47,6 +47,8 @@ struct C2SoftAacDec : public SimpleC2Component {
 private:
     enum {
         kNumDelayBlocksMax      = 8,
+        // access units per work; the ring buffer holds their output until the work is done
+        kMaxAccessUnitCount     = 8,
     };
 
     std::shared_ptr<IntfImpl> mIntf;
@@ -63,6 +65,12 @@ private:
         size_t bufferSize;
         uint64_t timestamp;
         std::vector<int32_t> decodedSizes;
+        struct AccessUnit {
+            int64_t timestamp;
+            uint32_t flags;
+            size_t numFrames;
+        };
+        std::vector<AccessUnit> accessUnits;
     };
     std::list<Info> mBuffersInfo;
 
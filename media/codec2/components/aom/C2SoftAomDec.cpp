@@ -336,7 +336,12 @@ status_t C2SoftAomDec::initDecoder() {
 
     aom_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(aom_codec_dec_cfg_t));
-    cfg.threads = GetCPUCoreCount();
+    if (!mCoreGrant) {
+        mCoreGrant = AcquireCodec2CoreBudget(GetParallelismHint(GetCPUCoreCount()));
+    }
+    // libaom has no frame parallel mode; its threads decode tiles and
+    // superblock rows of one frame, so they add no latency.
+    cfg.threads = mCoreGrant->cores();
     cfg.allow_lowbitdepth = 1;
 
     aom_codec_flags_t flags;
@@ -358,6 +363,7 @@ status_t C2SoftAomDec::destroyDecoder() {
         delete mCodecCtx;
         mCodecCtx = nullptr;
     }
+    mCoreGrant.reset();
     return OK;
 }
 
@@ -19,6 +19,7 @@
 
 #include <inttypes.h>
 
+#include <C2PlatformSupport.h>
 #include <SimpleC2Component.h>
 #include "aom/aom_decoder.h"
 #include "aom/aomdx.h"
@@ -46,6 +47,7 @@ struct C2SoftAomDec : public SimpleC2Component {
    private:
     std::shared_ptr<IntfImpl> mIntf;
     aom_codec_ctx_t* mCodecCtx;
+    std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
 
     uint32_t mWidth;
     uint32_t mHeight;
@@ -202,6 +202,13 @@ public:
                 .withConstValue(new C2StreamPixelFormatInfo::output(
                                      0u, HAL_PIXEL_FORMAT_YCBCR_420_888))
                 .build());
+
+        addParameter(
+                DefineParam(mLowLatencyMode, C2_PARAMKEY_LOW_LATENCY_MODE)
+                .withDefault(new C2GlobalLowLatencyModeTuning(C2_FALSE))
+                .withFields({C2F(mLowLatencyMode, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mLowLatencyMode)>::NonStrictValueWithNoDeps)
+                .build());
     }
     static C2R SizeSetter(bool mayBlock, const C2P<C2StreamPictureSizeInfo::output> &oldMe,
                           C2P<C2StreamPictureSizeInfo::output> &me) {
@@ -296,6 +303,8 @@ public:
         return mColorAspects;
     }
 
+    bool getLowLatencyMode_l() const { return mLowLatencyMode->value; }
+
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamPictureSizeInfo::output> mSize;
@@ -306,6 +315,7 @@ private:
     std::shared_ptr<C2StreamColorAspectsTuning::output> mDefaultColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
+    std::shared_ptr<C2GlobalLowLatencyModeTuning> mLowLatencyMode;
 };
 
 static size_t getCpuCoreCount() {
@@ -361,6 +371,8 @@ c2_status_t C2SoftAvcDec::onInit() {
 c2_status_t C2SoftAvcDec::onStop() {
     if (OK != resetDecoder()) return C2_CORRUPTED;
     resetPlugin();
+    // let the running decoders have our cores until we are started again
+    mCoreGrant.reset();
     return C2_OK;
 }
 
@@ -370,6 +382,7 @@ void C2SoftAvcDec::onReset() {
 
 void C2SoftAvcDec::onRelease() {
     (void) deleteDecoder();
+    mCoreGrant.reset();
     if (mOutBufferFlush) {
         ivd_aligned_free(nullptr, mOutBufferFlush);
         mOutBufferFlush = nullptr;
@@ -458,6 +471,18 @@ status_t C2SoftAvcDec::setNumCores() {
     return OK;
 }
 
+void C2SoftAvcDec::updateNumCores() {
+    if (!mCoreGrant) {
+        mCoreGrant = AcquireCodec2CoreBudget(
+                MIN(GetParallelismHint(getCpuCoreCount()), MAX_NUM_CORES));
+    }
+    if (mCoreGrant->cores() != mNumCores) {
+        mNumCores = mCoreGrant->cores();
+        ALOGV("using %zu cores", mNumCores);
+        (void) setNumCores();
+    }
+}
+
 status_t C2SoftAvcDec::setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode) {
     ih264d_ctl_set_config_ip_t s_h264d_set_dyn_params_ip = {};
     ih264d_ctl_set_config_op_t s_h264d_set_dyn_params_op = {};
@@ -471,7 +496,13 @@ status_t C2SoftAvcDec::setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode
     ps_set_dyn_params_ip->e_sub_cmd = IVD_CMD_CTL_SETPARAMS;
     ps_set_dyn_params_ip->u4_disp_wd = (UWORD32) stride;
     ps_set_dyn_params_ip->e_frm_skip_mode = IVD_SKIP_NONE;
-    ps_set_dyn_params_ip->e_frm_out_mode = IVD_DISPLAY_FRAME_OUT;
+    {
+        // in low latency mode frames are output in decode order as soon as
+        // they are decoded, without waiting for the reorder depth.
+        IntfImpl::Lock lock = mIntf->lock();
+        ps_set_dyn_params_ip->e_frm_out_mode =
+            mIntf->getLowLatencyMode_l() ? IVD_DECODE_FRAME_OUT : IVD_DISPLAY_FRAME_OUT;
+    }
     ps_set_dyn_params_ip->e_vid_dec_mode = dec_mode;
     ps_set_dyn_params_op->u4_size = sizeof(ih264d_ctl_set_config_op_t);
     IV_API_CALL_STATUS_T status = ivdec_api_function(mDecHandle,
@@ -510,7 +541,9 @@ void C2SoftAvcDec::getVersion() {
 
 status_t C2SoftAvcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    mCoreGrant = AcquireCodec2CoreBudget(
+            MIN(GetParallelismHint(getCpuCoreCount()), MAX_NUM_CORES));
+    mNumCores = mCoreGrant->cores();
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -832,6 +865,11 @@ void C2SoftAvcDec::process(
     ALOGV("in buffer attr. size %zu timestamp %d frameindex %d, flags %x",
           inSize, (int)work->input.ordinal.timestamp.peeku(),
           (int)work->input.ordinal.frameIndex.peeku(), work->input.flags);
+    // the share of cores changes as other decoders start and stop; only apply
+    // it before the decoder starts on a sequence.
+    if (!mHeaderDecoded) {
+        updateNumCores();
+    }
     size_t inPos = 0;
     while (inPos < inSize && inSize - inPos >= kMinInputBytes) {
         if (C2_OK != ensureDecoderState(pool)) {
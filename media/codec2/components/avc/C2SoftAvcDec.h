@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/ColorUtils.h>
 
 #include <atomic>
+#include <C2PlatformSupport.h>
 #include <SimpleC2Component.h>
 
 #include "ih264_typedefs.h"
@@ -114,6 +115,7 @@ public:
 private:
     status_t createDecoder();
     status_t setNumCores();
+    void updateNumCores();
     status_t setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode);
     void getVersion();
     status_t initDecoder();
@@ -152,6 +154,7 @@ private:
     uint8_t *mOutBufferFlush;
 
     size_t mNumCores;
+    std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
     IV_COLOR_FORMAT_T mIvColorFormat;
     uint32_t mOutputDelay;
     uint32_t mWidth;
@@ -24,6 +24,10 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <mutex>
+#include <string>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -577,22 +581,137 @@ struct DummyReadView : public C2ReadView {
     DummyReadView() : C2ReadView(C2_NO_INIT) {}
 };
 
+/**
+ * Worker loopers shared by the software components of this process.
+ *
+ * By default every component runs on a private looper thread. If
+ * debug.stagefright.c2-shared-loopers is set to N > 0, components instead run
+ * on up to N loopers per thread priority, so audio components never queue
+ * behind video ones. A component's handler stays on one looper for its whole
+ * life, so its messages are still processed in order; components on the same
+ * looper take turns one work item at a time.
+ *
+ * Note that a component blocking in process() (e.g. waiting for an output
+ * block) holds up the other components on its looper.
+ */
+class SharedLoopers {
+public:
+    static SharedLoopers &Get() {
+        static SharedLoopers sInstance;
+        return sInstance;
+    }
+
+    bool enabled() const { return mMaxLoopersPerPriority > 0; }
+
+    sp<ALooper> acquire(int32_t priority) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Entry *best = nullptr;
+        size_t count = 0;
+        for (Entry &entry : mLoopers) {
+            if (entry.priority != priority) {
+                continue;
+            }
+            ++count;
+            if (best == nullptr || entry.users < best->users) {
+                best = &entry;
+            }
+        }
+        if (count < mMaxLoopersPerPriority && (best == nullptr || best->users > 0)) {
+            sp<ALooper> looper = new ALooper;
+            looper->setName(("c2-shared-" + std::to_string(mLoopers.size())).c_str());
+            if (looper->start(false, false, priority) == OK) {
+                mLoopers.push_back({looper, priority, 0});
+                best = &mLoopers.back();
+            } else {
+                ALOGW("failed to start shared looper; reusing existing loopers");
+            }
+        }
+        if (best == nullptr) {
+            return nullptr;
+        }
+        ++best->users;
+        ++mUsers;
+        return best->looper;
+    }
+
+    void release(const sp<ALooper> &looper) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (Entry &entry : mLoopers) {
+            if (entry.looper == looper && entry.users > 0) {
+                --entry.users;
+                --mUsers;
+                break;
+            }
+        }
+    }
+
+    size_t parallelismHint(size_t cores) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return std::max(cores / std::max(mUsers, (size_t)1), (size_t)1);
+    }
+
+private:
+    SharedLoopers()
+        : mMaxLoopersPerPriority(std::max(
+                  property_get_int32("debug.stagefright.c2-shared-loopers", 0), 0)),
+          mUsers(0) {}
+
+    struct Entry {
+        sp<ALooper> looper;
+        int32_t priority;
+        size_t users;
+    };
+
+    const size_t mMaxLoopersPerPriority;
+    std::mutex mMutex;
+    // loopers are never stopped; there are at most a few of them per process.
+    std::list<Entry> mLoopers;
+    size_t mUsers;
+};
+
+int32_t GetLooperPriority(const std::shared_ptr<C2ComponentInterface> &intf) {
+    C2ComponentDomainSetting domain;
+    if (intf->query_vb({&domain}, {}, C2_DONT_BLOCK, nullptr) == C2_OK
+            && domain.value == C2Component::DOMAIN_AUDIO) {
+        return ANDROID_PRIORITY_AUDIO;
+    }
+    return ANDROID_PRIORITY_VIDEO;
+}
+
 }  // namespace
 
 SimpleC2Component::SimpleC2Component(
         const std::shared_ptr<C2ComponentInterface> &intf)
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
-      mLooper(new ALooper),
-      mHandler(new WorkHandler) {
-    mLooper->setName(intf->getName().c_str());
+      mHandler(new WorkHandler),
+      mSharedLooper(false) {
+    SharedLoopers &shared = SharedLoopers::Get();
+    if (shared.enabled()) {
+        mLooper = shared.acquire(GetLooperPriority(intf));
+        mSharedLooper = (mLooper != nullptr);
+    }
+    if (!mSharedLooper) {
+        mLooper = new ALooper;
+        mLooper->setName(intf->getName().c_str());
+        mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
+    }
     (void)mLooper->registerHandler(mHandler);
-    mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
 }
 
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
-    (void)mLooper->stop();
+    if (mSharedLooper) {
+        SharedLoopers::Get().release(mLooper);
+    } else {
+        (void)mLooper->stop();
+    }
+}
+
+// static
+size_t SimpleC2Component::GetParallelismHint(size_t cores) {
+    SharedLoopers &shared = SharedLoopers::Get();
+    return shared.enabled() ? shared.parallelismHint(cores) : cores;
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -1016,4 +1135,29 @@ std::shared_ptr<C2Buffer> SimpleC2Component::createGraphicBuffer(
     return C2Buffer::CreateGraphicBuffer(block->share(crop, ::C2Fence()));
 }
 
+// static
+std::vector<C2AccessUnitInfosStruct> SimpleC2Component::GetInputAccessUnits(
+        const std::unique_ptr<C2Work> &work, size_t size) {
+    std::shared_ptr<const C2StreamAccessUnitInfos::input> infos;
+    if (!work->input.buffers.empty() && work->input.buffers[0]) {
+        infos = std::static_pointer_cast<const C2StreamAccessUnitInfos::input>(
+                work->input.buffers[0]->getInfo(C2StreamAccessUnitInfos::input::PARAM_TYPE));
+    }
+    if (!infos || infos->flexCount() == 0) {
+        return { C2AccessUnitInfosStruct(
+                work->input.flags, size, work->input.ordinal.timestamp.peekll()) };
+    }
+    std::vector<C2AccessUnitInfosStruct> accessUnits(
+            infos->m.values, infos->m.values + infos->flexCount());
+    size_t total = 0;
+    for (const C2AccessUnitInfosStruct &au : accessUnits) {
+        total += au.size;
+    }
+    if (total != size) {
+        ALOGE("access units add up to %zu bytes, buffer has %zu", total, size);
+        return {};
+    }
+    return accessUnits;
+}
+
 } // namespace android
@@ -19,6 +19,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <vector>
 
 #include <C2Component.h>
 
@@ -26,6 +27,7 @@
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/Mutexed.h>
 
+struct C2AccessUnitInfosStruct;
 struct C2ColorAspectsStruct;
 
 namespace android {
@@ -173,11 +175,31 @@ protected:
             const std::shared_ptr<C2GraphicBlock> &block,
             const C2Rect &crop);
 
+    /**
+     * Returns the access units of the input of |work|, whose buffer holds |size| bytes.
+     *
+     * These are the C2StreamAccessUnitInfos attached to the input buffer if the work carries
+     * several access units, or else a single access unit with the flags and timestamp of the
+     * work. Returns an empty vector if the attached access units do not add up to |size|.
+     */
+    static std::vector<C2AccessUnitInfosStruct> GetInputAccessUnits(
+            const std::unique_ptr<C2Work> &work, size_t size);
+
     static constexpr uint32_t NO_DRAIN = ~0u;
 
     C2ReadView mDummyReadView;
     int getHalPixelFormatForBitDepth10(bool allowRGBA1010102);
 
+    /**
+     * Returns the number of threads a codec library should use for one
+     * component, given that the device has |cores| cores.
+     *
+     * When components share worker loopers (debug.stagefright.c2-shared-loopers)
+     * the cores are split between the components on those loopers; otherwise
+     * this returns |cores|.
+     */
+    static size_t GetParallelismHint(size_t cores);
+
 private:
     const std::shared_ptr<C2ComponentInterface> mIntf;
 
@@ -221,6 +243,8 @@ private:
 
     sp<ALooper> mLooper;
     sp<WorkHandler> mHandler;
+    // whether mLooper is shared with other components of this process
+    bool mSharedLooper;
 
     class WorkQueue {
     public:
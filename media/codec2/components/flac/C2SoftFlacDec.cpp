@@ -18,6 +18,8 @@
 #define LOG_TAG "C2SoftFlacDec"
 #include <log/log.h>
 
+#include <unistd.h>
+
 #include <media/stagefright/foundation/MediaDefs.h>
 
 #include <C2PlatformSupport.h>
@@ -81,6 +83,11 @@ public:
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 32768))
                 .build());
 
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitCount))
+                .build());
+
         addParameter(
                 DefineParam(mPcmEncodingInfo, C2_PARAMKEY_PCM_ENCODING)
                 .withDefault(new C2StreamPcmEncodingInfo::output(0u, C2Config::PCM_16))
@@ -100,6 +107,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
     std::shared_ptr<C2StreamPcmEncodingInfo::output> mPcmEncodingInfo;
 };
 
@@ -139,6 +147,7 @@ void C2SoftFlacDec::onRelease() {
     mInputBufferCount = 0;
     if (mFLACDecoder) delete mFLACDecoder;
     mFLACDecoder = nullptr;
+    mCoreGrant.reset();
 }
 
 c2_status_t C2SoftFlacDec::onFlush_sm() {
@@ -165,6 +174,11 @@ status_t C2SoftFlacDec::initDecoder() {
     return OK;
 }
 
+static size_t GetCPUCoreCount() {
+    long cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpuCoreCount > 1 ? cpuCoreCount : 1;
+}
+
 static void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
     work->worklets.front()->output.flags = work->input.flags;
     work->worklets.front()->output.buffers.clear();
@@ -172,7 +186,6 @@ static void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
     work->workletsProcessed = 1u;
 }
 
-// (TODO) add multiframe support, in plugin and FLACDecoder.cpp
 void C2SoftFlacDec::process(
         const std::unique_ptr<C2Work> &work,
         const std::shared_ptr<C2BlockPool> &pool) {
@@ -275,11 +288,36 @@ void C2SoftFlacDec::process(
         return;
     }
 
+    std::vector<C2AccessUnitInfosStruct> accessUnits = GetInputAccessUnits(work, inSize);
+    if (accessUnits.empty()) {
+        mSignalledError = true;
+        work->result = C2_CORRUPTED;
+        return;
+    }
+    // Frames are independent once STREAMINFO is known, so those of one work are decoded in
+    // parallel. Without STREAMINFO, all access units go to libFLAC as a single stream chunk.
+    const bool multiFrame = accessUnits.size() > 1 && mHasStreamInfo;
+    if (multiFrame) {
+        if (!mCoreGrant) {
+            mCoreGrant = AcquireCodec2CoreBudget(std::min<size_t>(
+                    kMaxFrameThreads + 1, GetParallelismHint(GetCPUCoreCount())));
+        }
+        // the grant shrinks and grows as other codecs come and go
+        const size_t frameThreads = mCoreGrant->cores() - 1;
+        if (frameThreads != mFLACDecoder->getParallelism()
+                && mFLACDecoder->setParallelism(frameThreads) != OK) {
+            ALOGW("process: decoding frames on the calling thread only");
+        }
+    }
+
     const bool outputFloat = mIntf->getPcmEncodingInfo() == C2Config::PCM_FLOAT;
     const size_t sampleSize = outputFloat ? sizeof(float) : sizeof(short);
     size_t outSize = mHasStreamInfo ?
             mStreamInfo.max_blocksize * mStreamInfo.channels * sampleSize
           : kMaxBlockSize * FLACDecoder::kMaxChannels * sampleSize;
+    if (multiFrame) {
+        outSize *= accessUnits.size();
+    }
 
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
@@ -296,21 +334,48 @@ void C2SoftFlacDec::process(
         return;
     }
 
-    status_t decoderErr = mFLACDecoder->decodeOneFrame(
-                            input, inSize, wView.data(), &outSize, outputFloat);
+    std::vector<C2AccessUnitInfosStruct> outInfos;
+    status_t decoderErr;
+    if (multiFrame) {
+        std::vector<const uint8_t *> frames(accessUnits.size());
+        std::vector<size_t> frameSizes(accessUnits.size());
+        std::vector<size_t> outFrameSizes(accessUnits.size());
+        const uint8_t *frame = input;
+        for (size_t i = 0; i < accessUnits.size(); ++i) {
+            frames[i] = frame;
+            frameSizes[i] = accessUnits[i].size;
+            frame += accessUnits[i].size;
+        }
+        decoderErr = mFLACDecoder->decodeFrames(frames.data(), frameSizes.data(),
+                accessUnits.size(), wView.data(), &outSize, outFrameSizes.data(), outputFloat);
+        for (size_t i = 0; i < accessUnits.size(); ++i) {
+            if (outFrameSizes[i] > 0) {
+                outInfos.emplace_back(
+                        accessUnits[i].flags, outFrameSizes[i], accessUnits[i].timestamp);
+            }
+        }
+    } else {
+        decoderErr = mFLACDecoder->decodeOneFrame(
+                input, inSize, wView.data(), &outSize, outputFloat);
+    }
     if (decoderErr != OK) {
-        ALOGE("process: FLACDecoder decodeOneFrame returns error %d", decoderErr);
+        ALOGE("process: FLACDecoder returns error %d", decoderErr);
         mSignalledError = true;
         work->result = C2_CORRUPTED;
         return;
     }
 
     mInputBufferCount++;
-    ALOGV("out buffer attr. size %zu", outSize);
+    ALOGV("out buffer attr. size %zu, %zu access units", outSize, accessUnits.size());
+    std::shared_ptr<C2Buffer> buffer = createLinearBuffer(block, 0, outSize);
     work->worklets.front()->output.flags = work->input.flags;
     work->worklets.front()->output.buffers.clear();
-    work->worklets.front()->output.buffers.push_back(createLinearBuffer(block, 0, outSize));
     work->worklets.front()->output.ordinal = work->input.ordinal;
+    if (multiFrame && !outInfos.empty()) {
+        buffer->setInfo(C2StreamAccessUnitInfos::output::AllocShared(outInfos, 0u));
+        work->worklets.front()->output.ordinal.timestamp = outInfos.front().timestamp;
+    }
+    work->worklets.front()->output.buffers.push_back(buffer);
     if (eos) {
         mSignalledOutputEos = true;
         ALOGV("signalled EOS");
@@ -17,6 +17,7 @@
 #ifndef ANDROID_C2_SOFT_FLAC_DEC_H_
 #define ANDROID_C2_SOFT_FLAC_DEC_H_
 
+#include <C2PlatformSupport.h>
 #include <SimpleC2Component.h>
 
 #include "FLACDecoder.h"
@@ -45,11 +46,16 @@ struct C2SoftFlacDec : public SimpleC2Component {
 
 private:
     enum {
-        kMaxBlockSize   = 4096
+        kMaxBlockSize   = 4096,
+        // access units per work, each is a FLAC frame decoded on its own thread
+        kMaxAccessUnitCount = 8,
+        kMaxFrameThreads = 4,
     };
 
     std::shared_ptr<IntfImpl> mIntf;
     FLACDecoder *mFLACDecoder;
+    // cores for the frame threads of mFLACDecoder, taken on the first multi-frame work
+    std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
     FLAC__StreamMetadata_StreamInfo mStreamInfo;
     bool mSignalledError;
     bool mSignalledOutputEos;
@@ -18,6 +18,8 @@
 #define LOG_TAG "C2SoftGav1Dec"
 #include "C2SoftGav1Dec.h"
 
+#include <cutils/properties.h>
+
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
 #include <Codec2BufferUtils.h>
@@ -34,6 +36,8 @@ namespace android {
 constexpr char COMPONENT_NAME[] = CODECNAME;
 
 constexpr size_t kMinInputBufferSize = 2 * 1024 * 1024;
+// In frame parallel mode libgav1 holds up to one frame per thread.
+constexpr uint32_t kMaxOutputDelay = 32;
 
 class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
  public:
@@ -52,6 +56,13 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
                          C2Component::ATTRIB_IS_TEMPORAL))
                      .build());
 
+    addParameter(
+        DefineParam(mActualOutputDelay, C2_PARAMKEY_OUTPUT_DELAY)
+            .withDefault(new C2PortActualDelayTuning::output(0u))
+            .withFields({C2F(mActualOutputDelay, value).inRange(0, kMaxOutputDelay)})
+            .withSetter(Setter<decltype(*mActualOutputDelay)>::StrictValueWithNoDeps)
+            .build());
+
     addParameter(
         DefineParam(mSize, C2_PARAMKEY_PICTURE_SIZE)
             .withDefault(new C2StreamPictureSizeInfo::output(0u, 320, 240))
@@ -208,6 +219,13 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
             .withFields({C2F(mPixelFormat, value).oneOf(pixelFormats)})
             .withSetter((Setter<decltype(*mPixelFormat)>::StrictValueWithNoDeps))
             .build());
+
+    addParameter(
+        DefineParam(mLowLatencyMode, C2_PARAMKEY_LOW_LATENCY_MODE)
+            .withDefault(new C2GlobalLowLatencyModeTuning(C2_FALSE))
+            .withFields({C2F(mLowLatencyMode, value).oneOf({C2_FALSE, C2_TRUE})})
+            .withSetter(Setter<decltype(*mLowLatencyMode)>::NonStrictValueWithNoDeps)
+            .build());
   }
 
   static C2R SizeSetter(bool mayBlock,
@@ -330,6 +348,7 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
 
   // unsafe getters
   std::shared_ptr<C2StreamPixelFormatInfo::output> getPixelFormat_l() const { return mPixelFormat; }
+  bool getLowLatencyMode_l() const { return mLowLatencyMode->value; }
 
  private:
   std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
@@ -343,6 +362,7 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
   std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
   std::shared_ptr<C2StreamHdr10PlusInfo::input> mHdr10PlusInfoInput;
   std::shared_ptr<C2StreamHdr10PlusInfo::output> mHdr10PlusInfoOutput;
+  std::shared_ptr<C2GlobalLowLatencyModeTuning> mLowLatencyMode;
 };
 
 C2SoftGav1Dec::C2SoftGav1Dec(const char *name, c2_node_id_t id,
@@ -350,7 +370,11 @@ C2SoftGav1Dec::C2SoftGav1Dec(const char *name, c2_node_id_t id,
     : SimpleC2Component(
           std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
-      mCodecCtx(nullptr) {
+      mCodecCtx(nullptr),
+      mFrameParallel(false),
+      mFramesInFlight(0),
+      mOutputDelay(0),
+      mOutputDelayChanged(false) {
   mTimeStart = mTimeEnd = systemTime();
 }
 
@@ -396,6 +420,7 @@ c2_status_t C2SoftGav1Dec::onFlush_sm() {
     return C2_CORRUPTED;
   }
 
+  mFramesInFlight = 0;
   mSignalledError = false;
   mSignalledOutputEos = false;
 
@@ -419,9 +444,11 @@ bool C2SoftGav1Dec::initDecoder() {
   mSignalledError = false;
   mSignalledOutputEos = false;
   mHalPixelFormat = HAL_PIXEL_FORMAT_YV12;
+  bool lowLatency = false;
   {
       IntfImpl::Lock lock = mIntf->lock();
       mPixelFormatInfo = mIntf->getPixelFormat_l();
+      lowLatency = mIntf->getLowLatencyMode_l();
   }
   mCodecCtx.reset(new libgav1::Decoder());
 
@@ -430,8 +457,31 @@ bool C2SoftGav1Dec::initDecoder() {
     return false;
   }
 
+  if (!mCoreGrant) {
+    mCoreGrant = AcquireCodec2CoreBudget(GetParallelismHint(GetCPUCoreCount()));
+  }
   libgav1::DecoderSettings settings = {};
-  settings.threads = GetCPUCoreCount();
+  settings.threads = mCoreGrant->cores();
+  // Frame parallel decoding keeps up to one frame per thread in flight, which
+  // adds as many frames of latency. Real-time streams use tile and superblock
+  // row threads only.
+  mFrameParallel = settings.threads > 1 && !lowLatency &&
+                   property_get_bool("debug.stagefright.gav1.frame-parallel", true);
+  settings.frame_parallel = mFrameParallel;
+  // Dequeuing is only done when the decoder has no room for more frames, or
+  // when draining, so it may as well wait for the oldest frame.
+  settings.blocking_dequeue = mFrameParallel;
+  mFramesInFlight = 0;
+
+  uint32_t outputDelay = mFrameParallel ? c2_min((uint32_t)settings.threads, kMaxOutputDelay) : 0;
+  if (outputDelay != mOutputDelay) {
+    mOutputDelay = outputDelay;
+    mOutputDelayChanged = true;
+    C2PortActualDelayTuning::output delay(mOutputDelay);
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    (void)mIntf->config({&delay}, C2_MAY_BLOCK, &failures);
+  }
+  ALOGV("Using %d threads, frame parallel: %d", settings.threads, mFrameParallel);
 
   ALOGV("Using libgav1 AV1 software decoder.");
   Libgav1StatusCode status = mCodecCtx->Init(&settings);
@@ -443,7 +493,10 @@ bool C2SoftGav1Dec::initDecoder() {
   return true;
 }
 
-void C2SoftGav1Dec::destroyDecoder() { mCodecCtx = nullptr; }
+void C2SoftGav1Dec::destroyDecoder() {
+  mCodecCtx = nullptr;
+  mCoreGrant.reset();
+}
 
 void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
   uint32_t flags = 0;
@@ -523,6 +576,12 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
     return;
   }
 
+  if (mOutputDelayChanged) {
+    mOutputDelayChanged = false;
+    work->worklets.front()->output.configUpdate.push_back(
+        C2Param::Copy(C2PortActualDelayTuning::output(mOutputDelay)));
+  }
+
   int64_t frameIndex = work->input.ordinal.frameIndex.peekll();
   if (inSize) {
     uint8_t *bitstream = const_cast<uint8_t *>(rView.data() + inOffset);
@@ -530,9 +589,18 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
     mTimeStart = systemTime();
     nsecs_t delay = mTimeStart - mTimeEnd;
 
-    const Libgav1StatusCode status =
+    Libgav1StatusCode status =
         mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
                                 /*buffer_private_data=*/nullptr);
+    while (status == kLibgav1StatusTryAgain && mFramesInFlight > 0) {
+      // All frame threads are busy. Output the oldest frame to make room.
+      (void)outputBuffer(pool, work);
+      status = mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
+                                       /*buffer_private_data=*/nullptr);
+    }
+    if (status == kLibgav1StatusOk && mFrameParallel) {
+      ++mFramesInFlight;
+    }
 
     mTimeEnd = systemTime();
     nsecs_t decodeTime = mTimeEnd - mTimeStart;
@@ -548,7 +616,12 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
 
   }
 
-  (void)outputBuffer(pool, work);
+  // In frame parallel mode the frame was most likely not decoded yet, and
+  // dequeuing would wait for it. Its output is sent when the decoder is full
+  // or drained.
+  if (!mFrameParallel) {
+    (void)outputBuffer(pool, work);
+  }
 
   if (eos) {
     drainInternal(DRAIN_COMPONENT_WITH_EOS, pool, work);
@@ -597,10 +670,17 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
   const libgav1::DecoderBuffer *buffer;
   const Libgav1StatusCode status = mCodecCtx->DequeueFrame(&buffer);
 
+  if (status == kLibgav1StatusOk && mFramesInFlight > 0) {
+    --mFramesInFlight;
+  }
   if (status != kLibgav1StatusOk && status != kLibgav1StatusNothingToDequeue) {
     ALOGE("av1 decoder DequeueFrame failed. status: %d.", status);
+    mFramesInFlight = 0;
     return false;
   }
+  if (status == kLibgav1StatusNothingToDequeue) {
+    mFramesInFlight = 0;
+  }
 
   // |buffer| can be NULL if status was equal to kLibgav1StatusOk or
   // kLibgav1StatusNothingToDequeue. This is not an error. This could mean one
@@ -765,6 +845,12 @@ c2_status_t C2SoftGav1Dec::drainInternal(
     return C2_OMITTED;
   }
 
+  // SignalEOS() drops the frames that are still being decoded in frame
+  // parallel mode, so wait for them first.
+  while (work && pool && mFramesInFlight > 0) {
+    (void)outputBuffer(pool, work);
+  }
+
   const Libgav1StatusCode status = mCodecCtx->SignalEOS();
   if (status != kLibgav1StatusOk) {
     ALOGE("Failed to flush av1 decoder. status: %d.", status);
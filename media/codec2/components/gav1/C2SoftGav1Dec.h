@@ -23,6 +23,7 @@
 
 #include <SimpleC2Component.h>
 #include <C2Config.h>
+#include <C2PlatformSupport.h>
 #include "libgav1/src/gav1/decoder.h"
 #include "libgav1/src/gav1/decoder_settings.h"
 
@@ -50,6 +51,17 @@ struct C2SoftGav1Dec : public SimpleC2Component {
  private:
   std::shared_ptr<IntfImpl> mIntf;
   std::unique_ptr<libgav1::Decoder> mCodecCtx;
+  std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
+
+  // Whether libgav1 decodes several frames in parallel, and how many frames
+  // have been enqueued but not dequeued in that mode.
+  bool mFrameParallel;
+  size_t mFramesInFlight;
+
+  // Output delay of the current decoder configuration, and whether it has yet
+  // to be reported in a work.
+  uint32_t mOutputDelay;
+  bool mOutputDelayChanged;
 
   // configurations used by component in process
   // (TODO: keep this in intf but make them internal only)
@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <inttypes.h>
+#include <C2PlatformSupport.h>
 #include <SimpleC2Component.h>
 
 #include "ihevc_typedefs.h"
@@ -66,6 +67,7 @@ struct C2SoftHevcDec : public SimpleC2Component {
  private:
     status_t createDecoder();
     status_t setNumCores();
+    void updateNumCores();
     status_t setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode);
     status_t getVersion();
     status_t initDecoder();
@@ -110,6 +112,7 @@ struct C2SoftHevcDec : public SimpleC2Component {
     uint8_t *mOutBufferFlush;
 
     size_t mNumCores;
+    std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
     IV_COLOR_FORMAT_T mIvColorformat;
     uint32_t mOutputDelay;
     uint32_t mWidth;
@@ -571,7 +571,7 @@ status_t C2SoftMpeg2Dec::initDecoder() {
 
     if (OK != createDecoder()) return UNKNOWN_ERROR;
 
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    mNumCores = MIN(GetParallelismHint(getCpuCoreCount()), MAX_NUM_CORES);
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
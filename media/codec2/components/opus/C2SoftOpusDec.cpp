@@ -34,6 +34,8 @@ namespace android {
 namespace {
 
 constexpr char COMPONENT_NAME[] = "c2.android.opus.decoder";
+// Access units decoded per work, bounding the output block to about 1 MB for 8 channels.
+constexpr uint32_t kMaxAccessUnitCount = 10;
 
 }  // namespace
 
@@ -84,6 +86,11 @@ public:
                 DefineParam(mInputMaxBufSize, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE)
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 960 * 6))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitCount))
+                .build());
     }
 
 private:
@@ -91,6 +98,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
 };
 
 C2SoftOpusDec::C2SoftOpusDec(const char *name, c2_node_id_t id,
@@ -369,15 +377,19 @@ void C2SoftOpusDec::process(
         return;
     }
 
-    // When seeking to zero, |mCodecDelay| samples has to be discarded
-    // instead of |mSeekPreRoll| samples (as we would when seeking to any
-    // other timestamp).
-    if (work->input.ordinal.timestamp.peeku() == 0) mSamplesToDiscard = mCodecDelay;
+    // The work may carry several access units, which are decoded into a single output buffer.
+    std::vector<C2AccessUnitInfosStruct> accessUnits = GetInputAccessUnits(work, inSize);
+    if (accessUnits.empty()) {
+        mSignalledError = true;
+        work->result = C2_CORRUPTED;
+        return;
+    }
 
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchLinearBlock(
-                          kMaxNumSamplesPerBuffer * kMaxChannels * sizeof(int16_t),
+                          accessUnits.size() * kMaxNumSamplesPerBuffer * mHeader.channels
+                                  * sizeof(int16_t),
                           usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
@@ -391,40 +403,62 @@ void C2SoftOpusDec::process(
         return;
     }
 
-    int numSamples = opus_multistream_decode(mDecoder,
-                                             data,
-                                             inSize,
-                                             reinterpret_cast<int16_t *> (wView.data()),
-                                             kMaxOpusOutputPacketSizeSamples,
-                                             0);
-    if (numSamples < 0) {
-        ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
-        numSamples = 0;
-        mSignalledError = true;
-        work->result = C2_CORRUPTED;
-        return;
-    }
-
-    int outOffset = 0;
-    if (mSamplesToDiscard > 0) {
-        if (mSamplesToDiscard > numSamples) {
-            mSamplesToDiscard -= numSamples;
+    int16_t *output = reinterpret_cast<int16_t *>(wView.data());
+    size_t outSize = 0;
+    std::vector<C2AccessUnitInfosStruct> outInfos;
+    for (const C2AccessUnitInfosStruct &au : accessUnits) {
+        // When seeking to zero, |mCodecDelay| samples has to be discarded
+        // instead of |mSeekPreRoll| samples (as we would when seeking to any
+        // other timestamp).
+        if (au.timestamp == 0) mSamplesToDiscard = mCodecDelay;
+
+        int16_t *auOutput = output + outSize / sizeof(int16_t);
+        int numSamples = opus_multistream_decode(mDecoder,
+                                                 data,
+                                                 au.size,
+                                                 auOutput,
+                                                 kMaxOpusOutputPacketSizeSamples,
+                                                 0);
+        data += au.size;
+        if (numSamples < 0) {
+            ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
             numSamples = 0;
-        } else {
-            numSamples -= mSamplesToDiscard;
-            outOffset = mSamplesToDiscard * sizeof(int16_t) * mHeader.channels;
-            mSamplesToDiscard = 0;
+            mSignalledError = true;
+            work->result = C2_CORRUPTED;
+            return;
+        }
+
+        if (mSamplesToDiscard > 0) {
+            if (mSamplesToDiscard > numSamples) {
+                mSamplesToDiscard -= numSamples;
+                numSamples = 0;
+            } else {
+                numSamples -= mSamplesToDiscard;
+                memmove(auOutput, auOutput + mSamplesToDiscard * mHeader.channels,
+                        numSamples * sizeof(int16_t) * mHeader.channels);
+                mSamplesToDiscard = 0;
+            }
+        }
+
+        if (numSamples) {
+            size_t auOutSize = numSamples * sizeof(int16_t) * mHeader.channels;
+            outInfos.emplace_back(au.flags, auOutSize, au.timestamp);
+            outSize += auOutSize;
         }
     }
 
-    if (numSamples) {
-        int outSize = numSamples * sizeof(int16_t) * mHeader.channels;
-        ALOGV("out buffer attr. offset %d size %d ", outOffset, outSize);
+    if (outSize) {
+        ALOGV("out buffer attr. size %zu, %zu access units", outSize, outInfos.size());
 
+        std::shared_ptr<C2Buffer> buffer = createLinearBuffer(block, 0, outSize);
+        work->worklets.front()->output.ordinal = work->input.ordinal;
+        if (accessUnits.size() > 1) {
+            buffer->setInfo(C2StreamAccessUnitInfos::output::AllocShared(outInfos, 0u));
+            work->worklets.front()->output.ordinal.timestamp = outInfos.front().timestamp;
+        }
         work->worklets.front()->output.flags = work->input.flags;
         work->worklets.front()->output.buffers.clear();
-        work->worklets.front()->output.buffers.push_back(createLinearBuffer(block, outOffset, outSize));
-        work->worklets.front()->output.ordinal = work->input.ordinal;
+        work->worklets.front()->output.buffers.push_back(buffer);
         work->workletsProcessed = 1u;
     } else {
         fillEmptyWork(work);
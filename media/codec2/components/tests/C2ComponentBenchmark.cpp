@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of Codec 2.0 components from the platform store.
+//
+// Each run feeds an elementary stream, described by an .info file in the
+// format of the codec2 VTS resources (one "<size> <flags> <timestamp>" line
+// per access unit), through 1..N concurrent instances of a component. It
+// reports the aggregate frame rate, the per-frame latency percentiles (from
+// queue_nb() to onWorkDone_nb()) and the CPU time of the process.
+//
+// Usage:
+//   C2ComponentBenchmark [-P <resource dir>] [-n <max instances>] [-r <repeat>]
+//                        [<component> <stream> [<info>]]
+// Without a component, the software decoders are measured with the streams
+// of the codec2 VTS resources in the resource directory (by default, the
+// directory of this binary).
+
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <C2Buffer.h>
+#include <C2Component.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <C2Work.h>
+
+using namespace android;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+constexpr uint32_t kDefaultMaxInstances = 4;
+constexpr std::chrono::seconds kTimeout(10);
+
+struct Target {
+    const char *component;
+    const char *stream;
+    const char *info;
+};
+
+const Target kDefaultTargets[] = {
+    { "c2.android.avc.decoder",
+      "bbb_avc_640x360_768kbps_30fps.h264", "bbb_avc_640x360_768kbps_30fps.info" },
+    { "c2.android.hevc.decoder",
+      "bbb_hevc_640x360_1600kbps_30fps.hevc", "bbb_hevc_640x360_1600kbps_30fps.info" },
+    { "c2.android.vp8.decoder",
+      "bbb_vp8_640x360_2mbps_30fps.vp8", "bbb_vp8_640x360_2mbps_30fps.info" },
+    { "c2.android.vp9.decoder",
+      "bbb_vp9_640x360_1600kbps_30fps.vp9", "bbb_vp9_640x360_1600kbps_30fps.info" },
+    { "c2.android.av1.decoder", "bbb_av1_640_360.av1", "bbb_av1_640_360.info" },
+    { "c2.android.aac.decoder",
+      "bbb_aac_stereo_128kbps_48000hz.aac", "bbb_aac_stereo_128kbps_48000hz.info" },
+    { "c2.android.opus.decoder",
+      "bbb_opus_stereo_128kbps_48000hz.opus", "bbb_opus_stereo_128kbps_48000hz.info" },
+    { "c2.android.flac.decoder",
+      "bbb_flac_stereo_680kbps_48000hz.flac", "bbb_flac_stereo_680kbps_48000hz.info" },
+};
+
+struct AccessUnit {
+    std::vector<uint8_t> data;
+    uint32_t flags;
+    int64_t timestamp;
+};
+
+// Reads |stream| split as described by |info|.
+bool readStream(const std::string &stream, const std::string &info,
+                std::vector<AccessUnit> *units) {
+    FILE *fpStream = fopen(stream.c_str(), "rb");
+    FILE *fpInfo = fopen(info.c_str(), "r");
+    bool ok = fpStream != nullptr && fpInfo != nullptr;
+    if (!ok) {
+        fprintf(stderr, "Could not open %s or %s\n", stream.c_str(), info.c_str());
+    }
+    int size = 0;
+    uint32_t flags = 0;
+    long long timestamp = 0;
+    while (ok && fscanf(fpInfo, "%d %u %lld", &size, &flags, &timestamp) == 3) {
+        AccessUnit unit;
+        unit.data.resize(size < 0 ? 0 : size);
+        // flags hold the 1-based index of a C2FrameData flag, e.g. 32 for
+        // FLAG_CODEC_CONFIG
+        unit.flags = flags ? (1u << (flags - 1)) & C2FrameData::FLAG_CODEC_CONFIG : 0;
+        unit.timestamp = timestamp;
+        ok = fread(unit.data.data(), 1, unit.data.size(), fpStream) == unit.data.size();
+        units->push_back(std::move(unit));
+    }
+    if (fpStream) {
+        fclose(fpStream);
+    }
+    if (fpInfo) {
+        fclose(fpInfo);
+    }
+    if (ok && units->empty()) {
+        fprintf(stderr, "%s describes no access units\n", info.c_str());
+        ok = false;
+    }
+    return ok;
+}
+
+class Listener : public C2Component::Listener {
+public:
+    explicit Listener(size_t count) : mQueueTimes(count), mLatenciesUs(count, -1) {}
+
+    void onWorkDone_nb(
+            std::weak_ptr<C2Component>, std::list<std::unique_ptr<C2Work>> workItems) override {
+        Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            if (work->result != C2_OK && work->result != C2_NOT_FOUND) {
+                mError = true;
+            }
+            if (!work->worklets.empty()) {
+                for (const std::unique_ptr<C2Param> &param :
+                        work->worklets.front()->output.configUpdate) {
+                    if (param && param->index() == C2PortActualDelayTuning::output::PARAM_TYPE) {
+                        mOutputDelay = C2PortActualDelayTuning::output::From(
+                                param.get())->value;
+                    }
+                }
+            }
+            uint64_t index = work->input.ordinal.frameIndex.peeku();
+            if (index < mLatenciesUs.size()) {
+                mLatenciesUs[index] = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - mQueueTimes[index]).count();
+            }
+            ++mDone;
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(
+            std::weak_ptr<C2Component>,
+            std::vector<std::shared_ptr<C2SettingResult>>) override {
+    }
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mError = true;
+        mCondition.notify_all();
+    }
+
+    void onQueued(size_t index) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mQueueTimes[index] = Clock::now();
+    }
+
+    // Waits until fewer works than the component can hold are pending out of
+    // |queued|, or all of them are done if |all| is set. Returns false on
+    // error or time out.
+    bool waitFor(size_t queued, uint32_t delay, bool all) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout, [this, queued, delay, all] {
+            return mError || mDone + (all ? 0 : delay + mOutputDelay + 1) >= queued;
+        }) && !mError;
+    }
+
+    void setOutputDelay(uint32_t delay) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mOutputDelay = delay;
+    }
+
+    std::vector<int64_t> latenciesUs() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mLatenciesUs;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<Clock::time_point> mQueueTimes;
+    std::vector<int64_t> mLatenciesUs;
+    size_t mDone = 0;
+    uint32_t mOutputDelay = 0;
+    bool mError = false;
+};
+
+// Runs one instance through |units| |repeat| times. Appends the latency of
+// each frame to |latenciesUs|.
+bool runInstance(const std::string &name, const std::vector<AccessUnit> &units,
+                 uint32_t repeat, std::vector<int64_t> *latenciesUs) {
+    std::shared_ptr<C2ComponentStore> store = GetCodec2PlatformComponentStore();
+    std::shared_ptr<C2Component> component;
+    if (store->createComponent(name, &component) != C2_OK) {
+        fprintf(stderr, "Failed to create %s\n", name.c_str());
+        return false;
+    }
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK) {
+        fprintf(stderr, "Failed to get the linear block pool\n");
+        return false;
+    }
+
+    size_t count = units.size() * repeat;
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>(count);
+    if (component->setListener_vb(listener, C2_MAY_BLOCK) != C2_OK
+            || component->start() != C2_OK) {
+        fprintf(stderr, "Failed to start %s\n", name.c_str());
+        return false;
+    }
+    // keep as many works queued as the component can hold, like CCodec does
+    C2PortActualDelayTuning::input inputDelay(0);
+    C2PortActualDelayTuning::output outputDelay(0);
+    C2ActualPipelineDelayTuning pipelineDelay(0);
+    (void)component->intf()->query_vb(
+            { &inputDelay, &outputDelay, &pipelineDelay }, {}, C2_MAY_BLOCK, nullptr);
+    listener->setOutputDelay(outputDelay.value);
+    uint32_t delay = inputDelay.value + pipelineDelay.value;
+
+    bool ok = true;
+    int64_t duration = units.back().timestamp + 1;
+    for (size_t n = 0; n < count && ok; ++n) {
+        const AccessUnit &unit = units[n % units.size()];
+        uint32_t round = n / units.size();
+        if (round > 0 && (unit.flags & C2FrameData::FLAG_CODEC_CONFIG)) {
+            // codec config is only sent once
+            listener->onQueued(n);
+            std::unique_ptr<C2Work> work(new C2Work);
+            work->input.ordinal.frameIndex = n;
+            std::list<std::unique_ptr<C2Work>> items;
+            items.push_back(std::move(work));
+            listener->onWorkDone_nb(component, std::move(items));
+            continue;
+        }
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.flags = (C2FrameData::flags_t)(
+                unit.flags | (n + 1 == count ? C2FrameData::FLAG_END_OF_STREAM : 0));
+        work->input.ordinal.timestamp = unit.timestamp + round * duration;
+        work->input.ordinal.frameIndex = n;
+        if (!unit.data.empty()) {
+            std::shared_ptr<C2LinearBlock> block;
+            if (pool->fetchLinearBlock(
+                    unit.data.size(), { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                    &block) != C2_OK) {
+                ok = false;
+                break;
+            }
+            C2WriteView view = block->map().get();
+            if (view.error() != C2_OK) {
+                ok = false;
+                break;
+            }
+            memcpy(view.base(), unit.data.data(), unit.data.size());
+            work->input.buffers.emplace_back(C2Buffer::CreateLinearBuffer(
+                    block->share(0, unit.data.size(), C2Fence())));
+        }
+        work->worklets.emplace_back(new C2Worklet);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        listener->onQueued(n);
+        ok = component->queue_nb(&items) == C2_OK
+                && listener->waitFor(n + 1, delay, false);
+    }
+    ok = ok && listener->waitFor(count, delay, true);
+
+    component->stop();
+    component->release();
+    if (!ok) {
+        fprintf(stderr, "Failed to run %s\n", name.c_str());
+        return false;
+    }
+    for (int64_t latencyUs : listener->latenciesUs()) {
+        if (latencyUs >= 0) {
+            latenciesUs->push_back(latencyUs);
+        }
+    }
+    return true;
+}
+
+int64_t cpuTimeUs() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ll
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+int64_t percentile(const std::vector<int64_t> &sorted, uint32_t percent) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+bool benchmark(const std::string &name, const std::string &stream, const std::string &info,
+               uint32_t maxInstances, uint32_t repeat) {
+    std::vector<AccessUnit> units;
+    if (!readStream(stream, info, &units)) {
+        return false;
+    }
+    printf("%s: %s, %zu access units x %u\n", name.c_str(),
+           stream.substr(stream.rfind('/') + 1).c_str(), units.size(), repeat);
+    printf("  instances      fps    p50 ms    p90 ms    p99 ms   cpu ms   cpu/wall\n");
+    for (uint32_t instances = 1; instances <= maxInstances; ++instances) {
+        std::vector<std::vector<int64_t>> latenciesUs(instances);
+        std::vector<std::thread> threads;
+        std::vector<char> results(instances, false);
+        int64_t cpuStartUs = cpuTimeUs();
+        Clock::time_point start = Clock::now();
+        for (uint32_t i = 0; i < instances; ++i) {
+            threads.emplace_back([&, i] {
+                results[i] = runInstance(name, units, repeat, &latenciesUs[i]);
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        int64_t cpuUs = cpuTimeUs() - cpuStartUs;
+        if (std::find(results.begin(), results.end(), false) != results.end()) {
+            return false;
+        }
+
+        std::vector<int64_t> all;
+        for (const std::vector<int64_t> &l : latenciesUs) {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+        std::sort(all.begin(), all.end());
+        printf("  %9u %8.1f %9.2f %9.2f %9.2f %8.1f %10.2f\n", instances,
+               seconds > 0 ? all.size() / seconds : 0.,
+               percentile(all, 50) / 1000., percentile(all, 90) / 1000.,
+               percentile(all, 99) / 1000., cpuUs / 1000.,
+               seconds > 0 ? cpuUs / (seconds * 1e6) : 0.);
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::string resourceDir = dirname(argv[0]);
+    uint32_t maxInstances = kDefaultMaxInstances;
+    uint32_t repeat = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "P:n:r:")) != -1) {
+        switch (opt) {
+            case 'P': resourceDir = optarg; break;
+            case 'n': maxInstances = atoi(optarg); break;
+            case 'r': repeat = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage %s [-P <resource dir>] [-n <max instances>] "
+                        "[-r <repeat>] [<component> <stream> [<info>]]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (maxInstances == 0 || repeat == 0) {
+        fprintf(stderr, "Instances and repeat must be positive\n");
+        return EXIT_FAILURE;
+    }
+    if (!resourceDir.empty() && resourceDir.back() != '/') {
+        resourceDir += '/';
+    }
+
+    if (optind + 1 < argc) {
+        std::string stream = argv[optind + 1];
+        std::string info = optind + 2 < argc ? std::string(argv[optind + 2])
+                : stream.substr(0, stream.rfind('.')) + ".info";
+        return benchmark(argv[optind], stream, info, maxInstances, repeat)
+                ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (const Target &target : kDefaultTargets) {
+        if (!benchmark(target.component, resourceDir + target.stream,
+                       resourceDir + target.info, maxInstances, repeat)) {
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
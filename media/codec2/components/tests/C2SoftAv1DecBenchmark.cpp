@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decodes an AV1 IVF file through the av1 decoder component, with and without
+// low latency mode, and reports the frame rate of each run.
+//
+// Usage: C2SoftGav1DecBenchmark|C2SoftAomDecBenchmark <input ivf> [<repeat>]
+// Use 1080p and 4K clips to compare with the hardware decoders. The number of
+// decoder threads follows the core budget, which can be limited with
+// media.stagefright.c2-core-budget.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <C2Buffer.h>
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <C2Work.h>
+
+using namespace android;
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace {
+
+constexpr size_t kIvfFileHeaderSize = 32;
+constexpr size_t kIvfFrameHeaderSize = 12;
+// more than the output delay of any av1 decoder configuration
+constexpr size_t kMaxWorksInFlight = 48;
+constexpr std::chrono::seconds kTimeout(10);
+
+struct Stream {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+uint32_t readLe(const uint8_t *data, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = size; i > 0; --i) {
+        value = (value << 8) | data[i - 1];
+    }
+    return value;
+}
+
+bool readIvf(const char *path, Stream *stream) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+    uint8_t header[kIvfFileHeaderSize];
+    bool ok = fread(header, 1, sizeof(header), fp) == sizeof(header)
+            && memcmp(header, "DKIF", 4) == 0 && memcmp(header + 8, "AV01", 4) == 0;
+    if (ok) {
+        stream->width = readLe(header + 12, 2);
+        stream->height = readLe(header + 14, 2);
+        // skip the rest of a longer header
+        ok = fseek(fp, readLe(header + 6, 2), SEEK_SET) == 0;
+    }
+    uint8_t frameHeader[kIvfFrameHeaderSize];
+    while (ok && fread(frameHeader, 1, sizeof(frameHeader), fp) == sizeof(frameHeader)) {
+        std::vector<uint8_t> frame(readLe(frameHeader, 4));
+        ok = fread(frame.data(), 1, frame.size(), fp) == frame.size();
+        stream->frames.push_back(std::move(frame));
+    }
+    fclose(fp);
+    if (!ok || stream->frames.empty()) {
+        fprintf(stderr, "%s is not an AV1 IVF file\n", path);
+        return false;
+    }
+    return true;
+}
+
+class Listener : public C2Component::Listener {
+public:
+    void onWorkDone_nb(
+            std::weak_ptr<C2Component>, std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            if (work->result != C2_OK && work->result != C2_NOT_FOUND) {
+                mError = true;
+            }
+            if (!work->worklets.empty()
+                    && !work->worklets.front()->output.buffers.empty()) {
+                ++mFrames;
+            }
+            ++mDone;
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(
+            std::weak_ptr<C2Component>,
+            std::vector<std::shared_ptr<C2SettingResult>>) override {
+    }
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mError = true;
+        mCondition.notify_all();
+    }
+
+    // Waits until at most |inFlight| of |queued| works are pending. Returns
+    // false on error or time out.
+    bool waitFor(size_t queued, size_t inFlight) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout, [this, queued, inFlight] {
+            return mError || mDone + inFlight >= queued;
+        }) && !mError;
+    }
+
+    size_t frames() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mFrames;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    size_t mDone = 0;
+    size_t mFrames = 0;
+    bool mError = false;
+};
+
+enum Result {
+    kOk,
+    kUnsupported,
+    kError,
+};
+
+Result decode(C2ComponentFactory *factory, const Stream &stream, uint32_t repeat,
+              bool lowLatency, double *fps) {
+    std::shared_ptr<C2Component> component;
+    if (factory->createComponent(0, &component, std::default_delete<C2Component>()) != C2_OK) {
+        fprintf(stderr, "Failed to create the component\n");
+        return kError;
+    }
+
+    C2StreamMaxPictureSizeTuning::output maxSize(0u, stream.width, stream.height);
+    C2GlobalLowLatencyModeTuning lowLatencyMode(lowLatency ? C2_TRUE : C2_FALSE);
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    (void)component->intf()->config_vb({ &maxSize }, C2_MAY_BLOCK, &failures);
+    if (lowLatency) {
+        failures.clear();
+        if (component->intf()->config_vb({ &lowLatencyMode }, C2_MAY_BLOCK, &failures) != C2_OK
+                || !failures.empty()) {
+            return kUnsupported;
+        }
+    }
+
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK) {
+        fprintf(stderr, "Failed to get the linear block pool\n");
+        return kError;
+    }
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+    if (component->setListener_vb(listener, C2_MAY_BLOCK) != C2_OK
+            || component->start() != C2_OK) {
+        fprintf(stderr, "Failed to start the component\n");
+        return kError;
+    }
+
+    bool ok = true;
+    size_t count = stream.frames.size() * repeat;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < count && ok; ++n) {
+        const std::vector<uint8_t> &frame = stream.frames[n % stream.frames.size()];
+        std::shared_ptr<C2LinearBlock> block;
+        ok = pool->fetchLinearBlock(
+                frame.size(), { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                &block) == C2_OK;
+        if (!ok) {
+            break;
+        }
+        C2WriteView view = block->map().get();
+        if (view.error() != C2_OK) {
+            ok = false;
+            break;
+        }
+        memcpy(view.base(), frame.data(), frame.size());
+
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.flags = (C2FrameData::flags_t)(
+                n + 1 == count ? C2FrameData::FLAG_END_OF_STREAM : 0);
+        work->input.ordinal.timestamp = n * 33333;
+        work->input.ordinal.frameIndex = n;
+        work->input.buffers.emplace_back(C2Buffer::CreateLinearBuffer(
+                block->share(0, frame.size(), C2Fence())));
+        work->worklets.emplace_back(new C2Worklet);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        ok = component->queue_nb(&items) == C2_OK
+                && listener->waitFor(n + 1, kMaxWorksInFlight);
+    }
+    ok = ok && listener->waitFor(count, 0);
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    *fps = seconds.count() > 0 ? listener->frames() / seconds.count() : 0;
+
+    component->stop();
+    component->release();
+    if (!ok) {
+        fprintf(stderr, "Failed to decode\n");
+        return kError;
+    }
+    return kOk;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage %s <input ivf> [<repeat>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint32_t repeat = argc > 2 ? atoi(argv[2]) : 1;
+    Stream stream;
+    if (repeat == 0 || !readIvf(argv[1], &stream)) {
+        return EXIT_FAILURE;
+    }
+
+    C2ComponentFactory *factory = CreateCodec2Factory();
+    printf("%ux%u, %zu frames\n", stream.width, stream.height,
+           stream.frames.size() * repeat);
+    int result = EXIT_SUCCESS;
+    for (bool lowLatency : { false, true }) {
+        double fps = 0;
+        Result res = decode(factory, stream, repeat, lowLatency, &fps);
+        if (res == kError) {
+            result = EXIT_FAILURE;
+            break;
+        }
+        if (res == kUnsupported) {
+            printf("low latency %3s: not supported\n", lowLatency ? "on" : "off");
+        } else {
+            printf("low latency %3s: %8.1f fps\n", lowLatency ? "on" : "off", fps);
+        }
+    }
+    DestroyCodec2Factory(factory);
+    return result;
+}
@@ -60,6 +60,14 @@ vpx_codec_err_t C2SoftVp8Enc::setCodecSpecificControls() {
                                                      mDCTPartitions);
     if (codec_return != VPX_CODEC_OK) {
         ALOGE("Error setting dct partitions for vpx encoder.");
+        return codec_return;
+    }
+    // 0 keeps the default speed, or the one set for constant bitrate
+    if (mThreading->speed != 0) {
+        codec_return = vpx_codec_control(mCodecContext, VP8E_SET_CPUUSED, mThreading->speed);
+        if (codec_return != VPX_CODEC_OK) {
+            ALOGE("Error setting VP8E_SET_CPUUSED to %d for vpx encoder.", mThreading->speed);
+        }
     }
     return codec_return;
 }
@@ -28,7 +28,6 @@ C2SoftVp9Enc::C2SoftVp9Enc(const char* name, c2_node_id_t id,
     : C2SoftVpxEnc(name, id, intfImpl),
       mProfile(1),
       mLevel(0),
-      mTileColumns(0),
       mFrameParallelDecoding(false) {
 }
 
@@ -61,10 +60,10 @@ void C2SoftVp9Enc::setCodecSpecificConfiguration() {
 
 vpx_codec_err_t C2SoftVp9Enc::setCodecSpecificControls() {
     vpx_codec_err_t codecReturn = vpx_codec_control(
-            mCodecContext, VP9E_SET_TILE_COLUMNS, mTileColumns);
+            mCodecContext, VP9E_SET_TILE_COLUMNS, mTileColumnsLog2);
     if (codecReturn != VPX_CODEC_OK) {
         ALOGE("Error setting VP9E_SET_TILE_COLUMNS to %d. vpx_codec_control() "
-              "returned %d", mTileColumns, codecReturn);
+              "returned %d", mTileColumnsLog2, codecReturn);
         return codecReturn;
     }
     codecReturn = vpx_codec_control(
@@ -76,19 +75,20 @@ vpx_codec_err_t C2SoftVp9Enc::setCodecSpecificControls() {
               codecReturn);
         return codecReturn;
     }
-    codecReturn = vpx_codec_control(mCodecContext, VP9E_SET_ROW_MT, 1);
+    int rowMt = mThreading->rowMt ? 1 : 0;
+    codecReturn = vpx_codec_control(mCodecContext, VP9E_SET_ROW_MT, rowMt);
     if (codecReturn != VPX_CODEC_OK) {
-        ALOGE("Error setting VP9E_SET_ROW_MT to 1. vpx_codec_control() "
-              "returned %d", codecReturn);
+        ALOGE("Error setting VP9E_SET_ROW_MT to %d. vpx_codec_control() "
+              "returned %d", rowMt, codecReturn);
         return codecReturn;
     }
 
-    // For VP9, we always set CPU_USED to 8 (because the realtime default is 0
-    // which is too slow).
-    codecReturn = vpx_codec_control(mCodecContext, VP8E_SET_CPUUSED, 8);
+    // The speed defaults to 8 because the realtime default of libvpx is 0,
+    // which is too slow.
+    codecReturn = vpx_codec_control(mCodecContext, VP8E_SET_CPUUSED, mThreading->speed);
     if (codecReturn != VPX_CODEC_OK) {
-        ALOGE("Error setting VP8E_SET_CPUUSED to 8. vpx_codec_control() "
-              "returned %d", codecReturn);
+        ALOGE("Error setting VP8E_SET_CPUUSED to %d. vpx_codec_control() "
+              "returned %d", mThreading->speed, codecReturn);
         return codecReturn;
     }
     return codecReturn;
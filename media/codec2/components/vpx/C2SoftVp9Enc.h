@@ -25,8 +25,7 @@ namespace android {
 //
 // In addition to the base class settings, Only following encoder settings are
 // available:
-//    - tile rows
-//    - tile columns
+//    - tile columns and row based multithreading (C2StreamEncoderThreadingTuning)
 //    - frame parallel mode
 struct C2SoftVp9Enc : public C2SoftVpxEnc {
     C2SoftVp9Enc(const char* name, c2_node_id_t id,
@@ -47,8 +46,6 @@ struct C2SoftVp9Enc : public C2SoftVpxEnc {
     int32_t mProfile;
     int32_t mLevel __unused;
 
-    int32_t mTileColumns;
-
     bool mFrameParallelDecoding;
 
     C2_DO_NOT_COPY(C2SoftVp9Enc);
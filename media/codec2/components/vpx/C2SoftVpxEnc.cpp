@@ -18,6 +18,7 @@
 #define LOG_TAG "C2SoftVpxEnc"
 #include <log/log.h>
 #include <utils/misc.h>
+#include <unistd.h>
 
 #include <media/hardware/VideoAPI.h>
 
@@ -31,6 +32,26 @@
 
 namespace android {
 
+namespace {
+
+// Range of the cpu-used speed control of libvpx.
+#ifdef VP9
+constexpr int32_t kMinSpeed = -9;
+constexpr int32_t kMaxSpeed = 9;
+#else
+constexpr int32_t kMinSpeed = -16;
+constexpr int32_t kMaxSpeed = 16;
+#endif
+
+// libvpx does not use more threads than this.
+constexpr uint32_t kMaxThreads = 64;
+
+// VP9 supports up to 64 tile columns, each at least 256 pixels wide.
+constexpr int32_t kMaxTileColumnsLog2 = 6;
+constexpr uint32_t kMinTileWidth = 256;
+
+} // namespace
+
 C2SoftVpxEnc::IntfImpl::IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helper)
     : SimpleInterface<void>::BaseParams(
             helper,
@@ -189,6 +210,24 @@ C2SoftVpxEnc::IntfImpl::IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helpe
             })
             .withSetter(CodedColorAspectsSetter, mColorAspects)
             .build());
+
+    addParameter(
+            DefineParam(mThreading, C2_PARAMKEY_ENCODER_THREADING)
+#ifdef VP9
+            // keep the realtime speed used before this was configurable
+            .withDefault(new C2StreamEncoderThreadingTuning::output(0u, 0, -1, C2_TRUE, 8))
+#else
+            // speed 0 keeps the libvpx default (-8 for constant bitrate)
+            .withDefault(new C2StreamEncoderThreadingTuning::output(0u, 0, -1, C2_FALSE, 0))
+#endif
+            .withFields({
+                C2F(mThreading, threadCount).inRange(0, kMaxThreads),
+                C2F(mThreading, tileColumnsLog2).inRange(-1, kMaxTileColumnsLog2),
+                C2F(mThreading, rowMt).oneOf({ C2_FALSE, C2_TRUE }),
+                C2F(mThreading, speed).inRange(kMinSpeed, kMaxSpeed),
+            })
+            .withSetter(ThreadingSetter)
+            .build());
 }
 
 C2R C2SoftVpxEnc::IntfImpl::BitrateSetter(bool mayBlock, C2P<C2StreamBitrateInfo::output> &me) {
@@ -245,6 +284,18 @@ C2R C2SoftVpxEnc::IntfImpl::LayeringSetter(bool mayBlock,
     return res;
 }
 
+C2R C2SoftVpxEnc::IntfImpl::ThreadingSetter(bool mayBlock,
+                                            C2P<C2StreamEncoderThreadingTuning::output>& me) {
+    (void)mayBlock;
+    if (me.v.threadCount > kMaxThreads) {
+        me.set().threadCount = kMaxThreads;
+    }
+    me.set().tileColumnsLog2 = c2_clamp(-1, me.v.tileColumnsLog2, kMaxTileColumnsLog2);
+    me.set().rowMt = me.v.rowMt ? C2_TRUE : C2_FALSE;
+    me.set().speed = c2_clamp(kMinSpeed, me.v.speed, kMaxSpeed);
+    return C2R::Ok();
+}
+
 uint32_t C2SoftVpxEnc::IntfImpl::getSyncFramePeriod() const {
     if (mSyncFramePeriod->value < 0 || mSyncFramePeriod->value == INT64_MAX) {
         return 0;
@@ -280,7 +331,6 @@ C2R C2SoftVpxEnc::IntfImpl::CodedColorAspectsSetter(
     return C2R::Ok();
 }
 
-#if 0
 static size_t getCpuCoreCount() {
     long cpuCoreCount = 1;
 #if defined(_SC_NPROCESSORS_ONLN)
@@ -289,11 +339,36 @@ static size_t getCpuCoreCount() {
     // _SC_NPROC_ONLN must be defined...
     cpuCoreCount = sysconf(_SC_NPROC_ONLN);
 #endif
-    CHECK(cpuCoreCount >= 1);
+    if (cpuCoreCount < 1) {
+        cpuCoreCount = 1;
+    }
     ALOGV("Number of CPU cores: %ld", cpuCoreCount);
     return (size_t)cpuCoreCount;
 }
-#endif
+
+// Number of threads worth using for a picture size. Small pictures do not have
+// enough macroblock rows to keep more threads busy, and the extra threads only
+// add synchronization overhead.
+static uint32_t getMaxThreadsForSize(uint32_t width, uint32_t height) {
+    uint64_t pixels = (uint64_t)width * height;
+    if (pixels >= 1920 * 1080) {
+        return 8;
+    } else if (pixels >= 1280 * 720) {
+        return 4;
+    } else if (pixels >= 640 * 360) {
+        return 2;
+    }
+    return 1;
+}
+
+// Largest log2 of the tile column count for a picture width.
+static int32_t getMaxTileColumnsLog2(uint32_t width) {
+    int32_t log2 = 0;
+    while (log2 < kMaxTileColumnsLog2 && (width >> (log2 + 1)) >= kMinTileWidth) {
+        ++log2;
+    }
+    return log2;
+}
 
 C2SoftVpxEnc::C2SoftVpxEnc(const char* name, c2_node_id_t id,
                            const std::shared_ptr<IntfImpl>& intfImpl)
@@ -315,7 +390,9 @@ C2SoftVpxEnc::C2SoftVpxEnc(const char* name, c2_node_id_t id,
       mTemporalPatternIdx(0),
       mLastTimestamp(0x7FFFFFFFFFFFFFFFull),
       mSignalledOutputEos(false),
-      mSignalledError(false) {
+      mSignalledError(false),
+      mNumThreads(1),
+      mTileColumnsLog2(0) {
     for (int i = 0; i < MAXTEMPORALLAYERS; i++) {
         mTemporalLayerBitrateRatio[i] = 1.0f;
     }
@@ -344,6 +421,7 @@ void C2SoftVpxEnc::onRelease() {
 
     // this one is not allocated by us
     mCodecInterface = nullptr;
+    mCoreGrant.reset();
 }
 
 c2_status_t C2SoftVpxEnc::onStop() {
@@ -375,6 +453,21 @@ status_t C2SoftVpxEnc::initEncoder() {
         mRequestSync = mIntf->getRequestSync_l();
         mLayering = mIntf->getTemporalLayers_l();
         mTemporalLayers = mLayering->m.layerCount;
+        mThreading = mIntf->getThreading_l();
+    }
+
+    mNumThreads = mThreading->threadCount;
+    if (mNumThreads == 0) {
+        mCoreGrant = AcquireCodec2CoreBudget(
+                c2_min((uint32_t)GetParallelismHint(getCpuCoreCount()),
+                       getMaxThreadsForSize(mSize->width, mSize->height)));
+        mNumThreads = mCoreGrant->cores();
+    }
+    mTileColumnsLog2 = mThreading->tileColumnsLog2;
+    if (mTileColumnsLog2 < 0) {
+        // one tile column per thread, as far as the width allows
+        int32_t threadsLog2 = 31 - __builtin_clz(mNumThreads);
+        mTileColumnsLog2 = c2_min(threadsLog2, getMaxTileColumnsLog2(mSize->width));
     }
 
     switch (mBitrateMode->value) {
@@ -391,9 +484,11 @@ status_t C2SoftVpxEnc::initEncoder() {
     setCodecSpecificInterface();
     if (!mCodecInterface) goto CleanUp;
 
-    ALOGD("VPx: initEncoder. BRMode: %u. TSLayers: %zu. KF: %u. QP: %u - %u",
+    ALOGD("VPx: initEncoder. BRMode: %u. TSLayers: %zu. KF: %u. QP: %u - %u. "
+          "Threads: %u. TileColumnsLog2: %d. RowMT: %d. Speed: %d",
           (uint32_t)mBitrateControlMode, mTemporalLayers, mIntf->getSyncFramePeriod(),
-          mMinQuantizer, mMaxQuantizer);
+          mMinQuantizer, mMaxQuantizer, mNumThreads, mTileColumnsLog2,
+          (int)mThreading->rowMt, mThreading->speed);
 
     mCodecConfiguration = new vpx_codec_enc_cfg_t;
     if (!mCodecConfiguration) goto CleanUp;
@@ -407,8 +502,7 @@ status_t C2SoftVpxEnc::initEncoder() {
 
     mCodecConfiguration->g_w = mSize->width;
     mCodecConfiguration->g_h = mSize->height;
-    //mCodecConfiguration->g_threads = getCpuCoreCount();
-    mCodecConfiguration->g_threads = 0;
+    mCodecConfiguration->g_threads = mNumThreads;
     mCodecConfiguration->g_error_resilient = mErrorResilience;
 
     // timebase unit is microsecond
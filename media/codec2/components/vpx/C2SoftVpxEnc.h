@@ -60,10 +60,12 @@ typedef enum TemporalPatternType {
 //    - C2PlanarLayout::TYPE_RGB
 //    - C2PlanarLayout::TYPE_RGBA
 //
+// Threading is configured with C2StreamEncoderThreadingTuning. By default the
+// number of threads is derived from the picture size and the cores available
+// to the component.
+//
 // Following settings are not configurable by the client
 //    - encoding deadline is realtime
-//    - multithreaded encoding utilizes a number of threads equal
-// to online cpu's available
 //    - the algorithm interface for encoder is decided by the sub-class in use
 //    - fractional bits of frame rate is discarded
 //    - timestamps are in microseconds, therefore encoder timebase is fixed
@@ -219,6 +221,15 @@ struct C2SoftVpxEnc : public SimpleC2Component {
     std::shared_ptr<C2StreamBitrateModeTuning::output> mBitrateMode;
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> mRequestSync;
     std::shared_ptr<C2StreamTemporalLayeringTuning::output> mLayering;
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> mThreading;
+
+    // Number of encoder threads and log2 of the tile columns in use. These
+    // are the resolved values of mThreading.
+    uint32_t mNumThreads;
+    int32_t mTileColumnsLog2;
+
+    // Share of the cores held while the encoder is initialized.
+    std::shared_ptr<C2CoreBudgetGrant> mCoreGrant;
 
      C2_DO_NOT_COPY(C2SoftVpxEnc);
 };
@@ -249,6 +260,8 @@ class C2SoftVpxEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
 
     static C2R LayeringSetter(bool mayBlock, C2P<C2StreamTemporalLayeringTuning::output>& me);
 
+    static C2R ThreadingSetter(bool mayBlock, C2P<C2StreamEncoderThreadingTuning::output>& me);
+
     // unsafe getters
     std::shared_ptr<C2StreamPictureSizeInfo::input> getSize_l() const { return mSize; }
     std::shared_ptr<C2StreamIntraRefreshTuning::output> getIntraRefresh_l() const {
@@ -268,6 +281,9 @@ class C2SoftVpxEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
     std::shared_ptr<C2StreamColorAspectsInfo::output> getCodedColorAspects_l() const {
         return mCodedColorAspects;
     }
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> getThreading_l() const {
+        return mThreading;
+    }
     uint32_t getSyncFramePeriod() const;
     static C2R ColorAspectsSetter(bool mayBlock, C2P<C2StreamColorAspectsInfo::input> &me);
     static C2R CodedColorAspectsSetter(bool mayBlock, C2P<C2StreamColorAspectsInfo::output> &me,
@@ -286,6 +302,7 @@ class C2SoftVpxEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
     std::shared_ptr<C2StreamProfileLevelInfo::output> mProfileLevel;
     std::shared_ptr<C2StreamColorAspectsInfo::input> mColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mCodedColorAspects;
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> mThreading;
 };
 
 }  // namespace android
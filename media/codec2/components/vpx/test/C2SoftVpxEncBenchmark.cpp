@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encodes the same synthetic frames through the vp8/vp9 encoder component
+// with different C2StreamEncoderThreadingTuning settings and reports the frame
+// rate and stream size of each.
+//
+// Usage: C2SoftVp9EncBenchmark [<width> <height> [<frames>]]
+// Without arguments, 300 frames of 1280x720 are encoded at constant bitrate.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <system/graphics.h>
+
+#include <C2AllocatorGralloc.h>
+#include <C2Buffer.h>
+#include <C2BufferPriv.h>
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <C2Work.h>
+
+using namespace android;
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace {
+
+constexpr uint32_t kDefaultWidth = 1280;
+constexpr uint32_t kDefaultHeight = 720;
+constexpr uint32_t kDefaultFrames = 300;
+constexpr uint32_t kFrameRate = 30;
+// distinct input pictures, cycled through while encoding
+constexpr size_t kNumInputFrames = 16;
+constexpr size_t kMaxWorksInFlight = 4;
+constexpr std::chrono::seconds kTimeout(10);
+
+struct Setting {
+    uint32_t threadCount;
+    int32_t tileColumnsLog2;
+    c2_bool_t rowMt;
+    int32_t speed;
+};
+
+#ifdef VP9
+const Setting kSettings[] = {
+    { 1, 0, C2_FALSE, 8 },
+    { 2, -1, C2_FALSE, 8 },
+    { 2, -1, C2_TRUE, 8 },
+    { 4, -1, C2_TRUE, 8 },
+    { 8, -1, C2_TRUE, 8 },
+    { 0, -1, C2_TRUE, 6 },
+    { 0, -1, C2_TRUE, 7 },
+    { 0, -1, C2_TRUE, 8 },
+    { 0, -1, C2_TRUE, 9 },
+};
+#else
+const Setting kSettings[] = {
+    { 1, -1, C2_FALSE, -8 },
+    { 2, -1, C2_FALSE, -8 },
+    { 4, -1, C2_FALSE, -8 },
+    { 0, -1, C2_FALSE, -4 },
+    { 0, -1, C2_FALSE, -8 },
+    { 0, -1, C2_FALSE, -12 },
+    { 0, -1, C2_FALSE, -16 },
+};
+#endif
+
+class Listener : public C2Component::Listener {
+public:
+    void onWorkDone_nb(
+            std::weak_ptr<C2Component>, std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            if (work->result != C2_OK) {
+                mError = true;
+                continue;
+            }
+            if (work->worklets.empty()
+                    || (work->worklets.front()->output.flags & C2FrameData::FLAG_INCOMPLETE)) {
+                continue;
+            }
+            for (const std::shared_ptr<C2Buffer> &buffer :
+                    work->worklets.front()->output.buffers) {
+                if (buffer && !buffer->data().linearBlocks().empty()) {
+                    mBytes += buffer->data().linearBlocks().front().size();
+                }
+            }
+            ++mDone;
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(
+            std::weak_ptr<C2Component>,
+            std::vector<std::shared_ptr<C2SettingResult>>) override {
+    }
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mError = true;
+        mCondition.notify_all();
+    }
+
+    // Waits until at most |inFlight| of |queued| works are pending. Returns
+    // false on error or time out.
+    bool waitFor(size_t queued, size_t inFlight) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout, [this, queued, inFlight] {
+            return mError || mDone + inFlight >= queued;
+        }) && !mError;
+    }
+
+    size_t bytes() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mBytes;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    size_t mDone = 0;
+    size_t mBytes = 0;
+    bool mError = false;
+};
+
+// Fills the picture with a pattern panning right and down by |n| steps.
+bool fillFrame(const std::shared_ptr<C2GraphicBlock> &block, uint32_t n) {
+    C2GraphicView view = block->map().get();
+    if (view.error() != C2_OK) {
+        return false;
+    }
+    const C2PlanarLayout &layout = view.layout();
+    uint32_t seed = n + 1;
+    for (uint32_t p = 0; p < layout.numPlanes; ++p) {
+        const C2PlaneInfo &plane = layout.planes[p];
+        uint8_t *data = view.data()[p];
+        uint32_t width = view.width() / plane.colSampling;
+        uint32_t height = view.height() / plane.rowSampling;
+        for (uint32_t j = 0; j < height; ++j) {
+            for (uint32_t i = 0; i < width; ++i) {
+                uint8_t value = 128;
+                if (p == C2PlanarLayout::PLANE_Y) {
+                    uint32_t x = i + n * 3, y = j + n;
+                    seed = seed * 1103515245 + 12345;
+                    value = (uint8_t)(((x * 7) ^ (y * 5)) + (x >> 2) + ((seed >> 16) & 7));
+                }
+                data[j * plane.rowInc + i * plane.colInc] = value;
+            }
+        }
+    }
+    return true;
+}
+
+// Returns false on failure.
+bool encode(C2ComponentFactory *factory, const std::vector<std::shared_ptr<C2GraphicBlock>> &input,
+            uint32_t width, uint32_t height, uint32_t frames, const Setting &setting,
+            double *fps, size_t *bytes) {
+    std::shared_ptr<C2Component> component;
+    if (factory->createComponent(0, &component, std::default_delete<C2Component>()) != C2_OK) {
+        fprintf(stderr, "Failed to create the component\n");
+        return false;
+    }
+
+    C2StreamPictureSizeInfo::input size(0u, width, height);
+    C2StreamFrameRateInfo::output frameRate(0u, kFrameRate);
+    C2StreamBitrateModeTuning::output bitrateMode(0u, C2Config::BITRATE_CONST);
+    // about 0.1 bit per pixel
+    C2StreamBitrateInfo::output bitrate(0u, width * height * kFrameRate / 10);
+    C2StreamEncoderThreadingTuning::output threading(
+            0u, setting.threadCount, setting.tileColumnsLog2, setting.rowMt, setting.speed);
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    if (component->intf()->config_vb(
+            { &size, &frameRate, &bitrateMode, &bitrate, &threading },
+            C2_MAY_BLOCK, &failures) != C2_OK || !failures.empty()) {
+        fprintf(stderr, "Failed to configure the component\n");
+        return false;
+    }
+
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+    if (component->setListener_vb(listener, C2_MAY_BLOCK) != C2_OK
+            || component->start() != C2_OK) {
+        fprintf(stderr, "Failed to start the component\n");
+        return false;
+    }
+
+    bool ok = true;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < frames && ok; ++n) {
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.flags = (C2FrameData::flags_t)0;
+        work->input.ordinal.timestamp = (uint64_t)n * 1000000 / kFrameRate;
+        work->input.ordinal.frameIndex = n;
+        const std::shared_ptr<C2GraphicBlock> &block = input[n % input.size()];
+        work->input.buffers.emplace_back(C2Buffer::CreateGraphicBuffer(
+                block->share(C2Rect(width, height), C2Fence())));
+        work->worklets.emplace_back(new C2Worklet);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        ok = component->queue_nb(&items) == C2_OK
+                && listener->waitFor(n + 1, kMaxWorksInFlight);
+    }
+    ok = ok && listener->waitFor(frames, 0);
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    *fps = seconds.count() > 0 ? frames / seconds.count() : 0;
+    *bytes = listener->bytes();
+
+    component->stop();
+    component->release();
+    if (!ok) {
+        fprintf(stderr, "Failed to encode\n");
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t width = kDefaultWidth;
+    uint32_t height = kDefaultHeight;
+    uint32_t frames = kDefaultFrames;
+    if (argc > 2) {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        frames = atoi(argv[3]);
+    }
+    if (width == 0 || height == 0 || width % 2 != 0 || height % 2 != 0 || frames == 0) {
+        fprintf(stderr, "Usage %s [<width> <height> [<frames>]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::shared_ptr<C2Allocator> allocator;
+    if (GetCodec2PlatformAllocatorStore()->fetchAllocator(
+            C2AllocatorStore::DEFAULT_GRAPHIC, &allocator) != C2_OK) {
+        fprintf(stderr, "Failed to get the graphic allocator\n");
+        return EXIT_FAILURE;
+    }
+    std::shared_ptr<C2BlockPool> pool = std::make_shared<C2BasicGraphicBlockPool>(allocator);
+    std::vector<std::shared_ptr<C2GraphicBlock>> input;
+    for (uint32_t n = 0; n < kNumInputFrames; ++n) {
+        std::shared_ptr<C2GraphicBlock> block;
+        if (pool->fetchGraphicBlock(
+                width, height, HAL_PIXEL_FORMAT_YCBCR_420_888,
+                { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, &block) != C2_OK
+                || !fillFrame(block, n)) {
+            fprintf(stderr, "Failed to allocate input frames\n");
+            return EXIT_FAILURE;
+        }
+        input.push_back(block);
+    }
+
+    C2ComponentFactory *factory = CreateCodec2Factory();
+    printf("%ux%u, %u frames\n", width, height, frames);
+    printf("threads tiles-log2 row-mt speed        fps      bytes\n");
+    int result = EXIT_SUCCESS;
+    for (const Setting &setting : kSettings) {
+        double fps = 0;
+        size_t bytes = 0;
+        if (!encode(factory, input, width, height, frames, setting, &fps, &bytes)) {
+            result = EXIT_FAILURE;
+            break;
+        }
+        char threads[16] = "auto", tiles[16] = "auto";
+        if (setting.threadCount > 0) {
+            snprintf(threads, sizeof(threads), "%u", setting.threadCount);
+        }
+        if (setting.tileColumnsLog2 >= 0) {
+            snprintf(tiles, sizeof(tiles), "%d", setting.tileColumnsLog2);
+        }
+        printf("%7s %10s %6s %5d %10.1f %10zu\n", threads, tiles,
+               setting.rowMt ? "on" : "off", setting.speed, fps, bytes);
+    }
+    DestroyCodec2Factory(factory);
+    return result;
+}
@@ -345,24 +345,32 @@ static void fillEmptyWork(const std::unique_ptr<C2Work>& work) {
 }
 
 void C2SoftXaacDec::finishWork(const std::unique_ptr<C2Work>& work,
-                            const std::shared_ptr<C2BlockPool>& pool) {
+                            const std::shared_ptr<C2BlockPool>& pool,
+                            uint32_t pendingOutBytes) {
     ALOGV("mCurFrameIndex = %" PRIu64, mCurFrameIndex);
 
+    const uint32_t outSize = mOutputDrainBufferWritePos + pendingOutBytes;
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE};
     // TODO: error handling, proper usage, etc.
     c2_status_t err =
-        pool->fetchLinearBlock(mOutputDrainBufferWritePos, usage, &block);
+        pool->fetchLinearBlock(outSize, usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock failed : err = %d", err);
         work->result = C2_NO_MEMORY;
         return;
     }
     C2WriteView wView = block->map().get();
-    int16_t* outBuffer = reinterpret_cast<int16_t*>(wView.data());
-    memcpy(outBuffer, mOutputDrainBuffer, mOutputDrainBufferWritePos);
+    uint8_t* outBuffer = wView.data();
+    if (mOutputDrainBufferWritePos) {
+        memcpy(outBuffer, mOutputDrainBuffer, mOutputDrainBufferWritePos);
+    }
+    // The last frame decoded is copied straight from the decoder's output buffer.
+    if (pendingOutBytes) {
+        memcpy(outBuffer + mOutputDrainBufferWritePos, mOutputBuffer, pendingOutBytes);
+    }
 
-    auto fillWork = [buffer = createLinearBuffer(block, 0, mOutputDrainBufferWritePos)](
+    auto fillWork = [buffer = createLinearBuffer(block, 0, outSize)](
         const std::unique_ptr<C2Work>& work) {
         uint32_t flags = 0;
         if (work->input.flags & C2FrameData::FLAG_END_OF_STREAM) {
@@ -445,8 +453,17 @@ void C2SoftXaacDec::process(const std::unique_ptr<C2Work>& work,
     mCurFrameIndex = work->input.ordinal.frameIndex.peeku();
     mCurTimestamp = work->input.ordinal.timestamp.peeku();
     mOutputDrainBufferWritePos = 0;
-    char* tempOutputDrainBuffer = mOutputDrainBuffer;
+    // The output of the last frame decoded is left in mOutputBuffer until another frame is
+    // decoded for this work, so that the usual single frame per work is copied only once,
+    // from the decoder to the output block.
+    uint32_t pendingOutBytes = 0;
     while (size > 0u) {
+        if (pendingOutBytes) {
+            memcpy(mOutputDrainBuffer + mOutputDrainBufferWritePos, mOutputBuffer,
+                   pendingOutBytes);
+            mOutputDrainBufferWritePos += pendingOutBytes;
+            pendingOutBytes = 0;
+        }
         if ((kOutputDrainBufferSize * sizeof(int16_t) -
              mOutputDrainBufferWritePos) <
             (mOutputFrameLength * sizeof(int16_t) * mNumChannels)) {
@@ -592,13 +609,11 @@ void C2SoftXaacDec::process(const std::unique_ptr<C2Work>& work,
 
             // fall through
         }
-        memcpy(tempOutputDrainBuffer, mOutputBuffer, mNumOutBytes);
-        tempOutputDrainBuffer += mNumOutBytes;
-        mOutputDrainBufferWritePos += mNumOutBytes;
+        pendingOutBytes = mNumOutBytes;
     }
 
-    if (mOutputDrainBufferWritePos) {
-        finishWork(work, pool);
+    if (mOutputDrainBufferWritePos || pendingOutBytes) {
+        finishWork(work, pool, pendingOutBytes);
     } else {
         fillEmptyWork(work);
     }
@@ -105,7 +105,8 @@ private:
     IA_ERRORCODE configflushDecode();
     IA_ERRORCODE drainDecoder();
     void finishWork(const std::unique_ptr<C2Work>& work,
-                    const std::shared_ptr<C2BlockPool>& pool);
+                    const std::shared_ptr<C2BlockPool>& pool,
+                    uint32_t pendingOutBytes);
 
     IA_ERRORCODE initXAACDrc();
     IA_ERRORCODE initXAACDecoder();
@@ -160,6 +160,10 @@ enum C2ParamIndexKind : C2Param::type_index_t {
     kParamIndexSecureMode,
     kParamIndexEncryptedBuffer, // info-buffer, used with SM_READ_PROTECTED_WITH_ENCRYPTED
 
+    /* multiple access units per work */
+    kParamIndexAccessUnitInfos,
+    kParamIndexMaxAccessUnitCount,
+
     // deprecated
     kParamIndexDelayRequest = kParamIndexDelay | C2Param::CoreIndex::IS_REQUEST_FLAG,
 
@@ -284,6 +288,9 @@ enum C2ParamIndexKind : C2Param::type_index_t {
 
     // allow tunnel peek behavior to be unspecified for app compatibility
     kParamIndexTunnelPeekMode, // tunnel mode, enum
+
+    // multithreading and speed controls of software encoders
+    kParamIndexEncoderThreading, // encoders, struct
 };
 
 }
@@ -1210,6 +1217,48 @@ typedef C2GlobalParam<C2Tuning, C2SimpleValueStruct<C2Config::secure_mode_t>, kP
         C2SecureModeTuning;
 constexpr char C2_PARAMKEY_SECURE_MODE[] = "algo.secure-mode";
 
+/* ------------------------------- multiple access units per work ------------------------------- */
+
+/**
+ * Access unit of a work or output buffer that carries several of them.
+ */
+struct C2AccessUnitInfosStruct {
+    C2AccessUnitInfosStruct() : flags(0), size(0), timestamp(0) {}
+    C2AccessUnitInfosStruct(uint32_t flags_, uint32_t size_, int64_t timestamp_)
+        : flags(flags_), size(size_), timestamp(timestamp_) { }
+
+    uint32_t flags;     ///< C2FrameData::flags_t of the access unit
+    uint32_t size;      ///< size in bytes
+    int64_t timestamp;  ///< timestamp in us
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(AccessUnitInfos)
+    C2FIELD(flags, "flags")
+    C2FIELD(size, "size")
+    C2FIELD(timestamp, "timestamp")
+};
+
+/**
+ * Access units of a buffer, in order. They are contiguous and their sizes add up to the size of
+ * the buffer.
+ *
+ * Attached by the client to the input buffer of a work that carries several access units, and by
+ * the component to the output buffer holding the output of all of them. The timestamp of the
+ * work is the timestamp of its first access unit.
+ */
+typedef C2StreamParam<C2Info, C2SimpleArrayStruct<C2AccessUnitInfosStruct>,
+        kParamIndexAccessUnitInfos> C2StreamAccessUnitInfos;
+constexpr char C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS[] = "input.access-unit-infos";
+constexpr char C2_PARAMKEY_OUTPUT_ACCESS_UNIT_INFOS[] = "output.access-unit-infos";
+
+/**
+ * Maximum number of access units the component accepts in a single input work.
+ *
+ * Read-only. Components that do not declare this, or declare 1, take one access unit per work.
+ */
+typedef C2PortParam<C2Info, C2Uint32Value, kParamIndexMaxAccessUnitCount>
+        C2PortMaxAccessUnitCountInfo;
+constexpr char C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT[] = "input.buffers.max-access-units";
+
 /* ===================================== ENCODER COMPONENTS ===================================== */
 
 /**
@@ -2538,6 +2587,39 @@ typedef C2StreamParam<C2Info, C2SimpleValueStruct<int32_t>, kParamIndexAverageBl
         C2AndroidStreamAverageBlockQuantizationInfo;
 constexpr char C2_PARAMKEY_AVERAGE_QP[] = "coded.average-qp";
 
+/**
+ * Encoder threading and speed.
+ *
+ * Controls how a software encoder spreads the work of a frame over threads and
+ * how much effort it spends on it. Fields that are not meaningful for the
+ * codec are ignored. Negative tile column counts and a zero thread count ask
+ * the component to pick a value from the picture size and the number of cores.
+ */
+struct C2EncoderThreadingStruct {
+    uint32_t threadCount;       ///< number of encoder threads, 0 for automatic
+    int32_t tileColumnsLog2;    ///< log2 of the number of tile columns, negative for automatic
+    c2_bool_t rowMt;            ///< encode rows of a tile on multiple threads
+    int32_t speed;              ///< codec specific speed preset (e.g. libvpx cpu-used)
+
+    C2EncoderThreadingStruct()
+        : threadCount(0), tileColumnsLog2(-1), rowMt(C2_TRUE), speed(0) { }
+
+    C2EncoderThreadingStruct(
+            uint32_t threadCount_, int32_t tileColumnsLog2_, c2_bool_t rowMt_, int32_t speed_)
+        : threadCount(threadCount_), tileColumnsLog2(tileColumnsLog2_), rowMt(rowMt_),
+          speed(speed_) { }
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(EncoderThreading)
+    C2FIELD(threadCount, "thread-count")
+    C2FIELD(tileColumnsLog2, "tile-columns-log2")
+    C2FIELD(rowMt, "row-mt")
+    C2FIELD(speed, "speed")
+};
+
+typedef C2StreamParam<C2Tuning, C2EncoderThreadingStruct, kParamIndexEncoderThreading>
+        C2StreamEncoderThreadingTuning;
+constexpr char C2_PARAMKEY_ENCODER_THREADING[] = "coding.threading";
+
 /// @}
 
 #endif  // C2CONFIG_H_
@@ -159,6 +159,24 @@ struct InputSurfaceConnection::Impl : public ComponentWrapper {
                          << "status = " << err << ".";
             return false;
         }
+
+        // Producers render at the configured size already. If a component
+        // that reads its input with the CPU declares the pixel format it
+        // consumes, have GPU producers render in that format too, so that the
+        // component does not have to convert every frame.
+        C2StreamPixelFormatInfo::input pixelFormat;
+        if ((grallocUsage & GRALLOC_USAGE_SW_READ_MASK)
+                && queryFromSink({ &pixelFormat }, {}, C2_MAY_BLOCK, nullptr)
+                        == C2_OK
+                && pixelFormat.value != 0
+                && pixelFormat.value != HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED) {
+            err = mSource->setDefaultBufferFormat(pixelFormat.value);
+            if (err != OK) {
+                LOG(WARNING) << "Impl::init -- cannot set default buffer "
+                             << "format to " << pixelFormat.value << ": "
+                             << "status = " << err << ".";
+            }
+        }
         for (int32_t i = 0; i < kBufferCount; ++i) {
             if (mSource->onInputBufferAdded(i) != OK) {
                 LOG(WARNING) << "Impl::init: failed to populate GBS slots.";
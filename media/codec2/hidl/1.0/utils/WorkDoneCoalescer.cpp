@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Codec2-WorkDoneCoalescer"
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+
+#include <codec2/hidl/1.0/WorkDoneCoalescer.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace media {
+namespace c2 {
+namespace V1_0 {
+namespace utils {
+
+// Process-wide thread that ends the windows of all coalescers.
+struct WorkDoneCoalescer::Timer {
+    static Timer& getInstance() {
+        // Never destroyed, as the thread runs for the life of the process.
+        static Timer* instance = new Timer();
+        return *instance;
+    }
+
+    void schedule(nsecs_t deadlineNs,
+                  const std::weak_ptr<WorkDoneCoalescer>& coalescer) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const bool earliest =
+                mDeadlines.empty() || deadlineNs < mDeadlines.begin()->first;
+        mDeadlines.emplace(deadlineNs, coalescer);
+        if (earliest) {
+            mCondition.notify_one();
+        }
+    }
+
+private:
+    Timer() : mThread{&Timer::main, this} {
+        mThread.detach();
+    }
+
+    void main() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            if (mDeadlines.empty()) {
+                mCondition.wait(lock);
+                continue;
+            }
+            const nsecs_t deadlineNs = mDeadlines.begin()->first;
+            const nsecs_t nowNs = systemTime();
+            if (deadlineNs > nowNs) {
+                mCondition.wait_for(
+                        lock, std::chrono::nanoseconds(deadlineNs - nowNs));
+                continue;
+            }
+            std::weak_ptr<WorkDoneCoalescer> coalescer =
+                    mDeadlines.begin()->second;
+            mDeadlines.erase(mDeadlines.begin());
+            lock.unlock();
+            // Send outside the lock, so that new windows can be scheduled.
+            std::shared_ptr<WorkDoneCoalescer> strongCoalescer =
+                    coalescer.lock();
+            if (strongCoalescer) {
+                strongCoalescer->onDeadline(deadlineNs);
+            }
+            strongCoalescer.reset();
+            lock.lock();
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::multimap<nsecs_t, std::weak_ptr<WorkDoneCoalescer>> mDeadlines;
+    std::thread mThread;
+};
+
+// static
+std::shared_ptr<WorkDoneCoalescer> WorkDoneCoalescer::Create(
+        const std::string& name,
+        const Sender& sender,
+        const LowLatencyQuery& isLowLatency) {
+    const nsecs_t windowNs = us2ns(std::max(0, ::android::base::GetIntProperty(
+            "debug.stagefright.c2-work-done-window-us", 0)));
+    return std::shared_ptr<WorkDoneCoalescer>(
+            new WorkDoneCoalescer(name, sender, isLowLatency, windowNs));
+}
+
+WorkDoneCoalescer::WorkDoneCoalescer(
+        const std::string& name,
+        const Sender& sender,
+        const LowLatencyQuery& isLowLatency,
+        nsecs_t windowNs)
+      : mName{name},
+        mSender{sender},
+        mIsLowLatency{isLowLatency},
+        mWindowNs{windowNs},
+        mDeadlineNs{0},
+        mCreatedNs{systemTime()},
+        mWorkItemCount{0},
+        mTransactionCount{0} {
+}
+
+WorkDoneCoalescer::~WorkDoneCoalescer() {
+    flush();
+    const nsecs_t durationNs = systemTime() - mCreatedNs;
+    if (mTransactionCount > 0 && durationNs > 0) {
+        LOG(INFO) << mName << ": " << mWorkItemCount << " work items done in "
+                  << mTransactionCount << " onWorkDone transactions over "
+                  << ns2ms(durationNs) << " ms ("
+                  << mTransactionCount * 1e9 / durationNs
+                  << " transactions/s, window " << ns2us(mWindowNs)
+                  << " us).";
+    }
+}
+
+void WorkDoneCoalescer::onWorkDone(
+        std::list<std::unique_ptr<C2Work>> workItems) {
+    bool sendNow = mWindowNs == 0;
+    for (const std::unique_ptr<C2Work>& work : workItems) {
+        if (sendNow) {
+            break;
+        }
+        if (!work) {
+            continue;
+        }
+        if (work->result != C2_OK
+                || (work->input.flags & C2FrameData::FLAG_END_OF_STREAM)) {
+            sendNow = true;
+        }
+        for (const std::unique_ptr<C2Worklet>& worklet : work->worklets) {
+            if (worklet &&
+                    (worklet->output.flags & C2FrameData::FLAG_END_OF_STREAM)) {
+                sendNow = true;
+            }
+        }
+    }
+
+    // Low latency mode is only queried when a window would start, so not for
+    // every call.
+    bool startWindow = false;
+    if (!sendNow) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        startWindow = mHeldWork.empty();
+    }
+    if (startWindow && mIsLowLatency && mIsLowLatency()) {
+        sendNow = true;
+    }
+
+    nsecs_t deadlineNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHeldWork.splice(mHeldWork.end(), workItems);
+        if (mHeldWork.size() >= kMaxHeldWorkItems) {
+            sendNow = true;
+        }
+        if (!sendNow && mDeadlineNs == 0) {
+            mDeadlineNs = systemTime() + mWindowNs;
+            deadlineNs = mDeadlineNs;
+        }
+    }
+
+    if (sendNow) {
+        flush();
+    } else if (deadlineNs != 0) {
+        Timer::getInstance().schedule(deadlineNs, weak_from_this());
+    }
+}
+
+void WorkDoneCoalescer::flush() {
+    std::lock_guard<std::mutex> sendLock(mSendMutex);
+    std::list<std::unique_ptr<C2Work>> workItems;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        workItems.swap(mHeldWork);
+        mDeadlineNs = 0;
+    }
+    if (!workItems.empty()) {
+        send_l(workItems);
+    }
+}
+
+void WorkDoneCoalescer::onDeadline(nsecs_t deadlineNs) {
+    std::lock_guard<std::mutex> sendLock(mSendMutex);
+    std::list<std::unique_ptr<C2Work>> workItems;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mDeadlineNs != deadlineNs) {
+            // Sent already, and maybe held again for a later deadline.
+            return;
+        }
+        workItems.swap(mHeldWork);
+        mDeadlineNs = 0;
+    }
+    if (!workItems.empty()) {
+        send_l(workItems);
+    }
+}
+
+void WorkDoneCoalescer::send_l(std::list<std::unique_ptr<C2Work>>& workItems) {
+    mWorkItemCount += workItems.size();
+    ++mTransactionCount;
+    mSender(workItems);
+}
+
+}  // namespace utils
+}  // namespace V1_0
+}  // namespace c2
+}  // namespace media
+}  // namespace hardware
+}  // namespace android
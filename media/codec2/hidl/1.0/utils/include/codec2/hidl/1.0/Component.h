@@ -20,6 +20,7 @@
 #include <codec2/hidl/1.0/ComponentInterface.h>
 #include <codec2/hidl/1.0/Configurable.h>
 #include <codec2/hidl/1.0/types.h>
+#include <codec2/hidl/1.0/WorkDoneCoalescer.h>
 
 #include <android/hardware/media/bufferpool/2.0/IClientManager.h>
 #include <android/hardware/media/c2/1.0/IComponent.h>
@@ -125,6 +126,10 @@ protected:
     // destroyBlockPool(), reset() or release(), or by destroying the component.
     std::map<uint64_t, std::shared_ptr<C2BlockPool>> mBlockPools;
 
+    // Coalesces onWorkDone() transactions to mListener. Created by
+    // initListener().
+    std::shared_ptr<WorkDoneCoalescer> mWorkDoneCoalescer;
+
     void initListener(const sp<Component>& self);
 
     virtual ~Component() override;
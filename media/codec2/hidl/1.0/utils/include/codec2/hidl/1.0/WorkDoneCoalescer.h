@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CODEC2_HIDL_V1_0_UTILS_WORK_DONE_COALESCER_H
+#define CODEC2_HIDL_V1_0_UTILS_WORK_DONE_COALESCER_H
+
+#include <utils/Timers.h>
+
+#include <C2Work.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace media {
+namespace c2 {
+namespace V1_0 {
+namespace utils {
+
+/**
+ * Coalesces the work items that a component reports done into fewer
+ * onWorkDone() transactions to the client.
+ *
+ * Work items are held for at most a window after the first of them, and sent
+ * in one transaction when the window ends. The window is read from the
+ * property debug.stagefright.c2-work-done-window-us, and is 0 by default,
+ * which sends each call as it comes.
+ *
+ * Work items are sent right away, together with the ones held before them,
+ * when:
+ * - the component is in low latency mode, checked when a window starts,
+ * - an item ends the stream or failed,
+ * - kMaxHeldWorkItems items are held.
+ *
+ * Only one thread sends at a time and items are sent in the order they are
+ * reported. The component must call flush() before sending any other callback
+ * to the client, so that the client sees all callbacks in order.
+ *
+ * The number of work items and transactions of each component is logged when
+ * the coalescer is destroyed.
+ */
+struct WorkDoneCoalescer : public std::enable_shared_from_this<WorkDoneCoalescer> {
+
+    /**
+     * Sends work items to the client in one transaction.
+     */
+    typedef std::function<void(std::list<std::unique_ptr<C2Work>>&)> Sender;
+
+    /**
+     * Returns whether the component is in low latency mode.
+     */
+    typedef std::function<bool()> LowLatencyQuery;
+
+    /**
+     * Maximum number of work items held before they are sent.
+     */
+    static constexpr size_t kMaxHeldWorkItems = 32;
+
+    static std::shared_ptr<WorkDoneCoalescer> Create(
+            const std::string& name,
+            const Sender& sender,
+            const LowLatencyQuery& isLowLatency);
+
+    ~WorkDoneCoalescer();
+
+    /**
+     * Holds or sends work items that are done.
+     */
+    void onWorkDone(std::list<std::unique_ptr<C2Work>> workItems);
+
+    /**
+     * Sends the held work items now.
+     */
+    void flush();
+
+private:
+    struct Timer;
+
+    WorkDoneCoalescer(
+            const std::string& name,
+            const Sender& sender,
+            const LowLatencyQuery& isLowLatency,
+            nsecs_t windowNs);
+
+    // Called by the timer at deadlineNs. Sends the held work items unless
+    // they were sent since.
+    void onDeadline(nsecs_t deadlineNs);
+
+    // Sends workItems, with mSendMutex held.
+    void send_l(std::list<std::unique_ptr<C2Work>>& workItems);
+
+    const std::string mName;
+    const Sender mSender;
+    const LowLatencyQuery mIsLowLatency;
+    const nsecs_t mWindowNs;
+
+    // Serializes and orders the transactions.
+    std::mutex mSendMutex;
+
+    // Protects mHeldWork and mDeadlineNs.
+    std::mutex mMutex;
+    std::list<std::unique_ptr<C2Work>> mHeldWork;
+    nsecs_t mDeadlineNs;
+
+    // Statistics, guarded by mSendMutex.
+    const nsecs_t mCreatedNs;
+    uint64_t mWorkItemCount;
+    uint64_t mTransactionCount;
+};
+
+}  // namespace utils
+}  // namespace V1_0
+}  // namespace c2
+}  // namespace media
+}  // namespace hardware
+}  // namespace android
+
+#endif  // CODEC2_HIDL_V1_0_UTILS_WORK_DONE_COALESCER_H
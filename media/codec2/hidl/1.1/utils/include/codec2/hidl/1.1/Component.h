@@ -26,6 +26,7 @@
 #include <codec2/hidl/1.1/ComponentInterface.h>
 #include <codec2/hidl/1.1/Configurable.h>
 #include <codec2/hidl/1.1/types.h>
+#include <codec2/hidl/1.1/WorkDoneCoalescer.h>
 #include <hidl/Status.h>
 #include <hwbinder/IBinder.h>
 
@@ -130,6 +131,10 @@ protected:
     // destroyBlockPool(), reset() or release(), or by destroying the component.
     std::map<uint64_t, std::shared_ptr<C2BlockPool>> mBlockPools;
 
+    // Coalesces onWorkDone() transactions to mListener. Created by
+    // initListener().
+    std::shared_ptr<WorkDoneCoalescer> mWorkDoneCoalescer;
+
     void initListener(const sp<Component>& self);
 
     virtual ~Component() override;
@@ -21,6 +21,7 @@
 #include <codec2/hidl/1.2/Component.h>
 #include <codec2/hidl/1.2/ComponentStore.h>
 #include <codec2/hidl/1.2/InputBufferManager.h>
+#include <codec2/hidl/1.2/WorkDoneCoalescer.h>
 
 #ifndef __ANDROID_APEX__
 #include <FilterWrapper.h>
@@ -30,6 +31,7 @@
 #include <utils/Timers.h>
 
 #include <C2BqBufferPriv.h>
+#include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
 
@@ -50,12 +52,15 @@ struct Component::Listener : public C2Component::Listener {
 
     Listener(const sp<Component>& component) :
         mComponent(component),
-        mListener(component->mListener) {
+        mListener(component->mListener),
+        mWorkDoneCoalescer(component->mWorkDoneCoalescer) {
     }
 
     virtual void onError_nb(
             std::weak_ptr<C2Component> /* c2component */,
             uint32_t errorCode) override {
+        // Send the work done before the error.
+        mWorkDoneCoalescer->flush();
         sp<IComponentListener> listener = mListener.promote();
         if (listener) {
             Return<void> transStatus = listener->onError(Status::OK, errorCode);
@@ -70,6 +75,7 @@ struct Component::Listener : public C2Component::Listener {
             std::weak_ptr<C2Component> /* c2component */,
             std::vector<std::shared_ptr<C2SettingResult>> c2settingResult
             ) override {
+        mWorkDoneCoalescer->flush();
         sp<IComponentListener> listener = mListener.promote();
         if (listener) {
             hidl_vec<SettingResult> settingResults(c2settingResult.size());
@@ -106,22 +112,30 @@ struct Component::Listener : public C2Component::Listener {
             }
         }
 
-        sp<IComponentListener> listener = mListener.promote();
+        mWorkDoneCoalescer->onWorkDone(std::move(c2workItems));
+    }
+
+    // Sends c2workItems to the client in one onWorkDone() transaction.
+    static void SendWorkDone(
+            const wp<Component>& component,
+            const wp<IComponentListener>& weakListener,
+            std::list<std::unique_ptr<C2Work>>& c2workItems) {
+        sp<IComponentListener> listener = weakListener.promote();
         if (listener) {
             WorkBundle workBundle;
 
-            sp<Component> strongComponent = mComponent.promote();
+            sp<Component> strongComponent = component.promote();
             beginTransferBufferQueueBlocks(c2workItems, true);
             if (!objcpy(&workBundle, c2workItems, strongComponent ?
                     &strongComponent->mBufferPoolSender : nullptr)) {
-                LOG(ERROR) << "Component::Listener::onWorkDone_nb -- "
+                LOG(ERROR) << "Component::Listener::SendWorkDone -- "
                            << "received corrupted work items.";
                 endTransferBufferQueueBlocks(c2workItems, false, true);
                 return;
             }
             Return<void> transStatus = listener->onWorkDone(workBundle);
             if (!transStatus.isOk()) {
-                LOG(ERROR) << "Component::Listener::onWorkDone_nb -- "
+                LOG(ERROR) << "Component::Listener::SendWorkDone -- "
                            << "transaction failed.";
                 endTransferBufferQueueBlocks(c2workItems, false, true);
                 return;
@@ -133,6 +147,7 @@ struct Component::Listener : public C2Component::Listener {
 protected:
     wp<Component> mComponent;
     wp<IComponentListener> mListener;
+    std::shared_ptr<WorkDoneCoalescer> mWorkDoneCoalescer;
 };
 
 // Component::Sink
@@ -268,6 +283,8 @@ Return<void> Component::flush(flush_cb _hidl_cb) {
             res = Status::CORRUPTED;
         }
     }
+    // Work done before the flush reaches the client before the flushed work.
+    mWorkDoneCoalescer->flush();
     _hidl_cb(res, flushedWorkBundle);
     endTransferBufferQueueBlocks(c2flushedWorks, true, true);
     return Void();
@@ -435,11 +452,14 @@ Return<Status> Component::start() {
 
 Return<Status> Component::stop() {
     InputBufferManager::unregisterFrameData(mListener);
-    return static_cast<Status>(mComponent->stop());
+    Status status = static_cast<Status>(mComponent->stop());
+    mWorkDoneCoalescer->flush();
+    return status;
 }
 
 Return<Status> Component::reset() {
     Status status = static_cast<Status>(mComponent->reset());
+    mWorkDoneCoalescer->flush();
     {
         std::lock_guard<std::mutex> lock(mBlockPoolsMutex);
         mBlockPools.clear();
@@ -450,6 +470,7 @@ Return<Status> Component::reset() {
 
 Return<Status> Component::release() {
     Status status = static_cast<Status>(mComponent->release());
+    mWorkDoneCoalescer->flush();
     {
         std::lock_guard<std::mutex> lock(mBlockPoolsMutex);
         mBlockPools.clear();
@@ -514,6 +535,24 @@ std::shared_ptr<C2Component> Component::findLocalComponent(
 }
 
 void Component::initListener(const sp<Component>& self) {
+    wp<Component> weakSelf = self;
+    wp<IComponentListener> weakListener = mListener;
+    std::weak_ptr<C2ComponentInterface> weakIntf = mComponent->intf();
+    mWorkDoneCoalescer = WorkDoneCoalescer::Create(
+            mComponent->intf()->getName(),
+            [weakSelf, weakListener](std::list<std::unique_ptr<C2Work>>& items) {
+                Listener::SendWorkDone(weakSelf, weakListener, items);
+            },
+            [weakIntf]() {
+                std::shared_ptr<C2ComponentInterface> intf = weakIntf.lock();
+                if (!intf) {
+                    return false;
+                }
+                C2GlobalLowLatencyModeTuning lowLatency;
+                c2_status_t res = intf->query_vb(
+                        {&lowLatency}, {}, C2_DONT_BLOCK, nullptr);
+                return res == C2_OK && lowLatency.value == C2_TRUE;
+            });
     std::shared_ptr<C2Component::Listener> c2listener =
             std::make_shared<Listener>(self);
     c2_status_t res = mComponent->setListener_vb(c2listener, C2_DONT_BLOCK);
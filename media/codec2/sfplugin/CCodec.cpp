@@ -779,12 +779,15 @@ void CCodec::allocate(const sp<MediaCodecInfo> &codecInfo) {
     // initialize config here in case setParameters is called prior to configure
     Mutexed<std::unique_ptr<Config>>::Locked configLocked(mConfig);
     const std::unique_ptr<Config> &config = *configLocked;
+    TimePoint initStart = std::chrono::steady_clock::now();
     status_t err = config->initialize(mClient->getParamReflector(), comp);
     if (err != OK) {
         ALOGW("Failed to initialize configuration support");
         // TODO: report error once we complete implementation.
     }
     config->queryConfiguration(comp);
+    mConfigInitTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - initStart).count();
 
     mCallback->onComponentAllocated(componentName.c_str());
 }
@@ -817,6 +820,7 @@ void CCodec::configure(const sp<AMessage> &msg) {
     if (tryAndReportOnError(checkAllocated) != OK) {
         return;
     }
+    TimePoint configureStart = std::chrono::steady_clock::now();
 
     auto doConfig = [msg, comp, this]() -> status_t {
         AString mime;
@@ -1529,6 +1533,10 @@ void CCodec::configure(const sp<AMessage> &msg) {
     const std::unique_ptr<Config> &config = *configLocked;
 
     config->queryConfiguration(comp);
+    mConfigureTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - configureStart).count();
+    ALOGV("configure took %lldus (config init %lldus)",
+            (long long)mConfigureTimeUs.load(), (long long)mConfigInitTimeUs.load());
 
     mCallback->onComponentConfigured(config->mInputFormat, config->mOutputFormat);
 }
@@ -2286,6 +2294,17 @@ status_t CCodec::unsubscribeFromParameters(const std::vector<std::string> &names
     return config->unsubscribeFromVendorConfigUpdate(comp, names);
 }
 
+void CCodec::getMetrics(const sp<AMessage> &metrics) const {
+    int64_t initTimeUs = mConfigInitTimeUs.load();
+    if (initTimeUs >= 0) {
+        metrics->setInt64("config.init-us", initTimeUs);
+    }
+    int64_t configureTimeUs = mConfigureTimeUs.load();
+    if (configureTimeUs >= 0) {
+        metrics->setInt64("config.configure-us", configureTimeUs);
+    }
+}
+
 void CCodec::onWorkDone(std::list<std::unique_ptr<C2Work>> &workItems) {
     if (!workItems.empty()) {
         Mutexed<std::list<std::unique_ptr<C2Work>>>::Locked queue(mWorkDoneQueue);
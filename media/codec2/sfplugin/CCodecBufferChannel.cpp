@@ -48,6 +48,7 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/hexdump.h>
+#include <media/stagefright/AccessUnitInfo.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/SkipCutBuffer.h>
 #include <media/stagefright/SurfaceUtils.h>
@@ -150,12 +151,15 @@ CCodecBufferChannel::CCodecBufferChannel(
         const std::shared_ptr<CCodecCallback> &callback)
     : mHeapSeqNum(-1),
       mCCodecCallback(callback),
+      mSendOutputRequests(0u),
+      mOutputContentionCount(0u),
       mFrameIndex(0u),
       mFirstValidFrameIndex(0u),
       mMetaMode(MODE_NONE),
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
-      mSendEncryptedInfoBuffer(false) {
+      mSendEncryptedInfoBuffer(false),
+      mMaxAccessUnitCount(1u) {
     char board_platform[PROPERTY_VALUE_MAX];
     property_get("ro.board.platform", board_platform, "");
     mNeedEmptyWork = false;
@@ -164,6 +168,7 @@ CCodecBufferChannel::CCodecBufferChannel(
         ALOGV("CCodecBufferChannel: going to queue empty work for lahaina.");
     }
     mOutputSurface.lock()->maxDequeueBuffers = kSmoothnessFactor + kRenderingDepth;
+    mLatencyStats = mPipelineWatcher.lock()->latencyStats();
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers.reset(new DummyInputBuffers(""));
@@ -239,6 +244,8 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     if (buffer->meta()->findInt32("tunnel-first-frame", &tmp) && tmp) {
         tunnelFirstFrame = true;
     }
+    sp<RefBase> accessUnits;
+    (void)buffer->meta()->findObject("accessUnits", &accessUnits);
     ALOGV("[%s] queueInputBuffer: buffer->size() = %zu", mName, buffer->size());
     std::list<std::unique_ptr<C2Work>> items;
     std::unique_ptr<C2Work> work(new C2Work);
@@ -252,6 +259,7 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
 
     sp<Codec2Buffer> copy;
     bool usesFrameReassembler = false;
+    bool usesAccessUnits = false;
 
     if (buffer->size() > 0u) {
         Mutexed<Input>::Locked input(mInput);
@@ -278,7 +286,54 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         }
         if (input->frameReassembler) {
             usesFrameReassembler = true;
-            input->frameReassembler.process(buffer, &items);
+            // whole frames in |c2buffer| are shared with the component unless disabled
+            static const bool kShareFrames = android::base::GetBoolProperty(
+                    "debug.stagefright.ccodec_reassembler_share_frames", true);
+            input->frameReassembler.process(buffer, kShareFrames ? c2buffer : nullptr, &items);
+        } else if (accessUnits && !encryptedBlock
+                && c2buffer->data().type() == C2BufferData::LINEAR) {
+            // Contiguous access units share a work, up to the count the component takes, and
+            // are described by C2StreamAccessUnitInfos on its buffer. Codec config goes alone.
+            // All works are queued to the component at once.
+            usesAccessUnits = true;
+            const C2ConstLinearBlock block = c2buffer->data().linearBlocks().front();
+            const sp<AccessUnitInfos> infos = static_cast<AccessUnitInfos *>(accessUnits.get());
+            const size_t maxAccessUnitCount = mMaxAccessUnitCount;
+            const std::vector<AccessUnitInfo> &aus = infos->value;
+            for (size_t first = 0; first < aus.size(); ) {
+                const bool codecConfig = (aus[first].mFlags & BUFFER_FLAG_CODEC_CONFIG) != 0;
+                size_t end = aus[first].mOffset + aus[first].mSize;
+                size_t last = first + 1;
+                while (!codecConfig && last < aus.size() && last - first < maxAccessUnitCount
+                        && (aus[last].mFlags & BUFFER_FLAG_CODEC_CONFIG) == 0
+                        && aus[last].mOffset == end) {
+                    end += aus[last].mSize;
+                    ++last;
+                }
+                if (end > block.size()) {
+                    return -EINVAL;
+                }
+                const AccessUnitInfo &au = aus[first];
+                std::unique_ptr<C2Work> auWork(new C2Work);
+                auWork->input.ordinal.timestamp = au.mTimeUs;
+                auWork->input.ordinal.frameIndex = mFrameIndex++;
+                auWork->input.ordinal.customOrdinal = au.mTimeUs;
+                std::shared_ptr<C2Buffer> auBuffer = C2Buffer::CreateLinearBuffer(
+                        block.subBlock(block.offset() + au.mOffset, end - au.mOffset));
+                if (last - first > 1) {
+                    std::vector<C2AccessUnitInfosStruct> groupInfos;
+                    for (size_t i = first; i < last; ++i) {
+                        groupInfos.emplace_back(0u, aus[i].mSize, aus[i].mTimeUs);
+                    }
+                    auBuffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(groupInfos, 0u));
+                }
+                auWork->input.buffers.push_back(auBuffer);
+                auWork->input.flags = (C2FrameData::flags_t)(
+                        codecConfig ? C2FrameData::FLAG_CODEC_CONFIG : 0);
+                auWork->worklets.emplace_back(new C2Worklet);
+                items.push_back(std::move(auWork));
+                first = last;
+            }
         } else {
             int32_t cvo = 0;
             if (buffer->meta()->findInt32("cvo", &cvo)) {
@@ -311,6 +366,11 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
             items.front()->input.configUpdate = std::move(mParamsToBeSet);
             mFrameIndex = (items.back()->input.ordinal.frameIndex + 1).peek();
         }
+    } else if (usesAccessUnits) {
+        if (!items.empty()) {
+            items.front()->input.configUpdate = std::move(mParamsToBeSet);
+        }
+        eos = eos && buffer->size() > 0u;
     } else {
         work->input.flags = (C2FrameData::flags_t)flags;
         // TODO: fill info's
@@ -760,6 +820,7 @@ void CCodecBufferChannel::feedInputBufferIfAvailableInternal() {
         Mutexed<Output>::Locked output(mOutput);
         if (!output->buffers ||
                 output->buffers->hasPending() ||
+                !mOutputRing.empty() ||
                 output->buffers->numActiveSlots() >= output->numSlots) {
             return;
         }
@@ -1028,6 +1089,11 @@ status_t CCodecBufferChannel::renderOutputBuffer(
         ALOGV("[%s] queue buffer successful", mName);
     }
 
+    int64_t frameIndex;
+    if (buffer->meta()->findInt64("frameIndex", &frameIndex)) {
+        mPipelineWatcher.lock()->onWorkRendered(frameIndex);
+    }
+
     int64_t mediaTimeUs = 0;
     (void)buffer->meta()->findInt64("timeUs", &mediaTimeUs);
     mCCodecCallback->onOutputFramesRendered(mediaTimeUs, timestampNs);
@@ -1101,6 +1167,7 @@ status_t CCodecBufferChannel::start(
     C2PortActualDelayTuning::output outputDelay(0);
     C2ActualPipelineDelayTuning pipelineDelay(0);
     C2SecureModeTuning secureMode(C2Config::SM_UNPROTECTED);
+    C2PortMaxAccessUnitCountInfo::input maxAccessUnitCount(1u);
 
     c2_status_t err = mComponent->query(
             {
@@ -1113,6 +1180,7 @@ status_t CCodecBufferChannel::start(
                 &pipelineDelay,
                 &outputDelay,
                 &secureMode,
+                &maxAccessUnitCount,
             },
             {},
             C2_DONT_BLOCK,
@@ -1128,6 +1196,7 @@ status_t CCodecBufferChannel::start(
     uint32_t inputDelayValue = inputDelay ? inputDelay.value : 0;
     uint32_t pipelineDelayValue = pipelineDelay ? pipelineDelay.value : 0;
     uint32_t outputDelayValue = outputDelay ? outputDelay.value : 0;
+    mMaxAccessUnitCount = maxAccessUnitCount ? std::max(maxAccessUnitCount.value, 1u) : 1u;
 
     size_t numInputSlots = inputDelayValue + pipelineDelayValue + kSmoothnessFactor;
     size_t numOutputSlots = outputDelayValue + kSmoothnessFactor;
@@ -1435,6 +1504,8 @@ status_t CCodecBufferChannel::start(
         }
 
         Mutexed<Output>::Locked output(mOutput);
+        // discard buffers left over from before the codec was stopped.
+        drainOutputRing(output);
         output->outputDelay = outputDelayValue;
         output->numSlots = numOutputSlots;
         if (graphic) {
@@ -1666,6 +1737,7 @@ void CCodecBufferChannel::reset() {
     {
         Mutexed<Output>::Locked output(mOutput);
         output->buffers.reset();
+        drainOutputRing(output);
     }
 }
 
@@ -1731,6 +1803,7 @@ void CCodecBufferChannel::flush(const std::list<std::unique_ptr<C2Work>> &flushe
     {
         Mutexed<Output>::Locked output(mOutput);
         if (output->buffers) {
+            drainOutputRing(output);
             output->buffers->flush(flushedWork);
             output->buffers->flushStash();
         }
@@ -1957,6 +2030,8 @@ bool CCodecBufferChannel::handleWork(
         if (!output->buffers) {
             return false;
         }
+        // apply the update after the buffers already returned.
+        drainOutputRing(output);
         numOutputSlots = output->numSlots;
         if (newReorderKey) {
             output->buffers->setReorderKey(newReorderKey.value());
@@ -2031,6 +2106,7 @@ bool CCodecBufferChannel::handleWork(
     // csd cannot be re-ordered and will always arrive first.
     if (initData != nullptr) {
         Mutexed<Output>::Locked output(mOutput);
+        drainOutputRing(output);
         if (output->buffers && outputFormat) {
             output->buffers->updateSkipCutBuffer(outputFormat);
             output->buffers->setFormat(outputFormat);
@@ -2087,24 +2163,61 @@ bool CCodecBufferChannel::handleWork(
         }
     }
 
-    {
+    StashEntry entry{buffer, notifyClient, timestamp.peek(), flags, outputFormat,
+                     worklet->output.ordinal};
+    if (!mOutputRing.push(std::move(entry))) {
+        mOutputContentionCount.fetch_add(1, std::memory_order_relaxed);
         Mutexed<Output>::Locked output(mOutput);
         if (!output->buffers) {
             return false;
         }
+        drainOutputRing(output);
         output->buffers->pushToStash(
-                buffer,
-                notifyClient,
-                timestamp.peek(),
-                flags,
-                outputFormat,
-                worklet->output.ordinal);
+                entry.buffer,
+                entry.notify,
+                entry.timestamp,
+                entry.flags,
+                entry.format,
+                entry.ordinal);
     }
     sendOutputBuffers();
     return true;
 }
 
+void CCodecBufferChannel::drainOutputRing(Mutexed<Output>::Locked &output) {
+    // Called with mOutput held, which makes the caller the only consumer of
+    // mOutputRing. Entries are dropped if the output buffers are gone.
+    StashEntry entry;
+    while (mOutputRing.pop(&entry)) {
+        if (output->buffers) {
+            output->buffers->pushToStash(
+                    entry.buffer,
+                    entry.notify,
+                    entry.timestamp,
+                    entry.flags,
+                    entry.format,
+                    entry.ordinal);
+        }
+    }
+}
+
 void CCodecBufferChannel::sendOutputBuffers() {
+    // onWorkDone() and the client releasing output buffers both end up here.
+    // Rather than having them wait on each other for mOutput, the first one in
+    // sends the buffers and keeps going until it has covered every request
+    // that arrived meanwhile.
+    if (mSendOutputRequests.fetch_add(1) != 0) {
+        mOutputContentionCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t requests;
+    do {
+        requests = mSendOutputRequests.load();
+        sendOutputBuffersInternal();
+    } while (mSendOutputRequests.fetch_sub(requests) != requests);
+}
+
+void CCodecBufferChannel::sendOutputBuffersInternal() {
     OutputBuffers::BufferAction action;
     size_t index;
     sp<MediaCodecBuffer> outBuffer;
@@ -2118,6 +2231,7 @@ void CCodecBufferChannel::sendOutputBuffers() {
         if (!output->buffers) {
             return;
         }
+        drainOutputRing(output);
         action = output->buffers->popFromStashAndRegister(
                 &c2Buffer, &index, &outBuffer);
         if (action != OutputBuffers::REALLOCATE) {
@@ -2225,6 +2339,25 @@ status_t CCodecBufferChannel::setSurface(const sp<Surface> &newSurface, bool pus
     return OK;
 }
 
+void CCodecBufferChannel::getMetrics(const sp<AMessage> &metrics) const {
+    auto add = [&metrics](const char *name, const LatencyHistogram &histogram) {
+        if (histogram.count() == 0) {
+            return;
+        }
+        std::string prefix = std::string("latency.") + name;
+        metrics->setInt64((prefix + ".count").c_str(), histogram.count());
+        metrics->setInt64((prefix + ".avg").c_str(), histogram.avgUs());
+        metrics->setInt64((prefix + ".p50").c_str(), histogram.percentileUs(50));
+        metrics->setInt64((prefix + ".p90").c_str(), histogram.percentileUs(90));
+        metrics->setInt64((prefix + ".p99").c_str(), histogram.percentileUs(99));
+        metrics->setInt64((prefix + ".max").c_str(), histogram.maxUs());
+        metrics->setString((prefix + ".hist").c_str(), histogram.toString().c_str());
+    };
+    // all in microseconds
+    add("queue-done", mLatencyStats->queueToDone);
+    add("done-render", mLatencyStats->doneToRender);
+}
+
 PipelineWatcher::Clock::duration CCodecBufferChannel::elapsed() {
     // Otherwise, component may have stalled work due to input starvation up to
     // the sum of the delay in the pipeline.
@@ -35,6 +35,7 @@
 #include "FrameReassembler.h"
 #include "InputSurfaceWrapper.h"
 #include "PipelineWatcher.h"
+#include "SpscRing.h"
 
 namespace android {
 
@@ -63,6 +64,7 @@ public:
     void setDescrambler(const sp<IDescrambler> &descrambler) override;
 
     virtual status_t queueInputBuffer(const sp<MediaCodecBuffer> &buffer) override;
+    virtual bool canQueueAccessUnits() const override { return true; }
     virtual status_t queueSecureInputBuffer(
             const sp<MediaCodecBuffer> &buffer,
             bool secure,
@@ -92,6 +94,10 @@ public:
     virtual status_t discardBuffer(const sp<MediaCodecBuffer> &buffer) override;
     virtual void getInputBufferArray(Vector<sp<MediaCodecBuffer>> *array) override;
     virtual void getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *array) override;
+    virtual uint64_t getOutputContentionCount() const override {
+        return mOutputContentionCount.load(std::memory_order_relaxed);
+    }
+    virtual void getMetrics(const sp<AMessage> &metrics) const override;
 
     // Methods below are interface for CCodec to use.
 
@@ -271,6 +277,7 @@ private:
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
             const C2StreamInitDataInfo::output *initData);
     void sendOutputBuffers();
+    void sendOutputBuffersInternal();
     void ensureDecryptDestination(size_t size);
     int32_t getHeapSeqNum(const sp<hardware::HidlMemory> &memory);
 
@@ -308,6 +315,30 @@ private:
         uint32_t outputDelay;
     };
     Mutexed<Output> mOutput;
+
+    // Output buffers returned by the component, waiting to be pushed to the
+    // output stash. handleWork() publishes them here without holding mOutput;
+    // they are moved to the stash by drainOutputRing() with mOutput held.
+    struct StashEntry {
+        std::shared_ptr<C2Buffer> buffer;
+        bool notify;
+        int64_t timestamp;
+        int32_t flags;
+        sp<AMessage> format;
+        C2WorkOrdinalStruct ordinal;
+    };
+    static constexpr size_t kOutputRingSize = 64;
+    SpscRing<StashEntry, kOutputRingSize> mOutputRing;
+    void drainOutputRing(Mutexed<Output>::Locked &output);
+
+    // Number of pending sendOutputBuffers() requests. Only the caller that
+    // raises it from zero sends output buffers; the others leave their
+    // request to that caller and return.
+    std::atomic_uint32_t mSendOutputRequests;
+    // Number of times the output path had to wait for or defer to another
+    // thread: sendOutputBuffers() requests handed over to another thread, or
+    // mOutputRing found full.
+    std::atomic_uint64_t mOutputContentionCount;
     Mutexed<std::list<std::unique_ptr<C2Work>>> mFlushedConfigs;
 
     std::atomic_uint64_t mFrameIndex;
@@ -337,6 +368,8 @@ private:
     MetaMode mMetaMode;
 
     Mutexed<PipelineWatcher> mPipelineWatcher;
+    // shared with mPipelineWatcher, read without its lock
+    std::shared_ptr<const PipelineWatcher::LatencyStats> mLatencyStats;
 
     std::atomic_bool mInputMetEos;
     std::once_flag mRenderWarningFlag;
@@ -356,6 +389,9 @@ private:
     std::atomic_bool mSendEncryptedInfoBuffer;
 
     std::atomic_bool mTunneled;
+
+    // access units the component takes in one work, see queueInputBuffers()
+    std::atomic_uint32_t mMaxAccessUnitCount;
 };
 
 // Conversion of a c2_status_t value to a status_t value may depend on the
@@ -22,6 +22,7 @@
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/MediaDefs.h>
+#include <media/stagefright/AccessUnitInfo.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/SkipCutBuffer.h>
 #include <mediadrm/ICrypto.h>
@@ -202,6 +203,8 @@ void OutputBuffers::setSkipCutBuffer(int32_t skip, int32_t cut) {
         if (prevSize != 0u) {
             ALOGD("[%s] Replacing SkipCutBuffer holding %zu bytes", mName, prevSize);
         }
+        mSkipCutBuffer->reset(skip, cut, mChannelCount);
+        return;
     }
     mSkipCutBuffer = new SkipCutBuffer(skip, cut, mChannelCount);
 }
@@ -377,6 +380,24 @@ OutputBuffers::BufferAction OutputBuffers::popFromStashAndRegister(
     (*outBuffer)->meta()->setInt64("timeUs", entry.timestamp);
     (*outBuffer)->meta()->setInt32("flags", entry.flags);
     (*outBuffer)->meta()->setInt64("frameIndex", entry.ordinal.frameIndex.peekll());
+    // The output of a work that carried several access units, see queueInputBuffers().
+    std::shared_ptr<const C2StreamAccessUnitInfos::output> auInfos;
+    if (*c2Buffer) {
+        auInfos = std::static_pointer_cast<const C2StreamAccessUnitInfos::output>(
+                (*c2Buffer)->getInfo(C2StreamAccessUnitInfos::output::PARAM_TYPE));
+    }
+    if (auInfos && auInfos->flexCount() > 0) {
+        std::vector<AccessUnitInfo> infos;
+        size_t offset = 0;
+        for (size_t i = 0; i < auInfos->flexCount(); ++i) {
+            const C2AccessUnitInfosStruct &au = auInfos->m.values[i];
+            infos.push_back({offset, au.size, au.timestamp, 0u});
+            offset += au.size;
+        }
+        (*outBuffer)->meta()->setObject("accessUnits", new AccessUnitInfos(std::move(infos)));
+    } else {
+        (*outBuffer)->meta()->removeEntryByName("accessUnits");
+    }
     ALOGV("[%s] popFromStashAndRegister: "
           "out buffer index = %zu [%p] => %p + %zu (%lld)",
           mName, *index, outBuffer->get(),
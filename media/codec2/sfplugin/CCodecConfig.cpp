@@ -18,6 +18,7 @@
 #define LOG_TAG "CCodecConfig"
 
 #include <initializer_list>
+#include <mutex>
 
 #include <cutils/properties.h>
 #include <log/log.h>
@@ -218,6 +219,43 @@ AString QueryMediaTypeImpl(
     return mediaType;
 }
 
+template <typename PORT, typename STREAM>
+AString FindMediaTypeImpl(const std::vector<std::unique_ptr<C2Param>> &queried) {
+    const STREAM *streamMediaType = nullptr;
+    for (const std::unique_ptr<C2Param> &param : queried) {
+        const PORT *portMediaType = PORT::From(param.get());
+        if (portMediaType) {
+            return AString(
+                    portMediaType->m.value,
+                    strnlen(portMediaType->m.value, portMediaType->flexCount()));
+        }
+        const STREAM *mediaType = STREAM::From(param.get());
+        if (mediaType && mediaType->stream() == 0u) {
+            streamMediaType = mediaType;
+        }
+    }
+    if (streamMediaType) {
+        return AString(
+                streamMediaType->m.value,
+                strnlen(streamMediaType->m.value, streamMediaType->flexCount()));
+    }
+    return AString();
+}
+
+/**
+ * Returns the media type of the input or output port (preferred) or stream #0
+ * among already |queried| params, or an empty string if not found.
+ */
+AString FindMediaType(bool input, const std::vector<std::unique_ptr<C2Param>> &queried) {
+    typedef C2PortMediaTypeSetting P;
+    typedef C2StreamMediaTypeSetting S;
+    if (input) {
+        return FindMediaTypeImpl<P::input, S::input>(queried);
+    } else {
+        return FindMediaTypeImpl<P::output, S::output>(queried);
+    }
+}
+
 AString QueryMediaType(
         bool input, const std::shared_ptr<Codec2Client::Configurable> &configurable) {
     typedef C2PortMediaTypeSetting P;
@@ -951,6 +989,21 @@ void CCodecConfig::initializeStandardParams() {
 
     add(ConfigMapper("android._encoding-quality-level", C2_PARAMKEY_ENCODING_QUALITY_LEVEL, "value")
         .limitTo(D::ENCODER & (D::CONFIG | D::PARAM)));
+    add(ConfigMapper("android._encoder-thread-count", C2_PARAMKEY_ENCODER_THREADING,
+                     "thread-count")
+        .limitTo(D::VIDEO & D::ENCODER & D::CONFIG));
+    add(ConfigMapper("android._encoder-tile-columns-log2", C2_PARAMKEY_ENCODER_THREADING,
+                     "tile-columns-log2")
+        .limitTo(D::VIDEO & D::ENCODER & D::CONFIG));
+    add(ConfigMapper("android._encoder-row-mt", C2_PARAMKEY_ENCODER_THREADING, "row-mt")
+        .limitTo(D::VIDEO & D::ENCODER & D::CONFIG)
+        .withMapper([](C2Value v) -> C2Value {
+            int32_t value = 0;
+            (void)v.get(&value);
+            return value == 0 ? C2_FALSE : C2_TRUE;
+        }));
+    add(ConfigMapper("android._encoder-speed", C2_PARAMKEY_ENCODER_THREADING, "speed")
+        .limitTo(D::VIDEO & D::ENCODER & D::CONFIG));
     add(ConfigMapper(KEY_QUALITY, C2_PARAMKEY_QUALITY, "value")
         .limitTo(D::ENCODER & (D::CONFIG | D::PARAM)));
     add(ConfigMapper(KEY_FLAC_COMPRESSION_LEVEL, C2_PARAMKEY_COMPLEXITY, "value")
@@ -1027,15 +1080,93 @@ void CCodecConfig::initializeStandardParams() {
     */
 }
 
+namespace {
+
+/**
+ * Reflection data of a component that is fixed for the lifetime of the
+ * process: its supported parameter descriptors and the descriptors of the
+ * structs it uses. Each of these takes a transaction to the component store
+ * to get, so they are only queried by the first instance of a component.
+ */
+struct ReflectionCache {
+    std::mutex lock;
+    bool hasParamDescs = false;
+    std::vector<std::shared_ptr<C2ParamDescriptor>> paramDescs;
+    std::map<uint32_t, std::shared_ptr<const C2StructDescriptor>> structDescs;  // by core index
+};
+
+std::shared_ptr<ReflectionCache> GetReflectionCache(const std::string &name) {
+    static std::mutex sMutex;
+    static std::map<std::string, std::shared_ptr<ReflectionCache>> sCache;
+    std::lock_guard<std::mutex> lock(sMutex);
+    std::shared_ptr<ReflectionCache> &cache = sCache[name];
+    if (!cache) {
+        cache = std::make_shared<ReflectionCache>();
+    }
+    return cache;
+}
+
+/**
+ * Reflector that serves struct descriptors from a ReflectionCache, and only
+ * asks the underlying reflector for the ones not cached yet.
+ */
+class CachedParamReflector : public C2ParamReflector {
+public:
+    CachedParamReflector(
+            const std::shared_ptr<C2ParamReflector> &reflector,
+            const std::shared_ptr<ReflectionCache> &cache)
+        : mReflector(reflector), mCache(cache) {}
+
+    virtual ~CachedParamReflector() = default;
+
+    std::unique_ptr<C2StructDescriptor> describe(C2Param::CoreIndex coreIndex) const override {
+        {
+            std::lock_guard<std::mutex> lock(mCache->lock);
+            auto it = mCache->structDescs.find(coreIndex.coreIndex());
+            if (it != mCache->structDescs.end()) {
+                return std::make_unique<C2StructDescriptor>(*it->second);
+            }
+        }
+        std::unique_ptr<C2StructDescriptor> desc = mReflector->describe(coreIndex);
+        // do not cache failures; they may be caused by a transaction error
+        if (desc) {
+            std::lock_guard<std::mutex> lock(mCache->lock);
+            mCache->structDescs.emplace(
+                    coreIndex.coreIndex(), std::make_shared<const C2StructDescriptor>(*desc));
+        }
+        return desc;
+    }
+
+private:
+    const std::shared_ptr<C2ParamReflector> mReflector;
+    const std::shared_ptr<ReflectionCache> mCache;
+};
+
+}  // namespace
+
 status_t CCodecConfig::initialize(
         const std::shared_ptr<C2ParamReflector> &reflector,
         const std::shared_ptr<Codec2Client::Configurable> &configurable) {
     C2ComponentDomainSetting domain(C2Component::DOMAIN_OTHER);
     C2ComponentKindSetting kind(C2Component::KIND_OTHER);
 
+    // query the domain, kind and media types in one transaction
     std::vector<std::unique_ptr<C2Param>> queried;
-    c2_status_t c2err = configurable->query({ &domain, &kind }, {}, C2_DONT_BLOCK, &queried);
-    if (c2err != C2_OK) {
+    c2_status_t c2err = configurable->query(
+            { &domain, &kind },
+            {
+                C2PortMediaTypeSetting::input::PARAM_TYPE,
+                C2PortMediaTypeSetting::output::PARAM_TYPE,
+                C2StreamMediaTypeSetting::input::PARAM_TYPE,
+                C2StreamMediaTypeSetting::output::PARAM_TYPE,
+            },
+            C2_DONT_BLOCK,
+            &queried);
+    // media types may legitimately be missing, so only treat it as an error if
+    // domain or kind is unknown
+    if (c2err != C2_OK && (!domain || !kind
+            || domain.value == C2Component::DOMAIN_OTHER
+            || kind.value == C2Component::KIND_OTHER)) {
         ALOGD("Query domain & kind failed => %s", asString(c2err));
         // TEMP: determine kind from component name
         if (kind.value == C2Component::KIND_OTHER) {
@@ -1048,7 +1179,10 @@ status_t CCodecConfig::initialize(
 
         // TEMP: determine domain from media type (port (preferred) or stream #0)
         if (domain.value == C2Component::DOMAIN_OTHER) {
-            AString mediaType = QueryMediaType(true /* input */, configurable);
+            AString mediaType = FindMediaType(true /* input */, queried);
+            if (mediaType.empty()) {
+                mediaType = QueryMediaType(true /* input */, configurable);
+            }
             if (mediaType.startsWith("audio/")) {
                 domain.value = C2Component::DOMAIN_AUDIO;
             } else if (mediaType.startsWith("video/")) {
@@ -1073,30 +1207,53 @@ status_t CCodecConfig::initialize(
     std::vector<C2Param::Index> paramIndices;
     switch (kind.value) {
     case C2Component::KIND_DECODER:
-        mCodingMediaType = QueryMediaType(true /* input */, configurable).c_str();
-        break;
-    case C2Component::KIND_ENCODER:
-        mCodingMediaType = QueryMediaType(false /* input */, configurable).c_str();
+    case C2Component::KIND_ENCODER: {
+        const bool input = (kind.value == C2Component::KIND_DECODER);
+        AString mediaType = FindMediaType(input, queried);
+        if (mediaType.empty()) {
+            mediaType = QueryMediaType(input, configurable);
+        } else {
+            ALOGD("read media type: %s", mediaType.c_str());
+        }
+        mCodingMediaType = mediaType.c_str();
         break;
+    }
     default:
         mCodingMediaType = "";
     }
 
-    c2err = configurable->querySupportedParams(&mParamDescs);
-    if (c2err != C2_OK) {
-        ALOGD("Query supported params failed after returning %zu values => %s",
-                mParamDescs.size(), asString(c2err));
-        return UNKNOWN_ERROR;
+    // the supported params of a component do not change, so reuse them from a
+    // previous instance if available
+    std::shared_ptr<ReflectionCache> cache = GetReflectionCache(configurable->getName());
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lock(cache->lock);
+        if (cache->hasParamDescs) {
+            mParamDescs = cache->paramDescs;
+            cached = true;
+        }
+    }
+    if (!cached) {
+        c2err = configurable->querySupportedParams(&mParamDescs);
+        if (c2err != C2_OK) {
+            ALOGD("Query supported params failed after returning %zu values => %s",
+                    mParamDescs.size(), asString(c2err));
+            return UNKNOWN_ERROR;
+        }
+        std::lock_guard<std::mutex> lock(cache->lock);
+        cache->hasParamDescs = true;
+        cache->paramDescs = mParamDescs;
     }
+    ALOGV("%s supported params (%zu)", cached ? "cached" : "queried", mParamDescs.size());
     for (const std::shared_ptr<C2ParamDescriptor> &desc : mParamDescs) {
         mSupportedIndices.emplace(desc->index());
     }
 
-    mReflector = reflector;
-    if (mReflector == nullptr) {
+    if (reflector == nullptr) {
         ALOGE("Null param reflector");
         return UNKNOWN_ERROR;
     }
+    mReflector = std::make_shared<CachedParamReflector>(reflector, cache);
 
     // enumerate all fields
     mParamUpdater = std::make_shared<ReflectedParamUpdater>();
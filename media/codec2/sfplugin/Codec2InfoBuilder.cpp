@@ -391,8 +391,106 @@ Switch isDomainEnabled(
     return isSettingEnabled("domain-" + domain, settings);
 }
 
+// Search dirs for the codec shaping information that the mainline modules
+// for media may optionally include, based on vendor partition SDK, and the
+// brand/product/device information (expect to be empty in almost always)
+std::vector<std::string> getShapingSearchDirs() {
+    // get build info so we know what file to search
+    // ro.vendor.build.fingerprint
+    std::string fingerprint = base::GetProperty("ro.vendor.build.fingerprint",
+                                           "brand/product/device:");
+    ALOGV("property_get for ro.vendor.build.fingerprint == '%s'", fingerprint.c_str());
+
+    // ro.vendor.build.version.sdk
+    std::string sdk = base::GetProperty("ro.vendor.build.version.sdk", "0");
+    ALOGV("property_get for ro.vendor.build.version.sdk == '%s'", sdk.c_str());
+
+    std::string brand;
+    std::string product;
+    std::string device;
+    size_t pos1;
+    pos1 = fingerprint.find('/');
+    if (pos1 != std::string::npos) {
+        brand = fingerprint.substr(0, pos1);
+        size_t pos2 = fingerprint.find('/', pos1+1);
+        if (pos2 != std::string::npos) {
+            product = fingerprint.substr(pos1+1, pos2 - pos1 - 1);
+            size_t pos3 = fingerprint.find('/', pos2+1);
+            if (pos3 != std::string::npos) {
+                device = fingerprint.substr(pos2+1, pos3 - pos2 - 1);
+                size_t pos4 = device.find(':');
+                if (pos4 != std::string::npos) {
+                    device.resize(pos4);
+                }
+            }
+        }
+    }
+
+    ALOGV("parsed: sdk '%s' brand '%s' product '%s' device '%s'",
+        sdk.c_str(), brand.c_str(), product.c_str(), device.c_str());
+
+    std::string base = "/apex/com.android.media/etc/formatshaper";
+
+    // looking in these directories within the apex
+    return {
+        base + "/" + sdk + "/" + brand + "/" + product + "/" + device,
+        base + "/" + sdk + "/" + brand + "/" + product,
+        base + "/" + sdk + "/" + brand,
+        base + "/" + sdk,
+        base
+    };
+}
+
+typedef std::pair<std::vector<std::string>, std::vector<std::string>> XmlFilesInSearchDirs;
+
+// XML files parsed by buildMediaCodecList(), in parsing order.
+std::vector<XmlFilesInSearchDirs> getXmlFiles() {
+    return {
+        // parse APEX XML first, followed by vendor XML.
+        // Note: APEX XML names do not depend on ro.media.xml_variant.* properties.
+        { { "media_codecs.xml", "media_codecs_performance.xml" },
+          { "/apex/com.android.media.swcodec/etc" } },
+
+        // TODO: remove these c2-specific files once product moved to default file names
+        { { "media_codecs_c2.xml", "media_codecs_performance_c2.xml" },
+          MediaCodecsXmlParser::getDefaultSearchDirs() },
+
+        // parse default XML files
+        { MediaCodecsXmlParser::getDefaultXmlNames(),
+          MediaCodecsXmlParser::getDefaultSearchDirs() },
+
+        { { "media_codecs_shaping.xml" }, getShapingSearchDirs() },
+    };
+}
+
 } // unnamed namespace
 
+std::string Codec2InfoBuilder::getCacheFingerprint() {
+    std::string fingerprint = "c2:";
+    for (const char *key : {
+            "debug.stagefright.ccodec",
+            "ro.vendor.build.fingerprint",
+            "ro.vendor.build.version.sdk" }) {
+        fingerprint += ::android::base::GetProperty(key, "") + " ";
+    }
+    for (const XmlFilesInSearchDirs &files : getXmlFiles()) {
+        fingerprint += MediaCodecsXmlParser::getXmlFilesFingerprint(files.first, files.second);
+        fingerprint += " ";
+    }
+    // listing the components is cheap compared to querying their interfaces,
+    // and covers components that come and go with their stores.
+    for (const Traits &trait : Codec2Client::ListComponents()) {
+        fingerprint += "\n" + trait.name + "/" + trait.owner + "/" + trait.mediaType;
+        fingerprint += "/" + std::to_string((uint32_t)trait.domain);
+        fingerprint += "/" + std::to_string((uint32_t)trait.kind);
+        fingerprint += "/" + std::to_string(trait.rank);
+        for (const std::string &alias : trait.aliases) {
+            fingerprint += "/" + alias;
+        }
+    }
+    return fingerprint;
+}
+
 status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // TODO: Remove run-time configurations once all codecs are working
     // properly. (Assume "full" behavior eventually.)
@@ -427,71 +525,9 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // Obtain Codec2Client
     std::vector<Traits> traits = Codec2Client::ListComponents();
 
-    // parse APEX XML first, followed by vendor XML.
-    // Note: APEX XML names do not depend on ro.media.xml_variant.* properties.
     MediaCodecsXmlParser parser;
-    parser.parseXmlFilesInSearchDirs(
-            { "media_codecs.xml", "media_codecs_performance.xml" },
-            { "/apex/com.android.media.swcodec/etc" });
-
-    // TODO: remove these c2-specific files once product moved to default file names
-    parser.parseXmlFilesInSearchDirs(
-            { "media_codecs_c2.xml", "media_codecs_performance_c2.xml" });
-
-    // parse default XML files
-    parser.parseXmlFilesInSearchDirs();
-
-    // The mainline modules for media may optionally include some codec shaping information.
-    // Based on vendor partition SDK, and the brand/product/device information
-    // (expect to be empty in almost always)
-    //
-    {
-        // get build info so we know what file to search
-        // ro.vendor.build.fingerprint
-        std::string fingerprint = base::GetProperty("ro.vendor.build.fingerprint",
-                                               "brand/product/device:");
-        ALOGV("property_get for ro.vendor.build.fingerprint == '%s'", fingerprint.c_str());
-
-        // ro.vendor.build.version.sdk
-        std::string sdk = base::GetProperty("ro.vendor.build.version.sdk", "0");
-        ALOGV("property_get for ro.vendor.build.version.sdk == '%s'", sdk.c_str());
-
-        std::string brand;
-        std::string product;
-        std::string device;
-        size_t pos1;
-        pos1 = fingerprint.find('/');
-        if (pos1 != std::string::npos) {
-            brand = fingerprint.substr(0, pos1);
-            size_t pos2 = fingerprint.find('/', pos1+1);
-            if (pos2 != std::string::npos) {
-                product = fingerprint.substr(pos1+1, pos2 - pos1 - 1);
-                size_t pos3 = fingerprint.find('/', pos2+1);
-                if (pos3 != std::string::npos) {
-                    device = fingerprint.substr(pos2+1, pos3 - pos2 - 1);
-                    size_t pos4 = device.find(':');
-                    if (pos4 != std::string::npos) {
-                        device.resize(pos4);
-                    }
-                }
-            }
-        }
-
-        ALOGV("parsed: sdk '%s' brand '%s' product '%s' device '%s'",
-            sdk.c_str(), brand.c_str(), product.c_str(), device.c_str());
-
-        std::string base = "/apex/com.android.media/etc/formatshaper";
-
-        // looking in these directories within the apex
-        const std::vector<std::string> modulePathnames = {
-            base + "/" + sdk + "/" + brand + "/" + product + "/" + device,
-            base + "/" + sdk + "/" + brand + "/" + product,
-            base + "/" + sdk + "/" + brand,
-            base + "/" + sdk,
-            base
-        };
-
-        parser.parseXmlFilesInSearchDirs( { "media_codecs_shaping.xml" }, modulePathnames);
+    for (const XmlFilesInSearchDirs &files : getXmlFiles()) {
+        parser.parseXmlFilesInSearchDirs(files.first, files.second);
     }
 
     if (parser.getParsingStatus() != OK) {
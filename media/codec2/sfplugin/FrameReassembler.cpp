@@ -32,7 +32,9 @@ FrameReassembler::FrameReassembler()
       mSampleRate(0u),
       mChannelCount(0u),
       mEncoding(C2Config::PCM_16),
-      mCurrentOrdinal({0, 0, 0}) {
+      mCurrentOrdinal({0, 0, 0}),
+      mBytesCopied(0u),
+      mBytesAliased(0u) {
 }
 
 void FrameReassembler::init(
@@ -78,6 +80,8 @@ void FrameReassembler::reset() {
     mSampleRate = 0u;
     mChannelCount = 0u;
     mEncoding = C2Config::PCM_16;
+    mBytesCopied = 0u;
+    mBytesAliased = 0u;
 }
 
 FrameReassembler::operator bool() const {
@@ -87,11 +91,27 @@ FrameReassembler::operator bool() const {
 c2_status_t FrameReassembler::process(
         const sp<MediaCodecBuffer> &buffer,
         std::list<std::unique_ptr<C2Work>> *items) {
+    return process(buffer, nullptr, items);
+}
+
+c2_status_t FrameReassembler::process(
+        const sp<MediaCodecBuffer> &buffer,
+        const std::shared_ptr<C2Buffer> &c2Buffer,
+        std::list<std::unique_ptr<C2Work>> *items) {
     int64_t timeUs;
     if (!buffer->meta()->findInt64("timeUs", &timeUs)) {
         return C2_BAD_VALUE;
     }
 
+    // Frames can only alias |c2Buffer| if it holds exactly the data of |buffer|.
+    std::optional<C2ConstLinearBlock> inputBlock;
+    if (c2Buffer && c2Buffer->data().type() == C2BufferData::LINEAR
+            && c2Buffer->data().linearBlocks().size() == 1u
+            && c2Buffer->data().linearBlocks().front().size() == buffer->size()) {
+        inputBlock = c2Buffer->data().linearBlocks().front();
+    }
+    const size_t inputOffset = buffer->offset();
+
     items->splice(items->end(), mPendingWork);
 
     // Fill mCurrentBlock
@@ -132,6 +152,7 @@ c2_status_t FrameReassembler::process(
                 buffer->size(),
                 size_t(mWriteView->capacity() - mWriteView->size()));
         memcpy(mWriteView->base() + mWriteView->size(), buffer->data(), copySize);
+        mBytesCopied += copySize;
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
         mWriteView->setSize(mWriteView->size() + copySize);
         if (mWriteView->size() == mWriteView->capacity()) {
@@ -150,6 +171,23 @@ c2_status_t FrameReassembler::process(
         LOG_ALWAYS_FATAL_IF(
                 mCurrentBlock,
                 "There's remaining data but the pending block is not filled & finished");
+        if (inputBlock && buffer->size() >= frameSizeBytes) {
+            // The whole frame is in the input buffer; share it instead of copying.
+            std::shared_ptr<C2Buffer> frame = C2Buffer::CreateLinearBuffer(inputBlock->subBlock(
+                    inputBlock->offset() + (buffer->offset() - inputOffset), frameSizeBytes));
+            // The client may only reuse the input buffer once |c2Buffer| is
+            // gone, so keep it alive for as long as the frame is.
+            frame->registerOnDestroyNotify(
+                    [](const C2Buffer *, void *arg) {
+                        delete static_cast<std::shared_ptr<C2Buffer> *>(arg);
+                    },
+                    new std::shared_ptr<C2Buffer>(c2Buffer));
+            ALOGV("buffer={offset=%zu size=%zu} shared", buffer->offset(), buffer->size());
+            buffer->setRange(buffer->offset() + frameSizeBytes, buffer->size() - frameSizeBytes);
+            mBytesAliased += frameSizeBytes;
+            queueFrame(frame, items);
+            continue;
+        }
         std::unique_ptr<C2Work> work(new C2Work);
         c2_status_t err = mBlockPool->fetchLinearBlock(frameSizeBytes, mUsage, &mCurrentBlock);
         if (err != C2_OK) {
@@ -163,6 +201,7 @@ c2_status_t FrameReassembler::process(
         ALOGV("buffer={offset=%zu size=%zu} copySize=%zu",
                 buffer->offset(), buffer->size(), copySize);
         memcpy(mWriteView->base(), buffer->data(), copySize);
+        mBytesCopied += copySize;
         mWriteView->setOffset(0u);
         mWriteView->setSize(copySize);
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
@@ -209,10 +248,17 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
                 mWriteView->capacity() - mWriteView->size());
         mWriteView->setSize(mWriteView->capacity());
     }
+    queueFrame(C2Buffer::CreateLinearBuffer(
+            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())), items);
+    mCurrentBlock.reset();
+    mWriteView.reset();
+}
+
+void FrameReassembler::queueFrame(
+        const std::shared_ptr<C2Buffer> &frame, std::list<std::unique_ptr<C2Work>> *items) {
     std::unique_ptr<C2Work> work{std::make_unique<C2Work>()};
     work->input.ordinal = mCurrentOrdinal;
-    work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
-            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())));
+    work->input.buffers.push_back(frame);
     work->worklets.clear();
     work->worklets.emplace_back(new C2Worklet);
     items->push_back(std::move(work));
@@ -220,8 +266,6 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
     ++mCurrentOrdinal.frameIndex;
     mCurrentOrdinal.timestamp += mFrameSize.value() * 1000000 / mSampleRate;
     mCurrentOrdinal.customOrdinal = mCurrentOrdinal.timestamp;
-    mCurrentBlock.reset();
-    mWriteView.reset();
 }
 
 }  // namespace android
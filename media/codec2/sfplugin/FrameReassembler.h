@@ -51,6 +51,24 @@ public:
             const sp<MediaCodecBuffer> &buffer,
             std::list<std::unique_ptr<C2Work>> *items);
 
+    /**
+     * Same as process(buffer, items), except that whole frames that start
+     * on a frame boundary are queued as sub-blocks of |c2Buffer| instead of
+     * being copied; only frames straddling two input buffers are copied.
+     *
+     * \param c2Buffer  a linear buffer holding the same data as |buffer|, or
+     *                  nullptr to copy everything.
+     */
+    c2_status_t process(
+            const sp<MediaCodecBuffer> &buffer,
+            const std::shared_ptr<C2Buffer> &c2Buffer,
+            std::list<std::unique_ptr<C2Work>> *items);
+
+    /// number of input bytes copied into blocks of the pool so far
+    uint64_t bytesCopied() const { return mBytesCopied; }
+    /// number of input bytes queued without copying so far
+    uint64_t bytesAliased() const { return mBytesAliased; }
+
 private:
     std::shared_ptr<C2BlockPool> mBlockPool;
     C2MemoryUsage mUsage;
@@ -62,12 +80,16 @@ private:
     C2WorkOrdinalStruct mCurrentOrdinal;
     std::shared_ptr<C2LinearBlock> mCurrentBlock;
     std::optional<C2WriteView> mWriteView;
+    uint64_t mBytesCopied;
+    uint64_t mBytesAliased;
 
     uint64_t bytesToSamples(size_t numBytes) const;
     size_t usToSamples(uint64_t us) const;
     uint32_t bytesPerSample() const;
 
     void finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items);
+    void queueFrame(
+            const std::shared_ptr<C2Buffer> &frame, std::list<std::unique_ptr<C2Work>> *items);
 };
 
 }  // namespace android
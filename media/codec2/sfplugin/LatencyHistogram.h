@@ -0,0 +1,135 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <stdint.h>
+
+namespace android {
+
+/**
+ * Lock-free histogram of durations in power-of-two microsecond buckets:
+ * bucket 0 holds durations below 2us, bucket n holds [2^n, 2^(n+1)) us and
+ * the last bucket holds everything longer.
+ *
+ * record() may be called from one or more threads while others read. Readers
+ * see each field atomically but not a consistent snapshot of all of them,
+ * which is fine for statistics.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kNumBuckets = 24;  // the last bucket starts at ~8.4s
+
+    LatencyHistogram() : mCount(0), mSumUs(0), mMaxUs(0) {
+        for (std::atomic<uint64_t> &bucket : mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(std::chrono::steady_clock::duration duration) {
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        uint64_t value = us < 0 ? 0 : (uint64_t)us;
+        size_t bucket = value < 2 ? 0 : 63 - __builtin_clzll(value);
+        if (bucket >= kNumBuckets) {
+            bucket = kNumBuckets - 1;
+        }
+        mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        mSumUs.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = mMaxUs.load(std::memory_order_relaxed);
+        while (value > max
+                && !mMaxUs.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+        mCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+
+    uint64_t maxUs() const { return mMaxUs.load(std::memory_order_relaxed); }
+
+    uint64_t avgUs() const {
+        uint64_t count = this->count();
+        return count == 0 ? 0 : mSumUs.load(std::memory_order_relaxed) / count;
+    }
+
+    /**
+     * \param percentile  in the range of [0, 100]
+     * \return  upper bound of the bucket holding the given percentile, capped
+     *          at the maximum recorded value; 0 if nothing was recorded.
+     */
+    uint64_t percentileUs(uint32_t percentile) const {
+        std::array<uint64_t, kNumBuckets> buckets;
+        uint64_t total = 0;
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+            total += buckets[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+        // rank of the sample, rounded up
+        uint64_t rank = (total * percentile + 99) / 100;
+        uint64_t seen = 0;
+        size_t i = 0;
+        for (; i + 1 < kNumBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank && seen > 0) {
+                break;
+            }
+        }
+        uint64_t upper = (2ull << i) - 1;
+        uint64_t max = maxUs();
+        return i + 1 == kNumBuckets || upper > max ? max : upper;
+    }
+
+    /**
+     * \return  bucket counts, separated by commas with trailing empty buckets
+     *          omitted, e.g. "0,3,10,2".
+     */
+    std::string toString() const {
+        std::string out;
+        size_t used = 0;
+        std::array<uint64_t, kNumBuckets> buckets;
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+            if (buckets[i] != 0) {
+                used = i + 1;
+            }
+        }
+        for (size_t i = 0; i < used; ++i) {
+            if (i > 0) {
+                out.append(",");
+            }
+            out.append(std::to_string(buckets[i]));
+        }
+        return out;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kNumBuckets> mBuckets;
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSumUs;
+    std::atomic<uint64_t> mMaxUs;
+};
+
+}  // namespace android
+
+#endif  // LATENCY_HISTOGRAM_H_
@@ -83,7 +83,7 @@ std::shared_ptr<C2Buffer> PipelineWatcher::onInputBufferReleased(
     return buffer;
 }
 
-void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
+void PipelineWatcher::onWorkDone(uint64_t frameIndex, const Clock::time_point &doneAt) {
     ALOGV("onWorkDone(frameIndex=%llu)", (unsigned long long)frameIndex);
     auto it = mFramesInPipeline.find(frameIndex);
     if (it == mFramesInPipeline.end()) {
@@ -91,12 +91,30 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
               (unsigned long long)frameIndex);
         return;
     }
+    mLatencyStats->queueToDone.record(doneAt - it->second.queuedAt);
     (void)mFramesInPipeline.erase(it);
+
+    mFramesDone[frameIndex] = doneAt;
+    while (mFramesDone.size() > kMaxFramesDone) {
+        (void)mFramesDone.erase(mFramesDone.begin());
+    }
+}
+
+void PipelineWatcher::onWorkRendered(uint64_t frameIndex, const Clock::time_point &renderedAt) {
+    ALOGV("onWorkRendered(frameIndex=%llu)", (unsigned long long)frameIndex);
+    auto it = mFramesDone.find(frameIndex);
+    if (it == mFramesDone.end()) {
+        // e.g. the work was flushed, or the output has no input frame.
+        return;
+    }
+    mLatencyStats->doneToRender.record(renderedAt - it->second);
+    (void)mFramesDone.erase(it);
 }
 
 void PipelineWatcher::flush() {
     ALOGV("flush");
     mFramesInPipeline.clear();
+    mFramesDone.clear();
 }
 
 bool PipelineWatcher::pipelineFull() const {
@@ -23,6 +23,8 @@
 
 #include <C2Work.h>
 
+#include "LatencyHistogram.h"
+
 namespace android {
 
 /**
@@ -33,11 +35,23 @@ class PipelineWatcher {
 public:
     typedef std::chrono::steady_clock Clock;
 
+    /**
+     * Per-frame latencies of the pipeline. The histograms can be read at any
+     * time without holding the lock that protects the watcher.
+     */
+    struct LatencyStats {
+        /** from onWorkQueued() to onWorkDone() */
+        LatencyHistogram queueToDone;
+        /** from onWorkDone() to onWorkRendered() */
+        LatencyHistogram doneToRender;
+    };
+
     PipelineWatcher()
         : mInputDelay(0),
           mPipelineDelay(0),
           mOutputDelay(0),
-          mSmoothnessFactor(0) {}
+          mSmoothnessFactor(0),
+          mLatencyStats(std::make_shared<LatencyStats>()) {}
     ~PipelineWatcher() = default;
 
     /**
@@ -91,8 +105,24 @@ public:
      * The component finished processing a work item.
      *
      * \param frameIndex  input frame index
+     * \param doneAt      time when the work item came back
+     */
+    void onWorkDone(uint64_t frameIndex, const Clock::time_point &doneAt = Clock::now());
+
+    /**
+     * The client rendered the output of a work item.
+     *
+     * \param frameIndex  frame index of the output
+     * \param renderedAt  time when the client rendered the output
      */
-    void onWorkDone(uint64_t frameIndex);
+    void onWorkRendered(uint64_t frameIndex, const Clock::time_point &renderedAt = Clock::now());
+
+    /**
+     * \return  latency statistics, shared with this watcher.
+     */
+    std::shared_ptr<const LatencyStats> latencyStats() const {
+        return mLatencyStats;
+    }
 
     /**
      * Flush the pipeline.
@@ -132,6 +162,14 @@ private:
         const Clock::time_point queuedAt;
     };
     std::map<uint64_t, Frame> mFramesInPipeline;
+
+    // outputs that may still be rendered, by frame index, with the time their
+    // work was done. Outputs that are never rendered (e.g. audio, or frames
+    // the client drops) are evicted oldest first.
+    static constexpr size_t kMaxFramesDone = 64;
+    std::map<uint64_t, Clock::time_point> mFramesDone;
+
+    const std::shared_ptr<LatencyStats> mLatencyStats;
 };
 
 }  // namespace android
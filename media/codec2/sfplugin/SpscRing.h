@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+
+namespace android {
+
+/**
+ * Bounded lock-free FIFO with a single producer and a single consumer.
+ *
+ * push() may only be called from one thread at a time, and pop() may only be
+ * called from one thread at a time; the two may run concurrently. empty() may
+ * be called from any thread, and is exact only on the consumer side.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    SpscRing() : mHead(0), mTail(0) {}
+
+    /**
+     * Append |item| to the ring. Returns false, and leaves |item| untouched,
+     * if the ring is full.
+     */
+    bool push(T &&item) {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        mSlots[tail & (N - 1)] = std::move(item);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the oldest item from the ring into |item|. Returns false if the
+     * ring is empty.
+     */
+    bool pop(T *item) {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *item = std::move(mSlots[head & (N - 1)]);
+        // do not hold on to the resources of the popped item.
+        mSlots[head & (N - 1)] = T();
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, N> mSlots;
+    // keep the indices on separate cache lines so that the producer and the
+    // consumer do not false share.
+    alignas(64) std::atomic_size_t mHead;
+    alignas(64) std::atomic_size_t mTail;
+};
+
+}  // namespace android
+
+#endif  // SPSC_RING_H_
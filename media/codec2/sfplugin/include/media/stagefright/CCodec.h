@@ -70,6 +70,7 @@ public:
             const std::string &name, CodecParameterDescriptor *desc) override;
     virtual status_t subscribeToParameters(const std::vector<std::string> &names) override;
     virtual status_t unsubscribeFromParameters(const std::vector<std::string> &names) override;
+    virtual void getMetrics(const sp<AMessage> &metrics) const override;
 
     void initiateReleaseIfStuck();
     void onWorkDone(std::list<std::unique_ptr<C2Work>> &workItems);
@@ -205,6 +206,11 @@ private:
     Mutexed<std::unique_ptr<CCodecConfig>> mConfig;
     Mutexed<std::list<std::unique_ptr<C2Work>>> mWorkDoneQueue;
 
+    // time spent initializing the config after allocation, and configuring the
+    // component, for metrics
+    std::atomic<int64_t> mConfigInitTimeUs{-1};
+    std::atomic<int64_t> mConfigureTimeUs{-1};
+
     friend class CCodecCallbackImpl;
 
     DISALLOW_EVIL_CONSTRUCTORS(CCodec);
@@ -27,6 +27,7 @@ public:
     Codec2InfoBuilder() = default;
     ~Codec2InfoBuilder() override = default;
     status_t buildMediaCodecList(MediaCodecListWriter* writer) override;
+    std::string getCacheFingerprint() override;
 };
 
 }  // namespace android
@@ -16,6 +16,7 @@
 
 #include "CCodecConfig.h"
 
+#include <atomic>
 #include <set>
 
 #include <gtest/gtest.h>
@@ -84,7 +85,12 @@ public:
                 C2Component::domain_t domain,
                 C2Component::kind_t kind,
                 const char *mediaType)
-            : ConfigurableC2Intf("name", 0u),
+            // CCodecConfig caches reflection by component name, so the name
+            // must reflect the set of supported params.
+            : ConfigurableC2Intf(
+                    std::string("c2.test.") + mediaType
+                            + (kind == C2Component::KIND_ENCODER ? ".encoder" : ".decoder"),
+                    0u),
               mImpl(reflector, domain, kind, mediaType) {
         }
 
@@ -104,9 +110,12 @@ public:
 
         c2_status_t querySupportedParams(
                 std::vector<std::shared_ptr<C2ParamDescriptor>>* const params) const override {
+            ++sQuerySupportedParamsCount;
             return mImpl.querySupportedParams(params);
         }
 
+        static std::atomic_int sQuerySupportedParamsCount;
+
         c2_status_t querySupportedValues(
                 std::vector<C2FieldSupportedValuesQuery>& fields,
                 c2_blocking_t mayBlock) const override {
@@ -275,6 +284,8 @@ public:
     CCodecConfig mConfig;
 };
 
+std::atomic_int CCodecConfigTest::Configurable::sQuerySupportedParamsCount{0};
+
 using D = CCodecConfig::Domain;
 
 template<typename T>
@@ -589,6 +600,27 @@ TEST_F(CCodecConfigTest, DataspaceUpdate) {
             << "mOutputFormat = " << mConfig.mOutputFormat->debugString().c_str();
 }
 
+TEST_F(CCodecConfigTest, ReflectionCache) {
+    init(C2Component::DOMAIN_AUDIO, C2Component::KIND_ENCODER, MIMETYPE_AUDIO_OPUS);
+    ASSERT_EQ(OK, mConfig.initialize(mReflector, mConfigurable));
+    int queryCount = Configurable::sQuerySupportedParamsCount;
+    std::vector<std::string> names;
+    ASSERT_EQ(OK, mConfig.querySupportedParameters(&names));
+
+    // another instance of the same component reuses the reflection
+    std::shared_ptr<Codec2Client::Configurable> first = mConfigurable;
+    init(C2Component::DOMAIN_AUDIO, C2Component::KIND_ENCODER, MIMETYPE_AUDIO_OPUS);
+    ASSERT_NE(first, mConfigurable);
+    CCodecConfig config;
+    ASSERT_EQ(OK, config.initialize(mReflector, mConfigurable));
+    EXPECT_EQ(queryCount, Configurable::sQuerySupportedParamsCount);
+    EXPECT_EQ(mConfig.mDomain, config.mDomain);
+    EXPECT_EQ(MIMETYPE_AUDIO_OPUS, config.mCodingMediaType);
+    std::vector<std::string> cachedNames;
+    ASSERT_EQ(OK, config.querySupportedParameters(&cachedNames));
+    EXPECT_EQ(names, cachedNames);
+}
+
 typedef std::tuple<std::string, C2Config::profile_t, int32_t> HdrProfilesParams;
 
 class HdrProfilesTest
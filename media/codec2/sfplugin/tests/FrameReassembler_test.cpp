@@ -54,7 +54,8 @@ public:
             size_t inputFrameSizeInBytes,
             size_t count,
             size_t expectedOutputSize,
-            bool separateEos) {
+            bool separateEos,
+            bool shareFrames = false) {
         FrameReassembler frameReassembler;
         frameReassembler.init(
                 mPool,
@@ -85,8 +86,12 @@ public:
                     buffer->base()[j] = (inputIndex & 0xFF);
                 }
             }
+            std::shared_ptr<C2Buffer> c2Buffer;
+            if (shareFrames && buffer->size() > 0) {
+                ASSERT_NO_FATAL_FAILURE(CopyToC2Buffer(buffer, &c2Buffer));
+            }
             std::list<std::unique_ptr<C2Work>> items;
-            ASSERT_EQ(C2_OK, frameReassembler.process(buffer, &items));
+            ASSERT_EQ(C2_OK, frameReassembler.process(buffer, c2Buffer, &items));
             while (!items.empty()) {
                 std::unique_ptr<C2Work> work = std::move(*items.begin());
                 items.erase(items.begin());
@@ -133,6 +138,45 @@ public:
             << " input size = " << inputIndex << " frame size = " << encoderFrameSizeInBytes;
     }
 
+    // Returns a linear buffer from the pool with the same content as |buffer|.
+    void CopyToC2Buffer(const sp<MediaCodecBuffer> &buffer, std::shared_ptr<C2Buffer> *c2Buffer) {
+        std::shared_ptr<C2LinearBlock> block;
+        ASSERT_EQ(C2_OK, mPool->fetchLinearBlock(buffer->size(), kUsage, &block));
+        C2WriteView view = block->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        memcpy(view.base(), buffer->data(), buffer->size());
+        *c2Buffer = C2Buffer::CreateLinearBuffer(block->share(0, buffer->size(), C2Fence()));
+    }
+
+    // Feeds |durationSec| seconds of 48kHz stereo 16-bit PCM in input buffers of
+    // |inputSizeInBytes| to a reassembler producing AAC sized frames, and
+    // returns the number of bytes copied per second of audio.
+    uint64_t bytesCopiedPerSecond(size_t inputSizeInBytes, size_t durationSec, bool shareFrames) {
+        constexpr size_t kSampleRate = 48000;
+        constexpr size_t kChannelCount = 2;
+        FrameReassembler frameReassembler;
+        frameReassembler.init(mPool, kUsage, 1024, kSampleRate, kChannelCount, PCM_16);
+        const size_t totalBytes = durationSec * kSampleRate * kChannelCount * 2;
+        size_t framesQueued = 0;
+        for (size_t offset = 0; offset < totalBytes; offset += inputSizeInBytes) {
+            size_t size = std::min(inputSizeInBytes, totalBytes - offset);
+            sp<MediaCodecBuffer> buffer = new MediaCodecBuffer(new AMessage, new ABuffer(size));
+            buffer->setRange(0, size);
+            buffer->meta()->setInt64(
+                    "timeUs", offset / (kChannelCount * 2) * 1000000 / kSampleRate);
+            std::shared_ptr<C2Buffer> c2Buffer;
+            if (shareFrames) {
+                CopyToC2Buffer(buffer, &c2Buffer);
+            }
+            std::list<std::unique_ptr<C2Work>> items;
+            EXPECT_EQ(C2_OK, frameReassembler.process(buffer, c2Buffer, &items));
+            framesQueued += items.size();
+        }
+        EXPECT_EQ(totalBytes / (1024 * kChannelCount * 2), framesQueued);
+        EXPECT_EQ(totalBytes, frameReassembler.bytesCopied() + frameReassembler.bytesAliased());
+        return frameReassembler.bytesCopied() / durationSec;
+    }
+
 private:
     status_t mInitStatus;
     std::shared_ptr<C2BlockPool> mPool;
@@ -378,4 +422,80 @@ TEST_F(FrameReassemblerTest, PushBigChunk) {
     }
 }
 
+// Frames shared with the input buffers must carry the same data as copied ones.
+TEST_F(FrameReassemblerTest, ShareFrames) {
+    ASSERT_EQ(OK, initStatus());
+    for (bool separateEos : {false, true}) {
+        testPushSameSize(
+                1024 /* frame size in samples */,
+                48000 /* sample rate */,
+                1 /* channel count */,
+                PCM_16,
+                2048 /* input frame size in bytes = 1024 samples * 1 channel * 2 bytes/sample */,
+                10 /* count */,
+                20480 /* expected output size = 10 * 2048 bytes/frame */,
+                separateEos,
+                true /* shareFrames */);
+        testPushSameSize(
+                1024 /* frame size in samples */,
+                48000 /* sample rate */,
+                1 /* channel count */,
+                PCM_16,
+                1024 /* input frame size in bytes = 512 samples * 1 channel * 2 bytes/sample */,
+                10 /* count */,
+                10240 /* expected output size = 5 * 2048 bytes/frame */,
+                separateEos,
+                true /* shareFrames */);
+        testPushSameSize(
+                1024 /* frame size in samples */,
+                48000 /* sample rate */,
+                1 /* channel count */,
+                PCM_16,
+                4096 /* input frame size in bytes = 2048 samples * 1 channel * 2 bytes/sample */,
+                10 /* count */,
+                40960 /* expected output size = 20 * 2048 bytes/frame */,
+                separateEos,
+                true /* shareFrames */);
+        testPushSameSize(
+                1024 /* frame size in samples */,
+                48000 /* sample rate */,
+                1 /* channel count */,
+                PCM_16,
+                2050 /* input frame size in bytes */,
+                10 /* count */,
+                22528 /* expected output size = 11 * 2048 bytes/frame */,
+                separateEos,
+                true /* shareFrames */);
+        testPushSameSize(
+                1024 /* frame size in samples */,
+                48000 /* sample rate */,
+                1 /* channel count */,
+                PCM_FLOAT,
+                100000 /* input frame size in bytes */,
+                1 /* count */,
+                102400 /* expected output size = 25 * 4096 bytes/frame */,
+                separateEos,
+                true /* shareFrames */);
+    }
+}
+
+// Compares how much PCM gets copied per second of audio with and without
+// sharing frames, for a few typical app buffer sizes.
+TEST_F(FrameReassemblerTest, BytesCopiedPerSecond) {
+    ASSERT_EQ(OK, initStatus());
+    constexpr size_t kDurationSec = 32;  // a whole number of 1024 sample frames
+    constexpr uint64_t kBytesPerSecond = 48000 * 2 * 2;
+    for (size_t inputSize : {2048, 3840, 4096, 8192, 10000, 16384}) {
+        uint64_t copied = bytesCopiedPerSecond(inputSize, kDurationSec, false);
+        uint64_t shared = bytesCopiedPerSecond(inputSize, kDurationSec, true);
+        printf("input buffer %5zu bytes: copied %6llu -> %6llu bytes per second of audio\n",
+               inputSize, (unsigned long long)copied, (unsigned long long)shared);
+        EXPECT_EQ(kBytesPerSecond, copied);
+        EXPECT_GE(copied, shared);
+        if (inputSize % 4096 == 0) {
+            EXPECT_EQ(0u, shared) << "input size = " << inputSize;
+        }
+    }
+}
+
 } // namespace android
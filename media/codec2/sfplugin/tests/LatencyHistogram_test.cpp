@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+#include "PipelineWatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace android {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+TEST(LatencyHistogramTest, Buckets) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.percentileUs(50));
+    EXPECT_EQ("", histogram.toString());
+
+    histogram.record(microseconds(1));    // bucket 0
+    histogram.record(microseconds(3));    // bucket 1
+    histogram.record(microseconds(5));    // bucket 2
+    histogram.record(microseconds(7));    // bucket 2
+    EXPECT_EQ(4u, histogram.count());
+    EXPECT_EQ(4u, histogram.avgUs());
+    EXPECT_EQ(7u, histogram.maxUs());
+    EXPECT_EQ("1,1,2", histogram.toString());
+    EXPECT_EQ(1u, histogram.percentileUs(25));
+    EXPECT_EQ(3u, histogram.percentileUs(50));
+    EXPECT_EQ(7u, histogram.percentileUs(100));
+
+    // negative durations count as 0, very long ones land in the last bucket
+    histogram.record(microseconds(-5));
+    histogram.record(std::chrono::seconds(60));
+    EXPECT_EQ(6u, histogram.count());
+    EXPECT_EQ(60000000u, histogram.maxUs());
+    EXPECT_EQ(60000000u, histogram.percentileUs(100));
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecord) {
+    constexpr int kThreads = 4;
+    constexpr int kSamples = 10000;
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&histogram] {
+            for (int i = 0; i < kSamples; ++i) {
+                histogram.record(microseconds(i % 1000));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ((uint64_t)kThreads * kSamples, histogram.count());
+    EXPECT_EQ(999u, histogram.maxUs());
+}
+
+TEST(PipelineWatcherTest, Latencies) {
+    PipelineWatcher watcher;
+    std::shared_ptr<const PipelineWatcher::LatencyStats> stats = watcher.latencyStats();
+    PipelineWatcher::Clock::time_point start = PipelineWatcher::Clock::now();
+
+    watcher.onWorkQueued(0, {}, start);
+    watcher.onWorkQueued(1, {}, start);
+    watcher.onWorkDone(0, start + milliseconds(10));
+    watcher.onWorkDone(1, start + milliseconds(20));
+    watcher.onWorkRendered(0, start + milliseconds(15));
+    // unknown or already rendered frames are ignored
+    watcher.onWorkRendered(0, start + milliseconds(30));
+    watcher.onWorkRendered(7, start + milliseconds(30));
+
+    EXPECT_EQ(2u, stats->queueToDone.count());
+    EXPECT_EQ(15000u, stats->queueToDone.avgUs());
+    EXPECT_EQ(20000u, stats->queueToDone.maxUs());
+    EXPECT_EQ(1u, stats->doneToRender.count());
+    EXPECT_EQ(5000u, stats->doneToRender.maxUs());
+
+    // flushed outputs are not rendered
+    watcher.flush();
+    watcher.onWorkRendered(1, start + milliseconds(40));
+    EXPECT_EQ(1u, stats->doneToRender.count());
+}
+
+} // namespace android
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpscRing.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+namespace android {
+
+TEST(SpscRingTest, PushPop) {
+    SpscRing<int, 4> ring;
+    int value = 0;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(&value));
+
+    for (int i = 0; i < 4; ++i) {
+        int item = i;
+        EXPECT_TRUE(ring.push(std::move(item)));
+    }
+    int extra = 4;
+    EXPECT_FALSE(ring.push(std::move(extra)));
+    EXPECT_EQ(4, extra);
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.pop(&value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, PopReleasesItem) {
+    SpscRing<std::shared_ptr<int>, 2> ring;
+    std::shared_ptr<int> item = std::make_shared<int>(1);
+    std::weak_ptr<int> weak = item;
+    ASSERT_TRUE(ring.push(std::move(item)));
+
+    std::shared_ptr<int> popped;
+    ASSERT_TRUE(ring.pop(&popped));
+    popped.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(SpscRingTest, ConcurrentOrder) {
+    constexpr int kCount = 100000;
+    SpscRing<int, 16> ring;
+
+    std::thread producer([&ring] {
+        for (int i = 0; i < kCount; ) {
+            int item = i;
+            if (ring.push(std::move(item))) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    while (expected < kCount) {
+        int value;
+        if (ring.pop(&value)) {
+            ASSERT_EQ(expected, value);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
+
+} // namespace android
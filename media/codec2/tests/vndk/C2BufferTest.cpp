@@ -432,6 +432,37 @@ TEST_F(C2BufferTest, BlockPoolTest) {
     }
 }
 
+TEST_F(C2BufferTest, RecyclingBlockPoolTest) {
+    constexpr uint32_t kCapacity = 100000u;
+    const C2MemoryUsage kUsage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+
+    std::shared_ptr<C2BlockPool> blockPool =
+        std::make_shared<C2RecyclingBlockPool>(mLinearAllocator, C2BlockPool::BASIC_LINEAR);
+
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity, kUsage, &block));
+    ASSERT_TRUE(block);
+    ASSERT_LE(kCapacity, block->capacity());
+    const C2Handle *handle = block->handle();
+
+    // a freed allocation is reused for a request of the same size class.
+    block.reset();
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity + 1, kUsage, &block));
+    ASSERT_TRUE(block);
+    ASSERT_EQ(handle, block->handle());
+
+    // but not while it is in use.
+    std::shared_ptr<C2LinearBlock> other;
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity, kUsage, &other));
+    ASSERT_TRUE(other);
+    ASSERT_NE(block->handle(), other->handle());
+
+    C2Acquirable<C2WriteView> writeViewHolder = block->map();
+    C2WriteView writeView = writeViewHolder.get();
+    ASSERT_EQ(C2_OK, writeView.error());
+    ASSERT_NE(nullptr, writeView.data());
+}
+
 void fillPlane(const C2Rect rect, const C2PlaneInfo info, uint8_t *addr, uint8_t value) {
     for (uint32_t row = 0; row < rect.height / info.rowSampling; ++row) {
         int32_t rowOffset = (row + rect.top / info.rowSampling) * info.rowInc;
@@ -18,9 +18,11 @@
 #define LOG_TAG "C2Buffer"
 #include <utils/Log.h>
 
+#include <chrono>
 #include <list>
 #include <map>
 #include <mutex>
+#include <tuple>
 
 #include <C2AllocatorBlob.h>
 #include <C2AllocatorGralloc.h>
@@ -1110,6 +1112,195 @@ c2_status_t C2BasicGraphicBlockPool::fetchGraphicBlock(
     return C2_OK;
 }
 
+/**
+ * Recycling block pool implementation.
+ */
+class C2RecyclingBlockPool::Impl : public std::enable_shared_from_this<Impl> {
+public:
+    explicit Impl(const std::shared_ptr<C2Allocator> &allocator) : mAllocator(allocator) {}
+
+    c2_status_t fetchLinearBlock(
+            uint32_t capacity,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2LinearBlock> *block /* nonnull */) {
+        block->reset();
+        std::shared_ptr<C2LinearAllocation> alloc;
+        if (capacity > kMaxRecycledCapacity) {
+            c2_status_t err = mAllocator->newLinearAllocation(capacity, usage, &alloc);
+            if (err != C2_OK) {
+                return err;
+            }
+            *block = _C2BlockFactory::CreateLinearBlock(alloc);
+            return C2_OK;
+        }
+        const Key key{SizeClass(capacity), 0, 0, usage.expected};
+        take(&mLinear, key, &alloc);
+        if (!alloc) {
+            c2_status_t err = mAllocator->newLinearAllocation(
+                    std::get<0>(key), usage, &alloc);
+            if (err != C2_OK) {
+                return err;
+            }
+        }
+        *block = _C2BlockFactory::CreateLinearBlock(wrap(&Impl::recycleLinear, key, alloc));
+        return C2_OK;
+    }
+
+    c2_status_t fetchGraphicBlock(
+            uint32_t width,
+            uint32_t height,
+            uint32_t format,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2GraphicBlock> *block /* nonnull */) {
+        block->reset();
+        const Key key{width, height, format, usage.expected};
+        std::shared_ptr<C2GraphicAllocation> alloc;
+        take(&mGraphic, key, &alloc);
+        if (!alloc) {
+            c2_status_t err = mAllocator->newGraphicAllocation(
+                    width, height, format, usage, &alloc);
+            if (err != C2_OK) {
+                return err;
+            }
+        }
+        *block = _C2BlockFactory::CreateGraphicBlock(wrap(&Impl::recycleGraphic, key, alloc));
+        return C2_OK;
+    }
+
+    void trim() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLinear.clear();
+        mGraphic.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Allocations idle for longer than this are freed.
+    static constexpr std::chrono::seconds kIdleTimeout{5};
+    // Maximum number of idle allocations kept per size class, dimensions and usage.
+    static constexpr size_t kMaxIdlePerKey = 4;
+    // Larger linear allocations are not recycled.
+    static constexpr uint32_t kMaxRecycledCapacity = 16 * 1024 * 1024;
+    static constexpr uint32_t kMinSizeClass = 4096;
+
+    // (capacity or width, height, format, usage)
+    using Key = std::tuple<uint32_t, uint32_t, uint32_t, uint64_t>;
+    template <typename T>
+    struct Idle {
+        std::shared_ptr<T> alloc;
+        Clock::time_point since;
+    };
+    template <typename T>
+    using IdleMap = std::map<Key, std::list<Idle<T>>>;
+
+    // Rounds |capacity| up to one of four size classes per power of two, so
+    // that an allocation spends at most a quarter of its capacity on rounding.
+    static uint32_t SizeClass(uint32_t capacity) {
+        if (capacity <= kMinSizeClass) {
+            return kMinSizeClass;
+        }
+        const uint32_t step = 1u << (29 - __builtin_clz(capacity));
+        return (capacity + step - 1) & ~(step - 1);
+    }
+
+    // Returns a block allocation for |alloc| that hands |alloc| back to
+    // |recycle| once the last block using it is gone.
+    template <typename T>
+    std::shared_ptr<T> wrap(
+            void (Impl::*recycle)(const Key &, std::shared_ptr<T> &&),
+            const Key &key, const std::shared_ptr<T> &alloc) {
+        std::weak_ptr<Impl> weak = shared_from_this();
+        return std::shared_ptr<T>(alloc.get(), [weak, recycle, key, owned = alloc](T *) mutable {
+            std::shared_ptr<Impl> impl = weak.lock();
+            if (impl) {
+                (impl.get()->*recycle)(key, std::move(owned));
+            }
+        });
+    }
+
+    void recycleLinear(const Key &key, std::shared_ptr<C2LinearAllocation> &&alloc) {
+        put(&mLinear, key, std::move(alloc));
+    }
+
+    void recycleGraphic(const Key &key, std::shared_ptr<C2GraphicAllocation> &&alloc) {
+        put(&mGraphic, key, std::move(alloc));
+    }
+
+    template <typename T>
+    void take(IdleMap<T> *idle, const Key &key, std::shared_ptr<T> *alloc) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        expireLocked(Clock::now());
+        auto it = idle->find(key);
+        if (it != idle->end()) {
+            // the most recently freed allocation is the most likely to be warm.
+            *alloc = std::move(it->second.back().alloc);
+            it->second.pop_back();
+            if (it->second.empty()) {
+                idle->erase(it);
+            }
+        }
+    }
+
+    template <typename T>
+    void put(IdleMap<T> *idle, const Key &key, std::shared_ptr<T> &&alloc) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const Clock::time_point now = Clock::now();
+        expireLocked(now);
+        std::list<Idle<T>> &list = (*idle)[key];
+        if (list.size() >= kMaxIdlePerKey) {
+            list.pop_front();
+        }
+        list.push_back({std::move(alloc), now});
+    }
+
+    void expireLocked(Clock::time_point now) {
+        expireLocked(&mLinear, now);
+        expireLocked(&mGraphic, now);
+    }
+
+    template <typename T>
+    static void expireLocked(IdleMap<T> *idle, Clock::time_point now) {
+        for (auto it = idle->begin(); it != idle->end(); ) {
+            while (!it->second.empty() && now - it->second.front().since > kIdleTimeout) {
+                it->second.pop_front();
+            }
+            it = it->second.empty() ? idle->erase(it) : std::next(it);
+        }
+    }
+
+    const std::shared_ptr<C2Allocator> mAllocator;
+    std::mutex mMutex;
+    IdleMap<C2LinearAllocation> mLinear;
+    IdleMap<C2GraphicAllocation> mGraphic;
+};
+
+C2RecyclingBlockPool::C2RecyclingBlockPool(
+        const std::shared_ptr<C2Allocator> &allocator, const local_id_t localId)
+    : mAllocator(allocator), mLocalId(localId), mImpl(std::make_shared<Impl>(allocator)) {}
+
+C2RecyclingBlockPool::~C2RecyclingBlockPool() {}
+
+c2_status_t C2RecyclingBlockPool::fetchLinearBlock(
+        uint32_t capacity,
+        C2MemoryUsage usage,
+        std::shared_ptr<C2LinearBlock> *block /* nonnull */) {
+    return mImpl->fetchLinearBlock(capacity, usage, block);
+}
+
+c2_status_t C2RecyclingBlockPool::fetchGraphicBlock(
+        uint32_t width,
+        uint32_t height,
+        uint32_t format,
+        C2MemoryUsage usage,
+        std::shared_ptr<C2GraphicBlock> *block /* nonnull */) {
+    return mImpl->fetchGraphicBlock(width, height, format, usage, block);
+}
+
+void C2RecyclingBlockPool::trim() {
+    mImpl->trim();
+}
+
 std::shared_ptr<C2GraphicBlock> _C2BlockFactory::CreateGraphicBlock(
         const std::shared_ptr<C2GraphicAllocation> &alloc,
         const std::shared_ptr<_C2BlockPoolData> &data, const C2Rect &allottedCrop) {
@@ -34,6 +34,8 @@
 #include <dlfcn.h>
 #include <unistd.h> // getpagesize
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -447,6 +449,83 @@ C2PlatformAllocatorStore::id_t GetPreferredLinearAllocatorId(int poolMask) {
 
 namespace {
 
+class C2CoreBudget : public std::enable_shared_from_this<C2CoreBudget> {
+public:
+    class Grant : public C2CoreBudgetGrant {
+    public:
+        Grant(const std::shared_ptr<C2CoreBudget> &budget, size_t wanted)
+            : mBudget(budget), mWanted(std::max(wanted, (size_t)1)), mCores(1) {}
+
+        ~Grant() override {
+            mBudget->remove(this);
+        }
+
+        size_t cores() const override {
+            return mCores.load(std::memory_order_relaxed);
+        }
+
+    private:
+        friend class C2CoreBudget;
+        const std::shared_ptr<C2CoreBudget> mBudget;
+        const size_t mWanted;
+        std::atomic_size_t mCores;
+    };
+
+    C2CoreBudget() : mTotal(GetTotal()) {}
+
+    std::shared_ptr<C2CoreBudgetGrant> acquire(size_t wanted) {
+        std::shared_ptr<Grant> grant = std::make_shared<Grant>(shared_from_this(), wanted);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGrants.push_back(grant.get());
+        rebalance_l();
+        return grant;
+    }
+
+private:
+    static size_t GetTotal() {
+        int32_t total = property_get_int32("media.stagefright.c2-core-budget", 0);
+        if (total <= 0) {
+            total = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        return std::max(total, 1);
+    }
+
+    void remove(Grant *grant) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGrants.erase(std::remove(mGrants.begin(), mGrants.end(), grant), mGrants.end());
+        rebalance_l();
+    }
+
+    void rebalance_l() {
+        // hand out an even share to each grant, smallest requests first so that
+        // what they do not use goes to the larger ones.
+        std::vector<Grant *> grants = mGrants;
+        std::sort(grants.begin(), grants.end(), [](const Grant *a, const Grant *b) {
+            return a->mWanted < b->mWanted;
+        });
+        size_t remaining = mTotal;
+        for (size_t i = 0; i < grants.size(); ++i) {
+            size_t share = std::max(remaining / (grants.size() - i), (size_t)1);
+            size_t cores = std::min(grants[i]->mWanted, share);
+            grants[i]->mCores.store(cores, std::memory_order_relaxed);
+            remaining -= std::min(cores, remaining);
+        }
+    }
+
+    const size_t mTotal;
+    std::mutex mMutex;
+    std::vector<Grant *> mGrants;
+};
+
+}  // namespace
+
+std::shared_ptr<C2CoreBudgetGrant> AcquireCodec2CoreBudget(size_t wanted) {
+    static std::shared_ptr<C2CoreBudget> sBudget = std::make_shared<C2CoreBudget>();
+    return sBudget->acquire(wanted);
+}
+
+namespace {
+
 class _C2BlockPoolCache {
 public:
     _C2BlockPoolCache() : mBlockPoolSeqId(C2BlockPool::PLATFORM_START + 1) {}
@@ -598,6 +677,32 @@ private:
 static std::unique_ptr<_C2BlockPoolCache> sBlockPoolCache =
     std::make_unique<_C2BlockPoolCache>();
 
+/**
+ * Returns whether the basic block pools recycle their allocations, see
+ * C2RecyclingBlockPool.
+ */
+bool UseRecyclingBasicBlockPools() {
+    static const bool sUseRecycling =
+        property_get_bool("debug.stagefright.c2-recycle-basic-pools", false);
+    return sUseRecycling;
+}
+
+/**
+ * Returns the process-wide recycling block pool for |allocator|, so that
+ * allocations freed by one component can be reused by the next.
+ */
+std::shared_ptr<C2BlockPool> GetRecyclingBasicBlockPool(
+        const std::shared_ptr<C2Allocator> &allocator, C2BlockPool::local_id_t id) {
+    static std::mutex sMutex;
+    static std::map<C2Allocator::id_t, std::shared_ptr<C2RecyclingBlockPool>> sPools;
+    std::lock_guard<std::mutex> lock(sMutex);
+    std::shared_ptr<C2RecyclingBlockPool> &pool = sPools[allocator->getId()];
+    if (!pool) {
+        pool = std::make_shared<C2RecyclingBlockPool>(allocator, id);
+    }
+    return pool;
+}
+
 } // anynymous namespace
 
 c2_status_t GetCodec2BlockPool(
@@ -616,13 +721,21 @@ c2_status_t GetCodec2BlockPool(
     case C2BlockPool::BASIC_LINEAR:
         res = allocatorStore->fetchAllocator(C2AllocatorStore::DEFAULT_LINEAR, &allocator);
         if (res == C2_OK) {
-            *pool = std::make_shared<C2BasicLinearBlockPool>(allocator);
+            if (UseRecyclingBasicBlockPools()) {
+                *pool = GetRecyclingBasicBlockPool(allocator, C2BlockPool::BASIC_LINEAR);
+            } else {
+                *pool = std::make_shared<C2BasicLinearBlockPool>(allocator);
+            }
         }
         break;
     case C2BlockPool::BASIC_GRAPHIC:
         res = allocatorStore->fetchAllocator(C2AllocatorStore::DEFAULT_GRAPHIC, &allocator);
         if (res == C2_OK) {
-            *pool = std::make_shared<C2BasicGraphicBlockPool>(allocator);
+            if (UseRecyclingBasicBlockPools()) {
+                *pool = GetRecyclingBasicBlockPool(allocator, C2BlockPool::BASIC_GRAPHIC);
+            } else {
+                *pool = std::make_shared<C2BasicGraphicBlockPool>(allocator);
+            }
         }
         break;
     default:
@@ -72,6 +72,59 @@ private:
     const std::shared_ptr<C2Allocator> mAllocator;
 };
 
+/**
+ * Block pool that keeps freed allocations of its allocator for reuse, instead
+ * of returning them to the allocator right away.
+ *
+ * Linear allocations are rounded up to size classes, so a freed allocation can
+ * serve any later request of the same class. Graphic allocations are reused
+ * only for the same dimensions and format. Allocations are also kept apart by
+ * usage. Allocations idle for longer than a timeout, or over the per class
+ * limit, are freed.
+ *
+ * An allocation is recycled as soon as the last local block referencing it is
+ * gone, so blocks from this pool must not be shared with other processes as
+ * native handles.
+ */
+class C2RecyclingBlockPool : public C2BlockPool {
+public:
+    C2RecyclingBlockPool(const std::shared_ptr<C2Allocator> &allocator, const local_id_t localId);
+
+    virtual ~C2RecyclingBlockPool() override;
+
+    virtual C2Allocator::id_t getAllocatorId() const override {
+        return mAllocator->getId();
+    }
+
+    virtual local_id_t getLocalId() const override {
+        return mLocalId;
+    }
+
+    virtual c2_status_t fetchLinearBlock(
+            uint32_t capacity,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2LinearBlock> *block /* nonnull */) override;
+
+    virtual c2_status_t fetchGraphicBlock(
+            uint32_t width,
+            uint32_t height,
+            uint32_t format,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2GraphicBlock> *block /* nonnull */) override;
+
+    /**
+     * Frees all allocations that are kept for reuse.
+     */
+    void trim();
+
+private:
+    const std::shared_ptr<C2Allocator> mAllocator;
+    const local_id_t mLocalId;
+
+    class Impl;
+    std::shared_ptr<Impl> mImpl;
+};
+
 class C2PooledBlockPool : public C2BlockPool {
 public:
     C2PooledBlockPool(const std::shared_ptr<C2Allocator> &allocator, const local_id_t localId);
@@ -100,6 +100,9 @@ public:
 /**
  * Retrieves a block pool for a component.
  *
+ * If property "debug.stagefright.c2-recycle-basic-pools" is set, the basic pools are shared by the
+ * process and keep freed allocations for reuse (see C2RecyclingBlockPool).
+ *
  * \param id        the local ID of the block pool
  * \param component the component using the block pool (must be non-null)
  * \param pool      pointer to where the obtained block pool shall be stored on success. nullptr
@@ -191,6 +194,34 @@ int GetCodec2PoolMask();
  */
 C2PlatformAllocatorStore::id_t GetPreferredLinearAllocatorId(int poolMask);
 
+/**
+ * A share of the CPU cores of the device held by a software codec that runs
+ * threads of its own (e.g. the libavc and libhevc decoders). The share is
+ * returned to the budget when this object is destroyed.
+ */
+class C2CoreBudgetGrant {
+public:
+    virtual ~C2CoreBudgetGrant() = default;
+
+    /**
+     * Returns the number of cores currently granted. This is at least 1 and at
+     * most the number requested, and changes as other codecs acquire and
+     * release their grants.
+     */
+    virtual size_t cores() const = 0;
+};
+
+/**
+ * Acquires a share of the process-wide core budget for a codec that would
+ * like to use up to |wanted| threads.
+ *
+ * The budget is the number of online cores, or the value of property
+ * "media.stagefright.c2-core-budget" if set. It is split evenly between the
+ * active grants; grants that want less than an even share leave the rest to
+ * the others.
+ */
+std::shared_ptr<C2CoreBudgetGrant> AcquireCodec2CoreBudget(size_t wanted);
+
 } // namespace android
 
 #endif // STAGEFRIGHT_CODEC2_PLATFORM_SUPPORT_H_
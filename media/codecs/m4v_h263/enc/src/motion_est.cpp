@@ -557,11 +557,11 @@ void InitHTFM(VideoEncData *video, HTFM_Stat *htfm_stat, double *newvar, Int *co
             newvar[i] = 0.0;
         }
 //      video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING_HTFM_Collect;
-        video->functionPointer->SAD_Macroblock = &SAD_MB_HTFM_Collect;
+        video->functionPointer->SAD_Macroblock = video->functionPointer->SAD_MB_HTFM_Collect;
         video->functionPointer->SAD_MB_HalfPel[0] = NULL;
-        video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HP_HTFM_Collectxh;
-        video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HP_HTFM_Collectyh;
-        video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HP_HTFM_Collectxhyh;
+        video->functionPointer->SAD_MB_HalfPel[1] = video->functionPointer->SAD_MB_HP_HTFM_Collect[1];
+        video->functionPointer->SAD_MB_HalfPel[2] = video->functionPointer->SAD_MB_HP_HTFM_Collect[2];
+        video->functionPointer->SAD_MB_HalfPel[3] = video->functionPointer->SAD_MB_HP_HTFM_Collect[3];
         video->sad_extra_info = (void*)(htfm_stat);
         offset = htfm_stat->offsetArray;
         offset2 = htfm_stat->offsetRef;
@@ -569,11 +569,11 @@ void InitHTFM(VideoEncData *video, HTFM_Stat *htfm_stat, double *newvar, Int *co
     else
     {
 //      video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING_HTFM;
-        video->functionPointer->SAD_Macroblock = &SAD_MB_HTFM;
+        video->functionPointer->SAD_Macroblock = video->functionPointer->SAD_MB_HTFM;
         video->functionPointer->SAD_MB_HalfPel[0] = NULL;
-        video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HP_HTFMxh;
-        video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HP_HTFMyh;
-        video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HP_HTFMxhyh;
+        video->functionPointer->SAD_MB_HalfPel[1] = video->functionPointer->SAD_MB_HP_HTFM[1];
+        video->functionPointer->SAD_MB_HalfPel[2] = video->functionPointer->SAD_MB_HP_HTFM[2];
+        video->functionPointer->SAD_MB_HalfPel[3] = video->functionPointer->SAD_MB_HP_HTFM[3];
         video->sad_extra_info = (void*)(video->nrmlz_th);
         offset = video->nrmlz_th + 16;
         offset2 = video->nrmlz_th + 32;
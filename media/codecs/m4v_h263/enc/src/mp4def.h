@@ -84,6 +84,9 @@ typedef UChar PIXEL;
 //typedef Int MOT;   /* : "int" type runs faster on RISC machine */
 
 #define HTFM            /*  3/2/01, Hypothesis Test Fast Matching for early drop-out*/
+#if defined(__aarch64__) || defined(__ARM_NEON__) || defined(__SSE2__)
+#define SAD_SIMD        /* NEON/SSE2 macroblock SAD in sad_simd.cpp */
+#endif
 //#define _MOVE_INTERFACE
 
 //#define RANDOM_REFSELCODE
@@ -1086,7 +1086,34 @@ OSCL_EXPORT_REF Bool    PVInitVideoEncoder(VideoEncControls *encoderControl, Vid
     video->functionPointer->SAD_Blk_HalfPel = &SAD_Blk_HalfPel_C;
     video->functionPointer->SAD_Block = &SAD_Block_C;
 #endif
+#ifdef SAD_SIMD
+    video->functionPointer->SAD_Macroblock = &SAD_Macroblock_SIMD;
+#else
     video->functionPointer->SAD_Macroblock = &SAD_Macroblock_C;
+#endif
+#ifdef HTFM
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[0] = NULL;
+    video->functionPointer->SAD_MB_HP_HTFM[0] = NULL;
+#ifdef SAD_SIMD
+    video->functionPointer->SAD_MB_HTFM_Collect = &SAD_MB_HTFM_Collect_SIMD;
+    video->functionPointer->SAD_MB_HTFM = &SAD_MB_HTFM_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[1] = &SAD_MB_HP_HTFM_Collectxh_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[2] = &SAD_MB_HP_HTFM_Collectyh_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[3] = &SAD_MB_HP_HTFM_Collectxhyh_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM[1] = &SAD_MB_HP_HTFMxh_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM[2] = &SAD_MB_HP_HTFMyh_SIMD;
+    video->functionPointer->SAD_MB_HP_HTFM[3] = &SAD_MB_HP_HTFMxhyh_SIMD;
+#else
+    video->functionPointer->SAD_MB_HTFM_Collect = &SAD_MB_HTFM_Collect;
+    video->functionPointer->SAD_MB_HTFM = &SAD_MB_HTFM;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[1] = &SAD_MB_HP_HTFM_Collectxh;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[2] = &SAD_MB_HP_HTFM_Collectyh;
+    video->functionPointer->SAD_MB_HP_HTFM_Collect[3] = &SAD_MB_HP_HTFM_Collectxhyh;
+    video->functionPointer->SAD_MB_HP_HTFM[1] = &SAD_MB_HP_HTFMxh;
+    video->functionPointer->SAD_MB_HP_HTFM[2] = &SAD_MB_HP_HTFMyh;
+    video->functionPointer->SAD_MB_HP_HTFM[3] = &SAD_MB_HP_HTFMxhyh;
+#endif
+#endif /* HTFM */
     video->functionPointer->ChooseMode = &ChooseMode_C;
     video->functionPointer->GetHalfPelMBRegion = &GetHalfPelMBRegion_C;
 //  video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING; /* 4/21/01 */
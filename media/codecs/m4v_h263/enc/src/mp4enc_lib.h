@@ -165,6 +165,21 @@ extern "C"
     Int SAD_MB_HP_HTFMxh(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
     Int SAD_MB_HTFM_Collect(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
     Int SAD_MB_HTFM(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+#endif
+
+#ifdef SAD_SIMD
+    /* defined in sad_simd.cpp, bit-exact with the C versions */
+    Int SAD_Macroblock_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+#ifdef HTFM
+    Int SAD_MB_HP_HTFM_Collectxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_x, void *extra_info);
+    Int SAD_MB_HP_HTFM_Collectyh_SIMD(UChar *ref, UChar *blk, Int dmin_x, void *extra_info);
+    Int SAD_MB_HP_HTFM_Collectxh_SIMD(UChar *ref, UChar *blk, Int dmin_x, void *extra_info);
+    Int SAD_MB_HP_HTFMxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HP_HTFMyh_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HP_HTFMxh_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HTFM_Collect_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HTFM_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+#endif
 #endif
     /* on-the-fly padding */
     Int SAD_Blk_PADDING(UChar *ref, UChar *cur, Int dmin, Int lx, void *extra_info);
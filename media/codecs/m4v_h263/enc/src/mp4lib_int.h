@@ -244,7 +244,13 @@ typedef struct tagFuncPtr
     void (*ChooseMode)(UChar *Mode, UChar *cur, Int lx, Int min_SAD);
     void (*GetHalfPelMBRegion)(UChar *cand, UChar *hmem, Int lx);
     void (*blockIdct)(Int *block);
-
+#ifdef HTFM
+    /* copied to SAD_Macroblock and SAD_MB_HalfPel by InitHTFM() for each frame */
+    Int(*SAD_MB_HTFM_Collect)(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int(*SAD_MB_HTFM)(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int(*SAD_MB_HP_HTFM_Collect[4])(UChar*, UChar*, Int, void *);
+    Int(*SAD_MB_HP_HTFM[4])(UChar*, UChar*, Int, void *);
+#endif
 
 } FuncPtr;
 
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mp4def.h"
+#include "mp4lib_int.h"
+#include "mp4enc_lib.h"
+
+#ifdef SAD_SIMD
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* consist of
+Int SAD_Macroblock_SIMD(UChar *ref,UChar *blk,Int dmin_lx,void *extra_info)
+Int SAD_MB_HTFM_Collect_SIMD(UChar *ref,UChar *blk,Int dmin_lx,void *extra_info)
+Int SAD_MB_HTFM_SIMD(UChar *ref,UChar *blk,Int dmin_lx,void *extra_info)
+Int SAD_MB_HP_HTFM_Collect{xh,yh,xhyh}_SIMD(UChar *ref,UChar *blk,Int dmin_rx,void *extra_info)
+Int SAD_MB_HP_HTFM{xh,yh,xhyh}_SIMD(UChar *ref,UChar *blk,Int dmin_rx,void *extra_info)
+
+These return exactly what the C versions in sad.cpp and sad_halfpel.cpp
+return, including the partial SAD at early termination, so the bitstream does
+not depend on which set is used.
+
+Like the C versions, a stage of 4 lines is read from ref to ref + 13 (the
+half-pel variants) on each line; the vector loads read up to ref + 16. The
+reference planes are followed by the chroma planes in the same allocation, so
+this stays inside the frame buffer.
+*/
+
+/* interpolation, same as the index ((yh&1)<<1)+(xh&1) of SAD_MB_HalfPel[] */
+#define HP_FULL 0
+#define HP_XH   1
+#define HP_YH   2
+#define HP_XHYH 3
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+
+/* pixels 0, 4, 8 and 12 of 4 lines lx4 apart, in the HTFM order of currYMB */
+static inline uint8x16_t load_stage(const UChar *p, Int lx4)
+{
+    uint16x4_t r0 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p)));
+    uint16x4_t r1 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p + lx4)));
+    uint16x4_t r2 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p + 2 * lx4)));
+    uint16x4_t r3 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p + 3 * lx4)));
+
+    return vcombine_u8(vmovn_u16(vcombine_u16(r0, r1)), vmovn_u16(vcombine_u16(r2, r3)));
+}
+
+static inline Int sum_abs_diff(uint8x16_t a, uint8x16_t b)
+{
+    uint16x8_t sum = vpaddlq_u8(vabdq_u8(a, b));
+#if defined(__aarch64__)
+    return vaddvq_u16(sum);
+#else
+    uint64x2_t sum2 = vpaddlq_u32(vpaddlq_u16(sum));
+    return (Int)(vgetq_lane_u64(sum2, 0) + vgetq_lane_u64(sum2, 1));
+#endif
+}
+
+static inline Int stage_sad(UChar *p1, Int rx, Int lx4, UChar *blk, Int hp)
+{
+    uint8x16_t ref;
+
+    switch (hp)
+    {
+        case HP_XH:
+            ref = vrhaddq_u8(load_stage(p1, lx4), load_stage(p1 + 1, lx4));
+            break;
+        case HP_YH:
+            ref = vrhaddq_u8(load_stage(p1, lx4), load_stage(p1 + rx, lx4));
+            break;
+        case HP_XHYH:
+        {
+            uint8x16_t a = load_stage(p1, lx4);
+            uint8x16_t b = load_stage(p1 + 1, lx4);
+            uint8x16_t c = load_stage(p1 + rx, lx4);
+            uint8x16_t d = load_stage(p1 + rx + 1, lx4);
+            uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+                                      vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+            uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+                                      vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+            ref = vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+            break;
+        }
+        default:
+            ref = load_stage(p1, lx4);
+            break;
+    }
+
+    return sum_abs_diff(ref, vld1q_u8(blk));
+}
+
+static inline Int line_sad(UChar *ref, UChar *blk)
+{
+    return sum_abs_diff(vld1q_u8(ref), vld1q_u8(blk));
+}
+
+#elif defined(__SSE2__)
+
+/* pixels 0, 4, 8 and 12 of 4 lines lx4 apart, in the HTFM order of currYMB */
+static inline __m128i load_stage(const UChar *p, Int lx4)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i r0 = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), mask);
+    __m128i r1 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + lx4)), mask);
+    __m128i r2 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 2 * lx4)), mask);
+    __m128i r3 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 3 * lx4)), mask);
+
+    return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+}
+
+static inline Int sum_abs_diff(__m128i a, __m128i b)
+{
+    __m128i sum = _mm_sad_epu8(a, b);
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+}
+
+static inline Int stage_sad(UChar *p1, Int rx, Int lx4, UChar *blk, Int hp)
+{
+    __m128i ref;
+
+    switch (hp)
+    {
+        case HP_XH:
+            ref = _mm_avg_epu8(load_stage(p1, lx4), load_stage(p1 + 1, lx4));
+            break;
+        case HP_YH:
+            ref = _mm_avg_epu8(load_stage(p1, lx4), load_stage(p1 + rx, lx4));
+            break;
+        case HP_XHYH:
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i two = _mm_set1_epi16(2);
+            __m128i a = load_stage(p1, lx4);
+            __m128i b = load_stage(p1 + 1, lx4);
+            __m128i c = load_stage(p1 + rx, lx4);
+            __m128i d = load_stage(p1 + rx + 1, lx4);
+            __m128i lo = _mm_add_epi16(
+                    _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                    _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+            __m128i hi = _mm_add_epi16(
+                    _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                    _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+            ref = _mm_packus_epi16(lo, hi);
+            break;
+        }
+        default:
+            ref = load_stage(p1, lx4);
+            break;
+    }
+
+    return sum_abs_diff(ref, _mm_loadu_si128((const __m128i*)blk));
+}
+
+static inline Int line_sad(UChar *ref, UChar *blk)
+{
+    return sum_abs_diff(_mm_loadu_si128((const __m128i*)ref),
+                        _mm_loadu_si128((const __m128i*)blk));
+}
+
+#endif
+
+/* SAD_MB_HTFM_Collect and SAD_MB_HP_HTFM_Collect* */
+static inline Int htfm_collect(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info, Int hp)
+{
+    Int i;
+    Int sad = 0;
+    Int rx = dmin_rx & 0xFFFF;
+    Int refwx4 = rx << 2;
+    Int saddata[16];
+    Int difmad;
+    HTFM_Stat *htfm_stat = (HTFM_Stat*) extra_info;
+    Int *offsetRef = htfm_stat->offsetRef;
+
+    for (i = 0; i < 16; i++) /* 16 stages */
+    {
+        sad += stage_sad(ref + offsetRef[i], rx, refwx4, blk, hp);
+        blk += 16;
+
+        saddata[i] = sad;
+
+        if (i > 0 && sad > (Int)((ULong)dmin_rx >> 16))
+        {
+            break;
+        }
+    }
+
+    difmad = saddata[0] - ((saddata[1] + 1) >> 1);
+    htfm_stat->abs_dif_mad_avg += ((difmad > 0) ? difmad : -difmad);
+    htfm_stat->countbreak++;
+
+    return sad;
+}
+
+/* SAD_MB_HTFM and SAD_MB_HP_HTFM* */
+static inline Int htfm(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info, Int hp)
+{
+    Int i;
+    Int sad = 0;
+    Int rx = dmin_rx & 0xFFFF;
+    Int refwx4 = rx << 2;
+    Int sadstar = 0, madstar;
+    Int *nrmlz_th = (Int*) extra_info;
+    Int *offsetRef = nrmlz_th + 32;
+
+    madstar = (ULong)dmin_rx >> 20;
+
+    for (i = 0; i < 16; i++) /* 16 stages */
+    {
+        sad += stage_sad(ref + offsetRef[i], rx, refwx4, blk, hp);
+        blk += 16;
+
+        sadstar += madstar;
+        if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+        {
+            return 65536;
+        }
+    }
+
+    return sad;
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    Int SAD_Macroblock_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        Int dmin = (ULong)dmin_lx >> 16;
+        Int lx = dmin_lx & 0xFFFF;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += line_sad(ref, blk);
+            if (sad > dmin)
+            {
+                break;
+            }
+            ref += lx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+#ifdef HTFM
+    Int SAD_MB_HTFM_Collect_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        return htfm_collect(ref, blk, dmin_lx, extra_info, HP_FULL);
+    }
+
+    Int SAD_MB_HTFM_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        return htfm(ref, blk, dmin_lx, extra_info, HP_FULL);
+    }
+
+    Int SAD_MB_HP_HTFM_Collectxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm_collect(ref, blk, dmin_rx, extra_info, HP_XHYH);
+    }
+
+    Int SAD_MB_HP_HTFM_Collectyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm_collect(ref, blk, dmin_rx, extra_info, HP_YH);
+    }
+
+    Int SAD_MB_HP_HTFM_Collectxh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm_collect(ref, blk, dmin_rx, extra_info, HP_XH);
+    }
+
+    Int SAD_MB_HP_HTFMxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm(ref, blk, dmin_rx, extra_info, HP_XHYH);
+    }
+
+    Int SAD_MB_HP_HTFMyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm(ref, blk, dmin_rx, extra_info, HP_YH);
+    }
+
+    Int SAD_MB_HP_HTFMxh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        return htfm(ref, blk, dmin_rx, extra_info, HP_XH);
+    }
+#endif /* HTFM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAD_SIMD */
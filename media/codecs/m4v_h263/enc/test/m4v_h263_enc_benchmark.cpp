@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encodes the same frames with the C and the SIMD motion estimation SAD
+// functions, reports the frame rate of each and checks that the bitstreams
+// are identical.
+//
+// Usage: m4v_h263_enc_benchmark [<mode> [<input yuv> <width> <height>]]
+// mode is h263 or mpeg4 (default h263). Without an input file, 150 CIF frames
+// of moving synthetic content are encoded.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "mp4def.h"
+#include "mp4lib_int.h"
+#include "mp4enc_lib.h"
+
+enum {
+    kDefaultWidth     = 352,
+    kDefaultHeight    = 288,
+    kDefaultFrames    = 150,
+    kFrameRate        = 30,
+    kBitrate          = 384, // in kbps.
+    kOutputBufferSize = 250 * 1024,
+};
+
+static std::vector<uint8_t> makeSyntheticFrames(int32_t width, int32_t height, int32_t count) {
+    const int32_t frameSize = width * height * 3 / 2;
+    std::vector<uint8_t> frames(frameSize * count);
+    uint32_t seed = 1;
+    for (int32_t n = 0; n < count; ++n) {
+        uint8_t *y = frames.data() + n * frameSize;
+        for (int32_t j = 0; j < height; ++j) {
+            for (int32_t i = 0; i < width; ++i) {
+                // a pattern panning right and down, plus some noise
+                int32_t x = i + n * 3, v = j + n;
+                seed = seed * 1103515245 + 12345;
+                y[j * width + i] = (uint8_t)(((x * 7) ^ (v * 5)) + (x >> 2) + ((seed >> 16) & 7));
+            }
+        }
+        memset(y + width * height, 128, width * height / 2);
+    }
+    return frames;
+}
+
+static void useCSad(tagvideoEncControls *handle) {
+    FuncPtr *func = ((VideoEncData *)handle->videoEncoderData)->functionPointer;
+    func->SAD_Macroblock = &SAD_Macroblock_C;
+#ifdef HTFM
+    func->SAD_MB_HTFM_Collect = &SAD_MB_HTFM_Collect;
+    func->SAD_MB_HTFM = &SAD_MB_HTFM;
+    func->SAD_MB_HP_HTFM_Collect[1] = &SAD_MB_HP_HTFM_Collectxh;
+    func->SAD_MB_HP_HTFM_Collect[2] = &SAD_MB_HP_HTFM_Collectyh;
+    func->SAD_MB_HP_HTFM_Collect[3] = &SAD_MB_HP_HTFM_Collectxhyh;
+    func->SAD_MB_HP_HTFM[1] = &SAD_MB_HP_HTFMxh;
+    func->SAD_MB_HP_HTFM[2] = &SAD_MB_HP_HTFMyh;
+    func->SAD_MB_HP_HTFM[3] = &SAD_MB_HP_HTFMxhyh;
+#endif
+}
+
+// Returns the encoded stream, or an empty one on failure.
+static std::vector<uint8_t> encode(const std::vector<uint8_t> &frames, int32_t width,
+                                   int32_t height, bool isH263mode, bool useC, double *fps) {
+    std::vector<uint8_t> stream;
+    tagvideoEncOptions encParams;
+    memset(&encParams, 0, sizeof(tagvideoEncOptions));
+    if (!PVGetDefaultEncOption(&encParams, 0)) {
+        fprintf(stderr, "Failed to get default encoding parameters\n");
+        return stream;
+    }
+    encParams.encMode = isH263mode ? H263_MODE : COMBINE_MODE_WITH_ERR_RES;
+    encParams.encWidth[0] = width;
+    encParams.encHeight[0] = height;
+    encParams.encFrameRate[0] = kFrameRate;
+    encParams.rcType = VBR_1;
+    encParams.vbvDelay = 5.0f;
+    encParams.profile_level = CORE_PROFILE_LEVEL2;
+    encParams.packetSize = 32;
+    encParams.rvlcEnable = PV_OFF;
+    encParams.numLayers = 1;
+    encParams.timeIncRes = 1000;
+    encParams.tickPerSrc = encParams.timeIncRes / kFrameRate;
+    encParams.bitRate[0] = kBitrate * 1024;
+    encParams.iQuant[0] = 15;
+    encParams.pQuant[0] = 12;
+    encParams.quantType[0] = 0;
+    encParams.noFrameSkipped = PV_ON;
+    encParams.intraPeriod = kFrameRate;
+    encParams.numIntraMB = 0;
+    encParams.sceneDetect = PV_ON;
+    encParams.searchRange = 16;
+    encParams.mv8x8Enable = PV_OFF;
+    encParams.gobHeaderInterval = 0;
+    encParams.useACPred = PV_ON;
+    encParams.intraDCVlcTh = 0;
+
+    tagvideoEncControls handle;
+    memset(&handle, 0, sizeof(tagvideoEncControls));
+    if (!PVInitVideoEncoder(&handle, &encParams)) {
+        fprintf(stderr, "Failed to initialize the encoder\n");
+        return stream;
+    }
+    if (useC) {
+        useCSad(&handle);
+    }
+
+    std::vector<uint8_t> outputBuf(kOutputBufferSize);
+    int32_t dataLength = kOutputBufferSize;
+    if (!PVGetVolHeader(&handle, outputBuf.data(), &dataLength, 0)) {
+        fprintf(stderr, "Failed to get VOL header\n");
+        PVCleanUpVideoEncoder(&handle);
+        return stream;
+    }
+    stream.insert(stream.end(), outputBuf.begin(), outputBuf.begin() + dataLength);
+
+    const int32_t frameSize = width * height * 3 / 2;
+    const int32_t count = frames.size() / frameSize;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t n = 0; n < count; ++n) {
+        VideoEncFrameIO vin, vout;
+        memset(&vin, 0, sizeof(vin));
+        memset(&vout, 0, sizeof(vout));
+        vin.height = height;
+        vin.pitch = width;
+        vin.timestamp = (n * 1000) / kFrameRate;
+        vin.yChan = const_cast<uint8_t *>(frames.data()) + n * frameSize;
+        vin.uChan = vin.yChan + vin.height * vin.pitch;
+        vin.vChan = vin.uChan + ((vin.height * vin.pitch) >> 2);
+        uint32_t modTimeMs = 0;
+        int32_t nLayer = 0;
+        dataLength = kOutputBufferSize;
+        if (!PVEncodeVideoFrame(&handle, &vin, &vout, &modTimeMs, outputBuf.data(),
+                                &dataLength, &nLayer)) {
+            fprintf(stderr, "Failed to encode frame %d\n", n);
+            stream.clear();
+            break;
+        }
+        stream.insert(stream.end(), outputBuf.begin(), outputBuf.begin() + dataLength);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    *fps = seconds > 0 ? count / seconds : 0;
+
+    PVCleanUpVideoEncoder(&handle);
+    return stream;
+}
+
+int main(int argc, char *argv[]) {
+    bool isH263mode = true;
+    if (argc > 1) {
+        if (strcmp(argv[1], "mpeg4") == 0) {
+            isH263mode = false;
+        } else if (strcmp(argv[1], "h263") != 0) {
+            fprintf(stderr, "Usage %s [<mode> [<input yuv> <width> <height>]]\n", argv[0]);
+            fprintf(stderr, "mode : h263 or mpeg4\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    int32_t width = kDefaultWidth;
+    int32_t height = kDefaultHeight;
+    std::vector<uint8_t> frames;
+    if (argc > 4) {
+        width = atoi(argv[3]);
+        height = atoi(argv[4]);
+        if (width <= 0 || height <= 0 || width % 16 != 0 || height % 16 != 0) {
+            fprintf(stderr, "Video frame size %dx%d must be a multiple of 16\n", width, height);
+            return EXIT_FAILURE;
+        }
+        FILE *fpInput = fopen(argv[2], "rb");
+        if (fpInput == NULL) {
+            fprintf(stderr, "Could not open %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        const size_t frameSize = width * height * 3 / 2;
+        std::vector<uint8_t> frame(frameSize);
+        while (fread(frame.data(), 1, frameSize, fpInput) == frameSize) {
+            frames.insert(frames.end(), frame.begin(), frame.end());
+        }
+        fclose(fpInput);
+    } else {
+        frames = makeSyntheticFrames(width, height, kDefaultFrames);
+    }
+
+    double fpsC = 0, fpsSimd = 0;
+    std::vector<uint8_t> streamC = encode(frames, width, height, isH263mode, true, &fpsC);
+    std::vector<uint8_t> streamSimd =
+            encode(frames, width, height, isH263mode, false, &fpsSimd);
+    if (streamC.empty() || streamSimd.empty()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%dx%d %s, %zu frames\n", width, height, isH263mode ? "h263" : "mpeg4",
+           frames.size() / (width * height * 3 / 2));
+    printf("C:       %8.1f fps, %zu bytes\n", fpsC, streamC.size());
+#ifdef SAD_SIMD
+    printf("SIMD:    %8.1f fps, %zu bytes\n", fpsSimd, streamSimd.size());
+#else
+    printf("no SIMD SAD in this build\n");
+#endif
+    if (streamC != streamSimd) {
+        fprintf(stderr, "bitstreams differ\n");
+        return EXIT_FAILURE;
+    }
+    printf("bitstreams match\n");
+    return EXIT_SUCCESS;
+}
@@ -70,6 +70,7 @@ Returns
 
 #include "pv_mp3dec_fxd_op.h"
 #include "pvmp3_mdct_18.h"
+#include "pvmp3_simd.h"
 
 
 /*----------------------------------------------------------------------------
@@ -148,7 +149,28 @@ void pvmp3_mdct_18(int32 vec[], int32 *history, const int32 *window)
     int32 *pt_vec_o = &vec[17];
 
 
+#ifdef PVMP3_SIMD
+    /* lines 0..7 against 17..10 four at a time, line 8 against 9 below */
+    for (i = 2; i != 0; i--)
+    {
+        pv_int32x4 a = pv_load4(pt_vec);
+        pv_int32x4 b = pv_load4_reversed(pt_vec_o - 3);
+        pv_int32x4 t  = PV_MUL4_Q(pv_shl4_1(a), pv_load4(pt_cos), 32);
+        pv_int32x4 t1 = PV_MUL4_Q(b, pv_load4_reversed(pt_cos_x - 3), 27);
+        pv_store4(pt_vec, pv_add4(t, t1));
+        pv_store4_reversed(pt_vec_o - 3,
+                           PV_MUL4_Q(pv_sub4(t, t1), pv_load4(pt_cos_split), 28));
+        pt_vec       += 4;
+        pt_vec_o     -= 4;
+        pt_cos       += 4;
+        pt_cos_x     -= 4;
+        pt_cos_split += 4;
+    }
+
+    for (i = 1; i != 0; i--)
+#else
     for (i = 9; i != 0; i--)
+#endif
     {
         tmp  = *(pt_vec);
         tmp1 = *(pt_vec_o);
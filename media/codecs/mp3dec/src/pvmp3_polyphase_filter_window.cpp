@@ -75,6 +75,7 @@ Input
 #include "pv_mp3dec_fxd_op.h"
 #include "pvmp3_dec_defs.h"
 #include "pvmp3_tables.h"
+#include "pvmp3_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -94,6 +95,67 @@ Input
 ; Function Prototype declaration
 ----------------------------------------------------------------------------*/
 
+#ifdef PVMP3_SIMD
+/*
+ *  Subbands j0 .. j0+3 of the windowing loop below, one per lane. The four
+ *  window rows of those subbands are transposed so that lane n of win[k] is
+ *  coefficient k of subband j0+n.
+ */
+static void polyphase_filter_window_4(const int32 *synth_buffer,
+                                      const int32 *winPtr,
+                                      int16 *outPcm,
+                                      int32 numChannels,
+                                      int32 j0)
+{
+    const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j0];
+    const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j0 - 3];
+    const int32 *row  = &winPtr[(j0 - 1) << 4];
+    pv_int32x4 win[16];
+
+    for (int32 k = 0; k < 16; k += 4)
+    {
+        win[k    ] = pv_load4(&row[k     ]);
+        win[k + 1] = pv_load4(&row[k + 16]);
+        win[k + 2] = pv_load4(&row[k + 32]);
+        win[k + 3] = pv_load4(&row[k + 48]);
+        pv_transpose4(&win[k], &win[k + 1], &win[k + 2], &win[k + 3]);
+    }
+
+    pv_int32x4 sum1 = pv_dup4(0x00000020);
+    pv_int32x4 sum2 = pv_dup4(0x00000020);
+
+    for (int32 k = 0; k < 4; k++)
+    {
+        pv_int32x4 temp1 = pv_load4(&pt_1[SUBBANDS_NUMBER * (2 * k)]);
+        pv_int32x4 temp3 = pv_load4_reversed(&pt_2[SUBBANDS_NUMBER * (15 - 2 * k)]);
+        pv_int32x4 temp2 = pv_load4_reversed(&pt_2[SUBBANDS_NUMBER * (2 * k + 1)]);
+        pv_int32x4 temp4 = pv_load4(&pt_1[SUBBANDS_NUMBER * (14 - 2 * k)]);
+        const pv_int32x4 *w = &win[k << 2];
+
+        sum1 = pv_add4(sum1, PV_MUL4_Q(temp1, w[0], 32));
+        sum2 = pv_add4(sum2, PV_MUL4_Q(temp3, w[0], 32));
+        sum2 = pv_add4(sum2, PV_MUL4_Q(temp1, w[1], 32));
+        sum1 = pv_sub4(sum1, PV_MUL4_Q(temp3, w[1], 32));
+        sum1 = pv_add4(sum1, PV_MUL4_Q(temp2, w[2], 32));
+        sum2 = pv_sub4(sum2, PV_MUL4_Q(temp4, w[2], 32));
+        sum2 = pv_add4(sum2, PV_MUL4_Q(temp2, w[3], 32));
+        sum1 = pv_add4(sum1, PV_MUL4_Q(temp4, w[3], 32));
+    }
+
+    int16 pcm1[4];
+    int16 pcm2[4];
+    pv_store4_pcm(pcm1, sum1);
+    pv_store4_pcm(pcm2, sum2);
+
+    for (int32 n = 0; n < 4; n++)
+    {
+        int32 k = (j0 + n) << (numChannels - 1);
+        outPcm[k] = pcm1[n];
+        outPcm[(numChannels<<5) - k] = pcm2[n];
+    }
+}
+#endif
+
 /*----------------------------------------------------------------------------
 ; LOCAL STORE/BUFFER/POINTER DEFINITIONS
 ; Variable declaration - defined here and used outside this module1
@@ -122,6 +184,17 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
     int32 i;
 
 
+#ifdef PVMP3_SIMD
+    /*
+     *  15 subbands in blocks of 4, the last block overlaps the previous one
+     *  by a subband, which is simply computed twice.
+     */
+    polyphase_filter_window_4(synth_buffer, winPtr, outPcm, numChannels, 1);
+    polyphase_filter_window_4(synth_buffer, winPtr, outPcm, numChannels, 5);
+    polyphase_filter_window_4(synth_buffer, winPtr, outPcm, numChannels, 9);
+    polyphase_filter_window_4(synth_buffer, winPtr, outPcm, numChannels, 12);
+    winPtr += ((SUBBANDS_NUMBER / 2) - 1) << 4;
+#else
     for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
     {
         sum1 = 0x00000020;
@@ -199,6 +272,7 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
         outPcm[k] = saturate16(sum1 >> 6);
         outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
     }
+#endif
 
 
 
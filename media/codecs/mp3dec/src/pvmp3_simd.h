@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Four lane fixed point helpers for the NEON and SSE4.1 paths of the
+ * synthesis filterbank. Every multiply truncates its 64 bit product exactly
+ * like the fxp_mul32_Qn() C equivalents, so the vector kernels are bit exact
+ * with the scalar code. PVMP3_SIMD is left undefined when neither is
+ * available (SSE2 has no signed 32x32->64 multiply).
+ */
+
+#ifndef PVMP3_SIMD_H
+#define PVMP3_SIMD_H
+
+#include "pvmp3_audio_type_defs.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+#define PVMP3_SIMD
+
+typedef int32x4_t pv_int32x4;
+
+static inline pv_int32x4 pv_load4(const int32 *p)
+{
+    return vld1q_s32(p);
+}
+
+/* { a[3], a[2], a[1], a[0] } */
+static inline pv_int32x4 pv_reverse4(pv_int32x4 a)
+{
+    int32x4_t v = vrev64q_s32(a);
+    return vextq_s32(v, v, 2);
+}
+
+static inline void pv_store4(int32 *p, pv_int32x4 v)
+{
+    vst1q_s32(p, v);
+}
+
+static inline pv_int32x4 pv_dup4(int32 a)
+{
+    return vdupq_n_s32(a);
+}
+
+static inline pv_int32x4 pv_add4(pv_int32x4 a, pv_int32x4 b)
+{
+    return vaddq_s32(a, b);
+}
+
+static inline pv_int32x4 pv_sub4(pv_int32x4 a, pv_int32x4 b)
+{
+    return vsubq_s32(a, b);
+}
+
+static inline pv_int32x4 pv_shl4_1(pv_int32x4 a)
+{
+    return vshlq_n_s32(a, 1);
+}
+
+/* (int32)(((int64)a * b) >> Q), per lane, 1 <= Q <= 32 */
+#define PV_MUL4_Q(a, b, Q)                                                     \
+    vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), Q),  \
+                 vshrn_n_s64(vmull_s32(vget_high_s32(a), vget_high_s32(b)), Q))
+
+/* saturate16(a >> 6) of the four lanes into out[0..3] */
+static inline void pv_store4_pcm(int16 *out, pv_int32x4 a)
+{
+    vst1_s16(out, vqmovn_s32(vshrq_n_s32(a, 6)));
+}
+
+/* rows r0..r3 become columns */
+static inline void pv_transpose4(pv_int32x4 *r0, pv_int32x4 *r1, pv_int32x4 *r2, pv_int32x4 *r3)
+{
+    int32x4x2_t t01 = vtrnq_s32(*r0, *r1);
+    int32x4x2_t t23 = vtrnq_s32(*r2, *r3);
+    *r0 = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+    *r1 = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+    *r2 = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+    *r3 = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+#elif defined(__SSE4_1__)
+
+#include <smmintrin.h>
+
+#define PVMP3_SIMD
+
+typedef __m128i pv_int32x4;
+
+static inline pv_int32x4 pv_load4(const int32 *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+/* { a[3], a[2], a[1], a[0] } */
+static inline pv_int32x4 pv_reverse4(pv_int32x4 a)
+{
+    return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static inline void pv_store4(int32 *p, pv_int32x4 v)
+{
+    _mm_storeu_si128((__m128i *)p, v);
+}
+
+static inline pv_int32x4 pv_dup4(int32 a)
+{
+    return _mm_set1_epi32(a);
+}
+
+static inline pv_int32x4 pv_add4(pv_int32x4 a, pv_int32x4 b)
+{
+    return _mm_add_epi32(a, b);
+}
+
+static inline pv_int32x4 pv_sub4(pv_int32x4 a, pv_int32x4 b)
+{
+    return _mm_sub_epi32(a, b);
+}
+
+static inline pv_int32x4 pv_shl4_1(pv_int32x4 a)
+{
+    return _mm_slli_epi32(a, 1);
+}
+
+/*
+ * (int32)(((int64)a * b) >> Q), per lane, 1 <= Q <= 32. Only the low 32 bits
+ * of each shifted product are kept, so a logical 64 bit shift is enough.
+ */
+#define PV_MUL4_Q(a, b, Q)                                                     \
+    _mm_blend_epi16(                                                           \
+            _mm_srli_epi64(_mm_mul_epi32((a), (b)), Q),                        \
+            _mm_slli_epi64(_mm_srli_epi64(_mm_mul_epi32(_mm_srli_epi64((a), 32), \
+                                                        _mm_srli_epi64((b), 32)), Q), 32), \
+            0xCC)
+
+/* saturate16(a >> 6) of the four lanes into out[0..3] */
+static inline void pv_store4_pcm(int16 *out, pv_int32x4 a)
+{
+    __m128i v = _mm_srai_epi32(a, 6);
+    _mm_storel_epi64((__m128i *)out, _mm_packs_epi32(v, v));
+}
+
+/* rows r0..r3 become columns */
+static inline void pv_transpose4(pv_int32x4 *r0, pv_int32x4 *r1, pv_int32x4 *r2, pv_int32x4 *r3)
+{
+    __m128i t0 = _mm_unpacklo_epi32(*r0, *r1);
+    __m128i t1 = _mm_unpacklo_epi32(*r2, *r3);
+    __m128i t2 = _mm_unpackhi_epi32(*r0, *r1);
+    __m128i t3 = _mm_unpackhi_epi32(*r2, *r3);
+    *r0 = _mm_unpacklo_epi64(t0, t1);
+    *r1 = _mm_unpackhi_epi64(t0, t1);
+    *r2 = _mm_unpacklo_epi64(t2, t3);
+    *r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+#endif
+
+#ifdef PVMP3_SIMD
+
+/* { p[3], p[2], p[1], p[0] } */
+static inline pv_int32x4 pv_load4_reversed(const int32 *p)
+{
+    return pv_reverse4(pv_load4(p));
+}
+
+static inline void pv_store4_reversed(int32 *p, pv_int32x4 a)
+{
+    pv_store4(p, pv_reverse4(a));
+}
+
+#endif
+
+#endif  /* PVMP3_SIMD_H */
@@ -584,6 +584,16 @@ int64_t BlockIterator::blockTimeUs() const {
 }
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
+    // Until the background index gets there, load the clusters up to the one
+    // starting past the seek time, so that the cluster containing it is found.
+    for (;;) {
+        const mkvparser::Cluster *last = mExtractor->mSegment->GetLast();
+        if ((last != NULL && !last->EOS() && last->GetTime() >= seekTimeUs * 1000ll)
+                || !mExtractor->loadNextCluster_l()) {
+            break;
+        }
+    }
+
     mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
@@ -1330,7 +1340,9 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
       mSegment(NULL),
       mExtractedThumbnails(false),
       mIsWebm(false),
-      mSeekPreRollNs(0) {
+      mSeekPreRollNs(0),
+      mClusterIndexDone(true),
+      mStopClusterIndex(false) {
     off64_t size;
     mIsLiveStreaming =
         (mDataSource->flags()
@@ -1400,8 +1412,17 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
                 ret = mSegment->LoadCluster(pos, len);
                 ALOGV("has Cue data, Cluster num=%ld", mSegment->GetCount());
             } else  {
-                long status_Load = mSegment->Load();
-                ALOGW("no Cue data,Segment Load status:%ld",status_Load);
+                // Only load the first cluster here, the others are indexed
+                // in the background once the tracks are known.
+                long len;
+                ret = mSegment->LoadCluster(pos, len);
+                ALOGW("no Cue data, indexing clusters in the background");
+                if (ret >= 1) {
+                    // no more clusters
+                    ret = 0;
+                } else if (ret == 0) {
+                    mClusterIndexDone = false;
+                }
             }
         } else if (ret > 0) {
             ret = mkvparser::E_BUFFER_NOT_FULL;
@@ -1428,9 +1449,21 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
 #endif
 
     addTracks();
+
+    if (!mClusterIndexDone) {
+        mClusterIndexThread = std::thread(&MatroskaExtractor::indexClusters, this);
+    }
 }
 
 MatroskaExtractor::~MatroskaExtractor() {
+    if (mClusterIndexThread.joinable()) {
+        {
+            Mutex::Autolock autoLock(mLock);
+            mStopClusterIndex = true;
+        }
+        mClusterIndexThread.join();
+    }
+
     delete mSegment;
     mSegment = NULL;
 
@@ -1447,6 +1480,43 @@ MatroskaExtractor::~MatroskaExtractor() {
     }
 }
 
+void MatroskaExtractor::indexClusters() {
+    // Load a few clusters at a time to let the tracks in between.
+    static const size_t kClustersPerStep = 16;
+
+    size_t count = 0;
+    for (bool more = true; more; ) {
+        {
+            Mutex::Autolock autoLock(mLock);
+            for (size_t i = 0; more && i < kClustersPerStep; ++i) {
+                more = !mStopClusterIndex && loadNextCluster_l();
+            }
+            count = mSegment->GetCount();
+        }
+        std::this_thread::yield();
+    }
+    ALOGV("indexed %zu clusters", count);
+}
+
+bool MatroskaExtractor::loadNextCluster_l() {
+    if (mClusterIndexDone) {
+        return false;
+    }
+    long long pos;
+    long len;
+    long status = mSegment->LoadCluster(pos, len);
+    if (status != 0) {
+        // no more clusters (> 0), or failure. E_BUFFER_NOT_FULL is not
+        // expected as this is not done for live streaming.
+        if (status < 0) {
+            ALOGW("cluster index stopped at %ld clusters: %ld", mSegment->GetCount(), status);
+        }
+        mClusterIndexDone = true;
+        return false;
+    }
+    return true;
+}
+
 size_t MatroskaExtractor::countTracks() {
     return mTracks.size();
 }
@@ -20,6 +20,8 @@
 
 #include "mkvparser/mkvparser.h"
 
+#include <thread>
+
 #include <media/MediaExtractorPluginApi.h>
 #include <media/MediaExtractorPluginHelper.h>
 #include <media/NdkMediaFormat.h>
@@ -92,6 +94,16 @@ private:
     bool mIsWebm;
     int64_t mSeekPreRollNs;
 
+    // Files without Cues are seeked through the loaded clusters. They are
+    // loaded on mClusterIndexThread after open rather than all at once.
+    std::thread mClusterIndexThread;
+    bool mClusterIndexDone;
+    bool mStopClusterIndex;
+
+    void indexClusters();
+    // Returns false once all clusters are loaded or loading fails.
+    bool loadNextCluster_l();
+
     status_t synthesizeAVCC(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG2(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG4(TrackInfo *trackInfo, size_t index);
@@ -24,6 +24,7 @@
 #include "VBRISeeker.h"
 #include "XINGSeeker.h"
 
+#include <media/stagefright/DataSourceBase.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/avc_utils.h>
@@ -35,6 +36,14 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace android {
 
 // Everything must match except for
@@ -207,6 +216,222 @@ static bool Resync(
     return valid;
 }
 
+// Seeker for files without XING or VBRI header. It walks the frame headers in
+// the background, and records the offset of every kFramesPerEntry-th frame.
+// Seeks into the part that is scanned go to the exact frame. The tables of
+// the last few files are kept across extractor instances.
+class FrameScanSeeker : public MP3Seeker {
+public:
+    FrameScanSeeker(DataSourceHelper *source, off64_t first_frame_pos, uint32_t fixed_header);
+    virtual ~FrameScanSeeker();
+
+    virtual bool getDuration(int64_t *durationUs);
+    virtual bool getOffsetForTime(int64_t *timeUs, off64_t *pos);
+
+private:
+    static const uint64_t kFramesPerEntry = 32;
+    static const size_t kScanBufferSize = 64 * 1024;
+    static const size_t kMaxCachedTables = 4;
+
+    struct Table {
+        std::vector<off64_t> mOffsets;
+        uint64_t mNumFrames = 0;
+    };
+
+    DataSourceHelper *mSource;
+    off64_t mFirstFramePos;
+    uint32_t mFixedHeader;
+    int mSampleRate = 0;
+    int mSamplesPerFrame = 0;
+    std::string mCacheKey;
+
+    std::mutex mLock;
+    Table mTable;
+    bool mDone = false;
+    bool mStop = false;
+    std::thread mThread;
+
+    static std::mutex sCacheLock;
+    static std::list<std::pair<std::string, std::shared_ptr<const Table>>> sCache;
+
+    void scan();
+    int64_t frameToTimeUs(uint64_t frame) const;
+
+    DISALLOW_EVIL_CONSTRUCTORS(FrameScanSeeker);
+};
+
+std::mutex FrameScanSeeker::sCacheLock;
+std::list<std::pair<std::string, std::shared_ptr<const FrameScanSeeker::Table>>>
+        FrameScanSeeker::sCache;
+
+FrameScanSeeker::FrameScanSeeker(
+        DataSourceHelper *source, off64_t first_frame_pos, uint32_t fixed_header)
+    : mSource(source),
+      mFirstFramePos(first_frame_pos),
+      mFixedHeader(fixed_header) {
+    size_t frame_size;
+    if (!GetMPEGAudioFrameSize(
+            fixed_header, &frame_size, &mSampleRate, NULL, NULL, &mSamplesPerFrame)) {
+        mDone = true;
+        return;
+    }
+
+    char uri[1024];
+    off64_t size;
+    if (source->getUri(uri, sizeof(uri)) && uri[0] != '\0' && source->getSize(&size) == OK) {
+        mCacheKey = std::string(uri) + ":" + std::to_string(size)
+                + ":" + std::to_string(first_frame_pos);
+        std::lock_guard<std::mutex> lock(sCacheLock);
+        for (auto it = sCache.begin(); it != sCache.end(); ++it) {
+            if (it->first == mCacheKey) {
+                mTable = *it->second;
+                mDone = true;
+                sCache.splice(sCache.begin(), sCache, it);
+                return;
+            }
+        }
+    }
+
+    mThread = std::thread(&FrameScanSeeker::scan, this);
+}
+
+FrameScanSeeker::~FrameScanSeeker() {
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+        }
+        mThread.join();
+    }
+}
+
+void FrameScanSeeker::scan() {
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[kScanBufferSize]);
+    off64_t bufferPos = 0;
+    size_t bufferSize = 0;
+    off64_t pos = mFirstFramePos;
+    uint64_t numFrames = 0;
+    std::vector<off64_t> offsets;
+
+    while (buffer != NULL) {
+        if (pos < bufferPos || pos + 4 > bufferPos + (off64_t)bufferSize) {
+            ssize_t n = mSource->readAt(pos, buffer.get(), kScanBufferSize);
+            if (n < 4) {
+                break;
+            }
+            bufferPos = pos;
+            bufferSize = n;
+        }
+
+        uint32_t header = U32_AT(&buffer[pos - bufferPos]);
+        size_t frame_size;
+        if ((header & kMask) != (mFixedHeader & kMask)
+                || !GetMPEGAudioFrameSize(header, &frame_size)) {
+            // lost sync, same as MP3Source::read()
+            if (!Resync(mSource, mFixedHeader, &pos, NULL, NULL)) {
+                break;
+            }
+            continue;
+        }
+
+        if (numFrames % kFramesPerEntry == 0) {
+            offsets.push_back(pos);
+        }
+        ++numFrames;
+        pos += frame_size;
+
+        // publish every few entries
+        if (numFrames % (kFramesPerEntry * 64) == 0) {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mStop) {
+                return;
+            }
+            mTable.mOffsets.insert(mTable.mOffsets.end(),
+                    offsets.begin() + mTable.mOffsets.size(), offsets.end());
+            mTable.mNumFrames = numFrames;
+        }
+    }
+
+    std::shared_ptr<Table> table;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTable.mOffsets = std::move(offsets);
+        mTable.mNumFrames = numFrames;
+        mDone = true;
+        if (!mCacheKey.empty() && !mStop) {
+            table = std::make_shared<Table>(mTable);
+        }
+    }
+    ALOGV("scanned %llu frames", (unsigned long long)numFrames);
+
+    if (table != NULL) {
+        std::lock_guard<std::mutex> lock(sCacheLock);
+        sCache.emplace_front(mCacheKey, table);
+        if (sCache.size() > kMaxCachedTables) {
+            sCache.pop_back();
+        }
+    }
+}
+
+int64_t FrameScanSeeker::frameToTimeUs(uint64_t frame) const {
+    return frame * mSamplesPerFrame * 1000000ll / mSampleRate;
+}
+
+bool FrameScanSeeker::getDuration(int64_t *durationUs) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!mDone || mTable.mNumFrames == 0) {
+        return false;
+    }
+    *durationUs = frameToTimeUs(mTable.mNumFrames);
+    return true;
+}
+
+bool FrameScanSeeker::getOffsetForTime(int64_t *timeUs, off64_t *pos) {
+    uint64_t frame;
+    off64_t offset;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mTable.mNumFrames == 0) {
+            return false;
+        }
+        int64_t seekTimeUs = std::max(*timeUs, (int64_t)0);
+        if (seekTimeUs > INT64_MAX / mSampleRate) {
+            return false;
+        }
+        frame = seekTimeUs * mSampleRate / 1000000ll / mSamplesPerFrame;
+        if (frame >= mTable.mNumFrames) {
+            if (!mDone) {
+                // not scanned yet
+                return false;
+            }
+            frame = mTable.mNumFrames - 1;
+        }
+        offset = mTable.mOffsets[frame / kFramesPerEntry];
+    }
+
+    // walk to the exact frame from the recorded one
+    uint64_t current = frame - frame % kFramesPerEntry;
+    while (current < frame) {
+        uint8_t data[4];
+        size_t frame_size;
+        if (mSource->readAt(offset, data, sizeof(data)) < (ssize_t)sizeof(data)) {
+            break;
+        }
+        uint32_t header = U32_AT(data);
+        if ((header & kMask) != (mFixedHeader & kMask)
+                || !GetMPEGAudioFrameSize(header, &frame_size)) {
+            // the scan resynced here, stay on the previous frame
+            break;
+        }
+        offset += frame_size;
+        ++current;
+    }
+
+    *timeUs = frameToTimeUs(current);
+    *pos = offset;
+    return true;
+}
+
 class MP3Source : public MediaTrackHelper {
 public:
     MP3Source(
@@ -310,6 +535,11 @@ MP3Extractor::MP3Extractor(
         }
         mFirstFramePos = pos;
         mFixedHeader = header;
+    } else if ((mDataSource->flags() & DataSourceBase::kIsLocalFileSource)
+            && !(mDataSource->flags() & DataSourceBase::kIsCachingDataSource)) {
+        // Without a seek table, scan local files for one. Remote ones would be
+        // downloaded entirely.
+        mSeeker = new FrameScanSeeker(mDataSource, mFirstFramePos, mFixedHeader);
     }
 
     size_t frame_size;
@@ -368,7 +598,7 @@ MP3Extractor::MP3Extractor(
     // When getting the id3 tag, skip the V1 tags to prevent the source cache
     // from being iterated to the end of the file.
     DataSourceHelper helper(mDataSource);
-    ID3 id3(&helper, true);
+    ID3 id3(&helper, true, 0 /* offset */, true /* lazy */);
     if (id3.isValid()) {
         ID3::Iterator *com = new ID3::Iterator(id3, "COM");
         if (com->done()) {
@@ -609,8 +839,9 @@ media_status_t MP3Extractor::getMetaData(AMediaFormat *meta) {
     }
     AMediaFormat_setString(meta, AMEDIAFORMAT_KEY_MIME, MEDIA_MIMETYPE_AUDIO_MPEG);
 
+    // Large frames, such as the album art, are only read once asked for.
     DataSourceHelper helper(mDataSource);
-    ID3 id3(&helper);
+    ID3 id3(&helper, false /* ignoreV1 */, 0 /* offset */, true /* lazy */);
 
     if (!id3.isValid()) {
         return AMEDIA_OK;
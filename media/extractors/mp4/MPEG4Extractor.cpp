@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <android-base/properties.h>
 #include <log/log.h>
 #include <utils/Log.h>
 
@@ -333,6 +334,120 @@ status_t CachedRangedDataSource::setCachedRange(off64_t offset,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// This custom data source is shared by the tracks of a fragmented file. It
+// serves small reads from a few read-ahead windows, so that the box headers
+// and sample tables of a moof, and the samples of all tracks interleaved in
+// the following mdat, are read with a few large reads instead of one read per
+// entry or sample. That keeps the readahead of network sources effective.
+class FragmentReadCache : public DataSourceHelper {
+public:
+    explicit FragmentReadCache(DataSourceHelper *source);
+    virtual ~FragmentReadCache();
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override;
+    status_t getSize(off64_t *size) override;
+    uint32_t flags() override;
+
+private:
+    static const size_t kWindowSize = 256 * 1024;
+    static const size_t kNumWindows = 4;
+
+    struct Window {
+        off64_t mOffset;
+        size_t mSize;
+        uint8_t *mData;
+        uint64_t mLastUse;
+    };
+
+    Mutex mLock;
+
+    DataSourceHelper *mSource;
+    Window mWindows[kNumWindows];
+    uint64_t mNumReads;
+    uint64_t mNumSourceReads;
+
+    FragmentReadCache(const FragmentReadCache &);
+    FragmentReadCache &operator=(const FragmentReadCache &);
+};
+
+FragmentReadCache::FragmentReadCache(DataSourceHelper *source)
+    : DataSourceHelper(source),
+      mSource(source),
+      mNumReads(0),
+      mNumSourceReads(0) {
+    for (Window &window : mWindows) {
+        window = { 0, 0, NULL, 0 };
+    }
+}
+
+FragmentReadCache::~FragmentReadCache() {
+    for (Window &window : mWindows) {
+        free(window.mData);
+    }
+    ALOGI("fragment read cache: %llu reads served with %llu source reads",
+            (unsigned long long)mNumReads, (unsigned long long)mNumSourceReads);
+}
+
+ssize_t FragmentReadCache::readAt(off64_t offset, void *data, size_t size) {
+    Mutex::Autolock autoLock(mLock);
+
+    ++mNumReads;
+    ++mNumSourceReads;
+    // larger reads gain nothing from the windows
+    if (size > kWindowSize / 4 || offset < 0) {
+        return mSource->readAt(offset, data, size);
+    }
+
+    Window *oldest = &mWindows[0];
+    for (Window &window : mWindows) {
+        if (window.mData != NULL && isInRange(window.mOffset, window.mSize, offset, size)) {
+            window.mLastUse = mNumReads;
+            memcpy(data, &window.mData[offset - window.mOffset], size);
+            --mNumSourceReads;
+            return size;
+        }
+        if (window.mLastUse < oldest->mLastUse) {
+            oldest = &window;
+        }
+    }
+
+    if (oldest->mData == NULL) {
+        oldest->mData = (uint8_t *)malloc(kWindowSize);
+        if (oldest->mData == NULL) {
+            return mSource->readAt(offset, data, size);
+        }
+    }
+    size_t windowSize = kWindowSize;
+    off64_t sourceSize;
+    if (mSource->getSize(&sourceSize) == OK && sourceSize > offset
+            && (uint64_t)(sourceSize - offset) < windowSize) {
+        windowSize = sourceSize - offset;
+    }
+    ssize_t n = mSource->readAt(offset, oldest->mData, windowSize);
+    if (n <= 0) {
+        oldest->mSize = 0;
+        return n;
+    }
+    oldest->mOffset = offset;
+    oldest->mSize = n;
+    oldest->mLastUse = mNumReads;
+    if ((size_t)n < size) {
+        size = n;
+    }
+    memcpy(data, oldest->mData, size);
+    return size;
+}
+
+status_t FragmentReadCache::getSize(off64_t *size) {
+    return mSource->getSize(size);
+}
+
+uint32_t FragmentReadCache::flags() {
+    return mSource->flags();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static const bool kUseHexDump = false;
 
 static const char *FourCC2MIME(uint32_t fourcc) {
@@ -425,6 +540,7 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mMoofFound(false),
       mMdatFound(false),
       mDataSource(source),
+      mFragmentReadCache(NULL),
       mInitCheck(NO_INIT),
       mHeaderTimescale(0),
       mIsQT(false),
@@ -453,6 +569,7 @@ MPEG4Extractor::~MPEG4Extractor() {
     }
     mPssh.clear();
 
+    delete mFragmentReadCache;
     delete mDataSource;
     AMediaFormat_delete(mFileMetaData);
 }
@@ -4553,8 +4670,19 @@ MediaTrackHelper *MPEG4Extractor::getTrack(size_t index) {
     ALOGV("elst_initial_empty_edit_ticks in MediaTimeScale :%" PRIu64,
           elst_initial_empty_edit_ticks);
 
+    // Fragments are parsed lazily as each track reaches them, which takes many
+    // small reads. Optionally share read-ahead windows between the tracks.
+    DataSourceHelper *dataSource = mDataSource;
+    if (mMoofOffset != 0 && android::base::GetBoolProperty(
+            "media.extractor.mp4.fragment-cache", false)) {
+        if (mFragmentReadCache == NULL) {
+            mFragmentReadCache = new FragmentReadCache(mDataSource);
+        }
+        dataSource = mFragmentReadCache;
+    }
+
     MPEG4Source* source =
-            new MPEG4Source(track->meta, mDataSource, track->timescale, track->sampleTable,
+            new MPEG4Source(track->meta, dataSource, track->timescale, track->sampleTable,
                             mSidxEntries, trex, mMoofOffset, itemTable,
                             track->elst_shift_start_ticks, elst_initial_empty_edit_ticks);
     if (source->init() != OK) {
@@ -6487,8 +6615,12 @@ media_status_t MPEG4Source::read(
         // the start code (0x00 00 00 01).
         ssize_t num_bytes_read = 0;
         bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
+        // 4-byte sizes take as much room as startcodes, so the sample can be
+        // converted in the output buffer.
+        bool convertInPlace = mNALLengthSize == 4 && size <= mBuffer->size();
         if (mSrcBufferFitsDataToRead) {
-          num_bytes_read = mDataSource->readAt(offset, mSrcBuffer, size);
+          num_bytes_read = mDataSource->readAt(
+                  offset, convertInPlace ? mBuffer->data() : mSrcBuffer, size);
         } else {
           // We are trying to read a sample larger than the expected max sample size.
           // Fall through and let the failure be handled by the following if.
@@ -6505,6 +6637,16 @@ media_status_t MPEG4Source::read(
         size_t srcOffset = 0;
         size_t dstOffset = 0;
 
+        if (convertInPlace) {
+            if (LengthPrefixedToAnnexBInPlace(dstData, size)) {
+                srcOffset = size;
+                dstOffset = size;
+            } else {
+                // Let the loop below drop the empty and abnormal NAL units.
+                memcpy(mSrcBuffer, dstData, size);
+            }
+        }
+
         while (srcOffset < size) {
             bool isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
             size_t nalLength = 0;
@@ -6837,6 +6979,13 @@ media_status_t MPEG4Source::fragmentedRead(
         } else {
             data = mSrcBuffer;
         }
+        // 4-byte sizes take as much room as startcodes, so the sample can be
+        // converted in the output buffer.
+        bool convertInPlace = !isMalFormed && mNALLengthSize == 4 && mBuffer != NULL
+                && size <= mBuffer->size();
+        if (convertInPlace) {
+            data = mBuffer->data();
+        }
 
         if (isMalFormed || data == NULL) {
             ALOGE("isMalFormed size %zu", size);
@@ -6860,6 +7009,16 @@ media_status_t MPEG4Source::fragmentedRead(
         size_t srcOffset = 0;
         size_t dstOffset = 0;
 
+        if (convertInPlace) {
+            if (LengthPrefixedToAnnexBInPlace(dstData, size)) {
+                srcOffset = size;
+                dstOffset = size;
+            } else {
+                // Let the loop below drop the empty and abnormal NAL units.
+                memcpy(mSrcBuffer, dstData, size);
+            }
+        }
+
         while (srcOffset < size) {
             isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
             size_t nalLength = 0;
@@ -20,6 +20,8 @@
 
 #include "SampleIterator.h"
 
+#include <algorithm>
+
 #include <arpa/inet.h>
 
 #include <media/stagefright/foundation/ADebug.h>
@@ -69,11 +71,8 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         return OK;
     }
 
-    if (!mInitialized || sampleIndex < mFirstChunkSampleIndex) {
-        reset();
-    }
-
-    if (sampleIndex >= mStopChunkSampleIndex) {
+    if (!mInitialized || sampleIndex < mFirstChunkSampleIndex
+            || sampleIndex >= mStopChunkSampleIndex) {
         status_t err;
         if ((err = findChunkRange(sampleIndex)) != OK) {
             ALOGE("findChunkRange failed");
@@ -99,29 +98,23 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
             return err;
         }
 
-        mCurrentChunkSampleSizes.clear();
+        mCurrentChunkSampleOffsets.clear();
 
         uint32_t firstChunkSampleIndex =
             mFirstChunkSampleIndex
                 + mSamplesPerChunk * (chunk - mFirstChunk);
 
-        for (uint32_t i = 0; i < mSamplesPerChunk; ++i) {
-            size_t sampleSize;
-            if ((err = getSampleSizeDirect(
-                            firstChunkSampleIndex + i, &sampleSize)) != OK) {
-                ALOGE("getSampleSizeDirect return error");
-                // stsc sample count is not sync with stsz sample count
-                if (err == ERROR_OUT_OF_RANGE) {
-                    ALOGW("stsc samples(%d) not sync with stsz samples(%d)", mSamplesPerChunk, i);
-                    mSamplesPerChunk = i;
-                    break;
-                } else{
-                    mCurrentChunkSampleSizes.clear();
-                    return err;
-                }
-            }
+        // stsc sample count is not sync with stsz sample count
+        if (mSamplesPerChunk > mTable->mNumSampleSizes - firstChunkSampleIndex) {
+            ALOGW("stsc samples(%d) not sync with stsz samples(%d)", mSamplesPerChunk,
+                    mTable->mNumSampleSizes - firstChunkSampleIndex);
+            mSamplesPerChunk = mTable->mNumSampleSizes - firstChunkSampleIndex;
+        }
 
-            mCurrentChunkSampleSizes.push(sampleSize);
+        if ((err = readChunkSampleSizes(firstChunkSampleIndex, mSamplesPerChunk)) != OK) {
+            ALOGE("readChunkSampleSizes return error");
+            mCurrentChunkSampleOffsets.clear();
+            return err;
         }
 
         mCurrentChunkIndex = chunk;
@@ -130,19 +123,11 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     uint32_t chunkRelativeSampleIndex =
         (sampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk;
 
-    mCurrentSampleOffset = mCurrentChunkOffset;
-    for (uint32_t i = 0; i < chunkRelativeSampleIndex; ++i) {
-        mCurrentSampleOffset += mCurrentChunkSampleSizes[i];
-    }
+    mCurrentSampleOffset =
+        mCurrentChunkOffset + mCurrentChunkSampleOffsets[chunkRelativeSampleIndex];
 
-    mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
-    if (sampleIndex < mTTSSampleIndex) {
-        mTimeToSampleIndex = 0;
-        mTTSSampleIndex = 0;
-        mTTSSampleTime = 0;
-        mTTSCount = 0;
-        mTTSDuration = 0;
-    }
+    mCurrentSampleSize = mCurrentChunkSampleOffsets[chunkRelativeSampleIndex + 1]
+            - mCurrentChunkSampleOffsets[chunkRelativeSampleIndex];
 
     status_t err;
     if ((err = findSampleTimeAndDuration(
@@ -158,43 +143,61 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     return OK;
 }
 
-status_t SampleIterator::findChunkRange(uint32_t sampleIndex) {
-    CHECK(sampleIndex >= mFirstChunkSampleIndex);
+void SampleIterator::buildRunIndex() {
+    const uint32_t numRuns = mTable->mNumSampleToChunkOffsets;
+    mRunFirstSampleIndices.reserve(numRuns + 1);
 
-    while (sampleIndex >= mStopChunkSampleIndex) {
-        if (mSampleToChunkIndex == mTable->mNumSampleToChunkOffsets) {
-            return ERROR_OUT_OF_RANGE;
-        }
+    uint32_t firstSampleIndex = 0;
+    for (uint32_t i = 0; i < numRuns; ++i) {
+        const SampleTable::SampleToChunkEntry *entry = &mTable->mSampleToChunkEntries[i];
 
-        mFirstChunkSampleIndex = mStopChunkSampleIndex;
+        if (i + 1 == numRuns) {
+            mRunFirstSampleIndices.push_back(firstSampleIndex);
+            firstSampleIndex = 0xffffffff;
+            break;
+        }
 
-        const SampleTable::SampleToChunkEntry *entry =
-            &mTable->mSampleToChunkEntries[mSampleToChunkIndex];
+        // Samples from an invalid run on cannot be found.
+        const uint32_t firstChunk = entry->startChunk;
+        const uint32_t samplesPerChunk = entry->samplesPerChunk;
+        const uint32_t stopChunk = entry[1].startChunk;
+        if (samplesPerChunk == 0 || stopChunk < firstChunk ||
+            (stopChunk - firstChunk) > UINT32_MAX / samplesPerChunk ||
+            ((stopChunk - firstChunk) * samplesPerChunk >
+             UINT32_MAX - firstSampleIndex)) {
+            break;
+        }
 
-        mFirstChunk = entry->startChunk;
-        mSamplesPerChunk = entry->samplesPerChunk;
-        mChunkDesc = entry->chunkDesc;
+        mRunFirstSampleIndices.push_back(firstSampleIndex);
+        firstSampleIndex += (stopChunk - firstChunk) * samplesPerChunk;
+    }
+    mRunFirstSampleIndices.push_back(firstSampleIndex);
+}
 
-        if (mSampleToChunkIndex + 1 < mTable->mNumSampleToChunkOffsets) {
-            mStopChunk = entry[1].startChunk;
+status_t SampleIterator::findChunkRange(uint32_t sampleIndex) {
+    if (mRunFirstSampleIndices.empty()) {
+        buildRunIndex();
+    }
 
-            if (mSamplesPerChunk == 0 || mStopChunk < mFirstChunk ||
-                (mStopChunk - mFirstChunk) > UINT32_MAX / mSamplesPerChunk ||
-                ((mStopChunk - mFirstChunk) * mSamplesPerChunk >
-                 UINT32_MAX - mFirstChunkSampleIndex)) {
+    // The last element is the end of the runs. Empty runs share their first
+    // sample index with the next run, upper_bound() skips them.
+    const auto runsEnd = mRunFirstSampleIndices.end() - 1;
+    if (sampleIndex >= *runsEnd) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    const auto next = std::upper_bound(mRunFirstSampleIndices.begin(), runsEnd, sampleIndex);
+    const uint32_t run = next - mRunFirstSampleIndices.begin() - 1;
 
-                return ERROR_OUT_OF_RANGE;
-            }
-            mStopChunkSampleIndex =
-                mFirstChunkSampleIndex
-                    + (mStopChunk - mFirstChunk) * mSamplesPerChunk;
-        } else {
-            mStopChunk = 0xffffffff;
-            mStopChunkSampleIndex = 0xffffffff;
-        }
+    const SampleTable::SampleToChunkEntry *entry = &mTable->mSampleToChunkEntries[run];
 
-        ++mSampleToChunkIndex;
-    }
+    mSampleToChunkIndex = run + 1;
+    mFirstChunkSampleIndex = mRunFirstSampleIndices[run];
+    mFirstChunk = entry->startChunk;
+    mSamplesPerChunk = entry->samplesPerChunk;
+    mChunkDesc = entry->chunkDesc;
+    mStopChunk = mSampleToChunkIndex < mTable->mNumSampleToChunkOffsets
+            ? entry[1].startChunk : 0xffffffff;
+    mStopChunkSampleIndex = *next;
 
     return OK;
 }
@@ -234,6 +237,57 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
     return OK;
 }
 
+status_t SampleIterator::readChunkSampleSizes(
+        uint32_t firstSampleIndex, uint32_t count) {
+    uint64_t offset = 0;
+    mCurrentChunkSampleOffsets.push(offset);
+
+    const uint32_t fieldSize = mTable->mSampleSizeFieldSize;
+    if (mTable->mDefaultSampleSize > 0 || (fieldSize != 8 && fieldSize != 16 && fieldSize != 32)) {
+        for (uint32_t i = 0; i < count; ++i) {
+            size_t sampleSize;
+            status_t err;
+            if ((err = getSampleSizeDirect(firstSampleIndex + i, &sampleSize)) != OK) {
+                return err;
+            }
+            offset += sampleSize;
+            mCurrentChunkSampleOffsets.push(offset);
+        }
+        return OK;
+    }
+
+    // Read the sizes of the chunk in blocks rather than with a read per sample.
+    const uint32_t bytesPerSize = fieldSize / 8;
+    uint8_t block[1024];
+    while (count > 0) {
+        const uint32_t n = std::min<uint32_t>(count, sizeof(block) / bytesPerSize);
+        const ssize_t bytes = n * bytesPerSize;
+        if (mTable->mDataSource->readAt(
+                    mTable->mSampleSizeOffset + 12 + (off64_t)bytesPerSize * firstSampleIndex,
+                    block, bytes) < bytes) {
+            return ERROR_IO;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            switch (bytesPerSize) {
+                case 4:
+                    offset += U32_AT(&block[4 * i]);
+                    break;
+                case 2:
+                    offset += U16_AT(&block[2 * i]);
+                    break;
+                default:
+                    offset += block[i];
+                    break;
+            }
+            mCurrentChunkSampleOffsets.push(offset);
+        }
+        firstSampleIndex += n;
+        count -= n;
+    }
+
+    return OK;
+}
+
 status_t SampleIterator::getSampleSizeDirect(
         uint32_t sampleIndex, size_t *size) {
     *size = 0;
@@ -312,26 +366,16 @@ status_t SampleIterator::findSampleTimeAndDuration(
         return ERROR_OUT_OF_RANGE;
     }
 
-    while (true) {
-        if (mTTSSampleIndex > UINT32_MAX - mTTSCount) {
+    if (sampleIndex < mTTSSampleIndex || sampleIndex - mTTSSampleIndex >= mTTSCount) {
+        uint32_t run = mTable->findTimeToSampleRun(sampleIndex);
+        if (run == mTable->mNumTimeToSampleRuns) {
             return ERROR_OUT_OF_RANGE;
         }
-        if(sampleIndex < mTTSSampleIndex + mTTSCount) {
-            break;
-        }
-        if (mTimeToSampleIndex == mTable->mTimeToSampleCount ||
-            (mTTSDuration != 0 && mTTSCount > UINT64_MAX / mTTSDuration) ||
-            mTTSSampleTime > UINT64_MAX - (mTTSCount * mTTSDuration)) {
-            return ERROR_OUT_OF_RANGE;
-        }
-
-        mTTSSampleIndex += mTTSCount;
-        mTTSSampleTime += mTTSCount * mTTSDuration;
-
-        mTTSCount = mTable->mTimeToSample[2 * mTimeToSampleIndex];
-        mTTSDuration = mTable->mTimeToSample[2 * mTimeToSampleIndex + 1];
-
-        ++mTimeToSampleIndex;
+        mTTSSampleIndex = mTable->mTimeToSampleRuns[run].mFirstSampleIndex;
+        mTTSSampleTime = mTable->mTimeToSampleRuns[run].mFirstSampleTime;
+        mTTSCount = mTable->mTimeToSample[2 * run];
+        mTTSDuration = mTable->mTimeToSample[2 * run + 1];
+        mTimeToSampleIndex = run + 1;
     }
 
     // below is equivalent to:
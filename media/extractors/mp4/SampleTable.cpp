@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "SampleTable.h"
@@ -53,7 +54,8 @@ struct SampleTable::CompositionDeltaLookup {
     CompositionDeltaLookup();
 
     void setEntries(
-            const int32_t *deltaEntries, size_t numDeltaEntries);
+            const int32_t *deltaEntries, const uint32_t *firstSamples,
+            size_t numDeltaEntries);
 
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
@@ -61,6 +63,7 @@ private:
     Mutex mLock;
 
     const int32_t *mDeltaEntries;
+    const uint32_t *mFirstSamples;
     size_t mNumDeltaEntries;
 
     size_t mCurrentDeltaEntry;
@@ -71,16 +74,19 @@ private:
 
 SampleTable::CompositionDeltaLookup::CompositionDeltaLookup()
     : mDeltaEntries(NULL),
+      mFirstSamples(NULL),
       mNumDeltaEntries(0),
       mCurrentDeltaEntry(0),
       mCurrentEntrySampleIndex(0) {
 }
 
 void SampleTable::CompositionDeltaLookup::setEntries(
-        const int32_t *deltaEntries, size_t numDeltaEntries) {
+        const int32_t *deltaEntries, const uint32_t *firstSamples,
+        size_t numDeltaEntries) {
     Mutex::Autolock autolock(mLock);
 
     mDeltaEntries = deltaEntries;
+    mFirstSamples = firstSamples;
     mNumDeltaEntries = numDeltaEntries;
     mCurrentDeltaEntry = 0;
     mCurrentEntrySampleIndex = 0;
@@ -94,9 +100,19 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
         return 0;
     }
 
-    if (sampleIndex < mCurrentEntrySampleIndex) {
-        mCurrentDeltaEntry = 0;
-        mCurrentEntrySampleIndex = 0;
+    // Samples are mostly looked up in order. For anything but the current or
+    // the next entry, look the entry up in the index.
+    if (sampleIndex < mCurrentEntrySampleIndex
+            || (mCurrentDeltaEntry + 1 < mNumDeltaEntries
+                && sampleIndex >= mFirstSamples[mCurrentDeltaEntry + 1]
+                        + (uint64_t)mDeltaEntries[2 * mCurrentDeltaEntry + 2])) {
+        const uint32_t *next = std::upper_bound(
+                mFirstSamples, mFirstSamples + mNumDeltaEntries, sampleIndex);
+        if (next == mFirstSamples) {
+            return 0;
+        }
+        mCurrentDeltaEntry = next - mFirstSamples - 1;
+        mCurrentEntrySampleIndex = mFirstSamples[mCurrentDeltaEntry];
     }
 
     while (mCurrentDeltaEntry < mNumDeltaEntries) {
@@ -128,9 +144,15 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
+      mTimeToSampleRuns(NULL),
+      mNumTimeToSampleRuns(0),
+      mNumTimedSamples(0),
       mSampleTimeEntries(NULL),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
+      mCompositionTimeDeltaFirstSamples(NULL),
+      mMinCompositionTimeDelta(0),
+      mMaxCompositionTimeDelta(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
       mSyncSampleOffset(-1),
       mNumSyncSamples(0),
@@ -151,12 +173,18 @@ SampleTable::~SampleTable() {
     delete[] mTimeToSample;
     mTimeToSample = NULL;
 
+    delete[] mTimeToSampleRuns;
+    mTimeToSampleRuns = NULL;
+
     delete mCompositionDeltaLookup;
     mCompositionDeltaLookup = NULL;
 
     delete[] mCompositionTimeDeltaEntries;
     mCompositionTimeDeltaEntries = NULL;
 
+    delete[] mCompositionTimeDeltaFirstSamples;
+    mCompositionTimeDeltaFirstSamples = NULL;
+
     delete[] mSampleTimeEntries;
     mSampleTimeEntries = NULL;
 
@@ -397,13 +425,14 @@ status_t SampleTable::setTimeToSampleParams(
     }
 
     uint64_t allocSize = (uint64_t)mTimeToSampleCount * 2 * sizeof(uint32_t);
-    mTotalSize += allocSize;
+    uint64_t runsSize = (uint64_t)mTimeToSampleCount * sizeof(TimeToSampleRun);
+    mTotalSize += allocSize + runsSize;
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Time-to-sample table size would make sample table too large.\n"
               "    Requested time-to-sample table size = %llu\n"
               "    Eventual sample table size >= %llu\n"
               "    Allowed sample table size = %llu\n",
-              (unsigned long long)allocSize,
+              (unsigned long long)(allocSize + runsSize),
               (unsigned long long)mTotalSize,
               (unsigned long long)kMaxTotalSize);
         return ERROR_OUT_OF_RANGE;
@@ -426,6 +455,35 @@ status_t SampleTable::setTimeToSampleParams(
         mTimeToSample[i] = ntohl(mTimeToSample[i]);
     }
 
+    mTimeToSampleRuns = new (std::nothrow) TimeToSampleRun[mTimeToSampleCount];
+    if (!mTimeToSampleRuns) {
+        ALOGE("Cannot allocate time-to-sample index with %llu entries.",
+                (unsigned long long)mTimeToSampleCount);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    // Runs past an overflow of the sample index or time cannot be reached.
+    uint32_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+    mNumTimeToSampleRuns = 0;
+    mNumTimedSamples = 0;
+    for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
+        uint32_t n = mTimeToSample[2 * i];
+        uint64_t duration;
+        mTimeToSampleRuns[i].mFirstSampleIndex = sampleIndex;
+        mTimeToSampleRuns[i].mFirstSampleTime = sampleTime;
+        mNumTimeToSampleRuns = i + 1;
+        if (__builtin_add_overflow(sampleIndex, n, &mNumTimedSamples)) {
+            mNumTimedSamples = UINT32_MAX;
+            break;
+        }
+        if (__builtin_mul_overflow((uint64_t)n, mTimeToSample[2 * i + 1], &duration)
+                || __builtin_add_overflow(sampleTime, duration, &sampleTime)) {
+            break;
+        }
+        sampleIndex = mNumTimedSamples;
+    }
+
     mHasTimeToSample = true;
     return OK;
 }
@@ -466,18 +524,19 @@ status_t SampleTable::setCompositionTimeToSampleParams(
 
     mNumCompositionTimeDeltaEntries = numEntries;
     uint64_t allocSize = (uint64_t)numEntries * 2 * sizeof(int32_t);
-    if (allocSize > kMaxTotalSize) {
+    uint64_t indexSize = (uint64_t)numEntries * sizeof(uint32_t);
+    if (allocSize + indexSize > kMaxTotalSize) {
         ALOGE("Composition-time-to-sample table size too large.");
         return ERROR_OUT_OF_RANGE;
     }
 
-    mTotalSize += allocSize;
+    mTotalSize += allocSize + indexSize;
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Composition-time-to-sample table would make sample table too large.\n"
               "    Requested composition-time-to-sample table size = %llu\n"
               "    Eventual sample table size >= %llu\n"
               "    Allowed sample table size = %llu\n",
-              (unsigned long long)allocSize,
+              (unsigned long long)(allocSize + indexSize),
               (unsigned long long)mTotalSize,
               (unsigned long long)kMaxTotalSize);
         return ERROR_OUT_OF_RANGE;
@@ -502,8 +561,34 @@ status_t SampleTable::setCompositionTimeToSampleParams(
         mCompositionTimeDeltaEntries[i] = ntohl(mCompositionTimeDeltaEntries[i]);
     }
 
+    mCompositionTimeDeltaFirstSamples = new (std::nothrow) uint32_t[numEntries];
+    if (!mCompositionTimeDeltaFirstSamples) {
+        ALOGE("Cannot allocate composition-time-to-sample index with %llu "
+                "entries.", (unsigned long long)numEntries);
+        delete[] mCompositionTimeDeltaEntries;
+        mCompositionTimeDeltaEntries = NULL;
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    // Entries past an overflow of the sample index cannot be reached.
+    uint32_t sampleIndex = 0;
+    size_t numIndexedEntries = 0;
+    while (numIndexedEntries < numEntries) {
+        uint32_t n = mCompositionTimeDeltaEntries[2 * numIndexedEntries];
+        int32_t delta = mCompositionTimeDeltaEntries[2 * numIndexedEntries + 1];
+        mCompositionTimeDeltaFirstSamples[numIndexedEntries++] = sampleIndex;
+        if (n > 0) {
+            mMinCompositionTimeDelta = std::min(mMinCompositionTimeDelta, delta);
+            mMaxCompositionTimeDelta = std::max(mMaxCompositionTimeDelta, delta);
+        }
+        if (__builtin_add_overflow(sampleIndex, n, &sampleIndex)) {
+            break;
+        }
+    }
+
     mCompositionDeltaLookup->setEntries(
-            mCompositionTimeDeltaEntries, mNumCompositionTimeDeltaEntries);
+            mCompositionTimeDeltaEntries, mCompositionTimeDeltaFirstSamples,
+            numIndexedEntries);
 
     return OK;
 }
@@ -714,67 +799,171 @@ void SampleTable::buildSampleEntriesTable() {
           CompareIncreasingTime);
 }
 
-status_t SampleTable::findSampleAtTime(
-        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
-        uint32_t *sample_index, uint32_t flags) {
-    buildSampleEntriesTable();
+uint32_t SampleTable::findTimeToSampleRun(uint32_t sampleIndex) const {
+    if (sampleIndex >= mNumTimedSamples) {
+        return mNumTimeToSampleRuns;
+    }
+    const TimeToSampleRun *next = std::upper_bound(
+            mTimeToSampleRuns, mTimeToSampleRuns + mNumTimeToSampleRuns, sampleIndex,
+            [](uint32_t index, const TimeToSampleRun &run) {
+                return index < run.mFirstSampleIndex;
+            });
+    // sampleIndex is covered by the runs, so next is past the first one
+    return next - mTimeToSampleRuns - 1;
+}
 
-    if (mSampleTimeEntries == NULL) {
-        return ERROR_OUT_OF_RANGE;
+uint64_t SampleTable::getDecodeTime(uint32_t sampleIndex) const {
+    uint32_t run = findTimeToSampleRun(sampleIndex);
+    if (run == mNumTimeToSampleRuns) {
+        return UINT64_MAX;
+    }
+    const TimeToSampleRun &entry = mTimeToSampleRuns[run];
+    uint64_t time;
+    if (__builtin_mul_overflow(
+                (uint64_t)(sampleIndex - entry.mFirstSampleIndex), mTimeToSample[2 * run + 1],
+                &time)
+            || __builtin_add_overflow(entry.mFirstSampleTime, time, &time)) {
+        return UINT64_MAX;
     }
+    return time;
+}
 
-    if (flags == kFlagFrameIndex) {
-        if (req_time >= mNumSampleSizes) {
-            return ERROR_OUT_OF_RANGE;
-        }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
-        return OK;
+uint64_t SampleTable::getOffsetDecodeTime(uint32_t sampleIndex, int32_t delta) const {
+    uint64_t time = getDecodeTime(sampleIndex);
+    if (delta < 0) {
+        uint64_t magnitude = delta == INT32_MIN ? INT32_MAX : uint32_t(-delta);
+        return time < magnitude ? 0 : time - magnitude;
     }
+    return time > UINT64_MAX - delta ? UINT64_MAX : time + delta;
+}
+
+uint64_t SampleTable::getCompositionTime(uint32_t sampleIndex) {
+    return getOffsetDecodeTime(
+            sampleIndex, mCompositionDeltaLookup->getCompositionTimeOffset(sampleIndex));
+}
 
+bool SampleTable::findSampleBefore_l(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint64_t *composition_time) {
+    // Samples from |left| on are composed after req_time, as they are decoded
+    // after req_time - mMinCompositionTimeDelta.
+    uint32_t numSamples = std::min(mNumTimedSamples, mNumSampleSizes);
     uint32_t left = 0;
-    uint32_t right_plus_one = mNumSampleSizes;
+    uint32_t right_plus_one = numSamples;
     while (left < right_plus_one) {
         uint32_t center = left + (right_plus_one - left) / 2;
-        uint64_t centerTime =
-            getSampleTime(center, scale_num, scale_den);
-
-        if (req_time < centerTime) {
+        if (scaleTime(getOffsetDecodeTime(center, mMinCompositionTimeDelta),
+                scale_num, scale_den) <= req_time) {
+            left = center + 1;
+        } else {
             right_plus_one = center;
-        } else if (req_time > centerTime) {
+        }
+    }
+
+    // Walk back until no earlier sample can be composed after the best one.
+    bool found = false;
+    for (uint32_t i = left; i > 0; --i) {
+        if (found && getOffsetDecodeTime(i - 1, mMaxCompositionTimeDelta) <= *composition_time) {
+            break;
+        }
+        uint64_t time = getCompositionTime(i - 1);
+        if (scaleTime(time, scale_num, scale_den) <= req_time
+                && (!found || time > *composition_time)) {
+            *sample_index = i - 1;
+            *composition_time = time;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool SampleTable::findSampleAfter_l(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint64_t *composition_time) {
+    // Samples before |left| are composed before req_time, as they are decoded
+    // before req_time - mMaxCompositionTimeDelta.
+    uint32_t numSamples = std::min(mNumTimedSamples, mNumSampleSizes);
+    uint32_t left = 0;
+    uint32_t right_plus_one = numSamples;
+    while (left < right_plus_one) {
+        uint32_t center = left + (right_plus_one - left) / 2;
+        if (scaleTime(getOffsetDecodeTime(center, mMaxCompositionTimeDelta),
+                scale_num, scale_den) < req_time) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            right_plus_one = center;
+        }
+    }
+
+    // Walk forward until no later sample can be composed before the best one.
+    bool found = false;
+    for (uint32_t i = left; i < numSamples; ++i) {
+        if (found && getOffsetDecodeTime(i, mMinCompositionTimeDelta) >= *composition_time) {
+            break;
+        }
+        uint64_t time = getCompositionTime(i);
+        if (scaleTime(time, scale_num, scale_den) >= req_time
+                && (!found || time < *composition_time)) {
+            *sample_index = i;
+            *composition_time = time;
+            found = true;
+        }
+    }
+    return found;
+}
+
+status_t SampleTable::findSampleAtTime(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint32_t flags) {
+    if (flags == kFlagFrameIndex) {
+        if (req_time >= mNumSampleSizes) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        if (mCompositionTimeDeltaEntries == NULL) {
+            // presentation order is decode order
+            *sample_index = req_time;
             return OK;
         }
+
+        buildSampleEntriesTable();
+
+        if (mSampleTimeEntries == NULL) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        return OK;
     }
 
-    uint32_t closestIndex = left;
+    Mutex::Autolock autoLock(mLock);
+
+    uint32_t beforeIndex = 0, afterIndex = 0;
+    uint64_t beforeTime = 0, afterTime = 0;
+    bool hasBefore = findSampleBefore_l(
+            req_time, scale_num, scale_den, &beforeIndex, &beforeTime);
+    bool hasAfter = findSampleAfter_l(
+            req_time, scale_num, scale_den, &afterIndex, &afterTime);
 
-    if (closestIndex == mNumSampleSizes) {
-        if (flags == kFlagAfter) {
+    if (!hasAfter) {
+        if (flags == kFlagAfter || !hasBefore) {
             return ERROR_OUT_OF_RANGE;
         }
         flags = kFlagBefore;
-    } else if (closestIndex == 0) {
-        if (flags == kFlagBefore) {
-            // normally we should return out of range, but that is
-            // treated as end-of-stream.  instead return first sample
-            //
-            // return ERROR_OUT_OF_RANGE;
-        }
+    } else if (!hasBefore) {
+        // normally we should return out of range for kFlagBefore, but that is
+        // treated as end-of-stream.  instead return first sample
         flags = kFlagAfter;
     }
 
     switch (flags) {
         case kFlagBefore:
         {
-            --closestIndex;
+            *sample_index = beforeIndex;
             break;
         }
 
         case kFlagAfter:
         {
-            // nothing to do
+            *sample_index = afterIndex;
             break;
         }
 
@@ -782,17 +971,16 @@ status_t SampleTable::findSampleAtTime(
         {
             CHECK(flags == kFlagClosest);
             // pick closest based on timestamp. use abs_difference for safety
-            if (abs_difference(
-                    getSampleTime(closestIndex, scale_num, scale_den), req_time) >
-                abs_difference(
-                    req_time, getSampleTime(closestIndex - 1, scale_num, scale_den))) {
-                --closestIndex;
+            if (abs_difference(scaleTime(afterTime, scale_num, scale_den), req_time) >
+                abs_difference(req_time, scaleTime(beforeTime, scale_num, scale_den))) {
+                *sample_index = beforeIndex;
+            } else {
+                *sample_index = afterIndex;
             }
             break;
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
     return OK;
 }
 
@@ -984,7 +1172,9 @@ status_t SampleTable::getMetaDataForSample(
         } else {
             size_t i = (mLastSyncSampleIndex < mNumSyncSamples)
                     && (mSyncSamples[mLastSyncSampleIndex] <= sampleIndex)
-                ? mLastSyncSampleIndex : 0;
+                ? mLastSyncSampleIndex
+                : std::lower_bound(mSyncSamples, mSyncSamples + mNumSyncSamples, sampleIndex)
+                        - mSyncSamples;
 
             while (i < mNumSyncSamples && mSyncSamples[i] < sampleIndex) {
                 ++i;
@@ -138,6 +138,8 @@ private:
     Vector<Trex> mTrex;
 
     DataSourceHelper *mDataSource;
+    // shared by the tracks of fragmented files, see getTrack()
+    DataSourceHelper *mFragmentReadCache;
     status_t mInitCheck;
     uint32_t mHeaderTimescale;
     bool mIsQT;
@@ -18,6 +18,8 @@
 
 #define SAMPLE_ITERATOR_H_
 
+#include <vector>
+
 #include <utils/Vector.h>
 
 namespace android {
@@ -57,9 +59,17 @@ private:
     uint32_t mSamplesPerChunk;
     uint32_t mChunkDesc;
 
+    // First sample index of each sample-to-chunk run, built on the first lookup
+    // of a run, followed by the end of the last run that is valid. Lets
+    // findChunkRange() find the run of any sample by binary search instead of
+    // walking the runs from the start.
+    std::vector<uint32_t> mRunFirstSampleIndices;
+
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
-    Vector<size_t> mCurrentChunkSampleSizes;
+    // Offset of each sample of the current chunk relative to the chunk,
+    // followed by the size of the samples of the chunk.
+    Vector<uint64_t> mCurrentChunkSampleOffsets;
 
     uint32_t mTimeToSampleIndex;
     uint32_t mTTSSampleIndex;
@@ -74,7 +84,9 @@ private:
     uint64_t mCurrentSampleDuration;
 
     void reset();
+    void buildRunIndex();
     status_t findChunkRange(uint32_t sampleIndex);
+    status_t readChunkSampleSizes(uint32_t firstSampleIndex, uint32_t count);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
 
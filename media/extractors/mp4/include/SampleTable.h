@@ -126,6 +126,20 @@ private:
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
 
+    // Index of the time-to-sample runs, so that the decode time of any sample
+    // can be found without expanding the table per sample.
+    struct TimeToSampleRun {
+        uint32_t mFirstSampleIndex;
+        uint64_t mFirstSampleTime;
+    };
+    TimeToSampleRun *mTimeToSampleRuns;
+    // runs whose first sample index and time are representable
+    uint32_t mNumTimeToSampleRuns;
+    // number of samples covered by the indexed runs
+    uint32_t mNumTimedSamples;
+
+    // Only built for lookups by presentation order of streams with reordered
+    // frames (kFlagFrameIndex), as it takes an entry per sample.
     struct SampleTimeEntry {
         uint32_t mSampleIndex;
         uint64_t mCompositionTime;
@@ -134,6 +148,12 @@ private:
 
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
+    // first sample index of each composition-time-to-sample entry
+    uint32_t *mCompositionTimeDeltaFirstSamples;
+    // bounds of the composition time offsets, including 0 for samples not
+    // covered by the table
+    int32_t mMinCompositionTimeDelta;
+    int32_t mMaxCompositionTimeDelta;
     CompositionDeltaLookup *mCompositionDeltaLookup;
 
     off64_t mSyncSampleOffset;
@@ -156,16 +176,37 @@ private:
     friend struct SampleIterator;
 
     // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
+    static inline uint64_t scaleTime(uint64_t time, uint64_t scale_num, uint64_t scale_den) {
+        return scale_den != 0 ? (time * scale_num) / scale_den : 0;
     }
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
+    // Returns the index of the time-to-sample run containing |sampleIndex|,
+    // or mNumTimeToSampleRuns if there is none.
+    uint32_t findTimeToSampleRun(uint32_t sampleIndex) const;
+
+    // Decode and composition time of a sample below mNumTimedSamples. The
+    // composition time is clamped like in buildSampleEntriesTable().
+    uint64_t getDecodeTime(uint32_t sampleIndex) const;
+    uint64_t getCompositionTime(uint32_t sampleIndex);
+
+    // Decode time of |sampleIndex| offset by |delta|, clamped to the range of
+    // uint64_t.
+    uint64_t getOffsetDecodeTime(uint32_t sampleIndex, int32_t delta) const;
+
+    // Last sample whose composition time is at or before |req_time| and first
+    // one at or after it. Return false if there is no such sample. These only
+    // scan the samples whose decode time is within the range of composition
+    // time offsets of |req_time|.
+    bool findSampleBefore_l(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            uint32_t *sample_index, uint64_t *composition_time);
+    bool findSampleAfter_l(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            uint32_t *sample_index, uint64_t *composition_time);
+
     static int CompareIncreasingTime(const void *, const void *);
 
     void buildSampleEntriesTable();
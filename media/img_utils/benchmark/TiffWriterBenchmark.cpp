@@ -0,0 +1,164 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <img_utils/FileOutput.h>
+#include <img_utils/TagDefinitions.h>
+#include <img_utils/TiffWriter.h>
+
+using namespace android;
+using namespace android::img_utils;
+
+// A 50 MP RAW16 capture
+static constexpr uint32_t kWidth = 8160;
+static constexpr uint32_t kHeight = 6120;
+static constexpr uint32_t kTileSize = 256;
+static constexpr uint32_t kRawIfd = 0;
+static const char* kOutputPath = "/data/local/tmp/img_utils_benchmark.dng";
+
+static const std::vector<uint16_t>& rawPixels() {
+    static std::vector<uint16_t> pixels = []() {
+        std::vector<uint16_t> p(static_cast<size_t>(kWidth) * kHeight);
+        for (size_t i = 0; i < p.size(); i++) {
+            p[i] = static_cast<uint16_t>((i * 2654435761u) >> 22);
+        }
+        return p;
+    }();
+    return pixels;
+}
+
+class RawStripSource : public StripSource {
+  public:
+    status_t writeToStream(Output& stream, uint32_t count) override {
+        const std::vector<uint16_t>& pixels = rawPixels();
+        if (count != pixels.size() * sizeof(uint16_t)) {
+            return BAD_VALUE;
+        }
+        return stream.write(reinterpret_cast<const uint8_t*>(pixels.data()), 0, count);
+    }
+
+    uint32_t getIfd() const override {
+        return kRawIfd;
+    }
+};
+
+class RawTileSource : public TileSource {
+  public:
+    status_t readTile(uint32_t left, uint32_t top, uint32_t width, uint32_t height,
+            uint8_t* buf, size_t rowStride) override {
+        const uint16_t* pixels = rawPixels().data();
+        for (uint32_t row = 0; row < height; row++) {
+            memcpy(buf + row * rowStride, pixels + (top + row) * kWidth + left,
+                    width * sizeof(uint16_t));
+        }
+        return OK;
+    }
+
+    uint32_t getIfd() const override {
+        return kRawIfd;
+    }
+};
+
+static sp<TiffWriter> buildWriter() {
+    sp<TiffWriter> writer = new TiffWriter();
+    writer->addIfd(kRawIfd);
+    uint32_t width = kWidth;
+    uint32_t height = kHeight;
+    uint16_t bitsPerSample = 16;
+    uint16_t samplesPerPixel = 1;
+    uint16_t compression = 1;
+    uint16_t photometric = 32803; // CFA
+    writer->addEntry(TAG_IMAGEWIDTH, 1, &width, kRawIfd);
+    writer->addEntry(TAG_IMAGELENGTH, 1, &height, kRawIfd);
+    writer->addEntry(TAG_BITSPERSAMPLE, 1, &bitsPerSample, kRawIfd);
+    writer->addEntry(TAG_SAMPLESPERPIXEL, 1, &samplesPerPixel, kRawIfd);
+    writer->addEntry(TAG_COMPRESSION, 1, &compression, kRawIfd);
+    writer->addEntry(TAG_PHOTOMETRICINTERPRETATION, 1, &photometric, kRawIfd);
+    return writer;
+}
+
+// Single-threaded writer with the RAW image in strips
+static void BM_TiffWriter_Strips(benchmark::State& state) {
+    rawPixels();
+    for (auto _ : state) {
+        sp<TiffWriter> writer = buildWriter();
+        writer->addStrip(kRawIfd);
+        RawStripSource source;
+        StripSource* sources[] = {&source};
+        FileOutput out{String8(kOutputPath)};
+        out.open();
+        if (writer->write(&out, sources, 1) != OK) {
+            state.SkipWithError("Failed to write strips");
+        }
+        out.close();
+    }
+    state.SetBytesProcessed(state.iterations() * kWidth * kHeight * sizeof(uint16_t));
+    unlink(kOutputPath);
+}
+
+// Tiled writer, with the number of worker threads as the argument
+static void BM_TiffWriter_Tiles(benchmark::State& state) {
+    rawPixels();
+    for (auto _ : state) {
+        sp<TiffWriter> writer = buildWriter();
+        writer->addTiles(kRawIfd, kTileSize, kTileSize);
+        RawTileSource source;
+        TileSource* sources[] = {&source};
+        FileOutput out{String8(kOutputPath)};
+        out.open();
+        if (writer->write(&out, /*stripSources*/nullptr, 0, sources, 1, LITTLE,
+                state.range(0)) != OK) {
+            state.SkipWithError("Failed to write tiles");
+        }
+        out.close();
+    }
+    state.SetBytesProcessed(state.iterations() * kWidth * kHeight * sizeof(uint16_t));
+    unlink(kOutputPath);
+}
+
+// Byte swapping is done on the worker threads
+static void BM_TiffWriter_TilesBigEndian(benchmark::State& state) {
+    rawPixels();
+    for (auto _ : state) {
+        sp<TiffWriter> writer = buildWriter();
+        writer->addTiles(kRawIfd, kTileSize, kTileSize);
+        RawTileSource source;
+        TileSource* sources[] = {&source};
+        FileOutput out{String8(kOutputPath)};
+        out.open();
+        if (writer->write(&out, /*stripSources*/nullptr, 0, sources, 1, BIG,
+                state.range(0)) != OK) {
+            state.SkipWithError("Failed to write tiles");
+        }
+        out.close();
+    }
+    state.SetBytesProcessed(state.iterations() * kWidth * kHeight * sizeof(uint16_t));
+    unlink(kOutputPath);
+}
+
+BENCHMARK(BM_TiffWriter_Strips)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TiffWriter_Tiles)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TiffWriter_TilesBigEndian)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -145,6 +145,10 @@ enum {
     TAG_SOFTWARE = 0x0131u,
     TAG_SAMPLESPERPIXEL = 0x0115u,
     TAG_ROWSPERSTRIP = 0x0116u,
+    TAG_TILEWIDTH = 0x0142u,
+    TAG_TILELENGTH = 0x0143u,
+    TAG_TILEOFFSETS = 0x0144u,
+    TAG_TILEBYTECOUNTS = 0x0145u,
     TAG_RESOLUTIONUNIT = 0x0128u,
     TAG_PLANARCONFIGURATION = 0x011Cu,
     TAG_PHOTOMETRICINTERPRETATION = 0x0106u,
@@ -654,6 +658,38 @@ const TagDefinition_t TIFF_6_TAG_DEFINITIONS[] = {
         1,
         UNDEFINED_ENDIAN
     },
+    { // TileByteCounts
+        "TileByteCounts",
+        0x0145u,
+        LONG,
+        IFD_0,
+        0,
+        UNDEFINED_ENDIAN
+    },
+    { // TileLength
+        "TileLength",
+        0x0143u,
+        LONG,
+        IFD_0,
+        1,
+        UNDEFINED_ENDIAN
+    },
+    { // TileOffsets
+        "TileOffsets",
+        0x0144u,
+        LONG,
+        IFD_0,
+        0,
+        UNDEFINED_ENDIAN
+    },
+    { // TileWidth
+        "TileWidth",
+        0x0142u,
+        LONG,
+        IFD_0,
+        1,
+        UNDEFINED_ENDIAN
+    },
     { // XResolution
         "XResolution",
         0x011Au,
@@ -116,12 +116,42 @@ class ANDROID_API TiffIfd : public TiffWritable {
         virtual status_t validateAndSetStripTags();
 
         /**
-         * Returns true if validateAndSetStripTags has been called, but not setStripOffsets.
+         * Convenience method to validate and set tile-related image tags.
+         *
+         * This sets all tile related tags, but leaves offset values unitialized,
+         * in the same way as validateAndSetStripTags.  Tiles are stored uncompressed
+         * in row-major order, and tiles on the right and bottom edges are padded to
+         * the full tile size.  The tile width and length must be multiples of 16.
+         *
+         * Does not handle planar image configurations (PlanarConfiguration != 1).
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t validateAndSetTileTags(uint32_t tileWidth, uint32_t tileLength);
+
+        /**
+         * Get the image dimensions and pixel layout from the ImageWidth, ImageLength,
+         * BitsPerSample and SamplesPerPixel tags set in this IFD.
+         *
+         * Returns OK on success, or a negative error code if a tag is missing or the
+         * samples are not byte-aligned.
+         */
+        virtual status_t getImageLayout(/*out*/uint32_t* width, /*out*/uint32_t* height,
+                /*out*/uint32_t* bytesPerSample, /*out*/uint32_t* samplesPerPixel) const;
+
+        /**
+         * Returns true if validateAndSetTileTags has been called for this IFD.
+         */
+        virtual bool isTiled() const;
+
+        /**
+         * Returns true if validateAndSetStripTags or validateAndSetTileTags has been called,
+         * but not setStripOffsets.
          */
         virtual bool uninitializedOffsets() const;
 
         /**
-         * Convenience method to set beginning offset for strips.
+         * Convenience method to set beginning offset for strips, or tiles for a tiled IFD.
          *
          * Call this to update the strip offsets before calling writeData.
          *
@@ -130,7 +160,7 @@ class ANDROID_API TiffIfd : public TiffWritable {
         virtual status_t setStripOffset(uint32_t offset);
 
         /**
-         * Get the total size of the strips in bytes.
+         * Get the total size of the strips in bytes, or of the tiles for a tiled IFD.
          *
          * This sums the byte count at each strip offset, and returns
          * the total count of bytes stored in strips for this IFD.
@@ -19,6 +19,7 @@
 
 #include <img_utils/EndianUtils.h>
 #include <img_utils/StripSource.h>
+#include <img_utils/TileSource.h>
 #include <img_utils/TiffEntryImpl.h>
 #include <img_utils/TagDefinitions.h>
 #include <img_utils/TiffIfd.h>
@@ -93,6 +94,23 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
         virtual status_t write(Output* out, StripSource** sources, size_t sourcesCount,
                 Endianness end = LITTLE);
 
+        /**
+         * Write a TIFF header containing each IFD set, followed by the image strips
+         * and tiles.  This will recursively write all SubIFDs and tags.
+         *
+         * This behaves like the StripSource variant of write, but IFDs set up with
+         * addTiles are written from the TileSource with a matching IFD.  Tiles are
+         * read and converted to the output byte order on workerCount threads, or one
+         * thread per CPU if workerCount is 0, while the calling thread streams the
+         * finished tiles to the output in order.  Only a few tiles per worker are
+         * held in memory at a time.
+         *
+         * Returns OK on success, or a negative error code on failure.
+         */
+        virtual status_t write(Output* out, StripSource** stripSources, size_t stripSourcesCount,
+                TileSource** tileSources, size_t tileSourcesCount, Endianness end = LITTLE,
+                uint32_t workerCount = 0);
+
         /**
          * Write a TIFF header containing each IFD set.  This will recursively
          * write all SubIFDs and tags.
@@ -175,6 +193,24 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
          */
         virtual status_t addStrip(uint32_t ifd);
 
+        /**
+         * Convenience function to set the tile related tags for a given IFD.
+         * Tiles are written uncompressed, and tiles on the right and bottom
+         * edges are padded to the full tile size.
+         *
+         * Call this before using a TileSource as an input to write.
+         * The following tags must be set before calling this method:
+         * - ImageWidth
+         * - ImageLength
+         * - SamplesPerPixel
+         * - BitsPerSample
+         *
+         * The tile width and length must be multiples of 16.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t addTiles(uint32_t ifd, uint32_t tileWidth, uint32_t tileLength);
+
         /**
          * Return the TIFF entry with the given tag ID in the IFD with the given ID,
          * or an empty pointer if none exists.
@@ -257,6 +293,8 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
 
         sp<TiffIfd> findLastIfd();
         status_t writeFileHeader(EndianOutput& out);
+        status_t writeTiles(EndianOutput& out, const sp<TiffIfd>& ifd, TileSource* source,
+                uint32_t workerCount);
         const TagDefinition_t* lookupDefinition(uint16_t tag) const;
         status_t calculateOffsets();
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef IMG_UTILS_TILE_SOURCE_H
+#define IMG_UTILS_TILE_SOURCE_H
+
+#include <cutils/compiler.h>
+#include <utils/Errors.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+namespace img_utils {
+
+/**
+ * This class acts as a data source for tiles set in a TiffIfd.
+ *
+ * Tiles are requested concurrently from several threads, so implementations
+ * must allow readTile to be called for different tiles at the same time.
+ */
+class ANDROID_API TileSource {
+    public:
+        virtual ~TileSource();
+
+        /**
+         * Copy the pixels of the given rectangle into buf, one row every rowStride
+         * bytes.  Samples are in host byte order, and are converted to the byte order
+         * of the output by the writer.
+         *
+         * The rectangle lies within the image, so it is smaller than the tile size for
+         * tiles on the right and bottom edges.  The writer zeroes the padding.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t readTile(uint32_t left, uint32_t top, uint32_t width, uint32_t height,
+                uint8_t* buf, size_t rowStride) = 0;
+
+        /**
+         * Return the source IFD.
+         */
+        virtual uint32_t getIfd() const = 0;
+};
+
+} /*namespace img_utils*/
+} /*namespace android*/
+
+#endif /*IMG_UTILS_TILE_SOURCE_H*/
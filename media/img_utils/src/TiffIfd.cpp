@@ -168,7 +168,8 @@ uint32_t TiffIfd::getComparableValue() const {
     return mIfdId;
 }
 
-status_t TiffIfd::validateAndSetStripTags() {
+status_t TiffIfd::getImageLayout(/*out*/uint32_t* width, /*out*/uint32_t* height,
+        /*out*/uint32_t* bytesPerSample, /*out*/uint32_t* samplesPerPixel) const {
     sp<TiffEntry> widthEntry = getEntry(TAG_IMAGEWIDTH);
     if (widthEntry == NULL) {
         ALOGE("%s: IFD %u doesn't have a ImageWidth tag set", __FUNCTION__, mIfdId);
@@ -193,18 +194,31 @@ status_t TiffIfd::validateAndSetStripTags() {
         return BAD_VALUE;
     }
 
-    uint32_t width = *(widthEntry->getData<uint32_t>());
-    uint32_t height = *(heightEntry->getData<uint32_t>());
-    uint16_t bitsPerSample = *(bitsEntry->getData<uint16_t>());
-    uint16_t samplesPerPixel = *(samplesEntry->getData<uint16_t>());
+    uint16_t bits = *(bitsEntry->getData<uint16_t>());
+    uint16_t samples = *(samplesEntry->getData<uint16_t>());
 
-    if ((bitsPerSample % 8) != 0) {
+    if ((bits % 8) != 0) {
         ALOGE("%s: BitsPerSample %d in IFD %u is not byte-aligned.", __FUNCTION__,
-                bitsPerSample, mIfdId);
+                bits, mIfdId);
         return BAD_VALUE;
     }
 
-    uint32_t bytesPerSample = bitsPerSample / 8;
+    *width = *(widthEntry->getData<uint32_t>());
+    *height = *(heightEntry->getData<uint32_t>());
+    *bytesPerSample = bits / 8;
+    *samplesPerPixel = samples;
+    return OK;
+}
+
+status_t TiffIfd::validateAndSetStripTags() {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bytesPerSample = 0;
+    uint32_t samplesPerPixel = 0;
+    status_t res = getImageLayout(&width, &height, &bytesPerSample, &samplesPerPixel);
+    if (res != OK) {
+        return res;
+    }
 
     // Choose strip size as close to 8kb as possible without splitting rows.
     // If the row length is >8kb, each strip will only contain a single row.
@@ -270,6 +284,12 @@ status_t TiffIfd::validateAndSetStripTags() {
         return BAD_VALUE;
     }
 
+    // A stripped image must not carry tile tags
+    removeEntry(TAG_TILEOFFSETS);
+    removeEntry(TAG_TILEBYTECOUNTS);
+    removeEntry(TAG_TILEWIDTH);
+    removeEntry(TAG_TILELENGTH);
+
     if(addEntry(stripByteCounts) != OK) {
         ALOGE("%s: Could not add entry for StripByteCounts to IFD %u", __FUNCTION__, mIfdId);
         return BAD_VALUE;
@@ -289,20 +309,94 @@ status_t TiffIfd::validateAndSetStripTags() {
     return OK;
 }
 
+status_t TiffIfd::validateAndSetTileTags(uint32_t tileWidth, uint32_t tileLength) {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bytesPerSample = 0;
+    uint32_t samplesPerPixel = 0;
+    status_t res = getImageLayout(&width, &height, &bytesPerSample, &samplesPerPixel);
+    if (res != OK) {
+        return res;
+    }
+
+    if (tileWidth == 0 || tileLength == 0 || (tileWidth % 16) != 0 || (tileLength % 16) != 0) {
+        ALOGE("%s: Tile size %ux%u in IFD %u is not a multiple of 16.", __FUNCTION__,
+                tileWidth, tileLength, mIfdId);
+        return BAD_VALUE;
+    }
+
+    uint64_t tileSize = static_cast<uint64_t>(tileWidth) * tileLength * bytesPerSample *
+            samplesPerPixel;
+    size_t tilesAcross = (width + tileWidth - 1) / tileWidth;
+    size_t tilesDown = (height + tileLength - 1) / tileLength;
+    size_t numTiles = tilesAcross * tilesDown;
+    if (tileSize * numTiles > UINT32_MAX) {
+        ALOGE("%s: Tiles in IFD %u do not fit in a TIFF file.", __FUNCTION__, mIfdId);
+        return BAD_VALUE;
+    }
+
+    sp<TiffEntry> tileWidthEntry = TiffWriter::uncheckedBuildEntry(TAG_TILEWIDTH, LONG, 1,
+            UNDEFINED_ENDIAN, &tileWidth);
+    sp<TiffEntry> tileLengthEntry = TiffWriter::uncheckedBuildEntry(TAG_TILELENGTH, LONG, 1,
+            UNDEFINED_ENDIAN, &tileLength);
+    if (tileWidthEntry == NULL || tileLengthEntry == NULL) {
+        ALOGE("%s: Could not build entries for TileWidth and TileLength tags.", __FUNCTION__);
+        return BAD_VALUE;
+    }
+
+    // Edge tiles are padded, so every tile has the same byte count
+    Vector<uint32_t> byteCounts;
+    byteCounts.insertAt(static_cast<uint32_t>(tileSize), 0, numTiles);
+    sp<TiffEntry> tileByteCounts = TiffWriter::uncheckedBuildEntry(TAG_TILEBYTECOUNTS, LONG,
+            static_cast<uint32_t>(numTiles), UNDEFINED_ENDIAN, byteCounts.array());
+
+    // Set uninitialized offsets
+    Vector<uint32_t> tileOffsetsVector;
+    tileOffsetsVector.resize(numTiles);
+    sp<TiffEntry> tileOffsets = TiffWriter::uncheckedBuildEntry(TAG_TILEOFFSETS, LONG,
+            static_cast<uint32_t>(numTiles), UNDEFINED_ENDIAN, tileOffsetsVector.array());
+
+    if (tileByteCounts == NULL || tileOffsets == NULL) {
+        ALOGE("%s: Could not build entries for TileByteCounts and TileOffsets tags.",
+                __FUNCTION__);
+        return BAD_VALUE;
+    }
+
+    // A tiled image must not carry strip tags
+    removeEntry(TAG_STRIPOFFSETS);
+    removeEntry(TAG_STRIPBYTECOUNTS);
+    removeEntry(TAG_ROWSPERSTRIP);
+
+    if (addEntry(tileWidthEntry) != OK || addEntry(tileLengthEntry) != OK ||
+            addEntry(tileByteCounts) != OK || addEntry(tileOffsets) != OK) {
+        ALOGE("%s: Could not add tile entries to IFD %u", __FUNCTION__, mIfdId);
+        return BAD_VALUE;
+    }
+
+    mStripOffsetsInitialized = true;
+    return OK;
+}
+
+bool TiffIfd::isTiled() const {
+    return getEntry(TAG_TILEOFFSETS) != NULL;
+}
+
 bool TiffIfd::uninitializedOffsets() const {
     return mStripOffsetsInitialized;
 }
 
 status_t TiffIfd::setStripOffset(uint32_t offset) {
+    const bool tiled = isTiled();
+    const uint16_t offsetsTag = tiled ? TAG_TILEOFFSETS : TAG_STRIPOFFSETS;
 
     // Get old offsets and bytecounts
-    sp<TiffEntry> oldOffsets = getEntry(TAG_STRIPOFFSETS);
+    sp<TiffEntry> oldOffsets = getEntry(offsetsTag);
     if (oldOffsets == NULL) {
         ALOGE("%s: IFD %u does not contain StripOffsets entry.", __FUNCTION__, mIfdId);
         return BAD_VALUE;
     }
 
-    sp<TiffEntry> stripByteCounts = getEntry(TAG_STRIPBYTECOUNTS);
+    sp<TiffEntry> stripByteCounts = getEntry(tiled ? TAG_TILEBYTECOUNTS : TAG_STRIPBYTECOUNTS);
     if (stripByteCounts == NULL) {
         ALOGE("%s: IFD %u does not contain StripByteCounts entry.", __FUNCTION__, mIfdId);
         return BAD_VALUE;
@@ -328,7 +422,7 @@ status_t TiffIfd::setStripOffset(uint32_t offset) {
         offset += stripByteCountsArray[i];
     }
 
-    sp<TiffEntry> newOffsets = TiffWriter::uncheckedBuildEntry(TAG_STRIPOFFSETS, LONG,
+    sp<TiffEntry> newOffsets = TiffWriter::uncheckedBuildEntry(offsetsTag, LONG,
             static_cast<uint32_t>(numStrips), UNDEFINED_ENDIAN, stripOffsets.array());
 
     if (newOffsets == NULL) {
@@ -344,7 +438,8 @@ status_t TiffIfd::setStripOffset(uint32_t offset) {
 }
 
 uint32_t TiffIfd::getStripSize() const {
-    sp<TiffEntry> stripByteCounts = getEntry(TAG_STRIPBYTECOUNTS);
+    sp<TiffEntry> stripByteCounts = getEntry(isTiled() ? TAG_TILEBYTECOUNTS :
+            TAG_STRIPBYTECOUNTS);
     if (stripByteCounts == NULL) {
         ALOGE("%s: IFD %u does not contain StripByteCounts entry.", __FUNCTION__, mIfdId);
         return BAD_VALUE;
@@ -20,11 +20,81 @@
 #include <img_utils/TiffWriter.h>
 #include <img_utils/TagDefinitions.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <assert.h>
+#include <string.h>
 
 namespace android {
 namespace img_utils {
 
+namespace {
+
+// Tiles held in memory for each worker thread while writing tiles
+constexpr size_t kTilesPerWorker = 2;
+
+struct TileLayout {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tileWidth = 0;
+    uint32_t tileLength = 0;
+    uint32_t tilesAcross = 0;
+    uint32_t bytesPerSample = 0;
+    uint32_t bytesPerPixel = 0;
+    size_t rowStride = 0;
+    bool swapBytes = false;
+};
+
+struct TileSlot {
+    std::vector<uint8_t> data;
+    status_t res = OK;
+    bool ready = false;
+};
+
+// Read a tile from the source, pad it and convert it to the output byte order
+status_t readTile(TileSource* source, const TileLayout& layout, size_t index, uint8_t* buf) {
+    uint32_t left = (index % layout.tilesAcross) * layout.tileWidth;
+    uint32_t top = (index / layout.tilesAcross) * layout.tileLength;
+    uint32_t width = std::min(layout.tileWidth, layout.width - left);
+    uint32_t height = std::min(layout.tileLength, layout.height - top);
+
+    status_t res = source->readTile(left, top, width, height, buf, layout.rowStride);
+    if (res != OK) {
+        return res;
+    }
+
+    if (width < layout.tileWidth) {
+        size_t rowBytes = static_cast<size_t>(width) * layout.bytesPerPixel;
+        for (uint32_t row = 0; row < height; row++) {
+            memset(buf + row * layout.rowStride + rowBytes, 0, layout.rowStride - rowBytes);
+        }
+    }
+    if (height < layout.tileLength) {
+        memset(buf + height * layout.rowStride, 0,
+                (layout.tileLength - height) * layout.rowStride);
+    }
+
+    if (layout.swapBytes && layout.bytesPerSample > 1) {
+        size_t tileSize = layout.rowStride * layout.tileLength;
+        if (layout.bytesPerSample == 2) {
+            for (size_t i = 0; i < tileSize; i += 2) {
+                std::swap(buf[i], buf[i + 1]);
+            }
+        } else {
+            for (size_t i = 0; i < tileSize; i += layout.bytesPerSample) {
+                std::reverse(buf + i, buf + i + layout.bytesPerSample);
+            }
+        }
+    }
+    return OK;
+}
+
+} // anonymous namespace
+
 KeyedVector<uint16_t, const TagDefinition_t*> TiffWriter::buildTagMap(
             const TagDefinition_t* definitions, size_t length) {
     KeyedVector<uint16_t, const TagDefinition_t*> map;
@@ -58,6 +128,12 @@ TiffWriter::~TiffWriter() {}
 
 status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCount,
         Endianness end) {
+    return write(out, sources, sourcesCount, /*tileSources*/NULL, /*tileSourcesCount*/0, end);
+}
+
+status_t TiffWriter::write(Output* out, StripSource** stripSources, size_t stripSourcesCount,
+        TileSource** tileSources, size_t tileSourcesCount, Endianness end,
+        uint32_t workerCount) {
     status_t ret = OK;
     EndianOutput endOut(out, end);
 
@@ -69,6 +145,7 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
     uint32_t totalSize = getTotalSize();
 
     KeyedVector<uint32_t, uint32_t> offsetVector;
+    size_t tiledCount = 0;
 
     for (size_t i = 0; i < mNamedIfds.size(); ++i) {
         if (mNamedIfds[i]->uninitializedOffsets()) {
@@ -80,13 +157,17 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
             totalSize += stripSize;
             WORD_ALIGN(totalSize);
             offsetVector.add(mNamedIfds.keyAt(i), totalSize);
+            if (mNamedIfds[i]->isTiled()) {
+                tiledCount++;
+            }
         }
     }
 
     size_t offVecSize = offsetVector.size();
-    if (offVecSize != sourcesCount) {
-        ALOGE("%s: Mismatch between number of IFDs with uninitialized strips (%zu) and"
-                " sources (%zu).", __FUNCTION__, offVecSize, sourcesCount);
+    if (offVecSize - tiledCount != stripSourcesCount || tiledCount != tileSourcesCount) {
+        ALOGE("%s: Mismatch between number of IFDs with uninitialized strips (%zu) and tiles"
+                " (%zu), and sources (%zu, %zu).", __FUNCTION__, offVecSize - tiledCount,
+                tiledCount, stripSourcesCount, tileSourcesCount);
         return BAD_VALUE;
     }
 
@@ -106,23 +187,37 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
 
     for (size_t i = 0; i < offVecSize; ++i) {
         uint32_t ifdKey = offsetVector.keyAt(i);
-        uint32_t sizeToWrite = mNamedIfds[ifdKey]->getStripSize();
+        const sp<TiffIfd>& selected = mNamedIfds.valueFor(ifdKey);
+        uint32_t sizeToWrite = selected->getStripSize();
         bool found = false;
-        for (size_t j = 0; j < sourcesCount; ++j) {
-            if (sources[j]->getIfd() == ifdKey) {
-                if ((ret = sources[i]->writeToStream(endOut, sizeToWrite)) != OK) {
-                    ALOGE("%s: Could not write to stream, received %d.", __FUNCTION__, ret);
-                    return ret;
+        if (selected->isTiled()) {
+            for (size_t j = 0; j < tileSourcesCount; ++j) {
+                if (tileSources[j]->getIfd() == ifdKey) {
+                    if ((ret = writeTiles(endOut, selected, tileSources[j], workerCount)) != OK) {
+                        ALOGE("%s: Could not write tiles, received %d.", __FUNCTION__, ret);
+                        return ret;
+                    }
+                    found = true;
+                    break;
+                }
+            }
+        } else {
+            for (size_t j = 0; j < stripSourcesCount; ++j) {
+                if (stripSources[j]->getIfd() == ifdKey) {
+                    if ((ret = stripSources[j]->writeToStream(endOut, sizeToWrite)) != OK) {
+                        ALOGE("%s: Could not write to stream, received %d.", __FUNCTION__, ret);
+                        return ret;
+                    }
+                    found = true;
+                    break;
                 }
-                ZERO_TILL_WORD(&endOut, sizeToWrite, ret);
-                found = true;
-                break;
             }
         }
         if (!found) {
             ALOGE("%s: No stream for byte strips for IFD %u", __FUNCTION__, ifdKey);
             return BAD_VALUE;
         }
+        ZERO_TILL_WORD(&endOut, sizeToWrite, ret);
         assert(offsetVector[i] == endOut.getCurrentOffset());
     }
 
@@ -214,6 +309,16 @@ status_t TiffWriter::addStrip(uint32_t ifd) {
     return selected->validateAndSetStripTags();
 }
 
+status_t TiffWriter::addTiles(uint32_t ifd, uint32_t tileWidth, uint32_t tileLength) {
+    ssize_t index = mNamedIfds.indexOfKey(ifd);
+    if (index < 0) {
+        ALOGE("%s: Ifd %u doesn't exist, cannot add tile entries.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+    sp<TiffIfd> selected = mNamedIfds[index];
+    return selected->validateAndSetTileTags(tileWidth, tileLength);
+}
+
 status_t TiffWriter::addIfd(uint32_t ifd) {
     ssize_t index = mNamedIfds.indexOfKey(ifd);
     if (index >= 0) {
@@ -368,6 +473,119 @@ status_t TiffWriter::writeFileHeader(EndianOutput& out) {
     return ret;
 }
 
+status_t TiffWriter::writeTiles(EndianOutput& out, const sp<TiffIfd>& ifd, TileSource* source,
+        uint32_t workerCount) {
+    TileLayout layout;
+    uint32_t samplesPerPixel = 0;
+    status_t ret = ifd->getImageLayout(&layout.width, &layout.height, &layout.bytesPerSample,
+            &samplesPerPixel);
+    if (ret != OK) {
+        return ret;
+    }
+
+    sp<TiffEntry> tileWidthEntry = ifd->getEntry(TAG_TILEWIDTH);
+    sp<TiffEntry> tileLengthEntry = ifd->getEntry(TAG_TILELENGTH);
+    if (tileWidthEntry == NULL || tileLengthEntry == NULL) {
+        ALOGE("%s: IFD %u doesn't have TileWidth and TileLength tags set", __FUNCTION__,
+                ifd->getId());
+        return BAD_VALUE;
+    }
+
+    layout.tileWidth = *(tileWidthEntry->getData<uint32_t>());
+    layout.tileLength = *(tileLengthEntry->getData<uint32_t>());
+    layout.bytesPerPixel = layout.bytesPerSample * samplesPerPixel;
+    layout.rowStride = static_cast<size_t>(layout.tileWidth) * layout.bytesPerPixel;
+    layout.tilesAcross = (layout.width + layout.tileWidth - 1) / layout.tileWidth;
+    layout.swapBytes = (out.getEndianness() == BIG) ?
+            (convertToBigEndian<uint16_t>(1) != 1) : (convertToLittleEndian<uint16_t>(1) != 1);
+
+    const size_t tileSize = layout.rowStride * layout.tileLength;
+    const size_t tileCount = static_cast<size_t>(layout.tilesAcross) *
+            ((layout.height + layout.tileLength - 1) / layout.tileLength);
+    if (tileCount == 0) {
+        return OK;
+    }
+
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workerCount = static_cast<uint32_t>(std::min<size_t>(workerCount, tileCount));
+
+    // Tile i is converted into slot i % slotCount, and a worker only claims a tile
+    // once the tile previously held by its slot has been written out.
+    const size_t slotCount = std::min<size_t>(static_cast<size_t>(workerCount) *
+            kTilesPerWorker, tileCount);
+    std::vector<TileSlot> slots(slotCount);
+    for (auto& slot : slots) {
+        slot.data.resize(tileSize);
+    }
+
+    std::mutex lock;
+    std::condition_variable cond;
+    size_t nextTile = 0;
+    size_t nextToWrite = 0;
+    bool aborted = false;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> l(lock);
+        while (true) {
+            cond.wait(l, [&]() {
+                return aborted || nextTile >= tileCount || nextTile < nextToWrite + slotCount;
+            });
+            if (aborted || nextTile >= tileCount) {
+                return;
+            }
+            size_t index = nextTile++;
+            TileSlot& slot = slots[index % slotCount];
+            l.unlock();
+            status_t res = readTile(source, layout, index, slot.data.data());
+            l.lock();
+            slot.res = res;
+            slot.ready = true;
+            cond.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < tileCount; i++) {
+        TileSlot& slot = slots[i % slotCount];
+        {
+            std::unique_lock<std::mutex> l(lock);
+            cond.wait(l, [&slot]() { return slot.ready; });
+        }
+        if (slot.res != OK) {
+            ALOGE("%s: Could not read tile %zu of IFD %u, received %d.", __FUNCTION__, i,
+                    ifd->getId(), slot.res);
+            ret = slot.res;
+            break;
+        }
+        if ((ret = out.write(slot.data.data(), 0, tileSize)) != OK) {
+            ALOGE("%s: Could not write tile %zu of IFD %u, received %d.", __FUNCTION__, i,
+                    ifd->getId(), ret);
+            break;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        slot.ready = false;
+        nextToWrite++;
+        cond.notify_all();
+    }
+
+    if (ret != OK) {
+        std::lock_guard<std::mutex> l(lock);
+        aborted = true;
+        cond.notify_all();
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    return ret;
+}
+
 uint32_t TiffWriter::getTotalSize() const {
     uint32_t totalSize = FILE_HEADER_SIZE;
     sp<TiffIfd> ifd = mIfd;
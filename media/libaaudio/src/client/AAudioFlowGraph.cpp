@@ -18,6 +18,11 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <limits>
+
+#include <audio_utils/primitives.h>
+
 #include "AAudioFlowGraph.h"
 
 #include <flowgraph/ClipToRange.h>
@@ -134,14 +139,118 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // The common chains, from a float or 16-bit source through the optional clipper,
+    // mono to multichannel expansion and volume ramps to a float or 16-bit sink,
+    // can also be run by processFused().
+    mFused = !useMonoBlend
+            && (sourceFormat == AUDIO_FORMAT_PCM_FLOAT || sourceFormat == AUDIO_FORMAT_PCM_16_BIT)
+            && (sinkFormat == AUDIO_FORMAT_PCM_FLOAT || sinkFormat == AUDIO_FORMAT_PCM_16_BIT);
+    if (mFused) {
+        mFusedSourceIsFloat = sourceFormat == AUDIO_FORMAT_PCM_FLOAT;
+        mFusedSinkIsFloat = sinkFormat == AUDIO_FORMAT_PCM_FLOAT;
+        mFusedSourceChannelCount = sourceChannelCount;
+        mFusedSinkChannelCount = sinkChannelCount;
+        if (mClipper) {
+            mFusedClipMinimum = mClipper->getMinimum();
+            mFusedClipMaximum = mClipper->getMaximum();
+        } else {
+            mFusedClipMinimum = -std::numeric_limits<float>::infinity();
+            mFusedClipMaximum = std::numeric_limits<float>::infinity();
+        }
+        mFusedGains.assign(sinkChannelCount, 1.0f);
+    }
+
+    // Without a format or channel conversion or volume ramps, only the float clipper is left.
+    // It can be skipped for shared streams because the service clips the final mix.
+    mPassThrough = !useMonoBlend && !isExclusive
+            && sourceFormat == sinkFormat && sourceChannelCount == sinkChannelCount;
+
     return AAUDIO_OK;
 }
 
 void AAudioFlowGraph::process(const void *source, void *destination, int32_t numFrames) {
+    if (mFused && processFused(source, destination, numFrames)) {
+        return;
+    }
     mSource->setData(source, numFrames);
     mSink->read(destination, numFrames);
 }
 
+namespace {
+
+inline float toFloat(float sample) { return sample; }
+inline float toFloat(int16_t sample) { return float_from_i16(sample); }
+
+template <typename T> T fromFloat(float sample);
+template <> inline float fromFloat<float>(float sample) { return sample; }
+template <> inline int16_t fromFloat<int16_t>(float sample) { return clamp16_from_float(sample); }
+
+/**
+ * Clip, expand a mono source to the sink channels, scale by the channel gain and
+ * convert to the sink format, in one pass.
+ * CHANNELS is the sink channel count if known at compile time, 0 otherwise.
+ */
+template <int32_t CHANNELS, typename S, typename D>
+void fusedLoop(const S *source, D *destination, int32_t numFrames, int32_t channelCount,
+        bool monoSource, float clipMinimum, float clipMaximum, const float *gains) {
+    if constexpr (CHANNELS != 0) {
+        channelCount = CHANNELS;
+    }
+    const int32_t sourceFrameStep = monoSource ? 1 : channelCount;
+    const int32_t sourceChannelStep = monoSource ? 0 : 1;
+    for (int32_t i = 0; i < numFrames; i++) {
+        for (int32_t ch = 0; ch < channelCount; ch++) {
+            const float sample = std::min(clipMaximum,
+                    std::max(clipMinimum, toFloat(source[ch * sourceChannelStep])));
+            destination[ch] = fromFloat<D>(sample * gains[ch]);
+        }
+        source += sourceFrameStep;
+        destination += channelCount;
+    }
+}
+
+template <typename S, typename D>
+void fusedLoop(const void *source, void *destination, int32_t numFrames, int32_t channelCount,
+        bool monoSource, float clipMinimum, float clipMaximum, const float *gains) {
+    const S *src = static_cast<const S *>(source);
+    D *dst = static_cast<D *>(destination);
+    switch (channelCount) {
+        case 1:
+            fusedLoop<1>(src, dst, numFrames, channelCount, monoSource,
+                    clipMinimum, clipMaximum, gains);
+            break;
+        case 2:
+            fusedLoop<2>(src, dst, numFrames, channelCount, monoSource,
+                    clipMinimum, clipMaximum, gains);
+            break;
+        default:
+            fusedLoop<0>(src, dst, numFrames, channelCount, monoSource,
+                    clipMinimum, clipMaximum, gains);
+            break;
+    }
+}
+
+} // namespace
+
+bool AAudioFlowGraph::processFused(const void *source, void *destination, int32_t numFrames) {
+    for (size_t i = 0; i < mVolumeRamps.size(); i++) {
+        if (!mVolumeRamps[i]->isSteady()) {
+            return false; // let the graph ramp, this is rare
+        }
+        mFusedGains[i] = mVolumeRamps[i]->getLevel();
+    }
+    const bool monoSource = mFusedSourceChannelCount == 1 && mFusedSinkChannelCount > 1;
+    void (*loop)(const void *, void *, int32_t, int32_t, bool, float, float, const float *);
+    if (mFusedSourceIsFloat) {
+        loop = mFusedSinkIsFloat ? fusedLoop<float, float> : fusedLoop<float, int16_t>;
+    } else {
+        loop = mFusedSinkIsFloat ? fusedLoop<int16_t, float> : fusedLoop<int16_t, int16_t>;
+    }
+    loop(source, destination, numFrames, mFusedSinkChannelCount, monoSource,
+            mFusedClipMinimum, mFusedClipMaximum, mFusedGains.data());
+    return true;
+}
+
 /**
  * @param volume between 0.0 and 1.0
  */
@@ -56,6 +56,14 @@ public:
 
     void process(const void *source, void *destination, int32_t numFrames);
 
+    /**
+     * @return true if process() would only copy the data, so the source can be
+     *         rendered directly into the destination instead
+     */
+    bool isPassThrough() const {
+        return mPassThrough;
+    }
+
     /**
      * @param volume between 0.0 and 1.0
      */
@@ -72,6 +80,25 @@ public:
     void setRampLengthInFrames(int32_t numFrames);
 
 private:
+    /**
+     * Run the configured chain as a single loop, without pulling through the nodes.
+     * The volume ramps must be steady, the graph is used while they are ramping.
+     *
+     * @return true if the frames were processed
+     */
+    bool processFused(const void *source, void *destination, int32_t numFrames);
+
+    // True if configure() built a chain that processFused() can run.
+    bool mFused = false;
+    bool mPassThrough = false;
+    bool mFusedSourceIsFloat = false;
+    bool mFusedSinkIsFloat = false;
+    int32_t mFusedSourceChannelCount = 0;
+    int32_t mFusedSinkChannelCount = 0;
+    float mFusedClipMinimum = 0.0f;
+    float mFusedClipMaximum = 0.0f;
+    std::vector<float> mFusedGains; // per sink channel, the level of the steady volume ramps
+
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSourceBuffered> mSource;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::MonoBlend> mMonoBlend;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::ClipToRange> mClipper;
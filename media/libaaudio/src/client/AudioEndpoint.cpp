@@ -215,6 +215,10 @@ android::fifo_frames_t AudioEndpoint::write(void *buffer, android::fifo_frames_t
     return mDataQueue == nullptr ? 0 : mDataQueue->write(buffer, numFrames);
 }
 
+int32_t AudioEndpoint::acquireWrite(WrappingBuffer *wrappingBuffer, int32_t numFrames) {
+    return mDataQueue == nullptr ? 0 : mDataQueue->acquireWrite(wrappingBuffer, numFrames);
+}
+
 void AudioEndpoint::advanceWriteIndex(int32_t deltaFrames) {
     if (mDataQueue != nullptr) {
         mDataQueue->advanceWriteIndex(deltaFrames);
@@ -65,6 +65,13 @@ public:
 
     android::fifo_frames_t write(void* buffer, android::fifo_frames_t numFrames);
 
+    /**
+     * Acquire up to numFrames of room in the data queue that can be rendered in place.
+     * Call advanceWriteIndex() with the number of frames rendered.
+     * @return total frames acquired in one or two parts
+     */
+    int32_t acquireWrite(android::WrappingBuffer *wrappingBuffer, int32_t numFrames);
+
     void advanceReadIndex(int32_t deltaFrames);
 
     void advanceWriteIndex(int32_t deltaFrames);
@@ -793,7 +793,9 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
             break;
         }
         framesLeft -= (int32_t) framesProcessed;
-        audioData += framesProcessed * getBytesPerFrame();
+        if (audioData != nullptr) {
+            audioData += framesProcessed * getBytesPerFrame();
+        }
 
         // Should we block?
         if (timeoutNanoseconds == 0) {
@@ -175,18 +175,24 @@ aaudio_result_t AudioStreamInternalPlay::processDataNow(void *buffer, int32_t nu
     }
 
     // Write some data to the buffer.
+    // A null buffer means the data callback renders directly into the data queue.
     //ALOGD("AudioStreamInternal::processDataNow() - writeNowWithConversion(%d)", numFrames);
-    int32_t framesWritten = writeNowWithConversion(buffer, numFrames);
+    int32_t framesWritten = (buffer == nullptr)
+            ? writeNowFromCallback(numFrames)
+            : writeNowWithConversion(buffer, numFrames);
     //ALOGD("AudioStreamInternal::processDataNow() - tried to write %d frames, wrote %d",
     //    numFrames, framesWritten);
     if (ATRACE_ENABLED()) {
         ATRACE_INT("aaWrote", framesWritten);
     }
 
+    // When rendering from the callback we have to wait for room for all the frames.
+    const int32_t roomNeeded = (buffer == nullptr) ? (numFrames - framesWritten) : 0;
+
     // Sleep if there is too much data in the buffer.
     // Calculate an ideal time to wake up.
     if (wakeTimePtr != nullptr
-            && (mAudioEndpoint->getFullFramesAvailable() >= getBufferSize())) {
+            && (mAudioEndpoint->getFullFramesAvailable() + roomNeeded >= getBufferSize())) {
         // By default wake up a few milliseconds from now.  // TODO review
         int64_t wakeTime = currentNanoTime + (1 * AAUDIO_NANOS_PER_MILLISECOND);
         aaudio_stream_state_t state = getState();
@@ -212,7 +218,8 @@ aaudio_result_t AudioStreamInternalPlay::processDataNow(void *buffer, int32_t nu
                 const int32_t endBufferSize = mAudioEndpoint->getBufferSizeInFrames()
                         - getFramesPerBurst();
                 const int32_t bestBufferSize = std::min(appBufferSize, endBufferSize);
-                int64_t targetReadPosition = mAudioEndpoint->getDataWriteCounter() - bestBufferSize;
+                int64_t targetReadPosition = mAudioEndpoint->getDataWriteCounter()
+                        - bestBufferSize + roomNeeded;
                 wakeTime = mClockModel.convertPositionToTime(targetReadPosition);
             }
                 break;
@@ -232,39 +239,47 @@ aaudio_result_t AudioStreamInternalPlay::writeNowWithConversion(const void *buff
                                                             int32_t numFrames) {
     WrappingBuffer wrappingBuffer;
     uint8_t *byteBuffer = (uint8_t *) buffer;
-    int32_t framesLeft = numFrames;
 
-    mAudioEndpoint->getEmptyFramesAvailable(&wrappingBuffer);
+    int32_t framesWritten = mAudioEndpoint->acquireWrite(&wrappingBuffer, numFrames);
 
     // Write data in one or two parts.
-    int partIndex = 0;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        int32_t framesToWrite = framesLeft;
-        int32_t framesAvailable = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailable > 0) {
-            if (framesToWrite > framesAvailable) {
-                framesToWrite = framesAvailable;
-            }
-
-            int32_t numBytes = getBytesPerFrame() * framesToWrite;
-
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        int32_t framesToWrite = wrappingBuffer.numFrames[partIndex];
+        if (framesToWrite > 0) {
             mFlowGraph.process((void *)byteBuffer,
                                wrappingBuffer.data[partIndex],
                                framesToWrite);
-
-            byteBuffer += numBytes;
-            framesLeft -= framesToWrite;
-        } else {
-            break;
+            byteBuffer += getBytesPerFrame() * framesToWrite;
         }
-        partIndex++;
     }
-    int32_t framesWritten = numFrames - framesLeft;
     mAudioEndpoint->advanceWriteIndex(framesWritten);
 
     return framesWritten;
 }
 
+aaudio_result_t AudioStreamInternalPlay::writeNowFromCallback(int32_t numFrames) {
+    WrappingBuffer wrappingBuffer;
+    if (mAudioEndpoint->acquireWrite(&wrappingBuffer, numFrames) < numFrames) {
+        return 0; // wait for more room
+    }
+
+    if (wrappingBuffer.numFrames[0] < numFrames) {
+        // The room wraps around the end of the queue so render into the callback
+        // buffer and copy it in two parts.
+        mDirectCallbackResult = maybeCallDataCallback(mCallbackBuffer.get(), numFrames);
+        if (mDirectCallbackResult != AAUDIO_CALLBACK_RESULT_CONTINUE) {
+            return numFrames; // nothing to write, let the callback loop handle it
+        }
+        return writeNowWithConversion(mCallbackBuffer.get(), numFrames);
+    }
+
+    mDirectCallbackResult = maybeCallDataCallback(wrappingBuffer.data[0], numFrames);
+    if (mDirectCallbackResult == AAUDIO_CALLBACK_RESULT_CONTINUE) {
+        mAudioEndpoint->advanceWriteIndex(numFrames);
+    }
+    return numFrames;
+}
+
 int64_t AudioStreamInternalPlay::getFramesRead() {
     if (mAudioEndpoint) {
         const int64_t framesReadHardware = isClockModelInControl()
@@ -295,12 +310,22 @@ void *AudioStreamInternalPlay::callbackLoop() {
 
     // result might be a frame count
     while (mCallbackEnabled.load() && isActive() && (result >= 0)) {
-        // Call application using the AAudio callback interface.
-        callbackResult = maybeCallDataCallback(mCallbackBuffer.get(), mCallbackFrames);
+        if (mFlowGraph.isPassThrough()) {
+            // Wait for room in the shared data queue, then call the application
+            // to render directly into it. This is a BLOCKING WRITE!
+            mDirectCallbackResult = AAUDIO_CALLBACK_RESULT_CONTINUE;
+            result = processData(nullptr, mCallbackFrames, timeoutNanos);
+            callbackResult = mDirectCallbackResult;
+        } else {
+            // Call application using the AAudio callback interface.
+            callbackResult = maybeCallDataCallback(mCallbackBuffer.get(), mCallbackFrames);
+            if (callbackResult == AAUDIO_CALLBACK_RESULT_CONTINUE) {
+                // Write audio data to stream. This is a BLOCKING WRITE!
+                result = write(mCallbackBuffer.get(), mCallbackFrames, timeoutNanos);
+            }
+        }
 
         if (callbackResult == AAUDIO_CALLBACK_RESULT_CONTINUE) {
-            // Write audio data to stream. This is a BLOCKING WRITE!
-            result = write(mCallbackBuffer.get(), mCallbackFrames, timeoutNanos);
             if ((result != mCallbackFrames)) {
                 if (result >= 0) {
                     // Only wrote some of the frames requested. Must have timed out.
@@ -94,8 +94,19 @@ private:
     aaudio_result_t writeNowWithConversion(const void *buffer,
                                            int32_t numFrames);
 
+    /*
+     * Asynchronous write that calls the data callback to render directly into the data queue.
+     * Nothing is written until there is room for all numFrames.
+     * The callback result is stored in mDirectCallbackResult.
+     * @param numFrames
+     * @return frames written or negative error
+     */
+    aaudio_result_t writeNowFromCallback(int32_t numFrames);
+
     AAudioFlowGraph          mFlowGraph;
 
+    aaudio_data_callback_result_t mDirectCallbackResult = AAUDIO_CALLBACK_RESULT_CONTINUE;
+
 };
 
 } /* namespace aaudio */
@@ -20,6 +20,7 @@
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <math.h>
 #include <stdint.h>
 #include <algorithm>
 
@@ -61,15 +62,24 @@ void IsochronousClockModel::start(int64_t nanoTime) {
     ALOGV("start(nanos = %lld)\n", (long long) nanoTime);
     mMarkerNanoTime = nanoTime;
     mState = STATE_STARTING;
+    resetDriftEstimate();
+    mRateScale = 1.0;
+    mDriftEstimate = 1.0;
+    mErrorCount = 0;
+    mErrorSumMicros = 0.0;
+    mErrorSumSquaresMicros = 0.0;
+    mMinErrorNanos = 0;
+    mMaxErrorNanos = 0;
     if (mHistogramMicros) {
         mHistogramMicros->clear();
     }
 }
 
 void IsochronousClockModel::stop(int64_t nanoTime) {
-    ALOGD("stop(nanos = %lld) max lateness = %d micros\n",
+    ALOGD("stop(nanos = %lld) max lateness = %d micros, drift = %.1f ppm\n",
         (long long) nanoTime,
-        (int) (mMaxMeasuredLatenessNanos / 1000));
+        (int) (mMaxMeasuredLatenessNanos / 1000),
+        getDriftPpm());
     setPositionAndTime(convertTimeToPosition(nanoTime), nanoTime);
     // TODO should we set position?
     mState = STATE_STOPPED;
@@ -129,6 +139,8 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
         if (mHistogramMicros) {
             mHistogramMicros->add(latenessNanos / AAUDIO_NANOS_PER_MICROSECOND);
         }
+        updateErrorStatistics(latenessNanos);
+        updateDriftEstimate(framePosition, nanoTime);
         // Modify estimated position based on lateness.
         // This affects the "early" side of the window, which controls output glitches.
         if (latenessNanos < 0) {
@@ -189,6 +201,91 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
     }
 }
 
+void IsochronousClockModel::resetDriftEstimate() {
+    mDriftTimestampCount = 0;
+    mDriftWeight = 0.0;
+    mDriftMeanSeconds = 0.0;
+    mDriftMeanFrames = 0.0;
+    mDriftVarSeconds = 0.0;
+    mDriftVarFrames = 0.0;
+    mDriftCovariance = 0.0;
+}
+
+// The positions are sampled at random times and rounded down to a burst, so they
+// jitter around the true position line by up to a burst. The slope of a linear
+// regression through them gives the real rate of the hardware clock, which is
+// then used to advance the model between the occasional timestamps.
+// The model must not run ahead of the hardware, so the lower bound of the rate is
+// used, and only once it is clearly away from the nominal rate. The heuristics in
+// processTimestamp() still pull the model forwards for what is left.
+void IsochronousClockModel::updateDriftEstimate(int64_t framePosition, int64_t nanoTime) {
+    if (mDriftTimestampCount == 0) {
+        mDriftOriginNanos = nanoTime;
+        mDriftOriginFrames = framePosition;
+    }
+    const double x = (nanoTime - mDriftOriginNanos) / (double) AAUDIO_NANOS_PER_SECOND;
+    const double y = (double) (framePosition - mDriftOriginFrames);
+
+    if (mDriftTimestampCount >= kMinDriftTimestamps && mDriftVarSeconds > 0.0) {
+        const double slope = mDriftCovariance / mDriftVarSeconds;
+        const double predicted = mDriftMeanFrames + slope * (x - mDriftMeanSeconds);
+        if (fabs(y - predicted) > (double) kDriftResetBursts * mFramesPerBurst) {
+            ALOGD("%s() position %lld is %d frames off the regression, restart it",
+                  __func__, (long long) framePosition, (int) (y - predicted));
+            resetDriftEstimate();
+            mRateScale = 1.0;
+            updateDriftEstimate(framePosition, nanoTime);
+            return;
+        }
+    }
+
+    // Exponentially weighted incremental mean and (co)variance.
+    constexpr double kDecay = 1.0 - (1.0 / kDriftWindowSize);
+    mDriftTimestampCount++;
+    mDriftWeight = (mDriftWeight * kDecay) + 1.0;
+    const double dx = x - mDriftMeanSeconds;
+    const double dy = y - mDriftMeanFrames;
+    mDriftMeanSeconds += dx / mDriftWeight;
+    mDriftMeanFrames += dy / mDriftWeight;
+    mDriftVarSeconds = (mDriftVarSeconds * kDecay) + (dx * (x - mDriftMeanSeconds));
+    mDriftVarFrames = (mDriftVarFrames * kDecay) + (dy * (y - mDriftMeanFrames));
+    mDriftCovariance = (mDriftCovariance * kDecay) + (dx * (y - mDriftMeanFrames));
+
+    // Span of timestamps spread evenly with the same variance.
+    const double spanSeconds = sqrt(12.0 * mDriftVarSeconds / mDriftWeight);
+    if (mDriftTimestampCount < kMinDriftTimestamps || spanSeconds < kMinDriftSpanSeconds) {
+        return;
+    }
+    const double slope = mDriftCovariance / mDriftVarSeconds;
+    const double residual = std::max(0.0, mDriftVarFrames - (slope * mDriftCovariance));
+    const double slopeError = sqrt(residual / (mDriftWeight * mDriftVarSeconds));
+    const double rateScale = slope / mSampleRate;
+    const double rateError = kDriftConfidence * slopeError / mSampleRate;
+    if (fabs(rateScale - 1.0) > kMaxDriftRatio) {
+        return;
+    }
+    mDriftEstimate = rateScale;
+    mRateScale = (fabs(rateScale - 1.0) > rateError) ? rateScale - rateError : 1.0;
+#if ICM_LOG_DRIFT
+    ALOGD("%s() - #%d, estimated drift %.1f +- %.1f ppm over %.2f seconds",
+          __func__, mTimestampCount, (rateScale - 1.0) * 1e6, rateError * 1e6, spanSeconds);
+#endif
+}
+
+void IsochronousClockModel::updateErrorStatistics(int64_t latenessNanos) {
+    const double latenessMicros = (double) latenessNanos / AAUDIO_NANOS_PER_MICROSECOND;
+    if (mErrorCount == 0) {
+        mMinErrorNanos = latenessNanos;
+        mMaxErrorNanos = latenessNanos;
+    } else {
+        mMinErrorNanos = std::min(mMinErrorNanos, latenessNanos);
+        mMaxErrorNanos = std::max(mMaxErrorNanos, latenessNanos);
+    }
+    mErrorCount++;
+    mErrorSumMicros += latenessMicros;
+    mErrorSumSquaresMicros += latenessMicros * latenessMicros;
+}
+
 void IsochronousClockModel::setSampleRate(int32_t sampleRate) {
     mSampleRate = sampleRate;
     update();
@@ -205,11 +302,19 @@ void IsochronousClockModel::update() {
 }
 
 int64_t IsochronousClockModel::convertDeltaPositionToTime(int64_t framesDelta) const {
-    return (AAUDIO_NANOS_PER_SECOND * framesDelta) / mSampleRate;
+    if (mRateScale == 1.0) {
+        return (AAUDIO_NANOS_PER_SECOND * framesDelta) / mSampleRate;
+    }
+    return (int64_t) ((AAUDIO_NANOS_PER_SECOND * (double) framesDelta)
+            / (mSampleRate * mRateScale));
 }
 
 int64_t IsochronousClockModel::convertDeltaTimeToPosition(int64_t nanosDelta) const {
-    return (mSampleRate * nanosDelta) / AAUDIO_NANOS_PER_SECOND;
+    if (mRateScale == 1.0) {
+        return (mSampleRate * nanosDelta) / AAUDIO_NANOS_PER_SECOND;
+    }
+    return (int64_t) ((mSampleRate * mRateScale * (double) nanosDelta)
+            / AAUDIO_NANOS_PER_SECOND);
 }
 
 int64_t IsochronousClockModel::convertPositionToTime(int64_t framePosition) const {
@@ -263,6 +368,17 @@ void IsochronousClockModel::dump() const {
     ALOGD("mFramesPerBurst      = %6d", mFramesPerBurst);
     ALOGD("mMaxMeasuredLatenessNanos = %6d", mMaxMeasuredLatenessNanos);
     ALOGD("mState               = %6d", mState);
+    ALOGD("drift                = %8.1f ppm from %d timestamps",
+          getDriftPpm(), mDriftTimestampCount);
+    if (mErrorCount > 0) {
+        const double meanMicros = mErrorSumMicros / mErrorCount;
+        const double rmsMicros = sqrt(mErrorSumSquaresMicros / mErrorCount);
+        ALOGD("timestamp error      = mean %.1f, rms %.1f, min %d, max %d micros, count %d",
+              meanMicros, rmsMicros,
+              (int) (mMinErrorNanos / AAUDIO_NANOS_PER_MICROSECOND),
+              (int) (mMaxErrorNanos / AAUDIO_NANOS_PER_MICROSECOND),
+              mErrorCount);
+    }
 }
 
 void IsochronousClockModel::dumpHistogram() const {
@@ -123,6 +123,14 @@ public:
      */
     int64_t convertDeltaTimeToPosition(int64_t nanosDelta) const;
 
+    /**
+     * @return estimated drift of the hardware clock in parts per million,
+     *         positive if the hardware runs faster than the nominal sample rate
+     */
+    double getDriftPpm() const {
+        return (mDriftEstimate - 1.0) * 1e6;
+    }
+
     void dump() const;
 
     void dumpHistogram() const;
@@ -131,6 +139,9 @@ private:
 
     int32_t getLateTimeOffsetNanos() const;
     void update();
+    void resetDriftEstimate();
+    void updateDriftEstimate(int64_t framePosition, int64_t nanoTime);
+    void updateErrorStatistics(int64_t latenessNanos);
 
     enum clock_model_state_t {
         STATE_STOPPED,
@@ -146,6 +157,23 @@ private:
     // Initial small threshold for causing a drift later in time.
     static constexpr int32_t   kInitialLatenessForDriftNanos = 10 * 1000;
 
+    // The drift of the hardware clock is estimated by a linear regression of the
+    // position over time, weighted to forget the older timestamps.
+    // Number of timestamps the regression remembers, about.
+    static constexpr double    kDriftWindowSize = 128.0;
+    // Timestamps needed, and time they must span, before the estimate is used.
+    // The positions jitter by up to a burst, so a long span is needed for a
+    // good estimate of a drift of a few tens of ppm.
+    static constexpr int32_t   kMinDriftTimestamps = 16;
+    static constexpr double    kMinDriftSpanSeconds = 2.0;
+    // Estimates further than this from the nominal rate are not believed.
+    static constexpr double    kMaxDriftRatio = 0.005;
+    // Standard errors of the estimate subtracted from the rate that is used.
+    static constexpr double    kDriftConfidence = 5.0;
+    // A timestamp this many bursts away from the regression restarts it,
+    // e.g. after a discontinuity in the position.
+    static constexpr int32_t   kDriftResetBursts = 16;
+
     static constexpr int32_t   kHistogramBinWidthMicros = 50;
     static constexpr int32_t   kHistogramBinCount = 128;
 
@@ -162,6 +190,30 @@ private:
 
     int32_t             mTimestampCount = 0;  // For logging.
 
+    // Ratio of the estimated hardware rate to mSampleRate, 1.0 until estimated.
+    double              mDriftEstimate{1.0};
+    // Lower bound of mDriftEstimate used for the conversions, or 1.0 when the
+    // drift is within the error of the estimate.
+    double              mRateScale{1.0};
+    // Exponentially weighted linear regression of the position over time,
+    // relative to the first timestamp since it was reset.
+    int32_t             mDriftTimestampCount{0};
+    int64_t             mDriftOriginNanos{0};
+    int64_t             mDriftOriginFrames{0};
+    double              mDriftWeight{0.0};
+    double              mDriftMeanSeconds{0.0};
+    double              mDriftMeanFrames{0.0};
+    double              mDriftVarSeconds{0.0};    // weighted sums of squares
+    double              mDriftVarFrames{0.0};
+    double              mDriftCovariance{0.0};
+
+    // Difference between each timestamp and the model while running.
+    int32_t             mErrorCount{0};
+    double              mErrorSumMicros{0.0};
+    double              mErrorSumSquaresMicros{0.0};
+    int64_t             mMinErrorNanos{0};
+    int64_t             mMaxErrorNanos{0};
+
     // distribution of timestamps relative to earliest
     std::unique_ptr<android::audio_utils::Histogram>   mHistogramMicros;
 
@@ -112,65 +112,57 @@ fifo_frames_t FifoBuffer::getEmptyRoomAvailable(WrappingBuffer *wrappingBuffer)
     return framesAvailable;
 }
 
+fifo_frames_t FifoBuffer::acquireRead(WrappingBuffer *wrappingBuffer, fifo_frames_t numFrames) {
+    // The FIFO might be overfull so clip to capacity.
+    fifo_frames_t framesAvailable = std::min(mFifo->getFullFramesAvailable(),
+                                             mFifo->getCapacity());
+    framesAvailable = std::max(0, std::min(framesAvailable, numFrames));
+    fillWrappingBuffer(wrappingBuffer, framesAvailable, mFifo->getReadIndex());
+    return framesAvailable;
+}
+
+fifo_frames_t FifoBuffer::acquireWrite(WrappingBuffer *wrappingBuffer, fifo_frames_t numFrames) {
+    // The FIFO might have underrun so clip to capacity.
+    fifo_frames_t framesAvailable = std::min(mFifo->getEmptyFramesAvailable(),
+                                             mFifo->getCapacity());
+    framesAvailable = std::max(0, std::min(framesAvailable, numFrames));
+    fillWrappingBuffer(wrappingBuffer, framesAvailable, mFifo->getWriteIndex());
+    return framesAvailable;
+}
+
 fifo_frames_t FifoBuffer::read(void *buffer, fifo_frames_t numFrames) {
     WrappingBuffer wrappingBuffer;
     uint8_t *destination = (uint8_t *) buffer;
-    fifo_frames_t framesLeft = numFrames;
 
-    getFullDataAvailable(&wrappingBuffer);
+    fifo_frames_t framesRead = acquireRead(&wrappingBuffer, numFrames);
 
     // Read data in one or two parts.
-    int partIndex = 0;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToRead = framesLeft;
-        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailable > 0) {
-            if (framesToRead > framesAvailable) {
-                framesToRead = framesAvailable;
-            }
-            int32_t numBytes = convertFramesToBytes(framesToRead);
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        int32_t numBytes = convertFramesToBytes(wrappingBuffer.numFrames[partIndex]);
+        if (numBytes > 0) {
             memcpy(destination, wrappingBuffer.data[partIndex], numBytes);
-
             destination += numBytes;
-            framesLeft -= framesToRead;
-        } else {
-            break;
         }
-        partIndex++;
     }
-    fifo_frames_t framesRead = numFrames - framesLeft;
-    mFifo->advanceReadIndex(framesRead);
+    commitRead(framesRead);
     return framesRead;
 }
 
 fifo_frames_t FifoBuffer::write(const void *buffer, fifo_frames_t numFrames) {
     WrappingBuffer wrappingBuffer;
     uint8_t *source = (uint8_t *) buffer;
-    fifo_frames_t framesLeft = numFrames;
 
-    getEmptyRoomAvailable(&wrappingBuffer);
+    fifo_frames_t framesWritten = acquireWrite(&wrappingBuffer, numFrames);
 
-    // Read data in one or two parts.
-    int partIndex = 0;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToWrite = framesLeft;
-        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailable > 0) {
-            if (framesToWrite > framesAvailable) {
-                framesToWrite = framesAvailable;
-            }
-            int32_t numBytes = convertFramesToBytes(framesToWrite);
+    // Write data in one or two parts.
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        int32_t numBytes = convertFramesToBytes(wrappingBuffer.numFrames[partIndex]);
+        if (numBytes > 0) {
             memcpy(wrappingBuffer.data[partIndex], source, numBytes);
-
             source += numBytes;
-            framesLeft -= framesToWrite;
-        } else {
-            break;
         }
-        partIndex++;
     }
-    fifo_frames_t framesWritten = numFrames - framesLeft;
-    mFifo->advanceWriteIndex(framesWritten);
+    commitWrite(framesWritten);
     return framesWritten;
 }
 
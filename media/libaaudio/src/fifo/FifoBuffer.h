@@ -72,6 +72,44 @@ public:
      */
     fifo_frames_t getEmptyRoomAvailable(WrappingBuffer *wrappingBuffer);
 
+    /**
+     * Acquire up to numFrames of full frames so they can be consumed in place,
+     * without copying them out of the FIFO.
+     * The frames are returned in one or two contiguous parts, as for getFullDataAvailable().
+     * Call commitRead() when done.
+     * @param wrappingBuffer
+     * @param numFrames maximum number of frames to acquire
+     * @return total frames acquired, never negative
+     */
+    fifo_frames_t acquireRead(WrappingBuffer *wrappingBuffer, fifo_frames_t numFrames);
+
+    /**
+     * Release frames acquired by acquireRead() back to the writer.
+     * @param numFrames number of frames consumed
+     */
+    void commitRead(fifo_frames_t numFrames) {
+        mFifo->advanceReadIndex(numFrames);
+    }
+
+    /**
+     * Acquire up to numFrames of empty room so it can be rendered in place,
+     * without copying through a temporary buffer.
+     * The room is returned in one or two contiguous parts, as for getEmptyRoomAvailable().
+     * Call commitWrite() when done.
+     * @param wrappingBuffer
+     * @param numFrames maximum number of frames to acquire
+     * @return total frames acquired, never negative
+     */
+    fifo_frames_t acquireWrite(WrappingBuffer *wrappingBuffer, fifo_frames_t numFrames);
+
+    /**
+     * Publish frames rendered into room acquired by acquireWrite() to the reader.
+     * @param numFrames number of frames rendered
+     */
+    void commitWrite(fifo_frames_t numFrames) {
+        mFifo->advanceWriteIndex(numFrames);
+    }
+
     int32_t getBytesPerFrame() {
         return mBytesPerFrame;
     }
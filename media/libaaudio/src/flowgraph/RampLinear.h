@@ -74,6 +74,22 @@ public:
         mLevelTo = level;
     }
 
+    /**
+     * @return true if the ramp has been used and is not ramping, so the next
+     *         frames will be scaled by getLevel()
+     */
+    bool isSteady() const {
+        return mLastCallCount != kInitialCallCount && mRemaining == 0
+                && mTarget.load() == mLevelTo;
+    }
+
+    /**
+     * @return the level reached at the end of the current ramp
+     */
+    float getLevel() const {
+        return mLevelTo;
+    }
+
     const char *getName() override {
         return "RampLinear";
     }
@@ -16,6 +16,12 @@
 
 #include <math.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "IntegerRatio.h"
 #include "LinearResampler.h"
 #include "MultiChannelResampler.h"
@@ -119,6 +125,91 @@ void MultiChannelResampler::writeFrame(const float *frame) {
     }
 }
 
+void MultiChannelResampler::filterFrame(const float *xFrame, const float *coefficients,
+                                        int32_t numTaps, int32_t channelCount, float *frame) {
+    const size_t stride = static_cast<size_t>(channelCount);
+    int32_t channel = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; channel + 4 <= channelCount; channel += 4) {
+        const float *x = xFrame + channel;
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            sum = vmlaq_n_f32(sum, vld1q_f32(x), coefficients[tap]);
+            x += stride;
+        }
+        vst1q_f32(frame + channel, sum);
+    }
+#elif defined(__SSE2__)
+    for (; channel + 4 <= channelCount; channel += 4) {
+        const float *x = xFrame + channel;
+        __m128 sum = _mm_setzero_ps();
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x), _mm_set1_ps(coefficients[tap])));
+            x += stride;
+        }
+        _mm_storeu_ps(frame + channel, sum);
+    }
+#endif
+    for (; channel < channelCount; channel++) {
+        const float *x = xFrame + channel;
+        float sum = 0.0f;
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            sum += *x * coefficients[tap];
+            x += stride;
+        }
+        frame[channel] = sum;
+    }
+}
+
+void MultiChannelResampler::filterFrame2(const float *xFrame,
+                                         const float *coefficients1, const float *coefficients2,
+                                         int32_t numTaps, int32_t channelCount,
+                                         float *frame1, float *frame2) {
+    const size_t stride = static_cast<size_t>(channelCount);
+    int32_t channel = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; channel + 4 <= channelCount; channel += 4) {
+        const float *x = xFrame + channel;
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        float32x4_t sum2 = vdupq_n_f32(0.0f);
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            const float32x4_t samples = vld1q_f32(x);
+            sum1 = vmlaq_n_f32(sum1, samples, coefficients1[tap]);
+            sum2 = vmlaq_n_f32(sum2, samples, coefficients2[tap]);
+            x += stride;
+        }
+        vst1q_f32(frame1 + channel, sum1);
+        vst1q_f32(frame2 + channel, sum2);
+    }
+#elif defined(__SSE2__)
+    for (; channel + 4 <= channelCount; channel += 4) {
+        const float *x = xFrame + channel;
+        __m128 sum1 = _mm_setzero_ps();
+        __m128 sum2 = _mm_setzero_ps();
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            const __m128 samples = _mm_loadu_ps(x);
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(samples, _mm_set1_ps(coefficients1[tap])));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(samples, _mm_set1_ps(coefficients2[tap])));
+            x += stride;
+        }
+        _mm_storeu_ps(frame1 + channel, sum1);
+        _mm_storeu_ps(frame2 + channel, sum2);
+    }
+#endif
+    for (; channel < channelCount; channel++) {
+        const float *x = xFrame + channel;
+        float sum1 = 0.0f;
+        float sum2 = 0.0f;
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            sum1 += *x * coefficients1[tap];
+            sum2 += *x * coefficients2[tap];
+            x += stride;
+        }
+        frame1[channel] = sum1;
+        frame2[channel] = sum2;
+    }
+}
+
 float MultiChannelResampler::sinc(float radians) {
     if (abs(radians) < 1.0e-9) return 1.0f;   // avoid divide by zero
     return sinf(radians) / radians;   // Sinc function
@@ -244,6 +244,28 @@ protected:
         return mIntegerPhase;
     }
 
+    /**
+     * Multiply numTaps frames of delayed input by one coefficient per frame
+     * and sum them into a single frame.
+     * Uses NEON or SSE for four channels at a time, so any channel count is accelerated.
+     *
+     * @param xFrame first delayed input frame
+     * @param coefficients numTaps coefficients
+     * @param numTaps number of frames and coefficients
+     * @param channelCount number of samples per frame
+     * @param frame output frame
+     */
+    static void filterFrame(const float *xFrame, const float *coefficients,
+                            int32_t numTaps, int32_t channelCount, float *frame);
+
+    /**
+     * Same as filterFrame() for two sets of coefficients applied to the same input.
+     */
+    static void filterFrame2(const float *xFrame,
+                             const float *coefficients1, const float *coefficients2,
+                             int32_t numTaps, int32_t channelCount,
+                             float *frame1, float *frame2);
+
     static constexpr int kMaxCoefficients = 8 * 1024;
     std::vector<float>   mCoefficients;
 
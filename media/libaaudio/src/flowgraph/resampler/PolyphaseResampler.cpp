@@ -37,24 +37,12 @@ PolyphaseResampler::PolyphaseResampler(const MultiChannelResampler::Builder &bui
 }
 
 void PolyphaseResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-
-    // Multiply input times windowed sinc function.
-    float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient = *coefficients++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            mSingleFrame[channel] += *xFrame++ * coefficient;
-        }
-    }
+    // Multiply input times windowed sinc function, directly into the output.
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame =
+            &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
+    filterFrame(xFrame, coefficients, mNumTaps, getChannelCount(), frame);
 
     // Advance and wrap through coefficients.
     mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
-
-    // Copy accumulator to output.
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        frame[channel] = mSingleFrame[channel];
-    }
 }
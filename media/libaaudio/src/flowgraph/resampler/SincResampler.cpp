@@ -35,10 +35,6 @@ SincResampler::SincResampler(const MultiChannelResampler::Builder &builder)
 }
 
 void SincResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-    std::fill(mSingleFrame2.begin(), mSingleFrame2.end(), 0.0);
-
     // Determine indices into coefficients table.
     double tablePhase = getIntegerPhase() * mPhaseScaler;
     int index1 = static_cast<int>(floor(tablePhase));
@@ -58,15 +54,8 @@ void SincResampler::readFrame(float *frame) {
             * static_cast<size_t>(getNumTaps())];
 
     float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient1 = *coefficients1++;
-        float coefficient2 = *coefficients2++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            float sample = *xFrame++;
-            mSingleFrame[channel] +=  sample * coefficient1;
-            mSingleFrame2[channel] += sample * coefficient2;
-        }
-    }
+    filterFrame2(xFrame, coefficients1, coefficients2, mNumTaps, getChannelCount(),
+                 mSingleFrame.data(), mSingleFrame2.data());
 
     // Interpolate and copy to output.
     float fraction = tablePhase - index1;
@@ -225,6 +225,14 @@ void AudioStreamLegacy::forceDisconnect(bool errorCallbackEnabled) {
     }
 }
 
+void AudioStreamLegacy::logBlockAdapterStats() const {
+    if (mBlockAdapter == nullptr) return;
+    const int64_t passedThrough = mBlockAdapter->getBytesPassedThrough();
+    const int64_t copied = mBlockAdapter->getBytesCopied();
+    ALOGD("%s() framesPerCallback = %d, %lld bytes passed through, %lld bytes copied",
+          __func__, mCallbackBufferSize, (long long) passedThrough, (long long) copied);
+}
+
 aaudio_result_t AudioStreamLegacy::getBestTimestamp(clockid_t clockId,
                                                    int64_t *framePosition,
                                                    int64_t *timeNanoseconds,
@@ -106,6 +106,9 @@ protected:
 
     void forceDisconnect(bool errorCallbackEnabled = true);
 
+    // Logs how much of the callback data went through the storage of the block adapter.
+    void logBlockAdapterStats() const;
+
     int64_t incrementFramesWritten(int32_t frames) {
         return mFramesWritten.increment(frames);
     }
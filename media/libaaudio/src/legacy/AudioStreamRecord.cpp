@@ -110,6 +110,14 @@ aaudio_result_t AudioStreamRecord::open(const AudioStreamBuilder& builder)
         callback = sp<AudioRecord::IAudioRecordCallback>::fromExisting(this);
     }
     mCallbackBufferSize = builder.getFramesPerDataCallback();
+    if (builder.getDataCallbackProc() != nullptr && mCallbackBufferSize > 0) {
+        // Ask for callbacks of the app's size, in a buffer that is a multiple of it,
+        // so that the block adapter writes straight from the record buffer instead of
+        // going through its storage.
+        notificationFrames = mCallbackBufferSize;
+        frameCount = (frameCount + mCallbackBufferSize - 1)
+                / mCallbackBufferSize * mCallbackBufferSize;
+    }
 
     // Don't call mAudioRecord->setInputDevice() because it will be overwritten by set()!
     audio_port_handle_t selectedDeviceId = (getDeviceId() == AAUDIO_UNSPECIFIED)
@@ -303,6 +311,7 @@ void AudioStreamRecord::close_l() {
     mStreamLock.lock();
 
     mAudioRecord.clear();
+    logBlockAdapterStats();
     // Do not close mFixedBlockReader. It has a unique_ptr to its buffer
     // so it will clean up by itself.
     AudioStream::close_l();
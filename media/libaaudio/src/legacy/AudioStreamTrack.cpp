@@ -119,6 +119,15 @@ aaudio_result_t AudioStreamTrack::open(const AudioStreamBuilder& builder)
         }
     }
     mCallbackBufferSize = builder.getFramesPerDataCallback();
+    if (builder.getDataCallbackProc() != nullptr && mCallbackBufferSize > 0
+            && notificationFrames == 0) {
+        // Ask for callbacks of the app's size, in a buffer that is a multiple of it,
+        // so that the block adapter reads straight into the track buffer instead of
+        // going through its storage.
+        notificationFrames = mCallbackBufferSize;
+        frameCount = (frameCount + mCallbackBufferSize - 1)
+                / mCallbackBufferSize * mCallbackBufferSize;
+    }
 
     ALOGD("open(), request notificationFrames = %d, frameCount = %u",
           notificationFrames, (uint)frameCount);
@@ -285,6 +294,7 @@ void AudioStreamTrack::close_l() {
     mAudioTrack->stopAndJoinCallbacks();
     mStreamLock.lock();
     mAudioTrack.clear();
+    logBlockAdapterStats();
     // Do not close mFixedBlockReader. It has a unique_ptr to its buffer
     // so it will clean up by itself.
     AudioStream::close_l();
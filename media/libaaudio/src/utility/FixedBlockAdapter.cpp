@@ -23,6 +23,8 @@ int32_t FixedBlockAdapter::open(int32_t bytesPerFixedBlock)
     mSize = bytesPerFixedBlock;
     mStorage = std::make_unique<uint8_t[]>(bytesPerFixedBlock);
     mPosition = 0;
+    mBytesPassedThrough = 0;
+    mBytesCopied = 0;
     return 0;
 }
 
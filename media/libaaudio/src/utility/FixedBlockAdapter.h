@@ -62,11 +62,23 @@ public:
      */
     int32_t close();
 
+    /**
+     * @return bytes that went straight between the variable-sized blocks and the processor
+     */
+    int64_t getBytesPassedThrough() const { return mBytesPassedThrough; }
+
+    /**
+     * @return bytes that were copied through the internal storage
+     */
+    int64_t getBytesCopied() const { return mBytesCopied; }
+
 protected:
     FixedBlockProcessor  &mFixedBlockProcessor;
     std::unique_ptr<uint8_t[]> mStorage;         // Store data here while assembling buffers.
     int32_t               mSize = 0;             // Size in bytes of the fixed size buffer.
     int32_t               mPosition = 0;         // Offset of the last byte read or written.
+    int64_t               mBytesPassedThrough = 0;
+    int64_t               mBytesCopied = 0;
 };
 
 #endif /* AAUDIO_FIXED_BLOCK_ADAPTER_H */
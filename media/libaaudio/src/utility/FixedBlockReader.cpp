@@ -41,6 +41,7 @@ int32_t FixedBlockReader::readFromStorage(uint8_t *buffer, int32_t numBytes) {
     }
     memcpy(buffer, &mStorage[mPosition], bytesToRead);
     mPosition += bytesToRead;
+    mBytesCopied += bytesToRead;
     return bytesToRead;
 }
 
@@ -58,6 +59,7 @@ int32_t FixedBlockReader::processVariableBlock(uint8_t *buffer, int32_t numBytes
             result = mFixedBlockProcessor.onProcessFixedBlock(buffer, mSize);
             buffer += mSize;
             bytesLeft -= mSize;
+            mBytesPassedThrough += mSize;
         } else {
             // Just need a partial block so we have to use storage.
             result = mFixedBlockProcessor.onProcessFixedBlock(mStorage.get(), mSize);
@@ -32,6 +32,7 @@ int32_t FixedBlockWriter::writeToStorage(uint8_t *buffer, int32_t numBytes) {
     }
     memcpy(&mStorage[mPosition], buffer, bytesToStore);
     mPosition += bytesToStore;
+    mBytesCopied += bytesToStore;
     return bytesToStore;
 }
 
@@ -52,10 +53,12 @@ int32_t FixedBlockWriter::processVariableBlock(uint8_t *buffer, int32_t numBytes
     }
 
     // Write through if enough for a complete block.
-    while(bytesLeft > mSize && result == 0) {
+    // An exact block is written through too, rather than held in storage until the next call.
+    while(bytesLeft >= mSize && result == 0) {
         result = mFixedBlockProcessor.onProcessFixedBlock(buffer, mSize);
         buffer += mSize;
         bytesLeft -= mSize;
+        mBytesPassedThrough += mSize;
     }
 
     // Save any remaining partial block for next time.
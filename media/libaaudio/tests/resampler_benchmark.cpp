@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark the flowgraph MultiChannelResampler for each quality level
+// and several channel counts. Results are reported as ns per output frame.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "flowgraph/resampler/MultiChannelResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+static constexpr int32_t kOutputFrames = 960;
+
+// state.range(0) is the quality, state.range(1) the channel count,
+// state.range(2) the input rate and state.range(3) the output rate.
+static void BM_Resampler(benchmark::State& state) {
+    const auto quality = (MultiChannelResampler::Quality) state.range(0);
+    const int32_t channelCount = state.range(1);
+    const int32_t inputRate = state.range(2);
+    const int32_t outputRate = state.range(3);
+
+    std::unique_ptr<MultiChannelResampler> resampler(
+            MultiChannelResampler::make(channelCount, inputRate, outputRate, quality));
+    std::vector<float> input(channelCount);
+    std::vector<float> output(static_cast<size_t>(kOutputFrames) * channelCount);
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        input[channel] = 0.01f * (channel + 1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        float *out = output.data();
+        for (int32_t frame = 0; frame < kOutputFrames; frame++) {
+            while (resampler->isWriteNeeded()) {
+                resampler->writeNextFrame(input.data());
+            }
+            resampler->readNextFrame(out);
+            out += channelCount;
+        }
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+    state.counters["ns_per_frame"] = elapsedNs / (state.iterations() * kOutputFrames);
+    state.SetItemsProcessed(state.iterations() * kOutputFrames);
+}
+
+static void ResamplerArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"quality", "channels", "in", "out"});
+    for (int quality : {(int) MultiChannelResampler::Quality::Fastest,
+                        (int) MultiChannelResampler::Quality::Low,
+                        (int) MultiChannelResampler::Quality::Medium,
+                        (int) MultiChannelResampler::Quality::High,
+                        (int) MultiChannelResampler::Quality::Best}) {
+        for (int channels : {1, 2, 4, 6, 8}) {
+            b->Args({quality, channels, 44100, 48000});
+            b->Args({quality, channels, 48000, 44100});
+        }
+    }
+}
+
+BENCHMARK(BM_Resampler)->Apply(ResamplerArgs);
+
+BENCHMARK_MAIN();
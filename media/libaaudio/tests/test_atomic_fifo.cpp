@@ -296,6 +296,45 @@ public:
         verifyStorageIntegrity();
     }
 
+    // Render and consume data in place, across the end of the buffer.
+    void checkAcquireCommit() {
+        const fifo_frames_t capacity = mFifoBuffer.getBufferCapacityInFrames();
+        const fifo_frames_t frames1 = capacity - 4;
+        const fifo_frames_t frames2 = 9; // arbitrary, wraps
+        for (fifo_frames_t numFrames : {frames1, frames2}) {
+            WrappingBuffer wrappingBuffer;
+            fifo_frames_t acquired = mFifoBuffer.acquireWrite(&wrappingBuffer, numFrames);
+            ASSERT_EQ(numFrames, acquired);
+            ASSERT_EQ(acquired, wrappingBuffer.numFrames[0] + wrappingBuffer.numFrames[1]);
+            for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+                int16_t *data = (int16_t *) wrappingBuffer.data[partIndex];
+                for (fifo_frames_t i = 0; i < wrappingBuffer.numFrames[partIndex]; i++) {
+                    data[i] = mNextWriteIndex++;
+                }
+            }
+            // Nothing is visible to the reader before the commit.
+            ASSERT_EQ(0, mFifoBuffer.getFullFramesAvailable());
+            mFifoBuffer.commitWrite(acquired);
+            verifyWrappingBuffer();
+
+            // Asking for more than is available only acquires what is there.
+            acquired = mFifoBuffer.acquireRead(&wrappingBuffer, capacity);
+            ASSERT_EQ(numFrames, acquired);
+            for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+                int16_t *data = (int16_t *) wrappingBuffer.data[partIndex];
+                for (fifo_frames_t i = 0; i < wrappingBuffer.numFrames[partIndex]; i++) {
+                    ASSERT_EQ(mNextVerifyIndex++, data[i]);
+                }
+            }
+            mFifoBuffer.commitRead(acquired);
+            ASSERT_EQ(0, mFifoBuffer.getFullFramesAvailable());
+            ASSERT_EQ(0, mFifoBuffer.acquireRead(&wrappingBuffer, numFrames));
+        }
+        ASSERT_LT(mFifoBuffer.getWriteCounter() % capacity, frames2); // did we wrap?
+
+        verifyStorageIntegrity();
+    }
+
     // Write and Read a specific amount of data.
     void checkNegativeCounters() {
         fifo_counter_t counter = -9876;
@@ -370,6 +409,12 @@ TEST(test_fifo_buffer, fifo_random_threshold) {
     tester.checkRandomWriteRead();
 }
 
+TEST(test_fifo_buffer, fifo_acquire_commit) {
+    constexpr int capacity = 53; // arbitrary
+    TestFifoBuffer tester(capacity);
+    tester.checkAcquireCommit();
+}
+
 TEST(test_fifo_buffer, fifo_negative_counters) {
     constexpr int capacity = 49; // arbitrary
     TestFifoBuffer tester(capacity);
@@ -83,6 +83,8 @@ public:
         return mFixedBlockWriter.processVariableBlock((uint8_t *) mTestBuffer, sizeBytes);
     }
 
+    const FixedBlockAdapter &getAdapter() const { return mFixedBlockWriter; }
+
 private:
     FixedBlockWriter mFixedBlockWriter;
 };
@@ -114,6 +116,8 @@ public:
         return result;
     }
 
+    const FixedBlockAdapter &getAdapter() const { return mFixedBlockReader; }
+
 private:
     FixedBlockReader   mFixedBlockReader;
 };
@@ -149,3 +153,28 @@ TEST(test_block_adapter, block_adapter_read) {
     ASSERT_EQ(0, result);
 };
 
+// Variable-sized blocks that are multiples of the fixed size never go through the storage.
+TEST(test_block_adapter, block_adapter_write_aligned) {
+    TestBlockWriter tester;
+    int64_t totalFrames = 0;
+    for (int i = 0; i < 1000; i++) {
+        int32_t size = FIXED_BLOCK_SIZE * (1 + random() % (TEST_BUFFER_SIZE / FIXED_BLOCK_SIZE));
+        ASSERT_EQ(0, tester.testInputWrite(size));
+        totalFrames += size;
+    }
+    EXPECT_EQ(totalFrames, tester.mTestIndex); // every frame was delivered
+    EXPECT_EQ(0, tester.getAdapter().getBytesCopied());
+    EXPECT_EQ(totalFrames * (int64_t) sizeof(int32_t), tester.getAdapter().getBytesPassedThrough());
+}
+
+TEST(test_block_adapter, block_adapter_read_aligned) {
+    TestBlockReader tester;
+    int64_t totalFrames = 0;
+    for (int i = 0; i < 1000; i++) {
+        int32_t size = FIXED_BLOCK_SIZE * (1 + random() % (TEST_BUFFER_SIZE / FIXED_BLOCK_SIZE));
+        ASSERT_EQ(0, tester.testOutputRead(size));
+        totalFrames += size;
+    }
+    EXPECT_EQ(0, tester.getAdapter().getBytesCopied());
+    EXPECT_EQ(totalFrames * (int64_t) sizeof(int32_t), tester.getAdapter().getBytesPassedThrough());
+}
@@ -163,4 +163,13 @@ TEST_F(ClockModelTestFixture, clock_slow_drift) {
 
 TEST_F(ClockModelTestFixture, clock_fast_drift) {
     checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
-}
\ No newline at end of file
+}
+
+// The estimated drift should converge on the rate of the simulated hardware.
+TEST_F(ClockModelTestFixture, clock_drift_estimate) {
+    checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
+    EXPECT_NEAR(2000.0, model.getDriftPpm(), 200.0);
+
+    checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT);
+    EXPECT_NEAR(0.0, model.getDriftPpm(), 200.0);
+}
@@ -25,6 +25,7 @@
 
 #include <gtest/gtest.h>
 
+#include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
 #include "flowgraph/MonoBlend.h"
 #include "flowgraph/MonoToMultiConverter.h"
@@ -319,3 +320,68 @@ TEST(test_flowgraph, module_mono_blend) {
     }
 }
 
+
+// AAudioFlowGraph runs steady chains in a fused loop, and the node graph while ramping.
+TEST(test_flowgraph, aaudio_flowgraph_fused_volume) {
+    constexpr int numChannels = 2;
+    constexpr int numFrames = 8;
+    constexpr int rampSize = 4;
+    constexpr float volume = 0.5f;
+    constexpr float finalVolume = 0.25f;
+    static const int16_t input[numChannels * numFrames] = {
+            INT16_MAX, INT16_MIN, 1 << 14, -(1 << 14), 1 << 13, 0, -1, 1,
+            100, -100, 1000, -1000, 10000, -10000, 20000, -20000};
+    float output[numChannels * numFrames];
+    AAudioFlowGraph flowGraph;
+
+    ASSERT_EQ(AAUDIO_OK, flowGraph.configure(AUDIO_FORMAT_PCM_16_BIT, numChannels,
+            AUDIO_FORMAT_PCM_FLOAT, numChannels, false /* useMonoBlend */,
+            0.0f /* audioBalance */, true /* isExclusive */));
+    flowGraph.setRampLengthInFrames(rampSize);
+    flowGraph.setTargetVolume(volume);
+
+    // The first call runs the graph, the following ones are fused.
+    constexpr float tolerance = 0.000001f; // arbitrary
+    for (int pass = 0; pass < 2; pass++) {
+        flowGraph.process(input, output, numFrames);
+        for (int i = 0; i < numChannels * numFrames; i++) {
+            EXPECT_NEAR(input[i] * (1.0f / 32768) * volume, output[i], tolerance);
+        }
+    }
+
+    // Ramp through the graph, then continue fused at the final volume.
+    flowGraph.setTargetVolume(finalVolume);
+    flowGraph.process(input, output, numFrames);
+    const float incrementSize = (finalVolume - volume) / rampSize;
+    for (int i = 0; i < numChannels * numFrames; i++) {
+        const int frame = i / numChannels;
+        const float level = frame < rampSize ? volume + frame * incrementSize : finalVolume;
+        EXPECT_NEAR(input[i] * (1.0f / 32768) * level, output[i], tolerance);
+    }
+    flowGraph.process(input, output, numFrames);
+    for (int i = 0; i < numChannels * numFrames; i++) {
+        EXPECT_NEAR(input[i] * (1.0f / 32768) * finalVolume, output[i], tolerance);
+    }
+}
+
+TEST(test_flowgraph, aaudio_flowgraph_fused_mono_to_stereo_clip) {
+    constexpr int numChannels = 2;
+    static const float input[] = {0.5f, -0.25f, 53.9f, -87.2f};
+    constexpr int numFrames = sizeof(input) / sizeof(input[0]);
+    float output[numChannels * numFrames];
+    AAudioFlowGraph flowGraph;
+
+    ASSERT_EQ(AAUDIO_OK, flowGraph.configure(AUDIO_FORMAT_PCM_FLOAT, 1 /* sourceChannelCount */,
+            AUDIO_FORMAT_PCM_FLOAT, numChannels, false /* useMonoBlend */,
+            0.0f /* audioBalance */, false /* isExclusive */));
+    flowGraph.process(input, output, numFrames);
+
+    constexpr float tolerance = 0.000001f; // arbitrary
+    for (int i = 0; i < numFrames; i++) {
+        const float expected = std::min(kDefaultMaxHeadroom,
+                std::max(kDefaultMinHeadroom, input[i]));
+        for (int ch = 0; ch < numChannels; ch++) {
+            EXPECT_NEAR(expected, output[i * numChannels + ch], tolerance);
+        }
+    }
+}
@@ -29,6 +29,7 @@
 #include <binder/Binder.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
+#include <cutils/properties.h>
 #include <media/AudioRecord.h>
 #include <utils/Log.h>
 #include <private/media/AudioTrackShared.h>
@@ -838,6 +839,12 @@ status_t AudioRecord::dump(int fd, const Vector<String16>& args __unused) const
              mNotificationFramesAct, mNotificationFramesReq);
     result.appendFormat("  input(%d), latency(%u), selected device Id(%d), routed device Id(%d)\n",
                         mInput, mLatency, mSelectedDeviceId, mRoutedDeviceId);
+    if (mProxy != nullptr) {
+        result.appendFormat("  spin budget(%lld ns), spin wakes(%llu), futex waits(%llu)\n",
+                (long long) mProxy->getSpinBudgetNs(),
+                (unsigned long long) mProxy->getSpinWakeCount(),
+                (unsigned long long) mProxy->getFutexWaitCount());
+    }
     result.appendFormat("  mic direction(%d) mic field dimension(%f)",
                         mSelectedMicDirection, mSelectedMicFieldDimension);
     ::write(fd, result.string(), result.size());
@@ -1071,6 +1078,11 @@ status_t AudioRecord::createRecord_l(const Modulo<uint32_t> &epoch)
     mProxy = new AudioRecordClientProxy(cblk, buffers, mFrameCount, mServerFrameSize);
     mProxy->setEpoch(epoch);
     mProxy->setMinimum(mNotificationFramesAct);
+    // Opt-in spinning before sleeping in a blocking obtainBuffer(), for low latency records.
+    if (mFlags & AUDIO_INPUT_FLAG_FAST) {
+        mProxy->setAdaptiveSpin(
+                property_get_int64("audio.client.adaptive_spin_max_us", 0) * 1000);
+    }
 
     mDeathNotifier = new DeathNotifier(this);
     IInterface::asBinder(mAudioRecord)->linkToDeath(mDeathNotifier, this);
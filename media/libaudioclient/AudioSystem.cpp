@@ -215,6 +215,8 @@ status_t AudioSystem::setStreamVolume(audio_stream_type_t stream, float value,
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     af->setStreamVolume(stream, value, output);
+    // AudioFlinger does not bump the policy state generation.
+    gQueryCache.clear();
     return NO_ERROR;
 }
 
@@ -223,15 +225,21 @@ status_t AudioSystem::setStreamMute(audio_stream_type_t stream, bool mute) {
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     af->setStreamMute(stream, mute);
+    gQueryCache.clear();
     return NO_ERROR;
 }
 
 status_t AudioSystem::getStreamVolume(audio_stream_type_t stream, float* volume,
                                       audio_io_handle_t output) {
     if (uint32_t(stream) >= AUDIO_STREAM_CNT) return BAD_VALUE;
+    if (gQueryCache.getStreamVolume(stream, output, volume)) {
+        return NO_ERROR;
+    }
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
+    const uint64_t generation = gQueryCache.generation();
     *volume = af->streamVolume(stream, output);
+    gQueryCache.putStreamVolume(generation, stream, output, *volume);
     return NO_ERROR;
 }
 
@@ -533,6 +541,7 @@ void AudioSystem::AudioFlingerClient::binderDied(const wp<IBinder>& who __unused
 
     // clear output handles and stream to output map caches
     clearIoCache();
+    gQueryCache.clear();
 
     reportError(DEAD_OBJECT);
 
@@ -840,6 +849,7 @@ status_t AudioSystem::AudioFlingerClient::removeSupportedLatencyModesCallback(
 // protected by gLockAPS
 sp<IAudioPolicyService> AudioSystem::gAudioPolicyService;
 sp<AudioSystem::AudioPolicyServiceClient> AudioSystem::gAudioPolicyServiceClient;
+AudioSystem::QueryCache AudioSystem::gQueryCache;
 
 
 // establish binder interface to AudioPolicy service
@@ -875,6 +885,11 @@ const sp<IAudioPolicyService> AudioSystem::get_audio_policy_service() {
         ap->registerClient(apc);
         ap->setAudioPortCallbacksEnabled(apc->isAudioPortCbEnabled());
         ap->setAudioVolumeGroupCallbacksEnabled(apc->isAudioVolumeGroupCbEnabled());
+        std::optional<media::SharedFileRegion> generation;
+        if (ap->getStateGeneration(&generation).isOk()) {
+            gQueryCache.setGenerationMemory(
+                    aidl2legacy_NullableSharedFileRegion_IMemory(generation).value_or(nullptr));
+        }
         IPCThreadState::self()->restoreCallingIdentity(token);
     }
 
@@ -882,8 +897,134 @@ const sp<IAudioPolicyService> AudioSystem::get_audio_policy_service() {
 }
 
 void AudioSystem::clearAudioPolicyService() {
-    Mutex::Autolock _l(gLockAPS);
-    gAudioPolicyService.clear();
+    {
+        Mutex::Autolock _l(gLockAPS);
+        gAudioPolicyService.clear();
+    }
+    gQueryCache.setGenerationMemory(nullptr);
+}
+
+// ---------------------------------------------------------------------------
+
+void AudioSystem::QueryCache::setGenerationMemory(const sp<IMemory>& memory) {
+    Mutex::Autolock _l(mLock);
+    mGenerationMemory.clear();
+    mGeneration = nullptr;
+    if (memory != nullptr && memory->size() >= sizeof(std::atomic<uint32_t>)
+            && memory->unsecurePointer() != nullptr) {
+        mGenerationMemory = memory;
+        mGeneration = static_cast<const std::atomic<uint32_t>*>(memory->unsecurePointer());
+    }
+    mEntriesGeneration = 0;
+    mStreamVolumes.clear();
+    mStreamVolumeIndexes.clear();
+    mStreamActive.clear();
+    mDevicesForAttributes.clear();
+}
+
+uint64_t AudioSystem::QueryCache::generation() const {
+    Mutex::Autolock _l(mLock);
+    return generation_l();
+}
+
+uint64_t AudioSystem::QueryCache::generation_l() const {
+    if (mGeneration == nullptr) {
+        return 0;
+    }
+    // the service generation starts at 1, so this is never 0.
+    return ((uint64_t)mGeneration->load(std::memory_order_acquire) << 32) | mLocalGeneration;
+}
+
+void AudioSystem::QueryCache::clear() {
+    Mutex::Autolock _l(mLock);
+    // results of queries made before this can no longer be added.
+    ++mLocalGeneration;
+}
+
+bool AudioSystem::QueryCache::prepare_l(uint64_t generation) {
+    if (generation == 0 || generation != generation_l()) {
+        return false;
+    }
+    if (generation != mEntriesGeneration) {
+        mEntriesGeneration = generation;
+        mStreamVolumes.clear();
+        mStreamVolumeIndexes.clear();
+        mStreamActive.clear();
+        mDevicesForAttributes.clear();
+    }
+    return true;
+}
+
+template <typename Key, typename Value>
+bool AudioSystem::QueryCache::get_l(
+        const std::map<Key, Value>& map, const Key& key, Value* value) const {
+    const uint64_t generation = generation_l();
+    if (generation == 0 || generation != mEntriesGeneration) {
+        return false;
+    }
+    auto it = map.find(key);
+    if (it == map.end()) {
+        return false;
+    }
+    *value = it->second;
+    return true;
+}
+
+bool AudioSystem::QueryCache::getStreamVolume(
+        audio_stream_type_t stream, audio_io_handle_t output, float* volume) const {
+    Mutex::Autolock _l(mLock);
+    return get_l(mStreamVolumes, std::make_pair(stream, output), volume);
+}
+
+void AudioSystem::QueryCache::putStreamVolume(uint64_t generation, audio_stream_type_t stream,
+                                              audio_io_handle_t output, float volume) {
+    Mutex::Autolock _l(mLock);
+    if (prepare_l(generation)) {
+        mStreamVolumes[std::make_pair(stream, output)] = volume;
+    }
+}
+
+bool AudioSystem::QueryCache::getStreamVolumeIndex(
+        audio_stream_type_t stream, audio_devices_t device, int* index) const {
+    Mutex::Autolock _l(mLock);
+    return get_l(mStreamVolumeIndexes, std::make_pair(stream, device), index);
+}
+
+void AudioSystem::QueryCache::putStreamVolumeIndex(uint64_t generation, audio_stream_type_t stream,
+                                                   audio_devices_t device, int index) {
+    Mutex::Autolock _l(mLock);
+    if (prepare_l(generation)) {
+        mStreamVolumeIndexes[std::make_pair(stream, device)] = index;
+    }
+}
+
+bool AudioSystem::QueryCache::isStreamActive(audio_stream_type_t stream, bool* active) const {
+    Mutex::Autolock _l(mLock);
+    return get_l(mStreamActive, stream, active);
+}
+
+void AudioSystem::QueryCache::putStreamActive(
+        uint64_t generation, audio_stream_type_t stream, bool active) {
+    Mutex::Autolock _l(mLock);
+    if (prepare_l(generation)) {
+        mStreamActive[stream] = active;
+    }
+}
+
+bool AudioSystem::QueryCache::getDevicesForAttributes(
+        const media::AudioAttributesEx& attr, bool forVolume,
+        std::vector<AudioDevice>* devices) const {
+    Mutex::Autolock _l(mLock);
+    return get_l(mDevicesForAttributes, std::make_pair(attr, forVolume), devices);
+}
+
+void AudioSystem::QueryCache::putDevicesForAttributes(
+        uint64_t generation, const media::AudioAttributesEx& attr, bool forVolume,
+        const std::vector<AudioDevice>& devices) {
+    Mutex::Autolock _l(mLock);
+    if (prepare_l(generation)) {
+        mDevicesForAttributes[std::make_pair(attr, forVolume)] = devices;
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -1240,11 +1381,21 @@ status_t AudioSystem::getStreamVolumeIndex(audio_stream_type_t stream,
             legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
     AudioDeviceDescription deviceAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_devices_t_AudioDeviceDescription(device));
+    int cachedIndex;
+    if (gQueryCache.getStreamVolumeIndex(stream, device, &cachedIndex)) {
+        if (index != nullptr) {
+            *index = cachedIndex;
+        }
+        return OK;
+    }
+    const uint64_t generation = gQueryCache.generation();
     int32_t indexAidl;
     RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(
             aps->getStreamVolumeIndex(streamAidl, deviceAidl, &indexAidl)));
+    int indexLegacy = VALUE_OR_RETURN_STATUS(convertIntegral<int>(indexAidl));
+    gQueryCache.putStreamVolumeIndex(generation, stream, device, indexLegacy);
     if (index != nullptr) {
-        *index = VALUE_OR_RETURN_STATUS(convertIntegral<int>(indexAidl));
+        *index = indexLegacy;
     }
     return OK;
 }
@@ -1334,8 +1485,12 @@ status_t AudioSystem::getDevicesForAttributes(const AudioAttributes& aa,
     media::AudioAttributesEx aaAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_AudioAttributes_AudioAttributesEx(aa));
     std::vector<AudioDevice> retAidl;
-    RETURN_STATUS_IF_ERROR(
-            statusTFromBinderStatus(aps->getDevicesForAttributes(aaAidl, forVolume, &retAidl)));
+    if (!gQueryCache.getDevicesForAttributes(aaAidl, forVolume, &retAidl)) {
+        const uint64_t generation = gQueryCache.generation();
+        RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(
+                aps->getDevicesForAttributes(aaAidl, forVolume, &retAidl)));
+        gQueryCache.putDevicesForAttributes(generation, aaAidl, forVolume, retAidl);
+    }
     *devices = VALUE_OR_RETURN_STATUS(
             convertContainer<AudioDeviceTypeAddrVector>(
                     retAidl,
@@ -1411,11 +1566,19 @@ status_t AudioSystem::isStreamActive(audio_stream_type_t stream, bool* state, ui
     if (aps == 0) return PERMISSION_DENIED;
     if (state == NULL) return BAD_VALUE;
 
+    // the activity within a past interval changes with time, only the current one is cached.
+    if (inPastMs == 0 && gQueryCache.isStreamActive(stream, state)) {
+        return OK;
+    }
+    const uint64_t generation = gQueryCache.generation();
     AudioStreamType streamAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
     int32_t inPastMsAidl = VALUE_OR_RETURN_STATUS(convertIntegral<int32_t>(inPastMs));
     RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(
             aps->isStreamActive(streamAidl, inPastMsAidl, state)));
+    if (inPastMs == 0) {
+        gQueryCache.putStreamActive(generation, stream, *state);
+    }
     return OK;
 }
 
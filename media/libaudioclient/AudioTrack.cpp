@@ -29,6 +29,7 @@
 #include <audio_utils/clock.h>
 #include <audio_utils/primitives.h>
 #include <binder/IPCThreadState.h>
+#include <cutils/properties.h>
 #include <media/AudioTrack.h>
 #include <utils/Log.h>
 #include <private/media/AudioTrackShared.h>
@@ -2107,6 +2108,11 @@ status_t AudioTrack::createTrack_l()
         mStaticProxy = new StaticAudioTrackClientProxy(cblk, buffers, mFrameCount, mFrameSize);
         mProxy = mStaticProxy;
     }
+    // Opt-in spinning before sleeping in a blocking obtainBuffer(), for low latency tracks.
+    if (mFlags & AUDIO_OUTPUT_FLAG_FAST) {
+        mProxy->setAdaptiveSpin(
+                property_get_int64("audio.client.adaptive_spin_max_us", 0) * 1000);
+    }
 
     mProxy->setVolumeLR(gain_minifloat_pack(
             gain_from_float(mVolume[AUDIO_INTERLEAVE_LEFT]),
@@ -3584,6 +3590,12 @@ status_t AudioTrack::dump(int fd, const Vector<String16>& args __unused) const
                         mLatency, mSelectedDeviceId, mRoutedDeviceId);
     result.appendFormat("  output(%d) AF latency (%u) AF frame count(%zu) AF SampleRate(%u)\n",
                         mOutput, mAfLatency, mAfFrameCount, mAfSampleRate);
+    if (mProxy != nullptr) {
+        result.appendFormat("  spin budget(%lld ns), spin wakes(%llu), futex waits(%llu)\n",
+                (long long) mProxy->getSpinBudgetNs(),
+                (unsigned long long) mProxy->getSpinWakeCount(),
+                (unsigned long long) mProxy->getFutexWaitCount());
+    }
     ::write(fd, result.string(), result.size());
     return NO_ERROR;
 }
@@ -17,10 +17,12 @@
 #define LOG_TAG "AudioTrackShared"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <atomic>
 #include <android-base/macros.h>
 #include <private/media/AudioTrackShared.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <audio_utils/safe_math.h>
 
 #include <linux/futex.h>
@@ -312,14 +314,23 @@ status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *reques
         }
         int32_t old = android_atomic_and(~CBLK_FUTEX_WAKE, &cblk->mFutex);
         if (!(old & CBLK_FUTEX_WAKE)) {
+            // The spin is bounded by a small budget, so it is not counted against the timeout.
+            if (mSpinBudgetNs > 0 && spinForWake()) {
+                continue;
+            }
             if (measure && !beforeIsValid) {
                 clock_gettime(CLOCK_MONOTONIC, &before);
                 beforeIsValid = true;
             }
+            const nsecs_t sleepStartNs = mMaxSpinNs > 0 ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
             errno = 0;
             (void) syscall(__NR_futex, &cblk->mFutex,
                     mClientInServer ? FUTEX_WAIT_PRIVATE : FUTEX_WAIT, old & ~CBLK_FUTEX_WAKE, ts);
             status_t error = errno; // clock_gettime can affect errno
+            if (mMaxSpinNs > 0) {
+                mFutexWaitCount++;
+                updateSpinBudget(systemTime(SYSTEM_TIME_MONOTONIC) - sleepStartNs);
+            }
             // update total elapsed time spent waiting
             if (measure) {
                 struct timespec after;
@@ -402,6 +413,46 @@ void ClientProxy::releaseBuffer(Buffer* buffer)
     }
 }
 
+void ClientProxy::setAdaptiveSpin(int64_t maxSpinNs)
+{
+    mMaxSpinNs = std::max(maxSpinNs, (int64_t) 0);
+    // Start at the bound, the budget quickly follows the actual wait times.
+    mSpinBudgetNs = mMaxSpinNs;
+}
+
+bool ClientProxy::spinForWake()
+{
+    const nsecs_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    nsecs_t spunNs = 0;
+    do {
+        // Also set by interrupt() and binderDied().
+        if (android_atomic_acquire_load(&mCblk->mFutex) & CBLK_FUTEX_WAKE) {
+            mSpinWakeCount++;
+            updateSpinBudget(spunNs);
+            return true;
+        }
+#if defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+#endif
+        spunNs = systemTime(SYSTEM_TIME_MONOTONIC) - startNs;
+    } while (spunNs < mSpinBudgetNs);
+    return false;
+}
+
+void ClientProxy::updateSpinBudget(int64_t waitNs)
+{
+    if (waitNs > mMaxSpinNs) {
+        // Waits are too long to be worth spinning for, back off.
+        mSpinBudgetNs /= 2;
+        return;
+    }
+    // Track a little more than the recent wait times, so most of them end while spinning.
+    const int64_t target = std::min(waitNs + waitNs / 4, mMaxSpinNs);
+    mSpinBudgetNs += (target - mSpinBudgetNs) / 4;
+}
+
 void ClientProxy::binderDied()
 {
     audio_track_cblk_t* cblk = mCblk;
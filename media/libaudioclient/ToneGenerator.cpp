@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "ToneGenerator"
 
+#include <array>
 #include <inttypes.h>
 #include <utility>
 
@@ -1759,27 +1760,19 @@ ToneGenerator::tone_type ToneGenerator::getToneForRegion(tone_type toneType) {
 ////////////////////////////////////////////////////////////////////////////////
 ToneGenerator::WaveGenerator::WaveGenerator(uint32_t samplingRate,
         uint16_t frequency, float volume) {
-    double d0;
     double F_div_Fs;  // frequency / samplingRate
 
     F_div_Fs = frequency / (double)samplingRate;
-    d0 = - (float)GEN_AMP * sin(2 * M_PI * F_div_Fs);
-    mS2_0 = (int16_t)d0;
-    mS1 = 0;
-    mS2 = mS2_0;
+    mPhaseInc = (uint32_t)llround(F_div_Fs * 4294967296.0);  // 2^32
+    mPhase = mPhaseInc;
 
     mAmplitude_Q15 = (int16_t)(32767. * 32767. * volume / GEN_AMP);
     // take some margin for amplitude fluctuation
     if (mAmplitude_Q15 > 32500)
         mAmplitude_Q15 = 32500;
 
-    d0 = 32768.0 * cos(2 * M_PI * F_div_Fs);  // Q14*2*cos()
-    if (d0 > 32767)
-        d0 = 32767;
-    mA1_Q14 = (int16_t) d0;
-
-    ALOGV("WaveGenerator init, mA1_Q14: %d, mS2_0: %d, mAmplitude_Q15: %d",
-            mA1_Q14, mS2_0, mAmplitude_Q15);
+    ALOGV("WaveGenerator init, mPhaseInc: %u, mAmplitude_Q15: %d",
+            mPhaseInc, mAmplitude_Q15);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1798,12 +1791,39 @@ ToneGenerator::WaveGenerator::WaveGenerator(uint32_t samplingRate,
 ToneGenerator::WaveGenerator::~WaveGenerator() {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Method:        WaveGenerator::getSineTable()
+//
+//    Description:    Returns the wavetable read by all wave generators, computed
+//        on first use.
+//
+//    Input:
+//        none
+//
+//    Output:
+//        (1 << TABLE_BITS) + 1 samples of one period of a sine wave
+//
+////////////////////////////////////////////////////////////////////////////////
+const int16_t *ToneGenerator::WaveGenerator::getSineTable() {
+    static const std::array<int16_t, (1 << TABLE_BITS) + 1> sTable = [] {
+        std::array<int16_t, (1 << TABLE_BITS) + 1> table;
+        for (size_t i = 0; i < table.size(); i++) {
+            table[i] = (int16_t)lround(GEN_AMP * sin(2 * M_PI * i / (1 << TABLE_BITS)));
+        }
+        return table;
+    }();
+    return sTable.data();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //    Method:        WaveGenerator::getSamples()
 //
 //    Description:    Generates count samples of a sine wave and accumulates
-//        result in outBuffer.
+//        result in outBuffer. Samples are interpolated linearly between two
+//        entries of the wavetable, which costs a few integer operations per
+//        sample and does not accumulate error over long tones.
 //
 //    Input:
 //        outBuffer:      Output buffer where to accumulate samples.
@@ -1816,21 +1836,28 @@ ToneGenerator::WaveGenerator::~WaveGenerator() {
 ////////////////////////////////////////////////////////////////////////////////
 void ToneGenerator::WaveGenerator::getSamples(int16_t *outBuffer,
         unsigned int count, unsigned int command) {
-    long lS1, lS2;
-    long lA1, lAmplitude;
+    const int16_t *table = getSineTable();
+    uint32_t lPhase;
+    const uint32_t lPhaseInc = mPhaseInc;
+    long lAmplitude;
     long Sample;  // current sample
 
     // init local
     if (command == WAVEGEN_START) {
-        lS1 = (long)0;
-        lS2 = (long)mS2_0;
+        lPhase = lPhaseInc;
     } else {
-        lS1 = mS1;
-        lS2 = mS2;
+        lPhase = mPhase;
     }
-    lA1 = (long)mA1_Q14;
     lAmplitude = (long)mAmplitude_Q15;
 
+    auto nextSample = [&]() {
+        uint32_t index = lPhase >> (32 - TABLE_BITS);
+        long frac = (lPhase >> (32 - TABLE_BITS - FRAC_BITS)) & ((1 << FRAC_BITS) - 1);
+        long s0 = table[index];
+        lPhase += lPhaseInc;
+        return s0 + (((table[index + 1] - s0) * frac) >> FRAC_BITS);
+    };
+
     if (command == WAVEGEN_STOP) {
         lAmplitude <<= 16;
         if (count == 0) {
@@ -1840,10 +1867,7 @@ void ToneGenerator::WaveGenerator::getSamples(int16_t *outBuffer,
         // loop generation
         while (count) {
             count--;
-            Sample = ((lA1 * lS1) >> S_Q14) - lS2;
-            // shift delay
-            lS2 = lS1;
-            lS1 = Sample;
+            Sample = nextSample();
             Sample = ((lAmplitude>>16) * Sample) >> S_Q15;
             *(outBuffer++) += (int16_t)Sample;  // put result in buffer
             lAmplitude -= dec;
@@ -1852,18 +1876,14 @@ void ToneGenerator::WaveGenerator::getSamples(int16_t *outBuffer,
         // loop generation
         while (count) {
             count--;
-            Sample = ((lA1 * lS1) >> S_Q14) - lS2;
-            // shift delay
-            lS2 = lS1;
-            lS1 = Sample;
+            Sample = nextSample();
             Sample = (lAmplitude * Sample) >> S_Q15;
             *(outBuffer++) += (int16_t)Sample;  // put result in buffer
         }
     }
 
     // save status
-    mS1 = lS1;
-    mS2 = lS2;
+    mPhase = lPhase;
 }
 
 }  // end namespace android
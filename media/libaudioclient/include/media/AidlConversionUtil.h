@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <iterator>
 #include <limits>
 #include <type_traits>
 #include <utility>
@@ -97,6 +98,32 @@ status_t convertRangeWithLimit(InputIterator start,
     return OK;
 }
 
+/**
+ * Reserves room in the output container for the converted items, when both the output container
+ * can reserve (e.g. std::vector) and the size of the input is known up front, so that the
+ * conversion does not reallocate the output as it grows.
+ */
+template<typename T, typename = void>
+struct HasReserve : std::false_type {};
+
+template<typename T>
+struct HasReserve<T, std::void_t<decltype(std::declval<T&>().reserve(size_t{}))>>
+        : std::true_type {};
+
+template<typename T, typename = void>
+struct HasSize : std::false_type {};
+
+template<typename T>
+struct HasSize<T, std::void_t<decltype(std::size(std::declval<const T&>()))>>
+        : std::true_type {};
+
+template<typename OutputContainer, typename InputContainer>
+void reserveForContainer(OutputContainer& output, const InputContainer& input) {
+    if constexpr (HasReserve<OutputContainer>::value && HasSize<InputContainer>::value) {
+        output.reserve(std::size(input));
+    }
+}
+
 /**
  * A generic template that helps convert containers of convertible types.
  */
@@ -104,6 +131,7 @@ template<typename OutputContainer, typename InputContainer, typename Func>
 ConversionResult<OutputContainer>
 convertContainer(const InputContainer& input, const Func& itemConversion) {
     OutputContainer output;
+    reserveForContainer(output, input);
     auto ins = std::inserter(output, output.begin());
     for (const auto& item : input) {
         *ins = VALUE_OR_RETURN(itemConversion(item));
@@ -119,6 +147,7 @@ template<typename OutputContainer, typename InputContainer, typename Func, typen
 ConversionResult<OutputContainer>
 convertContainer(const InputContainer& input, const Func& itemConversion, const Parameter& param) {
     OutputContainer output;
+    reserveForContainer(output, input);
     auto ins = std::inserter(output, output.begin());
     for (const auto& item : input) {
         *ins = VALUE_OR_RETURN(itemConversion(item, param));
@@ -138,6 +167,7 @@ convertContainers(const InputContainer1& input1, const InputContainer2& input2,
         const Func& itemConversion) {
     auto iter2 = input2.begin();
     OutputContainer output;
+    reserveForContainer(output, input1);
     auto ins = std::inserter(output, output.begin());
     for (const auto& item1 : input1) {
         RETURN_IF_ERROR(iter2 != input2.end() ? OK : BAD_VALUE);
@@ -157,14 +187,16 @@ ConversionResult<std::pair<OutputContainer1, OutputContainer2>>
 convertContainerSplit(const InputContainer& input, const Func& itemConversion) {
     OutputContainer1 output1;
     OutputContainer2 output2;
+    reserveForContainer(output1, input);
+    reserveForContainer(output2, input);
     auto ins1 = std::inserter(output1, output1.begin());
     auto ins2 = std::inserter(output2, output2.begin());
     for (const auto& item : input) {
         auto out_pair = VALUE_OR_RETURN(itemConversion(item));
-        *ins1 = out_pair.first;
-        *ins2 = out_pair.second;
+        *ins1 = std::move(out_pair.first);
+        *ins2 = std::move(out_pair.second);
     }
-    return std::make_pair(output1, output2);
+    return std::make_pair(std::move(output1), std::move(output2));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -215,27 +247,31 @@ Mask enumToMask_index(Enum e) {
             << static_cast<int>(e));
 }
 
-template<typename DestMask, typename SrcMask, typename DestEnum, typename SrcEnum>
+/**
+ * Converts a bitmask one set bit at a time. The conversion functions are template parameters
+ * rather than std::function, so that they are called (and usually inlined) directly instead of
+ * through a type-erased wrapper on every bit.
+ */
+template<typename DestMask, typename SrcMask, typename DestEnum, typename SrcEnum,
+        typename EnumConversion, typename SrcIndexToEnum, typename DestEnumToMask>
 ConversionResult<DestMask> convertBitmask(
-        SrcMask src, const std::function<ConversionResult<DestEnum>(SrcEnum)>& enumConversion,
-        const std::function<SrcEnum(int)>& srcIndexToEnum,
-        const std::function<DestMask(DestEnum)>& destEnumToMask) {
+        SrcMask src, const EnumConversion& enumConversion,
+        const SrcIndexToEnum& srcIndexToEnum,
+        const DestEnumToMask& destEnumToMask) {
     using UnsignedDestMask = std::make_unsigned_t<IntegralTypeOf<DestMask>>;
     using UnsignedSrcMask = std::make_unsigned_t<IntegralTypeOf<SrcMask>>;
 
     UnsignedDestMask dest = static_cast<UnsignedDestMask>(0);
     UnsignedSrcMask usrc = static_cast<UnsignedSrcMask>(src);
 
-    int srcBitIndex = 0;
+    // Only visits the bits that are set, lowest first.
     while (usrc != 0) {
-        if (usrc & 1) {
-            SrcEnum srcEnum = srcIndexToEnum(srcBitIndex);
-            DestEnum destEnum = VALUE_OR_RETURN(enumConversion(srcEnum));
-            DestMask destMask = destEnumToMask(destEnum);
-            dest |= destMask;
-        }
-        ++srcBitIndex;
-        usrc >>= 1;
+        const int srcBitIndex = __builtin_ctzll(static_cast<unsigned long long>(usrc));
+        usrc &= static_cast<UnsignedSrcMask>(usrc - 1);
+        SrcEnum srcEnum = srcIndexToEnum(srcBitIndex);
+        DestEnum destEnum = VALUE_OR_RETURN(enumConversion(srcEnum));
+        DestMask destMask = destEnumToMask(destEnum);
+        dest |= destMask;
     }
     return static_cast<DestMask>(dest);
 }
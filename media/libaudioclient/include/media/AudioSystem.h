@@ -19,15 +19,19 @@
 
 #include <sys/types.h>
 
+#include <atomic>
+#include <map>
 #include <set>
 #include <vector>
 
 #include <android/content/AttributionSourceState.h>
+#include <android/media/AudioAttributesEx.h>
 #include <android/media/AudioVibratorInfo.h>
 #include <android/media/BnAudioFlingerClient.h>
 #include <android/media/BnAudioPolicyServiceClient.h>
 #include <android/media/INativeSpatializerCallback.h>
 #include <android/media/ISpatializer.h>
+#include <android/media/audio/common/AudioDevice.h>
 #include <android/media/audio/common/AudioMMapPolicyInfo.h>
 #include <android/media/audio/common/AudioMMapPolicyType.h>
 #include <android/media/audio/common/AudioPort.h>
@@ -43,6 +47,7 @@
 #include <system/audio.h>
 #include <system/audio_effect.h>
 #include <system/audio_policy.h>
+#include <binder/IMemory.h>
 #include <utils/Errors.h>
 #include <utils/Mutex.h>
 
@@ -786,6 +791,55 @@ private:
         Vector <sp <AudioVolumeGroupCallback> > mAudioVolumeGroupCallback;
     };
 
+    // Caches the results of queries that clients repeat often, such as routing checks made for
+    // every buffer. Each result is tagged with the state generation that audioserver publishes
+    // in shared memory, as read before the query, and is only served while the generation is
+    // unchanged.
+    class QueryCache {
+    public:
+        // Uses the counter in |memory|, or disables caching if it is null.
+        void setGenerationMemory(const sp<IMemory>& memory);
+        // Returns the current generation, 0 if it is unknown and results must not be cached.
+        // It combines the generation of audioserver with the number of local clear() calls.
+        uint64_t generation() const;
+        // Drops the entries, for a change that audioserver does not count.
+        void clear();
+
+        bool getStreamVolume(audio_stream_type_t stream, audio_io_handle_t output,
+                             float* volume) const;
+        void putStreamVolume(uint64_t generation, audio_stream_type_t stream,
+                             audio_io_handle_t output, float volume);
+        bool getStreamVolumeIndex(audio_stream_type_t stream, audio_devices_t device,
+                                  int* index) const;
+        void putStreamVolumeIndex(uint64_t generation, audio_stream_type_t stream,
+                                  audio_devices_t device, int index);
+        bool isStreamActive(audio_stream_type_t stream, bool* active) const;
+        void putStreamActive(uint64_t generation, audio_stream_type_t stream, bool active);
+        bool getDevicesForAttributes(const media::AudioAttributesEx& attr, bool forVolume,
+                std::vector<media::audio::common::AudioDevice>* devices) const;
+        void putDevicesForAttributes(uint64_t generation, const media::AudioAttributesEx& attr,
+                bool forVolume, const std::vector<media::audio::common::AudioDevice>& devices);
+
+    private:
+        template <typename Key, typename Value>
+        bool get_l(const std::map<Key, Value>& map, const Key& key, Value* value) const;
+        // Returns false if the entries of |generation| are already stale.
+        bool prepare_l(uint64_t generation);
+        uint64_t generation_l() const;
+
+        mutable Mutex mLock;
+        sp<IMemory> mGenerationMemory;
+        const std::atomic<uint32_t>* mGeneration = nullptr;
+        uint32_t mLocalGeneration = 0;
+        // the generation of all the entries below
+        uint64_t mEntriesGeneration = 0;
+        std::map<std::pair<audio_stream_type_t, audio_io_handle_t>, float> mStreamVolumes;
+        std::map<std::pair<audio_stream_type_t, audio_devices_t>, int> mStreamVolumeIndexes;
+        std::map<audio_stream_type_t, bool> mStreamActive;
+        std::map<std::pair<media::AudioAttributesEx, bool>,
+                std::vector<media::audio::common::AudioDevice>> mDevicesForAttributes;
+    };
+
     static audio_io_handle_t getOutput(audio_stream_type_t stream);
     static const sp<AudioFlingerClient> getAudioFlingerClient();
     static sp<AudioIoDescriptor> getIoDescriptor(audio_io_handle_t ioHandle);
@@ -815,6 +869,7 @@ private:
     static audio_channel_mask_t gPrevInChannelMask;
 
     static sp<media::IAudioPolicyService> gAudioPolicyService;
+    static QueryCache gQueryCache;
 };
 
 };  // namespace android
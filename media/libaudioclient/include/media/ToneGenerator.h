@@ -326,7 +326,8 @@ private:
     void clearWaveGens();
     tone_type getToneForRegion(tone_type toneType);
 
-    // WaveGenerator generates a single sine wave
+    // WaveGenerator generates a single sine wave, read from a wavetable shared by all
+    // generators of the process
     class WaveGenerator {
     public:
         enum gen_command {
@@ -344,13 +345,16 @@ private:
 
     private:
         static const int16_t GEN_AMP = 32000;  // amplitude of generator
-        static const int16_t S_Q14 = 14;  // shift for Q14
         static const int16_t S_Q15 = 15;  // shift for Q15
+        static const unsigned int TABLE_BITS = 10;  // log2 of the wavetable entries per period
+        static const unsigned int FRAC_BITS = 15;  // bits of phase interpolated between entries
 
-        int16_t mA1_Q14;  // Q14 coefficient
-        // delay line of full amplitude generator
-        long mS1, mS2;  // delay line S2 oldest
-        int16_t mS2_0;  // saved value for reinitialisation
+        // One period of a sine wave of amplitude GEN_AMP, plus the first entry repeated so
+        // that interpolation never wraps.
+        static const int16_t *getSineTable();
+
+        uint32_t mPhase;  // phase of the next sample, in 1/2^32 of a period
+        uint32_t mPhaseInc;  // phase increment per sample
         int16_t mAmplitude_Q15;  // Q15 amplitude
     };
 
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AidlConversion.h>
+
+using namespace android;
+
+using media::audio::common::AudioChannelLayout;
+using media::audio::common::AudioConfig;
+
+// The conversions made for each createTrack() / createRecord() call, on the way in and out.
+
+static void BM_OutputFlagsMask(benchmark::State& state) {
+    const audio_output_flags_t legacy = static_cast<audio_output_flags_t>(
+            AUDIO_OUTPUT_FLAG_PRIMARY | AUDIO_OUTPUT_FLAG_FAST | AUDIO_OUTPUT_FLAG_DEEP_BUFFER);
+    for (auto _ : state) {
+        int32_t aidl = legacy2aidl_audio_output_flags_t_int32_t_mask(legacy).value();
+        benchmark::DoNotOptimize(aidl2legacy_int32_t_audio_output_flags_t_mask(aidl).value());
+    }
+}
+BENCHMARK(BM_OutputFlagsMask);
+
+static void BM_ChannelMask(benchmark::State& state) {
+    for (auto _ : state) {
+        AudioChannelLayout aidl = legacy2aidl_audio_channel_mask_t_AudioChannelLayout(
+                AUDIO_CHANNEL_OUT_5POINT1, false /*isInput*/).value();
+        benchmark::DoNotOptimize(aidl2legacy_AudioChannelLayout_audio_channel_mask_t(
+                aidl, false /*isInput*/).value());
+    }
+}
+BENCHMARK(BM_ChannelMask);
+
+static void BM_AudioConfig(benchmark::State& state) {
+    audio_config_t legacy = AUDIO_CONFIG_INITIALIZER;
+    legacy.sample_rate = 48000;
+    legacy.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+    legacy.format = AUDIO_FORMAT_PCM_16_BIT;
+    for (auto _ : state) {
+        AudioConfig aidl = legacy2aidl_audio_config_t_AudioConfig(
+                legacy, false /*isInput*/).value();
+        benchmark::DoNotOptimize(aidl2legacy_AudioConfig_audio_config_t(
+                aidl, false /*isInput*/).value());
+    }
+}
+BENCHMARK(BM_AudioConfig);
+
+static void BM_AudioAttributes(benchmark::State& state) {
+    audio_attributes_t legacy = AUDIO_ATTRIBUTES_INITIALIZER;
+    legacy.usage = AUDIO_USAGE_MEDIA;
+    legacy.content_type = AUDIO_CONTENT_TYPE_MUSIC;
+    legacy.flags = static_cast<audio_flags_mask_t>(AUDIO_FLAG_LOW_LATENCY);
+    strlcpy(legacy.tags, "addr=bus0_media_out", sizeof(legacy.tags));
+    for (auto _ : state) {
+        media::AudioAttributesInternal aidl =
+                legacy2aidl_audio_attributes_t_AudioAttributesInternal(legacy).value();
+        benchmark::DoNotOptimize(
+                aidl2legacy_AudioAttributesInternal_audio_attributes_t(aidl).value());
+    }
+}
+BENCHMARK(BM_AudioAttributes);
+
+// The lists of an audio profile, with a growing number of entries.
+static void BM_ChannelMaskList(benchmark::State& state) {
+    const std::vector<audio_channel_mask_t> legacy(state.range(0), AUDIO_CHANNEL_OUT_STEREO);
+    for (auto _ : state) {
+        std::vector<AudioChannelLayout> aidl =
+                convertContainer<std::vector<AudioChannelLayout>>(
+                        legacy, legacy2aidl_audio_channel_mask_t_AudioChannelLayout,
+                        false /*isInput*/).value();
+        benchmark::DoNotOptimize(
+                convertContainer<std::vector<audio_channel_mask_t>>(
+                        aidl, aidl2legacy_AudioChannelLayout_audio_channel_mask_t,
+                        false /*isInput*/).value());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ChannelMaskList)->RangeMultiplier(4)->Range(4, 256);
+
+BENCHMARK_MAIN();
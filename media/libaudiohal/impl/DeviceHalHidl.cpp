@@ -263,7 +263,10 @@ status_t DeviceHalHidl::openOutputStream(
                     const AudioConfig& suggestedConfig) {
                 retval = r;
                 if (retval == Result::OK) {
-                    *outStream = new StreamOutHalHidl(result);
+                    // Deep buffer outputs can trade latency for fewer HAL wakeups.
+                    const bool coalesceWrites = (flags & AUDIO_OUTPUT_FLAG_DEEP_BUFFER) != 0
+                            && (flags & AUDIO_OUTPUT_FLAG_FAST) == 0;
+                    *outStream = new StreamOutHalHidl(result, coalesceWrites);
                 }
                 HidlUtils::audioConfigToHal(suggestedConfig, config);
             });
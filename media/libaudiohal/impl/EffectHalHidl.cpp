@@ -17,6 +17,8 @@
 #define LOG_TAG "EffectHalHidl"
 //#define LOG_NDEBUG 0
 
+#include <stdio.h>
+
 #include <android/hidl/manager/1.0/IServiceManager.h>
 #include <android-base/stringprintf.h>
 #include <common/all-versions/VersionUtils.h>
@@ -28,6 +30,7 @@
 #include <mediautils/TimeCheck.h>
 #include <system/audio_effects/effect_spatializer.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include <util/EffectUtils.h>
 
@@ -159,6 +162,8 @@ bool EffectHalHidl::needToResetBuffers() {
 
 status_t EffectHalHidl::processImpl(uint32_t mqFlag) {
     if (mEffect == 0 || mInBuffer == 0 || mOutBuffer == 0) return NO_INIT;
+    mLastProcessNs = systemTime();
+    flushParameters();
     status_t status;
     if (!mStatusMQ && (status = prepareForProcessing()) != OK) {
         return status;
@@ -206,6 +211,13 @@ status_t EffectHalHidl::command(uint32_t cmdCode, uint32_t cmdSize, void *pCmdDa
 
     if (mEffect == 0) return NO_INIT;
 
+    if (cmdCode == EFFECT_CMD_SET_PARAM
+            && queueParameter(cmdSize, pCmdData, replySize, pReplyData)) {
+        return OK;
+    }
+    // Any other command is sent after the queued parameters, so that the order is kept.
+    flushParameters();
+
     // Special cases.
     if (cmdCode == EFFECT_CMD_SET_CONFIG || cmdCode == EFFECT_CMD_SET_CONFIG_REVERSE) {
         return setConfigImpl(cmdCode, cmdSize, pCmdData, replySize, pReplyData);
@@ -213,7 +225,19 @@ status_t EffectHalHidl::command(uint32_t cmdCode, uint32_t cmdSize, void *pCmdDa
         return getConfigImpl(cmdCode, replySize, pReplyData);
     }
 
-    // Common case.
+    if (cmdCode == EFFECT_CMD_DISABLE) {
+        mEnabled = false;
+    }
+    const status_t status = commandImpl(cmdCode, cmdSize, pCmdData, replySize, pReplyData);
+    if (cmdCode == EFFECT_CMD_ENABLE && status == OK && replySize != nullptr
+            && *replySize >= sizeof(int32_t) && pReplyData != nullptr) {
+        mEnabled = *static_cast<int32_t*>(pReplyData) == 0;
+    }
+    return status;
+}
+
+status_t EffectHalHidl::commandImpl(uint32_t cmdCode, uint32_t cmdSize, void *pCmdData,
+        uint32_t *replySize, void *pReplyData) {
     hidl_vec<uint8_t> hidlData;
     if (pCmdData != nullptr && cmdSize > 0) {
         hidlData.setToExternal(reinterpret_cast<uint8_t*>(pCmdData), cmdSize);
@@ -234,6 +258,69 @@ status_t EffectHalHidl::command(uint32_t cmdCode, uint32_t cmdSize, void *pCmdDa
     return ret.isOk() ? status : FAILED_TRANSACTION;
 }
 
+bool EffectHalHidl::queueParameter(
+        uint32_t cmdSize, void *pCmdData, uint32_t *replySize, void *pReplyData) {
+    // Only while processing, as the queue is sent from process().
+    if (!mEnabled || systemTime() - mLastProcessNs > kParamCoalesceWindowNs) {
+        return false;
+    }
+    // Only well formed commands with a status reply are queued, malformed ones are left to the
+    // effect to reject.
+    if (pCmdData == nullptr || cmdSize < sizeof(effect_param_t)
+            || replySize == nullptr || *replySize != sizeof(int32_t) || pReplyData == nullptr) {
+        return false;
+    }
+    const effect_param_t *param = static_cast<const effect_param_t*>(pCmdData);
+    const size_t paddedPSize = ((size_t)param->psize + sizeof(int32_t) - 1)
+            / sizeof(int32_t) * sizeof(int32_t);
+    if (param->psize == 0 || sizeof(effect_param_t) + paddedPSize + param->vsize != cmdSize) {
+        return false;
+    }
+
+    const uint8_t *data = static_cast<const uint8_t*>(pCmdData);
+    {
+        std::lock_guard<std::mutex> lock(mParamLock);
+        // Only the last queued command is replaced, so that the order of the updates of
+        // different parameters is kept.
+        if (!mPendingParams.empty()) {
+            std::vector<uint8_t>& last = mPendingParams.back();
+            const effect_param_t *lastParam = reinterpret_cast<const effect_param_t*>(last.data());
+            if (last.size() == cmdSize && lastParam->psize == param->psize
+                    && memcmp(lastParam->data, param->data, param->psize) == 0) {
+                last.assign(data, data + cmdSize);
+                mParamTransactionsSaved++;
+                *static_cast<int32_t*>(pReplyData) = 0;
+                return true;
+            }
+        }
+        mPendingParams.emplace_back(data, data + cmdSize);
+        mParamsPending = true;
+    }
+    // The effect status is not known yet, a failure is logged when the queue is sent.
+    *static_cast<int32_t*>(pReplyData) = 0;
+    return true;
+}
+
+void EffectHalHidl::flushParameters() {
+    if (!mParamsPending) return;
+    std::lock_guard<std::mutex> flushLock(mParamFlushLock);
+    std::vector<std::vector<uint8_t>> params;
+    {
+        std::lock_guard<std::mutex> lock(mParamLock);
+        params.swap(mPendingParams);
+        mParamsPending = false;
+    }
+    for (auto& param : params) {
+        int32_t reply = 0;
+        uint32_t replySize = sizeof(reply);
+        const status_t status = commandImpl(EFFECT_CMD_SET_PARAM, param.size(), param.data(),
+                &replySize, &reply);
+        ALOGW_IF(status != OK || reply != 0,
+                "%s: effectId %lld queued EFFECT_CMD_SET_PARAM failed, status %d reply %d",
+                __func__, (long long)mEffectId, status, reply);
+    }
+}
+
 status_t EffectHalHidl::getDescriptor(effect_descriptor_t *pDescriptor) {
     TIME_CHECK();
 
@@ -253,6 +340,7 @@ status_t EffectHalHidl::close() {
     TIME_CHECK();
 
     if (mEffect == 0) return NO_INIT;
+    flushParameters();
     Return<Result> ret = mEffect->close();
     return ret.isOk() ? analyzeResult(ret) : FAILED_TRANSACTION;
 }
@@ -261,6 +349,8 @@ status_t EffectHalHidl::dump(int fd) {
     TIME_CHECK();
 
     if (mEffect == 0) return NO_INIT;
+    dprintf(fd, "EffectHalHidl effectId %lld: %lld parameter transactions saved\n",
+            (long long)mEffectId, (long long)mParamTransactionsSaved.load());
     native_handle_t* hidlHandle = native_handle_create(1, 0);
     hidlHandle->data[0] = fd;
     Return<void> ret = mEffect->debug(hidlHandle, {} /* options */);
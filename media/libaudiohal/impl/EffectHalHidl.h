@@ -23,6 +23,10 @@
 #include <fmq/MessageQueue.h>
 #include <system/audio_effect.h>
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 #include "EffectConversionHelperHidl.h"
 
 using ::android::hardware::EventFlag;
@@ -84,13 +88,32 @@ class EffectHalHidl : public EffectHalInterface, public EffectConversionHelperHi
     // Typical RealTime mHalThreadPriority ranges from 1 (low) to 3 (high).
     int mHalThreadPriority = kRTPriorityDisabled;
 
+    // Parameter mailbox. While the effect is enabled and processing, EFFECT_CMD_SET_PARAM
+    // commands are queued here instead of being sent right away, and a command for the same
+    // parameter as the last queued one replaces it. The queue is sent in order at the next
+    // process() boundary, or before any other command.
+    // Processing is considered active for kParamCoalesceWindowNs after a process() call.
+    static constexpr int64_t kParamCoalesceWindowNs = 100000000;  // 100 ms
+    std::mutex mParamFlushLock;  // serializes flushParameters(), acquired before mParamLock
+    std::mutex mParamLock;
+    std::vector<std::vector<uint8_t>> mPendingParams;  // guarded by mParamLock
+    std::atomic<bool> mParamsPending = false;  // lets process() skip the locks
+    std::atomic<bool> mEnabled = false;
+    std::atomic<int64_t> mLastProcessNs = 0;
+    std::atomic<int64_t> mParamTransactionsSaved = 0;
+
     // Can not be constructed directly by clients.
     EffectHalHidl(const sp<IEffect>& effect, uint64_t effectId);
 
     // The destructor automatically releases the effect.
     virtual ~EffectHalHidl();
 
+    status_t commandImpl(uint32_t cmdCode, uint32_t cmdSize, void *pCmdData,
+            uint32_t *replySize, void *pReplyData);
     status_t getConfigImpl(uint32_t cmdCode, uint32_t *replySize, void *pReplyData);
+    // Queues an EFFECT_CMD_SET_PARAM command, returns false if it must be sent now.
+    bool queueParameter(uint32_t cmdSize, void *pCmdData, uint32_t *replySize, void *pReplyData);
+    void flushParameters();
     status_t prepareForProcessing();
     bool needToResetBuffers();
     status_t processImpl(uint32_t mqFlag);
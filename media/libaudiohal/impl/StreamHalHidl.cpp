@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 
 #include <android/hidl/manager/1.0/IServiceManager.h>
+#include <cutils/properties.h>
 #include <hwbinder/IPCThreadState.h>
 #include <media/AudioParameter.h>
 #include <mediautils/memory.h>
@@ -369,9 +370,13 @@ struct StreamOutCallback : public IStreamOutCallback {
 }  // namespace
 
 StreamOutHalHidl::StreamOutHalHidl(
-        const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream)
+        const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream,
+        bool coalesceWrites)
         : StreamHalHidl("StreamOutHalHidl", stream.get())
-        , mStream(stream), mWriterClient(0), mEfGroup(nullptr) {
+        , mStream(stream), mWriterClient(0), mEfGroup(nullptr)
+        , mCoalesceCount(coalesceWrites ? std::min((size_t)std::max(
+                property_get_int32("audio.hal.write_coalesce_count", 0), 0),
+                kMaxCoalescedWrites) : 0) {
 }
 
 StreamOutHalHidl::~StreamOutHalHidl() {
@@ -462,24 +467,79 @@ status_t StreamOutHalHidl::write(const void *buffer, size_t bytes, size_t *writt
             return status;
         }
         if (bytes > bufferSize) bufferSize = bytes;
+        if (mCoalesceCount > 1 && !mCallback.load().unsafe_get()) {
+            mCoalesceTargetBytes = bufferSize * mCoalesceCount;
+            mCoalesced.reserve(mCoalesceTargetBytes);
+            bufferSize = mCoalesceTargetBytes;
+        }
         if ((status = prepareForWriting(bufferSize)) != OK) {
+            mCoalesceTargetBytes = 0;
             return status;
         }
     }
 
-    status = callWriterThread(
-            WriteCommand::WRITE, "write", static_cast<const uint8_t*>(buffer), bytes,
+    if (mCoalesceTargetBytes != 0) {
+        status = coalesceWrite(buffer, bytes, written);
+    } else {
+        status = callWriterThread(
+                WriteCommand::WRITE, "write", static_cast<const uint8_t*>(buffer), bytes,
+                [&] (const WriteStatus& writeStatus) {
+                    *written = writeStatus.reply.written;
+                    // Diagnostics of the cause of b/35813113.
+                    ALOGE_IF(*written > bytes,
+                            "hal reports more bytes written than asked for: %lld > %lld",
+                            (long long)*written, (long long)bytes);
+                });
+    }
+    mStreamPowerLog.log(buffer, *written);
+    return status;
+}
+
+status_t StreamOutHalHidl::coalesceWrite(const void *buffer, size_t bytes, size_t *written) {
+    // Data which the HAL did not accept on the previous command stays in mCoalesced,
+    // in that case we report a short write so that the caller retries the rest.
+    const size_t toCoalesce = std::min(bytes, mCoalesceTargetBytes - mCoalesced.size());
+    if (mCoalesced.empty()) {
+        mCoalesceStartNs = systemTime();
+    }
+    const uint8_t *data = static_cast<const uint8_t*>(buffer);
+    mCoalesced.insert(mCoalesced.end(), data, data + toCoalesce);
+    *written = toCoalesce;
+
+    if (mCoalesced.size() < mCoalesceTargetBytes
+            && systemTime() - mCoalesceStartNs < kCoalesceDeadlineNs) {
+        return OK;
+    }
+    return flushCoalesced();
+}
+
+status_t StreamOutHalHidl::flushCoalesced() {
+    if (mCoalesced.empty()) return OK;
+    size_t halWritten = 0;
+    status_t status = callWriterThread(
+            WriteCommand::WRITE, "write", mCoalesced.data(), mCoalesced.size(),
             [&] (const WriteStatus& writeStatus) {
-                *written = writeStatus.reply.written;
+                halWritten = writeStatus.reply.written;
                 // Diagnostics of the cause of b/35813113.
-                ALOGE_IF(*written > bytes,
+                ALOGE_IF(halWritten > mCoalesced.size(),
                         "hal reports more bytes written than asked for: %lld > %lld",
-                        (long long)*written, (long long)bytes);
+                        (long long)halWritten, (long long)mCoalesced.size());
             });
-    mStreamPowerLog.log(buffer, *written);
+    mCoalesced.erase(mCoalesced.begin(),
+            mCoalesced.begin() + std::min(halWritten, mCoalesced.size()));
+    mCoalesceStartNs = systemTime();
     return status;
 }
 
+status_t StreamOutHalHidl::standby() {
+    if (mWriterClient == gettid() && mCommandMQ) {
+        (void)flushCoalesced();
+    }
+    ALOGW_IF(!mCoalesced.empty(), "standby drops %zu coalesced bytes", mCoalesced.size());
+    mCoalesced.clear();
+    return StreamHalHidl::standby();
+}
+
 status_t StreamOutHalHidl::callWriterThread(
         WriteCommand cmd, const char* cmdName,
         const uint8_t* data, size_t dataSize, StreamOutHalHidl::WriterCallback callback) {
@@ -657,6 +717,9 @@ status_t StreamOutHalHidl::supportsDrain(bool *supportsDrain) {
 status_t StreamOutHalHidl::drain(bool earlyNotify) {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
+    if (mWriterClient == gettid() && mCommandMQ) {
+        (void)flushCoalesced();
+    }
     return processReturn(
             "drain", mStream->drain(earlyNotify ? AudioDrain::EARLY_NOTIFY : AudioDrain::ALL));
 }
@@ -664,6 +727,7 @@ status_t StreamOutHalHidl::drain(bool earlyNotify) {
 status_t StreamOutHalHidl::flush() {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
+    mCoalesced.clear();
     return processReturn("pause", mStream->flush());
 }
 
@@ -18,6 +18,7 @@
 #define ANDROID_HARDWARE_STREAM_HAL_HIDL_H
 
 #include <atomic>
+#include <vector>
 
 #include PATH(android/hardware/audio/CORE_TYPES_FILE_VERSION/IStream.h)
 #include PATH(android/hardware/audio/CORE_TYPES_FILE_VERSION/IStreamIn.h)
@@ -27,6 +28,7 @@
 #include <media/audiohal/EffectHalInterface.h>
 #include <media/audiohal/StreamHalInterface.h>
 #include <mediautils/Synchronization.h>
+#include <utils/Timers.h>
 
 #include "CoreConversionHelperHidl.h"
 #include "StreamPowerLog.h"
@@ -131,6 +133,9 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Selects the audio presentation (if available).
     virtual status_t selectPresentation(int presentationId, int programId);
 
+    // Put the audio hardware output into standby mode, after writing any coalesced data.
+    status_t standby() override;
+
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written);
 
@@ -222,8 +227,20 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     std::atomic<pid_t> mWriterClient;
     EventFlag* mEfGroup;
 
+    // Write coalescing, enabled for deep buffer outputs by the audio.hal.write_coalesce_count
+    // property. Up to that many writes are held in mCoalesced, then sent to the HAL writer
+    // thread as a single command, which reduces the number of cross process wakeups.
+    // Accessed by the writer thread only.
+    static constexpr size_t kMaxCoalescedWrites = 4;
+    static constexpr nsecs_t kCoalesceDeadlineNs = 100000000;  // 100 ms
+    const size_t mCoalesceCount;        // 0 or 1 if disabled
+    size_t mCoalesceTargetBytes = 0;    // set when the data queue is prepared
+    nsecs_t mCoalesceStartNs = 0;       // time of the oldest coalesced write
+    std::vector<uint8_t> mCoalesced;
+
     // Can not be constructed directly by clients.
-    StreamOutHalHidl(const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream);
+    StreamOutHalHidl(const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream,
+            bool coalesceWrites = false);
 
     virtual ~StreamOutHalHidl();
 
@@ -232,6 +249,8 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
             WriteCommand cmd, const char* cmdName,
             const uint8_t* data, size_t dataSize, WriterCallback callback);
     status_t prepareForWriting(size_t bufferSize);
+    status_t coalesceWrite(const void *buffer, size_t bytes, size_t *written);
+    status_t flushCoalesced();
 };
 
 class StreamInHalHidl : public StreamInHalInterface, public StreamHalHidl {
@@ -144,6 +144,8 @@ void AudioMixer::Track::unprepareForDownmix() {
     }
 
     mDownmixRequiresFormat = AUDIO_FORMAT_INVALID;
+    mDownmixType = DownmixType::NONE;
+    mDownmixFused = false;
     if (mDownmixerBufferProvider.get() != nullptr) {
         // this track had previously been configured with a downmixer, delete it
         mDownmixerBufferProvider.reset(nullptr);
@@ -181,6 +183,7 @@ status_t AudioMixer::Track::prepareForDownmix()
             if (static_cast<DownmixerBufferProvider *>(mDownmixerBufferProvider.get())
                     ->isValid()) {
                 mDownmixRequiresFormat = format;
+                mDownmixType = DownmixType::EFFECT;
                 reconfigureBufferProviders();
                 return NO_ERROR;
             }
@@ -198,6 +201,7 @@ status_t AudioMixer::Track::prepareForDownmix()
         if (static_cast<ChannelMixBufferProvider *>(mDownmixerBufferProvider.get())
                 ->isValid()) {
             mDownmixRequiresFormat = mMixerInFormat;
+            mDownmixType = DownmixType::CHANNEL_MIX;
             reconfigureBufferProviders();
             ALOGD("%s: Fallback using ChannelMix", __func__);
             return NO_ERROR;
@@ -209,6 +213,7 @@ status_t AudioMixer::Track::prepareForDownmix()
     // Effect downmixer does not accept the channel conversion.  Let's use our remixer.
     mDownmixerBufferProvider.reset(new RemixBufferProvider(channelMask,
             mMixerChannelMask, mMixerInFormat, kCopyBufferFrameCount));
+    mDownmixType = DownmixType::REMIX;
     // Remix always finds a conversion whereas Downmixer effect above may fail.
     reconfigureBufferProviders();
     return NO_ERROR;
@@ -239,7 +244,38 @@ status_t AudioMixer::Track::prepareForReformat()
     const audio_format_t targetFormat = mDownmixRequiresFormat != AUDIO_FORMAT_INVALID
             ? mDownmixRequiresFormat : mMixerInFormat;
     bool requiresReconfigure = false;
-    if (mFormat != targetFormat) {
+
+    // A built-in downmixer is fused with the reformat (or float clamp) into a single
+    // ReformatDownmixBufferProvider, otherwise it is restored if previously fused.
+    const bool fuse = (mDownmixType == DownmixType::CHANNEL_MIX
+                    || mDownmixType == DownmixType::REMIX)
+            && (mFormat != targetFormat || mFormat == AUDIO_FORMAT_PCM_FLOAT);
+    if (fuse || mDownmixFused) {
+        mDownmixFused = false;
+        if (fuse) {
+            auto fused = std::make_unique<ReformatDownmixBufferProvider>(
+                    channelMask, mMixerChannelMask, mFormat, targetFormat,
+                    mDownmixType == DownmixType::CHANNEL_MIX, kCopyBufferFrameCount);
+            if (fused->isValid()) {
+                mDownmixerBufferProvider = std::move(fused);
+                mDownmixFused = true;
+            }
+        }
+        if (!mDownmixFused) {
+            if (mDownmixType == DownmixType::CHANNEL_MIX) {
+                mDownmixerBufferProvider.reset(new ChannelMixBufferProvider(channelMask,
+                        mMixerChannelMask, targetFormat, kCopyBufferFrameCount));
+            } else {
+                mDownmixerBufferProvider.reset(new RemixBufferProvider(channelMask,
+                        mMixerChannelMask, targetFormat, kCopyBufferFrameCount));
+            }
+        }
+        requiresReconfigure = true;
+    }
+
+    if (mDownmixFused) {
+        // reformat is done by mDownmixerBufferProvider.
+    } else if (mFormat != targetFormat) {
         mReformatBufferProvider.reset(new ReformatBufferProvider(
                 audio_channel_count_from_out_mask(channelMask),
                 mFormat,
@@ -19,13 +19,20 @@
 //#define LOG_NDEBUG 0
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sched.h>
 #include <sstream>
 #include <string.h>
+#include <thread>
 
 #include <audio_utils/primitives.h>
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "AudioMixerOps.h"
 
@@ -56,6 +63,151 @@ namespace android {
 
 // ----------------------------------------------------------------------------
 
+// A group is only split if each part gets at least this many tracks.
+static constexpr size_t kMinTracksPerMixPart = 2;
+
+/*
+ * MixWorkerPool runs the parts of a parallel group mix.  Part 0 is always run on
+ * the thread calling process(), parts 1 to N-1 each on a dedicated worker thread
+ * pinned to one CPU, with its own accumulator and resampler temp buffer.
+ */
+class AudioMixerBase::MixWorkerPool {
+public:
+    MixWorkerPool(size_t parts, size_t samples)
+        : mTiming(new Timing[parts])
+    {
+        for (size_t part = 0; part < parts; ++part) {
+            mAccumulators.emplace_back(part == 0 ? nullptr : new int32_t[samples]);
+            mResampleTemps.emplace_back(part == 0 ? nullptr : new int32_t[samples]);
+        }
+        for (size_t part = 1; part < parts; ++part) {
+            mThreads.emplace_back(&MixWorkerPool::threadLoop, this, part);
+        }
+    }
+
+    ~MixWorkerPool() {
+        {
+            std::lock_guard lock(mLock);
+            mExit = true;
+        }
+        mWorkCv.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    size_t parts() const { return mAccumulators.size(); }
+    int32_t *accumulator(size_t part) { return mAccumulators[part].get(); }
+    int32_t *resampleTemp(size_t part) { return mResampleTemps[part].get(); }
+
+    // Runs work(part) for part in [0, parts), and returns when all parts are done.
+    void run(size_t parts, const std::function<void(size_t)> &work) {
+        {
+            std::lock_guard lock(mLock);
+            mWork = &work;
+            mActiveParts = parts;
+            mPending = parts - 1;
+            ++mGeneration;
+        }
+        mWorkCv.notify_all();
+        runPart(0, work);
+        std::unique_lock lock(mLock);
+        mDoneCv.wait(lock, [this] { return mPending == 0; });
+        mWork = nullptr;
+    }
+
+    std::string timingToString() const {
+        std::stringstream ss;
+        for (size_t part = 0; part < parts(); ++part) {
+            const Timing &t = mTiming[part];
+            const uint64_t count = t.count.load(std::memory_order_relaxed);
+            const int64_t totalNs = t.totalNs.load(std::memory_order_relaxed);
+            ss << "part " << part << ": count " << count
+                    << " last " << t.lastNs.load(std::memory_order_relaxed) / 1000 << " us"
+                    << " avg " << (count > 0 ? totalNs / (int64_t)count / 1000 : 0) << " us"
+                    << " max " << t.maxNs.load(std::memory_order_relaxed) / 1000 << " us\n";
+        }
+        return ss.str();
+    }
+
+private:
+    // written by the thread running the part, read by dump.
+    struct Timing {
+        std::atomic<int64_t> lastNs{0};
+        std::atomic<int64_t> maxNs{0};
+        std::atomic<int64_t> totalNs{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    void runPart(size_t part, const std::function<void(size_t)> &work) {
+        const nsecs_t start = systemTime();
+        work(part);
+        const int64_t elapsedNs = systemTime() - start;
+        Timing &t = mTiming[part];
+        t.lastNs.store(elapsedNs, std::memory_order_relaxed);
+        if (elapsedNs > t.maxNs.load(std::memory_order_relaxed)) {
+            t.maxNs.store(elapsedNs, std::memory_order_relaxed);
+        }
+        t.totalNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+        t.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void threadLoop(size_t part) {
+        pthread_setname_np(pthread_self(), "AudioMixWorker");
+        // Pin each worker to a distinct CPU of the inherited affinity set, starting
+        // from the highest numbered CPU, which on most big.LITTLE SoCs is a big core.
+        cpu_set_t allowed;
+        if (sched_getaffinity(0 /* pid */, sizeof(allowed), &allowed) == 0) {
+            const int count = CPU_COUNT(&allowed);
+            int index = count > 0 ? (int)(part - 1) % count : -1;
+            for (int cpu = CPU_SETSIZE - 1; cpu >= 0; --cpu) {
+                if (!CPU_ISSET(cpu, &allowed)) continue;
+                if (index-- == 0) {
+                    cpu_set_t pinned;
+                    CPU_ZERO(&pinned);
+                    CPU_SET(cpu, &pinned);
+                    (void)sched_setaffinity(0 /* pid */, sizeof(pinned), &pinned);
+                    break;
+                }
+            }
+        }
+
+        uint64_t generation = 0;
+        std::unique_lock lock(mLock);
+        while (true) {
+            mWorkCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+            if (mExit) break;
+            generation = mGeneration;
+            if (part >= mActiveParts) continue;
+            const std::function<void(size_t)> &work = *mWork;
+            lock.unlock();
+            runPart(part, work);
+            lock.lock();
+            if (--mPending == 0) {
+                mDoneCv.notify_one();
+            }
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mWorkCv;  // signaled on new work or exit
+    std::condition_variable mDoneCv;  // signaled when all worker parts are done
+    uint64_t mGeneration = 0;         // GUARDED_BY(mLock)
+    size_t mActiveParts = 0;          // GUARDED_BY(mLock)
+    size_t mPending = 0;              // GUARDED_BY(mLock), worker parts left to run
+    bool mExit = false;               // GUARDED_BY(mLock)
+    const std::function<void(size_t)> *mWork = nullptr; // GUARDED_BY(mLock)
+
+    const std::unique_ptr<Timing[]> mTiming;
+    std::vector<std::unique_ptr<int32_t[]>> mAccumulators;  // indexed by part, [0] unused
+    std::vector<std::unique_ptr<int32_t[]>> mResampleTemps; // indexed by part, [0] unused
+    std::vector<std::thread> mThreads;
+};
+
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -599,6 +751,20 @@ std::string AudioMixerBase::trackNames() const
     return ss.str();
 }
 
+void AudioMixerBase::setParallelMixThreads(size_t threads)
+{
+    if (threads == mParallelMixThreads) return;
+    ALOGV("%s: %zu -> %zu", __func__, mParallelMixThreads, threads);
+    mParallelMixThreads = threads;
+    mMixWorkerPool.reset(); // recreated on demand with the new size.
+}
+
+std::string AudioMixerBase::parallelMixTimingToString() const
+{
+    if (mMixWorkerPool == nullptr) return {};
+    return mMixWorkerPool->timingToString();
+}
+
 void AudioMixerBase::process__validate()
 {
     // TODO: fix all16BitsStereNoResample logic to
@@ -634,6 +800,7 @@ void AudioMixerBase::process__validate()
             n |= NEEDS_MUTE;
         }
         t->needs = n;
+        t->mFusedMix = false;
 
         if (n & NEEDS_MUTE) {
             t->hook = &TrackBase::track__nop;
@@ -681,6 +848,18 @@ void AudioMixerBase::process__validate()
                     ALOGV_IF((n & NEEDS_CHANNEL_COUNT__MASK) > NEEDS_CHANNEL_2,
                             "Track %d needs downmix", name);
                 }
+                // The fused path only handles interleaved float input already at the
+                // mixer channel count, with at most stereo volume and no aux send.
+                const bool monoExpand = (n & NEEDS_CHANNEL_COUNT__MASK) == NEEDS_CHANNEL_1
+                        && isAudioChannelPositionMask(t->mMixerChannelMask)
+                        && t->channelMask == AUDIO_CHANNEL_OUT_MONO;
+                t->mFusedMix = kUseFusedMix
+                        && t->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+                        && (n & NEEDS_AUX) == 0
+                        && !monoExpand
+                        && (t->mMixerChannelCount == FCC_2
+                                || (t->mMixerChannelCount == 1
+                                        && (n & NEEDS_CHANNEL_COUNT__MASK) == NEEDS_CHANNEL_1));
             }
         }
     }
@@ -1072,12 +1251,49 @@ void AudioMixerBase::process__nop()
     }
 }
 
+// Helper to make a functional array from volumeMultiFused, indexed by track count.
+template <int NCHAN, std::size_t ... Is>
+static constexpr auto makeVMFArray(std::index_sequence<Is...>)
+{
+    using F = void(*)(float*, size_t, const float* const*, const float (*)[FCC_2]);
+    return std::array<F, sizeof...(Is)>{
+            { &volumeMultiFused<NCHAN, Is + 1> ... }
+        };
+}
+
+/* Accumulates tracks (1 to kMaxFusedTracks) of channels (1 or 2) interleaved
+ * float samples into out in a single pass.
+ */
+static void volumeMultiFused(uint32_t channels, size_t tracks, float* out, size_t frameCount,
+        const float* const* in, const float (*vol)[FCC_2])
+{
+    static constexpr auto volumeMultiFusedMonoArray =
+            makeVMFArray<1>(std::make_index_sequence<kMaxFusedTracks>());
+    static constexpr auto volumeMultiFusedStereoArray =
+            makeVMFArray<FCC_2>(std::make_index_sequence<kMaxFusedTracks>());
+    if (tracks == 0 || tracks > kMaxFusedTracks) {
+        ALOGE("%s: invalid track count:%zu", __func__, tracks);
+    } else if (channels == 1) {
+        volumeMultiFusedMonoArray[tracks - 1](out, frameCount, in, vol);
+    } else if (channels == FCC_2) {
+        volumeMultiFusedStereoArray[tracks - 1](out, frameCount, in, vol);
+    } else {
+        ALOGE("%s: invalid channel count:%d", __func__, channels);
+    }
+}
+
 // generic code without resampling
 void AudioMixerBase::process__genericNoResampling()
 {
     ALOGVV("process__genericNoResampling\n");
     int32_t outTemp[BLOCKSIZE * MAX_NUM_CHANNELS] __attribute__((aligned(32)));
 
+    // tracks batched for volumeMultiFused.
+    const float *fusedIn[kMaxFusedTracks];
+    float fusedVolume[kMaxFusedTracks][FCC_2];
+    size_t fusedTracks = 0;
+    uint32_t fusedChannels = 0;
+
     for (const auto &pair : mGroups) {
         // process by group of tracks with same output main buffer to
         // avoid multiple memset() on same buffer
@@ -1097,8 +1313,38 @@ void AudioMixerBase::process__genericNoResampling()
         do {
             const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
             memset(outTemp, 0, sizeof(outTemp));
+            auto flushFused = [&]() {
+                if (fusedTracks > 0) {
+                    volumeMultiFused(fusedChannels, fusedTracks,
+                            reinterpret_cast<float *>(outTemp), frameCount,
+                            fusedIn, fusedVolume);
+                    fusedTracks = 0;
+                }
+            };
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                // Float tracks at constant volume with the whole block available
+                // are batched, so outTemp is read and written once per batch.
+                if (t->mFusedMix && t->mIn != nullptr && t->frameCount >= frameCount
+                        && !t->needsRamp()) {
+                    if (fusedTracks > 0 && fusedChannels != t->mMixerChannelCount) {
+                        flushFused();
+                    }
+                    fusedChannels = t->mMixerChannelCount;
+                    const float *in = static_cast<const float *>(t->mIn);
+                    fusedIn[fusedTracks] = in;
+                    fusedVolume[fusedTracks][0] = t->mVolume[0];
+                    fusedVolume[fusedTracks][1] = t->mVolume[1];
+                    t->mIn = in + frameCount * fusedChannels;
+                    t->frameCount -= frameCount;
+                    if (++fusedTracks == kMaxFusedTracks) {
+                        flushFused();
+                    }
+                    continue;
+                }
+                // keep the accumulation order of tracks in the group.
+                flushFused();
+
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1133,6 +1379,7 @@ void AudioMixerBase::process__genericNoResampling()
                     }
                 }
             }
+            flushFused();
 
             const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
             convertMixerFormat(out, t1->mMixerFormat, outTemp, t1->mMixerInFormat,
@@ -1163,44 +1410,106 @@ void AudioMixerBase::process__genericResampling()
         const auto &group = pair.second;
         const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
 
-        // clear temp buffer
-        memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
-        for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
+        const size_t parts = parallelMixParts(group);
+        if (parts > 1) {
+            mixGroupParallel(group, parts, outTemp);
+        } else {
+            // clear temp buffer
+            memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
+            for (const int name : group) {
+                mixTrackResampling(mTracks[name].get(), outTemp,
+                        mResampleTemp.get() /* naked ptr */);
             }
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+void AudioMixerBase::mixTrackResampling(TrackBase *t, int32_t *outTemp, int32_t *resampleTemp)
+{
+    const size_t numFrames = mFrameCount;
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
 
-                size_t outFrames = 0;
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(outTemp, numFrames, resampleTemp, aux);
+    } else {
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+        size_t outFrames = 0;
+
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+            (t->*t->hook)(
+                    outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    resampleTemp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
-                }
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
+
+size_t AudioMixerBase::parallelMixParts(const std::vector<int> &group) const
+{
+    if (mParallelMixThreads <= 1 || group.size() < 2 * kMinTracksPerMixPart) return 1;
+    for (const int name : group) {
+        // aux buffers may be shared by tracks of different parts.
+        if (mTracks.at(name)->needs & NEEDS_AUX) return 1;
+    }
+    return std::min(mParallelMixThreads, group.size() / kMinTracksPerMixPart);
+}
+
+void AudioMixerBase::mixGroupParallel(
+        const std::vector<int> &group, size_t parts, int32_t *outTemp)
+{
+    const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+    const size_t sampleCount = t1->mMixerChannelCount * mFrameCount;
+    if (mMixWorkerPool == nullptr) {
+        mMixWorkerPool.reset(new MixWorkerPool(mParallelMixThreads,
+                MAX_NUM_CHANNELS * mFrameCount));
+    }
+
+    // Each part mixes a contiguous range of the group (in name order) into its
+    // own accumulator. Track state is only touched by the thread mixing its part.
+    const std::function<void(size_t)> work = [&](size_t part) {
+        int32_t *accumulator = part == 0 ? outTemp : mMixWorkerPool->accumulator(part);
+        int32_t *resampleTemp =
+                part == 0 ? mResampleTemp.get() : mMixWorkerPool->resampleTemp(part);
+        memset(accumulator, 0, sizeof(*accumulator) * sampleCount);
+        const size_t begin = group.size() * part / parts;
+        const size_t end = group.size() * (part + 1) / parts;
+        for (size_t i = begin; i < end; ++i) {
+            mixTrackResampling(mTracks.find(group[i])->second.get(), accumulator, resampleTemp);
+        }
+    };
+    mMixWorkerPool->run(parts, work);
+
+    // reduce in part order so the result does not depend on thread timing.
+    for (size_t part = 1; part < parts; ++part) {
+        const int32_t *accumulator = mMixWorkerPool->accumulator(part);
+        if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            float *out = reinterpret_cast<float *>(outTemp);
+            const float *in = reinterpret_cast<const float *>(accumulator);
+            for (size_t i = 0; i < sampleCount; ++i) {
+                out[i] += in[i];
+            }
+        } else {
+            for (size_t i = 0; i < sampleCount; ++i) {
+                outTemp[i] += accumulator[i];
             }
         }
-        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
     }
 }
 
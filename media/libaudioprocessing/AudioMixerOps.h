@@ -21,6 +21,14 @@
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -604,6 +612,86 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * volumeMultiFused accumulates NTRACKS float input tracks into a float output
+ * buffer in a single pass, so the accumulator is read and written once per
+ * block rather than once per track.
+ *
+ *   NCHAN:   number of input and output channels, 1 or 2 (interleaved).
+ *   NTRACKS: number of tracks to accumulate, 1 to kMaxFusedTracks.
+ *   in:      NTRACKS input buffers, each with frameCount * NCHAN samples.
+ *   vol:     NTRACKS constant volume pairs; vol[t][0] is applied to the left
+ *            (or mono) channel and vol[t][1] to the right channel.
+ *
+ * This is equivalent to NTRACKS calls of volumeMulti<MIXTYPE_MULTI, NCHAN>
+ * (or MIXTYPE_MULTI_STEREOVOL for NCHAN == 2) with no aux buffer, and the
+ * tracks are accumulated in order so the per-sample summation order matches.
+ */
+constexpr size_t kMaxFusedTracks = 8;
+
+template <int NCHAN, int NTRACKS>
+inline void volumeMultiFused(float* out, size_t frameCount,
+        const float* const* in, const float (*vol)[FCC_2])
+{
+    static_assert(NCHAN == 1 || NCHAN == 2);
+    static_assert(NTRACKS > 0 && NTRACKS <= kMaxFusedTracks);
+    const size_t sampleCount = frameCount * NCHAN;
+    size_t i = 0;
+
+    // The vector width is a multiple of NCHAN, so the volume pattern
+    // { vol[0], vol[1], ... } lines up with the interleaved samples.
+    // Multiply and add are kept separate to match the scalar rounding.
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    float32x4_t v[NTRACKS];
+    for (int t = 0; t < NTRACKS; ++t) {
+        const float pattern[4] = { vol[t][0], vol[t][NCHAN - 1], vol[t][0], vol[t][NCHAN - 1] };
+        v[t] = vld1q_f32(pattern);
+    }
+    for (; i + 4 <= sampleCount; i += 4) {
+        float32x4_t acc = vld1q_f32(out + i);
+        for (int t = 0; t < NTRACKS; ++t) {
+            acc = vaddq_f32(acc, vmulq_f32(vld1q_f32(in[t] + i), v[t]));
+        }
+        vst1q_f32(out + i, acc);
+    }
+#elif defined(__AVX2__)
+    __m256 v[NTRACKS];
+    for (int t = 0; t < NTRACKS; ++t) {
+        const float l = vol[t][0];
+        const float r = vol[t][NCHAN - 1];
+        v[t] = _mm256_setr_ps(l, r, l, r, l, r, l, r);
+    }
+    for (; i + 8 <= sampleCount; i += 8) {
+        __m256 acc = _mm256_loadu_ps(out + i);
+        for (int t = 0; t < NTRACKS; ++t) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(in[t] + i), v[t]));
+        }
+        _mm256_storeu_ps(out + i, acc);
+    }
+#elif defined(__SSE__)
+    __m128 v[NTRACKS];
+    for (int t = 0; t < NTRACKS; ++t) {
+        const float l = vol[t][0];
+        const float r = vol[t][NCHAN - 1];
+        v[t] = _mm_setr_ps(l, r, l, r);
+    }
+    for (; i + 4 <= sampleCount; i += 4) {
+        __m128 acc = _mm_loadu_ps(out + i);
+        for (int t = 0; t < NTRACKS; ++t) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(in[t] + i), v[t]));
+        }
+        _mm_storeu_ps(out + i, acc);
+    }
+#endif
+    for (; i < sampleCount; ++i) {
+        float acc = out[i];
+        for (int t = 0; t < NTRACKS; ++t) {
+            acc += MixMul<float, float, float>(in[t][i], vol[t][i % NCHAN]);
+        }
+        out[i] = acc;
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
@@ -21,7 +21,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <dlfcn.h>
+#include <map>
 #include <math.h>
+#include <mutex>
+#include <tuple>
 
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
@@ -42,6 +45,66 @@ constexpr size_t CACHE_LINE_SIZE = 64;
 
 namespace android {
 
+/*
+ * CoefficientCache shares designed polyphase filter banks across all
+ * AudioResamplerDyn instances in the process with the same coefficient type TC.
+ *
+ * The filter bank depends only on the design parameters (phases, half length,
+ * stopband attenuation and cutoff), which are in turn derived from the input
+ * rate, output rate and quality.  Coefficients are immutable once designed,
+ * so resamplers hold a shared_ptr and the cache holds only a weak_ptr; the
+ * buffer is freed when the last resampler using it changes rate or is destroyed.
+ */
+template<typename TC>
+class CoefficientCache {
+public:
+    // Returns the coefficients for the design, calling design(coefs) to fill
+    // a newly allocated buffer of (phases + 1) * halfLength elements if it is not cached.
+    template<typename F>
+    static std::shared_ptr<const TC> get(int phases, int halfLength,
+            double stopBandAtten, double fcr, F design) {
+        const Key key{phases, halfLength, stopBandAtten, fcr};
+        {
+            std::lock_guard lock(sMutex);
+            auto it = sCache.find(key);
+            if (it != sCache.end()) {
+                std::shared_ptr<const TC> coefs = it->second.lock();
+                if (coefs) return coefs;
+            }
+        }
+
+        // design outside of the lock, filter generation can take several milliseconds.
+        TC *coefs = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                (phases + 1) * halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        design(coefs);
+        std::shared_ptr<const TC> designed(coefs, [](const TC *p) { free((void *)p); });
+
+        std::lock_guard lock(sMutex);
+        for (auto it = sCache.begin(); it != sCache.end(); ) { // remove stale entries
+            it = it->second.expired() ? sCache.erase(it) : std::next(it);
+        }
+        auto [it, inserted] = sCache.try_emplace(key, designed);
+        if (!inserted) {
+            // another resampler designed the same filter concurrently, share theirs.
+            std::shared_ptr<const TC> coefs = it->second.lock();
+            if (coefs) return coefs;
+            it->second = designed;
+        }
+        return designed;
+    }
+
+private:
+    using Key = std::tuple<int /* phases */, int /* halfLength */,
+            double /* stopBandAtten */, double /* fcr */>;
+
+    static inline std::mutex sMutex;
+    static inline std::map<Key, std::weak_ptr<const TC>> sCache; // GUARDED_BY(sMutex)
+};
+
 /*
  * InBuffer is a type agnostic input buffer.
  *
@@ -181,8 +244,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +269,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -263,24 +324,17 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one already designed.
+    mCoefBuffer = CoefficientCache<TC>::get(phases, halfLength, stopBandAtten, fcr,
+            [&](TC *coefs) {
+        firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    });
+    c.mFirCoefs = mCoefBuffer.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +360,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
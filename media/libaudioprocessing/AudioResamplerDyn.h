@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_DYN_H
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
@@ -166,7 +167,9 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const TC> mCoefBuffer; // if a filter is created, this is not null.
+                                           // may be shared with other resamplers, see
+                                           // CoefficientCache in AudioResamplerDyn.cpp.
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
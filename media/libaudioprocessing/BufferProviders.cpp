@@ -19,6 +19,12 @@
 
 #include <algorithm>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <audio_utils/primitives.h>
 #include <audio_utils/format.h>
 #include <audio_utils/channels.h>
@@ -407,6 +413,135 @@ void ReformatBufferProvider::copyFrames(void *dst, const void *src, size_t frame
     memcpy_by_audio_format(dst, mOutputFormat, src, mInputFormat, frames * mChannelCount);
 }
 
+ReformatDownmixBufferProvider::ReformatDownmixBufferProvider(
+        audio_channel_mask_t inputChannelMask, audio_channel_mask_t outputChannelMask,
+        audio_format_t inputFormat, audio_format_t outputFormat, bool useChannelMix,
+        size_t bufferFrameCount) :
+        CopyBufferProvider(
+                audio_bytes_per_sample(inputFormat)
+                    * audio_channel_count_from_out_mask(inputChannelMask),
+                audio_bytes_per_sample(outputFormat)
+                    * audio_channel_count_from_out_mask(outputChannelMask),
+                bufferFrameCount),
+        mInputFormat(inputFormat),
+        mOutputFormat(outputFormat),
+        mInputChannels(audio_channel_count_from_out_mask(inputChannelMask)),
+        mOutputChannels(audio_channel_count_from_out_mask(outputChannelMask)),
+        mOutputSampleSize(audio_bytes_per_sample(outputFormat)),
+        mUseChannelMix(useChannelMix),
+        mScratch(new uint8_t[kBlockFrames * mInputChannels * mOutputSampleSize])
+{
+    ALOGV("ReformatDownmixBufferProvider(%p)(%#x, %#x, %#x, %#x, %d)",
+            this, inputFormat, outputFormat, inputChannelMask, outputChannelMask,
+            useChannelMix);
+    if (useChannelMix) {
+        if (outputChannelMask == AUDIO_CHANNEL_OUT_STEREO
+                && outputFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            mIsValid = mChannelMix.setInputChannelMask(inputChannelMask);
+        }
+    } else {
+        (void) memcpy_by_index_array_initialization_from_channel_mask(
+                mIdxAry, ARRAY_SIZE(mIdxAry), outputChannelMask, inputChannelMask);
+        mIsValid = true;
+    }
+}
+
+void ReformatDownmixBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
+{
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    while (frames > 0) {
+        const size_t count = std::min(frames, kBlockFrames);
+        if (mInputFormat == AUDIO_FORMAT_PCM_FLOAT && mOutputFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            // as ClampFloatBufferProvider, see b/68099072
+            memcpy_to_float_from_float_with_clamping((float *)mScratch.get(), (const float *)in,
+                    count * mInputChannels, FLOAT_NOMINAL_RANGE_HEADROOM);
+        } else {
+            memcpy_by_audio_format(mScratch.get(), mOutputFormat, in, mInputFormat,
+                    count * mInputChannels);
+        }
+        if (mUseChannelMix) {
+            mChannelMix.process((const float *)mScratch.get(), (float *)out,
+                    count, false /* accumulate */);
+        } else {
+            memcpy_by_index_array(out, mOutputChannels,
+                    mScratch.get(), mInputChannels, mIdxAry, mOutputSampleSize, count);
+        }
+        in += count * mInputFrameSize;
+        out += count * mOutputFrameSize;
+        frames -= count;
+    }
+}
+
+DownmixToMonoFloatBufferProvider::DownmixToMonoFloatBufferProvider(
+        audio_format_t inputFormat, size_t bufferFrameCount) :
+        CopyBufferProvider(
+                FCC_2 * audio_bytes_per_sample(inputFormat),
+                audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT),
+                bufferFrameCount),
+        mInputFormat(inputFormat)
+{
+    ALOGV("DownmixToMonoFloatBufferProvider(%p)(%#x)", this, inputFormat);
+    LOG_ALWAYS_FATAL_IF(inputFormat != AUDIO_FORMAT_PCM_16_BIT
+            && inputFormat != AUDIO_FORMAT_PCM_FLOAT,
+            "%s: unsupported format %#x", __func__, inputFormat);
+}
+
+void DownmixToMonoFloatBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
+{
+    float *out = (float *)dst;
+    size_t i = 0;
+    if (mInputFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        // (l + r) is exact in float, so scaling the sum by 0.5 / 32768 matches
+        // memcpy_to_float_from_i16() followed by downmix_to_mono_float_from_stereo_float().
+        constexpr float kScale = 1.f / (1 << 16);
+        const int16_t *in = (const int16_t *)src;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+        const float32x4_t scale = vdupq_n_f32(kScale);
+        for (; i + 8 <= frames; i += 8) {
+            const int16x8x2_t lr = vld2q_s16(in + i * FCC_2);
+            const int32x4_t lo = vaddl_s16(vget_low_s16(lr.val[0]), vget_low_s16(lr.val[1]));
+            const int32x4_t hi = vaddl_s16(vget_high_s16(lr.val[0]), vget_high_s16(lr.val[1]));
+            vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(lo), scale));
+            vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(hi), scale));
+        }
+#elif defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(kScale);
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 4 <= frames; i += 4) {
+            const __m128i lr = _mm_loadu_si128((const __m128i *)(in + i * FCC_2));
+            // multiply by one and add adjacent pairs: l + r as int32.
+            const __m128i sum = _mm_madd_epi16(lr, ones);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(sum), scale));
+        }
+#endif
+        for (; i < frames; ++i) {
+            out[i] = (float)(in[i * FCC_2] + in[i * FCC_2 + 1]) * kScale;
+        }
+    } else {
+        const float *in = (const float *)src;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        for (; i + 4 <= frames; i += 4) {
+            const float32x4x2_t lr = vld2q_f32(in + i * FCC_2);
+            vst1q_f32(out + i, vmulq_f32(vaddq_f32(lr.val[0], lr.val[1]), half));
+        }
+#elif defined(__SSE2__)
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= frames; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + i * FCC_2);
+            const __m128 b = _mm_loadu_ps(in + i * FCC_2 + 4);
+            const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(l, r), half));
+        }
+#endif
+        for (; i < frames; ++i) {
+            out[i] = (in[i * FCC_2] + in[i * FCC_2 + 1]) * 0.5f;
+        }
+    }
+}
+
 ClampFloatBufferProvider::ClampFloatBufferProvider(int32_t channelCount, size_t bufferFrameCount) :
         CopyBufferProvider(
                 channelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT),
@@ -56,6 +56,7 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
+            mDownmixOnInput(false),
             mInputConverterProvider(NULL)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
@@ -167,24 +168,29 @@ status_t RecordBufferConverter::updateParameters(
     mDstChannelCount = audio_channel_count_from_in_mask(dstChannelMask);
     mDstFrameSize = mDstChannelCount * audio_bytes_per_sample(mDstFormat);
 
+    // are we running legacy channel conversion modes?
+    mIsLegacyDownmix = (mSrcChannelMask == AUDIO_CHANNEL_IN_STEREO
+                            || mSrcChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK)
+                   && mDstChannelMask == AUDIO_CHANNEL_IN_MONO;
+    mIsLegacyUpmix = mSrcChannelMask == AUDIO_CHANNEL_IN_MONO
+                   && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
+                            || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
+
+    // Legacy downmix from 16 bit or float is done together with the conversion to float
+    // by the input converter, so the resampler (if any) only processes one channel.
+    mDownmixOnInput = mIsLegacyDownmix
+            && (mSrcFormat == AUDIO_FORMAT_PCM_16_BIT || mSrcFormat == AUDIO_FORMAT_PCM_FLOAT);
+
     // do we need to resample?
     delete mResampler;
     mResampler = NULL;
     if (mSrcSampleRate != mDstSampleRate) {
         mResampler = AudioResampler::create(AUDIO_FORMAT_PCM_FLOAT,
-                mSrcChannelCount, mDstSampleRate);
+                mDownmixOnInput ? 1 : mSrcChannelCount, mDstSampleRate);
         mResampler->setSampleRate(mSrcSampleRate);
         mResampler->setVolume(AudioMixer::UNITY_GAIN_FLOAT, AudioMixer::UNITY_GAIN_FLOAT);
     }
 
-    // are we running legacy channel conversion modes?
-    mIsLegacyDownmix = (mSrcChannelMask == AUDIO_CHANNEL_IN_STEREO
-                            || mSrcChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK)
-                   && mDstChannelMask == AUDIO_CHANNEL_IN_MONO;
-    mIsLegacyUpmix = mSrcChannelMask == AUDIO_CHANNEL_IN_MONO
-                   && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
-                            || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
-
     // do we need to process in float?
     mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
 
@@ -193,6 +199,8 @@ status_t RecordBufferConverter::updateParameters(
     if (mResampler != NULL) {
         mBufFrameSize = max(mSrcChannelCount, (uint32_t)FCC_2)
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
+    } else if (mDownmixOnInput) { // input converter provides float mono
+        mBufFrameSize = 0;
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
@@ -205,7 +213,11 @@ status_t RecordBufferConverter::updateParameters(
     // do we need an input converter buffer provider to give us float?
     delete mInputConverterProvider;
     mInputConverterProvider = NULL;
-    if (mRequiresFloat && mSrcFormat != AUDIO_FORMAT_PCM_FLOAT) {
+    if (mDownmixOnInput) {
+        mInputConverterProvider = new DownmixToMonoFloatBufferProvider(
+                mSrcFormat,
+                256 /* provider buffer frame count */);
+    } else if (mRequiresFloat && mSrcFormat != AUDIO_FORMAT_PCM_FLOAT) {
         mInputConverterProvider = new ReformatBufferProvider(
                 audio_channel_count_from_in_mask(mSrcChannelMask),
                 mSrcFormat,
@@ -225,6 +237,11 @@ void RecordBufferConverter::convertNoResampler(
         void *dst, const void *src, size_t frames)
 {
     // src is native type unless there is legacy upmix or downmix, whereupon it is float.
+    if (mDownmixOnInput) {
+        // src is already float mono
+        memcpy_by_audio_format(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT, frames);
+        return;
+    }
     if (mBufFrameSize != 0 && mBufFrames < frames) {
         free(mBuf);
         mBufFrames = frames;
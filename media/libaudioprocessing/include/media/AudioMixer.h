@@ -116,7 +116,9 @@ private:
          *    requires reformat. For example, it may convert floating point input to
          *    PCM_16_bit if that's required by the downmixer.
          * 4) mDownmixerBufferProvider: If not NULL, performs the channel remixing to match
-         *    the number of channels required by the mixer sink.
+         *    the number of channels required by the mixer sink. If mDownmixFused is set,
+         *    it is a ReformatDownmixBufferProvider doing the reformat of 3) as well, and
+         *    mReformatBufferProvider is NULL.
          * 5) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
          *    the downmixer requirements to the mixer engine input requirements.
          * 6) mTimestretchBufferProvider: Adds timestretching for playback rate
@@ -132,6 +134,17 @@ private:
                                                 // AUDIO_FORMAT_PCM_16_BIT if 16 bit necessary
                                                 // AUDIO_FORMAT_INVALID if no required format
 
+        // The built-in downmixers selected by prepareForDownmix() can be fused with the
+        // reformat by prepareForReformat(), see ReformatDownmixBufferProvider.
+        enum class DownmixType {
+            NONE,
+            EFFECT,         // DownmixerBufferProvider
+            CHANNEL_MIX,    // ChannelMixBufferProvider
+            REMIX,          // RemixBufferProvider
+        };
+        DownmixType          mDownmixType = DownmixType::NONE;
+        bool                 mDownmixFused = false; // mDownmixerBufferProvider also reformats
+
         AudioPlaybackRate    mPlaybackRate;
 
         // Haptic
@@ -92,7 +92,7 @@ public:
         , mFrameCount(frameCount) {
     }
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -135,6 +135,23 @@ public:
 
     std::string trackNames() const;
 
+    // Enable parallel mixing of the resampling process hook.
+    //
+    // \param threads     total number of threads mixing a group of tracks with the
+    //                    same main buffer, including the calling thread.
+    //                    0 or 1 disables parallel mixing (the default).
+    //
+    // Enabled tracks of a group are split into contiguous parts by name, each mixed
+    // into its own accumulator, and the accumulators are summed in part order before
+    // convertMixerFormat(), so the output is deterministic for a given track set.
+    // Worker threads are created on the first process() that needs them, and so
+    // inherit the scheduling of the thread calling process().
+    void        setParallelMixThreads(size_t threads);
+
+    // Returns a summary of the per part mix times, or an empty string if
+    // parallel mixing is disabled.
+    std::string parallelMixTimingToString() const;
+
   protected:
     // Set kUseNewMixer to true to use the new mixer engine always. Otherwise the
     // original code will be used for stereo sinks, the new mixer for everything else.
@@ -144,6 +161,10 @@ public:
     // If kUseNewMixer is false, this is ignored or may be overridden internally
     static constexpr bool kUseFloat = true;
 
+    // Set kUseFusedMix to true to accumulate float tracks with constant volume
+    // several at a time in process__genericNoResampling (see volumeMultiFused).
+    static constexpr bool kUseFusedMix = true;
+
 #ifdef FLOAT_AUX
     using TYPE_AUX = float;
     static_assert(kUseNewMixer && kUseFloat,
@@ -239,6 +260,7 @@ public:
         void volumeMix(TO *out, size_t outFrames, const TI *in, TA *aux, bool ramp);
 
         uint32_t    needs;
+        bool        mFusedMix = false; // may be mixed by volumeMultiFused without the hook
 
         // TODO: Eventually remove legacy integer volume settings
         union {
@@ -343,6 +365,15 @@ public:
     static void convertMixerFormat(void *out, audio_format_t mixerOutFormat,
             void *in, audio_format_t mixerInFormat, size_t sampleCount);
 
+    // Mixes one track for process__genericResampling into outTemp.
+    void mixTrackResampling(TrackBase *t, int32_t *outTemp, int32_t *resampleTemp);
+
+    // Returns the number of parts to mix group in, 1 if it should be mixed serially.
+    size_t parallelMixParts(const std::vector<int> &group) const;
+
+    // Mixes group in parts on the worker pool, the sum is left in outTemp.
+    void mixGroupParallel(const std::vector<int> &group, size_t parts, int32_t *outTemp);
+
     // initialization constants
     const uint32_t mSampleRate;
     const size_t mFrameCount;
@@ -363,6 +394,11 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // parallel mixing, see setParallelMixThreads().
+    class MixWorkerPool;
+    size_t mParallelMixThreads = 0;
+    std::unique_ptr<MixWorkerPool> mMixWorkerPool;
 };
 
 }  // namespace android
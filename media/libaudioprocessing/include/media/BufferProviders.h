@@ -17,6 +17,7 @@
 #ifndef ANDROID_BUFFER_PROVIDERS_H
 #define ANDROID_BUFFER_PROVIDERS_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -180,6 +181,54 @@ protected:
     const audio_format_t mOutputFormat;
 };
 
+// ReformatDownmixBufferProvider derives from CopyBufferProvider to convert the input
+// format and remix the channels in a single pass. It replaces a ReformatBufferProvider
+// (or ClampFloatBufferProvider for float input) stacked before a ChannelMixBufferProvider
+// or RemixBufferProvider, so the reformatted data is never written to an intermediate
+// buffer of its own. The conversion is done kBlockFrames at a time into a small scratch
+// buffer, which stays in cache, and then remixed into the output.
+class ReformatDownmixBufferProvider : public CopyBufferProvider {
+public:
+    // If useChannelMix is true, outputChannelMask must be AUDIO_CHANNEL_OUT_STEREO and
+    // outputFormat AUDIO_FORMAT_PCM_FLOAT, the same as ChannelMixBufferProvider.
+    // Otherwise channels are remixed by index as by RemixBufferProvider.
+    ReformatDownmixBufferProvider(audio_channel_mask_t inputChannelMask,
+            audio_channel_mask_t outputChannelMask, audio_format_t inputFormat,
+            audio_format_t outputFormat, bool useChannelMix, size_t bufferFrameCount);
+    //Overrides
+    void copyFrames(void *dst, const void *src, size_t frames) override;
+
+    bool isValid() const { return mIsValid; }
+
+protected:
+    static constexpr size_t kBlockFrames = 64;
+
+    const audio_format_t mInputFormat;
+    const audio_format_t mOutputFormat;
+    const size_t         mInputChannels;
+    const size_t         mOutputChannels;
+    const size_t         mOutputSampleSize;
+    const bool           mUseChannelMix;
+    audio_utils::channels::ChannelMix mChannelMix;
+    int8_t               mIdxAry[sizeof(uint32_t) * 8]; // 32 bits => channel indices
+    bool                 mIsValid = false;
+    std::unique_ptr<uint8_t[]> mScratch; // kBlockFrames of input channels in outputFormat
+};
+
+// DownmixToMonoFloatBufferProvider derives from CopyBufferProvider to convert
+// AUDIO_FORMAT_PCM_16_BIT or AUDIO_FORMAT_PCM_FLOAT stereo input to float mono
+// in a single pass. The result is the same as a ReformatBufferProvider to float
+// followed by downmix_to_mono_float_from_stereo_float().
+class DownmixToMonoFloatBufferProvider : public CopyBufferProvider {
+public:
+    DownmixToMonoFloatBufferProvider(audio_format_t inputFormat, size_t bufferFrameCount);
+    //Overrides
+    void copyFrames(void *dst, const void *src, size_t frames) override;
+
+protected:
+    const audio_format_t mInputFormat;
+};
+
 // ClampFloatBufferProvider derives from CopyBufferProvider to clamp floats inside -3db
 class ClampFloatBufferProvider : public CopyBufferProvider {
 public:
@@ -109,6 +109,7 @@ private:
     bool                 mIsLegacyDownmix;  // legacy stereo to mono conversion needed
     bool                 mIsLegacyUpmix;    // legacy mono to stereo conversion needed
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
+    bool                 mDownmixOnInput;   // legacy downmix done by mInputConverterProvider
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
 };
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the fused ReformatDownmixBufferProvider against the stacked
+// ReformatBufferProvider (or ClampFloatBufferProvider) followed by a
+// ChannelMixBufferProvider or RemixBufferProvider, as configured by
+// AudioMixer::Track::prepareForReformat().
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/BufferProviders.h>
+
+using namespace android;
+
+static constexpr size_t kCopyBufferFrameCount = 256; // as AudioMixer
+static constexpr size_t kFrameCount = 960;           // frames pulled per iteration
+
+// Provides kFrameCount frames of silence, indefinitely.
+class SourceProvider : public AudioBufferProvider {
+public:
+    explicit SourceProvider(size_t frameSize) : mBuffer(kFrameCount * frameSize) {}
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, kFrameCount);
+        buffer->raw = mBuffer.data();
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    std::vector<uint8_t> mBuffer;
+};
+
+static void pull(AudioBufferProvider *provider) {
+    for (size_t frames = kFrameCount; frames > 0; ) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = frames;
+        provider->getNextBuffer(&buffer);
+        if (buffer.frameCount == 0) break;
+        benchmark::DoNotOptimize(buffer.raw);
+        frames -= buffer.frameCount;
+        provider->releaseBuffer(&buffer);
+    }
+}
+
+// state.range(0) is the input format, state.range(1) the input channel mask,
+// state.range(2) is 1 to downmix with ChannelMix to stereo, 0 to remix to stereo.
+static void BM_Stacked(benchmark::State& state) {
+    const audio_format_t format = (audio_format_t)state.range(0);
+    const audio_channel_mask_t channelMask = (audio_channel_mask_t)state.range(1);
+    const bool useChannelMix = state.range(2) != 0;
+
+    SourceProvider source(audio_bytes_per_frame(
+            audio_channel_count_from_out_mask(channelMask), format));
+    std::unique_ptr<PassthruBufferProvider> reformat;
+    if (format == AUDIO_FORMAT_PCM_FLOAT) {
+        reformat.reset(new ClampFloatBufferProvider(
+                audio_channel_count_from_out_mask(channelMask), kCopyBufferFrameCount));
+    } else {
+        reformat.reset(new ReformatBufferProvider(
+                audio_channel_count_from_out_mask(channelMask), format,
+                AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+    }
+    std::unique_ptr<PassthruBufferProvider> downmix;
+    if (useChannelMix) {
+        downmix.reset(new ChannelMixBufferProvider(channelMask, AUDIO_CHANNEL_OUT_STEREO,
+                AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+    } else {
+        downmix.reset(new RemixBufferProvider(channelMask, AUDIO_CHANNEL_OUT_STEREO,
+                AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+    }
+    reformat->setBufferProvider(&source);
+    downmix->setBufferProvider(reformat.get());
+
+    for (auto _ : state) {
+        pull(downmix.get());
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void BM_Fused(benchmark::State& state) {
+    const audio_format_t format = (audio_format_t)state.range(0);
+    const audio_channel_mask_t channelMask = (audio_channel_mask_t)state.range(1);
+    const bool useChannelMix = state.range(2) != 0;
+
+    SourceProvider source(audio_bytes_per_frame(
+            audio_channel_count_from_out_mask(channelMask), format));
+    ReformatDownmixBufferProvider fused(channelMask, AUDIO_CHANNEL_OUT_STEREO,
+            format, AUDIO_FORMAT_PCM_FLOAT, useChannelMix, kCopyBufferFrameCount);
+    if (!fused.isValid()) {
+        state.SkipWithError("invalid configuration");
+        return;
+    }
+    fused.setBufferProvider(&source);
+
+    for (auto _ : state) {
+        pull(&fused);
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void FusedArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"format", "mask", "channelmix"});
+    for (int format : {AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_24_BIT_PACKED,
+            AUDIO_FORMAT_PCM_FLOAT}) {
+        // multichannel to stereo downmix.
+        for (int mask : {AUDIO_CHANNEL_OUT_5POINT1, AUDIO_CHANNEL_OUT_7POINT1}) {
+            b->Args({format, mask, 1});
+        }
+        // mono and stereo channel adjust.
+        for (int mask : {AUDIO_CHANNEL_OUT_MONO, AUDIO_CHANNEL_OUT_STEREO}) {
+            b->Args({format, mask, 0});
+        }
+    }
+}
+
+BENCHMARK(BM_Stacked)->Apply(FusedArgs);
+BENCHMARK(BM_Fused)->Apply(FusedArgs);
+
+// Capture path legacy stereo to mono downmix in RecordBufferConverter,
+// state.range(0) is the input format.
+static void BM_DownmixToMonoStacked(benchmark::State& state) {
+    const audio_format_t format = (audio_format_t)state.range(0);
+    SourceProvider source(audio_bytes_per_frame(FCC_2, format));
+    std::vector<float> mono(kFrameCount);
+    std::unique_ptr<PassthruBufferProvider> reformat;
+    if (format != AUDIO_FORMAT_PCM_FLOAT) {
+        reformat.reset(new ReformatBufferProvider(
+                FCC_2, format, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+        reformat->setBufferProvider(&source);
+    }
+    AudioBufferProvider *provider = reformat ? reformat.get() : (AudioBufferProvider *)&source;
+
+    for (auto _ : state) {
+        for (size_t frames = kFrameCount; frames > 0; ) {
+            AudioBufferProvider::Buffer buffer;
+            buffer.frameCount = frames;
+            provider->getNextBuffer(&buffer);
+            if (buffer.frameCount == 0) break;
+            downmix_to_mono_float_from_stereo_float(
+                    mono.data(), (const float *)buffer.raw, buffer.frameCount);
+            benchmark::DoNotOptimize(mono.data());
+            frames -= buffer.frameCount;
+            provider->releaseBuffer(&buffer);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void BM_DownmixToMonoFused(benchmark::State& state) {
+    const audio_format_t format = (audio_format_t)state.range(0);
+    SourceProvider source(audio_bytes_per_frame(FCC_2, format));
+    DownmixToMonoFloatBufferProvider fused(format, kCopyBufferFrameCount);
+    fused.setBufferProvider(&source);
+
+    for (auto _ : state) {
+        pull(&fused);
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+BENCHMARK(BM_DownmixToMonoStacked)->Arg(AUDIO_FORMAT_PCM_16_BIT)->Arg(AUDIO_FORMAT_PCM_FLOAT);
+BENCHMARK(BM_DownmixToMonoFused)->Arg(AUDIO_FORMAT_PCM_16_BIT)->Arg(AUDIO_FORMAT_PCM_FLOAT);
+
+BENCHMARK_MAIN();
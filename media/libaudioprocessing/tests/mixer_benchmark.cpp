@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End-to-end AudioMixer benchmark.
+//
+// Each benchmark configures an AudioMixer so that process__validate() selects
+// one of the process hooks, then calls AudioMixer::process() in a loop:
+//
+//   BM_MixerNop                 process__nop (all tracks muted)
+//   BM_MixerOneTrack            process__noResampleOneTrack
+//   BM_MixerGenericNoResampling process__genericNoResampling
+//   BM_MixerGenericResampling   process__genericResampling
+//
+// process__oneTrack16BitsStereoNoResampling is only used by the legacy
+// integer mixer (kUseNewMixer false) and is not reachable in this build.
+//
+// Results are reported as ns per output frame, and as the equivalent
+// CPU load (percent of one core) to mix in real time at 48 kHz.
+
+#include <algorithm>
+#include <chrono>
+#include <inttypes.h>
+#include <memory>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixer.h>
+
+using namespace android;
+
+static constexpr uint32_t kMixerSampleRate = 48000;
+
+// Provides an endless stream by looping over a one second buffer.
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(audio_format_t format, uint32_t channels, uint32_t sampleRate)
+        : mFrameSize(channels * audio_bytes_per_sample(format))
+        , mFrames(sampleRate)
+        , mBuffer(mFrames * mFrameSize) {
+        // fill with a low level ramp so the mixer processes nonzero data.
+        const size_t samples = mFrames * channels;
+        if (format == AUDIO_FORMAT_PCM_FLOAT) {
+            float *data = reinterpret_cast<float *>(mBuffer.data());
+            for (size_t i = 0; i < samples; ++i) data[i] = (i % 100) * 0.001f;
+        } else {
+            int16_t *data = reinterpret_cast<int16_t *>(mBuffer.data());
+            for (size_t i = 0; i < samples; ++i) data[i] = (i % 100) * 32;
+        }
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrames - mNextFrame);
+        buffer->raw = mBuffer.data() + mNextFrame * mFrameSize;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mNextFrame = (mNextFrame + buffer->frameCount) % mFrames;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrames;
+    std::vector<uint8_t> mBuffer;
+    size_t mNextFrame = 0;
+};
+
+// Benchmark arguments, in order.
+enum {
+    ARG_TRACKS,
+    ARG_CHANNELS,      // track channel count, the mixer is always stereo.
+    ARG_FLOAT,         // 1 for float track and mixer format, 0 for 16 bit.
+    ARG_SAMPLE_RATE,   // track sample rate.
+    ARG_FRAME_COUNT,   // mixer frame count.
+};
+
+static void runMixer(benchmark::State& state, float volume) {
+    const size_t tracks = state.range(ARG_TRACKS);
+    const uint32_t channels = state.range(ARG_CHANNELS);
+    const audio_format_t format =
+            state.range(ARG_FLOAT) ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const uint32_t sampleRate = state.range(ARG_SAMPLE_RATE);
+    const size_t frameCount = state.range(ARG_FRAME_COUNT);
+
+    const audio_channel_mask_t channelMask = audio_channel_out_mask_from_count(channels);
+    const audio_channel_mask_t mixerChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+    std::vector<uint8_t> out(frameCount * audio_bytes_per_frame(
+            audio_channel_count_from_out_mask(mixerChannelMask), format));
+
+    AudioMixer mixer(frameCount, kMixerSampleRate);
+    std::vector<std::unique_ptr<LoopProvider>> providers;
+    for (size_t name = 0; name < tracks; ++name) {
+        providers.emplace_back(new LoopProvider(format, channels, sampleRate));
+        if (mixer.create(name, channelMask, format, AUDIO_SESSION_OUTPUT_MIX) != OK) {
+            state.SkipWithError("cannot create track");
+            return;
+        }
+        mixer.setBufferProvider(name, providers.back().get());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, out.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)format);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                (void *)(uintptr_t)format);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)mixerChannelMask);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                (void *)(uintptr_t)channelMask);
+        // AudioMixer selects the resampler quality from the track sample rate,
+        // DEFAULT_QUALITY for music rates and DYN_LOW_QUALITY below.
+        mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)sampleRate);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+        mixer.enable(name);
+    }
+    mixer.process(); // process__validate() selects the process hook.
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        mixer.process();
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+    const double nsPerFrame = elapsedNs / (state.iterations() * frameCount);
+    state.counters["ns_per_frame"] = nsPerFrame;
+    state.counters["cpu_load_48k_pct"] = nsPerFrame * kMixerSampleRate * 1e-9 * 100.;
+    state.SetItemsProcessed(state.iterations() * frameCount);
+}
+
+static void BM_MixerNop(benchmark::State& state) {
+    runMixer(state, 0.f /* volume */);
+}
+
+static void BM_MixerOneTrack(benchmark::State& state) {
+    runMixer(state, 0.5f /* volume */);
+}
+
+static void BM_MixerGenericNoResampling(benchmark::State& state) {
+    runMixer(state, 0.5f /* volume */);
+}
+
+static void BM_MixerGenericResampling(benchmark::State& state) {
+    runMixer(state, 0.5f /* volume */);
+}
+
+static constexpr int kChannels[] = {1, 2, 6};
+static constexpr int kFrameCounts[] = {192, 240, 960};
+
+static void OneTrackArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"tracks", "channels", "float", "rate", "frames"});
+    for (int channels : kChannels) {
+        for (int useFloat : {0, 1}) {
+            for (int frames : kFrameCounts) {
+                b->Args({1, channels, useFloat, kMixerSampleRate, frames});
+            }
+        }
+    }
+}
+
+static void NoResamplingArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"tracks", "channels", "float", "rate", "frames"});
+    // a single track uses process__noResampleOneTrack, see OneTrackArgs.
+    for (int tracks : {2, 4, 8, 16, 32}) {
+        for (int channels : kChannels) {
+            for (int useFloat : {0, 1}) {
+                for (int frames : kFrameCounts) {
+                    b->Args({tracks, channels, useFloat, kMixerSampleRate, frames});
+                }
+            }
+        }
+    }
+}
+
+static void ResamplingArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"tracks", "channels", "float", "rate", "frames"});
+    for (int tracks : {1, 2, 4, 8, 16, 32}) {
+        for (int channels : kChannels) {
+            for (int useFloat : {0, 1}) {
+                // 44100 uses DEFAULT_QUALITY, 16000 uses DYN_LOW_QUALITY.
+                for (int rate : {44100, 16000}) {
+                    for (int frames : kFrameCounts) {
+                        b->Args({tracks, channels, useFloat, rate, frames});
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Muted tracks only, the cost of consuming data is measured.
+BENCHMARK(BM_MixerNop)->Apply(NoResamplingArgs);
+
+// A single track with constant volume uses process__noResampleOneTrack.
+BENCHMARK(BM_MixerOneTrack)->Apply(OneTrackArgs);
+
+BENCHMARK(BM_MixerGenericNoResampling)->Apply(NoResamplingArgs);
+
+BENCHMARK(BM_MixerGenericResampling)->Apply(ResamplingArgs);
+
+BENCHMARK_MAIN();
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <array>
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 #define LOG_ALWAYS_FATAL(...)
 
 #include <../AudioMixerOps.h>
@@ -72,6 +75,76 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Mixes the track count given by state.range(0) into a single output block,
+// one volumeMulti() pass per track, as process__genericNoResampling does for
+// tracks that are not fused.
+template <int NCHAN>
+static void BM_VolumeMultiPerTrack(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const size_t trackCount = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<std::vector<float>> in(trackCount, std::vector<float>(SAMPLE_COUNT, 0.5f));
+    float vol[2] = {0.25f, 0.5f};
+    float *aux = nullptr;
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        for (size_t t = 0; t < trackCount; ++t) {
+            volumeMulti<MIXTYPE_MULTI, NCHAN>(
+                    out.data(), FRAME_COUNT, in[t].data(), aux, vol, 0.f /* vola */);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT * trackCount);
+}
+
+template <int NCHAN, size_t ... Is>
+static constexpr auto makeFusedArray(std::index_sequence<Is...>) {
+    using F = void(*)(float*, size_t, const float* const*, const float (*)[FCC_2]);
+    return std::array<F, sizeof...(Is)>{ { &volumeMultiFused<NCHAN, Is + 1> ... } };
+}
+
+// Mixes the track count given by state.range(0) into a single output block,
+// kMaxFusedTracks tracks per volumeMultiFused() pass.
+template <int NCHAN>
+static void BM_VolumeMultiFused(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    static constexpr auto fused =
+            makeFusedArray<NCHAN>(std::make_index_sequence<kMaxFusedTracks>());
+    const size_t trackCount = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<std::vector<float>> in(trackCount, std::vector<float>(SAMPLE_COUNT, 0.5f));
+    std::vector<const float *> inPtrs;
+    std::vector<std::array<float, FCC_2>> vols(trackCount, {0.25f, 0.5f});
+    for (const auto &buffer : in) inPtrs.push_back(buffer.data());
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        for (size_t t = 0; t < trackCount; t += kMaxFusedTracks) {
+            const size_t tracks = std::min(kMaxFusedTracks, trackCount - t);
+            fused[tracks - 1](out.data(), FRAME_COUNT, &inPtrs[t],
+                    reinterpret_cast<const float (*)[FCC_2]>(vols[t].data()));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT * trackCount);
+}
+
+static void TrackCountArgs(benchmark::internal::Benchmark* b) {
+    for (int tracks : {1, 2, 4, 8, 16, 24, 32}) {
+        b->Arg(tracks);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 1)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiFused, 1)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 2)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiFused, 2)->Apply(TrackCountArgs);
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ThreadCpuSampler"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include <cpustats/ThreadCpuSampler.h>
+
+namespace android {
+
+static long long toNs(const struct timespec& ts)
+{
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void ThreadCpuSampler::Load::reset()
+{
+    mPercent.reset();
+    memset(mHistogram, 0, sizeof(mHistogram));
+}
+
+/*static*/
+ThreadCpuSampler& ThreadCpuSampler::getInstance()
+{
+    // never destroyed, as the sampling thread runs until process exit
+    static ThreadCpuSampler *instance = new ThreadCpuSampler();
+    return *instance;
+}
+
+ThreadCpuSampler::ThreadCpuSampler() :
+    mThreadStarted(false),
+    mRegistered(0)
+{
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mCond, NULL);
+    for (int i = 0; i < kMaxThreads; ++i) {
+        mEntries[i].mInUse = false;
+    }
+}
+
+int ThreadCpuSampler::registerCurrentThread(const char *name)
+{
+    clockid_t clock;
+    int rc = pthread_getcpuclockid(pthread_self(), &clock);
+    if (rc) {
+        ALOGE("pthread_getcpuclockid() for %s error=%d", name, rc);
+        return -1;
+    }
+
+    pthread_mutex_lock(&mMutex);
+    int handle = -1;
+    for (int i = 0; i < kMaxThreads; ++i) {
+        if (!mEntries[i].mInUse) {
+            handle = i;
+            break;
+        }
+    }
+    if (handle < 0) {
+        pthread_mutex_unlock(&mMutex);
+        ALOGW("can't sample %s, already sampling %d threads", name, kMaxThreads);
+        return -1;
+    }
+    Entry& entry = mEntries[handle];
+    entry.mInUse = true;
+    entry.mClock = clock;
+    entry.mPreviousKnown = false;
+    entry.mLoad.reset();
+    strncpy(entry.mLoad.mName, name, kNameLength - 1);
+    entry.mLoad.mName[kNameLength - 1] = '\0';
+    if (mRegistered++ == 0) {
+        pthread_cond_signal(&mCond);
+    }
+    if (!mThreadStarted) {
+        pthread_t thread;
+        rc = pthread_create(&thread, NULL, threadMain, this);
+        if (rc) {
+            ALOGE("pthread_create() error=%d", rc);
+        } else {
+            pthread_detach(thread);
+            mThreadStarted = true;
+        }
+    }
+    pthread_mutex_unlock(&mMutex);
+    ALOGV("registered %s as %d", name, handle);
+    return handle;
+}
+
+void ThreadCpuSampler::unregisterThread(int handle)
+{
+    if (handle < 0 || handle >= kMaxThreads) {
+        return;
+    }
+    pthread_mutex_lock(&mMutex);
+    if (mEntries[handle].mInUse) {
+        mEntries[handle].mInUse = false;
+        --mRegistered;
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+bool ThreadCpuSampler::getLoad(int handle, Load *load)
+{
+    if (handle < 0 || handle >= kMaxThreads) {
+        return false;
+    }
+    pthread_mutex_lock(&mMutex);
+    bool inUse = mEntries[handle].mInUse;
+    if (inUse) {
+        *load = mEntries[handle].mLoad;
+    }
+    pthread_mutex_unlock(&mMutex);
+    return inUse;
+}
+
+void ThreadCpuSampler::resetLoad(int handle)
+{
+    if (handle < 0 || handle >= kMaxThreads) {
+        return;
+    }
+    pthread_mutex_lock(&mMutex);
+    if (mEntries[handle].mInUse) {
+        mEntries[handle].mLoad.reset();
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+/*static*/
+void *ThreadCpuSampler::threadMain(void *arg)
+{
+    static_cast<ThreadCpuSampler *>(arg)->run();
+    return NULL;
+}
+
+void ThreadCpuSampler::run()
+{
+    const struct timespec period = {
+        (time_t) (kSamplePeriodNs / 1000000000LL), (long) (kSamplePeriodNs % 1000000000LL) };
+    pthread_mutex_lock(&mMutex);
+    for (;;) {
+        // don't wake up while no thread is registered
+        while (mRegistered == 0) {
+            pthread_cond_wait(&mCond, &mMutex);
+        }
+        pthread_mutex_unlock(&mMutex);
+        (void) nanosleep(&period, NULL);
+        pthread_mutex_lock(&mMutex);
+        sample_l();
+    }
+}
+
+void ThreadCpuSampler::sample_l()
+{
+    struct timespec wallTs;
+    if (clock_gettime(CLOCK_MONOTONIC, &wallTs)) {
+        ALOGE("clock_gettime(CLOCK_MONOTONIC) errno=%d", errno);
+        return;
+    }
+    const long long wallNs = toNs(wallTs);
+    for (int i = 0; i < kMaxThreads; ++i) {
+        Entry& entry = mEntries[i];
+        if (!entry.mInUse) {
+            continue;
+        }
+        struct timespec cpuTs;
+        if (clock_gettime(entry.mClock, &cpuTs)) {
+            ALOGW("clock_gettime() for %s errno=%d", entry.mLoad.mName, errno);
+            entry.mPreviousKnown = false;
+            continue;
+        }
+        const long long cpuNs = toNs(cpuTs);
+        if (entry.mPreviousKnown && wallNs > entry.mPreviousWallNs) {
+            double percent = (cpuNs - entry.mPreviousCpuNs) * 100.
+                    / (wallNs - entry.mPreviousWallNs);
+            // CPU and wall clocks are not read at the same instant
+            if (percent > 100.) {
+                percent = 100.;
+            } else if (percent < 0.) {
+                percent = 0.;
+            }
+            entry.mLoad.mPercent.sample(percent);
+            int bucket = (int) (percent * kLoadBuckets / 100.);
+            if (bucket >= kLoadBuckets) {
+                bucket = kLoadBuckets - 1;
+            }
+            ++entry.mLoad.mHistogram[bucket];
+        }
+        entry.mPreviousCpuNs = cpuNs;
+        entry.mPreviousWallNs = wallNs;
+        entry.mPreviousKnown = true;
+    }
+}
+
+}   // namespace android
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _THREAD_CPU_SAMPLER_H
+#define _THREAD_CPU_SAMPLER_H
+
+#include <pthread.h>
+#include <time.h>
+
+#include <cpustats/CentralTendencyStatistics.h>
+
+namespace android {
+
+// Continuous, low overhead CPU accounting for named threads of a process.
+// A thread registers itself, and from then on a single background thread of the
+// process samples its CPU time every kSamplePeriodNs through the thread's CPU-time
+// clock, see pthread_getcpuclockid(3).  The registered thread does no work per sample.
+// Each sample is the thread's load over the period: the percentage of wall clock
+// time it spent on a CPU.  The loads are kept as statistics and as a histogram,
+// until read and reset by whoever reports them (e.g. to media metrics).
+// A thread must unregister before it exits, as its CPU-time clock is then invalid;
+// ThreadCpuSampler::Scoped does both.
+// This class is thread-safe.
+
+class ThreadCpuSampler
+{
+
+public:
+    static const long long kSamplePeriodNs = 1000000000LL;  // 1 second
+    static const int kMaxThreads = 32;          // registered at the same time
+    static const int kNameLength = 16;          // including NUL, as for pthread_setname_np
+    static const int kLoadBuckets = 10;         // 10% each, the last one includes 100%
+
+    // The load sampled for a thread since its last reset.
+    struct Load {
+        char mName[kNameLength];
+        CentralTendencyStatistics mPercent;     // load per sample, in percent
+        unsigned mHistogram[kLoadBuckets];      // number of samples per load bucket
+
+        Load() { reset(); }
+        void reset();
+    };
+
+    static ThreadCpuSampler& getInstance();
+
+    // Register the current thread under name, truncated to kNameLength - 1 characters.
+    // Returns a handle for the other methods, or -1 if the thread can't be sampled.
+    int registerCurrentThread(const char *name);
+
+    // Stop sampling the thread of handle, which may then be reused by another thread.
+    void unregisterThread(int handle);
+
+    // Copy the load sampled for the thread of handle since its last reset.
+    // Returns false if handle is not registered.
+    bool getLoad(int handle, Load *load);
+
+    // Discard the load sampled for the thread of handle so far.
+    void resetLoad(int handle);
+
+    // Registers the current thread for the lifetime of the object.
+    class Scoped {
+    public:
+        explicit Scoped(const char *name) :
+            mHandle(ThreadCpuSampler::getInstance().registerCurrentThread(name)) { }
+        ~Scoped() { ThreadCpuSampler::getInstance().unregisterThread(mHandle); }
+        int handle() const { return mHandle; }
+    private:
+        const int mHandle;
+        Scoped(const Scoped&);
+        Scoped& operator=(const Scoped&);
+    };
+
+private:
+    ThreadCpuSampler();
+    ~ThreadCpuSampler() { }
+
+    struct Entry {
+        bool mInUse;
+        clockid_t mClock;           // CPU-time clock of the thread
+        bool mPreviousKnown;        // whether mPreviousCpuNs and mPreviousWallNs are set
+        long long mPreviousCpuNs;
+        long long mPreviousWallNs;
+        Load mLoad;
+    };
+
+    static void *threadMain(void *arg);
+    void run();
+    void sample_l();
+
+    pthread_mutex_t mMutex;
+    pthread_cond_t mCond;           // signaled when the first thread registers
+    bool mThreadStarted;            // the sampling thread runs until process exit
+    int mRegistered;                // number of entries in use
+    Entry mEntries[kMaxThreads];
+};
+
+}   // namespace android
+
+#endif //  _THREAD_CPU_SAMPLER_H
@@ -18,21 +18,30 @@
 #define LOG_TAG "FileSource"
 #include <utils/Log.h>
 
+#include <cutils/properties.h>
 #include <datasource/FileSource.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/FoundationUtils.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
 namespace android {
 
+// Files are only mapped on 32-bit processes up to this size, to leave room
+// in the address space.
+static const int64_t kMaxMapSizeOn32Bit = 256 * 1024 * 1024;
+
 FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
+      mMapBase(MAP_FAILED),
+      mMapSize(0),
+      mMapData(NULL),
       mName("<null>") {
 
     if (filename) {
@@ -43,6 +52,7 @@ FileSource::FileSource(const char *filename)
 
     if (mFd >= 0) {
         mLength = lseek64(mFd, 0, SEEK_END);
+        mapFile();
     } else {
         ALOGE("Failed to open file '%s'. (%s)", filename, strerror(errno));
     }
@@ -52,6 +62,9 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
+      mMapBase(MAP_FAILED),
+      mMapSize(0),
+      mMapData(NULL),
       mName("<null>") {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
@@ -87,9 +100,14 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
             (long long) mOffset,
             (long long) mLength);
 
+    mapFile();
 }
 
 FileSource::~FileSource() {
+    if (mMapBase != MAP_FAILED) {
+        munmap(mMapBase, mMapSize);
+        mMapBase = MAP_FAILED;
+    }
     if (mFd >= 0) {
         ::close(mFd);
         mFd = -1;
@@ -122,13 +140,46 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
+    if (mMapData != NULL && offset >= 0 && offset <= mLength
+            && (uint64_t)size <= (uint64_t)(mLength - offset)) {
+        memcpy(data, mMapData + offset, size);
+        return size;
+    }
+
+    ssize_t result = pread64(mFd, data, size, offset + mOffset);
     if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
         return UNKNOWN_ERROR;
     }
+    return result;
+}
+
+void FileSource::mapFile() {
+    // A mapped file that is truncated while it is played raises SIGBUS rather
+    // than a read error, so mapping is opt-in.
+    if (mFd < 0 || mLength <= 0
+            || !property_get_bool("media.datasource.file.mmap", false)) {
+        return;
+    }
+    if (sizeof(void *) < 8 && mLength > kMaxMapSizeOn32Bit) {
+        ALOGV("not mapping %lld bytes in a 32-bit process", (long long)mLength);
+        return;
+    }
 
-    return ::read(mFd, data, size);
+    int64_t pageSize = sysconf(_SC_PAGESIZE);
+    int64_t mapOffset = mOffset - mOffset % pageSize;
+    uint64_t mapSize = mLength + (mOffset - mapOffset);
+    if (mapSize > SIZE_MAX) {
+        return;
+    }
+    void *base = mmap64(NULL, mapSize, PROT_READ, MAP_SHARED, mFd, mapOffset);
+    if (base == MAP_FAILED) {
+        ALOGW("mmap of %s failed (%s), reading instead", mName.c_str(), strerror(errno));
+        return;
+    }
+    mMapBase = base;
+    mMapSize = mapSize;
+    mMapData = (const uint8_t *)base + (mOffset - mapOffset);
 }
 
 status_t FileSource::getSize(off64_t *size) {
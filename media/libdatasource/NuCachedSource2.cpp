@@ -37,6 +37,7 @@ struct PageCache {
     struct Page {
         void *mData;
         size_t mSize;
+        size_t mCapacity;
     };
 
     Page *acquirePage();
@@ -49,6 +50,14 @@ struct PageCache {
         return mTotalSize;
     }
 
+    size_t pageSize() const {
+        return mPageSize;
+    }
+
+    // Pages acquired from now on have |pageSize| bytes, pages of another size
+    // are freed as they are released.
+    void setPageSize(size_t pageSize);
+
     void copy(size_t from, void *data, size_t size);
 
 private:
@@ -86,6 +95,12 @@ void PageCache::freePages(List<Page *> *list) {
     }
 }
 
+void PageCache::setPageSize(size_t pageSize) {
+    mPageSize = pageSize;
+    freePages(&mFreePages);
+    mFreePages.clear();
+}
+
 PageCache::Page *PageCache::acquirePage() {
     if (!mFreePages.empty()) {
         List<Page *>::iterator it = mFreePages.begin();
@@ -98,11 +113,17 @@ PageCache::Page *PageCache::acquirePage() {
     Page *page = new Page;
     page->mData = malloc(mPageSize);
     page->mSize = 0;
+    page->mCapacity = mPageSize;
 
     return page;
 }
 
 void PageCache::releasePage(Page *page) {
+    if (page->mCapacity != mPageSize) {
+        free(page->mData);
+        delete page;
+        return;
+    }
     page->mSize = 0;
     mFreePages.push_back(page);
 }
@@ -197,7 +218,13 @@ NuCachedSource2::NuCachedSource2(
       mHighwaterThresholdBytes(kDefaultHighWaterThreshold),
       mLowwaterThresholdBytes(kDefaultLowWaterThreshold),
       mKeepAliveIntervalUs(kDefaultKeepAliveIntervalUs),
-      mDisconnectAtHighwatermark(disconnectAtHighwatermark) {
+      mAdaptivePageSize(true),
+      mDisconnectAtHighwatermark(disconnectAtHighwatermark),
+      mNumFetches(0),
+      mBytesFetched(0),
+      mNumCacheHits(0),
+      mNumCacheMisses(0),
+      mNumSeeks(0) {
     // We are NOT going to support disconnect-at-highwatermark indefinitely
     // and we are not guaranteeing support for client-specified cache
     // parameters. Both of these are temporary measures to solve a specific
@@ -232,6 +259,11 @@ NuCachedSource2::~NuCachedSource2() {
     mLooper->stop();
     mLooper->unregisterHandler(mReflector->id());
 
+    ALOGI("%s: %" PRId64 " bytes in %" PRId64 " fetches, last page size %zu, "
+            "%" PRId64 " reads from cache, %" PRId64 " waited, %" PRId64 " new ranges",
+            mName.string(), mBytesFetched, mNumFetches, mCache->pageSize(),
+            mNumCacheHits, mNumCacheMisses, mNumSeeks);
+
     delete mCache;
     mCache = NULL;
 }
@@ -364,10 +396,12 @@ void NuCachedSource2::fetchInternal() {
     PageCache::Page *page = mCache->acquirePage();
 
     ssize_t n = mSource->readAt(
-            mCacheOffset + mCache->totalSize(), page->mData, kPageSize);
+            mCacheOffset + mCache->totalSize(), page->mData, page->mCapacity);
 
     Mutex::Autolock autoLock(mLock);
 
+    ++mNumFetches;
+
     if (n == 0 || mDisconnecting) {
         ALOGI("caching reached eos.");
 
@@ -394,6 +428,32 @@ void NuCachedSource2::fetchInternal() {
 
         page->mSize = n;
         mCache->appendPage(page);
+        mBytesFetched += n;
+
+        if (mAdaptivePageSize) {
+            updatePageSize_l();
+        }
+    }
+}
+
+void NuCachedSource2::updatePageSize_l() {
+    int32_t kbps;
+    if (!(mSource->flags() & kIsHTTPBasedSource)
+            || static_cast<HTTPBase *>(mSource.get())->getEstimatedBandwidthKbps(&kbps) != OK
+            || kbps <= 0) {
+        return;
+    }
+
+    // Read about what arrives in kTargetFetchDurationMs per fetch, so that
+    // fast links are not held back by the round trip of each read.
+    size_t targetSize = (size_t)kbps * kTargetFetchDurationMs / 8;
+    size_t pageSize = kPageSize;
+    while (pageSize < targetSize && pageSize < kMaxPageSize) {
+        pageSize *= 2;
+    }
+    if (pageSize != mCache->pageSize()) {
+        ALOGV("page size %zu for %d kbps", pageSize, kbps);
+        mCache->setPageSize(pageSize);
     }
 }
 
@@ -533,10 +593,12 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         mCache->copy(delta, data, size);
 
         mLastAccessPos = offset + size;
+        ++mNumCacheHits;
 
         return size;
     }
 
+    ++mNumCacheMisses;
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -673,6 +735,7 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     ALOGI("new range: offset= %lld", (long long)offset);
 
     mCacheOffset = offset;
+    ++mNumSeeks;
 
     size_t totalSize = mCache->totalSize();
     CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
@@ -709,9 +772,10 @@ void NuCachedSource2::updateCacheParamsFromSystemProperty() {
 void NuCachedSource2::updateCacheParamsFromString(const char *s) {
     ssize_t lowwaterMarkKb, highwaterMarkKb;
     int keepAliveSecs;
+    ssize_t pageSizeKb = -1;
 
-    if (sscanf(s, "%zd/%zd/%d",
-               &lowwaterMarkKb, &highwaterMarkKb, &keepAliveSecs) != 3) {
+    if (sscanf(s, "%zd/%zd/%d/%zd",
+               &lowwaterMarkKb, &highwaterMarkKb, &keepAliveSecs, &pageSizeKb) < 3) {
         ALOGE("Failed to parse cache parameters from '%s'.", s);
         return;
     }
@@ -741,10 +805,20 @@ void NuCachedSource2::updateCacheParamsFromString(const char *s) {
         mKeepAliveIntervalUs = kDefaultKeepAliveIntervalUs;
     }
 
-    ALOGV("lowwater = %zu bytes, highwater = %zu bytes, keepalive = %lld us",
+    // A page size fixes it, otherwise it follows the bandwidth.
+    if (pageSizeKb > 0 && (size_t)pageSizeKb <= kMaxPageSize / 1024) {
+        mCache->setPageSize(pageSizeKb * 1024);
+        mAdaptivePageSize = false;
+    } else {
+        mCache->setPageSize(kPageSize);
+        mAdaptivePageSize = true;
+    }
+
+    ALOGV("lowwater = %zu bytes, highwater = %zu bytes, keepalive = %lld us, page = %zu bytes",
          mLowwaterThresholdBytes,
          mHighwaterThresholdBytes,
-         (long long)mKeepAliveIntervalUs);
+         (long long)mKeepAliveIntervalUs,
+         mCache->pageSize());
 }
 
 // static
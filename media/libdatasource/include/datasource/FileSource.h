@@ -56,8 +56,15 @@ protected:
     Mutex mLock;
 
 private:
+    // The file is mapped for reading when enabled by the
+    // media.datasource.file.mmap property, otherwise it is read with pread.
+    void *mMapBase;
+    size_t mMapSize;
+    const uint8_t *mMapData;  // at mOffset
     String8 mName;
 
+    void mapFile();
+
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
 };
@@ -84,7 +84,11 @@ private:
             bool disconnectAtHighwatermark);
 
     enum {
+        // Default and smallest page size, pages grow up to kMaxPageSize
+        // with the bandwidth unless the cache parameters set one.
         kPageSize                       = 65536,
+        kMaxPageSize                    = 1024 * 1024,
+        kTargetFetchDurationMs          = 250,
         kDefaultHighWaterThreshold      = 20 * 1024 * 1024,
         kDefaultLowWaterThreshold       = 4 * 1024 * 1024,
 
@@ -128,13 +132,23 @@ private:
     // If the keep-alive interval is 0, keep-alives are disabled.
     int64_t mKeepAliveIntervalUs;
 
+    bool mAdaptivePageSize;
+
     bool mDisconnectAtHighwatermark;
 
+    // statistics, logged when done
+    int64_t mNumFetches;
+    int64_t mBytesFetched;
+    int64_t mNumCacheHits;
+    int64_t mNumCacheMisses;
+    int64_t mNumSeeks;
+
     void onMessageReceived(const sp<AMessage> &msg);
     void onFetch();
     void onRead(const sp<AMessage> &msg);
 
     void fetchInternal();
+    void updatePageSize_l();
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ConvolutionReverb"
+
+#include <log/log.h>
+#include "ConvolutionReverb.h"
+#include <algorithm>
+
+namespace conv_fx {
+
+ConvolutionReverb::ConvolutionReverb(size_t channelCount, const std::vector<FloatVec> &irs,
+                                     size_t blockSize, size_t tailThreadCount)
+    : mChannelCount(channelCount),
+      mBlockSize(blockSize),
+      mDryLevel(0.0f),
+      mWetLevel(1.0f),
+      mChannelIn(blockSize),
+      mChannelOut(blockSize) {
+    LOG_ALWAYS_FATAL_IF(channelCount == 0 || (irs.size() != 1 && irs.size() != channelCount),
+            "%zu impulse responses for %zu channels", irs.size(), channelCount);
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        const FloatVec &ir = irs.size() == 1 ? irs[0] : irs[ch];
+        mConvolvers.push_back(std::make_unique<PartitionedConvolver>(
+                blockSize, ir.data(), ir.size(), tailThreadCount));
+    }
+}
+
+void ConvolutionReverb::process(const float *in, float *out, size_t frameCount) {
+    while (frameCount > 0) {
+        const size_t frames = std::min(frameCount, mBlockSize);
+        for (size_t ch = 0; ch < mChannelCount; ch++) {
+            for (size_t i = 0; i < frames; i++) {
+                mChannelIn[i] = in[i * mChannelCount + ch];
+            }
+            mConvolvers[ch]->process(mChannelIn.data(), mChannelOut.data(), frames);
+            for (size_t i = 0; i < frames; i++) {
+                const size_t index = i * mChannelCount + ch;
+                out[index] = mDryLevel * in[index] + mWetLevel * mChannelOut[i];
+            }
+        }
+        in += frames * mChannelCount;
+        out += frames * mChannelCount;
+        frameCount -= frames;
+    }
+}
+
+void ConvolutionReverb::reset() {
+    for (auto &convolver : mConvolvers) {
+        convolver->reset();
+    }
+}
+
+} //namespace conv_fx
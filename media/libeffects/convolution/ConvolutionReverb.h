@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONVOLUTION_REVERB_H_
+#define CONVOLUTION_REVERB_H_
+
+#include <memory>
+#include <vector>
+
+#include "PartitionedConvolver.h"
+
+namespace conv_fx {
+
+using FloatVec = std::vector<float>;
+
+/**
+ * Reverb or room simulation of interleaved float audio by convolution with measured impulse
+ * responses, one per channel or a single one for all channels.
+ *
+ * The wet signal is delayed by getLatencyFrames(), which acts as a pre-delay of the reverb; the
+ * dry signal is not delayed.
+ */
+class ConvolutionReverb {
+public:
+    ConvolutionReverb(size_t channelCount, const std::vector<FloatVec> &irs, size_t blockSize,
+                      size_t tailThreadCount = 0);
+
+    // in and out may be the same buffer.
+    void process(const float *in, float *out, size_t frameCount);
+
+    void reset();
+
+    void setLevels(float dryLevel, float wetLevel) {
+        mDryLevel = dryLevel;
+        mWetLevel = wetLevel;
+    }
+
+    size_t getLatencyFrames() const { return mConvolvers[0]->getLatencyFrames(); }
+
+private:
+    const size_t mChannelCount;
+    const size_t mBlockSize;
+    float mDryLevel;
+    float mWetLevel;
+    std::vector<std::unique_ptr<PartitionedConvolver>> mConvolvers;
+    FloatVec mChannelIn;    // one channel of up to mBlockSize frames
+    FloatVec mChannelOut;
+};
+
+} //namespace conv_fx
+
+#endif  // CONVOLUTION_REVERB_H_
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PartitionedConvolver"
+
+#include <log/log.h>
+#include "PartitionedConvolver.h"
+#include <algorithm>
+
+namespace conv_fx {
+
+PartitionedConvolver::PartitionedConvolver(size_t blockSize, const float *ir, size_t irFrames,
+                                           size_t tailThreadCount)
+    : mBlockSize(blockSize),
+      mPartitionCount(std::max<size_t>(1, (irFrames + blockSize - 1) / blockSize)),
+      mHeadPartitionCount(mPartitionCount),
+      mIrSpectra(mPartitionCount),
+      mInputSpectra(mPartitionCount, Eigen::VectorXcf::Zero(blockSize + 1)),
+      mNewest(0),
+      mInput(Eigen::VectorXf::Zero(2 * blockSize)),
+      mTime(2 * blockSize),
+      mSpectrum(blockSize + 1),
+      mOutput(blockSize),
+      mFill(0),
+      mJobSequence(0),
+      mTailNewest(0),
+      mPendingWorkers(0),
+      mQuit(false) {
+    LOG_ALWAYS_FATAL_IF(blockSize == 0 || blockSize % 2 != 0, "invalid block size %zu",
+            blockSize);
+    // Only the bins up to Nyquist are kept, real signals have a conjugate symmetric spectrum.
+    mFft.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+
+    Eigen::VectorXf partition(2 * blockSize);
+    for (size_t k = 0; k < mPartitionCount; k++) {
+        const size_t offset = k * blockSize;
+        const size_t frames = offset < irFrames ? std::min(blockSize, irFrames - offset) : 0;
+        partition.setZero();
+        std::copy(ir + offset, ir + offset + frames, partition.data());
+        mFft.fwd(mIrSpectra[k], partition);
+    }
+
+    // Partition 0 needs the current block, so it is always summed on the calling thread.
+    const size_t workerCount = std::min(tailThreadCount, mPartitionCount - 1);
+    if (workerCount > 0) {
+        mHeadPartitionCount = 1;
+        const size_t tailCount = mPartitionCount - mHeadPartitionCount;
+        for (size_t i = 0; i <= workerCount; i++) {
+            mTailBegin.push_back(mHeadPartitionCount + tailCount * i / workerCount);
+        }
+        mTailSpectra.assign(workerCount, Eigen::VectorXcf::Zero(blockSize + 1));
+        for (size_t i = 0; i < workerCount; i++) {
+            mWorkers.emplace_back(&PartitionedConvolver::workerLoop, this, i);
+        }
+    }
+}
+
+PartitionedConvolver::~PartitionedConvolver() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mQuit = true;
+    }
+    mJobCondition.notify_all();
+    for (auto &worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void PartitionedConvolver::process(const float *in, float *out, size_t frameCount) {
+    while (frameCount > 0) {
+        const size_t frames = std::min(frameCount, mBlockSize - mFill);
+        // The input is copied first, so that in and out may alias.
+        std::copy(in, in + frames, mInput.data() + mBlockSize + mFill);
+        std::copy(mOutput.begin() + mFill, mOutput.begin() + mFill + frames, out);
+        in += frames;
+        out += frames;
+        frameCount -= frames;
+        mFill += frames;
+        if (mFill == mBlockSize) {
+            processBlock();
+            mFill = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::reset() {
+    waitTail();
+    for (auto &spectrum : mInputSpectra) {
+        spectrum.setZero();
+    }
+    for (auto &spectrum : mTailSpectra) {
+        spectrum.setZero();
+    }
+    mNewest = 0;
+    mInput.setZero();
+    std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+    mFill = 0;
+}
+
+void PartitionedConvolver::processBlock() {
+    mNewest = (mNewest + 1) % mPartitionCount;
+    mFft.fwd(mInputSpectra[mNewest], mInput);
+
+    waitTail();
+    accumulate(mSpectrum, 0, mHeadPartitionCount, mNewest);
+    for (const auto &spectrum : mTailSpectra) {
+        mSpectrum += spectrum;
+    }
+
+    // Overlap-save: the first half of the inverse FFT is circular aliasing.
+    mFft.inv(mTime, mSpectrum);
+    std::copy(mTime.data() + mBlockSize, mTime.data() + 2 * mBlockSize, mOutput.begin());
+    mInput.head(mBlockSize) = mInput.tail(mBlockSize);
+
+    if (!mWorkers.empty()) {
+        startTail((mNewest + 1) % mPartitionCount);
+    }
+}
+
+void PartitionedConvolver::accumulate(Eigen::VectorXcf &acc, size_t firstPartition,
+                                      size_t endPartition, size_t newest) const {
+    acc.setZero();
+    for (size_t k = firstPartition; k < endPartition; k++) {
+        const size_t index = (newest + mPartitionCount - k) % mPartitionCount;
+        acc.array() += mInputSpectra[index].array() * mIrSpectra[k].array();
+    }
+}
+
+void PartitionedConvolver::startTail(size_t newest) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTailNewest = newest;
+        mPendingWorkers = mWorkers.size();
+        mJobSequence++;
+    }
+    mJobCondition.notify_all();
+}
+
+void PartitionedConvolver::waitTail() {
+    if (mWorkers.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCondition.wait(lock, [this] { return mPendingWorkers == 0; });
+}
+
+void PartitionedConvolver::workerLoop(size_t worker) {
+    uint64_t sequence = 0;
+    for (;;) {
+        size_t newest;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mJobCondition.wait(lock, [&] { return mQuit || mJobSequence != sequence; });
+            if (mQuit) {
+                return;
+            }
+            sequence = mJobSequence;
+            newest = mTailNewest;
+        }
+        // The slot of the newest block is not read here, so the calling thread can fill it
+        // while the tail is summed.
+        accumulate(mTailSpectra[worker], mTailBegin[worker], mTailBegin[worker + 1], newest);
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            done = --mPendingWorkers == 0;
+        }
+        if (done) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+} //namespace conv_fx
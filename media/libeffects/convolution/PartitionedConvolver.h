@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARTITIONED_CONVOLVER_H_
+#define PARTITIONED_CONVOLVER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
+
+namespace conv_fx {
+
+/**
+ * Uniformly partitioned overlap-save convolution of a mono signal with an impulse response.
+ *
+ * The impulse response is split into partitions of blockSize frames, each kept as the spectrum
+ * of a 2 * blockSize FFT. Every block of input is transformed once, into a frequency domain
+ * delay line, and the output block is the inverse FFT of the sum of the products of the delay
+ * line with the partition spectra. The output is delayed by blockSize frames.
+ *
+ * With tail threads, the partitions after the first one are summed on worker threads, each
+ * taking an equal share. The tail of the next block only needs input that is already in the
+ * delay line, so it is computed between two blocks and process() only waits for it when the
+ * workers are late. This moves the cost of long impulse responses off the calling thread.
+ */
+class PartitionedConvolver {
+public:
+    // blockSize must be even, and should be a power of 2 for the FFT.
+    PartitionedConvolver(size_t blockSize, const float *ir, size_t irFrames,
+                         size_t tailThreadCount = 0);
+    ~PartitionedConvolver();
+
+    PartitionedConvolver(const PartitionedConvolver&) = delete;
+    PartitionedConvolver& operator=(const PartitionedConvolver&) = delete;
+
+    // in and out may be the same buffer.
+    void process(const float *in, float *out, size_t frameCount);
+
+    void reset();
+
+    size_t getLatencyFrames() const { return mBlockSize; }
+    size_t getPartitionCount() const { return mPartitionCount; }
+    size_t getTailThreadCount() const { return mWorkers.size(); }
+
+private:
+    void processBlock();
+    // Sums the products of partitions [firstPartition, endPartition) with the delay line,
+    // where newest is the delay line index of the input of partition 0.
+    void accumulate(Eigen::VectorXcf &acc, size_t firstPartition, size_t endPartition,
+                    size_t newest) const;
+    void startTail(size_t newest);
+    void waitTail();
+    void workerLoop(size_t worker);
+
+    const size_t mBlockSize;
+    const size_t mPartitionCount;
+    // Partitions summed on the calling thread, all of them without tail threads.
+    size_t mHeadPartitionCount;
+
+    Eigen::FFT<float> mFft;
+    std::vector<Eigen::VectorXcf> mIrSpectra;
+    // Frequency domain delay line of the input, mInputSpectra[mNewest] is the last block.
+    std::vector<Eigen::VectorXcf> mInputSpectra;
+    size_t mNewest;
+
+    Eigen::VectorXf mInput;     // the previous block, then the block being filled
+    Eigen::VectorXf mTime;      // inverse FFT of the output block
+    Eigen::VectorXcf mSpectrum; // output block spectrum
+    std::vector<float> mOutput; // the last output block
+    size_t mFill;               // frames in the current block
+
+    // Tail threads, each summing partitions [mTailBegin[i], mTailBegin[i + 1]).
+    std::vector<std::thread> mWorkers;
+    std::vector<size_t> mTailBegin;
+    std::vector<Eigen::VectorXcf> mTailSpectra;
+    std::mutex mLock;
+    std::condition_variable mJobCondition;
+    std::condition_variable mDoneCondition;
+    uint64_t mJobSequence;  // guarded by mLock
+    size_t mTailNewest;     // guarded by mLock
+    size_t mPendingWorkers; // guarded by mLock
+    bool mQuit;             // guarded by mLock
+};
+
+} //namespace conv_fx
+
+#endif  // PARTITIONED_CONVOLVER_H_
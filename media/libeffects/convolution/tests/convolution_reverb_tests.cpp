@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ConvolutionReverb.h"
+
+using namespace conv_fx;
+
+static FloatVec randomSignal(size_t frames, unsigned seed) {
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    FloatVec signal(frames);
+    for (auto &sample : signal) {
+        sample = dis(gen);
+    }
+    return signal;
+}
+
+// Direct convolution, delayed by latency frames.
+static FloatVec convolve(const FloatVec &in, const FloatVec &ir, size_t latency) {
+    FloatVec out(in.size());
+    for (size_t n = latency; n < in.size(); n++) {
+        double sum = 0;
+        for (size_t m = 0; m < ir.size() && m <= n - latency; m++) {
+            sum += (double)ir[m] * in[n - latency - m];
+        }
+        out[n] = sum;
+    }
+    return out;
+}
+
+// blockSize, irFrames, tailThreadCount
+using ConvolverTestParam = std::tuple<size_t, size_t, size_t>;
+class PartitionedConvolverTest : public ::testing::TestWithParam<ConvolverTestParam> {};
+
+TEST_P(PartitionedConvolverTest, MatchesDirectConvolution) {
+    const auto [blockSize, irFrames, tailThreadCount] = GetParam();
+    const FloatVec ir = randomSignal(irFrames, 1);
+    const FloatVec in = randomSignal(8 * blockSize + irFrames + 123, 2);
+    const FloatVec expected = convolve(in, ir, blockSize);
+
+    PartitionedConvolver convolver(blockSize, ir.data(), ir.size(), tailThreadCount);
+    EXPECT_EQ(blockSize, convolver.getLatencyFrames());
+    // Process in buffers not aligned with the blocks, in place for half of them.
+    FloatVec out = in;
+    std::minstd_rand gen(3);
+    for (size_t offset = 0; offset < out.size();) {
+        const size_t frames = std::min<size_t>(out.size() - offset, 1 + gen() % (2 * blockSize));
+        if (offset % 2 == 0) {
+            convolver.process(&out[offset], &out[offset], frames);
+        } else {
+            FloatVec buffer(in.begin() + offset, in.begin() + offset + frames);
+            convolver.process(buffer.data(), &out[offset], frames);
+        }
+        offset += frames;
+    }
+    for (size_t i = 0; i < out.size(); i++) {
+        ASSERT_NEAR(expected[i], out[i], 1e-3f) << "at frame " << i;
+    }
+
+    // After a reset, the output is the same as the first time.
+    convolver.reset();
+    FloatVec again(in.size());
+    convolver.process(in.data(), again.data(), in.size());
+    for (size_t i = 0; i < again.size(); i++) {
+        ASSERT_NEAR(expected[i], again[i], 1e-3f) << "at frame " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        PartitionedConvolverAll, PartitionedConvolverTest,
+        ::testing::Combine(::testing::Values(16, 64, 256),
+                           ::testing::Values(1, 100, 1000, 3001),
+                           ::testing::Values(0, 1, 3)));
+
+TEST(ConvolutionReverbTest, MixesDryAndWet) {
+    constexpr size_t kChannelCount = 2;
+    constexpr size_t kBlockSize = 64;
+    constexpr size_t kFrames = 1000;
+    const std::vector<FloatVec> irs{randomSignal(300, 4), randomSignal(200, 5)};
+    const FloatVec in = randomSignal(kFrames * kChannelCount, 6);
+
+    ConvolutionReverb reverb(kChannelCount, irs, kBlockSize);
+    reverb.setLevels(0.5f /* dryLevel */, 0.25f /* wetLevel */);
+    FloatVec out(in.size());
+    reverb.process(in.data(), out.data(), kFrames);
+
+    for (size_t ch = 0; ch < kChannelCount; ch++) {
+        FloatVec channel(kFrames);
+        for (size_t i = 0; i < kFrames; i++) {
+            channel[i] = in[i * kChannelCount + ch];
+        }
+        const FloatVec wet = convolve(channel, irs[ch], reverb.getLatencyFrames());
+        for (size_t i = 0; i < kFrames; i++) {
+            ASSERT_NEAR(0.5f * channel[i] + 0.25f * wet[i], out[i * kChannelCount + ch], 1e-3f)
+                    << "at frame " << i << " channel " << ch;
+        }
+    }
+}
@@ -21,6 +21,12 @@
 #include "EffectDownmix.h"
 #include <audio_utils/ChannelMix.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // Do not submit with DOWNMIX_TEST_CHANNEL_INDEX defined, strictly for testing
 //#define DOWNMIX_TEST_CHANNEL_INDEX 0
 // Do not submit with DOWNMIX_ALWAYS_USE_GENERIC_DOWNMIXER defined, strictly for testing
@@ -34,6 +40,8 @@ typedef enum {
     DOWNMIX_STATE_ACTIVE,
 } downmix_state_t;
 
+typedef void (*downmix_fold_func_t)(const float *pSrc, float *pDst, size_t numFrames);
+
 /* parameters for each downmixer */
 struct downmix_object_t {
     downmix_state_t state;
@@ -41,6 +49,8 @@ struct downmix_object_t {
     bool apply_volume_correction;
     uint8_t input_channel_count;
     android::audio_utils::channels::ChannelMix channelMix;
+    // layout specialized fold selected by Downmix_Configure(), nullptr to use channelMix
+    downmix_fold_func_t foldFunc;
 };
 
 typedef struct downmix_module_s {
@@ -123,6 +133,225 @@ static inline float clamp_float(float value) {
     return fmin(fmax(value, -1.f), 1.f);
 }
 
+/*----------------------------------------------------------------------------
+ * Layout specialized fold to stereo
+ *--------------------------------------------------------------------------*/
+
+// Fold coefficients by channel position index, the same matrix as ChannelMix.
+static constexpr float COEF_25 = 0.2508909536f;
+static constexpr float COEF_35 = 0.3543928915f;
+static constexpr float COEF_36 = 0.3552343859f;
+static constexpr float COEF_61 = 0.6057043428f;
+static constexpr float MINUS_3_DB = MINUS_3_DB_IN_FLOAT;
+
+static constexpr float kFoldLeft[FCC_26] = {
+    1.f,        // AUDIO_CHANNEL_OUT_FRONT_LEFT
+    0.f,        // AUDIO_CHANNEL_OUT_FRONT_RIGHT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_FRONT_CENTER
+    0.5f,       // AUDIO_CHANNEL_OUT_LOW_FREQUENCY
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_BACK_LEFT
+    0.f,        // AUDIO_CHANNEL_OUT_BACK_RIGHT
+    COEF_61,    // AUDIO_CHANNEL_OUT_FRONT_LEFT_OF_CENTER
+    COEF_25,    // AUDIO_CHANNEL_OUT_FRONT_RIGHT_OF_CENTER
+    0.5f,       // AUDIO_CHANNEL_OUT_BACK_CENTER
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_SIDE_LEFT
+    0.f,        // AUDIO_CHANNEL_OUT_SIDE_RIGHT
+    COEF_36,    // AUDIO_CHANNEL_OUT_TOP_CENTER
+    1.f,        // AUDIO_CHANNEL_OUT_TOP_FRONT_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_TOP_FRONT_CENTER
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_FRONT_RIGHT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_TOP_BACK_LEFT
+    COEF_35,    // AUDIO_CHANNEL_OUT_TOP_BACK_CENTER
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_BACK_RIGHT
+    COEF_61,    // AUDIO_CHANNEL_OUT_TOP_SIDE_LEFT
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_SIDE_RIGHT
+    1.f,        // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_CENTER
+    0.f,        // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_RIGHT
+    0.f,        // AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT
+    0.f,        // AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT
+};
+
+static constexpr float kFoldRight[FCC_26] = {
+    0.f,        // AUDIO_CHANNEL_OUT_FRONT_LEFT
+    1.f,        // AUDIO_CHANNEL_OUT_FRONT_RIGHT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_FRONT_CENTER
+    0.5f,       // AUDIO_CHANNEL_OUT_LOW_FREQUENCY
+    0.f,        // AUDIO_CHANNEL_OUT_BACK_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_BACK_RIGHT
+    COEF_25,    // AUDIO_CHANNEL_OUT_FRONT_LEFT_OF_CENTER
+    COEF_61,    // AUDIO_CHANNEL_OUT_FRONT_RIGHT_OF_CENTER
+    0.5f,       // AUDIO_CHANNEL_OUT_BACK_CENTER
+    0.f,        // AUDIO_CHANNEL_OUT_SIDE_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_SIDE_RIGHT
+    COEF_36,    // AUDIO_CHANNEL_OUT_TOP_CENTER
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_FRONT_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_TOP_FRONT_CENTER
+    1.f,        // AUDIO_CHANNEL_OUT_TOP_FRONT_RIGHT
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_BACK_LEFT
+    COEF_35,    // AUDIO_CHANNEL_OUT_TOP_BACK_CENTER
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_TOP_BACK_RIGHT
+    0.f,        // AUDIO_CHANNEL_OUT_TOP_SIDE_LEFT
+    COEF_61,    // AUDIO_CHANNEL_OUT_TOP_SIDE_RIGHT
+    0.f,        // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_CENTER
+    1.f,        // AUDIO_CHANNEL_OUT_BOTTOM_FRONT_RIGHT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2
+    0.f,        // AUDIO_CHANNEL_OUT_FRONT_WIDE_LEFT
+    MINUS_3_DB, // AUDIO_CHANNEL_OUT_FRONT_WIDE_RIGHT
+};
+
+// Left and right fold coefficients for the channels present in MASK, in sample order.
+template <audio_channel_mask_t MASK>
+struct FoldCoefficients {
+    static constexpr size_t kChannelCount = __builtin_popcount(MASK);
+    float left[kChannelCount];
+    float right[kChannelCount];
+
+    constexpr FoldCoefficients() : left{}, right{} {
+        size_t channel = 0;
+        for (size_t index = 0; index < FCC_26; ++index) {
+            if ((MASK & (1u << index)) != 0) {
+                left[channel] = kFoldLeft[index];
+                right[channel] = kFoldRight[index];
+                ++channel;
+            }
+        }
+    }
+};
+
+/*
+ * Folds numFrames frames of MASK layout to stereo, with the channel loop unrolled
+ * at compile time and a SIMD multiply-accumulate of 4 input channels at a time.
+ * The layouts specialized have an even channel count, so the remainder is 0 or 2.
+ */
+template <audio_channel_mask_t MASK, bool ACCUMULATE>
+static void Downmix_foldToStereo(const float *pSrc, float *pDst, size_t numFrames) {
+    static constexpr FoldCoefficients<MASK> kCoefs{};
+    constexpr size_t N = FoldCoefficients<MASK>::kChannelCount;
+    static_assert(N >= 4 && N % 2 == 0, "specialized layouts must have an even channel count");
+
+#if defined(__aarch64__) || defined(__ARM_NEON__) || defined(__SSE2__)
+    constexpr size_t kGroups = N / 4;
+    constexpr bool kPair = (N % 4) != 0;
+#endif
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    float32x4_t coefL[kGroups], coefR[kGroups];
+    for (size_t g = 0; g < kGroups; ++g) {
+        coefL[g] = vld1q_f32(&kCoefs.left[g * 4]);
+        coefR[g] = vld1q_f32(&kCoefs.right[g * 4]);
+    }
+    float32x2_t pairL = vdup_n_f32(0.f);
+    float32x2_t pairR = vdup_n_f32(0.f);
+    if constexpr (kPair) {
+        pairL = vld1_f32(&kCoefs.left[kGroups * 4]);
+        pairR = vld1_f32(&kCoefs.right[kGroups * 4]);
+    }
+    const float32x2_t minusOne = vdup_n_f32(-1.f);
+    const float32x2_t one = vdup_n_f32(1.f);
+    for (; numFrames > 0; --numFrames, pSrc += N, pDst += 2) {
+        const float32x4_t in0 = vld1q_f32(pSrc);
+        float32x4_t accL = vmulq_f32(in0, coefL[0]);
+        float32x4_t accR = vmulq_f32(in0, coefR[0]);
+        for (size_t g = 1; g < kGroups; ++g) {
+            const float32x4_t in = vld1q_f32(pSrc + g * 4);
+            accL = vmlaq_f32(accL, in, coefL[g]);
+            accR = vmlaq_f32(accR, in, coefR[g]);
+        }
+        float32x2_t l = vadd_f32(vget_low_f32(accL), vget_high_f32(accL));
+        float32x2_t r = vadd_f32(vget_low_f32(accR), vget_high_f32(accR));
+        if constexpr (kPair) {
+            const float32x2_t in = vld1_f32(pSrc + kGroups * 4);
+            l = vmla_f32(l, in, pairL);
+            r = vmla_f32(r, in, pairR);
+        }
+        float32x2_t out = vpadd_f32(l, r); // {left, right}
+        if constexpr (ACCUMULATE) {
+            out = vadd_f32(out, vld1_f32(pDst));
+        }
+        vst1_f32(pDst, vmin_f32(vmax_f32(out, minusOne), one));
+    }
+#elif defined(__SSE2__)
+    __m128 coefL[kGroups + 1], coefR[kGroups + 1];
+    for (size_t g = 0; g < kGroups; ++g) {
+        coefL[g] = _mm_loadu_ps(&kCoefs.left[g * 4]);
+        coefR[g] = _mm_loadu_ps(&kCoefs.right[g * 4]);
+    }
+    if constexpr (kPair) {
+        coefL[kGroups] = _mm_setr_ps(
+                kCoefs.left[kGroups * 4], kCoefs.left[kGroups * 4 + 1], 0.f, 0.f);
+        coefR[kGroups] = _mm_setr_ps(
+                kCoefs.right[kGroups * 4], kCoefs.right[kGroups * 4 + 1], 0.f, 0.f);
+    }
+    const __m128 minusOne = _mm_set1_ps(-1.f);
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; numFrames > 0; --numFrames, pSrc += N, pDst += 2) {
+        __m128 accL = _mm_setzero_ps();
+        __m128 accR = _mm_setzero_ps();
+        for (size_t g = 0; g < kGroups; ++g) {
+            const __m128 in = _mm_loadu_ps(pSrc + g * 4);
+            accL = _mm_add_ps(accL, _mm_mul_ps(in, coefL[g]));
+            accR = _mm_add_ps(accR, _mm_mul_ps(in, coefR[g]));
+        }
+        if constexpr (kPair) {
+            const __m128 in = _mm_castpd_ps(_mm_load_sd((const double *)(pSrc + kGroups * 4)));
+            accL = _mm_add_ps(accL, _mm_mul_ps(in, coefL[kGroups]));
+            accR = _mm_add_ps(accR, _mm_mul_ps(in, coefR[kGroups]));
+        }
+        // {l0 + l2, r0 + r2, l1 + l3, r1 + r3} then {left, right, x, x}
+        __m128 sum = _mm_add_ps(_mm_unpacklo_ps(accL, accR), _mm_unpackhi_ps(accL, accR));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        if constexpr (ACCUMULATE) {
+            sum = _mm_add_ps(sum, _mm_castpd_ps(_mm_load_sd((const double *)pDst)));
+        }
+        sum = _mm_min_ps(_mm_max_ps(sum, minusOne), one);
+        _mm_store_sd((double *)pDst, _mm_castps_pd(sum));
+    }
+#else
+    for (; numFrames > 0; --numFrames, pSrc += N, pDst += 2) {
+        float l = 0.f;
+        float r = 0.f;
+        for (size_t i = 0; i < N; ++i) {
+            l += pSrc[i] * kCoefs.left[i];
+            r += pSrc[i] * kCoefs.right[i];
+        }
+        if constexpr (ACCUMULATE) {
+            l += pDst[0];
+            r += pDst[1];
+        }
+        pDst[0] = clamp_float(l);
+        pDst[1] = clamp_float(r);
+    }
+#endif
+}
+
+// Returns the specialized fold for the input channel mask, or nullptr to use ChannelMix.
+static downmix_fold_func_t Downmix_getFoldFunction(audio_channel_mask_t mask, bool accumulate) {
+#ifdef DOWNMIX_ALWAYS_USE_GENERIC_DOWNMIXER
+    (void)mask;
+    (void)accumulate;
+    return nullptr;
+#else
+#define FOLD_CASE(m) \
+    case m: return accumulate ? Downmix_foldToStereo<m, true> : Downmix_foldToStereo<m, false>
+    switch (mask) {
+    FOLD_CASE(AUDIO_CHANNEL_OUT_QUAD);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_QUAD_SIDE);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_5POINT1);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_5POINT1_SIDE);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_5POINT1POINT2);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_7POINT1);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_5POINT1POINT4);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_7POINT1POINT2);
+    FOLD_CASE(AUDIO_CHANNEL_OUT_7POINT1POINT4);
+    default:
+        return nullptr;
+    }
+#undef FOLD_CASE
+#endif
+}
+
 /*----------------------------------------------------------------------------
  * Test code
  *--------------------------------------------------------------------------*/
@@ -369,7 +598,9 @@ static int32_t Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD: {
-            if (!pDownmixer->channelMix.process(
+            if (pDownmixer->foldFunc != nullptr) {
+                pDownmixer->foldFunc(pSrc, pDst, numFrames);
+            } else if (!pDownmixer->channelMix.process(
                     pSrc, pDst, numFrames, accumulate, downmixInputChannelMask)) {
                 ALOGE("Multichannel configuration %#x is not supported",
                       downmixInputChannelMask);
@@ -668,6 +899,9 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
         pDownmixer->input_channel_count =
                 audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
     }
+    pDownmixer->foldFunc = Downmix_getFoldFunction(
+            (audio_channel_mask_t)pConfig->inputCfg.channels,
+            pConfig->outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE);
 
     Downmix_Reset(pDownmixer, init);
 
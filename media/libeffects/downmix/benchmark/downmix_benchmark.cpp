@@ -90,7 +90,10 @@ BM_Downmix/20      16693 ns        16624 ns        42109 AUDIO_CHANNEL_OUT_13POI
 BM_Downmix/21      28267 ns        28116 ns        24982 AUDIO_CHANNEL_OUT_22POINT2
 */
 
-static void BM_Downmix(benchmark::State& state) {
+// The layouts with an EffectDownmix specialized fold to stereo are
+// AUDIO_CHANNEL_OUT_QUAD, QUAD_SIDE, 5POINT1, 5POINT1_SIDE, 5POINT1POINT2,
+// 7POINT1, 5POINT1POINT4, 7POINT1POINT2 and 7POINT1POINT4, all others use ChannelMix.
+static void runDownmix(benchmark::State& state, bool accumulate) {
     const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
     const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
     const int sampleRate = 48000;
@@ -119,7 +122,8 @@ static void BM_Downmix(benchmark::State& state) {
     config.inputCfg.bufferProvider.cookie = nullptr;
     config.inputCfg.mask = EFFECT_CONFIG_ALL;
 
-    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.accessMode =
+            accumulate ? EFFECT_BUFFER_ACCESS_ACCUMULATE : EFFECT_BUFFER_ACCESS_WRITE;
     config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
     config.outputCfg.bufferProvider.getBuffer = nullptr;
     config.outputCfg.bufferProvider.releaseBuffer = nullptr;
@@ -170,6 +174,14 @@ static void BM_Downmix(benchmark::State& state) {
     }
 }
 
+static void BM_Downmix(benchmark::State& state) {
+    runDownmix(state, false /* accumulate */);
+}
+
+static void BM_DownmixAccumulate(benchmark::State& state) {
+    runDownmix(state, true /* accumulate */);
+}
+
 static void DownmixArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
         b->Args({i});
@@ -177,5 +189,6 @@ static void DownmixArgs(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK(BM_Downmix)->Apply(DownmixArgs);
+BENCHMARK(BM_DownmixAccumulate)->Apply(DownmixArgs);
 
 BENCHMARK_MAIN();
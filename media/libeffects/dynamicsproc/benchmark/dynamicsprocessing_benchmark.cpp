@@ -0,0 +1,104 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+
+#include "dsp/DPFrequency.h"
+
+static constexpr size_t kSampleRate = 48000;
+static constexpr size_t kBlockSize = 1024;  // as DP_configureVariant() for a 20 ms frame
+static constexpr size_t kFrameCount = 960;  // 20 ms
+static constexpr float kCutoffsHz[] = {100, 300, 1000, 3000, 8000, 20000};
+
+/*******************************************************************
+ * The first parameter indicates the number of channels.
+ * The second parameter indicates the number of MBC bands.
+ * The pre and post EQ and the limiter are always in use.
+ *******************************************************************/
+
+static void BM_DynamicsProcessing(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const size_t mbcBandCount = state.range(1);
+    constexpr size_t kEqBandCount = 6;
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    dp_fx::DPFrequency dynamics;
+    dynamics.init(channelCount, true /* preEqInUse */, kEqBandCount,
+            mbcBandCount > 0 /* mbcInUse */, mbcBandCount, true /* postEqInUse */, kEqBandCount,
+            true /* limiterInUse */);
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        dp_fx::DPChannel *pChannel = dynamics.getChannel(ch);
+        pChannel->getPreEq()->setEnabled(true);
+        pChannel->getPostEq()->setEnabled(true);
+        for (size_t b = 0; b < kEqBandCount; b++) {
+            dp_fx::DPEqBand eqBand;
+            eqBand.init(true /* enabled */, kCutoffsHz[b], b % 2 ? -3.f : 3.f /* gain */);
+            pChannel->getPreEq()->setBand(b, eqBand);
+            pChannel->getPostEq()->setBand(b, eqBand);
+        }
+        pChannel->getMbc()->setEnabled(mbcBandCount > 0);
+        for (size_t b = 0; b < mbcBandCount; b++) {
+            dp_fx::DPMbcBand mbcBand;
+            mbcBand.init(true /* enabled */, kCutoffsHz[b], 3 /* attackTime */,
+                    80 /* releaseTime */, 4 /* ratio */, -40 /* threshold */,
+                    6 /* kneeWidth */, -90 /* noiseGateThreshold */, 1 /* expanderRatio */,
+                    0 /* preGain */, 6 /* postGain */);
+            pChannel->getMbc()->setBand(b, mbcBand);
+        }
+        dp_fx::DPLimiter limiter;
+        limiter.init(true /* inUse */, true /* enabled */, 0 /* linkGroup */, 1 /* attackTime */,
+                60 /* releaseTime */, 10 /* ratio */, -2 /* threshold */, 0 /* postGain */);
+        pChannel->setLimiter(limiter);
+    }
+    dynamics.configure(kBlockSize, kBlockSize / 2, kSampleRate);
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        dynamics.processSamples(input.data(), output.data(), input.size());
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(channelCount);
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void DynamicsProcessingArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 6, 8, 12}) {
+        for (int mbcBandCount : {0, 3, 6}) {
+            b->Args({channelCount, mbcBandCount});
+        }
+    }
+}
+
+BENCHMARK(BM_DynamicsProcessing)->Apply(DynamicsProcessingArgs);
+
+BENCHMARK_MAIN();
@@ -32,6 +32,8 @@ using Eigen::MatrixXd;
 
 static constexpr float MIN_ENVELOPE = 1e-6f; //-120 dB
 static constexpr float EPSILON = 0.0000001f;
+static constexpr float LOG_TO_DB = 20 / M_LN10;  // 20 * log10(x) == LOG_TO_DB * log(x)
+static constexpr float DB_TO_LOG = M_LN10 / 20;
 
 static inline bool isZero(float f) {
     return fabs(f) <= EPSILON;
@@ -76,6 +78,11 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     mPostEqBands.resize(dpBase.getPostEqBandCount());
     ALOGV("mPreEqBands %zu, mMbcBands %zu, mPostEqBands %zu",mPreEqBands.size(),
             mMbcBands.size(), mPostEqBands.size());
+    for (auto &mbcBand : mMbcBands) {
+        //invalid times, so the attack and release thetas are recomputed for this block rate.
+        mbcBand.attackTimeMs = -1;
+        mbcBand.releaseTimeMs = -1;
+    }
 
     DPChannel *pChannel = dpBase.getChannel(0);
     if (pChannel != nullptr) {
@@ -94,6 +101,15 @@ void ChannelBuffer::computeBinStartStop(BandParams &bp, size_t binStart) {
     bp.binStop = (int)(0.5 + bp.freqCutoffHz * mBlockSize / mSamplingRate);
 }
 
+//MbcBandChannels helper
+void MbcBandChannels::resize(size_t channelCount) {
+    for (Eigen::ArrayXf *a : {&enabled, &energy, &previousEnvelope, &attackTheta,
+            &releaseTheta, &preGain, &postGain, &slope, &thresholdDb, &kneeWidthDbHalf,
+            &noiseGateThresholdDb, &expanderRatio, &factor}) {
+        a->setZero(channelCount);
+    }
+}
+
 //== LinkedLimiters Helper
 void LinkedLimiters::reset() {
     mGroupsMap.clear();
@@ -160,6 +176,11 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
                 mSamplingRate, *this);
     }
 
+    mMbcBandChannels.resize(getMbcBandCount());
+    for (auto &band : mMbcBandChannels) {
+        band.resize(channelcount);
+    }
+
     //effective number of frames processed per second
     mBlocksPerSecond = (float)mSamplingRate / (mBlockSize - mOverlapSize);
 
@@ -299,6 +320,9 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
             return;
         }
         cb.mMbcEnabled = pMbc->isEnabled();
+        for (auto &band : mMbcBandChannels) {
+            band.enabled[channelIndex] = cb.mMbcEnabled ? 1 : 0;
+        }
         if (cb.mMbcEnabled) {
             bool changed = false;
             for (unsigned int b = 0; b < getMbcBandCount(); b++) {
@@ -312,16 +336,34 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                 IS_CHANGED(changed, pMbcBandParams->freqCutoffHz,
                         pMbcBand->getCutoffFrequency());
 
+                bool timeChanged = false;
+                IS_CHANGED(timeChanged, pMbcBandParams->attackTimeMs, pMbcBand->getAttackTime());
+                IS_CHANGED(timeChanged, pMbcBandParams->releaseTimeMs,
+                        pMbcBand->getReleaseTime());
                 pMbcBandParams->gainPreDb = pMbcBand->getPreGain();
                 pMbcBandParams->gainPostDb = pMbcBand->getPostGain();
-                pMbcBandParams->attackTimeMs = pMbcBand->getAttackTime();
-                pMbcBandParams->releaseTimeMs = pMbcBand->getReleaseTime();
                 pMbcBandParams->ratio = pMbcBand->getRatio();
                 pMbcBandParams->thresholdDb = pMbcBand->getThreshold();
                 pMbcBandParams->kneeWidthDb = pMbcBand->getKneeWidth();
                 pMbcBandParams->noiseGateThresholdDb = pMbcBand->getNoiseGateThreshold();
                 pMbcBandParams->expanderRatio = pMbcBand->getExpanderRatio();
 
+                //per channel column of the band state, used by processMbc()
+                MbcBandChannels &band = mMbcBandChannels[b];
+                if (timeChanged) {
+                    // updates computed per frame advance.
+                    float fFAttSec = pMbcBandParams->attackTimeMs / 1000; //in seconds
+                    float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
+                    band.attackTheta[channelIndex] = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+                    band.releaseTheta[channelIndex] = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+                }
+                band.preGain[channelIndex] = dBtoLinear(pMbcBandParams->gainPreDb);
+                band.postGain[channelIndex] = dBtoLinear(pMbcBandParams->gainPostDb);
+                band.slope[channelIndex] = (1 / pMbcBandParams->ratio) - 1;
+                band.thresholdDb[channelIndex] = pMbcBandParams->thresholdDb;
+                band.kneeWidthDbHalf[channelIndex] = pMbcBandParams->kneeWidthDb / 2;
+                band.noiseGateThresholdDb[channelIndex] = pMbcBandParams->noiseGateThresholdDb;
+                band.expanderRatio[channelIndex] = pMbcBandParams->expanderRatio;
             }
 
             if (changed) {
@@ -330,7 +372,7 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                 for (unsigned int b = 0; b < getMbcBandCount(); b++) {
                     ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[b];
 
-                    pMbcBandParams->previousEnvelope = 0;
+                    mMbcBandChannels[b].previousEnvelope[channelIndex] = 0;
 
                     //frequency translation
                     cb.computeBinStartStop(*pMbcBandParams, binNext);
@@ -445,8 +487,16 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             for (unsigned int k = 0; k < processFrames; k++) {
                 pCb->input[mOverlapSize + k] = pCb->cBInput.read();
             }
-            //first stages: fft, preEq, mbc, postEq and start of Limiter
-            processedSamples += processFirstStages(*pCb);
+            //first stages: fft, preEq and mbc band energies
+            processedSamples += processFirstStages(*pCb, ch);
+        }
+
+        //**mbc envelope followers and gain computers, across all channels
+        processMbc();
+
+        for (int ch = 0; ch < channelCount; ch++) {
+            //middle stages: mbc gains, postEq and start of Limiter
+            processMiddleStages(channelBuffers[ch], ch);
         }
 
         //**compute linked limiters and update levels if needed
@@ -474,7 +524,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
     }
     return processedSamples;
 }
-size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
+size_t DPFrequency::processFirstStages(ChannelBuffer &cb, int channelIndex) {
 
     //##apply window
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
@@ -496,18 +546,15 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
         cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
     }
 
-    //== MBC
+    //== MBC band energies
     if (cb.mMbcInUse && cb.mMbcEnabled) {
         for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
             ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
             float fEnergySum = 0;
-
-            //apply pre gain.
-            float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
-            float preGainSquared = preGainFactor * preGainFactor;
-
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
+            if (pMbcBandParams->binStart <= pMbcBandParams->binStop) {
+                fEnergySum = cb.complexTemp.segment(pMbcBandParams->binStart,
+                        pMbcBandParams->binStop - pMbcBandParams->binStart + 1)
+                        .squaredNorm(); //mag squared
             }
 
             //Eigen FFT is full spectrum, even if the source was real data.
@@ -517,62 +564,60 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             // in here, the fEnergySum is duplicated to account for the second half spectrum,
             // and the windowRms is used to normalize by the expected energy reduction
             // caused by the window used (expected for steady state signals)
-            fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
-
-            // updates computed per frame advance.
-            float fTheta = 0.0;
-            float fFAttSec = pMbcBandParams->attackTimeMs / 1000; //in seconds
-            float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
-
-            if (fEnergySum > pMbcBandParams->previousEnvelope) {
-                fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-            } else {
-                fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
-            }
-
-            float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
-            //preserve for next iteration
-            pMbcBandParams->previousEnvelope = fEnv;
+            // The pre gain is applied to the energy, sqrt(sum * preGain^2) == sqrt(sum) * preGain
+            MbcBandChannels &bandChannels = mMbcBandChannels[band];
+            bandChannels.energy[channelIndex] = sqrt(fEnergySum * 2) *
+                    bandChannels.preGain[channelIndex] / (mBlockSize * mWindowRms);
+        } //end per band energy
+    } //end MBC
+    return mBlockSize;
+}
 
-            if (fEnv < MIN_ENVELOPE) {
-                fEnv = MIN_ENVELOPE;
-            }
-            const float envDb = linearToDb(fEnv);
-            float newLevelDb = envDb;
-            //using shorter variables for code clarity
-            const float thresholdDb = pMbcBandParams->thresholdDb;
-            const float ratio = pMbcBandParams->ratio;
-            const float kneeWidthDbHalf = pMbcBandParams->kneeWidthDb / 2;
-            const float noiseGateThresholdDb = pMbcBandParams->noiseGateThresholdDb;
-            const float expanderRatio = pMbcBandParams->expanderRatio;
-
-            //find segment
-            if (envDb > thresholdDb + kneeWidthDbHalf) {
+void DPFrequency::processMbc() {
+    for (MbcBandChannels &band : mMbcBandChannels) {
+        //envelope follower
+        const Eigen::ArrayXf theta = (band.energy > band.previousEnvelope).select(
+                band.attackTheta, band.releaseTheta);
+        const Eigen::ArrayXf env = (1.f - theta) * band.energy + theta * band.previousEnvelope;
+        //preserve for next iteration, only for channels with mbc enabled
+        band.previousEnvelope = (band.enabled > 0.f).select(env, band.previousEnvelope);
+
+        //gain computer
+        const Eigen::ArrayXf envDb = env.max(MIN_ENVELOPE).log() * LOG_TO_DB;
+        const Eigen::ArrayXf overDb = envDb - band.thresholdDb;
+        const Eigen::ArrayXf kneeDb = overDb + band.kneeWidthDbHalf;
+        const Eigen::ArrayXf gainDb =
                 //compression segment
-                newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
-            } else if (envDb > thresholdDb - kneeWidthDbHalf) {
+                (overDb > band.kneeWidthDbHalf).select(band.slope * overDb,
                 //knee-compression segment
-                float temp = (envDb - thresholdDb + kneeWidthDbHalf);
-                newLevelDb = envDb + ((1 / ratio) - 1) *
-                        temp * temp / (kneeWidthDbHalf * 4);
-            } else if (envDb < noiseGateThresholdDb) {
+                (overDb > -band.kneeWidthDbHalf).select(
+                        band.slope * kneeDb * kneeDb / (band.kneeWidthDbHalf * 4.f),
                 //expander segment
-                newLevelDb = noiseGateThresholdDb -
-                        expanderRatio * (noiseGateThresholdDb - envDb);
-            }
+                (envDb < band.noiseGateThresholdDb).select(
+                        (band.expanderRatio - 1.f) * (envDb - band.noiseGateThresholdDb),
+                        0.f)));
+
+        //apply post gain.
+        band.factor = (gainDb * DB_TO_LOG).exp() * band.postGain;
+    }
+}
+
+size_t DPFrequency::processMiddleStages(ChannelBuffer &cb, int channelIndex) {
 
-            float newFactor = dBtoLinear(newLevelDb - envDb);
+    size_t cSize = cb.complexTemp.size();
+    size_t maxBin = std::min(cSize/2, mHalfFFTSize);
 
-            //apply post gain.
-            newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
+    //== MBC
+    if (cb.mMbcInUse && cb.mMbcEnabled) {
+        for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
+            ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
+            const float newFactor = mMbcBandChannels[band].factor[channelIndex];
 
             //apply to this band
             for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
                 cb.complexTemp[k] *= newFactor;
             }
-
         } //end per band process
-
     } //end MBC
 
     //== EqPost
@@ -584,10 +629,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //== Limiter. First Pass
     if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+        float fEnergySum = cb.complexTemp.head(maxBin).squaredNorm();
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
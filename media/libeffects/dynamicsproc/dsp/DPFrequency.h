@@ -63,9 +63,7 @@ public:
         float kneeWidthDb;
         float noiseGateThresholdDb;
         float expanderRatio;
-
-        //Historic values
-        float previousEnvelope;
+        //Historic values are kept in DPFrequency::MbcBandChannels
     };
     struct LimiterParams {
         int32_t linkGroup;
@@ -110,6 +108,28 @@ private:
 
 using CBufferVector = std::vector<ChannelBuffer>;
 
+// State of one MBC band for all channels, as a structure of arrays indexed by channel,
+// so the envelope follower and the gain computer are evaluated SIMD across channels.
+struct MbcBandChannels {
+    Eigen::ArrayXf enabled;             // 1 if MBC is enabled for the channel, 0 otherwise
+    Eigen::ArrayXf energy;              // band energy of the current block
+    Eigen::ArrayXf previousEnvelope;
+    Eigen::ArrayXf attackTheta;
+    Eigen::ArrayXf releaseTheta;
+    Eigen::ArrayXf preGain;
+    Eigen::ArrayXf postGain;
+    Eigen::ArrayXf slope;               // 1 / ratio - 1
+    Eigen::ArrayXf thresholdDb;
+    Eigen::ArrayXf kneeWidthDbHalf;
+    Eigen::ArrayXf noiseGateThresholdDb;
+    Eigen::ArrayXf expanderRatio;
+    Eigen::ArrayXf factor;              // gain computer output, applied to the band bins
+
+    void resize(size_t channelCount);
+};
+
+using MbcBandVector = std::vector<MbcBandChannels>;
+
 using GroupsMap = std::map<int32_t, IntVec>;
 
 class LinkedLimiters {
@@ -134,7 +154,9 @@ private:
     size_t processOneVector(FloatVec &output, FloatVec &input, ChannelBuffer &cb);
 
     size_t processChannelBuffers(CBufferVector &channelBuffers);
-    size_t processFirstStages(ChannelBuffer &cb);
+    size_t processFirstStages(ChannelBuffer &cb, int channelIndex);
+    void processMbc();
+    size_t processMiddleStages(ChannelBuffer &cb, int channelIndex);
     size_t processLastStages(ChannelBuffer &cb);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
@@ -146,6 +168,7 @@ private:
     float mBlocksPerSecond;
 
     CBufferVector mChannelBuffers;
+    MbcBandVector mMbcBandChannels;
 
     LinkedLimiters mLinkedLimiters;
 
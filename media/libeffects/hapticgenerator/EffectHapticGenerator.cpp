@@ -28,6 +28,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <math.h>
+#include <time.h>
 
 #include <android-base/parsedouble.h>
 #include <android-base/properties.h>
@@ -131,6 +132,10 @@ int HapticGenerator_Init(struct HapticGeneratorContext *context) {
             "vendor.audio.hapticgenerator.distortion.output.gain", DEFAULT_DISTORTION_OUTPUT_GAIN);
     ALOGD("Using distortion output gain as %f", context->param.distortionOutputGain);
 
+    context->processCount = 0;
+    context->processTotalNs = 0;
+    context->processMaxNs = 0;
+
     context->state = HAPTICGENERATOR_STATE_INITIALIZED;
     return 0;
 }
@@ -148,6 +153,22 @@ void addBiquadFilter(
     });
 }
 
+void addBiquadCascade(
+        std::vector<std::function<void(float *, const float *, size_t)>> &processingChain,
+        struct HapticGeneratorProcessorsRecord &processorsRecord,
+        std::shared_ptr<BiquadCascade> cascade) {
+    // Same as addBiquadFilter(), for a cascade of filters.
+    processorsRecord.cascades.push_back(cascade);
+    processingChain.push_back([cascade](float *out, const float *in, size_t frameCount) {
+            cascade->process(out, in, frameCount);
+    });
+}
+
+// Returns the coefficients of two cascaded first order filters with the same coefficients.
+BiquadFilterCoefficients cascadeSame(const BiquadFilterCoefficients &coefs) {
+    return cascadeFirstOrderFilters(coefs, coefs);
+}
+
 /**
  * \brief build haptic generator processing chain.
  *
@@ -161,12 +182,14 @@ void HapticGenerator_buildProcessingChain(
         struct HapticGeneratorProcessorsRecord& processorsRecord, float sampleRate,
         const struct HapticGeneratorParam* param) {
     const size_t channelCount = param->hapticChannelCount;
+    // Consecutive biquad filters run as a cascade, which filters all the stages and channels
+    // in a single pass over the data.
     float highPassCornerFrequency = 50.0f;
-    auto hpf = createHPF2(highPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, hpf);
     float lowPassCornerFrequency = 9000.0f;
-    auto lpf = createLPF2(lowPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, lpf);
+    addBiquadCascade(processingChain, processorsRecord, std::make_shared<BiquadCascade>(
+            channelCount, std::vector<BiquadFilterCoefficients>{
+                    cascadeSame(hpfCoefs(highPassCornerFrequency, sampleRate)),
+                    cascadeSame(lpfCoefs(lowPassCornerFrequency, sampleRate))}));
 
     auto ramp = std::make_shared<Ramp>(channelCount);  // ramp = half-wave rectifier.
     // The process chain captures the shared pointer of the ramp in lambda. It will be the only
@@ -178,23 +201,17 @@ void HapticGenerator_buildProcessingChain(
             ramp->process(out, in, frameCount);
     });
 
+    // The band-pass filter is the last stage of this cascade.
     highPassCornerFrequency = 60.0f;
-    hpf = createHPF2(highPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, hpf);
-    lowPassCornerFrequency = 700.0f;
-    lpf = createLPF2(lowPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, lpf);
-
-    lowPassCornerFrequency = 400.0f;
-    lpf = createLPF2(lowPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, lpf);
-    lowPassCornerFrequency = 500.0f;
-    lpf = createLPF2(lowPassCornerFrequency, sampleRate, channelCount);
-    addBiquadFilter(processingChain, processorsRecord, lpf);
-
-    auto bpf = createBPF(param->resonantFrequency, param->bpfQ, sampleRate, channelCount);
+    auto bpf = std::make_shared<BiquadCascade>(
+            channelCount, std::vector<BiquadFilterCoefficients>{
+                    cascadeSame(hpfCoefs(highPassCornerFrequency, sampleRate)),
+                    cascadeSame(lpfCoefs(700.0f /*lowPassCornerFrequency*/, sampleRate)),
+                    cascadeSame(lpfCoefs(400.0f /*lowPassCornerFrequency*/, sampleRate)),
+                    cascadeSame(lpfCoefs(500.0f /*lowPassCornerFrequency*/, sampleRate)),
+                    bpfCoefs(param->resonantFrequency, param->bpfQ, sampleRate)});
     processorsRecord.bpf = bpf;
-    addBiquadFilter(processingChain, processorsRecord, bpf);
+    addBiquadCascade(processingChain, processorsRecord, bpf);
 
     float normalizationPower = param->slowEnvNormalizationPower;
     // The process chain captures the shared pointer of the slow envelope in lambda. It will
@@ -239,6 +256,7 @@ int HapticGenerator_Configure(struct HapticGeneratorContext *context, effect_con
     if (&context->config != config) {
         context->processingChain.clear();
         context->processorsRecord.filters.clear();
+        context->processorsRecord.cascades.clear();
         context->processorsRecord.ramps.clear();
         context->processorsRecord.slowEnvs.clear();
         context->processorsRecord.distortions.clear();
@@ -269,6 +287,9 @@ int HapticGenerator_Reset(struct HapticGeneratorContext *context) {
     for (auto& filter : context->processorsRecord.filters) {
         filter->clear();
     }
+    for (auto& cascade : context->processorsRecord.cascades) {
+        cascade->clear();
+    }
     for (auto& slowEnv : context->processorsRecord.slowEnvs) {
         slowEnv->clear();
     }
@@ -316,6 +337,7 @@ int HapticGenerator_SetParameter(struct HapticGeneratorContext *context,
 
         if (context->processorsRecord.bpf != nullptr) {
             context->processorsRecord.bpf->setCoefficients(
+                    context->processorsRecord.bpf->getStageCount() - 1,
                     bpfCoefs(context->param.resonantFrequency,
                              context->param.bpfQ,
                              context->config.inputCfg.samplingRate));
@@ -462,9 +484,18 @@ int32_t HapticGenerator_Process(effect_handle_t self,
         }
     }
 
+    struct timespec start;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
     float* hapticOutBuffer = HapticGenerator_runProcessingChain(
             context->processingChain, context->inputBuffer.data(),
             context->outputBuffer.data(), inBuffer->frameCount);
+    struct timespec end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    const int64_t processNs = (end.tv_sec - start.tv_sec) * 1000000000LL
+            + (end.tv_nsec - start.tv_nsec);
+    ++context->processCount;
+    context->processTotalNs += processNs;
+    context->processMaxNs = std::max(context->processMaxNs, processNs);
     os::scaleHapticData(hapticOutBuffer, hapticSampleCount, context->param.maxHapticIntensity,
                         context->param.maxHapticAmplitude);
 
@@ -541,6 +572,9 @@ int32_t HapticGenerator_Command(effect_handle_t self, uint32_t cmdCode, uint32_t
                 return -ENOSYS;
             }
             context->state = HAPTICGENERATOR_STATE_ACTIVE;
+            context->processCount = 0;
+            context->processTotalNs = 0;
+            context->processMaxNs = 0;
             ALOGV("EFFECT_CMD_ENABLE() OK");
             *(int *) replyData = 0;
             break;
@@ -553,6 +587,12 @@ int32_t HapticGenerator_Command(effect_handle_t self, uint32_t cmdCode, uint32_t
                 return -ENOSYS;
             }
             context->state = HAPTICGENERATOR_STATE_INITIALIZED;
+            if (context->processCount > 0) {
+                ALOGD("Haptic generation CPU time per buffer: avg %" PRId64 " ns, max %" PRId64
+                      " ns over %" PRId64 " buffers",
+                      context->processTotalNs / context->processCount, context->processMaxNs,
+                      context->processCount);
+            }
             ALOGV("EFFECT_CMD_DISABLE() OK");
             *(int *) replyData = 0;
             break;
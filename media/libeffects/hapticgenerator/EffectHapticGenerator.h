@@ -67,13 +67,14 @@ struct HapticGeneratorParam {
 // A structure to keep all shared pointers for all processors in HapticGenerator.
 struct HapticGeneratorProcessorsRecord {
     std::vector<std::shared_ptr<HapticBiquadFilter>> filters;
+    std::vector<std::shared_ptr<BiquadCascade>> cascades;
     std::vector<std::shared_ptr<Ramp>> ramps;
     std::vector<std::shared_ptr<SlowEnvelope>> slowEnvs;
     std::vector<std::shared_ptr<Distortion>> distortions;
 
     // Cache band-pass filter and band-stop filter for updating parameters
-    // according to vibrator info
-    std::shared_ptr<HapticBiquadFilter> bpf;
+    // according to vibrator info. The band-pass filter is the last stage of its cascade.
+    std::shared_ptr<BiquadCascade> bpf;
     std::shared_ptr<HapticBiquadFilter> bsf;
 };
 
@@ -100,6 +101,11 @@ struct HapticGeneratorContext {
     // outputBuffer is a buffer having the same length as inputBuffer. It can be used as
     // intermediate buffer in the generating algorithm.
     std::vector<float> outputBuffer;
+
+    // Thread CPU time of the generating algorithm per buffer, since the effect was enabled.
+    int64_t processCount;
+    int64_t processTotalNs;
+    int64_t processMaxNs;
 };
 
 //-----------------------------------------------------------------------------
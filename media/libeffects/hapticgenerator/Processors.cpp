@@ -20,6 +20,7 @@
 
 #include <assert.h>
 
+#include <algorithm>
 #include <cmath>
 
 #include "Processors.h"
@@ -169,6 +170,96 @@ void Distortion::clear() {
 }
 
 
+// Implementation of BiquadCascade
+
+BiquadCascade::BiquadCascade(size_t channelCount,
+                             const std::vector<BiquadFilterCoefficients> &coefs)
+        : mChannelCount(channelCount),
+          mStageCount(coefs.size()),
+          mLaneCount(channelCount * coefs.size()),
+          mPaddedLaneCount((mLaneCount + 3) & ~(size_t) 3),
+          mB0(mPaddedLaneCount),
+          mB1(mPaddedLaneCount),
+          mB2(mPaddedLaneCount),
+          mA1(mPaddedLaneCount),
+          mA2(mPaddedLaneCount),
+          mS1(mPaddedLaneCount),
+          mS2(mPaddedLaneCount),
+          mX(mPaddedLaneCount),
+          mY(mPaddedLaneCount) {
+    for (size_t stage = 0; stage < mStageCount; ++stage) {
+        setCoefficients(stage, coefs[stage]);
+    }
+}
+
+void BiquadCascade::setCoefficients(size_t stage, const BiquadFilterCoefficients &coefs) {
+    assert(stage < mStageCount);
+    for (size_t lane = stage * mChannelCount; lane < (stage + 1) * mChannelCount; ++lane) {
+        mB0[lane] = coefs[0];
+        mB1[lane] = coefs[1];
+        mB2[lane] = coefs[2];
+        mA1[lane] = coefs[3];
+        mA2[lane] = coefs[4];
+    }
+}
+
+void BiquadCascade::clear() {
+    std::fill(mS1.begin(), mS1.end(), 0.0f);
+    std::fill(mS2.begin(), mS2.end(), 0.0f);
+}
+
+void BiquadCascade::stepLanes(const float *in, float *out, size_t firstLane, size_t endLane) {
+    for (size_t lane = firstLane; lane < endLane; ++lane) {
+        const float x = in[lane];
+        const float y = mB0[lane] * x + mS1[lane];
+        mS1[lane] = mB1[lane] * x - mA1[lane] * y + mS2[lane];
+        mS2[lane] = mB2[lane] * x - mA2[lane] * y;
+        out[lane] = y;
+    }
+}
+
+void BiquadCascade::process(float *out, const float *in, size_t frameCount) {
+    if (frameCount == 0) {
+        return;
+    }
+    // At step t, stage k filters frame t - k, taking the output of stage k - 1 at step t - 1.
+    // Only the first and last mStageCount - 1 steps have stages without a frame to filter.
+    const size_t lastStage = mStageCount - 1;
+    float *x = mX.data();
+    float *y = mY.data();
+    for (size_t t = 0; t < frameCount + lastStage; ++t) {
+        std::copy(y, y + mLaneCount - mChannelCount, x + mChannelCount);
+        const size_t firstActive = t < frameCount ? 0 : t - frameCount + 1;
+        const size_t lastActive = std::min(t, lastStage);
+        if (firstActive == 0) {
+            std::copy(in + t * mChannelCount, in + (t + 1) * mChannelCount, x);
+        }
+        if (firstActive == 0 && lastActive == lastStage) {
+            size_t lane = 0;
+#if USE_NEON
+            for (; lane < mPaddedLaneCount; lane += 4) {
+                const float32x4_t xv = vld1q_f32(x + lane);
+                const float32x4_t yv = vmlaq_f32(vld1q_f32(&mS1[lane]), vld1q_f32(&mB0[lane]), xv);
+                float32x4_t s1 = vmlaq_f32(vld1q_f32(&mS2[lane]), vld1q_f32(&mB1[lane]), xv);
+                s1 = vmlsq_f32(s1, vld1q_f32(&mA1[lane]), yv);
+                float32x4_t s2 = vmulq_f32(vld1q_f32(&mB2[lane]), xv);
+                s2 = vmlsq_f32(s2, vld1q_f32(&mA2[lane]), yv);
+                vst1q_f32(&mS1[lane], s1);
+                vst1q_f32(&mS2[lane], s2);
+                vst1q_f32(y + lane, yv);
+            }
+#endif // USE_NEON
+            stepLanes(x, y, lane, mLaneCount);
+        } else {
+            stepLanes(x, y, firstActive * mChannelCount, (lastActive + 1) * mChannelCount);
+        }
+        if (lastActive == lastStage) {
+            std::copy(y + lastStage * mChannelCount, y + mLaneCount,
+                      out + (t - lastStage) * mChannelCount);
+        }
+    }
+}
+
 // Implementation of helper functions
 
 BiquadFilterCoefficients cascadeFirstOrderFilters(const BiquadFilterCoefficients &coefs1,
@@ -196,6 +287,20 @@ BiquadFilterCoefficients lpfCoefs(const float cornerFrequency, const float sampl
     return coefficient;
 }
 
+BiquadFilterCoefficients hpfCoefs(const float cornerFrequency, const float sampleRate) {
+    BiquadFilterCoefficients coefficient;
+    // Note: this is valid only when corner frequency is less than nyquist / 2.
+    float realPoleZ = getRealPoleZ(cornerFrequency, sampleRate);
+
+    // Note: this is a zero at DC
+    coefficient[0] = 0.5f * (1 + realPoleZ);
+    coefficient[1] = -coefficient[0];
+    coefficient[2] = 0.0f;
+    coefficient[3] = -realPoleZ;
+    coefficient[4] = 0.0f;
+    return coefficient;
+}
+
 BiquadFilterCoefficients bpfCoefs(const float ringingFrequency,
                                   const float q,
                                   const float sampleRate) {
@@ -248,16 +353,7 @@ std::shared_ptr<HapticBiquadFilter> createLPF2(const float cornerFrequency,
 std::shared_ptr<HapticBiquadFilter> createHPF2(const float cornerFrequency,
                                          const float sampleRate,
                                          const size_t channelCount) {
-    BiquadFilterCoefficients coefficient;
-    // Note: this is valid only when corner frequency is less than nyquist / 2.
-    float realPoleZ = getRealPoleZ(cornerFrequency, sampleRate);
-
-    // Note: this is a zero at DC
-    coefficient[0] = 0.5f * (1 + realPoleZ);
-    coefficient[1] = -coefficient[0];
-    coefficient[2] = 0.0f;
-    coefficient[3] = -realPoleZ;
-    coefficient[4] = 0.0f;
+    BiquadFilterCoefficients coefficient = hpfCoefs(cornerFrequency, sampleRate);
     return std::make_shared<HapticBiquadFilter>(
             channelCount, cascadeFirstOrderFilters(coefficient, coefficient));
 }
@@ -90,6 +90,39 @@ private:
     const size_t mChannelCount;
 };
 
+// A class providing a process function that runs a cascade of biquad filters on all channels.
+// The state of every stage of every channel is kept in its own lane of structure of arrays,
+// lane = stage * channelCount + channel. The stages are pipelined, each stage working on the
+// sample before the one of the previous stage, so that all the lanes are processed with SIMD
+// at each step and the whole cascade is done in a single pass over the data.
+class BiquadCascade {
+public:
+    BiquadCascade(size_t channelCount, const std::vector<BiquadFilterCoefficients> &coefs);
+
+    void process(float *out, const float *in, size_t frameCount);
+
+    size_t getStageCount() const { return mStageCount; }
+
+    void setCoefficients(size_t stage, const BiquadFilterCoefficients &coefs);
+
+    void clear();
+
+private:
+    // Processes the lanes [firstLane, endLane) of one step, without SIMD.
+    void stepLanes(const float *in, float *out, size_t firstLane, size_t endLane);
+
+    const size_t mChannelCount;
+    const size_t mStageCount;
+    const size_t mLaneCount;
+    // mLaneCount rounded up to a multiple of 4, the extra lanes have zero coefficients.
+    const size_t mPaddedLaneCount;
+    std::vector<float> mB0, mB1, mB2, mA1, mA2;
+    // Transposed direct form II state of each lane
+    std::vector<float> mS1, mS2;
+    // Input and output of each lane for the current step
+    std::vector<float> mX, mY;
+};
+
 // Helper functions
 
 BiquadFilterCoefficients cascadeFirstOrderFilters(const BiquadFilterCoefficients &coefs1,
@@ -97,6 +130,8 @@ BiquadFilterCoefficients cascadeFirstOrderFilters(const BiquadFilterCoefficients
 
 BiquadFilterCoefficients lpfCoefs(const float cornerFrequency, const float sampleRate);
 
+BiquadFilterCoefficients hpfCoefs(const float cornerFrequency, const float sampleRate);
+
 BiquadFilterCoefficients bpfCoefs(const float ringingFrequency,
                                   const float q,
                                   const float sampleRate);
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <audio_effects/effect_loudnessenhancer.h>
+#include <benchmark/benchmark.h>
+#include <hardware/audio_effect.h>
+#include <log/log.h>
+#include <system/audio.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+// AOSP Loudness Enhancer UUID: fa415329-2034-4bea-b5dc-5b381c8d1e2c
+static constexpr effect_uuid_t kLoudnessUuid = {
+    0xfa415329, 0x2034, 0x4bea, 0xb5dc, {0x5b, 0x38, 0x1c, 0x8d, 0x1e, 0x2c}};
+
+static constexpr size_t kFrameCount = 1024;
+static constexpr int kSampleRate = 48000;
+
+// Target gains in millibels, the louder the more the signal is compressed.
+static constexpr int32_t kTargetGainsMb[] = {0, 500, 1000, 2000};
+
+static int setTargetGain(effect_handle_t effectHandle, int32_t gainMb) {
+    uint32_t buf[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+    effect_param_t *param = (effect_param_t *)buf;
+    param->psize = sizeof(uint32_t);
+    param->vsize = sizeof(int32_t);
+    *(uint32_t *)param->data = LOUDNESS_ENHANCER_PARAM_TARGET_GAIN_MB;
+    *((int32_t *)param->data + 1) = gainMb;
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_SET_PARAM, sizeof(buf), param,
+                                          &replySize, &reply);
+    return status != 0 ? status : reply;
+}
+
+static void BM_Loudness(benchmark::State& state) {
+    const int32_t gainMb = kTargetGainsMb[state.range(0)];
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(gainMb);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> data(kFrameCount * FCC_2);
+    for (auto& in : data) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+            &kLoudnessUuid, 1, 1, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_SET_CONFIG,
+                                              sizeof(effect_config_t), &config,
+                                              &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        return;
+    }
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr,
+                                              &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        return;
+    }
+    if (int status = setTargetGain(effectHandle, gainMb); status != 0) {
+        ALOGE("Setting the target gain returned an error = %d\n", status);
+        return;
+    }
+
+    // Run the test in place, as the effect always processes its input buffer in place.
+    // The compressor keeps the samples within [-1.0, 1.0] across iterations.
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(data.data());
+
+        audio_buffer_t buffer = {.frameCount = kFrameCount, .f32 = data.data()};
+        (*effectHandle)->process(effectHandle, &buffer, &buffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(std::to_string(gainMb) + " mB");
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+    }
+}
+
+static void LoudnessArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kTargetGainsMb); i++) {
+        b->Args({i});
+    }
+}
+
+BENCHMARK(BM_Loudness)->Apply(LoudnessArgs);
+
+BENCHMARK_MAIN();
@@ -17,6 +17,12 @@
 
 #include <cmath>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "common/core/math.h"
 #include "common/core/types.h"
 #include "dsp/core/basic.h"
@@ -40,6 +46,7 @@ const float AdaptiveDynamicRangeCompression::kDefaultKneeThresholdInDecibel =
 const float AdaptiveDynamicRangeCompression::kCompressionRatio = 7.0f;
 const float AdaptiveDynamicRangeCompression::kTauAttack = 0.001f;
 const float AdaptiveDynamicRangeCompression::kTauRelease = 0.015f;
+const size_t AdaptiveDynamicRangeCompression::kBlockFrames;
 
 AdaptiveDynamicRangeCompression::AdaptiveDynamicRangeCompression() {
   static const float kTargetGain[] = {
@@ -136,5 +143,145 @@ void AdaptiveDynamicRangeCompression::Compress(float *x1, float *x2) {
   }
 }
 
+void AdaptiveDynamicRangeCompression::Compress(float *x, size_t frame_count,
+                                               float input_gain,
+                                               float output_gain) {
+  // The control voltage and then the gain of each frame in the block
+  float cv[kBlockFrames];
+  float gain[kBlockFrames];
+  while (frame_count > 0) {
+    const size_t n = std::min(frame_count, kBlockFrames);
+
+    // Level detection, the same as Compress(float*, float*) with fast_log(.)
+    // computed on 4 frames at a time.
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    const float32x4_t in_gain = vdupq_n_f32(input_gain);
+    const float32x4_t min_abs = vdupq_n_f32(kMinLogAbsValue);
+    const float32x4_t knee = vdupq_n_f32(knee_threshold_);
+    const float32x4_t slope = vdupq_n_f32(slope_);
+    for (; i + 4 <= n; i += 4) {
+      const float32x4x2_t in = vld2q_f32(x + 2 * i);
+      const float32x4_t l = vabsq_f32(vmulq_f32(in.val[0], in_gain));
+      const float32x4_t r = vabsq_f32(vmulq_f32(in.val[1], in_gain));
+      int32x4_t bits =
+          vreinterpretq_s32_f32(vmaxq_f32(l, vmaxq_f32(r, min_abs)));
+      const float32x4_t log_2 = vcvtq_f32_s32(vsubq_s32(
+          vandq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(255)),
+          vdupq_n_s32(128)));
+      bits = vaddq_s32(vandq_s32(bits, vdupq_n_s32(~(255 << 23))),
+                       vdupq_n_s32(127 << 23));
+      float32x4_t val = vreinterpretq_f32_s32(bits);
+      val = vaddq_f32(vmulq_f32(vdupq_n_f32(-1.0f / 3), val), vdupq_n_f32(2));
+      val = vsubq_f32(vmulq_f32(val, vreinterpretq_f32_s32(bits)),
+                      vdupq_n_f32(2.0f / 3));
+      const float32x4_t log_x = vmulq_f32(vaddq_f32(val, log_2),
+          vdupq_n_f32(0.693147180559945286226763982995180413126945495605468750f));
+      const float32x4_t rect = vmaxq_f32(vsubq_f32(log_x, knee), vdupq_n_f32(0));
+      vst1q_f32(cv + i, vmulq_f32(rect, slope));
+    }
+#elif defined(__SSE2__)
+    const __m128 in_gain = _mm_set1_ps(input_gain);
+    const __m128 min_abs = _mm_set1_ps(kMinLogAbsValue);
+    const __m128 knee = _mm_set1_ps(knee_threshold_);
+    const __m128 slope = _mm_set1_ps(slope_);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= n; i += 4) {
+      const __m128 a = _mm_loadu_ps(x + 2 * i);
+      const __m128 b = _mm_loadu_ps(x + 2 * i + 4);
+      const __m128 l = _mm_and_ps(
+          _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), in_gain),
+          abs_mask);
+      const __m128 r = _mm_and_ps(
+          _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), in_gain),
+          abs_mask);
+      __m128i bits = _mm_castps_si128(_mm_max_ps(l, _mm_max_ps(r, min_abs)));
+      const __m128 log_2 = _mm_cvtepi32_ps(_mm_sub_epi32(
+          _mm_and_si128(_mm_srai_epi32(bits, 23), _mm_set1_epi32(255)),
+          _mm_set1_epi32(128)));
+      bits = _mm_add_epi32(_mm_and_si128(bits, _mm_set1_epi32(~(255 << 23))),
+                           _mm_set1_epi32(127 << 23));
+      __m128 val = _mm_castsi128_ps(bits);
+      val = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.0f / 3), val), _mm_set1_ps(2));
+      val = _mm_sub_ps(_mm_mul_ps(val, _mm_castsi128_ps(bits)),
+                       _mm_set1_ps(2.0f / 3));
+      const __m128 log_x = _mm_mul_ps(_mm_add_ps(val, log_2),
+          _mm_set1_ps(0.693147180559945286226763982995180413126945495605468750f));
+      const __m128 rect = _mm_max_ps(_mm_sub_ps(log_x, knee), _mm_setzero_ps());
+      _mm_storeu_ps(cv + i, _mm_mul_ps(rect, slope));
+    }
+#endif
+    for (; i < n; ++i) {
+      const float max_abs_x = std::max(std::fabs(input_gain * x[2 * i]),
+          std::max(std::fabs(input_gain * x[2 * i + 1]), kMinLogAbsValue));
+      const float max_abs_x_dB = math::fast_log(max_abs_x);
+      const float rect = std::max(max_abs_x_dB - knee_threshold_, 0.0f);
+      cv[i] = rect * slope_;
+    }
+
+    // The envelope detector depends on the previous sample, so only its steps
+    // are computed here. Their exponentials are independent of each other,
+    // which leaves a running product of the gain.
+    for (i = 0; i < n; ++i) {
+      const float prev_state = state_;
+      if (cv[i] <= state_) {
+        state_ = alpha_attack_ * state_ + (1.0f - alpha_attack_) * cv[i];
+      } else {
+        state_ = alpha_release_ * state_ + (1.0f - alpha_release_) * cv[i];
+      }
+      cv[i] = state_ - prev_state;
+    }
+    for (i = 0; i < n; ++i) {
+      gain[i] = math::ExpApproximationViaTaylorExpansionOrder5(cv[i]);
+    }
+    for (i = 0; i < n; ++i) {
+      compressor_gain_ *= gain[i];
+      gain[i] = compressor_gain_;
+    }
+
+    // Gain stage
+    i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    const float32x4_t out_gain = vdupq_n_f32(output_gain);
+    const float32x4_t limit = vdupq_n_f32(kFixedPointLimit);
+    const float32x4_t minus_limit = vdupq_n_f32(-kFixedPointLimit);
+    for (; i + 4 <= n; i += 4) {
+      float32x4x2_t io = vld2q_f32(x + 2 * i);
+      const float32x4_t g = vld1q_f32(gain + i);
+      for (int c = 0; c < 2; ++c) {
+        const float32x4_t y = vmulq_f32(vmulq_f32(io.val[c], in_gain), g);
+        io.val[c] = vmulq_f32(vmaxq_f32(vminq_f32(y, limit), minus_limit),
+                              out_gain);
+      }
+      vst2q_f32(x + 2 * i, io);
+    }
+#elif defined(__SSE2__)
+    const __m128 out_gain = _mm_set1_ps(output_gain);
+    const __m128 limit = _mm_set1_ps(kFixedPointLimit);
+    const __m128 minus_limit = _mm_set1_ps(-kFixedPointLimit);
+    for (; i + 2 <= n; i += 2) {
+      // {gain[i], gain[i], gain[i + 1], gain[i + 1]} for a pair of frames
+      const __m128 g = _mm_castpd_ps(_mm_load_sd(
+          reinterpret_cast<const double *>(gain + i)));
+      const __m128 y = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(x + 2 * i), in_gain),
+                                  _mm_unpacklo_ps(g, g));
+      _mm_storeu_ps(x + 2 * i, _mm_mul_ps(
+          _mm_max_ps(_mm_min_ps(y, limit), minus_limit), out_gain));
+    }
+#endif
+    for (; i < n; ++i) {
+      for (int c = 0; c < 2; ++c) {
+        const float y = input_gain * x[2 * i + c] * gain[i];
+        x[2 * i + c] =
+            std::max(std::min(y, kFixedPointLimit), -kFixedPointLimit) *
+            output_gain;
+      }
+    }
+
+    x += 2 * n;
+    frame_count -= n;
+  }
+}
+
 }  // namespace le_fx
 
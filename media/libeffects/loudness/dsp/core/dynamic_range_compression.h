@@ -58,6 +58,13 @@ class AdaptiveDynamicRangeCompression {
   // Stereo channel version of the compressor
   void Compress(float *x1, float *x2);
 
+  // Compresses `frame_count` interleaved stereo frames in place. The input is
+  // scaled by `input_gain` before the compressor, and the output by
+  // `output_gain` after it. The level detection and the gain stage are
+  // vectorized, only the envelope detector runs sample by sample.
+  void Compress(float *x, size_t frame_count, float input_gain,
+                float output_gain);
+
   // This version is slower than Compress(.) but faster than CompressSlow(.)
   float CompressNormalSpeed(float x);
 
@@ -91,6 +98,9 @@ class AdaptiveDynamicRangeCompression {
   static const float kTauAttack;
   // The release time of the envelope detector
   static const float kTauRelease;
+  // The number of frames that the block version of Compress(.) processes at
+  // a time
+  static const size_t kBlockFrames = 64;
 
   float sampling_rate_;
   // the internal state of the envelope detector
@@ -17,8 +17,10 @@
 #include <array>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <random>
 #include <vector>
+#include <audio_utils/BiquadFilter.h>
 #include <log/log.h>
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
@@ -235,4 +237,59 @@ static void LVMArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_LVM)->Apply(LVMArgs);
 
+/*******************************************************************
+ * Equalizer band processing, y = x + G * H(x) for a peaking filter H.
+ * The first parameter indicates the number of channels.
+ * The second parameter indicates the implementation.
+ * 0: biquad into a temporary buffer, then gain accumulation (former LVEQNB_Process)
+ * 1: gain folded into the biquad coefficients, in place (LVEQNB_Process)
+ *******************************************************************/
+
+static void BM_EqBand(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const bool folded = state.range(1) != 0;
+
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    std::vector<float> output(input.size());
+    std::vector<float> temp(input.size());
+
+    // representative peaking filter in LVEQNB_BiquadCoefs_t form, 1 kHz at 44.1 kHz.
+    constexpr float A0 = 0.0345f, B1 = 1.9112f, B2 = -0.9310f, G = 1.5f;
+    using Coefs = std::array<float, android::audio_utils::kBiquadNumCoefs>;
+    const Coefs coefs = folded ? Coefs{1.f + G * A0, -B1, -B2 - G * A0, -B1, -B2}
+                               : Coefs{A0, 0.f, -A0, -B1, -B2};
+    android::audio_utils::BiquadFilter<float> biquad(channelCount, coefs);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        memcpy(output.data(), input.data(), input.size() * sizeof(float));
+        if (folded) {
+            biquad.process(output.data(), output.data(), kFrameCount);
+        } else {
+            biquad.process(temp.data(), output.data(), kFrameCount);
+            for (size_t i = 0; i < output.size(); ++i) {
+                output[i] += temp[i] * G;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+
+static void EqBandArgs(benchmark::internal::Benchmark* b) {
+    for (int i = FCC_1; i <= kNumChMasks; i++) {
+        for (int j = 0; j < 2; ++j) {
+            b->Args({i, j});
+        }
+    }
+}
+
+BENCHMARK(BM_EqBand)->Apply(EqBandArgs);
+
 BENCHMARK_MAIN();
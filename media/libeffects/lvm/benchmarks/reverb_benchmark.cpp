@@ -16,6 +16,7 @@
 
 #include <array>
 #include <climits>
+#include <cmath>
 #include <cstdlib>
 #include <random>
 #include <vector>
@@ -23,6 +24,7 @@
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
 #include <system/audio.h>
+#include "ConvolutionReverb.h"
 #include "EffectReverb.h"
 
 extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
@@ -177,4 +179,63 @@ static void REVERBArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_REVERB)->Apply(REVERBArgs);
 
+/*******************************************************************
+ * Convolution reverb of a stereo buffer with impulse responses of
+ * 0.5 to 4 s, in partitions of kConvolutionBlockSize frames.
+ * The first parameter is the impulse response length in ms.
+ * The second parameter is the number of tail threads per channel,
+ * 0 to convolve on the calling thread. The CPU column is the time of
+ * the calling thread only. Buffers are processed back to back, so the
+ * real time includes waiting for the workers, which have no idle time
+ * between buffers to finish the tail as they would in playback.
+ *******************************************************************/
+
+constexpr size_t kConvolutionBlockSize = 512;
+
+static void BM_CONVOLUTION_REVERB(benchmark::State& state) {
+    const size_t irFrames = (size_t)state.range(0) * kSampleRate / 1000;
+    const size_t tailThreadCount = state.range(1);
+    const size_t channelCount = FCC_2;
+
+    // Decaying noise impulse responses, and a deterministic pseudo-random input.
+    std::minstd_rand gen(irFrames);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<conv_fx::FloatVec> irs(channelCount, conv_fx::FloatVec(irFrames));
+    for (auto& ir : irs) {
+        for (size_t i = 0; i < irFrames; i++) {
+            ir[i] = dis(gen) * expf(-6.9f * i / irFrames);
+        }
+    }
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    conv_fx::ConvolutionReverb reverb(channelCount, irs, kConvolutionBlockSize, tailThreadCount);
+    reverb.setLevels(1.0f /* dryLevel */, 0.5f /* wetLevel */);
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        reverb.process(input.data(), output.data(), kFrameCount);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(irFrames);
+}
+
+static void CONVOLUTIONArgs(benchmark::internal::Benchmark* b) {
+    for (int irMs : {500, 1000, 2000, 4000}) {
+        for (int tailThreadCount : {0, 1, 2}) {
+            b->Args({irMs, tailThreadCount});
+        }
+    }
+}
+
+BENCHMARK(BM_CONVOLUTION_REVERB)->Apply(CONVOLUTIONArgs)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -199,9 +199,18 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
                  * Set the coefficients
                  */
                 pInstance->gain[i] = Coefficients.G;
+                /*
+                 * The band output is x + G * H(x), where H is the peaking filter
+                 *      H(z) = A0 * (1 - z^-2) / (1 - B1 * z^-1 - B2 * z^-2)
+                 * so the band is computed in place by the single biquad
+                 *      1 + G * H(z) = (1 + G * A0 - B1 * z^-1 - (B2 + G * A0) * z^-2)
+                 *                      / (1 - B1 * z^-1 - B2 * z^-2)
+                 * rather than by a biquad into a temporary buffer and a gain accumulation.
+                 */
+                const LVM_FLOAT GA0 = Coefficients.G * Coefficients.A0;
                 std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
-                        Coefficients.A0, 0.0, -(Coefficients.A0), -(Coefficients.B1),
-                        -(Coefficients.B2)};
+                        1.0f + GA0, -(Coefficients.B1), -(Coefficients.B2) - GA0,
+                        -(Coefficients.B1), -(Coefficients.B2)};
                 pInstance->eqBiquad[i]
                         .setCoefficients<
                                 std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(
@@ -106,12 +106,11 @@ LVEQNB_ReturnStatus_en LVEQNB_Process(
                      */
                     switch (pInstance->pBiquadType[i]) {
                         case LVEQNB_SinglePrecision_Float: {
-                            LVM_FLOAT* pTemp = pScratch + NrSamples;
-                            pInstance->eqBiquad[i].process(pTemp, pScratch, NrFrames);
-                            const auto gain = pInstance->gain[i];
-                            for (unsigned j = 0; j < NrSamples; ++j) {
-                                pScratch[j] += pTemp[j] * gain;
-                            }
+                            /*
+                             * The band gain and the input feed-through are folded into the
+                             * biquad coefficients, see LVEQNB_SetCoefficients.
+                             */
+                            pInstance->eqBiquad[i].process(pScratch, pScratch, NrFrames);
                             break;
                         }
                         default:
@@ -16,6 +16,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <vector>
 #define LOG_TAG "PreProcessing"
 //#define LOG_NDEBUG 0
 #include <audio_effects/effect_aec.h>
@@ -124,6 +126,17 @@ struct preproc_session_s {
     uint32_t revProcessedMsk;  // bit field containing IDs of pre processors with reverse
                                // channel already processed in current round
     webrtc::StreamConfig revConfig;     // reverse stream configuration.
+    // session on the same input stream, with the same processing, whose output is reused instead
+    // of running this session's APM. NULL if this session runs its own APM.
+    preproc_session_t* leader;
+    // input and output of the last frame processed by the APM, kept while other sessions are on
+    // the same input stream so that they can reuse the output.
+    std::vector<int16_t> lastIn;
+    std::vector<int16_t> lastOut;
+    // incremented by every command that may change the processing, the kept frame is only
+    // reused while it was processed with the current settings.
+    std::atomic<uint32_t> settingsGeneration;
+    uint32_t lastGeneration;    // settings generation of the kept frame
 };
 
 #ifdef DUAL_MIC_TEST
@@ -712,6 +725,7 @@ static const preproc_ops_t* sPreProcOps[PREPROC_NUM_EFFECTS] = {&sAgcOps,
 //------------------------------------------------------------------------------
 
 void Session_SetProcEnabled(preproc_session_t* session, uint32_t procId, bool enabled);
+void Session_StopSharing(preproc_session_t* session);
 
 extern "C" const struct effect_interface_s sEffectInterface;
 extern "C" const struct effect_interface_s sEffectInterfaceReverse;
@@ -835,6 +849,7 @@ int Session_Init(preproc_session_t* session) {
     session->id = 0;
     session->io = 0;
     session->createdMsk = 0;
+    session->leader = NULL;
     for (i = 0; i < PREPROC_NUM_EFFECTS && status == 0; i++) {
         status = Effect_Init(&session->effects[i], i);
     }
@@ -892,6 +907,7 @@ int Session_ReleaseEffect(preproc_session_t* session, preproc_effect_t* fx) {
         delete session->apm;
         session->apm = NULL;
         session->id = 0;
+        Session_StopSharing(session);
     }
 
     return 0;
@@ -998,6 +1014,142 @@ void Session_SetProcEnabled(preproc_session_t* session, uint32_t procId, bool en
 static int sInitStatus = 1;
 static preproc_session_t sSessions[PREPROC_NUM_SESSIONS];
 
+// Returns true if the two sessions process the same input stream into the same output: same
+// stream configuration, same enabled pre processors and same pre processor settings.
+bool Session_HasSameProcessing(preproc_session_t* session, preproc_session_t* other) {
+    if (other->io != session->io || other->createdMsk == 0 ||
+        other->state != PREPROC_SESSION_STATE_CONFIG ||
+        session->state != PREPROC_SESSION_STATE_CONFIG ||
+        other->samplingRate != session->samplingRate ||
+        other->inChannelCount != session->inChannelCount ||
+        other->outChannelCount != session->outChannelCount ||
+        other->revChannelCount != session->revChannelCount ||
+        other->enabledMsk != session->enabledMsk) {
+        return false;
+    }
+    // session->config mirrors the APM configuration, it is refreshed on every change.
+    const webrtc::AudioProcessing::Config& config = session->config;
+    const webrtc::AudioProcessing::Config& otherConfig = other->config;
+    if (session->enabledMsk & (1 << PREPROC_AGC)) {
+        if (config.gain_controller1.target_level_dbfs !=
+                    otherConfig.gain_controller1.target_level_dbfs ||
+            config.gain_controller1.compression_gain_db !=
+                    otherConfig.gain_controller1.compression_gain_db ||
+            config.gain_controller1.enable_limiter != otherConfig.gain_controller1.enable_limiter) {
+            return false;
+        }
+    }
+    if (session->enabledMsk & (1 << PREPROC_AGC2)) {
+        if (config.gain_controller2.fixed_digital.gain_db !=
+                    otherConfig.gain_controller2.fixed_digital.gain_db ||
+            config.gain_controller2.adaptive_digital.level_estimator !=
+                    otherConfig.gain_controller2.adaptive_digital.level_estimator ||
+            config.gain_controller2.adaptive_digital.extra_saturation_margin_db !=
+                    otherConfig.gain_controller2.adaptive_digital.extra_saturation_margin_db) {
+            return false;
+        }
+    }
+    if (session->enabledMsk & (1 << PREPROC_AEC)) {
+        if (config.echo_canceller.mobile_mode != otherConfig.echo_canceller.mobile_mode ||
+            session->apm->stream_delay_ms() != other->apm->stream_delay_ms()) {
+            return false;
+        }
+    }
+    if (session->enabledMsk & (1 << PREPROC_NS)) {
+        if (config.noise_suppression.level != otherConfig.noise_suppression.level) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns true if another session is on the same input stream as this one.
+bool Session_HasInputPeer(preproc_session_t* session) {
+    for (size_t i = 0; i < PREPROC_NUM_SESSIONS; i++) {
+        if (&sSessions[i] != session && sSessions[i].io == session->io &&
+            sSessions[i].createdMsk != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Session_StopSharing(preproc_session_t* session) {
+    for (size_t i = 0; i < PREPROC_NUM_SESSIONS; i++) {
+        if (sSessions[i].leader == session) {
+            sSessions[i].leader = NULL;
+        }
+    }
+    session->leader = NULL;
+    session->lastIn.clear();
+    session->lastOut.clear();
+}
+
+// Runs the APM of the session on one 10ms frame.
+// Concurrent capture sessions (e.g. VoIP and hotword) on the same input stream receive the same
+// frames, and often have the same pre processors enabled with the same settings. The first of
+// them to process a frame runs its APM and keeps the frame, the others then reuse its output
+// instead of running their own APM on identical input. A session that stops matching (different
+// settings, enabled pre processors or input) goes back to running its own APM.
+// All sessions on an input stream are processed by the same capture thread.
+int Session_ProcessStream(preproc_session_t* session, int16_t* in, int16_t* out) {
+    const size_t inSamples = session->frameCount * session->inChannelCount;
+    const size_t outSamples = session->frameCount * session->outputConfig.num_channels();
+
+    preproc_session_t* leader = session->leader;
+    if (leader == NULL) {
+        for (size_t i = 0; i < PREPROC_NUM_SESSIONS; i++) {
+            preproc_session_t* other = &sSessions[i];
+            if (other != session && other->io == session->io && other->leader == NULL &&
+                !other->lastIn.empty() && Session_HasSameProcessing(session, other)) {
+                leader = other;
+                break;
+            }
+        }
+    }
+    if (leader != NULL && leader->leader == NULL && leader->lastIn.size() == inSamples &&
+        leader->lastOut.size() == outSamples &&
+        leader->lastGeneration == leader->settingsGeneration &&
+        Session_HasSameProcessing(session, leader) &&
+        memcmp(leader->lastIn.data(), in, inSamples * sizeof(int16_t)) == 0) {
+        if (session->leader != leader) {
+            ALOGV("Session_ProcessStream session %d shares the processing of session %d",
+                  session->id, leader->id);
+            session->leader = leader;
+            session->lastIn.clear();
+            session->lastOut.clear();
+        }
+        memcpy(out, leader->lastOut.data(), outSamples * sizeof(int16_t));
+        return 0;
+    }
+    if (session->leader != NULL) {
+        ALOGV("Session_ProcessStream session %d stops sharing the processing of session %d",
+              session->id, session->leader->id);
+        session->leader = NULL;
+    }
+
+    // the input is kept first, the buffers may be the same.
+    const bool keepFrame = Session_HasInputPeer(session);
+    if (keepFrame) {
+        session->lastIn.assign(in, in + inSamples);
+        session->lastGeneration = session->settingsGeneration;
+    } else {
+        session->lastIn.clear();
+    }
+    if (int status = session->apm->ProcessStream(in, session->inputConfig, session->outputConfig,
+                                                  out);
+        status != 0) {
+        session->lastIn.clear();
+        return status;
+    }
+    if (keepFrame) {
+        session->lastOut.assign(out, out + outSamples);
+    } else {
+        session->lastOut.clear();
+    }
+    return 0;
+}
+
 preproc_session_t* PreProc_GetSession(int32_t procId, int32_t sessionId, int32_t ioId) {
     size_t i;
     for (i = 0; i < PREPROC_NUM_SESSIONS; i++) {
@@ -1081,11 +1233,7 @@ int PreProcessingFx_Process(effect_handle_t self, audio_buffer_t* inBuffer,
     //         inBuffer->frameCount, session->enabledMsk, session->processedMsk);
     if ((session->processedMsk & session->enabledMsk) == session->enabledMsk) {
         effect->session->processedMsk = 0;
-        if (int status = effect->session->apm->ProcessStream(
-                    (const int16_t* const)inBuffer->s16,
-                    (const webrtc::StreamConfig)effect->session->inputConfig,
-                    (const webrtc::StreamConfig)effect->session->outputConfig,
-                    (int16_t* const)outBuffer->s16);
+        if (int status = Session_ProcessStream(effect->session, inBuffer->s16, outBuffer->s16);
             status != 0) {
             ALOGE("Process Stream failed with error %d\n", status);
             return status;
@@ -1106,6 +1254,18 @@ int PreProcessingFx_Command(effect_handle_t self, uint32_t cmdCode, uint32_t cmd
 
     // ALOGV("PreProcessingFx_Command: command %d cmdSize %d",cmdCode, cmdSize);
 
+    switch (cmdCode) {
+        case EFFECT_CMD_GET_CONFIG:
+        case EFFECT_CMD_GET_CONFIG_REVERSE:
+        case EFFECT_CMD_GET_PARAM:
+        case EFFECT_CMD_GET_FEATURE_SUPPORTED_CONFIGS:
+        case EFFECT_CMD_GET_FEATURE_CONFIG:
+            break;
+        default:
+            effect->session->settingsGeneration++;
+            break;
+    }
+
     switch (cmdCode) {
         case EFFECT_CMD_INIT:
             if (pReplyData == NULL || *replySize != sizeof(int)) {
@@ -1484,6 +1644,14 @@ int PreProcessingFx_ProcessReverse(effect_handle_t self, audio_buffer_t* inBuffe
 
     if ((session->revProcessedMsk & session->revEnabledMsk) == session->revEnabledMsk) {
         effect->session->revProcessedMsk = 0;
+        if (effect->session->leader != NULL) {
+            // the far end is processed by the APM of the session this one shares.
+            if (outBuffer->raw != NULL && outBuffer->raw != inBuffer->raw) {
+                memcpy(outBuffer->s16, inBuffer->s16,
+                       inBuffer->frameCount * session->revConfig.num_channels() * sizeof(int16_t));
+            }
+            return 0;
+        }
         if (int status = effect->session->apm->ProcessReverseStream(
                     (const int16_t* const)inBuffer->s16,
                     (const webrtc::StreamConfig)effect->session->revConfig,
@@ -319,4 +319,111 @@ static void preprocessingArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_PREPROCESSING)->Apply(preprocessingArgs);
 
+// Concurrent capture sessions (e.g. VoIP and hotword) running the same effect on the same input
+// stream. The first parameter is the number of sessions, the second the effect index.
+static void BM_PREPROCESSING_SESSIONS(benchmark::State& state) {
+    const size_t chMask = kChMasks[0];
+    const size_t channelCount = audio_channel_count_from_in_mask(chMask);
+    const int sessionCount = state.range(0);
+
+    PreProcId effectType = (PreProcId)state.range(1);
+
+    int32_t ioId = 1;
+    std::vector<effect_handle_t> effectHandles(sessionCount);
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
+
+    for (int s = 0; s < sessionCount; ++s) {
+        int32_t sessionId = s + 1;
+        if (int status = preProcCreateEffect(&effectHandles[s], state.range(1), &config, sessionId,
+                                             ioId);
+            status != 0) {
+            ALOGE("Create effect call returned error %i", status);
+            return;
+        }
+        int reply = 0;
+        uint32_t replySize = sizeof(reply);
+        if (int status = (*effectHandles[s])
+                                 ->command(effectHandles[s], EFFECT_CMD_ENABLE, 0, nullptr,
+                                           &replySize, &reply);
+            status != 0) {
+            ALOGE("Command enable call returned error %d\n", reply);
+            return;
+        }
+        if (PREPROC_AEC == effectType) {
+            if (int status = preProcSetConfigParam(effectHandles[s], AEC_PARAM_ECHO_DELAY,
+                                                   kStreamDelayMs);
+                status != 0) {
+                ALOGE("preProcSetConfigParam returned Error %d\n", status);
+                return;
+            }
+        }
+    }
+
+    // Initialize input buffer with deterministic pseudo-random values
+    const int frameLength = (int)(kSampleRate * kTenMilliSecVal);
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<short> in(frameLength * channelCount);
+    std::vector<short> farIn(frameLength * channelCount);
+    std::vector<short> out(frameLength * channelCount);
+
+    // Run the test, with a new capture frame in each iteration
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (auto& i : in) {
+            i = preProcGetShortVal(dis(gen));
+        }
+        for (auto& i : farIn) {
+            i = preProcGetShortVal(dis(gen));
+        }
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(in.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(farIn.data());
+
+        audio_buffer_t inBuffer = {.frameCount = (size_t)frameLength, .s16 = in.data()};
+        audio_buffer_t outBuffer = {.frameCount = (size_t)frameLength, .s16 = out.data()};
+        audio_buffer_t farInBuffer = {.frameCount = (size_t)frameLength, .s16 = farIn.data()};
+
+        for (effect_handle_t effectHandle : effectHandles) {
+            if (int status = (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+                status != 0) {
+                ALOGE("\nError: Process i = %d returned with error %d\n", (int)state.range(1),
+                      status);
+                return;
+            }
+            if (PREPROC_AEC == effectType) {
+                if (int status = (*effectHandle)
+                                         ->process_reverse(effectHandle, &farInBuffer, &outBuffer);
+                    status != 0) {
+                    ALOGE("\nError: Process reverse i = %d returned with error %d\n",
+                          (int)state.range(1), status);
+                    return;
+                }
+            }
+        }
+    }
+    benchmark::ClobberMemory();
+
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+            return;
+        }
+    }
+}
+
+static void preprocessingSessionsArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 1; i <= 3; i++) {
+        for (int j = 0; j < (int)kNumEffectUuids; ++j) {
+            b->Args({i, j});
+        }
+    }
+}
+
+BENCHMARK(BM_PREPROCESSING_SESSIONS)->Apply(preprocessingSessionsArgs);
+
 BENCHMARK_MAIN();
@@ -19,6 +19,7 @@
 #include <getopt.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -324,6 +325,107 @@ INSTANTIATE_TEST_SUITE_P(
                            ::testing::Range(0, (int)EffectTestHelper::kNumLoopCounts),
                            ::testing::Range(0, (int)kNumPreProcParams)));
 
+typedef std::tuple<int, int> MultiSessionTestParam;
+class MultiSessionTest : public ::testing::TestWithParam<MultiSessionTestParam> {
+  public:
+    MultiSessionTest()
+        : mSampleRate(EffectTestHelper::kSampleRates[std::get<0>(GetParam())]),
+          mFrameCount(mSampleRate * EffectTestHelper::kTenMilliSecVal),
+          mTotalFrameCount(mFrameCount * kFrameCount),
+          mParamIdx(std::get<1>(GetParam())),
+          mOtherParamIdx(kNumPreProcParams - 1 - mParamIdx){};
+
+    struct Session {
+        std::unique_ptr<EffectTestHelper> effect;
+        bool aec;
+    };
+
+    void createSession(size_t paramIdx, int32_t sessionId, std::vector<Session>* sessions) {
+        const effect_uuid_t* uuid = kPreProcParams[paramIdx].uuid;
+        auto effect = std::make_unique<EffectTestHelper>(uuid, AUDIO_CHANNEL_IN_MONO, mSampleRate,
+                                                         1 /*loopCount*/, sessionId, kIoId);
+        ASSERT_NO_FATAL_FAILURE(effect->createEffect());
+        ASSERT_NO_FATAL_FAILURE(effect->setConfig(isAECEffect(uuid)));
+        ASSERT_NO_FATAL_FAILURE(setPreProcParams(uuid, *effect, paramIdx));
+        sessions->push_back({std::move(effect), isAECEffect(uuid)});
+    }
+
+    // Processes the input through the sessions one 10ms frame at a time, as a capture thread
+    // does, then releases them.
+    void processSessions(std::vector<Session>& sessions, std::vector<int16_t>& input,
+                         std::vector<int16_t>& farInput,
+                         std::vector<std::vector<int16_t>>* outputs) {
+        outputs->assign(sessions.size(), std::vector<int16_t>(mTotalFrameCount));
+        std::vector<int16_t> farOutput(mFrameCount);
+        for (size_t i = 0; i < kFrameCount; ++i) {
+            const size_t offset = i * mFrameCount;
+            for (size_t j = 0; j < sessions.size(); ++j) {
+                ASSERT_NO_FATAL_FAILURE(sessions[j].effect->process(
+                        &input[offset], &(*outputs)[j][offset], sessions[j].aec));
+                if (sessions[j].aec) {
+                    ASSERT_NO_FATAL_FAILURE(
+                            sessions[j].effect->process_reverse(&farInput[offset], farOutput.data()));
+                }
+            }
+        }
+        for (auto& session : sessions) {
+            ASSERT_NO_FATAL_FAILURE(session.effect->releaseEffect());
+        }
+    }
+
+    static constexpr size_t kFrameCount = 8;
+    static constexpr int32_t kIoId = 1;
+
+    const size_t mSampleRate;
+    const size_t mFrameCount;
+    const size_t mTotalFrameCount;
+    const size_t mParamIdx;
+    const size_t mOtherParamIdx;
+};
+
+// Runs two sessions with the same effect and parameters and a third one with other parameters
+// on the same input stream, and checks that each of them gets the output of a session running
+// alone, whether its processing is shared with another session or not.
+TEST_P(MultiSessionTest, SharedInput) {
+    SCOPED_TRACE(testing::Message() << " sampleRate: " << mSampleRate << " paramIdx " << mParamIdx
+                                    << " otherParamIdx " << mOtherParamIdx);
+
+    // Initialize input buffers with deterministic pseudo-random values
+    std::vector<int16_t> input(mTotalFrameCount);
+    std::vector<int16_t> farInput(mTotalFrameCount);
+    std::minstd_rand gen(mSampleRate);
+    std::uniform_int_distribution<int16_t> dis(INT16_MIN, INT16_MAX);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    for (auto& farIn : farInput) {
+        farIn = dis(gen);
+    }
+
+    std::vector<std::vector<int16_t>> refOutputs[2];
+    for (size_t k = 0; k < 2; ++k) {
+        std::vector<Session> sessions;
+        ASSERT_NO_FATAL_FAILURE(createSession(k == 0 ? mParamIdx : mOtherParamIdx, 1, &sessions));
+        ASSERT_NO_FATAL_FAILURE(processSessions(sessions, input, farInput, &refOutputs[k]));
+    }
+
+    std::vector<Session> sessions;
+    ASSERT_NO_FATAL_FAILURE(createSession(mParamIdx, 1, &sessions));
+    ASSERT_NO_FATAL_FAILURE(createSession(mParamIdx, 2, &sessions));
+    ASSERT_NO_FATAL_FAILURE(createSession(mOtherParamIdx, 3, &sessions));
+    std::vector<std::vector<int16_t>> outputs;
+    ASSERT_NO_FATAL_FAILURE(processSessions(sessions, input, farInput, &outputs));
+
+    EXPECT_EQ(refOutputs[0][0], outputs[0]) << "First session output does not match";
+    EXPECT_EQ(refOutputs[0][0], outputs[1]) << "Shared session output does not match";
+    EXPECT_EQ(refOutputs[1][0], outputs[2]) << "Other session output does not match";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        PreProcTestAll, MultiSessionTest,
+        ::testing::Combine(::testing::Range(0, (int)EffectTestHelper::kNumSampleRates),
+                           ::testing::Range(0, (int)kNumPreProcParams)));
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     int status = RUN_ALL_TESTS();
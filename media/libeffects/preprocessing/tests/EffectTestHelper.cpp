@@ -18,7 +18,8 @@
 extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
 
 void EffectTestHelper::createEffect() {
-    int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(mUuid, 1, 1, &mEffectHandle);
+    int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(mUuid, mSessionId, mIoId,
+                                                             &mEffectHandle);
     ASSERT_EQ(status, 0) << "create_effect returned an error " << status;
 }
 
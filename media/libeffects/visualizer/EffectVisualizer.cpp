@@ -27,6 +27,12 @@
 #include <algorithm> // max
 #include <new>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <log/log.h>
 
 #include <audio_effects/effect_visualizer.h>
@@ -134,6 +140,170 @@ void Visualizer_reset(VisualizerContext *pContext)
     memset(pContext->mCaptureBuf, 0x80, CAPTURE_BUF_SIZE);
 }
 
+#ifdef BUILD_FLOAT
+
+// Returns the peak absolute value of count samples, and the sum of their squares
+// in *sumSquares.
+static float Visualizer_peakAndSumSquares(const float *in, size_t count, float *sumSquares)
+{
+    size_t i = 0;
+    float maxSample = 0.f;
+    float sumSq = 0.f;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    if (count >= 8) {
+        float32x4_t max0 = vdupq_n_f32(0.f), max1 = vdupq_n_f32(0.f);
+        float32x4_t acc0 = vdupq_n_f32(0.f), acc1 = vdupq_n_f32(0.f);
+        for (; i + 8 <= count; i += 8) {
+            const float32x4_t x0 = vld1q_f32(in + i);
+            const float32x4_t x1 = vld1q_f32(in + i + 4);
+            max0 = vmaxq_f32(max0, vabsq_f32(x0));
+            max1 = vmaxq_f32(max1, vabsq_f32(x1));
+            acc0 = vmlaq_f32(acc0, x0, x0);
+            acc1 = vmlaq_f32(acc1, x1, x1);
+        }
+        float maxLanes[4], accLanes[4];
+        vst1q_f32(maxLanes, vmaxq_f32(max0, max1));
+        vst1q_f32(accLanes, vaddq_f32(acc0, acc1));
+        maxSample = std::max(std::max(maxLanes[0], maxLanes[1]), std::max(maxLanes[2], maxLanes[3]));
+        sumSq = (accLanes[0] + accLanes[1]) + (accLanes[2] + accLanes[3]);
+    }
+#elif defined(__SSE2__)
+    if (count >= 8) {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 max0 = _mm_setzero_ps(), max1 = _mm_setzero_ps();
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        for (; i + 8 <= count; i += 8) {
+            const __m128 x0 = _mm_loadu_ps(in + i);
+            const __m128 x1 = _mm_loadu_ps(in + i + 4);
+            max0 = _mm_max_ps(max0, _mm_and_ps(x0, absMask));
+            max1 = _mm_max_ps(max1, _mm_and_ps(x1, absMask));
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(x0, x0));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(x1, x1));
+        }
+        float maxLanes[4], accLanes[4];
+        _mm_storeu_ps(maxLanes, _mm_max_ps(max0, max1));
+        _mm_storeu_ps(accLanes, _mm_add_ps(acc0, acc1));
+        maxSample = std::max(std::max(maxLanes[0], maxLanes[1]), std::max(maxLanes[2], maxLanes[3]));
+        sumSq = (accLanes[0] + accLanes[1]) + (accLanes[2] + accLanes[3]);
+    }
+#endif
+    for (; i < count; ++i) {
+        maxSample = fmax(maxSample, fabs(in[i]));
+        sumSq += in[i] * in[i];
+    }
+    *sumSquares = sumSq;
+    return maxSample;
+}
+
+// Returns the peak absolute value of the sum of the channels of each frame.
+static float Visualizer_peakOfChannelSum(const float *in, size_t frameCount, uint32_t channelCount)
+{
+    size_t i = 0;
+    float maxSample = 0.f;
+    if (channelCount == FCC_2) {
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+        float32x4_t maxSum = vdupq_n_f32(0.f);
+        for (; i + 4 <= frameCount; i += 4) {
+            const float32x4x2_t x = vld2q_f32(in + i * FCC_2);
+            maxSum = vmaxq_f32(maxSum, vabsq_f32(vaddq_f32(x.val[0], x.val[1])));
+        }
+        float lanes[4];
+        vst1q_f32(lanes, maxSum);
+        maxSample = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(__SSE2__)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 maxSum = _mm_setzero_ps();
+        for (; i + 4 <= frameCount; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + i * FCC_2);
+            const __m128 b = _mm_loadu_ps(in + i * FCC_2 + 4);
+            const __m128 sum = _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                    _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            maxSum = _mm_max_ps(maxSum, _mm_and_ps(sum, absMask));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, maxSum);
+        maxSample = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    }
+    for (const float *frame = in + i * channelCount; i < frameCount; ++i) {
+        // we reconstruct the actual summed value to ensure proper normalization
+        // for multichannel outputs (channels > 2 may often be 0).
+        float smp = 0.f;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            smp += *frame++;
+        }
+        maxSample = fmax(maxSample, fabs(smp));
+    }
+    return maxSample;
+}
+
+// Writes the scaled sum of the channels of each frame to the capture buffer as
+// 8 bit samples, from captIdx on, and returns the capture index after the last one.
+static uint32_t Visualizer_capture(const float *in, size_t frameCount, uint32_t channelCount,
+        float fscale, uint8_t *buf, uint32_t captIdx)
+{
+    while (frameCount > 0) {
+        if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
+        const size_t frames = std::min(frameCount, (size_t)(CAPTURE_BUF_SIZE - captIdx));
+        uint8_t *out = buf + captIdx;
+        size_t i = 0;
+        if (channelCount == FCC_2) {
+            // The same conversion as clamp8_from_float(), which recenters [-1.0, 1.0)
+            // into the low bits of the significand and clamps the float as an integer.
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+            const float32x4_t scale = vdupq_n_f32(fscale);
+            const float32x4_t offset = vdupq_n_f32((float)((3 << (22 - 7)) + 1));
+            const float32x4_t limNeg = vreinterpretq_f32_s32(vdupq_n_s32(0x10f << 22));
+            const float32x4_t limPos = vreinterpretq_f32_s32(vdupq_n_s32(0x43c001fe));
+            for (; i + 8 <= frames; i += 8) {
+                uint16x4_t half[2];
+                for (int h = 0; h < 2; ++h) {
+                    const float32x4x2_t x = vld2q_f32(in + (i + h * 4) * FCC_2);
+                    float32x4_t v = vaddq_f32(
+                            vmulq_f32(vaddq_f32(x.val[0], x.val[1]), scale), offset);
+                    v = vminq_f32(vmaxq_f32(v, limNeg), limPos);
+                    half[h] = vmovn_u32(vshrq_n_u32(vreinterpretq_u32_f32(v), 1));
+                }
+                vst1_u8(out + i, vmovn_u16(vcombine_u16(half[0], half[1])));
+            }
+#elif defined(__SSE2__)
+            const __m128 scale = _mm_set1_ps(fscale);
+            const __m128 offset = _mm_set1_ps((float)((3 << (22 - 7)) + 1));
+            const __m128 limNeg = _mm_castsi128_ps(_mm_set1_epi32(0x10f << 22));
+            const __m128 limPos = _mm_castsi128_ps(_mm_set1_epi32(0x43c001fe));
+            const __m128i lowByte = _mm_set1_epi32(0xff);
+            for (; i + 8 <= frames; i += 8) {
+                __m128i half[2];
+                for (int h = 0; h < 2; ++h) {
+                    const __m128 a = _mm_loadu_ps(in + (i + h * 4) * FCC_2);
+                    const __m128 b = _mm_loadu_ps(in + (i + h * 4) * FCC_2 + 4);
+                    const __m128 sum = _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                            _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                    __m128 v = _mm_add_ps(_mm_mul_ps(sum, scale), offset);
+                    v = _mm_min_ps(_mm_max_ps(v, limNeg), limPos);
+                    half[h] = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(v), 1), lowByte);
+                }
+                const __m128i words = _mm_packs_epi32(half[0], half[1]);
+                _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(words, words));
+            }
+#endif
+        }
+        for (const float *frame = in + i * channelCount; i < frames; ++i) {
+            float smp = 0.f;
+            for (uint32_t c = 0; c < channelCount; ++c) {
+                smp += *frame++;
+            }
+            out[i] = clamp8_from_float(smp * fscale);
+        }
+        in += frames * channelCount;
+        frameCount -= frames;
+        captIdx += frames;
+    }
+    return captIdx;
+}
+
+#endif // BUILD_FLOAT
+
 //----------------------------------------------------------------------------
 // Visualizer_setConfig()
 //----------------------------------------------------------------------------
@@ -342,11 +512,7 @@ int Visualizer_process(
         float rmsSqAcc = 0;
 
 #ifdef BUILD_FLOAT
-        float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ++inIdx) {
-            maxSample = fmax(maxSample, fabs(inBuffer->f32[inIdx]));
-            rmsSqAcc += inBuffer->f32[inIdx] * inBuffer->f32[inIdx];
-        }
+        float maxSample = Visualizer_peakAndSumSquares(inBuffer->f32, sampleLen, &rmsSqAcc);
         maxSample *= 1 << 15; // scale to int16_t, with exactly 1 << 15 representing positive num.
         rmsSqAcc *= 1 << 30; // scale to int16_t * 2
 #else
@@ -377,16 +543,8 @@ int Visualizer_process(
         // this gives more interesting captures for display.
 
 #ifdef BUILD_FLOAT
-        float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ) {
-            // we reconstruct the actual summed value to ensure proper normalization
-            // for multichannel outputs (channels > 2 may often be 0).
-            float smp = 0.f;
-            for (int i = 0; i < pContext->mChannelCount; ++i) {
-                smp += inBuffer->f32[inIdx++];
-            }
-            maxSample = fmax(maxSample, fabs(smp));
-        }
+        const float maxSample = Visualizer_peakOfChannelSum(
+                inBuffer->f32, inBuffer->frameCount, pContext->mChannelCount);
         if (maxSample > 0.f) {
             fscale = 0.99f / maxSample;
             int exp; // unused
@@ -427,6 +585,10 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+#ifdef BUILD_FLOAT
+    const uint32_t captIdx = Visualizer_capture(inBuffer->f32, inBuffer->frameCount,
+            pContext->mChannelCount, fscale, pContext->mCaptureBuf, pContext->mCaptureIdx);
+#else
     uint32_t captIdx;
     uint32_t inIdx;
     uint8_t *buf = pContext->mCaptureBuf;
@@ -435,18 +597,11 @@ int Visualizer_process(
          captIdx++) {
         if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
 
-#ifdef BUILD_FLOAT
-        float smp = 0.f;
-        for (uint32_t i = 0; i < pContext->mChannelCount; ++i) {
-            smp += inBuffer->f32[inIdx++];
-        }
-        buf[captIdx] = clamp8_from_float(smp * fscale);
-#else
         const int32_t smp = (inBuffer->s16[inIdx] + inBuffer->s16[inIdx + 1]) >> shift;
         inIdx += FCC_2;  // integer supports stereo only.
         buf[captIdx] = ((uint8_t)smp)^0x80;
-#endif // BUILD_FLOAT
     }
+#endif // BUILD_FLOAT
 
     // XXX the following two should really be atomic, though it probably doesn't
     // matter much for visualization purposes
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <audio_effects/effect_visualizer.h>
+#include <benchmark/benchmark.h>
+#include <hardware/audio_effect.h>
+#include <log/log.h>
+#include <system/audio.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+// Google Visualizer UUID: d069d9e0-8329-11df-9168-0002a5d5c51b
+static constexpr effect_uuid_t kVisualizerUuid = {
+    0xd069d9e0, 0x8329, 0x11df, 0x9168, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}};
+
+static constexpr size_t kFrameCount = 1024;
+static constexpr int kSampleRate = 48000;
+
+static constexpr audio_channel_mask_t kChannelMasks[] = {
+    AUDIO_CHANNEL_OUT_STEREO,
+    AUDIO_CHANNEL_OUT_5POINT1,
+};
+
+static constexpr uint32_t kScalingModes[] = {
+    VISUALIZER_SCALING_MODE_NORMALIZED,
+    VISUALIZER_SCALING_MODE_AS_PLAYED,
+};
+
+static constexpr uint32_t kMeasurementModes[] = {
+    MEASUREMENT_MODE_NONE,
+    MEASUREMENT_MODE_PEAK_RMS,
+};
+
+static int setParam(effect_handle_t effectHandle, uint32_t paramType, uint32_t value) {
+    uint32_t buf[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+    effect_param_t *param = (effect_param_t *)buf;
+    param->psize = sizeof(uint32_t);
+    param->vsize = sizeof(uint32_t);
+    *(uint32_t *)param->data = paramType;
+    *((uint32_t *)param->data + 1) = value;
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_SET_PARAM, sizeof(buf), param,
+                                          &replySize, &reply);
+    return status != 0 ? status : reply;
+}
+
+static void BM_Visualizer(benchmark::State& state) {
+    const audio_channel_mask_t channelMask = kChannelMasks[state.range(0)];
+    const uint32_t scalingMode = kScalingModes[state.range(1)];
+    const uint32_t measurementMode = kMeasurementModes[state.range(2)];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+            &kVisualizerUuid, 1, 1, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = channelMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_SET_CONFIG,
+                                              sizeof(effect_config_t), &config,
+                                              &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        return;
+    }
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr,
+                                              &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        return;
+    }
+    if (int status = setParam(effectHandle, VISUALIZER_PARAM_SCALING_MODE, scalingMode);
+        status != 0) {
+        ALOGE("Setting the scaling mode returned an error = %d\n", status);
+        return;
+    }
+    if (int status = setParam(effectHandle, VISUALIZER_PARAM_MEASUREMENT_MODE, measurementMode);
+        status != 0) {
+        ALOGE("Setting the measurement mode returned an error = %d\n", status);
+        return;
+    }
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(std::to_string(channelCount) + " channels"
+            + (scalingMode == VISUALIZER_SCALING_MODE_NORMALIZED ? " normalized" : " as played")
+            + (measurementMode == MEASUREMENT_MODE_PEAK_RMS ? " peak rms" : ""));
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+    }
+}
+
+static void VisualizerArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kChannelMasks); i++) {
+        for (int j = 0; j < (int)std::size(kScalingModes); j++) {
+            for (int k = 0; k < (int)std::size(kMeasurementModes); k++) {
+                b->Args({i, j, k});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Visualizer)->Apply(VisualizerArgs);
+
+BENCHMARK_MAIN();
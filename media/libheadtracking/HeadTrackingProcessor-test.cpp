@@ -106,6 +106,37 @@ TEST(HeadTrackingProcessor, Prediction) {
     EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
 }
 
+TEST(HeadTrackingProcessor, Burst) {
+    const Options options{.predictionDuration = 2.f,
+                          .autoRecenterWindowDuration = 10,
+                          .autoRecenterTranslationalThreshold = 0.1f,
+                          .autoRecenterRotationalThreshold = 0.1f};
+    std::unique_ptr<HeadTrackingProcessor> single =
+            createHeadTrackingProcessor(options, HeadTrackingMode::WORLD_RELATIVE);
+    std::unique_ptr<HeadTrackingProcessor> burst =
+            createHeadTrackingProcessor(options, HeadTrackingMode::WORLD_RELATIVE);
+
+    std::vector<HeadTrackingProcessor::HeadPoseSample> samples;
+    for (int64_t t = 0; t < 40; ++t) {
+        samples.push_back({t, Pose3f({0.01f * t, 0, 0}, rotateZ(0.02f * t)),
+                           Twist3f({0.01f, 0, 0}, {0, 0, 0.02f})});
+    }
+
+    // Deliver samples one by one, or in bursts of 8, and compare at the end of each burst.
+    for (size_t i = 0; i < samples.size(); i += 8) {
+        for (size_t j = i; j < i + 8; ++j) {
+            single->setWorldToHeadPose(samples[j].timestamp, samples[j].worldToHead,
+                                       samples[j].headTwist);
+        }
+        burst->setWorldToHeadPoses(&samples[i], 8);
+        const int64_t timestamp = samples[i + 7].timestamp;
+        single->calculate(timestamp);
+        burst->calculate(timestamp);
+        EXPECT_EQ(single->getActualMode(), burst->getActualMode());
+        EXPECT_EQ(single->getHeadToStagePose(), burst->getHeadToStagePose());
+    }
+}
+
 TEST(HeadTrackingProcessor, SmoothModeSwitch) {
     const Pose3f targetHeadToWorld = Pose3f({4, 0, 0}, rotateZ(M_PI / 2));
 
@@ -13,12 +13,14 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <chrono>
 #include <inttypes.h>
 
 #include <android-base/stringprintf.h>
 #include <audio_utils/SimpleLog.h>
 #include "media/HeadTrackingProcessor.h"
 #include "media/QuaternionUtil.h"
+#include "media/VectorRecorder.h"
 
 #include "ModeSelector.h"
 #include "PoseBias.h"
@@ -60,11 +62,32 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
     void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                             const Twist3f& headTwist) override {
-        const Pose3f predictedWorldToHead = mPosePredictor.predict(
-                timestamp, worldToHead, headTwist, mOptions.predictionDuration);
+        const HeadPoseSample sample{timestamp, worldToHead, headTwist};
+        setWorldToHeadPoses(&sample, 1);
+    }
+
+    void setWorldToHeadPoses(const HeadPoseSample* samples, size_t count) override {
+        if (count == 0) return;
+        const auto startTime = std::chrono::steady_clock::now();
+
+        // Every sample goes through the predictor and the stillness window, but only the
+        // last one is used by the pose bias.
+        Pose3f predictedWorldToHead;
+        for (size_t i = 0; i < count; ++i) {
+            const HeadPoseSample& sample = samples[i];
+            predictedWorldToHead = mPosePredictor.predict(sample.timestamp, sample.worldToHead,
+                                                          sample.headTwist,
+                                                          mOptions.predictionDuration);
+            mHeadStillnessDetector.setInput(sample.timestamp, predictedWorldToHead);
+        }
         mHeadPoseBias.setInput(predictedWorldToHead);
-        mHeadStillnessDetector.setInput(timestamp, predictedWorldToHead);
-        mWorldToHeadTimestamp = timestamp;
+        mWorldToHeadTimestamp = samples[count - 1].timestamp;
+
+        const std::chrono::duration<float, std::micro> cost =
+                std::chrono::steady_clock::now() - startTime;
+        mCostRecord[0] = cost.count() / count;
+        mCostRecord[1] = count;
+        mCostRecorder.record(mCostRecord);
     }
 
     void setWorldToScreenPose(int64_t timestamp, const Pose3f& worldToScreen) override {
@@ -192,6 +215,8 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
         ss += mModeSelector.toString(level + 1);
         ss += mRateLimiter.toString(level + 1);
         ss += mPosePredictor.toString(level + 1);
+        ss.append(prefixSpace + " HeadPoseCost [ us per sample : samples per burst ]:\n");
+        ss += mCostRecorder.toString(level + 2);
         ss.append(prefixSpace + "ReCenterHistory:\n");
         ss += mLocalLog.dumpToString((prefixSpace + " ").c_str(), mMaxLocalLogLine);
         return ss;
@@ -216,6 +241,10 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     PosePredictor mPosePredictor;
     static constexpr std::size_t mMaxLocalLogLine = 10;
     SimpleLog mLocalLog{mMaxLocalLogLine};
+    // Processing cost of the world-to-head samples, per minute.
+    std::vector<float> mCostRecord = std::vector<float>(2);
+    VectorRecorder mCostRecorder{
+        2 /* vectorSize */, std::chrono::minutes(1), mMaxLocalLogLine, { 1 } /* delimiterIdx */};
 };
 
 }  // namespace
@@ -132,7 +132,7 @@ Pose3f PosePredictor::predict(
     }
     mLastTimestampNs = timestampNs;
 
-    auto selectedPredictor = getCurrentPredictor();
+    const auto& selectedPredictor = getCurrentPredictor();
     if constexpr (kEnableVerification) {
         // Update all Predictors
         for (const auto& predictor : mPredictors) {
@@ -229,7 +229,7 @@ std::string PosePredictor::toString(size_t index) const {
     return ss;
 }
 
-std::shared_ptr<PredictorBase> PosePredictor::getCurrentPredictor() const {
+const std::shared_ptr<PredictorBase>& PosePredictor::getCurrentPredictor() const {
     // we don't use a map here, we look up directly
     switch (mCurrentType) {
     default:
@@ -208,8 +208,8 @@ private:
     int64_t mResets{};
     int64_t mLastTimestampNs{};
 
-    // Returns current predictor
-    std::shared_ptr<PredictorBase> getCurrentPredictor() const;
+    // Returns current predictor, without a reference count update per sample.
+    const std::shared_ptr<PredictorBase>& getCurrentPredictor() const;
 };
 
 }  // namespace android::media
@@ -16,6 +16,8 @@
 
 #include "StillnessDetector.h"
 
+#include <algorithm>
+
 namespace android {
 namespace media {
 
@@ -23,7 +25,9 @@ StillnessDetector::StillnessDetector(const Options& options)
     : mOptions(options), mCosHalfRotationalThreshold(cos(mOptions.rotationalThreshold / 2)) {}
 
 void StillnessDetector::reset() {
-    mFifo.clear();
+    // Keep the buffer, as the next window is likely to be as large.
+    mFifoFront = 0;
+    mFifoSize = 0;
     mWindowFull = false;
     mSuppressionDeadline.reset();
     // A "true" state indicates stillness is detected (default = true)
@@ -32,10 +36,26 @@ void StillnessDetector::reset() {
 }
 
 void StillnessDetector::setInput(int64_t timestamp, const Pose3f& input) {
-    mFifo.push_back(TimestampedPose{timestamp, input});
+    fifoPush(timestamp, input);
     discardOld(timestamp);
 }
 
+void StillnessDetector::fifoPush(int64_t timestamp, const Pose3f& pose) {
+    if (mFifoSize == mFifo.size()) {
+        // Grow, moving the window to the start of the new buffer.
+        std::vector<TimestampedPose> fifo;
+        fifo.reserve(std::max(kMinFifoCapacity, mFifo.size() * 2));
+        for (size_t i = 0; i < mFifoSize; ++i) {
+            fifo.push_back(fifoAt(i));
+        }
+        fifo.resize(fifo.capacity());
+        mFifo.swap(fifo);
+        mFifoFront = 0;
+    }
+    mFifo[(mFifoFront + mFifoSize) % mFifo.size()] = TimestampedPose{timestamp, pose};
+    ++mFifoSize;
+}
+
 bool StillnessDetector::getPreviousState() const {
     return mPreviousState;
 }
@@ -54,10 +74,11 @@ bool StillnessDetector::calculate(int64_t timestamp) {
     // one ends after the current one.
     bool moved = false;
 
-    if (!mFifo.empty()) {
-        for (auto iter = mFifo.rbegin() + 1; iter != mFifo.rend(); ++iter) {
-            const auto& event = *iter;
-            if (!areNear(event.pose, mFifo.back().pose)) {
+    if (mFifoSize > 0) {
+        const Pose3f& latest = fifoAt(mFifoSize - 1).pose;
+        for (size_t i = mFifoSize - 1; i-- > 0; ) {
+            const auto& event = fifoAt(i);
+            if (!areNear(event.pose, latest)) {
                 // Enable suppression for the duration of the window.
                 int64_t deadline = event.timestamp + mOptions.windowDuration;
                 if (!mSuppressionDeadline.has_value() || mSuppressionDeadline.value() < deadline) {
@@ -87,16 +108,18 @@ bool StillnessDetector::calculate(int64_t timestamp) {
 void StillnessDetector::discardOld(int64_t timestamp) {
     // Handle the special case of the window duration being zero (always considered full).
     if (mOptions.windowDuration == 0) {
-        mFifo.clear();
+        mFifoFront = 0;
+        mFifoSize = 0;
         mWindowFull = true;
     }
 
     // Remove any events from the queue that are older than the window. If there were any such
     // events we consider the window full.
     const int64_t windowStart = timestamp - mOptions.windowDuration;
-    while (!mFifo.empty() && mFifo.front().timestamp <= windowStart) {
+    while (mFifoSize > 0 && fifoAt(0).timestamp <= windowStart) {
         mWindowFull = true;
-        mFifo.pop_front();
+        mFifoFront = (mFifoFront + 1) % mFifo.size();
+        --mFifoSize;
     }
 
     // Expire the suppression deadline.
@@ -15,7 +15,8 @@
  */
 #pragma once
 
-#include <deque>
+#include <optional>
+#include <vector>
 
 #include <media/Pose.h>
 
@@ -83,6 +84,8 @@ class StillnessDetector {
     /** Return the stillness state from the previous call to calculate() */
     bool getPreviousState() const;
   private:
+    static constexpr size_t kMinFifoCapacity = 64;
+
     struct TimestampedPose {
         int64_t timestamp;
         Pose3f pose;
@@ -91,7 +94,12 @@ class StillnessDetector {
     const Options mOptions;
     // Precalculated cos(mOptions.rotationalThreshold / 2)
     const float mCosHalfRotationalThreshold;
-    std::deque<TimestampedPose> mFifo;
+    // The poses of the window, oldest first, in a ring buffer starting at mFifoFront.
+    // The buffer only grows until it holds a window at the sensor rate, so once the window
+    // has been filled, samples are pushed and discarded without allocating.
+    std::vector<TimestampedPose> mFifo;
+    size_t mFifoFront = 0;
+    size_t mFifoSize = 0;
     bool mWindowFull = false;
     bool mCurrentState = true;
     bool mPreviousState = true;
@@ -103,6 +111,12 @@ class StillnessDetector {
 
     bool areNear(const Pose3f& pose1, const Pose3f& pose2) const;
     void discardOld(int64_t timestamp);
+
+    // Returns the i-th oldest pose of the window.
+    const TimestampedPose& fifoAt(size_t i) const {
+        return mFifo[(mFifoFront + i) % mFifo.size()];
+    }
+    void fifoPush(int64_t timestamp, const Pose3f& pose);
 };
 
 }  // namespace media
@@ -59,6 +59,22 @@ class HeadTrackingProcessor {
     virtual void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                                     const Twist3f& headTwist) = 0;
 
+    /**
+     * A world-to-head sample, as given to setWorldToHeadPose().
+     */
+    struct HeadPoseSample {
+        int64_t timestamp;
+        Pose3f worldToHead;
+        Twist3f headTwist;
+    };
+
+    /**
+     * Sets a burst of world-to-head samples at once, in timestamp order.
+     * This is equivalent to calling setWorldToHeadPose() for each sample, with less work
+     * for the samples that are superseded within the burst.
+     */
+    virtual void setWorldToHeadPoses(const HeadPoseSample* samples, size_t count) = 0;
+
     /**
      * Sets the world-to-screen pose.
      */
@@ -33,6 +33,7 @@
 #include <private/media/VideoFrame.h>
 #include <utils/Log.h>
 #include <utils/RefBase.h>
+#include <utils/Timers.h>
 #include <vector>
 
 HeifDecoder* createHeifDecoder() {
@@ -315,10 +316,12 @@ HeifDecoderImpl::HeifDecoderImpl() :
     mHasImage(false),
     mHasVideo(false),
     mSequenceLength(0),
+    mDecodeStartNs(0),
     mAvailableLines(0),
     mNumSlices(1),
     mSliceHeight(0),
-    mAsyncDecodeDone(false) {
+    mAsyncDecodeDone(false),
+    mDecodeTimeUs(-1) {
 }
 
 HeifDecoderImpl::~HeifDecoderImpl() {
@@ -531,6 +534,9 @@ bool HeifDecoderImpl::decodeAsync() {
             mFrameMemory = frameMemory;
             mAvailableLines = bottom;
             ALOGV("decodeAsync(): available lines %zu", mAvailableLines);
+            if (i == mNumSlices - 1) {
+                mDecodeTimeUs = ns2us(systemTime() - mDecodeStartNs);
+            }
             mScanlineReady.signal();
         }
     }
@@ -549,6 +555,9 @@ bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
         return true;
     }
 
+    mDecodeStartNs = systemTime();
+    setDecodeTimeUs(-1);
+
     // See if we want to decode in slices to allow client to start
     // scanline processing in parallel with decode. If this fails
     // we fallback to decoding the full frame.
@@ -634,6 +643,7 @@ bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
 
     }
     mFrameDecoded = true;
+    setDecodeTimeUs(ns2us(systemTime() - mDecodeStartNs));
 
     // Aggressively clear to avoid holding on to resources
     mRetriever.clear();
@@ -658,6 +668,8 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
     // set total scanline to sequence height now
     mTotalScanline = mSequenceInfo.mHeight;
 
+    mDecodeStartNs = systemTime();
+    setDecodeTimeUs(-1);
     mFrameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
     if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
         ALOGE("decode: videoFrame is a nullptr");
@@ -687,6 +699,7 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
     if (frameInfo != nullptr) {
         initFrameInfo(frameInfo, videoFrame);
     }
+    setDecodeTimeUs(ns2us(systemTime() - mDecodeStartNs));
     return true;
 }
 
@@ -740,4 +753,14 @@ uint32_t HeifDecoderImpl::getColorDepth() {
     return 0;
 }
 
+int64_t HeifDecoderImpl::getDecodeTimeUs() {
+    Mutex::Autolock autolock(mLock);
+    return mDecodeTimeUs;
+}
+
+void HeifDecoderImpl::setDecodeTimeUs(int64_t decodeTimeUs) {
+    Mutex::Autolock autolock(mLock);
+    mDecodeTimeUs = decodeTimeUs;
+}
+
 } // namespace android
@@ -56,6 +56,8 @@ public:
 
     uint32_t getColorDepth() override;
 
+    int64_t getDecodeTimeUs() override;
+
 private:
     struct DecodeThread;
 
@@ -71,6 +73,7 @@ private:
     bool mHasImage;
     bool mHasVideo;
     size_t mSequenceLength;
+    nsecs_t mDecodeStartNs;
 
     // Slice decoding only
     Mutex mLock;
@@ -80,8 +83,10 @@ private:
     size_t mNumSlices;
     uint32_t mSliceHeight;
     bool mAsyncDecodeDone;
+    int64_t mDecodeTimeUs; // guarded by mLock
 
     bool decodeAsync();
+    void setDecodeTimeUs(int64_t decodeTimeUs);
     bool getScanlineInner(uint8_t* dst);
     bool reinit(HeifFrameInfo* frameInfo);
 };
@@ -168,6 +168,12 @@ struct HeifDecoder {
      */
     virtual uint32_t getColorDepth() = 0;
 
+    /*
+     * Returns the time in us it took to decode the last picture in full, or -1
+     * if no picture was decoded yet or slices of it are still being decoded.
+     */
+    virtual int64_t getDecodeTimeUs() = 0;
+
 private:
     HeifDecoder(const HeifFrameInfo&) = delete;
     HeifDecoder& operator=(const HeifFrameInfo&) = delete;
@@ -29,13 +29,91 @@
 #include <unicode/ustring.h>
 
 #include <cutils/properties.h>
+#include <utils/Mutex.h>
+
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace android {
 
+// Opening ICU detectors and converters loads and sets up conversion tables, and a media scan
+// creates a detector for every file. Idle ones are kept here and reused across detectors.
+class IcuObjectPool {
+public:
+    static IcuObjectPool &getInstance() {
+        static IcuObjectPool sInstance;
+        return sInstance;
+    }
+
+    UCharsetDetector *acquireDetector(UErrorCode *status) {
+        {
+            Mutex::Autolock lock(mLock);
+            if (!mDetectors.empty()) {
+                UCharsetDetector *csd = mDetectors.back();
+                mDetectors.pop_back();
+                return csd;
+            }
+        }
+        return ucsdet_open(status);
+    }
+
+    void releaseDetector(UCharsetDetector *csd) {
+        if (csd == NULL) {
+            return;
+        }
+        Mutex::Autolock lock(mLock);
+        if (mDetectors.size() < kMaxIdleDetectors) {
+            mDetectors.push_back(csd);
+            return;
+        }
+        ucsdet_close(csd);
+    }
+
+    UConverter *acquireConverter(const char *name, UErrorCode *status) {
+        {
+            Mutex::Autolock lock(mLock);
+            for (auto it = mConverters.begin(); it != mConverters.end(); ++it) {
+                if (it->first == name) {
+                    UConverter *conv = it->second;
+                    mConverters.erase(it);
+                    return conv;
+                }
+            }
+        }
+        return ucnv_open(name, status);
+    }
+
+    // name is the one the converter was acquired with.
+    void releaseConverter(const char *name, UConverter *conv) {
+        if (conv == NULL) {
+            return;
+        }
+        ucnv_reset(conv);
+        Mutex::Autolock lock(mLock);
+        if (mConverters.size() >= kMaxIdleConverters) {
+            ucnv_close(mConverters.front().second);
+            mConverters.erase(mConverters.begin());
+        }
+        mConverters.emplace_back(name, conv);
+    }
+
+private:
+    static constexpr size_t kMaxIdleDetectors = 4;
+    static constexpr size_t kMaxIdleConverters = 16;
+
+    IcuObjectPool() = default;
+
+    Mutex mLock;
+    std::vector<UCharsetDetector *> mDetectors;
+    // Least recently released first.
+    std::vector<std::pair<std::string, UConverter *>> mConverters;
+};
+
 CharacterEncodingDetector::CharacterEncodingDetector() {
 
     UErrorCode status = U_ZERO_ERROR;
-    mUtf8Conv = ucnv_open("UTF-8", &status);
+    mUtf8Conv = IcuObjectPool::getInstance().acquireConverter("UTF-8", &status);
     if (U_FAILURE(status)) {
         ALOGE("could not create UConverter for UTF-8");
         mUtf8Conv = NULL;
@@ -63,7 +141,7 @@ CharacterEncodingDetector::CharacterEncodingDetector() {
 }
 
 CharacterEncodingDetector::~CharacterEncodingDetector() {
-    ucnv_close(mUtf8Conv);
+    IcuObjectPool::getInstance().releaseConverter("UTF-8", mUtf8Conv);
 }
 
 void CharacterEncodingDetector::addTag(const char *name, const char *value) {
@@ -85,8 +163,27 @@ status_t CharacterEncodingDetector::getTag(int index, const char **name, const c
     return OK;
 }
 
+static constexpr uint64_t kOnes = 0x0101010101010101ull;
+static constexpr uint64_t kHighBits = 0x8080808080808080ull;
+
+// Nonzero if any byte of w is below n, for words without high bits and n <= 0x80.
+// The subtraction borrows across bytes by design.
+__attribute__((no_sanitize("integer")))
+static inline uint64_t hasByteBelow(uint64_t w, uint8_t n) {
+    return (w - n * kOnes) & ~w & kHighBits;
+}
+
 static bool isPrintableAscii(const char *value, size_t len) {
-    for (size_t i = 0; i < len; i++) {
+    // Tags are nearly always plain ASCII, so whole words are checked first.
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t w;
+        memcpy(&w, value + i, sizeof(w));
+        if ((w & kHighBits) || hasByteBelow(w, 0x20) || hasByteBelow(w ^ (0x7f * kOnes), 1)) {
+            return false;
+        }
+    }
+    for (; i < len; i++) {
         if ((value[i] & 0x80) || value[i] < 0x20 || value[i] == 0x7f) {
             return false;
         }
@@ -94,6 +191,62 @@ static bool isPrintableAscii(const char *value, size_t len) {
     return true;
 }
 
+// True if value is well formed UTF-8 with at least one multibyte sequence. Overlong forms,
+// surrogates and code points above U+10FFFF are rejected, as are C0 control characters, so
+// legacy 8-bit encodings practically never pass.
+static bool isMultibyteUtf8(const char *value, size_t len) {
+    const uint8_t *s = reinterpret_cast<const uint8_t *>(value);
+    bool multibyte = false;
+    size_t i = 0;
+    while (i < len) {
+        if (i + sizeof(uint64_t) <= len) {
+            uint64_t w;
+            memcpy(&w, s + i, sizeof(w));
+            if (!(w & kHighBits)) {
+                if (hasByteBelow(w, 0x20)) {
+                    return false;
+                }
+                i += sizeof(uint64_t);
+                continue;
+            }
+        }
+        const uint8_t c = s[i];
+        if (c < 0x80) {
+            if (c < 0x20) {
+                return false;
+            }
+            i++;
+            continue;
+        }
+        size_t extra;
+        uint8_t min = 0x80, max = 0xbf;  // valid range of the second byte
+        if (c >= 0xc2 && c <= 0xdf) {
+            extra = 1;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            extra = 2;
+            if (c == 0xe0) min = 0xa0;
+            if (c == 0xed) max = 0x9f;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            extra = 3;
+            if (c == 0xf0) min = 0x90;
+            if (c == 0xf4) max = 0x8f;
+        } else {
+            return false;
+        }
+        if (i + extra >= len || s[i + 1] < min || s[i + 1] > max) {
+            return false;
+        }
+        for (size_t k = 2; k <= extra; k++) {
+            if ((s[i + k] & 0xc0) != 0x80) {
+                return false;
+            }
+        }
+        multibyte = true;
+        i += extra + 1;
+    }
+    return multibyte;
+}
+
 void CharacterEncodingDetector::detectAndConvert() {
 
     int size = mNames.size();
@@ -105,7 +258,7 @@ void CharacterEncodingDetector::detectAndConvert() {
     if (size && mUtf8Conv) {
 
         UErrorCode status = U_ZERO_ERROR;
-        UCharsetDetector *csd = ucsdet_open(&status);
+        UCharsetDetector *csd = IcuObjectPool::getInstance().acquireDetector(&status);
         const UCharsetMatch *ucm;
         bool goodmatch = true;
         int highest = 0;
@@ -114,10 +267,12 @@ void CharacterEncodingDetector::detectAndConvert() {
         char buf[1024];
         buf[0] = 0;
         bool allprintable = true;
+        bool allutf8 = true;
         for (int i = 0; i < size; i++) {
             const char *name = mNames.getEntry(i);
             const char *value = mValues.getEntry(i);
-            if (!isPrintableAscii(value, strlen(value)) && (
+            const size_t len = strlen(value);
+            if (!isPrintableAscii(value, len) && (
                         !strcmp(name, "artist") ||
                         !strcmp(name, "albumartist") ||
                         !strcmp(name, "composer") ||
@@ -128,6 +283,7 @@ void CharacterEncodingDetector::detectAndConvert() {
                 // separate tags by space so ICU's ngram detector can do its job
                 strlcat(buf, " ", sizeof(buf));
                 allprintable = false;
+                allutf8 = allutf8 && isMultibyteUtf8(value, len);
             }
         }
 
@@ -136,6 +292,10 @@ void CharacterEncodingDetector::detectAndConvert() {
             // since 'buf' is empty, ICU would return a UTF-8 matcher with low confidence, so
             // no need to even call it
             ALOGV("all tags are printable, assuming ascii (%zu)", strlen(buf));
+        } else if (allutf8) {
+            // ICU would report UTF-8 too, valid multibyte UTF-8 is very unlikely to be
+            // anything else.
+            ALOGV("all non-ascii tags are valid UTF-8");
         } else {
             ucsdet_setText(csd, buf, strlen(buf), &status);
             int32_t matches;
@@ -190,6 +350,7 @@ void CharacterEncodingDetector::detectAndConvert() {
             }
         }
 
+        std::vector<char> convertBuffer;
         for (int i = 0; i < size; i++) {
             const char *name = mNames.getEntry(i);
             uint8_t* src = (uint8_t *)mValues.getEntry(i);
@@ -228,6 +389,9 @@ void CharacterEncodingDetector::detectAndConvert() {
                 if (isPrintableAscii(s, inputLength)) {
                     enc = "UTF-8";
                     ALOGV("@@@@ %s is ascii", mNames.getEntry(i));
+                } else if (isMultibyteUtf8(s, inputLength)) {
+                    enc = "UTF-8";
+                    ALOGV("@@@@ %s is UTF-8", mNames.getEntry(i));
                 } else {
                     ucsdet_setText(csd, s, inputLength, &status);
                     ucm = ucsdet_detect(csd, &status);
@@ -245,12 +409,13 @@ void CharacterEncodingDetector::detectAndConvert() {
                 // only convert if the source encoding isn't already UTF-8
                 ALOGV("@@@ using converter %s for %s", enc, mNames.getEntry(i));
                 status = U_ZERO_ERROR;
-                UConverter *conv = ucnv_open(enc, &status);
+                UConverter *conv = IcuObjectPool::getInstance().acquireConverter(enc, &status);
                 if (U_FAILURE(status)) {
                     ALOGW("could not create UConverter for %s (%d), falling back to ISO-8859-1",
                             enc, status);
                     status = U_ZERO_ERROR;
-                    conv = ucnv_open("ISO-8859-1", &status);
+                    enc = "ISO-8859-1";
+                    conv = IcuObjectPool::getInstance().acquireConverter(enc, &status);
                     if (U_FAILURE(status)) {
                         ALOGW("could not create UConverter for ISO-8859-1 either");
                         continue;
@@ -260,10 +425,8 @@ void CharacterEncodingDetector::detectAndConvert() {
                 // convert from native encoding to UTF-8
                 const char* source = mValues.getEntry(i);
                 int targetLength = len * 3 + 1;
-                char* buffer = new char[targetLength];
-                // don't normally check for NULL, but in this case targetLength may be large
-                if (!buffer)
-                    break;
+                convertBuffer.resize(targetLength);
+                char* buffer = convertBuffer.data();
                 char* target = buffer;
 
                 ucnv_convertEx(mUtf8Conv, conv, &target, target + targetLength,
@@ -288,9 +451,7 @@ void CharacterEncodingDetector::detectAndConvert() {
                     mValues.setEntry(i, start);
                 }
 
-                delete[] buffer;
-
-                ucnv_close(conv);
+                IcuObjectPool::getInstance().releaseConverter(enc, conv);
             }
         }
 
@@ -302,7 +463,7 @@ void CharacterEncodingDetector::detectAndConvert() {
             }
         }
 
-        ucsdet_close(csd);
+        IcuObjectPool::getInstance().releaseDetector(csd);
     }
 }
 
@@ -378,7 +539,7 @@ const UCharsetMatch *CharacterEncodingDetector::getPreferred(
 
         ALOGV("%zu: %s %d", i, encname, confidence);
         status = U_ZERO_ERROR;
-        UConverter *conv = ucnv_open(encname, &status);
+        UConverter *conv = IcuObjectPool::getInstance().acquireConverter(encname, &status);
         int demerit = 0;
         if (U_FAILURE(status)) {
             ALOGV("failed to open %s: %d", encname, status);
@@ -441,7 +602,7 @@ const UCharsetMatch *CharacterEncodingDetector::getPreferred(
         }
         ALOGV("%d-%d=%d", confidence, demerit, confidence - demerit);
         newconfidence.push_back(confidence - demerit);
-        ucnv_close(conv);
+        IcuObjectPool::getInstance().releaseConverter(encname, conv);
         if (i == 0 && (confidence - demerit) == 100) {
             // no need to check any further, we'll end up using this match anyway
             break;
@@ -74,8 +74,12 @@ enum {
     GET_FRAME_AT_INDEX,
     EXTRACT_ALBUM_ART,
     EXTRACT_METADATA,
+    GET_FRAMES_AT_TIMES,
 };
 
+// Upper bound on the frames requested by one getFramesAtTimes() call.
+static const size_t kMaxFramesAtTimes = 64;
+
 class BpMediaMetadataRetriever: public BpInterface<IMediaMetadataRetriever>
 {
 public:
@@ -234,6 +238,39 @@ public:
         return interface_cast<IMemory>(reply.readStrongBinder());
     }
 
+    status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames)
+    {
+        ALOGV("getFramesAtTimes: count(%zu), option(%d), colorFormat(%d)",
+                timesUs.size(), option, colorFormat);
+        frames->clear();
+        Parcel data, reply;
+        data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
+        data.writeInt64Vector(timesUs);
+        data.writeInt32(option);
+        data.writeInt32(colorFormat);
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+        sendSchedPolicy(data);
+#endif
+        status_t ret = remote()->transact(GET_FRAMES_AT_TIMES, data, &reply);
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        ret = reply.readInt32();
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        for (size_t i = 0; i < timesUs.size(); ++i) {
+            sp<IMemory> frame;
+            if (reply.readInt32() != 0) {
+                frame = interface_cast<IMemory>(reply.readStrongBinder());
+            }
+            frames->push_back(frame);
+        }
+        return NO_ERROR;
+    }
+
     sp<IMemory> extractAlbumArt()
     {
         Parcel data, reply;
@@ -451,6 +488,40 @@ status_t BnMediaMetadataRetriever::onTransact(
             }
 #ifndef DISABLE_GROUP_SCHEDULE_HACK
             restoreSchedPolicy();
+#endif
+            return NO_ERROR;
+        } break;
+        case GET_FRAMES_AT_TIMES: {
+            CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
+            std::vector<int64_t> timesUs;
+            status_t ret = data.readInt64Vector(&timesUs);
+            int option = data.readInt32();
+            int colorFormat = data.readInt32();
+            ALOGV("getFramesAtTimes: count(%zu), option(%d), colorFormat(%d)",
+                    timesUs.size(), option, colorFormat);
+            if (ret != NO_ERROR || timesUs.size() > kMaxFramesAtTimes) {
+                reply->writeInt32(BAD_VALUE);
+                return NO_ERROR;
+            }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            setSchedPolicy(data);
+#endif
+            std::vector<sp<IMemory>> frames;
+            ret = getFramesAtTimes(timesUs, option, colorFormat, &frames);
+            if (ret == NO_ERROR && frames.size() == timesUs.size()) {
+                reply->writeInt32(NO_ERROR);
+                for (const sp<IMemory> &frame : frames) {
+                    // Don't send NULL across the binder interface
+                    reply->writeInt32(frame != nullptr);
+                    if (frame != nullptr) {
+                        reply->writeStrongBinder(IInterface::asBinder(frame));
+                    }
+                }
+            } else {
+                reply->writeInt32(ret != NO_ERROR ? ret : UNKNOWN_ERROR);
+            }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            restoreSchedPolicy();
 #endif
             return NO_ERROR;
         } break;
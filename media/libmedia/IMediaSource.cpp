@@ -273,10 +273,49 @@ IMPLEMENT_META_INTERFACE(MediaSource, "android.media.IMediaSource");
 
 BnMediaSource::BnMediaSource()
     : mBuffersSinceStop(0)
-    , mGroup(new MediaBufferGroup(kBinderMediaBuffers /* growthLimit */)) {
+    , mGroup(new MediaBufferGroup(kBinderMediaBuffers /* growthLimit */))
+    , mPackGroup(new MediaBufferGroup(kPackBuffers /* growthLimit */))
+    , mPackBuffer(nullptr)
+    , mPackLength(0) {
 }
 
 BnMediaSource::~BnMediaSource() {
+    AutoMutex _l(mBnLock);
+    releasePackBuffer_l();
+}
+
+MediaBuffer *BnMediaSource::pack_l(const void *data, size_t length, size_t *offset) {
+    if (mPackBuffer != nullptr && mPackBuffer->size() - mPackLength < length) {
+        releasePackBuffer_l();
+    }
+    if (mPackBuffer == nullptr) {
+        MediaBuffer *buffer = nullptr;
+        // never wait, the client may be holding all of them
+        if (mPackGroup->acquire_buffer(
+                (MediaBufferBase **)&buffer, true /* nonBlocking */, kPackBufferSize) != OK
+                || buffer == nullptr) {
+            return nullptr;
+        }
+        if (buffer->mMemory == nullptr || buffer->size() < length) {
+            buffer->release();
+            return nullptr;
+        }
+        mPackBuffer = buffer;
+        mPackLength = 0;
+    }
+    memcpy((uint8_t *)mPackBuffer->data() + mPackLength, data, length);
+    *offset = mPackLength;
+    mPackLength += length;
+    mPackBuffer->add_ref();
+    return mPackBuffer;
+}
+
+void BnMediaSource::releasePackBuffer_l() {
+    if (mPackBuffer != nullptr) {
+        mPackBuffer->release();
+        mPackBuffer = nullptr;
+        mPackLength = 0;
+    }
 }
 
 status_t BnMediaSource::onTransact(
@@ -302,6 +341,7 @@ status_t BnMediaSource::onTransact(
             mGroup->signalBufferReturned(nullptr);
             status_t status = stop();
             AutoMutex _l(mBnLock);
+            releasePackBuffer_l();
             mIndexCache.reset();
             mBuffersSinceStop = 0;
             return status;
@@ -392,6 +432,9 @@ status_t BnMediaSource::onTransact(
                             }
                         }
                     }
+                } else if (length > 0) {
+                    transferBuf = pack_l((uint8_t*)buf->data() + offset, length, &offset);
+                    ALOGV_IF(transferBuf != nullptr, "Packed %zu at %zu", length, offset);
                 }
                 if (transferBuf != nullptr) { // Using shared buffers.
                     if (!transferBuf->isObserved() && transferBuf != buf) {
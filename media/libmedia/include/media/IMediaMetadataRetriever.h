@@ -18,6 +18,8 @@
 #ifndef ANDROID_IMEDIAMETADATARETRIEVER_H
 #define ANDROID_IMEDIAMETADATARETRIEVER_H
 
+#include <vector>
+
 #include <binder/IInterface.h>
 #include <binder/IMemory.h>
 #include <utils/KeyedVector.h>
@@ -50,6 +52,9 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory>     getFrameAtIndex(
             int index, int colorFormat, bool metaOnly) = 0;
+    virtual status_t        getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames) = 0;
     virtual sp<IMemory>     extractAlbumArt() = 0;
     virtual const char*     extractMetadata(int keyCode) = 0;
 };
@@ -129,6 +129,8 @@ public:
     static const size_t kTransferSharedAsSharedThreshold = 4 * 1024;  // if >= shared, else inline
     static const size_t kTransferInlineAsSharedThreshold = 8 * 1024; // if >= shared, else inline
     static const size_t kInlineMaxTransfer = 64 * 1024; // Binder size limited to BINDER_VM_SIZE.
+    static const size_t kPackBuffers = 4; // shared buffers that small buffers are packed into
+    static const size_t kPackBufferSize = 128 * 1024;
 
 protected:
     virtual ~BnMediaSource();
@@ -139,6 +141,19 @@ private:
 
     std::unique_ptr<MediaBufferGroup> mGroup;
 
+    // Buffers too small for a shared buffer of their own are copied one after
+    // the other into a shared pack buffer, which is only reused once the
+    // client has released all of them. This keeps them out of the transaction
+    // without costing a shared buffer each.
+    std::unique_ptr<MediaBufferGroup> mPackGroup;
+    MediaBuffer *mPackBuffer; // pack buffer being filled, with a local reference
+    size_t mPackLength; // used part of mPackBuffer
+
+    // Returns the pack buffer |data| was copied to at |*offset| with a local
+    // reference added, or nullptr if none has room.
+    MediaBuffer *pack_l(const void *data, size_t length, size_t *offset);
+    void releasePackBuffer_l();
+
     // To prevent marshalling IMemory with each read transaction, we cache the IMemory pointer
     // into a map.
     //
@@ -18,6 +18,8 @@
 #ifndef ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 #define ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 
+#include <vector>
+
 #include <utils/RefBase.h>
 #include <media/mediametadataretriever.h>
 #include <media/mediascanner.h>
@@ -51,6 +53,17 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory> getFrameAtIndex(
             int frameIndex, int colorFormat, bool metaOnly) = 0;
+    // Extracts the frames at each of timesUs into frames, in the same order.
+    // Frames that cannot be extracted are NULL.
+    virtual status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames) {
+        frames->clear();
+        for (int64_t timeUs : timesUs) {
+            frames->push_back(getFrameAtTime(timeUs, option, colorFormat, false /* metaOnly */));
+        }
+        return OK;
+    }
     virtual MediaAlbumArt* extractAlbumArt() = 0;
     virtual const char* extractMetadata(int keyCode) = 0;
 };
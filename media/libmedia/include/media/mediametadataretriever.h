@@ -103,6 +103,9 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     sp<IMemory>  getFrameAtIndex(
             int index, int colorFormat = HAL_PIXEL_FORMAT_RGB_565, bool metaOnly = false);
+    status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option,
+            std::vector<sp<IMemory>> *frames, int colorFormat = HAL_PIXEL_FORMAT_RGB_565);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
 
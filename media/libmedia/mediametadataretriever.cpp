@@ -191,6 +191,19 @@ sp<IMemory>  MediaMetadataRetriever::getFrameAtIndex(
     return mRetriever->getFrameAtIndex(index, colorFormat, metaOnly);
 }
 
+status_t MediaMetadataRetriever::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option,
+        std::vector<sp<IMemory>> *frames, int colorFormat) {
+    ALOGV("getFramesAtTimes: count(%zu) option(%d) colorFormat(%d)",
+            timesUs.size(), option, colorFormat);
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->getFramesAtTimes(timesUs, option, colorFormat, frames);
+}
+
 const char* MediaMetadataRetriever::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata(%d)", keyCode);
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/CharacterEncodingDetector.h>
+
+using namespace android;
+
+// Size of the simulated music library, every song gets its own detector as in a media scan.
+static constexpr size_t kSongCount = 50000;
+
+struct Song {
+    std::string artist;
+    std::string album;
+    std::string title;
+    std::string genre;
+};
+
+// Most tags are ASCII, some are UTF-8 and a few use legacy 8-bit encodings.
+static const std::vector<Song>& library() {
+    static std::vector<Song> songs = []() {
+        std::vector<Song> s;
+        s.reserve(kSongCount);
+        for (size_t i = 0; i < kSongCount; i++) {
+            const std::string n = std::to_string(i);
+            switch (i % 20) {
+                case 0:
+                case 1:
+                    s.push_back({"Bj\xc3\xb6rk " + n, "Hom\xc3\xb3gen\xc3\xadc",
+                                 "J\xc3\xb3ga " + n, "Electronic"});
+                    break;
+                case 2:
+                    s.push_back({"\xe5\xae\x87\xe5\xa4\x9a\xe7\x94\xb0 " + n,
+                                 "\xe5\x88\x9d\xe6\x81\x8b", "Track " + n, "J-Pop"});
+                    break;
+                case 3:
+                    // ISO-8859-1
+                    s.push_back({"Bj\xf6rk " + n, "Hom\xf3gen\xedc", "J\xf3ga " + n,
+                                 "Electronic"});
+                    break;
+                default:
+                    s.push_back({"Artist " + n, "Album " + std::to_string(i / 12),
+                                 "Title of track " + n, "Rock"});
+                    break;
+            }
+        }
+        return s;
+    }();
+    return songs;
+}
+
+static void BM_ScanLibrary(benchmark::State& state) {
+    const std::vector<Song>& songs = library();
+    for (auto _ : state) {
+        for (const Song& song : songs) {
+            CharacterEncodingDetector detector;
+            detector.addTag("artist", song.artist.c_str());
+            detector.addTag("album", song.album.c_str());
+            detector.addTag("title", song.title.c_str());
+            detector.addTag("genre", song.genre.c_str());
+            detector.detectAndConvert();
+            benchmark::DoNotOptimize(detector.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * songs.size());
+}
+
+BENCHMARK(BM_ScanLibrary)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -18,6 +18,7 @@
 #define LOG_TAG "CodecProperties"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <string>
 #include <stdlib.h>
 
@@ -270,24 +271,10 @@ bool CodecProperties::bppPoint(std::string resolution, std::string value) {
 }
 
 double CodecProperties::getBpp(int32_t width, int32_t height) {
-    // look in the per-resolution list
-
-    int32_t pixels = width * height;
-
-    if (mBppPoints) {
-        struct bpp_point *point = mBppPoints;
-        while (point && point->pixels < pixels) {
-            point = point->next;
-        }
-        if (point) {
-            ALOGV("getBpp(w=%d,h=%d) returns %f from bpppoint w=%d h=%d",
-                width, height, point->bpp, point->width, point->height);
-            return point->bpp;
-        }
-    }
-
-    ALOGV("defaulting to %f bpp", mBpp);
-    return mBpp;
+    double bpp;
+    int qpMax;
+    getTargets(width, height, &bpp, &qpMax);
+    return bpp;
 }
 
 bool CodecProperties::qpMaxPoint(std::string resolution, std::string value) {
@@ -388,24 +375,65 @@ bool CodecProperties::qpMaxPoint(std::string resolution, std::string value) {
 }
 
 int CodecProperties::targetQpMax(int32_t width, int32_t height) {
-    // look in the per-resolution list
-
-    int32_t pixels = width * height;
+    double bpp;
+    int qpMax;
+    getTargets(width, height, &bpp, &qpMax);
+    return qpMax;
+}
 
-    if (mQpMaxPoints) {
-        struct qpmax_point *point = mQpMaxPoints;
-        while (point && point->pixels < pixels) {
-            point = point->next;
+// merge the bpp and qpmax points into one table, so that shaping a format is
+// a single lookup instead of walks through both lists.
+// each entry carries what the lists would answer for its pixel count; since
+// both lists use the 'next largest' point, that is also their answer for any
+// pixel count between the previous entry and this one.
+void CodecProperties::buildTargetPoints() {
+    mTargetPoints.clear();
+
+    std::vector<int32_t> pixels;
+    for (struct bpp_point *point = mBppPoints; point; point = point->next) {
+        pixels.push_back(point->pixels);
+    }
+    for (struct qpmax_point *point = mQpMaxPoints; point; point = point->next) {
+        pixels.push_back(point->pixels);
+    }
+    std::sort(pixels.begin(), pixels.end());
+    pixels.erase(std::unique(pixels.begin(), pixels.end()), pixels.end());
+
+    struct bpp_point *bppPoint = mBppPoints;
+    struct qpmax_point *qpMaxPoint = mQpMaxPoints;
+    for (int32_t p : pixels) {
+        while (bppPoint && bppPoint->pixels < p) {
+            bppPoint = bppPoint->next;
         }
-        if (point) {
-            ALOGV("targetQpMax(w=%d,h=%d) returns %d from qpmax_point w=%d h=%d",
-                width, height, point->qpMax, point->width, point->height);
-            return point->qpMax;
+        while (qpMaxPoint && qpMaxPoint->pixels < p) {
+            qpMaxPoint = qpMaxPoint->next;
         }
+        struct target_point target = {
+            .pixels = p,
+            .bpp = bppPoint ? bppPoint->bpp : mBpp,
+            .qpMax = qpMaxPoint ? qpMaxPoint->qpMax : mTargetQpMax,
+        };
+        ALOGV("target point pixels=%d bpp=%f qpmax=%d", target.pixels, target.bpp, target.qpMax);
+        mTargetPoints.push_back(target);
+    }
+}
+
+void CodecProperties::getTargets(int32_t width, int32_t height, double *bpp, int *qpMax) {
+    int32_t pixels = width * height;
+
+    auto point = std::lower_bound(mTargetPoints.begin(), mTargetPoints.end(), pixels,
+            [](const target_point &point, int32_t pixels) { return point.pixels < pixels; });
+    if (point != mTargetPoints.end()) {
+        ALOGV("getTargets(w=%d,h=%d) returns bpp %f qpmax %d from point pixels=%d",
+              width, height, point->bpp, point->qpMax, point->pixels);
+        *bpp = point->bpp;
+        *qpMax = point->qpMax;
+        return;
     }
 
-    ALOGV("defaulting to %d qpmax", mTargetQpMax);
-    return mTargetQpMax;
+    ALOGV("defaulting to %f bpp, %d qpmax", mBpp, mTargetQpMax);
+    *bpp = mBpp;
+    *qpMax = mTargetQpMax;
 }
 
 void CodecProperties::setTargetQpMax(int qpMax) {
@@ -20,6 +20,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <inttypes.h>
 
@@ -37,6 +38,8 @@ class CodecProperties {
     // (e.g. mediaType-granularity defaults)
     // runs from the constructor
     void Seed();
+    // apply the final values, and build the per-resolution targets table;
+    // runs as the codec is registered
     void Finish();
 
     std::string getName();
@@ -90,6 +93,14 @@ class CodecProperties {
     double getMissingQpBoost() {return mMissingQpBoost; }
     void setMissingQpBoost(double boost);
 
+    // bpp and qpmax targets for a resolution, in one lookup of the table built
+    // by Finish(). getBpp() and targetQpMax() use the same table.
+    void getTargets(int32_t width, int32_t height, double *bpp, int *qpMax);
+
+    // features consulted on every shapeFormat(), cached by Finish()
+    bool isVQEligible() { return mVQEligible; }
+    int32_t qualityTarget() { return mQualityTarget; }
+
     int  supportedApi();
 
     // a codec is not usable until it has been registered with its
@@ -136,6 +147,19 @@ class CodecProperties {
     struct qpmax_point *mQpMaxPoints = nullptr;
     bool qpMaxPoint(std::string resolution, std::string value);
 
+    // the bpp and qpmax points merged into one table, sorted by pixel count.
+    // built once by Finish(), and not changed after the codec is registered.
+    struct target_point {
+        int32_t pixels;
+        double bpp;
+        int qpMax;
+    };
+    std::vector<target_point> mTargetPoints;
+    void buildTargetPoints();
+
+    bool mVQEligible = false;
+    int32_t mQualityTarget = 1;     // default S_HANDHELD
+
     std::mutex mMappingLock;
     // XXX figure out why I'm having problems getting compiler to like GUARDED_BY
     std::map<std::string, std::string> mMappings /*GUARDED_BY(mMappingLock)*/ ;
@@ -157,6 +157,16 @@ void CodecProperties::Seed() {
 void CodecProperties::Finish() {
     ALOGV("Finish: for codec %s, mediatype %s", mName.c_str(), mMediaType.c_str());
     addMediaDefaults(false);
+
+    // everything shapeFormat() consults is fixed from here on, so compute it once
+    // instead of on every configure.
+    buildTargetPoints();
+
+    // TODO: make a #define for ' _vq_eligible.device' here and in MediaCodec.cpp
+    int32_t isVQEligible = 0;
+    (void) getFeatureValue("_vq_eligible.device", &isVQEligible);
+    mVQEligible = isVQEligible != 0;
+    (void) getFeatureValue("_quality.target", &mQualityTarget);
 }
 
 } // namespace mediaformatshaper
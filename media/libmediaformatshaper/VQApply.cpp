@@ -67,11 +67,7 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
     // We embed this information within the codec record when we build up features
     // and pass them in from MediaCodec; it's the easiest place to store it
     //
-    // TODO: make a #define for ' _vq_eligible.device' here and in MediaCodec.cpp
-    //
-    int32_t isVQEligible = 0;
-    (void) codec->getFeatureValue("_vq_eligible.device", &isVQEligible);
-    if (!isVQEligible) {
+    if (!codec->isVQEligible()) {
         ALOGD("minquality: not an eligible device class");
         return 0;
     }
@@ -109,10 +105,9 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
               codec->supportedMinimumQuality());
 
         // tell the underlying codec to do its thing; we won't try to second guess.
-        // default to 1, aka S_HANDHELD;
-        int32_t qualityTarget = 1;
-        (void) codec->getFeatureValue("_quality.target", &qualityTarget);
-        AMediaFormat_setInt32(inFormat, "android._encoding-quality-level", qualityTarget);
+        // defaults to 1, aka S_HANDHELD;
+        AMediaFormat_setInt32(inFormat, "android._encoding-quality-level",
+                              codec->qualityTarget());
         return 0;
     }
 
@@ -135,7 +130,10 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
 
     // width, height, and pixels are calculated above
 
-    double minimumBpp = codec->getBpp(width, height);
+    // one lookup in the table built as the codec was registered
+    double minimumBpp;
+    int32_t qpmax;
+    codec->getTargets(width, height, &minimumBpp, &qpmax);
 
     int64_t bitrateFloor = pixels * minimumBpp;
     int64_t bitrateCeiling = bitrateFloor * codec->getPhaseOut();
@@ -160,8 +158,7 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
 
     bool qpPresent = hasQpMax(inFormat);
 
-    // calculate a target QP value
-    int32_t qpmax = codec->targetQpMax(width, height);
+    // qpmax is the target QP value
     if (!qpPresent) {
         // user didn't, so shaper wins
         if (qpmax != INT32_MAX) {
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iterator>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <media/NdkMediaFormat.h>
+#include <media/formatshaper/FormatShaper.h>
+
+using namespace android::mediaformatshaper;
+
+extern "C" FormatShaperOps_t shaper_ops;
+
+static constexpr int32_t kResolutions[][2] = {
+    {640, 480},
+    {1280, 720},
+    {1920, 1080},
+    {3840, 2160},
+};
+
+static shaperHandle_t createHandheldShaper(const char *codecName, const char *mediaType,
+                                           bool qpBounds) {
+    shaperHandle_t shaper = shaper_ops.findShaper(codecName, mediaType);
+    if (shaper != nullptr) {
+        return shaper;
+    }
+    shaper = shaper_ops.createShaper(codecName, mediaType);
+    shaper_ops.setFeature(shaper, "_vq_eligible.device", 1);
+    if (qpBounds) {
+        shaper_ops.setFeature(shaper, "qp-bounds", 1);
+    }
+    return shaper_ops.registerShaper(shaper, codecName, mediaType);
+}
+
+// Shapes a VBR format as configured for an encoder of args {resolution, qp-bounds}.
+static void BM_ShapeFormat(benchmark::State& state) {
+    const int32_t width = kResolutions[state.range(0)][0];
+    const int32_t height = kResolutions[state.range(0)][1];
+    const bool qpBounds = state.range(1);
+    shaperHandle_t shaper = createHandheldShaper(
+            qpBounds ? "benchmark.avc.encoder.qp" : "benchmark.avc.encoder", "video/avc",
+            qpBounds);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        AMediaFormat *format = AMediaFormat_new();
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, height);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, 1000000);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BITRATE_MODE, 1 /* VBR */);
+        state.ResumeTiming();
+
+        shaper_ops.shapeFormat(shaper, format, 0 /* flags */);
+
+        state.PauseTiming();
+        AMediaFormat_delete(format);
+        state.ResumeTiming();
+    }
+    state.SetLabel(std::to_string(width) + "x" + std::to_string(height));
+}
+
+static void ShapeFormatArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kResolutions); i++) {
+        b->Args({i, 0});
+        b->Args({i, 1});
+    }
+}
+
+BENCHMARK(BM_ShapeFormat)->Apply(ShapeFormatArgs);
+
+BENCHMARK_MAIN();
@@ -21,9 +21,13 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <cutils/multiuser.h>
@@ -313,8 +317,7 @@ bool mediametrics::Item::selfrecord() {
     size_t size;
     status_t status = writeToByteString(&str, &size);
     if (status == NO_ERROR) {
-        status = submitBuffer(str, size);
-        free(str);
+        status = submitMallocedBuffer(str, size);
     }
     if (status != NO_ERROR) {
         ALOGW("%s: failed to record: %s", __func__, this->toString().c_str());
@@ -382,8 +385,166 @@ void BaseItem::dropInstance() {
     sMediaMetricsService = nullptr;
 }
 
+// how long a buffer may wait to be batched; 0 disables batching
+static std::atomic<int32_t>& batchLatencyMs() {
+    static std::atomic<int32_t> latencyMs{std::max(property_get_int32(
+            BaseItem::BatchLatencyProperty, BaseItem::BatchLatencyProperty_default), 0)};
+    return latencyMs;
+}
+
+// Collects buffers submitted from any thread and sends them to the service from a
+// single thread, several at a time.  Submitting only pushes onto a lock-free list;
+// the batch thread is woken when the list becomes non-empty, then waits for the flush
+// latency so that more buffers can accumulate.
+class BatchSubmitter {
+public:
+    static BatchSubmitter& get() {
+        static BatchSubmitter *submitter = new BatchSubmitter(); // never deleted
+        return *submitter;
+    }
+
+    // takes ownership of the malloc'ed buffer
+    void submit(char *buffer, size_t size) {
+        Node *node = new Node{nullptr, buffer, size};
+        node->next = mHead.load(std::memory_order_relaxed);
+        while (!mHead.compare_exchange_weak(
+                node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        // wake the batch thread for the first buffer, and once there is a full batch
+        const size_t pending = mPendingBytes.fetch_add(size, std::memory_order_relaxed);
+        if (node->next == nullptr
+                || (pending < kMaxBatchBytes && pending + size >= kMaxBatchBytes)) {
+            wake();
+        }
+    }
+
+    void wake() {
+        {
+            std::lock_guard _l(mWakeLock);
+            mWakeRequested = true;
+        }
+        mWakeCondition.notify_one();
+    }
+
+private:
+    // keep batches well below the binder buffer limit for one-way transactions
+    static constexpr size_t kMaxBatchBytes = 32 * 1024;
+
+    struct Node {
+        Node *next;
+        char *buffer;
+        size_t size;
+    };
+
+    BatchSubmitter() {
+        std::thread(&BatchSubmitter::threadLoop, this).detach();
+    }
+
+    void threadLoop() {
+        std::vector<char> batch;
+        while (true) {
+            {
+                std::unique_lock _l(mWakeLock);
+                mWakeCondition.wait(_l, [this] { return mWakeRequested; });
+                mWakeRequested = false;
+                if (mPendingBytes.load(std::memory_order_relaxed) < kMaxBatchBytes) {
+                    // wait for more buffers, unless we are woken because the batch is full
+                    const std::chrono::milliseconds latency(batchLatencyMs().load());
+                    mWakeCondition.wait_for(_l, latency, [this] { return mWakeRequested; });
+                    mWakeRequested = false;
+                }
+            }
+
+            // the list is in reverse submission order
+            Node *reversed = mHead.exchange(nullptr, std::memory_order_acquire);
+            Node *node = nullptr;
+            while (reversed != nullptr) {
+                Node *next = reversed->next;
+                reversed->next = node;
+                node = reversed;
+                reversed = next;
+            }
+
+            while (node != nullptr) {
+                mPendingBytes.fetch_sub(node->size, std::memory_order_relaxed);
+                if (!batch.empty() && batch.size() + node->size > kMaxBatchBytes) {
+                    flush(&batch);
+                }
+                batch.insert(batch.end(), node->buffer, node->buffer + node->size);
+                free(node->buffer);
+                Node *next = node->next;
+                delete node;
+                node = next;
+            }
+            flush(&batch);
+        }
+    }
+
+    void flush(std::vector<char> *batch) {
+        if (batch->empty()) return;
+        (void)BaseItem::transactBuffer(
+                ::android::media::BnMediaMetricsService::TRANSACTION_submitBatch,
+                batch->data(), batch->size());
+        batch->clear();
+    }
+
+    std::atomic<Node *> mHead{nullptr};
+    std::atomic<size_t> mPendingBytes{0};
+
+    std::mutex mWakeLock;
+    std::condition_variable mWakeCondition;
+    bool mWakeRequested = false; // GUARDED_BY(mWakeLock)
+};
+
+// static
+void BaseItem::setBatchFlushLatencyMs(int32_t latencyMs) {
+    const int32_t previous = batchLatencyMs().exchange(std::max(latencyMs, 0));
+    if (previous > 0) {
+        BatchSubmitter::get().wake(); // flush what is pending with the new latency
+    }
+}
+
+// static
+int32_t BaseItem::getBatchFlushLatencyMs() {
+    return batchLatencyMs().load(std::memory_order_relaxed);
+}
+
 // static
 status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
+    if (getBatchFlushLatencyMs() > 0 && size > 0) {
+        char *copy = (char *)malloc(size);
+        if (copy == nullptr) return NO_MEMORY;
+        memcpy(copy, buffer, size);
+        return submitMallocedBuffer(copy, size);
+    }
+    return transactBuffer(
+            ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer, buffer, size);
+}
+
+// static
+status_t BaseItem::submitMallocedBuffer(char *buffer, size_t size) {
+    if (getBatchFlushLatencyMs() > 0) {
+        // Validate size and service availability now, as the caller will not learn
+        // about later failures.
+        if (size > std::numeric_limits<int32_t>::max()) {
+            free(buffer);
+            return BAD_VALUE;
+        }
+        if (getService() == nullptr) {
+            free(buffer);
+            return NO_INIT;
+        }
+        BatchSubmitter::get().submit(buffer, size);
+        return NO_ERROR;
+    }
+    const status_t status = transactBuffer(
+            ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer, buffer, size);
+    free(buffer);
+    return status;
+}
+
+// static
+status_t BaseItem::transactBuffer(uint32_t code, const char *buffer, size_t size) {
     ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
 
     // Validate size
@@ -402,7 +563,9 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
         //
         // Use the AIDL calling interface - this is a bit slower as a byte vector must be
         // constructed. As the call is one-way, the only a transaction error occurs.
-        status = svc->submitBuffer({buffer, buffer + size}).transactionError();
+        status = (code == ::android::media::BnMediaMetricsService::TRANSACTION_submitBatch
+                ? svc->submitBatch({buffer, buffer + size})
+                : svc->submitBuffer({buffer, buffer + size})).transactionError();
     } else {
         // Use the Binder calling interface - this direct implementation avoids
         // malloc/copy/free for the vector and reduces the overhead for logging.
@@ -422,8 +585,7 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
         if (status != ::android::OK) goto _aidl_error;
 
         status = ::android::IInterface::asBinder(svc)->transact(
-                ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer,
-                _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
+                code, _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
 
         // AIDL permits setting a default implementation for additional functionality.
         // See go/aog/713984. This is not used here.
@@ -40,6 +40,9 @@
 // They must be appended with another value to make a key.
 #define AMEDIAMETRICS_KEY_PREFIX_AUDIO "audio."
 
+// The Audio binder key appends the interface and method name, e.g. "IAudioFlinger.createTrack".
+#define AMEDIAMETRICS_KEY_PREFIX_AUDIO_BINDER  AMEDIAMETRICS_KEY_PREFIX_AUDIO "binder."
+
 // Device related key prefix.
 #define AMEDIAMETRICS_KEY_PREFIX_AUDIO_DEVICE  AMEDIAMETRICS_KEY_PREFIX_AUDIO "device."
 
@@ -125,8 +128,18 @@
 #define AMEDIAMETRICS_PROP_CHANNELMASKS   "channelMasks"   // string with channelMask values
                                                            // separated by |.
 #define AMEDIAMETRICS_PROP_CONTENTTYPE    "contentType"    // string attributes (AudioTrack)
+#define AMEDIAMETRICS_PROP_CPULOADHISTOGRAM "cpuLoadHistogram" // string, counts of 1 s thread load
+                                                           // samples per 10% bucket, comma separated
+#define AMEDIAMETRICS_PROP_CPULOADMAXPERCENT "cpuLoadMaxPercent"   // double thread CPU time / wall
+#define AMEDIAMETRICS_PROP_CPULOADMEANPERCENT "cpuLoadMeanPercent" // double thread CPU time / wall
 #define AMEDIAMETRICS_PROP_CUMULATIVETIMENS "cumulativeTimeNs" // int64_t playback/record time
                                                            // since start
+#define AMEDIAMETRICS_PROP_CYCLECOUNT     "cycleCount"     // int32 FastThread cycles
+#define AMEDIAMETRICS_PROP_CYCLEMAXMS     "cycleMaxMs"     // double FastThread cycle time
+#define AMEDIAMETRICS_PROP_CYCLEMEANMS    "cycleMeanMs"    // double FastThread cycle time
+#define AMEDIAMETRICS_PROP_CYCLEP50MS     "cycleP50Ms"     // double FastThread cycle time
+#define AMEDIAMETRICS_PROP_CYCLEP90MS     "cycleP90Ms"     // double FastThread cycle time
+#define AMEDIAMETRICS_PROP_CYCLEP99MS     "cycleP99Ms"     // double FastThread cycle time
 // DEVICE values are averaged since starting on device
 #define AMEDIAMETRICS_PROP_DEVICELATENCYMS "deviceLatencyMs" // double - avg latency time
 #define AMEDIAMETRICS_PROP_DEVICESTARTUPMS "deviceStartupMs" // double - avg startup time
@@ -145,6 +158,11 @@
 
 #define AMEDIAMETRICS_PROP_EVENT          "event#"         // string value (often func name)
 #define AMEDIAMETRICS_PROP_EXECUTIONTIMENS "executionTimeNs"  // time to execute the event
+#define AMEDIAMETRICS_PROP_EXECUTIONCOUNT "executionCount" // int64 number of executions
+#define AMEDIAMETRICS_PROP_EXECUTIONMEANMS "executionMeanMs" // double execution time
+#define AMEDIAMETRICS_PROP_EXECUTIONP50MS "executionP50Ms" // double execution time
+#define AMEDIAMETRICS_PROP_EXECUTIONP99MS "executionP99Ms" // double execution time
+#define AMEDIAMETRICS_PROP_EXECUTIONP999MS "executionP999Ms" // double execution time
 
 // TODO: fix inconsistency in flags: AudioRecord / AudioTrack int32,  AudioThread string
 #define AMEDIAMETRICS_PROP_FLAGS          "flags"
@@ -156,8 +174,10 @@
 #define AMEDIAMETRICS_PROP_INPUTDEVICES   "inputDevices"   // string value
 #define AMEDIAMETRICS_PROP_INTERNALTRACKID "internalTrackId" // int32
 #define AMEDIAMETRICS_PROP_INTERVALCOUNT  "intervalCount"  // int32
+#define AMEDIAMETRICS_PROP_INTERVALENDNS  "intervalEndNs"  // int64_t CLOCK_REALTIME end
 #define AMEDIAMETRICS_PROP_LATENCYMS      "latencyMs"      // double value
 #define AMEDIAMETRICS_PROP_LEVELS         "levels"          // string | with levels
+#define AMEDIAMETRICS_PROP_LOADPERCENT    "loadPercent"    // double CPU time / wall time
 #define AMEDIAMETRICS_PROP_LOGSESSIONID   "logSessionId"   // hex string, "" none
 #define AMEDIAMETRICS_PROP_METHODCODE     "methodCode"     // int64_t an int indicating method
 #define AMEDIAMETRICS_PROP_METHODNAME     "methodName"     // string method name
@@ -166,6 +186,7 @@
 #define AMEDIAMETRICS_PROP_NAME           "name"           // string value
 #define AMEDIAMETRICS_PROP_ORIGINALFLAGS  "originalFlags"  // int32
 #define AMEDIAMETRICS_PROP_OUTPUTDEVICES  "outputDevices"  // string value
+#define AMEDIAMETRICS_PROP_OVERRUN        "overrun"        // int32
 #define AMEDIAMETRICS_PROP_PERFORMANCEMODE "performanceMode"    // string value, "none", lowLatency"
 #define AMEDIAMETRICS_PROP_PLAYBACK_PITCH "playback.pitch" // double value (AudioTrack)
 #define AMEDIAMETRICS_PROP_PLAYBACK_SPEED "playback.speed" // double value (AudioTrack)
@@ -205,6 +226,8 @@
 #define AMEDIAMETRICS_PROP_VOICEVOLUME    "voiceVolume"    // double (audio.flinger)
 #define AMEDIAMETRICS_PROP_VOLUME_LEFT    "volume.left"    // double (AudioTrack)
 #define AMEDIAMETRICS_PROP_VOLUME_RIGHT   "volume.right"   // double (AudioTrack)
+#define AMEDIAMETRICS_PROP_WAKEUPSPERMIN  "wakeupsPerMin"  // double, thread wakeups per minute
+                                                           // of playback (offload Thread)
 #define AMEDIAMETRICS_PROP_WHERE          "where"          // string value
 // EncodingClient is the encoding format requested by the client
 #define AMEDIAMETRICS_PROP_ENCODINGCLIENT "encodingClient" // string
@@ -230,6 +253,7 @@
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_DTOR       "dtor"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAAUDIOSTREAM "endAAudioStream" // AAudioStream
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP "endAudioIntervalGroup"
+#define AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADCYCLES "fastThreadCycles" // Thread
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_FLUSH      "flush"  // AudioTrack
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_INVALIDATE "invalidate" // server track, record
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_OPEN       "open"
@@ -267,6 +267,7 @@ private:
 
 class BaseItem {
     friend class MediaMetricsDeathNotifier; // for dropInstance
+    friend class BatchSubmitter; // for transactBuffer
     // enabled 1, disabled 0
 public:
     // are we collecting metrics data
@@ -274,12 +275,25 @@ public:
     // returns the MediaMetrics service if active.
     static sp<media::IMediaMetricsService> getService();
     // submits a raw buffer directly to the MediaMetrics service - this is highly optimized.
+    // If batching is enabled, the buffer is copied and queued for the batch thread instead.
     static status_t submitBuffer(const char *buffer, size_t len);
 
+    // Sets how long a submitted buffer may wait to be batched with others before it is
+    // sent to the MediaMetrics service.  0 disables batching.
+    static void setBatchFlushLatencyMs(int32_t latencyMs);
+    static int32_t getBatchFlushLatencyMs();
+
 protected:
     static constexpr const char * const EnabledProperty = "media.metrics.enabled";
     static constexpr const char * const EnabledPropertyPersist = "persist.media.metrics.enabled";
     static const int EnabledProperty_default = 1;
+    static constexpr const char * const BatchLatencyProperty = "media.metrics.batch_latency_ms";
+    static const int BatchLatencyProperty_default = 0;
+
+    // submits a malloc'ed buffer, taking ownership of it.
+    static status_t submitMallocedBuffer(char *buffer, size_t len);
+    // sends the buffer to the MediaMetrics service with transaction |code|.
+    static status_t transactBuffer(uint32_t code, const char *buffer, size_t len);
 
     // let's reuse a binder connection
     static sp<media::IMediaMetricsService> sMediaMetricsService;
@@ -25,6 +25,11 @@
 #include <unistd.h>
 
 #include <string.h>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <tuple>
+#include <vector>
 #include <cutils/atomic.h>
 #include <cutils/properties.h>
 #include <binder/MemoryBase.h>
@@ -45,12 +50,100 @@
 
 namespace android {
 
+// Size of the process wide metadata cache, 0 disables it.
+static const char *kMetadataCacheSizeProperty = "media.metadata_retriever.cache_kb";
+static const int32_t kDefaultMetadataCacheSizeKb = 2048;
+
+bool MetadataRetrieverClient::FileKey::operator<(const FileKey &other) const
+{
+    return std::tie(dev, ino, mtimeNs, size, offset, length)
+            < std::tie(other.dev, other.ino, other.mtimeNs, other.size, other.offset,
+                       other.length);
+}
+
+struct MetadataRetrieverClient::CachedMetadata : public RefBase {
+    KeyedVector<int, String8> mMetadata;
+    bool mHasAlbumArt = false;
+    // False when the album art was too large to keep, it is then extracted again.
+    bool mAlbumArtCached = true;
+    std::vector<char> mAlbumArt;
+    size_t mBytes = 0;
+};
+
+// Least recently used cache of the metadata of local files, shared by all clients of the
+// process so that repeated queries for a file do not instantiate an extractor.
+class MetadataRetrieverClient::MetadataCache {
+public:
+    static MetadataCache &getInstance() {
+        static MetadataCache sInstance;
+        return sInstance;
+    }
+
+    size_t getLimitBytes() const { return mLimitBytes; }
+
+    sp<CachedMetadata> lookup(const FileKey &key) {
+        Mutex::Autolock lock(mLock);
+        auto it = mIndex.find(key);
+        if (it == mIndex.end()) {
+            mMisses++;
+            return NULL;
+        }
+        mHits++;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return it->second->second;
+    }
+
+    void insert(const FileKey &key, const sp<CachedMetadata> &metadata) {
+        Mutex::Autolock lock(mLock);
+        if (metadata->mBytes > mLimitBytes || mIndex.count(key) != 0) {
+            return;
+        }
+        mEntries.emplace_front(key, metadata);
+        mIndex[key] = mEntries.begin();
+        mBytes += metadata->mBytes;
+        while (mBytes > mLimitBytes) {
+            const Entry &oldest = mEntries.back();
+            mBytes -= oldest.second->mBytes;
+            mIndex.erase(oldest.first);
+            mEntries.pop_back();
+        }
+    }
+
+    void dump(String8 *result) {
+        Mutex::Autolock lock(mLock);
+        result->appendFormat("  metadata cache: %zu entries, %zu of %zu bytes, "
+                "%llu hits, %llu misses\n", mEntries.size(), mBytes, mLimitBytes,
+                (unsigned long long)mHits, (unsigned long long)mMisses);
+    }
+
+private:
+    using Entry = std::pair<FileKey, sp<CachedMetadata>>;
+
+    MetadataCache()
+        : mLimitBytes(std::max(property_get_int32(kMetadataCacheSizeProperty,
+                                                  kDefaultMetadataCacheSizeKb), 0) * 1024ull),
+          mBytes(0),
+          mHits(0),
+          mMisses(0) {
+    }
+
+    Mutex mLock;
+    const size_t mLimitBytes;
+    std::list<Entry> mEntries;  // most recently used first
+    std::map<FileKey, std::list<Entry>::iterator> mIndex;
+    size_t mBytes;
+    uint64_t mHits;
+    uint64_t mMisses;
+};
+
 MetadataRetrieverClient::MetadataRetrieverClient(pid_t pid)
 {
     ALOGV("MetadataRetrieverClient constructor pid(%d)", pid);
     mPid = pid;
     mAlbumArt = NULL;
     mRetriever = NULL;
+    mCacheable = false;
+    mFd = -1;
 }
 
 MetadataRetrieverClient::~MetadataRetrieverClient()
@@ -67,6 +160,7 @@ status_t MetadataRetrieverClient::dump(int fd, const Vector<String16>& /*args*/)
     result.append(" MetadataRetrieverClient\n");
     snprintf(buffer, 255, "  pid(%d)\n", mPid);
     result.append(buffer);
+    MetadataCache::getInstance().dump(&result);
     write(fd, result.string(), result.size());
     write(fd, "\n", 1);
     return NO_ERROR;
@@ -76,11 +170,22 @@ void MetadataRetrieverClient::disconnect()
 {
     ALOGV("disconnect from pid %d", mPid);
     Mutex::Autolock lock(mLock);
-    mRetriever.clear();
+    clearDataSource_l();
     mAlbumArt.clear();
     IPCThreadState::self()->flushCommands();
 }
 
+void MetadataRetrieverClient::clearDataSource_l()
+{
+    mRetriever.clear();
+    mCacheable = false;
+    mCachedMetadata.clear();
+    if (mFd >= 0) {
+        close(mFd);
+        mFd = -1;
+    }
+}
+
 static sp<MediaMetadataRetrieverBase> createRetriever(player_type playerType)
 {
     sp<MediaMetadataRetrieverBase> p;
@@ -128,7 +233,10 @@ status_t MetadataRetrieverClient::setDataSource(
     sp<MediaMetadataRetrieverBase> p = createRetriever(playerType);
     if (p == NULL) return NO_INIT;
     status_t ret = p->setDataSource(httpService, url, headers);
-    if (ret == NO_ERROR) mRetriever = p;
+    if (ret == NO_ERROR) {
+        clearDataSource_l();
+        mRetriever = p;
+    }
     return ret;
 }
 
@@ -159,6 +267,32 @@ status_t MetadataRetrieverClient::setDataSource(int fd, int64_t offset, int64_t
         ALOGV("calculated length = %lld", (long long)length);
     }
 
+    FileKey key = {};
+    const bool cacheable = S_ISREG(sb.st_mode)
+            && MetadataCache::getInstance().getLimitBytes() > 0;
+    if (cacheable) {
+        key.dev = sb.st_dev;
+        key.ino = sb.st_ino;
+        key.mtimeNs = sb.st_mtim.tv_sec * 1000000000ll + sb.st_mtim.tv_nsec;
+        key.size = sb.st_size;
+        key.offset = offset;
+        key.length = length;
+        sp<CachedMetadata> metadata = MetadataCache::getInstance().lookup(key);
+        if (metadata != NULL) {
+            // The retriever, and with it the extractor, is only created if frames are asked for.
+            int dupFd = dup(fd);
+            if (dupFd >= 0) {
+                ALOGV("metadata cache hit");
+                clearDataSource_l();
+                mCacheable = true;
+                mCacheKey = key;
+                mCachedMetadata = metadata;
+                mFd = dupFd;
+                return NO_ERROR;
+            }
+        }
+    }
+
     player_type playerType =
         MediaPlayerFactory::getPlayerType(NULL /* client */,
                                           fd,
@@ -170,10 +304,65 @@ status_t MetadataRetrieverClient::setDataSource(int fd, int64_t offset, int64_t
         return NO_INIT;
     }
     status_t status = p->setDataSource(fd, offset, length);
-    if (status == NO_ERROR) mRetriever = p;
+    if (status == NO_ERROR) {
+        clearDataSource_l();
+        mRetriever = p;
+        mCacheable = cacheable;
+        mCacheKey = key;
+        if (cacheable) {
+            mFd = dup(fd);
+        }
+    }
     return status;
 }
 
+sp<MediaMetadataRetrieverBase> MetadataRetrieverClient::getRetriever_l()
+{
+    if (mRetriever != NULL || mFd < 0) {
+        return mRetriever;
+    }
+    player_type playerType = MediaPlayerFactory::getPlayerType(
+            NULL /* client */, mFd, mCacheKey.offset, mCacheKey.length);
+    sp<MediaMetadataRetrieverBase> p = createRetriever(playerType);
+    if (p == NULL || p->setDataSource(mFd, mCacheKey.offset, mCacheKey.length) != NO_ERROR) {
+        ALOGE("failed to create a retriever for a cached data source");
+        return NULL;
+    }
+    mRetriever = p;
+    return mRetriever;
+}
+
+void MetadataRetrieverClient::cacheMetadata_l()
+{
+    if (!mCacheable || mCachedMetadata != NULL || mRetriever == NULL) {
+        return;
+    }
+    // The first query parses the container, the others are lookups.
+    sp<CachedMetadata> metadata = new CachedMetadata;
+    for (int keyCode = 0; keyCode <= METADATA_KEY_XMP_LENGTH; keyCode++) {
+        const char *value = mRetriever->extractMetadata(keyCode);
+        if (value != NULL) {
+            metadata->mMetadata.add(keyCode, String8(value));
+            metadata->mBytes += sizeof(int) + sizeof(String8) + strlen(value) + 1;
+        }
+    }
+    MediaAlbumArt *albumArt = mRetriever->extractAlbumArt();
+    if (albumArt != NULL) {
+        metadata->mHasAlbumArt = true;
+        // Large artwork would evict the metadata of many files, it is extracted again instead.
+        const size_t size = albumArt->size();
+        if (size <= MetadataCache::getInstance().getLimitBytes() / 8) {
+            metadata->mAlbumArt.assign(albumArt->data(), albumArt->data() + size);
+            metadata->mBytes += size;
+        } else {
+            metadata->mAlbumArtCached = false;
+        }
+        delete albumArt;
+    }
+    MetadataCache::getInstance().insert(mCacheKey, metadata);
+    mCachedMetadata = metadata;
+}
+
 status_t MetadataRetrieverClient::setDataSource(
         const sp<IDataSource>& source, const char *mime)
 {
@@ -187,7 +376,10 @@ status_t MetadataRetrieverClient::setDataSource(
     sp<MediaMetadataRetrieverBase> p = createRetriever(playerType);
     if (p == NULL) return NO_INIT;
     status_t ret = p->setDataSource(dataSource, mime);
-    if (ret == NO_ERROR) mRetriever = p;
+    if (ret == NO_ERROR) {
+        clearDataSource_l();
+        mRetriever = p;
+    }
     return ret;
 }
 
@@ -200,7 +392,7 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtTime(
             (long long)timeUs, option, colorFormat, metaOnly);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
-    if (mRetriever == NULL) {
+    if (getRetriever_l() == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
@@ -218,7 +410,7 @@ sp<IMemory> MetadataRetrieverClient::getImageAtIndex(
             index, colorFormat, metaOnly, thumbnail);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
-    if (mRetriever == NULL) {
+    if (getRetriever_l() == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
@@ -236,7 +428,7 @@ sp<IMemory> MetadataRetrieverClient::getImageRectAtIndex(
             index, colorFormat, left, top, right, bottom);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
-    if (mRetriever == NULL) {
+    if (getRetriever_l() == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
@@ -254,7 +446,7 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtIndex(
             index, colorFormat, metaOnly);
     Mutex::Autolock lock(mLock);
     Mutex::Autolock glock(sLock);
-    if (mRetriever == NULL) {
+    if (getRetriever_l() == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
@@ -266,16 +458,38 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtIndex(
     return frame;
 }
 
+status_t MetadataRetrieverClient::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        std::vector<sp<IMemory>> *frames) {
+    ALOGV("getFramesAtTimes: count(%zu) option(%d) colorFormat(%d)",
+            timesUs.size(), option, colorFormat);
+    Mutex::Autolock lock(mLock);
+    Mutex::Autolock glock(sLock);
+    if (getRetriever_l() == NULL) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->getFramesAtTimes(timesUs, option, colorFormat, frames);
+}
+
 sp<IMemory> MetadataRetrieverClient::extractAlbumArt()
 {
     ALOGV("extractAlbumArt");
     Mutex::Autolock lock(mLock);
     mAlbumArt.clear();
-    if (mRetriever == NULL) {
+    cacheMetadata_l();
+    MediaAlbumArt *albumArt = NULL;
+    if (mCachedMetadata != NULL && mCachedMetadata->mAlbumArtCached) {
+        if (mCachedMetadata->mHasAlbumArt) {
+            albumArt = MediaAlbumArt::fromData(
+                    mCachedMetadata->mAlbumArt.size(), mCachedMetadata->mAlbumArt.data());
+        }
+    } else if (getRetriever_l() == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
+    } else {
+        albumArt = mRetriever->extractAlbumArt();
     }
-    MediaAlbumArt *albumArt = mRetriever->extractAlbumArt();
     if (albumArt == NULL) {
         ALOGE("failed to extract an album art");
         return NULL;
@@ -303,6 +517,12 @@ const char* MetadataRetrieverClient::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata");
     Mutex::Autolock lock(mLock);
+    cacheMetadata_l();
+    if (mCachedMetadata != NULL) {
+        // Cache entries are immutable, the value lives as long as mCachedMetadata.
+        ssize_t index = mCachedMetadata->mMetadata.indexOfKey(keyCode);
+        return index < 0 ? NULL : mCachedMetadata->mMetadata.valueAt(index).string();
+    }
     if (mRetriever == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
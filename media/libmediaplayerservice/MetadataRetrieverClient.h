@@ -24,6 +24,7 @@
 #include <utils/Errors.h>
 #include <utils/KeyedVector.h>
 #include <binder/IMemory.h>
+#include <sys/types.h>
 
 #include <media/MediaMetadataRetrieverInterface.h>
 
@@ -58,6 +59,9 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory>             getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t                getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames);
     virtual sp<IMemory>             extractAlbumArt();
     virtual const char*             extractMetadata(int keyCode);
 
@@ -69,11 +73,40 @@ private:
     explicit MetadataRetrieverClient(pid_t pid);
     virtual ~MetadataRetrieverClient();
 
+    // Identity of a region of a local file, the key of the metadata cache. A file that is
+    // rewritten gets a new modification time or size, so stale entries are never hit.
+    struct FileKey {
+        dev_t   dev;
+        ino_t   ino;
+        int64_t mtimeNs;
+        int64_t size;
+        int64_t offset;
+        int64_t length;
+
+        bool operator<(const FileKey &other) const;
+    };
+    struct CachedMetadata;
+    class MetadataCache;
+
+    // Returns the retriever, creating it for a data source that was served from the metadata
+    // cache so far. NULL if there is no data source or the retriever cannot be created.
+    sp<MediaMetadataRetrieverBase> getRetriever_l();
+    // Extracts all metadata and the album art of a local file and adds them to the cache.
+    void cacheMetadata_l();
+    void clearDataSource_l();
+
     mutable Mutex                          mLock;
     static  Mutex                          sLock;
     sp<MediaMetadataRetrieverBase>         mRetriever;
     pid_t                                  mPid;
 
+    // Set for a local file data source: the cached metadata when there is a cache entry, and
+    // a dup of the file descriptor to create the retriever from if frames are requested.
+    bool                                   mCacheable;
+    FileKey                                mCacheKey;
+    sp<CachedMetadata>                     mCachedMetadata;
+    int                                    mFd;
+
     // Keep the shared memory copy of album art
     sp<IMemory>                            mAlbumArt;
 };
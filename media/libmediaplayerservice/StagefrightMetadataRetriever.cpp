@@ -17,7 +17,9 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "StagefrightMetadataRetriever"
 
+#include <algorithm>
 #include <inttypes.h>
+#include <numeric>
 
 #include <utils/Log.h>
 #include <cutils/properties.h>
@@ -328,8 +330,50 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
             MediaSource::ReadOptions::SEEK_FRAME_INDEX, colorFormat, metaOnly);
 }
 
+status_t StagefrightMetadataRetriever::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        std::vector<sp<IMemory>> *frames) {
+    ALOGV("getFramesAtTimes: count %zu option: %d colorFormat: %d",
+            timesUs.size(), option, colorFormat);
+    if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        return BAD_VALUE;
+    }
+    frames->assign(timesUs.size(), nullptr);
+
+    // Extract in time order on one decoder, so that each frame is either seeked
+    // to or decoded forward to from the previous one.
+    std::vector<size_t> order(timesUs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+            [&timesUs](size_t a, size_t b) { return timesUs[a] < timesUs[b]; });
+
+    sp<IMemory> lastFrame;
+    int64_t lastTimeUs = -1;
+    for (size_t i : order) {
+        if (lastFrame != nullptr && timesUs[i] == lastTimeUs) {
+            (*frames)[i] = lastFrame;
+            continue;
+        }
+        sp<IMemory> frame;
+        if (mDecoder != NULL && mDecoder->seekTo(timesUs[i], option) == OK) {
+            frame = mDecoder->extractFrame();
+        }
+        if (frame == nullptr) {
+            // start over with a new decoder.
+            frame = getFrameInternal(timesUs[i], option, colorFormat,
+                    false /* metaOnly */, true /* keepDecoder */);
+        }
+        (*frames)[i] = lastFrame = frame;
+        lastTimeUs = timesUs[i];
+    }
+
+    mDecoder.clear();
+    mLastDecodedIndex = -1;
+    return OK;
+}
+
 sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+        int64_t timeUs, int option, int colorFormat, bool metaOnly, bool keepDecoder) {
     mDecoder.clear();
     mLastDecodedIndex = -1;
 
@@ -423,6 +467,8 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
                 if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
                     mDecoder = decoder;
                     mLastDecodedIndex = timeUs;
+                } else if (keepDecoder) {
+                    mDecoder = decoder;
                 }
                 return frame;
             }
@@ -106,6 +106,17 @@ static const char *kRecorderVideoMime = "android.media.mediarecorder.video.mime"
 static const char *kRecorderDurationMs = "android.media.mediarecorder.durationMs";
 static const char *kRecorderPaused = "android.media.mediarecorder.pausedMs";
 static const char *kRecorderNumPauses = "android.media.mediarecorder.NPauses";
+static const char *kRecorderWriteLatencyHistogram =
+        "android.media.mediarecorder.write-latency-histogram";
+static const char *kRecorderWriteLatencyMaxUs = "android.media.mediarecorder.write-latency-max-us";
+static const char *kRecorderAudioQueueLatencyAvgUs =
+        "android.media.mediarecorder.audio-queue-latency-avg-us";
+static const char *kRecorderAudioQueueLatencyMaxUs =
+        "android.media.mediarecorder.audio-queue-latency-max-us";
+static const char *kRecorderVideoQueueLatencyAvgUs =
+        "android.media.mediarecorder.video-queue-latency-avg-us";
+static const char *kRecorderVideoQueueLatencyMaxUs =
+        "android.media.mediarecorder.video-queue-latency-max-us";
 
 
 // To collect the encoder usage for the battery app
@@ -212,6 +223,38 @@ void StagefrightRecorder::updateMetrics() {
         mMetricsItem->setInt64(kRecorderPaused, (mDurationPausedUs+500)/1000 );
         mMetricsItem->setInt32(kRecorderNumPauses, mNPauses);
     }
+
+    // file write latency, from the live writer or the one stop() released
+    if (mWriter != NULL) {
+        mWriterMetrics = new AMessage;
+        mWriter->getMetrics(mWriterMetrics);
+    }
+    AString writeLatencyHistogram;
+    int64_t writeLatencyMaxUs;
+    if (mWriterMetrics != NULL
+            && mWriterMetrics->findString("write-latency-histogram", &writeLatencyHistogram)
+            && mWriterMetrics->findInt64("write-latency-max-us", &writeLatencyMaxUs)) {
+        mMetricsItem->setCString(kRecorderWriteLatencyHistogram, writeLatencyHistogram.c_str());
+        mMetricsItem->setInt64(kRecorderWriteLatencyMaxUs, writeLatencyMaxUs);
+    }
+
+    // latency from the source puller to the encoder input
+    for (const auto &source : { mAudioEncoderSource, mVideoEncoderSource }) {
+        if (source == NULL) {
+            continue;
+        }
+        sp<AMessage> sourceMetrics = new AMessage;
+        source->getMetrics(sourceMetrics);
+        int64_t queueLatencyAvgUs, queueLatencyMaxUs;
+        if (sourceMetrics->findInt64("queue-latency-avg-us", &queueLatencyAvgUs)
+                && sourceMetrics->findInt64("queue-latency-max-us", &queueLatencyMaxUs)) {
+            bool isVideo = source->isVideo();
+            mMetricsItem->setInt64(isVideo ? kRecorderVideoQueueLatencyAvgUs
+                    : kRecorderAudioQueueLatencyAvgUs, queueLatencyAvgUs);
+            mMetricsItem->setInt64(isVideo ? kRecorderVideoQueueLatencyMaxUs
+                    : kRecorderAudioQueueLatencyMaxUs, queueLatencyMaxUs);
+        }
+    }
 }
 
 void StagefrightRecorder::flushAndResetMetrics(bool reinitialize) {
@@ -227,6 +270,7 @@ void StagefrightRecorder::flushAndResetMetrics(bool reinitialize) {
         delete mMetricsItem;
         mMetricsItem = NULL;
     }
+    mWriterMetrics.clear();
     mAnalyticsDirty = false;
     if (reinitialize) {
         mMetricsItem = mediametrics::Item::create(kKeyRecorder);
@@ -722,6 +766,24 @@ status_t StagefrightRecorder::setParamTrackTimeStatus(int64_t timeDurationUs) {
     return OK;
 }
 
+status_t StagefrightRecorder::setParamFragmentDuration(int64_t durationUs) {
+    ALOGV("setParamFragmentDuration: %lld", (long long)durationUs);
+    if (durationUs < 0) {
+        ALOGE("Fragment duration is negative: %lld us", (long long)durationUs);
+        return BAD_VALUE;
+    } else if (durationUs > 0 && durationUs < 500000) {  // 500 ms
+        // Short fragments spend a large part of the file on moof boxes.
+        ALOGE("Fragment duration is too small: %lld us", (long long)durationUs);
+        return BAD_VALUE;
+    } else if (durationUs >= 10000000) {  // 10 seconds
+        // A whole fragment is held in memory before it is written out.
+        ALOGE("Fragment duration is too large: %lld us", (long long)durationUs);
+        return BAD_VALUE;
+    }
+    mFragmentDurationUs = durationUs;
+    return OK;
+}
+
 status_t StagefrightRecorder::setParamVideoEncoderProfile(int32_t profile) {
     ALOGV("setParamVideoEncoderProfile: %d", profile);
 
@@ -974,6 +1036,11 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi64(value.string(), &latitudex10000)) {
             return setParamGeoDataLatitude(latitudex10000);
         }
+    } else if (key == "param-fragment-duration-us") {
+        int64_t durationUs;
+        if (safe_strtoi64(value.string(), &durationUs)) {
+            return setParamFragmentDuration(durationUs);
+        }
     } else if (key == "param-track-time-status") {
         int64_t timeDurationUs;
         if (safe_strtoi64(value.string(), &timeDurationUs)) {
@@ -2268,6 +2335,9 @@ void StagefrightRecorder::setupMPEG4orWEBMMetaData(sp<MetaData> *meta) {
     if (mOutputFormat == OUTPUT_FORMAT_MPEG_4 || mOutputFormat == OUTPUT_FORMAT_THREE_GPP) {
         (*meta)->setInt32(kKeyEmptyTrackMalFormed, true);
         (*meta)->setInt32(kKey4BitTrackIds, true);
+        if (mFragmentDurationUs > 0) {
+            (*meta)->setInt64(kKeyFragmentDurationUs, mFragmentDurationUs);
+        }
     }
 }
 
@@ -2387,6 +2457,8 @@ status_t StagefrightRecorder::stop() {
     if (mWriter != NULL) {
         err = mWriter->stop();
         mLastSeqNo = mWriter->getSequenceNum();
+        mWriterMetrics = new AMessage;
+        mWriter->getMetrics(mWriterMetrics);
         mWriter.clear();
     }
 
@@ -2482,6 +2554,7 @@ status_t StagefrightRecorder::reset() {
     mMaxFileDurationUs = 0;
     mMaxFileSizeBytes = 0;
     mTrackEveryTimeDurationUs = 0;
+    mFragmentDurationUs = 0;
     mCaptureFpsEnable = false;
     mCaptureFps = -1.0;
     mCameraSourceTimeLapse = NULL;
@@ -2646,6 +2719,8 @@ status_t StagefrightRecorder::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     Progress notification: %" PRId64 " us\n", mTrackEveryTimeDurationUs);
     result.append(buffer);
+    snprintf(buffer, SIZE, "     Fragment duration (us): %" PRId64 "\n", mFragmentDurationUs);
+    result.append(buffer);
     snprintf(buffer, SIZE, "   Audio\n");
     result.append(buffer);
     snprintf(buffer, SIZE, "     Source: %d\n", mAudioSource);
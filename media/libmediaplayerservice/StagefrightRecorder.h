@@ -44,6 +44,7 @@ class MetaData;
 struct AudioSource;
 class MediaProfiles;
 struct ALooper;
+struct AMessage;
 
 struct StagefrightRecorder : public MediaRecorderBase {
     explicit StagefrightRecorder(const AttributionSourceState& attributionSource);
@@ -109,6 +110,8 @@ private:
 
     mediametrics::Item *mMetricsItem;
     bool mAnalyticsDirty;
+    // Writer metrics, kept past stop() since the writer is gone by then.
+    sp<AMessage> mWriterMetrics;
     void flushAndResetMetrics(bool reinitialize);
     void updateMetrics();
 
@@ -138,6 +141,7 @@ private:
     int64_t mMaxFileSizeBytes;
     int64_t mMaxFileDurationUs;
     int64_t mTrackEveryTimeDurationUs;
+    int64_t mFragmentDurationUs;  // 0 unless a fragmented MPEG4 file is written
     int32_t mRotationDegrees;  // Clockwise
     int32_t mLatitudex10000;
     int32_t mLongitudex10000;
@@ -231,6 +235,7 @@ private:
     status_t setParamVideoTimeScale(int32_t timeScale);
     status_t setParamVideoRotation(int32_t degrees);
     status_t setParamTrackTimeStatus(int64_t timeDurationUs);
+    status_t setParamFragmentDuration(int64_t durationUs);
     status_t setParamInterleaveDuration(int32_t durationUs);
     status_t setParam64BitFileOffset(bool use64BitFileOffset);
     status_t setParamMaxFileDurationUs(int64_t timeUs);
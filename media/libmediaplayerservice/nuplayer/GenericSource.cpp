@@ -20,6 +20,8 @@
 #include "GenericSource.h"
 #include "NuPlayerDrm.h"
 
+#include <algorithm>
+
 #include <binder/IServiceManager.h>
 #include <cutils/properties.h>
 #include <datasource/PlayerServiceDataSourceFactory.h>
@@ -52,6 +54,17 @@ static const int kInitialMarkMs        = 5000;  // 5secs
 //static const int kPausePlaybackMarkMs  = 2000;  // 2secs
 static const int kResumePlaybackMarkMs = 15000;  // 15secs
 
+// Local sources read ahead of the decoders by a multiple of the recent peak read latency,
+// within these bounds on the buffered duration and size of each track.
+static const int64_t kPrefetchReadLatencyFactor = 8;
+static const int64_t kPrefetchMinDurationUs = 500000LL;
+static const int64_t kPrefetchMaxDurationUs = 5000000LL;
+static const size_t kPrefetchMaxAudioBytes = 1 << 20;
+static const size_t kPrefetchMaxVideoBytes = 8 << 20;
+
+// Size of the seek cache of encoded video in MB, 0 to disable it.
+static const char *kSeekCachePropertyMB = "media.nuplayer.seek_cache_mb";
+
 NuPlayer::GenericSource::GenericSource(
         const sp<AMessage> &notify,
         bool uidValid,
@@ -62,6 +75,10 @@ NuPlayer::GenericSource::GenericSource(
       mAudioLastDequeueTimeUs(0),
       mVideoTimeUs(0),
       mVideoLastDequeueTimeUs(0),
+      mSeekCacheLimitBytes(
+              (size_t)std::max(property_get_int32(kSeekCachePropertyMB, 0), 0) << 20),
+      mSeekCacheBytes(0),
+      mVideoResumeAtUs(-1),
       mPrevBufferPercentage(-1),
       mPollBufferingGeneration(0),
       mSentPauseOnBuffering(false),
@@ -108,6 +125,7 @@ void NuPlayer::GenericSource::resetDataSource() {
     mIsDrmReleased = false;
     mIsSecure = false;
     mMimes.clear();
+    clearSeekCache_l();
 }
 
 status_t NuPlayer::GenericSource::setDataSource(
@@ -340,6 +358,40 @@ bool NuPlayer::GenericSource::isStreaming() const {
     return mIsStreaming;
 }
 
+sp<AMessage> NuPlayer::GenericSource::getStats() const {
+    Mutex::Autolock _l(mLock);
+    if (mIsStreaming) {
+        return NULL;
+    }
+
+    // the least buffered of the tracks, the underruns of both, and the slowest reads
+    int64_t bufferedUs = -1;
+    int32_t underruns = 0;
+    int64_t readLatencyUs = 0;
+    for (int i = 0; i < 2; ++i) {
+        const Track &track = i ? mVideoTrack : mAudioTrack;
+        const Prefetch &prefetch = i ? mVideoPrefetch : mAudioPrefetch;
+        if (track.mSource == NULL) {
+            continue;
+        }
+        status_t finalResult;
+        int64_t durationUs = track.mPackets->getBufferedDurationUs(&finalResult);
+        if (finalResult == OK && (bufferedUs < 0 || durationUs < bufferedUs)) {
+            bufferedUs = durationUs;
+        }
+        underruns += prefetch.mUnderruns;
+        readLatencyUs = std::max(readLatencyUs, prefetch.mPeakReadLatencyUs);
+    }
+
+    sp<AMessage> stats = new AMessage;
+    if (bufferedUs >= 0) {
+        stats->setInt64("buffered-us", bufferedUs);
+    }
+    stats->setInt32("underruns", underruns);
+    stats->setInt64("read-latency-us", readLatencyUs);
+    return stats;
+}
+
 NuPlayer::GenericSource::~GenericSource() {
     ALOGV("~GenericSource");
     if (mLooper != NULL) {
@@ -667,6 +719,9 @@ void NuPlayer::GenericSource::onMessageReceived(const sp<AMessage> &msg) {
           if (track->mSource != NULL) {
               track->mSource->stop();
           }
+          if (trackType == MEDIA_TRACK_TYPE_VIDEO) {
+              clearSeekCache_l();
+          }
           track->mSource = source;
           track->mSource->start();
           track->mIndex = trackIndex;
@@ -852,9 +907,14 @@ status_t NuPlayer::GenericSource::dequeueAccessUnit(
         return -EWOULDBLOCK;
     }
 
+    Prefetch *prefetch = audio ? &mAudioPrefetch : &mVideoPrefetch;
     status_t finalResult;
     if (!track->mPackets->hasBufferAvailable(&finalResult)) {
         if (finalResult == OK) {
+            if (mStarted && !mIsStreaming && !prefetch->mStarved) {
+                prefetch->mStarved = true;
+                ++prefetch->mUnderruns;
+            }
             postReadBuffer(
                     audio ? MEDIA_TRACK_TYPE_AUDIO : MEDIA_TRACK_TYPE_VIDEO);
             return -EWOULDBLOCK;
@@ -863,11 +923,12 @@ status_t NuPlayer::GenericSource::dequeueAccessUnit(
     }
 
     status_t result = track->mPackets->dequeueAccessUnit(accessUnit);
+    prefetch->mStarved = false;
 
     // start pulling in more buffers if cache is running low
     // so that decoder has less chance of being starved
     if (!mIsStreaming) {
-        if (track->mPackets->getAvailableBufferCount(&finalResult) < 2) {
+        if (needsPrefetch_l(audio)) {
             postReadBuffer(audio? MEDIA_TRACK_TYPE_AUDIO : MEDIA_TRACK_TYPE_VIDEO);
         }
     } else {
@@ -1156,7 +1217,11 @@ status_t NuPlayer::GenericSource::doSeek(int64_t seekTimeUs, MediaPlayerSeekMode
         ++mVideoDataGeneration;
 
         int64_t actualTimeUs;
-        readBuffer(MEDIA_TRACK_TYPE_VIDEO, seekTimeUs, mode, &actualTimeUs);
+        if (mode != MediaPlayerSeekMode::SEEK_CLOSEST
+                || !seekFromCache_l(seekTimeUs, &actualTimeUs)) {
+            mVideoResumeAtUs = -1;
+            readBuffer(MEDIA_TRACK_TYPE_VIDEO, seekTimeUs, mode, &actualTimeUs);
+        }
 
         if (mode != MediaPlayerSeekMode::SEEK_CLOSEST) {
             seekTimeUs = std::max<int64_t>(0, actualTimeUs);
@@ -1356,9 +1421,17 @@ void NuPlayer::GenericSource::readBuffer(
     MediaSource::ReadOptions options;
 
     bool seeking = false;
+    // the next sample read does not follow the previous one, for the seek cache
+    bool discontinuity = formatChange;
     if (seekTimeUs >= 0) {
         options.setSeekTo(seekTimeUs, mode);
         seeking = true;
+        discontinuity = true;
+    } else if (trackType == MEDIA_TRACK_TYPE_VIDEO && mVideoResumeAtUs >= 0) {
+        // continue after a segment queued from the seek cache, without a discontinuity
+        options.setSeekTo(mVideoResumeAtUs, MediaPlayerSeekMode::SEEK_PREVIOUS_SYNC);
+        mVideoResumeAtUs = -1;
+        discontinuity = true;
     }
 
     const bool couldReadMultiple = (track->mSource->supportReadMultiple());
@@ -1368,11 +1441,13 @@ void NuPlayer::GenericSource::readBuffer(
     }
 
     int32_t generation = getDataGeneration(trackType);
-    for (size_t numBuffers = 0; numBuffers < maxBuffers; ) {
+    size_t numBuffers = 0;
+    while (numBuffers < maxBuffers) {
         Vector<MediaBufferBase *> mediaBuffers;
         status_t err = NO_ERROR;
 
         sp<IMediaSource> source = track->mSource;
+        int64_t readStartUs = ALooper::GetNowUs();
         mLock.unlock();
         if (couldReadMultiple) {
             err = source->readMultiple(
@@ -1386,6 +1461,12 @@ void NuPlayer::GenericSource::readBuffer(
         }
         mLock.lock();
 
+        if (!mIsStreaming && (trackType == MEDIA_TRACK_TYPE_AUDIO
+                || trackType == MEDIA_TRACK_TYPE_VIDEO)) {
+            updateReadLatency_l(
+                    trackType == MEDIA_TRACK_TYPE_AUDIO, ALooper::GetNowUs() - readStartUs);
+        }
+
         options.clearNonPersistent();
 
         size_t id = 0;
@@ -1415,6 +1496,8 @@ void NuPlayer::GenericSource::readBuffer(
 
             queueDiscontinuityIfNeeded(seeking, formatChange, trackType, track);
 
+            int32_t isSync = 0;
+            mbuf->meta_data().findInt32(kKeyIsSyncFrame, &isSync);
             sp<ABuffer> buffer = mediaBufferToABuffer(mbuf, trackType);
             if (numBuffers == 0 && actualTimeUs != nullptr) {
                 *actualTimeUs = timeUs;
@@ -1430,8 +1513,13 @@ void NuPlayer::GenericSource::readBuffer(
             }
 
             track->mPackets->queueAccessUnit(buffer);
+            if (trackType == MEDIA_TRACK_TYPE_VIDEO && mSeekCacheLimitBytes > 0
+                    && !mIsDrmProtected) {
+                addToSeekCache_l(buffer, isSync, discontinuity);
+            }
             formatChange = false;
             seeking = false;
+            discontinuity = false;
             ++numBuffers;
         }
         if (id < count) {
@@ -1458,6 +1546,16 @@ void NuPlayer::GenericSource::readBuffer(
         }
     }
 
+    if (!mIsStreaming
+        && (trackType == MEDIA_TRACK_TYPE_VIDEO || trackType == MEDIA_TRACK_TYPE_AUDIO)) {
+        // keep reading ahead in further messages, so that seeks and the other track get in
+        // between. A read that brought nothing is retried when the decoder next dequeues.
+        if (mStarted && numBuffers > 0
+                && needsPrefetch_l(trackType == MEDIA_TRACK_TYPE_AUDIO)) {
+            postReadBuffer(trackType);
+        }
+    }
+
     if (mIsStreaming
         && (trackType == MEDIA_TRACK_TYPE_VIDEO || trackType == MEDIA_TRACK_TYPE_AUDIO)) {
         status_t finalResult;
@@ -1494,6 +1592,125 @@ void NuPlayer::GenericSource::readBuffer(
     }
 }
 
+bool NuPlayer::GenericSource::needsPrefetch_l(bool audio) const {
+    const Track &track = audio ? mAudioTrack : mVideoTrack;
+    const Prefetch &prefetch = audio ? mAudioPrefetch : mVideoPrefetch;
+
+    status_t finalResult;
+    if (track.mPackets->getAvailableBufferCount(&finalResult) < 2) {
+        return finalResult == OK;
+    }
+
+    int64_t targetUs = std::min(kPrefetchMaxDurationUs, std::max(kPrefetchMinDurationUs,
+            prefetch.mPeakReadLatencyUs * kPrefetchReadLatencyFactor));
+    size_t maxBytes = audio ? kPrefetchMaxAudioBytes : kPrefetchMaxVideoBytes;
+    return track.mPackets->getBufferedDurationUs(&finalResult) < targetUs
+            && finalResult == OK
+            && track.mPackets->getBufferedBytes() < maxBytes;
+}
+
+void NuPlayer::GenericSource::updateReadLatency_l(bool audio, int64_t latencyUs) {
+    Prefetch &prefetch = audio ? mAudioPrefetch : mVideoPrefetch;
+    // the peak decays by an eighth per read, following I/O contention as it comes and goes
+    prefetch.mPeakReadLatencyUs = std::max(latencyUs,
+            prefetch.mPeakReadLatencyUs - prefetch.mPeakReadLatencyUs / 8);
+}
+
+void NuPlayer::GenericSource::addToSeekCache_l(
+        const sp<ABuffer> &buffer, bool isSync, bool discontinuity) {
+    if (discontinuity) {
+        mSeekCacheFill = SeekCacheSegment();
+    }
+    int64_t timeUs;
+    CHECK(buffer->meta()->findInt64("timeUs", &timeUs));
+
+    if (!isSync) {
+        // only segments read from their sync sample on are kept
+        if (mSeekCacheFill.mBuffers.empty()) {
+            return;
+        }
+        // a segment may take half of the cache, so that seeking back and forth between two
+        // of them stays cached
+        if (mSeekCacheFill.mBytes + buffer->size() > mSeekCacheLimitBytes / 2) {
+            ALOGV("segment at %lld us is too large to cache",
+                    (long long)mSeekCacheFill.mSyncTimeUs);
+            mSeekCacheFill = SeekCacheSegment();
+            return;
+        }
+        mSeekCacheFill.mBuffers.push_back(buffer);
+        mSeekCacheFill.mBytes += buffer->size();
+        return;
+    }
+
+    if (!mSeekCacheFill.mBuffers.empty() && timeUs > mSeekCacheFill.mSyncTimeUs) {
+        mSeekCacheFill.mNextSyncTimeUs = timeUs;
+        for (auto it = mSeekCache.begin(); it != mSeekCache.end(); ++it) {
+            if (it->mSyncTimeUs == mSeekCacheFill.mSyncTimeUs) {
+                mSeekCacheBytes -= it->mBytes;
+                mSeekCache.erase(it);
+                break;
+            }
+        }
+        mSeekCacheBytes += mSeekCacheFill.mBytes;
+        mSeekCache.push_front(std::move(mSeekCacheFill));
+        while (mSeekCacheBytes > mSeekCacheLimitBytes) {
+            mSeekCacheBytes -= mSeekCache.back().mBytes;
+            mSeekCache.pop_back();
+        }
+    }
+    mSeekCacheFill = SeekCacheSegment();
+    mSeekCacheFill.mSyncTimeUs = timeUs;
+    mSeekCacheFill.mBuffers.push_back(buffer);
+    mSeekCacheFill.mBytes = buffer->size();
+}
+
+bool NuPlayer::GenericSource::seekFromCache_l(int64_t seekTimeUs, int64_t *actualTimeUs) {
+    auto it = mSeekCache.begin();
+    while (it != mSeekCache.end()
+            && (seekTimeUs < it->mSyncTimeUs || seekTimeUs >= it->mNextSyncTimeUs)) {
+        ++it;
+    }
+    if (it == mSeekCache.end()) {
+        return false;
+    }
+    mSeekCache.splice(mSeekCache.begin(), mSeekCache, it);
+    const SeekCacheSegment &segment = mSeekCache.front();
+    ALOGV("seek to %lld us from the cached segment at %lld us",
+            (long long)seekTimeUs, (long long)segment.mSyncTimeUs);
+
+    queueDiscontinuityIfNeeded(
+            true /* seeking */, false /* formatChange */, MEDIA_TRACK_TYPE_VIDEO, &mVideoTrack);
+    for (size_t i = 0; i < segment.mBuffers.size(); ++i) {
+        // the queued buffers are handed to the decoder, so each seek gets its own copies
+        const sp<ABuffer> &cached = segment.mBuffers[i];
+        sp<ABuffer> buffer = ABuffer::CreateAsCopy(cached->data(), cached->size());
+        buffer->meta()->extend(cached->meta());
+        buffer->meta()->removeEntryByName("extra");
+        int64_t timeUs;
+        CHECK(buffer->meta()->findInt64("timeUs", &timeUs));
+        if (i == 0 && seekTimeUs > timeUs) {
+            sp<AMessage> extra = new AMessage;
+            extra->setInt64("resume-at-mediaTimeUs", seekTimeUs);
+            buffer->meta()->setMessage("extra", extra);
+        }
+        mVideoTrack.mPackets->queueAccessUnit(buffer);
+        mVideoTimeUs = timeUs;
+    }
+
+    *actualTimeUs = segment.mSyncTimeUs;
+    mVideoResumeAtUs = segment.mNextSyncTimeUs;
+    mSeekCacheFill = SeekCacheSegment();
+    readBuffer(MEDIA_TRACK_TYPE_VIDEO);
+    return true;
+}
+
+void NuPlayer::GenericSource::clearSeekCache_l() {
+    mSeekCache.clear();
+    mSeekCacheBytes = 0;
+    mSeekCacheFill = SeekCacheSegment();
+    mVideoResumeAtUs = -1;
+}
+
 void NuPlayer::GenericSource::queueDiscontinuityIfNeeded(
         bool seeking, bool formatChange, media_track_type trackType, Track *track) {
     // formatChange && seeking: track whose source is changed during selection
@@ -1619,6 +1836,7 @@ status_t NuPlayer::GenericSource::prepareDrm(
     *outCrypto = crypto;
     // as long a there is an active crypto
     mIsDrmProtected = true;
+    clearSeekCache_l();
 
     if (mMimes.size() == 0) {
         status = UNKNOWN_ERROR;
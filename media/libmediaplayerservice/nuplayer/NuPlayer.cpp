@@ -65,6 +65,9 @@
 
 namespace android {
 
+// Seeks requested closer together than this are taken as scrubbing, in scrub preview mode.
+static const int64_t kScrubIntervalUs = 250000LL;
+
 struct NuPlayer::Action : public RefBase {
     Action() {}
 
@@ -202,12 +205,20 @@ NuPlayer::NuPlayer(pid_t pid, const sp<MediaClock> &mediaClock)
       mPrepared(false),
       mResetting(false),
       mSourceStarted(false),
+      mFastStart(property_get_bool("media.nuplayer.fast_start", false)),
+      mScrubPreview(property_get_bool("media.nuplayer.scrub_preview", false)),
+      mLastSeekRequestUs(-1),
+      mScrubGeneration(0),
+      mSeekStartUs(-1),
+      mSeekFlushPending(false),
+      mSeekIsPreview(false),
       mAudioDecoderError(false),
       mVideoDecoderError(false),
       mPaused(false),
       mPausedByClient(true),
       mPausedForBuffering(false),
       mIsDrmProtected(false),
+      mSourceHasDrmInfo(false),
       mDataSourceType(DATA_SOURCE_TYPE_NONE) {
     CHECK(mediaClock != NULL);
     clearFlushComplete();
@@ -1304,8 +1315,21 @@ void NuPlayer::onMessageReceived(const sp<AMessage> &msg) {
                     // Flush has been handled by tear down.
                     break;
                 }
+                if (!audio) {
+                    mSeekFlushPending = false;
+                }
                 handleFlushComplete(audio, false /* isDecoder */);
                 finishFlushIfPossible();
+            } else if (what == Renderer::kWhatFirstVideoFrame) {
+                // frames that were queued before the flush of the seek do not count
+                if (mSeekStartUs >= 0 && !mSeekFlushPending) {
+                    sp<NuPlayerDriver> driver = mDriver.promote();
+                    if (driver != NULL) {
+                        driver->notifySeekLatencyUs(
+                                ALooper::GetNowUs() - mSeekStartUs, mSeekIsPreview);
+                    }
+                    mSeekStartUs = -1;
+                }
             } else if (what == Renderer::kWhatVideoRenderingStart) {
                 notifyListener(MEDIA_INFO, MEDIA_INFO_RENDERING_START, 0);
             } else if (what == Renderer::kWhatMediaRenderingStart) {
@@ -1397,12 +1421,19 @@ void NuPlayer::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
+            MediaPlayerSeekMode seekMode = getScrubSeekMode(seekTimeUs, (MediaPlayerSeekMode)mode);
+            if (mVideoDecoder != NULL) {
+                mSeekStartUs = ALooper::GetNowUs();
+                mSeekFlushPending = true;
+                mSeekIsPreview = seekMode != (MediaPlayerSeekMode)mode;
+            }
+
             mDeferredActions.push_back(
                     new FlushDecoderAction(FLUSH_CMD_FLUSH /* audio */,
                                            FLUSH_CMD_FLUSH /* video */));
 
             mDeferredActions.push_back(
-                    new SeekAction(seekTimeUs, (MediaPlayerSeekMode)mode));
+                    new SeekAction(seekTimeUs, seekMode));
 
             // After a flush without shutdown, decoder is paused.
             // Don't resume it until source seek is done, otherwise it could
@@ -1414,6 +1445,21 @@ void NuPlayer::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatScrubSettled:
+        {
+            int32_t generation;
+            CHECK(msg->findInt32("generation", &generation));
+            if (generation != mScrubGeneration) {
+                // still scrubbing
+                break;
+            }
+            int64_t seekTimeUs;
+            CHECK(msg->findInt64("seekTimeUs", &seekTimeUs));
+            ALOGV("scrubbing stopped, seeking accurately to %lld us", (long long)seekTimeUs);
+            seekToAsync(seekTimeUs, MediaPlayerSeekMode::SEEK_CLOSEST, false /* needNotify */);
+            break;
+        }
+
         case kWhatPause:
         {
             onPause();
@@ -1535,6 +1581,29 @@ status_t NuPlayer::onInstantiateSecureDecoders() {
     return OK;
 }
 
+void NuPlayer::instantiateDecodersForFastStart() {
+    // Modular DRM sources get their crypto only in prepareDrm(), after being prepared.
+    if (mSourceHasDrmInfo) {
+        return;
+    }
+
+    // As for secure decoders, a null mRenderer keeps the decoders from requesting data,
+    // while the codecs are allocated and configured on their own loopers until start.
+    // Audio is always decoded to PCM then, as offload is only decided in onStart().
+    mOffloadAudio = false;
+    if (mSurface != NULL && mSource->getFormat(false /* audio */) != NULL) {
+        if (instantiateDecoder(false, &mVideoDecoder) != OK) {
+            ALOGW("fast start: failed to instantiate video decoder");
+        }
+    }
+    if (mAudioSink != NULL && mSource->getFormat(true /* audio */) != NULL) {
+        if (instantiateDecoder(
+                true, &mAudioDecoder, false /* checkAudioModeChange */) != OK) {
+            ALOGW("fast start: failed to instantiate audio decoder");
+        }
+    }
+}
+
 void NuPlayer::onStart(int64_t startPositionUs, MediaPlayerSeekMode mode) {
     ALOGV("onStart: mCrypto: %p (%d)", mCrypto.get(),
             (mCrypto != NULL ? mCrypto->getStrongCount() : 0));
@@ -1590,10 +1659,19 @@ void NuPlayer::onStart(int64_t startPositionUs, MediaPlayerSeekMode mode) {
         ALOGV("onStart: Disabling mOffloadAudio now that the source is protected.");
     }
 
+    // An audio decoder instantiated for fast start already decodes to PCM.
+    if (mOffloadAudio && mFastStart && mAudioDecoder != NULL) {
+        mOffloadAudio = false;
+    }
+
     if (mOffloadAudio) {
         flags |= Renderer::FLAG_OFFLOAD_AUDIO;
     }
 
+    if (mFastStart && hasVideo && mSurface != NULL) {
+        flags |= Renderer::FLAG_FAST_START;
+    }
+
     sp<AMessage> notify = new AMessage(kWhatRendererNotify, this);
     ++mRendererGeneration;
     notify->setInt32("generation", mRendererGeneration);
@@ -1704,6 +1782,10 @@ void NuPlayer::updateInternalTimers() {
     updateRebufferingTimer(false /* stopping */, false /* exiting */);
 }
 
+bool NuPlayer::isFastStartEnabled() const {
+    return mFastStart;
+}
+
 void NuPlayer::setTargetBitrate(int bitrate) {
     if (mSource != NULL) {
         mSource->setTargetBitrate(bitrate);
@@ -2276,6 +2358,19 @@ void NuPlayer::getStats(Vector<sp<AMessage> > *trackStats) {
     if (mAudioDecoder != NULL) {
         trackStats->push_back(mAudioDecoder->getStats());
     }
+
+    sp<Renderer> renderer = mRenderer;
+    if (renderer != NULL) {
+        trackStats->push_back(renderer->getStats());
+    }
+
+    Mutex::Autolock sourceLock(mSourceLock);
+    if (mSource != NULL) {
+        sp<AMessage> sourceStats = mSource->getStats();
+        if (sourceStats != NULL) {
+            trackStats->push_back(sourceStats);
+        }
+    }
 }
 
 sp<MetaData> NuPlayer::getFileMeta() {
@@ -2337,6 +2432,28 @@ void NuPlayer::processDeferredActions() {
     }
 }
 
+MediaPlayerSeekMode NuPlayer::getScrubSeekMode(int64_t seekTimeUs, MediaPlayerSeekMode mode) {
+    if (!mScrubPreview || mVideoDecoder == NULL) {
+        return mode;
+    }
+    const int64_t nowUs = ALooper::GetNowUs();
+    const bool scrubbing =
+            mLastSeekRequestUs >= 0 && nowUs - mLastSeekRequestUs < kScrubIntervalUs;
+    mLastSeekRequestUs = nowUs;
+    ++mScrubGeneration;
+    if (!scrubbing || mode != MediaPlayerSeekMode::SEEK_CLOSEST) {
+        return mode;
+    }
+
+    // A sync frame is shown after decoding just that frame, while an accurate seek decodes
+    // up to a whole group of pictures, most of which the next seek would discard.
+    sp<AMessage> msg = new AMessage(kWhatScrubSettled, this);
+    msg->setInt32("generation", mScrubGeneration);
+    msg->setInt64("seekTimeUs", seekTimeUs);
+    msg->post(kScrubIntervalUs);
+    return MediaPlayerSeekMode::SEEK_CLOSEST_SYNC;
+}
+
 void NuPlayer::performSeek(int64_t seekTimeUs, MediaPlayerSeekMode mode) {
     ALOGV("performSeek seekTimeUs=%lld us (%.2f secs), mode=%d",
           (long long)seekTimeUs, seekTimeUs / 1E6, mode);
@@ -2425,6 +2542,10 @@ void NuPlayer::performReset() {
         mCrypto.clear();
     }
     mIsDrmProtected = false;
+    mSourceHasDrmInfo = false;
+    mLastSeekRequestUs = -1;
+    ++mScrubGeneration;
+    mSeekStartUs = -1;
 }
 
 void NuPlayer::performScanSources() {
@@ -2538,6 +2659,9 @@ void NuPlayer::onSourceNotify(const sp<AMessage> &msg) {
                 processDeferredActions();
             } else {
                 mPrepared = true;
+                if (mFastStart && !mStarted) {
+                    instantiateDecodersForFastStart();
+                }
             }
 
             sp<NuPlayerDriver> driver = mDriver.promote();
@@ -2564,6 +2688,7 @@ void NuPlayer::onSourceNotify(const sp<AMessage> &msg) {
 
             ALOGV("onSourceNotify() kWhatDrmInfo MEDIA_DRM_INFO drmInfo: %p  parcel size: %zu",
                     drmInfo.get(), parcel.dataSize());
+            mSourceHasDrmInfo = true;
 
             notifyListener(MEDIA_DRM_INFO, 0 /* ext1 */, 0 /* ext2 */, &parcel);
 
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "NuPlayerDriver"
 #include <inttypes.h>
+#include <algorithm>
 #include <android-base/macros.h>
 #include <utils/Log.h>
 #include <cutils/properties.h>
@@ -67,6 +68,18 @@ static const char *kPlayerDataSourceType = "android.media.mediaplayer.dataSource
 static const char *kPlayerRebuffering = "android.media.mediaplayer.rebufferingMs";
 static const char *kPlayerRebufferingCount = "android.media.mediaplayer.rebuffers";
 static const char *kPlayerRebufferingAtExit = "android.media.mediaplayer.rebufferExit";
+static const char *kPlayerTimeToFirstFrame = "android.media.mediaplayer.timeToFirstFrameMs";
+static const char *kPlayerStartupPrepare = "android.media.mediaplayer.startup.prepareMs";
+static const char *kPlayerStartupFirstFrame = "android.media.mediaplayer.startup.firstFrameMs";
+static const char *kPlayerStartupFastStart = "android.media.mediaplayer.startup.fastStart";
+static const char *kPlayerSeekCount = "android.media.mediaplayer.seek.count";
+static const char *kPlayerSeekPreviews = "android.media.mediaplayer.seek.previews";
+static const char *kPlayerSeekLatencyAvg = "android.media.mediaplayer.seek.latencyAvgMs";
+static const char *kPlayerSeekLatencyMax = "android.media.mediaplayer.seek.latencyMaxMs";
+static const char *kPlayerPrefetchBuffered = "android.media.mediaplayer.prefetch.bufferedMs";
+static const char *kPlayerPrefetchUnderruns = "android.media.mediaplayer.prefetch.underruns";
+static const char *kPlayerPrefetchReadLatency = "android.media.mediaplayer.prefetch.readLatencyMs";
+static const char *kPlayerAudioWakeups = "android.media.mediaplayer.audio.wakeupsPerSec";
 
 
 NuPlayerDriver::NuPlayerDriver(pid_t pid)
@@ -81,6 +94,15 @@ NuPlayerDriver::NuPlayerDriver(pid_t pid)
       mRebufferingTimeUs(0),
       mRebufferingEvents(0),
       mRebufferingAtExit(false),
+      mStartRequestTimeUs(-1),
+      mTimeToFirstFrameUs(-1),
+      mPrepareRequestTimeUs(-1),
+      mTimeToPreparedUs(-1),
+      mPrepareToFirstFrameUs(-1),
+      mSeekCount(0),
+      mPreviewSeekCount(0),
+      mSeekLatencySumUs(0),
+      mSeekLatencyMaxUs(0),
       mLooper(new ALooper),
       mMediaClock(new MediaClock),
       mPlayer(new NuPlayer(pid, mMediaClock)),
@@ -301,6 +323,7 @@ status_t NuPlayerDriver::prepare_l() {
     switch (mState) {
         case STATE_UNPREPARED:
             mState = STATE_PREPARING;
+            mPrepareRequestTimeUs = ALooper::GetNowUs();
 
             // Make sure we're not posting any notifications, success or
             // failure information is only communicated through our result
@@ -334,6 +357,7 @@ status_t NuPlayerDriver::prepareAsync() {
     switch (mState) {
         case STATE_UNPREPARED:
             mState = STATE_PREPARING;
+            mPrepareRequestTimeUs = ALooper::GetNowUs();
             mIsAsyncPrepare = true;
             mPlayer->prepareAsync();
             return OK;
@@ -375,6 +399,9 @@ status_t NuPlayerDriver::start_l() {
         case STATE_STOPPED_AND_PREPARED:
         case STATE_PREPARED:
         {
+            if (mStartRequestTimeUs < 0) {
+                mStartRequestTimeUs = ALooper::GetNowUs();
+            }
             mPlayer->start();
 
             FALLTHROUGH_INTENDED;
@@ -581,6 +608,13 @@ void NuPlayerDriver::updateMetrics(const char *where) {
     int64_t rebufferingTimeUs;
     int32_t rebufferingEvents;
     bool rebufferingAtExit;
+    int64_t timeToFirstFrameUs;
+    int64_t timeToPreparedUs;
+    int64_t prepareToFirstFrameUs;
+    int32_t seekCount;
+    int32_t previewSeekCount;
+    int64_t seekLatencySumUs;
+    int64_t seekLatencyMaxUs;
     {
         Mutex::Autolock autoLock(mLock);
 
@@ -588,6 +622,13 @@ void NuPlayerDriver::updateMetrics(const char *where) {
         rebufferingTimeUs = mRebufferingTimeUs;
         rebufferingEvents = mRebufferingEvents;
         rebufferingAtExit = mRebufferingAtExit;
+        timeToFirstFrameUs = mTimeToFirstFrameUs;
+        timeToPreparedUs = mTimeToPreparedUs;
+        prepareToFirstFrameUs = mPrepareToFirstFrameUs;
+        seekCount = mSeekCount;
+        previewSeekCount = mPreviewSeekCount;
+        seekLatencySumUs = mSeekLatencySumUs;
+        seekLatencyMaxUs = mSeekLatencyMaxUs;
     }
 
     // finish the rest of the gathering under our mutex to avoid metrics races.
@@ -607,6 +648,28 @@ void NuPlayerDriver::updateMetrics(const char *where) {
         mMetricsItem->setInt32(kPlayerRebufferingAtExit, rebufferingAtExit);
     }
 
+    if (timeToFirstFrameUs >= 0) {
+        mMetricsItem->setInt64(kPlayerTimeToFirstFrame, (timeToFirstFrameUs+500)/1000);
+    }
+
+    // startup phases: prepare, then start to first frame above, and prepare to first frame
+    if (timeToPreparedUs >= 0) {
+        mMetricsItem->setInt64(kPlayerStartupPrepare, (timeToPreparedUs+500)/1000);
+        mMetricsItem->setInt32(kPlayerStartupFastStart, mPlayer->isFastStartEnabled());
+    }
+    if (prepareToFirstFrameUs >= 0) {
+        mMetricsItem->setInt64(kPlayerStartupFirstFrame, (prepareToFirstFrameUs+500)/1000);
+    }
+
+    // seek requests to the first video frame after them, scrubbing previews included
+    if (seekCount > 0) {
+        mMetricsItem->setInt32(kPlayerSeekCount, seekCount);
+        mMetricsItem->setInt32(kPlayerSeekPreviews, previewSeekCount);
+        mMetricsItem->setInt64(kPlayerSeekLatencyAvg,
+                (seekLatencySumUs / seekCount + 500) / 1000);
+        mMetricsItem->setInt64(kPlayerSeekLatencyMax, (seekLatencyMaxUs+500)/1000);
+    }
+
     mMetricsItem->setCString(kPlayerDataSourceType, mPlayer->getDataSourceType());
 
     if (trackStats.size() > 0) {
@@ -650,6 +713,25 @@ void NuPlayerDriver::updateMetrics(const char *where) {
                 if (!name.empty()) {
                     mMetricsItem->setCString(kPlayerACodec, name.c_str());
                 }
+            } else if (mime.empty()) {
+                // renderer and source statistics
+                int64_t wakeups;
+                if (stats->findInt64("audio-drain-wakeups", &wakeups) && playingTimeUs > 0) {
+                    mMetricsItem->setDouble(kPlayerAudioWakeups,
+                            wakeups * 1000000.0 / playingTimeUs);
+                }
+                int64_t bufferedUs;
+                if (stats->findInt64("buffered-us", &bufferedUs)) {
+                    mMetricsItem->setInt64(kPlayerPrefetchBuffered, (bufferedUs+500)/1000);
+                }
+                int32_t underruns;
+                if (stats->findInt32("underruns", &underruns)) {
+                    mMetricsItem->setInt32(kPlayerPrefetchUnderruns, underruns);
+                }
+                int64_t readLatencyUs;
+                if (stats->findInt64("read-latency-us", &readLatencyUs)) {
+                    mMetricsItem->setInt64(kPlayerPrefetchReadLatency, (readLatencyUs+500)/1000);
+                }
             }
         }
     }
@@ -740,6 +822,15 @@ status_t NuPlayerDriver::reset() {
     mRebufferingTimeUs = 0;
     mRebufferingEvents = 0;
     mRebufferingAtExit = false;
+    mStartRequestTimeUs = -1;
+    mTimeToFirstFrameUs = -1;
+    mPrepareRequestTimeUs = -1;
+    mTimeToPreparedUs = -1;
+    mPrepareToFirstFrameUs = -1;
+    mSeekCount = 0;
+    mPreviewSeekCount = 0;
+    mSeekLatencySumUs = 0;
+    mSeekLatencyMaxUs = 0;
 
     return OK;
 }
@@ -910,6 +1001,17 @@ void NuPlayerDriver::notifyRebufferingWhenExit(bool status) {
     mRebufferingAtExit = status;
 }
 
+void NuPlayerDriver::notifySeekLatencyUs(int64_t latencyUs, bool preview) {
+    ALOGV("notifySeekLatencyUs(%p) %lld us, preview %d", this, (long long)latencyUs, preview);
+    Mutex::Autolock autoLock(mLock);
+    mSeekCount++;
+    if (preview) {
+        mPreviewSeekCount++;
+    }
+    mSeekLatencySumUs += latencyUs;
+    mSeekLatencyMaxUs = std::max(mSeekLatencyMaxUs, latencyUs);
+}
+
 void NuPlayerDriver::notifySeekComplete() {
     ALOGV("notifySeekComplete(%p)", this);
     Mutex::Autolock autoLock(mLock);
@@ -997,6 +1099,19 @@ status_t NuPlayerDriver::dump(
                             ? 0.0 : (double)(numFramesDropped * 100) / numFramesTotal);
             logString.append(buf);
         }
+
+        int64_t readLatencyUs;
+        if (stats->findInt64("read-latency-us", &readLatencyUs)) {
+            int64_t bufferedUs = -1;
+            int32_t underruns = 0;
+            stats->findInt64("buffered-us", &bufferedUs);
+            stats->findInt32("underruns", &underruns);
+            snprintf(buf, sizeof(buf), "  prefetch: buffered(%lld ms), underruns(%d), "
+                     "readLatency(%lld ms)\n",
+                     (long long)(bufferedUs / 1000), underruns,
+                     (long long)(readLatencyUs / 1000));
+            logString.append(buf);
+        }
     }
 
     ALOGI("%s", logString.c_str());
@@ -1074,6 +1189,20 @@ void NuPlayerDriver::notifyListener_l(
             break;
         }
 
+        case MEDIA_INFO:
+        {
+            // time from the first start() to the first video frame
+            if (ext1 == MEDIA_INFO_RENDERING_START && mStartRequestTimeUs >= 0
+                    && mTimeToFirstFrameUs < 0) {
+                int64_t nowUs = ALooper::GetNowUs();
+                mTimeToFirstFrameUs = nowUs - mStartRequestTimeUs;
+                if (mPrepareRequestTimeUs >= 0) {
+                    mPrepareToFirstFrameUs = nowUs - mPrepareRequestTimeUs;
+                }
+            }
+            break;
+        }
+
         default:
             break;
     }
@@ -1114,6 +1243,9 @@ void NuPlayerDriver::notifyPrepareCompleted(status_t err) {
         // update state before notifying client, so that if client calls back into NuPlayerDriver
         // in response, NuPlayerDriver has the right state
         mState = STATE_PREPARED;
+        if (mPrepareRequestTimeUs >= 0 && mTimeToPreparedUs < 0) {
+            mTimeToPreparedUs = ALooper::GetNowUs() - mPrepareRequestTimeUs;
+        }
         if (mIsAsyncPrepare) {
             notifyListener_l(MEDIA_PREPARED);
         }
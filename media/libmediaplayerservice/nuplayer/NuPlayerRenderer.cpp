@@ -64,6 +64,10 @@ static inline bool getUseAudioCallbackSetting() {
     return property_get_bool("media.stagefright.audio.cbk", false /* default_value */);
 }
 
+static inline bool getAudioBurstSetting() {
+    return property_get_bool("media.stagefright.audio.burst", false /* default_value */);
+}
+
 static inline int32_t getAudioSinkPcmMsSetting() {
     return property_get_int32(
             "media.stagefright.audio.sink", 500 /* default_value */);
@@ -82,10 +86,17 @@ static const int64_t kMaxAllowedAudioSinkDelayUs = 1500000LL;
 
 static const int64_t kMinimumAudioClockUpdatePeriodUs = 20 /* msec */ * 1000;
 
+// In audio burst mode, the AudioSink is written to when it has no more than this left to play.
+static const int64_t kAudioBurstLowWatermarkUs = 200000LL;
+
 // Default video frame display duration when only video exists.
 // Used to set max media time in MediaClock.
 static const int64_t kDefaultVideoFrameIntervalUs = 100000LL;
 
+// Maximum time the audio sink open is held back in fast start mode waiting for the first
+// video frame.
+static const int64_t kFastStartAudioSinkDelayUs = 100000LL;
+
 // static
 const NuPlayer::Renderer::PcmInfo NuPlayer::Renderer::AUDIO_PCMINFO_INITIALIZER = {
         AUDIO_CHANNEL_NONE,
@@ -145,6 +156,7 @@ NuPlayer::Renderer::Renderer(
       mPauseDrainAudioAllowedUs(0),
       mVideoSampleReceived(false),
       mVideoRenderingStarted(false),
+      mAudioSinkOpenDeferred(false),
       mVideoRenderingStartGeneration(0),
       mAudioRenderingStartGeneration(0),
       mRenderingDataDelivered(false),
@@ -157,6 +169,7 @@ NuPlayer::Renderer::Renderer(
       mTotalBuffersQueued(0),
       mLastAudioBufferDrained(0),
       mUseAudioCallback(false),
+      mAudioBurstMode(false),
       mWakeLock(new AWakeLock()) {
     CHECK(mediaClock != NULL);
     mPlaybackRate = mPlaybackSettings.mSpeed;
@@ -443,6 +456,12 @@ int64_t NuPlayer::Renderer::getVideoLateByUs() {
     return mVideoLateByUs;
 }
 
+sp<AMessage> NuPlayer::Renderer::getStats() {
+    sp<AMessage> stats = new AMessage;
+    stats->setInt64("audio-drain-wakeups", mAudioDrainWakeups);
+    return stats;
+}
+
 status_t NuPlayer::Renderer::openAudioSink(
         const sp<AMessage> &format,
         bool offloadOnly,
@@ -567,20 +586,33 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
             sp<AMessage> meta;
             CHECK(msg->findMessage("meta", &meta));
 
-            if (queueGeneration != getQueueGeneration(true /* audio */)
-                    || mAudioQueue.empty()) {
+            if (queueGeneration != getQueueGeneration(true /* audio */)) {
                 onChangeAudioFormat(meta, notify);
                 break;
             }
 
-            QueueEntry entry;
-            entry.mNotifyConsumed = notify;
-            entry.mMeta = meta;
+            {
+                Mutex::Autolock autoLock(mLock);
+                if (!mAudioQueue.empty() || deferAudioSinkOpen_l(meta)) {
+                    QueueEntry entry;
+                    entry.mNotifyConsumed = notify;
+                    entry.mMeta = meta;
+
+                    mAudioQueue.push_back(entry);
+                    postDrainAudioQueue_l();
+                    break;
+                }
+            }
 
-            Mutex::Autolock autoLock(mLock);
-            mAudioQueue.push_back(entry);
-            postDrainAudioQueue_l();
+            onChangeAudioFormat(meta, notify);
+            break;
+        }
 
+        case kWhatOpenDeferredAudioSink:
+        {
+            Mutex::Autolock autoLock(mLock);
+            ALOGV_IF(mAudioSinkOpenDeferred, "no video frame yet, opening audio sink");
+            openDeferredAudioSink_l();
             break;
         }
 
@@ -590,10 +622,12 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
 
             int32_t generation;
             CHECK(msg->findInt32("drainGeneration", &generation));
-            if (generation != getDrainGeneration(true /* audio */)) {
+            if (generation != getDrainGeneration(true /* audio */)
+                    || mAudioSinkOpenDeferred) {
                 break;
             }
 
+            ++mAudioDrainWakeups;
             if (onDrainAudioQueue()) {
                 uint32_t numFramesPlayed;
                 CHECK_EQ(mAudioSink->getPosition(&numFramesPlayed),
@@ -613,9 +647,15 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
                     delayUs /= mPlaybackRate;
                 }
 
-                // Let's give it more data after about half that time
-                // has elapsed.
-                delayUs /= 2;
+                if (mAudioBurstMode) {
+                    // Sleep until the sink is down to its low watermark, and write what the
+                    // decoder has delivered meanwhile in one go.
+                    delayUs = std::max(delayUs - kAudioBurstLowWatermarkUs, (int64_t)0);
+                } else {
+                    // Let's give it more data after about half that time
+                    // has elapsed.
+                    delayUs /= 2;
+                }
                 // check the buffer size to estimate maximum delay permitted.
                 const int64_t maxDrainDelayUs = std::max(
                         mAudioSink->getBufferDurationInUs(), (int64_t)500000 /* half second */);
@@ -827,7 +867,7 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
 }
 
 void NuPlayer::Renderer::postDrainAudioQueue_l(int64_t delayUs) {
-    if (mDrainAudioQueuePending || mSyncQueues || mUseAudioCallback) {
+    if (mDrainAudioQueuePending || mSyncQueues || mUseAudioCallback || mAudioSinkOpenDeferred) {
         return;
     }
 
@@ -849,6 +889,19 @@ void NuPlayer::Renderer::postDrainAudioQueue_l(int64_t delayUs) {
     msg->post(delayUs);
 }
 
+// Rather than waking up for every buffer from the decoder, let them collect while the sink
+// still has enough to play.
+int64_t NuPlayer::Renderer::getAudioBurstDelayUs() {
+    if (!mAudioBurstMode || mPaused || mDrainAudioQueuePending) {
+        return 0;
+    }
+    int64_t pendingUs = getPendingAudioPlayoutDurationUs(ALooper::GetNowUs());
+    if (mPlaybackRate > 1.0f) {
+        pendingUs /= mPlaybackRate;
+    }
+    return std::max(pendingUs - kAudioBurstLowWatermarkUs, (int64_t)0);
+}
+
 void NuPlayer::Renderer::prepareForMediaRenderingStart_l() {
     mAudioRenderingStartGeneration = mAudioDrainGeneration;
     mVideoRenderingStartGeneration = mVideoDrainGeneration;
@@ -1437,6 +1490,10 @@ void NuPlayer::Renderer::onDrainVideoQueue() {
     if (!mVideoSampleReceived) {
         realTimeUs = nowUs;
         tooLate = false;
+
+        sp<AMessage> notify = mNotify->dup();
+        notify->setInt32("what", kWhatFirstVideoFrame);
+        notify->post();
     }
 
     entry->mNotifyConsumed->setInt64("timestampNs", realTimeUs * 1000LL);
@@ -1447,6 +1504,11 @@ void NuPlayer::Renderer::onDrainVideoQueue() {
 
     mVideoSampleReceived = true;
 
+    if (mAudioSinkOpenDeferred) {
+        Mutex::Autolock autoLock(mLock);
+        openDeferredAudioSink_l();
+    }
+
     if (!mPaused) {
         if (!mVideoRenderingStarted) {
             mVideoRenderingStarted = true;
@@ -1545,9 +1607,10 @@ void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
     entry.mBufferOrdinal = ++mTotalBuffersQueued;
 
     if (audio) {
+        int64_t delayUs = getAudioBurstDelayUs();
         Mutex::Autolock autoLock(mLock);
         mAudioQueue.push_back(entry);
-        postDrainAudioQueue_l();
+        postDrainAudioQueue_l(delayUs);
     } else {
         mVideoQueue.push_back(entry);
         postDrainVideoQueue();
@@ -1679,6 +1742,8 @@ void NuPlayer::Renderer::onFlush(const sp<AMessage> &msg) {
     if (audio) {
         {
             Mutex::Autolock autoLock(mLock);
+            // the deferred format change is applied by the flush.
+            mAudioSinkOpenDeferred = false;
             flushQueue(&mAudioQueue);
 
             ++mAudioDrainGeneration;
@@ -2017,6 +2082,7 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
             offloadFlags &= ~AUDIO_OUTPUT_FLAG_DEEP_BUFFER;
             audioSinkChanged = true;
             mAudioSink->close();
+            mAudioBurstMode = false;
 
             err = mAudioSink->open(
                     sampleRate,
@@ -2081,6 +2147,7 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
 
         audioSinkChanged = true;
         mAudioSink->close();
+        mAudioBurstMode = false;
         mCurrentOffloadInfo = AUDIO_INFO_INITIALIZER;
         // Note: It is possible to set up the callback, but not use it to send audio data.
         // This requires a fix in AudioSink to explicitly specify the transfer mode.
@@ -2123,6 +2190,10 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
             return err;
         }
         mCurrentPcmInfo = info;
+        // Bursts only pay off with a deep buffer, and video needs a steadily updated clock.
+        mAudioBurstMode = getAudioBurstSetting() && !mUseAudioCallback && !hasVideo
+                && (pcmFlags & AUDIO_OUTPUT_FLAG_DEEP_BUFFER) != 0;
+        ALOGV_IF(mAudioBurstMode, "openAudioSink: writing in bursts");
         if (!mPaused) { // for preview mode, don't start if paused
             mAudioSink->start();
         }
@@ -2136,6 +2207,7 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
 
 void NuPlayer::Renderer::onCloseAudioSink() {
     mAudioSink->close();
+    mAudioBurstMode = false;
     mCurrentOffloadInfo = AUDIO_INFO_INITIALIZER;
     mCurrentPcmInfo = AUDIO_PCMINFO_INITIALIZER;
 }
@@ -2165,4 +2237,32 @@ void NuPlayer::Renderer::onChangeAudioFormat(
     notify->post();
 }
 
+// Holds the first audio format change, and the audio queued behind it, until the first
+// video frame is rendered, so that opening the audio sink does not delay it.
+bool NuPlayer::Renderer::deferAudioSinkOpen_l(const sp<AMessage> &meta) {
+    if (!(mFlags & FLAG_FAST_START) || mVideoSampleReceived) {
+        return false;
+    }
+    // only the initial open is deferred
+    mFlags &= ~FLAG_FAST_START;
+
+    int32_t hasVideo;
+    if (!meta->findInt32("has-video", &hasVideo) || !hasVideo) {
+        return false;
+    }
+
+    ALOGV("deferring audio sink open until the first video frame");
+    mAudioSinkOpenDeferred = true;
+    (new AMessage(kWhatOpenDeferredAudioSink, this))->post(kFastStartAudioSinkDelayUs);
+    return true;
+}
+
+void NuPlayer::Renderer::openDeferredAudioSink_l() {
+    if (!mAudioSinkOpenDeferred) {
+        return;
+    }
+    mAudioSinkOpenDeferred = false;
+    postDrainAudioQueue_l();
+}
+
 }  // namespace android
@@ -21,6 +21,9 @@
 #include "NuPlayer.h"
 #include "NuPlayerSource.h"
 
+#include <list>
+#include <vector>
+
 #include <android-base/unique_fd.h>
 #include <media/mediaplayer.h>
 #include <media/stagefright/MediaBuffer.h>
@@ -88,6 +91,8 @@ struct NuPlayer::GenericSource : public NuPlayer::Source,
 
     virtual bool isStreaming() const;
 
+    virtual sp<AMessage> getStats() const;
+
     // Modular DRM
     virtual void signalBufferReturned(MediaBufferBase *buffer);
 
@@ -137,6 +142,33 @@ private:
     Track mSubtitleTrack;
     Track mTimedTextTrack;
 
+    // Read-ahead state of the audio or video track of a local source.
+    struct Prefetch {
+        Prefetch() : mPeakReadLatencyUs(0), mUnderruns(0), mStarved(false) {}
+        int64_t mPeakReadLatencyUs;  // decaying peak of the time taken by a read
+        int32_t mUnderruns;          // times the decoder found no data while started
+        bool mStarved;
+    };
+    Prefetch mAudioPrefetch;
+    Prefetch mVideoPrefetch;
+
+    // Encoded video of a group of pictures, from a sync sample up to the next one.
+    struct SeekCacheSegment {
+        SeekCacheSegment() : mSyncTimeUs(-1), mNextSyncTimeUs(-1), mBytes(0) {}
+        int64_t mSyncTimeUs;
+        int64_t mNextSyncTimeUs;
+        size_t mBytes;
+        std::vector<sp<ABuffer>> mBuffers;  // in decoding order
+    };
+    // Opt-in cache of the segments read most recently, most recently used first. An accurate
+    // seek into one of them queues it from memory, and reading resumes at the next sync
+    // sample, so scrubbing within recent content does not read it from the extractor again.
+    size_t mSeekCacheLimitBytes;  // 0 if disabled
+    size_t mSeekCacheBytes;
+    std::list<SeekCacheSegment> mSeekCache;
+    SeekCacheSegment mSeekCacheFill;  // segment being read
+    int64_t mVideoResumeAtUs;         // sync sample to read from after a cached seek, or -1
+
     BufferingSettings mBufferingSettings;
     int32_t mPrevBufferPercentage;
     int32_t mPollBufferingGeneration;
@@ -224,6 +256,13 @@ private:
     void queueDiscontinuityIfNeeded(
             bool seeking, bool formatChange, media_track_type trackType, Track *track);
 
+    bool needsPrefetch_l(bool audio) const;
+    void updateReadLatency_l(bool audio, int64_t latencyUs);
+
+    void addToSeekCache_l(const sp<ABuffer> &buffer, bool isSync, bool discontinuity);
+    bool seekFromCache_l(int64_t seekTimeUs, int64_t *actualTimeUs);
+    void clearSeekCache_l();
+
     void schedulePollBuffering();
     void onPollBuffering();
     void notifyBufferingUpdate(int32_t percentage);
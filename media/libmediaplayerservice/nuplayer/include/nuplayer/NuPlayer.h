@@ -102,6 +102,8 @@ struct NuPlayer : public AHandler {
 
     void updateInternalTimers();
 
+    bool isFastStartEnabled() const;
+
     void setTargetBitrate(int bitrate /* bps */);
 
 protected:
@@ -163,6 +165,7 @@ private:
         kWhatPrepareDrm                 = 'pDrm',
         kWhatReleaseDrm                 = 'rDrm',
         kWhatMediaClockNotify           = 'mckN',
+        kWhatScrubSettled               = 'scrS',
     };
 
     wp<NuPlayerDriver> mDriver;
@@ -241,6 +244,18 @@ private:
     bool mPrepared;
     bool mResetting;
     bool mSourceStarted;
+    // decoders are instantiated once prepared, and the first video frame is shown
+    // before the audio sink is opened.
+    const bool mFastStart;
+    // accurate seeks in quick succession, as from dragging a seek bar, only go to the closest
+    // sync frame, and the last one is repeated accurately once they stop.
+    const bool mScrubPreview;
+    int64_t mLastSeekRequestUs;
+    int32_t mScrubGeneration;
+    // time the seek in progress was requested, until its first video frame, or -1
+    int64_t mSeekStartUs;
+    bool mSeekFlushPending;  // the renderer has not been flushed for it yet
+    bool mSeekIsPreview;
     bool mAudioDecoderError;
     bool mVideoDecoderError;
 
@@ -258,6 +273,7 @@ private:
     // Modular DRM
     sp<ICrypto> mCrypto;
     bool mIsDrmProtected;
+    bool mSourceHasDrmInfo;
 
     typedef enum {
         DATA_SOURCE_TYPE_NONE,
@@ -294,6 +310,7 @@ private:
             bool audio, sp<DecoderBase> *decoder, bool checkAudioModeChange = true);
 
     status_t onInstantiateSecureDecoders();
+    void instantiateDecodersForFastStart();
 
     void updateVideoSize(
             const sp<AMessage> &inputFormat,
@@ -325,6 +342,7 @@ private:
     void processDeferredActions();
 
     void performSeek(int64_t seekTimeUs, MediaPlayerSeekMode mode);
+    MediaPlayerSeekMode getScrubSeekMode(int64_t seekTimeUs, MediaPlayerSeekMode mode);
     void performDecoderFlush(FlushCommand audio, FlushCommand video);
     void performReset();
     void performScanSources();
@@ -88,6 +88,7 @@ struct NuPlayerDriver : public MediaPlayerInterface {
     void notifyMorePlayingTimeUs(int64_t timeUs);
     void notifyMoreRebufferingTimeUs(int64_t timeUs);
     void notifyRebufferingWhenExit(bool status);
+    void notifySeekLatencyUs(int64_t latencyUs, bool preview);
     void notifySeekComplete();
     void notifySeekComplete_l();
     void notifyListener(int msg, int ext1 = 0, int ext2 = 0, const Parcel *in = NULL);
@@ -135,6 +136,16 @@ private:
     int64_t mRebufferingTimeUs;
     int32_t mRebufferingEvents;
     bool mRebufferingAtExit;
+    int64_t mStartRequestTimeUs;
+    int64_t mTimeToFirstFrameUs;
+    int64_t mPrepareRequestTimeUs;
+    int64_t mTimeToPreparedUs;
+    int64_t mPrepareToFirstFrameUs;
+    // seek request to the first video frame after it
+    int32_t mSeekCount;
+    int32_t mPreviewSeekCount;
+    int64_t mSeekLatencySumUs;
+    int64_t mSeekLatencyMaxUs;
     // <<<
 
     sp<ALooper> mLooper;
@@ -36,6 +36,8 @@ struct NuPlayer::Renderer : public AHandler {
     enum Flags {
         FLAG_REAL_TIME = 1,
         FLAG_OFFLOAD_AUDIO = 2,
+        // Render the first video frame before opening the audio sink.
+        FLAG_FAST_START = 4,
     };
     Renderer(const sp<MediaPlayerBase::AudioSink> &sink,
              const sp<MediaClock> &mediaClock,
@@ -73,6 +75,7 @@ struct NuPlayer::Renderer : public AHandler {
 
     status_t getCurrentPosition(int64_t *mediaUs);
     int64_t getVideoLateByUs();
+    sp<AMessage> getStats();
 
     status_t openAudioSink(
             const sp<AMessage> &format,
@@ -98,6 +101,7 @@ struct NuPlayer::Renderer : public AHandler {
         kWhatPosition                 = 'posi',
         kWhatVideoRenderingStart      = 'vdrd',
         kWhatMediaRenderingStart      = 'mdrd',
+        kWhatFirstVideoFrame          = 'vdff',  // first video frame after start or a flush
         kWhatAudioTearDown            = 'adTD',
         kWhatAudioOffloadPauseTimeout = 'aOPT',
         kWhatReleaseWakeLock          = 'adRL',
@@ -135,6 +139,7 @@ private:
         kWhatDisableOffloadAudio = 'noOA',
         kWhatEnableOffloadAudio  = 'enOA',
         kWhatSetVideoFrameRate   = 'sVFR',
+        kWhatOpenDeferredAudioSink = 'opDA',
     };
 
     // if mBuffer != nullptr, it's a buffer containing real data.
@@ -195,6 +200,8 @@ private:
 
     bool mVideoSampleReceived;
     bool mVideoRenderingStarted;
+    // the audio queue is held behind its first format change until the first video frame.
+    bool mAudioSinkOpenDeferred;
     int32_t mVideoRenderingStartGeneration;
     int32_t mAudioRenderingStartGeneration;
     bool mRenderingDataDelivered;
@@ -220,6 +227,9 @@ private:
     int32_t mTotalBuffersQueued;
     int32_t mLastAudioBufferDrained;
     bool mUseAudioCallback;
+    // PCM is written to a deep buffer sink in bursts, sleeping in between.
+    bool mAudioBurstMode;
+    std::atomic<int64_t> mAudioDrainWakeups{0};
 
     sp<AWakeLock> mWakeLock;
 
@@ -242,6 +252,7 @@ private:
     void drainAudioQueueUntilLastEOS();
     int64_t getPendingAudioPlayoutDurationUs(int64_t nowUs);
     void postDrainAudioQueue_l(int64_t delayUs = 0);
+    int64_t getAudioBurstDelayUs();
 
     void clearAnchorTime();
     void clearAudioFirstAnchorTime_l();
@@ -283,6 +294,8 @@ private:
             bool isStreaming);
     void onCloseAudioSink();
     void onChangeAudioFormat(const sp<AMessage> &meta, const sp<AMessage> &notify);
+    bool deferAudioSinkOpen_l(const sp<AMessage> &meta);
+    void openDeferredAudioSink_l();
 
     void notifyEOS(bool audio, status_t finalResult, int64_t delayUs = 0);
     void notifyEOS_l(bool audio, status_t finalResult, int64_t delayUs = 0);
@@ -130,6 +130,11 @@ struct NuPlayer::Source : public AHandler {
         return true;
     }
 
+    // Read-ahead statistics of the source, if it keeps any.
+    virtual sp<AMessage> getStats() const {
+        return NULL;
+    }
+
     virtual void setOffloadAudio(bool /* offload */) {}
 
     virtual void setTargetBitrate(int32_t) {}
@@ -90,6 +90,31 @@ static std::shared_ptr<AMediaFormat> getVideoFormat(
     return format;
 }
 
+// Encoder operating rates used under thermal throttling, in frames per second. The default
+// operating rate lets the encoder run well above real time, so under throttling we ask it to
+// run at a small multiple of (or at) real time instead of pausing altogether.
+static constexpr int32_t kReducedOperatingRate = 60;
+static constexpr int32_t kMinimalOperatingRate = 30;
+// Lowest (non-realtime) codec priority.
+static constexpr int32_t kThrottledCodecPriority = 1;
+
+static void applyThrottlingLevel(AMediaFormat* format, ThermalThrottlingLevel level) {
+    int32_t operatingRate;
+    switch (level) {
+    case ThermalThrottlingLevel::kReduced:
+        operatingRate = kReducedOperatingRate;
+        break;
+    case ThermalThrottlingLevel::kMinimal:
+        operatingRate = kMinimalOperatingRate;
+        break;
+    default:
+        return;
+    }
+    ALOGI("Throttling level %d, using operating rate %d", (int32_t)level, operatingRate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_OPERATING_RATE, operatingRate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_PRIORITY, kThrottledCodecPriority);
+}
+
 //static
 std::string TranscoderWrapper::toString(const Event& event) {
     std::string typeStr;
@@ -189,6 +214,7 @@ TranscoderWrapper::TranscoderWrapper(const std::shared_ptr<TranscoderCallbackInt
         mHeartBeatIntervalUs(heartBeatIntervalUs),
         mCurrentClientId(0),
         mCurrentSessionId(-1),
+        mThrottlingLevel(ThermalThrottlingLevel::kNone),
         mLooperReady(false) {
     ALOGV("TranscoderWrapper CTOR: %p", this);
 }
@@ -275,6 +301,10 @@ void TranscoderWrapper::resume(ClientIdType clientId, SessionIdType sessionId,
     });
 }
 
+void TranscoderWrapper::setThrottlingLevel(ThermalThrottlingLevel level) {
+    mThrottlingLevel = level;
+}
+
 void TranscoderWrapper::stop(ClientIdType clientId, SessionIdType sessionId, bool abandon) {
     queueEvent(Event::Stop, clientId, sessionId, [=] {
         if (mTranscoder != nullptr && clientId == mCurrentClientId &&
@@ -443,6 +473,9 @@ media_status_t TranscoderWrapper::setupTranscoder(
 
         if (!strncmp(mime, "video/", 6)) {
             format = getVideoFormat(mime, request.requestedVideoTrackFormat);
+            if (format != nullptr) {
+                applyThrottlingLevel(format.get(), mThrottlingLevel);
+            }
 
             mSrcFormat = trackFormats[i];
             mDstFormat = format;
@@ -22,6 +22,7 @@
 #include <statslog_media.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -156,6 +157,27 @@ void TranscodingLogger::logSessionEnded(const std::chrono::steady_clock::time_po
                             srcDurationMs, srcIsHdr, dstWidth, dstHeight, dstMime, dstIsHdr);
 }
 
+void TranscodingLogger::logSessionScheduled(uid_t callingUid,
+                                            std::chrono::microseconds waitingTime,
+                                            std::chrono::microseconds runningTime,
+                                            std::chrono::microseconds pausedTime) {
+    ALOGI("Session scheduled: uid %d, waiting %lldms, running %lldms, paused %lldms", callingUid,
+          (long long)waitingTime.count() / 1000, (long long)runningTime.count() / 1000,
+          (long long)pausedTime.count() / 1000);
+
+    std::scoped_lock lock{mLock};
+    mSchedulingStats.sessionCount++;
+    mSchedulingStats.totalWaitingTime += waitingTime;
+    mSchedulingStats.maxWaitingTime = std::max(mSchedulingStats.maxWaitingTime, waitingTime);
+    mSchedulingStats.totalRunningTime += runningTime;
+    mSchedulingStats.totalPausedTime += pausedTime;
+}
+
+TranscodingLogger::SchedulingStats TranscodingLogger::getSchedulingStats() {
+    std::scoped_lock lock{mLock};
+    return mSchedulingStats;
+}
+
 bool TranscodingLogger::shouldLogAtom(const std::chrono::steady_clock::time_point& now,
                                       int status) {
     std::scoped_lock lock{mLock};
@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -330,26 +331,31 @@ TranscodingSessionController::TranscodingSessionController(
         const std::shared_ptr<UidPolicyInterface>& uidPolicy,
         const std::shared_ptr<ResourcePolicyInterface>& resourcePolicy,
         const std::shared_ptr<ThermalPolicyInterface>& thermalPolicy,
-        const ControllerConfig* config)
+        const ControllerConfig* config, const std::shared_ptr<TranscodingLogger>& logger)
       : mTranscoderFactory(transcoderFactory),
         mUidPolicy(uidPolicy),
         mResourcePolicy(resourcePolicy),
         mThermalPolicy(thermalPolicy),
-        mCurrentSession(nullptr),
+        mLogger(logger),
         mResourceLost(false) {
     // Only push empty offline queue initially. Realtime queues are added when requests come in.
     mUidSortedList.push_back(OFFLINE_UID);
     mOfflineUidIterator = mUidSortedList.begin();
     mSessionQueues.emplace(OFFLINE_UID, SessionQueueType());
     mUidPackageNames[OFFLINE_UID] = "(offline)";
-    mThermalThrottling = thermalPolicy->getThrottlingStatus();
+    mThrottlingLevel = thermalPolicy->getThrottlingLevel();
     if (config != nullptr) {
         mConfig = *config;
     }
+    if (mConfig.maxConcurrentSessions < 1) {
+        mConfig.maxConcurrentSessions = 1;
+    }
+    mResourceCapacity = mConfig.maxConcurrentSessions;
     mPacer.reset(new Pacer(mConfig));
-    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d",
+    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d, concurrency %d",
           (long long)mConfig.watchdogTimeoutUs, mConfig.pacerBurstCountQuota,
-          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs);
+          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs,
+          mConfig.maxConcurrentSessions);
 }
 
 TranscodingSessionController::~TranscodingSessionController() {}
@@ -389,6 +395,9 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
     result.append(buffer);
     snprintf(buffer, SIZE, "  Total num of Sessions: %zu\n", mSessionMap.size());
     result.append(buffer);
+    snprintf(buffer, SIZE, "  Session capacity: %d (max %d), thermal throttling level: %d\n",
+             getSessionCapacity_l(), mConfig.maxConcurrentSessions, (int32_t)mThrottlingLevel);
+    result.append(buffer);
 
     std::vector<int32_t> uids(mUidSortedList.begin(), mUidSortedList.end());
 
@@ -421,35 +430,104 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
         dumpSession_l(session, result, true /*closedSession*/);
     }
 
+    if (mLogger != nullptr) {
+        TranscodingLogger::SchedulingStats stats = mLogger->getSchedulingStats();
+        snprintf(buffer, SIZE, "\n========== Dumping scheduling stats =========\n");
+        result.append(buffer);
+        snprintf(buffer, SIZE,
+                 "  sessions: %lld, waiting: %.1fs (max %.1fs), running: %.1fs, paused: %.1fs\n",
+                 (long long)stats.sessionCount, stats.totalWaitingTime.count() / 1000000.0f,
+                 stats.maxWaitingTime.count() / 1000000.0f,
+                 stats.totalRunningTime.count() / 1000000.0f,
+                 stats.totalPausedTime.count() / 1000000.0f);
+        result.append(buffer);
+    }
+
     write(fd, result.string(), result.size());
 }
 
 /*
- * Returns nullptr if there is no session, or we're paused globally (due to resource lost,
- * thermal throttling, etc.). Otherwise, return the session that should be run next.
+ * Returns the number of sessions that may run at the same time. This is 0 if we're paused
+ * globally (due to resource lost, thermal throttling, etc.). Milder thermal throttling levels
+ * reduce the concurrency instead of pausing everything.
  */
-TranscodingSessionController::Session* TranscodingSessionController::getTopSession_l() {
-    if (mSessionMap.empty()) {
-        return nullptr;
+int32_t TranscodingSessionController::getSessionCapacity_l() {
+    if (((mResourcePolicy != nullptr && mResourceLost) ||
+         (mThermalPolicy != nullptr && mThrottlingLevel == ThermalThrottlingLevel::kPaused))) {
+        return 0;
+    }
+    int32_t capacity = std::min(mConfig.maxConcurrentSessions, mResourceCapacity);
+    if (mThermalPolicy != nullptr) {
+        if (mThrottlingLevel == ThermalThrottlingLevel::kMinimal) {
+            capacity = std::min(capacity, 1);
+        } else if (mThrottlingLevel == ThermalThrottlingLevel::kReduced) {
+            capacity = (capacity + 1) / 2;
+        }
     }
+    return capacity;
+}
 
-    // Return nullptr if we're paused globally due to resource lost or thermal throttling.
-    if (((mResourcePolicy != nullptr && mResourceLost) ||
-         (mThermalPolicy != nullptr && mThermalThrottling))) {
-        return nullptr;
+/*
+ * Fills topSessions with the sessions that should be running, in priority order, each
+ * paired with the index of the transcoder to run it on. The list is empty if there is
+ * no session, or we're paused globally.
+ */
+void TranscodingSessionController::getTopSessions_l(
+        std::vector<std::pair<Session*, int32_t>>* topSessions) {
+    topSessions->clear();
+
+    const size_t capacity = getSessionCapacity_l();
+    if (mSessionMap.empty() || capacity == 0) {
+        return;
     }
 
-    uid_t topUid = *mUidSortedList.begin();
-    // If the current session is running, and it's in the topUid's queue, let it continue
-    // to run even if it's not the earliest in that uid's queue.
-    // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
-    // B is brought to front which caused the session to run, then user switches back to A.
-    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING &&
-        mCurrentSession->allClientUids.count(topUid) > 0) {
-        return mCurrentSession;
+    std::vector<bool> transcoderTaken(mConfig.maxConcurrentSessions, false);
+    auto isPicked = [topSessions](const Session* session) {
+        return std::find_if(topSessions->begin(), topSessions->end(), [session](const auto& p) {
+                   return p.first == session;
+               }) != topSessions->end();
+    };
+
+    // Walk the uids from the most-recently-top one. Within a uid's queue, sessions that are
+    // already running go first, so that they continue to run even if they're not the earliest
+    // in that uid's queue. For example, uid(B) is added to a session while it's pending in
+    // uid(A)'s queue, then B is brought to front which caused the session to run, then user
+    // switches back to A.
+    for (auto uidIt = mUidSortedList.begin();
+         uidIt != mUidSortedList.end() && topSessions->size() < capacity; ++uidIt) {
+        for (bool runningPass : {true, false}) {
+            for (const SessionKeyType& sessionKey : mSessionQueues[*uidIt]) {
+                if (topSessions->size() >= capacity) {
+                    break;
+                }
+                Session* session = &mSessionMap[sessionKey];
+                if (session->isRunning() != runningPass || isPicked(session)) {
+                    continue;
+                }
+                // A started session can only continue on its own transcoder, skip it if a
+                // higher-priority session already took that transcoder.
+                int32_t index = session->transcoderIndex;
+                if (index >= 0) {
+                    if (transcoderTaken[index]) {
+                        continue;
+                    }
+                    transcoderTaken[index] = true;
+                }
+                topSessions->emplace_back(session, index);
+            }
+        }
+    }
+
+    // New sessions take the transcoders left over by the started ones. There are always
+    // enough of them, as no more than maxConcurrentSessions sessions are picked.
+    auto freeIt = transcoderTaken.begin();
+    for (auto& [session, index] : *topSessions) {
+        if (index < 0) {
+            freeIt = std::find(freeIt, transcoderTaken.end(), false);
+            *freeIt = true;
+            index = freeIt - transcoderTaken.begin();
+        }
     }
-    SessionKeyType topSessionKey = *mSessionQueues[topUid].begin();
-    return &mSessionMap[topSessionKey];
 }
 
 void TranscodingSessionController::setSessionState_l(Session* session, Session::State state) {
@@ -461,14 +539,13 @@ void TranscodingSessionController::setSessionState_l(Session* session, Session::
         return;
     }
 
-    // Currently we only have 1 running session, and we always put the previous
-    // session in non-running state before we run the new session, so it's okay
-    // to start/stop the watchdog here. If this assumption changes, we need to
-    // track the number of running sessions and start/stop watchdog based on that.
+    // Each transcoder runs at most 1 session, and we always put the previous session
+    // on a transcoder in non-running state before we run a new session on it, so it's
+    // okay to start/stop that transcoder's watchdog here.
     if (isRunning) {
-        mWatchdog->start(session->key);
+        mWatchdogs[session->transcoderIndex]->start(session->key);
     } else {
-        mWatchdog->stop();
+        mWatchdogs[session->transcoderIndex]->stop();
     }
 }
 
@@ -501,72 +578,82 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
-void TranscodingSessionController::updateCurrentSession_l() {
-    Session* curSession = mCurrentSession;
-    Session* topSession = nullptr;
-
-    // Delayed init of transcoder and watchdog.
-    if (mTranscoder == nullptr) {
-        mTranscoder = mTranscoderFactory(shared_from_this());
-        mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
-    }
-
-    // If we found a different top session, or the top session's running state is not
-    // correct. Take some actions to ensure it's correct.
-    while ((topSession = getTopSession_l()) != curSession ||
-           (topSession != nullptr && !topSession->isRunning())) {
-        ALOGV("updateCurrentSession_l: topSession is %s, curSession is %s",
-              topSession == nullptr ? "null" : sessionToString(topSession->key).c_str(),
-              curSession == nullptr ? "null" : sessionToString(curSession->key).c_str());
-
-        // If current session is running, pause it first. Note this is needed for either
-        // cases: 1) Top session is changing to another session, or 2) Top session is
-        // changing to null (which means we should be globally paused).
-        if (curSession != nullptr && curSession->getState() == Session::RUNNING) {
-            mTranscoder->pause(curSession->key.first, curSession->key.second);
-            setSessionState_l(curSession, Session::PAUSED);
+void TranscodingSessionController::updateRunningSessions_l() {
+    // Delayed init of transcoders and watchdogs.
+    if (mTranscoders.empty()) {
+        for (int32_t i = 0; i < mConfig.maxConcurrentSessions; i++) {
+            mTranscoders.push_back(mTranscoderFactory(shared_from_this()));
+            mTranscoders.back()->setThrottlingLevel(mThrottlingLevel);
+            mWatchdogs.push_back(std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs));
         }
+    }
 
-        if (topSession == nullptr) {
-            // Nothing more to run (either no session or globally paused).
-            break;
+    std::vector<std::pair<Session*, int32_t>> topSessions;
+    bool sessionDropped;
+    do {
+        sessionDropped = false;
+        getTopSessions_l(&topSessions);
+
+        // Pause the running sessions that are no longer among the top sessions first. This
+        // is needed for either cases: 1) A higher-priority session is preempting it, or 2) The
+        // capacity is reduced (to 0 if we should be globally paused). It also frees up the
+        // transcoders before new sessions are started on them.
+        for (auto& sessionPair : mSessionMap) {
+            Session* session = &sessionPair.second;
+            if (session->getState() != Session::RUNNING ||
+                std::find_if(topSessions.begin(), topSessions.end(), [session](const auto& p) {
+                    return p.first == session;
+                }) != topSessions.end()) {
+                continue;
+            }
+            ALOGV("updateRunningSessions_l: pausing %s", sessionToString(session->key).c_str());
+            mTranscoders[session->transcoderIndex]->pause(session->key.first,
+                                                          session->key.second);
+            setSessionState_l(session, Session::PAUSED);
         }
 
-        // Otherwise, ensure topSession is running.
-        if (topSession->getState() == Session::NOT_STARTED) {
-            // Check if at least one client has quota to start the session.
-            bool keepForClient = false;
-            for (uid_t uid : topSession->allClientUids) {
-                if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
-                    keepForClient = true;
-                    // DO NOT break here, because book-keeping still needs to happen
-                    // for the other uids.
+        // Otherwise, ensure the top sessions are running.
+        for (auto& [topSession, transcoderIndex] : topSessions) {
+            if (topSession->getState() == Session::NOT_STARTED) {
+                // Check if at least one client has quota to start the session.
+                bool keepForClient = false;
+                for (uid_t uid : topSession->allClientUids) {
+                    if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
+                        keepForClient = true;
+                        // DO NOT break here, because book-keeping still needs to happen
+                        // for the other uids.
+                    }
                 }
-            }
-            if (!keepForClient) {
-                // Unfortunately all uids requesting this session are out of quota.
-                // Drop this session and try the next one.
-                {
-                    auto clientCallback = mSessionMap[topSession->key].callback.lock();
-                    if (clientCallback != nullptr) {
-                        clientCallback->onTranscodingFailed(
-                                topSession->key.second, TranscodingErrorCode::kDroppedByService);
+                if (!keepForClient) {
+                    // Unfortunately all uids requesting this session are out of quota.
+                    // Drop this session and pick the top sessions again.
+                    {
+                        auto clientCallback = topSession->callback.lock();
+                        if (clientCallback != nullptr) {
+                            clientCallback->onTranscodingFailed(
+                                    topSession->key.second,
+                                    TranscodingErrorCode::kDroppedByService);
+                        }
                     }
+                    removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
+                    sessionDropped = true;
+                    break;
                 }
-                removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
-                continue;
+                topSession->transcoderIndex = transcoderIndex;
+                mTranscoders[transcoderIndex]->start(topSession->key.first,
+                                                     topSession->key.second, topSession->request,
+                                                     topSession->callingUid,
+                                                     topSession->callback.lock());
+                setSessionState_l(topSession, Session::RUNNING);
+            } else if (topSession->getState() == Session::PAUSED) {
+                mTranscoders[transcoderIndex]->resume(topSession->key.first,
+                                                      topSession->key.second, topSession->request,
+                                                      topSession->callingUid,
+                                                      topSession->callback.lock());
+                setSessionState_l(topSession, Session::RUNNING);
             }
-            mTranscoder->start(topSession->key.first, topSession->key.second, topSession->request,
-                               topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
-        } else if (topSession->getState() == Session::PAUSED) {
-            mTranscoder->resume(topSession->key.first, topSession->key.second, topSession->request,
-                                topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
         }
-        break;
-    }
-    mCurrentSession = topSession;
+    } while (sessionDropped);
 }
 
 void TranscodingSessionController::addUidToSession_l(uid_t clientUid,
@@ -648,11 +735,6 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
-    // Clear current session.
-    if (mCurrentSession == &mSessionMap[sessionKey]) {
-        mCurrentSession = nullptr;
-    }
-
     setSessionState_l(&mSessionMap[sessionKey], finalState);
 
     // We can use onSessionCompleted() even for CANCELLED, because runningTime is
@@ -661,6 +743,12 @@ void TranscodingSessionController::removeSession_l(
         mPacer->onSessionCompleted(uid, mSessionMap[sessionKey].runningTime);
     }
 
+    if (mLogger != nullptr) {
+        const Session& session = mSessionMap[sessionKey];
+        mLogger->logSessionScheduled(session.callingUid, session.waitingTime, session.runningTime,
+                                     session.pausedTime);
+    }
+
     mSessionHistory.push_back(mSessionMap[sessionKey]);
     if (mSessionHistory.size() > kSessionHistoryMax) {
         mSessionHistory.erase(mSessionHistory.begin());
@@ -668,6 +756,11 @@ void TranscodingSessionController::removeSession_l(
 
     // Remove session from session map.
     mSessionMap.erase(sessionKey);
+
+    // Give the full capacity another try once the sessions that hit the resource limit are gone.
+    if (mSessionMap.empty()) {
+        mResourceCapacity = mConfig.maxConcurrentSessions;
+    }
 }
 
 /**
@@ -760,7 +853,7 @@ bool TranscodingSessionController::submit(
 
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -801,7 +894,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mTranscoders[mSessionMap[*it].transcoderIndex]->stop(it->first, it->second);
         }
 
         // Remove the session.
@@ -815,7 +908,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -840,7 +933,7 @@ bool TranscodingSessionController::addClientUid(ClientIdType clientId, SessionId
     mSessionMap[sessionKey].allClientUids.insert(clientUid);
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -949,7 +1042,7 @@ void TranscodingSessionController::onFinish(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::FINISHED);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -961,10 +1054,12 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         if (err == TranscodingErrorCode::kWatchdogTimeout) {
             // Abandon the transcoder, as its handler thread might be stuck in some call to
             // MediaTranscoder altogether, and may not be able to handle any new tasks.
-            mTranscoder->stop(clientId, sessionId, true /*abandon*/);
+            int32_t index = mSessionMap[sessionKey].transcoderIndex;
+            mTranscoders[index]->stop(clientId, sessionId, true /*abandon*/);
             // Clear the last ref count before we create new transcoder.
-            mTranscoder = nullptr;
-            mTranscoder = mTranscoderFactory(shared_from_this());
+            mTranscoders[index] = nullptr;
+            mTranscoders[index] = mTranscoderFactory(shared_from_this());
+            mTranscoders[index]->setThrottlingLevel(mThrottlingLevel);
         }
 
         {
@@ -978,7 +1073,7 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::ERROR);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -996,8 +1091,9 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
 }
 
 void TranscodingSessionController::onHeartBeat(ClientIdType clientId, SessionIdType sessionId) {
-    notifyClient(clientId, sessionId, "heart-beat",
-                 [=](const SessionKeyType& /*sessionKey*/) { mWatchdog->keepAlive(); });
+    notifyClient(clientId, sessionId, "heart-beat", [=](const SessionKeyType& sessionKey) {
+        mWatchdogs[mSessionMap[sessionKey].transcoderIndex]->keepAlive();
+    });
 }
 
 void TranscodingSessionController::onResourceLost(ClientIdType clientId, SessionIdType sessionId) {
@@ -1028,6 +1124,17 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
         }
         mResourceLost = true;
 
+        // If other sessions are still running, the codecs couldn't sustain this many
+        // sessions at once. Run one session less after resource comes back, and pause
+        // the remaining ones until then.
+        int32_t numRunning = std::count_if(mSessionMap.begin(), mSessionMap.end(),
+                                           [](auto& p) { return p.second.isRunning(); });
+        if (numRunning > 0) {
+            mResourceCapacity = std::min(mResourceCapacity, numRunning);
+            ALOGI("%s: lowering session capacity to %d", __FUNCTION__, mResourceCapacity);
+            updateRunningSessions_l();
+        }
+
         validateState_l();
     });
 }
@@ -1052,7 +1159,7 @@ void TranscodingSessionController::onTopUidsChanged(const std::unordered_set<uid
 
     moveUidsToTop_l(uids, true /*preserveTopUid*/);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1082,7 +1189,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mTranscoders[mSessionMap[*it].transcoderIndex]->stop(it->first, it->second);
         }
 
         {
@@ -1104,7 +1211,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1119,37 +1226,37 @@ void TranscodingSessionController::onResourceAvailable() {
     ALOGI("%s", __FUNCTION__);
 
     mResourceLost = false;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
 
 void TranscodingSessionController::onThrottlingStarted() {
-    std::scoped_lock lock{mLock};
-
-    if (mThermalThrottling) {
-        return;
-    }
-
-    ALOGI("%s", __FUNCTION__);
-
-    mThermalThrottling = true;
-    updateCurrentSession_l();
-
-    validateState_l();
+    onThrottlingLevelChanged(ThermalThrottlingLevel::kPaused);
 }
 
 void TranscodingSessionController::onThrottlingStopped() {
+    onThrottlingLevelChanged(ThermalThrottlingLevel::kNone);
+}
+
+void TranscodingSessionController::onThrottlingLevelChanged(ThermalThrottlingLevel level) {
     std::scoped_lock lock{mLock};
 
-    if (!mThermalThrottling) {
+    if (mThrottlingLevel == level) {
         return;
     }
 
-    ALOGI("%s", __FUNCTION__);
+    ALOGI("%s: %d -> %d", __FUNCTION__, (int32_t)mThrottlingLevel, (int32_t)level);
 
-    mThermalThrottling = false;
-    updateCurrentSession_l();
+    mThrottlingLevel = level;
+    // Sessions already running keep their codec settings, the new level applies to sessions
+    // started or resumed from now on.
+    for (auto& transcoder : mTranscoders) {
+        if (transcoder != nullptr) {
+            transcoder->setThrottlingLevel(level);
+        }
+    }
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -24,8 +24,17 @@
 
 namespace android {
 
-static bool needThrottling(AThermalStatus status) {
-    return (status >= ATHERMAL_STATUS_SEVERE);
+static ThermalThrottlingLevel getThrottlingLevelForStatus(AThermalStatus status) {
+    if (status >= ATHERMAL_STATUS_CRITICAL) {
+        return ThermalThrottlingLevel::kPaused;
+    }
+    if (status >= ATHERMAL_STATUS_SEVERE) {
+        return ThermalThrottlingLevel::kMinimal;
+    }
+    if (status >= ATHERMAL_STATUS_MODERATE) {
+        return ThermalThrottlingLevel::kReduced;
+    }
+    return ThermalThrottlingLevel::kNone;
 }
 
 //static
@@ -35,7 +44,9 @@ void TranscodingThermalPolicy::onStatusChange(void* data, AThermalStatus status)
 }
 
 TranscodingThermalPolicy::TranscodingThermalPolicy()
-      : mRegistered(false), mThermalManager(nullptr), mIsThrottling(false) {
+      : mRegistered(false),
+        mThermalManager(nullptr),
+        mThrottlingLevel(ThermalThrottlingLevel::kNone) {
     registerSelf();
 }
 
@@ -66,7 +77,8 @@ void TranscodingThermalPolicy::registerSelf() {
             return;
         }
 
-        mIsThrottling = needThrottling(AThermal_getCurrentThermalStatus(thermalManager));
+        mThrottlingLevel =
+                getThrottlingLevelForStatus(AThermal_getCurrentThermalStatus(thermalManager));
         mThermalManager = thermalManager;
     }
 
@@ -106,29 +118,31 @@ void TranscodingThermalPolicy::setCallback(
 
 bool TranscodingThermalPolicy::getThrottlingStatus() {
     std::scoped_lock lock{mRegisteredLock};
-    return mIsThrottling;
+    return mThrottlingLevel == ThermalThrottlingLevel::kPaused;
+}
+
+ThermalThrottlingLevel TranscodingThermalPolicy::getThrottlingLevel() {
+    std::scoped_lock lock{mRegisteredLock};
+    return mThrottlingLevel;
 }
 
 void TranscodingThermalPolicy::onStatusChange(AThermalStatus status) {
-    bool isThrottling = needThrottling(status);
+    ThermalThrottlingLevel level = getThrottlingLevelForStatus(status);
 
     {
         std::scoped_lock lock{mRegisteredLock};
-        if (isThrottling == mIsThrottling) {
+        if (level == mThrottlingLevel) {
             return;
         }
-        ALOGI("Transcoding thermal throttling changed: %d", isThrottling);
-        mIsThrottling = isThrottling;
+        ALOGI("Transcoding thermal throttling level changed: %d -> %d", (int32_t)mThrottlingLevel,
+              (int32_t)level);
+        mThrottlingLevel = level;
     }
 
     std::scoped_lock lock{mCallbackLock};
     std::shared_ptr<ThermalPolicyCallbackInterface> cb;
     if ((cb = mThermalPolicyCallback.lock()) != nullptr) {
-        if (isThrottling) {
-            cb->onThrottlingStarted();
-        } else {
-            cb->onThrottlingStopped();
-        }
+        cb->onThrottlingLevelChanged(level);
     }
 }
 }  // namespace android
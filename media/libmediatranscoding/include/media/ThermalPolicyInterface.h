@@ -16,12 +16,23 @@
 
 #ifndef ANDROID_MEDIA_THERMAL_POLICY_INTERFACE_H
 #define ANDROID_MEDIA_THERMAL_POLICY_INTERFACE_H
+#include <cstdint>
 #include <memory>
 
 namespace android {
 
 class ThermalPolicyCallbackInterface;
 
+// Graduated thermal throttling levels, in increasing order of severity. Sessions keep running
+// with less aggressive codec settings and lower concurrency up to kMinimal, and are only paused
+// at kPaused.
+enum class ThermalThrottlingLevel : int32_t {
+    kNone = 0,
+    kReduced = 1,
+    kMinimal = 2,
+    kPaused = 3,
+};
+
 // Interface for the SessionController to control the thermal policy.
 class ThermalPolicyInterface {
 public:
@@ -33,6 +44,9 @@ public:
     // false otherwise.
     virtual bool getThrottlingStatus() = 0;
 
+    // Get the current graduated thermal throttling level.
+    virtual ThermalThrottlingLevel getThrottlingLevel() = 0;
+
 protected:
     virtual ~ThermalPolicyInterface() = default;
 };
@@ -44,6 +58,10 @@ public:
     virtual void onThrottlingStarted() = 0;
     virtual void onThrottlingStopped() = 0;
 
+    // Called when the throttling level changes. Throttling is considered started when the
+    // level reaches kPaused, and stopped when it falls back to kNone.
+    virtual void onThrottlingLevelChanged(ThermalThrottlingLevel level) = 0;
+
 protected:
     virtual ~ThermalPolicyCallbackInterface() = default;
 };
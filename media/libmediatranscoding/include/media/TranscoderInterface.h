@@ -20,6 +20,7 @@
 #include <aidl/android/media/ITranscodingClientCallback.h>
 #include <aidl/android/media/TranscodingErrorCode.h>
 #include <aidl/android/media/TranscodingRequestParcel.h>
+#include <media/ThermalPolicyInterface.h>
 #include <media/TranscodingDefs.h>
 
 namespace android {
@@ -42,6 +43,9 @@ public:
     // Stop the specified session. If abandon is true, the transcoder wrapper will be discarded
     // after the session stops.
     virtual void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon = false) = 0;
+    // Set the thermal throttling level that sessions started or resumed from now on should
+    // observe. Transcoders that can't scale their codec settings down may ignore it.
+    virtual void setThrottlingLevel(ThermalThrottlingLevel /*level*/) {}
 
 protected:
     virtual ~TranscoderInterface() = default;
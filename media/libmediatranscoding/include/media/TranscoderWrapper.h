@@ -22,6 +22,7 @@
 #include <media/TranscoderInterface.h>
 #include <media/TranscodingLogger.h>
 
+#include <atomic>
 #include <chrono>
 #include <list>
 #include <map>
@@ -53,6 +54,7 @@ public:
                 const TranscodingRequestParcel& request, uid_t callingUid,
                 const std::shared_ptr<ITranscodingClientCallback>& clientCallback) override;
     void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon = false) override;
+    void setThrottlingLevel(ThermalThrottlingLevel level) override;
     // ~TranscoderInterface
 
 private:
@@ -91,6 +93,7 @@ private:
     ClientIdType mCurrentClientId;
     SessionIdType mCurrentSessionId;
     uid_t mCurrentCallingUid;
+    std::atomic<ThermalThrottlingLevel> mThrottlingLevel;
     std::chrono::steady_clock::time_point mTranscodeStartTime;
 
     // Whether the looper has been created.
@@ -70,6 +70,29 @@ public:
                          std::chrono::microseconds duration, AMediaFormat* srcFormat,
                          AMediaFormat* dstFormat);
 
+    /** Aggregated scheduling metrics of the sessions that left the session controller. */
+    struct SchedulingStats {
+        int64_t sessionCount = 0;
+        std::chrono::microseconds totalWaitingTime{0};
+        std::chrono::microseconds maxWaitingTime{0};
+        std::chrono::microseconds totalRunningTime{0};
+        std::chrono::microseconds totalPausedTime{0};
+    };
+
+    /**
+     * Logs the scheduling metrics of a transcoding session when it leaves the session controller.
+     * @param callingUid UID of the caller connecting to the transcoding service.
+     * @param waitingTime Time the session spent queued before it was started.
+     * @param runningTime Time the session spent running.
+     * @param pausedTime Time the session spent paused, e.g. preempted by another session.
+     */
+    void logSessionScheduled(uid_t callingUid, std::chrono::microseconds waitingTime,
+                             std::chrono::microseconds runningTime,
+                             std::chrono::microseconds pausedTime);
+
+    /** Returns the scheduling metrics aggregated from all logSessionScheduled calls. */
+    SchedulingStats getSchedulingStats();
+
 private:
     friend class TranscodingLoggerTest;
 
@@ -82,6 +105,7 @@ private:
     std::queue<std::pair<std::chrono::steady_clock::time_point, int>> mLastLoggedAtoms
             GUARDED_BY(mLock);
     uint32_t mSuccessfulCount = 0;
+    SchedulingStats mSchedulingStats GUARDED_BY(mLock);
     SessionEndedAtomWriter mSessionEndedAtomWriter;
 
     void logSessionEnded(const std::chrono::steady_clock::time_point& now,
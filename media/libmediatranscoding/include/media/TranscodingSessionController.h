@@ -22,6 +22,7 @@
 #include <media/ResourcePolicyInterface.h>
 #include <media/ThermalPolicyInterface.h>
 #include <media/TranscoderInterface.h>
+#include <media/TranscodingLogger.h>
 #include <media/TranscodingRequest.h>
 #include <media/UidPolicyInterface.h>
 #include <utils/String8.h>
@@ -32,6 +33,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace android {
 using ::aidl::android::media::TranscodingResultParcel;
@@ -83,7 +85,8 @@ public:
     // ThermalPolicyCallbackInterface
     void onThrottlingStarted() override;
     void onThrottlingStopped() override;
-    // ~ResourcePolicyCallbackInterface
+    void onThrottlingLevelChanged(ThermalThrottlingLevel level) override;
+    // ~ThermalPolicyCallbackInterface
 
     /**
      * Dump all the session information to the fd.
@@ -108,6 +111,9 @@ private:
         int32_t pacerBurstCountQuota = 10;
         // Maximum allowed back-to-back running time.
         int32_t pacerBurstTimeQuotaSeconds = 120;  // 2-min
+        // Maximum number of sessions allowed to run at the same time. Each concurrent
+        // session gets its own transcoder instance from the transcoder factory.
+        int32_t maxConcurrentSessions = 1;
     };
 
     struct Session {
@@ -128,6 +134,9 @@ private:
         std::unordered_set<uid_t> allClientUids;
         int32_t lastProgress = 0;
         int32_t pauseCount = 0;
+        // Index of the transcoder the session was started on, or -1 if never started.
+        // A started session stays on that transcoder as its paused state is kept there.
+        int32_t transcoderIndex = -1;
         std::chrono::time_point<std::chrono::steady_clock> stateEnterTime;
         std::chrono::microseconds waitingTime{0};
         std::chrono::microseconds runningTime{0};
@@ -166,16 +175,21 @@ private:
     std::map<uid_t, std::string> mUidPackageNames;
 
     TranscoderFactoryType mTranscoderFactory;
-    std::shared_ptr<TranscoderInterface> mTranscoder;
+    std::vector<std::shared_ptr<TranscoderInterface>> mTranscoders;
     std::shared_ptr<UidPolicyInterface> mUidPolicy;
     std::shared_ptr<ResourcePolicyInterface> mResourcePolicy;
     std::shared_ptr<ThermalPolicyInterface> mThermalPolicy;
 
-    Session* mCurrentSession;
+    std::shared_ptr<TranscodingLogger> mLogger;
+
     bool mResourceLost;
-    bool mThermalThrottling;
+    ThermalThrottlingLevel mThrottlingLevel;
+    // Number of concurrent sessions the codec resources were found to sustain. Lowered when
+    // resource is lost while several sessions are running, reset once all sessions are done.
+    int32_t mResourceCapacity;
     std::list<Session> mSessionHistory;
-    std::shared_ptr<Watchdog> mWatchdog;
+    // One watchdog per transcoder, as each transcoder runs at most one session at a time.
+    std::vector<std::shared_ptr<Watchdog>> mWatchdogs;
     std::shared_ptr<Pacer> mPacer;
 
     // Only allow MediaTranscodingService and unit tests to instantiate.
@@ -183,11 +197,13 @@ private:
                                  const std::shared_ptr<UidPolicyInterface>& uidPolicy,
                                  const std::shared_ptr<ResourcePolicyInterface>& resourcePolicy,
                                  const std::shared_ptr<ThermalPolicyInterface>& thermalPolicy,
-                                 const ControllerConfig* config = nullptr);
+                                 const ControllerConfig* config = nullptr,
+                                 const std::shared_ptr<TranscodingLogger>& logger = nullptr);
 
     void dumpSession_l(const Session& session, String8& result, bool closedSession = false);
-    Session* getTopSession_l();
-    void updateCurrentSession_l();
+    int32_t getSessionCapacity_l();
+    void getTopSessions_l(std::vector<std::pair<Session*, int32_t>>* topSessions);
+    void updateRunningSessions_l();
     void addUidToSession_l(uid_t uid, const SessionKeyType& sessionKey);
     void removeSession_l(const SessionKeyType& sessionKey, Session::State finalState,
                          const std::shared_ptr<std::function<bool(uid_t uid)>>& keepUid = nullptr);
@@ -32,6 +32,7 @@ public:
 
     void setCallback(const std::shared_ptr<ThermalPolicyCallbackInterface>& cb) override;
     bool getThrottlingStatus() override;
+    ThermalThrottlingLevel getThrottlingLevel() override;
 
 private:
     mutable std::mutex mRegisteredLock;
@@ -41,7 +42,7 @@ private:
     std::weak_ptr<ThermalPolicyCallbackInterface> mThermalPolicyCallback GUARDED_BY(mCallbackLock);
 
     AThermalManager* mThermalManager;
-    bool mIsThrottling;
+    ThermalThrottlingLevel mThrottlingLevel;
 
     static void onStatusChange(void* data, AThermalStatus status);
     void onStatusChange(AThermalStatus status);
@@ -283,4 +283,27 @@ TEST_F(TranscodingLoggerTest, TestAtomContentCorrectness) {
     validateLatestAtom(Reason::FINISHED, AMEDIA_OK);
 }
 
+TEST_F(TranscodingLoggerTest, TestSchedulingStats) {
+    ALOGD("TestSchedulingStats");
+    using std::chrono::microseconds;
+
+    TranscodingLogger::SchedulingStats stats = mLogger->getSchedulingStats();
+    EXPECT_EQ(stats.sessionCount, 0);
+
+    mLogger->logSessionScheduled(kDefaultCallingUid, microseconds{100}, microseconds{1000},
+                                 microseconds{10});
+    mLogger->logSessionScheduled(kDefaultCallingUid, microseconds{300}, microseconds{2000},
+                                 microseconds{0});
+
+    stats = mLogger->getSchedulingStats();
+    EXPECT_EQ(stats.sessionCount, 2);
+    EXPECT_EQ(stats.totalWaitingTime, microseconds{400});
+    EXPECT_EQ(stats.maxWaitingTime, microseconds{300});
+    EXPECT_EQ(stats.totalRunningTime, microseconds{3000});
+    EXPECT_EQ(stats.totalPausedTime, microseconds{10});
+
+    // Scheduling metrics do not write session ended atoms.
+    EXPECT_EQ(logCount(), 0);
+}
+
 }  // namespace android
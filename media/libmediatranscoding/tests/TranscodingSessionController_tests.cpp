@@ -111,6 +111,7 @@ public:
     // ThermalPolicyInterface
     void setCallback(const std::shared_ptr<ThermalPolicyCallbackInterface>& /*cb*/) override {}
     bool getThrottlingStatus() { return false; }
+    ThermalThrottlingLevel getThrottlingLevel() override { return ThermalThrottlingLevel::kNone; }
     // ~ThermalPolicyInterface
 
 private:
@@ -118,7 +119,7 @@ private:
 
 class TestTranscoder : public TranscoderInterface {
 public:
-    TestTranscoder() : mGeneration(0) {}
+    TestTranscoder() : mGeneration(0), mThrottlingLevel(ThermalThrottlingLevel::kNone) {}
     virtual ~TestTranscoder() {}
 
     // TranscoderInterface
@@ -138,6 +139,10 @@ public:
     void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon) override {
         append(abandon ? Abandon(clientId, sessionId) : Stop(clientId, sessionId));
     }
+    void setThrottlingLevel(ThermalThrottlingLevel level) override {
+        std::scoped_lock lock{mLock};
+        mThrottlingLevel = level;
+    }
 
     void onFinished(ClientIdType clientId, SessionIdType sessionId) {
         append(Finished(clientId, sessionId));
@@ -220,6 +225,11 @@ public:
         return mGeneration;
     }
 
+    ThermalThrottlingLevel getThrottlingLevel() {
+        std::scoped_lock lock{mLock};
+        return mThrottlingLevel;
+    }
+
 private:
     std::mutex mLock;
     std::condition_variable mCondition;
@@ -227,6 +237,7 @@ private:
     std::list<Event> mEventQueue;
     std::list<TranscodingErrorCode> mLastErrorQueue;
     int32_t mGeneration;
+    ThermalThrottlingLevel mThrottlingLevel;
 };
 
 bool operator==(const TestTranscoder::Event& lhs, const TestTranscoder::Event& rhs) {
@@ -1241,6 +1252,151 @@ TEST_F(TranscodingSessionControllerTest, TestResourceLostAndThermalCallback) {
     EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(2), SESSION(0)));
 }
 
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessions) {
+    ALOGD("TestConcurrentSessions");
+
+    // Recreate the controller allowing 2 sessions to run at the same time. Both transcoders
+    // share mTranscoder so that all events are recorded in order.
+    std::shared_ptr<TranscodingLogger> logger = std::make_shared<TranscodingLogger>();
+    TranscodingSessionController::ControllerConfig config = {
+            .pacerBurstThresholdMs = 500,
+            .pacerBurstCountQuota = 10,
+            .pacerBurstTimeQuotaSeconds = 3,
+            .maxConcurrentSessions = 2,
+    };
+    mController.reset(new TranscodingSessionController(
+            [this](const std::shared_ptr<TranscoderCallbackInterface>& /*cb*/) {
+                mTranscoder->onCreated();
+                return mTranscoder;
+            },
+            mUidPolicy, mResourcePolicy, mThermalPolicy, &config, logger));
+    mUidPolicy->setCallback(mController);
+
+    // Submit real-time session to CLIENT(0) and offline session to CLIENT(1),
+    // both should start immediately.
+    mRealtimeRequest.clientPid = PID(0);
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mController->submit(CLIENT(1), SESSION(0), UID(1), UID(0), mOfflineRequest, mClientCallback1);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->getGeneration(), 2);
+
+    // Submit another offline session, should not start as capacity is reached.
+    mController->submit(CLIENT(2), SESSION(0), UID(2), UID(0), mOfflineRequest, mClientCallback2);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Move UID(1) to top and submit real-time session for it. The lowest-priority
+    // running session (offline CLIENT(1)) should be preempted.
+    mUidPolicy->setTop(UID(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    mController->submit(CLIENT(3), SESSION(0), UID(3), UID(1), mRealtimeRequest, mClientCallback3);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(3), SESSION(0)));
+
+    // Throttling pauses all running sessions, which resume in priority order after it stops.
+    mController->onThrottlingStarted();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(3), SESSION(0)));
+    mController->onThrottlingStopped();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(3), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+
+    // Finish CLIENT(3), the preempted CLIENT(1) should resume.
+    mController->onFinish(CLIENT(3), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(3), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(1), SESSION(0)));
+
+    // Resource lost while another session is running pauses that session too, and only
+    // one session runs after resource is available again.
+    mController->onResourceLost(CLIENT(0), SESSION(0));
+    EXPECT_EQ(mResourcePolicy->getPid(), PID(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(1), SESSION(0)));
+    mController->onResourceAvailable();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Remaining sessions run one at a time.
+    mController->onFinish(CLIENT(0), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    mController->onFinish(CLIENT(1), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(2), SESSION(0)));
+    mController->onFinish(CLIENT(2), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(2), SESSION(0)));
+
+    // Full capacity is restored once all sessions are done.
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    mController->submit(CLIENT(0), SESSION(2), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(2)));
+
+    // Scheduling metrics of the finished sessions are logged.
+    TranscodingLogger::SchedulingStats stats = logger->getSchedulingStats();
+    EXPECT_EQ(stats.sessionCount, 4);
+    EXPECT_GE(stats.totalWaitingTime, stats.maxWaitingTime);
+    EXPECT_GT(stats.maxWaitingTime.count(), 0);
+}
+
+TEST_F(TranscodingSessionControllerTest, TestThrottlingLevels) {
+    ALOGD("TestThrottlingLevels");
+
+    // Recreate the controller allowing 4 sessions to run at the same time.
+    TranscodingSessionController::ControllerConfig config = {
+            .pacerBurstThresholdMs = 500,
+            .pacerBurstCountQuota = 10,
+            .pacerBurstTimeQuotaSeconds = 3,
+            .maxConcurrentSessions = 4,
+    };
+    mController.reset(new TranscodingSessionController(
+            [this](const std::shared_ptr<TranscoderCallbackInterface>& /*cb*/) {
+                mTranscoder->onCreated();
+                return mTranscoder;
+            },
+            mUidPolicy, mResourcePolicy, mThermalPolicy, &config));
+    mUidPolicy->setCallback(mController);
+
+    // Minimal level only allows 1 session to run, and the transcoders pick up the level.
+    mController->onThrottlingLevelChanged(ThermalThrottlingLevel::kMinimal);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    mController->submit(CLIENT(0), SESSION(2), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    EXPECT_EQ(mTranscoder->getThrottlingLevel(), ThermalThrottlingLevel::kMinimal);
+
+    // Reduced level halves the concurrency.
+    mController->onThrottlingLevelChanged(ThermalThrottlingLevel::kReduced);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    EXPECT_EQ(mTranscoder->getThrottlingLevel(), ThermalThrottlingLevel::kReduced);
+
+    // No throttling restores full concurrency.
+    mController->onThrottlingLevelChanged(ThermalThrottlingLevel::kNone);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+    EXPECT_EQ(mTranscoder->getThrottlingLevel(), ThermalThrottlingLevel::kNone);
+
+    // Going back to minimal level pauses all but the top session.
+    mController->onThrottlingLevelChanged(ThermalThrottlingLevel::kMinimal);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Only the paused level stops everything.
+    mController->onThrottlingLevelChanged(ThermalThrottlingLevel::kPaused);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    mController->onThrottlingStopped();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+}
+
 TEST_F(TranscodingSessionControllerTest, TestTranscoderWatchdogNoHeartbeat) {
     ALOGD("TestTranscoderWatchdogTimeout");
 
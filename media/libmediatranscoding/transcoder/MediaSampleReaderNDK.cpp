@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace android {
 
@@ -31,7 +32,8 @@ static_assert(SAMPLE_FLAG_SYNC_SAMPLE == AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC,
 
 // static
 std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, size_t offset,
-                                                                      size_t size) {
+                                                                      size_t size,
+                                                                      size_t readaheadBytes) {
     AMediaExtractor* extractor = AMediaExtractor_new();
     if (extractor == nullptr) {
         LOG(ERROR) << "Unable to allocate AMediaExtractor";
@@ -45,14 +47,18 @@ std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, si
         return nullptr;
     }
 
-    auto sampleReader = std::shared_ptr<MediaSampleReaderNDK>(new MediaSampleReaderNDK(extractor));
+    auto sampleReader = std::shared_ptr<MediaSampleReaderNDK>(
+            new MediaSampleReaderNDK(extractor, readaheadBytes));
     return sampleReader;
 }
 
-MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor)
-      : mExtractor(extractor), mTrackCount(AMediaExtractor_getTrackCount(mExtractor)) {
+MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor, size_t readaheadBytes)
+      : mExtractor(extractor),
+        mTrackCount(AMediaExtractor_getTrackCount(mExtractor)),
+        mReadaheadBytesMax(readaheadBytes) {
     if (mTrackCount > 0) {
         mTrackCursors.resize(mTrackCount);
+        mReadaheadQueues.resize(mTrackCount);
     }
 }
 
@@ -212,6 +218,112 @@ media_status_t MediaSampleReaderNDK::primeExtractorForTrack_l(
     }
 }
 
+media_status_t MediaSampleReaderNDK::readaheadSample_l(int trackIndex,
+                                                       std::unique_lock<std::mutex>& lockHeld) {
+    if (mExtractorTrackIndex < 0 && !mEosReached) {
+        mExtractorTrackIndex = AMediaExtractor_getSampleTrackIndex(mExtractor);
+        if (mExtractorTrackIndex < 0) {
+            mEosReached = true;
+            mReadaheadEos = true;
+        }
+    }
+    if (mEosReached) {
+        return AMEDIA_ERROR_END_OF_STREAM;
+    }
+
+    // Find the sample in its track's queue, or add it if the extractor is at the frontier.
+    // Samples behind the frontier that are no longer queued have already been consumed.
+    std::deque<ReadaheadSample>& queue = mReadaheadQueues[mExtractorTrackIndex];
+    ReadaheadSample* sample = nullptr;
+    if (mExtractorSampleIndex >= mReadaheadFrontier) {
+        queue.push_back({mExtractorSampleIndex, AMediaExtractor_getSampleTime(mExtractor),
+                         AMediaExtractor_getSampleFlags(mExtractor),
+                         static_cast<size_t>(AMediaExtractor_getSampleSize(mExtractor)), nullptr});
+        sample = &queue.back();
+        mReadaheadFrontier = mExtractorSampleIndex + 1;
+    } else {
+        auto it = std::lower_bound(queue.begin(), queue.end(), mExtractorSampleIndex,
+                                   [](const ReadaheadSample& s, uint64_t index) {
+                                       return s.index < index;
+                                   });
+        if (it != queue.end() && it->index == mExtractorSampleIndex) {
+            sample = &*it;
+        }
+    }
+
+    // Buffer the sample if it is the one requested or if it fits in the budget. The budget
+    // always admits one sample so that a sample larger than the budget can't stall the reader.
+    if (sample != nullptr && sample->data == nullptr) {
+        const bool overBudget =
+                mReadaheadBytes > 0 && mReadaheadBytes + sample->size > mReadaheadBytesMax;
+        if (mExtractorTrackIndex != trackIndex && overBudget) {
+            if (mEnforceSequentialAccess) {
+                // Let the other tracks catch up rather than having them seek back later.
+                mReadaheadCondition.wait(lockHeld);
+                return AMEDIA_OK;
+            }
+        } else {
+            sample->data = std::make_unique<uint8_t[]>(sample->size);
+            ssize_t bytesRead =
+                    AMediaExtractor_readSampleData(mExtractor, sample->data.get(), sample->size);
+            if (bytesRead < static_cast<ssize_t>(sample->size)) {
+                LOG(ERROR) << "Unable to read full sample, " << bytesRead << " vs "
+                           << sample->size;
+                sample->data.reset();
+                return AMEDIA_ERROR_IO;
+            }
+            mReadaheadBytes += sample->size;
+        }
+    }
+
+    mExtractorSampleIndex++;
+    if (AMediaExtractor_advance(mExtractor)) {
+        mExtractorTrackIndex = AMediaExtractor_getSampleTrackIndex(mExtractor);
+    } else {
+        LOG(DEBUG) << "  EOS in readaheadSample_l";
+        mEosReached = true;
+        mReadaheadEos = true;
+    }
+    mReadaheadCondition.notify_all();
+    return AMEDIA_OK;
+}
+
+media_status_t MediaSampleReaderNDK::primeReadaheadForTrack_l(
+        int trackIndex, std::unique_lock<std::mutex>& lockHeld) {
+    std::deque<ReadaheadSample>& queue = mReadaheadQueues[trackIndex];
+
+    while (queue.empty() || queue.front().data == nullptr) {
+        if (queue.empty() && mReadaheadEos) {
+            return AMEDIA_ERROR_END_OF_STREAM;
+        }
+
+        // The extractor passed the sample without buffering it, go back for it.
+        if (!queue.empty() && queue.front().index < mExtractorSampleIndex) {
+            media_status_t status = seekExtractorBackwards_l(queue.front().timeStampUs,
+                                                             trackIndex, queue.front().index);
+            if (status != AMEDIA_OK) return status;
+        }
+
+        media_status_t status = readaheadSample_l(trackIndex, lockHeld);
+        if (status != AMEDIA_OK) return status;
+    }
+
+    return AMEDIA_OK;
+}
+
+void MediaSampleReaderNDK::consumeReadaheadSample_l(int trackIndex) {
+    std::deque<ReadaheadSample>& queue = mReadaheadQueues[trackIndex];
+    if (queue.empty()) {
+        return;
+    }
+
+    if (queue.front().data != nullptr) {
+        mReadaheadBytes -= queue.front().size;
+        mReadaheadCondition.notify_all();
+    }
+    queue.pop_front();
+}
+
 media_status_t MediaSampleReaderNDK::selectTrack(int trackIndex) {
     std::scoped_lock lock(mExtractorMutex);
 
@@ -269,6 +381,14 @@ media_status_t MediaSampleReaderNDK::setEnforceSequentialAccess(bool enforce) {
 
     std::scoped_lock lock(mExtractorMutex);
 
+    if (mReadaheadBytesMax > 0) {
+        // The readahead stage never moves the extractor backwards on its own, so only threads
+        // waiting for budget need to be woken up.
+        mEnforceSequentialAccess = enforce;
+        mReadaheadCondition.notify_all();
+        return AMEDIA_OK;
+    }
+
     if (mEnforceSequentialAccess && !enforce) {
         // If switching from enforcing to not enforcing sequential access there may be threads
         // waiting that needs to be woken up.
@@ -399,8 +519,14 @@ media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, Media
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
-    media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
-    if (status == AMEDIA_OK) {
+    media_status_t status = mReadaheadBytesMax > 0 ? primeReadaheadForTrack_l(trackIndex, lock)
+                                                   : primeExtractorForTrack_l(trackIndex, lock);
+    if (status == AMEDIA_OK && mReadaheadBytesMax > 0) {
+        const ReadaheadSample& sample = mReadaheadQueues[trackIndex].front();
+        info->presentationTimeUs = sample.timeStampUs;
+        info->flags = sample.flags;
+        info->size = sample.size;
+    } else if (status == AMEDIA_OK) {
         info->presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
         info->flags = AMediaExtractor_getSampleFlags(mExtractor);
         info->size = AMediaExtractor_getSampleSize(mExtractor);
@@ -428,6 +554,23 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
+    if (mReadaheadBytesMax > 0) {
+        media_status_t status = primeReadaheadForTrack_l(trackIndex, lock);
+        if (status != AMEDIA_OK) {
+            return status;
+        }
+
+        const ReadaheadSample& sample = mReadaheadQueues[trackIndex].front();
+        if (bufferSize < sample.size) {
+            LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs " << sample.size;
+            return AMEDIA_ERROR_INVALID_PARAMETER;
+        }
+
+        memcpy(buffer, sample.data.get(), sample.size);
+        consumeReadaheadSample_l(trackIndex);
+        return AMEDIA_OK;
+    }
+
     media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
     if (status != AMEDIA_OK) {
         return status;
@@ -451,9 +594,13 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
 }
 
 void MediaSampleReaderNDK::advanceTrack(int trackIndex) {
-    std::scoped_lock lock(mExtractorMutex);
+    std::unique_lock<std::mutex> lock(mExtractorMutex);
 
-    if (mTrackSignals.find(trackIndex) != mTrackSignals.end()) {
+    if (mTrackSignals.find(trackIndex) != mTrackSignals.end() && mReadaheadBytesMax > 0) {
+        if (primeReadaheadForTrack_l(trackIndex, lock) == AMEDIA_OK) {
+            consumeReadaheadSample_l(trackIndex);
+        }
+    } else if (mTrackSignals.find(trackIndex) != mTrackSignals.end()) {
         advanceTrack_l(trackIndex);
     } else {
         LOG(ERROR) << "Trying to advance a track that is not selected (#" << trackIndex << ")";
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "MediaSampleRingQueue"
+
+#include <android-base/logging.h>
+#include <media/MediaSampleRingQueue.h>
+
+#include <algorithm>
+
+namespace android {
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+MediaSampleRingQueue::MediaSampleRingQueue(size_t capacity)
+      : mCapacity(roundUpToPowerOfTwo(std::max(capacity, (size_t)1))),
+        mMask(mCapacity - 1),
+        mRing(new std::shared_ptr<MediaSample>[mCapacity]) {}
+
+MediaSampleRingQueue::~MediaSampleRingQueue() {
+    drain();
+}
+
+// Unfortunately std::unique_lock is incompatible with -Wthread-safety
+template <typename Predicate>
+bool MediaSampleRingQueue::waitUntil(Predicate predicate) NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mMutex);
+    // Registering as a waiter before re-checking the predicate pairs with the fence in
+    // notifyWaiter, so either the other side sees the waiter or this side sees its update.
+    mWaiters.fetch_add(1);
+    while (!predicate() && !mAborted.load()) {
+        mCondition.wait(lock);
+    }
+    mWaiters.fetch_sub(1);
+    return mAborted.load();
+}
+
+void MediaSampleRingQueue::notifyWaiter() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWaiters.load(std::memory_order_relaxed) > 0) {
+        std::scoped_lock<std::mutex> lock(mMutex);
+        mCondition.notify_all();
+    }
+}
+
+void MediaSampleRingQueue::drain() {
+    const size_t tail = mTail.load(std::memory_order_acquire);
+    size_t head = mHead.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) {
+        mRing[head & mMask].reset();
+    }
+    mHead.store(head, std::memory_order_release);
+}
+
+bool MediaSampleRingQueue::enqueue(const std::shared_ptr<MediaSample>& sample) {
+    if (mAborted.load(std::memory_order_acquire)) return true;
+
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHead.load(std::memory_order_acquire) >= mCapacity) {
+        if (waitUntil([this, tail] { return tail - mHead.load() < mCapacity; })) {
+            return true;
+        }
+    }
+
+    mRing[tail & mMask] = sample;
+    mTail.store(tail + 1, std::memory_order_release);
+    notifyWaiter();
+    return false;
+}
+
+bool MediaSampleRingQueue::dequeue(std::shared_ptr<MediaSample>* sample) {
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    if (mAborted.load(std::memory_order_acquire) ||
+        (head == mTail.load(std::memory_order_acquire) &&
+         waitUntil([this, head] { return head != mTail.load(); }))) {
+        drain();
+        return true;
+    }
+
+    if (sample != nullptr) {
+        *sample = std::move(mRing[head & mMask]);
+    } else {
+        mRing[head & mMask].reset();
+    }
+    mHead.store(head + 1, std::memory_order_release);
+    notifyWaiter();
+    return false;
+}
+
+bool MediaSampleRingQueue::dequeueBatch(std::vector<std::shared_ptr<MediaSample>>* samples,
+                                        size_t maxSamples) {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if (mAborted.load(std::memory_order_acquire) ||
+        (head == mTail.load(std::memory_order_acquire) &&
+         waitUntil([this, head] { return head != mTail.load(); }))) {
+        drain();
+        return true;
+    }
+
+    // Take everything published so far in one go and hand the slots back with a single store.
+    const size_t tail = mTail.load(std::memory_order_acquire);
+    const size_t count = std::min(tail - head, maxSamples);
+    for (size_t i = 0; i < count; ++i, ++head) {
+        samples->push_back(std::move(mRing[head & mMask]));
+    }
+    mHead.store(head, std::memory_order_release);
+    notifyWaiter();
+    return false;
+}
+
+bool MediaSampleRingQueue::isEmpty() const {
+    return mAborted.load() || mHead.load() == mTail.load();
+}
+
+void MediaSampleRingQueue::abort() {
+    mAborted.store(true);
+    std::scoped_lock<std::mutex> lock(mMutex);
+    mCondition.notify_all();
+}
+
+}  // namespace android
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "MediaSampleSegmentReader"
+
+#include <android-base/logging.h>
+#include <media/MediaSampleSegmentReader.h>
+
+namespace android {
+
+static AMediaExtractor* createExtractorForTrack(int fd, size_t offset, size_t size,
+                                                int trackIndex) {
+    AMediaExtractor* extractor = AMediaExtractor_new();
+    if (extractor == nullptr) {
+        LOG(ERROR) << "Unable to allocate AMediaExtractor";
+        return nullptr;
+    }
+
+    media_status_t status = AMediaExtractor_setDataSourceFd(extractor, fd, offset, size);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "AMediaExtractor_setDataSourceFd returned error: " << status;
+        AMediaExtractor_delete(extractor);
+        return nullptr;
+    }
+
+    if (trackIndex < 0 || trackIndex >= AMediaExtractor_getTrackCount(extractor)) {
+        LOG(ERROR) << "Invalid trackIndex " << trackIndex;
+        AMediaExtractor_delete(extractor);
+        return nullptr;
+    }
+
+    status = AMediaExtractor_selectTrack(extractor, trackIndex);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "AMediaExtractor_selectTrack returned error: " << status;
+        AMediaExtractor_delete(extractor);
+        return nullptr;
+    }
+
+    return extractor;
+}
+
+// static
+media_status_t MediaSampleSegmentReader::getSegmentBoundaries(int fd, size_t offset, size_t size,
+                                                              int trackIndex, int maxSegmentCount,
+                                                              int64_t minSegmentDurationUs,
+                                                              std::vector<int64_t>* boundariesUs) {
+    if (boundariesUs == nullptr) {
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    boundariesUs->clear();
+
+    AMediaExtractor* extractor = createExtractorForTrack(fd, offset, size, trackIndex);
+    if (extractor == nullptr) {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    int64_t durationUs = 0;
+    AMediaFormat* trackFormat = AMediaExtractor_getTrackFormat(extractor, trackIndex);
+    if (trackFormat != nullptr) {
+        AMediaFormat_getInt64(trackFormat, AMEDIAFORMAT_KEY_DURATION, &durationUs);
+        AMediaFormat_delete(trackFormat);
+    }
+
+    const int64_t firstSampleTimeUs = AMediaExtractor_getSampleTime(extractor);
+    int64_t previousBoundaryUs = firstSampleTimeUs;
+
+    // Seek to evenly spaced points and use the sync sample at or before each of them. Boundaries
+    // that would create a segment shorter than the minimum duration are dropped, so long GOPs
+    // simply result in fewer segments.
+    for (int segment = 1; segment < maxSegmentCount && durationUs > 0 && firstSampleTimeUs >= 0;
+         ++segment) {
+        const int64_t targetTimeUs = firstSampleTimeUs + durationUs * segment / maxSegmentCount;
+        if (AMediaExtractor_seekTo(extractor, targetTimeUs, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC) !=
+            AMEDIA_OK) {
+            break;
+        }
+
+        const int64_t syncTimeUs = AMediaExtractor_getSampleTime(extractor);
+        if (syncTimeUs >= previousBoundaryUs + minSegmentDurationUs &&
+            syncTimeUs <= firstSampleTimeUs + durationUs - minSegmentDurationUs) {
+            boundariesUs->push_back(syncTimeUs);
+            previousBoundaryUs = syncTimeUs;
+        }
+    }
+
+    AMediaExtractor_delete(extractor);
+    return AMEDIA_OK;
+}
+
+// static
+std::shared_ptr<MediaSampleReader> MediaSampleSegmentReader::createFromFd(
+        int fd, size_t offset, size_t size, int trackIndex, int64_t startTimeUs,
+        int64_t endTimeUs) {
+    AMediaExtractor* extractor = createExtractorForTrack(fd, offset, size, trackIndex);
+    if (extractor == nullptr) {
+        return nullptr;
+    }
+
+    if (startTimeUs != INT64_MIN) {
+        // Segments start at sync samples, so the previous sync sample is the segment start itself.
+        media_status_t status =
+                AMediaExtractor_seekTo(extractor, startTimeUs, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "Unable to seek to segment start " << startTimeUs << ": " << status;
+            AMediaExtractor_delete(extractor);
+            return nullptr;
+        }
+    }
+
+    return std::shared_ptr<MediaSampleSegmentReader>(
+            new MediaSampleSegmentReader(extractor, trackIndex, endTimeUs));
+}
+
+MediaSampleSegmentReader::MediaSampleSegmentReader(AMediaExtractor* extractor, int trackIndex,
+                                                   int64_t endTimeUs)
+      : mExtractor(extractor),
+        mTrackCount(AMediaExtractor_getTrackCount(extractor)),
+        mTrackIndex(trackIndex),
+        mEndTimeUs(endTimeUs) {}
+
+MediaSampleSegmentReader::~MediaSampleSegmentReader() {
+    if (mExtractor != nullptr) {
+        AMediaExtractor_delete(mExtractor);
+    }
+}
+
+bool MediaSampleSegmentReader::reachedEndOfSegment_l() {
+    const int64_t sampleTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+    if (sampleTimeUs < 0 && AMediaExtractor_getSampleTrackIndex(mExtractor) < 0) {
+        return true;
+    }
+
+    return !mFirstSample && sampleTimeUs >= mEndTimeUs &&
+           (AMediaExtractor_getSampleFlags(mExtractor) & AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC);
+}
+
+AMediaFormat* MediaSampleSegmentReader::getFileFormat() {
+    return AMediaExtractor_getFileFormat(mExtractor);
+}
+
+size_t MediaSampleSegmentReader::getTrackCount() const {
+    return mTrackCount;
+}
+
+AMediaFormat* MediaSampleSegmentReader::getTrackFormat(int trackIndex) {
+    if (trackIndex < 0 || trackIndex >= mTrackCount) {
+        LOG(ERROR) << "Invalid trackIndex " << trackIndex << " for trackCount " << mTrackCount;
+        return AMediaFormat_new();
+    }
+
+    return AMediaExtractor_getTrackFormat(mExtractor, trackIndex);
+}
+
+media_status_t MediaSampleSegmentReader::selectTrack(int trackIndex) {
+    // The segment track is selected on creation.
+    return trackIndex == mTrackIndex ? AMEDIA_OK : AMEDIA_ERROR_UNSUPPORTED;
+}
+
+media_status_t MediaSampleSegmentReader::unselectTrack(int trackIndex __unused) {
+    return AMEDIA_ERROR_UNSUPPORTED;
+}
+
+media_status_t MediaSampleSegmentReader::setEnforceSequentialAccess(bool enforce __unused) {
+    // Only a single track is read, so access is always sequential.
+    return AMEDIA_OK;
+}
+
+media_status_t MediaSampleSegmentReader::getEstimatedBitrateForTrack(int trackIndex __unused,
+                                                                     int32_t* bitrate __unused) {
+    return AMEDIA_ERROR_UNSUPPORTED;
+}
+
+media_status_t MediaSampleSegmentReader::getSampleInfoForTrack(int trackIndex,
+                                                               MediaSampleInfo* info) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (trackIndex != mTrackIndex) {
+        LOG(ERROR) << "Track not selected.";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    } else if (info == nullptr) {
+        LOG(ERROR) << "MediaSampleInfo pointer is NULL.";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    if (reachedEndOfSegment_l()) {
+        info->presentationTimeUs = 0;
+        info->flags = SAMPLE_FLAG_END_OF_STREAM;
+        info->size = 0;
+        return AMEDIA_ERROR_END_OF_STREAM;
+    }
+
+    info->presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+    info->flags = AMediaExtractor_getSampleFlags(mExtractor);
+    info->size = AMediaExtractor_getSampleSize(mExtractor);
+    return AMEDIA_OK;
+}
+
+media_status_t MediaSampleSegmentReader::readSampleDataForTrack(int trackIndex, uint8_t* buffer,
+                                                                size_t bufferSize) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (trackIndex != mTrackIndex) {
+        LOG(ERROR) << "Track not selected.";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    } else if (buffer == nullptr) {
+        LOG(ERROR) << "buffer pointer is NULL";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    if (reachedEndOfSegment_l()) {
+        return AMEDIA_ERROR_END_OF_STREAM;
+    }
+
+    ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
+    if (bufferSize < sampleSize) {
+        LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs " << sampleSize;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    ssize_t bytesRead = AMediaExtractor_readSampleData(mExtractor, buffer, bufferSize);
+    if (bytesRead < sampleSize) {
+        LOG(ERROR) << "Unable to read full sample, " << bytesRead << " vs " << sampleSize;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    AMediaExtractor_advance(mExtractor);
+    mFirstSample = false;
+    return AMEDIA_OK;
+}
+
+void MediaSampleSegmentReader::advanceTrack(int trackIndex) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (trackIndex == mTrackIndex) {
+        AMediaExtractor_advance(mExtractor);
+        mFirstSample = false;
+    } else {
+        LOG(ERROR) << "Trying to advance a track that is not selected (#" << trackIndex << ")";
+    }
+}
+
+}  // namespace android
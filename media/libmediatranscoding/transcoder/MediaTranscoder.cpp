@@ -20,16 +20,25 @@
 #include <android-base/logging.h>
 #include <fcntl.h>
 #include <media/MediaSampleReaderNDK.h>
+#include <media/MediaSampleSegmentReader.h>
 #include <media/MediaSampleWriter.h>
 #include <media/MediaTranscoder.h>
 #include <media/NdkCommon.h>
 #include <media/PassthroughTrackTranscoder.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 #include <sys/prctl.h>
 #include <unistd.h>
 
 namespace android {
 
+// Segments shorter than this are not worth the cost of starting another pair of codecs.
+static constexpr int64_t kMinVideoSegmentDurationUs = 5 * 1000 * 1000;
+
+// Source samples read ahead of the tracks, so that a poorly interleaved source does not make the
+// sample reader seek back and forth between the tracks.
+static constexpr size_t kSampleReaderReadaheadBytes = 4 * 1024 * 1024;
+
 static std::shared_ptr<AMediaFormat> createVideoTrackFormat(AMediaFormat* srcFormat,
                                                             AMediaFormat* options) {
     if (srcFormat == nullptr || options == nullptr) {
@@ -261,12 +270,16 @@ media_status_t MediaTranscoder::configureSource(int fd) {
     const size_t fileSize = lseek(fd, 0, SEEK_END);
     lseek(fd, 0, SEEK_SET);
 
-    mSampleReader = MediaSampleReaderNDK::createFromFd(fd, 0 /* offset */, fileSize);
+    mSampleReader = MediaSampleReaderNDK::createFromFd(fd, 0 /* offset */, fileSize,
+                                                       kSampleReaderReadaheadBytes);
     if (mSampleReader == nullptr) {
         LOG(ERROR) << "Unable to parse source fd: " << fd;
         return AMEDIA_ERROR_UNSUPPORTED;
     }
 
+    mSourceFd = std::make_shared<::android::base::unique_fd>(dup(fd));
+    mSourceSize = fileSize;
+
     const size_t trackCount = mSampleReader->getTrackCount();
     for (size_t trackIndex = 0; trackIndex < trackCount; ++trackIndex) {
         AMediaFormat* trackFormat = mSampleReader->getTrackFormat(static_cast<int>(trackIndex));
@@ -333,7 +346,32 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
             }
         }
 
-        transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        int32_t maxParallelSegments = 1;
+        AMediaFormat_getInt32(destinationOptions, kTrackOptionMaxParallelSegments,
+                              &maxParallelSegments);
+
+        std::vector<int64_t> segmentBoundariesUs;
+        if (maxParallelSegments > 1 && mSourceFd->get() >= 0) {
+            MediaSampleSegmentReader::getSegmentBoundaries(
+                    mSourceFd->get(), 0 /* offset */, mSourceSize, trackIndex, maxParallelSegments,
+                    kMinVideoSegmentDurationUs, &segmentBoundariesUs);
+        }
+
+        if (!segmentBoundariesUs.empty()) {
+            LOG(INFO) << "Transcoding track #" << trackIndex << " in "
+                      << segmentBoundariesUs.size() + 1 << " segments";
+            auto readerFactory = [sourceFd = mSourceFd, size = mSourceSize, trackIndex](
+                                         int64_t startTimeUs, int64_t endTimeUs) {
+                return MediaSampleSegmentReader::createFromFd(sourceFd->get(), 0 /* offset */,
+                                                              size, trackIndex, startTimeUs,
+                                                              endTimeUs);
+            };
+            transcoder = SegmentedVideoTrackTranscoder::create(
+                    shared_from_this(), segmentBoundariesUs, readerFactory, maxParallelSegments,
+                    mPid, mUid);
+        } else {
+            transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        }
 
         trackFormat = createVideoTrackFormat(srcTrackFormat, destinationOptions);
         if (trackFormat == nullptr) {
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "SegmentedVideoTrackTranscoder"
+
+#include <android-base/logging.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
+#include <sys/prctl.h>
+
+#include <cstring>
+
+namespace android {
+
+// Copies a sample into its own buffer so that the producer's buffer can be released.
+static std::shared_ptr<MediaSample> copySample(const std::shared_ptr<MediaSample>& sample,
+                                               const std::vector<uint8_t>& prefix = {}) {
+    const size_t size = prefix.size() + sample->info.size;
+    uint8_t* buffer = new uint8_t[size > 0 ? size : 1];
+    if (!prefix.empty()) {
+        memcpy(buffer, prefix.data(), prefix.size());
+    }
+    if (sample->info.size > 0) {
+        memcpy(buffer + prefix.size(), sample->buffer + sample->dataOffset, sample->info.size);
+    }
+
+    auto copy = MediaSample::createWithReleaseCallback(
+            buffer, 0 /* offset */, sample->bufferId,
+            [](MediaSample* s) { delete[] s->buffer; });
+    copy->info = sample->info;
+    copy->info.size = size;
+    return copy;
+}
+
+// static
+std::shared_ptr<SegmentedVideoTrackTranscoder> SegmentedVideoTrackTranscoder::create(
+        const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+        const std::vector<int64_t>& segmentBoundariesUs, const SegmentReaderFactory& readerFactory,
+        int maxParallelSegments, pid_t pid, uid_t uid) {
+    if (readerFactory == nullptr) {
+        LOG(ERROR) << "Segment reader factory cannot be null";
+        return nullptr;
+    }
+
+    return std::shared_ptr<SegmentedVideoTrackTranscoder>(new SegmentedVideoTrackTranscoder(
+            transcoderCallback, segmentBoundariesUs, readerFactory, maxParallelSegments, pid, uid));
+}
+
+SegmentedVideoTrackTranscoder::SegmentedVideoTrackTranscoder(
+        const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+        const std::vector<int64_t>& segmentBoundariesUs, const SegmentReaderFactory& readerFactory,
+        int maxParallelSegments, pid_t pid, uid_t uid)
+      : MediaTrackTranscoder(transcoderCallback),
+        mReaderFactory(readerFactory),
+        mMaxParallelSegments(std::max(maxParallelSegments, 1)),
+        mPid(pid),
+        mUid(uid) {
+    int64_t startTimeUs = INT64_MIN;
+    for (int64_t boundaryUs : segmentBoundariesUs) {
+        mSegments.push_back({.startTimeUs = startTimeUs, .endTimeUs = boundaryUs});
+        startTimeUs = boundaryUs;
+    }
+    mSegments.push_back({.startTimeUs = startTimeUs, .endTimeUs = INT64_MAX});
+}
+
+media_status_t SegmentedVideoTrackTranscoder::configureDestinationFormat(
+        const std::shared_ptr<AMediaFormat>& destinationFormat) {
+    if (destinationFormat == nullptr) {
+        LOG(ERROR) << "Destination format is null, use passthrough transcoder";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    AMediaFormat* format = AMediaFormat_new();
+    if (!format || AMediaFormat_copy(format, destinationFormat.get()) != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to copy destination format";
+        AMediaFormat_delete(format);
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    mDestinationFormat = std::shared_ptr<AMediaFormat>(format, &AMediaFormat_delete);
+
+    // Estimate the bitrate once over the whole track so that all segments encode at the same rate.
+    int32_t bitrate;
+    if (!AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, &bitrate)) {
+        if (mMediaSampleReader->getEstimatedBitrateForTrack(mTrackIndex, &bitrate) == AMEDIA_OK) {
+            LOG(INFO) << "Configuring bitrate " << bitrate;
+            AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, bitrate);
+        }
+    }
+
+    // Segments read the track through their own readers. Unselect it from the shared reader so
+    // that it does not hold back the other tracks in sequential access mode.
+    mMediaSampleReader->unselectTrack(mTrackIndex);
+
+    // The first segment is configured up front so that configuration errors surface here.
+    std::scoped_lock lock{mSegmentMutex};
+    return configureSegment(0);
+}
+
+media_status_t SegmentedVideoTrackTranscoder::configureSegment(size_t index) {
+    Segment& segment = mSegments[index];
+
+    std::shared_ptr<MediaSampleReader> reader =
+            mReaderFactory(segment.startTimeUs, segment.endTimeUs);
+    if (reader == nullptr) {
+        LOG(ERROR) << "Unable to create reader for segment " << index;
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    auto transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+    media_status_t status = transcoder->configure(reader, mTrackIndex, mDestinationFormat);
+    if (status != AMEDIA_OK) {
+        LOG(WARNING) << "Unable to configure segment " << index << ": " << status;
+        return status;
+    }
+
+    std::weak_ptr<SegmentedVideoTrackTranscoder> weakThis = shared_from_this();
+    transcoder->setSampleConsumer([weakThis, index](const std::shared_ptr<MediaSample>& sample) {
+        if (auto self = weakThis.lock()) {
+            self->onSegmentSample(index, sample);
+        }
+    });
+
+    segment.transcoder = std::move(transcoder);
+    return AMEDIA_OK;
+}
+
+// Unfortunately std::unique_lock is incompatible with -Wthread-safety
+media_status_t SegmentedVideoTrackTranscoder::runTranscodeLoop(bool* stopped)
+        NO_THREAD_SAFETY_ANALYSIS {
+    prctl(PR_SET_NAME, (unsigned long)"SegTranscodTrd", 0, 0, 0);
+
+    std::unique_lock lock{mSegmentMutex};
+    size_t nextSegment = 0;
+    size_t runningCount = 0;
+    size_t doneCount = 0;
+    bool waitForFreeCodec = false;
+    StopRequest stopSent = NONE;
+
+    while (doneCount < mSegments.size()) {
+        // Forward stop requests and errors to the running segments.
+        const StopRequest stopRequest = mStatus != AMEDIA_OK ? STOP_NOW : mStopRequest.load();
+        if (stopRequest != NONE && stopRequest != stopSent) {
+            std::scoped_lock outputLock{mOutputMutex};
+            for (size_t index = 0; index < mSegments.size(); ++index) {
+                if (mSegments[index].state == Segment::RUNNING) {
+                    // Only the segment being delivered needs to end on a sync sample.
+                    mSegments[index].transcoder->stop(stopRequest == STOP_ON_SYNC &&
+                                                      index == mOutputSegment);
+                }
+            }
+            stopSent = stopRequest;
+        }
+
+        // Start as many segments as allowed.
+        while (stopSent == NONE && !waitForFreeCodec && runningCount < mMaxParallelSegments &&
+               nextSegment < mSegments.size()) {
+            Segment& segment = mSegments[nextSegment];
+            if (segment.transcoder == nullptr) {
+                media_status_t status = configureSegment(nextSegment);
+                if (status != AMEDIA_OK) {
+                    if (runningCount > 0) {
+                        // Codec instances are likely exhausted. Retry once a segment finishes.
+                        waitForFreeCodec = true;
+                        break;
+                    }
+                    mStatus = status;
+                    break;
+                }
+            }
+
+            if (!segment.transcoder->start()) {
+                LOG(ERROR) << "Unable to start segment " << nextSegment;
+                mStatus = AMEDIA_ERROR_UNKNOWN;
+                break;
+            }
+            LOG(DEBUG) << "Started segment " << nextSegment;
+            segment.state = Segment::RUNNING;
+            ++runningCount;
+            ++nextSegment;
+        }
+
+        if (stopSent != NONE && runningCount == 0) {
+            break;
+        } else if (mStatus != AMEDIA_OK && stopSent == NONE) {
+            continue;
+        }
+
+        mSegmentCondition.wait(lock);
+
+        // Collect finished segments.
+        size_t nowDone = 0;
+        size_t nowRunning = 0;
+        for (const Segment& segment : mSegments) {
+            nowDone += segment.state == Segment::DONE;
+            nowRunning += segment.state == Segment::RUNNING;
+        }
+        if (nowDone > doneCount) {
+            waitForFreeCodec = false;
+        }
+        doneCount = nowDone;
+        runningCount = nowRunning;
+    }
+
+    if (mStatus == AMEDIA_OK && doneCount < mSegments.size()) {
+        *stopped = true;
+    }
+    return mStatus;
+}
+
+void SegmentedVideoTrackTranscoder::abortTranscodeLoop() {
+    std::scoped_lock lock{mSegmentMutex};
+    mSegmentCondition.notify_all();
+}
+
+std::shared_ptr<AMediaFormat> SegmentedVideoTrackTranscoder::getOutputFormat() const {
+    return mOutputFormat;
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFormatAvailable(const MediaTrackTranscoder* transcoder) {
+    {
+        std::scoped_lock lock{mSegmentMutex};
+        if (transcoder != mSegments[0].transcoder.get() || mOutputFormat != nullptr) {
+            return;
+        }
+        mOutputFormat = transcoder->getOutputFormat();
+    }
+    notifyTrackFormatAvailable();
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFinished(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackStopped(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackError(const MediaTrackTranscoder* transcoder,
+                                                 media_status_t status) {
+    onSegmentDone(transcoder, status);
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentDone(const MediaTrackTranscoder* transcoder,
+                                                  media_status_t status) {
+    std::scoped_lock lock{mSegmentMutex};
+    for (Segment& segment : mSegments) {
+        if (segment.transcoder.get() == transcoder) {
+            segment.state = Segment::DONE;
+            break;
+        }
+    }
+    if (status != AMEDIA_OK && mStatus == AMEDIA_OK) {
+        mStatus = status;
+    }
+    mSegmentCondition.notify_all();
+}
+
+void SegmentedVideoTrackTranscoder::writeSample_l(Segment& segment,
+                                                  const std::shared_ptr<MediaSample>& sample) {
+    // Encoders configured the same way normally produce identical parameter sets. If a later
+    // segment's differ, send them in-band ahead of its first frame so it remains decodable.
+    if (!segment.wroteFirstFrame && &segment != &mSegments[0] && !segment.codecConfig.empty() &&
+        segment.codecConfig != mCodecConfig) {
+        LOG(WARNING) << "Segment codec config differs, prepending it in-band";
+        segment.wroteFirstFrame = true;
+        onOutputSampleAvailable(copySample(sample, segment.codecConfig));
+        return;
+    }
+
+    segment.wroteFirstFrame = true;
+    onOutputSampleAvailable(sample);
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentSample(size_t index,
+                                                    const std::shared_ptr<MediaSample>& sample) {
+    std::scoped_lock lock{mOutputMutex};
+    Segment& segment = mSegments[index];
+    const bool isLastSegment = index == mSegments.size() - 1;
+
+    if (sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG) {
+        std::vector<uint8_t>& config = index == 0 ? mCodecConfig : segment.codecConfig;
+        config.insert(config.end(), sample->buffer + sample->dataOffset,
+                      sample->buffer + sample->dataOffset + sample->info.size);
+        // Only the first segment's codec config goes into the track.
+        if (index != 0) return;
+    }
+
+    if (sample->info.flags & SAMPLE_FLAG_END_OF_STREAM) {
+        segment.reachedEos = true;
+        if (!isLastSegment) {
+            // Only the last segment ends the track. Keep any data sent along with the EOS.
+            sample->info.flags &= ~SAMPLE_FLAG_END_OF_STREAM;
+        }
+    }
+
+    const bool hasData = sample->info.size > 0 || (sample->info.flags & SAMPLE_FLAG_END_OF_STREAM);
+    if (index == mOutputSegment) {
+        if (hasData) {
+            writeSample_l(segment, sample);
+        }
+    } else if (hasData) {
+        segment.heldSamples.push_back(copySample(sample));
+    }
+
+    // Once the output segment has ended, flush the segments after it that are already complete
+    // or have samples waiting. A stopped transcode ends with the segment being delivered.
+    while (mSegments[mOutputSegment].reachedEos && mOutputSegment + 1 < mSegments.size() &&
+           mStopRequest == NONE) {
+        Segment& next = mSegments[++mOutputSegment];
+        for (const std::shared_ptr<MediaSample>& held : next.heldSamples) {
+            writeSample_l(next, held);
+        }
+        next.heldSamples.clear();
+    }
+}
+
+}  // namespace android
@@ -42,7 +42,8 @@
 using namespace android;
 
 static void ReadMediaSamples(benchmark::State& state, const std::string& srcFileName,
-                             bool readAudio, bool sequentialAccess = false) {
+                             bool readAudio, bool sequentialAccess = false,
+                             size_t readaheadBytes = 0, bool oneTrackAtATime = false) {
     // Asset directory.
     static const std::string kAssetDirectory = "/data/local/tmp/TranscodingBenchmark/";
 
@@ -58,7 +59,8 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
     lseek(srcFd, 0, SEEK_SET);
 
     for (auto _ : state) {
-        auto sampleReader = MediaSampleReaderNDK::createFromFd(srcFd, 0, fileSize);
+        auto sampleReader =
+                MediaSampleReaderNDK::createFromFd(srcFd, 0, fileSize, readaheadBytes);
         if (sampleReader->setEnforceSequentialAccess(sequentialAccess) != AMEDIA_OK) {
             state.SkipWithError("setEnforceSequentialAccess failed");
             return;
@@ -117,11 +119,19 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
 
                 LOG(INFO) << "Track " << trackIndex << " finished";
             });
+
+            // Draining one track before starting the next makes the reader traverse the file
+            // the same way it would for a file whose tracks are stored one after another.
+            if (oneTrackAtATime) {
+                trackThreads.back().join();
+            }
         }
 
         // Join threads.
         for (auto& thread : trackThreads) {
-            thread.join();
+            if (thread.joinable()) {
+                thread.join();
+            }
         }
     }
 
@@ -147,8 +157,37 @@ static void BM_MediaSampleReader_Video(benchmark::State& state) {
                      false /* readAudio */);
 }
 
+static constexpr size_t kReadaheadBytes = 4 * 1024 * 1024;
+
+static void BM_MediaSampleReader_AudioVideo_Parallel_Readahead(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, false /* sequentialAccess */, kReadaheadBytes);
+}
+
+static void BM_MediaSampleReader_AudioVideo_Sequential_Readahead(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, true /* sequentialAccess */, kReadaheadBytes);
+}
+
+// The *_OneTrackAtATime benchmarks model poorly interleaved sources.
+static void BM_MediaSampleReader_AudioVideo_OneTrackAtATime(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, false /* sequentialAccess */, 0 /* readaheadBytes */,
+                     true /* oneTrackAtATime */);
+}
+
+static void BM_MediaSampleReader_AudioVideo_OneTrackAtATime_Readahead(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, false /* sequentialAccess */, kReadaheadBytes,
+                     true /* oneTrackAtATime */);
+}
+
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel_Readahead);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential_Readahead);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_OneTrackAtATime);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_OneTrackAtATime_Readahead);
 
 BENCHMARK_MAIN();
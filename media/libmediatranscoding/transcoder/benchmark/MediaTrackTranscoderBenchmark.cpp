@@ -27,6 +27,8 @@
  *
  * 3. Run:
  *      $ adb shell /data/nativetest64/MediaTrackTranscoderBenchmark/MediaTrackTranscoderBenchmark
+ *
+ * The sample queue benchmarks do not need any media assets.
  */
 
 // #define LOG_NDEBUG 0
@@ -37,13 +39,17 @@
 #include <benchmark/benchmark.h>
 #include <fcntl.h>
 #include <media/MediaSampleReader.h>
+#include <media/MediaSampleQueue.h>
 #include <media/MediaSampleReaderNDK.h>
+#include <media/MediaSampleRingQueue.h>
 #include <media/MediaTrackTranscoder.h>
 #include <media/MediaTrackTranscoderCallback.h>
 #include <media/NdkCommon.h>
 #include <media/PassthroughTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 
+#include <thread>
+
 using namespace android;
 
 typedef enum {
@@ -432,6 +438,53 @@ static void BM_VideoTranscode_HEVC2AVC_NoExtractor(benchmark::State& state) {
     BenchmarkTranscoderWithOperatingRate(state, srcFile, true /* mockReader */, kVideo);
 }
 
+//-------------------------------- Sample Queue Benchmarks -----------------------------------------
+
+// Number of samples handed from the producer to the consumer thread per iteration. This is roughly
+// a minute of 48kHz AAC audio, whose small, frequent samples make queue overhead most visible.
+static constexpr int kQueueSampleCount = 3000;
+
+static void BM_SampleQueue_Mutex(benchmark::State& state) {
+    for (auto _ : state) {
+        MediaSampleQueue queue;
+        std::thread producer([&queue] {
+            for (int i = 0; i < kQueueSampleCount; ++i) {
+                queue.enqueue(std::make_shared<MediaSample>());
+            }
+        });
+
+        std::shared_ptr<MediaSample> sample;
+        for (int i = 0; i < kQueueSampleCount; ++i) {
+            queue.dequeue(&sample);
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kQueueSampleCount);
+}
+
+static void BM_SampleQueue_Ring(benchmark::State& state) {
+    const size_t capacity = state.range(0);
+    const size_t batchSize = state.range(1);
+
+    for (auto _ : state) {
+        MediaSampleRingQueue queue(capacity);
+        std::thread producer([&queue] {
+            for (int i = 0; i < kQueueSampleCount; ++i) {
+                queue.enqueue(std::make_shared<MediaSample>());
+            }
+        });
+
+        std::vector<std::shared_ptr<MediaSample>> samples;
+        samples.reserve(batchSize);
+        for (int received = 0; received < kQueueSampleCount; received += samples.size()) {
+            samples.clear();
+            queue.dequeueBatch(&samples, batchSize);
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kQueueSampleCount);
+}
+
 //-------------------------------- Benchmark Registration ------------------------------------------
 
 // Benchmark registration wrapper for transcoding.
@@ -453,4 +506,13 @@ TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_AVC2AVC_NoExtractor);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC_NoExtractor);
 
+BENCHMARK(BM_SampleQueue_Mutex)->UseRealTime();
+// Args are {capacity, batch size}.
+BENCHMARK(BM_SampleQueue_Ring)
+        ->UseRealTime()
+        ->Args({64, 1})
+        ->Args({64, 16})
+        ->Args({256, 1})
+        ->Args({256, 64});
+
 BENCHMARK_MAIN();
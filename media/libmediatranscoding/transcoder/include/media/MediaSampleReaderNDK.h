@@ -20,6 +20,8 @@
 #include <media/MediaSampleReader.h>
 #include <media/NdkMediaExtractor.h>
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -39,10 +41,19 @@ public:
      *           to do so when this method returns.
      * @param offset Source data offset.
      * @param size Source data size.
+     * @param readaheadBytes Memory budget for reading samples ahead in file order, or 0 to read
+     *                       each sample from the extractor when it is requested. See below.
      * @return A shared pointer referencing the new MediaSampleReaderNDK instance on success, or an
      *         empty shared pointer if an error occurred.
+     *
+     * With readahead enabled, the reader walks the file in order once and buffers the samples
+     * of all selected tracks, so that requests for tracks the extractor has already passed are
+     * served from memory instead of seeking back. When the budget is used up, sequential access
+     * mode waits for the other tracks to consume their buffered samples, while parallel access
+     * mode only records the position of the samples it passes and seeks back to them later.
      */
-    static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size);
+    static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size,
+                                                           size_t readaheadBytes = 0);
 
     AMediaFormat* getFileFormat() override;
     size_t getTrackCount() const override;
@@ -89,12 +100,25 @@ private:
         SamplePosition next;
     };
 
+    /**
+     * ReadaheadSample describes a sample the readahead stage has passed over. Its data is only
+     * present if it fit in the readahead budget at the time.
+     */
+    struct ReadaheadSample {
+        uint64_t index;
+        int64_t timeStampUs;
+        uint32_t flags;
+        size_t size;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
      * @param extractor The initialized media extractor.
+     * @param readaheadBytes The readahead budget, or 0 to disable readahead.
      */
-    MediaSampleReaderNDK(AMediaExtractor* extractor);
+    MediaSampleReaderNDK(AMediaExtractor* extractor, size_t readaheadBytes);
 
     /** Advances the track to next sample. */
     void advanceTrack_l(int trackIndex);
@@ -120,6 +144,15 @@ private:
      */
     media_status_t primeExtractorForTrack_l(int trackIndex, std::unique_lock<std::mutex>& lockHeld);
 
+    /** Reads the sample the extractor points to into the readahead queues and advances. */
+    media_status_t readaheadSample_l(int trackIndex, std::unique_lock<std::mutex>& lockHeld);
+
+    /** Ensures the next sample of the track is buffered in its readahead queue. */
+    media_status_t primeReadaheadForTrack_l(int trackIndex, std::unique_lock<std::mutex>& lockHeld);
+
+    /** Drops the next sample of the track from its readahead queue. */
+    void consumeReadaheadSample_l(int trackIndex);
+
     AMediaExtractor* mExtractor = nullptr;
     std::mutex mExtractorMutex;
     const size_t mTrackCount;
@@ -135,6 +168,19 @@ private:
 
     // Samples cursor for each track in the file.
     std::vector<SampleCursor> mTrackCursors;
+
+    // Readahead budget in bytes, 0 if readahead is disabled.
+    const size_t mReadaheadBytesMax;
+    // Size of the sample data currently held in the readahead queues.
+    size_t mReadaheadBytes = 0;
+    // Index of the first sample in file order that the readahead stage has not passed yet.
+    uint64_t mReadaheadFrontier = 0;
+    // Whether the readahead stage has passed the last sample in the file.
+    bool mReadaheadEos = false;
+    // Signals sequential mode readers waiting for readahead budget.
+    std::condition_variable mReadaheadCondition;
+    // Samples passed but not yet consumed for each track, in file order.
+    std::vector<std::deque<ReadaheadSample>> mReadaheadQueues;
 };
 
 }  // namespace android
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_SAMPLE_RING_QUEUE_H
+#define ANDROID_MEDIA_SAMPLE_RING_QUEUE_H
+
+#include <media/MediaSample.h>
+#include <utils/Mutex.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * MediaSampleRingQueue is a bounded alternative to MediaSampleQueue for exactly one producer
+ * thread and one consumer thread. Samples are passed through a fixed size ring buffer indexed by
+ * atomic counters, so as long as the queue is neither empty nor full, enqueue and dequeue never
+ * take a lock. A thread only blocks, on a mutex and condition variable, when the consumer finds
+ * the queue empty or the producer finds it full, which gives the producer backpressure instead of
+ * unbounded growth.
+ */
+class MediaSampleRingQueue {
+public:
+    /**
+     * Creates a new queue.
+     * @param capacity The maximum number of samples held by the queue. Rounded up to a power of 2.
+     */
+    explicit MediaSampleRingQueue(size_t capacity);
+    ~MediaSampleRingQueue();
+
+    /**
+     * Enqueues a media sample at the end of the queue and notifies a potentially waiting consumer.
+     * If the queue is full this method blocks until the consumer has made room. If the queue has
+     * previously been aborted this method does nothing. Must only be called by the producer.
+     * @param sample The media sample to enqueue.
+     * @return True if the queue has been aborted.
+     */
+    bool enqueue(const std::shared_ptr<MediaSample>& sample);
+
+    /**
+     * Removes the next media sample from the queue and returns it. If the queue has previously been
+     * aborted this method returns null. Note that this method will block while the queue is empty.
+     * Must only be called by the consumer.
+     * @param[out] sample The next media sample in the queue.
+     * @return True if the queue has been aborted.
+     */
+    bool dequeue(std::shared_ptr<MediaSample>* sample /* nonnull */);
+
+    /**
+     * Removes up to maxSamples media samples from the queue and appends them to samples. Blocks
+     * while the queue is empty, then takes everything available up to maxSamples at once. Must only
+     * be called by the consumer.
+     * @param[out] samples Vector the dequeued samples are appended to.
+     * @param maxSamples The maximum number of samples to dequeue.
+     * @return True if the queue has been aborted.
+     */
+    bool dequeueBatch(std::vector<std::shared_ptr<MediaSample>>* samples /* nonnull */,
+                      size_t maxSamples);
+
+    /**
+     * Checks if the queue currently holds any media samples.
+     * @return True if the queue is empty or has been aborted. False otherwise.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Aborts the queue operation and notifies waiting threads. After the queue has been aborted it
+     * is not possible to enqueue more samples, and dequeue will return null. Samples still in the
+     * queue are released by the consumer's next dequeue call, or when the queue is destroyed.
+     */
+    void abort();
+
+private:
+    // Waits until the predicate holds or the queue is aborted. Returns true if aborted.
+    template <typename Predicate>
+    bool waitUntil(Predicate predicate);
+    // Wakes up the other side if it is blocked in waitUntil.
+    void notifyWaiter();
+    // Releases all samples currently in the ring. Must only be called by the consumer.
+    void drain();
+
+    const size_t mCapacity;
+    const size_t mMask;
+    std::unique_ptr<std::shared_ptr<MediaSample>[]> mRing;
+
+    // The consumer and producer indices are kept on separate cache lines so that the two threads
+    // do not contend on the same line while the queue is neither empty nor full.
+    alignas(64) std::atomic<size_t> mHead = 0;  // Next slot to dequeue, written by the consumer.
+    alignas(64) std::atomic<size_t> mTail = 0;  // Next slot to enqueue, written by the producer.
+
+    std::atomic<bool> mAborted = false;
+    std::atomic<int> mWaiters = 0;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+}  // namespace android
+#endif  // ANDROID_MEDIA_SAMPLE_RING_QUEUE_H
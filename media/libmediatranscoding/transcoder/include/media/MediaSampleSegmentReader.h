@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_SAMPLE_SEGMENT_READER_H
+#define ANDROID_MEDIA_SAMPLE_SEGMENT_READER_H
+
+#include <media/MediaSampleReader.h>
+#include <media/NdkMediaExtractor.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * MediaSampleSegmentReader reads a single track of a media file between two sync samples, using its
+ * own media NDK extractor. Several segment readers over the same file can be used concurrently to
+ * transcode different parts of a track in parallel. The track is selected on creation and the
+ * reader reports end of stream when it reaches the sync sample that starts the next segment.
+ */
+class MediaSampleSegmentReader : public MediaSampleReader {
+public:
+    /**
+     * Finds sync samples that split a track into segments of roughly equal duration.
+     * @param fd Source file descriptor.
+     * @param offset Source data offset.
+     * @param size Source data size.
+     * @param trackIndex The track to split.
+     * @param maxSegmentCount The maximum number of segments to split the track into.
+     * @param minSegmentDurationUs The minimum duration of a segment.
+     * @param[out] boundariesUs Timestamps of the sync samples that start the second and following
+     *             segments, in increasing order. Empty if the track can not be split.
+     * @return AMEDIA_OK on success.
+     */
+    static media_status_t getSegmentBoundaries(int fd, size_t offset, size_t size, int trackIndex,
+                                               int maxSegmentCount, int64_t minSegmentDurationUs,
+                                               std::vector<int64_t>* boundariesUs /* nonnull */);
+
+    /**
+     * Creates a new MediaSampleSegmentReader instance wrapped in a shared pointer.
+     * @param fd Source file descriptor. The caller is responsible for closing the fd and it is safe
+     *           to do so when this method returns.
+     * @param offset Source data offset.
+     * @param size Source data size.
+     * @param trackIndex The track to read.
+     * @param startTimeUs Timestamp of the sync sample the segment starts at, or INT64_MIN to start
+     *                    at the beginning of the track.
+     * @param endTimeUs Timestamp of the sync sample that starts the next segment, or INT64_MAX to
+     *                  read until the end of the track.
+     * @return A shared pointer referencing the new reader on success, or an empty shared pointer if
+     *         an error occurred.
+     */
+    static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size,
+                                                           int trackIndex, int64_t startTimeUs,
+                                                           int64_t endTimeUs);
+
+    AMediaFormat* getFileFormat() override;
+    size_t getTrackCount() const override;
+    AMediaFormat* getTrackFormat(int trackIndex) override;
+    media_status_t selectTrack(int trackIndex) override;
+    media_status_t unselectTrack(int trackIndex) override;
+    media_status_t setEnforceSequentialAccess(bool enforce) override;
+    media_status_t getEstimatedBitrateForTrack(int trackIndex, int32_t* bitrate) override;
+    media_status_t getSampleInfoForTrack(int trackIndex, MediaSampleInfo* info) override;
+    media_status_t readSampleDataForTrack(int trackIndex, uint8_t* buffer,
+                                          size_t bufferSize) override;
+    void advanceTrack(int trackIndex) override;
+
+    virtual ~MediaSampleSegmentReader() override;
+
+private:
+    MediaSampleSegmentReader(AMediaExtractor* extractor, int trackIndex, int64_t endTimeUs);
+
+    /** Returns true if the extractor has moved past the end of the segment. */
+    bool reachedEndOfSegment_l();
+
+    AMediaExtractor* mExtractor = nullptr;
+    std::mutex mExtractorMutex;
+    const size_t mTrackCount;
+    const int mTrackIndex;
+    const int64_t mEndTimeUs;
+    // The first sample always belongs to the segment, even if it is a sync sample past the end.
+    bool mFirstSample = true;
+};
+
+}  // namespace android
+#endif  // ANDROID_MEDIA_SAMPLE_SEGMENT_READER_H
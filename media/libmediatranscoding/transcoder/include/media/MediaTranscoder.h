@@ -17,6 +17,7 @@
 #ifndef ANDROID_MEDIA_TRANSCODER_H
 #define ANDROID_MEDIA_TRANSCODER_H
 
+#include <android-base/unique_fd.h>
 #include <android/binder_auto_utils.h>
 #include <media/MediaSampleWriter.h>
 #include <media/MediaTrackTranscoderCallback.h>
@@ -67,6 +68,14 @@ public:
         virtual ~CallbackInterface() = default;
     };
 
+    /**
+     * Track format option (int32) for video tracks. When set to a value greater than one, the track
+     * is split at sync samples into segments that are transcoded in parallel by up to this many
+     * codec instances. Short tracks, or tracks without enough sync samples, are transcoded by a
+     * single codec instance as usual.
+     */
+    static constexpr char kTrackOptionMaxParallelSegments[] = "max-parallel-segments";
+
     /**
      * Creates a new MediaTranscoder instance. If the supplied paused state is valid, the transcoder
      * will be initialized with the paused state and be ready to be resumed right away. It is not
@@ -147,6 +156,9 @@ private:
 
     std::shared_ptr<CallbackInterface> mCallbacks;
     std::shared_ptr<MediaSampleReader> mSampleReader;
+    // Source file kept open for readers of segmented video tracks.
+    std::shared_ptr<::android::base::unique_fd> mSourceFd;
+    size_t mSourceSize = 0;
     std::shared_ptr<MediaSampleWriter> mSampleWriter;
     std::vector<std::shared_ptr<AMediaFormat>> mSourceTrackFormats;
     std::vector<std::shared_ptr<MediaTrackTranscoder>> mTrackTranscoders;
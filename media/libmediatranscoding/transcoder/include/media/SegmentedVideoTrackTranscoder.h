@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+#define ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+
+#include <media/MediaTrackTranscoder.h>
+#include <media/MediaTrackTranscoderCallback.h>
+#include <media/NdkMediaCodecPlatform.h>
+#include <media/VideoTrackTranscoder.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * Track transcoder that splits a video track at sync samples into segments and transcodes up to
+ * a maximum number of segments in parallel, each with its own VideoTrackTranscoder and codec
+ * instances. Encoded samples are delivered in segment order so that the consumer sees a single
+ * continuous track. Samples from segments that are ahead of the one currently being delivered are
+ * copied and held until their turn, which releases the encoder buffers right away. Since every
+ * segment decodes and encodes the source timestamps unchanged, the stitched track keeps the source
+ * timing. The first segment's encoder output format is used for the track.
+ *
+ * Segments beyond the first are configured only when they are about to start. If a segment's
+ * codecs can not be created while other segments are running it waits for one of them to finish,
+ * so the parallelism adapts to the codec instances the resource manager actually grants.
+ */
+class SegmentedVideoTrackTranscoder
+      : public std::enable_shared_from_this<SegmentedVideoTrackTranscoder>,
+        public MediaTrackTranscoder,
+        public MediaTrackTranscoderCallback {
+public:
+    /** Creates a reader for the part of the track between two sync samples. */
+    using SegmentReaderFactory = std::function<std::shared_ptr<MediaSampleReader>(
+            int64_t startTimeUs, int64_t endTimeUs)>;
+
+    /**
+     * Creates a new segmented video track transcoder.
+     * @param transcoderCallback The track transcoder callback.
+     * @param segmentBoundariesUs Timestamps of the sync samples starting the second and following
+     *        segments, in increasing order.
+     * @param readerFactory Factory creating the sample reader of each segment.
+     * @param maxParallelSegments Maximum number of segments transcoded at the same time.
+     */
+    static std::shared_ptr<SegmentedVideoTrackTranscoder> create(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+            const std::vector<int64_t>& segmentBoundariesUs,
+            const SegmentReaderFactory& readerFactory, int maxParallelSegments,
+            pid_t pid = AMEDIACODEC_CALLING_PID, uid_t uid = AMEDIACODEC_CALLING_UID);
+
+    virtual ~SegmentedVideoTrackTranscoder() override = default;
+
+private:
+    struct Segment {
+        int64_t startTimeUs;
+        int64_t endTimeUs;
+        std::shared_ptr<VideoTrackTranscoder> transcoder;
+        enum { PENDING, RUNNING, DONE } state = PENDING;
+
+        // Output state, guarded by mOutputMutex.
+        std::vector<std::shared_ptr<MediaSample>> heldSamples;
+        std::vector<uint8_t> codecConfig;
+        bool reachedEos = false;
+        bool wroteFirstFrame = false;
+    };
+
+    SegmentedVideoTrackTranscoder(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+            const std::vector<int64_t>& segmentBoundariesUs,
+            const SegmentReaderFactory& readerFactory, int maxParallelSegments, pid_t pid,
+            uid_t uid);
+
+    // MediaTrackTranscoder
+    media_status_t runTranscodeLoop(bool* stopped) override;
+    void abortTranscodeLoop() override;
+    media_status_t configureDestinationFormat(
+            const std::shared_ptr<AMediaFormat>& destinationFormat) override;
+    std::shared_ptr<AMediaFormat> getOutputFormat() const override;
+    // ~MediaTrackTranscoder
+
+    // MediaTrackTranscoderCallback
+    void onTrackFormatAvailable(const MediaTrackTranscoder* transcoder) override;
+    void onTrackFinished(const MediaTrackTranscoder* transcoder) override;
+    void onTrackStopped(const MediaTrackTranscoder* transcoder) override;
+    void onTrackError(const MediaTrackTranscoder* transcoder, media_status_t status) override;
+    // ~MediaTrackTranscoderCallback
+
+    // Creates and configures the reader and transcoder of a segment.
+    media_status_t configureSegment(size_t index);
+
+    // Marks the segment run by the transcoder as done and wakes up the transcode loop.
+    void onSegmentDone(const MediaTrackTranscoder* transcoder, media_status_t status);
+
+    // Receives an encoded sample from a segment and delivers or holds it in segment order.
+    void onSegmentSample(size_t index, const std::shared_ptr<MediaSample>& sample);
+
+    // Delivers a sample of the current output segment.
+    void writeSample_l(Segment& segment, const std::shared_ptr<MediaSample>& sample);
+
+    const SegmentReaderFactory mReaderFactory;
+    const size_t mMaxParallelSegments;
+    const pid_t mPid;
+    const uid_t mUid;
+    std::shared_ptr<AMediaFormat> mDestinationFormat;
+    std::shared_ptr<AMediaFormat> mOutputFormat;
+
+    std::mutex mSegmentMutex;
+    std::condition_variable mSegmentCondition;
+    std::vector<Segment> mSegments;
+    media_status_t mStatus GUARDED_BY(mSegmentMutex) = AMEDIA_OK;
+
+    std::mutex mOutputMutex;
+    size_t mOutputSegment GUARDED_BY(mOutputMutex) = 0;
+    std::vector<uint8_t> mCodecConfig GUARDED_BY(mOutputMutex);
+};
+
+}  // namespace android
+#endif  // ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
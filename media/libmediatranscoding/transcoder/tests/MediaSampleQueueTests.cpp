@@ -22,6 +22,7 @@
 #include <android-base/logging.h>
 #include <gtest/gtest.h>
 #include <media/MediaSampleQueue.h>
+#include <media/MediaSampleRingQueue.h>
 
 #include <thread>
 
@@ -229,6 +230,120 @@ TEST_F(MediaSampleQueueTests, TestBlockingAbort) {
     abortingThread.join();
 }
 
+TEST_F(MediaSampleQueueTests, TestRingQueueDequeueOrder) {
+    LOG(DEBUG) << "TestRingQueueDequeueOrder Starts";
+
+    static constexpr int kNumSamples = 4;
+    MediaSampleRingQueue sampleQueue(kNumSamples);
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+        EXPECT_FALSE(sampleQueue.isEmpty());
+    }
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        bool aborted = sampleQueue.dequeue(&sample);
+        EXPECT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+        EXPECT_FALSE(aborted);
+    }
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestRingQueueBatchDequeue) {
+    LOG(DEBUG) << "TestRingQueueBatchDequeue Starts";
+
+    static constexpr int kNumSamples = 8;
+    MediaSampleRingQueue sampleQueue(kNumSamples);
+    for (int i = 0; i < kNumSamples; ++i) {
+        EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+    }
+
+    std::vector<std::shared_ptr<MediaSample>> samples;
+    EXPECT_FALSE(sampleQueue.dequeueBatch(&samples, 5));
+    EXPECT_EQ(samples.size(), 5);
+    EXPECT_FALSE(sampleQueue.dequeueBatch(&samples, kNumSamples));
+    ASSERT_EQ(samples.size(), kNumSamples);
+    for (int i = 0; i < kNumSamples; ++i) {
+        EXPECT_EQ(samples[i]->bufferId, i);
+    }
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestRingQueueBackpressure) {
+    LOG(DEBUG) << "TestRingQueueBackpressure Starts";
+
+    static constexpr int kCapacity = 2;
+    static constexpr int kNumSamples = 1000;
+    MediaSampleRingQueue sampleQueue(kCapacity);
+
+    // The producer is blocked whenever the queue is full and must still deliver every sample in
+    // order once the consumer catches up.
+    std::thread enqueueThread([&sampleQueue] {
+        for (int i = 0; i < kNumSamples; ++i) {
+            EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+        }
+    });
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        EXPECT_FALSE(sampleQueue.dequeue(&sample));
+        ASSERT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+    }
+
+    enqueueThread.join();
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestRingQueueAbortBufferRelease) {
+    LOG(DEBUG) << "TestRingQueueAbortBufferRelease Starts";
+
+    static constexpr int kNumSamples = 4;
+    std::vector<bool> bufferReleased(kNumSamples, false);
+
+    MediaSample::OnSampleReleasedCallback callback = [&bufferReleased](MediaSample* sample) {
+        bufferReleased[sample->bufferId] = true;
+    };
+
+    MediaSampleRingQueue sampleQueue(kNumSamples);
+    for (int i = 0; i < kNumSamples; ++i) {
+        bool aborted = sampleQueue.enqueue(
+                MediaSample::createWithReleaseCallback(nullptr, 0, i, callback));
+        EXPECT_FALSE(aborted);
+    }
+
+    sampleQueue.abort();
+    EXPECT_TRUE(sampleQueue.isEmpty());
+    EXPECT_TRUE(sampleQueue.enqueue(newSample(kNumSamples)));
+
+    std::shared_ptr<MediaSample> sample;
+    EXPECT_TRUE(sampleQueue.dequeue(&sample));
+    EXPECT_EQ(sample, nullptr);
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        EXPECT_TRUE(bufferReleased[i]);
+    }
+}
+
+TEST_F(MediaSampleQueueTests, TestRingQueueBlockingAbort) {
+    LOG(DEBUG) << "TestRingQueueBlockingAbort Starts";
+
+    MediaSampleRingQueue sampleQueue(1);
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(1)));
+
+    // Blocks the producer on a full queue until the queue is aborted.
+    std::thread abortingThread([&sampleQueue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+        sampleQueue.abort();
+    });
+
+    EXPECT_TRUE(sampleQueue.enqueue(newSample(2)));
+    abortingThread.join();
+}
+
 }  // namespace android
 
 int main(int argc, char** argv) {
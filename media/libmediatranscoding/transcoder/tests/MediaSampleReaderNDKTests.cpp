@@ -84,8 +84,8 @@ static constexpr int SAMPLE_COUNT_ALL = -1;
  */
 class SampleAccessTester {
 public:
-    SampleAccessTester(int sourceFd, size_t fileSize) {
-        mSampleReader = MediaSampleReaderNDK::createFromFd(sourceFd, 0, fileSize);
+    SampleAccessTester(int sourceFd, size_t fileSize, size_t readaheadBytes = 0) {
+        mSampleReader = MediaSampleReaderNDK::createFromFd(sourceFd, 0, fileSize, readaheadBytes);
         EXPECT_TRUE(mSampleReader);
 
         mTrackCount = mSampleReader->getTrackCount();
@@ -380,6 +380,53 @@ TEST_F(MediaSampleReaderNDKTests, TestMixedSampleAccess) {
     }
 }
 
+/**
+ * Reads all samples with readahead enabled, with a budget that holds the whole file and with one
+ * that is exceeded, in all access modes.
+ */
+TEST_F(MediaSampleReaderNDKTests, TestReadaheadSampleAccess) {
+    LOG(DEBUG) << "TestReadaheadSampleAccess Starts";
+    initExtractorSamples();
+
+    for (size_t readaheadBytes : {mFileSize, (size_t)16 * 1024}) {
+        {  // Parallel
+            SampleAccessTester tester{mSourceFd, mFileSize, readaheadBytes};
+            tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+            tester.waitForTracks();
+            compareSamples(tester.getSamples());
+        }
+
+        {  // Sequential
+            SampleAccessTester tester{mSourceFd, mFileSize, readaheadBytes};
+            tester.setEnforceSequentialAccess(true);
+            tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+            tester.waitForTracks();
+            compareSamples(tester.getSamples());
+        }
+
+        {  // One track at a time, as if the tracks were not interleaved.
+            SampleAccessTester tester{mSourceFd, mFileSize, readaheadBytes};
+            for (int trackIndex = mTrackCount - 1; trackIndex >= 0; --trackIndex) {
+                tester.readSamplesAsync(trackIndex, SAMPLE_COUNT_ALL);
+                tester.waitForTrack(trackIndex);
+            }
+            compareSamples(tester.getSamples());
+        }
+
+        {  // Mixed, half of each track in parallel mode before switching to sequential mode.
+            SampleAccessTester tester{mSourceFd, mFileSize, readaheadBytes};
+            for (int trackIndex = 0; trackIndex < mTrackCount; ++trackIndex) {
+                tester.readSamplesAsync(trackIndex, mExtractorSamples[trackIndex].size() / 2);
+            }
+            tester.waitForTracks();
+            tester.setEnforceSequentialAccess(true);
+            tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+            tester.waitForTracks();
+            compareSamples(tester.getSamples());
+        }
+    }
+}
+
 TEST_F(MediaSampleReaderNDKTests, TestEstimatedBitrateAccuracy) {
     // Just put a somewhat reasonable upper bound on the estimated bitrate expected in our test
     // assets. This is mostly to make sure the estimation is not way off.
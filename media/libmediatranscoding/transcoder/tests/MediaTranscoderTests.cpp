@@ -331,6 +331,30 @@ TEST_F(MediaTranscoderTests, TestCustomBitrate) {
     EXPECT_GT(getFileSizeDiffPercent(destPath1, destPath2), 10);
 }
 
+TEST_F(MediaTranscoderTests, TestVideoTranscode_ParallelSegments) {
+    const char* srcPath = "/data/local/tmp/TranscodingTestAssets/jets_hevc_1280x720_20Mbps.mp4";
+    const char* destPath = "/data/local/tmp/MediaTranscoder_VideoTranscode_ParallelSegments.MP4";
+    EXPECT_EQ(transcodeHelper(srcPath, destPath,
+                              [](AMediaFormat* sourceFormat) {
+                                  AMediaFormat* format = nullptr;
+                                  const char* mime = nullptr;
+                                  AMediaFormat_getString(sourceFormat, AMEDIAFORMAT_KEY_MIME,
+                                                         &mime);
+
+                                  if (strncmp(mime, "video/", 6) == 0) {
+                                      format = AMediaFormat_new();
+                                      AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME,
+                                                             AMEDIA_MIMETYPE_VIDEO_AVC);
+                                      AMediaFormat_setInt32(
+                                              format,
+                                              MediaTranscoder::kTrackOptionMaxParallelSegments, 2);
+                                  }
+                                  return format;
+                              }),
+              AMEDIA_OK);
+    verifyOutputFormat(destPath);
+}
+
 static AMediaFormat* getAVCVideoFormat(AMediaFormat* sourceFormat) {
     AMediaFormat* format = nullptr;
     const char* mime = nullptr;
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MonoPipeSecondaryReader"
+//#define LOG_NDEBUG 0
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/MonoPipeSecondaryReader.h>
+
+namespace android {
+
+MonoPipeSecondaryReader::MonoPipeSecondaryReader(MonoPipe* pipe, OverrunPolicy policy,
+        size_t targetFrames) :
+        NBAIO_Source(pipe->mFormat),
+        mPipe(pipe),
+        // only the MonoPipeReader throttles the writer
+        mFifoReader(mPipe->mFifo, false /*throttlesWriter*/,
+                policy == OVERRUN_FLUSH /*flush*/),
+        mTargetFrames(targetFrames),
+        mFramesOverrun(0),
+        mOverruns(0),
+        mFramesSkipped(0),
+        mTimestampObserver(&mPipe->mTimestampShared),
+        // mTimestamp
+        mTimestampValid(false)
+{
+}
+
+MonoPipeSecondaryReader::~MonoPipeSecondaryReader()
+{
+}
+
+ssize_t MonoPipeSecondaryReader::checkedAvailable()
+{
+    size_t lost;
+    ssize_t avail = mFifoReader.available(&lost);
+    if (avail == -EOVERFLOW || lost > 0) {
+        mFramesOverrun += lost;
+        ++mOverruns;
+        avail = OVERRUN;
+    }
+    return avail;
+}
+
+ssize_t MonoPipeSecondaryReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    ssize_t avail = checkedAvailable();
+    ALOG_ASSERT(avail <= (ssize_t) mPipe->mMaxFrames);
+    return avail;
+}
+
+void MonoPipeSecondaryReader::skipToTarget()
+{
+    ssize_t avail = checkedAvailable();
+    if (avail <= (ssize_t) (2 * mTargetFrames)) {
+        return;
+    }
+    // The skipped frames are released without being copied.
+    size_t skip = avail - mTargetFrames;
+    while (skip > 0) {
+        audio_utils_iovec iovec[2];
+        size_t lost;
+        ssize_t obtained = mFifoReader.obtain(iovec, skip, NULL /*timeout*/, &lost);
+        if (obtained == -EOVERFLOW || lost > 0) {
+            mFramesOverrun += lost;
+            ++mOverruns;
+            return;
+        }
+        if (obtained <= 0) {
+            return;
+        }
+        mFifoReader.release(obtained);
+        mFramesSkipped += obtained;
+        skip -= obtained;
+    }
+    ALOGV("skipped to %zu frames, %lld frames skipped in total", mTargetFrames,
+            (long long) mFramesSkipped);
+}
+
+ssize_t MonoPipeSecondaryReader::read(void *buffer, size_t count)
+{
+    if (mTargetFrames > 0) {
+        skipToTarget();
+    }
+    size_t lost;
+    ssize_t actual = mFifoReader.read(buffer, count, NULL /*timeout*/, &lost);
+    ALOG_ASSERT(actual <= (ssize_t) count);
+    if (actual == -EOVERFLOW || lost > 0) {
+        mFramesOverrun += lost;
+        ++mOverruns;
+        actual = OVERRUN;
+    }
+    if (actual <= 0) {
+        return actual;
+    }
+    mFramesRead += (size_t) actual;
+    return actual;
+}
+
+ssize_t MonoPipeSecondaryReader::flush()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    size_t lost;
+    ssize_t flushed = mFifoReader.flush(&lost);
+    if (flushed == -EOVERFLOW || lost > 0) {
+        mFramesOverrun += lost;
+        ++mOverruns;
+        flushed = OVERRUN;
+    }
+    if (flushed <= 0) {
+        return flushed;
+    }
+    mFramesRead += (size_t) flushed;  // we consider flushed frames as read, but not lost frames
+    return flushed;
+}
+
+status_t MonoPipeSecondaryReader::getTimestamp(ExtendedTimestamp &timestamp)
+{
+    // Each reader has its own observer, so polling here does not consume the timestamp of
+    // MonoPipe::getTimestamp() or of other secondary readers.
+    ExtendedTimestamp ets;
+    if (mTimestampObserver.poll(ets)) {
+        mTimestamp = ets;
+        mTimestampValid = true;
+    }
+    if (!mTimestampValid) {
+        return INVALID_OPERATION;
+    }
+    // The position counts frames of the pipe, which this reader sees less the frames it lost
+    // or skipped.
+    timestamp.mPosition[ExtendedTimestamp::LOCATION_KERNEL] =
+            mTimestamp.mPosition[ExtendedTimestamp::LOCATION_KERNEL]
+            - mFramesOverrun - mFramesSkipped;
+    timestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL] =
+            mTimestamp.mTimeNs[ExtendedTimestamp::LOCATION_KERNEL];
+    return OK;
+}
+
+}   // namespace android
@@ -27,7 +27,8 @@ namespace android {
 typedef SingleStateQueue<ExtendedTimestamp> ExtendedTimestampSingleStateQueue;
 
 // MonoPipe is similar to Pipe except:
-//  - supports only a single reader, called MonoPipeReader
+//  - supports only a single throttling reader, called MonoPipeReader,
+//    plus any number of MonoPipeSecondaryReader that never slow down the writer
 //  - write() cannot overrun; instead it will return a short actual count if insufficient space
 //  - write() can optionally block if the pipe is full
 // Like Pipe, it is not multi-thread safe for either writer or reader
@@ -35,6 +36,7 @@ typedef SingleStateQueue<ExtendedTimestamp> ExtendedTimestampSingleStateQueue;
 class MonoPipe : public NBAIO_Sink {
 
     friend class MonoPipeReader;
+    friend class MonoPipeSecondaryReader;
 
 public:
     // reqFrames will be rounded up to a power of 2, and all slots are available. Must be >= 2.
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MONO_PIPE_SECONDARY_READER_H
+#define ANDROID_AUDIO_MONO_PIPE_SECONDARY_READER_H
+
+#include "MonoPipe.h"
+
+namespace android {
+
+// MonoPipeSecondaryReader is an additional reader of a MonoPipe, for consumers such as
+// capture taps or analysis that must never slow down the MonoPipeReader.
+// It has its own read index and does not throttle the writer, so reads and writes are
+// wait-free, but the writer can overrun it like a PipeReader.
+// There can be any number of secondary readers per MonoPipe; each is safe for only a single
+// reader thread.
+class MonoPipeSecondaryReader : public NBAIO_Source {
+
+public:
+
+    // What happens to the frames of this reader when the writer overruns it.
+    enum OverrunPolicy {
+        // Keep the oldest frames that are still valid, like PipeReader.
+        OVERRUN_KEEP_VALID,
+        // Discard all frames in the pipe and resume with the next frame written.
+        OVERRUN_FLUSH,
+    };
+
+    // Construct a MonoPipeSecondaryReader and associate it with a MonoPipe;
+    // any data already in the pipe is visible to this reader.
+    // If targetFrames is non-zero, read() skips the oldest frames whenever more than
+    // 2 * targetFrames are queued, so that the latency of this reader returns to about
+    // targetFrames independently of the other readers.
+    MonoPipeSecondaryReader(MonoPipe* pipe, OverrunPolicy policy = OVERRUN_KEEP_VALID,
+                            size_t targetFrames = 0);
+    virtual ~MonoPipeSecondaryReader();
+
+    // NBAIO_Port interface
+
+    //virtual ssize_t negotiate(const NBAIO_Format offers[], size_t numOffers,
+    //                          NBAIO_Format counterOffers[], size_t& numCounterOffers);
+    //virtual NBAIO_Format format() const;
+
+    // NBAIO_Source interface
+
+    //virtual size_t framesRead() const;
+    virtual int64_t framesOverrun() { return mFramesOverrun; }
+    virtual int64_t overruns()  { return mOverruns; }
+
+    virtual ssize_t availableToRead();
+
+    virtual ssize_t read(void *buffer, size_t count);
+
+    virtual ssize_t flush();
+
+    // NBAIO_Source end
+
+            size_t  getTargetFrames() const { return mTargetFrames; }
+            void    setTargetFrames(size_t targetFrames) { mTargetFrames = targetFrames; }
+
+            // Frames skipped to stay within the latency target, not counted as overrun.
+            int64_t framesSkipped() const { return mFramesSkipped; }
+
+            // The timestamp reported by the MonoPipeReader via onTimestamp(), with the
+            // position translated to the frames of this reader.
+            // Returns NO_ERROR if a timestamp is available.
+            status_t getTimestamp(ExtendedTimestamp &timestamp);
+
+private:
+            // Returns the frames available, or OVERRUN after accounting for the lost frames.
+            ssize_t checkedAvailable();
+            void    skipToTarget();
+
+    MonoPipe * const mPipe;
+    audio_utils_fifo_reader mFifoReader;
+    size_t          mTargetFrames;
+    int64_t         mFramesOverrun;
+    int64_t         mOverruns;
+    int64_t         mFramesSkipped;
+    // pipe position = position of this reader + mFramesOverrun + mFramesSkipped
+
+    ExtendedTimestampSingleStateQueue::Observer mTimestampObserver;
+    ExtendedTimestamp mTimestamp;       // last timestamp polled from the pipe
+    bool            mTimestampValid;    // whether mTimestamp is valid
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_MONO_PIPE_SECONDARY_READER_H
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <queue>
+#include <utility>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
@@ -170,20 +171,12 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
         case EVENT_UNDERRUN: {
             const int64_t ts = it.payload<int64_t>();
             data.underruns++;
-            data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
-            // TODO have a data structure to automatically handle resizing
-            if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
-                data.snapshots.pop_back();
-            }
+            data.addSnapshot(EVENT_UNDERRUN, ts);
         } break;
         case EVENT_OVERRUN: {
             const int64_t ts = it.payload<int64_t>();
             data.overruns++;
-            data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
-            // TODO have a data structure to automatically handle resizing
-            if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
-                data.snapshots.pop_back();
-            }
+            data.addSnapshot(EVENT_OVERRUN, ts);
         } break;
         case EVENT_RESERVED:
         case EVENT_UPPER_BOUND:
@@ -197,14 +190,15 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
 
 void MergeReader::getAndProcessSnapshot()
 {
-    // get a snapshot of each reader and process them
-    // TODO insert lock here
+    // get a snapshot of each reader and process them.
+    // Only the data written since the previous call is consumed, so this is cheap
+    // enough to be called both by the MergeThread and before each dump.
+    AutoMutex _l(mLock);
     const size_t nLogs = mReaders.size();
     std::vector<std::unique_ptr<Snapshot>> snapshots(nLogs);
     for (size_t i = 0; i < nLogs; i++) {
         snapshots[i] = mReaders[i]->getSnapshot();
     }
-    // TODO unlock lock here
     for (size_t i = 0; i < nLogs; i++) {
         if (snapshots[i] != nullptr) {
             processSnapshot(*(snapshots[i]), i);
@@ -227,7 +221,6 @@ void MergeReader::checkPushToMediaMetrics()
 
 void MergeReader::dump(int fd, const Vector<String16>& args)
 {
-    // TODO: add a mutex around media.log dump
     // Options for dumpsys
     bool pa = false, json = false, plots = false, retro = false;
     for (const auto &arg : args) {
@@ -241,17 +234,29 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
             retro = true;
         }
     }
+    if (!pa && !json && !plots && !retro) {
+        return;
+    }
+
+    // Catch up with the data logged since the last merge, then format a copy of the
+    // aggregates so that the MergeThread is not blocked while writing to fd.
+    getAndProcessSnapshot();
+    auto [threadPerformanceAnalysis, threadPerformanceData] = [this] {
+        AutoMutex _l(mLock);
+        return std::make_pair(mThreadPerformanceAnalysis, mThreadPerformanceData);
+    }();
+
     if (pa) {
-        ReportPerformance::dump(fd, 0 /*indent*/, mThreadPerformanceAnalysis);
+        ReportPerformance::dump(fd, 0 /*indent*/, threadPerformanceAnalysis);
     }
     if (json) {
-        ReportPerformance::dumpJson(fd, mThreadPerformanceData);
+        ReportPerformance::dumpJson(fd, threadPerformanceData);
     }
     if (plots) {
-        ReportPerformance::dumpPlots(fd, mThreadPerformanceData);
+        ReportPerformance::dumpPlots(fd, threadPerformanceData);
     }
     if (retro) {
-        ReportPerformance::dumpRetro(fd, mThreadPerformanceData);
+        ReportPerformance::dumpRetro(fd, threadPerformanceData);
     }
 }
 
@@ -288,10 +293,15 @@ bool MergeThread::threadLoop()
     bool doMerge;
     {
         AutoMutex _l(mMutex);
-        // If mTimeoutUs is negative, wait on the condition variable until it's positive.
-        // If it's positive, merge. The minimum period between waking the condition variable
+        // If mTimeoutUs is not positive, wait on the condition variable until it's positive.
+        // If it's positive, merge every kThreadSleepPeriodUs until the timeout runs out.
+        // The minimum period between waking the condition variable
         // is handled in AudioFlinger::MediaLogNotifier::threadLoop().
-        mCond.wait(mMutex);
+        if (mTimeoutUs > 0) {
+            mCond.waitRelative(mMutex, us2ns(kThreadSleepPeriodUs));
+        } else {
+            mCond.wait(mMutex);
+        }
         doMerge = mTimeoutUs > 0;
         mTimeoutUs -= kThreadSleepPeriodUs;
     }
@@ -205,14 +205,21 @@ void PerformanceAnalysis::logTsEntry(timestamp ts) {
     if (mHists.empty() ||
         deltaMs(mHists[0].first, ts) >= kMaxLength.HistTimespanMs) {
         mHists.emplace_front(ts, std::map<int, int>());
-        // When memory is full, delete oldest histogram
+        // When memory is full, delete oldest histogram and remove it from the total
         // TODO: use a circular buffer
-        if (mHists.size() >= kMaxLength.Hists) {
-            mHists.resize(kMaxLength.Hists);
+        while (mHists.size() > kMaxLength.Hists) {
+            for (const auto &countPair : mHists.back().second) {
+                auto it = mTotalHist.find(countPair.first);
+                if (it != mTotalHist.end() && (it->second -= countPair.second) <= 0) {
+                    mTotalHist.erase(it);
+                }
+            }
+            mHists.pop_back();
         }
     }
     // add current time intervals to histogram
     ++mHists[0].second[diffJiffy];
+    ++mTotalHist[diffJiffy];
     // update previous timestamp
     mBufferPeriod.mPrevTs = ts;
 }
@@ -353,12 +360,10 @@ void PerformanceAnalysis::reportPerformance(String8 *body, int author, log_hash_
 
     // histogram which stores .1 precision ms counts instead of Jiffy multiple counts
     std::map<double, int> buckets;
-    for (const auto &shortHist: mHists) {
-        for (const auto &countPair : shortHist.second) {
-            const double ms = static_cast<double>(countPair.first) / kJiffyPerMs;
-            buckets[logRound(ms, mBufferPeriod.mMean)] += countPair.second;
-            elapsedMs += ms * countPair.second;
-        }
+    for (const auto &countPair : mTotalHist) {
+        const double ms = static_cast<double>(countPair.first) / kJiffyPerMs;
+        buckets[logRound(ms, mBufferPeriod.mMean)] += countPair.second;
+        elapsedMs += ms * countPair.second;
     }
 
     static const int SIZE = 128;
@@ -80,12 +80,14 @@ public:
     void processSnapshot(Snapshot &snap, int author);
 
     // call getSnapshot of the content of the reader's buffer and process the data
+    // into the per-thread aggregates.
     void getAndProcessSnapshot();
 
     // check for periodic push of performance data to media metrics, and perform
     // the send if it is time to do so.
     void checkPushToMediaMetrics();
 
+    // dumps a snapshot of the per-thread aggregates, after processing any pending data.
     void dump(int fd, const Vector<String16>& args);
 
 private:
@@ -94,6 +96,10 @@ private:
     // The object is owned by the Merger class.
     const std::vector<sp<Reader>>& mReaders;
 
+    // protects the performance data below, which is updated by the MergeThread
+    // and read by dump().
+    Mutex mLock;
+
     // analyzes, compresses and stores the merged data
     // contains a separate instance for every author (thread), and for every source file
     // location within each author
@@ -166,6 +166,14 @@ struct PerformanceData {
     nsecs_t active = 0;
     nsecs_t start{systemTime()};
 
+    // Record an event in snapshots, dropping the oldest one when full.
+    void addSnapshot(NBLog::Event event, int64_t ts) {
+        snapshots.emplace_front(event, ts);
+        if (snapshots.size() > kMaxSnapshotsToStore) {
+            snapshots.pop_back();
+        }
+    }
+
     // Reset the performance data. This does not represent a thread state change.
     // Thread info is not reset here because the data is meant to be a continuation of the thread
     // that struct PerformanceData is associated with.
@@ -244,6 +252,10 @@ private:
     // stores buffer period histograms with timestamp of first sample
     std::deque<std::pair<timestamp, Hist>> mHists;
 
+    // sum of the histograms in mHists, updated as samples are added and histograms
+    // are dropped, so that reporting does not need to combine mHists.
+    Hist mTotalHist;
+
     // Parameters used when detecting outliers
     struct BufferPeriod {
         double    mMean = -1;          // average time between audio processing wakeups
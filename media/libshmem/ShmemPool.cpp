@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "media/ShmemPool.h"
+
+#include <string.h>
+
+#include "android-base/stringprintf.h"
+#include "binder/MemoryBase.h"
+#include "binder/MemoryHeapBase.h"
+#include "media/ShmemCompat.h"
+
+namespace android {
+namespace media {
+
+// Memory handed out by the pool, which keeps the usage of its heap up to date.
+class ShmemPool::PooledMemory : public MemoryBase {
+public:
+    PooledMemory(const sp<IMemoryHeap>& heap, ssize_t offset, size_t size,
+                 const sp<IMemory>& allocation, const std::shared_ptr<Usage>& usage)
+        : MemoryBase(heap, offset, size), mAllocation(allocation), mUsage(usage) {
+        mUsage->allocationCount++;
+        mUsage->bytes += size;
+    }
+
+    ~PooledMemory() override {
+        mUsage->allocationCount--;
+        mUsage->bytes -= size();
+    }
+
+private:
+    // Returned to the dealer, if any, when released.
+    const sp<IMemory> mAllocation;
+    const std::shared_ptr<Usage> mUsage;
+};
+
+const std::vector<ShmemPool::Tier>& ShmemPool::getDefaultTiers() {
+    static const std::vector<Tier> tiers{
+            {4 * 1024, 64 * 1024},
+            {64 * 1024, 1024 * 1024},
+    };
+    return tiers;
+}
+
+ShmemPool::ShmemPool(const char* name, const std::vector<Tier>& tiers, size_t maxHeapsPerTier)
+    : mName(name),
+      mMaxHeapsPerTier(maxHeapsPerTier),
+      mCreationTimeNs(systemTime()),
+      mDedicatedUsage(std::make_shared<Usage>()) {
+    for (const Tier& tier : tiers) {
+        mTiers.push_back({tier, {}});
+    }
+}
+
+sp<IMemory> ShmemPool::allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    sp<IMemory> result;
+    bool pooled = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (TierState& tierState : mTiers) {
+            if (size <= tierState.tier.maxAllocationSize) {
+                result = allocatePooled_l(tierState, size);
+                break;
+            }
+        }
+        pooled = result != nullptr;
+    }
+    if (!pooled) {
+        result = allocateDedicated(size);
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (result == nullptr) {
+        mFailureCount++;
+        return nullptr;
+    }
+    mAllocationCount++;
+    if (pooled) {
+        mPooledAllocationCount++;
+    }
+    return result;
+}
+
+bool ShmemPool::allocateSharedFileRegion(size_t size, SharedFileRegion* result,
+                                         sp<IMemory>* memory) {
+    assert(result != nullptr);
+    assert(memory != nullptr);
+
+    *memory = allocate(size);
+    if (*memory == nullptr) {
+        return false;
+    }
+    if (!convertIMemoryToSharedFileRegion(*memory, result)) {
+        memory->clear();
+        return false;
+    }
+    return true;
+}
+
+sp<IMemory> ShmemPool::allocatePooled_l(TierState& tierState, size_t size) {
+    sp<IMemory> allocation;
+    const Heap* heap = nullptr;
+    for (const Heap& candidate : tierState.heaps) {
+        allocation = candidate.dealer->allocate(size);
+        if (allocation != nullptr) {
+            heap = &candidate;
+            break;
+        }
+    }
+    if (allocation == nullptr) {
+        if (tierState.heaps.size() >= mMaxHeapsPerTier) {
+            return nullptr;
+        }
+        sp<MemoryDealer> dealer = new MemoryDealer(tierState.tier.heapSize, mName.c_str());
+        if (dealer->getMemoryHeap() == nullptr || dealer->getMemoryHeap()->getHeapID() < 0) {
+            return nullptr;
+        }
+        allocation = dealer->allocate(size);
+        if (allocation == nullptr) {
+            return nullptr;
+        }
+        tierState.heaps.push_back({dealer, std::make_shared<Usage>()});
+        heap = &tierState.heaps.back();
+    }
+
+    ssize_t offset;
+    size_t allocationSize;
+    sp<IMemoryHeap> memoryHeap = allocation->getMemory(&offset, &allocationSize);
+    // The heap is reused, so don't leak the previous content to the next peer.
+    memset(allocation->unsecurePointer(), 0, allocationSize);
+    return sp<PooledMemory>::make(memoryHeap, offset, allocationSize, allocation, heap->usage);
+}
+
+sp<IMemory> ShmemPool::allocateDedicated(size_t size) {
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(size, 0, mName.c_str());
+    if (heap->getHeapID() < 0) {
+        return nullptr;
+    }
+    return sp<PooledMemory>::make(heap, 0, size, nullptr, mDedicatedUsage);
+}
+
+void ShmemPool::trim() {
+    std::vector<Heap> released;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (TierState& tierState : mTiers) {
+            auto& heaps = tierState.heaps;
+            for (auto it = heaps.size() > 0 ? heaps.begin() + 1 : heaps.end();
+                    it != heaps.end();) {
+                if (it->usage->allocationCount == 0) {
+                    released.push_back(std::move(*it));
+                    it = heaps.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    // The heaps are unmapped and their file descriptors closed here, outside of the lock.
+}
+
+ShmemPool::Stats ShmemPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return getStats_l();
+}
+
+ShmemPool::Stats ShmemPool::getStats_l() const {
+    Stats stats{};
+    for (const TierState& tierState : mTiers) {
+        stats.heapCount += tierState.heaps.size();
+        for (const Heap& heap : tierState.heaps) {
+            stats.bytesInUse += heap.usage->bytes;
+        }
+    }
+    stats.dedicatedHeapCount = mDedicatedUsage->allocationCount;
+    stats.bytesInUse += mDedicatedUsage->bytes;
+    stats.allocationCount = mAllocationCount;
+    stats.pooledAllocationCount = mPooledAllocationCount;
+    stats.failureCount = mFailureCount;
+    const nsecs_t elapsedNs = systemTime() - mCreationTimeNs;
+    stats.allocationsPerSecond = elapsedNs > 0 ? mAllocationCount * 1e9 / elapsedNs : 0.;
+    return stats;
+}
+
+std::string ShmemPool::dump() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    const Stats stats = getStats_l();
+    std::string result = base::StringPrintf(
+            "ShmemPool %s: %zu pooled heaps, %zu dedicated heaps, %zu bytes in use\n"
+            "  %llu allocations (%llu pooled, %.2f/s), %llu failures\n",
+            mName.c_str(), stats.heapCount, stats.dedicatedHeapCount, stats.bytesInUse,
+            (unsigned long long)stats.allocationCount,
+            (unsigned long long)stats.pooledAllocationCount, stats.allocationsPerSecond,
+            (unsigned long long)stats.failureCount);
+    for (const TierState& tierState : mTiers) {
+        result.append(base::StringPrintf("  tier up to %zu bytes: %zu/%zu heaps of %zu bytes\n",
+                                         tierState.tier.maxAllocationSize, tierState.heaps.size(),
+                                         mMaxHeapsPerTier, tierState.tier.heapSize));
+    }
+    return result;
+}
+
+}  // namespace media
+}  // namespace android
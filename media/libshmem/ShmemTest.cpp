@@ -19,6 +19,7 @@
 #include "binder/MemoryHeapBase.h"
 #include "cutils/ashmem.h"
 #include "media/ShmemCompat.h"
+#include "media/ShmemPool.h"
 #include "media/ShmemUtil.h"
 
 namespace android {
@@ -114,6 +115,107 @@ TEST(ShmemTest, NullConversion) {
     ASSERT_EQ(nullptr, reconstructed);
 }
 
+TEST(ShmemTest, PoolSuballocates) {
+    sp<ShmemPool> pool = sp<ShmemPool>::make("ShmemTest");
+    sp<IMemory> first = pool->allocate(100);
+    sp<IMemory> second = pool->allocate(200);
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(100, first->size());
+    EXPECT_EQ(200, second->size());
+    EXPECT_EQ(first->getMemory()->getHeapID(), second->getMemory()->getHeapID());
+
+    ShmemPool::Stats stats = pool->getStats();
+    EXPECT_EQ(1, stats.heapCount);
+    EXPECT_EQ(0, stats.dedicatedHeapCount);
+    EXPECT_EQ(300, stats.bytesInUse);
+    EXPECT_EQ(2, stats.allocationCount);
+    EXPECT_EQ(2, stats.pooledAllocationCount);
+
+    first.clear();
+    second.clear();
+    stats = pool->getStats();
+    EXPECT_EQ(1, stats.heapCount);
+    EXPECT_EQ(0, stats.bytesInUse);
+}
+
+TEST(ShmemTest, PoolClearsReusedMemory) {
+    sp<ShmemPool> pool = sp<ShmemPool>::make("ShmemTest");
+    sp<IMemory> mem = pool->allocate(16);
+    ASSERT_NE(nullptr, mem);
+    memset(mem->unsecurePointer(), 0xff, 16);
+    mem.clear();
+
+    mem = pool->allocate(16);
+    ASSERT_NE(nullptr, mem);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(mem->unsecurePointer());
+    for (size_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(0, p[i]);
+    }
+}
+
+TEST(ShmemTest, PoolFallsBackToDedicatedHeap) {
+    sp<ShmemPool> pool = sp<ShmemPool>::make(
+            "ShmemTest", std::vector<ShmemPool::Tier>{{1024, 4096}}, 1 /* maxHeapsPerTier */);
+    sp<IMemory> large = pool->allocate(2048);
+    ASSERT_NE(nullptr, large);
+    std::vector<sp<IMemory>> small;
+    for (int i = 0; i < 8; ++i) {
+        small.push_back(pool->allocate(1024));
+        ASSERT_NE(nullptr, small.back());
+    }
+
+    ShmemPool::Stats stats = pool->getStats();
+    EXPECT_EQ(1, stats.heapCount);
+    EXPECT_GE(stats.dedicatedHeapCount, 5);
+    EXPECT_EQ(9, stats.allocationCount);
+    EXPECT_EQ(0, stats.failureCount);
+
+    large.clear();
+    small.clear();
+    stats = pool->getStats();
+    EXPECT_EQ(0, stats.dedicatedHeapCount);
+    EXPECT_EQ(0, stats.bytesInUse);
+}
+
+TEST(ShmemTest, PoolTrim) {
+    sp<ShmemPool> pool = sp<ShmemPool>::make(
+            "ShmemTest", std::vector<ShmemPool::Tier>{{1024, 4096}}, 4 /* maxHeapsPerTier */);
+    std::vector<sp<IMemory>> mems;
+    for (int i = 0; i < 8; ++i) {
+        mems.push_back(pool->allocate(1024));
+        ASSERT_NE(nullptr, mems.back());
+    }
+    EXPECT_GE(pool->getStats().heapCount, 2);
+
+    mems.clear();
+    pool->trim();
+    EXPECT_EQ(1, pool->getStats().heapCount);
+}
+
+TEST(ShmemTest, PoolSharedFileRegion) {
+    sp<ShmemPool> pool = sp<ShmemPool>::make("ShmemTest");
+    SharedFileRegion shmem;
+    sp<IMemory> mem;
+    ASSERT_TRUE(pool->allocateSharedFileRegion(3, &shmem, &mem));
+    ASSERT_NE(nullptr, mem);
+    ASSERT_EQ(3, shmem.size);
+    ASSERT_GE(shmem.fd.get(), 0);
+    ASSERT_TRUE(shmem.writeable);
+    uint8_t* p = reinterpret_cast<uint8_t*>(mem->unsecurePointer());
+    p[0] = 6;
+    p[1] = 5;
+    p[2] = 3;
+
+    sp<IMemory> reconstructed;
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(shmem, &reconstructed));
+    ASSERT_EQ(3, reconstructed->size());
+    const uint8_t* q = reinterpret_cast<const uint8_t*>(reconstructed->unsecurePointer());
+    EXPECT_EQ(6, q[0]);
+    EXPECT_EQ(5, q[1]);
+    EXPECT_EQ(3, q[2]);
+}
+
 }  // namespace
 }  // namespace media
 }  // namespace android
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// This module contains a pool of shared memory for small, frequent transfers, which suballocates
+// from a few large heaps instead of creating a new file descriptor and mapping per transfer.
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "android/media/SharedFileRegion.h"
+#include "binder/IMemory.h"
+#include "binder/MemoryDealer.h"
+#include "utils/RefBase.h"
+#include "utils/StrongPointer.h"
+#include "utils/Timers.h"
+
+namespace android {
+namespace media {
+
+/**
+ * A tiered pool of shared memory.
+ *
+ * Each tier serves allocations up to a maximum size, by suballocating from heaps of a fixed size
+ * that the tier creates on demand. Allocations too large for any tier, or made while their tier
+ * already has its maximum number of heaps in use, get a dedicated heap instead.
+ *
+ * An allocation is returned to its heap when the last reference to the returned IMemory goes
+ * away, including references held by remote processes through binder. A SharedFileRegion made
+ * from an allocation does not hold such a reference, so the caller must keep the IMemory until
+ * the peer is done with the region.
+ *
+ * A peer receiving a pooled region gets the file descriptor of the whole heap, so one pool must
+ * only serve transfers to peers that may see each other's data.
+ */
+class ShmemPool : public RefBase {
+public:
+    struct Tier {
+        size_t maxAllocationSize;
+        size_t heapSize;
+    };
+
+    struct Stats {
+        // Heaps held by the pool, each holding one file descriptor.
+        size_t heapCount;
+        // Dedicated heaps currently allocated, each holding one file descriptor.
+        size_t dedicatedHeapCount;
+        // Bytes currently allocated, from pooled and dedicated heaps.
+        size_t bytesInUse;
+        // Number of successful allocations since the pool was created.
+        uint64_t allocationCount;
+        // Number of those allocations that were served from a pooled heap.
+        uint64_t pooledAllocationCount;
+        // Number of failed allocations since the pool was created.
+        uint64_t failureCount;
+        // Average rate of allocations since the pool was created.
+        double allocationsPerSecond;
+    };
+
+    // Tiers of 4 KiB allocations from 64 KiB heaps, and of 64 KiB allocations from 1 MiB heaps.
+    static const std::vector<Tier>& getDefaultTiers();
+
+    static constexpr size_t kDefaultMaxHeapsPerTier = 4;
+
+    /**
+     * @param name Name given to the heaps, for debugging.
+     * @param tiers Tiers in increasing maxAllocationSize order.
+     * @param maxHeapsPerTier Maximum number of heaps each tier may hold.
+     */
+    explicit ShmemPool(const char* name,
+                       const std::vector<Tier>& tiers = getDefaultTiers(),
+                       size_t maxHeapsPerTier = kDefaultMaxHeapsPerTier);
+
+    /**
+     * Allocates zero-filled, writeable shared memory.
+     * @param size The size of the allocation. Must not be 0.
+     * @return The allocated memory, or null on failure.
+     */
+    sp<IMemory> allocate(size_t size);
+
+    /**
+     * Allocates zero-filled, writeable shared memory as a SharedFileRegion.
+     * @param size The size of the allocation. Must not be 0.
+     * @param result The resulting SharedFileRegion instance. May not be null.
+     * @param memory The allocated memory, which keeps the region allocated. May not be null.
+     * @return true if the allocation is successful.
+     */
+    bool allocateSharedFileRegion(size_t size, SharedFileRegion* result, sp<IMemory>* memory);
+
+    /**
+     * Releases the heaps that have no allocation outstanding, except for the first heap of each
+     * tier.
+     */
+    void trim();
+
+    Stats getStats() const;
+
+    std::string dump() const;
+
+private:
+    // Allocations outstanding from a heap, shared with the allocations themselves, which may
+    // outlive the pool.
+    struct Usage {
+        std::atomic<size_t> allocationCount{0};
+        std::atomic<size_t> bytes{0};
+    };
+
+    struct Heap {
+        sp<MemoryDealer> dealer;
+        std::shared_ptr<Usage> usage;
+    };
+
+    struct TierState {
+        Tier tier;
+        std::vector<Heap> heaps;
+    };
+
+    class PooledMemory;
+
+    sp<IMemory> allocatePooled_l(TierState& tierState, size_t size);
+    sp<IMemory> allocateDedicated(size_t size);
+    Stats getStats_l() const;
+
+    const std::string mName;
+    const size_t mMaxHeapsPerTier;
+    const nsecs_t mCreationTimeNs;
+    const std::shared_ptr<Usage> mDedicatedUsage;
+
+    mutable std::mutex mLock;
+    std::vector<TierState> mTiers;             // guarded by mLock
+    uint64_t mAllocationCount = 0;             // guarded by mLock
+    uint64_t mPooledAllocationCount = 0;       // guarded by mLock
+    uint64_t mFailureCount = 0;                // guarded by mLock
+};
+
+}  // namespace media
+}  // namespace android
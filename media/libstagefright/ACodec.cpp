@@ -1041,6 +1041,10 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
                         info.mData = info.mCodecData;
                         info.mMemRef = info.mCodecRef;
                     }
+                    if (portIndex == kPortIndexInput
+                            && mode == IOMX::kPortModePresetByteBuffer) {
+                        info.mHidlMemRef = hardware::HidlMemory::getInstance(hidlMemToken);
+                    }
                 }
 
                 mBuffers[portIndex].push(info);
@@ -1054,7 +1058,8 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
 
     std::vector<ACodecBufferChannel::BufferAndId> array(mBuffers[portIndex].size());
     for (size_t i = 0; i < mBuffers[portIndex].size(); ++i) {
-        array[i] = {mBuffers[portIndex][i].mData, mBuffers[portIndex][i].mBufferID};
+        array[i] = {mBuffers[portIndex][i].mData, mBuffers[portIndex][i].mBufferID,
+                mBuffers[portIndex][i].mHidlMemRef};
     }
     if (portIndex == kPortIndexInput) {
         mBufferChannel->setInputBufferArray(array);
@@ -5885,8 +5890,10 @@ void ACodec::sendFormatChange() {
             if (prevbufsize != 0) {
                 ALOGW("Replacing SkipCutBuffer holding %zu bytes", prevbufsize);
             }
+            mSkipCutBuffer->reset(mEncoderDelay, mEncoderPadding, channelCount);
+        } else {
+            mSkipCutBuffer = new SkipCutBuffer(mEncoderDelay, mEncoderPadding, channelCount);
         }
-        mSkipCutBuffer = new SkipCutBuffer(mEncoderDelay, mEncoderPadding, channelCount);
     }
 
     // mLastOutputFormat is not used when tunneled; doing this just to stay consistent
@@ -6781,16 +6788,11 @@ void ACodec::BaseState::onOutputBufferDrained(const sp<AMessage> &msg) {
             mCodec->mLastHdr10PlusBuffer = hdr10PlusInfo;
         }
 
-        // save buffers sent to the surface so we can get render time when they return
-        int64_t mediaTimeUs = -1;
-        buffer->meta()->findInt64("timeUs", &mediaTimeUs);
-        if (mediaTimeUs >= 0) {
-            mCodec->mRenderTracker.onFrameQueued(
-                    mediaTimeUs, info->mGraphicBuffer, new Fence(::dup(info->mFenceFd)));
-        }
-
         int64_t timestampNs = 0;
-        if (!msg->findInt64("timestampNs", &timestampNs)) {
+        int64_t desiredRenderTimeNs = -1;
+        if (msg->findInt64("timestampNs", &timestampNs)) {
+            desiredRenderTimeNs = timestampNs;
+        } else {
             // use media timestamp if client did not request a specific render timestamp
             if (buffer->meta()->findInt64("timeUs", &timestampNs)) {
                 ALOGV("using buffer PTS of %lld", (long long)timestampNs);
@@ -6798,6 +6800,15 @@ void ACodec::BaseState::onOutputBufferDrained(const sp<AMessage> &msg) {
             }
         }
 
+        // save buffers sent to the surface so we can get render time when they return
+        int64_t mediaTimeUs = -1;
+        buffer->meta()->findInt64("timeUs", &mediaTimeUs);
+        if (mediaTimeUs >= 0) {
+            mCodec->mRenderTracker.onFrameQueued(
+                    mediaTimeUs, info->mGraphicBuffer, new Fence(::dup(info->mFenceFd)),
+                    desiredRenderTimeNs);
+        }
+
         status_t err;
         err = native_window_set_buffers_timestamp(mCodec->mNativeWindow.get(), timestampNs);
         ALOGW_IF(err != NO_ERROR, "failed to set buffer timestamp: %d", err);
@@ -52,8 +52,15 @@ using BufferInfo = ACodecBufferChannel::BufferInfo;
 using BufferInfoIterator = std::vector<const BufferInfo>::const_iterator;
 
 ACodecBufferChannel::~ACodecBufferChannel() {
-    if (mCrypto != nullptr && mDealer != nullptr && mHeapSeqNum >= 0) {
-        mCrypto->unsetHeap(mHeapSeqNum);
+    if (mCrypto != nullptr) {
+        if (mDealer != nullptr && mHeapSeqNum >= 0) {
+            mCrypto->unsetHeap(mHeapSeqNum);
+        }
+        unsetCodecHeaps(std::atomic_load(&mInputBuffers));
+    }
+    if (mDecryptsInPlace + mDecryptCopies > 0) {
+        ALOGV("decrypted %lld buffers in place, %lld with a copy",
+                (long long)mDecryptsInPlace, (long long)mDecryptCopies);
     }
 }
 
@@ -76,21 +83,25 @@ static BufferInfoIterator findBufferId(
 ACodecBufferChannel::BufferInfo::BufferInfo(
         const sp<MediaCodecBuffer> &buffer,
         IOMX::buffer_id bufferId,
-        const sp<IMemory> &sharedEncryptedBuffer)
+        const sp<IMemory> &sharedEncryptedBuffer,
+        int32_t codecHeapSeqNum)
     : mClientBuffer(
           (sharedEncryptedBuffer == nullptr)
           ? buffer
           : new SharedMemoryBuffer(buffer->format(), sharedEncryptedBuffer)),
       mCodecBuffer(buffer),
       mBufferId(bufferId),
-      mSharedEncryptedBuffer(sharedEncryptedBuffer) {
+      mSharedEncryptedBuffer(sharedEncryptedBuffer),
+      mCodecHeapSeqNum(codecHeapSeqNum) {
 }
 
 ACodecBufferChannel::ACodecBufferChannel(
         const sp<AMessage> &inputBufferFilled, const sp<AMessage> &outputBufferDrained)
     : mInputBufferFilled(inputBufferFilled),
       mOutputBufferDrained(outputBufferDrained),
-      mHeapSeqNum(-1) {
+      mHeapSeqNum(-1),
+      mDecryptsInPlace(0),
+      mDecryptCopies(0) {
 }
 
 status_t ACodecBufferChannel::queueInputBuffer(const sp<MediaCodecBuffer> &buffer) {
@@ -161,8 +172,7 @@ status_t ACodecBufferChannel::queueSecureInputBuffer(
             destination.secureMemory = hidl_handle(secureHandle);
         } else {
             destination.type = DrmBufferType::SHARED_MEMORY;
-            IMemoryToSharedBuffer(
-                    mDecryptDestination, mHeapSeqNum, &destination.nonsecureMemory);
+            setNonsecureDestination(*it, &destination.nonsecureMemory);
         }
 
         hardware::drm::V1_0::SharedBuffer source;
@@ -177,7 +187,7 @@ status_t ACodecBufferChannel::queueSecureInputBuffer(
         }
 
         if (destination.type == DrmBufferType::SHARED_MEMORY) {
-            memcpy(it->mCodecBuffer->base(), mDecryptDestination->unsecurePointer(), result);
+            copyDecryptedContent(*it, result);
         }
     } else {
         // Here we cast CryptoPlugin::SubSample to hardware::cas::native::V1_0::SubSample
@@ -316,6 +326,39 @@ status_t ACodecBufferChannel::attachBuffer(
     return OK;
 }
 
+void ACodecBufferChannel::setNonsecureDestination(
+        const BufferInfo &info, hardware::drm::V1_0::SharedBuffer *destination) {
+    if (info.mCodecHeapSeqNum >= 0) {
+        // the codec buffer is registered with the plugin, so decrypt straight into it.
+        destination->bufferId = info.mCodecHeapSeqNum;
+        destination->offset = 0;
+        destination->size = info.mCodecBuffer->capacity();
+    } else {
+        IMemoryToSharedBuffer(mDecryptDestination, mHeapSeqNum, destination);
+    }
+}
+
+void ACodecBufferChannel::copyDecryptedContent(const BufferInfo &info, ssize_t size) {
+    if (info.mCodecHeapSeqNum >= 0) {
+        ++mDecryptsInPlace;
+        return;
+    }
+    memcpy(info.mCodecBuffer->base(), mDecryptDestination->unsecurePointer(), size);
+    ++mDecryptCopies;
+}
+
+void ACodecBufferChannel::unsetCodecHeaps(
+        const std::shared_ptr<const std::vector<const BufferInfo>> &array) {
+    if (array == nullptr) {
+        return;
+    }
+    for (const BufferInfo &elem : *array) {
+        if (elem.mCodecHeapSeqNum >= 0) {
+            mCrypto->unsetHeap(elem.mCodecHeapSeqNum);
+        }
+    }
+}
+
 int32_t ACodecBufferChannel::getHeapSeqNum(const sp<HidlMemory> &memory) {
     CHECK(mCrypto);
     auto it = mHeapSeqNumMap.find(memory);
@@ -370,8 +413,7 @@ status_t ACodecBufferChannel::attachEncryptedBuffer(
             destination.secureMemory = hidl_handle(secureHandle);
         } else {
             destination.type = DrmBufferType::SHARED_MEMORY;
-            IMemoryToSharedBuffer(
-                    mDecryptDestination, mHeapSeqNum, &destination.nonsecureMemory);
+            setNonsecureDestination(*it, &destination.nonsecureMemory);
         }
 
         int32_t heapSeqNum = getHeapSeqNum(memory);
@@ -386,7 +428,7 @@ status_t ACodecBufferChannel::attachEncryptedBuffer(
         }
 
         if (destination.type == DrmBufferType::SHARED_MEMORY) {
-            memcpy(it->mCodecBuffer->base(), mDecryptDestination->unsecurePointer(), result);
+            copyDecryptedContent(*it, result);
         }
     } else {
         // Here we cast CryptoPlugin::SubSample to hardware::cas::native::V1_0::SubSample
@@ -566,13 +608,26 @@ void ACodecBufferChannel::setInputBufferArray(const std::vector<BufferAndId> &ar
             mDecryptDestination = mDealer->allocate(destinationBufferSize);
         }
     }
+    if (mCrypto != nullptr) {
+        unsetCodecHeaps(std::atomic_load(&mInputBuffers));
+    }
     std::vector<const BufferInfo> inputBuffers;
     for (const BufferAndId &elem : array) {
         sp<IMemory> sharedEncryptedBuffer;
+        int32_t codecHeapSeqNum = -1;
         if (hasCryptoOrDescrambler()) {
             sharedEncryptedBuffer = mDealer->allocate(elem.mBuffer->capacity());
         }
-        inputBuffers.emplace_back(elem.mBuffer, elem.mBufferId, sharedEncryptedBuffer);
+        if (mCrypto != nullptr && elem.mMemory != nullptr) {
+            // Register the codec buffer once for the lifetime of the array, so that
+            // non-secure decryption does not need to go through mDecryptDestination.
+            codecHeapSeqNum = mCrypto->setHeap(elem.mMemory);
+            if (codecHeapSeqNum < 0) {
+                ALOGW("setHeap failed for buffer #%d, decrypting with a copy", elem.mBufferId);
+            }
+        }
+        inputBuffers.emplace_back(
+                elem.mBuffer, elem.mBufferId, sharedEncryptedBuffer, codecHeapSeqNum);
     }
     std::atomic_store(
             &mInputBuffers,
@@ -18,14 +18,18 @@
 #define LOG_TAG "NetworkSession"
 #include <utils/Log.h>
 
+#include <algorithm>
+
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <linux/tcp.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <time.h>
 
 #include <media/stagefright/ANetworkSession.h>
 #include <media/stagefright/ParsedMessage.h>
@@ -39,6 +43,25 @@ namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 static const int32_t kMaxUDPRetries = 200;
+static const size_t kMaxUDPBatch = 16;
+static const size_t kMaxPollEvents = 32;
+
+// Epoll tag of the interrupt pipe, session IDs start at 1.
+static const uint32_t kInterruptPollID = 0;
+
+// Returns the SO_TIMESTAMPNS receive time of |msg| in CLOCK_REALTIME.
+static bool getReceiveTimeUs(struct msghdr *msg, int64_t *timeUs) {
+    for (struct cmsghdr *cMsg = CMSG_FIRSTHDR(msg); cMsg != NULL;
+            cMsg = CMSG_NXTHDR(msg, cMsg)) {
+        if (cMsg->cmsg_level == SOL_SOCKET && cMsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cMsg), sizeof(ts));
+            *timeUs = ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+            return true;
+        }
+    }
+    return false;
+}
 
 struct ANetworkSession::NetworkThread : public Thread {
     explicit NetworkThread(ANetworkSession *session);
@@ -84,6 +107,10 @@ struct ANetworkSession::Session : public RefBase {
     bool wantsToRead();
     bool wantsToWrite();
 
+    // EPOLLIN/EPOLLOUT the socket is registered for, 0 if not registered.
+    uint32_t pollEvents() const;
+    void setPollEvents(uint32_t events);
+
     status_t readMore();
     status_t writeMore();
 
@@ -114,6 +141,10 @@ private:
     sp<AMessage> mNotify;
     bool mSawReceiveFailure, mSawSendFailure;
     int32_t mUDPRetries;
+    uint32_t mPollEvents;
+
+    // Datagrams of a single recvmmsg(), kMaxUDPBatch of kMaxUDPSize.
+    uint8_t *mRecvBuffer;
 
     List<Fragment> mOutFragments;
 
@@ -158,6 +189,8 @@ ANetworkSession::Session::Session(
       mSawReceiveFailure(false),
       mSawSendFailure(false),
       mUDPRetries(kMaxUDPRetries),
+      mPollEvents(0),
+      mRecvBuffer(NULL),
       mLastStallReportUs(-1ll) {
     if (mState == CONNECTED) {
         struct sockaddr_in localAddr;
@@ -206,6 +239,8 @@ ANetworkSession::Session::~Session() {
 
     close(mSocket);
     mSocket = -1;
+
+    delete[] mRecvBuffer;
 }
 
 int32_t ANetworkSession::Session::sessionID() const {
@@ -253,40 +288,83 @@ bool ANetworkSession::Session::wantsToWrite() {
             || (mState == DATAGRAM && !mOutFragments.empty()));
 }
 
+uint32_t ANetworkSession::Session::pollEvents() const {
+    return mPollEvents;
+}
+
+void ANetworkSession::Session::setPollEvents(uint32_t events) {
+    mPollEvents = events;
+}
+
 status_t ANetworkSession::Session::readMore() {
     if (mState == DATAGRAM) {
         CHECK_EQ(mMode, MODE_DATAGRAM);
 
+        if (mRecvBuffer == NULL) {
+            mRecvBuffer = new uint8_t[kMaxUDPBatch * kMaxUDPSize];
+        }
+
+        const size_t kControlSize = CMSG_SPACE(sizeof(struct timespec));
+
+        struct mmsghdr msgs[kMaxUDPBatch];
+        struct iovec iov[kMaxUDPBatch];
+        struct sockaddr_in remoteAddrs[kMaxUDPBatch];
+        char control[kMaxUDPBatch][kControlSize];
+
         status_t err;
         do {
-            sp<ABuffer> buf = new ABuffer(kMaxUDPSize);
-
-            struct sockaddr_in remoteAddr;
-            socklen_t remoteAddrLen = sizeof(remoteAddr);
+            memset(msgs, 0, sizeof(msgs));
+            for (size_t i = 0; i < kMaxUDPBatch; ++i) {
+                iov[i].iov_base = mRecvBuffer + i * kMaxUDPSize;
+                iov[i].iov_len = kMaxUDPSize;
+
+                msgs[i].msg_hdr.msg_name = &remoteAddrs[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(remoteAddrs[i]);
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_control = control[i];
+                msgs[i].msg_hdr.msg_controllen = kControlSize;
+            }
 
-            ssize_t n;
+            int count;
             do {
-                n = recvfrom(
-                        mSocket, buf->data(), buf->capacity(), 0,
-                        (struct sockaddr *)&remoteAddr, &remoteAddrLen);
-            } while (n < 0 && errno == EINTR);
+                count = recvmmsg(mSocket, msgs, kMaxUDPBatch, 0, NULL);
+            } while (count < 0 && errno == EINTR);
 
             err = OK;
-            if (n < 0) {
+            if (count < 0) {
                 err = -errno;
-            } else if (n == 0) {
-                err = -ECONNRESET;
-            } else {
-                buf->setRange(0, n);
+                break;
+            }
 
-                int64_t nowUs = ALooper::GetNowUs();
-                buf->meta()->setInt64("arrivalTimeUs", nowUs);
+            // Kernel receive times are CLOCK_REALTIME, arrivalTimeUs is ALooper time.
+            struct timespec realNow;
+            clock_gettime(CLOCK_REALTIME, &realNow);
+            int64_t nowUs = ALooper::GetNowUs();
+            int64_t realNowUs = realNow.tv_sec * 1000000LL + realNow.tv_nsec / 1000;
+
+            for (int i = 0; i < count; ++i) {
+                size_t n = msgs[i].msg_len;
+                if (n == 0) {
+                    err = -ECONNRESET;
+                    break;
+                }
+
+                sp<ABuffer> buf = new ABuffer(n);
+                memcpy(buf->data(), iov[i].iov_base, n);
+
+                int64_t arrivalTimeUs = nowUs;
+                int64_t receiveTimeUs;
+                if (getReceiveTimeUs(&msgs[i].msg_hdr, &receiveTimeUs)) {
+                    arrivalTimeUs = std::min(nowUs, nowUs - (realNowUs - receiveTimeUs));
+                }
+                buf->meta()->setInt64("arrivalTimeUs", arrivalTimeUs);
 
                 sp<AMessage> notify = mNotify->dup();
                 notify->setInt32("sessionID", mSessionID);
                 notify->setInt32("reason", kWhatDatagram);
 
-                uint32_t ip = ntohl(remoteAddr.sin_addr.s_addr);
+                uint32_t ip = ntohl(remoteAddrs[i].sin_addr.s_addr);
                 notify->setString(
                         "fromAddr",
                         AStringPrintf(
@@ -296,11 +374,16 @@ status_t ANetworkSession::Session::readMore() {
                             (ip >> 8) & 0xff,
                             ip & 0xff).c_str());
 
-                notify->setInt32("fromPort", ntohs(remoteAddr.sin_port));
+                notify->setInt32("fromPort", ntohs(remoteAddrs[i].sin_port));
 
                 notify->setBuffer("data", buf);
                 notify->post();
             }
+
+            if (err == OK && (size_t)count < kMaxUDPBatch) {
+                // The socket has been drained.
+                break;
+            }
         } while (err == OK);
 
         if (err == -EAGAIN) {
@@ -786,12 +869,23 @@ void ANetworkSession::Session::notify(NotificationReason reason) {
 ////////////////////////////////////////////////////////////////////////////////
 
 ANetworkSession::ANetworkSession()
-    : mNextSessionID(1) {
+    : mNextSessionID(1),
+      mEpollFd(-1) {
     mPipeFd[0] = mPipeFd[1] = -1;
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpollFd < 0) {
+        ALOGE("Error creating epoll fd (%s)", strerror(errno));
+    }
 }
 
 ANetworkSession::~ANetworkSession() {
     stop();
+
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
 }
 
 status_t ANetworkSession::start() {
@@ -799,12 +893,29 @@ status_t ANetworkSession::start() {
         return INVALID_OPERATION;
     }
 
+    if (mEpollFd < 0) {
+        return NO_INIT;
+    }
+
     int res = pipe(mPipeFd);
     if (res != 0) {
         mPipeFd[0] = mPipeFd[1] = -1;
         return -errno;
     }
 
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = kInterruptPollID;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mPipeFd[0], &event) < 0) {
+        status_t err = -errno;
+
+        close(mPipeFd[0]);
+        close(mPipeFd[1]);
+        mPipeFd[0] = mPipeFd[1] = -1;
+
+        return err;
+    }
+
     mThread = new NetworkThread(this);
 
     status_t err = mThread->run("ANetworkSession", ANDROID_PRIORITY_AUDIO);
@@ -833,6 +944,7 @@ status_t ANetworkSession::stop() {
 
     mThread.clear();
 
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, mPipeFd[0], NULL);
     close(mPipeFd[0]);
     close(mPipeFd[1]);
     mPipeFd[0] = mPipeFd[1] = -1;
@@ -925,6 +1037,7 @@ status_t ANetworkSession::destroySession(int32_t sessionID) {
         return -ENOENT;
     }
 
+    removeFromPoll(mSessions.valueAt(index));
     mSessions.removeItemsAt(index);
 
     interrupt();
@@ -984,6 +1097,12 @@ status_t ANetworkSession::createClientOrServer(
     }
 
     if (mode == kModeCreateUDPSession) {
+        // readMore() reports the kernel receive time as the arrival time
+        const int enable = 1;
+        if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+            ALOGW("Unable to enable receive timestamps (%s)", strerror(errno));
+        }
+
         int size = 256 * 1024;
 
         res = setsockopt(s, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
@@ -1137,6 +1256,7 @@ status_t ANetworkSession::createClientOrServer(
     }
 
     mSessions.add(session->sessionID(), session);
+    updatePollEvents(session);
 
     interrupt();
 
@@ -1204,6 +1324,7 @@ status_t ANetworkSession::sendRequest(
     const sp<Session> session = mSessions.valueAt(index);
 
     status_t err = session->sendRequest(data, size, timeValid, timeUs);
+    updatePollEvents(session);
 
     interrupt();
 
@@ -1236,43 +1357,56 @@ void ANetworkSession::interrupt() {
     }
 }
 
-void ANetworkSession::threadLoop() {
-    fd_set rs, ws;
-    FD_ZERO(&rs);
-    FD_ZERO(&ws);
-
-    FD_SET(mPipeFd[0], &rs);
-    int maxFd = mPipeFd[0];
+void ANetworkSession::updatePollEvents(const sp<Session> &session) {
+    int s = session->socket();
+    if (s < 0 || mEpollFd < 0) {
+        return;
+    }
 
-    {
-        Mutex::Autolock autoLock(mLock);
+    uint32_t events = 0;
+    if (session->wantsToRead()) {
+        events |= EPOLLIN;
+    }
+    if (session->wantsToWrite()) {
+        events |= EPOLLOUT;
+    }
 
-        for (size_t i = 0; i < mSessions.size(); ++i) {
-            const sp<Session> &session = mSessions.valueAt(i);
+    uint32_t oldEvents = session->pollEvents();
+    if (events == oldEvents) {
+        return;
+    }
 
-            int s = session->socket();
+    // An idle socket is taken out of the set altogether, otherwise a hangup
+    // nobody is interested in would wake up the network thread forever.
+    int res;
+    if (events == 0) {
+        res = epoll_ctl(mEpollFd, EPOLL_CTL_DEL, s, NULL);
+    } else {
+        struct epoll_event event = {};
+        event.events = events;
+        event.data.u32 = session->sessionID();
+        res = epoll_ctl(
+                mEpollFd, oldEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, s, &event);
+    }
 
-            if (s < 0) {
-                continue;
-            }
+    if (res < 0) {
+        ALOGE("Unable to poll socket %d (%s)", s, strerror(errno));
+        return;
+    }
 
-            if (session->wantsToRead()) {
-                FD_SET(s, &rs);
-                if (s > maxFd) {
-                    maxFd = s;
-                }
-            }
+    session->setPollEvents(events);
+}
 
-            if (session->wantsToWrite()) {
-                FD_SET(s, &ws);
-                if (s > maxFd) {
-                    maxFd = s;
-                }
-            }
-        }
+void ANetworkSession::removeFromPoll(const sp<Session> &session) {
+    if (session->pollEvents() != 0 && session->socket() >= 0) {
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, session->socket(), NULL);
     }
+    session->setPollEvents(0);
+}
 
-    int res = select(maxFd + 1, &rs, &ws, NULL, NULL /* tv */);
+void ANetworkSession::threadLoop() {
+    struct epoll_event events[kMaxPollEvents];
+    int res = epoll_wait(mEpollFd, events, kMaxPollEvents, -1 /* timeout */);
 
     if (res == 0) {
         return;
@@ -1283,32 +1417,36 @@ void ANetworkSession::threadLoop() {
             return;
         }
 
-        ALOGE("select failed w/ error %d (%s)", errno, strerror(errno));
+        ALOGE("epoll_wait failed w/ error %d (%s)", errno, strerror(errno));
         return;
     }
 
-    if (FD_ISSET(mPipeFd[0], &rs)) {
-        char c;
-        ssize_t n;
-        do {
-            n = read(mPipeFd[0], &c, 1);
-        } while (n < 0 && errno == EINTR);
-
-        if (n < 0) {
-            ALOGW("Error reading from pipe (%s)", strerror(errno));
-        }
-
-        --res;
-    }
-
     {
         Mutex::Autolock autoLock(mLock);
 
         List<sp<Session> > sessionsToAdd;
 
-        for (size_t i = mSessions.size(); res > 0 && i > 0;) {
-            i--;
-            const sp<Session> &session = mSessions.valueAt(i);
+        for (int i = 0; i < res; ++i) {
+            if (events[i].data.u32 == kInterruptPollID) {
+                char c;
+                ssize_t n;
+                do {
+                    n = read(mPipeFd[0], &c, 1);
+                } while (n < 0 && errno == EINTR);
+
+                if (n < 0) {
+                    ALOGW("Error reading from pipe (%s)", strerror(errno));
+                }
+                continue;
+            }
+
+            // The session may have been destroyed since epoll_wait returned.
+            ssize_t index = mSessions.indexOfKey((int32_t)events[i].data.u32);
+            if (index < 0) {
+                continue;
+            }
+
+            const sp<Session> session = mSessions.valueAt(index);
 
             int s = session->socket();
 
@@ -1316,11 +1454,14 @@ void ANetworkSession::threadLoop() {
                 continue;
             }
 
-            if (FD_ISSET(s, &rs) || FD_ISSET(s, &ws)) {
-                --res;
+            // Errors and hangups surface through the read or write they interrupt.
+            uint32_t ready = events[i].events;
+            if (ready & (EPOLLERR | EPOLLHUP)) {
+                ready |= EPOLLIN | EPOLLOUT;
             }
+            ready &= session->pollEvents();
 
-            if (FD_ISSET(s, &rs)) {
+            if (ready & EPOLLIN) {
                 if (session->isRTSPServer() || session->isTCPDatagramServer()) {
                     struct sockaddr_in remoteAddr;
                     socklen_t remoteAddrLen = sizeof(remoteAddr);
@@ -1377,13 +1518,15 @@ void ANetworkSession::threadLoop() {
                 }
             }
 
-            if (FD_ISSET(s, &ws)) {
+            if (ready & EPOLLOUT) {
                 status_t err = session->writeMore();
                 if (err != OK) {
                     ALOGE("writeMore on socket %d failed w/ error %d (%s)",
                           s, err, strerror(-err));
                 }
             }
+
+            updatePollEvents(session);
         }
 
         while (!sessionsToAdd.empty()) {
@@ -1391,6 +1534,7 @@ void ANetworkSession::threadLoop() {
             sessionsToAdd.erase(sessionsToAdd.begin());
 
             mSessions.add(session->sessionID(), session);
+            updatePollEvents(session);
 
             ALOGI("added clientSession %d", session->sessionID());
         }
@@ -91,6 +91,12 @@ CameraSourceTimeLapse::CameraSourceTimeLapse(
         mInitCheck = NO_INIT;
     }
 
+    // Frames between time lapse frames are still skipped, but the camera
+    // does not need to capture as many of them.
+    if (OK == mInitCheck && mTimeBetweenFrameCaptureUs > mTimeBetweenTimeLapseVideoFramesUs) {
+        (void)trySettingSlowestFpsRange();
+    }
+
     // Initialize quick stop variables.
     mQuickStop = false;
     mForceRead = false;
@@ -165,6 +171,44 @@ bool CameraSourceTimeLapse::trySettingVideoSize(
     return isSuccessful;
 }
 
+bool CameraSourceTimeLapse::trySettingSlowestFpsRange() {
+    ALOGV("trySettingSlowestFpsRange");
+    int64_t token = IPCThreadState::self()->clearCallingIdentity();
+    String8 s = mCamera->getParameters();
+
+    CameraParameters params(s);
+    const char *supportedRanges = params.get(CameraParameters::KEY_SUPPORTED_PREVIEW_FPS_RANGE);
+    int minFps = -1;
+    int maxFps = -1;
+    // Ranges are listed as "(min,max),(min,max),..." in fps * 1000. Pick the
+    // one with the lowest maximum, then the lowest minimum.
+    for (const char *p = supportedRanges; p != NULL && (p = strchr(p, '(')) != NULL; ++p) {
+        int min, max;
+        if (sscanf(p, "(%d,%d)", &min, &max) != 2 || min <= 0 || max < min) {
+            continue;
+        }
+        if (maxFps < 0 || max < maxFps || (max == maxFps && min < minFps)) {
+            minFps = min;
+            maxFps = max;
+        }
+    }
+
+    bool isSuccessful = false;
+    if (maxFps > 0) {
+        String8 range = String8::format("%d,%d", minFps, maxFps);
+        params.set(CameraParameters::KEY_PREVIEW_FPS_RANGE, range.c_str());
+        if (mCamera->setParameters(params.flatten()) == OK) {
+            ALOGD("Time lapse capture at fps range %s", range.c_str());
+            isSuccessful = true;
+        } else {
+            ALOGW("Failed to set preview fps range to %s", range.c_str());
+        }
+    }
+
+    IPCThreadState::self()->restoreCallingIdentity(token);
+    return isSuccessful;
+}
+
 void CameraSourceTimeLapse::signalBufferReturned(MediaBufferBase* buffer) {
     ALOGV("signalBufferReturned");
     Mutex::Autolock autoLock(mQuickStopLock);
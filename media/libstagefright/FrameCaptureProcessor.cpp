@@ -28,6 +28,9 @@
 
 namespace android {
 
+// mediaserver's own data directory.
+static const char kProgramBinaryCachePath[] = "/data/misc/media/renderfright_programs.bin";
+
 //static
 Mutex FrameCaptureProcessor::sLock;
 //static
@@ -125,11 +128,15 @@ status_t FrameCaptureProcessor::onCreate() {
                 .setEnableProtectedContext(false)
                 .setPrecacheToneMapperShaderOnly(true)
                 .setContextPriority(renderengine::RenderEngine::ContextPriority::LOW)
+                .setProgramBinaryCachePath(kProgramBinaryCachePath)
                 .build());
 
     if (mRE == nullptr) {
         return ERROR_UNSUPPORTED;
     }
+    // Load the tone mapping programs now, from their saved binaries once
+    // they were compiled, instead of on the first HDR capture.
+    mRE->primeCache();
     return OK;
 }
 
@@ -20,8 +20,10 @@
 #include "include/FrameDecoder.h"
 #include "include/FrameCaptureLayer.h"
 #include "include/HevcUtils.h"
+#include <algorithm>
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
 #include <mediadrm/ICrypto.h>
@@ -47,6 +49,9 @@ namespace android {
 static const int64_t kBufferTimeOutUs = 10000LL; // 10 msec
 static const size_t kRetryCount = 100; // must be >0
 static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
+// frames up to this far after the last output are decoded to rather than seeked to.
+static const int64_t kMaxForwardDecodeUs = 1000000LL; // 1 sec
+static const int32_t kMaxImageDecoders = 4;
 
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
@@ -262,13 +267,17 @@ FrameDecoder::FrameDecoder(
       mSource(source),
       mDstFormat(OMX_COLOR_Format16bitRGB565),
       mDstBpp(2),
+      mInputCount(0),
+      mOutputCount(0),
       mHaveMoreInputs(true),
       mFirstSample(true) {
 }
 
 FrameDecoder::~FrameDecoder() {
-    if (mDecoder != NULL) {
-        mDecoder->release();
+    if (!mDecoders.empty()) {
+        for (const sp<MediaCodec> &decoder : mDecoders) {
+            decoder->release();
+        }
         mSource->stop();
     }
 }
@@ -300,39 +309,66 @@ status_t FrameDecoder::init(
         return ERROR_UNSUPPORTED;
     }
 
+    std::vector<sp<MediaCodec>> decoders;
+    const size_t decoderCount = mSurface == NULL ? std::max(onGetDecoderCount(), (size_t)1) : 1;
+    status_t err = OK;
+    while (decoders.size() < decoderCount) {
+        sp<MediaCodec> decoder;
+        err = startDecoder(videoFormat, &decoder);
+        if (err != OK) {
+            break;
+        }
+        decoders.push_back(decoder);
+    }
+    if (decoders.empty()) {
+        return err;
+    }
+    if (decoders.size() < decoderCount) {
+        // the codec resources are exhausted, use the instances we got.
+        ALOGW("using %zu of %zu decoders [%s]",
+                decoders.size(), decoderCount, mComponentName.c_str());
+    }
+
+    err = mSource->start();
+    if (err != OK) {
+        ALOGW("source failed to start: %d (%s)", err, asString(err));
+        for (const sp<MediaCodec> &decoder : decoders) {
+            decoder->release();
+        }
+        return err;
+    }
+    mDecoders = decoders;
+
+    return OK;
+}
+
+status_t FrameDecoder::startDecoder(
+        const sp<AMessage> &videoFormat, sp<MediaCodec> *decoder) {
     status_t err;
     sp<ALooper> looper = new ALooper;
     looper->start();
-    sp<MediaCodec> decoder = MediaCodec::CreateByComponentName(
+    sp<MediaCodec> codec = MediaCodec::CreateByComponentName(
             looper, mComponentName, &err);
-    if (decoder.get() == NULL || err != OK) {
+    if (codec.get() == NULL || err != OK) {
         ALOGW("Failed to instantiate decoder [%s]", mComponentName.c_str());
-        return (decoder.get() == NULL) ? NO_MEMORY : err;
+        return (codec.get() == NULL) ? NO_MEMORY : err;
     }
 
-    err = decoder->configure(
+    err = codec->configure(
             videoFormat, mSurface, NULL /* crypto */, 0 /* flags */);
     if (err != OK) {
         ALOGW("configure returned error %d (%s)", err, asString(err));
-        decoder->release();
+        codec->release();
         return err;
     }
 
-    err = decoder->start();
+    err = codec->start();
     if (err != OK) {
         ALOGW("start returned error %d (%s)", err, asString(err));
-        decoder->release();
+        codec->release();
         return err;
     }
-
-    err = mSource->start();
-    if (err != OK) {
-        ALOGW("source failed to start: %d (%s)", err, asString(err));
-        decoder->release();
-        return err;
-    }
-    mDecoder = decoder;
-
+    *decoder = codec;
     return OK;
 }
 
@@ -348,6 +384,36 @@ sp<IMemory> FrameDecoder::extractFrame(FrameRect *rect) {
     return mFrameMemory;
 }
 
+status_t FrameDecoder::seekTo(int64_t frameTimeUs, int option) {
+    if (mDecoders.empty()) {
+        return NO_INIT;
+    }
+
+    bool decodeForward = false;
+    status_t err = onSeekTo(frameTimeUs, option, &mReadOptions,
+            mHaveMoreInputs /* canDecodeForward */, &decodeForward);
+    if (err != OK) {
+        return err;
+    }
+    mFrameMemory.clear();
+    if (decodeForward) {
+        return OK;
+    }
+
+    for (const sp<MediaCodec> &decoder : mDecoders) {
+        err = decoder->flush();
+        if (err != OK) {
+            ALOGW("flush returned error %d (%s)", err, asString(err));
+            return err;
+        }
+    }
+    mInputCount = 0;
+    mOutputCount = 0;
+    mHaveMoreInputs = true;
+    mFirstSample = true;
+    return OK;
+}
+
 status_t FrameDecoder::extractInternal() {
     status_t err = OK;
     bool done = false;
@@ -361,7 +427,8 @@ status_t FrameDecoder::extractInternal() {
         // outputs. After getting each output, come back and queue the inputs
         // again to keep the decoder busy.
         while (mHaveMoreInputs) {
-            err = mDecoder->dequeueInputBuffer(&index, 0);
+            const sp<MediaCodec> &decoder = mDecoders[mInputCount % mDecoders.size()];
+            err = decoder->dequeueInputBuffer(&index, 0);
             if (err != OK) {
                 ALOGV("Timed out waiting for input");
                 if (retriesLeft) {
@@ -370,7 +437,7 @@ status_t FrameDecoder::extractInternal() {
                 break;
             }
             sp<MediaCodecBuffer> codecBuffer;
-            err = mDecoder->getInputBuffer(index, &codecBuffer);
+            err = decoder->getInputBuffer(index, &codecBuffer);
             if (err != OK) {
                 ALOGE("failed to get input buffer %zu", index);
                 break;
@@ -383,7 +450,7 @@ status_t FrameDecoder::extractInternal() {
             if (err != OK) {
                 mHaveMoreInputs = false;
                 if (!mFirstSample && err == ERROR_END_OF_STREAM) {
-                    (void)mDecoder->queueInputBuffer(
+                    (void)decoder->queueInputBuffer(
                             index, 0, 0, 0, MediaCodec::BUFFER_FLAG_EOS);
                     err = OK;
                 } else {
@@ -415,12 +482,13 @@ status_t FrameDecoder::extractInternal() {
                 ALOGV("QueueInput: size=%zu ts=%" PRId64 " us flags=%x",
                         codecBuffer->size(), ptsUs, flags);
 
-                err = mDecoder->queueInputBuffer(
+                err = decoder->queueInputBuffer(
                         index,
                         codecBuffer->offset(),
                         codecBuffer->size(),
                         ptsUs,
                         flags);
+                ++mInputCount;
 
                 if (flags & MediaCodec::BUFFER_FLAG_EOS) {
                     mHaveMoreInputs = false;
@@ -429,9 +497,11 @@ status_t FrameDecoder::extractInternal() {
         }
 
         while (err == OK) {
+            // outputs are in input order as long as each decoder outputs in order.
+            const sp<MediaCodec> &decoder = mDecoders[mOutputCount % mDecoders.size()];
             size_t offset, size;
             // wait for a decoded buffer
-            err = mDecoder->dequeueOutputBuffer(
+            err = decoder->dequeueOutputBuffer(
                     &index,
                     &offset,
                     &size,
@@ -441,7 +511,7 @@ status_t FrameDecoder::extractInternal() {
 
             if (err == INFO_FORMAT_CHANGED) {
                 ALOGV("Received format change");
-                err = mDecoder->getOutputFormat(&mOutputFormat);
+                err = decoder->getOutputFormat(&mOutputFormat);
             } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
                 ALOGV("Output buffers changed");
                 err = OK;
@@ -454,17 +524,18 @@ status_t FrameDecoder::extractInternal() {
                     // from the extractor, decode to the specified frame. Otherwise we're done.
                     ALOGV("Received an output buffer, timeUs=%lld", (long long)ptsUs);
                     sp<MediaCodecBuffer> videoFrameBuffer;
-                    err = mDecoder->getOutputBuffer(index, &videoFrameBuffer);
+                    err = decoder->getOutputBuffer(index, &videoFrameBuffer);
                     if (err != OK) {
                         ALOGE("failed to get output buffer %zu", index);
                         break;
                     }
+                    ++mOutputCount;
                     if (mSurface != nullptr) {
-                        mDecoder->renderOutputBufferAndRelease(index);
+                        decoder->renderOutputBufferAndRelease(index);
                         err = onOutputReceived(videoFrameBuffer, mOutputFormat, ptsUs, &done);
                     } else {
                         err = onOutputReceived(videoFrameBuffer, mOutputFormat, ptsUs, &done);
-                        mDecoder->releaseOutputBuffer(index);
+                        decoder->releaseOutputBuffer(index);
                     }
                 } else {
                     ALOGW("Received error %d (%s) instead of output", err, asString(err));
@@ -494,6 +565,7 @@ VideoFrameDecoder::VideoFrameDecoder(
       mIsHevc(false),
       mSeekMode(MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC),
       mTargetTimeUs(-1LL),
+      mLastOutputTimeUs(-1LL),
       mDefaultSampleDurationUs(0) {
 }
 
@@ -570,6 +642,42 @@ sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
     return videoFormat;
 }
 
+status_t VideoFrameDecoder::onSeekTo(
+        int64_t frameTimeUs, int seekMode,
+        MediaSource::ReadOptions *options,
+        bool canDecodeForward, bool *decodeForward) {
+    if (seekMode < MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC ||
+            seekMode > MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        ALOGE("Unknown seek mode: %d", seekMode);
+        return BAD_VALUE;
+    }
+    mSeekMode = static_cast<MediaSource::ReadOptions::SeekMode>(seekMode);
+
+    // the previous frame belongs to the caller now.
+    mFrame = NULL;
+
+    // A seek restarts decoding from the previous sync frame, so a nearby later
+    // frame is reached faster by decoding on from the last output.
+    if (canDecodeForward
+            && mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST
+            && mLastOutputTimeUs >= 0
+            && frameTimeUs > mLastOutputTimeUs
+            && frameTimeUs - mLastOutputTimeUs <= kMaxForwardDecodeUs) {
+        ALOGV("Decoding forward from %lld to %lld us",
+                (long long)mLastOutputTimeUs, (long long)frameTimeUs);
+        mTargetTimeUs = frameTimeUs;
+        *decodeForward = true;
+        return OK;
+    }
+
+    mTargetTimeUs = -1LL;
+    mLastOutputTimeUs = -1LL;
+    mSampleDurations.clear();
+    options->setSeekTo(frameTimeUs < 0 ? 0 : frameTimeUs, mSeekMode);
+    *decodeForward = false;
+    return OK;
+}
+
 status_t VideoFrameDecoder::onInputReceived(
         const sp<MediaCodecBuffer> &codecBuffer,
         MetaDataBase &sampleMeta, bool firstSample, uint32_t *flags) {
@@ -616,6 +724,7 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
 
     *done = true;
+    mLastOutputTimeUs = timeUs;
 
     if (outputFormat == NULL) {
         return ERROR_MALFORMED;
@@ -870,6 +979,18 @@ sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
     return videoFormat;
 }
 
+size_t MediaImageDecoder::onGetDecoderCount() {
+    // Grid tiles are coded independently, so they can be decoded on several
+    // codec instances at once. This is opt-in, as it takes codec resources
+    // that other clients may need.
+    const size_t tiles = mGridRows * mGridCols;
+    if (tiles <= 1) {
+        return 1;
+    }
+    int32_t maxDecoders = property_get_int32("media.stagefright.heif.max_decoders", 1);
+    return std::min((size_t)std::clamp(maxDecoders, 1, kMaxImageDecoders), tiles);
+}
+
 status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
     // TODO:
     // This callback is for verifying whether we can decode the rect,
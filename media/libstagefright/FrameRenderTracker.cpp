@@ -18,6 +18,7 @@
 #define LOG_TAG "FrameRenderTracker"
 
 #include <inttypes.h>
+#include <string.h>
 #include <gui/Surface.h>
 
 #include <media/stagefright/foundation/ADebug.h>
@@ -25,9 +26,15 @@
 
 namespace android {
 
+// early, within a 60Hz vsync, and late by up to 1, 2 and 3 vsyncs at 60Hz
+const int64_t FrameRenderTracker::kRenderErrorBucketLimitsUs[kNumRenderErrorBuckets - 1] = {
+    -8000, -4000, 4000, 8000, 16700, 33300, 50000,
+};
+
 FrameRenderTracker::FrameRenderTracker()
     : mLastRenderTimeNs(-1),
       mComponentName("unknown component") {
+    memset(mRenderErrorCounts, 0, sizeof(mRenderErrorCounts));
 }
 
 FrameRenderTracker::~FrameRenderTracker() {
@@ -43,8 +50,9 @@ void FrameRenderTracker::clear(nsecs_t lastRenderTimeNs) {
 }
 
 void FrameRenderTracker::onFrameQueued(
-        int64_t mediaTimeUs, const sp<GraphicBuffer> &graphicBuffer, const sp<Fence> &fence) {
-    mRenderQueue.emplace_back(mediaTimeUs, graphicBuffer, fence);
+        int64_t mediaTimeUs, const sp<GraphicBuffer> &graphicBuffer, const sp<Fence> &fence,
+        nsecs_t desiredRenderTimeNs) {
+    mRenderQueue.emplace_back(mediaTimeUs, graphicBuffer, fence, desiredRenderTimeNs);
 }
 
 FrameRenderTracker::Info *FrameRenderTracker::updateInfoForDequeuedBuffer(
@@ -130,6 +138,9 @@ std::list<FrameRenderTracker::Info> FrameRenderTracker::checkFencesAndGetRendere
                 // save render time
                 it->mFence.clear();
                 it->mRenderTimeNs = signalTime;
+                if (it->mDesiredRenderTimeNs >= 0) {
+                    addRenderError(signalTime - it->mDesiredRenderTimeNs);
+                }
             }
         }
         bool foundFrame = (Info *)&*it == until;
@@ -170,6 +181,19 @@ void FrameRenderTracker::untrackFrame(const FrameRenderTracker::Info *info, ssiz
     }
 }
 
+void FrameRenderTracker::addRenderError(nsecs_t errorNs) {
+    int64_t errorUs = errorNs / 1000;
+    size_t i = 0;
+    while (i < kNumRenderErrorBuckets - 1 && errorUs >= kRenderErrorBucketLimitsUs[i]) {
+        ++i;
+    }
+    ++mRenderErrorCounts[i];
+}
+
+void FrameRenderTracker::getRenderErrorHistogram(uint64_t counts[kNumRenderErrorBuckets]) const {
+    memcpy(counts, mRenderErrorCounts, sizeof(mRenderErrorCounts));
+}
+
 void FrameRenderTracker::dumpRenderQueue() const {
     ALOGI("[%s] Render Queue: (last render time: %lldns)",
             mComponentName.c_str(), (long long)mLastRenderTimeNs);
@@ -188,6 +212,17 @@ void FrameRenderTracker::dumpRenderQueue() const {
                     it->mGraphicBuffer->handle, (long long)it->mMediaTimeUs, it->mIndex);
         }
     }
+
+    AString histogram;
+    for (size_t i = 0; i < kNumRenderErrorBuckets; ++i) {
+        if (i < kNumRenderErrorBuckets - 1) {
+            histogram.append(AStringPrintf(" <%lldus:", (long long)kRenderErrorBucketLimitsUs[i]));
+        } else {
+            histogram.append(" more:");
+        }
+        histogram.append(AStringPrintf("%llu", (unsigned long long)mRenderErrorCounts[i]));
+    }
+    ALOGI("[%s] Render errors:%s", mComponentName.c_str(), histogram.c_str());
 }
 
 }  // namespace android
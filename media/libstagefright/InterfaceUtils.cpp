@@ -40,11 +40,12 @@ sp<IDataSource> CreateIDataSourceFromDataSource(const sp<DataSource> &source) {
 sp<IMediaExtractor> CreateIMediaExtractorFromMediaExtractor(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin) {
+        const sp<RefBase> &plugin,
+        int64_t openTimeUs) {
     if (extractor == nullptr) {
         return nullptr;
     }
-    return RemoteMediaExtractor::wrap(extractor, source, plugin);
+    return RemoteMediaExtractor::wrap(extractor, source, plugin, openTimeUs);
 }
 
 sp<MediaSource> CreateMediaSourceFromIMediaSource(const sp<IMediaSource> &source) {
@@ -526,6 +526,11 @@ status_t MPEG2TSWriter::start(MetaData *param ) {
     mNumTSPacketsWritten = 0;
     mNumTSPacketsBeforeMeta = 0;
 
+    // The sources are fixed once started, so the program tables and their CRCs
+    // only need to be built once.
+    buildProgramAssociationTable(mProgramTables);
+    buildProgramMap(mProgramTables + kTSPacketSize);
+
     for (size_t i = 0; i < mSources.size(); ++i) {
         sp<AMessage> notify =
             new AMessage(kWhatSourceNotify, mReflector);
@@ -661,7 +666,7 @@ void MPEG2TSWriter::onMessageReceived(const sp<AMessage> &msg) {
     }
 }
 
-void MPEG2TSWriter::writeProgramAssociationTable() {
+void MPEG2TSWriter::buildProgramAssociationTable(uint8_t *packet) {
     // 0x47
     // transport_error_indicator = b0
     // payload_unit_start_indicator = b1
@@ -698,22 +703,14 @@ void MPEG2TSWriter::writeProgramAssociationTable() {
         0x00, 0x00, 0x00, 0x00   // b???? ???? ???? ???? ???? ???? ???? ????
     };
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
-    memcpy(buffer->data(), kData, sizeof(kData));
-
-    if (++mPATContinuityCounter == 16) {
-        mPATContinuityCounter = 0;
-    }
-    buffer->data()[3] |= mPATContinuityCounter;
-
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12));
-    memcpy(&buffer->data()[17], &crc, sizeof(crc));
+    memset(packet, 0xff, kTSPacketSize);
+    memcpy(packet, kData, sizeof(kData));
 
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
+    uint32_t crc = htonl(crc32(&packet[5], 12));
+    memcpy(&packet[17], &crc, sizeof(crc));
 }
 
-void MPEG2TSWriter::writeProgramMap() {
+void MPEG2TSWriter::buildProgramMap(uint8_t *packet) {
     // 0x47
     // transport_error_indicator = b0
     // payload_unit_start_indicator = b1
@@ -755,24 +752,18 @@ void MPEG2TSWriter::writeProgramMap() {
         0xe0, 0x00, 0xf0, 0x00   // b111? ???? ???? ???? 1111 0000 0000 0000
     };
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
-    memcpy(buffer->data(), kData, sizeof(kData));
-
-    if (++mPMTContinuityCounter == 16) {
-        mPMTContinuityCounter = 0;
-    }
-    buffer->data()[3] |= mPMTContinuityCounter;
+    memset(packet, 0xff, kTSPacketSize);
+    memcpy(packet, kData, sizeof(kData));
 
     size_t section_length = 5 * mSources.size() + 4 + 9;
-    buffer->data()[6] |= section_length >> 8;
-    buffer->data()[7] = section_length & 0xff;
+    packet[6] |= section_length >> 8;
+    packet[7] = section_length & 0xff;
 
     static const unsigned kPCR_PID = 0x1e1;
-    buffer->data()[13] |= (kPCR_PID >> 8) & 0x1f;
-    buffer->data()[14] = kPCR_PID & 0xff;
+    packet[13] |= (kPCR_PID >> 8) & 0x1f;
+    packet[14] = kPCR_PID & 0xff;
 
-    uint8_t *ptr = &buffer->data()[sizeof(kData)];
+    uint8_t *ptr = &packet[sizeof(kData)];
     for (size_t i = 0; i < mSources.size(); ++i) {
         *ptr++ = mSources.editItemAt(i)->streamType();
 
@@ -783,10 +774,8 @@ void MPEG2TSWriter::writeProgramMap() {
         *ptr++ = 0x00;
     }
 
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12+mSources.size()*5));
-    memcpy(&buffer->data()[17+mSources.size()*5], &crc, sizeof(crc));
-
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
+    uint32_t crc = htonl(crc32(&packet[5], 12+mSources.size()*5));
+    memcpy(&packet[17+mSources.size()*5], &crc, sizeof(crc));
 }
 
 void MPEG2TSWriter::writeAccessUnit(
@@ -826,8 +815,23 @@ void MPEG2TSWriter::writeAccessUnit(
     // reserved = b1
     // the first fragment of "buffer" follows
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
+    // All TS packets of the access unit are built into one buffer, which is
+    // written at once. The first packet carries up to 170 bytes after the PES
+    // header, each of the others up to 184 bytes.
+    const size_t kFirstPayloadSize = kTSPacketSize - 18;
+    const size_t kPayloadSize = kTSPacketSize - 4;
+    size_t numPackets = 1;
+    if (accessUnit->size() > kFirstPayloadSize) {
+        numPackets += (accessUnit->size() - kFirstPayloadSize + kPayloadSize - 1)
+                / kPayloadSize;
+    }
+    const size_t size = numPackets * kTSPacketSize;
+    if (mPacketBuffer == NULL || mPacketBuffer->capacity() < size) {
+        mPacketBuffer = new ABuffer(size);
+    }
+    mPacketBuffer->setRange(0, size);
+    memset(mPacketBuffer->data(), 0xff, size);
+    uint8_t *packet = mPacketBuffer->data();
 
     const unsigned PID = 0x1e0 + sourceIndex + 1;
 
@@ -855,7 +859,7 @@ void MPEG2TSWriter::writeAccessUnit(
         PES_packet_length = 0;
     }
 
-    uint8_t *ptr = buffer->data();
+    uint8_t *ptr = packet;
     *ptr++ = 0x47;
     *ptr++ = 0x40 | (PID >> 8);
     *ptr++ = PID & 0xff;
@@ -883,7 +887,7 @@ void MPEG2TSWriter::writeAccessUnit(
     *ptr++ = (PTS >> 7) & 0xff;
     *ptr++ = ((PTS & 0x7f) << 1) | 1;
 
-    size_t sizeLeft = buffer->data() + buffer->size() - ptr;
+    size_t sizeLeft = packet + kTSPacketSize - ptr;
     size_t copy = accessUnit->size();
     if (copy > sizeLeft) {
         copy = sizeLeft;
@@ -891,8 +895,6 @@ void MPEG2TSWriter::writeAccessUnit(
 
     memcpy(ptr, accessUnit->data(), copy);
 
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
-
     size_t offset = copy;
     while (offset < accessUnit->size()) {
         bool lastAccessUnit = ((accessUnit->size() - offset) < 184);
@@ -907,12 +909,12 @@ void MPEG2TSWriter::writeAccessUnit(
         // continuity_counter = b????
         // the fragment of "buffer" follows.
 
-        memset(buffer->data(), 0xff, buffer->size());
+        packet += kTSPacketSize;
 
         const unsigned continuity_counter =
             mSources.editItemAt(sourceIndex)->incrementContinuityCounter();
 
-        ptr = buffer->data();
+        ptr = packet;
         *ptr++ = 0x47;
         *ptr++ = 0x00 | (PID >> 8);
         *ptr++ = PID & 0xff;
@@ -929,24 +931,39 @@ void MPEG2TSWriter::writeAccessUnit(
             }
         }
 
-        size_t sizeLeft = buffer->data() + buffer->size() - ptr;
+        size_t sizeLeft = packet + kTSPacketSize - ptr;
         size_t copy = accessUnit->size() - offset;
         if (copy > sizeLeft) {
             copy = sizeLeft;
         }
 
         memcpy(ptr, accessUnit->data() + offset, copy);
-        CHECK_EQ(internalWrite(buffer->data(), buffer->size()),
-                 (ssize_t)buffer->size());
 
         offset += copy;
     }
+
+    CHECK_EQ(internalWrite(mPacketBuffer->data(), size), (ssize_t)size);
+    mNumTSPacketsWritten += numPackets;
 }
 
 void MPEG2TSWriter::writeTS() {
     if (mNumTSPacketsWritten >= mNumTSPacketsBeforeMeta) {
-        writeProgramAssociationTable();
-        writeProgramMap();
+        // Only the continuity counters change between repetitions. They are in
+        // the TS headers, outside of the sections covered by the CRCs.
+        if (++mPATContinuityCounter == 16) {
+            mPATContinuityCounter = 0;
+        }
+        mProgramTables[3] = (mProgramTables[3] & 0xf0) | mPATContinuityCounter;
+
+        if (++mPMTContinuityCounter == 16) {
+            mPMTContinuityCounter = 0;
+        }
+        mProgramTables[kTSPacketSize + 3] =
+            (mProgramTables[kTSPacketSize + 3] & 0xf0) | mPMTContinuityCounter;
+
+        CHECK_EQ(internalWrite(mProgramTables, sizeof(mProgramTables)),
+                 (ssize_t)sizeof(mProgramTables));
+        mNumTSPacketsWritten += 2;
 
         mNumTSPacketsBeforeMeta = mNumTSPacketsWritten + 2500;
     }
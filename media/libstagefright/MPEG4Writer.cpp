@@ -30,8 +30,10 @@
 
 #include <utils/Log.h>
 
+#include <condition_variable>
 #include <functional>
 #include <fcntl.h>
+#include <thread>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -73,6 +75,27 @@ static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
+// Coalesced writes go out in blocks of this size, ending on aligned file offsets.
+static const size_t kWriteBlockSize = 2 * 1024 * 1024;
+static const size_t kWriteBlockAlignment = 4096;
+// fallocate() reaches this far past what the next sample needs.
+static const uint64_t kPreAllocateExtentSize = 8 * 1024 * 1024;
+// Upper bounds of the write latency histogram buckets but the last.
+static const int64_t kWriteLatencyBucketsUs[] = {500, 2000, 10000, 50000, 200000, 1000000};
+static const size_t kNumWriteLatencyBounds =
+        sizeof(kWriteLatencyBucketsUs) / sizeof(kWriteLatencyBucketsUs[0]);
+// The sidx box of a fragmented file gets room for this much recording unless
+// a max duration is set, within kSidxMaxSize.
+static const int64_t kSidxDefaultDurationUs = 60 * 60 * 1000000LL;  // 1 hour
+static const int64_t kSidxHeaderSize = 40;  // version 1 with 64 bit times
+static const int64_t kSidxEntrySize = 12;
+static const int64_t kSidxMaxSize = 1024 * 1024;
+// The writer thread takes up to this many chunks, in timestamp order across the
+// tracks, each time it holds the lock.
+static const size_t kMaxChunksPerBatch = 8;
+// When not recording in real time, a track thread waits for the writer before
+// queueing more chunks than this.
+static const size_t kMaxQueuedChunksPerTrack = 4;
 
 static const char kMetaKey_Version[]    = "com.android.version";
 static const char kMetaKey_Manufacturer[]      = "com.android.manufacturer";
@@ -153,10 +176,12 @@ public:
     void writeTrackHeader();
     int64_t getMinCttsOffsetTimeUs();
     void bufferChunk(int64_t timestampUs);
+    void bufferFragment();
     bool isAvc() const { return mIsAvc; }
     bool isHevc() const { return mIsHevc; }
     bool isHeic() const { return mIsHeic; }
     bool isAudio() const { return mIsAudio; }
+    bool isVideo() const { return mIsVideo; }
     bool isMPEG4() const { return mIsMPEG4; }
     bool usePrefix() const { return mIsAvc || mIsHevc || mIsHeic || mIsDovi; }
     bool isExifData(MediaBufferBase *buffer, uint32_t *tiffHdrOffset) const;
@@ -170,6 +195,14 @@ public:
     const char *getTrackType() const;
     void resetInternal();
     int64_t trackMetaDataSize();
+    uint32_t getSampleCount() const;
+    void addFragmentIndexEntry(off64_t moofOffset, int64_t timeTicks, uint32_t durationTicks);
+    void writeTrexBox();
+    size_t getSidxBoxSize() const;
+    bool canWriteSidxBox(off64_t fragmentsEndOffset) const;
+    void writeSidxBox(off64_t fragmentsEndOffset);
+    size_t getTfraBoxSize() const;
+    void writeTfraBox();
 
 private:
     // A helper class to handle faster write box with table entries
@@ -338,6 +371,19 @@ private:
 
     List<MediaBuffer *> mChunkSamples;
 
+    // Fragmented files keep no sample tables. The samples of the fragment being
+    // collected are described in mFragmentSamples, and written ones only leave
+    // an entry per fragment for the sidx and tfra boxes.
+    struct FragmentIndexEntry {
+        off64_t mMoofOffset;
+        int64_t mTimeTicks;         // Earliest presentation time
+        uint32_t mDurationTicks;
+    };
+    std::vector<FragmentSample> mFragmentSamples;
+    int64_t mFragmentDecodeTimeTicks;  // Of the next fragment, -1 before the first one
+    uint32_t mFragmentedSampleCount;
+    std::vector<FragmentIndexEntry> mFragmentIndex;
+
     bool mSamplesHaveSameSize;
     ListTableEntries<uint32_t, 1> *mStszTableEntries;
     ListTableEntries<off64_t, 1> *mCo64TableEntries;
@@ -492,6 +538,189 @@ private:
     Track &operator=(const Track &);
 };
 
+// Writes the file in blocks of kWriteBlockSize. The writer thread fills one
+// block while a second one is written out with pwrite64() on a thread of its
+// own. Each block is pushed to storage with sync_file_range() one block
+// behind and then dropped from the page cache, so that dirty pages do not
+// pile up into a writeback stall that blocks the writer thread.
+class MPEG4Writer::BlockWriter {
+public:
+    BlockWriter(MPEG4Writer *owner, int fd);
+    ~BlockWriter();
+
+    // Queues |count| bytes to be written at |offset|. Returns false once a
+    // write has failed.
+    bool write(off64_t offset, const void *data, size_t count);
+
+    // Writes out everything queued and waits for it to complete.
+    bool flush();
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> mData;
+        off64_t mOffset;
+        size_t mSize;
+        size_t mLimit;
+    };
+
+    MPEG4Writer *mOwner;
+    int mFd;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    Block mBlocks[2];
+    Block *mFilling;  // Only touched by the writer thread.
+    Block *mWriting;  // Handed to mThread, NULL when it is idle.
+    bool mError;
+    bool mDone;
+
+    // The block written before the current one, still in writeback.
+    off64_t mSyncOffset;
+    size_t mSyncSize;
+
+    std::thread mThread;
+
+    void submit();
+    bool writeBlock(const Block &block);
+    void threadLoop();
+
+    BlockWriter(const BlockWriter &);
+    BlockWriter &operator=(const BlockWriter &);
+};
+
+MPEG4Writer::BlockWriter::BlockWriter(MPEG4Writer *owner, int fd)
+    : mOwner(owner),
+      mFd(fd),
+      mFilling(&mBlocks[0]),
+      mWriting(NULL),
+      mError(false),
+      mDone(false),
+      mSyncOffset(0),
+      mSyncSize(0) {
+    for (Block &block : mBlocks) {
+        block.mData.reset(new uint8_t[kWriteBlockSize]);
+        block.mOffset = 0;
+        block.mSize = 0;
+        block.mLimit = kWriteBlockSize;
+    }
+    mThread = std::thread(&BlockWriter::threadLoop, this);
+}
+
+MPEG4Writer::BlockWriter::~BlockWriter() {
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        mDone = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+bool MPEG4Writer::BlockWriter::write(off64_t offset, const void *data, size_t count) {
+    const uint8_t *src = (const uint8_t *)data;
+    while (count > 0) {
+        if (mFilling->mSize > 0 && offset != mFilling->mOffset + (off64_t)mFilling->mSize) {
+            // Not contiguous, e.g. a box size patched after the fact. Blocks
+            // are written in order, so the later write still wins.
+            submit();
+        }
+        if (mFilling->mSize == 0) {
+            mFilling->mOffset = offset;
+            mFilling->mLimit = kWriteBlockSize - (offset % kWriteBlockAlignment);
+        }
+
+        size_t n = std::min(count, mFilling->mLimit - mFilling->mSize);
+        memcpy(mFilling->mData.get() + mFilling->mSize, src, n);
+        mFilling->mSize += n;
+        src += n;
+        offset += n;
+        count -= n;
+
+        if (mFilling->mSize == mFilling->mLimit) {
+            submit();
+        }
+    }
+
+    std::lock_guard<std::mutex> l(mLock);
+    return !mError;
+}
+
+bool MPEG4Writer::BlockWriter::flush() {
+    if (mFilling->mSize > 0) {
+        submit();
+    }
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait(lock, [this] { return mWriting == NULL; });
+    return !mError;
+}
+
+void MPEG4Writer::BlockWriter::submit() {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait(lock, [this] { return mWriting == NULL; });
+    mWriting = mFilling;
+    mFilling = (mFilling == &mBlocks[0]) ? &mBlocks[1] : &mBlocks[0];
+    mFilling->mSize = 0;
+    mCondition.notify_all();
+}
+
+bool MPEG4Writer::BlockWriter::writeBlock(const Block &block) {
+    auto beforeTP = std::chrono::steady_clock::now();
+    size_t written = 0;
+    while (written < block.mSize) {
+        ssize_t n = pwrite64(mFd, block.mData.get() + written, block.mSize - written,
+                block.mOffset + written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ALOGE("BlockWriter pwrite64 offset:%" PRId64 " size:%zu error:%s(%d)",
+                  (int64_t)block.mOffset, block.mSize, std::strerror(errno), errno);
+            return false;
+        }
+        written += n;
+    }
+    auto afterTP = std::chrono::steady_clock::now();
+    mOwner->recordWriteLatency(
+            std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count());
+
+    // Start writeback of this block and wait for the previous one, which
+    // bounds the dirty pages to two blocks. Failures only lose the pacing.
+    sync_file_range(mFd, block.mOffset, block.mSize, SYNC_FILE_RANGE_WRITE);
+    if (mSyncSize > 0) {
+        sync_file_range(mFd, mSyncOffset, mSyncSize,
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise64(mFd, mSyncOffset, mSyncSize, POSIX_FADV_DONTNEED);
+    }
+    mSyncOffset = block.mOffset;
+    mSyncSize = block.mSize;
+    return true;
+}
+
+void MPEG4Writer::BlockWriter::threadLoop() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4BlockWriter", 0, 0, 0);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCondition.wait(lock, [this] { return mWriting != NULL || mDone; });
+        if (mWriting == NULL) {
+            break;
+        }
+
+        // Nothing is written after a failure, the file is malformed anyway.
+        const Block *block = mWriting;
+        bool error = mError;
+        lock.unlock();
+        if (!error) {
+            error = !writeBlock(*block);
+        }
+        lock.lock();
+
+        mError = error;
+        mWriting = NULL;
+        mCondition.notify_all();
+    }
+}
+
 MPEG4Writer::MPEG4Writer(int fd) {
     initInternal(dup(fd), true /*isFirstSession*/);
 }
@@ -537,6 +766,12 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mOffset = 0;
     mMaxOffsetAppend = 0;
     mPreAllocateFileEndOffset = 0;
+    mPreAllocatedExtentEnd = 0;
+    mFragmentDurationUs = 0;
+    mFragmentHeaderWritten = false;
+    mFragmentSequenceNumber = 0;
+    mSidxOffset = 0;
+    mSidxReservedSize = 0;
     mMdatOffset = 0;
     mMdatEndOffset = 0;
     mInMemoryCache = NULL;
@@ -569,6 +804,10 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
         mAreGeoTagsAvailable = false;
         mSwitchPending = false;
         mIsFileSizeLimitExplicitlyRequested = false;
+
+        std::lock_guard<std::mutex> l(mWriteLatencyLock);
+        std::fill_n(mWriteLatencyCounts, kNumWriteLatencyBuckets, 0);
+        mMaxWriteLatencyUs = 0;
     }
 
     // Verify mFd is seekable
@@ -586,6 +825,13 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
         mPreAllocationEnabled = false;
     }
 
+    mBlockWriter.reset();
+    mBlockWriterOffset = 0;
+    if (mInitCheck == OK && property_get_bool("media.mp4writer.coalesce-writes", false)) {
+        ALOGD("Coalescing writes into %zu byte blocks", kWriteBlockSize);
+        mBlockWriter.reset(new BlockWriter(this, mFd));
+    }
+
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
         (*it)->resetInternal();
@@ -934,14 +1180,27 @@ status_t MPEG4Writer::start(MetaData *param) {
     CHECK_GT(mTimeScale, 0);
     ALOGV("movie time scale: %d", mTimeScale);
 
+    mFragmentDurationUs = 0;
+    if (param && param->findInt64(kKeyFragmentDurationUs, &mFragmentDurationUs)) {
+        if (mHasFileLevelMeta) {
+            ALOGW("Image items can not be fragmented, writing a regular file");
+            mFragmentDurationUs = 0;
+        } else if (mFragmentDurationUs < 0) {
+            mFragmentDurationUs = 0;
+        }
+        ALOGV("fragment duration: %" PRId64 " us", mFragmentDurationUs);
+    }
+
     /*
      * When the requested file size limit is small, the priority
      * is to meet the file size limit requirement, rather than
      * to make the file streamable. mStreamableFile does not tell
      * whether the actual recorded file is streamable or not.
+     * A fragmented file has its moov box in front anyway.
      */
     mStreamableFile =
-        (mMaxFileSizeLimitBytes != 0 &&
+        (!isFragmented() &&
+         mMaxFileSizeLimitBytes != 0 &&
          mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
 
     /*
@@ -1049,7 +1308,10 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!isFragmented()) {
+        // Fragments carry mdat boxes of their own.
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1098,6 +1360,7 @@ status_t MPEG4Writer::stopWriterThread() {
         Mutex::Autolock autolock(mLock);
         mDone = true;
         mChunkReadyCondition.signal();
+        mChunkWrittenCondition.broadcast();
     }
 
     void *dummy;
@@ -1184,6 +1447,12 @@ void MPEG4Writer::printWriteDurations() {
 status_t MPEG4Writer::release() {
     ALOGD("release()");
     status_t err = OK;
+    if (mBlockWriter != nullptr) {
+        if (!mBlockWriter->flush()) {
+            err = ERROR_IO;
+        }
+        mBlockWriter.reset();
+    }
     if (!truncatePreAllocation()) {
         if (err == OK) { err = ERROR_IO; }
     }
@@ -1344,12 +1613,16 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
-    // Fix up the size of the 'mdat' chunk.
-    seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
-    uint64_t size = mOffset - mMdatOffset;
-    size = hton64(size);
-    writeOrPostError(mFd, &size, 8);
-    seekOrPostError(mFd, mOffset, SEEK_SET);
+    if (isFragmented()) {
+        writeFragmentIndexes();
+    } else {
+        // Fix up the size of the 'mdat' chunk.
+        seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
+        uint64_t size = mOffset - mMdatOffset;
+        size = hton64(size);
+        writeOrPostError(mFd, &size, 8);
+        seekOrPostError(mFd, mOffset, SEEK_SET);
+    }
     mMdatEndOffset = mOffset;
 
     // Construct file-level meta and moov box now
@@ -1372,7 +1645,7 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         }
     }
 
-    if (mHasMoovBox) {
+    if (mHasMoovBox && !isFragmented()) {
         writeMoovBox(maxDurationUs);
         // mWriteBoxToMemory could be set to false in
         // MPEG4Writer::write() method
@@ -1509,6 +1782,9 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
             (*it)->writeTrackHeader();
         }
     }
+    if (isFragmented()) {
+        writeMvexBox();
+    }
     endBox();  // moov
 }
 
@@ -1540,6 +1816,9 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
         if (mHasMoovBox) {
             writeFourcc("isom");
             writeFourcc("mp42");
+            if (isFragmented()) {
+                writeFourcc("iso6");
+            }
         }
     }
 
@@ -1650,6 +1929,24 @@ static void StripStartcode(MediaBuffer *buffer) {
 }
 
 void MPEG4Writer::addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer) {
+    if (mUse4ByteNalLength) {
+        // The sample is our own copy, so its startcodes can be turned into sizes
+        // and the whole sample written at once.
+        uint8_t *data = (uint8_t *)buffer->data() + buffer->range_offset();
+        size_t leadingSize;
+        if (AnnexBToLengthPrefixedInPlace(data, buffer->range_length(), &leadingSize)) {
+            uint8_t x[4];
+            x[0] = leadingSize >> 24;
+            x[1] = (leadingSize >> 16) & 0xff;
+            x[2] = (leadingSize >> 8) & 0xff;
+            x[3] = leadingSize & 0xff;
+            writeOrPostError(mFd, &x, 4);
+            writeOrPostError(mFd, data, buffer->range_length());
+            mOffset += buffer->range_length() + 4;
+            return;
+        }
+    }
+
     const uint8_t *dataStart = (const uint8_t *)buffer->data() + buffer->range_offset();
     const uint8_t *currentNalStart = dataStart;
     const uint8_t *nextNalStart;
@@ -1738,6 +2035,20 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteSeekErr == true)
         return;
 
+    if (mBlockWriter != nullptr) {
+        bool success = mBlockWriter->write(mBlockWriterOffset, buf, count);
+        mBlockWriterOffset += count;
+        if (success)
+            return;
+        mWriteSeekErr = true;
+        ALOGE("writeOrPostError coalesced write failed");
+
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
+        return;
+    }
+
     auto beforeTP = std::chrono::high_resolution_clock::now();
     ssize_t bytesWritten = ::write(fd, buf, count);
     auto afterTP = std::chrono::high_resolution_clock::now();
@@ -1747,6 +2058,7 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteDurationPQ.size() > kWriteDurationsCount) {
         mWriteDurationPQ.pop();
     }
+    recordWriteLatency(writeDuration);
 
     /* Write as much as possible during stop() execution when there was an error
      * (mWriteSeekErr == true) in the previous call to write() or lseek64().
@@ -1764,9 +2076,45 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
 }
 
+void MPEG4Writer::recordWriteLatency(int64_t latencyUs) {
+    static_assert(kNumWriteLatencyBounds + 1 == kNumWriteLatencyBuckets,
+            "one bucket per bound plus one for the rest");
+    size_t bucket = 0;
+    while (bucket < kNumWriteLatencyBounds && latencyUs > kWriteLatencyBucketsUs[bucket]) {
+        ++bucket;
+    }
+
+    std::lock_guard<std::mutex> l(mWriteLatencyLock);
+    ++mWriteLatencyCounts[bucket];
+    mMaxWriteLatencyUs = std::max(mMaxWriteLatencyUs, latencyUs);
+}
+
+void MPEG4Writer::getMetrics(const sp<AMessage> &metrics) {
+    std::lock_guard<std::mutex> l(mWriteLatencyLock);
+
+    // "<bound in us>:<count>" pairs, the last bucket is unbounded.
+    std::string histogram;
+    for (size_t i = 0; i < kNumWriteLatencyBuckets; ++i) {
+        if (i > 0) {
+            histogram += ",";
+        }
+        histogram += (i < kNumWriteLatencyBounds)
+                ? std::to_string(kWriteLatencyBucketsUs[i]) : std::string("inf");
+        histogram += ":" + std::to_string(mWriteLatencyCounts[i]);
+    }
+    metrics->setString("write-latency-histogram", histogram.c_str());
+    metrics->setInt64("write-latency-max-us", mMaxWriteLatencyUs);
+}
+
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
     if (mWriteSeekErr == true)
         return;
+
+    if (mBlockWriter != nullptr && whence == SEEK_SET) {
+        // Coalesced writes carry their file offset along.
+        mBlockWriterOffset = offset;
+        return;
+    }
     off64_t resOffset = lseek64(fd, offset, whence);
     /* Allow to seek during stop() execution even when there was an error
      * (mWriteSeekErr == true) in the previous call to write() or lseek64().
@@ -2015,7 +2363,22 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
     ALOGV("preAllocateSize :%" PRIu64 " lastFileEndOffset:%" PRIu64, preAllocateSize,
           lastFileEndOffset);
 
-    int res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset, preAllocateSize);
+    off64_t neededEndOffset = lastFileEndOffset + preAllocateSize;
+    int res = 0;
+    if (neededEndOffset > mPreAllocatedExtentEnd) {
+        // Allocate a large extent ahead instead of a small one per sample,
+        // and only fall back to the exact size when that does not fit.
+        off64_t extentStart = std::max(mPreAllocatedExtentEnd, lastFileEndOffset);
+        uint64_t extentSize = neededEndOffset - extentStart + kPreAllocateExtentSize;
+        res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, extentStart, extentSize);
+        if (res == -1) {
+            extentSize = neededEndOffset - extentStart;
+            res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, extentStart, extentSize);
+        }
+        if (res == 0) {
+            mPreAllocatedExtentEnd = extentStart + extentSize;
+        }
+    }
     if (res == -1) {
         ALOGE("fallocate err:%s, %d, fd:%d", strerror(errno), errno, mFd);
         sp<AMessage> msg = new AMessage(kWhatFallocateError, mReflector);
@@ -2024,7 +2387,7 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
         mFallocateErr = true;
         ALOGD("preAllocation post:%d", err);
     } else {
-        mPreAllocateFileEndOffset = lastFileEndOffset + preAllocateSize;
+        mPreAllocateFileEndOffset = neededEndOffset;
         ALOGV("mPreAllocateFileEndOffset:%" PRIu64, mPreAllocateFileEndOffset);
     }
     return (res == -1) ? false : true;
@@ -2167,6 +2530,8 @@ MPEG4Writer::Track::Track(
       mTrackId(aTrackId),
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
+      mFragmentDecodeTimeTicks(-1),
+      mFragmentedSampleCount(0),
       mSamplesHaveSameSize(true),
       mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
@@ -2282,6 +2647,10 @@ void MPEG4Writer::Track::resetInternal() {
         delete mElstTableEntries;
         mElstTableEntries = new ListTableEntries<uint32_t, 3>(3);
     }
+    mFragmentSamples.clear();
+    mFragmentDecodeTimeTicks = -1;
+    mFragmentedSampleCount = 0;
+    mFragmentIndex.clear();
     mReachedEOS = false;
 }
 
@@ -2721,6 +3090,14 @@ void MPEG4Writer::bufferChunk(const Chunk& chunk) {
          it != mChunkInfos.end(); ++it) {
 
         if (chunk.mTrack == it->mTrack) {  // Found owner
+            // Without real time sources to keep up with, throttle the track
+            // instead of queueing its whole input. Not before the first
+            // fragment, which waits for a chunk from every track.
+            while (!mIsRealTimeRecording && !mDone
+                    && it->mChunks.size() >= kMaxQueuedChunksPerTrack
+                    && (!isFragmented() || mFragmentHeaderWritten)) {
+                mChunkWrittenCondition.wait(mLock);
+            }
             it->mChunks.push_back(chunk);
             mChunkReadyCondition.signal();
             return;
@@ -2734,6 +3111,11 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     ALOGV("writeChunkToFile: %" PRId64 " from %s track",
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
+    if (isFragmented()) {
+        writeFragment(chunk);
+        return;
+    }
+
     int32_t isFirstSample = true;
     while (!chunk->mSamples.empty()) {
         List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
@@ -2763,6 +3145,208 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     chunk->mSamples.clear();
 }
 
+void MPEG4Writer::writeFragment(Chunk *chunk) {
+    if (!mFragmentHeaderWritten) {
+        writeFragmentHeader();
+    }
+
+    Track *track = chunk->mTrack;
+    const std::vector<FragmentSample> &samples = chunk->mFragmentSamples;
+    CHECK_EQ(samples.size(), chunk->mSamples.size());
+
+    bool hasCompositionOffsets = false;
+    uint64_t mdatSize = 8;
+    for (const FragmentSample &sample : samples) {
+        hasCompositionOffsets |= (sample.mCompositionOffsetTicks != 0);
+        mdatSize += sample.mSize;
+    }
+    // data-offset, sample-duration, sample-size and sample-flags present, plus
+    // sample-composition-time-offsets present if any sample needs one.
+    const uint32_t trunFlags = 0x000701 | (hasCompositionOffsets ? 0x000800 : 0);
+    const size_t trunSize = 20 + samples.size() * (hasCompositionOffsets ? 16 : 12);
+    const size_t moofSize =
+            8 /* moof */ + 16 /* mfhd */ + 8 /* traf */ + 16 /* tfhd */ + 20 /* tfdt */ + trunSize;
+
+    const off64_t moofOffset = mOffset;
+    int64_t decodeTimeTicks = chunk->mBaseDecodeTimeTicks;
+    int64_t earliestTimeTicks = INT64_MAX;
+
+    beginBoxesInMemory(moofSize);
+    beginBox("moof");
+        beginBox("mfhd");
+        writeInt32(0);  // version=0, flags=0
+        writeInt32(++mFragmentSequenceNumber);
+        endBox();  // mfhd
+        beginBox("traf");
+            beginBox("tfhd");
+            writeInt32(0x020000);  // version=0, flags=default-base-is-moof
+            writeInt32(track->getTrackId().getId());
+            endBox();  // tfhd
+            beginBox("tfdt");
+            writeInt32(1 << 24);  // version=1, flags=0
+            writeInt64(chunk->mBaseDecodeTimeTicks);
+            endBox();  // tfdt
+            beginBox("trun");
+            writeInt32((1 << 24) | trunFlags);  // version=1 for signed offsets
+            writeInt32(samples.size());
+            writeInt32(moofSize + 8);  // data offset, past the mdat header
+            for (const FragmentSample &sample : samples) {
+                writeInt32(sample.mDurationTicks);
+                writeInt32(sample.mSize);
+                // Sync samples do not depend on others, the rest do and are
+                // flagged as non sync samples.
+                writeInt32(sample.mIsSync ? 0x02000000 : 0x01010000);
+                if (hasCompositionOffsets) {
+                    writeInt32(sample.mCompositionOffsetTicks);
+                }
+                earliestTimeTicks = std::min(earliestTimeTicks,
+                        decodeTimeTicks + sample.mCompositionOffsetTicks);
+                decodeTimeTicks += sample.mDurationTicks;
+            }
+            endBox();  // trun
+        endBox();  // traf
+    endBox();  // moof
+    writeBoxesFromMemory();
+
+    const off64_t mdatOffset = mOffset;
+    writeInt32(mdatSize);
+    writeFourcc("mdat");
+    bool usePrefix = track->usePrefix();
+    while (!chunk->mSamples.empty()) {
+        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+        size_t bytesWritten;
+        addSample_l(*it, usePrefix, 0 /* tiffHdrOffset */, &bytesWritten);
+        (*it)->release();
+        (*it) = NULL;
+        chunk->mSamples.erase(it);
+    }
+    if ((uint64_t)(mOffset - mdatOffset) != mdatSize) {
+        // Samples of several NAL units may not come out at the size counted
+        // for them, e.g. behind 3 byte start codes.
+        ALOGW("%s fragment mdat is %" PRId64 " bytes instead of %" PRIu64,
+                track->getTrackType(), (int64_t)(mOffset - mdatOffset), mdatSize);
+        uint32_t size = htonl(mOffset - mdatOffset);
+        seekOrPostError(mFd, mdatOffset, SEEK_SET);
+        writeOrPostError(mFd, &size, 4);
+        seekOrPostError(mFd, mOffset, SEEK_SET);
+    }
+
+    track->addFragmentIndexEntry(moofOffset, earliestTimeTicks,
+            decodeTimeTicks - chunk->mBaseDecodeTimeTicks);
+}
+
+void MPEG4Writer::writeFragmentHeader() {
+    // Sample tables in the moov box stay empty, the samples are all described
+    // by the fragments, which leaves the file playable up to the last complete
+    // fragment if recording is cut short.
+    writeMoovBox(0);
+    mFragmentHeaderWritten = true;
+
+    // Reserve room for a sidx box with an entry per fragment of the expected
+    // recording duration. If the recording outlasts it, only mfra is written.
+    int64_t durationUs =
+            mMaxFileDurationLimitUs > 0 ? mMaxFileDurationLimitUs : kSidxDefaultDurationUs;
+    mSidxOffset = mOffset;
+    mSidxReservedSize = std::min(kSidxMaxSize,
+            kSidxHeaderSize + kSidxEntrySize * (durationUs / mFragmentDurationUs + 1));
+    writeInt32(mSidxReservedSize);
+    write("free", 4);
+    off64_t bufSize = mSidxReservedSize - 8;
+    char *zeroBuffer = new (std::nothrow) char[bufSize];
+    if (zeroBuffer) {
+        std::fill_n(zeroBuffer, bufSize, 0);
+        write(zeroBuffer, bufSize);
+        delete [] zeroBuffer;
+    } else {
+        ALOGW("sidx free box isn't initialized to 0");
+        seekOrPostError(mFd, mOffset + bufSize, SEEK_SET);
+        mOffset += bufSize;
+    }
+}
+
+void MPEG4Writer::writeFragmentIndexes() {
+    if (!mFragmentHeaderWritten) {
+        // Nothing was recorded, still leave a well formed file behind.
+        writeFragmentHeader();
+    }
+    const off64_t fragmentsEndOffset = mOffset;
+
+    // Index the fragments of the first video track, or of the first track if
+    // there is no video. Its subsegments span the fragments of other tracks.
+    Track *sidxTrack = NULL;
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if (sidxTrack == NULL || (!sidxTrack->isVideo() && (*it)->isVideo())) {
+            sidxTrack = *it;
+        }
+    }
+    if (sidxTrack != NULL && sidxTrack->canWriteSidxBox(fragmentsEndOffset)) {
+        size_t sidxSize = sidxTrack->getSidxBoxSize();
+        off64_t freeSize = mSidxReservedSize - sidxSize;
+        if (freeSize == 0 || freeSize >= 8) {
+            seekOrPostError(mFd, mSidxOffset, SEEK_SET);
+            mOffset = mSidxOffset;
+            beginBoxesInMemory(sidxSize + (freeSize > 0 ? 8 : 0));
+            sidxTrack->writeSidxBox(fragmentsEndOffset);
+            if (freeSize > 0) {
+                writeInt32(freeSize);
+                write("free", 4);
+            }
+            writeBoxesFromMemory();
+            mOffset = fragmentsEndOffset;
+            seekOrPostError(mFd, mOffset, SEEK_SET);
+        } else {
+            ALOGW("sidx box of %zu bytes does not fit in %" PRId64 " reserved bytes",
+                    sidxSize, (int64_t)mSidxReservedSize);
+        }
+    }
+
+    size_t mfraSize = 8 + 16 /* mfro */;
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        mfraSize += (*it)->getTfraBoxSize();
+    }
+    beginBoxesInMemory(mfraSize);
+    beginBox("mfra");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        (*it)->writeTfraBox();
+    }
+    beginBox("mfro");
+    writeInt32(0);  // version=0, flags=0
+    writeInt32(mfraSize);
+    endBox();  // mfro
+    endBox();  // mfra
+    writeBoxesFromMemory();
+}
+
+void MPEG4Writer::writeMvexBox() {
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        (*it)->writeTrexBox();
+    }
+    endBox();  // mvex
+}
+
+void MPEG4Writer::beginBoxesInMemory(size_t size) {
+    CHECK(!mWriteBoxToMemory);
+    // write() leaves room for a trailing free box in the cache.
+    mInMemoryCacheSize = size + 8;
+    mInMemoryCache = (uint8_t *) malloc(mInMemoryCacheSize);
+    CHECK(mInMemoryCache != NULL);
+    mInMemoryCacheOffset = 0;
+    mWriteBoxToMemory = true;
+}
+
+void MPEG4Writer::writeBoxesFromMemory() {
+    // write() already went to the file if the boxes outgrew the cache.
+    if (mWriteBoxToMemory) {
+        mWriteBoxToMemory = false;
+        write(mInMemoryCache, mInMemoryCacheOffset);
+    }
+    free(mInMemoryCache);
+    mInMemoryCache = NULL;
+    mInMemoryCacheOffset = 0;
+    mInMemoryCacheSize = 0;
+}
+
 void MPEG4Writer::writeAllChunks() {
     ALOGV("writeAllChunks");
     size_t outstandingChunks = 0;
@@ -2781,6 +3365,18 @@ void MPEG4Writer::writeAllChunks() {
 bool MPEG4Writer::findChunkToWrite(Chunk *chunk) {
     ALOGV("findChunkToWrite");
 
+    if (isFragmented() && !mFragmentHeaderWritten && !mDone) {
+        // The moov box goes out with the first fragment and needs the codec
+        // specific data of every track, which it has once its first fragment
+        // is buffered, unless the track ends without any.
+        for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+             it != mChunkInfos.end(); ++it) {
+            if (it->mChunks.empty() && !it->mTrack->reachedEOS()) {
+                return false;
+            }
+        }
+    }
+
     int64_t minTimestampUs = 0x7FFFFFFFFFFFFFFFLL;
     Track *track = NULL;
     for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
@@ -2833,27 +3429,27 @@ void MPEG4Writer::threadFunc() {
     }
 
     Mutex::Autolock autoLock(mLock);
+    std::vector<Chunk> chunks;
     while (!mDone) {
         Chunk chunk;
-        bool chunkFound = false;
-
-        while (!mDone && !(chunkFound = findChunkToWrite(&chunk))) {
+        while (chunks.size() < kMaxChunksPerBatch && findChunkToWrite(&chunk)) {
+            chunks.push_back(chunk);
+        }
+        if (chunks.empty()) {
             mChunkReadyCondition.wait(mLock);
+            continue;
         }
+        mChunkWrittenCondition.broadcast();
 
-        // In real time recording mode, write without holding the lock in order
-        // to reduce the blocking time for media track threads.
-        // Otherwise, hold the lock until the existing chunks get written to the
-        // file.
-        if (chunkFound) {
-            if (mIsRealTimeRecording) {
-                mLock.unlock();
-            }
-            writeChunkToFile(&chunk);
-            if (mIsRealTimeRecording) {
-                mLock.lock();
-            }
+        // Write without holding the lock, so that the track threads can queue
+        // their next chunks meanwhile. When not recording in real time, they
+        // are throttled in bufferChunk() instead.
+        mLock.unlock();
+        for (Chunk &batchChunk : chunks) {
+            writeChunkToFile(&batchChunk);
         }
+        chunks.clear();
+        mLock.lock();
     }
 
     writeAllChunks();
@@ -3456,6 +4052,10 @@ status_t MPEG4Writer::Track::threadEntry() {
     int64_t lastSampleDurationUs = -1;      // Duration calculated from EOS buffer and its timestamp
     int64_t lastSampleDurationTicks = -1;   // Timescale based ticks
     int64_t sampleFileOffset = -1;
+    // Fragmented files only, timescale based ticks
+    const int64_t fragmentDurationTicks = mOwner->isFragmented() ?
+            std::max((int64_t)1, (mOwner->mFragmentDurationUs * mTimeScale) / 1000000LL) : 0;
+    int64_t fragmentDurationSoFarTicks = 0;  // Of the samples in mFragmentSamples but the last
 
     if (mIsAudio) {
         prctl(PR_SET_NAME, (unsigned long)"MP4WtrAudTrkThread", 0, 0, 0);
@@ -3706,7 +4306,7 @@ status_t MPEG4Writer::Track::threadEntry() {
         }
 ////////////////////////////////////////////////////////////////////////////////
         if (!mIsHeic) {
-            if (mStszTableEntries->count() == 0) {
+            if (getSampleCount() == 0) {
                 mFirstSampleTimeRealUs = systemTime() / 1000;
                 if (timestampUs < 0 && mFirstSampleStartOffsetUs == 0) {
                     mFirstSampleStartOffsetUs = -timestampUs;
@@ -3800,33 +4400,36 @@ status_t MPEG4Writer::Track::threadEntry() {
                     break;
                 }
 
-                if (mStszTableEntries->count() == 0) {
-                    // Force the first ctts table entry to have one single entry
-                    // so that we can do adjustment for the initial track start
-                    // time offset easily in writeCttsBox().
-                    lastCttsOffsetTimeTicks = currCttsOffsetTimeTicks;
-                    addOneCttsTableEntry(1, currCttsOffsetTimeTicks);
-                    cttsSampleCount = 0;      // No sample in ctts box is pending
-                } else {
-                    if (currCttsOffsetTimeTicks != lastCttsOffsetTimeTicks) {
-                        addOneCttsTableEntry(cttsSampleCount, lastCttsOffsetTimeTicks);
+                // Fragments carry the composition offsets in their trun boxes.
+                if (fragmentDurationTicks == 0) {
+                    if (mStszTableEntries->count() == 0) {
+                        // Force the first ctts table entry to have one single entry
+                        // so that we can do adjustment for the initial track start
+                        // time offset easily in writeCttsBox().
                         lastCttsOffsetTimeTicks = currCttsOffsetTimeTicks;
-                        cttsSampleCount = 1;  // One sample in ctts box is pending
+                        addOneCttsTableEntry(1, currCttsOffsetTimeTicks);
+                        cttsSampleCount = 0;      // No sample in ctts box is pending
                     } else {
-                        ++cttsSampleCount;
+                        if (currCttsOffsetTimeTicks != lastCttsOffsetTimeTicks) {
+                            addOneCttsTableEntry(cttsSampleCount, lastCttsOffsetTimeTicks);
+                            lastCttsOffsetTimeTicks = currCttsOffsetTimeTicks;
+                            cttsSampleCount = 1;  // One sample in ctts box is pending
+                        } else {
+                            ++cttsSampleCount;
+                        }
                     }
-                }
 
-                // Update ctts time offset range
-                if (mStszTableEntries->count() == 0) {
-                    mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
-                    mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
-                } else {
-                    if (currCttsOffsetTimeTicks > mMaxCttsOffsetTicks) {
-                        mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
-                    } else if (currCttsOffsetTimeTicks < mMinCttsOffsetTicks) {
+                    // Update ctts time offset range
+                    if (mStszTableEntries->count() == 0) {
                         mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
-                        mMinCttsOffsetTimeUs = cttsOffsetTimeUs;
+                        mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
+                    } else {
+                        if (currCttsOffsetTimeTicks > mMaxCttsOffsetTicks) {
+                            mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
+                        } else if (currCttsOffsetTimeTicks < mMinCttsOffsetTicks) {
+                            mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
+                            mMinCttsOffsetTimeUs = cttsOffsetTimeUs;
+                        }
                     }
                 }
             }
@@ -3884,24 +4487,50 @@ status_t MPEG4Writer::Track::threadEntry() {
                     timestampUs += deltaUs;
                 }
             }
-            mStszTableEntries->add(htonl(sampleSize));
+            if (fragmentDurationTicks > 0) {
+                // A sample's duration is known once the next one arrives. The
+                // fragment is cut in front of a sync sample, or of any sample
+                // of a track without sync samples, once it is long enough.
+                if (!mFragmentSamples.empty()) {
+                    mFragmentSamples.back().mDurationTicks = currDurationTicks;
+                    fragmentDurationSoFarTicks += currDurationTicks;
+                    if (fragmentDurationSoFarTicks >= fragmentDurationTicks &&
+                            (isSync || !mIsVideo)) {
+                        bufferFragment();
+                        fragmentDurationSoFarTicks = 0;
+                    }
+                }
+                FragmentSample sample;
+                sample.mSize = sampleSize;
+                sample.mDurationTicks = 0;
+                sample.mCompositionOffsetTicks = mIsVideo ?
+                        currCttsOffsetTimeTicks - (kMaxCttsOffsetTimeUs * mTimeScale) / 1000000LL : 0;
+                sample.mIsSync = (isSync || !mIsVideo);
+                mFragmentSamples.push_back(sample);
+                ++mFragmentedSampleCount;
+            } else {
+                mStszTableEntries->add(htonl(sampleSize));
 
-            if (mStszTableEntries->count() > 2) {
+                if (mStszTableEntries->count() > 2) {
 
-                // Force the first sample to have its own stts entry so that
-                // we can adjust its value later to maintain the A/V sync.
-                if (lastDurationTicks && currDurationTicks != lastDurationTicks) {
-                    addOneSttsTableEntry(sampleCount, lastDurationTicks);
-                    sampleCount = 1;
-                } else {
-                    ++sampleCount;
+                    // Force the first sample to have its own stts entry so that
+                    // we can adjust its value later to maintain the A/V sync.
+                    if (lastDurationTicks && currDurationTicks != lastDurationTicks) {
+                        addOneSttsTableEntry(sampleCount, lastDurationTicks);
+                        sampleCount = 1;
+                    } else {
+                        ++sampleCount;
+                    }
                 }
-            }
-            if (mSamplesHaveSameSize) {
-                if (mStszTableEntries->count() >= 2 && previousSampleSize != sampleSize) {
-                    mSamplesHaveSameSize = false;
+                if (mSamplesHaveSameSize) {
+                    if (mStszTableEntries->count() >= 2 && previousSampleSize != sampleSize) {
+                        mSamplesHaveSameSize = false;
+                    }
+                    previousSampleSize = sampleSize;
+                }
+                if (isSync != 0) {
+                    addOneStssTableEntry(mStszTableEntries->count());
                 }
-                previousSampleSize = sampleSize;
             }
             ALOGV("%s timestampUs/lastTimestampUs: %" PRId64 "/%" PRId64,
                     trackName, timestampUs, lastTimestampUs);
@@ -3909,10 +4538,6 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastDurationTicks = currDurationTicks;
             lastTimestampUs = timestampUs;
 
-            if (isSync != 0) {
-                addOneStssTableEntry(mStszTableEntries->count());
-            }
-
             if (mTrackingProgressStatus) {
                 if (mPreviousTrackTimeUs <= 0) {
                     mPreviousTrackTimeUs = mStartTimestampUs;
@@ -3920,6 +4545,11 @@ status_t MPEG4Writer::Track::threadEntry() {
                 trackProgressStatus(timestampUs);
             }
         }
+        if (fragmentDurationTicks > 0) {
+            // Held until its fragment is cut.
+            mChunkSamples.push_back(copy);
+            continue;
+        }
         if (!hasMultipleTracks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
@@ -3975,12 +4605,23 @@ status_t MPEG4Writer::Track::threadEntry() {
     mOwner->trackProgressStatus(mTrackId.getId(), -1, err);
 
     // Add final entries only for non-empty tracks.
-    if (mStszTableEntries->count() > 0) {
+    if (getSampleCount() > 0) {
         if (mIsHeic) {
             if (!mChunkSamples.empty()) {
                 bufferChunk(0);
                 ++nChunks;
             }
+        } else if (fragmentDurationTicks > 0) {
+            // As below, the last sample lasts as long as the EOS buffer says,
+            // or as long as the one before it.
+            if (lastSampleDurationUs >= 0) {
+                mFragmentSamples.back().mDurationTicks = lastSampleDurationTicks;
+                mTrackDurationUs += lastSampleDurationUs;
+            } else {
+                mFragmentSamples.back().mDurationTicks = lastDurationTicks;
+                mTrackDurationUs += lastDurationUs;
+            }
+            bufferFragment();
         } else {
             // Last chunk
             if (!hasMultipleTracks) {
@@ -4028,7 +4669,7 @@ status_t MPEG4Writer::Track::threadEntry() {
     sendTrackSummary(hasMultipleTracks);
 
     ALOGI("Received total/0-length (%d/%d) buffers and encoded %d frames. - %s",
-            count, nZeroLengthFrames, mStszTableEntries->count(), trackName);
+            count, nZeroLengthFrames, getSampleCount(), trackName);
     if (mIsAudio) {
         ALOGI("Audio track drift time: %" PRId64 " us", mOwner->getDriftTimeUs());
     }
@@ -4049,7 +4690,7 @@ bool MPEG4Writer::Track::isTrackMalFormed() {
         mOwner->mStartMeta->findInt32(kKeyEmptyTrackMalFormed, &emptyTrackMalformed) &&
         emptyTrackMalformed) {
         // MediaRecorder(sets kKeyEmptyTrackMalFormed by default) report empty tracks as malformed.
-        if (!mIsHeic && mStszTableEntries->count() == 0) {  // no samples written
+        if (!mIsHeic && getSampleCount() == 0) {  // no samples written
             ALOGE("The number of recorded samples is 0");
             mIsMalformed = true;
             return true;
@@ -4096,7 +4737,7 @@ void MPEG4Writer::Track::sendTrackSummary(bool hasMultipleTracks) {
 
     mOwner->notify(MEDIA_RECORDER_TRACK_EVENT_INFO,
                     trackNum | MEDIA_RECORDER_TRACK_INFO_ENCODED_FRAMES,
-                    mStszTableEntries->count());
+                    getSampleCount());
 
     {
         // The system delay time excluding the requested initial delay that
@@ -4202,6 +4843,41 @@ void MPEG4Writer::Track::bufferChunk(int64_t timestampUs) {
     mChunkSamples.clear();
 }
 
+void MPEG4Writer::Track::bufferFragment() {
+    ALOGV("bufferFragment");
+
+    if (mFragmentDecodeTimeTicks < 0) {
+        // Like the edit list of a regular file, start the track as much later
+        // than the movie as its first sample came after the earliest one.
+        mFragmentDecodeTimeTicks =
+                ((mStartTimestampUs - mOwner->getStartTimestampUs()) * mTimeScale + 500000LL) /
+                1000000LL;
+        mFragmentDecodeTimeTicks = std::max((int64_t)0, mFragmentDecodeTimeTicks);
+    }
+
+    Chunk chunk(this, (mFragmentDecodeTimeTicks * 1000000LL) / mTimeScale, mChunkSamples);
+    chunk.mBaseDecodeTimeTicks = mFragmentDecodeTimeTicks;
+    chunk.mFragmentSamples.swap(mFragmentSamples);
+    for (const FragmentSample &sample : chunk.mFragmentSamples) {
+        mFragmentDecodeTimeTicks += sample.mDurationTicks;
+    }
+    mOwner->bufferChunk(chunk);
+    mChunkSamples.clear();
+}
+
+uint32_t MPEG4Writer::Track::getSampleCount() const {
+    return mOwner->isFragmented() ? mFragmentedSampleCount : mStszTableEntries->count();
+}
+
+void MPEG4Writer::Track::addFragmentIndexEntry(
+        off64_t moofOffset, int64_t timeTicks, uint32_t durationTicks) {
+    FragmentIndexEntry entry;
+    entry.mMoofOffset = moofOffset;
+    entry.mTimeTicks = timeTicks;
+    entry.mDurationTicks = durationTicks;
+    mFragmentIndex.push_back(entry);
+}
+
 int64_t MPEG4Writer::Track::getDurationUs() const {
     return mTrackDurationUs + getStartTimeOffsetTimeUs() + mOwner->getStartTimeOffsetBFramesUs();
 }
@@ -4290,7 +4966,9 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4322,7 +5000,7 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
     // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
+    if (getSampleCount() > 0 && !isTrackMalFormed()) {
         mOwner->beginBox("stsd");
         mOwner->writeInt32(0);               // version=0, flags=0
         mOwner->writeInt32(1);               // entry count
@@ -4335,7 +5013,8 @@ void MPEG4Writer::Track::writeStblBox() {
         }
         mOwner->endBox();  // stsd
         writeSttsBox();
-        if (mIsVideo) {
+        // An empty stss box would mark every sample of the fragments as non sync.
+        if (mIsVideo && !mOwner->isFragmented()) {
             writeCttsBox();
             writeStssBox();
         }
@@ -4706,7 +5385,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The duration of a fragmented file is only known from its fragments.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -4909,7 +5589,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -5138,6 +5818,79 @@ void MPEG4Writer::Track::writeCo64Box() {
     mOwner->endBox();  // stco or co64
 }
 
+void MPEG4Writer::Track::writeTrexBox() {
+    mOwner->beginBox("trex");
+    mOwner->writeInt32(0);  // version=0, flags=0
+    mOwner->writeInt32(mTrackId.getId());
+    mOwner->writeInt32(1);  // default sample description index
+    mOwner->writeInt32(0);  // default sample duration
+    mOwner->writeInt32(0);  // default sample size
+    mOwner->writeInt32(0);  // default sample flags
+    mOwner->endBox();  // trex
+}
+
+size_t MPEG4Writer::Track::getSidxBoxSize() const {
+    return kSidxHeaderSize + kSidxEntrySize * mFragmentIndex.size();
+}
+
+bool MPEG4Writer::Track::canWriteSidxBox(off64_t fragmentsEndOffset) const {
+    if (mFragmentIndex.empty() || mFragmentIndex.size() > UINT16_MAX) {
+        return false;
+    }
+    // Referenced sizes have 31 bits.
+    for (size_t i = 0; i < mFragmentIndex.size(); ++i) {
+        off64_t endOffset = (i + 1 < mFragmentIndex.size()) ?
+                mFragmentIndex[i + 1].mMoofOffset : fragmentsEndOffset;
+        if (endOffset - mFragmentIndex[i].mMoofOffset > INT32_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MPEG4Writer::Track::writeSidxBox(off64_t fragmentsEndOffset) {
+    // Each fragment of this track starts a subsegment that runs up to its next
+    // fragment, taking in the fragments of other tracks written in between.
+    off64_t sidxEndOffset = mOwner->mOffset + getSidxBoxSize();
+    mOwner->beginBox("sidx");
+    mOwner->writeInt32(1 << 24);  // version=1, flags=0
+    mOwner->writeInt32(mTrackId.getId());  // reference ID
+    mOwner->writeInt32(mTimeScale);
+    mOwner->writeInt64(mFragmentIndex[0].mTimeTicks);  // earliest presentation time
+    mOwner->writeInt64(mFragmentIndex[0].mMoofOffset - sidxEndOffset);  // first offset
+    mOwner->writeInt16(0);  // reserved
+    mOwner->writeInt16(mFragmentIndex.size());  // reference count
+    for (size_t i = 0; i < mFragmentIndex.size(); ++i) {
+        off64_t endOffset = (i + 1 < mFragmentIndex.size()) ?
+                mFragmentIndex[i + 1].mMoofOffset : fragmentsEndOffset;
+        mOwner->writeInt32(endOffset - mFragmentIndex[i].mMoofOffset);  // reference type 0
+        mOwner->writeInt32(mFragmentIndex[i].mDurationTicks);
+        mOwner->writeInt32(0x90000000);  // starts with SAP, SAP type 1, SAP delta 0
+    }
+    mOwner->endBox();  // sidx
+}
+
+size_t MPEG4Writer::Track::getTfraBoxSize() const {
+    return 24 + 19 * mFragmentIndex.size();
+}
+
+void MPEG4Writer::Track::writeTfraBox() {
+    // Every fragment starts with a sync sample and gets an entry.
+    mOwner->beginBox("tfra");
+    mOwner->writeInt32(1 << 24);  // version=1, flags=0
+    mOwner->writeInt32(mTrackId.getId());
+    mOwner->writeInt32(0);  // 1 byte traf, trun and sample numbers
+    mOwner->writeInt32(mFragmentIndex.size());
+    for (const FragmentIndexEntry &entry : mFragmentIndex) {
+        mOwner->writeInt64(entry.mTimeTicks);
+        mOwner->writeInt64(entry.mMoofOffset);
+        mOwner->writeInt8(1);  // traf number
+        mOwner->writeInt8(1);  // trun number
+        mOwner->writeInt8(1);  // sample number
+    }
+    mOwner->endBox();  // tfra
+}
+
 void MPEG4Writer::writeUdtaBox() {
     beginBox("udta");
     writeGeoDataBox();
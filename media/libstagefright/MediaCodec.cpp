@@ -185,9 +185,32 @@ static const char *kCodecPlaybackDurationSec =
    >=0: number of fields changed */
 static const char *kCodecShapingEnhanced = "android.media.mediacodec.shaped";
 
+static const char *kCodecOutputContention = "android.media.mediacodec.output.contention";
+
+// prefix of the metrics reported by CodecBase::getMetrics() and
+// BufferChannelBase::getMetrics(), e.g.
+// android.media.mediacodec.latency.queue-done.p90 (in us) from Codec 2.0
+static const char *kCodecMetricsPrefix = "android.media.mediacodec.";
+
 // XXX suppress until we get our representation right
 static bool kEmitHistogram = false;
 
+// copy the int64 and string entries of |metrics| into |handle|
+static void setCodecMetrics(mediametrics_handle_t handle, const sp<AMessage> &metrics) {
+    for (size_t i = 0; i < metrics->countEntries(); ++i) {
+        AMessage::Type type;
+        const char *name = metrics->getEntryNameAt(i, &type);
+        std::string key = std::string(kCodecMetricsPrefix) + name;
+        int64_t value;
+        AString str;
+        if (type == AMessage::kTypeInt64 && metrics->findInt64(name, &value)) {
+            mediametrics_setInt64(handle, key.c_str(), value);
+        } else if (type == AMessage::kTypeString && metrics->findString(name, &str)) {
+            mediametrics_setCString(handle, key.c_str(), str.c_str());
+        }
+    }
+}
+
 static int64_t getId(IResourceManagerClient const * client) {
     return (int64_t) client;
 }
@@ -946,6 +969,21 @@ void MediaCodec::updateMediametrics() {
         lifetime = lifetime / (1000 * 1000);    // emitted in ms, truncated not rounded
         mediametrics_setInt64(mMetricsHandle, kCodecLifetimeMs, lifetime);
     }
+    if (mBufferChannel != nullptr) {
+        uint64_t contention = mBufferChannel->getOutputContentionCount();
+        if (contention > 0) {
+            mediametrics_setInt64(mMetricsHandle, kCodecOutputContention, contention);
+        }
+
+        sp<AMessage> channelMetrics = new AMessage;
+        mBufferChannel->getMetrics(channelMetrics);
+        setCodecMetrics(mMetricsHandle, channelMetrics);
+    }
+    if (mCodec != nullptr) {
+        sp<AMessage> codecMetrics = new AMessage;
+        mCodec->getMetrics(codecMetrics);
+        setCodecMetrics(mMetricsHandle, codecMetrics);
+    }
 
     if (mBytesEncoded) {
         Mutex::Autolock al(mOutputStatsLock);
@@ -2676,6 +2714,49 @@ status_t MediaCodec::queueInputBuffer(
     return PostAndAwaitResponse(msg, &response);
 }
 
+status_t MediaCodec::queueInputBuffers(
+        size_t index,
+        const std::vector<AccessUnitInfo> &accessUnits,
+        AString *errorDetailMsg) {
+    if (errorDetailMsg != NULL) {
+        errorDetailMsg->clear();
+    }
+    if (accessUnits.empty()) {
+        return -EINVAL;
+    }
+
+    // access units must not overlap, and only the last one may carry EOS.
+    const size_t offset = accessUnits.front().mOffset;
+    size_t end = offset;
+    std::vector<AccessUnitInfo> infos;
+    infos.reserve(accessUnits.size());
+    for (size_t i = 0; i < accessUnits.size(); ++i) {
+        const AccessUnitInfo &au = accessUnits[i];
+        uint32_t allowedFlags = BUFFER_FLAG_CODECCONFIG;
+        if (i + 1 == accessUnits.size()) {
+            allowedFlags |= BUFFER_FLAG_EOS;
+        }
+        if (au.mOffset < end || au.mSize > SIZE_MAX - au.mOffset
+                || (au.mFlags & ~allowedFlags) != 0) {
+            return -EINVAL;
+        }
+        end = au.mOffset + au.mSize;
+        infos.push_back({au.mOffset - offset, au.mSize, au.mTimeUs, au.mFlags});
+    }
+
+    sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setSize("index", index);
+    msg->setSize("offset", offset);
+    msg->setSize("size", end - offset);
+    msg->setInt64("timeUs", accessUnits.front().mTimeUs);
+    msg->setInt32("flags", accessUnits.back().mFlags & BUFFER_FLAG_EOS);
+    msg->setObject("accessUnits", new AccessUnitInfos(std::move(infos)));
+    msg->setPointer("errorDetailMsg", errorDetailMsg);
+
+    sp<AMessage> response;
+    return PostAndAwaitResponse(msg, &response);
+}
+
 status_t MediaCodec::queueSecureInputBuffer(
         size_t index,
         size_t offset,
@@ -5227,6 +5308,14 @@ status_t MediaCodec::onQueueInputBuffer(const sp<AMessage> &msg) {
         return -EINVAL;
     }
 
+    sp<RefBase> accessUnits;
+    if (msg->findObject("accessUnits", &accessUnits)) {
+        if (hasCryptoOrDescrambler() || !mBufferChannel->canQueueAccessUnits()) {
+            return ERROR_UNSUPPORTED;
+        }
+        buffer->meta()->setObject("accessUnits", accessUnits);
+    }
+
     buffer->setRange(offset, size);
     buffer->meta()->setInt64("timeUs", timeUs);
     if (flags & BUFFER_FLAG_EOS) {
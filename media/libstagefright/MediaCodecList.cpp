@@ -56,6 +56,36 @@ Mutex sRemoteInitMutex;
 constexpr const char* kProfilingResults =
         MediaCodecsXmlParser::defaultProfilingResultsXmlPath;
 
+constexpr const char* kCodecListCache = "/data/misc/media/media_codec_list.cache";
+
+bool isCacheEnabled() {
+    return property_get_bool("debug.stagefright.codec-list-cache", true);
+}
+
+// Returns the fingerprint of the list the builders would create, or an empty
+// string if any of them cannot be cached.
+std::string GetCacheFingerprint(const std::vector<MediaCodecListBuilderBase *> &builders) {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", value, "");
+    std::string fingerprint = value;
+    // the active module versions and the profiling results
+    fingerprint += " " + MediaCodecsXmlParser::getXmlFilesFingerprint(
+            { "apex-info-list.xml" }, { "/apex" });
+    fingerprint += " " + MediaCodecsXmlParser::getXmlFilesFingerprint(
+            { "media_codecs_profiling_results.xml" }, { "/data/misc/media" });
+    for (MediaCodecListBuilderBase *builder : builders) {
+        if (builder == nullptr) {
+            continue;
+        }
+        std::string builderFingerprint = builder->getCacheFingerprint();
+        if (builderFingerprint.empty()) {
+            return std::string();
+        }
+        fingerprint += "\n" + builderFingerprint;
+    }
+    return fingerprint;
+}
+
 bool isProfilingNeeded() {
     int8_t value = property_get_bool("debug.stagefright.profilecodec", 0);
     if (value == 0) {
@@ -147,7 +177,8 @@ sp<IMediaCodecList> MediaCodecList::getLocalInstance() {
     Mutex::Autolock autoLock(sInitMutex);
 
     if (sCodecList == nullptr) {
-        MediaCodecList *codecList = new MediaCodecList(GetBuilders());
+        MediaCodecList *codecList = new MediaCodecList(
+                GetBuilders(), isCacheEnabled() ? kCodecListCache : nullptr);
         if (codecList->initCheck() == OK) {
             sCodecList = codecList;
 
@@ -200,21 +231,35 @@ sp<IMediaCodecList> MediaCodecList::getInstance() {
     return sRemoteList;
 }
 
-MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders) {
+MediaCodecList::MediaCodecList(
+        std::vector<MediaCodecListBuilderBase*> builders, const char *cachePath) {
     mGlobalSettings = new AMessage();
     mCodecInfos.clear();
     MediaCodecListWriter writer;
-    for (MediaCodecListBuilderBase *builder : builders) {
-        if (builder == nullptr) {
-            ALOGD("ignored a null builder");
-            continue;
+    std::string fingerprint;
+    if (cachePath != nullptr) {
+        fingerprint = GetCacheFingerprint(builders);
+    }
+    if (!fingerprint.empty() && writer.loadCache(cachePath, fingerprint) == OK) {
+        ALOGV("loaded codec list from %s", cachePath);
+        mInitCheck = OK;
+    } else {
+        for (MediaCodecListBuilderBase *builder : builders) {
+            if (builder == nullptr) {
+                ALOGD("ignored a null builder");
+                continue;
+            }
+            auto currentCheck = builder->buildMediaCodecList(&writer);
+            if (currentCheck != OK) {
+                ALOGD("ignored failed builder");
+                continue;
+            } else {
+                mInitCheck = currentCheck;
+            }
         }
-        auto currentCheck = builder->buildMediaCodecList(&writer);
-        if (currentCheck != OK) {
-            ALOGD("ignored failed builder");
-            continue;
-        } else {
-            mInitCheck = currentCheck;
+        if (!fingerprint.empty() && mInitCheck == OK) {
+            // not fatal, e.g. the process may not be allowed to write the cache
+            (void)writer.saveCache(cachePath, fingerprint);
         }
     }
     writer.writeGlobalSettings(mGlobalSettings);
@@ -18,12 +18,30 @@
 #define LOG_TAG "MediaCodecListWriter"
 #include <utils/Log.h>
 
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+#include <binder/Parcel.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/MediaCodecListWriter.h>
 #include <media/MediaCodecInfo.h>
 
 namespace android {
 
+namespace {
+
+// bump kCacheVersion whenever the layout below or the parcel layout of
+// MediaCodecInfo changes.
+constexpr int32_t kCacheMagic = 0x4d434c43; // 'MCLC'
+constexpr int32_t kCacheVersion = 1;
+
+}  // unnamed namespace
+
 void MediaCodecListWriter::addGlobalSetting(
         const char* key, const char* value) {
     mGlobalSettings.emplace_back(key, value);
@@ -54,6 +72,116 @@ void MediaCodecListWriter::writeGlobalSettings(
     }
 }
 
+status_t MediaCodecListWriter::loadCache(const char *path, const std::string &fingerprint) {
+    base::unique_fd fd(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd.get() < 0) {
+        ALOGV("no codec list cache at %s", path);
+        return NAME_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0 || st.st_size <= 0) {
+        return NAME_NOT_FOUND;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGD("failed to map codec list cache %s", path);
+        return NAME_NOT_FOUND;
+    }
+    Parcel parcel;
+    status_t err = parcel.setData(static_cast<const uint8_t *>(data), st.st_size);
+    munmap(data, st.st_size);
+    if (err != OK) {
+        return NAME_NOT_FOUND;
+    }
+
+    if (parcel.readInt32() != kCacheMagic || parcel.readInt32() != kCacheVersion) {
+        ALOGD("ignoring codec list cache %s of another version", path);
+        return NAME_NOT_FOUND;
+    }
+    const char *cachedFingerprint = parcel.readCString();
+    if (cachedFingerprint == nullptr || fingerprint != cachedFingerprint) {
+        ALOGD("codec list cache %s is stale", path);
+        return NAME_NOT_FOUND;
+    }
+
+    std::vector<std::pair<std::string, std::string>> globalSettings;
+    int32_t count = parcel.readInt32();
+    for (int32_t i = 0; i < count && parcel.dataAvail() > 0; ++i) {
+        const char *key = parcel.readCString();
+        const char *value = parcel.readCString();
+        if (key == nullptr || value == nullptr) {
+            return NAME_NOT_FOUND;
+        }
+        globalSettings.emplace_back(key, value);
+    }
+    if (globalSettings.size() != (size_t)count) {
+        ALOGW("codec list cache %s is corrupt", path);
+        return NAME_NOT_FOUND;
+    }
+    std::vector<sp<MediaCodecInfo>> codecInfos;
+    count = parcel.readInt32();
+    for (int32_t i = 0; i < count && parcel.dataAvail() > 0; ++i) {
+        sp<MediaCodecInfo> info = MediaCodecInfo::FromParcel(parcel);
+        if (info == nullptr) {
+            return NAME_NOT_FOUND;
+        }
+        codecInfos.push_back(info);
+    }
+    if (codecInfos.size() != (size_t)count || parcel.dataAvail() != 0) {
+        ALOGW("codec list cache %s is corrupt", path);
+        return NAME_NOT_FOUND;
+    }
+
+    mGlobalSettings = std::move(globalSettings);
+    mCodecInfos = std::move(codecInfos);
+    return OK;
+}
+
+status_t MediaCodecListWriter::saveCache(const char *path, const std::string &fingerprint) const {
+    Parcel parcel;
+    parcel.writeInt32(kCacheMagic);
+    parcel.writeInt32(kCacheVersion);
+    parcel.writeCString(fingerprint.c_str());
+    parcel.writeInt32(mGlobalSettings.size());
+    for (const std::pair<std::string, std::string> &kv : mGlobalSettings) {
+        parcel.writeCString(kv.first.c_str());
+        parcel.writeCString(kv.second.c_str());
+    }
+    parcel.writeInt32(mCodecInfos.size());
+    for (const sp<MediaCodecInfo> &info : mCodecInfos) {
+        info->writeToParcel(&parcel);
+    }
+
+    // several processes may build the list at the same time; each writes its
+    // own file and the last rename wins.
+    std::string tmpPath = base::StringPrintf("%s.%d", path, getpid());
+    base::unique_fd fd(open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (fd.get() < 0) {
+        status_t err = -errno;
+        ALOGV("cannot write codec list cache %s", tmpPath.c_str());
+        return err;
+    }
+    const uint8_t *data = parcel.data();
+    size_t size = parcel.dataSize();
+    while (size > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(write(fd.get(), data, size));
+        if (written <= 0) {
+            ALOGD("failed to write codec list cache %s", tmpPath.c_str());
+            unlink(tmpPath.c_str());
+            return UNKNOWN_ERROR;
+        }
+        data += written;
+        size -= written;
+    }
+    if (fsync(fd.get()) != 0 || rename(tmpPath.c_str(), path) != 0) {
+        ALOGD("failed to replace codec list cache %s", path);
+        unlink(tmpPath.c_str());
+        return UNKNOWN_ERROR;
+    }
+    ALOGV("saved codec list cache %s", path);
+    return OK;
+}
+
 void MediaCodecListWriter::writeCodecInfos(
         std::vector<sp<MediaCodecInfo>> *codecInfos) const {
     for (const sp<MediaCodecInfo> &info : mCodecInfos) {
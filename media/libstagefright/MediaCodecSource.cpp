@@ -20,6 +20,10 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <deque>
+#include <utility>
+
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/Surface.h>
 #include <mediadrm/ICrypto.h>
@@ -65,6 +69,7 @@ struct MediaCodecSource::Puller : public AHandler {
     void resume();
     status_t setStopTimeUs(int64_t stopTimeUs);
     bool readBuffer(MediaBufferBase **buffer);
+    void getQueueLatency(int64_t *avgUs, int64_t *maxUs);
 
 protected:
     virtual void onMessageReceived(const sp<AMessage> &msg);
@@ -87,18 +92,29 @@ private:
         Queue()
             : mReadPendingSince(0),
               mPaused(false),
-              mPulling(false) { }
+              mPulling(false),
+              mLatencyCount(0),
+              mLatencySumUs(0),
+              mLatencyMaxUs(0) { }
         int64_t mReadPendingSince;
         bool mPaused;
         bool mPulling;
-        Vector<MediaBufferBase *> mReadBuffers;
+        // buffers with the time they were queued
+        std::deque<std::pair<MediaBufferBase *, int64_t>> mReadBuffers;
+
+        // latency of the buffers read by the encoder
+        int64_t mLatencyCount;
+        int64_t mLatencySumUs;
+        int64_t mLatencyMaxUs;
 
         void flush();
         // if queue is empty, return false and set *|buffer| to NULL . Otherwise, pop
         // buffer from front of the queue, place it into *|buffer| and return true.
-        bool readBuffer(MediaBufferBase **buffer);
-        // add a buffer to the back of the queue
-        void pushBuffer(MediaBufferBase *mbuf);
+        // If |queuedUs| is not NULL, it is set to the time the buffer was queued.
+        bool readBuffer(MediaBufferBase **buffer, int64_t *queuedUs = NULL);
+        // add a buffer to the back of the queue. Returns true if the queue was
+        // empty before.
+        bool pushBuffer(MediaBufferBase *mbuf);
     };
     Mutexed<Queue> mQueue;
 
@@ -128,8 +144,9 @@ MediaCodecSource::Puller::~Puller() {
     mLooper->stop();
 }
 
-void MediaCodecSource::Puller::Queue::pushBuffer(MediaBufferBase *mbuf) {
-    mReadBuffers.push_back(mbuf);
+bool MediaCodecSource::Puller::Queue::pushBuffer(MediaBufferBase *mbuf) {
+    bool wasEmpty = mReadBuffers.empty();
+    mReadBuffers.emplace_back(mbuf, ALooper::GetNowUs());
     if (mReadBuffers.size() > kQueuedBufferMax + kDropCountOnce) {
         ALOGW("Queued buffers(%zu) > %u, dropped frames!!", mReadBuffers.size(), kQueuedBufferMax + kDropCountOnce);
         MediaBufferBase *mbuffer;
@@ -139,15 +156,19 @@ void MediaCodecSource::Puller::Queue::pushBuffer(MediaBufferBase *mbuf) {
             }
         }
     }
+    return wasEmpty;
 }
 
-bool MediaCodecSource::Puller::Queue::readBuffer(MediaBufferBase **mbuf) {
+bool MediaCodecSource::Puller::Queue::readBuffer(MediaBufferBase **mbuf, int64_t *queuedUs) {
     if (mReadBuffers.empty()) {
         *mbuf = NULL;
         return false;
     }
-    *mbuf = *mReadBuffers.begin();
-    mReadBuffers.erase(mReadBuffers.begin());
+    *mbuf = mReadBuffers.front().first;
+    if (queuedUs != NULL) {
+        *queuedUs = mReadBuffers.front().second;
+    }
+    mReadBuffers.pop_front();
     return true;
 }
 
@@ -161,7 +182,21 @@ void MediaCodecSource::Puller::Queue::flush() {
 
 bool MediaCodecSource::Puller::readBuffer(MediaBufferBase **mbuf) {
     Mutexed<Queue>::Locked queue(mQueue);
-    return queue->readBuffer(mbuf);
+    int64_t queuedUs;
+    if (!queue->readBuffer(mbuf, &queuedUs)) {
+        return false;
+    }
+    int64_t latencyUs = ALooper::GetNowUs() - queuedUs;
+    ++queue->mLatencyCount;
+    queue->mLatencySumUs += latencyUs;
+    queue->mLatencyMaxUs = std::max(queue->mLatencyMaxUs, latencyUs);
+    return true;
+}
+
+void MediaCodecSource::Puller::getQueueLatency(int64_t *avgUs, int64_t *maxUs) {
+    Mutexed<Queue>::Locked queue(mQueue);
+    *avgUs = queue->mLatencyCount > 0 ? queue->mLatencySumUs / queue->mLatencyCount : 0;
+    *maxUs = queue->mLatencyMaxUs;
 }
 
 status_t MediaCodecSource::Puller::postSynchronouslyAndReturnError(
@@ -325,14 +360,19 @@ void MediaCodecSource::Puller::onMessageReceived(const sp<AMessage> &msg) {
                 }
             }
 
+            // The encoder takes all the buffers it can whenever it is
+            // notified, so only notify it when the queue stops being empty.
+            bool notify = false;
             if (mbuf != NULL) {
-                queue->pushBuffer(mbuf);
+                notify = queue->pushBuffer(mbuf);
             }
 
             queue.unlock();
 
             if (mbuf != NULL) {
-                mNotify->post();
+                if (notify) {
+                    mNotify->post();
+                }
                 msg->post();
             } else {
                 handleEOS();
@@ -383,6 +423,16 @@ int64_t MediaCodecSource::getFirstSampleSystemTimeUs() {
     return timeUs;
 }
 
+void MediaCodecSource::getMetrics(const sp<AMessage> &metrics) {
+    if (mPuller == NULL) {
+        return;
+    }
+    int64_t avgUs, maxUs;
+    mPuller->getQueueLatency(&avgUs, &maxUs);
+    metrics->setInt64("queue-latency-avg-us", avgUs);
+    metrics->setInt64("queue-latency-max-us", maxUs);
+}
+
 status_t MediaCodecSource::start(MetaData* params) {
     sp<AMessage> msg = new AMessage(kWhatStart, mReflector);
     msg->setObject("meta", params);
@@ -34,9 +34,15 @@
 #include <cutils/properties.h>
 #include <utils/String8.h>
 
+#include <utils/Timers.h>
+
 #include <dirent.h>
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 namespace android {
 
 // static
@@ -75,13 +81,14 @@ sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
 
     ALOGV("MediaExtractorFactory::CreateFromService %s", mime);
 
+    const nsecs_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
     void *meta = nullptr;
     void *creator = NULL;
     FreeMetaFunc freeMeta = nullptr;
     float confidence;
     sp<ExtractorPlugin> plugin;
     uint32_t creatorVersion = 0;
-    creator = sniff(source, &confidence, &meta, &freeMeta, plugin, &creatorVersion);
+    creator = sniff(source, mime, &confidence, &meta, &freeMeta, plugin, &creatorVersion);
     if (!creator) {
         ALOGV("FAILED to autodetect media content.");
         return NULL;
@@ -97,10 +104,11 @@ sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
         ex = ret != nullptr ? new MediaExtractorCUnwrapper(ret) : nullptr;
     }
 
-    ALOGV("Created an extractor '%s' with confidence %.2f",
-         ex != nullptr ? ex->name() : "<null>", confidence);
+    const int64_t openTimeUs = ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - startNs);
+    ALOGV("Created an extractor '%s' with confidence %.2f in %lld us",
+         ex != nullptr ? ex->name() : "<null>", confidence, (long long)openTimeUs);
 
-    return CreateIMediaExtractorFromMediaExtractor(ex, source, plugin);
+    return CreateIMediaExtractorFromMediaExtractor(ex, source, plugin, openTimeUs);
 }
 
 struct ExtractorPlugin : public RefBase {
@@ -108,9 +116,11 @@ struct ExtractorPlugin : public RefBase {
     void *libHandle;
     String8 libPath;
     String8 uuidString;
+    // number of times this plugin was picked, to sniff the likely ones first
+    std::atomic<uint32_t> hits;
 
     ExtractorPlugin(ExtractorDef definition, void *handle, String8 &path)
-        : def(definition), libHandle(handle), libPath(path) {
+        : def(definition), libHandle(handle), libPath(path), hits(0) {
         for (size_t i = 0; i < sizeof ExtractorDef::extractor_uuid; i++) {
             uuidString.appendFormat("%02x", def.extractor_uuid.b[i]);
         }
@@ -121,8 +131,23 @@ struct ExtractorPlugin : public RefBase {
             dlclose(libHandle);
         }
     }
+
+    bool supportsType(const char *type) const {
+        if (type == nullptr || def.def_version != EXTRACTORDEF_VERSION_NDK_V2) {
+            return false;
+        }
+        for (size_t i = 0; def.u.v3.supported_types[i] != nullptr; i++) {
+            if (!strcasecmp(def.u.v3.supported_types[i], type)) {
+                return true;
+            }
+        }
+        return false;
+    }
 };
 
+// A sniffer that is this confident ends the sniffing, the remaining plugins are not tried.
+static const float kShortCircuitConfidence = 0.8f;
+
 Mutex MediaExtractorFactory::gPluginMutex;
 std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
@@ -130,7 +155,7 @@ bool MediaExtractorFactory::gIgnoreVersion = false;
 
 // static
 void *MediaExtractorFactory::sniff(
-        const sp<DataSource> &source, float *confidence, void **meta,
+        const sp<DataSource> &source, const char *mime, float *confidence, void **meta,
         FreeMetaFunc *freeMeta, sp<ExtractorPlugin> &plugin, uint32_t *creatorVersion) {
     *confidence = 0.0f;
     *meta = nullptr;
@@ -144,8 +169,30 @@ void *MediaExtractorFactory::sniff(
         plugins = gPlugins;
     }
 
+    // Plugins that support the mime type hint go first, then the ones that were picked
+    // most often, so that a confident sniffer is usually reached early.
+    std::vector<sp<ExtractorPlugin>> ordered(plugins->begin(), plugins->end());
+    std::vector<uint32_t> hits;
+    hits.reserve(ordered.size());
+    for (const sp<ExtractorPlugin> &p : ordered) {
+        hits.push_back(p->hits);
+    }
+    std::vector<size_t> order(ordered.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        bool aSupports = ordered[a]->supportsType(mime);
+        bool bSupports = ordered[b]->supportsType(mime);
+        if (aSupports != bSupports) {
+            return aSupports;
+        }
+        return hits[a] > hits[b];
+    });
+
     void *bestCreator = NULL;
-    for (auto it = plugins->begin(); it != plugins->end(); ++it) {
+    for (size_t index : order) {
+        const sp<ExtractorPlugin> *it = &ordered[index];
         ALOGV("sniffing %s", (*it)->def.extractor_name);
         float newConfidence;
         void *newMeta = nullptr;
@@ -176,9 +223,15 @@ void *MediaExtractorFactory::sniff(
                     newFreeMeta(newMeta);
                 }
             }
+            if (*confidence >= kShortCircuitConfidence) {
+                break;
+            }
         }
     }
 
+    if (bestCreator != NULL) {
+        plugin->hits++;
+    }
     return bestCreator;
 }
 
@@ -364,12 +417,14 @@ status_t MediaExtractorFactory::dump(int fd, const Vector<String16>&) {
         out.append("Available extractors:\n");
         if (gPluginsRegistered) {
             for (auto it = gPlugins->begin(); it != gPlugins->end(); ++it) {
-                out.appendFormat("  %25s: plugin_version(%d), uuid(%s), version(%u), path(%s)",
+                out.appendFormat("  %25s: plugin_version(%d), uuid(%s), version(%u), path(%s)"
+                        ", hits(%u)",
                         (*it)->def.extractor_name,
                     (*it)->def.def_version,
                         (*it)->uuidString.c_str(),
                         (*it)->def.extractor_version,
-                        (*it)->libPath.c_str());
+                        (*it)->libPath.c_str(),
+                        (*it)->hits.load());
                 if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
                     out.append(", supports: ");
                     for (size_t i = 0;; i++) {
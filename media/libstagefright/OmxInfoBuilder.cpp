@@ -32,6 +32,7 @@
 #include <android/hardware/media/omx/1.0/IOmx.h>
 #include <android/hardware/media/omx/1.0/IOmxNode.h>
 #include <media/stagefright/omx/OMXUtils.h>
+#include <media/stagefright/xmlparser/MediaCodecsXmlParser.h>
 
 #include <media/IOMX.h>
 #include <media/omx/1.0/WOmx.h>
@@ -91,6 +92,22 @@ OmxInfoBuilder::OmxInfoBuilder(bool allowSurfaceEncoders)
     : mAllowSurfaceEncoders(allowSurfaceEncoders) {
 }
 
+std::string OmxInfoBuilder::getCacheFingerprint() {
+    // IOmxStore serves the vendor media_codecs*.xml files, and the
+    // capabilities come from the vendor OMX components.
+    std::string fingerprint = "omx:";
+    fingerprint += mAllowSurfaceEncoders ? "surface-encoders " : "no-surface-encoders ";
+    fingerprint += ::android::base::GetProperty("ro.vendor.build.fingerprint", "") + " ";
+    for (const char *key : {
+            "debug.stagefright.omx_default_rank",
+            "debug.stagefright.omx_default_rank.sw-audio",
+            "debug.stagefright.omx_default_rank.sw-other" }) {
+        fingerprint += ::android::base::GetProperty(key, "") + " ";
+    }
+    fingerprint += MediaCodecsXmlParser::getXmlFilesFingerprint();
+    return fingerprint;
+}
+
 status_t OmxInfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // Obtain IOmxStore
     sp<IOmxStore> omxStore = IOmxStore::getService();
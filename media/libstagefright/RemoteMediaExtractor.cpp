@@ -44,6 +44,7 @@ static const char *kExtractorTracks = "android.media.mediaextractor.ntrk";
 // because they are not applicable or useful to that API.
 static const char *kExtractorEntryPoint = "android.media.mediaextractor.entry";
 static const char *kExtractorLogSessionId = "android.media.mediaextractor.logSessionId";
+static const char *kExtractorOpenTimeUs = "android.media.mediaextractor.openTimeUs";
 
 static const char *kEntryPointSdk = "sdk";
 static const char *kEntryPointWithJvm = "ndk-with-jvm";
@@ -53,7 +54,8 @@ static const char *kEntryPointOther = "other";
 RemoteMediaExtractor::RemoteMediaExtractor(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin)
+        const sp<RefBase> &plugin,
+        int64_t openTimeUs)
     :mExtractor(extractor),
      mSource(source),
      mExtractorPlugin(plugin) {
@@ -72,6 +74,10 @@ RemoteMediaExtractor::RemoteMediaExtractor(
         mMetricsItem->setCString(kExtractorFormat, extractor->name());
         // tracks (size_t)
         mMetricsItem->setInt32(kExtractorTracks, ntracks);
+        // time to sniff the content and create the extractor
+        if (openTimeUs >= 0) {
+            mMetricsItem->setInt64(kExtractorOpenTimeUs, openTimeUs);
+        }
         // metadata
         MetaDataBase pMetaData;
         if (extractor->getMetaData(pMetaData) == OK) {
@@ -189,11 +195,12 @@ status_t RemoteMediaExtractor::setLogSessionId(const String8& logSessionId) {
 sp<IMediaExtractor> RemoteMediaExtractor::wrap(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin) {
+        const sp<RefBase> &plugin,
+        int64_t openTimeUs) {
     if (extractor == nullptr) {
         return nullptr;
     }
-    return new RemoteMediaExtractor(extractor, source, plugin);
+    return new RemoteMediaExtractor(extractor, source, plugin, openTimeUs);
 }
 
 }  // namespace android
@@ -25,21 +25,34 @@
 namespace android {
 
 SkipCutBuffer::SkipCutBuffer(size_t skip, size_t cut, size_t num16BitChannels) {
+    mCapacity = 0;
+    mCutBuffer = NULL;
+    reset(skip, cut, num16BitChannels);
+}
+
+SkipCutBuffer::~SkipCutBuffer() {
+    delete[] mCutBuffer;
+}
 
+void SkipCutBuffer::reset(size_t skip, size_t cut, size_t num16BitChannels) {
     mWriteHead = 0;
     mReadHead = 0;
-    mCapacity = 0;
-    mCutBuffer = NULL;
 
+    bool valid = true;
+    size_t frameSize = num16BitChannels * 2;
     if (num16BitChannels == 0 || num16BitChannels > INT32_MAX / 2) {
         ALOGW("# channels out of range: %zu, using passthrough instead", num16BitChannels);
-        return;
-    }
-    size_t frameSize = num16BitChannels * 2;
-    if (skip > INT32_MAX / frameSize || cut > INT32_MAX / frameSize
-            || cut * frameSize > INT32_MAX - 4096) {
+        valid = false;
+    } else if (skip > INT32_MAX / frameSize || cut > INT32_MAX / frameSize
+            || cut * frameSize > (INT32_MAX - 4096) / 2) {
         ALOGW("out of range skip/cut: %zu/%zu, using passthrough instead",
                 skip, cut);
+        valid = false;
+    }
+    if (!valid) {
+        delete[] mCutBuffer;
+        mCutBuffer = NULL;
+        mCapacity = 0;
         return;
     }
     skip *= frameSize;
@@ -47,45 +60,30 @@ SkipCutBuffer::SkipCutBuffer(size_t skip, size_t cut, size_t num16BitChannels) {
 
     mFrontPadding = mSkip = skip;
     mBackPadding = cut;
-    mCapacity = cut + 4096;
-    mCutBuffer = new (std::nothrow) char[mCapacity];
+    // The end of a buffer is written before the held data is read out, so the ring holds up
+    // to twice the cut.
+    int32_t capacity = 2 * cut + 4096;
+    if (mCutBuffer == NULL || mCapacity < capacity) {
+        delete[] mCutBuffer;
+        mCapacity = capacity;
+        mCutBuffer = new (std::nothrow) char[mCapacity];
+        if (mCutBuffer == NULL) {
+            mCapacity = 0;
+        }
+    }
     ALOGV("skipcutbuffer %zu %zu %d", skip, cut, mCapacity);
 }
 
-SkipCutBuffer::~SkipCutBuffer() {
-    delete[] mCutBuffer;
-}
-
 void SkipCutBuffer::submit(MediaBuffer *buffer) {
     if (mCutBuffer == NULL) {
         // passthrough mode
         return;
     }
 
-    int32_t offset = buffer->range_offset();
-    int32_t buflen = buffer->range_length();
-
-    // drop the initial data from the buffer if needed
-    if (mFrontPadding > 0) {
-        // still data left to drop
-        int32_t to_drop = (buflen < mFrontPadding) ? buflen : mFrontPadding;
-        offset += to_drop;
-        buflen -= to_drop;
-        buffer->set_range(offset, buflen);
-        mFrontPadding -= to_drop;
-    }
-
-
-    // append data to cutbuffer
-    char *src = ((char*) buffer->data()) + offset;
-    write(src, buflen);
-
-
-    // the mediabuffer is now empty. Fill it from cutbuffer, always leaving
-    // at least mBackPadding bytes in the cutbuffer
-    char *dst = (char*) buffer->data();
-    size_t copied = read(dst, buffer->size());
-    buffer->set_range(0, copied);
+    int32_t offset, length;
+    trim((char *) buffer->data(), buffer->size(),
+            buffer->range_offset(), buffer->range_length(), &offset, &length);
+    buffer->set_range(offset, length);
 }
 
 template <typename T>
@@ -95,30 +93,50 @@ void SkipCutBuffer::submitInternal(const sp<T>& buffer) {
         return;
     }
 
-    int32_t offset = buffer->offset();
-    int32_t buflen = buffer->size();
+    int32_t offset, length;
+    trim((char *) buffer->base(), buffer->capacity(),
+            buffer->offset(), buffer->size(), &offset, &length);
+    buffer->setRange(offset, length);
+}
 
+void SkipCutBuffer::trim(char *base, size_t capacity, int32_t offset, int32_t length,
+                         int32_t *outOffset, int32_t *outLength) {
     // drop the initial data from the buffer if needed
     if (mFrontPadding > 0) {
         // still data left to drop
-        int32_t to_drop = (buflen < mFrontPadding) ? buflen : mFrontPadding;
+        int32_t to_drop = (length < mFrontPadding) ? length : mFrontPadding;
         offset += to_drop;
-        buflen -= to_drop;
-        buffer->setRange(offset, buflen);
+        length -= to_drop;
         mFrontPadding -= to_drop;
     }
 
-
-    // append data to cutbuffer
-    char *src = (char*) buffer->data();
-    write(src, buflen);
-
-
-    // the mediabuffer is now empty. Fill it from cutbuffer, always leaving
-    // at least mBackPadding bytes in the cutbuffer
-    char *dst = (char*) buffer->base();
-    size_t copied = read(dst, buffer->capacity());
-    buffer->setRange(0, copied);
+    // The output is the held data followed by the new data, less the last mBackPadding bytes.
+    int32_t held = size();
+    int64_t out = (int64_t) held + length - mBackPadding;
+    if (out <= 0) {
+        write(base + offset, length);
+        *outOffset = 0;
+        *outLength = 0;
+        return;
+    }
+    if (out > (int64_t) capacity) {
+        out = capacity;
+    }
+    int32_t fromRing = (held < out) ? held : out;
+    int32_t fromBuffer = out - fromRing;
+
+    // Save the new end first, moving the data below may overwrite it.
+    write(base + offset + fromBuffer, length - fromBuffer);
+    int32_t start = 0;
+    if (offset >= fromRing) {
+        // the held data fits in front of the new data, which stays in place
+        start = offset - fromRing;
+    } else if (fromBuffer > 0) {
+        memmove(base + fromRing, base + offset, fromBuffer);
+    }
+    read(base + start, fromRing);
+    *outOffset = start;
+    *outLength = out;
 }
 
 void SkipCutBuffer::submit(const sp<ABuffer>& buffer) {
@@ -180,18 +198,10 @@ void SkipCutBuffer::write(const char *src, size_t num) {
     }
 }
 
-size_t SkipCutBuffer::read(char *dst, size_t num) {
-    int32_t available = (mWriteHead - mReadHead);
-    if (available < 0) available += mCapacity;
-
-    available -= mBackPadding;
-    if (available <=0) {
-        return 0;
-    }
-    if (available < int32_t(num)) {
-        num = available;
-    }
+void SkipCutBuffer::read(char *dst, size_t num) {
+    CHECK_LE(num, size());
 
+    // at most two copies, the second one for the part that wrapped around
     size_t copyfirst = (mCapacity - mReadHead);
     if (copyfirst > num) copyfirst = num;
     if (copyfirst) {
@@ -206,7 +216,6 @@ size_t SkipCutBuffer::read(char *dst, size_t num) {
             mReadHead += num;
         }
     }
-    return available;
 }
 
 size_t SkipCutBuffer::size() {
@@ -21,6 +21,8 @@
 #include <utils/Trace.h>
 #include <utils/Vector.h>
 
+#include <cutils/properties.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/VideoFrameSchedulerBase.h>
@@ -326,28 +328,49 @@ nsecs_t VideoFrameSchedulerBase::PLL::getPeriod() const {
 /*                             Frame Scheduler                             */
 /* ======================================================================= */
 
+static const int64_t kVsyncPeriodChangeThresholdDiv = 50;                            // 2%
+static const int64_t kCadenceThresholdDiv = 100;                                     // 1%
+
+static inline bool getCadenceLockSetting() {
+    return property_get_bool("media.stagefright.video.cadence_lock", false /* default */);
+}
+
 VideoFrameSchedulerBase::VideoFrameSchedulerBase()
     : mVsyncTime(0),
       mVsyncPeriod(0),
       mVsyncRefreshAt(0),
       mLastVsyncTime(-1),
-      mTimeCorrection(0) {
+      mTimeCorrection(0),
+      mCadenceLockEnabled(getCadenceLockSetting()),
+      mCadenceVsyncs(0),
+      mCadenceFrames(0),
+      mCadenceVideoPeriod(0),
+      mCadenceAnchorTime(0),
+      mCadenceAnchorVsync(0) {
 }
 
 void VideoFrameSchedulerBase::init(float videoFps) {
     updateVsync();
 
-    mLastVsyncTime = -1;
-    mTimeCorrection = 0;
+    resetVsyncState();
 
     mPll.reset(videoFps);
 }
 
 void VideoFrameSchedulerBase::restart() {
+    resetVsyncState();
+
+    mPll.restart();
+}
+
+void VideoFrameSchedulerBase::resetVsyncState() {
     mLastVsyncTime = -1;
     mTimeCorrection = 0;
+    mCadenceFrames = 0;
+}
 
-    mPll.restart();
+void VideoFrameSchedulerBase::onDisplayRefreshRateChanged() {
+    mVsyncRefreshAt = 0;
 }
 
 nsecs_t VideoFrameSchedulerBase::getVsyncPeriod() {
@@ -370,7 +393,16 @@ nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
 
     nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
     if (now >= mVsyncRefreshAt) {
+        nsecs_t lastVsyncPeriod = mVsyncPeriod;
         updateVsync();
+        if (lastVsyncPeriod > 0 && mVsyncPeriod > 0 && abs(mVsyncPeriod - lastVsyncPeriod)
+                > lastVsyncPeriod / kVsyncPeriodChangeThresholdDiv) {
+            // the correction and cadence were computed for the old refresh rate, but the
+            // video frame rate estimate is still good
+            ALOGV("vsync period changed: %lld => %lld",
+                    (long long)lastVsyncPeriod, (long long)mVsyncPeriod);
+            resetVsyncState();
+        }
     }
 
     // without VSYNC info, there is nothing to do
@@ -390,6 +422,15 @@ nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
     renderTime -= mVsyncPeriod / 2;
 
     const nsecs_t videoPeriod = mPll.addSample(origRenderTime);
+    if (mCadenceLockEnabled && mPll.getPeriod() > 0) {
+        nsecs_t cadenceRenderTime = scheduleWithCadence(origRenderTime, mPll.getPeriod());
+        if (cadenceRenderTime >= 0) {
+            ALOGV("cadence render: %lld => %lld",
+                    (long long)origRenderTime, (long long)cadenceRenderTime);
+            ATRACE_INT("FRAME_FLIP_IN(ms)", (cadenceRenderTime - now) / 1000000);
+            return cadenceRenderTime;
+        }
+    }
     if (videoPeriod > 0) {
         // Smooth out rendering
         size_t N = 12;
@@ -464,6 +505,64 @@ nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
     return renderTime;
 }
 
+nsecs_t VideoFrameSchedulerBase::scheduleWithCadence(nsecs_t renderTime, nsecs_t videoPeriod) {
+    if (mCadenceFrames > 0) {
+        nsecs_t frames = divRound(renderTime - mCadenceAnchorTime, videoPeriod);
+        nsecs_t vsyncTime = mCadenceAnchorVsync
+                + divRound(frames * mCadenceVsyncs, mCadenceFrames) * mVsyncPeriod;
+        // Re-anchor on discontinuities, on frame rate changes and once the content clock
+        // has drifted from the display clock by more than it can absorb.  The cadence
+        // itself may put a frame up to a vsync away from its requested time.
+        if (frames < 0
+                || abs(renderTime - mCadenceAnchorTime - frames * videoPeriod)
+                        > mVsyncPeriod / 2
+                || abs(videoPeriod - mCadenceVideoPeriod)
+                        > mCadenceVideoPeriod / kCadenceThresholdDiv
+                || abs(vsyncTime - renderTime) > mVsyncPeriod * 3 / 2) {
+            ALOGV("cadence broken at render=%lld", (long long)renderTime);
+            mCadenceFrames = 0;
+        } else {
+            if (mLastVsyncTime >= 0) {
+                ATRACE_INT("FRAME_VSYNCS", divRound(vsyncTime - mLastVsyncTime, mVsyncPeriod));
+            }
+            mLastVsyncTime = vsyncTime;
+            return vsyncTime - mVsyncPeriod / 2;
+        }
+    }
+
+    // find the shortest cycle of frames that spans a whole number of vsyncs, e.g. 5 vsyncs
+    // for 2 frames of 24p on 60Hz, or 15 vsyncs for 4 frames of 24p on 90Hz
+    for (nsecs_t frames = 1; frames <= kMaxCadenceFrames; ++frames) {
+        nsecs_t vsyncs = divRound(videoPeriod * frames, mVsyncPeriod);
+        // leave frame rates above the refresh rate to the regular scheduler
+        if (vsyncs < frames) {
+            break;
+        }
+        if (abs(videoPeriod * frames - vsyncs * mVsyncPeriod)
+                <= mVsyncPeriod * frames / kCadenceThresholdDiv) {
+            mCadenceVsyncs = vsyncs;
+            mCadenceFrames = frames;
+            break;
+        }
+    }
+    if (mCadenceFrames == 0) {
+        return -1;
+    }
+
+    // anchor the cadence at the vsync closest to the render time
+    nsecs_t roundedTime = renderTime - mVsyncPeriod / 2;
+    mCadenceVideoPeriod = videoPeriod;
+    mCadenceAnchorTime = renderTime;
+    mCadenceAnchorVsync =
+        roundedTime + mVsyncPeriod - ((roundedTime - mVsyncTime) % mVsyncPeriod);
+    ALOGV("locked cadence of %lld vsyncs per %lld frames (video:%lld vsync:%lld)",
+            (long long)mCadenceVsyncs, (long long)mCadenceFrames,
+            (long long)videoPeriod, (long long)mVsyncPeriod);
+    mTimeCorrection = 0;
+    mLastVsyncTime = mCadenceAnchorVsync;
+    return mCadenceAnchorVsync - mVsyncPeriod / 2;
+}
+
 VideoFrameSchedulerBase::~VideoFrameSchedulerBase() {}
 
 } // namespace android
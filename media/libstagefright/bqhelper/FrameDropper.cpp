@@ -18,6 +18,8 @@
 #define LOG_TAG "FrameDropper"
 #include <utils/Log.h>
 
+#include <string.h>
+
 #include <media/stagefright/bqhelper/FrameDropper.h>
 #include <media/stagefright/foundation/ADebug.h>
 
@@ -27,7 +29,13 @@ static const int64_t kMaxJitterUs = 2000;
 
 FrameDropper::FrameDropper()
     : mDesiredMinTimeUs(-1),
-      mMinIntervalUs(0) {
+      mMinIntervalUs(0),
+      mDropStaticFrames(false),
+      mHaveStaticHash(false),
+      mLastContentHash(0),
+      mLastKeptStaticTimeUs(-1),
+      mDroppedForRate(0),
+      mDroppedAsStatic(0) {
 }
 
 FrameDropper::~FrameDropper() {
@@ -63,6 +71,7 @@ bool FrameDropper::shouldDrop(int64_t timeUs) {
         ALOGV("drop frame %lld, desired frame %lld, diff %lld",
                 (long long)timeUs, (long long)mDesiredMinTimeUs,
                 (long long)(mDesiredMinTimeUs - timeUs));
+        ++mDroppedForRate;
         return true;
     }
 
@@ -74,4 +83,51 @@ bool FrameDropper::shouldDrop(int64_t timeUs) {
     return false;
 }
 
+void FrameDropper::setDropStaticFrames(bool drop) {
+    mDropStaticFrames = drop;
+    mHaveStaticHash = false;
+}
+
+bool FrameDropper::shouldDropStatic(int64_t timeUs, uint64_t contentHash) {
+    if (!mDropStaticFrames) {
+        return false;
+    }
+
+    if (mHaveStaticHash && contentHash == mLastContentHash
+            && timeUs - mLastKeptStaticTimeUs < kMaxStaticIntervalUs) {
+        ALOGV("drop static frame %lld, last kept %lld",
+                (long long)timeUs, (long long)mLastKeptStaticTimeUs);
+        ++mDroppedAsStatic;
+        return true;
+    }
+
+    mHaveStaticHash = true;
+    mLastContentHash = contentHash;
+    mLastKeptStaticTimeUs = timeUs;
+    return false;
+}
+
+// FNV-1a over 64-bit words, which wraps around by design.
+#ifdef __clang__
+__attribute__((no_sanitize("integer")))
+#endif
+uint64_t FrameDropper::HashPlane(
+        const uint8_t *data, size_t rowBytes, size_t rows, size_t stride) {
+    static const uint64_t kPrime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t y = 0; y < rows; y += kHashRowStep) {
+        const uint8_t *row = data + y * stride;
+        size_t x = 0;
+        for (; x + sizeof(uint64_t) <= rowBytes; x += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, row + x, sizeof(word));
+            hash = (hash ^ word) * kPrime;
+        }
+        for (; x < rowBytes; ++x) {
+            hash = (hash ^ row[x]) * kPrime;
+        }
+    }
+    return hash;
+}
+
 }  // namespace android
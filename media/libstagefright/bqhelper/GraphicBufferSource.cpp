@@ -333,6 +333,7 @@ GraphicBufferSource::GraphicBufferSource() :
     mStopTimeUs(-1),
     mLastActionTimeUs(-1LL),
     mSkipFramesBeforeNs(-1LL),
+    mConsumerUsage(0),
     mFrameRepeatIntervalUs(-1LL),
     mRepeatLastFrameGeneration(0),
     mOutstandingFrameRepeatCount(0),
@@ -471,6 +472,12 @@ status_t GraphicBufferSource::stop() {
         // We are only interested in the transition from executing->idle,
         // not loaded->idle.
         mExecuting = false;
+
+        if (mFrameDropper != NULL) {
+            ALOGD("dropped %lld frames for max fps, %lld static frames",
+                    (long long)mFrameDropper->droppedForRateCount(),
+                    (long long)mFrameDropper->droppedAsStaticCount());
+        }
     }
     return OK;
 }
@@ -721,6 +728,11 @@ bool GraphicBufferSource::fillCodecBuffer_l() {
             ALOGV("skipping frame (%lld) to meet max framerate", static_cast<long long>(timeUs));
             // set err to OK so that the skipped frame can still be saved as the lastest frame
             err = OK;
+        } else if (isStaticFrame_l(item, timeUs)) {
+            ALOGV("skipping frame (%lld) with static content", static_cast<long long>(timeUs));
+            // not saved as the latest frame, so that any pending repeat of the
+            // previous frame is not pushed back
+            return true;
         } else {
             err = submitBuffer_l(item); // this takes shared ownership of the acquired buffer on succeess
         }
@@ -880,6 +892,54 @@ bool GraphicBufferSource::calculateCodecTimestamp_l(
     return true;
 }
 
+bool GraphicBufferSource::isStaticFrame_l(const VideoBuffer &item, int64_t timeUs) {
+    if (mFrameDropper == NULL || !mFrameDropper->dropsStaticFrames()) {
+        return false;
+    }
+
+    uint64_t hash;
+    if (!hashFrame_l(item, &hash)) {
+        ALOGW("cannot read the content of the frames, not dropping static frames");
+        mFrameDropper->setDropStaticFrames(false);
+        return false;
+    }
+    return mFrameDropper->shouldDropStatic(timeUs, hash);
+}
+
+bool GraphicBufferSource::hashFrame_l(const VideoBuffer &item, uint64_t *hash) {
+    sp<GraphicBuffer> buffer = item.mBuffer->getGraphicBuffer();
+    // the lock waits for, and closes, a duplicate of the acquire fence
+    int fenceFd = item.mBuffer->getAcquireFenceFd();
+    switch (buffer->getPixelFormat()) {
+        case HAL_PIXEL_FORMAT_RGBA_8888:
+        case HAL_PIXEL_FORMAT_RGBX_8888:
+        case HAL_PIXEL_FORMAT_BGRA_8888:
+        {
+            void *data = nullptr;
+            if (buffer->lockAsync(GRALLOC_USAGE_SW_READ_RARELY, &data, fenceFd) != OK) {
+                return false;
+            }
+            *hash = FrameDropper::HashPlane((const uint8_t *)data,
+                    buffer->getWidth() * 4, buffer->getHeight(), buffer->getStride() * 4);
+            break;
+        }
+        default:
+        {
+            android_ycbcr ycbcr;
+            if (buffer->lockAsyncYCbCr(GRALLOC_USAGE_SW_READ_RARELY, &ycbcr, fenceFd) != OK) {
+                return false;
+            }
+            // 16-bit samples (e.g. P010) have interleaved chroma 4 bytes apart
+            size_t sampleBytes = ycbcr.chroma_step >= 4 ? 2 : 1;
+            *hash = FrameDropper::HashPlane((const uint8_t *)ycbcr.y,
+                    buffer->getWidth() * sampleBytes, buffer->getHeight(), ycbcr.ystride);
+            break;
+        }
+    }
+    buffer->unlock();
+    return true;
+}
+
 status_t GraphicBufferSource::submitBuffer_l(const VideoBuffer &item) {
     CHECK(!mFreeCodecBuffers.empty());
     uint32_t codecBufferId = *mFreeCodecBuffers.begin();
@@ -1179,6 +1239,12 @@ status_t GraphicBufferSource::configure(
         }
 
         consumerUsage |= GRALLOC_USAGE_HW_VIDEO_ENCODER;
+        mConsumerUsage = consumerUsage;
+        bool dropStaticFrames = base::GetBoolProperty(
+                "media.stagefright.gbs.drop-static-frames", false);
+        if (dropStaticFrames) {
+            consumerUsage |= GRALLOC_USAGE_SW_READ_RARELY;
+        }
         mConsumer->setConsumerUsageBits(consumerUsage);
 
         // Set impl. defined format as default. Depending on the usage flags
@@ -1200,6 +1266,10 @@ status_t GraphicBufferSource::configure(
         mEndOfStreamSent = false;
         mSkipFramesBeforeNs = -1LL;
         mFrameDropper.clear();
+        if (dropStaticFrames) {
+            mFrameDropper = new FrameDropper();
+            mFrameDropper->setDropStaticFrames(true);
+        }
         mFrameRepeatIntervalUs = -1LL;
         mRepeatLastFrameGeneration = 0;
         mOutstandingFrameRepeatCount = 0;
@@ -1305,16 +1375,49 @@ status_t GraphicBufferSource::setMaxFps(float maxFps) {
         return INVALID_OPERATION;
     }
 
-    mFrameDropper = new FrameDropper();
+    // keep any static frame dropping
+    if (mFrameDropper == NULL) {
+        mFrameDropper = new FrameDropper();
+    }
     status_t err = mFrameDropper->setMaxFrameRate(maxFps);
     if (err != OK) {
-        mFrameDropper.clear();
+        if (!mFrameDropper->dropsStaticFrames()) {
+            mFrameDropper.clear();
+        }
         return err;
     }
 
     return OK;
 }
 
+status_t GraphicBufferSource::setDropStaticFrames(bool drop) {
+    ALOGV("setDropStaticFrames: %d", drop);
+
+    Mutex::Autolock autoLock(mMutex);
+
+    if (mExecuting) {
+        return INVALID_OPERATION;
+    }
+
+    if (mFrameDropper == NULL) {
+        if (!drop) {
+            return OK;
+        }
+        mFrameDropper = new FrameDropper();
+    }
+    mFrameDropper->setDropStaticFrames(drop);
+    mConsumer->setConsumerUsageBits(
+            drop ? mConsumerUsage | GRALLOC_USAGE_SW_READ_RARELY : mConsumerUsage);
+    return OK;
+}
+
+void GraphicBufferSource::getDroppedFrameCounts(int64_t *forRate, int64_t *asStatic) {
+    Mutex::Autolock autoLock(mMutex);
+
+    *forRate = mFrameDropper == NULL ? 0 : mFrameDropper->droppedForRateCount();
+    *asStatic = mFrameDropper == NULL ? 0 : mFrameDropper->droppedAsStaticCount();
+}
+
 status_t GraphicBufferSource::setStartTimeUs(int64_t skipFramesBeforeUs) {
     ALOGV("setStartTimeUs: skipFramesBeforeUs=%lld", (long long)skipFramesBeforeUs);
 
@@ -1403,6 +1506,19 @@ status_t GraphicBufferSource::setColorAspects(int32_t aspectsPacked) {
     return OK;
 }
 
+status_t GraphicBufferSource::setDefaultBufferFormat(int32_t format) {
+    Mutex::Autolock autoLock(mMutex);
+    if (mComponent == NULL) {
+        return NO_INIT;
+    }
+    ALOGD("setting default buffer format: %#x", format);
+    status_t err = mConsumer->setDefaultBufferFormat(format);
+    if (err != NO_ERROR) {
+        ALOGE("Failed to set default buffer format %#x: %d", format, err);
+    }
+    return err;
+}
+
 status_t GraphicBufferSource::signalEndOfInputStream() {
     Mutex::Autolock autoLock(mMutex);
     ALOGV("signalEndOfInputStream: executing=%d available=%zu+%d eos=%d",
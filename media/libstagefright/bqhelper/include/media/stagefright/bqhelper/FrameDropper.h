@@ -40,6 +40,28 @@ struct FrameDropper : public RefBase {
     // Returns true if all frame drop logic should be disabled.
     bool disabled() { return (mMinIntervalUs == -1ll); }
 
+    // Enables dropping of frames whose content hash matches that of the last
+    // kept frame. A frame is still kept at least every kMaxStaticIntervalUs,
+    // so that a change the hash sampling missed does not go unencoded.
+    void setDropStaticFrames(bool drop);
+    bool dropsStaticFrames() const { return mDropStaticFrames; }
+
+    // Returns true if the frame repeats the content of the last kept frame.
+    // Always false unless enabled via setDropStaticFrames.
+    bool shouldDropStatic(int64_t timeUs, uint64_t contentHash);
+
+    // Hashes every kHashRowStep-th row of a plane of |rows| rows of
+    // |rowBytes| bytes, |stride| bytes apart.
+    static uint64_t HashPlane(
+            const uint8_t *data, size_t rowBytes, size_t rows, size_t stride);
+
+    // Number of frames shouldDrop and shouldDropStatic returned true for.
+    int64_t droppedForRateCount() const { return mDroppedForRate; }
+    int64_t droppedAsStaticCount() const { return mDroppedAsStatic; }
+
+    static const int64_t kMaxStaticIntervalUs = 1000000;
+    static const size_t kHashRowStep = 8;
+
 protected:
     virtual ~FrameDropper();
 
@@ -47,6 +69,14 @@ private:
     int64_t mDesiredMinTimeUs;
     int64_t mMinIntervalUs;
 
+    bool mDropStaticFrames;
+    bool mHaveStaticHash;
+    uint64_t mLastContentHash;
+    int64_t mLastKeptStaticTimeUs;
+
+    int64_t mDroppedForRate;
+    int64_t mDroppedAsStatic;
+
     DISALLOW_EVIL_CONSTRUCTORS(FrameDropper);
 };
 
@@ -174,6 +174,19 @@ public:
      */
     status_t setMaxFps(float maxFps);
 
+    // Drops frames whose content did not change since the last submitted
+    // frame, e.g. of a static screen, as if the producer had not queued them,
+    // so that the repeat of the previous frame keeps its schedule. The content
+    // is compared via a hash of a sample of the luma (or RGB) rows, which needs
+    // CPU read access to the buffers. Defaults to the
+    // media.stagefright.gbs.drop-static-frames property. Must be called before
+    // the encoder is executing.
+    status_t setDropStaticFrames(bool drop);
+
+    // Gets the number of frames dropped so far to meet the max frame rate, and
+    // as repeats of static content.
+    void getDroppedFrameCounts(int64_t *forRate, int64_t *asStatic);
+
     // Sets the time lapse (or slow motion) parameters.
     // When set, the sample's timestamp will be modified to playback framerate,
     // and capture timestamp will be modified to capture rate.
@@ -197,6 +210,13 @@ public:
     // Sets the desired color aspects, e.g. to be used when producer does not specify a dataspace.
     status_t setColorAspects(int32_t aspectsPacked);
 
+    // Sets the pixel format of the buffers that producers dequeue without
+    // asking for one, instead of the implementation defined format set by
+    // configure(). Producers that render with the GPU, e.g. virtual displays,
+    // then convert to the format the component consumes. Must be called after
+    // configure().
+    status_t setDefaultBufferFormat(int32_t format);
+
 protected:
 
     // BufferQueue::ConsumerListener interface, called when a new frame of
@@ -333,6 +353,14 @@ private:
     // it returns any submit success or error value returned by the codec.
     status_t submitBuffer_l(const VideoBuffer &item);
 
+    // Returns true if |item| repeats the content of the last submitted frame and
+    // static frames are being dropped.
+    bool isStaticFrame_l(const VideoBuffer &item, int64_t timeUs);
+
+    // Hashes a sample of the content of |item|. Returns false if the buffer
+    // cannot be read by the CPU.
+    bool hashFrame_l(const VideoBuffer &item, uint64_t *hash);
+
     // Submits an empty buffer, with the EOS flag set if there is an available codec buffer and
     // sets mEndOfStreamSent flag. Does nothing if there is no codec buffer available.
     void submitEndOfInputStream_l();
@@ -407,6 +435,9 @@ private:
 
     int64_t mSkipFramesBeforeNs;
 
+    // consumer usage from configure(), without the CPU read for static frames
+    uint32_t mConsumerUsage;
+
     sp<FrameDropper> mFrameDropper;
 
     sp<ALooper> mLooper;
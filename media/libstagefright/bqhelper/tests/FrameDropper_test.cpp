@@ -134,4 +134,46 @@ TEST_F(FrameDropperTest, TestVariableFps) {
     RunTest(testFramesVariableFps, ARRAY_SIZE(testFramesVariableFps));
 }
 
+TEST_F(FrameDropperTest, TestStaticFramesNotDroppedByDefault) {
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(1000000, 1));
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(1033333, 1));
+    EXPECT_EQ(0, mFrameDropper->droppedAsStaticCount());
+}
+
+TEST_F(FrameDropperTest, TestStaticFrames) {
+    mFrameDropper->setDropStaticFrames(true);
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(1000000, 1));
+    EXPECT_TRUE(mFrameDropper->shouldDropStatic(1033333, 1));
+    EXPECT_TRUE(mFrameDropper->shouldDropStatic(1066667, 1));
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(1100000, 2));
+    EXPECT_TRUE(mFrameDropper->shouldDropStatic(1133333, 2));
+    // a static frame is still kept every kMaxStaticIntervalUs
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(
+            1100000 + FrameDropper::kMaxStaticIntervalUs, 2));
+    EXPECT_EQ(3, mFrameDropper->droppedAsStaticCount());
+
+    mFrameDropper->setDropStaticFrames(false);
+    EXPECT_FALSE(mFrameDropper->shouldDropStatic(3000000, 2));
+}
+
+TEST_F(FrameDropperTest, TestDroppedForRateCount) {
+    RunTest(testFrames60Fps, ARRAY_SIZE(testFrames60Fps));
+    EXPECT_EQ(10, mFrameDropper->droppedForRateCount());
+}
+
+TEST_F(FrameDropperTest, TestHashPlane) {
+    const size_t kWidth = 67, kHeight = 33, kStride = 80;
+    uint8_t plane[kStride * kHeight] = {};
+    const uint64_t hash = FrameDropper::HashPlane(plane, kWidth, kHeight, kStride);
+
+    // padding past the row and rows between the sampled ones are not hashed
+    plane[kWidth] = 1;
+    plane[kStride] = 1;
+    EXPECT_EQ(hash, FrameDropper::HashPlane(plane, kWidth, kHeight, kStride));
+
+    // the trailing bytes of a sampled row are
+    plane[FrameDropper::kHashRowStep * kStride + kWidth - 1] = 1;
+    EXPECT_NE(hash, FrameDropper::HashPlane(plane, kWidth, kHeight, kStride));
+}
+
 } // namespace android
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "ColorConverter"
 #include <android-base/macros.h>
+#include <cutils/properties.h>
 #include <utils/Log.h>
 
 #include <media/stagefright/foundation/ADebug.h>
@@ -30,7 +31,14 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/prctl.h>
 #include <sys/time.h>
 
 #define USE_LIBYUV
@@ -47,6 +55,19 @@
 #include <arm_neon.h>
 #endif
 
+// SIMD for the 16 bit YUV sources to RGB.
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON_YUV16 1
+#define USE_SSE2_YUV16 0
+#elif defined(__SSE2__)
+#define USE_NEON_YUV16 0
+#define USE_SSE2_YUV16 1
+#include <emmintrin.h>
+#else
+#define USE_NEON_YUV16 0
+#define USE_SSE2_YUV16 0
+#endif
+
 namespace android {
 
 static bool isRGB(OMX_COLOR_FORMATTYPE colorFormat) {
@@ -211,13 +232,86 @@ constexpr int CLIP_RANGE_MAX_10BIT = 2218;
 
 }
 
+// Upper bound on the number of bands, and on the worker pool size.
+constexpr size_t kMaxConversionThreads = 8;
+
+// Bands shorter than this are not worth handing to another thread.
+constexpr size_t kMinBandHeight = 64;
+
+namespace {
+
+// Worker threads shared by all ColorConverter instances. Threads are created on
+// demand and are never destroyed.
+class ConversionPool {
+public:
+    static ConversionPool &get() {
+        static ConversionPool *pool = new ConversionPool();
+        return *pool;
+    }
+
+    // Runs fn(0) .. fn(count - 1) and returns once all of them are done.
+    // fn(0) runs on the calling thread, the rest on up to count - 1 workers.
+    void run(size_t count, const std::function<void(size_t)> &fn) {
+        std::mutex doneLock;
+        std::condition_variable doneCond;
+        size_t pending = count - 1;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            while (mThreads < std::min(count - 1, kMaxConversionThreads - 1)) {
+                std::thread(&ConversionPool::threadLoop, this).detach();
+                ++mThreads;
+            }
+            for (size_t i = 1; i < count; ++i) {
+                mJobs.emplace_back([&fn, &doneLock, &doneCond, &pending, i] {
+                    fn(i);
+                    std::lock_guard<std::mutex> lock(doneLock);
+                    if (--pending == 0) {
+                        doneCond.notify_one();
+                    }
+                });
+            }
+        }
+        mCond.notify_all();
+
+        fn(0);
+
+        std::unique_lock<std::mutex> lock(doneLock);
+        doneCond.wait(lock, [&pending] { return pending == 0; });
+    }
+
+private:
+    ConversionPool() = default;
+
+    void threadLoop() {
+        prctl(PR_SET_NAME, (unsigned long)"ColorConvert", 0, 0, 0);
+        std::unique_lock<std::mutex> lock(mLock);
+        for (;;) {
+            mCond.wait(lock, [this] { return !mJobs.empty(); });
+            std::function<void()> job = std::move(mJobs.front());
+            mJobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<std::function<void()>> mJobs; // guarded by mLock
+    size_t mThreads = 0;                     // guarded by mLock
+};
+
+} // namespace
+
 ColorConverter::ColorConverter(
         OMX_COLOR_FORMATTYPE from, OMX_COLOR_FORMATTYPE to)
     : mSrcFormat(from),
       mDstFormat(to),
       mSrcColorSpace({0, 0, 0}),
       mClip(NULL),
-      mClip10Bit(NULL) {
+      mClip10Bit(NULL),
+      mNumThreads(1) {
+    setNumThreads(std::max(property_get_int32("media.stagefright.cc_threads", 1), 1));
 }
 
 ColorConverter::~ColorConverter() {
@@ -275,6 +369,10 @@ void ColorConverter::setSrcColorSpace(
     mSrcColorSpace.mTransfer = transfer;
 }
 
+void ColorConverter::setNumThreads(size_t numThreads) {
+    mNumThreads = std::clamp(numThreads, (size_t)1, kMaxConversionThreads);
+}
+
 /*
  * If stride is non-zero, client's stride will be used. For planar
  * or semi-planar YUV formats, stride must be even numbers.
@@ -375,6 +473,46 @@ status_t ColorConverter::convert(
         return ERROR_UNSUPPORTED;
     }
 
+    // each band converts at least kMinBandHeight rows and, except for the last
+    // one, an even number of rows so that bands start on a chroma row.
+    size_t bandHeight = std::max(
+            (src.cropHeight() + mNumThreads - 1) / mNumThreads, kMinBandHeight);
+    bandHeight = (bandHeight + 1) & ~(size_t)1;
+    const size_t numBands = (src.cropHeight() + bandHeight - 1) / bandHeight;
+    if (numBands <= 1) {
+        return convertBand(src, dst);
+    }
+
+    // the clip tables are allocated on first use, do it before sharing them.
+    initClip();
+    initClip10Bit();
+
+    std::vector<status_t> results(numBands, OK);
+    ConversionPool::get().run(numBands, [&](size_t band) {
+        const size_t top = band * bandHeight;
+        const size_t bottom = std::min(top + bandHeight, src.cropHeight()) - 1;
+
+        BitmapParams srcBand = src;
+        srcBand.mCropTop = src.mCropTop + top;
+        srcBand.mCropBottom = src.mCropTop + bottom;
+
+        BitmapParams dstBand = dst;
+        dstBand.mCropTop = dst.mCropTop + top;
+        dstBand.mCropBottom = dst.mCropTop + bottom;
+
+        results[band] = convertBand(srcBand, dstBand);
+    });
+
+    for (status_t err : results) {
+        if (err != OK) {
+            return err;
+        }
+    }
+    return OK;
+}
+
+status_t ColorConverter::convertBand(
+        const BitmapParams &src, const BitmapParams &dst) {
     status_t err;
 
     switch ((int32_t)mSrcFormat) {
@@ -779,6 +917,242 @@ getWriteToDst(OMX_COLOR_FORMATTYPE dstFormat, void *kAdjustedClip) {
     return nullptr;
 }
 
+/* Vectorized kernels for the 16 bit YUV sources, converting 8 pixels of a row at a time.
+ *
+ * They compute exactly what the scalar loops below compute:
+ *   c = clip((y - c16) * _y + 128 + chroma) / 256)
+ * As the clip tables map all negative values to 0, the division can be an arithmetic shift.
+ */
+enum class RgbPacking {
+    RGB565,
+    RGBA8888,
+    BGRA8888,
+    ABGR2101010,
+};
+
+struct YuvKernel {
+    int16_t y;      // luma scale
+    int16_t c16;    // luma offset
+    int16_t b_u;
+    int16_t neg_g_u;
+    int16_t neg_g_v;
+    int16_t r_v;
+    int16_t max;    // 255 or 1023
+};
+
+#if USE_NEON_YUV16
+
+// r, g and b are clipped to [0, k.max].
+static inline void yuvToRgb(int16x8_t y, int16x4_t u, int16x4_t v, const YuvKernel &k,
+        int16x8_t *r, int16x8_t *g, int16x8_t *b) {
+    // each chroma sample covers two pixels
+    const int32x4x2_t ub = vzipq_s32(vmull_n_s16(u, k.b_u), vmull_n_s16(u, k.b_u));
+    const int32x4_t guvq = vmlal_n_s16(vmull_n_s16(u, k.neg_g_u), v, k.neg_g_v);
+    const int32x4x2_t guv = vzipq_s32(guvq, guvq);
+    const int32x4x2_t vr = vzipq_s32(vmull_n_s16(v, k.r_v), vmull_n_s16(v, k.r_v));
+    const int32x4_t ylo = vmlal_n_s16(vdupq_n_s32(128), vget_low_s16(y), k.y);
+    const int32x4_t yhi = vmlal_n_s16(vdupq_n_s32(128), vget_high_s16(y), k.y);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t max = vdupq_n_s16(k.max);
+    *b = vminq_s16(vmaxq_s16(vcombine_s16(
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(ylo, ub.val[0]), 8)),
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(yhi, ub.val[1]), 8))), zero), max);
+    *g = vminq_s16(vmaxq_s16(vcombine_s16(
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(ylo, guv.val[0]), 8)),
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(yhi, guv.val[1]), 8))), zero), max);
+    *r = vminq_s16(vmaxq_s16(vcombine_s16(
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(ylo, vr.val[0]), 8)),
+            vqmovn_s32(vshrq_n_s32(vaddq_s32(yhi, vr.val[1]), 8))), zero), max);
+}
+
+template <RgbPacking P>
+static inline void storeRgb(uint8_t *dst, int16x8_t r, int16x8_t g, int16x8_t b) {
+    const uint16x8_t ru = vreinterpretq_u16_s16(r);
+    const uint16x8_t gu = vreinterpretq_u16_s16(g);
+    const uint16x8_t bu = vreinterpretq_u16_s16(b);
+    if (P == RgbPacking::RGB565) {
+        const uint16x8_t rgb = vorrq_u16(vorrq_u16(
+                vshlq_n_u16(vshrq_n_u16(ru, 3), 11),
+                vshlq_n_u16(vshrq_n_u16(gu, 2), 5)),
+                vshrq_n_u16(bu, 3));
+        vst1q_u16((uint16_t *)dst, rgb);
+        return;
+    }
+    const uint16x8_t c0 = P == RgbPacking::BGRA8888 ? bu : ru;
+    const uint16x8_t c2 = P == RgbPacking::BGRA8888 ? ru : bu;
+    const uint32x4_t alpha = vdupq_n_u32(P == RgbPacking::ABGR2101010 ? 3u << 30 : 0xFFu << 24);
+    const int shift = P == RgbPacking::ABGR2101010 ? 10 : 8;
+    const int32x4_t shift1 = vdupq_n_s32(shift);
+    const int32x4_t shift2 = vdupq_n_s32(shift * 2);
+    const uint32x4_t lo = vorrq_u32(vorrq_u32(vmovl_u16(vget_low_u16(c0)),
+            vshlq_u32(vmovl_u16(vget_low_u16(gu)), shift1)),
+            vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(c2)), shift2), alpha));
+    const uint32x4_t hi = vorrq_u32(vorrq_u32(vmovl_u16(vget_high_u16(c0)),
+            vshlq_u32(vmovl_u16(vget_high_u16(gu)), shift1)),
+            vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(c2)), shift2), alpha));
+    vst1q_u32((uint32_t *)dst, lo);
+    vst1q_u32((uint32_t *)dst + 4, hi);
+}
+
+// P010: 10 bit samples in the upper bits, interleaved chroma.
+template <RgbPacking P>
+static size_t convertRowP010(const uint16_t *src_y, const uint16_t *src_uv, uint8_t *dst,
+        size_t width, size_t bpp, const YuvKernel &k) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const int16x8_t y = vsubq_s16(
+                vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(src_y + x), 6)), vdupq_n_s16(k.c16));
+        const uint16x4x2_t uv = vld2_u16(src_uv + x);
+        const int16x4_t u = vsub_s16(
+                vreinterpret_s16_u16(vshr_n_u16(uv.val[0], 6)), vdup_n_s16(512));
+        const int16x4_t v = vsub_s16(
+                vreinterpret_s16_u16(vshr_n_u16(uv.val[1], 6)), vdup_n_s16(512));
+        int16x8_t r, g, b;
+        yuvToRgb(y, u, v, k, &r, &g, &b);
+        storeRgb<P>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+// YUV420Planar16 to 8 bit RGB: samples are truncated to 8 bits as (uint8_t)(s >> 2).
+template <RgbPacking P>
+static size_t convertRowPlanar16(const uint16_t *src_y, const uint16_t *src_u,
+        const uint16_t *src_v, uint8_t *dst, size_t width, size_t bpp, const YuvKernel &k) {
+    const uint16x8_t mask = vdupq_n_u16(0xFF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const int16x8_t y = vsubq_s16(vreinterpretq_s16_u16(
+                vandq_u16(vshrq_n_u16(vld1q_u16(src_y + x), 2), mask)), vdupq_n_s16(k.c16));
+        const int16x4_t u = vsub_s16(vreinterpret_s16_u16(
+                vand_u16(vshr_n_u16(vld1_u16(src_u + x / 2), 2), vget_low_u16(mask))),
+                vdup_n_s16(128));
+        const int16x4_t v = vsub_s16(vreinterpret_s16_u16(
+                vand_u16(vshr_n_u16(vld1_u16(src_v + x / 2), 2), vget_low_u16(mask))),
+                vdup_n_s16(128));
+        int16x8_t r, g, b;
+        yuvToRgb(y, u, v, k, &r, &g, &b);
+        storeRgb<P>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+#elif USE_SSE2_YUV16
+
+// uv holds four interleaved u, v pairs. r, g and b are clipped to [0, k.max].
+static inline void yuvToRgb(__m128i y, __m128i uv, const YuvKernel &k,
+        __m128i *r, __m128i *g, __m128i *b) {
+    // pmaddwd computes the sum of the products of adjacent 16 bit pairs
+    const __m128i ub = _mm_madd_epi16(uv, _mm_set1_epi32((uint16_t)k.b_u));
+    const __m128i guv = _mm_madd_epi16(uv,
+            _mm_set1_epi32(((uint32_t)(uint16_t)k.neg_g_v << 16) | (uint16_t)k.neg_g_u));
+    const __m128i vr = _mm_madd_epi16(uv, _mm_set1_epi32((uint32_t)(uint16_t)k.r_v << 16));
+    const __m128i yk = _mm_set1_epi32((128 << 16) | (uint16_t)k.y);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i ylo = _mm_madd_epi16(_mm_unpacklo_epi16(y, one), yk);
+    const __m128i yhi = _mm_madd_epi16(_mm_unpackhi_epi16(y, one), yk);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(k.max);
+    // each chroma sample covers two pixels
+    *b = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(ylo, _mm_unpacklo_epi32(ub, ub)), 8),
+            _mm_srai_epi32(_mm_add_epi32(yhi, _mm_unpackhi_epi32(ub, ub)), 8)), zero), max);
+    *g = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(ylo, _mm_unpacklo_epi32(guv, guv)), 8),
+            _mm_srai_epi32(_mm_add_epi32(yhi, _mm_unpackhi_epi32(guv, guv)), 8)), zero), max);
+    *r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(ylo, _mm_unpacklo_epi32(vr, vr)), 8),
+            _mm_srai_epi32(_mm_add_epi32(yhi, _mm_unpackhi_epi32(vr, vr)), 8)), zero), max);
+}
+
+template <RgbPacking P>
+static inline void storeRgb(uint8_t *dst, __m128i r, __m128i g, __m128i b) {
+    if (P == RgbPacking::RGB565) {
+        const __m128i rgb = _mm_or_si128(_mm_or_si128(
+                _mm_slli_epi16(_mm_srli_epi16(r, 3), 11),
+                _mm_slli_epi16(_mm_srli_epi16(g, 2), 5)),
+                _mm_srli_epi16(b, 3));
+        _mm_storeu_si128((__m128i *)dst, rgb);
+        return;
+    }
+    const __m128i c0 = P == RgbPacking::BGRA8888 ? b : r;
+    const __m128i c2 = P == RgbPacking::BGRA8888 ? r : b;
+    const __m128i alpha = _mm_set1_epi32(
+            P == RgbPacking::ABGR2101010 ? (int32_t)(3u << 30) : (int32_t)(0xFFu << 24));
+    const int shift = P == RgbPacking::ABGR2101010 ? 10 : 8;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_or_si128(_mm_or_si128(_mm_unpacklo_epi16(c0, zero),
+            _mm_slli_epi32(_mm_unpacklo_epi16(g, zero), shift)),
+            _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(c2, zero), shift * 2), alpha));
+    const __m128i hi = _mm_or_si128(_mm_or_si128(_mm_unpackhi_epi16(c0, zero),
+            _mm_slli_epi32(_mm_unpackhi_epi16(g, zero), shift)),
+            _mm_or_si128(_mm_slli_epi32(_mm_unpackhi_epi16(c2, zero), shift * 2), alpha));
+    _mm_storeu_si128((__m128i *)dst, lo);
+    _mm_storeu_si128((__m128i *)dst + 1, hi);
+}
+
+// P010: 10 bit samples in the upper bits, interleaved chroma.
+template <RgbPacking P>
+static size_t convertRowP010(const uint16_t *src_y, const uint16_t *src_uv, uint8_t *dst,
+        size_t width, size_t bpp, const YuvKernel &k) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i y = _mm_sub_epi16(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src_y + x)), 6),
+                _mm_set1_epi16(k.c16));
+        const __m128i uv = _mm_sub_epi16(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src_uv + x)), 6),
+                _mm_set1_epi16(512));
+        __m128i r, g, b;
+        yuvToRgb(y, uv, k, &r, &g, &b);
+        storeRgb<P>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+// YUV420Planar16 to 8 bit RGB: samples are truncated to 8 bits as (uint8_t)(s >> 2).
+template <RgbPacking P>
+static size_t convertRowPlanar16(const uint16_t *src_y, const uint16_t *src_u,
+        const uint16_t *src_v, uint8_t *dst, size_t width, size_t bpp, const YuvKernel &k) {
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i y = _mm_sub_epi16(_mm_and_si128(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src_y + x)), 2), mask),
+                _mm_set1_epi16(k.c16));
+        const __m128i u = _mm_loadl_epi64((const __m128i *)(src_u + x / 2));
+        const __m128i v = _mm_loadl_epi64((const __m128i *)(src_v + x / 2));
+        const __m128i uv = _mm_sub_epi16(
+                _mm_and_si128(_mm_srli_epi16(_mm_unpacklo_epi16(u, v), 2), mask),
+                _mm_set1_epi16(128));
+        __m128i r, g, b;
+        yuvToRgb(y, uv, k, &r, &g, &b);
+        storeRgb<P>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+#endif
+
+#if USE_NEON_YUV16 || USE_SSE2_YUV16
+
+using RowPlanar16Func = size_t (*)(const uint16_t *, const uint16_t *, const uint16_t *,
+        uint8_t *, size_t, size_t, const YuvKernel &);
+
+static RowPlanar16Func getRowPlanar16Func(OMX_COLOR_FORMATTYPE dstFormat) {
+    switch ((int)dstFormat) {
+    case OMX_COLOR_Format16bitRGB565:
+        return convertRowPlanar16<RgbPacking::RGB565>;
+    case OMX_COLOR_Format32BitRGBA8888:
+        return convertRowPlanar16<RgbPacking::RGBA8888>;
+    case OMX_COLOR_Format32bitBGRA8888:
+        return convertRowPlanar16<RgbPacking::BGRA8888>;
+    default:
+        return nullptr;
+    }
+}
+
+#endif
+
 status_t ColorConverter::convertYUV420Planar(
         const BitmapParams &src, const BitmapParams &dst) {
     const struct Coeffs *matrix = getMatrix();
@@ -809,8 +1183,23 @@ status_t ColorConverter::convertYUV420Planar(
 
     uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
 
+#if USE_NEON_YUV16 || USE_SSE2_YUV16
+    const YuvKernel kernel = {
+        (int16_t)_y, (int16_t)_c16, (int16_t)_b_u, (int16_t)_neg_g_u, (int16_t)_neg_g_v,
+        (int16_t)_r_v, 255 /* max */ };
+    const RowPlanar16Func convertRow = mSrcFormat == OMX_COLOR_FormatYUV420Planar16
+            ? getRowPlanar16Func(mDstFormat) : nullptr;
+#endif
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = 0;
+#if USE_NEON_YUV16 || USE_SSE2_YUV16
+        if (convertRow != nullptr) {
+            x = convertRow((const uint16_t *)src_y, (const uint16_t *)src_u,
+                    (const uint16_t *)src_v, dst_ptr, src.cropWidth(), dst.mBpp, kernel);
+        }
+#endif
+        for (; x < src.cropWidth(); x += 2) {
             signed y1, y2, u, v;
             readFromSrc(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
 
@@ -893,8 +1282,19 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
             + src.mStride * src.mHeight
             + (src.mCropTop / 2) * src.mStride + src.mCropLeft * src.mBpp);
 
+#if USE_NEON_YUV16 || USE_SSE2_YUV16
+    const YuvKernel kernel = {
+        (int16_t)_y, (int16_t)_c16, (int16_t)_b_u, (int16_t)_neg_g_u, (int16_t)_neg_g_v,
+        (int16_t)_r_v, 1023 /* max */ };
+#endif
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = 0;
+#if USE_NEON_YUV16 || USE_SSE2_YUV16
+        x = convertRowP010<RgbPacking::ABGR2101010>(
+                src_y, src_uv, dst_ptr, src.cropWidth(), dst.mBpp, kernel);
+#endif
+        for (; x < src.cropWidth(); x += 2) {
             signed y1, y2, u, v;
             y1 = (src_y[x] >> 6) - _c16;
             y2 = (src_y[x + 1] >> 6) - _c16;
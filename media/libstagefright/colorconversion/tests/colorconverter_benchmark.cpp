@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Converts one frame per iteration for every source and destination format
+// pair accepted by ColorConverter::isValid().
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+
+using namespace android;
+
+// state.range(0) is the source format, state.range(1) the destination format,
+// state.range(2) and state.range(3) the frame width and height, state.range(4)
+// the number of conversion threads.
+static void BM_ColorConverter(benchmark::State& state) {
+    const OMX_COLOR_FORMATTYPE srcFormat = (OMX_COLOR_FORMATTYPE)state.range(0);
+    const OMX_COLOR_FORMATTYPE dstFormat = (OMX_COLOR_FORMATTYPE)state.range(1);
+    const size_t width = state.range(2);
+    const size_t height = state.range(3);
+    const size_t threads = state.range(4);
+
+    ColorConverter converter(srcFormat, dstFormat);
+    if (!converter.isValid()) {
+        state.SkipWithError("invalid conversion");
+        return;
+    }
+    converter.setSrcColorSpace(ColorUtils::kColorStandardBT709,
+            ColorUtils::kColorRangeLimited, ColorUtils::kColorTransferSMPTE_170M);
+    converter.setNumThreads(threads);
+
+    // large enough for any supported format, 16 bit 4:2:0 or 32 bit packed.
+    std::vector<uint8_t> src(width * height * 4);
+    std::vector<uint8_t> dst(width * height * 4);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = (uint8_t)(i * 7);
+    }
+
+    for (auto _ : state) {
+        if (converter.convert(
+                src.data(), width, height, 0 /* srcStride */,
+                0, 0, width - 1, height - 1,
+                dst.data(), width, height, 0 /* dstStride */,
+                0, 0, width - 1, height - 1) != OK) {
+            state.SkipWithError("convert failed");
+            return;
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+static void ConversionArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"src", "dst", "width", "height", "threads"});
+    const int srcFormats[] = {
+        OMX_COLOR_FormatYUV420Planar,
+        OMX_COLOR_FormatYUV420Planar16,
+        OMX_COLOR_FormatCbYCrY,
+        OMX_QCOM_COLOR_FormatYVU420SemiPlanar,
+        OMX_TI_COLOR_FormatYUV420PackedSemiPlanar,
+        OMX_COLOR_FormatYUV420SemiPlanar,
+        COLOR_FormatYUVP010,
+    };
+    const int dstFormats[] = {
+        OMX_COLOR_Format16bitRGB565,
+        OMX_COLOR_Format32BitRGBA8888,
+        OMX_COLOR_Format32bitBGRA8888,
+        OMX_COLOR_FormatYUV444Y410,
+        COLOR_Format32bitABGR2101010,
+    };
+    for (int src : srcFormats) {
+        for (int dst : dstFormats) {
+            if (!ColorConverter((OMX_COLOR_FORMATTYPE)src, (OMX_COLOR_FORMATTYPE)dst).isValid()) {
+                continue;
+            }
+            for (int threads : {1, 4}) {
+                b->Args({src, dst, 1920, 1080, threads});
+                b->Args({src, dst, 3840, 2160, threads});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(ConversionArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "GLComputeFilter"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <GLES2/gl2ext.h>
+#include <gui/BufferQueue.h>
+#include <utils/Log.h>
+
+#include <media/MediaCodecBuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <ui/GraphicBuffer.h>
+
+#include "GLComputeFilter.h"
+
+namespace android {
+
+static const GLuint kWorkGroupSize = 16;
+
+// Writes ARGB8888 with A in the lowest byte. The source is RGBA, or ARGB
+// bytes uploaded as RGBA8 when uSrcArgb is set.
+static const char kComputeShader[] =
+    "#version 310 es\n"
+    "precision highp float;\n"
+    "layout(local_size_x = 16, local_size_y = 16) in;\n"
+    "uniform highp sampler2D uSrc;\n"
+    "layout(std430, binding = 0) writeonly buffer Dst { uint dst[]; };\n"
+    "uniform ivec2 uSize;\n"
+    "uniform int uEffect;\n"
+    "uniform bool uSrcArgb;\n"
+    "uniform float uSaturation;\n"
+    "void main() {\n"
+    "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    if (pos.x >= uSize.x || pos.y >= uSize.y) {\n"
+    "        return;\n"
+    "    }\n"
+    "    vec4 c = texelFetch(uSrc, pos, 0);\n"
+    "    vec4 rgba = uSrcArgb ? c.yzwx : c;\n"
+    "    if (uEffect == 1) {\n"
+    "        rgba = 1.0 - rgba;\n"
+    "    } else if (uEffect == 2) {\n"
+    "        float mono = dot(rgba.rgb, vec3(0.299, 0.587, 0.114));\n"
+    "        rgba.rgb = clamp(mix(vec3(mono), rgba.rgb, uSaturation), 0.0, 1.0);\n"
+    "    }\n"
+    "    uvec4 v = uvec4(rgba.argb * 255.0 + 0.5);\n"
+    "    dst[pos.y * uSize.x + pos.x] = v.x | (v.y << 8) | (v.z << 16) | (v.w << 24);\n"
+    "}\n";
+
+GLComputeFilter::GLComputeFilter(Effect effect)
+    : mEffect(effect),
+      mSaturation(1.f),
+      mDisplay(EGL_NO_DISPLAY),
+      mContext(EGL_NO_CONTEXT),
+      mSurface(EGL_NO_SURFACE),
+      mProgram(0),
+      mSizeLoc(-1),
+      mEffectLoc(-1),
+      mSrcArgbLoc(-1),
+      mSaturationLoc(-1),
+      mInputTexture(0),
+      mOutputBuffer(0),
+      mHasTimerQuery(false),
+      mTimerQuery(0) {
+}
+
+GLComputeFilter::~GLComputeFilter() {
+    reset();
+}
+
+status_t GLComputeFilter::start() {
+    mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, NULL, NULL)) {
+        ALOGE("Failed to initialize EGL: %#x", eglGetError());
+        return NO_INIT;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(mDisplay, configAttribs, &config, 1, &numConfigs)
+            || numConfigs != 1) {
+        ALOGE("No GLES 3 EGL config: %#x", eglGetError());
+        reset();
+        return NO_INIT;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 3,
+        EGL_NONE
+    };
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    // nothing is drawn, but not every driver supports EGL_KHR_surfaceless_context
+    const EGLint surfaceAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    mSurface = eglCreatePbufferSurface(mDisplay, config, surfaceAttribs);
+    if (mContext == EGL_NO_CONTEXT || mSurface == EGL_NO_SURFACE) {
+        ALOGE("Failed to create EGL context: %#x", eglGetError());
+        reset();
+        return NO_INIT;
+    }
+
+    status_t err = makeCurrent();
+    if (err != OK) {
+        reset();
+        return err;
+    }
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 3 || (major == 3 && minor < 1)) {
+        ALOGE("GLES %d.%d does not support compute shaders", major, minor);
+        reset();
+        return NO_INIT;
+    }
+
+    err = initProgram();
+    if (err != OK) {
+        reset();
+        return err;
+    }
+
+    glGenTextures(1, &mInputTexture);
+    glBindTexture(GL_TEXTURE_2D, mInputTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, mWidth, mHeight);
+
+    glGenBuffers(1, &mOutputBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mOutputBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, mWidth * mHeight * 4, NULL, GL_STREAM_READ);
+
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    mHasTimerQuery = extensions != NULL
+            && strstr(extensions, "GL_EXT_disjoint_timer_query") != NULL;
+    if (mHasTimerQuery) {
+        glGenQueries(1, &mTimerQuery);
+    }
+
+    GLenum glErr = glGetError();
+    if (glErr != GL_NO_ERROR) {
+        ALOGE("Failed to allocate GL resources: %#x", glErr);
+        reset();
+        return NO_MEMORY;
+    }
+
+    ALOGV("Started %dx%d, timer query %d", mWidth, mHeight, mHasTimerQuery);
+    return OK;
+}
+
+void GLComputeFilter::reset() {
+    if (mDisplay == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (mContext != EGL_NO_CONTEXT && makeCurrent() == OK) {
+        clearImages();
+        if (mTimerQuery != 0) {
+            glDeleteQueries(1, &mTimerQuery);
+        }
+        if (mOutputBuffer != 0) {
+            glDeleteBuffers(1, &mOutputBuffer);
+        }
+        if (mInputTexture != 0) {
+            glDeleteTextures(1, &mInputTexture);
+        }
+        if (mProgram != 0) {
+            glDeleteProgram(mProgram);
+        }
+    }
+    mTimerQuery = 0;
+    mOutputBuffer = 0;
+    mInputTexture = 0;
+    mProgram = 0;
+    mImages.clear();
+
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (mSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(mDisplay, mSurface);
+        mSurface = EGL_NO_SURFACE;
+    }
+    if (mContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(mDisplay, mContext);
+        mContext = EGL_NO_CONTEXT;
+    }
+    mDisplay = EGL_NO_DISPLAY;
+}
+
+status_t GLComputeFilter::setParameters(const sp<AMessage> &msg) {
+    sp<AMessage> params;
+    CHECK(msg->findMessage("params", &params));
+
+    int32_t invert;
+    if (mEffect != kEffectSaturation && params->findInt32("invert", &invert)) {
+        mEffect = invert != 0 ? kEffectInvert : kEffectCopy;
+    }
+
+    float saturation;
+    if (params->findFloat("saturation", &saturation)) {
+        mSaturation = saturation;
+    }
+
+    return OK;
+}
+
+status_t GLComputeFilter::processBuffers(
+        const sp<MediaCodecBuffer> &srcBuffer, const sp<MediaCodecBuffer> &outBuffer) {
+    status_t err = makeCurrent();
+    if (err != OK) {
+        return err;
+    }
+
+    if (srcBuffer->size() < (size_t)mWidth * mHeight * 4) {
+        ALOGE("Input buffer of %zu bytes is too small for %dx%d",
+                srcBuffer->size(), mWidth, mHeight);
+        return BAD_VALUE;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, mInputTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight,
+            GL_RGBA, GL_UNSIGNED_BYTE, srcBuffer->data());
+
+    return dispatch(mInputTexture, true /* srcArgb */, mWidth, mHeight, outBuffer);
+}
+
+status_t GLComputeFilter::processGraphicBuffer(
+        const sp<GraphicBuffer> &srcBuffer, const sp<MediaCodecBuffer> &outBuffer) {
+    status_t err = makeCurrent();
+    if (err != OK) {
+        return err;
+    }
+
+    GLuint texture;
+    err = getImageTexture(srcBuffer, &texture);
+    if (err != OK) {
+        return err;
+    }
+
+    int32_t width = std::min((int32_t)srcBuffer->getWidth(), mWidth);
+    int32_t height = std::min((int32_t)srcBuffer->getHeight(), mHeight);
+    return dispatch(texture, false /* srcArgb */, width, height, outBuffer);
+}
+
+status_t GLComputeFilter::makeCurrent() {
+    if (eglGetCurrentContext() == mContext) {
+        return OK;
+    }
+    if (!eglMakeCurrent(mDisplay, mSurface, mSurface, mContext)) {
+        ALOGE("eglMakeCurrent failed: %#x", eglGetError());
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
+
+status_t GLComputeFilter::initProgram() {
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    const char *source = kComputeShader;
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        ALOGE("Failed to compile the compute shader: %s", log);
+        glDeleteShader(shader);
+        return UNKNOWN_ERROR;
+    }
+
+    mProgram = glCreateProgram();
+    glAttachShader(mProgram, shader);
+    glLinkProgram(mProgram);
+    glDeleteShader(shader);
+
+    glGetProgramiv(mProgram, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[512];
+        glGetProgramInfoLog(mProgram, sizeof(log), NULL, log);
+        ALOGE("Failed to link the compute program: %s", log);
+        return UNKNOWN_ERROR;
+    }
+
+    mSizeLoc = glGetUniformLocation(mProgram, "uSize");
+    mEffectLoc = glGetUniformLocation(mProgram, "uEffect");
+    mSrcArgbLoc = glGetUniformLocation(mProgram, "uSrcArgb");
+    mSaturationLoc = glGetUniformLocation(mProgram, "uSaturation");
+
+    glUseProgram(mProgram);
+    glUniform1i(glGetUniformLocation(mProgram, "uSrc"), 0);
+    return OK;
+}
+
+void GLComputeFilter::clearImages() {
+    for (size_t i = 0; i < mImages.size(); ++i) {
+        const Image &image = mImages.valueAt(i);
+        glDeleteTextures(1, &image.mTexture);
+        eglDestroyImageKHR(mDisplay, image.mImage);
+    }
+    mImages.clear();
+}
+
+status_t GLComputeFilter::getImageTexture(const sp<GraphicBuffer> &buffer, GLuint *texture) {
+    ssize_t index = mImages.indexOfKey(buffer->getId());
+    if (index >= 0) {
+        *texture = mImages.valueAt(index).mTexture;
+        return OK;
+    }
+
+    // the producer reallocated its buffers, drop the images of the old ones
+    if (mImages.size() >= (size_t)BufferQueue::NUM_BUFFER_SLOTS) {
+        clearImages();
+    }
+
+    const EGLint attribs[] = {
+        EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
+        EGL_NONE
+    };
+    Image image;
+    image.mImage = eglCreateImageKHR(mDisplay, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+            (EGLClientBuffer)buffer->getNativeBuffer(), attribs);
+    if (image.mImage == EGL_NO_IMAGE_KHR) {
+        ALOGE("Failed to create an EGLImage for buffer %" PRIu64 ": %#x",
+                buffer->getId(), eglGetError());
+        return UNKNOWN_ERROR;
+    }
+
+    glGenTextures(1, &image.mTexture);
+    glBindTexture(GL_TEXTURE_2D, image.mTexture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)image.mImage);
+    GLenum glErr = glGetError();
+    if (glErr != GL_NO_ERROR) {
+        ALOGE("Failed to bind the EGLImage of buffer %" PRIu64 ": %#x",
+                buffer->getId(), glErr);
+        glDeleteTextures(1, &image.mTexture);
+        eglDestroyImageKHR(mDisplay, image.mImage);
+        return UNKNOWN_ERROR;
+    }
+
+    mImages.add(buffer->getId(), image);
+    *texture = image.mTexture;
+    return OK;
+}
+
+status_t GLComputeFilter::dispatch(GLuint texture, bool srcArgb, int32_t width, int32_t height,
+        const sp<MediaCodecBuffer> &outBuffer) {
+    const size_t size = (size_t)width * height * 4;
+    if (outBuffer->capacity() < size) {
+        ALOGE("Output buffer of %zu bytes is too small for %dx%d",
+                outBuffer->capacity(), width, height);
+        return BAD_VALUE;
+    }
+
+    glUseProgram(mProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform2i(mSizeLoc, width, height);
+    glUniform1i(mEffectLoc, mEffect);
+    glUniform1i(mSrcArgbLoc, srcArgb);
+    glUniform1f(mSaturationLoc, mSaturation);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mOutputBuffer);
+
+    if (mHasTimerQuery) {
+        glBeginQuery(GL_TIME_ELAPSED_EXT, mTimerQuery);
+    }
+    glDispatchCompute((width + kWorkGroupSize - 1) / kWorkGroupSize,
+            (height + kWorkGroupSize - 1) / kWorkGroupSize, 1);
+    if (mHasTimerQuery) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+    }
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // mapping waits for the dispatch to finish
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mOutputBuffer);
+    void *data = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (data == NULL) {
+        ALOGE("Failed to map the output buffer: %#x", glGetError());
+        return UNKNOWN_ERROR;
+    }
+    memcpy(outBuffer->data(), data, size);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    outBuffer->setRange(0, size);
+
+    if (mHasTimerQuery) {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        GLuint elapsedNs = 0;
+        glGetQueryObjectuiv(mTimerQuery, GL_QUERY_RESULT, &elapsedNs);
+        if (!disjoint) {
+            outBuffer->meta()->setInt64("gpu-time-us", elapsedNs / 1000);
+        }
+    }
+
+    return OK;
+}
+
+}   // namespace android
@@ -22,6 +22,7 @@
 
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
 
 #include <media/stagefright/BufferProducerWrapper.h>
@@ -35,6 +36,7 @@
 #include <gui/BufferItem.h>
 
 #include "ColorConvert.h"
+#include "GLComputeFilter.h"
 #include "GraphicBufferListener.h"
 #include "IntrinsicBlurFilter.h"
 #include "RSFilter.h"
@@ -162,7 +164,8 @@ static const size_t kBufferCountActual = 4;
 MediaFilter::MediaFilter()
     : mState(UNINITIALIZED),
       mGeneration(0),
-      mGraphicBufferListener(NULL) {
+      mGraphicBufferListener(NULL),
+      mDeferredFrames(0) {
 }
 
 MediaFilter::~MediaFilter() {
@@ -337,6 +340,7 @@ status_t MediaFilter::allocateBuffersOnPort(OMX_U32 portIndex) {
         info.mBufferID = i;
         info.mGeneration = mGeneration;
         info.mOutputFlags = 0;
+        info.mFrameNumber = 0;
         info.mData = new MediaCodecBuffer(
                 isInput ? mInputFormat : outputFormat,
                 new ABuffer(bufferSize));
@@ -450,11 +454,19 @@ void MediaFilter::processBuffers() {
     BufferInfo *outputInfo = mAvailableOutputBuffers[0];
     mAvailableOutputBuffers.removeAt(0);
 
+    outputInfo->mData->meta()->removeEntryByName("gpu-time-us");
+    int64_t startUs = ALooper::GetNowUs();
     status_t err;
-    err = mFilter->processBuffers(inputInfo->mData, outputInfo->mData);
+    if (inputInfo->mGraphicBuffer != NULL) {
+        err = mFilter->processGraphicBuffer(inputInfo->mGraphicBuffer, outputInfo->mData);
+    } else {
+        err = mFilter->processBuffers(inputInfo->mData, outputInfo->mData);
+    }
+    int64_t processTimeUs = ALooper::GetNowUs() - startUs;
     if (err != (status_t)OK) {
         outputInfo->mData->meta()->setInt32("err", err);
     }
+    outputInfo->mData->meta()->setInt64("process-time-us", processTimeUs);
 
     int64_t timeUs;
     CHECK(inputInfo->mData->meta()->findInt64("timeUs", &timeUs));
@@ -469,12 +481,12 @@ void MediaFilter::processBuffers() {
         ALOGV("Output stream saw EOS.");
     }
 
-    ALOGV("Processed input buffer %u [%zu], output buffer %u [%zu]",
+    ALOGV("Processed input buffer %u [%zu], output buffer %u [%zu] in %" PRId64 " us",
                 inputInfo->mBufferID, inputInfo->mData->size(),
-                outputInfo->mBufferID, outputInfo->mData->size());
+                outputInfo->mBufferID, outputInfo->mData->size(), processTimeUs);
 
     if (mGraphicBufferListener != NULL) {
-        delete inputInfo;
+        releaseInputFrame(inputInfo);
     } else {
         postFillThisBuffer(inputInfo);
     }
@@ -484,6 +496,22 @@ void MediaFilter::processBuffers() {
     signalProcessBuffers();
 }
 
+void MediaFilter::releaseInputFrame(BufferInfo *info) {
+    if (info->mGraphicBuffer != NULL) {
+        BufferItem item;
+        item.mSlot = info->mBufferID;
+        item.mFrameNumber = info->mFrameNumber;
+        mGraphicBufferListener->releaseBuffer(item);
+    }
+    delete info;
+
+    // a frame was left in the queue while all that can be acquired were held
+    if (mDeferredFrames > 0) {
+        --mDeferredFrames;
+        onInputFrameAvailable();
+    }
+}
+
 void MediaFilter::onAllocateComponent(const sp<AMessage> &msg) {
     CHECK_EQ(mState, UNINITIALIZED);
 
@@ -497,6 +525,10 @@ void MediaFilter::onAllocateComponent(const sp<AMessage> &msg) {
         mFilter = new IntrinsicBlurFilter;
     } else if (!strcasecmp(name, "android.filter.RenderScript")) {
         mFilter = new RSFilter;
+    } else if (!strcasecmp(name, "android.filter.gpu.zerofilter")) {
+        mFilter = new GLComputeFilter(GLComputeFilter::kEffectCopy);
+    } else if (!strcasecmp(name, "android.filter.gpu.saturation")) {
+        mFilter = new GLComputeFilter(GLComputeFilter::kEffectSaturation);
     } else {
         ALOGE("Unrecognized filter name: %s", name);
         signalError(NAME_NOT_FOUND);
@@ -719,7 +751,14 @@ void MediaFilter::onShutdown(const sp<AMessage> &msg) {
 void MediaFilter::onFlush() {
     mGeneration++;
 
+    // the input surface frames are ours, not in mBuffers
+    Vector<BufferInfo*> inputFrames = mAvailableInputBuffers;
     mAvailableInputBuffers.clear();
+    if (mGraphicBufferListener != NULL) {
+        for (size_t i = 0; i < inputFrames.size(); ++i) {
+            releaseInputFrame(inputFrames[i]);
+        }
+    }
     for (size_t i = 0; i < mBuffers[kPortIndexInput].size(); ++i) {
         BufferInfo *info = &mBuffers[kPortIndexInput].editItemAt(i);
         info->mStatus = BufferInfo::OWNED_BY_US;
@@ -774,9 +813,33 @@ void MediaFilter::onCreateInputSurface() {
 }
 
 void MediaFilter::onInputFrameAvailable() {
+    const bool gpuInput = mFilter->acceptsGraphicBuffers();
+    if (gpuInput && mAvailableInputBuffers.size() >= kBufferCountActual) {
+        // acquired on release of a held frame
+        ++mDeferredFrames;
+        return;
+    }
+
     BufferItem item = mGraphicBufferListener->getBufferItem();
     sp<GraphicBuffer> buf = mGraphicBufferListener->getBuffer(item);
 
+    if (gpuInput) {
+        // the filter samples the buffer itself, which is released once processed
+        BufferInfo *inputInfo = new BufferInfo;
+        inputInfo->mData = new MediaCodecBuffer(mInputFormat, new ABuffer(0));
+        inputInfo->mGraphicBuffer = buf;
+        inputInfo->mFrameNumber = item.mFrameNumber;
+        inputInfo->mBufferID = item.mSlot;
+        inputInfo->mGeneration = mGeneration;
+        inputInfo->mOutputFlags = 0;
+        inputInfo->mStatus = BufferInfo::OWNED_BY_US;
+        inputInfo->mData->meta()->setInt64("timeUs", item.mTimestamp / 1000);
+
+        mAvailableInputBuffers.push_back(inputInfo);
+        signalProcessBuffers();
+        return;
+    }
+
     // get pointer to graphic buffer
     void* bufPtr;
     buf->lock(GraphicBuffer::USAGE_SW_READ_OFTEN, &bufPtr);
@@ -792,6 +855,7 @@ void MediaFilter::onInputFrameAvailable() {
     convertRGBAToARGB(
             (uint8_t*)bufPtr, buf->getWidth(), buf->getHeight(),
             buf->getStride(), inputInfo->mData->data());
+    buf->unlock();
     inputInfo->mBufferID = item.mSlot;
     inputInfo->mGeneration = mGeneration;
     inputInfo->mOutputFlags = 0;
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GL_COMPUTE_FILTER_H_
+#define GL_COMPUTE_FILTER_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl31.h>
+
+#include <utils/KeyedVector.h>
+
+#include "SimpleFilter.h"
+
+namespace android {
+
+// Runs the zero (copy / invert) and saturation filters, including the
+// RGBA to ARGB conversion of input surface frames, in a GLES 3.1 compute
+// shader. Frames from an input surface are sampled straight from their
+// GraphicBuffer through an EGLImage, so the only CPU access to the pixels is
+// the read back into the ARGB8888 output buffer.
+struct GLComputeFilter : public SimpleFilter {
+public:
+    enum Effect {
+        kEffectCopy,
+        kEffectInvert,
+        kEffectSaturation,
+    };
+
+    explicit GLComputeFilter(Effect effect);
+
+    virtual status_t start();
+    virtual void reset();
+    virtual status_t setParameters(const sp<AMessage> &msg);
+    virtual status_t processBuffers(
+            const sp<MediaCodecBuffer> &srcBuffer, const sp<MediaCodecBuffer> &outBuffer);
+
+    virtual bool acceptsGraphicBuffers() const { return true; }
+    virtual status_t processGraphicBuffer(
+            const sp<GraphicBuffer> &srcBuffer, const sp<MediaCodecBuffer> &outBuffer);
+
+protected:
+    virtual ~GLComputeFilter();
+
+private:
+    struct Image {
+        EGLImageKHR mImage;
+        GLuint mTexture;
+    };
+
+    Effect mEffect;
+    float mSaturation;
+
+    EGLDisplay mDisplay;
+    EGLContext mContext;
+    EGLSurface mSurface;
+
+    GLuint mProgram;
+    GLint mSizeLoc;
+    GLint mEffectLoc;
+    GLint mSrcArgbLoc;
+    GLint mSaturationLoc;
+
+    // ARGB8888 input of processBuffers(), uploaded as RGBA8
+    GLuint mInputTexture;
+    GLuint mOutputBuffer;
+
+    // GL_EXT_disjoint_timer_query, for the GPU time of each frame
+    bool mHasTimerQuery;
+    GLuint mTimerQuery;
+
+    // EGLImages of the input surface buffers, by GraphicBuffer id
+    KeyedVector<uint64_t, Image> mImages;
+
+    status_t makeCurrent();
+    status_t initProgram();
+    void clearImages();
+    status_t getImageTexture(const sp<GraphicBuffer> &buffer, GLuint *texture);
+    status_t dispatch(GLuint texture, bool srcArgb, int32_t width, int32_t height,
+            const sp<MediaCodecBuffer> &outBuffer);
+};
+
+}   // namespace android
+
+#endif  // GL_COMPUTE_FILTER_H_
@@ -24,6 +24,7 @@
 namespace android {
 
 struct AMessage;
+class GraphicBuffer;
 class MediaCodecBuffer;
 
 struct SimpleFilter : public RefBase {
@@ -39,6 +40,15 @@ public:
     virtual status_t processBuffers(
             const sp<MediaCodecBuffer> &srcBuffer, const sp<MediaCodecBuffer> &outBuffer) = 0;
 
+    // Filters that read input surface frames on the GPU return true, and get
+    // those frames through processGraphicBuffer() instead of as an ARGB copy.
+    virtual bool acceptsGraphicBuffers() const { return false; }
+    virtual status_t processGraphicBuffer(
+            const sp<GraphicBuffer> & /* srcBuffer */,
+            const sp<MediaCodecBuffer> & /* outBuffer */) {
+        return INVALID_OPERATION;
+    }
+
 protected:
     int32_t mWidth, mHeight;
     int32_t mStride, mSliceHeight;
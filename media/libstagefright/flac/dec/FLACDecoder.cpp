@@ -20,6 +20,8 @@
 
 #include "FLACDecoder.h"
 
+#include <algorithm>
+
 #include <audio_utils/primitives.h> // float_from_i32
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -32,6 +34,15 @@ namespace android {
 // These are the corresponding callbacks with C++ calling conventions
 FLAC__StreamDecoderReadStatus FLACDecoder::readCallback(
         FLAC__byte buffer[], size_t *bytes) {
+    if (mInput != nullptr) {
+        const size_t actual = std::min(*bytes, mInputLen - mInputPos);
+        memcpy(buffer, mInput + mInputPos, actual);
+        mInputPos += actual;
+        *bytes = actual;
+        return (actual == 0 ? FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM
+                            : FLAC__STREAM_DECODER_READ_STATUS_CONTINUE);
+    }
+
     if (mBuffer == nullptr || mBufferLen == 0) {
         *bytes = 0;
         return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
@@ -159,6 +170,36 @@ static void copyToFloat(
     }
 }
 
+// Writes the stream marker and a STREAMINFO block holding |info|, as the only metadata
+// block, to |out|, which must hold kStreamInfoHeaderSize bytes.
+static constexpr size_t kStreamInfoHeaderSize = 8 + FLAC__STREAM_METADATA_STREAMINFO_LENGTH;
+
+static void writeStreamInfoHeader(const FLAC__StreamMetadata_StreamInfo &info, uint8_t *out) {
+    memcpy(out, "fLaC", 4);
+    out[4] = 0x80 | FLAC__METADATA_TYPE_STREAMINFO;  // last metadata block
+    out[5] = 0;
+    out[6] = 0;
+    out[7] = FLAC__STREAM_METADATA_STREAMINFO_LENGTH;
+    uint8_t *block = out + 8;
+    block[0] = info.min_blocksize >> 8;
+    block[1] = info.min_blocksize;
+    block[2] = info.max_blocksize >> 8;
+    block[3] = info.max_blocksize;
+    for (int i = 0; i < 3; ++i) {
+        block[4 + i] = info.min_framesize >> (16 - 8 * i);
+        block[7 + i] = info.max_framesize >> (16 - 8 * i);
+    }
+    // 20 bits sample rate, 3 bits channels - 1, 5 bits bits per sample - 1, 36 bits samples
+    const uint64_t packed = ((uint64_t)info.sample_rate << 44)
+            | ((uint64_t)(info.channels - 1) << 41)
+            | ((uint64_t)(info.bits_per_sample - 1) << 36)
+            | (info.total_samples & 0xFFFFFFFFFull);
+    for (int i = 0; i < 8; ++i) {
+        block[10 + i] = packed >> (56 - 8 * i);
+    }
+    memcpy(block + 18, info.md5sum, sizeof(info.md5sum));
+}
+
 // static
 FLACDecoder *FLACDecoder::Create() {
     FLACDecoder *decoder = new (std::nothrow) FLACDecoder();
@@ -175,10 +216,18 @@ FLACDecoder::FLACDecoder()
       mBufferLen(0),
       mBufferPos(0),
       mBufferDataSize(0),
+      mInput(nullptr),
+      mInputLen(0),
+      mInputPos(0),
       mStreamInfoValid(false),
       mWriteRequested(false),
       mWriteCompleted(false),
-      mErrorStatus((FLAC__StreamDecoderErrorStatus) -1) {
+      mErrorStatus((FLAC__StreamDecoderErrorStatus) -1),
+      mFrameDecodersPrimed(false),
+      mJob(),
+      mJobSequence(0),
+      mPendingThreads(0),
+      mQuit(false) {
     ALOGV("ctor:");
     memset(&mStreamInfo, 0, sizeof(mStreamInfo));
     memset(&mWriteHeader, 0, sizeof(mWriteHeader));
@@ -187,6 +236,7 @@ FLACDecoder::FLACDecoder()
 
 FLACDecoder::~FLACDecoder() {
     ALOGV("dtor:");
+    stopFrameThreads();
     if (mDecoder != NULL) {
         FLAC__stream_decoder_delete(mDecoder);
         mDecoder = NULL;
@@ -267,6 +317,10 @@ void FLACDecoder::flush() {
     if (!FLAC__stream_decoder_reset(mDecoder)) {
         ALOGE("flush: failed to reset FLAC stream decoder");
     }
+    for (auto &decoder : mFrameDecoders) {
+        decoder->flush();
+    }
+    mFrameDecodersPrimed = false;
 }
 
 status_t FLACDecoder::parseMetadata(const uint8_t *inBuffer, size_t inBufferLen) {
@@ -330,6 +384,7 @@ status_t FLACDecoder::parseMetadata(const uint8_t *inBuffer, size_t inBufferLen)
     // Now we have all metadata blocks.
     mBufferPos = 0;
     mBufferDataSize = 0;
+    mFrameDecodersPrimed = false;
 
     return OK;
 }
@@ -342,7 +397,15 @@ status_t FLACDecoder::decodeOneFrame(const uint8_t *inBuffer, size_t inBufferLen
         ALOGW("decodeOneFrame: no streaminfo metadata block");
     }
 
-    if (inBufferLen != 0) {
+    // Whole frames are read by libFLAC in place, only partial ones need to be buffered.
+    const bool readInPlace = inBufferLen != 0 && mBufferPos == mBufferDataSize;
+    if (readInPlace) {
+        mBufferPos = 0;
+        mBufferDataSize = 0;
+        mInput = inBuffer;
+        mInputLen = inBufferLen;
+        mInputPos = 0;
+    } else if (inBufferLen != 0) {
         status_t err = addDataToBuffer(inBuffer, inBufferLen);
         if (err != OK) {
             ALOGW("decodeOneFrame: addDataToBuffer returns error %d", err);
@@ -352,7 +415,18 @@ status_t FLACDecoder::decodeOneFrame(const uint8_t *inBuffer, size_t inBufferLen
 
     mWriteRequested = true;
     mWriteCompleted = false;
-    if (!FLAC__stream_decoder_process_single(mDecoder)) {
+    const bool processed = FLAC__stream_decoder_process_single(mDecoder);
+    if (readInPlace) {
+        mInput = nullptr;
+        if (mInputPos < mInputLen) {
+            status_t err = addDataToBuffer(inBuffer + mInputPos, mInputLen - mInputPos);
+            if (err != OK) {
+                ALOGW("decodeOneFrame: addDataToBuffer returns error %d", err);
+                return err;
+            }
+        }
+    }
+    if (!processed) {
         ALOGE("decodeOneFrame: process_single failed");
         return ERROR_MALFORMED;
     }
@@ -415,6 +489,178 @@ status_t FLACDecoder::decodeOneFrame(const uint8_t *inBuffer, size_t inBufferLen
     return OK;
 }
 
+status_t FLACDecoder::setParallelism(size_t threadCount) {
+    stopFrameThreads();
+    mFrameDecoders.clear();
+    mFrameDecodersPrimed = false;
+    if (threadCount == 0) {
+        return OK;
+    }
+
+    for (size_t i = 0; i <= threadCount; ++i) {
+        std::unique_ptr<FLACDecoder> decoder(Create());
+        if (decoder == nullptr) {
+            ALOGE("setParallelism: failed to create frame decoder");
+            mFrameDecoders.clear();
+            return NO_MEMORY;
+        }
+        mFrameDecoders.push_back(std::move(decoder));
+    }
+    mJobSequence = 0;
+    mPendingThreads = 0;
+    mQuit = false;
+    for (size_t i = 1; i <= threadCount; ++i) {
+        mFrameThreads.emplace_back(&FLACDecoder::frameThreadLoop, this, i);
+    }
+    return OK;
+}
+
+void FLACDecoder::stopFrameThreads() {
+    {
+        std::lock_guard<std::mutex> lock(mJobLock);
+        mQuit = true;
+    }
+    mJobCondition.notify_all();
+    for (auto &thread : mFrameThreads) {
+        thread.join();
+    }
+    mFrameThreads.clear();
+}
+
+status_t FLACDecoder::decodeFrames(const uint8_t *const inBuffers[], const size_t inBufferLens[],
+        size_t numFrames, void *outBuffer, size_t *outBufferLen, size_t outFrameLens[],
+        bool outputFloat) {
+    ALOGV("decodeFrames: %zu frames", numFrames);
+
+    if (!mStreamInfoValid) {
+        ALOGE("decodeFrames: no streaminfo metadata block");
+        return NO_INIT;
+    }
+    const size_t frameSize = getChannels() * (outputFloat ? sizeof(float) : sizeof(int16_t));
+    const size_t slotSize = getMaxBlockSize() * frameSize;
+    if (numFrames > *outBufferLen / slotSize) {
+        ALOGE("decodeFrames: output buffer of %zu bytes is too small for %zu frames",
+                *outBufferLen, numFrames);
+        return BAD_VALUE;
+    }
+    uint8_t *out = reinterpret_cast<uint8_t *>(outBuffer);
+
+    if (mFrameThreads.empty() || numFrames == 1) {
+        status_t status = OK;
+        size_t offset = 0;
+        for (size_t i = 0; i < numFrames; ++i) {
+            size_t len = slotSize;
+            status_t err = decodeOneFrame(
+                    inBuffers[i], inBufferLens[i], out + offset, &len, outputFloat);
+            if (err != OK) {
+                status = status == OK ? err : status;
+                len = 0;
+            }
+            outFrameLens[i] = len;
+            offset += len;
+        }
+        *outBufferLen = offset;
+        return status;
+    }
+
+    // The frame decoders are not given the metadata blocks, so they start from a STREAMINFO
+    // block of their own, which also resolves frame headers that refer to it.
+    if (!mFrameDecodersPrimed) {
+        uint8_t header[kStreamInfoHeaderSize];
+        writeStreamInfoHeader(mStreamInfo, header);
+        for (auto &decoder : mFrameDecoders) {
+            decoder->flush();
+            status_t err = decoder->parseMetadata(header, sizeof(header));
+            if (err != OK) {
+                ALOGE("decodeFrames: frame decoder rejected STREAMINFO: %d", err);
+                return err;
+            }
+        }
+        mFrameDecodersPrimed = true;
+    }
+
+    // Each frame is decoded into its own slot of the output buffer, then the slots are packed.
+    mJob.inBuffers = inBuffers;
+    mJob.inBufferLens = inBufferLens;
+    mJob.numFrames = numFrames;
+    mJob.outBuffer = out;
+    mJob.slotSize = slotSize;
+    mJob.outFrameLens = outFrameLens;
+    mJob.outputFloat = outputFloat;
+    mJob.nextFrame = 0;
+    mJob.status = OK;
+    {
+        std::lock_guard<std::mutex> lock(mJobLock);
+        mPendingThreads = mFrameThreads.size();
+        mJobSequence++;
+    }
+    mJobCondition.notify_all();
+    decodeJobFrames(mFrameDecoders[0].get());
+    {
+        std::unique_lock<std::mutex> lock(mJobLock);
+        mDoneCondition.wait(lock, [this] { return mPendingThreads == 0; });
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < numFrames; ++i) {
+        if (offset != i * slotSize && outFrameLens[i] > 0) {
+            memmove(out + offset, out + i * slotSize, outFrameLens[i]);
+        }
+        offset += outFrameLens[i];
+    }
+    *outBufferLen = offset;
+    return mJob.status;
+}
+
+void FLACDecoder::decodeJobFrames(FLACDecoder *decoder) {
+    for (;;) {
+        const size_t i = mJob.nextFrame.fetch_add(1);
+        if (i >= mJob.numFrames) {
+            return;
+        }
+        size_t len = mJob.slotSize;
+        status_t err = decoder->decodeOneFrame(mJob.inBuffers[i], mJob.inBufferLens[i],
+                mJob.outBuffer + i * mJob.slotSize, &len, mJob.outputFloat);
+        if (err == OK && (len == 0 || decoder->mBufferPos != decoder->mBufferDataSize)) {
+            ALOGE("decodeFrames: frame %zu is not a single complete frame", i);
+            err = ERROR_MALFORMED;
+        }
+        if (err != OK) {
+            // drop whatever is left of the frame, so that it does not corrupt the next one
+            FLAC__stream_decoder_flush(decoder->mDecoder);
+            decoder->mBufferPos = 0;
+            decoder->mBufferDataSize = 0;
+            status_t expected = OK;
+            mJob.status.compare_exchange_strong(expected, err);
+            len = 0;
+        }
+        mJob.outFrameLens[i] = len;
+    }
+}
+
+void FLACDecoder::frameThreadLoop(size_t decoderIndex) {
+    uint64_t sequence = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mJobLock);
+            mJobCondition.wait(lock, [&] { return mQuit || mJobSequence != sequence; });
+            if (mQuit) {
+                return;
+            }
+            sequence = mJobSequence;
+        }
+        decodeJobFrames(mFrameDecoders[decoderIndex].get());
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(mJobLock);
+            done = --mPendingThreads == 0;
+        }
+        if (done) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
 status_t FLACDecoder::addDataToBuffer(const uint8_t *inBuffer, size_t inBufferLen) {
     // mBufferPos should be no larger than mBufferDataSize
     if (inBufferLen > SIZE_MAX - (mBufferDataSize - mBufferPos)) {
@@ -17,6 +17,13 @@
 #ifndef FLAC_DECODER_H_
 #define FLAC_DECODER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <media/stagefright/foundation/ABase.h>
 #include <utils/RefBase.h>
 #include <utils/String8.h>
@@ -42,6 +49,21 @@ public:
     status_t parseMetadata(const uint8_t *inBuffer, size_t inBufferLen);
     status_t decodeOneFrame(const uint8_t *inBuffer, size_t inBufferLen,
             void *outBuffer, size_t *outBufferLen, bool outputFloat = false);
+
+    // FLAC frames are independent, so decodeFrames() can decode them on |threadCount|
+    // threads besides the calling one, each with its own libFLAC decoder. 0 disables this.
+    status_t setParallelism(size_t threadCount);
+    size_t getParallelism() const { return mFrameThreads.size(); }
+
+    // Decodes |numFrames| complete frames, frame i being |inBufferLens[i]| bytes at
+    // |inBuffers[i]|, into |outBuffer| of |*outBufferLen| bytes, which must hold
+    // |numFrames| blocks of the maximum block size. Returns the size of the output of each
+    // frame in |outFrameLens| and the total in |*outBufferLen|. Requires STREAMINFO, and
+    // must not be mixed with partial frames passed to decodeOneFrame().
+    status_t decodeFrames(const uint8_t *const inBuffers[], const size_t inBufferLens[],
+            size_t numFrames, void *outBuffer, size_t *outBufferLen, size_t outFrameLens[],
+            bool outputFloat = false);
+
     void flush();
     virtual ~FLACDecoder();
 
@@ -68,6 +90,11 @@ private:
 
     status_t addDataToBuffer(const uint8_t *inBuffer, size_t inBufferLen);
 
+    // decodes the frames of mJob claimed through mJob.nextFrame with |decoder|
+    void decodeJobFrames(FLACDecoder *decoder);
+    void frameThreadLoop(size_t decoderIndex);
+    void stopFrameThreads();
+
     FLAC__StreamDecoder *mDecoder;
 
     uint8_t *mBuffer;  // cache input bit stream data
@@ -76,6 +103,11 @@ private:
     // size of input data stored in |mBuffer|, always started at offset 0
     size_t mBufferDataSize;
 
+    // input read in place by libFLAC while |mBuffer| is empty, to save copying it there
+    const uint8_t *mInput;
+    size_t mInputLen;
+    size_t mInputPos;
+
     // cached when the STREAMINFO metadata is parsed by libFLAC
     FLAC__StreamMetadata_StreamInfo mStreamInfo;
     bool mStreamInfoValid;
@@ -89,6 +121,30 @@ private:
     // most recent error reported by libFLAC decoder
     FLAC__StreamDecoderErrorStatus mErrorStatus;
 
+    // frame parallel decoding, mFrameDecoders[0] is used by the calling thread and
+    // mFrameDecoders[i + 1] by mFrameThreads[i]
+    struct FrameJob {
+        const uint8_t *const *inBuffers;
+        const size_t *inBufferLens;
+        size_t numFrames;
+        uint8_t *outBuffer;
+        size_t slotSize;    // output bytes reserved per frame
+        size_t *outFrameLens;
+        bool outputFloat;
+        std::atomic<size_t> nextFrame;
+        std::atomic<status_t> status;
+    };
+    std::vector<std::unique_ptr<FLACDecoder>> mFrameDecoders;
+    std::vector<std::thread> mFrameThreads;
+    bool mFrameDecodersPrimed;  // with the current STREAMINFO
+    FrameJob mJob;
+    std::mutex mJobLock;
+    std::condition_variable mJobCondition;
+    std::condition_variable mDoneCondition;
+    uint64_t mJobSequence;      // guarded by mJobLock
+    size_t mPendingThreads;     // guarded by mJobLock
+    bool mQuit;                 // guarded by mJobLock
+
     status_t init();
 
     // FLAC stream decoder callbacks as C++ instance methods
@@ -245,6 +245,76 @@ TEST_P(FLACDecoderTest, DecodeTest) {
     ASSERT_EQ(status, 0) << "Test Failed. Decode returned error = " << status << endl;
 }
 
+TEST_P(FLACDecoderTest, ParallelDecodeTest) {
+    tuple<string /* InputFileName */, string /* InfoFileName */, bool /* outputfloat */> params =
+            GetParam();
+
+    string inputFileName = gEnv->getRes() + get<0>(params);
+    string infoFileName = gEnv->getRes() + get<1>(params);
+    bool outputFloat = get<2>(params);
+
+    vector<FrameInfo> Info;
+    getInfo(infoFileName, Info);
+
+    mEleStream.open(inputFileName, ifstream::binary);
+    ASSERT_EQ(mEleStream.is_open(), true);
+    vector<vector<uint8_t>> frames;
+    for (const FrameInfo &info : Info) {
+        ASSERT_GE(info.bytesCount, 0) << "Size for the memory allocation is negative";
+        vector<uint8_t> frame(info.bytesCount);
+        mEleStream.read(reinterpret_cast<char *>(frame.data()), frame.size());
+        ASSERT_EQ(mEleStream.gcount(), info.bytesCount);
+        frames.push_back(std::move(frame));
+    }
+
+    std::unique_ptr<FLACDecoder> parallelDecoder(FLACDecoder::Create());
+    ASSERT_NE(parallelDecoder, nullptr) << "FLACDecoder Creation Failed";
+    ASSERT_EQ(parallelDecoder->setParallelism(3), OK);
+    ASSERT_EQ(parallelDecoder->getParallelism(), 3u);
+
+    size_t frameID = 0;
+    status_t status = WOULD_BLOCK;
+    for (; frameID < Info.size() && Info[frameID].flags == CODEC_CONFIG_FLAG; frameID++) {
+        status = mFLACDecoder->parseMetadata(frames[frameID].data(), frames[frameID].size());
+        ASSERT_EQ(parallelDecoder->parseMetadata(frames[frameID].data(), frames[frameID].size()),
+                  status);
+    }
+    ASSERT_EQ(status, OK) << "Metadata is incomplete";
+
+    const size_t sampleSize = outputFloat ? sizeof(float) : sizeof(int16_t);
+    const size_t slotSize = mFLACDecoder->getMaxBlockSize() * mFLACDecoder->getChannels() *
+                            sampleSize;
+    vector<uint8_t> serialOut(slotSize * kMaxCount);
+    vector<uint8_t> parallelOut(slotSize * kMaxCount);
+    while (frameID < Info.size()) {
+        const size_t count = std::min<size_t>(kMaxCount, Info.size() - frameID);
+        vector<const uint8_t *> inBuffers;
+        vector<size_t> inBufferLens;
+        size_t serialSize = 0;
+        for (size_t i = frameID; i < frameID + count; i++) {
+            inBuffers.push_back(frames[i].data());
+            inBufferLens.push_back(frames[i].size());
+            size_t outSize = slotSize;
+            ASSERT_EQ(mFLACDecoder->decodeOneFrame(frames[i].data(), frames[i].size(),
+                                                   serialOut.data() + serialSize, &outSize,
+                                                   outputFloat),
+                      OK);
+            serialSize += outSize;
+        }
+
+        size_t parallelSize = parallelOut.size();
+        vector<size_t> outFrameLens(count);
+        ASSERT_EQ(parallelDecoder->decodeFrames(inBuffers.data(), inBufferLens.data(), count,
+                                                parallelOut.data(), &parallelSize,
+                                                outFrameLens.data(), outputFloat),
+                  OK);
+        ASSERT_EQ(parallelSize, serialSize) << "for frames from " << frameID;
+        ASSERT_EQ(memcmp(parallelOut.data(), serialOut.data(), serialSize), 0)
+                << "for frames from " << frameID;
+        frameID += count;
+    }
+}
+
 // TODO: Add remaining tests
 INSTANTIATE_TEST_SUITE_P(
         FLACDecoderTestAll, FLACDecoderTest,
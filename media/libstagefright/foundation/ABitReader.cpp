@@ -16,10 +16,24 @@
 
 #include "ABitReader.h"
 
+#include <endian.h>
+#include <string.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 
 namespace android {
 
+static inline uint64_t loadBigEndian64(const uint8_t *data) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return be64toh(word);
+}
+
+// true if any of the 8 bytes of |word| is zero
+static inline bool hasZeroByte(uint64_t word) {
+    return ((word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL) != 0;
+}
+
 ABitReader::ABitReader(const uint8_t *data, size_t size)
     : mData(data),
       mSize(size),
@@ -37,9 +51,17 @@ bool ABitReader::fillReservoir() {
         return false;
     }
 
+    if (mSize >= sizeof(mReservoir)) {
+        mReservoir = loadBigEndian64(mData);
+        mData += sizeof(mReservoir);
+        mSize -= sizeof(mReservoir);
+        mNumBitsLeft = 64;
+        return true;
+    }
+
     mReservoir = 0;
     size_t i;
-    for (i = 0; mSize > 0 && i < 4; ++i) {
+    for (i = 0; mSize > 0; ++i) {
         mReservoir = (mReservoir << 8) | *mData;
 
         ++mData;
@@ -47,7 +69,7 @@ bool ABitReader::fillReservoir() {
     }
 
     mNumBitsLeft = 8 * i;
-    mReservoir <<= 32 - mNumBitsLeft;
+    mReservoir <<= 64 - mNumBitsLeft;
     return true;
 }
 
@@ -68,12 +90,26 @@ bool ABitReader::getBitsGraceful(size_t n, uint32_t *out) {
         return false;
     }
 
-    uint32_t result = 0;
+    if (n == 0) {
+        *out = 0;
+        return true;
+    }
+
+    // fast path, the bits are already in the reservoir
+    if (n <= mNumBitsLeft) {
+        *out = mReservoir >> (64 - n);
+        mReservoir <<= n;
+        mNumBitsLeft -= n;
+        return true;
+    }
+
+    uint64_t result = 0;
     while (n > 0) {
         if (mNumBitsLeft == 0) {
             if (!fillReservoir()) {
                 return false;
             }
+            continue;
         }
 
         size_t m = n;
@@ -81,7 +117,7 @@ bool ABitReader::getBitsGraceful(size_t n, uint32_t *out) {
             m = mNumBitsLeft;
         }
 
-        result = (result << m) | (mReservoir >> (32 - m));
+        result = (result << m) | (mReservoir >> (64 - m));
         mReservoir <<= m;
         mNumBitsLeft -= m;
 
@@ -107,20 +143,37 @@ bool ABitReader::skipBits(size_t n) {
     return true;
 }
 
+bool ABitReader::getUEFromReservoir(uint32_t *out) {
+    if (mReservoir == 0) {
+        return false;
+    }
+    // a code with z leading zeros takes 2z + 1 bits
+    size_t numZeroes = __builtin_clzll(mReservoir);
+    size_t numBits = 2 * numZeroes + 1;
+    if (numZeroes >= 32 || numBits > mNumBitsLeft) {
+        return false;
+    }
+
+    *out = (mReservoir >> (64 - numBits)) - 1;
+    mReservoir <<= numBits;
+    mNumBitsLeft -= numBits;
+    return true;
+}
+
 void ABitReader::putBits(uint32_t x, size_t n) {
-    if (mOverRead) {
+    if (mOverRead || n == 0) {
         return;
     }
 
     CHECK_LE(n, 32u);
 
-    while (mNumBitsLeft + n > 32) {
+    while (mNumBitsLeft + n > 64) {
         mNumBitsLeft -= 8;
         --mData;
         ++mSize;
     }
 
-    mReservoir = (mReservoir >> n) | (x << (32 - n));
+    mReservoir = (mReservoir >> n) | ((uint64_t)x << (64 - n));
     mNumBitsLeft += n;
 }
 
@@ -175,9 +228,23 @@ bool NALBitReader::fillReservoir() {
         return false;
     }
 
+    // Emulation prevention bytes follow two zero bytes, so 8 bytes without zeros can be
+    // taken as is, unless the first of them ends a sequence started in the previous bytes.
+    if (mSize >= sizeof(mReservoir) && !(mNumZeros >= 2 && *mData == 3)) {
+        uint64_t word = loadBigEndian64(mData);
+        if (!hasZeroByte(word)) {
+            mReservoir = word;
+            mData += sizeof(mReservoir);
+            mSize -= sizeof(mReservoir);
+            mNumZeros = 0;
+            mNumBitsLeft = 64;
+            return true;
+        }
+    }
+
     mReservoir = 0;
     size_t i = 0;
-    while (mSize > 0 && i < 4) {
+    while (mSize > 0 && i < sizeof(mReservoir)) {
         bool isEmulationPreventionByte = (mNumZeros >= 2 && *mData == 3);
 
         if (*mData == 0) {
@@ -197,7 +264,9 @@ bool NALBitReader::fillReservoir() {
     }
 
     mNumBitsLeft = 8 * i;
-    mReservoir <<= 32 - mNumBitsLeft;
+    if (i > 0) {
+        mReservoir <<= 64 - mNumBitsLeft;
+    }
     return true;
 }
 
@@ -23,6 +23,8 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "ALooper.h"
 
 #include "AHandler.h"
@@ -64,13 +66,23 @@ private:
     DISALLOW_EVIL_CONSTRUCTORS(LooperThread);
 };
 
+// static
+bool ALooper::IsLaterEvent(const Event &a, const Event &b) {
+    // events due at the same time are delivered in the order they were posted
+    if (a.mWhenUs != b.mWhenUs) {
+        return a.mWhenUs > b.mWhenUs;
+    }
+    return a.mSequence > b.mSequence;
+}
+
 // static
 int64_t ALooper::GetNowUs() {
     return systemTime(SYSTEM_TIME_MONOTONIC) / 1000LL;
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextEventSequence(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -177,20 +189,17 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = GetNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
-    }
-
     Event event;
     event.mWhenUs = whenUs;
+    event.mSequence = mNextEventSequence++;
     event.mMessage = msg;
 
-    if (it == mEventQueue.begin()) {
+    mEventQueue.push_back(std::move(event));
+    std::push_heap(mEventQueue.begin(), mEventQueue.end(), IsLaterEvent);
+
+    if (mEventQueue.front().mSequence == mNextEventSequence - 1) {
         mQueueChangedCondition.signal();
     }
-
-    mEventQueue.insert(it, event);
 }
 
 bool ALooper::loop() {
@@ -205,7 +214,7 @@ bool ALooper::loop() {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.front().mWhenUs;
         int64_t nowUs = GetNowUs();
 
         if (whenUs > nowUs) {
@@ -218,8 +227,9 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        std::pop_heap(mEventQueue.begin(), mEventQueue.end(), IsLaterEvent);
+        event = std::move(mEventQueue.back());
+        mEventQueue.pop_back();
     }
 
     event.mMessage->deliver();
@@ -20,6 +20,9 @@
 
 #include <ctype.h>
 
+#include <atomic>
+#include <new>
+
 #include "AMessage.h"
 
 #include <log/log.h>
@@ -32,6 +35,7 @@
 #include "AString.h"
 
 #include <media/stagefright/foundation/hexdump.h>
+#include <utils/Mutex.h>
 
 #if defined(__ANDROID__) && !defined(__ANDROID_VNDK__) && !defined(__ANDROID_APEX__)
 #include <binder/Parcel.h>
@@ -41,6 +45,88 @@ namespace android {
 
 extern ALooperRoster gLooperRoster;
 
+namespace {
+
+// Bounded free list of storage blocks of a single size. Blocks of any other size, e.g. for
+// subclasses, go straight to the heap.
+template<size_t kBlockSize, size_t kMaxFreeBlocks>
+struct FreeList {
+    void *allocate(size_t size) {
+        if (size == kBlockSize) {
+            Mutex::Autolock autoLock(mLock);
+            if (mNumFreeBlocks > 0) {
+                return mFreeBlocks[--mNumFreeBlocks];
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void release(void *ptr, size_t size) {
+        if (size == kBlockSize) {
+            Mutex::Autolock autoLock(mLock);
+            if (mNumFreeBlocks < kMaxFreeBlocks) {
+                mFreeBlocks[mNumFreeBlocks++] = ptr;
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+private:
+    Mutex mLock;
+    void *mFreeBlocks[kMaxFreeBlocks];
+    size_t mNumFreeBlocks = 0;
+};
+
+// Enough for the messages in flight on a busy playback or recording session
+typedef FreeList<sizeof(AMessage), 256> MessageFreeList;
+typedef FreeList<sizeof(AReplyToken), 32> ReplyTokenFreeList;
+
+// The free lists are never destroyed, as messages may still be freed during static
+// destruction.
+MessageFreeList &messageFreeList() {
+    static MessageFreeList *freeList = new MessageFreeList;
+    return *freeList;
+}
+
+ReplyTokenFreeList &replyTokenFreeList() {
+    static ReplyTokenFreeList *freeList = new ReplyTokenFreeList;
+    return *freeList;
+}
+
+// Header stored in front of each item name
+struct NameHeader {
+    std::atomic<int32_t> mRefCount;
+    uint32_t mHash;
+};
+
+NameHeader *getNameHeader(const char *name) {
+    return reinterpret_cast<NameHeader *>(const_cast<char *>(name) - sizeof(NameHeader));
+}
+
+// FNV-1a
+uint32_t hashName(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+    }
+    return hash;
+}
+
+const uint16_t kNoItem = 0xFFFF;
+
+}  // namespace
+
+// static
+void *AReplyToken::operator new(size_t size) {
+    return replyTokenFreeList().allocate(size);
+}
+
+// static
+void AReplyToken::operator delete(void *ptr, size_t size) {
+    replyTokenFreeList().release(ptr, size);
+}
+
 status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     if (mReplied) {
         ALOGE("trying to post a duplicate reply");
@@ -52,6 +138,16 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     return OK;
 }
 
+// static
+void *AMessage::operator new(size_t size) {
+    return messageFreeList().allocate(size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+    messageFreeList().release(ptr, size);
+}
+
 AMessage::AMessage(void)
     : mWhat(0),
       mTarget(0) {
@@ -89,11 +185,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.releaseName();
         freeItemValue(&item);
     }
     mItems.clear();
+    mIndex.clear();
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -151,6 +247,19 @@ static void reportStats() {
 #endif
 
 inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+    if (!mIndex.empty()) {
+        uint32_t hash = hashName(name, len);
+        size_t mask = mIndex.size() - 1;
+        for (size_t slot = hash & mask; mIndex[slot] != kNoItem; slot = (slot + 1) & mask) {
+            const Item &item = mItems[mIndex[slot]];
+            if (item.mNameLength == len && item.nameHash() == hash
+                    && !memcmp(item.mName, name, len)) {
+                return mIndex[slot];
+            }
+        }
+        return mItems.size();
+    }
+
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
@@ -179,13 +288,69 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
+void AMessage::addToIndex(size_t itemIndex) {
+    // keep the table at most half full
+    if (mIndex.size() < mItems.size() * 2) {
+        rebuildIndex();
+        return;
+    }
+    size_t mask = mIndex.size() - 1;
+    size_t slot = mItems[itemIndex].nameHash() & mask;
+    while (mIndex[slot] != kNoItem) {
+        slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = static_cast<uint16_t>(itemIndex);
+}
+
+void AMessage::rebuildIndex() {
+    mIndex.clear();
+    if (mItems.size() <= kMinIndexedItems) {
+        return;
+    }
+    size_t size = kMinIndexedItems * 4;
+    while (size < mItems.size() * 2) {
+        size *= 2;
+    }
+    mIndex.resize(size, kNoItem);
+    for (size_t i = 0; i < mItems.size(); ++i) {
+        addToIndex(i);
+    }
+}
+
 // assumes item's name was uninitialized or NULL
 void AMessage::Item::setName(const char *name, size_t len) {
+    char *block = new char[sizeof(NameHeader) + len + 1];
+    NameHeader *header = new (block) NameHeader;
+    header->mRefCount.store(1, std::memory_order_relaxed);
+    header->mHash = hashName(name, len);
     mNameLength = len;
-    mName = new char[len + 1];
+    mName = block + sizeof(NameHeader);
     memcpy((void*)mName, name, len + 1);
 }
 
+// assumes item's name was uninitialized or NULL
+void AMessage::Item::shareName(const Item &other) {
+    getNameHeader(other.mName)->mRefCount.fetch_add(1, std::memory_order_relaxed);
+    mNameLength = other.mNameLength;
+    mName = other.mName;
+}
+
+void AMessage::Item::releaseName() {
+    if (mName == nullptr) {
+        return;
+    }
+    NameHeader *header = getNameHeader(mName);
+    if (header->mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        header->~NameHeader();
+        delete[] reinterpret_cast<char *>(header);
+    }
+    mName = nullptr;
+}
+
+uint32_t AMessage::Item::nameHash() const {
+    return getNameHeader(mName)->mHash;
+}
+
 AMessage::Item::Item(const char *name, size_t len)
     : mType(kTypeInt32) {
     // mName and mNameLength are initialized by setName
@@ -206,6 +371,9 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         // place a 'blank' item at the end - this is of type kTypeInt32
         mItems.emplace_back(name, len);
         item = &mItems[i];
+        if (i >= kMinIndexedItems) {
+            addToIndex(i);
+        }
     }
 
     return item;
@@ -480,6 +648,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
     msg->mItems = mItems;
+    msg->mIndex = mIndex;
 
 #ifdef DUMP_STATS
     {
@@ -494,7 +663,7 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        to->shareName(*from);
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -762,6 +931,7 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
 
         item->setName(name, strlen(name));
     }
+    msg->rebuildIndex();
 
     return msg;
 }
@@ -1010,9 +1180,9 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].releaseName();
     mItems[index].setName(name, len);
+    rebuildIndex();
     return OK;
 }
 
@@ -1075,8 +1245,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].releaseName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1087,6 +1256,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
+    rebuildIndex();
     return OK;
 }
 
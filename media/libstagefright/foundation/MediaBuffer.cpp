@@ -122,6 +122,11 @@ void MediaBuffer::add_ref() {
     (void) mRefCount.fetch_add(1);
 }
 
+bool MediaBuffer::add_first_ref() {
+    int expected = 0;
+    return mRefCount.compare_exchange_strong(expected, 1);
+}
+
 void *MediaBuffer::data() const {
     return mData;
 }
@@ -17,6 +17,9 @@
 #define LOG_TAG "MediaBufferGroup"
 #include <utils/Log.h>
 
+#include <sched.h>
+
+#include <atomic>
 #include <list>
 
 #include <binder/MemoryDealer.h>
@@ -36,13 +39,89 @@ constexpr T MIN(const T &a, const T &b) { return a <= b ? a : b; }
 static const size_t kSharedMemoryThreshold = MIN(
         (size_t)MediaBuffer::kSharedMemThreshold, (size_t)(4 * 1024));
 
+// Returned buffers are put in a small lock-free set of slots, which acquire_buffer()
+// takes them from without the lock. The slots may hold buffers that were acquired
+// again through the locked path, so taking a buffer from them goes through
+// add_first_ref(). Buffers that do not fit in the slots are found by the locked path.
+static const size_t kFreeSlots = 16;
+
 struct MediaBufferGroup::InternalData {
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
     std::list<MediaBufferBase *> mBuffers;
+
+    std::atomic<MediaBufferBase *> mFreeSlots[kFreeSlots] = {};
+    std::atomic<int> mSlotReaders{0};  // acquire_buffer() calls looking at buffers in slots
+    std::atomic<int> mWaiters{0};      // acquire_buffer() calls on the locked path
+    std::atomic<size_t> mWaitCount{0};
+    std::atomic<size_t> mGrowCount{0};
+
+    MediaBufferBase *takeFreeBuffer(size_t requestedSize);
+    void putFreeBuffer(MediaBufferBase *buffer);
+    bool retireFreeBuffer_l(MediaBufferBase *buffer);
 };
 
+// Takes the first local reference of a buffer that no one, local or remote, holds.
+static bool acquireIfFree(MediaBufferBase *buffer) {
+    // Remote references are only added while a local one is held.
+    return buffer->remoteRefcount() == 0 && buffer->add_first_ref();
+}
+
+MediaBufferBase *MediaBufferGroup::InternalData::takeFreeBuffer(size_t requestedSize) {
+    MediaBufferBase *buffer = nullptr;
+    mSlotReaders.fetch_add(1);
+    for (size_t i = 0; i < kFreeSlots && buffer == nullptr; ++i) {
+        if (mFreeSlots[i].load(std::memory_order_relaxed) == nullptr) {
+            continue;
+        }
+        MediaBufferBase *candidate = mFreeSlots[i].exchange(nullptr);
+        if (candidate == nullptr) {
+            continue;
+        }
+        if (candidate->size() < requestedSize) {
+            // Leave it for a smaller request, or for the locked path to replace.
+            MediaBufferBase *expected = nullptr;
+            (void)mFreeSlots[i].compare_exchange_strong(expected, candidate);
+        } else if (acquireIfFree(candidate)) {
+            buffer = candidate;
+        }
+    }
+    mSlotReaders.fetch_sub(1);
+    return buffer;
+}
+
+void MediaBufferGroup::InternalData::putFreeBuffer(MediaBufferBase *buffer) {
+    for (size_t i = 0; i < kFreeSlots; ++i) {
+        MediaBufferBase *expected = nullptr;
+        if (mFreeSlots[i].load(std::memory_order_relaxed) == nullptr
+                && mFreeSlots[i].compare_exchange_strong(expected, buffer)) {
+            return;
+        }
+    }
+}
+
+// Removes a buffer about to be deleted from the slots, and returns whether it is
+// still free once no acquire_buffer() call can be holding it from them.
+bool MediaBufferGroup::InternalData::retireFreeBuffer_l(MediaBufferBase *buffer) {
+    auto removeFromSlots = [this, buffer] {
+        for (size_t i = 0; i < kFreeSlots; ++i) {
+            MediaBufferBase *expected = buffer;
+            (void)mFreeSlots[i].compare_exchange_strong(expected, nullptr);
+        }
+    };
+    removeFromSlots();
+    while (mSlotReaders.load() != 0) {
+        sched_yield();
+    }
+    if (buffer->refcount() != 0) {
+        return false;
+    }
+    // It may have been taken, and returned to the slots, in the meantime.
+    removeFromSlots();
+    return true;
+}
+
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
     : mWrapper(nullptr), mInternal(new InternalData()) {
     mInternal->mGrowthLimit = growthLimit;
@@ -136,7 +215,7 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
             mInternal->mGrowthLimit > 0
             && mInternal->mBuffers.size() >= mInternal->mGrowthLimit
             && it != mInternal->mBuffers.end();) {
-        if ((*it)->refcount() == 0) {
+        if ((*it)->refcount() == 0 && mInternal->retireFreeBuffer_l(*it)) {
             (*it)->setObserver(nullptr);
             (*it)->release();
             it = mInternal->mBuffers.erase(it);
@@ -163,11 +242,21 @@ bool MediaBufferGroup::has_buffers() {
 
 status_t MediaBufferGroup::acquire_buffer(
         MediaBufferBase **out, bool nonBlocking, size_t requestedSize) {
+    MediaBufferBase *buffer = mInternal->takeFreeBuffer(requestedSize);
+    if (buffer != nullptr) {
+        buffer->reset();
+        *out = buffer;
+        return OK;
+    }
+
     Mutex::Autolock autoLock(mInternal->mLock);
+    // From here on, returned buffers signal the condition.
+    mInternal->mWaiters.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     for (;;) {
         size_t smallest = requestedSize;
         size_t biggest = requestedSize;
-        MediaBufferBase *buffer = nullptr;
+        buffer = nullptr;
         auto free = mInternal->mBuffers.end();
         for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
             const size_t size = (*it)->size();
@@ -176,15 +265,20 @@ status_t MediaBufferGroup::acquire_buffer(
             }
             if ((*it)->refcount() == 0) {
                 if (size >= requestedSize) {
-                    buffer = *it;
-                    break;
-                }
-                if (size < smallest) {
+                    if (acquireIfFree(*it)) {
+                        buffer = *it;
+                        break;
+                    }
+                } else if (size < smallest) {
                     smallest = size; // always free the smallest buf
                     free = it;
                 }
             }
         }
+        if (buffer == nullptr && free != mInternal->mBuffers.end()
+                && !mInternal->retireFreeBuffer_l(*free)) {
+            free = mInternal->mBuffers.end();
+        }
         if (buffer == nullptr
                 && (free != mInternal->mBuffers.end()
                     || mInternal->mBuffers.size() < mInternal->mGrowthLimit)) {
@@ -199,6 +293,8 @@ status_t MediaBufferGroup::acquire_buffer(
                 buffer = nullptr;
             } else {
                 buffer->setObserver(this);
+                buffer->add_ref();
+                mInternal->mGrowCount.fetch_add(1, std::memory_order_relaxed);
                 if (free != mInternal->mBuffers.end()) {
                     ALOGV("reallocate buffer, requested size %zu vs available %zu",
                             requestedSize, (*free)->size());
@@ -212,16 +308,18 @@ status_t MediaBufferGroup::acquire_buffer(
             }
         }
         if (buffer != nullptr) {
-            buffer->add_ref();
+            mInternal->mWaiters.fetch_sub(1);
             buffer->reset();
             *out = buffer;
             return OK;
         }
         if (nonBlocking) {
+            mInternal->mWaiters.fetch_sub(1);
             *out = nullptr;
             return WOULD_BLOCK;
         }
         // All buffers are in use, block until one of them is returned.
+        mInternal->mWaitCount.fetch_add(1, std::memory_order_relaxed);
         mInternal->mCondition.wait(mInternal->mLock);
     }
     // Never gets here.
@@ -231,7 +329,22 @@ size_t MediaBufferGroup::buffers() const {
     return mInternal->mBuffers.size();
 }
 
-void MediaBufferGroup::signalBufferReturned(MediaBufferBase *) {
+size_t MediaBufferGroup::waitCount() const {
+    return mInternal->mWaitCount.load(std::memory_order_relaxed);
+}
+
+size_t MediaBufferGroup::growCount() const {
+    return mInternal->mGrowCount.load(std::memory_order_relaxed);
+}
+
+void MediaBufferGroup::signalBufferReturned(MediaBufferBase *buffer) {
+    if (buffer != nullptr) {
+        mInternal->putFreeBuffer(buffer);
+        // Pairs with acquire_buffer() registering before it looks at the refcounts.
+        if (mInternal->mWaiters.load() == 0) {
+            return;
+        }
+    }
     Mutex::Autolock autoLock(mInternal->mLock);
     mInternal->mCondition.signal();
 }
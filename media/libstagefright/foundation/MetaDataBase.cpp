@@ -17,12 +17,16 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "MetaDataBase"
 #include <inttypes.h>
-#include <utils/KeyedVector.h>
 #include <utils/Log.h>
 
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -34,85 +38,312 @@
 
 namespace android {
 
-struct MetaDataBase::typed_data {
-    typed_data();
-    ~typed_data();
-
-    typed_data(const MetaDataBase::typed_data &);
-    typed_data &operator=(const MetaDataBase::typed_data &);
-
-    void clear();
-    void setData(uint32_t type, const void *data, size_t size);
-    void getData(uint32_t *type, const void **data, size_t *size) const;
-    // may include hexdump of binary data if verbose=true
-    String8 asString(bool verbose) const;
-
-private:
-    uint32_t mType;
-    size_t mSize;
+namespace {
+
+// Storage for values that are too large to be kept inline. Blocks are shared by copies of a
+// MetaDataBase and are never moved, so pointers returned by findData() stay valid until the
+// same key is set again. Only a block's exclusive owner writes to it, and then only to parts
+// no other item refers to.
+struct ValueBlock {
+    std::atomic<int32_t> mRefCount;
+    size_t mCapacity;
+    size_t mUsed;
+
+    static ValueBlock *Create(size_t capacity) {
+        void *mem = malloc(sizeof(ValueBlock) + capacity);
+        if (mem == NULL) {
+            return NULL;
+        }
+        ValueBlock *block = new (mem) ValueBlock;
+        block->mRefCount.store(1, std::memory_order_relaxed);
+        block->mCapacity = capacity;
+        block->mUsed = 0;
+        return block;
+    }
 
-    union {
-        void *ext_data;
-        float reservoir;
-    } u;
+    uint8_t *data() {
+        return reinterpret_cast<uint8_t *>(this + 1);
+    }
 
-    bool usesReservoir() const {
-        return mSize <= sizeof(u.reservoir);
+    bool contains(const uint8_t *ptr) {
+        return ptr >= data() && ptr < data() + mCapacity;
     }
 
-    void *allocateStorage(size_t size);
-    void freeStorage();
+    bool isShared() const {
+        return mRefCount.load(std::memory_order_acquire) > 1;
+    }
 
-    void *storage() {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+    void incRef() {
+        mRefCount.fetch_add(1, std::memory_order_relaxed);
     }
 
-    const void *storage() const {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+    void decRef() {
+        if (mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->~ValueBlock();
+            free(this);
+        }
     }
 };
 
+static_assert(sizeof(ValueBlock) % sizeof(int64_t) == 0, "values must stay aligned");
+
+// Fits the values of a typical sample (crypto IVs, keys and subsample sizes) or format
+const size_t kValueBlockSize = 256;
+
+size_t alignValueSize(size_t size) {
+    return (size + sizeof(int64_t) - 1) & ~(sizeof(int64_t) - 1);
+}
+
+}  // namespace
+
 struct MetaDataBase::Rect {
     int32_t mLeft, mTop, mRight, mBottom;
 };
 
-
+// Items are kept sorted by key in a flat array. Values of up to 8 bytes are stored in the
+// item itself, larger ones in a few shared value blocks, so copying metadata copies the item
+// array and takes references on the blocks.
 struct MetaDataBase::MetaDataInternal {
-    KeyedVector<uint32_t, MetaDataBase::typed_data> mItems;
+    struct Item {
+        uint32_t mKey;
+        uint32_t mType;
+        size_t mSize;
+        union {
+            uint8_t inlineData[sizeof(int64_t)];
+            int64_t alignment;
+            uint8_t *externalData;
+        } u;
+
+        bool isInline() const {
+            return mSize <= sizeof(u.inlineData);
+        }
+
+        const void *data() const {
+            return isInline() ? u.inlineData : u.externalData;
+        }
+    };
+
+    MetaDataInternal() {}
+    MetaDataInternal(const MetaDataInternal &from);
+    MetaDataInternal &operator=(const MetaDataInternal &from);
+    ~MetaDataInternal();
+
+    void clear();
+    ssize_t indexOfKey(uint32_t key) const;
+    // returns true if an existing value was overwritten
+    bool setData(uint32_t key, uint32_t type, const void *data, size_t size);
+    void removeItemAt(size_t index);
+
+    std::vector<Item> mItems;
+
+private:
+    std::vector<ValueBlock *> mBlocks;
+
+    void releaseBlocks();
+    uint8_t *allocateValue(size_t size);
+    uint8_t *compactValues(size_t extraSize);
 };
 
+MetaDataBase::MetaDataInternal::MetaDataInternal(const MetaDataInternal &from)
+    : mItems(from.mItems),
+      mBlocks(from.mBlocks) {
+    for (ValueBlock *block : mBlocks) {
+        block->incRef();
+    }
+}
+
+MetaDataBase::MetaDataInternal &MetaDataBase::MetaDataInternal::operator=(
+        const MetaDataInternal &from) {
+    if (this != &from) {
+        for (ValueBlock *block : from.mBlocks) {
+            block->incRef();
+        }
+        releaseBlocks();
+        mItems = from.mItems;
+        mBlocks = from.mBlocks;
+    }
+    return *this;
+}
+
+MetaDataBase::MetaDataInternal::~MetaDataInternal() {
+    releaseBlocks();
+}
+
+void MetaDataBase::MetaDataInternal::releaseBlocks() {
+    for (ValueBlock *block : mBlocks) {
+        block->decRef();
+    }
+    mBlocks.clear();
+}
+
+void MetaDataBase::MetaDataInternal::clear() {
+    mItems.clear();
+    // keep an unshared block around, as metadata is often cleared and refilled per sample
+    ValueBlock *reusable = NULL;
+    if (!mBlocks.empty() && !mBlocks.back()->isShared()) {
+        reusable = mBlocks.back();
+        mBlocks.pop_back();
+        reusable->mUsed = 0;
+    }
+    releaseBlocks();
+    if (reusable != NULL) {
+        mBlocks.push_back(reusable);
+    }
+}
+
+ssize_t MetaDataBase::MetaDataInternal::indexOfKey(uint32_t key) const {
+    auto it = std::lower_bound(mItems.begin(), mItems.end(), key,
+            [](const Item &item, uint32_t k) { return item.mKey < k; });
+    if (it == mItems.end() || it->mKey != key) {
+        return NAME_NOT_FOUND;
+    }
+    return it - mItems.begin();
+}
+
+uint8_t *MetaDataBase::MetaDataInternal::allocateValue(size_t size) {
+    size_t alignedSize = alignValueSize(size);
+    if (!mBlocks.empty()) {
+        ValueBlock *block = mBlocks.back();
+        if (!block->isShared() && block->mCapacity - block->mUsed >= alignedSize) {
+            uint8_t *dst = block->data() + block->mUsed;
+            block->mUsed += alignedSize;
+            return dst;
+        }
+    }
+
+    // Values that were overwritten or removed stay in their block. Once they take up most of
+    // the storage, move the remaining values to a new block instead of adding one.
+    size_t usedSize = 0;
+    for (ValueBlock *block : mBlocks) {
+        usedSize += block->mUsed;
+    }
+    size_t liveSize = 0;
+    for (const Item &item : mItems) {
+        if (!item.isInline()) {
+            liveSize += alignValueSize(item.mSize);
+        }
+    }
+    if (liveSize < usedSize / 2) {
+        return compactValues(alignedSize);
+    }
+
+    ValueBlock *block = ValueBlock::Create(std::max(kValueBlockSize, alignedSize));
+    if (block == NULL) {
+        return NULL;
+    }
+    mBlocks.push_back(block);
+    block->mUsed = alignedSize;
+    return block->data();
+}
+
+uint8_t *MetaDataBase::MetaDataInternal::compactValues(size_t extraSize) {
+    size_t liveSize = 0;
+    for (const Item &item : mItems) {
+        if (!item.isInline()) {
+            liveSize += alignValueSize(item.mSize);
+        }
+    }
+    ValueBlock *block = ValueBlock::Create(std::max(kValueBlockSize, liveSize + extraSize));
+    if (block == NULL) {
+        return NULL;
+    }
+    for (Item &item : mItems) {
+        if (!item.isInline()) {
+            uint8_t *dst = block->data() + block->mUsed;
+            memcpy(dst, item.u.externalData, item.mSize);
+            item.u.externalData = dst;
+            block->mUsed += alignValueSize(item.mSize);
+        }
+    }
+    releaseBlocks();
+    mBlocks.push_back(block);
+
+    uint8_t *dst = block->data() + block->mUsed;
+    block->mUsed += extraSize;
+    return dst;
+}
+
+bool MetaDataBase::MetaDataInternal::setData(
+        uint32_t key, uint32_t type, const void *data, size_t size) {
+    auto it = std::lower_bound(mItems.begin(), mItems.end(), key,
+            [](const Item &item, uint32_t k) { return item.mKey < k; });
+    bool overwrote_existing = it != mItems.end() && it->mKey == key;
+    size_t index = it - mItems.begin();
+
+    uint8_t *dst = NULL;
+    if (size > sizeof(Item::u.inlineData)) {
+        // overwrite in place if no one else can see the current value
+        if (overwrote_existing && !it->isInline() && alignValueSize(it->mSize) >= size) {
+            for (ValueBlock *block : mBlocks) {
+                if (block->contains(it->u.externalData)) {
+                    if (!block->isShared()) {
+                        dst = it->u.externalData;
+                    }
+                    break;
+                }
+            }
+        }
+        if (dst == NULL) {
+            dst = allocateValue(size);
+            if (dst == NULL) {
+                ALOGE("Couldn't allocate %zu bytes for item", size);
+                size = 0;
+            }
+        }
+    }
+
+    if (!overwrote_existing) {
+        mItems.insert(mItems.begin() + index, Item());
+    }
+    Item &item = mItems[index];
+    item.mKey = key;
+    item.mType = type;
+    item.mSize = size;
+    if (item.isInline()) {
+        memset(item.u.inlineData, 0, sizeof(item.u.inlineData));
+        dst = item.u.inlineData;
+    } else {
+        item.u.externalData = dst;
+    }
+    if (size > 0) {
+        memcpy(dst, data, size);
+    }
+    return overwrote_existing;
+}
+
+void MetaDataBase::MetaDataInternal::removeItemAt(size_t index) {
+    mItems.erase(mItems.begin() + index);
+}
 
 MetaDataBase::MetaDataBase()
     : mInternalData(new MetaDataInternal()) {
 }
 
 MetaDataBase::MetaDataBase(const MetaDataBase &from)
-    : mInternalData(new MetaDataInternal()) {
-    mInternalData->mItems = from.mInternalData->mItems;
+    : mInternalData(new MetaDataInternal(*from.mInternalData)) {
 }
 
 MetaDataBase& MetaDataBase::operator = (const MetaDataBase &rhs) {
-    this->mInternalData->mItems = rhs.mInternalData->mItems;
+    *this->mInternalData = *rhs.mInternalData;
     return *this;
 }
 
 MetaDataBase::~MetaDataBase() {
-    clear();
     delete mInternalData;
 }
 
 void MetaDataBase::clear() {
-    mInternalData->mItems.clear();
+    mInternalData->clear();
 }
 
 bool MetaDataBase::remove(uint32_t key) {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    mInternalData->mItems.removeItemsAt(i);
+    mInternalData->removeItemAt(i);
 
     return true;
 }
@@ -250,40 +481,28 @@ bool MetaDataBase::findRect(
 
 bool MetaDataBase::setData(
         uint32_t key, uint32_t type, const void *data, size_t size) {
-    bool overwrote_existing = true;
-
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
-    if (i < 0) {
-        typed_data item;
-        i = mInternalData->mItems.add(key, item);
-
-        overwrote_existing = false;
-    }
-
-    typed_data &item = mInternalData->mItems.editValueAt(i);
-
-    item.setData(type, data, size);
-
-    return overwrote_existing;
+    return mInternalData->setData(key, type, data, size);
 }
 
 bool MetaDataBase::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    const typed_data &item = mInternalData->mItems.valueAt(i);
+    const MetaDataInternal::Item &item = mInternalData->mItems[i];
 
-    item.getData(type, data, size);
+    *type = item.mType;
+    *size = item.mSize;
+    *data = item.data();
 
     return true;
 }
 
 bool MetaDataBase::hasData(uint32_t key) const {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
@@ -292,125 +511,40 @@ bool MetaDataBase::hasData(uint32_t key) const {
     return true;
 }
 
-MetaDataBase::typed_data::typed_data()
-    : mType(0),
-      mSize(0) {
-}
-
-MetaDataBase::typed_data::~typed_data() {
-    clear();
-}
-
-MetaDataBase::typed_data::typed_data(const typed_data &from)
-    : mType(from.mType),
-      mSize(0) {
-
-    void *dst = allocateStorage(from.mSize);
-    if (dst) {
-        memcpy(dst, from.storage(), mSize);
-    }
-}
-
-MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
-        const MetaDataBase::typed_data &from) {
-    if (this != &from) {
-        clear();
-        mType = from.mType;
-        void *dst = allocateStorage(from.mSize);
-        if (dst) {
-            memcpy(dst, from.storage(), mSize);
-        }
-    }
-
-    return *this;
-}
-
-void MetaDataBase::typed_data::clear() {
-    freeStorage();
-
-    mType = 0;
-}
-
-void MetaDataBase::typed_data::setData(
-        uint32_t type, const void *data, size_t size) {
-    clear();
-
-    mType = type;
-
-    void *dst = allocateStorage(size);
-    if (dst) {
-        memcpy(dst, data, size);
-    }
-}
-
-void MetaDataBase::typed_data::getData(
-        uint32_t *type, const void **data, size_t *size) const {
-    *type = mType;
-    *size = mSize;
-    *data = storage();
-}
-
-void *MetaDataBase::typed_data::allocateStorage(size_t size) {
-    mSize = size;
-
-    if (usesReservoir()) {
-        return &u.reservoir;
-    }
-
-    u.ext_data = malloc(mSize);
-    if (u.ext_data == NULL) {
-        ALOGE("Couldn't allocate %zu bytes for item", size);
-        mSize = 0;
-    }
-    return u.ext_data;
-}
-
-void MetaDataBase::typed_data::freeStorage() {
-    if (!usesReservoir()) {
-        if (u.ext_data) {
-            free(u.ext_data);
-            u.ext_data = NULL;
-        }
-    }
-
-    mSize = 0;
-}
-
-String8 MetaDataBase::typed_data::asString(bool verbose) const {
+// may include hexdump of binary data if verbose=true
+static String8 ValueAsString(uint32_t type, const void *data, size_t size, bool verbose) {
     String8 out;
-    const void *data = storage();
-    switch(mType) {
-        case TYPE_NONE:
-            out = String8::format("no type, size %zu)", mSize);
+    switch(type) {
+        case MetaDataBase::TYPE_NONE:
+            out = String8::format("no type, size %zu)", size);
             break;
-        case TYPE_C_STRING:
+        case MetaDataBase::TYPE_C_STRING:
             out = String8::format("(char*) %s", (const char *)data);
             break;
-        case TYPE_INT32:
+        case MetaDataBase::TYPE_INT32:
             out = String8::format("(int32_t) %d", *(int32_t *)data);
             break;
-        case TYPE_INT64:
+        case MetaDataBase::TYPE_INT64:
             out = String8::format("(int64_t) %" PRId64, *(int64_t *)data);
             break;
-        case TYPE_FLOAT:
+        case MetaDataBase::TYPE_FLOAT:
             out = String8::format("(float) %f", *(float *)data);
             break;
-        case TYPE_POINTER:
+        case MetaDataBase::TYPE_POINTER:
             out = String8::format("(void*) %p", *(void **)data);
             break;
-        case TYPE_RECT:
+        case MetaDataBase::TYPE_RECT:
         {
-            const Rect *r = (const Rect *)data;
-            out = String8::format("Rect(%d, %d, %d, %d)",
-                                  r->mLeft, r->mTop, r->mRight, r->mBottom);
+            const int32_t *r = (const int32_t *)data;
+            out = String8::format("Rect(%d, %d, %d, %d)", r[0], r[1], r[2], r[3]);
             break;
         }
 
         default:
-            out = String8::format("(unknown type %d, size %zu)", mType, mSize);
-            if (verbose && mSize <= 48) { // if it's less than three lines of hex data, dump it
+            out = String8::format("(unknown type %d, size %zu)", type, size);
+            if (verbose && size <= 48) { // if it's less than three lines of hex data, dump it
                 AString foo;
-                hexdump(data, mSize, 0, &foo);
+                hexdump(data, size, 0, &foo);
                 out.append("\n");
                 out.append(foo.c_str());
             }
@@ -430,11 +564,11 @@ static void MakeFourCCString(uint32_t x, char *s) {
 String8 MetaDataBase::toString() const {
     String8 s;
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        const MetaDataInternal::Item &item = mInternalData->mItems[i];
         char cc[5];
-        MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
-        s.appendFormat("%s: %s", cc, item.asString(false).string());
+        MakeFourCCString(item.mKey, cc);
+        s.appendFormat("%s: %s", cc,
+                ValueAsString(item.mType, item.data(), item.mSize, false).string());
         if (i != 0) {
             s.append(", ");
         }
@@ -444,11 +578,11 @@ String8 MetaDataBase::toString() const {
 
 void MetaDataBase::dumpToLog() const {
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        const MetaDataInternal::Item &item = mInternalData->mItems[i];
         char cc[5];
-        MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
-        ALOGI("%s: %s", cc, item.asString(true /* verbose */).string());
+        MakeFourCCString(item.mKey, cc);
+        ALOGI("%s: %s", cc,
+                ValueAsString(item.mType, item.data(), item.mSize, true /* verbose */).string());
     }
 }
 
@@ -461,12 +595,11 @@ status_t MetaDataBase::writeToParcel(Parcel &parcel) {
         return ret;
     }
     for (size_t i = 0; i < numItems; i++) {
-        int32_t key = mInternalData->mItems.keyAt(i);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
-        uint32_t type;
-        const void *data;
-        size_t size;
-        item.getData(&type, &data, &size);
+        const MetaDataInternal::Item &item = mInternalData->mItems[i];
+        int32_t key = item.mKey;
+        uint32_t type = item.mType;
+        const void *data = item.data();
+        size_t size = item.mSize;
         ret = parcel.writeInt32(key);
         if (ret) {
             return ret;
@@ -28,9 +28,20 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/misc.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace android {
 
 unsigned parseUE(ABitReader *br) {
+    uint32_t codeNum;
+    if (br->getUEFromReservoir(&codeNum)) {
+        return codeNum;
+    }
+
     unsigned numZeroes = 0;
     while (br->getBits(1) == 0) {
         ++numZeroes;
@@ -42,6 +53,11 @@ unsigned parseUE(ABitReader *br) {
 }
 
 unsigned parseUEWithFallback(ABitReader *br, unsigned fallback) {
+    uint32_t codeNum;
+    if (br->getUEFromReservoir(&codeNum)) {
+        return codeNum;
+    }
+
     unsigned numZeroes = 0;
     while (br->getBitsWithFallback(1, 1) == 0) {
         ++numZeroes;
@@ -288,6 +304,56 @@ void FindAVCDimensions(
     }
 }
 
+size_t FindNALStartCode(const uint8_t *data, size_t size) {
+    size_t offset = 0;
+
+#if defined(__SSE2__)
+    // Compare 16 candidate positions at a time against 00 00 01.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; offset + 18 <= size; offset += 16) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)&data[offset]);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)&data[offset + 1]);
+        __m128i b2 = _mm_loadu_si128((const __m128i *)&data[offset + 2]);
+        __m128i match = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+                _mm_cmpeq_epi8(b2, one));
+        int mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return offset + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__aarch64__)
+    // Compare 16 candidate positions at a time against 00 00 01, and leave
+    // the block holding a match to the scalar loop below.
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; offset + 18 <= size; offset += 16) {
+        uint8x16_t b0 = vld1q_u8(&data[offset]);
+        uint8x16_t b1 = vld1q_u8(&data[offset + 1]);
+        uint8x16_t b2 = vld1q_u8(&data[offset + 2]);
+        uint8x16_t match = vandq_u8(
+                vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+        if (vmaxvq_u8(match) != 0) {
+            break;
+        }
+    }
+#endif
+
+    // No start code can begin at, or right before, a byte above 0x01.
+    while (offset + 2 < size) {
+        if (data[offset + 2] > 0x01) {
+            offset += 3;
+        } else if (data[offset + 2] == 0x01 && data[offset] == 0x00
+                && data[offset + 1] == 0x00) {
+            return offset;
+        } else {
+            ++offset;
+        }
+    }
+    return size;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,17 +368,10 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    size_t offset = FindNALStartCode(data, size);
+    if (offset == size) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
@@ -320,25 +379,15 @@ status_t getNextNALUnit(
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
+    // |offset| ends up at the 0x01 of the next startcode.
+    size_t nextOffset = FindNALStartCode(&data[startOffset], size - startOffset);
+    if (nextOffset == size - startOffset) {
+        if (!startCodeFollows) {
             return -EAGAIN;
         }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+        offset = size + 2;
+    } else {
+        offset = startOffset + nextOffset + 2;
     }
 
     size_t endOffset = offset - 2;
@@ -360,6 +409,90 @@ status_t getNextNALUnit(
     return OK;
 }
 
+static void WriteNALSize(uint8_t *data, size_t nalSize) {
+    data[0] = nalSize >> 24;
+    data[1] = (nalSize >> 16) & 0xff;
+    data[2] = (nalSize >> 8) & 0xff;
+    data[3] = nalSize & 0xff;
+}
+
+static size_t ReadNALSize(const uint8_t *data) {
+    return ((size_t)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static void WriteStartCode(uint8_t *data) {
+    data[0] = 0x00;
+    data[1] = 0x00;
+    data[2] = 0x00;
+    data[3] = 0x01;
+}
+
+bool AnnexBToLengthPrefixedInPlace(uint8_t *data, size_t size, size_t *leadingSize) {
+    size_t nalStart = 0;
+    size_t prefixOffset = 0;
+    bool hasPrefix = false;
+    bool converted = true;
+
+    for (;;) {
+        size_t offset = nalStart + FindNALStartCode(&data[nalStart], size - nalStart);
+        bool found = offset < size;
+        // The size of a NAL unit only fits in place of a 4-byte startcode.
+        if (found && (offset == nalStart || data[offset - 1] != 0x00)) {
+            converted = false;
+            break;
+        }
+        size_t nalEnd = found ? offset - 1 : size;
+        if ((uint64_t)(nalEnd - nalStart) > UINT32_MAX) {
+            converted = false;
+            break;
+        }
+
+        // The sizes go behind the scan, so they are never mistaken for startcodes.
+        if (hasPrefix) {
+            WriteNALSize(&data[prefixOffset], nalEnd - nalStart);
+        } else {
+            *leadingSize = nalEnd - nalStart;
+        }
+        if (!found) {
+            break;
+        }
+        prefixOffset = nalEnd;
+        nalStart = offset + 3;
+        hasPrefix = true;
+    }
+
+    if (!converted && hasPrefix) {
+        // Put back the startcodes replaced so far.
+        for (size_t offset = *leadingSize; offset < prefixOffset;) {
+            size_t nalSize = ReadNALSize(&data[offset]);
+            WriteStartCode(&data[offset]);
+            offset += 4 + nalSize;
+        }
+    }
+    return converted;
+}
+
+bool LengthPrefixedToAnnexBInPlace(uint8_t *data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < 4) {
+            return false;
+        }
+        size_t nalSize = ReadNALSize(&data[offset]);
+        if (nalSize == 0 || nalSize > size - offset - 4) {
+            return false;
+        }
+        offset += 4 + nalSize;
+    }
+
+    for (offset = 0; offset < size;) {
+        size_t nalSize = ReadNALSize(&data[offset]);
+        WriteStartCode(&data[offset]);
+        offset += 4 + nalSize;
+    }
+    return true;
+}
+
 static sp<ABuffer> FindNAL(const uint8_t *data, size_t size, unsigned nalType) {
     const uint8_t *nalStart;
     size_t nalSize;
@@ -46,9 +46,14 @@ public:
     // Tries to skip |n| bits. Returns true iff successful. Skipping 0 bits will always succeed.
     bool skipBits(size_t n);
 
+    // Fast path for unsigned Exp-Golomb codes (ue(v)) of up to 32 bits. If the whole code is
+    // already buffered, consumes it, stores its value in |out| and returns true. Otherwise
+    // returns false without consuming anything, and the code must be read bit by bit.
+    bool getUEFromReservoir(uint32_t *out);
+
     // "Puts" |n| bits with the value |x| back virtually into the bit stream. The put-back bits
     // are not actually written into the data, but are tracked in a separate buffer that can
-    // store at most 32 bits. This is a no-op if the stream has already been over-read.
+    // store at most 64 bits. This is a no-op if the stream has already been over-read.
     void putBits(uint32_t x, size_t n);
 
     size_t numBitsLeft() const;
@@ -63,10 +68,11 @@ protected:
     const uint8_t *mData;
     size_t mSize;
 
-    uint32_t mReservoir;  // left-aligned bits
+    uint64_t mReservoir;  // left-aligned bits
     size_t mNumBitsLeft;
     bool mOverRead;
 
+    // Refills the empty reservoir with up to 64 bits. Called once every 8 bytes of data.
     virtual bool fillReservoir();
 
     DISALLOW_EVIL_CONSTRUCTORS(ABitReader);
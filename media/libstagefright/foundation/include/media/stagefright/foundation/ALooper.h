@@ -26,6 +26,8 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <vector>
+
 namespace android {
 
 struct AHandler;
@@ -66,15 +68,22 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        // orders events posted for the same time
+        uint64_t mSequence;
         sp<AMessage> mMessage;
     };
 
+    // heap ordering that keeps the next event to deliver at the front of the queue
+    static bool IsLaterEvent(const Event &a, const Event &b);
+
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // binary min-heap on (mWhenUs, mSequence)
+    std::vector<Event> mEventQueue;
+    uint64_t mNextEventSequence;
 
     struct LooperThread;
     sp<LooperThread> mThread;
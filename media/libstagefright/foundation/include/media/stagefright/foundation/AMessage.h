@@ -39,6 +39,10 @@ struct AReplyToken : public RefBase {
           mReplied(false) {
     }
 
+    // reply tokens are recycled through a process-wide free list, see AMessage
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
 private:
     friend struct AMessage;
     friend struct ALooper;
@@ -65,6 +69,11 @@ struct AMessage : public RefBase {
     AMessage();
     AMessage(uint32_t what, const sp<const AHandler> &handler);
 
+    // Messages are created and freed at a high rate by every looper, usually on different
+    // threads, so their storage is recycled through a small process-wide free list.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
 #if !defined(__ANDROID_VNDK__) && !defined(__ANDROID_APEX__)
     // Construct an AMessage from a parcel.
     // nestingAllowed determines how many levels AMessage can be nested inside
@@ -304,16 +313,29 @@ private:
         const char *mName;
         size_t      mNameLength;
         Type mType;
+        // Names are immutable and reference counted, so that copies of a message share them.
         void setName(const char *name, size_t len);
+        void shareName(const Item &other);
+        void releaseName();
+        uint32_t nameHash() const;
         Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
         Item(const char *name, size_t length);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // messages with more items than this also keep a hash index of the item names
+        kMinIndexedItems = 16,
     };
     std::vector<Item> mItems;
 
+    // Open addressing table of indices into mItems, keyed by name hash. Empty for messages
+    // with up to kMinIndexedItems items, which are searched linearly.
+    std::vector<uint16_t> mIndex;
+
+    void addToIndex(size_t itemIndex);
+    void rebuildIndex();
+
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
      * item value is freed. Otherwise a new item is added.
@@ -75,11 +75,26 @@ inline void skipSE(ABitReader *br) {
     (void)parseSEWithFallback(br, 0);
 }
 
+// Returns the offset of the first 00 00 01 startcode in the |size| bytes at |data|, or |size| if
+// there is none.
+size_t FindNALStartCode(const uint8_t *data, size_t size);
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
         bool startCodeFollows = false);
 
+// Replaces the 4-byte startcodes in the |size| bytes at |data| with the 4-byte big endian sizes of
+// the NAL units following them. The bytes before the first startcode are a NAL unit of their own,
+// whose size is returned in |leadingSize|. Returns false, and leaves |data| unchanged, if a NAL
+// unit starts with a 3-byte startcode, as its size does not fit in place.
+bool AnnexBToLengthPrefixedInPlace(uint8_t *data, size_t size, size_t *leadingSize);
+
+// Replaces the 4-byte big endian sizes before the NAL units in the |size| bytes at |data| with
+// 4-byte startcodes. Returns false, and leaves |data| unchanged, if a size is zero or runs past
+// the end of the data.
+bool LengthPrefixedToAnnexBInPlace(uint8_t *data, size_t size);
+
 sp<ABuffer> MakeAVCCodecSpecificData(
         const sp<ABuffer> &accessUnit, int32_t *width, int32_t *height,
         int32_t *sarWidth = nullptr, int32_t *sarHeight = nullptr);
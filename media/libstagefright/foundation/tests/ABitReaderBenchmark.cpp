@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABitReader.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+using namespace android;
+
+static std::vector<uint8_t> randomData(size_t size, bool withStartCodePrefixes) {
+    std::default_random_engine gen(0xC0FFEE);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = byteDist(gen);
+        // zero runs and emulation prevention bytes, as in slice data
+        if (withStartCodePrefixes && i >= 2 && i % 64 == 0) {
+            data[i - 2] = 0;
+            data[i - 1] = 0;
+            data[i] = 3;
+        }
+    }
+    return data;
+}
+
+// Mixed field sizes, as in header parsing
+template<class Reader>
+static void BM_GetBits(benchmark::State& state) {
+    std::vector<uint8_t> data = randomData(state.range(0), true);
+    static const size_t kFieldBits[] = {1, 3, 8, 16, 2, 5, 32, 4};
+    for (auto _ : state) {
+        Reader br(data.data(), data.size());
+        uint32_t value = 0;
+        for (size_t i = 0; br.getBitsGraceful(kFieldBits[i % 8], &value); ++i) {
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// Exp-Golomb codes of small values, as in parameter sets and slice headers
+static void BM_ParseUE(benchmark::State& state) {
+    std::vector<uint8_t> data(state.range(0));
+    std::default_random_engine gen(0xC0FFEE);
+    std::geometric_distribution<uint32_t> valueDist(0.3);
+    size_t bit = 0;
+    while (true) {
+        uint32_t codeNum = valueDist(gen) + 1;
+        size_t numBits = 2 * (31 - __builtin_clz(codeNum)) + 1;
+        if (bit + numBits > data.size() * 8) {
+            break;
+        }
+        bit += numBits - (32 - __builtin_clz(codeNum));
+        for (int b = 31 - __builtin_clz(codeNum); b >= 0; --b, ++bit) {
+            data[bit / 8] |= ((codeNum >> b) & 1) << (7 - bit % 8);
+        }
+    }
+
+    for (auto _ : state) {
+        ABitReader br(data.data(), data.size());
+        while (br.numBitsLeft() > 64) {
+            benchmark::DoNotOptimize(parseUE(&br));
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK_TEMPLATE(BM_GetBits, ABitReader)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_GetBits, NALBitReader)->Arg(64)->Arg(4096);
+BENCHMARK(BM_ParseUE)->Arg(64)->Arg(4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ABitReader_test"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <media/stagefright/foundation/ABitReader.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+namespace android {
+
+TEST(ABitReader_tests, reads_across_refills) {
+    std::vector<uint8_t> data(19);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i + 1;
+    }
+    ABitReader br(data.data(), data.size());
+
+    EXPECT_EQ(0x01u, br.getBits(8));
+    // straddles the first and second 8-byte words
+    EXPECT_EQ(0x02030405u, br.getBits(32));
+    EXPECT_EQ(0x0607u, br.getBits(16));
+    EXPECT_EQ(0x08090A0Bu, br.getBits(32));
+    EXPECT_EQ(8 * 8u, br.numBitsLeft());
+
+    // put back more than was left in the reservoir
+    br.putBits(0x090A0B, 24);
+    br.putBits(0x0608, 16);
+    EXPECT_EQ(0x0608u, br.getBits(16));
+    EXPECT_EQ(0x090A0Bu, br.getBits(24));
+
+    uint32_t value;
+    EXPECT_TRUE(br.skipBits(7 * 8));
+    EXPECT_TRUE(br.getBitsGraceful(8, &value));
+    EXPECT_EQ(0x13u, value);
+    EXPECT_FALSE(br.getBitsGraceful(1, &value));
+    EXPECT_TRUE(br.overRead());
+}
+
+TEST(ABitReader_tests, strips_emulation_prevention_bytes) {
+    const uint8_t data[] = {
+        0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88,  // taken as a whole word
+        0x00, 0x00, 0x03, 0x01, 0x99, 0x00, 0x00, 0x03,
+        0x03, 0xAA, 0x00, 0x00,
+    };
+    NALBitReader br(data, sizeof(data));
+
+    EXPECT_TRUE(br.atLeastNumBitsLeft(18 * 8));
+    EXPECT_FALSE(br.atLeastNumBitsLeft(18 * 8 + 1));
+    EXPECT_EQ(0x11223344u, br.getBits(32));
+    EXPECT_EQ(0x55667788u, br.getBits(32));
+    EXPECT_EQ(0x00000199u, br.getBits(32));
+    // only the first 0x03 follows two zeros
+    EXPECT_EQ(0x000003AAu, br.getBits(32));
+    EXPECT_EQ(0x0000u, br.getBits(16));
+}
+
+TEST(ABitReader_tests, parses_exp_golomb_codes) {
+    // ue(v) 0, 1, 2, 3, 6 and 65534, then se(v) -1 and 2
+    const uint8_t data[] = {
+        0b10100110, 0b01000011, 0b10000000, 0b00000000,
+        0b11111111, 0b11111111, 0b01100100, 0b00000000,
+    };
+    ABitReader br(data, sizeof(data));
+
+    EXPECT_EQ(0u, parseUE(&br));
+    EXPECT_EQ(1u, parseUE(&br));
+    EXPECT_EQ(2u, parseUE(&br));
+    EXPECT_EQ(3u, parseUE(&br));
+    EXPECT_EQ(6u, parseUE(&br));
+    EXPECT_EQ(65534u, parseUE(&br));
+    EXPECT_EQ(-1, parseSE(&br));
+    EXPECT_EQ(2, parseSE(&br));
+
+    // a code longer than the data left
+    EXPECT_EQ(123u, parseUEWithFallback(&br, 123));
+}
+
+}  // namespace android
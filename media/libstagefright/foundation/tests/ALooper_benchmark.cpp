@@ -0,0 +1,141 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+namespace {
+
+enum {
+    kWhatCount,
+    kWhatPing,
+};
+
+struct CountingHandler : public AHandler {
+    void waitForCount(int64_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [&] { return mCount >= count; });
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        switch (msg->what()) {
+            case kWhatCount:
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                ++mCount;
+                mCondition.notify_all();
+                break;
+            }
+            case kWhatPing:
+            {
+                sp<AReplyToken> replyID;
+                if (msg->senderAwaitsResponse(&replyID)) {
+                    (new AMessage)->postReply(replyID);
+                }
+                break;
+            }
+        }
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    int64_t mCount = 0;
+};
+
+}  // namespace
+
+// Messages posted from one thread and delivered on the looper thread
+static void BM_ALooper_PostDeliver(benchmark::State& state) {
+    sp<ALooper> looper = new ALooper;
+    sp<CountingHandler> handler = new CountingHandler;
+    looper->registerHandler(handler);
+    looper->start();
+
+    int64_t count = 0;
+    for (auto _ : state) {
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            sp<AMessage> msg = new AMessage(kWhatCount, handler);
+            msg->setInt64("index", i);
+            msg->post();
+        }
+        count += state.range(0);
+        handler->waitForCount(count);
+    }
+    state.SetItemsProcessed(count);
+
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+// Round trip latency of postAndAwaitResponse, which also allocates a reply token
+static void BM_ALooper_PostAndAwaitResponse(benchmark::State& state) {
+    sp<ALooper> looper = new ALooper;
+    sp<CountingHandler> handler = new CountingHandler;
+    looper->registerHandler(handler);
+    looper->start();
+
+    for (auto _ : state) {
+        sp<AMessage> response;
+        (new AMessage(kWhatPing, handler))->postAndAwaitResponse(&response);
+        benchmark::DoNotOptimize(response.get());
+    }
+
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+// Delayed messages posted into a queue that already holds range(0) pending events, the way
+// renderers and RTP sessions keep many timeouts outstanding
+static void BM_ALooper_PostDelayed(benchmark::State& state) {
+    std::default_random_engine gen(0xC0FFEE);
+    std::uniform_int_distribution<int64_t> delayDist(1000000, 10000000);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        // not started, so that nothing is delivered
+        sp<ALooper> looper = new ALooper;
+        sp<CountingHandler> handler = new CountingHandler;
+        looper->registerHandler(handler);
+        state.ResumeTiming();
+
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            (new AMessage(kWhatCount, handler))->post(delayDist(gen));
+        }
+
+        state.PauseTiming();
+        looper->unregisterHandler(handler->id());
+        looper.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ALooper_PostDeliver)->Arg(1)->Arg(64);
+BENCHMARK(BM_ALooper_PostAndAwaitResponse);
+BENCHMARK(BM_ALooper_PostDelayed)->Arg(64)->Arg(1024)->Arg(8192);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ALooper_test"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+namespace android {
+
+namespace {
+
+struct RecordingHandler : public AHandler {
+    // waits until count messages were received, and returns their "what" in delivery order
+    std::vector<uint32_t> waitForMessages(size_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait_for(lock, std::chrono::seconds(5),
+                [&] { return mReceived.size() >= count; });
+        return mReceived;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mReceived.push_back(msg->what());
+        mCondition.notify_all();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<uint32_t> mReceived;
+};
+
+}  // namespace
+
+TEST(ALooper_tests, delivers_in_time_order) {
+    sp<ALooper> looper = new ALooper;
+    sp<RecordingHandler> handler = new RecordingHandler;
+    looper->registerHandler(handler);
+
+    // queue everything before the looper starts
+    (new AMessage(1, handler))->post(30000);
+    (new AMessage(2, handler))->post(10000);
+    (new AMessage(3, handler))->post(20000);
+    (new AMessage(4, handler))->post(10000);
+    for (uint32_t what = 5; what <= 7; ++what) {
+        (new AMessage(what, handler))->post();
+    }
+
+    ASSERT_EQ(OK, looper->start());
+    std::vector<uint32_t> expected = {5, 6, 7, 2, 4, 3, 1};
+    EXPECT_EQ(expected, handler->waitForMessages(expected.size()));
+
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+TEST(ALooper_tests, recycles_messages) {
+    sp<AMessage> msg = new AMessage;
+    AMessage *storage = msg.get();
+    msg->setInt32("value", 1);
+    msg.clear();
+
+    // the storage is reused, but none of the previous contents
+    msg = new AMessage;
+    EXPECT_EQ(storage, msg.get());
+    EXPECT_EQ(0u, msg->countEntries());
+    EXPECT_EQ(0u, msg->what());
+}
+
+}  // namespace android
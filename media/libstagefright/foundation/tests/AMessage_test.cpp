@@ -17,6 +17,8 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AData_test"
 
+#include <string>
+
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
@@ -123,3 +125,57 @@ TEST(AMessage_tests, item_manipulation) {
 
 }
 
+TEST(AMessage_tests, many_items) {
+  // large enough for the name index
+  const size_t kNumItems = 48;
+  sp<AMessage> m1 = new AMessage();
+  for (size_t i = 0; i < kNumItems; ++i) {
+    m1->setInt32(("key-" + std::to_string(i)).c_str(), static_cast<int32_t>(i));
+  }
+  EXPECT_EQ(kNumItems, m1->countEntries());
+
+  int32_t i32;
+  for (size_t i = 0; i < kNumItems; ++i) {
+    EXPECT_TRUE(m1->findInt32(("key-" + std::to_string(i)).c_str(), &i32));
+    EXPECT_EQ(static_cast<int32_t>(i), i32);
+  }
+  EXPECT_FALSE(m1->findInt32("key-", &i32));
+  EXPECT_FALSE(m1->findInt32("key-48", &i32));
+
+  // overwriting keeps a single entry
+  m1->setInt32("key-7", 70);
+  EXPECT_EQ(kNumItems, m1->countEntries());
+  EXPECT_TRUE(m1->findInt32("key-7", &i32));
+  EXPECT_EQ(70, i32);
+
+  // removal moves the last entry, which must still be found
+  EXPECT_EQ(OK, m1->removeEntryByName("key-3"));
+  EXPECT_FALSE(m1->findInt32("key-3", &i32));
+  EXPECT_TRUE(m1->findInt32("key-47", &i32));
+  EXPECT_EQ(47, i32);
+
+  size_t index = m1->findEntryByName("key-5");
+  EXPECT_EQ(ALREADY_EXISTS, m1->setEntryNameAt(index, "key-6"));
+  EXPECT_EQ(OK, m1->setEntryNameAt(index, "renamed"));
+  EXPECT_FALSE(m1->findInt32("key-5", &i32));
+  EXPECT_TRUE(m1->findInt32("renamed", &i32));
+  EXPECT_EQ(5, i32);
+
+  // copies share the names, but not the values
+  sp<AMessage> m2 = m1->dup();
+  m1->setInt32("renamed", 50);
+  m1->clear();
+  EXPECT_TRUE(m2->findInt32("renamed", &i32));
+  EXPECT_EQ(5, i32);
+  EXPECT_TRUE(m2->findInt32("key-47", &i32));
+  EXPECT_EQ(47, i32);
+  EXPECT_EQ(kNumItems - 1, m2->countEntries());
+
+  // shrinking back to a small message
+  while (m2->countEntries() > 2) {
+    EXPECT_EQ(OK, m2->removeEntryAt(0));
+  }
+  AMessage::Type type;
+  const char *name = m2->getEntryNameAt(1, &type);
+  EXPECT_EQ(1u, m2->findEntryByName(name));
+}
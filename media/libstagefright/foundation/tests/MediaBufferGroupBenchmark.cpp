@@ -0,0 +1,50 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/MediaBufferGroup.h>
+
+using namespace android;
+
+// Enough buffers for every thread, as with a source and its reader
+static void BM_AcquireRelease(benchmark::State& state) {
+    static MediaBufferGroup *group = new MediaBufferGroup(8, 1024);
+    for (auto _ : state) {
+        MediaBufferBase *buffer;
+        group->acquire_buffer(&buffer);
+        benchmark::DoNotOptimize(buffer->data());
+        buffer->release();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Fewer buffers than threads, so that acquire_buffer() blocks
+static void BM_AcquireReleaseExhausted(benchmark::State& state) {
+    static MediaBufferGroup *group = new MediaBufferGroup(2, 1024);
+    for (auto _ : state) {
+        MediaBufferBase *buffer;
+        group->acquire_buffer(&buffer);
+        benchmark::DoNotOptimize(buffer->data());
+        buffer->release();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AcquireRelease)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_AcquireReleaseExhausted)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MediaBufferGroup_test"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include <media/stagefright/MediaBufferGroup.h>
+
+namespace android {
+
+TEST(MediaBufferGroup_tests, reuses_returned_buffers) {
+    MediaBufferGroup group(2, 1024);
+    MediaBufferBase *a;
+    MediaBufferBase *b;
+    MediaBufferBase *c;
+    ASSERT_EQ(OK, group.acquire_buffer(&a));
+    ASSERT_EQ(OK, group.acquire_buffer(&b));
+    EXPECT_NE(a, b);
+    EXPECT_EQ(1, a->refcount());
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&c, true /* nonBlocking */));
+    EXPECT_EQ(nullptr, c);
+
+    a->set_range(10, 10);
+    a->release();
+    ASSERT_EQ(OK, group.acquire_buffer(&c, true /* nonBlocking */));
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(0u, c->range_offset());
+    EXPECT_EQ(1024u, c->range_length());
+
+    b->release();
+    c->release();
+    EXPECT_EQ(2u, group.buffers());
+    EXPECT_EQ(0u, group.growCount());
+    EXPECT_EQ(0u, group.waitCount());
+}
+
+TEST(MediaBufferGroup_tests, grows_for_larger_requests) {
+    MediaBufferGroup group(1, 1024, 2);
+    MediaBufferBase *buffer;
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, false, 512));
+    EXPECT_EQ(1024u, buffer->size());
+    buffer->release();
+
+    // the returned buffer is too small, and is replaced
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, false, 2048));
+    EXPECT_LE(2048u, buffer->size());
+    EXPECT_EQ(1u, group.buffers());
+    EXPECT_EQ(1u, group.growCount());
+
+    // the buffer in use is kept, and a new one added
+    MediaBufferBase *other;
+    ASSERT_EQ(OK, group.acquire_buffer(&other, false, 4096));
+    EXPECT_NE(buffer, other);
+    EXPECT_EQ(2u, group.buffers());
+    EXPECT_EQ(2u, group.growCount());
+    buffer->release();
+    other->release();
+}
+
+TEST(MediaBufferGroup_tests, blocks_until_buffer_returned) {
+    MediaBufferGroup group(1, 1024);
+    MediaBufferBase *buffer;
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer));
+
+    MediaBufferBase *blocked = nullptr;
+    std::thread thread([&group, &blocked] {
+        ASSERT_EQ(OK, group.acquire_buffer(&blocked));
+    });
+    while (group.waitCount() == 0) {
+        std::this_thread::yield();
+    }
+    buffer->release();
+    thread.join();
+
+    EXPECT_EQ(buffer, blocked);
+    EXPECT_EQ(1u, group.waitCount());
+    blocked->release();
+}
+
+TEST(MediaBufferGroup_tests, hands_out_each_buffer_once) {
+    static const size_t kThreads = 4;
+    static const size_t kIterations = 10000;
+    MediaBufferGroup group(kThreads / 2, 1024);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&group, i] {
+            for (size_t j = 0; j < kIterations; ++j) {
+                MediaBufferBase *buffer;
+                ASSERT_EQ(OK, group.acquire_buffer(&buffer));
+                uint8_t *data = (uint8_t *)buffer->data();
+                memset(data, i, 16);
+                std::this_thread::yield();
+                for (size_t k = 0; k < 16; ++k) {
+                    ASSERT_EQ(i, data[k]);
+                }
+                buffer->release();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(kThreads / 2, group.buffers());
+    EXPECT_EQ(0u, group.growCount());
+}
+
+} // namespace android
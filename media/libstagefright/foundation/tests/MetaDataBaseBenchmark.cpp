@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/MetaDataBase.h>
+
+using namespace android;
+
+namespace {
+
+const uint8_t kKey[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+const uint8_t kIV[16] = {16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+const size_t kPlainSizes[4] = {10, 20, 30, 40};
+const size_t kEncryptedSizes[4] = {1000, 2000, 3000, 4000};
+
+// What an extractor attaches to each encrypted sample
+void setSampleMeta(MetaDataBase *meta, int64_t timeUs) {
+    meta->setInt64(kKeyTime, timeUs);
+    meta->setInt64(kKeyDuration, 33333);
+    meta->setInt32(kKeyIsSyncFrame, 1);
+    meta->setData(kKeyCryptoKey, 0, kKey, sizeof(kKey));
+    meta->setData(kKeyCryptoIV, 0, kIV, sizeof(kIV));
+    meta->setData(kKeyPlainSizes, 0, kPlainSizes, sizeof(kPlainSizes));
+    meta->setData(kKeyEncryptedSizes, 0, kEncryptedSizes, sizeof(kEncryptedSizes));
+}
+
+}  // namespace
+
+// A buffer's metadata cleared and refilled for each sample
+static void BM_MetaDataBase_RefillSample(benchmark::State& state) {
+    MetaDataBase meta;
+    int64_t timeUs = 0;
+    for (auto _ : state) {
+        meta.clear();
+        setSampleMeta(&meta, timeUs);
+        timeUs += 33333;
+    }
+}
+
+// Sample metadata copied on its way to the decoder, then read
+static void BM_MetaDataBase_CopyAndFind(benchmark::State& state) {
+    MetaDataBase meta;
+    setSampleMeta(&meta, 0);
+    for (auto _ : state) {
+        MetaDataBase copy(meta);
+        int64_t timeUs;
+        uint32_t type;
+        const void *data;
+        size_t size;
+        copy.findInt64(kKeyTime, &timeUs);
+        copy.findData(kKeyCryptoIV, &type, &data, &size);
+        benchmark::DoNotOptimize(data);
+    }
+}
+
+// A copy modified after the fact, e.g. to adjust the sample time
+static void BM_MetaDataBase_CopyAndModify(benchmark::State& state) {
+    MetaDataBase meta;
+    setSampleMeta(&meta, 0);
+    for (auto _ : state) {
+        MetaDataBase copy(meta);
+        copy.setInt64(kKeyTime, 1000);
+        copy.setData(kKeyCryptoIV, 0, kKey, sizeof(kKey));
+        benchmark::DoNotOptimize(&copy);
+    }
+}
+
+BENCHMARK(BM_MetaDataBase_RefillSample);
+BENCHMARK(BM_MetaDataBase_CopyAndFind);
+BENCHMARK(BM_MetaDataBase_CopyAndModify);
+
+BENCHMARK_MAIN();
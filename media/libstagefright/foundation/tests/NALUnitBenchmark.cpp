@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/avc_utils.h>
+
+using namespace android;
+
+// An access unit of |nalCount| NAL units behind 4-byte startcodes, with the zero runs and
+// emulation prevention bytes of slice data in their payload.
+static std::vector<uint8_t> makeAccessUnit(size_t size, size_t nalCount) {
+    std::default_random_engine gen(0xC0FFEE);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    std::vector<uint8_t> data;
+    size_t nalSize = size / nalCount - 4;
+    for (size_t n = 0; n < nalCount; ++n) {
+        data.insert(data.end(), {0x00, 0x00, 0x00, 0x01});
+        for (size_t i = 0; i < nalSize; ++i) {
+            if (i % 64 == 63) {
+                data.insert(data.end(), {0x00, 0x00, 0x03});
+                i += 2;
+            } else {
+                int value = byteDist(gen);
+                data.push_back(value < 2 ? 0x80 : value);
+            }
+        }
+    }
+    return data;
+}
+
+static size_t findStartCodeBytewise(const uint8_t *data, size_t size) {
+    size_t offset = 0;
+    for (; offset + 2 < size; ++offset) {
+        if (data[offset + 2] == 0x01 && data[offset] == 0x00 && data[offset + 1] == 0x00) {
+            return offset;
+        }
+    }
+    return size;
+}
+
+template<size_t (*Find)(const uint8_t *, size_t)>
+static void BM_FindStartCodes(benchmark::State& state) {
+    std::vector<uint8_t> data = makeAccessUnit(state.range(0), 4);
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < data.size(); offset += 3) {
+            offset += Find(&data[offset], data.size() - offset);
+            benchmark::DoNotOptimize(offset);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_GetNextNALUnit(benchmark::State& state) {
+    std::vector<uint8_t> data = makeAccessUnit(state.range(0), 4);
+    for (auto _ : state) {
+        const uint8_t *ptr = data.data();
+        size_t size = data.size();
+        const uint8_t *nalStart;
+        size_t nalSize;
+        while (getNextNALUnit(&ptr, &size, &nalStart, &nalSize, true) == OK) {
+            benchmark::DoNotOptimize(nalStart);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// Annex-B to length prefixed and back, as done when muxing and extracting
+static void BM_ConvertInPlace(benchmark::State& state) {
+    std::vector<uint8_t> data = makeAccessUnit(state.range(0), 4);
+    for (auto _ : state) {
+        size_t leadingSize;
+        AnnexBToLengthPrefixedInPlace(data.data(), data.size(), &leadingSize);
+        LengthPrefixedToAnnexBInPlace(data.data(), data.size());
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// From small P-frames up to large I-frames
+BENCHMARK_TEMPLATE(BM_FindStartCodes, findStartCodeBytewise)->Arg(4 << 10)->Arg(256 << 10);
+BENCHMARK_TEMPLATE(BM_FindStartCodes, FindNALStartCode)->Arg(4 << 10)->Arg(256 << 10);
+BENCHMARK(BM_GetNextNALUnit)->Arg(4 << 10)->Arg(256 << 10);
+BENCHMARK(BM_ConvertInPlace)->Arg(4 << 10)->Arg(256 << 10);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "NALUnit_test"
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <media/stagefright/foundation/avc_utils.h>
+
+namespace android {
+
+static size_t findStartCodeBytewise(const uint8_t *data, size_t size) {
+    for (size_t offset = 0; offset + 2 < size; ++offset) {
+        if (data[offset] == 0x00 && data[offset + 1] == 0x00 && data[offset + 2] == 0x01) {
+            return offset;
+        }
+    }
+    return size;
+}
+
+TEST(NALUnit_tests, finds_start_codes_at_every_position) {
+    // mostly zeros and ones, so that partial startcodes show up everywhere
+    std::vector<uint8_t> data(200);
+    srand(1);
+    for (size_t i = 0; i < data.size(); ++i) {
+        int r = rand() % 8;
+        data[i] = r < 5 ? 0x00 : r < 7 ? 0x01 : 0x80;
+    }
+
+    for (size_t start = 0; start < 40; ++start) {
+        for (size_t size = 0; start + size <= data.size(); ++size) {
+            ASSERT_EQ(findStartCodeBytewise(&data[start], size),
+                      FindNALStartCode(&data[start], size))
+                    << "start " << start << " size " << size;
+        }
+    }
+
+    std::vector<uint8_t> noStartCode(100, 0x00);
+    EXPECT_EQ(noStartCode.size(), FindNALStartCode(noStartCode.data(), noStartCode.size()));
+    noStartCode.back() = 0x01;
+    EXPECT_EQ(noStartCode.size() - 3,
+              FindNALStartCode(noStartCode.data(), noStartCode.size()));
+}
+
+TEST(NALUnit_tests, splits_annex_b_stream) {
+    const std::vector<uint8_t> stream = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00,
+        0x00, 0x00, 0x01, 0x68, 0xCE,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x00, 0x03, 0x01, 0x20,
+    };
+    const uint8_t *data = stream.data();
+    size_t size = stream.size();
+    const uint8_t *nalStart;
+    size_t nalSize;
+
+    // trailing zeros belong to the next startcode
+    ASSERT_EQ(OK, getNextNALUnit(&data, &size, &nalStart, &nalSize, true));
+    EXPECT_EQ(&stream[4], nalStart);
+    EXPECT_EQ(2u, nalSize);
+    ASSERT_EQ(OK, getNextNALUnit(&data, &size, &nalStart, &nalSize, true));
+    EXPECT_EQ(&stream[10], nalStart);
+    EXPECT_EQ(2u, nalSize);
+    ASSERT_EQ(OK, getNextNALUnit(&data, &size, &nalStart, &nalSize, true));
+    EXPECT_EQ(&stream[17], nalStart);
+    EXPECT_EQ(8u, nalSize);
+    EXPECT_EQ(-EAGAIN, getNextNALUnit(&data, &size, &nalStart, &nalSize, true));
+
+    // without a following startcode, the last NAL unit is incomplete
+    data = stream.data();
+    size = stream.size();
+    ASSERT_EQ(OK, getNextNALUnit(&data, &size, &nalStart, &nalSize, false));
+    ASSERT_EQ(OK, getNextNALUnit(&data, &size, &nalStart, &nalSize, false));
+    EXPECT_EQ(-EAGAIN, getNextNALUnit(&data, &size, &nalStart, &nalSize, false));
+    EXPECT_EQ(&stream[14], data);
+}
+
+TEST(NALUnit_tests, converts_in_place) {
+    const std::vector<uint8_t> annexB = {
+        0x09, 0xF0,
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42,
+        0x00, 0x00, 0x00, 0x01, 0x68,
+        0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84,
+    };
+    const std::vector<uint8_t> lengthPrefixed = {
+        0x09, 0xF0,
+        0x00, 0x00, 0x00, 0x02, 0x67, 0x42,
+        0x00, 0x00, 0x00, 0x01, 0x68,
+        0x00, 0x00, 0x00, 0x03, 0x65, 0x88, 0x84,
+    };
+
+    std::vector<uint8_t> data = annexB;
+    size_t leadingSize;
+    ASSERT_TRUE(AnnexBToLengthPrefixedInPlace(data.data(), data.size(), &leadingSize));
+    EXPECT_EQ(2u, leadingSize);
+    EXPECT_EQ(lengthPrefixed, data);
+
+    // a 3-byte startcode does not fit a size, and the sizes already written are undone
+    std::vector<uint8_t> shortStartCode = annexB;
+    shortStartCode.erase(shortStartCode.begin() + 13);
+    data = shortStartCode;
+    EXPECT_FALSE(AnnexBToLengthPrefixedInPlace(data.data(), data.size(), &leadingSize));
+    EXPECT_EQ(shortStartCode, data);
+
+    data.assign(lengthPrefixed.begin() + 2, lengthPrefixed.end());
+    ASSERT_TRUE(LengthPrefixedToAnnexBInPlace(data.data(), data.size()));
+    EXPECT_EQ(std::vector<uint8_t>(annexB.begin() + 2, annexB.end()), data);
+
+    // sizes running past the end, or empty NAL units, are left alone
+    std::vector<uint8_t> truncated(lengthPrefixed.begin() + 2, lengthPrefixed.end() - 1);
+    data = truncated;
+    EXPECT_FALSE(LengthPrefixedToAnnexBInPlace(data.data(), data.size()));
+    EXPECT_EQ(truncated, data);
+    const std::vector<uint8_t> empty = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x65};
+    data = empty;
+    EXPECT_FALSE(LengthPrefixedToAnnexBInPlace(data.data(), data.size()));
+    EXPECT_EQ(empty, data);
+}
+
+TEST(NALUnit_tests, round_trips_random_streams) {
+    srand(2);
+    for (int round = 0; round < 50; ++round) {
+        std::vector<uint8_t> annexB;
+        size_t nalCount = 1 + rand() % 10;
+        for (size_t i = 0; i < nalCount; ++i) {
+            annexB.insert(annexB.end(), {0x00, 0x00, 0x00, 0x01});
+            size_t nalSize = 1 + rand() % 100;
+            for (size_t j = 0; j < nalSize; ++j) {
+                // no startcodes or emulation prevention in the payload
+                annexB.push_back(j % 3 == 2 ? 0x80 + rand() % 0x80 : rand() % 0x100);
+            }
+        }
+
+        std::vector<uint8_t> data = annexB;
+        size_t leadingSize;
+        ASSERT_TRUE(AnnexBToLengthPrefixedInPlace(data.data(), data.size(), &leadingSize));
+        EXPECT_EQ(0u, leadingSize);
+        ASSERT_TRUE(LengthPrefixedToAnnexBInPlace(data.data(), data.size()));
+        EXPECT_EQ(annexB, data);
+    }
+}
+
+} // namespace android
@@ -28,6 +28,7 @@
 #include <media/MediaHTTPService.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <openssl/aes.h>
 #include <openssl/md5.h>
 #include <utils/Mutex.h>
@@ -35,12 +36,53 @@
 
 namespace android {
 
+HTTPConnectionPool::HTTPConnectionPool(
+        const sp<MediaHTTPService> &httpService, size_t maxIdle) :
+    mHTTPService(httpService),
+    mMaxIdle(maxIdle) {
+}
+
+sp<HTTPBase> HTTPConnectionPool::acquire() {
+    {
+        AutoMutex _l(mLock);
+        if (!mIdle.isEmpty()) {
+            sp<HTTPBase> connection = mIdle.top();
+            mIdle.pop();
+            return connection;
+        }
+    }
+    return new MediaHTTP(mHTTPService->makeHTTPConnection());
+}
+
+void HTTPConnectionPool::release(const sp<HTTPBase> &connection) {
+    // A connection whose service died can't be used again.
+    if (connection->initCheck() != OK) {
+        return;
+    }
+    AutoMutex _l(mLock);
+    if (mIdle.size() < mMaxIdle) {
+        mIdle.push(connection);
+    }
+}
+
 HTTPDownloader::HTTPDownloader(
         const sp<MediaHTTPService> &httpService,
-        const KeyedVector<String8, String8> &headers) :
-    mHTTPDataSource(new MediaHTTP(httpService->makeHTTPConnection())),
+        const KeyedVector<String8, String8> &headers,
+        const sp<HTTPConnectionPool> &pool) :
+    mPool(pool),
+    mHTTPDataSource(pool != NULL
+            ? pool->acquire() : sp<HTTPBase>(new MediaHTTP(httpService->makeHTTPConnection()))),
     mExtraHeaders(headers),
-    mDisconnecting(false) {
+    mDisconnecting(false),
+    mLastFetchTiming{0, 0, 0, 0} {
+}
+
+HTTPDownloader::~HTTPDownloader() {
+    mDataSource.clear();
+    if (mPool != NULL) {
+        mHTTPDataSource->disconnect();
+        mPool->release(mHTTPDataSource);
+    }
 }
 
 void HTTPDownloader::reconnect() {
@@ -88,6 +130,7 @@ ssize_t HTTPDownloader::fetchBlock(
     }
 
     off64_t size;
+    int64_t startUs = ALooper::GetNowUs();
 
     if (reconnect) {
         if (!strncasecmp(url, "file://", 7)) {
@@ -123,7 +166,10 @@ ssize_t HTTPDownloader::fetchBlock(
         }
     }
 
+    // On a new connection, the response headers are received by the time the size is known.
     status_t getSizeErr = mDataSource->getSize(&size);
+    int64_t responseUs = reconnect ? ALooper::GetNowUs() - startUs : 0;
+    int64_t firstByteUs = -1;
 
     if (isDisconnecting()) {
         return ERROR_NOT_CONNECTED;
@@ -202,10 +248,22 @@ ssize_t HTTPDownloader::fetchBlock(
             break;
         }
 
+        if (firstByteUs < 0) {
+            firstByteUs = ALooper::GetNowUs() - startUs;
+        }
         buffer->setRange(0, buffer->size() + (size_t)n);
         bytesRead += n;
     }
 
+    {
+        AutoMutex _l(mLock);
+        mLastFetchTiming.mResponseUs = responseUs;
+        mLastFetchTiming.mTotalUs = ALooper::GetNowUs() - startUs;
+        mLastFetchTiming.mFirstByteUs =
+                firstByteUs < 0 ? mLastFetchTiming.mTotalUs : firstByteUs;
+        mLastFetchTiming.mBytes = bytesRead;
+    }
+
     *out = buffer;
     if (actualUrl != NULL) {
         *actualUrl = mDataSource->getUri();
@@ -217,6 +275,11 @@ ssize_t HTTPDownloader::fetchBlock(
     return bytesRead;
 }
 
+HTTPDownloader::FetchTiming HTTPDownloader::getLastFetchTiming() {
+    AutoMutex _l(mLock);
+    return mLastFetchTiming;
+}
+
 ssize_t HTTPDownloader::fetchFile(
         const char *url, sp<ABuffer> *out, String8 *actualUrl) {
     ssize_t err = fetchBlock(url, out, 0, -1, 0, actualUrl, true /* reconnect */);
@@ -228,7 +291,8 @@ ssize_t HTTPDownloader::fetchFile(
 }
 
 sp<M3UParser> HTTPDownloader::fetchPlaylist(
-        const char *url, uint8_t *curPlaylistHash, bool *unchanged) {
+        const char *url, uint8_t *curPlaylistHash, bool *unchanged,
+        const sp<M3UParser> &previous) {
     ALOGV("fetchPlaylist '%s'", url);
 
     *unchanged = false;
@@ -265,7 +329,7 @@ sp<M3UParser> HTTPDownloader::fetchPlaylist(
 #endif
 
     sp<M3UParser> playlist =
-        new M3UParser(actualUrl.string(), buffer->data(), buffer->size());
+        new M3UParser(actualUrl.string(), buffer->data(), buffer->size(), previous);
 
     if (playlist->initCheck() != OK) {
         ALOGE("failed to parse .m3u8 playlist");
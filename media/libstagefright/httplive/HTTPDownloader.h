@@ -22,6 +22,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
+#include <utils/Vector.h>
 
 namespace android {
 
@@ -31,10 +32,44 @@ struct HTTPBase;
 struct MediaHTTPService;
 struct M3UParser;
 
+// Idle HTTP connections shared by the downloaders of a session, so that a new
+// downloader (e.g. for a new fetcher after a variant switch) doesn't have to
+// create a connection through the media HTTP service, and the platform HTTP
+// stack gets to keep its connections to the server alive across downloaders.
+struct HTTPConnectionPool : public RefBase {
+    HTTPConnectionPool(const sp<MediaHTTPService> &httpService, size_t maxIdle);
+
+    // Returns an idle connection, or a new one if there is none.
+    sp<HTTPBase> acquire();
+
+    // Returns a disconnected connection to the pool, unless the pool is full.
+    void release(const sp<HTTPBase> &connection);
+
+private:
+    sp<MediaHTTPService> mHTTPService;
+    size_t mMaxIdle;
+
+    Mutex mLock;
+    Vector<sp<HTTPBase> > mIdle;
+
+    DISALLOW_EVIL_CONSTRUCTORS(HTTPConnectionPool);
+};
+
 struct HTTPDownloader : public RefBase {
+    // Where the time of a fetch went, for bandwidth estimation and logs.
+    // The DNS lookup, TCP and TLS handshakes are not seen separately by the media
+    // HTTP service, so they are part of mResponseUs on a new connection.
+    struct FetchTiming {
+        int64_t mResponseUs;    // until the response headers (0 if the source was reused)
+        int64_t mFirstByteUs;   // until the first byte of the body
+        int64_t mTotalUs;       // until the end of the fetch
+        size_t mBytes;          // body bytes fetched
+    };
+
     HTTPDownloader(
             const sp<MediaHTTPService> &httpService,
-            const KeyedVector<String8, String8> &headers);
+            const KeyedVector<String8, String8> &headers,
+            const sp<HTTPConnectionPool> &pool = NULL);
 
     void reconnect();
     void disconnect();
@@ -66,17 +101,26 @@ struct HTTPDownloader : public RefBase {
             sp<ABuffer> *out,
             String8 *actualUrl = NULL);
 
-    // fetch a playlist file
+    // fetch a playlist file, |previous| is the last version of it if any
     sp<M3UParser> fetchPlaylist(
-            const char *url, uint8_t *curPlaylistHash, bool *unchanged);
+            const char *url, uint8_t *curPlaylistHash, bool *unchanged,
+            const sp<M3UParser> &previous = NULL);
+
+    // Timing of the last successful fetchBlock().
+    FetchTiming getLastFetchTiming();
+
+protected:
+    virtual ~HTTPDownloader();
 
 private:
+    sp<HTTPConnectionPool> mPool;
     sp<HTTPBase> mHTTPDataSource;
     sp<DataSource> mDataSource;
     KeyedVector<String8, String8> mExtraHeaders;
 
     Mutex mLock;
     bool mDisconnecting;
+    FetchTiming mLastFetchTiming;
 
     DISALLOW_EVIL_CONSTRUCTORS(HTTPDownloader);
 };
@@ -53,6 +53,8 @@ const int64_t LiveSession::kResumeThresholdUs = 100000LL;
 //TODO: redefine this mark to a fair value
 // default buffer underflow mark
 static const int kUnderflowMarkMs = 1000;  // 1 second
+// Enough for the playlist and segment downloaders of the audio, video and subtitle fetchers
+static const size_t kMaxIdleHTTPConnections = 6;
 
 struct LiveSession::BandwidthEstimator : public RefBase {
     BandwidthEstimator();
@@ -279,6 +281,7 @@ LiveSession::LiveSession(
     : mNotify(notify),
       mFlags(flags),
       mHTTPService(httpService),
+      mHTTPConnectionPool(new HTTPConnectionPool(httpService, kMaxIdleHTTPConnections)),
       mBuffering(false),
       mInPreparationPhase(true),
       mPollBufferingGeneration(0),
@@ -302,6 +305,7 @@ LiveSession::LiveSession(
       mUpSwitchMark(kUpSwitchMarkUs),
       mDownSwitchMark(kDownSwitchMarkUs),
       mUpSwitchMargin(kUpSwitchMarginUs),
+      mMinBufferedDurationUs(-1LL),
       mFirstTimeUsValid(false),
       mFirstTimeUs(0),
       mLastSeekTimeUs(0),
@@ -492,7 +496,7 @@ status_t LiveSession::getStreamFormatMeta(StreamType stream, sp<MetaData> *meta)
 }
 
 sp<HTTPDownloader> LiveSession::getHTTPDownloader() {
-    return new HTTPDownloader(mHTTPService, mExtraHeaders);
+    return new HTTPDownloader(mHTTPService, mExtraHeaders, mHTTPConnectionPool);
 }
 
 void LiveSession::setBufferingSettings(
@@ -1380,12 +1384,23 @@ size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps) {
         // Pick the highest bandwidth stream that's not currently blacklisted
         // below or equal to estimated bandwidth.
 
+        // Be conservative (70%) to avoid overestimating and immediately
+        // switching down again. A buffer above the up switch mark can absorb
+        // an overestimate, so allow more of the bandwidth then, and less when
+        // the buffer is about to run low.
+        float safetyFactor = .7f;
+        if (mMinBufferedDurationUs >= 0) {
+            if (mMinBufferedDurationUs > mUpSwitchMark) {
+                safetyFactor = .85f;
+            } else if (mMinBufferedDurationUs < mDownSwitchMark) {
+                safetyFactor = .6f;
+            }
+        }
+
         index = mBandwidthItems.size() - 1;
         ssize_t lowestBandwidth = getLowestValidBandwidthIndex();
         while (index > lowestBandwidth) {
-            // be conservative (70%) to avoid overestimating and immediately
-            // switching down again.
-            size_t adjustedBandwidthBps = bandwidthBps * .7f;
+            size_t adjustedBandwidthBps = bandwidthBps * safetyFactor;
             const BandwidthItem &item = mBandwidthItems[index];
             if (item.mBandwidth <= adjustedBandwidthBps
                     && isBandwidthValid(item)) {
@@ -2169,6 +2184,7 @@ bool LiveSession::checkBuffering(
     size_t activeCount, underflowCount, readyCount, downCount, upCount;
     activeCount = underflowCount = readyCount = downCount = upCount =0;
     int32_t minBufferPercent = -1;
+    int64_t minBufferedDurationUs = -1;
     int64_t durationUs;
     if (getDuration(&durationUs) != OK) {
         durationUs = -1;
@@ -2215,6 +2231,9 @@ bool LiveSession::checkBuffering(
             ++readyCount;
         }
         if (!mPacketSources[i]->isFinished(0)) {
+            if (minBufferedDurationUs < 0 || bufferedDurationUs < minBufferedDurationUs) {
+                minBufferedDurationUs = bufferedDurationUs;
+            }
             if (bufferedDurationUs < kUnderflowMarkMs * 1000LL) {
                 ++underflowCount;
             }
@@ -2230,6 +2249,7 @@ bool LiveSession::checkBuffering(
     if (minBufferPercent >= 0) {
         notifyBufferingUpdate(minBufferPercent);
     }
+    mMinBufferedDurationUs = minBufferedDurationUs;
 
     if (activeCount > 0) {
         up        = (upCount == activeCount);
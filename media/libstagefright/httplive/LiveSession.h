@@ -38,6 +38,7 @@ struct LiveDataSource;
 struct M3UParser;
 struct PlaylistFetcher;
 struct HLSTime;
+struct HTTPConnectionPool;
 struct HTTPDownloader;
 
 struct LiveSession : public AHandler {
@@ -188,6 +189,8 @@ private:
     sp<AMessage> mNotify;
     uint32_t mFlags;
     sp<MediaHTTPService> mHTTPService;
+    // Shared by the downloaders of all fetchers, for playlists and segments alike
+    sp<HTTPConnectionPool> mHTTPConnectionPool;
 
     bool mBuffering;
     bool mInPreparationPhase;
@@ -241,6 +244,9 @@ private:
     int64_t mUpSwitchMark;
     int64_t mDownSwitchMark;
     int64_t mUpSwitchMargin;
+    // least buffered of the unfinished audio and video streams at the last
+    // buffering check, -1 if unknown
+    int64_t mMinBufferedDurationUs;
 
     sp<AReplyToken> mDisconnectReplyID;
     sp<AReplyToken> mSeekReplyID;
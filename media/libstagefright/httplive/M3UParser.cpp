@@ -263,7 +263,30 @@ M3UParser::M3UParser(
       mDiscontinuitySeq(0),
       mDiscontinuityCount(0),
       mSelectedIndex(-1) {
-    mInitCheck = parse(data, size);
+    mInitCheck = parse(data, size, NULL /* previous */);
+}
+
+M3UParser::M3UParser(
+        const char *baseURI, const void *data, size_t size,
+        const sp<M3UParser> &previous)
+    : mInitCheck(NO_INIT),
+      mBaseURI(baseURI),
+      mIsExtM3U(false),
+      mIsVariantPlaylist(false),
+      mIsComplete(false),
+      mIsEvent(false),
+      mFirstSeqNumber(-1),
+      mLastSeqNumber(-1),
+      mTargetDurationUs(-1LL),
+      mDiscontinuitySeq(0),
+      mDiscontinuityCount(0),
+      mSelectedIndex(-1) {
+    if (previous != NULL && (previous->mInitCheck != OK
+            || previous->mIsVariantPlaylist || previous->mBaseURI != mBaseURI)) {
+        mInitCheck = parse(data, size, NULL /* previous */);
+    } else {
+        mInitCheck = parse(data, size, previous);
+    }
 }
 
 M3UParser::~M3UParser() {
@@ -566,7 +589,24 @@ AString M3UParser::MediaGroup::Media::makeURL(const char *baseURL) const {
     return out;
 }
 
-status_t M3UParser::parse(const void *_data, size_t size) {
+// Returns the item of |previous| with the sequence number of the next item of
+// this playlist, or NULL if it has none.
+const M3UParser::Item *M3UParser::findPreviousItem(const sp<M3UParser> &previous) const {
+    if (mIsExtM3U == false || mIsVariantPlaylist) {
+        return NULL;
+    }
+    int32_t firstSeqNumber = 0;
+    if (mMeta != NULL) {
+        mMeta->findInt32("media-sequence", &firstSeqNumber);
+    }
+    int64_t index = (int64_t)firstSeqNumber + mItems.size() - previous->mFirstSeqNumber;
+    if (index < 0 || index >= (int64_t)previous->mItems.size()) {
+        return NULL;
+    }
+    return &previous->mItems.itemAt(index);
+}
+
+status_t M3UParser::parse(const void *_data, size_t size, const sp<M3UParser> &previous) {
     int32_t lineNo = 0;
 
     sp<AMessage> itemMeta;
@@ -574,6 +614,21 @@ status_t M3UParser::parse(const void *_data, size_t size) {
     const char *data = (const char *)_data;
     size_t offset = 0;
     uint64_t segmentRangeOffset = 0;
+
+    // While |prevItem| is set, the tags of the current segment are skipped and
+    // the item of |previous| is taken over once its URI line matches. On a
+    // mismatch the segment is parsed again from |segmentStart|.
+    const Item *prevItem = NULL;
+    size_t segmentStart = 0;
+    int32_t segmentLineNo = 0;
+    int32_t segmentDiscontinuityCount = 0;
+    uint64_t segmentStartRangeOffset = 0;
+    bool reparsing = false;
+    if (previous != NULL) {
+        // the live window only slides forward
+        mItems.setCapacity(previous->mItems.size() + 1);
+    }
+
     while (offset < size) {
         size_t offsetLF = offset;
         while (offsetLF < size && data[offsetLF] != '\n') {
@@ -598,6 +653,61 @@ status_t M3UParser::parse(const void *_data, size_t size) {
             mIsExtM3U = true;
         }
 
+        if (previous != NULL && !reparsing) {
+            prevItem = findPreviousItem(previous);
+        }
+
+        if (prevItem != NULL && line.startsWith("#")) {
+            // per-segment tags, already parsed into the item of |previous|
+            if (line.startsWith("#EXTINF")
+                    || line.startsWith("#EXT-X-KEY")
+                    || line.startsWith("#EXT-X-BYTERANGE")) {
+                offset = offsetLF + 1;
+                ++lineNo;
+                continue;
+            }
+            if (line.startsWith("#EXT-X-DISCONTINUITY")
+                    && !line.startsWith("#EXT-X-DISCONTINUITY-SEQUENCE")) {
+                ++mDiscontinuityCount;
+                offset = offsetLF + 1;
+                ++lineNo;
+                continue;
+            }
+        }
+
+        if (prevItem != NULL && !line.startsWith("#")) {
+            int32_t discontinuitySeq;
+            if (line == prevItem->mURI
+                    && prevItem->mMeta->findInt32("discontinuity-sequence", &discontinuitySeq)
+                    && (size_t)discontinuitySeq == mDiscontinuitySeq + mDiscontinuityCount) {
+                mItems.push(*prevItem);
+
+                int64_t rangeOffset, rangeLength;
+                if (prevItem->mMeta->findInt64("range-offset", &rangeOffset)
+                        && prevItem->mMeta->findInt64("range-length", &rangeLength)) {
+                    segmentRangeOffset = rangeOffset + rangeLength;
+                }
+
+                offset = offsetLF + 1;
+                ++lineNo;
+                segmentStart = offset;
+                segmentLineNo = lineNo;
+                segmentDiscontinuityCount = mDiscontinuityCount;
+                segmentStartRangeOffset = segmentRangeOffset;
+                continue;
+            }
+
+            // not the segment we had, parse its tags after all
+            ALOGV("segment %zu changed, parsing it again", mItems.size());
+            offset = segmentStart;
+            lineNo = segmentLineNo;
+            mDiscontinuityCount = segmentDiscontinuityCount;
+            segmentRangeOffset = segmentStartRangeOffset;
+            prevItem = NULL;
+            reparsing = true;
+            continue;
+        }
+
         if (mIsExtM3U) {
             status_t err = OK;
 
@@ -701,6 +811,12 @@ status_t M3UParser::parse(const void *_data, size_t size) {
             item->mMeta = itemMeta;
 
             itemMeta.clear();
+
+            segmentStart = offsetLF + 1;
+            segmentLineNo = lineNo + 1;
+            segmentDiscontinuityCount = mDiscontinuityCount;
+            segmentStartRangeOffset = segmentRangeOffset;
+            reparsing = false;
         }
 
         offset = offsetLF + 1;
@@ -29,6 +29,12 @@ namespace android {
 struct M3UParser : public RefBase {
     M3UParser(const char *baseURI, const void *data, size_t size);
 
+    // Parses a refresh of |previous|. Media segments that |previous| already
+    // holds under the same sequence number and URI are taken over from it
+    // instead of being parsed again.
+    M3UParser(const char *baseURI, const void *data, size_t size,
+              const sp<M3UParser> &previous);
+
     status_t initCheck() const;
 
     bool isExtM3U() const;
@@ -89,7 +95,8 @@ private:
     // Media groups keyed by group ID.
     KeyedVector<AString, sp<MediaGroup> > mMediaGroups;
 
-    status_t parse(const void *data, size_t size);
+    status_t parse(const void *data, size_t size, const sp<M3UParser> &previous);
+    const Item *findPreviousItem(const sp<M3UParser> &previous) const;
 
     static status_t parseMetaData(
             const AString &line, sp<AMessage> *meta, const char *key);
@@ -24,6 +24,7 @@
 #include "HTTPDownloader.h"
 #include "LiveSession.h"
 #include "M3UParser.h"
+#include "SegmentPrefetcher.h"
 #include <ID3.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/HlsSampleDecryptor.h>
@@ -41,9 +42,12 @@
 #include <media/stagefright/Utils.h>
 #include <media/stagefright/FoundationUtils.h>
 
+#include <cutils/properties.h>
 #include <ctype.h>
 #include <inttypes.h>
 
+#include <algorithm>
+
 #define FLOGV(fmt, ...) ALOGV("[fetcher-%d] " fmt, mFetcherID, ##__VA_ARGS__)
 #define FSLOGV(stream, fmt, ...) ALOGV("[fetcher-%d] [%s] " fmt, mFetcherID, \
          LiveSession::getNameForStream(stream), ##__VA_ARGS__)
@@ -55,6 +59,7 @@ const int64_t PlaylistFetcher::kMinBufferedDurationUs = 30000000LL;
 const int64_t PlaylistFetcher::kMaxMonitorDelayUs = 3000000LL;
 // LCM of 188 (size of a TS packet) & 1k works well
 const int32_t PlaylistFetcher::kDownloadBlockSize = 47 * 1024;
+const int32_t PlaylistFetcher::kMaxPrefetchSegments = 4;
 
 struct PlaylistFetcher::DownloadState : public RefBase {
     DownloadState();
@@ -177,15 +182,26 @@ PlaylistFetcher::PlaylistFetcher(
       mSampleAesKeyItemChanged(false),
       mThresholdRatio(-1.0f),
       mDownloadState(new DownloadState()),
-      mHasMetadata(false) {
+      mHasMetadata(false),
+      mPrefetchedDelayUs(0) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
 
+    int32_t numPrefetchSegments = property_get_int32("media.httplive.prefetch-segments", 0);
+    if (numPrefetchSegments > 0) {
+        mPrefetcher = new SegmentPrefetcher(
+                mSession->getHTTPDownloader(),
+                std::min(numPrefetchSegments, kMaxPrefetchSegments));
+    }
+
     memset(mKeyData, 0, sizeof(mKeyData));
     memset(mAESInitVec, 0, sizeof(mAESInitVec));
 }
 
 PlaylistFetcher::~PlaylistFetcher() {
+    if (mPrefetcher != NULL) {
+        mPrefetcher->stop();
+    }
 }
 
 int32_t PlaylistFetcher::getFetcherID() const {
@@ -809,6 +825,11 @@ void PlaylistFetcher::onStop(const sp<AMessage> &msg) {
     mPacketSources.clear();
     mStreamTypeMask = 0;
 
+    if (mPrefetcher != NULL) {
+        mPrefetcher->stop();
+    }
+    mPrefetchedSegment.clear();
+
     resetStoppingThreshold(true /* disconnect */);
 }
 
@@ -937,7 +958,7 @@ status_t PlaylistFetcher::refreshPlaylist() {
     if (delayUsToRefreshPlaylist() <= 0) {
         bool unchanged;
         sp<M3UParser> playlist = mHTTPDownloader->fetchPlaylist(
-                mURI.c_str(), mPlaylistHash, &unchanged);
+                mURI.c_str(), mPlaylistHash, &unchanged, mPlaylist);
 
         if (playlist == NULL) {
             if (unchanged) {
@@ -1364,15 +1385,34 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    if (connectHTTP && mPrefetcher != NULL) {
+        mPrefetchedSegment = mPrefetcher->take(
+                uri, range_offset, range_length, &mPrefetchedDelayUs);
+        queueSegmentPrefetches(firstSeqNumberInPlaylist, lastSeqNumberInPlaylist);
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     do {
-        int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
-        int64_t delayUs = ALooper::GetNowUs() - startUs;
+        int64_t delayUs;
+        if (mPrefetchedSegment != NULL) {
+            // A prefetched segment is handed over as a single block.
+            if (buffer != mPrefetchedSegment) {
+                buffer = mPrefetchedSegment;
+                bytesRead = buffer->size();
+                delayUs = mPrefetchedDelayUs;
+            } else {
+                bytesRead = 0;
+                delayUs = 0;
+            }
+        } else {
+            int64_t startUs = ALooper::GetNowUs();
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+            delayUs = ALooper::GetNowUs() - startUs;
+        }
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
             return;
@@ -1393,8 +1433,17 @@ void PlaylistFetcher::onDownloadNext() {
                         | LiveSession::STREAMTYPE_VIDEO))) {
             mSession->addBandwidthMeasurement(bytesRead, delayUs);
             if (delayUs > 2000000LL) {
-                FLOGV("bytesRead %zd took %.2f seconds - abnormal bandwidth dip",
-                        bytesRead, (double)delayUs / 1.0e6);
+                if (mPrefetchedSegment == NULL) {
+                    HTTPDownloader::FetchTiming timing = mHTTPDownloader->getLastFetchTiming();
+                    FLOGV("bytesRead %zd took %.2f seconds - abnormal bandwidth dip"
+                            " (response %.2f, first byte %.2f seconds)",
+                            bytesRead, (double)delayUs / 1.0e6,
+                            (double)timing.mResponseUs / 1.0e6,
+                            (double)timing.mFirstByteUs / 1.0e6);
+                } else {
+                    FLOGV("bytesRead %zd took %.2f seconds - abnormal bandwidth dip",
+                            bytesRead, (double)delayUs / 1.0e6);
+                }
             }
         }
 
@@ -1475,6 +1524,7 @@ void PlaylistFetcher::onDownloadNext() {
             shouldPause = true;
         }
     } while (bytesRead != 0);
+    mPrefetchedSegment.clear();
 
     if (bufferStartsWithTsSyncByte(buffer)) {
         // If we don't see a stream in the program table after fetching a full ts segment
@@ -1555,6 +1605,29 @@ void PlaylistFetcher::onDownloadNext() {
     }
 }
 
+void PlaylistFetcher::queueSegmentPrefetches(
+        int32_t firstSeqNumberInPlaylist, int32_t lastSeqNumberInPlaylist) {
+    // The prefetcher keeps no more than its limit queued, so this tops it up
+    // with the segments that follow the one about to be fetched.
+    for (int32_t seqNumber = mSeqNumber + 1;
+            seqNumber <= lastSeqNumberInPlaylist
+                    && seqNumber <= mSeqNumber + kMaxPrefetchSegments;
+            ++seqNumber) {
+        AString uri;
+        sp<AMessage> itemMeta;
+        if (!mPlaylist->itemAt(seqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+            break;
+        }
+        int64_t rangeOffset, rangeLength;
+        if (!itemMeta->findInt64("range-offset", &rangeOffset)
+                || !itemMeta->findInt64("range-length", &rangeLength)) {
+            rangeOffset = 0;
+            rangeLength = -1;
+        }
+        mPrefetcher->queue(uri, rangeOffset, rangeLength);
+    }
+}
+
 /*
  * returns true if we need to adjust mSeqNumber
  */
@@ -1741,14 +1814,9 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
     }
 
     size_t offset = 0;
-    while (offset + 188 <= buffer->size()) {
-        status_t err = mTSParser->feedTSPacket(buffer->data() + offset, 188);
-
-        if (err != OK) {
-            return err;
-        }
-
-        offset += 188;
+    status_t err = mTSParser->feedTSPackets(buffer->data(), buffer->size(), &offset);
+    if (err != OK) {
+        return err;
     }
     // setRange to indicate consumed bytes.
     buffer->setRange(buffer->offset() + offset, buffer->size() - offset);
@@ -1810,7 +1878,7 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         }
     }
 
-    status_t err = OK;
+    err = OK;
     for (size_t i = mPacketSources.size(); i > 0;) {
         i--;
         sp<AnotherPacketSource> packetSource = mPacketSources.valueAt(i);
@@ -32,11 +32,14 @@ class DataSource;
 struct HTTPBase;
 struct LiveDataSource;
 struct M3UParser;
+struct SegmentPrefetcher;
 class String8;
 
 struct PlaylistFetcher : public AHandler {
     static const int64_t kMinBufferedDurationUs;
     static const int32_t kDownloadBlockSize;
+    // upper limit of media.httplive.prefetch-segments
+    static const int32_t kMaxPrefetchSegments;
     static const int64_t kFetcherResumeThreshold;
 
     enum {
@@ -189,6 +192,13 @@ private:
 
     bool mHasMetadata;
 
+    // Set when media.httplive.prefetch-segments is, to download the next
+    // segments over a second connection while the current one is parsed.
+    sp<SegmentPrefetcher> mPrefetcher;
+    // prefetched copy of the segment being fetched, if any
+    sp<ABuffer> mPrefetchedSegment;
+    int64_t mPrefetchedDelayUs;
+
     // Set first to true if decrypting the first segment of a playlist segment. When
     // first is true, reset the initialization vector based on the available
     // information in the manifest; otherwise, use the initialization vector as
@@ -226,6 +236,8 @@ private:
     void initSeqNumberForLiveStream(
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
+    void queueSegmentPrefetches(
+            int32_t firstSeqNumberInPlaylist, int32_t lastSeqNumberInPlaylist);
     bool initDownloadState(
             AString &uri,
             sp<AMessage> &itemMeta,
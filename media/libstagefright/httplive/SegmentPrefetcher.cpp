@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SegmentPrefetcher"
+#include <utils/Log.h>
+
+#include "HTTPDownloader.h"
+#include "SegmentPrefetcher.h"
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ALooper.h>
+
+namespace android {
+
+SegmentPrefetcher::SegmentPrefetcher(
+        const sp<HTTPDownloader> &downloader, size_t maxSegments)
+    : mDownloader(downloader),
+      mMaxSegments(maxSegments),
+      mStopping(false),
+      mThread(&SegmentPrefetcher::run, this) {
+}
+
+SegmentPrefetcher::~SegmentPrefetcher() {
+    stop();
+}
+
+void SegmentPrefetcher::queue(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mStopping || mSegments.size() >= mMaxSegments
+            || find_l(uri, rangeOffset, rangeLength) != mSegments.end()) {
+        return;
+    }
+    ALOGV("queueing %s @%lld", uri.c_str(), (long long)rangeOffset);
+    mSegments.push_back({ uri, rangeOffset, rangeLength, false, false, nullptr, 0 });
+    mCondition.notify_all();
+}
+
+sp<ABuffer> SegmentPrefetcher::take(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength, int64_t *delayUs) {
+    std::unique_lock<std::mutex> lock(mLock);
+    std::list<Segment>::iterator it = find_l(uri, rangeOffset, rangeLength);
+    // a download in progress that is dropped is discarded when it completes
+    mSegments.erase(mSegments.begin(), it);
+    if (it == mSegments.end()) {
+        return nullptr;
+    }
+    mCondition.wait(lock, [this, it] { return mStopping || it->mDone; });
+    if (mStopping) {
+        return nullptr;
+    }
+    sp<ABuffer> buffer = it->mBuffer;
+    *delayUs = it->mDelayUs;
+    mSegments.erase(it);
+    mCondition.notify_all();
+    ALOGV("%s %s @%lld", buffer != nullptr ? "prefetched" : "failed to prefetch",
+            uri.c_str(), (long long)rangeOffset);
+    return buffer;
+}
+
+void SegmentPrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mStopping) {
+            return;
+        }
+        mStopping = true;
+        mSegments.clear();
+        mCondition.notify_all();
+    }
+    mDownloader->disconnect();
+    mThread.join();
+}
+
+std::list<SegmentPrefetcher::Segment>::iterator SegmentPrefetcher::find_l(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    std::list<Segment>::iterator it = mSegments.begin();
+    while (it != mSegments.end() && !(it->mUri == uri
+            && it->mRangeOffset == rangeOffset && it->mRangeLength == rangeLength)) {
+        ++it;
+    }
+    return it;
+}
+
+void SegmentPrefetcher::run() {
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        std::list<Segment>::iterator it;
+        mCondition.wait(lock, [this, &it] {
+            if (mStopping) {
+                return true;
+            }
+            for (it = mSegments.begin(); it != mSegments.end() && it->mStarted; ++it) {
+            }
+            return it != mSegments.end();
+        });
+        if (mStopping) {
+            return;
+        }
+        it->mStarted = true;
+        Segment segment = *it;
+        lock.unlock();
+
+        sp<ABuffer> buffer;
+        int64_t startUs = ALooper::GetNowUs();
+        ssize_t bytesRead = mDownloader->fetchBlock(
+                segment.mUri.c_str(), &buffer, segment.mRangeOffset, segment.mRangeLength,
+                0 /* block_size */, NULL /* actualUrl */, true /* reconnect */);
+        int64_t delayUs = ALooper::GetNowUs() - startUs;
+        ALOGW_IF(bytesRead < 0, "failed to prefetch %s: %zd", segment.mUri.c_str(), bytesRead);
+
+        lock.lock();
+        it = find_l(segment.mUri, segment.mRangeOffset, segment.mRangeLength);
+        if (it != mSegments.end() && it->mStarted) {
+            it->mDone = true;
+            it->mBuffer = bytesRead > 0 ? buffer : nullptr;
+            it->mDelayUs = delayUs;
+            mCondition.notify_all();
+        }
+    }
+}
+
+}  // namespace android
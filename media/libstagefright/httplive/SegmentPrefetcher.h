@@ -0,0 +1,88 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEGMENT_PREFETCHER_H_
+
+#define SEGMENT_PREFETCHER_H_
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+struct ABuffer;
+struct HTTPDownloader;
+
+// Downloads the segments a PlaylistFetcher is going to need next over a
+// connection of its own, so that they are ready by the time the fetcher gets
+// to them rather than each one waiting for the one before.
+struct SegmentPrefetcher : public RefBase {
+    SegmentPrefetcher(const sp<HTTPDownloader> &downloader, size_t maxSegments);
+
+    // Queues a segment for download after those already queued, unless it
+    // is queued already or the queue is full.
+    void queue(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+
+    // Returns the downloaded segment, waiting for it if it is being downloaded,
+    // with the time its download took in |*delayUs|. Returns NULL if it was not
+    // queued or failed. Segments queued before it are dropped, and all of them
+    // are if it was not queued.
+    sp<ABuffer> take(
+            const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+            int64_t *delayUs);
+
+    // Drops the queue and aborts the download in progress for good.
+    void stop();
+
+protected:
+    virtual ~SegmentPrefetcher();
+
+private:
+    struct Segment {
+        AString mUri;
+        int64_t mRangeOffset;
+        int64_t mRangeLength;
+        bool mStarted;
+        bool mDone;
+        sp<ABuffer> mBuffer;
+        int64_t mDelayUs;
+    };
+
+    sp<HTTPDownloader> mDownloader;
+    size_t mMaxSegments;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::list<Segment> mSegments;
+    bool mStopping;
+    std::thread mThread;
+
+    std::list<Segment>::iterator find_l(
+            const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+    void run();
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+}  // namespace android
+
+#endif  // SEGMENT_PREFETCHER_H_
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Parses the refreshes of a synthetic sliding window live playlist, from
+// scratch and incrementally, and reports the time per refresh of each.
+//
+// Usage: M3UParserBenchmark [<segments> [<refreshes>]]
+// Without arguments, a window of 1800 segments (2 hours of 4 second
+// segments) is refreshed 100 times.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <M3UParser.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kDefaultSegments = 1800;
+constexpr uint32_t kDefaultRefreshes = 100;
+constexpr char kBaseURI[] = "http://example.com/live/index.m3u8";
+
+// Returns the playlist with |segments| segments starting at |firstSeq|, with
+// a discontinuity every 100 segments.
+std::string makePlaylist(uint32_t firstSeq, uint32_t segments) {
+    std::string playlist =
+            "#EXTM3U\n"
+            "#EXT-X-VERSION:3\n"
+            "#EXT-X-TARGETDURATION:4\n"
+            "#EXT-X-MEDIA-SEQUENCE:" + std::to_string(firstSeq) + "\n"
+            "#EXT-X-DISCONTINUITY-SEQUENCE:" + std::to_string(firstSeq / 100) + "\n";
+    for (uint32_t seq = firstSeq; seq < firstSeq + segments; ++seq) {
+        if (seq % 100 == 0 && seq != firstSeq) {
+            playlist += "#EXT-X-DISCONTINUITY\n";
+        }
+        playlist += "#EXTINF:4.004,\nsegment_" + std::to_string(seq) + ".ts\n";
+    }
+    return playlist;
+}
+
+// Returns the microseconds per refresh, or a negative value on failure.
+double run(uint32_t segments, uint32_t refreshes, bool incremental) {
+    std::string data = makePlaylist(0, segments);
+    sp<M3UParser> playlist = new M3UParser(kBaseURI, data.data(), data.size());
+    if (playlist->initCheck() != OK) {
+        return -1;
+    }
+
+    std::chrono::duration<double, std::micro> total(0);
+    for (uint32_t n = 1; n <= refreshes; ++n) {
+        data = makePlaylist(n, segments);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sp<M3UParser> refreshed = incremental
+                ? new M3UParser(kBaseURI, data.data(), data.size(), playlist)
+                : new M3UParser(kBaseURI, data.data(), data.size());
+        total += std::chrono::steady_clock::now() - start;
+
+        int32_t firstSeq, lastSeq;
+        refreshed->getSeqNumberRange(&firstSeq, &lastSeq);
+        if (refreshed->initCheck() != OK
+                || firstSeq != (int32_t)n || lastSeq != (int32_t)(n + segments - 1)) {
+            return -1;
+        }
+        playlist = refreshed;
+    }
+    return total.count() / refreshes;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t segments = argc > 1 ? atoi(argv[1]) : kDefaultSegments;
+    uint32_t refreshes = argc > 2 ? atoi(argv[2]) : kDefaultRefreshes;
+    if (segments == 0 || refreshes == 0) {
+        fprintf(stderr, "Usage %s [<segments> [<refreshes>]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%u segments, %u refreshes\n", segments, refreshes);
+    for (bool incremental : { false, true }) {
+        double us = run(segments, refreshes, incremental);
+        if (us < 0) {
+            fprintf(stderr, "Failed to parse the playlist\n");
+            return EXIT_FAILURE;
+        }
+        printf("%-11s: %10.1f us per refresh\n", incremental ? "incremental" : "full", us);
+    }
+    return EXIT_SUCCESS;
+}
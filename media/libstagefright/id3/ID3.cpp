@@ -92,13 +92,14 @@ private:
 };
 
 
-ID3::ID3(DataSourceHelper *sourcehelper, bool ignoreV1, off64_t offset)
+ID3::ID3(DataSourceHelper *sourcehelper, bool ignoreV1, off64_t offset, bool lazy)
     : mIsValid(false),
       mData(NULL),
       mSize(0),
       mFirstFrameOffset(0),
       mVersion(ID3_UNKNOWN),
-      mRawSize(0) {
+      mRawSize(0),
+      mLazySource(lazy ? sourcehelper : NULL) {
     DataSourceUnwrapper source(sourcehelper);
     mIsValid = parseV2(&source, offset);
 
@@ -113,7 +114,8 @@ ID3::ID3(const uint8_t *data, size_t size, bool ignoreV1)
       mSize(0),
       mFirstFrameOffset(0),
       mVersion(ID3_UNKNOWN),
-      mRawSize(0) {
+      mRawSize(0),
+      mLazySource(NULL) {
     MemorySource *source = new (std::nothrow) MemorySource(data, size);
 
     if (source == NULL)
@@ -132,6 +134,14 @@ ID3::~ID3() {
         free(mData);
         mData = NULL;
     }
+    freeLazyFrames();
+}
+
+void ID3::freeLazyFrames() {
+    for (const LazyFrame &frame : mLazyFrames) {
+        free(frame.mData);
+    }
+    mLazyFrames.clear();
 }
 
 bool ID3::isValid() const {
@@ -217,6 +227,16 @@ struct id3_header {
         return false;
     }
 
+    // A tag with global unsynchronization has to be decoded as a whole.
+    if (mLazySource != NULL && !(header.flags & 0x80)) {
+        if (parseV2Lazy(source, offset + sizeof(header), header.version_major, header.flags,
+                size)) {
+            mRawSize = size + sizeof(header);
+            return true;
+        }
+        ALOGV("could not index the ID3 tag, reading all of it");
+    }
+
     mData = (uint8_t *)malloc(size);
 
     if (mData == NULL) {
@@ -388,26 +408,180 @@ struct id3_header {
     return true;
 }
 
-void ID3::removeUnsynchronization() {
+// Indexes the frames of a v2 tag of |size| bytes at |offset| in |source|, reading
+// only the frames that are smaller than kMinLazyFrameSize into mData. Returns
+// false, with nothing allocated, if the tag needs the full parse of parseV2().
+bool ID3::parseV2Lazy(
+        DataSourceBase *source, off64_t offset, uint8_t majorVersion, uint8_t flags,
+        size_t size) {
+    size_t frameOffset = 0;
+    size_t end = size;
+    uint8_t buf[10];
+
+    if (majorVersion == 3 && (flags & 0x40)) {
+        if (size < 4 || source->readAt(offset, buf, 4) != 4) {
+            return false;
+        }
+        // v2.3 does not have syncsafe integers
+        size_t extendedHeaderSize = U32_AT(buf);
+        if (extendedHeaderSize > size - 4) {
+            return false;
+        }
+        extendedHeaderSize += 4;
+        if (extendedHeaderSize >= 10) {
+            if (source->readAt(offset, buf, 10) != 10) {
+                return false;
+            }
+            size_t paddingSize = U32_AT(&buf[6]);
+            if (paddingSize > size - extendedHeaderSize) {
+                return false;
+            }
+            end -= paddingSize;
+        }
+        frameOffset = extendedHeaderSize;
+    } else if (majorVersion == 4 && (flags & 0x40)) {
+        size_t extendedHeaderSize;
+        if (size < 4 || source->readAt(offset, buf, 4) != 4
+                || !ParseSyncsafeInteger(buf, &extendedHeaderSize)
+                || extendedHeaderSize < 6 || extendedHeaderSize > size) {
+            return false;
+        }
+        frameOffset = extendedHeaderSize;
+    }
 
-    // This file has "unsynchronization", so we have to replace occurrences
-    // of 0xff 0x00 with just 0xff in order to get the real data.
+    // the frames to read now, as offset and size in the tag
+    std::vector<std::pair<size_t, size_t>> frames;
+    size_t total = 0;
+    const size_t headerSize = (majorVersion == 2) ? 6 : 10;
+    while (end - frameOffset >= headerSize) {
+        if (source->readAt(offset + frameOffset, buf, headerSize) != (ssize_t)headerSize) {
+            freeLazyFrames();
+            return false;
+        }
+        if (!memcmp(buf, "\0\0\0", 3)) {
+            break;  // padding
+        }
+
+        size_t dataSize;
+        uint16_t frameFlags = 0;
+        if (majorVersion == 2) {
+            dataSize = (buf[3] << 16) | (buf[4] << 8) | buf[5];
+        } else if (majorVersion == 3) {
+            dataSize = U32_AT(&buf[4]);
+            frameFlags = U16_AT(&buf[8]);
+        } else if (!ParseSyncsafeInteger(&buf[4], &dataSize)) {
+            // maybe written by iTunes, which parseV2() knows how to handle.
+            freeLazyFrames();
+            return false;
+        } else {
+            frameFlags = U16_AT(&buf[8]);
+        }
+
+        if (dataSize == 0) {
+            break;
+        }
+        if (dataSize > end - frameOffset - headerSize) {
+            freeLazyFrames();
+            return false;
+        }
+        size_t frameSize = headerSize + dataSize;
+
+        if ((majorVersion == 4 && (frameFlags & 0x000c))
+                || (majorVersion == 3 && (frameFlags & 0x00c0))) {
+            // compressed or encrypted frames are skipped by Iterator anyway.
+        } else if (dataSize >= kMinLazyFrameSize) {
+            LazyFrame frame;
+            size_t idLength = (majorVersion == 2) ? 3 : 4;
+            memcpy(frame.mID, buf, idLength);
+            frame.mID[idLength] = '\0';
+            frame.mOffset = offset + frameOffset;
+            frame.mSize = frameSize;
+            frame.mData = NULL;
+            frame.mDataSize = 0;
+            mLazyFrames.push_back(frame);
+        } else {
+            frames.push_back(std::make_pair(frameOffset, frameSize));
+            total += frameSize;
+        }
+        frameOffset += frameSize;
+    }
+
+    if (total > 0) {
+        mData = (uint8_t *)malloc(total);
+        if (mData == NULL) {
+            freeLazyFrames();
+            return false;
+        }
+    }
+
+    // frames that follow each other in the source are read together.
+    size_t writeOffset = 0;
+    for (size_t i = 0; i < frames.size();) {
+        size_t readOffset = frames[i].first;
+        size_t readSize = 0;
+        do {
+            readSize += frames[i].second;
+            ++i;
+        } while (i < frames.size() && frames[i].first == readOffset + readSize);
+
+        if (source->readAt(offset + readOffset, &mData[writeOffset], readSize)
+                != (ssize_t)readSize) {
+            free(mData);
+            mData = NULL;
+            freeLazyFrames();
+            return false;
+        }
+        writeOffset += readSize;
+    }
+
+    mSize = total;
+    mFirstFrameOffset = 0;
+
+    if (majorVersion == 4 && !removeUnsynchronizationV2_4(
+            false /* iTunesHack */, false /* hasGlobalUnsync */)) {
+        free(mData);
+        mData = NULL;
+        mSize = 0;
+        freeLazyFrames();
+        return false;
+    }
 
+    if (majorVersion == 2) {
+        mVersion = ID3_V2_2;
+    } else if (majorVersion == 3) {
+        mVersion = ID3_V2_3;
+    } else {
+        mVersion = ID3_V2_4;
+    }
+
+    ALOGV("indexed ID3 tag: %zu bytes read, %zu frames left in the source",
+            mSize, mLazyFrames.size());
+
+    return true;
+}
+
+// Replaces occurrences of 0xff 0x00 with just 0xff, returning the new size.
+static size_t RemoveUnsynchronization(uint8_t *data, size_t size) {
     size_t writeOffset = 1;
-    for (size_t readOffset = 1; readOffset < mSize; ++readOffset) {
-        if (mData[readOffset - 1] == 0xff && mData[readOffset] == 0x00) {
+    for (size_t readOffset = 1; readOffset < size; ++readOffset) {
+        if (data[readOffset - 1] == 0xff && data[readOffset] == 0x00) {
             continue;
         }
         // Only move data if there's actually something to move.
         // This handles the special case of the data being only [0xff, 0x00]
         // which should be converted to just 0xff if unsynchronization is on.
-        mData[writeOffset++] = mData[readOffset];
+        data[writeOffset++] = data[readOffset];
     }
 
-    if (writeOffset < mSize) {
-        mSize = writeOffset;
-    }
+    return writeOffset < size ? writeOffset : size;
+}
+
+void ID3::removeUnsynchronization() {
 
+    // This file has "unsynchronization", so we have to replace occurrences
+    // of 0xff 0x00 with just 0xff in order to get the real data.
+
+    mSize = RemoveUnsynchronization(mData, mSize);
 }
 
 static void WriteSyncsafeInteger(uint8_t *dst, size_t x) {
@@ -500,10 +674,57 @@ bool ID3::removeUnsynchronizationV2_4(bool iTunesHack, bool hasGlobalUnsync) {
     return true;
 }
 
+// Reads lazy frame |index| from the source and decodes it, the first time it is
+// requested. Returns the frame including its header, or NULL on error.
+const uint8_t *ID3::loadLazyFrame(size_t index, size_t *size) const {
+    const LazyFrame &frame = mLazyFrames[index];
+    if (frame.mData != NULL) {
+        *size = frame.mDataSize;
+        return frame.mData;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(frame.mSize);
+    if (data == NULL) {
+        return NULL;
+    }
+    if (mLazySource->readAt(frame.mOffset, data, frame.mSize) != (ssize_t)frame.mSize) {
+        ALOGW("failed to read ID3 frame %s at offset %lld",
+                frame.mID, (long long)frame.mOffset);
+        free(data);
+        return NULL;
+    }
+
+    size_t dataSize = frame.mSize;
+    if (mVersion == ID3_V2_4) {
+        uint16_t flags = U16_AT(&data[8]);
+        if (flags & 1) {
+            // Strip data length indicator
+            if (dataSize < 14) {
+                free(data);
+                return NULL;
+            }
+            memmove(&data[10], &data[14], dataSize - 14);
+            dataSize -= 4;
+        }
+        if (flags & 2) {
+            dataSize = 10 + RemoveUnsynchronization(&data[10], dataSize - 10);
+        }
+        WriteSyncsafeInteger(&data[4], dataSize - 10);
+        data[8] = (flags & ~3) >> 8;
+        data[9] = (flags & ~3) & 0xff;
+    }
+
+    frame.mData = data;
+    frame.mDataSize = dataSize;
+    *size = dataSize;
+    return data;
+}
+
 ID3::Iterator::Iterator(const ID3 &parent, const char *id)
     : mParent(parent),
       mID(NULL),
       mOffset(mParent.mFirstFrameOffset),
+      mLazyIndex(-1),
       mFrameData(NULL),
       mFrameSize(0) {
     if (id) {
@@ -529,7 +750,11 @@ void ID3::Iterator::next() {
         return;
     }
 
-    mOffset += mFrameSize;
+    if (mLazyIndex >= 0) {
+        ++mLazyIndex;
+    } else {
+        mOffset += mFrameSize;
+    }
 
     findFrame();
 }
@@ -542,9 +767,9 @@ void ID3::Iterator::getID(String8 *id) const {
     }
 
     if (mParent.mVersion == ID3_V2_2) {
-        id->setTo((const char *)&mParent.mData[mOffset], 3);
+        id->setTo((const char *)(mFrameData - getHeaderLength()), 3);
     } else if (mParent.mVersion == ID3_V2_3 || mParent.mVersion == ID3_V2_4) {
-        id->setTo((const char *)&mParent.mData[mOffset], 4);
+        id->setTo((const char *)(mFrameData - getHeaderLength()), 4);
     } else {
         CHECK(mParent.mVersion == ID3_V1 || mParent.mVersion == ID3_V1_1);
 
@@ -759,6 +984,38 @@ size_t ID3::Iterator::getHeaderLength() const {
 }
 
 void ID3::Iterator::findFrame() {
+    if (mLazyIndex < 0) {
+        findDataFrame();
+        if (mFrameData != NULL || mParent.mLazyFrames.empty()) {
+            return;
+        }
+        mLazyIndex = 0;
+    }
+
+    findLazyFrame();
+}
+
+void ID3::Iterator::findLazyFrame() {
+    mFrameData = NULL;
+    mFrameSize = 0;
+
+    for (; (size_t)mLazyIndex < mParent.mLazyFrames.size(); ++mLazyIndex) {
+        if (mID && strcmp(mParent.mLazyFrames[mLazyIndex].mID, mID)) {
+            continue;
+        }
+
+        size_t size;
+        const uint8_t *data = mParent.loadLazyFrame(mLazyIndex, &size);
+        if (data == NULL) {
+            continue;
+        }
+        mFrameData = data + getHeaderLength();
+        mFrameSize = size;
+        return;
+    }
+}
+
+void ID3::Iterator::findDataFrame() {
     for (;;) {
         mFrameData = NULL;
         mFrameSize = 0;
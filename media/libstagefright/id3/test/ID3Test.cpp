@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <ctype.h>
+#include <set>
 #include <string>
 #include <sys/stat.h>
 #include <datasource/FileSource.h>
@@ -39,6 +40,7 @@ class ID3versionTest : public ::testing::TestWithParam<pair<string, int>> {};
 class ID3textTagTest : public ::testing::TestWithParam<pair<string, int>> {};
 class ID3albumArtTest : public ::testing::TestWithParam<pair<string, bool>> {};
 class ID3multiAlbumArtTest : public ::testing::TestWithParam<pair<string, int>> {};
+class ID3lazyTest : public ::testing::TestWithParam<string> {};
 
 TEST_P(ID3tagTest, TagTest) {
     string path = gEnv->getRes() + GetParam();
@@ -181,6 +183,51 @@ TEST_P(ID3multiAlbumArtTest, MultiAlbumArtTest) {
                                   << " album arts! \n";
 }
 
+TEST_P(ID3lazyTest, LazyTest) {
+    string path = gEnv->getRes() + GetParam();
+    ALOGV(" =====   LazyTest for %s", path.c_str());
+    sp<android::FileSource> file = new FileSource(path.c_str());
+    ASSERT_EQ(file->initCheck(), (status_t)OK) << "File initialization failed! \n";
+
+    DataSourceHelper helper(file->wrap());
+    ID3 tag(&helper);
+    ID3 lazyTag(&helper, false /* ignoreV1 */, 0 /* offset */, true /* lazy */);
+    ASSERT_TRUE(tag.isValid()) << "No valid ID3 tag found for " << path.c_str() << "\n";
+    ASSERT_TRUE(lazyTag.isValid()) << "No valid lazy ID3 tag found for " << path.c_str() << "\n";
+    ASSERT_EQ(tag.version(), lazyTag.version());
+    ASSERT_EQ(tag.rawSize(), lazyTag.rawSize());
+
+    // the lazy tag has the same frames, though not necessarily in the same order.
+    multiset<string> frames;
+    multiset<string> lazyFrames;
+    for (ID3 *id3 : {&tag, &lazyTag}) {
+        ID3::Iterator it(*id3, nullptr);
+        while (!it.done()) {
+            String8 id;
+            it.getID(&id);
+            size_t size;
+            const uint8_t *data = it.getData(&size);
+            string frame = string(id.c_str()) + ":" + string((const char *)data, size);
+            (id3 == &tag ? frames : lazyFrames).insert(frame);
+            it.next();
+        }
+    }
+    ASSERT_EQ(frames, lazyFrames) << "Lazy parsing changed the frames of " << path;
+
+    size_t dataSize;
+    size_t lazyDataSize;
+    String8 mime;
+    String8 lazyMime;
+    const void *data = tag.getAlbumArt(&dataSize, &mime);
+    const void *lazyData = lazyTag.getAlbumArt(&lazyDataSize, &lazyMime);
+    ASSERT_EQ(data == nullptr, lazyData == nullptr);
+    if (data) {
+        ASSERT_EQ(dataSize, lazyDataSize);
+        ASSERT_EQ(memcmp(data, lazyData, dataSize), 0) << "Album art differs for " << path;
+        ASSERT_EQ(mime, lazyMime);
+    }
+}
+
 // we have a test asset with large album art -- which is larger than our 3M cap
 // that we inserted intentionally in the ID3 parsing routine.
 // Rather than have it fail all the time, we have wrapped it under an #ifdef
@@ -266,6 +313,17 @@ INSTANTIATE_TEST_SUITE_P(id3TestAll, ID3multiAlbumArtTest,
                                            make_pair("bbb_2sec_2_image.mp3", 2)
                                            ));
 
+INSTANTIATE_TEST_SUITE_P(id3TestAll, ID3lazyTest,
+                         ::testing::Values("bbb_1sec_v23.mp3",
+                                           "bbb_1sec_1_image.mp3",
+                                           "bbb_1sec_2_image.mp3",
+                                           "bbb_2sec_v24.mp3",
+                                           "bbb_2sec_1_image.mp3",
+                                           "bbb_2sec_2_image.mp3",
+                                           "bbb_1sec_v23_3tags.mp3",
+                                           "bbb_2sec_v24_unsynchronizedOneFrame.mp3",
+                                           "idv24_unsynchronized.mp3"));
+
 int main(int argc, char **argv) {
     gEnv = new ID3TestEnvironment();
     ::testing::AddGlobalTestEnvironment(gEnv);
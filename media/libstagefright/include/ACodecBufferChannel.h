@@ -42,13 +42,16 @@ public:
     struct BufferAndId {
         sp<MediaCodecBuffer> mBuffer;
         IOMX::buffer_id mBufferId;
+        // Shared memory backing mBuffer, if any; used to decrypt in place.
+        sp<HidlMemory> mMemory;
     };
 
     struct BufferInfo {
         BufferInfo(
                 const sp<MediaCodecBuffer> &buffer,
                 IOMX::buffer_id bufferId,
-                const sp<IMemory> &sharedEncryptedBuffer);
+                const sp<IMemory> &sharedEncryptedBuffer,
+                int32_t codecHeapSeqNum = -1);
 
         BufferInfo() = delete;
 
@@ -60,6 +63,9 @@ public:
         const IOMX::buffer_id mBufferId;
         // Encrypted buffer in case of secure input.
         const sp<IMemory> mSharedEncryptedBuffer;
+        // Heap registered with the crypto plugin for mCodecBuffer, or -1 if
+        // non-secure output has to be copied from mDecryptDestination.
+        const int32_t mCodecHeapSeqNum;
     };
 
     ACodecBufferChannel(
@@ -133,6 +139,10 @@ public:
 
 private:
     int32_t getHeapSeqNum(const sp<HidlMemory> &memory);
+    void setNonsecureDestination(
+            const BufferInfo &info, hardware::drm::V1_0::SharedBuffer *destination);
+    void copyDecryptedContent(const BufferInfo &info, ssize_t size);
+    void unsetCodecHeaps(const std::shared_ptr<const std::vector<const BufferInfo>> &array);
 
     const sp<AMessage> mInputBufferFilled;
     const sp<AMessage> mOutputBufferDrained;
@@ -143,6 +153,11 @@ private:
     std::map<wp<HidlMemory>, int32_t> mHeapSeqNumMap;
     sp<HidlMemory> mHidlMemory;
 
+    // Number of non-secure decrypts written directly into the codec buffer,
+    // and of those that went through mDecryptDestination and a copy.
+    int64_t mDecryptsInPlace;
+    int64_t mDecryptCopies;
+
     // These should only be accessed via std::atomic_* functions.
     //
     // Note on thread safety: since the vector and BufferInfo are const, it's
@@ -49,6 +49,11 @@ struct FrameDecoder : public RefBase {
 
     sp<IMemory> extractFrame(FrameRect *rect = NULL);
 
+    // Prepares the next extractFrame() to return the frame at frameTimeUs,
+    // reusing the codec started by init(). Requesting frames in increasing
+    // time order lets closest frame seeks decode forward instead of seeking.
+    status_t seekTo(int64_t frameTimeUs, int option);
+
     static sp<IMemory> getMetadataOnly(
             const sp<MetaData> &trackMeta, int colorFormat,
             bool thumbnail = false, uint32_t bitDepth = 0);
@@ -64,6 +69,20 @@ protected:
 
     virtual status_t onExtractRect(FrameRect *rect) = 0;
 
+    // Returns the number of codec instances to distribute samples over,
+    // round-robin. Only valid if every sample is decodable on its own.
+    virtual size_t onGetDecoderCount() { return 1; }
+
+    // Sets up options to seek the source to frameTimeUs, or sets *decodeForward
+    // if the frame is reached by decoding on from the last output, which is only
+    // possible when canDecodeForward is true.
+    virtual status_t onSeekTo(
+            int64_t frameTimeUs __unused,
+            int seekMode __unused,
+            MediaSource::ReadOptions *options __unused,
+            bool canDecodeForward __unused,
+            bool *decodeForward __unused) { return ERROR_UNSUPPORTED; }
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer,
             MetaDataBase &sampleMeta,
@@ -91,12 +110,16 @@ private:
     int32_t mDstBpp;
     sp<IMemory> mFrameMemory;
     MediaSource::ReadOptions mReadOptions;
-    sp<MediaCodec> mDecoder;
+    // samples are queued to, and outputs dequeued from, mDecoders in turn.
+    std::vector<sp<MediaCodec>> mDecoders;
+    size_t mInputCount;
+    size_t mOutputCount;
     sp<AMessage> mOutputFormat;
     bool mHaveMoreInputs;
     bool mFirstSample;
     sp<Surface> mSurface;
 
+    status_t startDecoder(const sp<AMessage> &videoFormat, sp<MediaCodec> *decoder);
     status_t extractInternal();
 
     DISALLOW_EVIL_CONSTRUCTORS(FrameDecoder);
@@ -121,6 +144,13 @@ protected:
         return (rect == NULL) ? OK : ERROR_UNSUPPORTED;
     }
 
+    virtual status_t onSeekTo(
+            int64_t frameTimeUs,
+            int seekMode,
+            MediaSource::ReadOptions *options,
+            bool canDecodeForward,
+            bool *decodeForward) override;
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer,
             MetaDataBase &sampleMeta,
@@ -140,6 +170,7 @@ private:
     bool mIsHevc;
     MediaSource::ReadOptions::SeekMode mSeekMode;
     int64_t mTargetTimeUs;
+    int64_t mLastOutputTimeUs;
     List<int64_t> mSampleDurations;
     int64_t mDefaultSampleDurationUs;
 
@@ -162,6 +193,8 @@ protected:
 
     virtual status_t onExtractRect(FrameRect *rect) override;
 
+    virtual size_t onGetDecoderCount() override;
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer __unused,
             MetaDataBase &sampleMeta __unused,
@@ -20,6 +20,8 @@
 
 #include <utils/RefBase.h>
 
+#include <vector>
+
 namespace android {
 
 class DataSourceBase;
@@ -36,7 +38,12 @@ struct ID3 {
         ID3_V2_4,
     };
 
-    explicit ID3(DataSourceHelper *source, bool ignoreV1 = false, off64_t offset = 0);
+    // With |lazy|, frames of at least kMinLazyFrameSize bytes (typically album
+    // art) are only indexed while parsing, and are read from |source| and
+    // decoded when an Iterator first stops on them. |source| must then outlive
+    // this object. Iterators visit the lazy frames after all other frames.
+    explicit ID3(DataSourceHelper *source, bool ignoreV1 = false, off64_t offset = 0,
+            bool lazy = false);
     ID3(const uint8_t *data, size_t size, bool ignoreV1 = false);
     ~ID3();
 
@@ -60,11 +67,15 @@ struct ID3 {
         const ID3 &mParent;
         char *mID;
         size_t mOffset;
+        // index of the current lazy frame, or -1 while in the parsed tag data
+        ssize_t mLazyIndex;
 
         const uint8_t *mFrameData;
         size_t mFrameSize;
 
         void findFrame();
+        void findDataFrame();
+        void findLazyFrame();
 
         size_t getHeaderLength() const;
         void getstring(String8 *s, bool secondhalf) const;
@@ -75,9 +86,22 @@ struct ID3 {
 
     size_t rawSize() const { return mRawSize; }
 
+    static const size_t kMinLazyFrameSize = 32 * 1024;
+
 private:
     class DataSourceUnwrapper;
     struct MemorySource;
+
+    // A frame that is left in the source until it is first requested.
+    struct LazyFrame {
+        char mID[5];
+        off64_t mOffset;    // of the frame header in the source
+        size_t mSize;       // of the frame, including its header
+        // the frame with its payload decoded, once loaded
+        mutable uint8_t *mData;
+        mutable size_t mDataSize;
+    };
+
     bool mIsValid;
     uint8_t *mData;
     size_t mSize;
@@ -88,8 +112,16 @@ private:
     // only valid for IDV2+
     size_t mRawSize;
 
+    DataSourceHelper *mLazySource;
+    std::vector<LazyFrame> mLazyFrames;
+
     bool parseV1(DataSourceBase *source);
     bool parseV2(DataSourceBase *source, off64_t offset);
+    bool parseV2Lazy(
+            DataSourceBase *source, off64_t offset, uint8_t majorVersion, uint8_t flags,
+            size_t size);
+    const uint8_t *loadLazyFrame(size_t index, size_t *size) const;
+    void freeLazyFrames();
     void removeUnsynchronization();
     bool removeUnsynchronizationV2_4(bool iTunesHack, bool hasGlobalUnsync);
 
@@ -216,6 +216,8 @@ virtual status_t setupAudioCodec(
         sp<MediaCodecBuffer> mData;  // the client's buffer; if not using data conversion, this is
                                      // the codec buffer; otherwise, it is allocated separately
         sp<RefBase> mMemRef;         // and a reference to the IMemory, so it does not go away
+        sp<hardware::HidlMemory> mHidlMemRef;  // the shared memory of mData, for in-place
+                                               // decryption of non-secure input
         sp<MediaCodecBuffer> mCodecData;  // the codec's buffer
         sp<RefBase> mCodecRef;            // and a reference to the IMemory
 
@@ -104,6 +104,9 @@ private:
 
     int mPipeFd[2];
 
+    // Readiness of the interrupt pipe and of every session socket.
+    int mEpollFd;
+
     KeyedVector<int32_t, sp<Session> > mSessions;
 
     enum Mode {
@@ -125,6 +128,9 @@ private:
     void threadLoop();
     void interrupt();
 
+    void updatePollEvents(const sp<Session> &session);
+    void removeFromPoll(const sp<Session> &session);
+
     static status_t MakeSocketNonBlocking(int s);
 
     DISALLOW_EVIL_CONSTRUCTORS(ANetworkSession);
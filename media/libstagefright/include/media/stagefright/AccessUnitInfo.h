@@ -0,0 +1,49 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ACCESS_UNIT_INFO_H_
+#define ACCESS_UNIT_INFO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <utils/RefBase.h>
+
+namespace android {
+
+// One access unit of an input buffer that carries several of them,
+// see MediaCodec::queueInputBuffers().
+struct AccessUnitInfo {
+    size_t mOffset;     // from the start of the input buffer
+    size_t mSize;
+    int64_t mTimeUs;
+    uint32_t mFlags;    // MediaCodec::BUFFER_FLAG_*
+};
+
+// Carries the access units of an input buffer in its meta, under "accessUnits".
+// Codec2 decoders that take several access units per work also set it on output buffers
+// holding the output of several access units, with the timestamps of their inputs.
+// Offsets are relative to the buffer offset.
+struct AccessUnitInfos : public RefBase {
+    explicit AccessUnitInfos(std::vector<AccessUnitInfo> &&infos) : value(std::move(infos)) {}
+    const std::vector<AccessUnitInfo> value;
+};
+
+}  // namespace android
+
+#endif  // ACCESS_UNIT_INFO_H_
@@ -148,6 +148,11 @@ private:
     // Otherwise returns false.
     bool trySettingVideoSize(int32_t width, int32_t height);
 
+    // Lowers the camera frame rate to the slowest supported preview fps range,
+    // so that the camera captures fewer of the frames that are skipped
+    // between time lapse frames. Returns true if the range was set.
+    bool trySettingSlowestFpsRange();
+
     // When video camera is used for time lapse capture, returns true
     // until enough time has passed for the next time lapse frame. When
     // the frame needs to be encoded, it returns false and also modifies
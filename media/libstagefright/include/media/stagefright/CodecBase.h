@@ -289,6 +289,11 @@ struct CodecBase : public AHandler, /* static */ ColorUtils {
      *         ERROR_UNSUPPORTED if not supported.
      */
     virtual status_t unsubscribeFromParameters(const std::vector<std::string> &names);
+    /**
+     * Add diagnostic metrics of this instance to |metrics|, in the same
+     * format as BufferChannelBase::getMetrics().
+     */
+    virtual void getMetrics(const sp<AMessage> & /* metrics */) const {}
 
     typedef CodecBase *(*CreateCodecFunc)(void);
     typedef PersistentSurface *(*CreateInputSurfaceFunc)(void);
@@ -335,6 +340,11 @@ public:
      *            handled gracefully in the future, here and below).
      */
     virtual status_t queueInputBuffer(const sp<MediaCodecBuffer> &buffer) = 0;
+    /**
+     * Returns true if queueInputBuffer() sends each access unit listed under
+     * "accessUnits" in the buffer meta to the codec as a separate input.
+     */
+    virtual bool canQueueAccessUnits() const { return false; }
     /**
      * Queue a secure input buffer into the buffer channel.
      *
@@ -425,6 +435,17 @@ public:
      * Clear and fill array with output buffers.
      */
     virtual void getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *array) = 0;
+    /**
+     * Returns the number of times the output path of this buffer channel had
+     * to wait for another thread, for diagnostics.
+     */
+    virtual uint64_t getOutputContentionCount() const { return 0; }
+    /**
+     * Add diagnostic metrics of this buffer channel to |metrics|, as int64 or
+     * string entries keyed by a mediametrics attribute name relative to
+     * "android.media.mediacodec.".
+     */
+    virtual void getMetrics(const sp<AMessage> & /* metrics */) const {}
 
     /**
      * Convert binder IMemory to drm SharedBuffer
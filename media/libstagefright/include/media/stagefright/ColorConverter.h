@@ -37,6 +37,12 @@ struct ColorConverter {
 
     void setSrcColorSpace(uint32_t standard, uint32_t range, uint32_t transfer);
 
+    // Splits the crop rectangle of each convert() call into up to numThreads
+    // horizontal bands that are converted in parallel on a shared worker pool.
+    // 1 converts on the calling thread only. The initial value is read from
+    // the media.stagefright.cc_threads property, and defaults to 1.
+    void setNumThreads(size_t numThreads);
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight, size_t srcStride,
@@ -87,6 +93,7 @@ private:
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
     uint16_t *mClip10Bit;
+    size_t mNumThreads;
 
     uint8_t *initClip();
     uint16_t *initClip10Bit();
@@ -94,6 +101,10 @@ private:
     // returns the YUV2RGB matrix coefficients according to the color aspects and bit depth
     const struct Coeffs *getMatrix() const;
 
+    // converts the crop rectangle of src to dst on the calling thread.
+    status_t convertBand(
+            const BitmapParams &src, const BitmapParams &dst);
+
     status_t convertCbYCrY(
             const BitmapParams &src, const BitmapParams &dst);
 
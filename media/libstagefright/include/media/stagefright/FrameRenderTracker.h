@@ -58,9 +58,10 @@ struct RenderedFrameInfo {
 
     // creates information for a queued frame
     RenderedFrameInfo(int64_t mediaTimeUs, const sp<GraphicBuffer> &graphicBuffer,
-            const sp<Fence> &fence)
+            const sp<Fence> &fence, nsecs_t desiredRenderTimeNs = -1)
         : mMediaTimeUs(mediaTimeUs),
           mRenderTimeNs(-1),
+          mDesiredRenderTimeNs(desiredRenderTimeNs),
           mIndex(-1),
           mGraphicBuffer(graphicBuffer),
           mFence(fence) {
@@ -70,6 +71,7 @@ struct RenderedFrameInfo {
     RenderedFrameInfo(int64_t mediaTimeUs, nsecs_t renderTimeNs)
         : mMediaTimeUs(mediaTimeUs),
           mRenderTimeNs(renderTimeNs),
+          mDesiredRenderTimeNs(-1),
           mIndex(-1),
           mGraphicBuffer(NULL),
           mFence(NULL) {
@@ -78,6 +80,7 @@ struct RenderedFrameInfo {
 private:
     int64_t mMediaTimeUs;
     nsecs_t mRenderTimeNs;
+    nsecs_t mDesiredRenderTimeNs;  // -1 if not known
     ssize_t mIndex;         // to be used by client
     sp<GraphicBuffer> mGraphicBuffer;
     sp<Fence> mFence;
@@ -96,9 +99,11 @@ struct FrameRenderTracker {
     void clear(nsecs_t lastRenderTimeNs);
 
     // called when |graphicBuffer| corresponding to |mediaTimeUs| is
-    // queued to the output surface using |fence|.
+    // queued to the output surface using |fence|. If known, |desiredRenderTimeNs| is the
+    // system time the frame was scheduled to render at, and is used to track render errors.
     void onFrameQueued(
-            int64_t mediaTimeUs, const sp<GraphicBuffer> &graphicBuffer, const sp<Fence> &fence);
+            int64_t mediaTimeUs, const sp<GraphicBuffer> &graphicBuffer, const sp<Fence> &fence,
+            nsecs_t desiredRenderTimeNs = -1);
 
     // Called when we have dequeued a buffer |buf| from the native window to track render info.
     // |fenceFd| is the dequeue fence, and |index| is a positive buffer ID to be usable by the
@@ -128,15 +133,25 @@ struct FrameRenderTracker {
 
     void dumpRenderQueue() const;
 
+    // Histogram of render time errors (actual minus desired render time) of rendered frames.
+    // Bucket i counts errors below kRenderErrorBucketLimitsUs[i] (and at or above the limit
+    // of bucket i - 1). The last bucket counts all larger errors.
+    static const size_t kNumRenderErrorBuckets = 8;
+    static const int64_t kRenderErrorBucketLimitsUs[kNumRenderErrorBuckets - 1];
+    void getRenderErrorHistogram(uint64_t counts[kNumRenderErrorBuckets]) const;
+
     virtual ~FrameRenderTracker();
 
 private:
+    void addRenderError(nsecs_t errorNs);
+
 
     // Render information for buffers. Regular surface buffers are queued in the order of
     // rendering. Tunneled buffers are queued in the order of receipt.
     std::list<Info> mRenderQueue;
     nsecs_t mLastRenderTimeNs;
     AString mComponentName;
+    uint64_t mRenderErrorCounts[kNumRenderErrorBuckets];
 
     DISALLOW_EVIL_CONSTRUCTORS(FrameRenderTracker);
 };
@@ -39,10 +39,12 @@ sp<DataSource> CreateDataSourceFromIDataSource(const sp<IDataSource> &source);
 sp<IDataSource> CreateIDataSourceFromDataSource(const sp<DataSource> &source);
 
 // Creates an IMediaExtractor wrapper to the given MediaExtractor.
+// openTimeUs is how long it took to find and create the extractor, -1 if unknown.
 sp<IMediaExtractor> CreateIMediaExtractorFromMediaExtractor(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin);
+        const sp<RefBase> &plugin,
+        int64_t openTimeUs = -1);
 
 // Creates a MediaSource which wraps the given IMediaSource object.
 sp<MediaSource> CreateMediaSourceFromIMediaSource(const sp<IMediaSource> &source);
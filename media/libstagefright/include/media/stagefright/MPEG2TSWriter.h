@@ -51,6 +51,8 @@ private:
         kWhatSourceNotify = 'noti'
     };
 
+    static const size_t kTSPacketSize = 188;
+
     struct SourceInfo;
 
     FILE *mFile;
@@ -72,11 +74,17 @@ private:
     int mPMTContinuityCounter;
     uint32_t mCrcTable[256];
 
+    // The PAT and PMT packets, built when started.
+    uint8_t mProgramTables[2 * kTSPacketSize];
+
+    // Holds the TS packets of one access unit, reused across access units.
+    sp<ABuffer> mPacketBuffer;
+
     void init();
 
     void writeTS();
-    void writeProgramAssociationTable();
-    void writeProgramMap();
+    void buildProgramAssociationTable(uint8_t *packet);
+    void buildProgramMap(uint8_t *packet);
     void writeAccessUnit(int32_t sourceIndex, const sp<ABuffer> &buffer);
     void initCrcTable();
     uint32_t crc32(const uint8_t *start, size_t length);
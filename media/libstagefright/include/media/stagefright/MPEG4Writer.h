@@ -26,8 +26,10 @@
 #include <map>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace android {
 
@@ -50,6 +52,7 @@ public:
     virtual status_t pause();
     virtual bool reachedEOS();
     virtual status_t dump(int fd, const Vector<String16>& args);
+    virtual void getMetrics(const sp<AMessage> &metrics);
 
     void beginBox(const char *fourcc);
     void beginBox(uint32_t id);
@@ -83,6 +86,7 @@ protected:
 
 private:
     class Track;
+    class BlockWriter;
     friend struct AHandlerReflector<MPEG4Writer>;
 
     enum {
@@ -134,6 +138,30 @@ private:
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
 
+    // Coalesces file writes into large blocks written on a separate thread,
+    // enabled by the media.mp4writer.coalesce-writes property.
+    std::unique_ptr<BlockWriter> mBlockWriter;
+    off64_t mBlockWriterOffset;  // File offset the next coalesced write goes to.
+    off64_t mPreAllocatedExtentEnd;  // End of the space actually fallocate()d.
+
+    // Fragmented files, requested with kKeyFragmentDurationUs, have a moov box
+    // with empty sample tables followed by moof/mdat fragments, and end with an
+    // mfra box. A sidx box is written into space reserved after the moov box.
+    int64_t mFragmentDurationUs;  // 0 if the file is not fragmented.
+    bool mFragmentHeaderWritten;  // The moov box is written with the first fragment.
+    uint32_t mFragmentSequenceNumber;
+    off64_t mSidxOffset;
+    off64_t mSidxReservedSize;
+    bool isFragmented() const { return mFragmentDurationUs > 0; }
+
+    // Histogram of write latencies for the recorder metrics, counted against
+    // kWriteLatencyBucketsUs with a last bucket for anything slower.
+    static constexpr size_t kNumWriteLatencyBuckets = 7;
+    std::mutex mWriteLatencyLock;
+    uint32_t mWriteLatencyCounts[kNumWriteLatencyBuckets];
+    int64_t mMaxWriteLatencyUs;
+    void recordWriteLatency(int64_t latencyUs);
+
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
 
@@ -161,16 +189,28 @@ private:
     void writeCachedBoxToFile(const char *type);
     void printWriteDurations();
 
+    // A sample as described by the trun box of its fragment.
+    struct FragmentSample {
+        uint32_t mSize;
+        uint32_t mDurationTicks;            // In track timescale
+        int32_t mCompositionOffsetTicks;    // In track timescale
+        bool mIsSync;
+    };
+
     struct Chunk {
         Track               *mTrack;        // Owner
         int64_t             mTimeStampUs;   // Timestamp of the 1st sample
         List<MediaBuffer *> mSamples;       // Sample data
 
+        // Fragmented files only, a chunk is written out as one fragment.
+        int64_t mBaseDecodeTimeTicks;       // Decode time of the 1st sample
+        std::vector<FragmentSample> mFragmentSamples;
+
         // Convenient constructor
-        Chunk(): mTrack(NULL), mTimeStampUs(0) {}
+        Chunk(): mTrack(NULL), mTimeStampUs(0), mBaseDecodeTimeTicks(0) {}
 
         Chunk(Track *track, int64_t timeUs, List<MediaBuffer *> samples)
-            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples) {
+            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples), mBaseDecodeTimeTicks(0) {
         }
 
     };
@@ -191,6 +231,7 @@ private:
     pthread_t       mThread;                // Thread id for the writer
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
+    Condition       mChunkWrittenCondition; // Signal that chunks were taken to write
 
     // HEIF writing
     typedef key_value_pair_t< const char *, Vector<uint16_t> > ItemRefs;
@@ -259,6 +300,18 @@ private:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Fragmented files: write the chunk as a moof box followed by an mdat box.
+    void writeFragment(Chunk *chunk);
+    // Write the moov box and reserve the space for the sidx box.
+    void writeFragmentHeader();
+    // Write the sidx box into its reserved space and the mfra box at the end.
+    void writeFragmentIndexes();
+    void writeMvexBox();
+
+    // Build boxes of a known total size in memory and write them out at once.
+    void beginBoxesInMemory(size_t size);
+    void writeBoxesFromMemory();
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -70,6 +70,10 @@ public:
     // Use only when MediaBufferGroup is set.
     virtual void add_ref();
 
+    // Increments the local reference count if it is zero, and returns whether it did.
+    // Use only when MediaBufferGroup is set.
+    virtual bool add_first_ref();
+
     virtual void *data() const;
     virtual size_t size() const;
 
@@ -55,6 +55,10 @@ public:
     // Use only when MediaBufferGroup is set.
     virtual void add_ref() = 0;
 
+    // Increments the local reference count if it is zero, and returns whether it did.
+    // Use only when MediaBufferGroup is set.
+    virtual bool add_first_ref() = 0;
+
     virtual void *data() const = 0;
     virtual size_t size() const = 0;
 
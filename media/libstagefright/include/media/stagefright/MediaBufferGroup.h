@@ -56,6 +56,10 @@ public:
 
     size_t buffers() const;
 
+    // Number of times acquire_buffer() blocked, and allocated a buffer.
+    size_t waitCount() const;
+    size_t growCount() const;
+
     // If buffer is nullptr, have acquire_buffer() check for remote release.
     virtual void signalBufferReturned(MediaBufferBase *buffer);
 
@@ -26,6 +26,7 @@
 #include <media/MediaCodecInfo.h>
 #include <media/MediaMetrics.h>
 #include <media/MediaProfiles.h>
+#include <media/stagefright/AccessUnitInfo.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/FrameRenderTracker.h>
 #include <utils/Vector.h>
@@ -174,6 +175,15 @@ struct MediaCodec : public AHandler {
             uint32_t flags,
             AString *errorDetailMsg = NULL);
 
+    // Queues an input buffer holding several access units back to back, each
+    // with its own timestamp and flags. Only BUFFER_FLAG_CODECCONFIG and, on
+    // the last access unit, BUFFER_FLAG_EOS are allowed. Returns
+    // ERROR_UNSUPPORTED if the codec cannot take access units this way.
+    status_t queueInputBuffers(
+            size_t index,
+            const std::vector<AccessUnitInfo> &accessUnits,
+            AString *errorDetailMsg = NULL);
+
     status_t queueSecureInputBuffer(
             size_t index,
             size_t offset,
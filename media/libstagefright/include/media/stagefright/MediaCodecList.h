@@ -106,8 +106,13 @@ private:
     /**
      * This constructor will call `buildMediaCodecList()` from the given
      * `MediaCodecListBuilderBase` objects.
+     *
+     * If `cachePath` is not null, the list is loaded from the cache file there
+     * instead as long as the builders report the same fingerprint as when it
+     * was written, and the cache is rewritten after a full build.
      */
-    MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders);
+    MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders,
+                   const char *cachePath = nullptr);
 
     ~MediaCodecList();
 
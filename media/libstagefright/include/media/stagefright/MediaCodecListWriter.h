@@ -60,6 +60,19 @@ private:
     void writeGlobalSettings(const sp<AMessage> &globalSettings) const;
     void writeCodecInfos(std::vector<sp<MediaCodecInfo>> *codecInfos) const;
 
+    /**
+     * Fill this writer from the cache file at `path` if it was saved with the
+     * same `fingerprint`. The writer is left empty on failure.
+     *
+     * @return `OK` on success, `NAME_NOT_FOUND` if there is no usable cache.
+     */
+    status_t loadCache(const char *path, const std::string &fingerprint);
+    /**
+     * Atomically replace the cache file at `path` with the contents of this
+     * writer, tagged with `fingerprint`.
+     */
+    status_t saveCache(const char *path, const std::string &fingerprint) const;
+
     std::vector<std::pair<std::string, std::string>> mGlobalSettings;
     std::vector<sp<MediaCodecInfo>> mCodecInfos;
 
@@ -81,6 +94,17 @@ struct MediaCodecListBuilderBase {
      */
     virtual status_t buildMediaCodecList(MediaCodecListWriter* writer) = 0;
 
+    /**
+     * Describe everything the output of `buildMediaCodecList()` depends on,
+     * e.g. the configuration files and the components it queries, so that a
+     * `MediaCodecList` can reuse a cached copy of it while the fingerprint is
+     * unchanged. This must be much cheaper than building the list.
+     *
+     * @return The fingerprint, or an empty string if the output of this
+     * builder must not be cached.
+     */
+    virtual std::string getCacheFingerprint() { return std::string(); }
+
     /**
      * The default destructor does nothing.
      */
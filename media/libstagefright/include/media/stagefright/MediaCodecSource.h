@@ -49,6 +49,10 @@ struct MediaCodecSource : public MediaSource,
     sp<IGraphicBufferProducer> getGraphicBufferProducer();
     status_t setInputBufferTimeOffset(int64_t timeOffsetUs);
     int64_t getFirstSampleSystemTimeUs();
+    // Adds the latency of input buffers from the puller to the encoder as
+    // "queue-latency-avg-us" and "queue-latency-max-us". Nothing is added
+    // when the source is a surface.
+    void getMetrics(const sp<AMessage> &metrics);
 
     // MediaSource
     virtual status_t start(MetaData *params = NULL);
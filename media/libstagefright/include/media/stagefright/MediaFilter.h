@@ -21,9 +21,13 @@
 
 namespace android {
 
+class GraphicBuffer;
 struct GraphicBufferListener;
 struct SimpleFilter;
 
+// Each output buffer carries the time the filter took for the frame in its
+// "process-time-us" meta, and filters running on the GPU add the GPU time of
+// the frame as "gpu-time-us" where the driver can measure it.
 struct MediaFilter : public CodecBase {
     MediaFilter();
 
@@ -61,6 +65,10 @@ private:
         Status mStatus;
 
         sp<MediaCodecBuffer> mData;
+
+        // input surface frame handed to the filter as is, held until processed
+        sp<GraphicBuffer> mGraphicBuffer;
+        uint64_t mFrameNumber;
     };
 
     class BufferChannel;
@@ -111,6 +119,8 @@ private:
 
     sp<SimpleFilter> mFilter;
     sp<GraphicBufferListener> mGraphicBufferListener;
+    // input surface frames not acquired yet, while all that can be are held
+    size_t mDeferredFrames;
 
     std::shared_ptr<BufferChannel> mBufferChannel;
 
@@ -127,6 +137,7 @@ private:
     void postEOS();
     void requestFillEmptyInput();
     void processBuffers();
+    void releaseInputFrame(BufferInfo *info);
 
     void onAllocateComponent(const sp<AMessage> &msg);
     void onConfigureComponent(const sp<AMessage> &msg);
@@ -25,6 +25,8 @@
 
 namespace android {
 
+struct AMessage;
+
 struct MediaWriter : public RefBase {
     MediaWriter()
         : mMaxFileSizeLimitBytes(0),
@@ -59,6 +61,7 @@ struct MediaWriter : public RefBase {
     virtual void updateSocketNetwork(int64_t /*socketNetwork*/) {}
     virtual uint32_t getSequenceNum() { return 0; }
     virtual uint64_t getAccumulativeBytes() { return 0; }
+    virtual void getMetrics(const sp<AMessage> & /* metrics */) {}
 
 protected:
     virtual ~MediaWriter() {}
@@ -259,6 +259,9 @@ enum {
     // Treat empty track as malformed for MediaRecorder.
     kKeyEmptyTrackMalFormed = 'nemt', // bool (int32_t)
 
+    // Write a fragmented file with moof/mdat fragments of about this duration.
+    kKeyFragmentDurationUs = 'frgd', // int64_t (usecs)
+
     kKeyVps              = 'sVps', // int32_t, indicates that a buffer has vps.
     kKeySps              = 'sSps', // int32_t, indicates that a buffer has sps.
     kKeyPps              = 'sPps', // int32_t, indicates that a buffer has pps.
@@ -359,7 +362,6 @@ private:
     friend class BnMediaExtractor;
     friend class MetaData;
 
-    struct typed_data;
     struct Rect;
     struct MetaDataInternal;
     MetaDataInternal *mInternalData;
@@ -30,6 +30,7 @@ public:
     explicit OmxInfoBuilder(bool allowSurfaceEncoders);
     ~OmxInfoBuilder() override = default;
     status_t buildMediaCodecList(MediaCodecListWriter* writer) override;
+    std::string getCacheFingerprint() override;
 };
 
 }  // namespace android
@@ -31,7 +31,8 @@ public:
     static sp<IMediaExtractor> wrap(
             MediaExtractor *extractor,
             const sp<DataSource> &source,
-            const sp<RefBase> &plugin);
+            const sp<RefBase> &plugin,
+            int64_t openTimeUs = -1);
 
     virtual ~RemoteMediaExtractor();
     virtual size_t countTracks();
@@ -55,7 +56,8 @@ private:
     explicit RemoteMediaExtractor(
             MediaExtractor *extractor,
             const sp<DataSource> &source,
-            const sp<RefBase> &plugin);
+            const sp<RefBase> &plugin,
+            int64_t openTimeUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(RemoteMediaExtractor);
 };
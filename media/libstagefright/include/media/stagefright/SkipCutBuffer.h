@@ -27,6 +27,9 @@ namespace android {
 /**
  * utility class to cut the start and end off a stream of data in MediaBuffers
  *
+ * Buffers are trimmed in place: the held back end of the previous buffers is put in front of
+ * the data, and only the new end is copied into the internal ring. When the data of a buffer
+ * starts far enough into it, nothing in the buffer is moved.
  */
 class SkipCutBuffer: public RefBase {
  public:
@@ -42,6 +45,9 @@ class SkipCutBuffer: public RefBase {
     void submit(const sp<ABuffer>& buffer);    // same as above, but with an ABuffer
     void submit(const sp<MediaCodecBuffer>& buffer);    // same as above, but with an ABuffer
     void clear();
+    // Starts over as a newly constructed SkipCutBuffer would, for instance on a change of the
+    // channel count. The internal ring is kept when it is large enough.
+    void reset(size_t skip, size_t cut, size_t num16BitChannels);
     size_t size(); // how many bytes are currently stored in the buffer
 
  protected:
@@ -49,7 +55,12 @@ class SkipCutBuffer: public RefBase {
 
  private:
     void write(const char *src, size_t num);
-    size_t read(char *dst, size_t num);
+    // Reads exactly num bytes, which must not be more than size().
+    void read(char *dst, size_t num);
+    // Trims the data at [offset, offset + length) of a buffer with the given capacity, and
+    // returns the range of the result.
+    void trim(char *base, size_t capacity, int32_t offset, int32_t length,
+              int32_t *outOffset, int32_t *outLength);
     template <typename T>
     void submitInternal(const sp<T>& buffer);
     int32_t mSkip;
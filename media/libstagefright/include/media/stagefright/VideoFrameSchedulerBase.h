@@ -40,12 +40,17 @@ struct VideoFrameSchedulerBase : public RefBase {
     // returns the current frames-per-second, or 0.f if not primed
     float getFrameRate();
 
+    // re-read the display timing on the next schedule(), e.g. when the display
+    // switches between 60, 90 and 120Hz
+    void onDisplayRefreshRateChanged();
+
     virtual void release() = 0;
 
     static const size_t kHistorySize = 8;
     static const nsecs_t kNanosIn1s = 1000000000;
     static const nsecs_t kDefaultVsyncPeriod = kNanosIn1s / 60;  // 60Hz
     static const nsecs_t kVsyncRefreshPeriod = kNanosIn1s;       // 1 sec
+    static const nsecs_t kMaxCadenceFrames = 4;  // longest cadence cycle, e.g. 4:4:4:3
 
 protected:
     virtual ~VideoFrameSchedulerBase();
@@ -88,10 +93,25 @@ private:
 
     virtual void updateVsync() = 0;
 
+    // clear state that depends on the vsync timing
+    void resetVsyncState();
+    // returns the adjusted render time following a fixed cadence of vsyncs per frame,
+    // or -1 if the video period does not map to one
+    nsecs_t scheduleWithCadence(nsecs_t renderTime, nsecs_t videoPeriod);
+
     nsecs_t mLastVsyncTime;    // estimated vsync time for last frame
     nsecs_t mTimeCorrection;   // running adjustment
     PLL mPll;                  // PLL for video frame rate based on render time
 
+    // Cadence lock: frames are shown for mCadenceVsyncs vsyncs every mCadenceFrames
+    // frames (e.g. 5 vsyncs per 2 frames for 3:2 pulldown of 24p on 60Hz.)
+    const bool mCadenceLockEnabled;
+    nsecs_t mCadenceVsyncs;
+    nsecs_t mCadenceFrames;      // 0 if not locked
+    nsecs_t mCadenceVideoPeriod; // video period the cadence was selected for
+    nsecs_t mCadenceAnchorTime;  // render time of the first frame of the cadence
+    nsecs_t mCadenceAnchorVsync; // vsync time the first frame of the cadence is shown at
+
     DISALLOW_EVIL_CONSTRUCTORS(VideoFrameSchedulerBase);
 };
 
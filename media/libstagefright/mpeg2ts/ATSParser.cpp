@@ -125,6 +125,8 @@ private:
     uint32_t mPMTVersion;
     uint32_t mPMT_CRC;
     KeyedVector<unsigned, sp<Stream> > mStreams;
+    // index of the last stream looked up in mStreams, checked before use
+    size_t mLastStreamIndex;
     bool mFirstPTSValid;
     uint64_t mFirstPTS;
     int64_t mLastRecoveredPTS;
@@ -303,6 +305,7 @@ ATSParser::Program::Program(
       mProgramMapPID(programMapPID),
       mPMTVersion(0xffffffff),
       mPMT_CRC(0xffffffff),
+      mLastStreamIndex(0),
       mFirstPTSValid(false),
       mFirstPTS(0),
       mLastRecoveredPTS(lastRecoveredPTS) {
@@ -330,9 +333,14 @@ bool ATSParser::Program::parsePID(
         ABitReader *br, status_t *err, SyncEvent *event) {
     *err = OK;
 
-    ssize_t index = mStreams.indexOfKey(pid);
-    if (index < 0) {
-        return false;
+    // packets of the same stream mostly come in a row
+    ssize_t index = mLastStreamIndex;
+    if (mLastStreamIndex >= mStreams.size() || mStreams.keyAt(mLastStreamIndex) != pid) {
+        index = mStreams.indexOfKey(pid);
+        if (index < 0) {
+            return false;
+        }
+        mLastStreamIndex = index;
     }
 
     *err = mStreams.editValueAt(index)->parse(
@@ -1621,6 +1629,7 @@ status_t ATSParser::Stream::flushScrambled(SyncEvent *event) {
 
         ALOGV("[stream %d] descramble succeeded, %d bytes",
                 mElementaryPID, bytesWritten);
+        mProgram->casManager()->onDescramble(descrambleSubSamples);
 
         // Set descrambleBytes to the returned result.
         // Note that this might be smaller than the total length of input data.
@@ -1873,6 +1882,7 @@ ATSParser::ATSParser(uint32_t flags)
       mTimeOffsetValid(false),
       mTimeOffsetUs(0LL),
       mLastRecoveredPTS(-1LL),
+      mLastProgramIndex(0),
       mNumTSPacketsParsed(0),
       mNumPCRs(0) {
     mPSISections.add(0 /* PID */, new PSISection);
@@ -1893,6 +1903,43 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
     return parseTS(&br, event);
 }
 
+status_t ATSParser::feedTSPackets(const void *data, size_t size, size_t *consumed) {
+    const uint8_t *start = (const uint8_t *)data;
+    const uint8_t *end = start + size;
+    const uint8_t *packet = start;
+    status_t err = OK;
+
+    while (end - packet >= (ptrdiff_t)kTSPacketSize) {
+        if (packet[0] != 0x47) {
+            // Resync at the next sync byte that is followed by another one a
+            // packet later, if that is in the buffer. memchr is vectorized.
+            const uint8_t *next = packet + 1;
+            while ((next = (const uint8_t *)memchr(next, 0x47, end - next)) != NULL
+                    && end - next > (ptrdiff_t)kTSPacketSize
+                    && next[kTSPacketSize] != 0x47) {
+                ++next;
+            }
+            ALOGW("skipped %zd bytes to resync", (next == NULL ? end : next) - packet);
+            if (next == NULL) {
+                packet = end;
+                break;
+            }
+            packet = next;
+            continue;
+        }
+
+        ABitReader br(packet, kTSPacketSize);
+        err = parseTS(&br, NULL);
+        if (err != OK) {
+            break;
+        }
+        packet += kTSPacketSize;
+    }
+
+    *consumed = packet - start;
+    return err;
+}
+
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
     status_t err = mCasManager->setMediaCas(cas);
     if (err != OK) {
@@ -2102,8 +2149,11 @@ status_t ATSParser::parsePID(
         return OK;
     }
 
+    // Start with the program that handled the last packet, as there is
+    // mostly a single one.
     bool handled = false;
-    for (size_t i = 0; i < mPrograms.size(); ++i) {
+    for (size_t n = 0; n < mPrograms.size(); ++n) {
+        size_t i = (mLastProgramIndex + n) % mPrograms.size();
         status_t err;
         if (mPrograms.editItemAt(i)->parsePID(
                     PID, continuity_counter,
@@ -2115,6 +2165,7 @@ status_t ATSParser::parsePID(
                 return err;
             }
 
+            mLastProgramIndex = i;
             handled = true;
             break;
         }
@@ -2204,32 +2255,41 @@ status_t ATSParser::parseAdaptationField(
 status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
     ALOGV("---");
 
-    unsigned sync_byte = br->getBits(8);
+    if (br->numBitsLeft() < 32) {
+        return ERROR_MALFORMED;
+    }
+
+    // The header is byte aligned at the start of the packet, read it directly
+    // rather than field by field.
+    const uint8_t *header = br->data();
+    br->skipBits(32);
+
+    unsigned sync_byte = header[0];
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if (header[1] & 0x80) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    unsigned payload_unit_start_indicator = (header[1] >> 6) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (header[1] >> 5) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = ((header[1] & 0x1f) << 8) | header[2];
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = header[3] >> 6;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (header[3] >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = header[3] & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
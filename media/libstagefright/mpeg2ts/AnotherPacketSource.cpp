@@ -44,6 +44,7 @@ AnotherPacketSource::AnotherPacketSource(const sp<MetaData> &meta)
       mFormat(NULL),
       mLastQueuedTimeUs(0),
       mEstimatedBufferDurationUs(-1),
+      mBufferedBytes(0),
       mEOSResult(OK),
       mLatestEnqueuedMeta(NULL),
       mLatestDequeuedMeta(NULL) {
@@ -125,6 +126,7 @@ status_t AnotherPacketSource::dequeueAccessUnit(sp<ABuffer> *buffer) {
     if (!mBuffers.empty()) {
         *buffer = *mBuffers.begin();
         mBuffers.erase(mBuffers.begin());
+        mBufferedBytes -= (*buffer)->size();
 
         int32_t discontinuity;
         if ((*buffer)->meta()->findInt32("discontinuity", &discontinuity)) {
@@ -162,6 +164,7 @@ void AnotherPacketSource::requeueAccessUnit(const sp<ABuffer> &buffer) {
     // TODO: update corresponding book keeping info.
     Mutex::Autolock autoLock(mLock);
     mBuffers.push_front(buffer);
+    mBufferedBytes += buffer->size();
 }
 
 status_t AnotherPacketSource::read(
@@ -177,6 +180,7 @@ status_t AnotherPacketSource::read(
 
         const sp<ABuffer> buffer = *mBuffers.begin();
         mBuffers.erase(mBuffers.begin());
+        mBufferedBytes -= buffer->size();
 
         int32_t discontinuity;
         if (buffer->meta()->findInt32("discontinuity", &discontinuity)) {
@@ -295,6 +299,7 @@ void AnotherPacketSource::queueAccessUnit(const sp<ABuffer> &buffer) {
 
     Mutex::Autolock autoLock(mLock);
     mBuffers.push_back(buffer);
+    mBufferedBytes += buffer->size();
     mCondition.signal();
 
     int32_t discontinuity;
@@ -346,6 +351,7 @@ void AnotherPacketSource::clear() {
     Mutex::Autolock autoLock(mLock);
 
     mBuffers.clear();
+    mBufferedBytes = 0;
     mEOSResult = OK;
 
     mDiscontinuitySegments.clear();
@@ -372,6 +378,7 @@ void AnotherPacketSource::queueDiscontinuity(
             int32_t oldDiscontinuityType;
             if (!oldBuffer->meta()->findInt32(
                         "discontinuity", &oldDiscontinuityType)) {
+                mBufferedBytes -= oldBuffer->size();
                 it = mBuffers.erase(it);
                 continue;
             }
@@ -477,6 +484,11 @@ int64_t AnotherPacketSource::getBufferedDurationUs(status_t *finalResult) {
     return durationUs;
 }
 
+size_t AnotherPacketSource::getBufferedBytes() {
+    Mutex::Autolock autoLock(mLock);
+    return mBufferedBytes;
+}
+
 int64_t AnotherPacketSource::getEstimatedBufferDurationUs() {
     Mutex::Autolock autoLock(mLock);
     if (mEstimatedBufferDurationUs >= 0) {
@@ -621,6 +633,9 @@ void AnotherPacketSource::trimBuffersAfterMeta(
         newLastQueuedTimeUs = curTime.mTimeUs;
     }
 
+    for (List<sp<ABuffer> >::iterator it3 = it; it3 != mBuffers.end(); ++it3) {
+        mBufferedBytes -= (*it3)->size();
+    }
     mBuffers.erase(it, mBuffers.end());
     mLatestEnqueuedMeta = newLatestEnqueuedMeta;
     mLastQueuedTimeUs = newLastQueuedTimeUs;
@@ -691,6 +706,9 @@ sp<AMessage> AnotherPacketSource::trimBuffersBeforeMeta(
             break;
         }
     }
+    for (List<sp<ABuffer> >::iterator it2 = mBuffers.begin(); it2 != it; ++it2) {
+        mBufferedBytes -= (*it2)->size();
+    }
     mBuffers.erase(mBuffers.begin(), it);
     mLatestDequeuedMeta = NULL;
 
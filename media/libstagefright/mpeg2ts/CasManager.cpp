@@ -224,9 +224,15 @@ void ATSParser::CasManager::ProgramCasManager::closeAllSessions(
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ATSParser::CasManager::CasManager() : mSystemId(-1) {}
+ATSParser::CasManager::CasManager()
+    : mSystemId(-1), mDescrambleCalls(0), mDescrambledPackets(0) {}
 
 ATSParser::CasManager::~CasManager() {
+    if (mDescrambleCalls > 0) {
+        ALOGV("descrambled %lld packets in %lld calls (%.1f packets per call)",
+                (long long)mDescrambledPackets, (long long)mDescrambleCalls,
+                (double)mDescrambledPackets / mDescrambleCalls);
+    }
     // Explictly close the sessions opened by us, since the CAS object is owned
     // by the app and may not go away after the parser is destroyed, and the app
     // may not have information about the sessions.
@@ -345,4 +351,9 @@ bool ATSParser::CasManager::parsePID(ABitReader *br, unsigned pid) {
     return true; // handled
 }
 
+void ATSParser::CasManager::onDescramble(size_t numPackets) {
+    ++mDescrambleCalls;
+    mDescrambledPackets += numPackets;
+}
+
 }  // namespace android
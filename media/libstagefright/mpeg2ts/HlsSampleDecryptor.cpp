@@ -55,11 +55,11 @@ void HlsSampleDecryptor::signalNewSampleAesKey(const sp<AMessage> &sampleAesKeyI
               aesBlockToStr(keyDataBuffer->data()).c_str(),
               aesBlockToStr(initVecBuffer->data()).c_str());
 
-        uint8_t KeyData[AES_BLOCK_SIZE];
-        memcpy(KeyData, keyDataBuffer->data(), AES_BLOCK_SIZE);
         memcpy(mAESInitVec, initVecBuffer->data(), AES_BLOCK_SIZE);
 
-        mValidKeyInfo = (AES_set_decrypt_key(KeyData, 8*AES_BLOCK_SIZE/*128*/, &mAesKey) == 0);
+        mValidKeyInfo = EVP_DecryptInit_ex(mCipherCtx.get(), EVP_aes_128_cbc(), NULL,
+                keyDataBuffer->data(), mAESInitVec) == 1
+                && EVP_CIPHER_CTX_set_padding(mCipherCtx.get(), 0) == 1;
         if (!mValidKeyInfo) {
             ALOGE("signalNewSampleAesKey: failed to set AES decryption key.");
         }
@@ -106,33 +106,29 @@ size_t HlsSampleDecryptor::processNal(uint8_t *nalData, size_t nalSize) {
         //    }
         //}
 
-        size_t offset = VIDEO_CLEAR_LEAD;
-        size_t remainingBytes = nalSize - VIDEO_CLEAR_LEAD;
-
-        // a copy of initVec as decryptBlock updates it
-        unsigned char AESInitVec[AES_BLOCK_SIZE];
-        memcpy(AESInitVec, mAESInitVec, AES_BLOCK_SIZE);
-
-        while (remainingBytes > 0) {
-            // encrypted_block: protected block uses 10% skip encryption
-            if (remainingBytes > AES_BLOCK_SIZE) {
-                uint8_t *encrypted = nalData + offset;
-                status_t ret = decryptBlock(encrypted, AES_BLOCK_SIZE, AESInitVec);
-                if (ret != OK) {
-                    ALOGE("processNal failed with %d", ret);
-                    return nalSize; // revisit this
-                }
-
-                offset += AES_BLOCK_SIZE;
-                remainingBytes -= AES_BLOCK_SIZE;
-            }
+        // encrypted_block: protected block uses 10% skip encryption, i.e. one encrypted
+        // block every 160 bytes while more than a block remains. All of them form a
+        // single CBC chain, so they are gathered, decrypted in one call and put back.
+        const size_t kStride = 10 * AES_BLOCK_SIZE;
+        mEncryptedBlocks.clear();
+        for (size_t offset = VIDEO_CLEAR_LEAD; offset + AES_BLOCK_SIZE < nalSize;
+                offset += kStride) {
+            mEncryptedBlocks.insert(mEncryptedBlocks.end(),
+                    nalData + offset, nalData + offset + AES_BLOCK_SIZE);
+        }
 
-            // unencrypted_block
-            size_t clearBytes = std::min(remainingBytes, (size_t)(9 * AES_BLOCK_SIZE));
+        status_t ret = decryptBlocks(mEncryptedBlocks.data(), mEncryptedBlocks.size());
+        if (ret != OK) {
+            ALOGE("processNal failed with %d", ret);
+            return nalSize; // revisit this
+        }
 
-            offset += clearBytes;
-            remainingBytes -= clearBytes;
-        } // while
+        const uint8_t *decrypted = mEncryptedBlocks.data();
+        for (size_t offset = VIDEO_CLEAR_LEAD; offset + AES_BLOCK_SIZE < nalSize;
+                offset += kStride) {
+            memcpy(nalData + offset, decrypted, AES_BLOCK_SIZE);
+            decrypted += AES_BLOCK_SIZE;
+        }
 
     } else { // isEncrypted == false
         ALOGV("processNal[%d]: Unencrypted NALU  (%p)/%zu", nalType, nalData, nalSize);
@@ -179,14 +175,12 @@ void HlsSampleDecryptor::processAAC(size_t adtsHdrSize, uint8_t *data, size_t si
         if (remainingBytes >= AES_BLOCK_SIZE) {
 
             size_t encryptedBytes = (remainingBytes / AES_BLOCK_SIZE) * AES_BLOCK_SIZE;
-            unsigned char AESInitVec[AES_BLOCK_SIZE];
-            memcpy(AESInitVec, mAESInitVec, AES_BLOCK_SIZE);
 
             // decrypting all blocks at once
             uint8_t *encrypted = data + offset;
-            status_t ret = decryptBlock(encrypted, encryptedBytes, AESInitVec);
+            status_t ret = decryptBlocks(encrypted, encryptedBytes);
             if (ret != OK) {
-                ALOGE("processAAC: decryptBlock failed with %d", ret);
+                ALOGE("processAAC: decryptBlocks failed with %d", ret);
                 return;
             }
 
@@ -234,15 +228,11 @@ void HlsSampleDecryptor::processAC3(uint8_t *data, size_t size) {
 
             size_t encryptedBytes = (remainingBytes / AES_BLOCK_SIZE) * AES_BLOCK_SIZE;
 
-            // encrypted_block
-            unsigned char AESInitVec[AES_BLOCK_SIZE];
-            memcpy(AESInitVec, mAESInitVec, AES_BLOCK_SIZE);
-
-            // decrypting all blocks at once
+            // encrypted_block, decrypting all blocks at once
             uint8_t *encrypted = data + offset;
-            status_t ret = decryptBlock(encrypted, encryptedBytes, AESInitVec);
+            status_t ret = decryptBlocks(encrypted, encryptedBytes);
             if (ret != OK) {
-                ALOGE("processAC3: decryptBlock failed with %d", ret);
+                ALOGE("processAC3: decryptBlocks failed with %d", ret);
                 return;
             }
 
@@ -305,20 +295,26 @@ size_t HlsSampleDecryptor::findNextUnescapeIndex(uint8_t *data, size_t offset, s
     return limit;
 }
 
-status_t HlsSampleDecryptor::decryptBlock(uint8_t *buffer, size_t size,
-        uint8_t AESInitVec[AES_BLOCK_SIZE]) {
+// Decrypts |size| bytes in place as one CBC chain starting from the epoch's IV.
+status_t HlsSampleDecryptor::decryptBlocks(uint8_t *buffer, size_t size) {
     if (size == 0) {
         return OK;
     }
 
     if ((size % AES_BLOCK_SIZE) != 0) {
-        ALOGE("decryptBlock: size (%zu) not a multiple of block size", size);
+        ALOGE("decryptBlocks: size (%zu) not a multiple of block size", size);
         return ERROR_MALFORMED;
     }
 
-    ALOGV("decryptBlock: %p (%zu)", buffer, size);
+    ALOGV("decryptBlocks: %p (%zu)", buffer, size);
 
-    AES_cbc_encrypt(buffer, buffer, size, &mAesKey, AESInitVec, AES_DECRYPT);
+    // keeps the key schedule, only resets the chaining state.
+    int outLength = 0;
+    if (EVP_DecryptInit_ex(mCipherCtx.get(), NULL, NULL, NULL, mAESInitVec) != 1
+            || EVP_DecryptUpdate(mCipherCtx.get(), buffer, &outLength, buffer, size) != 1
+            || (size_t)outLength != size) {
+        return UNKNOWN_ERROR;
+    }
 
     return OK;
 }
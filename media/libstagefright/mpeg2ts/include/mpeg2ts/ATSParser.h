@@ -122,6 +122,12 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feeds all the whole TS packets in |data|. Bytes that are not at a sync
+    // byte are skipped up to the next packet start. |*consumed| is set to the
+    // number of bytes consumed, which leaves out a partial packet at the end
+    // and, on error, the packet that failed and those after it.
+    status_t feedTSPackets(const void *data, size_t size, size_t *consumed);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -205,6 +211,8 @@ private:
 
     uint32_t mFlags;
     Vector<sp<Program> > mPrograms;
+    // program that handled the last PES packet, tried first for the next one
+    size_t mLastProgramIndex;
 
     // Keyed by PID
     KeyedVector<unsigned, sp<PSISection> > mPSISections;
@@ -60,6 +60,9 @@ struct AnotherPacketSource : public MediaSource {
     // Returns the difference between the two largest timestamps queued
     int64_t getEstimatedBufferDurationUs();
 
+    // Returns the total size of the queued access units.
+    size_t getBufferedBytes();
+
     status_t nextBufferTime(int64_t *timeUs);
 
     void queueAccessUnit(const sp<ABuffer> &buffer);
@@ -118,6 +121,7 @@ private:
     int64_t mLastQueuedTimeUs;
     int64_t mEstimatedBufferDurationUs;
     List<sp<ABuffer> > mBuffers;
+    size_t mBufferedBytes;
     status_t mEOSResult;
     sp<AMessage> mLatestEnqueuedMeta;
     sp<AMessage> mLatestDequeuedMeta;
@@ -51,6 +51,9 @@ struct ATSParser::CasManager : public RefBase {
 
     bool parsePID(ABitReader *br, unsigned pid);
 
+    // Records a descramble call covering |numPackets| TS packets.
+    void onDescramble(size_t numPackets);
+
 private:
     typedef KeyedVector<unsigned, std::vector<uint8_t> > PidToSessionMap;
     struct ProgramCasManager;
@@ -62,6 +65,8 @@ private:
     KeyedVector<unsigned, sp<ProgramCasManager> > mProgramCasMap;
     PidToSessionMap mCAPidToSessionIdMap;
     std::set<uint32_t> mCAPidSet;
+    int64_t mDescrambleCalls;
+    int64_t mDescrambledPackets;
 };
 
 }  // namespace android
@@ -132,6 +132,9 @@ private:
             int32_t *pesOffset = NULL,
             int32_t *pesScramblingControl = NULL);
 
+    // Drops |size| bytes from the front of mBuffer without moving the rest.
+    void consumeBuffer(size_t size);
+
     sp<ABuffer> dequeueScrambledAccessUnit();
 
     DISALLOW_EVIL_CONSTRUCTORS(ElementaryStreamQueue);
@@ -22,6 +22,9 @@
 #include <media/stagefright/foundation/AString.h>
 
 #include <openssl/aes.h>
+#include <openssl/cipher.h>
+
+#include <vector>
 
 #include <utils/Errors.h>
 #include <utils/List.h>
@@ -48,14 +51,17 @@ struct HlsSampleDecryptor : SampleDecryptor {
 private:
     size_t unescapeStream(uint8_t *data, size_t limit) const;
     size_t findNextUnescapeIndex(uint8_t *data, size_t offset, size_t limit) const;
-    status_t decryptBlock(uint8_t *buffer, size_t size, uint8_t AESInitVec[AES_BLOCK_SIZE]);
+    status_t decryptBlocks(uint8_t *buffer, size_t size);
 
     static const int VIDEO_CLEAR_LEAD = 32;
     static const int AUDIO_CLEAR_LEAD = 16;
 
-    AES_KEY mAesKey;
+    // AES-128-CBC context keyed once per key/IV epoch, only the IV is reset per sample.
+    bssl::ScopedEVP_CIPHER_CTX mCipherCtx;
     uint8_t mAESInitVec[AES_BLOCK_SIZE];
     bool mValidKeyInfo;
+    // Encrypted blocks of a NAL unit, gathered to be decrypted in one call.
+    std::vector<uint8_t> mEncryptedBlocks;
 
     DISALLOW_EVIL_CONSTRUCTORS(HlsSampleDecryptor);
 };
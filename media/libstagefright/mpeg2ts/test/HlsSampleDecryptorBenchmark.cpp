@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decrypts synthetic SAMPLE-AES access units, H.264 slices and ADTS AAC
+// frames, checks them against the clear data and reports the throughput.
+//
+// Usage: HlsSampleDecryptorBenchmark [<access unit size> [<access units>]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <mpeg2ts/HlsSampleDecryptor.h>
+#include <openssl/aes.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kVideoClearLead = 32;
+constexpr size_t kAudioClearLead = 16;
+constexpr size_t kAdtsHeaderSize = 7;
+constexpr size_t kAacFrameSize = 768;
+
+const uint8_t kKey[AES_BLOCK_SIZE] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+const uint8_t kIv[AES_BLOCK_SIZE] = {
+        0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08,
+        0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00};
+
+// Clear data without any zero bytes, so that no emulation prevention is needed
+// before or after encryption is undone.
+std::vector<uint8_t> makeClearData(size_t size, std::default_random_engine *gen) {
+    std::uniform_int_distribution<int> byteDist(1, 255);
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = byteDist(*gen);
+    }
+    return data;
+}
+
+// Encrypts a slice NAL unit with the 1:9 block pattern of SAMPLE-AES video.
+void encryptNal(uint8_t *data, size_t size) {
+    AES_KEY key;
+    AES_set_encrypt_key(kKey, 128, &key);
+    uint8_t iv[AES_BLOCK_SIZE];
+    memcpy(iv, kIv, sizeof(iv));
+    for (size_t offset = kVideoClearLead; offset + AES_BLOCK_SIZE < size;
+            offset += 10 * AES_BLOCK_SIZE) {
+        AES_cbc_encrypt(data + offset, data + offset, AES_BLOCK_SIZE, &key, iv, AES_ENCRYPT);
+    }
+}
+
+// Encrypts the whole blocks after the clear leader of an ADTS frame.
+void encryptAac(uint8_t *data, size_t size) {
+    AES_KEY key;
+    AES_set_encrypt_key(kKey, 128, &key);
+    uint8_t iv[AES_BLOCK_SIZE];
+    memcpy(iv, kIv, sizeof(iv));
+    size_t offset = kAdtsHeaderSize + kAudioClearLead;
+    size_t encryptedBytes = (size - offset) / AES_BLOCK_SIZE * AES_BLOCK_SIZE;
+    AES_cbc_encrypt(data + offset, data + offset, encryptedBytes, &key, iv, AES_ENCRYPT);
+}
+
+sp<HlsSampleDecryptor> makeDecryptor() {
+    sp<AMessage> keyItem = new AMessage;
+    keyItem->setBuffer("keyData", ABuffer::CreateAsCopy(kKey, sizeof(kKey)));
+    keyItem->setBuffer("initVec", ABuffer::CreateAsCopy(kIv, sizeof(kIv)));
+    return new HlsSampleDecryptor(keyItem);
+}
+
+// Returns false if the decrypted data does not match the clear data.
+bool decryptVideo(size_t auSize, uint32_t accessUnits, double *seconds) {
+    std::default_random_engine gen(0xC0FFEE);
+    std::vector<uint8_t> clear = makeClearData(auSize, &gen);
+    clear[0] = 0x65; // IDR slice
+    std::vector<uint8_t> encrypted = clear;
+    encryptNal(encrypted.data(), encrypted.size());
+
+    sp<HlsSampleDecryptor> decryptor = makeDecryptor();
+    std::vector<uint8_t> data;
+    std::chrono::duration<double> elapsed(0);
+    for (uint32_t i = 0; i < accessUnits; ++i) {
+        data = encrypted;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t size = decryptor->processNal(data.data(), data.size());
+        elapsed += std::chrono::steady_clock::now() - start;
+        if (size != clear.size() || data != clear) {
+            fprintf(stderr, "Video access unit %u did not decrypt\n", i);
+            return false;
+        }
+    }
+    *seconds = elapsed.count();
+    return true;
+}
+
+size_t aacFrames(size_t auSize) {
+    return std::max(auSize / kAacFrameSize, (size_t)1);
+}
+
+bool decryptAudio(size_t auSize, uint32_t accessUnits, double *seconds) {
+    std::default_random_engine gen(0xBEEF);
+    size_t frames = aacFrames(auSize);
+    std::vector<uint8_t> clear = makeClearData(frames * kAacFrameSize, &gen);
+    std::vector<uint8_t> encrypted = clear;
+    for (size_t f = 0; f < frames; ++f) {
+        encryptAac(encrypted.data() + f * kAacFrameSize, kAacFrameSize);
+    }
+
+    sp<HlsSampleDecryptor> decryptor = makeDecryptor();
+    std::vector<uint8_t> data;
+    std::chrono::duration<double> elapsed(0);
+    for (uint32_t i = 0; i < accessUnits; ++i) {
+        data = encrypted;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t f = 0; f < frames; ++f) {
+            decryptor->processAAC(kAdtsHeaderSize, data.data() + f * kAacFrameSize,
+                    kAacFrameSize);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+        if (data != clear) {
+            fprintf(stderr, "Audio access unit %u did not decrypt\n", i);
+            return false;
+        }
+    }
+    *seconds = elapsed.count();
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    size_t auSize = argc > 1 ? atoi(argv[1]) : 64 * 1024;
+    uint32_t accessUnits = argc > 2 ? atoi(argv[2]) : 2000;
+    if (auSize <= kVideoClearLead + AES_BLOCK_SIZE || accessUnits == 0) {
+        fprintf(stderr, "Usage %s [<access unit size> [<access units>]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%u access units of %zu bytes\n", accessUnits, auSize);
+    for (bool video : { true, false }) {
+        double seconds = 0;
+        if (!(video ? decryptVideo : decryptAudio)(auSize, accessUnits, &seconds)) {
+            return EXIT_FAILURE;
+        }
+        if (seconds <= 0) {
+            seconds = 1e-9;
+        }
+        size_t bytes = video ? auSize : aacFrames(auSize) * kAacFrameSize;
+        printf("%-6s %10.1f MB/s %12.0f AU/s\n", video ? "video" : "audio",
+               bytes * (double)accessUnits / seconds / 1e6, accessUnits / seconds);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Demuxes a transport stream from memory, feeding it packet by packet and in
+// batches, and reports the throughput of each.
+//
+// Usage: Mpeg2tsBenchmark <input ts> [<repeat>]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+#include <mpeg2ts/ATSParser.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kTSPacketSize = 188;
+// data fed between draining the access units
+constexpr size_t kChunkSize = kTSPacketSize * 1024;
+
+bool readFile(const char *path, std::vector<uint8_t> *data) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        data->insert(data->end(), buffer, buffer + n);
+    }
+    fclose(fp);
+    if (data->size() < kTSPacketSize) {
+        fprintf(stderr, "%s is too short\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Drops the access units queued so far so that the memory use stays flat.
+void drain(const sp<ATSParser> &parser) {
+    for (ATSParser::SourceType type : { ATSParser::VIDEO, ATSParser::AUDIO, ATSParser::META }) {
+        sp<AnotherPacketSource> source = parser->getSource(type);
+        if (source != nullptr) {
+            source->clear();
+        }
+    }
+}
+
+// Returns false on failure.
+bool demux(const std::vector<uint8_t> &data, uint32_t repeat, bool batch, double *seconds) {
+    sp<ATSParser> parser = new ATSParser();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeat; ++r) {
+        if (r > 0) {
+            parser->signalDiscontinuity(ATSParser::DISCONTINUITY_TIME, nullptr);
+        }
+        for (size_t offset = 0; offset + kTSPacketSize <= data.size();) {
+            size_t size = std::min(kChunkSize, data.size() - offset);
+            if (batch) {
+                size_t consumed = 0;
+                status_t err = parser->feedTSPackets(data.data() + offset, size, &consumed);
+                if (err != OK || consumed == 0) {
+                    fprintf(stderr, "Failed to demux at %zu (%d)\n", offset + consumed, err);
+                    return false;
+                }
+                offset += consumed;
+            } else {
+                size_t end = offset + size - size % kTSPacketSize;
+                for (; offset < end; offset += kTSPacketSize) {
+                    status_t err = parser->feedTSPacket(data.data() + offset, kTSPacketSize);
+                    if (err != OK) {
+                        fprintf(stderr, "Failed to demux at %zu (%d)\n", offset, err);
+                        return false;
+                    }
+                }
+            }
+            drain(parser);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    *seconds = elapsed.count();
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage %s <input ts> [<repeat>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint32_t repeat = argc > 2 ? atoi(argv[2]) : 1;
+    std::vector<uint8_t> data;
+    if (repeat == 0 || !readFile(argv[1], &data)) {
+        return EXIT_FAILURE;
+    }
+
+    double packets = (double)(data.size() / kTSPacketSize) * repeat;
+    printf("%zu bytes, %.0f packets\n", data.size() * repeat, packets);
+    for (bool batch : { false, true }) {
+        double seconds = 0;
+        if (!demux(data, repeat, batch, &seconds)) {
+            return EXIT_FAILURE;
+        }
+        if (seconds <= 0) {
+            seconds = 1e-9;
+        }
+        printf("%-10s %10.1f MB/s %12.0f packets/s\n", batch ? "batch" : "per-packet",
+               data.size() * repeat / seconds / 1e6, packets / seconds);
+    }
+    return EXIT_SUCCESS;
+}
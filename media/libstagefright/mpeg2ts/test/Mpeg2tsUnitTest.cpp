@@ -25,6 +25,8 @@
 #include <datasource/FileSource.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaDataBase.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/ATSParser.h>
@@ -216,6 +218,28 @@ TEST_P(Mpeg2tsUnitTest, MediaInfoTest) {
     }
 }
 
+TEST(AnotherPacketSourceTest, BufferedBytesTest) {
+    sp<AnotherPacketSource> source = new AnotherPacketSource(nullptr);
+    for (int64_t i = 0; i < 4; ++i) {
+        sp<ABuffer> buffer = new ABuffer(100 * (i + 1));
+        buffer->meta()->setInt64("timeUs", i * 10000);
+        source->queueAccessUnit(buffer);
+    }
+    ASSERT_EQ(source->getBufferedBytes(), 1000u);
+
+    sp<ABuffer> buffer;
+    ASSERT_EQ(source->dequeueAccessUnit(&buffer), (status_t)OK);
+    ASSERT_EQ(source->getBufferedBytes(), 900u);
+    source->requeueAccessUnit(buffer);
+    ASSERT_EQ(source->getBufferedBytes(), 1000u);
+
+    // discarding keeps only the discontinuity, which holds no data
+    source->queueDiscontinuity(ATSParser::DISCONTINUITY_TIME, nullptr, true /* discard */);
+    ASSERT_EQ(source->getBufferedBytes(), 0u);
+    status_t finalResult;
+    ASSERT_TRUE(source->hasBufferAvailable(&finalResult));
+}
+
 INSTANTIATE_TEST_SUITE_P(
         infoTest, Mpeg2tsUnitTest,
         ::testing::Values(make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", 0x01, 1),
@@ -17,6 +17,7 @@
 #include <ios>
 #include <list>
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <media/openmax/OMX_Core.h>
 #include <media/openmax/OMX_AsString.h>
@@ -182,6 +183,26 @@ void Omx::serviceDied(uint64_t /* cookie */, wp<IBase> const& who) {
     instance->onObserverDied();
 }
 
+Return<void> Omx::debug(const hidl_handle& fd, const hidl_vec<hidl_string>& /* args */) {
+    if (fd.getNativeHandle() == nullptr || fd->numFds < 1) {
+        LOG(ERROR) << "debug -- missing fd to dump to";
+        return Void();
+    }
+
+    std::string out;
+    {
+        Mutex::Autolock autoLock(mLock);
+        out = "Live nodes: " + std::to_string(mLiveNodes.size()) + "\n";
+        for (size_t i = 0; i < mLiveNodes.size(); ++i) {
+            out += mLiveNodes.valueAt(i)->dumpBufferStats();
+        }
+    }
+    if (!::android::base::WriteStringToFd(out, fd->data[0])) {
+        PLOG(WARNING) << "debug -- write failed";
+    }
+    return Void();
+}
+
 status_t Omx::freeNode(sp<OMXNodeInstance> const& instance) {
     if (instance == NULL) {
         return OK;
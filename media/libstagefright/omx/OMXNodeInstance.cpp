@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "OMXNodeInstance"
 #include <android-base/macros.h>
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
 
 #include <inttypes.h>
@@ -135,30 +136,38 @@ struct BufferMeta {
                 static_cast<void*>(mHidlMemory->getPointer())) : nullptr;
     }
 
-    void CopyFromOMX(const OMX_BUFFERHEADERTYPE *header) {
+    // returns the number of bytes copied
+    size_t CopyFromOMX(const OMX_BUFFERHEADERTYPE *header) {
         if (!mCopyFromOmx) {
-            return;
+            return 0;
         }
 
         // add NULL check to avoid memcpy on freed buffer
         if (header == NULL) {
-            return;
-}
-        
+            return 0;
+        }
+
         // check component returns proper range
         sp<ABuffer> codec = getBuffer(header, true /* limit */);
 
         memcpy(getPointer() + header->nOffset, codec->data(), codec->size());
+        return codec->size();
     }
 
-    void CopyToOMX(const OMX_BUFFERHEADERTYPE *header) {
+    // returns the number of bytes copied
+    size_t CopyToOMX(const OMX_BUFFERHEADERTYPE *header) {
         if (!mCopyToOmx) {
-            return;
+            return 0;
         }
 
         memcpy(header->pBuffer + header->nOffset,
                 getPointer() + header->nOffset,
                 header->nFilledLen);
+        return header->nFilledLen;
+    }
+
+    bool copies() const {
+        return mCopyFromOmx || mCopyToOmx;
     }
 
     // return the codec buffer
@@ -457,6 +466,14 @@ OMXNodeInstance::OMXNodeInstance(
     mSecureBufferType[1] = kSecureBufferTypeUnknown;
     mGraphicBufferEnabled[0] = false;
     mGraphicBufferEnabled[1] = false;
+    bool shareClientBuffers = property_get_bool("vendor.media.omx.share_client_buffers", true);
+    for (size_t i = 0; i < 2; ++i) {
+        mShareClientBuffers[i] = shareClientBuffers;
+        mSharedBuffers[i] = 0;
+        mCopiedBuffers[i] = 0;
+        mCopies[i] = 0;
+        mCopiedBytes[i] = 0;
+    }
     mIsSecure = AString(name).endsWith(".secure");
     mLegacyAdaptiveExperiment = ADebug::isExperimentEnabled("legacy-adaptive");
 }
@@ -1308,7 +1325,31 @@ status_t OMXNodeInstance::useBuffer_l(
             : kRequiresAllocateBufferOnOutputPorts;
 
     // we use useBuffer for output metadata regardless of quirks
-    if (!isOutputGraphicMetadata && (mQuirks & requiresAllocateBufferBit)) {
+    bool requiresAllocate = !isOutputGraphicMetadata && (mQuirks & requiresAllocateBufferBit);
+    bool shared = false;
+    if (requiresAllocate && !isMetadata && canShareClientBuffer_l(portIndex, paramsPointer)) {
+        // offer the client's memory first, and copy only if the component refuses it
+        buffer_meta = new BufferMeta(
+                params, hParams, portIndex, false /* copy */, NULL /* data */);
+
+        err = OMX_UseBuffer(
+                mHandle, &header, portIndex, buffer_meta,
+                allottedSize, static_cast<OMX_U8 *>(paramsPointer));
+
+        if (err == OMX_ErrorNone) {
+            shared = true;
+        } else {
+            CLOG_CONFIG(useBuffer, "%s:%u refused the client buffer (%s), copying",
+                    portString(portIndex), portIndex, asString(err));
+            delete buffer_meta;
+            // do not offer it again on this port
+            mShareClientBuffers[portIndex] = false;
+        }
+    }
+
+    if (shared) {
+        // the buffer is set up
+    } else if (requiresAllocate) {
         // metadata buffers are not connected cross process; only copy if not meta.
         buffer_meta = new BufferMeta(
                     params, hParams, portIndex, !isMetadata /* copy */, NULL /* data */);
@@ -1367,6 +1408,12 @@ status_t OMXNodeInstance::useBuffer_l(
 
     addActiveBuffer(portIndex, *buffer);
 
+    if (buffer_meta->copies()) {
+        ++mCopiedBuffers[portIndex];
+    } else if (!isMetadata) {
+        ++mSharedBuffers[portIndex];
+    }
+
     sp<IOMXBufferSource> bufferSource(getBufferSource());
     if (bufferSource != NULL && portIndex == kPortIndexInput) {
         bufferSource->onInputBufferAdded(*buffer);
@@ -1377,6 +1424,44 @@ status_t OMXNodeInstance::useBuffer_l(
     return OK;
 }
 
+bool OMXNodeInstance::canShareClientBuffer_l(OMX_U32 portIndex, const void *data) {
+    if (!mShareClientBuffers[portIndex]) {
+        return false;
+    }
+
+    OMX_PARAM_PORTDEFINITIONTYPE def;
+    InitOMXParams(&def);
+    def.nPortIndex = portIndex;
+    if (OMX_GetParameter(mHandle, OMX_IndexParamPortDefinition, &def) != OMX_ErrorNone) {
+        return false;
+    }
+
+    // separately mapped client buffers cannot be contiguous, or more aligned than they are
+    if (def.bBuffersContiguous
+            || (def.nBufferAlignment > 1
+                    && reinterpret_cast<uintptr_t>(data) % def.nBufferAlignment != 0)) {
+        CLOG_CONFIG(useBuffer, "%s:%u needs %s buffers aligned to %u, copying",
+                portString(portIndex), portIndex,
+                def.bBuffersContiguous ? "contiguous" : "separate", def.nBufferAlignment);
+        mShareClientBuffers[portIndex] = false;
+        return false;
+    }
+    return true;
+}
+
+std::string OMXNodeInstance::dumpBufferStats() const {
+    std::string out = base::StringPrintf("%s\n", mName);
+    for (OMX_U32 portIndex = 0; portIndex < 2; ++portIndex) {
+        out += base::StringPrintf(
+                "  %s: %u shared buffers, %u copied buffers, %llu copies of %llu bytes\n",
+                portString(portIndex), mSharedBuffers[portIndex].load(),
+                mCopiedBuffers[portIndex].load(),
+                (unsigned long long)mCopies[portIndex].load(),
+                (unsigned long long)mCopiedBytes[portIndex].load());
+    }
+    return out;
+}
+
 status_t OMXNodeInstance::useGraphicBuffer2_l(
         OMX_U32 portIndex, const sp<GraphicBuffer>& graphicBuffer,
         IOMX::buffer_id *buffer) {
@@ -1885,7 +1970,11 @@ status_t OMXNodeInstance::emptyBuffer_l(
         header->nFilledLen = rangeLength;
         header->nOffset = rangeOffset;
 
-        buffer_meta->CopyToOMX(header);
+        size_t copied = buffer_meta->CopyToOMX(header);
+        if (copied > 0) {
+            ++mCopies[kPortIndexInput];
+            mCopiedBytes[kPortIndexInput] += copied;
+        }
     }
 
     return emptyBuffer_l(header, flags, timestamp, (intptr_t)buffer, fenceFd);
@@ -2192,7 +2281,11 @@ bool OMXNodeInstance::handleMessage(omx_message &msg) {
             CLOG_ERROR(onFillBufferDone, OMX_ErrorBadParameter,
                     FULL_BUFFER(NULL, buffer, msg.fenceFd));
         }
-        buffer_meta->CopyFromOMX(buffer);
+        size_t copied = buffer_meta->CopyFromOMX(buffer);
+        if (copied > 0) {
+            ++mCopies[kPortIndexOutput];
+            mCopiedBytes[kPortIndexOutput] += copied;
+        }
 
         // fix up the buffer info (especially timestamp) if needed
         codecBufferFilled(msg);
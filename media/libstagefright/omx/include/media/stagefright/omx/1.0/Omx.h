@@ -43,6 +43,7 @@ using ::android::hardware::media::omx::V1_0::Status;
 using ::android::hidl::base::V1_0::IBase;
 using ::android::hardware::hidl_death_recipient;
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
@@ -66,6 +67,9 @@ struct Omx : public IOmx, public hidl_death_recipient {
             allocateNode_cb _hidl_cb) override;
     Return<void> createInputSurface(createInputSurface_cb _hidl_cb) override;
 
+    // Method from IBase, dumps the buffer copy statistics of the live nodes
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& args) override;
+
     // Method from hidl_death_recipient
     void serviceDied(uint64_t cookie, const wp<IBase>& who) override;
 
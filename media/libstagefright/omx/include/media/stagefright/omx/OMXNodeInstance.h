@@ -19,6 +19,7 @@
 #define OMX_NODE_INSTANCE_H_
 
 #include <atomic>
+#include <string>
 
 #include <media/IOMX.h>
 #include <utils/RefBase.h>
@@ -117,6 +118,11 @@ struct OMXNodeInstance : public BnOMXNode {
 
     static OMX_CALLBACKTYPE kCallbacks;
 
+    // Returns the name of the component and how many byte buffers of each port
+    // are shared with the client or copied, and how much was copied, for the
+    // dump of the service.
+    std::string dumpBufferStats() const;
+
 private:
     struct CallbackDispatcherThread;
     struct CallbackDispatcher;
@@ -163,6 +169,16 @@ private:
     SecureBufferType mSecureBufferType[2];
     bool mGraphicBufferEnabled[2];
 
+    // Whether byte buffers of a component that requires OMX_AllocateBuffer
+    // are offered from the client's memory first, which saves copying them in
+    // or out for every frame. Cleared for a port once the component refuses.
+    bool mShareClientBuffers[2];
+    // modified under mLock, read outside for the dump
+    std::atomic<uint32_t> mSharedBuffers[2];
+    std::atomic<uint32_t> mCopiedBuffers[2];
+    std::atomic<uint64_t> mCopies[2];
+    std::atomic<uint64_t> mCopiedBytes[2];
+
     // Following are OMX parameters managed by us (instead of the component)
     // OMX_IndexParamMaxFrameDurationForBitrateControl
     KeyedVector<int64_t, int64_t> mOriginalTimeUs;
@@ -197,6 +213,9 @@ private:
 
     bool isProhibitedIndex_l(OMX_INDEXTYPE index);
 
+    // Returns true if byte buffers of the port may be offered from the client's memory at |data|.
+    bool canShareClientBuffer_l(OMX_U32 portIndex, const void *data);
+
     status_t useBuffer_l(
             OMX_U32 portIndex, const sp<IMemory> &params,
             const sp<IHidlMemory> &hParams, IOMX::buffer_id *buffer);
@@ -350,6 +350,14 @@ GLESRenderEngine::GLESRenderEngine(const RenderEngineCreationArgs& args, EGLDisp
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
+    if (!args.programBinaryCachePath.empty()) {
+        if (GLExtensions::getInstance().hasProgramBinary()) {
+            ProgramCache::getInstance().setBinaryCachePath(args.programBinaryCachePath);
+        } else {
+            ALOGI("GL_OES_get_program_binary is not supported, not caching programs");
+        }
+    }
+
     // Initialize protected EGL Context.
     if (mProtectedEGLContext != EGL_NO_CONTEXT) {
         EGLBoolean success = eglMakeCurrent(display, mProtectedStubSurface, mProtectedStubSurface,
@@ -1513,6 +1521,7 @@ void GLESRenderEngine::dump(std::string& result) {
                   cache.getSize(mEGLContext));
     StringAppendF(&result, "RenderEngine program cache size for protected context: %zu\n",
                   cache.getSize(mProtectedEGLContext));
+    StringAppendF(&result, "RenderEngine program binaries: %zu\n", cache.getBinaryCacheSize());
     StringAppendF(&result, "RenderEngine last dataspace conversion: (%s) to (%s)\n",
                   dataspaceDetails(static_cast<android_dataspace>(mDataSpace)).c_str(),
                   dataspaceDetails(static_cast<android_dataspace>(mOutputDataSpace)).c_str());
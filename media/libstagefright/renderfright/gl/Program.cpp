@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 
+#include <GLES2/gl2ext.h>
 #include <log/log.h>
 #include <math/mat4.h>
 #include <utils/String8.h>
@@ -58,29 +59,66 @@ Program::Program(const ProgramCache::Key& /*needs*/, const char* vertex, const c
         glDeleteShader(fragmentId);
         glDeleteProgram(programId);
     } else {
-        mProgram = programId;
         mVertexShader = vertexId;
         mFragmentShader = fragmentId;
-        mInitialized = true;
-        mProjectionMatrixLoc = glGetUniformLocation(programId, "projection");
-        mTextureMatrixLoc = glGetUniformLocation(programId, "texture");
-        mSamplerLoc = glGetUniformLocation(programId, "sampler");
-        mColorLoc = glGetUniformLocation(programId, "color");
-        mDisplayMaxLuminanceLoc = glGetUniformLocation(programId, "displayMaxLuminance");
-        mMaxMasteringLuminanceLoc = glGetUniformLocation(programId, "maxMasteringLuminance");
-        mMaxContentLuminanceLoc = glGetUniformLocation(programId, "maxContentLuminance");
-        mInputTransformMatrixLoc = glGetUniformLocation(programId, "inputTransformMatrix");
-        mOutputTransformMatrixLoc = glGetUniformLocation(programId, "outputTransformMatrix");
-        mCornerRadiusLoc = glGetUniformLocation(programId, "cornerRadius");
-        mCropCenterLoc = glGetUniformLocation(programId, "cropCenter");
-
-        // set-up the default values for our uniforms
-        glUseProgram(programId);
-        glUniformMatrix4fv(mProjectionMatrixLoc, 1, GL_FALSE, mat4().asArray());
-        glEnableVertexAttribArray(0);
+        init(programId);
     }
 }
 
+Program::Program(const ProgramCache::Key& /*needs*/, GLenum binaryFormat, const void* binary,
+                 GLsizei length)
+      : mInitialized(false), mVertexShader(0), mFragmentShader(0) {
+    GLuint programId = glCreateProgram();
+    glProgramBinaryOES(programId, binaryFormat, binary, length);
+
+    // drivers reject binaries they can't use, e.g. after an update
+    GLint status;
+    glGetProgramiv(programId, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        ALOGW("Program binary (format 0x%x, %d bytes) was rejected", binaryFormat, length);
+        glDeleteProgram(programId);
+        return;
+    }
+    init(programId);
+}
+
+void Program::init(GLuint programId) {
+    mProgram = programId;
+    mInitialized = true;
+    mProjectionMatrixLoc = glGetUniformLocation(programId, "projection");
+    mTextureMatrixLoc = glGetUniformLocation(programId, "texture");
+    mSamplerLoc = glGetUniformLocation(programId, "sampler");
+    mColorLoc = glGetUniformLocation(programId, "color");
+    mDisplayMaxLuminanceLoc = glGetUniformLocation(programId, "displayMaxLuminance");
+    mMaxMasteringLuminanceLoc = glGetUniformLocation(programId, "maxMasteringLuminance");
+    mMaxContentLuminanceLoc = glGetUniformLocation(programId, "maxContentLuminance");
+    mInputTransformMatrixLoc = glGetUniformLocation(programId, "inputTransformMatrix");
+    mOutputTransformMatrixLoc = glGetUniformLocation(programId, "outputTransformMatrix");
+    mCornerRadiusLoc = glGetUniformLocation(programId, "cornerRadius");
+    mCropCenterLoc = glGetUniformLocation(programId, "cropCenter");
+
+    // set-up the default values for our uniforms
+    glUseProgram(programId);
+    glUniformMatrix4fv(mProjectionMatrixLoc, 1, GL_FALSE, mat4().asArray());
+    glEnableVertexAttribArray(0);
+}
+
+bool Program::getBinary(GLenum* binaryFormat, std::vector<uint8_t>* binary) const {
+    GLint length = 0;
+    glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) {
+        return false;
+    }
+    binary->resize(length);
+    GLsizei written = 0;
+    glGetProgramBinaryOES(mProgram, length, &written, binaryFormat, binary->data());
+    if (written <= 0) {
+        return false;
+    }
+    binary->resize(written);
+    return true;
+}
+
 bool Program::isValid() const {
     return mInitialized;
 }
@@ -18,12 +18,21 @@
 
 #include "ProgramCache.h"
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <log/log.h>
 #include <renderengine/private/Description.h>
 #include <utils/String8.h>
 #include <utils/Trace.h>
+#include "GLExtensions.h"
 #include "Program.h"
 
 ANDROID_SINGLETON_STATIC_INSTANCE(android::renderengine::gl::ProgramCache)
@@ -77,6 +86,27 @@ Formatter& dedent(Formatter& f) {
     return f;
 }
 
+/*
+ * Layout of the program binary cache file, all integers in native byte order:
+ * magic, version, fingerprint size, fingerprint, binary count, then for each
+ * binary: key, format, size, data.
+ */
+static const uint32_t kBinaryCacheMagic = 0x42505246; // "FRPB"
+static const uint32_t kBinaryCacheVersion = 1;
+
+static void appendUint32(std::string* out, uint32_t value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static bool readUint32(const std::string& in, size_t* offset, uint32_t* value) {
+    if (in.size() - *offset < sizeof(*value)) {
+        return false;
+    }
+    memcpy(value, in.data() + *offset, sizeof(*value));
+    *offset += sizeof(*value);
+    return true;
+}
+
 void ProgramCache::primeCache(
         EGLContext context, bool useColorManagement, bool toneMapperShaderOnly) {
     auto& cache = mCaches[context];
@@ -102,10 +132,11 @@ void ProgramCache::primeCache(
             shaderKey.set(Key::Y410_BT2020_MASK, (i & 2) ?
                     Key::Y410_BT2020_ON : Key::Y410_BT2020_OFF);
             if (cache.count(shaderKey) == 0) {
-                cache.emplace(shaderKey, generateProgram(shaderKey));
+                cache.emplace(shaderKey, createProgram(shaderKey));
                 shaderCount++;
             }
         }
+        saveBinaryCache();
         return;
     }
 
@@ -123,7 +154,7 @@ void ProgramCache::primeCache(
             continue;
         }
         if (cache.count(shaderKey) == 0) {
-            cache.emplace(shaderKey, generateProgram(shaderKey));
+            cache.emplace(shaderKey, createProgram(shaderKey));
             shaderCount++;
         }
     }
@@ -147,7 +178,7 @@ void ProgramCache::primeCache(
             // Cache texture off option for window transition
             shaderKey.set(Key::TEXTURE_MASK, (i & 8) ? Key::TEXTURE_EXT : Key::TEXTURE_OFF);
             if (cache.count(shaderKey) == 0) {
-                cache.emplace(shaderKey, generateProgram(shaderKey));
+                cache.emplace(shaderKey, createProgram(shaderKey));
                 shaderCount++;
             }
         }
@@ -156,6 +187,7 @@ void ProgramCache::primeCache(
     nsecs_t timeAfter = systemTime();
     float compileTimeMs = static_cast<float>(timeAfter - timeBefore) / 1.0E6;
     ALOGD("shader cache generated - %u shaders in %f ms\n", shaderCount, compileTimeMs);
+    saveBinaryCache();
 }
 
 ProgramCache::Key ProgramCache::computeKey(const Description& description) {
@@ -777,6 +809,123 @@ std::unique_ptr<Program> ProgramCache::generateProgram(const Key& needs) {
     return std::make_unique<Program>(needs, vs.string(), fs.string());
 }
 
+std::unique_ptr<Program> ProgramCache::createProgram(const Key& needs) {
+    auto binary = mBinaries.find(needs);
+    if (binary != mBinaries.end()) {
+        auto program = std::make_unique<Program>(needs, binary->second.format,
+                                                 binary->second.data.data(),
+                                                 binary->second.data.size());
+        if (program->isValid()) {
+            return program;
+        }
+        mBinaries.erase(binary);
+        mBinariesChanged = true;
+    }
+
+    std::unique_ptr<Program> program = generateProgram(needs);
+    if (!mBinaryCachePath.empty() && program->isValid()) {
+        ProgramBinary newBinary;
+        if (program->getBinary(&newBinary.format, &newBinary.data)) {
+            mBinaries[needs] = std::move(newBinary);
+            mBinariesChanged = true;
+        }
+    }
+    return program;
+}
+
+void ProgramCache::setBinaryCachePath(const std::string& path) {
+    if (path == mBinaryCachePath) {
+        return;
+    }
+    mBinaryCachePath = path;
+    mBinaries.clear();
+    mBinariesChanged = false;
+    if (!mBinaryCachePath.empty()) {
+        loadBinaryCache();
+    }
+}
+
+std::string ProgramCache::getBinaryCacheFingerprint() {
+    const GLExtensions& extensions = GLExtensions::getInstance();
+    return base::StringPrintf("%s|%s|%s|%s", extensions.getVendor(), extensions.getRenderer(),
+                              extensions.getVersion(),
+                              base::GetProperty("ro.build.fingerprint", "").c_str());
+}
+
+void ProgramCache::loadBinaryCache() {
+    std::string contents;
+    if (!base::ReadFileToString(mBinaryCachePath, &contents)) {
+        ALOGV("No program binaries saved in %s", mBinaryCachePath.c_str());
+        return;
+    }
+
+    const std::string fingerprint = getBinaryCacheFingerprint();
+    size_t offset = 0;
+    uint32_t magic, version, fingerprintSize, count;
+    if (!readUint32(contents, &offset, &magic) || magic != kBinaryCacheMagic ||
+        !readUint32(contents, &offset, &version) || version != kBinaryCacheVersion ||
+        !readUint32(contents, &offset, &fingerprintSize) ||
+        contents.size() - offset < fingerprintSize ||
+        contents.compare(offset, fingerprintSize, fingerprint) != 0) {
+        ALOGI("Discarding program binaries of another driver or build in %s",
+              mBinaryCachePath.c_str());
+        mBinariesChanged = true;
+        return;
+    }
+    offset += fingerprintSize;
+
+    if (!readUint32(contents, &offset, &count)) {
+        count = 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t key, format, size;
+        if (!readUint32(contents, &offset, &key) || !readUint32(contents, &offset, &format) ||
+            !readUint32(contents, &offset, &size) || contents.size() - offset < size) {
+            ALOGW("Program binary cache %s is truncated", mBinaryCachePath.c_str());
+            mBinaries.clear();
+            mBinariesChanged = true;
+            return;
+        }
+        Key needs;
+        needs.mKey = key;
+        ProgramBinary& binary = mBinaries[needs];
+        binary.format = format;
+        binary.data.assign(contents.begin() + offset, contents.begin() + offset + size);
+        offset += size;
+    }
+    ALOGD("Loaded %zu program binaries from %s", mBinaries.size(), mBinaryCachePath.c_str());
+}
+
+void ProgramCache::saveBinaryCache() {
+    if (mBinaryCachePath.empty() || !mBinariesChanged) {
+        return;
+    }
+    mBinariesChanged = false;
+
+    const std::string fingerprint = getBinaryCacheFingerprint();
+    std::string contents;
+    appendUint32(&contents, kBinaryCacheMagic);
+    appendUint32(&contents, kBinaryCacheVersion);
+    appendUint32(&contents, fingerprint.size());
+    contents.append(fingerprint);
+    appendUint32(&contents, mBinaries.size());
+    for (const auto& [needs, binary] : mBinaries) {
+        appendUint32(&contents, needs.mKey);
+        appendUint32(&contents, binary.format);
+        appendUint32(&contents, binary.data.size());
+        contents.append(reinterpret_cast<const char*>(binary.data.data()), binary.data.size());
+    }
+
+    // replace the file atomically, so that a crash never leaves a partial cache behind
+    const std::string tmpPath = mBinaryCachePath + ".tmp";
+    if (!base::WriteStringToFile(contents, tmpPath) ||
+        rename(tmpPath.c_str(), mBinaryCachePath.c_str()) != 0) {
+        ALOGW("Unable to save program binaries to %s: %s", mBinaryCachePath.c_str(),
+              strerror(errno));
+        unlink(tmpPath.c_str());
+    }
+}
+
 void ProgramCache::useProgram(EGLContext context, const Description& description) {
     // generate the key for the shader based on the description
     Key needs(computeKey(description));
@@ -787,8 +936,9 @@ void ProgramCache::useProgram(EGLContext context, const Description& description
     if (it == cache.end()) {
         // we didn't find our program, so generate one...
         nsecs_t time = systemTime();
-        it = cache.emplace(needs, generateProgram(needs)).first;
+        it = cache.emplace(needs, createProgram(needs)).first;
         time = systemTime() - time;
+        saveBinaryCache();
 
         ALOGV(">>> generated new program for context %p: needs=%08X, time=%u ms (%zu programs)",
               context, needs.mKey, uint32_t(ns2ms(time)), cache.size());
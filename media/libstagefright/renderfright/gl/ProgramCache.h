@@ -18,7 +18,9 @@
 #define SF_RENDER_ENGINE_PROGRAMCACHE_H
 
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
@@ -190,11 +192,23 @@ public:
 
     size_t getSize(const EGLContext context) { return mCaches[context].size(); }
 
+    // Loads the program binaries saved in |path|, and saves the binaries of
+    // programs generated from then on to it. Binaries are only reused with the
+    // GL driver and system build they were saved with.
+    void setBinaryCachePath(const std::string& path);
+
+    size_t getBinaryCacheSize() const { return mBinaries.size(); }
+
     // useProgram lookup a suitable program in the cache or generates one
     // if none can be found.
     void useProgram(const EGLContext context, const Description& description);
 
 private:
+    struct ProgramBinary {
+        GLenum format;
+        std::vector<uint8_t> data;
+    };
+
     // compute a cache Key from a Description
     static Key computeKey(const Description& description);
     // Generate EOTF based from Key.
@@ -211,11 +225,23 @@ private:
     static String8 generateVertexShader(const Key& needs);
     // generates the fragment shader from the Key
     static String8 generateFragmentShader(const Key& needs);
+    // creates a program from its saved binary, or generates it
+    std::unique_ptr<Program> createProgram(const Key& needs);
+    // identifies the driver and build that program binaries are valid for
+    static std::string getBinaryCacheFingerprint();
+    void loadBinaryCache();
+    // writes the binaries out if any were added or dropped
+    void saveBinaryCache();
 
     // Key/Value map used for caching Programs. Currently the cache
     // is never shrunk (and the GL program objects are never deleted).
     std::unordered_map<EGLContext, std::unordered_map<Key, std::unique_ptr<Program>, Key::Hash>>
             mCaches;
+
+    // Program binaries, shared by all contexts. Empty path if not persisted.
+    std::string mBinaryCachePath;
+    std::unordered_map<Key, ProgramBinary, Key::Hash> mBinaries;
+    bool mBinariesChanged = false;
 };
 
 } // namespace gl
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <memory>
+#include <string>
 
 #include <android-base/unique_fd.h>
 #include <math/mat4.h>
@@ -207,6 +208,9 @@ struct RenderEngineCreationArgs {
     RenderEngine::ContextPriority contextPriority;
     RenderEngine::RenderEngineType renderEngineType;
     bool realtime;
+    // File to persist linked GL program binaries in, so that shaders are not
+    // compiled again by later processes. Empty disables the binary cache.
+    std::string programBinaryCachePath;
 
     struct Builder;
 
@@ -217,7 +221,7 @@ private:
                              bool _supportsBackgroundBlur,
                              RenderEngine::ContextPriority _contextPriority,
                              RenderEngine::RenderEngineType _renderEngineType,
-                             bool _realtime)
+                             bool _realtime, const std::string& _programBinaryCachePath)
           : pixelFormat(_pixelFormat),
             imageCacheSize(_imageCacheSize),
             useColorManagement(_useColorManagement),
@@ -226,7 +230,8 @@ private:
             supportsBackgroundBlur(_supportsBackgroundBlur),
             contextPriority(_contextPriority),
             renderEngineType(_renderEngineType),
-            realtime(_realtime) {}
+            realtime(_realtime),
+            programBinaryCachePath(_programBinaryCachePath) {}
     RenderEngineCreationArgs() = delete;
 };
 
@@ -269,11 +274,15 @@ struct RenderEngineCreationArgs::Builder {
         this->realtime = realtime;
         return *this;
     }
+    Builder& setProgramBinaryCachePath(const std::string& programBinaryCachePath) {
+        this->programBinaryCachePath = programBinaryCachePath;
+        return *this;
+    }
     RenderEngineCreationArgs build() const {
         return RenderEngineCreationArgs(pixelFormat, imageCacheSize, useColorManagement,
                                         enableProtectedContext, precacheToneMapperShaderOnly,
                                         supportsBackgroundBlur, contextPriority, renderEngineType,
-                                        realtime);
+                                        realtime, programBinaryCachePath);
     }
 
 private:
@@ -287,6 +296,7 @@ private:
     RenderEngine::ContextPriority contextPriority = RenderEngine::ContextPriority::MEDIUM;
     RenderEngine::RenderEngineType renderEngineType = RenderEngine::RenderEngineType::GLES;
     bool realtime = true;
+    std::string programBinaryCachePath;
 };
 
 class BindNativeBufferAsFramebuffer {
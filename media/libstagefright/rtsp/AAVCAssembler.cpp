@@ -30,11 +30,13 @@
 
 #include <android-base/properties.h>
 
+#include <algorithm>
 #include <stdint.h>
 
 namespace android {
 
 const double JITTER_MULTIPLE = 1.5f;
+static const size_t kMinAccessUnitSize = 64 * 1024;
 
 // static
 AAVCAssembler::AAVCAssembler(const sp<AMessage> &notify)
@@ -47,7 +49,9 @@ AAVCAssembler::AAVCAssembler(const sp<AMessage> &notify)
       mLastCvo(-1),
       mLastIFrameProvidedAtMs(0),
       mWidth(0),
-      mHeight(0) {
+      mHeight(0),
+      mAccessUnitSize(0),
+      mMaxAccessUnitSize(0) {
 }
 
 AAVCAssembler::~AAVCAssembler() {
@@ -367,6 +371,7 @@ void AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
     }
     mAccessUnitRTPTime = rtpTime;
 
+    commitNALUnit(buffer);
     mNALUnits.push_back(buffer);
 }
 
@@ -517,7 +522,13 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
     // header byte.
     ++totalSize;
 
-    sp<ABuffer> unit = new ABuffer(totalSize);
+    // The fragments are written straight into the access unit, which has to
+    // be the one this NAL unit belongs to.
+    if (!mNALUnits.empty() && rtpTimeStartAt != mAccessUnitRTPTime) {
+        submitAccessUnit();
+    }
+
+    sp<ABuffer> unit = reserveNALUnit(totalSize);
     CopyTimes(unit, *queue->begin());
 
     unit->data()[0] = (nri << 5) | nalType;
@@ -562,6 +573,38 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
     return OK;
 }
 
+// Returns a NAL unit of |size| bytes that is backed by the tail of
+// mAccessUnit. It becomes part of the access unit on commitNALUnit().
+sp<ABuffer> AAVCAssembler::reserveNALUnit(size_t size) {
+    size_t needed = mAccessUnitSize + 4 + size;
+    if (mAccessUnit == NULL || mAccessUnit->capacity() < needed) {
+        size_t capacity = std::max(needed + needed / 2,
+                std::max(mMaxAccessUnitSize + mMaxAccessUnitSize / 4, kMinAccessUnitSize));
+
+        sp<ABuffer> accessUnit = new ABuffer(capacity);
+        if (mAccessUnitSize > 0) {
+            memcpy(accessUnit->data(), mAccessUnit->data(), mAccessUnitSize);
+        }
+        mAccessUnit = accessUnit;
+    }
+
+    uint8_t *dst = mAccessUnit->data() + mAccessUnitSize;
+    memcpy(dst, "\x00\x00\x00\x01", 4);
+
+    return new ABuffer(dst + 4, size);
+}
+
+void AAVCAssembler::commitNALUnit(const sp<ABuffer> &nal) {
+    if (mAccessUnit == NULL
+            || nal->data() != mAccessUnit->data() + mAccessUnitSize + 4) {
+        // Not reserved in place, e.g. a single NAL unit packet.
+        sp<ABuffer> dst = reserveNALUnit(nal->size());
+        memcpy(dst->data(), nal->data(), nal->size());
+    }
+
+    mAccessUnitSize += 4 + nal->size();
+}
+
 void AAVCAssembler::submitAccessUnit() {
     CHECK(!mNALUnits.empty());
 
@@ -571,25 +614,19 @@ void AAVCAssembler::submitAccessUnit() {
         ALOGV("Access unit complete (%zu nal units)", mNALUnits.size());
     }
 
-    size_t totalSize = 0;
-    for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
-         it != mNALUnits.end(); ++it) {
-        totalSize += 4 + (*it)->size();
-    }
+    sp<ABuffer> accessUnit = mAccessUnit;
+    accessUnit->setRange(0, mAccessUnitSize);
+
+    mMaxAccessUnitSize = std::max(
+            mAccessUnitSize, mMaxAccessUnitSize - mMaxAccessUnitSize / 16);
+    mAccessUnit.clear();
+    mAccessUnitSize = 0;
 
-    sp<ABuffer> accessUnit = new ABuffer(totalSize);
-    size_t offset = 0;
+    // The NAL units only carry metadata by now, their data is in accessUnit.
     int32_t cvo = -1;
     for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
          it != mNALUnits.end(); ++it) {
-        memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
-        offset += 4;
-
-        sp<ABuffer> nal = *it;
-        memcpy(accessUnit->data() + offset, nal->data(), nal->size());
-        offset += nal->size();
-
-        nal->meta()->findInt32("cvo", &cvo);
+        (*it)->meta()->findInt32("cvo", &cvo);
     }
 
     CopyTimes(accessUnit, *mNALUnits.begin());
@@ -37,8 +37,12 @@
 
 #include <android/multinetwork.h>
 
+#include <algorithm>
+
 #include <arpa/inet.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
+#include <time.h>
 
 namespace android {
 
@@ -60,6 +64,20 @@ static uint64_t u64at(const uint8_t *data) {
     return (uint64_t)(u32at(data)) << 32 | u32at(&data[4]);
 }
 
+// Returns the SO_TIMESTAMPNS receive time of |msg| in CLOCK_REALTIME.
+static bool getReceiveTimeUs(struct msghdr *msg, int64_t *timeUs) {
+    for (struct cmsghdr *cMsg = CMSG_FIRSTHDR(msg); cMsg != NULL;
+            cMsg = CMSG_NXTHDR(msg, cMsg)) {
+        if (cMsg->cmsg_level == SOL_SOCKET && cMsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cMsg), sizeof(ts));
+            *timeUs = ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+            return true;
+        }
+    }
+    return false;
+}
+
 // static
 const int64_t ARTPConnection::kSelectTimeoutUs = 1000LL;
 const int64_t ARTPConnection::kMinOneSecondNotifyDelayUs = 100000ll;
@@ -95,10 +113,16 @@ ARTPConnection::ARTPConnection(uint32_t flags)
       mTargetBitrate(-1),
       mRtpSockOptEcn(0),
       mIsIPv6(false),
-      mStaticJitterTimeMs(kStaticJitterTimeMs) {
+      mStaticJitterTimeMs(kStaticJitterTimeMs),
+      mEpollFd(-1),
+      mRecvBuffer(NULL) {
 }
 
 ARTPConnection::~ARTPConnection() {
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+    }
+    delete[] mRecvBuffer;
 }
 
 void ARTPConnection::addStream(
@@ -397,6 +421,29 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
     }
 
     if (!injected) {
+        if (mEpollFd < 0) {
+            mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (mEpollFd < 0) {
+                ALOGE("failed to create epoll fd (%s)", strerror(errno));
+            }
+        }
+
+        // receive() uses the kernel receive time as the arrival time
+        int enable = 1;
+        if (setsockopt(info->mRTPSocket, SOL_SOCKET, SO_TIMESTAMPNS,
+                &enable, sizeof(enable)) < 0) {
+            ALOGW("failed to enable receive timestamps (%s)", strerror(errno));
+        }
+
+        for (int fd : { info->mRTPSocket, info->mRTCPSocket }) {
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (mEpollFd >= 0 && epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                ALOGE("failed to poll socket %d (%s)", fd, strerror(errno));
+            }
+        }
+
         postPollEvent();
     }
 }
@@ -428,9 +475,18 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
         return;
     }
 
+    removeFromPoll(&*it);
     mStreams.erase(it);
 }
 
+void ARTPConnection::removeFromPoll(const StreamInfo *s) {
+    if (s->mIsInjected || mEpollFd < 0) {
+        return;
+    }
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, s->mRTPSocket, NULL);
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, s->mRTCPSocket, NULL);
+}
+
 void ARTPConnection::postPollEvent() {
     if (mPollEventPending) {
         return;
@@ -449,37 +505,23 @@ void ARTPConnection::onPollStreams() {
         return;
     }
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = kSelectTimeoutUs;
-
-    fd_set rs;
-    FD_ZERO(&rs);
-
-    int maxSocket = -1;
-    for (List<StreamInfo>::iterator it = mStreams.begin();
-         it != mStreams.end(); ++it) {
-        if ((*it).mIsInjected) {
-            continue;
-        }
-
-        FD_SET(it->mRTPSocket, &rs);
-        FD_SET(it->mRTCPSocket, &rs);
-
-        if (it->mRTPSocket > maxSocket) {
-            maxSocket = it->mRTPSocket;
-        }
-        if (it->mRTCPSocket > maxSocket) {
-            maxSocket = it->mRTCPSocket;
-        }
-    }
-
-    if (maxSocket == -1) {
+    if (mEpollFd < 0) {
         return;
     }
 
     int64_t nowUs = ALooper::GetNowUs();
-    int res = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+
+    // Only the sockets that are readable are reported, not one per stream.
+    struct epoll_event events[kMaxPollEvents];
+    int res = epoll_wait(mEpollFd, events, NELEM(events), kSelectTimeoutUs / 1000);
+    auto isReadable = [&events, res](int socket) {
+        for (int i = 0; i < res; ++i) {
+            if (events[i].data.fd == socket) {
+                return true;
+            }
+        }
+        return false;
+    };
 
     if (res > 0) {
         List<StreamInfo>::iterator it = mStreams.begin();
@@ -491,10 +533,10 @@ void ARTPConnection::onPollStreams() {
             it->mLastPollTimeUs = nowUs;
 
             status_t err = OK;
-            if (FD_ISSET(it->mRTPSocket, &rs)) {
+            if (isReadable(it->mRTPSocket)) {
                 err = receive(&*it, true);
             }
-            if (err == OK && FD_ISSET(it->mRTCPSocket, &rs)) {
+            if (err == OK && isReadable(it->mRTCPSocket)) {
                 err = receive(&*it, false);
             }
 
@@ -510,6 +552,7 @@ void ARTPConnection::onPollStreams() {
 
                     ALOGW("failed to receive RTP/RTCP datagram.");
                 }
+                removeFromPoll(&*it);
                 it = mStreams.erase(it);
                 continue;
             }
@@ -619,31 +662,35 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
+    if (mRecvBuffer == NULL) {
+        mRecvBuffer = new uint8_t[kMaxRecvBatch * kMaxRecvSize];
+    }
 
-    struct msghdr sMsg = {};
-    struct iovec sIov[1] = {};
+    // Room for the TOS header and the SO_TIMESTAMPNS receive time.
+    const size_t kControlSize = CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec));
 
-    sIov[0].iov_base = (char *) buffer->data();
-    sIov[0].iov_len = buffer->capacity();
+    struct mmsghdr sMsgs[kMaxRecvBatch] = {};
+    struct iovec sIov[kMaxRecvBatch] = {};
+    char control[kMaxRecvBatch][kControlSize];
 
-    sMsg.msg_iov = sIov;
-    sMsg.msg_iovlen = 1;
+    for (size_t i = 0; i < kMaxRecvBatch; ++i) {
+        sIov[i].iov_base = mRecvBuffer + i * kMaxRecvSize;
+        sIov[i].iov_len = kMaxRecvSize;
 
-    int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
-    char buf[CMSG_SPACE(cMsgSize)];
-    sMsg.msg_control = buf;
-    sMsg.msg_controllen = sizeof(buf);
-    sMsg.msg_flags = 0;
+        sMsgs[i].msg_hdr.msg_iov = &sIov[i];
+        sMsgs[i].msg_hdr.msg_iovlen = 1;
+        sMsgs[i].msg_hdr.msg_control = control[i];
+        sMsgs[i].msg_hdr.msg_controllen = kControlSize;
+    }
 
-    ssize_t nbytes;
+    int count;
     do {
-        // Used recvmsg to get the TOS header of incoming packet
-        nbytes = recvmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket, &sMsg, 0);
-        mCumulativeBytes += nbytes;
-    } while (nbytes < 0 && errno == EINTR);
+        // Used recvmmsg to get the TOS header of incoming packets
+        count = recvmmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket,
+                sMsgs, kMaxRecvBatch, MSG_DONTWAIT, NULL);
+    } while (count < 0 && errno == EINTR);
 
-    if (nbytes <= 0) {
+    if (count <= 0) {
         ALOGW("failed to recv rtp packet. cause=%s", strerror(errno));
         // ECONNREFUSED may happen in next recvfrom() calling if one of
         // outgoing packet can not be delivered to remote by using sendto()
@@ -654,19 +701,38 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
         }
     }
 
-    if (nbytes > 0) {
-        handleIpHeadersIfReceived(s, sMsg);
-    }
+    // Kernel receive times are CLOCK_REALTIME; ALooper runs on the monotonic clock.
+    struct timespec realNow;
+    clock_gettime(CLOCK_REALTIME, &realNow);
+    int64_t nowUs = ALooper::GetNowUs();
+    int64_t realNowUs = realNow.tv_sec * 1000000LL + realNow.tv_nsec / 1000;
+
+    status_t err = OK;
+    for (int i = 0; i < count && err == OK; ++i) {
+        size_t nbytes = sMsgs[i].msg_len;
+        mCumulativeBytes += nbytes;
+        if (nbytes == 0) {
+            continue;
+        }
 
-    buffer->setRange(0, nbytes);
+        handleIpHeadersIfReceived(s, sMsgs[i].msg_hdr);
 
-    // ALOGI("received %d bytes.", buffer->size());
+        sp<ABuffer> buffer = new ABuffer(nbytes);
+        memcpy(buffer->data(), sIov[i].iov_base, nbytes);
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+        int64_t receiveTimeUs;
+        if (getReceiveTimeUs(&sMsgs[i].msg_hdr, &receiveTimeUs)) {
+            int64_t arrivalTimeUs = nowUs - (realNowUs - receiveTimeUs);
+            buffer->meta()->setInt64("arrival-time-us", std::min(arrivalTimeUs, nowUs));
+        }
+
+        // ALOGI("received %d bytes.", buffer->size());
+
+        if (receiveRTP) {
+            err = parseRTP(s, buffer);
+        } else {
+            err = parseRTCP(s, buffer);
+        }
     }
 
     return err;
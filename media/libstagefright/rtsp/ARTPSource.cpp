@@ -264,6 +264,8 @@ void ARTPSource::adjustAnchorTimeIfRequired(int64_t nowUs) {
 
 bool ARTPSource::queuePacket(const sp<ABuffer> &buffer) {
     int64_t nowUs = ALooper::GetNowUs();
+    // Prefer the kernel receive time so that polling latency is not counted as jitter.
+    buffer->meta()->findInt64("arrival-time-us", &nowUs);
     int64_t rtpTime = 0;
     uint32_t seqNum = (uint32_t)buffer->int32Data();
     int32_t ssrc = 0;
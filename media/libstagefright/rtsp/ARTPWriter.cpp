@@ -28,9 +28,15 @@
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaData.h>
+#include <cutils/properties.h>
 #include <utils/ByteOrder.h>
+#include <utils/String8.h>
+
+#include <algorithm>
 
 #include <fcntl.h>
+#include <inttypes.h>
+#include <netinet/udp.h>
 #include <strings.h>
 
 #define PT      97
@@ -58,6 +64,13 @@
 #define RTP_FU_HEADER_SIZE 2
 #define RTP_PAYLOAD_ROOM_SIZE 100 // ROOM size for IPv6 header, ESP and etc.
 
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
 
 namespace android {
 
@@ -68,6 +81,15 @@ static char kCNAME[255] = "someone@somewhere";
 static const size_t kTrafficRecorderMaxEntries = 128;
 static const size_t kTrafficRecorderMaxTimeSpanMs = 2000;
 
+// Packets per sendmmsg(), and per UDP GSO send (the kernel limit is 64).
+static const size_t kMaxBatchPackets = 64;
+static const size_t kMaxGSOBytes = 65000;
+// With pacing a NAL unit leaves in bursts of kPacedBatchPackets, at most
+// kMaxPacingGapUs apart and kMaxPacingSpanUs in total.
+static const size_t kPacedBatchPackets = 8;
+static const int64_t kMaxPacingGapUs = 1000;
+static const int64_t kMaxPacingSpanUs = 10000;
+
 static int UniformRand(int limit) {
     return ((double)rand() * limit) / RAND_MAX;
 }
@@ -205,6 +227,12 @@ void ARTPWriter::initState() {
     mNumRTPSent = 0;
     mNumRTPOctetsSent = 0;
 
+    mPendingRTP.clear();
+    mGSOEnabled = true;
+    mPacingEnabled = property_get_bool("media.rtp.writer.pacing", false);
+    mNumFramesSent = 0;
+    mNumSendCalls = 0;
+
     mOpponentID = 0;
     mBitrate = 192000;
 
@@ -586,6 +614,7 @@ void ARTPWriter::onRead(const sp<AMessage> &msg) {
 
     if (mediaBuf->range_length() > 0) {
         ALOGV("read buffer of size %zu", mediaBuf->range_length());
+        ++mNumFramesSent;
 
         if (mMode == H264) {
             StripStartcode(mediaBuf);
@@ -650,6 +679,7 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
 
     ssize_t n = sendto(isRTCP ? mRTCPSocket : mRTPSocket,
             buffer->data(), buffer->size(), 0, remAddr, sizeSockSt);
+    ++mNumSendCalls;
 
     if (n != (ssize_t)buffer->size()) {
         ALOGW("packets can not be sent. ret=%d, buf=%d", (int)n, (int)buffer->size());
@@ -671,6 +701,159 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
 #endif
 }
 
+void ARTPWriter::queueRTP(const sp<ABuffer> &buffer) {
+    mPendingRTP.push_back(buffer);
+}
+
+void ARTPWriter::flushRTP() {
+    size_t total = mPendingRTP.size();
+    size_t batch = mPacingEnabled ? kPacedBatchPackets : kMaxBatchPackets;
+    int64_t gapUs = 0;
+    if (mPacingEnabled && total > batch) {
+        size_t numBatches = (total + batch - 1) / batch;
+        gapUs = std::min(kMaxPacingGapUs, kMaxPacingSpanUs / (int64_t)(numBatches - 1));
+    }
+
+    for (size_t first = 0; first < total; first += batch) {
+        if (first > 0 && gapUs > 0) {
+            usleep(gapUs);
+        }
+
+        size_t count = std::min(batch, total - first);
+        size_t sent = sendRTPBatch(first, count);
+        if (sent != count) {
+            ALOGW("packets can not be sent. sent=%zu, batch=%zu", sent, count);
+        }
+    }
+
+    mPendingRTP.clear();
+    mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
+}
+
+// Sends mPendingRTP[first, first + count) and returns how many packets went out.
+size_t ARTPWriter::sendRTPBatch(size_t first, size_t count) {
+    struct sockaddr *remAddr = mIsIPv6
+            ? (struct sockaddr *)&mRTPAddr6 : (struct sockaddr *)&mRTPAddr;
+    socklen_t sizeSockSt = mIsIPv6
+            ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+
+    struct iovec iov[kMaxBatchPackets];
+    struct mmsghdr msgs[kMaxBatchPackets];
+    memset(msgs, 0, sizeof(msgs));
+
+    for (size_t i = 0; i < count; ++i) {
+        const sp<ABuffer> &buffer = mPendingRTP[first + i];
+        iov[i].iov_base = buffer->data();
+        iov[i].iov_len = buffer->size();
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+        // FU-A fragments are equally sized up to the last one, which is
+        // what UDP GSO needs to cut one buffer back into datagrams.
+        size_t segment = iov[sent].iov_len;
+        size_t numSegments = 1;
+        size_t bytes = segment;
+        while (mGSOEnabled && sent + numSegments < count
+                && bytes + iov[sent + numSegments].iov_len <= kMaxGSOBytes) {
+            size_t size = iov[sent + numSegments].iov_len;
+            if (size > segment) {
+                break;
+            }
+            bytes += size;
+            ++numSegments;
+            if (size < segment) {
+                break;
+            }
+        }
+
+        if (numSegments > 1) {
+            char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+            struct msghdr msg = {};
+            msg.msg_name = remAddr;
+            msg.msg_namelen = sizeSockSt;
+            msg.msg_iov = &iov[sent];
+            msg.msg_iovlen = numSegments;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            struct cmsghdr *cMsg = CMSG_FIRSTHDR(&msg);
+            cMsg->cmsg_level = SOL_UDP;
+            cMsg->cmsg_type = UDP_SEGMENT;
+            cMsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segmentSize = segment;
+            memcpy(CMSG_DATA(cMsg), &segmentSize, sizeof(segmentSize));
+
+            ssize_t n;
+            do {
+                n = sendmsg(mRTPSocket, &msg, 0);
+            } while (n < 0 && errno == EINTR);
+            ++mNumSendCalls;
+
+            if (n < 0 && (errno == EIO || errno == EINVAL
+                    || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+                ALOGI("UDP GSO is not available (%s), using sendmmsg", strerror(errno));
+                mGSOEnabled = false;
+                continue;
+            }
+
+            if (n != (ssize_t)bytes) {
+                ALOGW("GSO send failed. ret=%d, bytes=%zu", (int)n, bytes);
+                break;
+            }
+
+            for (size_t i = 0; i < numSegments; ++i) {
+                onRTPSent(mPendingRTP[first + sent + i]);
+            }
+            sent += numSegments;
+            continue;
+        }
+
+        size_t numMsgs = count - sent;
+        if (mGSOEnabled) {
+            // Only this packet, the rest may form another GSO send.
+            numMsgs = 1;
+        }
+        for (size_t i = 0; i < numMsgs; ++i) {
+            msgs[i].msg_hdr.msg_name = remAddr;
+            msgs[i].msg_hdr.msg_namelen = sizeSockSt;
+            msgs[i].msg_hdr.msg_iov = &iov[sent + i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n;
+        do {
+            n = sendmmsg(mRTPSocket, msgs, numMsgs, 0);
+        } while (n < 0 && errno == EINTR);
+        ++mNumSendCalls;
+
+        if (n <= 0) {
+            ALOGW("sendmmsg failed (%s)", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            onRTPSent(mPendingRTP[first + sent + i]);
+        }
+        sent += n;
+    }
+
+    return sent;
+}
+
+void ARTPWriter::onRTPSent(const sp<ABuffer> &buffer) {
+    mTrafficRec->writeBytes(buffer->size() +
+            (mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE));
+
+#if LOG_TO_FILES
+    uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
+    uint32_t length = tolel(buffer->size());
+    write(mRTPFd, &ms, sizeof(ms));
+    write(mRTPFd, &length, sizeof(length));
+    write(mRTPFd, buffer->data(), buffer->size());
+#endif
+}
+
 void ARTPWriter::addSR(const sp<ABuffer> &buffer) {
     uint8_t *data = buffer->data() + buffer->size();
 
@@ -1198,7 +1381,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 15 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTP(buffer);
 
             ++mSeqNo;
             ++mNumRTPSent;
@@ -1206,7 +1389,14 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
             firstPacket = false;
             offset += size;
+
+            if (!lastPacket) {
+                // the queued fragment keeps its own buffer until flushRTP()
+                buffer = new ABuffer(kMaxPacketSize);
+            }
         }
+
+        flushRTP();
     }
 }
 
@@ -1382,7 +1572,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 14 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTP(buffer);
 
             ++mSeqNo;
             ++mNumRTPSent;
@@ -1390,7 +1580,14 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
             firstPacket = false;
             offset += size;
+
+            if (!lastPacket) {
+                // the queued fragment keeps its own buffer until flushRTP()
+                buffer = new ABuffer(kMaxPacketSize);
+            }
         }
+
+        flushRTP();
     }
 }
 
@@ -1516,6 +1713,26 @@ uint64_t ARTPWriter::getAccumulativeBytes() {
     return mTrafficRec->readBytesForTotal();
 }
 
+status_t ARTPWriter::dump(
+        int fd, const Vector<String16>& /* args */) {
+    const size_t SIZE = 256;
+    char buffer[SIZE];
+    String8 result;
+    snprintf(buffer, SIZE, "   ARTPWriter %p\n", this);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     RTP packets sent : %u\n", mNumRTPSent);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     send calls : %" PRIu64 " for %" PRIu64 " frames (%.2f per frame)\n",
+            mNumSendCalls, mNumFramesSent,
+            mNumFramesSent > 0 ? (double)mNumSendCalls / mNumFramesSent : 0.0);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     UDP GSO: %s, pacing: %s\n",
+            mGSOEnabled ? "true" : "false", mPacingEnabled ? "true" : "false");
+    result.append(buffer);
+    ::write(fd, result.string(), result.size());
+    return OK;
+}
+
 static size_t getFrameSize(bool isWide, unsigned FT) {
     static const size_t kFrameSizeNB[8] = {
         95, 103, 118, 134, 148, 159, 204, 244
@@ -54,6 +54,13 @@ private:
     int32_t mHeight;
     List<sp<ABuffer> > mNALUnits;
 
+    // Annex B access unit the NAL units are written into as they complete,
+    // so that submitAccessUnit() hands it on without another copy. It is
+    // sized from a decaying maximum of the recent access unit sizes.
+    sp<ABuffer> mAccessUnit;
+    size_t mAccessUnitSize;
+    size_t mMaxAccessUnitSize;
+
     int32_t addNack(const sp<ARTPSource> &source);
     void checkSpsUpdated(const sp<ABuffer> &buffer);
     void checkIFrameProvided(const sp<ABuffer> &buffer);
@@ -63,6 +70,8 @@ private:
     AssemblyStatus addFragmentedNALUnit(List<sp<ABuffer> > *queue);
     bool addSingleTimeAggregationPacket(const sp<ABuffer> &buffer);
 
+    sp<ABuffer> reserveNALUnit(size_t size);
+    void commitNALUnit(const sp<ABuffer> &nal);
     void submitAccessUnit();
 
     int32_t pickStartSeq(const Queue *q, uint32_t first, int64_t play, int64_t jit);
@@ -82,6 +82,9 @@ private:
 
     static const int64_t kSelectTimeoutUs;
     static const int64_t kMinOneSecondNotifyDelayUs;
+    static const size_t kMaxPollEvents = 16;
+    static const size_t kMaxRecvBatch = 8;
+    static const size_t kMaxRecvSize = 65536;
 
     uint32_t mFlags;
 
@@ -103,6 +106,11 @@ private:
 
     int32_t mCumulativeBytes;
 
+    // Polls the sockets of all streams that are not injected.
+    int mEpollFd;
+    // Datagrams of a single receive() call, kMaxRecvBatch of kMaxRecvSize.
+    uint8_t *mRecvBuffer;
+
     void onAddStream(const sp<AMessage> &msg);
     void onSeekStream(const sp<AMessage> &msg);
     void onRemoveStream(const sp<AMessage> &msg);
@@ -113,6 +121,7 @@ private:
     void checkRxBitrate(int64_t nowUs);
     void notifyCongestionToUpperLayerIfNeeded(StreamInfo *s);
     void handleIpHeadersIfReceived(StreamInfo *s, struct msghdr sMsg);
+    void removeFromPoll(const StreamInfo *s);
 
     status_t receive(StreamInfo *info, bool receiveRTP);
     ssize_t send(const StreamInfo *info, const sp<ABuffer> buffer);
@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/base64.h>
 #include <media/stagefright/MediaWriter.h>
+#include <utils/Vector.h>
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -54,6 +55,7 @@ struct ARTPWriter : public MediaWriter {
     void updateSocketNetwork(int64_t socketNetwork);
     uint32_t getSequenceNum();
     virtual uint64_t getAccumulativeBytes() override;
+    virtual status_t dump(int fd, const Vector<String16>& args) override;
 
     virtual void onMessageReceived(const sp<AMessage> &msg);
     virtual void setTMMBNInfo(uint32_t opponentID, uint32_t bitrate);
@@ -117,6 +119,13 @@ private:
     uint32_t mNumRTPSent;
     uint32_t mNumRTPOctetsSent;
 
+    // FU-A fragments of the current NAL unit, sent together by flushRTP().
+    Vector<sp<ABuffer> > mPendingRTP;
+    bool mGSOEnabled;
+    bool mPacingEnabled;
+    uint64_t mNumFramesSent;
+    uint64_t mNumSendCalls;
+
     uint32_t mOpponentID;
     uint32_t mBitrate;
     typedef uint64_t Bytes;
@@ -158,6 +167,10 @@ private:
     void sendAMRData(MediaBufferBase *mediaBuf);
 
     void send(const sp<ABuffer> &buffer, bool isRTCP);
+    void queueRTP(const sp<ABuffer> &buffer);
+    void flushRTP();
+    size_t sendRTPBatch(size_t first, size_t count);
+    void onRTPSent(const sp<ABuffer> &buffer);
     void makeSocketPairAndBind(String8& localIp, int localPort, String8& remoteIp, int remotePort);
 
     void ModerateInstantTraffic(uint32_t samplePeriod, uint32_t limitBytes);
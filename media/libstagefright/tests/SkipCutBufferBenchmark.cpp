@@ -0,0 +1,65 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/SkipCutBuffer.h>
+
+using namespace android;
+
+// AAC like output: 1024 frame buffers with 2112 frames of decoder delay and some padding.
+static constexpr size_t kFramesPerBuffer = 1024;
+static constexpr size_t kSkipFrames = 2112;
+static constexpr size_t kCutFrames = 576;
+
+// Args: channel count, bytes of headroom in front of the data.
+static void BM_Submit(benchmark::State& state) {
+    const size_t channels = state.range(0);
+    const size_t headroom = state.range(1);
+    const size_t length = kFramesPerBuffer * channels * 2;
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(kSkipFrames, kCutFrames, channels);
+    sp<ABuffer> buffer = new ABuffer(headroom + length);
+    for (auto _ : state) {
+        buffer->setRange(headroom, length);
+        skipCut->submit(buffer);
+        benchmark::DoNotOptimize(buffer->data());
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+
+// Alternates between stereo and 5.1 output every 64 buffers, as on a format change.
+static void BM_SubmitWithFrameSizeChanges(benchmark::State& state) {
+    const size_t maxLength = kFramesPerBuffer * 6 * 2;
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(kSkipFrames, kCutFrames, 2);
+    sp<ABuffer> buffer = new ABuffer(maxLength);
+    size_t count = 0;
+    size_t channels = 2;
+    for (auto _ : state) {
+        if (++count % 64 == 0) {
+            channels = channels == 2 ? 6 : 2;
+            skipCut->reset(kSkipFrames, kCutFrames, channels);
+        }
+        buffer->setRange(0, kFramesPerBuffer * channels * 2);
+        skipCut->submit(buffer);
+        benchmark::DoNotOptimize(buffer->data());
+    }
+}
+
+BENCHMARK(BM_Submit)->Args({2, 0})->Args({2, kCutFrames * 2 * 2})->Args({6, 0});
+BENCHMARK(BM_SubmitWithFrameSizeChanges);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "SkipCutBuffer_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/SkipCutBuffer.h>
+
+#include <vector>
+
+namespace android {
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrameSize = kChannels * 2;
+
+class SkipCutBufferTest : public ::testing::Test {
+protected:
+    // Submits frameCount frames of the running byte pattern at the given offset of a buffer with
+    // room for extraFrames more frames, and appends the result to mOutput.
+    void submit(const sp<SkipCutBuffer> &skipCut, size_t frameCount, size_t offsetFrames,
+                size_t extraFrames = 0) {
+        const size_t length = frameCount * kFrameSize;
+        const size_t offset = offsetFrames * kFrameSize;
+        sp<ABuffer> buffer = new ABuffer(offset + length + extraFrames * kFrameSize);
+        for (size_t i = 0; i < length; i++) {
+            buffer->base()[offset + i] = mNextByte++;
+        }
+        buffer->setRange(offset, length);
+        skipCut->submit(buffer);
+        ASSERT_LE(buffer->offset() + buffer->size(), buffer->capacity());
+        mOutput.insert(mOutput.end(), buffer->data(), buffer->data() + buffer->size());
+        mLastBuffer = buffer;
+    }
+
+    // Checks that mOutput is the byte pattern from firstByte on.
+    void expectPattern(size_t firstByte, size_t length) {
+        ASSERT_EQ(length, mOutput.size());
+        for (size_t i = 0; i < length; i++) {
+            ASSERT_EQ(uint8_t(firstByte + i), mOutput[i]) << "at byte " << i;
+        }
+    }
+
+    uint8_t mNextByte = 0;
+    std::vector<uint8_t> mOutput;
+    sp<ABuffer> mLastBuffer;
+};
+
+TEST_F(SkipCutBufferTest, SkipsAndCuts) {
+    constexpr size_t kSkip = 300;
+    constexpr size_t kCut = 500;
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(kSkip, kCut, kChannels);
+    size_t inputFrames = 0;
+    for (size_t frames : {100, 1024, 1, 700, 1024, 0, 333, 1024}) {
+        submit(skipCut, frames, 0);
+        inputFrames += frames;
+    }
+    expectPattern(kSkip * kFrameSize, (inputFrames - kSkip - kCut) * kFrameSize);
+    EXPECT_EQ(kCut * kFrameSize, skipCut->size());
+}
+
+TEST_F(SkipCutBufferTest, TrimsInPlaceWithRoomInFront) {
+    constexpr size_t kCut = 100;
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(0, kCut, kChannels);
+    submit(skipCut, 1024, 0);
+    // The held back frames are put in front of the data, which does not move.
+    submit(skipCut, 1024, kCut);
+    EXPECT_EQ(0u, mLastBuffer->offset());
+    EXPECT_EQ(1024 * kFrameSize, mLastBuffer->size());
+    submit(skipCut, 1024, 2 * kCut);
+    EXPECT_EQ(kCut * kFrameSize, mLastBuffer->offset());
+    expectPattern(0, (3 * 1024 - kCut) * kFrameSize);
+}
+
+TEST_F(SkipCutBufferTest, SmallBuffers) {
+    constexpr size_t kCut = 64;
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(0, kCut, kChannels);
+    // The first buffers are smaller than the cut and come out empty.
+    for (size_t i = 0; i < 20; i++) {
+        submit(skipCut, 10, 0);
+    }
+    submit(skipCut, 16, 0);
+    EXPECT_EQ(16 * kFrameSize, mLastBuffer->size());
+    submit(skipCut, 16, 0, 200);
+    submit(skipCut, 512, 0);
+    expectPattern(0, (20 * 10 + 16 + 16 + 512 - kCut) * kFrameSize);
+    EXPECT_EQ(kCut * kFrameSize, skipCut->size());
+}
+
+TEST_F(SkipCutBufferTest, ResetForNewFrameSize) {
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(10, 100, kChannels);
+    submit(skipCut, 1024, 0);
+    EXPECT_EQ(100 * kFrameSize, skipCut->size());
+
+    // Mono now: the held data is dropped and the skip starts over, in frames of 2 bytes.
+    skipCut->reset(20, 50, 1);
+    EXPECT_EQ(0u, skipCut->size());
+    mOutput.clear();
+    const size_t first = mNextByte;
+    for (size_t i = 0; i < 4; i++) {
+        submit(skipCut, 256, 0);
+    }
+    // Each submit above is 256 stereo frames, i.e. 512 mono frames.
+    expectPattern(first + 20 * 2, (4 * 256 * kFrameSize) - (20 + 50) * 2);
+    EXPECT_EQ(50u * 2, skipCut->size());
+
+    // Out of range parameters switch to passthrough.
+    skipCut->reset(0, 10, 0);
+    mOutput.clear();
+    submit(skipCut, 16, 3);
+    EXPECT_EQ(3 * kFrameSize, mLastBuffer->offset());
+    EXPECT_EQ(16 * kFrameSize, mLastBuffer->size());
+}
+
+TEST_F(SkipCutBufferTest, Clear) {
+    sp<SkipCutBuffer> skipCut = new SkipCutBuffer(8, 32, kChannels);
+    submit(skipCut, 100, 0);
+    skipCut->clear();
+    EXPECT_EQ(0u, skipCut->size());
+    mOutput.clear();
+    const size_t first = mNextByte;
+    submit(skipCut, 100, 0);
+    expectPattern(first + 8 * kFrameSize, (100 - 8 - 32) * kFrameSize);
+}
+
+}  // namespace android
@@ -20,6 +20,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <android-base/file.h>
 #include <gui/Surface.h>
 #include <mediadrm/ICrypto.h>
 #include <media/stagefright/CodecBase.h>
@@ -441,3 +442,54 @@ TEST(MediaCodecTest, DeadWhileStoppingError) {
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     looper->stop();
 }
+
+TEST(MediaCodecListWriterTest, CacheRoundTrip) {
+    static const char *kFingerprint = "test-fingerprint";
+    TemporaryDir dir;
+    std::string path = std::string(dir.path) + "/codec_list.cache";
+
+    std::shared_ptr<MediaCodecListWriter> writer = MediaTestHelper::CreateCodecListWriter();
+    {
+        std::unique_ptr<MediaCodecInfoWriter> infoWriter = writer->addMediaCodecInfo();
+        infoWriter->setName("test.codec");
+        infoWriter->setOwner("nobody");
+        infoWriter->addAlias("test.codec.alias");
+        infoWriter->setRank(0x123);
+        std::unique_ptr<MediaCodecInfo::CapabilitiesWriter> caps =
+                infoWriter->addMediaType("video/x-test");
+        caps->addDetail("size-range", "2x2-64x64");
+        caps->addProfileLevel(1, 2);
+    }
+    ASSERT_EQ(OK, MediaTestHelper::SaveCodecListCache(writer, path.c_str(), kFingerprint));
+
+    std::shared_ptr<MediaCodecListWriter> stale = MediaTestHelper::CreateCodecListWriter();
+    EXPECT_EQ(NAME_NOT_FOUND,
+              MediaTestHelper::LoadCodecListCache(stale, path.c_str(), "other-fingerprint"));
+    std::vector<sp<MediaCodecInfo>> staleInfos;
+    MediaTestHelper::WriteCodecInfos(stale, &staleInfos);
+    EXPECT_TRUE(staleInfos.empty());
+
+    std::shared_ptr<MediaCodecListWriter> cached = MediaTestHelper::CreateCodecListWriter();
+    ASSERT_EQ(OK, MediaTestHelper::LoadCodecListCache(cached, path.c_str(), kFingerprint));
+    std::vector<sp<MediaCodecInfo>> infos;
+    MediaTestHelper::WriteCodecInfos(cached, &infos);
+    ASSERT_EQ(1u, infos.size());
+    const sp<MediaCodecInfo> &info = infos[0];
+    EXPECT_STREQ("test.codec", info->getCodecName());
+    EXPECT_STREQ("nobody", info->getOwnerName());
+    EXPECT_EQ(0x123u, info->getRank());
+    Vector<AString> aliases;
+    info->getAliases(&aliases);
+    ASSERT_EQ(1u, aliases.size());
+    EXPECT_EQ(AString("test.codec.alias"), aliases[0]);
+    sp<MediaCodecInfo::Capabilities> caps = info->getCapabilitiesFor("video/x-test");
+    ASSERT_NE(nullptr, caps);
+    AString sizeRange;
+    EXPECT_TRUE(caps->getDetails()->findString("size-range", &sizeRange));
+    EXPECT_EQ(AString("2x2-64x64"), sizeRange);
+    Vector<MediaCodecInfo::ProfileLevel> profileLevels;
+    caps->getSupportedProfileLevels(&profileLevels);
+    ASSERT_EQ(1u, profileLevels.size());
+    EXPECT_EQ(1u, profileLevels[0].mProfile);
+    EXPECT_EQ(2u, profileLevels[0].mLevel);
+}
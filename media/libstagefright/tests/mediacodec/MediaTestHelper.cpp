@@ -52,4 +52,18 @@ void MediaTestHelper::WriteCodecInfos(
     writer->writeCodecInfos(codecInfos);
 }
 
+// static
+status_t MediaTestHelper::SaveCodecListCache(
+        const std::shared_ptr<MediaCodecListWriter> &writer,
+        const char *path, const std::string &fingerprint) {
+    return writer->saveCache(path, fingerprint);
+}
+
+// static
+status_t MediaTestHelper::LoadCodecListCache(
+        const std::shared_ptr<MediaCodecListWriter> &writer,
+        const char *path, const std::string &fingerprint) {
+    return writer->loadCache(path, fingerprint);
+}
+
 }  // namespace android
@@ -18,6 +18,8 @@
 
 #define MEDIA_TEST_HELPER_H_
 
+#include <string>
+
 #include <media/stagefright/foundation/AString.h>
 #include <utils/StrongPointer.h>
 
@@ -44,6 +46,12 @@ public:
     static void WriteCodecInfos(
             const std::shared_ptr<MediaCodecListWriter> &writer,
             std::vector<sp<MediaCodecInfo>> *codecInfos);
+    static status_t SaveCodecListCache(
+            const std::shared_ptr<MediaCodecListWriter> &writer,
+            const char *path, const std::string &fingerprint);
+    static status_t LoadCodecListCache(
+            const std::shared_ptr<MediaCodecListWriter> &writer,
+            const char *path, const std::string &fingerprint);
 };
 
 }  // namespace android
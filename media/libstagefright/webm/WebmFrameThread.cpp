@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "WebmFrameThread"
 
+#include "EbmlUtil.h"
 #include "WebmConstants.h"
 #include "WebmFrameThread.h"
 
@@ -24,7 +25,11 @@
 #include <media/stagefright/foundation/ADebug.h>
 
 #include <utils/Log.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <linux/falloc.h>
+#include <unistd.h>
 
 using namespace webm;
 
@@ -67,6 +72,145 @@ WebmFrameSourceThread::WebmFrameSourceThread(
 
 //=================================================================================================
 
+// File space is preallocated in steps of this size, as clusters are written.
+static const uint64_t kPreallocationSize = 16 * 1024 * 1024;
+
+// The cues written while recording start with a 4-byte id and a size of fixed 8-byte width, so
+// that cue points can be added without moving them.
+static const size_t kCuesHeaderSize = 4 + 8;
+
+WebmClusterWriterThread::WebmClusterWriterThread(
+        int fd, uint64_t offset, uint64_t cuesOffset, uint64_t cuesSpace)
+    : mFd(fd),
+      mCuesOffset(cuesOffset),
+      mCuesSpace(cuesSpace),
+      mOffset(offset),
+      mAllocatedOffset(offset),
+      mCuesSize(0),
+      mCuesFull(cuesSpace < kCuesHeaderSize),
+      mError(OK) {
+}
+
+void WebmClusterWriterThread::write(const sp<ABuffer>& cluster, const sp<WebmElement>& cuePoint) {
+    CHECK(cluster != NULL);
+    Item item;
+    item.mCluster = cluster;
+    item.mCuePoint = cuePoint;
+    mItems.push(item);
+}
+
+status_t WebmClusterWriterThread::stop() {
+    // An item without a cluster ends the thread.
+    mItems.push(Item());
+    WebmFrameThread::stop();
+
+    ::lseek64(mFd, mOffset, SEEK_SET);
+    // Releases the space preallocated past the last cluster.
+    if (mAllocatedOffset > mOffset) {
+        ::ftruncate64(mFd, mOffset);
+        mAllocatedOffset = mOffset;
+    }
+    return mError;
+}
+
+void WebmClusterWriterThread::run() {
+    while (true) {
+        const Item item = mItems.take();
+        if (item.mCluster == NULL) {
+            break;
+        }
+        if (mError != OK) {
+            continue;
+        }
+
+        const size_t size = item.mCluster->size();
+        preallocate(size);
+        mError = writeAt(item.mCluster->data(), size, mOffset);
+        if (mError != OK) {
+            continue;
+        }
+        mOffset += size;
+
+        if (item.mCuePoint != NULL) {
+            mError = writeCuePoint(item.mCuePoint);
+        }
+    }
+}
+
+status_t WebmClusterWriterThread::writeAt(const uint8_t *data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite64(mFd, data, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ALOGE("failed to write %zu bytes at %" PRIu64 "; errno = %d", size, offset, errno);
+            return -errno;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return OK;
+}
+
+void WebmClusterWriterThread::preallocate(uint64_t size) {
+    if (mOffset + size <= mAllocatedOffset) {
+        return;
+    }
+    // The file size is kept, so that a recording that is never finalized does not end in
+    // preallocated zeros.
+    uint64_t length = mOffset + size - mAllocatedOffset + kPreallocationSize;
+    if (::fallocate64(mFd, FALLOC_FL_KEEP_SIZE, mAllocatedOffset, length) != 0) {
+        // Not supported by all file systems; clusters are written all the same.
+        ALOGV("failed to preallocate %" PRIu64 " bytes; errno = %d", length, errno);
+        mAllocatedOffset = mOffset + size;
+        return;
+    }
+    mAllocatedOffset += length;
+}
+
+// Writes a cue point after the ones written before, followed by the header of a void element
+// that fills the rest of the reserved space, and then updates the size of the cues. The cues are
+// left as they are once the space is full, as the recording then writes them anew after the
+// clusters when it is finalized.
+status_t WebmClusterWriterThread::writeCuePoint(const sp<WebmElement>& cuePoint) {
+    if (mCuesFull) {
+        return OK;
+    }
+
+    const uint64_t cuePointSize = cuePoint->totalSize();
+    const uint64_t used = kCuesHeaderSize + mCuesSize + cuePointSize;
+    if (used > mCuesSpace || (used < mCuesSpace && mCuesSpace - used < kMinEbmlVoidSize)) {
+        ALOGV("reserved cues space of %" PRIu64 " bytes is full", mCuesSpace);
+        mCuesFull = true;
+        return OK;
+    }
+
+    sp<ABuffer> buffer = new ABuffer(cuePointSize + sizeOf(kMkvVoid) + sizeof(uint64_t));
+    uint8_t *ptr = buffer->data();
+    ptr += cuePoint->serializeInto(ptr);
+    if (used < mCuesSpace) {
+        sp<WebmElement> space = new EbmlVoid(mCuesSpace - used);
+        ptr += serializeCodedUnsigned(space->mId, ptr);
+        ptr += space->serializePayloadSize(ptr);
+    }
+    status_t err = writeAt(
+            buffer->data(), ptr - buffer->data(), mCuesOffset + kCuesHeaderSize + mCuesSize);
+    if (err != OK) {
+        return err;
+    }
+    mCuesSize += cuePointSize;
+
+    uint8_t header[kCuesHeaderSize];
+    ptr = header;
+    ptr += serializeCodedUnsigned(kMkvCues, ptr);
+    serializeCodedUnsigned(encodeUnsigned(mCuesSize, kCuesHeaderSize - 4), ptr);
+    return writeAt(header, sizeof(header), mCuesOffset);
+}
+
+//=================================================================================================
+
 WebmFrameSinkThread::WebmFrameSinkThread(
         const int& fd,
         const uint64_t& off,
@@ -79,6 +223,9 @@ WebmFrameSinkThread::WebmFrameSinkThread(
       mAudioFrames(audioThread->mSink),
       mCues(cues),
       mStartOffsetTimecode(UINT64_MAX),
+      mCuesOffset(0),
+      mCuesSpace(0),
+      mClusterOffset(0),
       mDone(true) {
 }
 
@@ -94,6 +241,9 @@ WebmFrameSinkThread::WebmFrameSinkThread(
       mAudioFrames(audioSource),
       mCues(cues),
       mStartOffsetTimecode(UINT64_MAX),
+      mCuesOffset(0),
+      mCuesSpace(0),
+      mClusterOffset(0),
       mDone(true) {
 }
 
@@ -124,13 +274,17 @@ void WebmFrameSinkThread::initCluster(
     children.push_back(clusterTimecode);
 }
 
-void WebmFrameSinkThread::writeCluster(List<sp<WebmElement> >& children) {
+void WebmFrameSinkThread::writeCluster(
+        List<sp<WebmElement> >& children,
+        const sp<WebmElement>& cuePoint) {
     // children must contain at least one simpleblock and its timecode
     CHECK_GE(children.size(), 2u);
 
-    uint64_t size;
     sp<WebmElement> cluster = new WebmMaster(kMkvCluster, children);
-    cluster->write(mFd, size);
+    sp<ABuffer> buffer = new ABuffer(cluster->totalSize());
+    cluster->serializeInto(buffer->data());
+    mClusterOffset += buffer->size();
+    mWriter->write(buffer, cuePoint);
     children.clear();
 }
 
@@ -148,7 +302,7 @@ void WebmFrameSinkThread::flushFrames(List<const sp<WebmFrame> >& frames, bool l
     initCluster(frames, clusterTimecodeL, children);
 
     uint64_t cueTime = clusterTimecodeL;
-    off_t fpos = ::lseek(mFd, 0, SEEK_CUR);
+    uint64_t fpos = mClusterOffset;
     size_t n = frames.size();
     if (!last) {
         // If we are not flushing the last sequence of outstanding frames, flushFrames
@@ -186,13 +340,26 @@ void WebmFrameSinkThread::flushFrames(List<const sp<WebmFrame> >& frames, bool l
         }
     }
 
-    writeCluster(children);
     sp<WebmElement> cuePoint = WebmElement::CuePointEntry(cueTime, 1, fpos - mSegmentDataStart);
+    writeCluster(children, cuePoint);
     mCues.push_back(cuePoint);
 }
 
+void WebmFrameSinkThread::setCuesSpace(uint64_t offset, uint64_t size) {
+    mCuesOffset = offset;
+    mCuesSpace = size;
+}
+
 status_t WebmFrameSinkThread::start() {
     mDone = false;
+    mClusterOffset = ::lseek64(mFd, 0, SEEK_CUR);
+    mWriter = new WebmClusterWriterThread(mFd, mClusterOffset, mCuesOffset, mCuesSpace);
+    status_t err = mWriter->start();
+    if (err != OK) {
+        mWriter.clear();
+        mDone = true;
+        return err;
+    }
     return WebmFrameThread::start();
 }
 
@@ -200,7 +367,15 @@ status_t WebmFrameSinkThread::stop() {
     mDone = true;
     mVideoFrames.push(WebmFrame::EOS);
     mAudioFrames.push(WebmFrame::EOS);
-    return WebmFrameThread::stop();
+    status_t err = WebmFrameThread::stop();
+    if (mWriter != NULL) {
+        status_t writeErr = mWriter->stop();
+        mWriter.clear();
+        if (err == OK) {
+            err = writeErr;
+        }
+    }
+    return err;
 }
 
 void WebmFrameSinkThread::run() {
@@ -360,7 +360,10 @@ status_t WebmWriter::reset() {
         ALOGD("Duration from tracks range is [%" PRId64 ", %" PRId64 "] us", minDurationUs, maxDurationUs);
     }
 
-    mSinkThread->stop();
+    status_t status = mSinkThread->stop();
+    if (err == OK && status != OK) {
+        err = status;
+    }
 
     // Do not write out movie header on error.
     if (err != OK) {
@@ -374,7 +377,16 @@ status_t WebmWriter::reset() {
     // perfectly, we still need to check if there is enough "extra space" to write an
     // EBML void element.
     if (cuesSize != mEstimatedCuesSize && cuesSize > mEstimatedCuesSize - kMinEbmlVoidSize) {
-        mCuesOffset = ::lseek(mFd, 0, SEEK_CUR);
+        uint64_t endOffset = ::lseek(mFd, 0, SEEK_CUR);
+        if (mStreamableFile) {
+            // Clear the cues written into the reserved space while recording.
+            uint64_t spaceSize;
+            ::lseek(mFd, mCuesOffset, SEEK_SET);
+            sp<WebmElement> space = new EbmlVoid(mEstimatedCuesSize);
+            space->write(mFd, spaceSize);
+            ::lseek(mFd, endOffset, SEEK_SET);
+        }
+        mCuesOffset = endOffset;
         cues->write(mFd, cuesSize);
     } else {
         uint64_t spaceSize;
@@ -588,6 +600,8 @@ status_t WebmWriter::start(MetaData *params) {
     initStream(kAudioIndex);
     initStream(kVideoIndex);
 
+    mSinkThread->setCuesSpace(mCuesOffset, mStreamableFile ? mEstimatedCuesSize : 0);
+
     mStreams[kAudioIndex].mThread->start();
     mStreams[kVideoIndex].mThread->start();
     mSinkThread->start();
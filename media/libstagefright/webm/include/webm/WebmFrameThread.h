@@ -53,6 +53,47 @@ private:
 
 //=================================================================================================
 
+// Writes serialized clusters to the file in order, so that the sink thread does not wait on
+// storage. File space is preallocated ahead of the clusters. If space was reserved for the cues,
+// the cue point of each cluster is written into it once the cluster is written, so that the
+// cues of a recording that is never finalized still index the clusters written.
+class WebmClusterWriterThread : public WebmFrameThread {
+public:
+    WebmClusterWriterThread(int fd, uint64_t offset, uint64_t cuesOffset, uint64_t cuesSpace);
+
+    void run();
+
+    // Queues a cluster to be written after the previous ones, and the cue point (may be NULL)
+    // that refers to it.
+    void write(const sp<ABuffer>& cluster, const sp<WebmElement>& cuePoint);
+
+    // Writes out the queued clusters, and moves the file offset past them. Returns the first
+    // write error.
+    status_t stop();
+
+private:
+    struct Item {
+        sp<ABuffer> mCluster;
+        sp<WebmElement> mCuePoint;
+    };
+
+    const int mFd;
+    const uint64_t mCuesOffset;
+    const uint64_t mCuesSpace;
+    uint64_t mOffset;
+    uint64_t mAllocatedOffset;
+    uint64_t mCuesSize;
+    bool mCuesFull;
+    status_t mError;
+    LinkedBlockingQueue<Item> mItems;
+
+    status_t writeAt(const uint8_t *data, size_t size, uint64_t offset);
+    void preallocate(uint64_t size);
+    status_t writeCuePoint(const sp<WebmElement>& cuePoint);
+};
+
+//=================================================================================================
+
 class WebmFrameSourceThread;
 class WebmFrameSinkThread : public WebmFrameThread {
 public:
@@ -77,6 +118,10 @@ public:
     status_t start();
     status_t stop();
 
+    // Sets the space reserved for the cues, which is filled in as clusters are written. A size
+    // of 0 means no space is reserved.
+    void setCuesSpace(uint64_t offset, uint64_t size);
+
 private:
     const int& mFd;
     const uint64_t& mSegmentDataStart;
@@ -84,6 +129,10 @@ private:
     LinkedBlockingQueue<const sp<WebmFrame> >& mAudioFrames;
     List<sp<WebmElement> >& mCues;
     uint64_t mStartOffsetTimecode;
+    uint64_t mCuesOffset;
+    uint64_t mCuesSpace;
+    uint64_t mClusterOffset;
+    sp<WebmClusterWriterThread> mWriter;
 
     volatile bool mDone;
 
@@ -91,7 +140,9 @@ private:
             List<const sp<WebmFrame> >& frames,
             uint64_t& clusterTimecodeL,
             List<sp<WebmElement> >& children);
-    void writeCluster(List<sp<WebmElement> >& children);
+    void writeCluster(
+            List<sp<WebmElement> >& children,
+            const sp<WebmElement>& cuePoint = NULL);
     void flushFrames(List<const sp<WebmFrame> >& frames, bool last);
 };
 
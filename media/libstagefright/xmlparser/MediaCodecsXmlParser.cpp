@@ -22,13 +22,16 @@
 #include <android-base/logging.h>
 #include <android-base/macros.h>
 #include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
 
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/omx/OMXUtils.h>
 
+#include <dirent.h>
 #include <expat.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -77,6 +80,36 @@ bool findFileInDirs(
     return false;
 }
 
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+// FNV-1a, stable across processes and builds unlike std::hash
+__attribute__((no_sanitize("integer")))
+void fnvHash(uint64_t *hash, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        *hash = (*hash ^ bytes[i]) * kFnvPrime;
+    }
+}
+
+/**
+ * Hash the path of a file (including the terminating null) followed by its
+ * contents, if it can be read.
+ */
+void hashFile(uint64_t *hash, const std::string &path) {
+    fnvHash(hash, path.c_str(), path.size() + 1);
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return;
+    }
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        fnvHash(hash, buffer, size);
+    }
+    fclose(file);
+}
+
 bool strnEq(const char* s1, const char* s2, size_t count) {
     return strncmp(s1, s2, count) == 0;
 }
@@ -423,6 +456,45 @@ status_t MediaCodecsXmlParser::parseXmlPath(const std::string &path) {
     return mImpl->parseXmlPath(path);
 }
 
+// static
+std::string MediaCodecsXmlParser::getXmlFilesFingerprint(
+        const std::vector<std::string> &fileNames,
+        const std::vector<std::string> &searchDirs) {
+    uint64_t hash = kFnvOffsetBasis;
+    std::set<std::string> hashedDirs;
+    for (const std::string &fileName : fileNames) {
+        std::string path;
+        if (!findFileInDirs(searchDirs, fileName, &path)) {
+            continue;
+        }
+        hashFile(&hash, path);
+
+        // includes are resolved relative to the including file, and must be
+        // named media_codecs_*.xml (see includeXmlFile())
+        std::string dir = path.substr(0, path.rfind('/') + 1);
+        if (!hashedDirs.insert(dir).second) {
+            continue;
+        }
+        DIR *dirp = opendir(dir.c_str());
+        if (dirp == nullptr) {
+            continue;
+        }
+        std::set<std::string> includable;
+        while (struct dirent *entry = readdir(dirp)) {
+            std::string name = entry->d_name;
+            if (name.size() > 17 && name.compare(0, 13, "media_codecs_") == 0
+                    && name.compare(name.size() - 4, 4, ".xml") == 0) {
+                includable.insert(name);
+            }
+        }
+        closedir(dirp);
+        for (const std::string &name : includable) {
+            hashFile(&hash, dir + name);
+        }
+    }
+    return android::base::StringPrintf("%016" PRIx64, hash);
+}
+
 status_t MediaCodecsXmlParser::Impl::parseXmlFilesInSearchDirs(
         const std::vector<std::string> &fileNames,
         const std::vector<std::string> &searchDirs) {
@@ -134,6 +134,21 @@ public:
             const std::vector<std::string> &xmlFiles = getDefaultXmlNames(),
             const std::vector<std::string> &searchDirs = getDefaultSearchDirs());
 
+    /**
+     * Compute a fingerprint of the XML files that parseXmlFilesInSearchDirs()
+     * would read for the same arguments: the top level files found, and the
+     * media_codecs_*.xml files next to them that they may include. The
+     * fingerprint changes whenever the path or contents of any of them do.
+     *
+     * @param xmlFiles ordered list of XML file names (no paths)
+     * @param searchDirs ordered list of paths to consider
+     *
+     * @return fingerprint as a hex string
+     */
+    static std::string getXmlFilesFingerprint(
+            const std::vector<std::string> &xmlFiles = getDefaultXmlNames(),
+            const std::vector<std::string> &searchDirs = getDefaultSearchDirs());
+
 
     /**
      * Parse a top level XML file.
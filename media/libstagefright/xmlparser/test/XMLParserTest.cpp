@@ -17,6 +17,8 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "XMLParserTest"
 
+#include <stdlib.h>
+#include <unistd.h>
 #include <utils/Log.h>
 
 #include <fstream>
@@ -408,6 +410,35 @@ TEST_F(XMLParseTest, ServiceAttributeMapParseTest) {
     ASSERT_TRUE(flag) << "ServiceMapParseTest: typeMap mismatch";
 }
 
+TEST_F(XMLParseTest, XmlFilesFingerprintTest) {
+    string dir = gEnv->getRes() + "XMLParserTest.XXXXXX";
+    ASSERT_NE(mkdtemp(&dir[0]), nullptr) << "Failed to create a directory in " << gEnv->getRes();
+    for (const char *name : {XML_FILE_NAME, "media_codecs_unit_test.xml"}) {
+        ifstream src(gEnv->getRes() + name, ifstream::binary);
+        ofstream dst(dir + "/" + name, ofstream::binary);
+        dst << src.rdbuf();
+    }
+
+    string fingerprint = MediaCodecsXmlParser::getXmlFilesFingerprint({XML_FILE_NAME}, {dir});
+    ASSERT_EQ(fingerprint, MediaCodecsXmlParser::getXmlFilesFingerprint({XML_FILE_NAME}, {dir}))
+            << "fingerprint is not stable";
+    ASSERT_NE(fingerprint, MediaCodecsXmlParser::getXmlFilesFingerprint({"missing.xml"}, {dir}))
+            << "fingerprint ignores the file set";
+
+    // a change to an included file must change the fingerprint
+    {
+        ofstream included(dir + "/media_codecs_unit_test.xml", ofstream::app);
+        included << "<!-- changed -->\n";
+    }
+    ASSERT_NE(fingerprint, MediaCodecsXmlParser::getXmlFilesFingerprint({XML_FILE_NAME}, {dir}))
+            << "fingerprint ignores included files";
+
+    for (const char *name : {XML_FILE_NAME, "media_codecs_unit_test.xml"}) {
+        unlink((dir + "/" + name).c_str());
+    }
+    rmdir(dir.c_str());
+}
+
 int main(int argc, char **argv) {
     gEnv = new XMLParserTestEnvironment();
     ::testing::AddGlobalTestEnvironment(gEnv);
@@ -18,13 +18,17 @@
 #define LOG_TAG "mediaserver"
 //#define LOG_NDEBUG 0
 
+#include <android-base/properties.h>
 #include <binder/IPCThreadState.h>
 #include <binder/ProcessState.h>
 #include <binder/IServiceManager.h>
 #include <hidl/HidlTransportSupport.h>
+#include <media/stagefright/FrameCaptureProcessor.h>
 #include <utils/Log.h>
 #include "RegisterExtensions.h"
 
+#include <thread>
+
 #include <MediaPlayerService.h>
 #include <ResourceManagerService.h>
 
@@ -42,6 +46,11 @@ int main(int argc __unused, char **argv __unused)
     registerExtensions();
     ::android::hardware::configureRpcThreadpool(16, false);
     ProcessState::self()->startThreadPool();
+    if (base::GetBoolProperty("media.stagefright.thumbnail.prewarm", true)) {
+        // Set up the GL context and the HDR tone mapping programs of frame
+        // capture in the background, so the first HDR thumbnail doesn't wait.
+        std::thread([] { FrameCaptureProcessor::getInstance(); }).detach();
+    }
     IPCThreadState::self()->joinThreadPool();
     ::android::hardware::joinRpcThreadpool();
 }
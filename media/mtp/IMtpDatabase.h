@@ -81,6 +81,16 @@ public:
                                             int groupCode, int depth,
                                             MtpDataPacket& packet) = 0;
 
+    // Writes the ObjectPropList of all the properties of all the children of |parent|,
+    // MTP_PARENT_ROOT for the root, with a single query. MtpServer caches the result
+    // instead of querying each object and property on its own.
+    virtual MtpResponseCode         getChildObjectPropertyList(MtpObjectHandle parent,
+                                            MtpDataPacket& packet) {
+        return getObjectPropertyList(parent == MTP_PARENT_ROOT ? 0 : parent,
+                0 /* all formats */, 0xFFFFFFFF /* all properties */, 0, 1 /* children */,
+                packet);
+    }
+
     virtual MtpResponseCode         getObjectInfo(MtpObjectHandle handle,
                                             MtpObjectInfo& info) = 0;
 
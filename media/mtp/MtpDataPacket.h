@@ -93,6 +93,8 @@ public:
     void                putString(const uint16_t* string);
     inline void         putEmptyString() { putUInt8(0); }
     inline void         putEmptyArray() { putUInt32(0); }
+    // appends |length| bytes that are already encoded
+    void                putData(const void* data, size_t length);
 
 #ifdef MTP_DEVICE
     // fill our buffer with data from the given usb handle
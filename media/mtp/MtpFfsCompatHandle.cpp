@@ -176,7 +176,7 @@ int MtpFfsCompatHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
     bool read = false;
     bool write = false;
 
-    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
     // Break down the file into pieces that fit in buffers
     while (file_length > 0 || write) {
@@ -258,7 +258,7 @@ int MtpFfsCompatHandle::sendFile(mtp_file_range mfr) {
     unsigned char *data = mIobuf[0].bufs.data();
     unsigned char *data2 = mIobuf[1].bufs.data();
 
-    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
     struct aiocb aio;
     aio.aio_fildes = mfr.fd;
@@ -45,6 +45,9 @@ constexpr unsigned AIO_BUF_LEN = 16384;
 constexpr unsigned FFS_NUM_EVENTS = 5;
 
 constexpr unsigned MAX_FILE_CHUNK_SIZE = AIO_BUFS_MAX * AIO_BUF_LEN;
+// Chunks on links slower than SuperSpeed, where a smaller first chunk gets
+// data onto the bus sooner and the larger one gains nothing.
+constexpr unsigned HS_FILE_CHUNK_SIZE = MAX_FILE_CHUNK_SIZE / 4;
 
 constexpr uint32_t MAX_MTP_FILE_SIZE = 0xFFFFFFFF;
 // Note: POLL_TIMEOUT_MS = 0 means return immediately i.e. no sleep.
@@ -113,16 +116,28 @@ bool MtpFfsHandle::openEndpoints(bool ptp) {
 }
 
 void MtpFfsHandle::advise(int fd) {
+    // The advice values are not flags and can not be or'ed together.
     for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
         if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
-                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED) != 0)
+                POSIX_MADV_SEQUENTIAL) != 0)
             PLOG(ERROR) << "Failed to madvise";
     }
-    if (posix_fadvise(fd, 0, 0,
-                POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE | POSIX_FADV_WILLNEED) != 0)
+    // Doubles the kernel read-ahead window of the file.
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL) != 0)
         PLOG(ERROR) << "Failed to fadvise";
 }
 
+void MtpFfsHandle::readAhead(int fd, uint64_t offset, uint64_t length) {
+    // Start reading the next chunk into the page cache while the current one is in flight.
+    // Failing is harmless, the read only takes longer.
+    if (length > 0)
+        posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+}
+
+unsigned MtpFfsHandle::getChunkSize(int packet_size) {
+    return packet_size >= MAX_PACKET_SIZE_SS ? MAX_FILE_CHUNK_SIZE : HS_FILE_CHUNK_SIZE;
+}
+
 bool MtpFfsHandle::writeDescriptors(bool ptp) {
     return ::android::writeDescriptors(mControl, ptp);
 }
@@ -459,6 +474,7 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
     bool error = false;
     bool write_error = false;
     int packet_size = getPacketSize(mBulkOut);
+    const unsigned chunk_size = getChunkSize(packet_size);
     bool short_packet = false;
     advise(mfr.fd);
 
@@ -466,7 +482,7 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
     while (file_length > 0 || has_write) {
         // Queue an asynchronous read from USB.
         if (file_length > 0) {
-            length = std::min(static_cast<uint32_t>(MAX_FILE_CHUNK_SIZE), file_length);
+            length = std::min(static_cast<uint32_t>(chunk_size), file_length);
             if (iobufSubmit(&mIobuf[i], mBulkOut, length, true) == -1)
                 error = true;
         }
@@ -567,6 +583,7 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
             file_length + sizeof(mtp_data_header));
     uint64_t offset = mfr.offset;
     int packet_size = getPacketSize(mBulkIn);
+    const unsigned chunk_size = getChunkSize(packet_size);
 
     // If file_length is larger than a size_t, truncating would produce the wrong comparison.
     // Instead, promote the left side to 64 bits, then truncate the small result.
@@ -592,6 +609,18 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     header->command = htole16(mfr.command);
     header->transaction_id = htole32(mfr.transaction_id);
 
+    // A file that fits in one chunk is sent with the header in a single transfer,
+    // which saves a round trip per file when many small files are copied.
+    if (file_length <= chunk_size - sizeof(mtp_data_header)) {
+        if (TEMP_FAILURE_RETRY(pread(mfr.fd, mIobuf[0].bufs.data() + sizeof(mtp_data_header),
+                        file_length, offset)) != static_cast<ssize_t>(file_length))
+            return -1;
+        if (doAsync(mIobuf[0].bufs.data(), sizeof(mtp_data_header) + file_length,
+                    false, true /* send a zlp if the length is a multiple of the packet */) == -1)
+            return -1;
+        return 0;
+    }
+
     // Some hosts don't support header/data separation even though MTP allows it
     // Handle by filling first packet with initial file data
     if (TEMP_FAILURE_RETRY(pread(mfr.fd, mIobuf[0].bufs.data() +
@@ -608,9 +637,11 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     while(file_length > 0 || has_write) {
         if (file_length > 0) {
             // Queue up a read from disk.
-            length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), file_length);
+            length = std::min(static_cast<uint64_t>(chunk_size), file_length);
             aio_prepare(&aio, mIobuf[i].bufs.data(), length, offset);
             aio_read(&aio);
+            readAhead(mfr.fd, offset + length,
+                    std::min(static_cast<uint64_t>(chunk_size), file_length - length));
         }
 
         if (has_write) {
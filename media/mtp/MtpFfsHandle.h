@@ -48,6 +48,7 @@ protected:
     void closeConfig();
     void closeEndpoints();
     void advise(int fd);
+    void readAhead(int fd, uint64_t offset, uint64_t length);
     int handleControlRequest(const struct usb_ctrlrequest *request);
     int doAsync(void* data, size_t len, bool read, bool zero_packet);
     int handleEvent();
@@ -56,6 +57,8 @@ protected:
     bool openEndpoints(bool ptp);
 
     static int getPacketSize(int ffs_fd);
+    // The amount of a file that is moved per aio request batch, for the link speed.
+    static unsigned getChunkSize(int packet_size);
 
     bool mCanceled;
     bool mBatchCancel;
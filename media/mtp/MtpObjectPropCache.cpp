@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MtpObjectPropCache"
+
+#include "IMtpDatabase.h"
+#include "MtpDataPacket.h"
+#include "MtpDebug.h"
+#include "MtpObjectPropCache.h"
+#include "mtp.h"
+
+#include <stdlib.h>
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kAllProperties = 0xFFFFFFFF;
+constexpr uint32_t kAllObjects = 0xFFFFFFFF;
+
+uint16_t readUInt16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+uint32_t readUInt32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+size_t scalarSize(MtpDataType type) {
+    switch (type) {
+        case MTP_TYPE_INT8:
+        case MTP_TYPE_UINT8:
+            return 1;
+        case MTP_TYPE_INT16:
+        case MTP_TYPE_UINT16:
+            return 2;
+        case MTP_TYPE_INT32:
+        case MTP_TYPE_UINT32:
+            return 4;
+        case MTP_TYPE_INT64:
+        case MTP_TYPE_UINT64:
+            return 8;
+        case MTP_TYPE_INT128:
+        case MTP_TYPE_UINT128:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// Returns the size of the encoded value of |type| at |data|, or 0 if it is malformed.
+size_t valueSize(MtpDataType type, const uint8_t* data, size_t length) {
+    size_t size;
+    if (type == MTP_TYPE_STR) {
+        if (length < 1)
+            return 0;
+        size = 1 + data[0] * sizeof(uint16_t);
+    } else if (type & 0x4000) {
+        size_t elementSize = scalarSize(type & ~0x4000);
+        if (elementSize == 0 || length < sizeof(uint32_t))
+            return 0;
+        size = sizeof(uint32_t) + readUInt32(data) * elementSize;
+    } else {
+        size = scalarSize(type);
+    }
+    return size <= length ? size : 0;
+}
+
+} // anonymous namespace
+
+MtpObjectPropCache::MtpObjectPropCache(IMtpDatabase* database)
+    :   mDatabase(database),
+        mNumObjects(0),
+        mGeneration(0)
+{
+}
+
+void MtpObjectPropCache::addObjectList(MtpStorageID storageID, MtpObjectHandle parent,
+        const MtpObjectHandleList& handles) {
+    // Listings of all the objects, or of no specific storage, are not folders to load.
+    if (storageID == 0 || storageID == kAllObjects || parent == 0
+            || handles.size() > kMaxObjects)
+        return;
+
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (mNumObjects + handles.size() > kMaxObjects) {
+        ALOGV("dropping the property cache at %zu objects", mNumObjects);
+        mStorages.clear();
+        mNumObjects = 0;
+        mGeneration++;
+    }
+    StorageCache& storage = mStorages[storageID];
+    for (MtpObjectHandle handle : handles) {
+        auto result = storage.mObjects.insert({handle, Object{parent, false, {}}});
+        if (result.second) {
+            mNumObjects++;
+        } else if (result.first->second.mParent != parent) {
+            result.first->second = Object{parent, false, {}};
+        }
+    }
+    // a new listing may have new objects, so the folder is loaded again.
+    storage.mParents[parent] = false;
+}
+
+MtpObjectPropCache::Object* MtpObjectPropCache::findObject(MtpObjectHandle handle,
+        MtpStorageID* storageID) {
+    for (auto& storage : mStorages) {
+        auto it = storage.second.mObjects.find(handle);
+        if (it != storage.second.mObjects.end()) {
+            *storageID = storage.first;
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+MtpObjectPropCache::Object* MtpObjectPropCache::load(std::unique_lock<std::mutex>& lock,
+        MtpObjectHandle handle) {
+    MtpStorageID storageID;
+    Object* object = findObject(handle, &storageID);
+    if (object == nullptr || object->mLoaded)
+        return object;
+    auto parentIt = mStorages[storageID].mParents.find(object->mParent);
+    if (parentIt == mStorages[storageID].mParents.end() || parentIt->second) {
+        // the folder was loaded, but did not have this object.
+        return nullptr;
+    }
+    // loaded or not, the folder is queried once per listing.
+    parentIt->second = true;
+    const MtpObjectHandle parent = object->mParent;
+    const uint32_t generation = mGeneration;
+
+    lock.unlock();
+    MtpDataPacket packet;
+    MtpResponseCode response = mDatabase->getChildObjectPropertyList(parent, packet);
+    lock.lock();
+    if (response != MTP_RESPONSE_OK || generation != mGeneration)
+        return nullptr;
+
+    int length = 0;
+    uint8_t* data = static_cast<uint8_t*>(packet.getData(&length));
+    if (data == nullptr)
+        return nullptr;
+    if (!parse(data, length, mStorages[storageID], parent))
+        ALOGW("malformed ObjectPropList for parent %d", parent);
+    free(data);
+
+    object = findObject(handle, &storageID);
+    return object != nullptr && object->mLoaded ? object : nullptr;
+}
+
+bool MtpObjectPropCache::parse(const uint8_t* data, size_t length, StorageCache& storage,
+        MtpObjectHandle parent) {
+    if (length < sizeof(uint32_t))
+        return false;
+    uint32_t count = readUInt32(data);
+    size_t offset = sizeof(uint32_t);
+    std::vector<Object*> loaded;
+    bool ok = true;
+    for (uint32_t i = 0; i < count; i++) {
+        // each element is the object handle, property code, data type and value.
+        if (length - offset < 8) {
+            ok = false;
+            break;
+        }
+        MtpObjectHandle handle = readUInt32(data + offset);
+        MtpObjectProperty property = readUInt16(data + offset + 4);
+        MtpDataType type = readUInt16(data + offset + 6);
+        offset += 8;
+        size_t size = valueSize(type, data + offset, length - offset);
+        if (size == 0) {
+            ok = false;
+            break;
+        }
+        auto it = storage.mObjects.find(handle);
+        if (it != storage.mObjects.end() && it->second.mParent == parent) {
+            PropValue& value = it->second.mProps[property];
+            value.mType = type;
+            value.mData.assign(data + offset, data + offset + size);
+            loaded.push_back(&it->second);
+        }
+        offset += size;
+    }
+    // only objects with all their properties are answered from the cache.
+    if (ok) {
+        for (Object* object : loaded)
+            object->mLoaded = true;
+    }
+    return ok;
+}
+
+void MtpObjectPropCache::putProp(MtpObjectHandle handle, MtpObjectProperty property,
+        const PropValue& value, MtpDataPacket& packet) {
+    packet.putUInt32(handle);
+    packet.putUInt16(property);
+    packet.putUInt16(value.mType);
+    packet.putData(value.mData.data(), value.mData.size());
+}
+
+bool MtpObjectPropCache::getObjectPropertyValue(MtpObjectHandle handle,
+        MtpObjectProperty property, MtpDataPacket& packet) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    Object* object = load(lock, handle);
+    if (object == nullptr)
+        return false;
+    auto it = object->mProps.find(property);
+    if (it == object->mProps.end())
+        return false;
+    packet.putData(it->second.mData.data(), it->second.mData.size());
+    return true;
+}
+
+bool MtpObjectPropCache::getObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+        uint32_t property, int groupCode, int depth, MtpDataPacket& packet) {
+    // Only the properties of a single object are answered from the cache.
+    if (handle == 0 || handle == kAllObjects || format != 0 || groupCode != 0 || depth != 0)
+        return false;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    Object* object = load(lock, handle);
+    if (object == nullptr)
+        return false;
+    if (property == kAllProperties) {
+        packet.putUInt32(object->mProps.size());
+        for (const auto& prop : object->mProps)
+            putProp(handle, prop.first, prop.second, packet);
+        return true;
+    }
+    auto it = object->mProps.find(property);
+    if (it == object->mProps.end())
+        return false;
+    packet.putUInt32(1);
+    putProp(handle, it->first, it->second, packet);
+    return true;
+}
+
+void MtpObjectPropCache::invalidateObject(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    for (auto& storage : mStorages) {
+        if (storage.second.mObjects.erase(handle)) {
+            mNumObjects--;
+            return;
+        }
+    }
+}
+
+void MtpObjectPropCache::invalidateStorageOf(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    for (auto it = mStorages.begin(); it != mStorages.end(); ++it) {
+        if (it->second.mObjects.count(handle) || it->second.mParents.count(handle)) {
+            mNumObjects -= it->second.mObjects.size();
+            mStorages.erase(it);
+            return;
+        }
+    }
+}
+
+void MtpObjectPropCache::invalidateStorage(MtpStorageID storageID) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    auto it = mStorages.find(storageID);
+    if (it != mStorages.end()) {
+        mNumObjects -= it->second.mObjects.size();
+        mStorages.erase(it);
+    }
+}
+
+void MtpObjectPropCache::clear() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mStorages.clear();
+    mNumObjects = 0;
+}
+
+}  // namespace android
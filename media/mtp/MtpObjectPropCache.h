@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MTP_OBJECT_PROP_CACHE_H
+#define _MTP_OBJECT_PROP_CACHE_H
+
+#include "MtpTypes.h"
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+class IMtpDatabase;
+class MtpDataPacket;
+
+// Caches the object properties of the folders that the host listed, per storage.
+//
+// Hosts list a folder with GetObjectHandles and then ask for the properties of each
+// object in it, one GetObjectPropValue or GetObjectPropList at a time. Each of those is
+// a query of the database. The first time such a request misses, all the properties of
+// the objects in the folder are loaded with one getChildObjectPropertyList() query,
+// and the following requests are answered from the cache.
+class MtpObjectPropCache {
+private:
+    struct PropValue {
+        MtpDataType             mType;
+        std::vector<uint8_t>    mData;      // the encoded value
+    };
+
+    struct Object {
+        MtpObjectHandle         mParent;
+        bool                    mLoaded;
+        std::map<MtpObjectProperty, PropValue> mProps;
+    };
+
+    struct StorageCache {
+        std::map<MtpObjectHandle, Object> mObjects;
+        // the parents listed with GetObjectHandles, and whether they were loaded.
+        std::map<MtpObjectHandle, bool> mParents;
+    };
+
+    // The total number of objects kept, a storage is dropped when it would go over.
+    static const size_t     kMaxObjects = 50000;
+
+    IMtpDatabase*           mDatabase;
+    std::mutex              mMutex;
+    std::map<MtpStorageID, StorageCache> mStorages;
+    size_t                  mNumObjects;
+    // bumped by every invalidation, so a load that raced with one is not kept.
+    uint32_t                mGeneration;
+
+    Object*                 findObject(MtpObjectHandle handle, MtpStorageID* storageID);
+    // Loads the properties of the folder that |handle| was listed in, if not done yet.
+    Object*                 load(std::unique_lock<std::mutex>& lock, MtpObjectHandle handle);
+    // Parses an ObjectPropList dataset into the objects of |storage| that are children
+    // of |parent|. Returns false if the dataset is malformed.
+    bool                    parse(const uint8_t* data, size_t length, StorageCache& storage,
+                                    MtpObjectHandle parent);
+    void                    putProp(MtpObjectHandle handle, MtpObjectProperty property,
+                                    const PropValue& value, MtpDataPacket& packet);
+
+public:
+    explicit                MtpObjectPropCache(IMtpDatabase* database);
+
+    // Records the objects that GetObjectHandles returned for |parent|.
+    void                    addObjectList(MtpStorageID storageID, MtpObjectHandle parent,
+                                    const MtpObjectHandleList& handles);
+
+    // Write the value of the property or the ObjectPropList to |packet| and return true,
+    // or return false if the request has to go to the database.
+    bool                    getObjectPropertyValue(MtpObjectHandle handle,
+                                    MtpObjectProperty property, MtpDataPacket& packet);
+    bool                    getObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+                                    uint32_t property, int groupCode, int depth,
+                                    MtpDataPacket& packet);
+
+    // Drops the object, after it was edited or its properties changed.
+    void                    invalidateObject(MtpObjectHandle handle);
+    // Drops the storage the object is in, after a change to the tree such as a delete or
+    // a move.
+    void                    invalidateStorageOf(MtpObjectHandle handle);
+    void                    invalidateStorage(MtpStorageID storageID);
+    void                    clear();
+};
+
+}; // namespace android
+
+#endif // _MTP_OBJECT_PROP_CACHE_H
@@ -120,7 +120,8 @@ MtpServer::MtpServer(IMtpDatabase* database, int controlFd, bool ptp,
         mSendObjectHandle(kInvalidObjectHandle),
         mSendObjectFormat(0),
         mSendObjectFileSize(0),
-        mSendObjectModifiedTime(0)
+        mSendObjectModifiedTime(0),
+        mPropCache(database)
 {
     bool ffs_ok = access(FFS_MTP_EP0, W_OK) == 0;
     if (ffs_ok) {
@@ -146,6 +147,7 @@ void MtpServer::removeStorage(MtpStorage* storage) {
     auto iter = std::find(mStorages.begin(), mStorages.end(), storage);
     if (iter != mStorages.end()) {
         sendStoreRemoved(storage->getStorageID());
+        mPropCache.invalidateStorage(storage->getStorageID());
         mStorages.erase(iter);
     }
 }
@@ -259,11 +261,13 @@ void MtpServer::sendObjectAdded(MtpObjectHandle handle) {
 
 void MtpServer::sendObjectRemoved(MtpObjectHandle handle) {
     ALOGV("sendObjectRemoved %d\n", handle);
+    mPropCache.invalidateStorageOf(handle);
     sendEvent(MTP_EVENT_OBJECT_REMOVED, handle);
 }
 
 void MtpServer::sendObjectInfoChanged(MtpObjectHandle handle) {
     ALOGV("sendObjectInfoChanged %d\n", handle);
+    mPropCache.invalidateObject(handle);
     sendEvent(MTP_EVENT_OBJECT_INFO_CHANGED, handle);
 }
 
@@ -322,6 +326,7 @@ void MtpServer::removeEditObject(MtpObjectHandle handle) {
 
 void MtpServer::commitEdit(ObjectEdit* edit) {
     mDatabase->rescanFile((const char *)edit->mPath, edit->mHandle, edit->mFormat);
+    mPropCache.invalidateObject(edit->mHandle);
 }
 
 
@@ -514,6 +519,7 @@ MtpResponseCode MtpServer::doOpenSession() {
 
     mSessionID = mRequest.getParameter(1);
     mSessionOpen = true;
+    mPropCache.clear();
 
     return MTP_RESPONSE_OK;
 }
@@ -523,6 +529,7 @@ MtpResponseCode MtpServer::doCloseSession() {
         return MTP_RESPONSE_SESSION_NOT_OPEN;
     mSessionID = 0;
     mSessionOpen = false;
+    mPropCache.clear();
     return MTP_RESPONSE_OK;
 }
 
@@ -592,6 +599,7 @@ MtpResponseCode MtpServer::doGetObjectHandles() {
     MtpObjectHandleList* handles = mDatabase->getObjectList(storageID, format, parent);
     if (handles == NULL)
         return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
+    mPropCache.addObjectList(storageID, parent, *handles);
     mData.putAUInt32(handles);
     delete handles;
     return MTP_RESPONSE_OK;
@@ -666,6 +674,8 @@ MtpResponseCode MtpServer::doGetObjectPropValue() {
     ALOGV("GetObjectPropValue %d %s (0x%04X)\n", handle,
           MtpDebug::getObjectPropCodeName(property), property);
 
+    if (mPropCache.getObjectPropertyValue(handle, property, mData))
+        return MTP_RESPONSE_OK;
     return mDatabase->getObjectPropertyValue(handle, property, mData);
 }
 
@@ -679,6 +689,7 @@ MtpResponseCode MtpServer::doSetObjectPropValue() {
     ALOGV("SetObjectPropValue %d %s\n", handle,
             MtpDebug::getObjectPropCodeName(property));
 
+    mPropCache.invalidateObject(handle);
     return mDatabase->setObjectPropertyValue(handle, property, mData);
 }
 
@@ -728,6 +739,8 @@ MtpResponseCode MtpServer::doGetObjectPropList() {
             handle, MtpDebug::getFormatCodeName(format),
             MtpDebug::getObjectPropCodeName(property), groupCode, depth);
 
+    if (mPropCache.getObjectPropertyList(handle, format, property, groupCode, depth, mData))
+        return MTP_RESPONSE_OK;
     return mDatabase->getObjectPropertyList(handle, format, property, groupCode, depth, mData);
 }
 
@@ -1121,6 +1134,10 @@ MtpResponseCode MtpServer::doMoveObject() {
         }
     }
 
+    // the object and all under it may have moved to another storage.
+    mPropCache.invalidateStorageOf(objectHandle);
+    mPropCache.invalidateStorage(storageID);
+
     // If the move failed, undo the database change
     mDatabase->endMoveObject(info.mParent, parent, info.mStorageID, storageID, objectHandle,
             result == MTP_RESPONSE_OK);
@@ -1296,6 +1313,7 @@ done:
     // reset so we don't attempt to send the data back
     mData.reset();
 
+    mPropCache.invalidateObject(mSendObjectHandle);
     mDatabase->endSendObject(mSendObjectHandle, result == MTP_RESPONSE_OK);
     mSendObjectHandle = kInvalidObjectHandle;
     mSendObjectFormat = 0;
@@ -1332,6 +1350,7 @@ MtpResponseCode MtpServer::doDeleteObject() {
 
     bool success = deletePath((const char *)filePath);
 
+    mPropCache.invalidateStorageOf(handle);
     mDatabase->endDeleteObject(handle, success);
     return success ? result : MTP_RESPONSE_PARTIAL_DELETION;
 }
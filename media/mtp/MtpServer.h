@@ -21,6 +21,7 @@
 #include "MtpDataPacket.h"
 #include "MtpResponsePacket.h"
 #include "MtpEventPacket.h"
+#include "MtpObjectPropCache.h"
 #include "MtpStringBuffer.h"
 #include "mtp.h"
 #include "MtpUtils.h"
@@ -100,6 +101,9 @@ private:
     };
     std::vector<ObjectEdit*>  mObjectEditList;
 
+    // properties of the objects in the folders the host listed
+    MtpObjectPropCache  mPropCache;
+
 public:
                         MtpServer(IMtpDatabase* database, int controlFd, bool ptp,
                                     const char *deviceInfoManufacturer,
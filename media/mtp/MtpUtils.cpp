@@ -20,14 +20,21 @@
 #include <android-base/unique_fd.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <linux/fs.h>
 #include <string>
+#include <sys/ioctl.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "MtpUtils.h"
 
 using namespace std;
@@ -35,6 +42,7 @@ using namespace std;
 namespace android {
 
 constexpr unsigned long FILE_COPY_SIZE = 262144;
+constexpr size_t COPY_THREADS = 4;
 
 static void access_ok(const char *path) {
     if (access(path, F_OK) == -1) {
@@ -112,17 +120,15 @@ int makeFolder(const char *path) {
     return ret;
 }
 
-/**
- * Copies target path and all children to destination path.
- *
- * Returns 0 on success or a negative value indicating number of failures
- */
-int copyRecursive(const char *fromPath, const char *toPath) {
+// Copies the children of fromPath to toPath, creating the folders right away and
+// adding the files to copy to |files|.
+static int listCopies(const string& fromPath, const string& toPath,
+        vector<pair<string, string>>* files) {
     int ret = 0;
     string fromPathStr(fromPath);
     string toPathStr(toPath);
 
-    DIR* dir = opendir(fromPath);
+    DIR* dir = opendir(fromPath.c_str());
     if (!dir) {
         PLOG(ERROR) << "opendir " << fromPath << " failed";
         return -1;
@@ -145,15 +151,82 @@ int copyRecursive(const char *fromPath, const char *toPath) {
 
         if (entry->d_type == DT_DIR) {
             ret += makeFolder(newFile.c_str());
-            ret += copyRecursive(oldFile.c_str(), newFile.c_str());
+            ret += listCopies(oldFile, newFile, files);
         } else {
-            ret += copyFile(oldFile.c_str(), newFile.c_str());
+            files->emplace_back(oldFile, newFile);
         }
     }
     closedir(dir);
     return ret;
 }
 
+/**
+ * Copies target path and all children to destination path.
+ * The folders are created first, then the files are copied on COPY_THREADS threads,
+ * which keeps the storage busy for trees of many small files.
+ *
+ * Returns 0 on success or a negative value indicating number of failures
+ */
+int copyRecursive(const char *fromPath, const char *toPath) {
+    vector<pair<string, string>> files;
+    int ret = listCopies(fromPath, toPath, &files);
+
+    atomic<size_t> next(0);
+    atomic<int> failures(0);
+    auto copyFiles = [&files, &next, &failures]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            if (copyFile(files[i].first.c_str(), files[i].second.c_str()))
+                failures++;
+        }
+    };
+    vector<thread> threads;
+    for (size_t i = 1; i < min(files.size(), COPY_THREADS); i++)
+        threads.emplace_back(copyFiles);
+    copyFiles();
+    for (thread& t : threads)
+        t.join();
+    return ret - failures;
+}
+
+// Copies the data of fromFd to toFd, sharing the extents if the file system can,
+// else copying in the kernel.
+static int copyData(int fromFd, int toFd, off_t length) {
+    if (ioctl(toFd, FICLONE, fromFd) == 0)
+        return 0;
+
+    off_t offset = 0;
+    bool useCopyFileRange = true;
+    while (offset < length) {
+        size_t transfer_length = std::min(length - offset, (off_t) FILE_COPY_SIZE);
+        ssize_t ret;
+        if (useCopyFileRange) {
+            // copy_file_range can also clone, or copy on the storage, depending on the
+            // file system. Not all kernels and file system pairs support it.
+            loff_t fromOffset = offset;
+            loff_t toOffset = offset;
+            ret = syscall(__NR_copy_file_range, fromFd, &fromOffset, toFd, &toOffset,
+                    transfer_length, 0);
+            if (ret == -1 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                        errno == EOPNOTSUPP)) {
+                useCopyFileRange = false;
+                if (lseek(toFd, offset, SEEK_SET) == -1)
+                    return -1;
+                continue;
+            }
+            if (ret > 0)
+                offset += ret;
+        } else {
+            ret = sendfile(toFd, fromFd, &offset, transfer_length);
+        }
+        if (ret <= 0) {
+            // 0 means the file got shorter while it was copied.
+            PLOG(ERROR) << "Copying failed!";
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int copyFile(const char *fromPath, const char *toPath) {
     auto start = std::chrono::steady_clock::now();
 
@@ -167,31 +240,21 @@ int copyFile(const char *fromPath, const char *toPath) {
         PLOG(ERROR) << "Failed to open copy to " << toPath;
         return -1;
     }
-    off_t offset = 0;
 
     struct stat sstat = {};
-    if (stat(fromPath, &sstat) == -1)
+    if (fstat(fromFd, &sstat) == -1)
         return -1;
 
     off_t length = sstat.st_size;
-    int ret = 0;
+    int ret = copyData(fromFd, toFd, length);
 
-    while (offset < length) {
-        ssize_t transfer_length = std::min(length - offset, (off_t) FILE_COPY_SIZE);
-        ret = sendfile(toFd, fromFd, &offset, transfer_length);
-        if (ret != transfer_length) {
-            ret = -1;
-            PLOG(ERROR) << "Copying failed!";
-            break;
-        }
-    }
     auto end = std::chrono::steady_clock::now();
     std::chrono::duration<double> diff = end - start;
     LOG(DEBUG) << "Copied a file with MTP. Time: " << diff.count() << " s, Size: " << length <<
         ", Rate: " << ((double) length) / diff.count() << " bytes/s";
     chown(toPath, getuid(), FILE_GROUP);
     access_ok(toPath);
-    return ret == -1 ? -1 : 0;
+    return ret;
 }
 
 void deleteRecursive(const char* path) {
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of MtpFfsHandle file transfers, with the ffs endpoints replaced by
+// pipes as in MtpFfsHandle_test, so that it runs without a USB gadget.
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "MtpFfsHandle.h"
+#include "mtp.h"
+
+using android::base::unique_fd;
+
+namespace android {
+
+constexpr int PIPE_SIZE = 1048576;
+
+class BenchmarkHandle : public MtpFfsHandle {
+public:
+    BenchmarkHandle() : MtpFfsHandle(-1) {}
+
+    // Replaces the endpoints with pipes and returns the host side of the bulk ones.
+    bool openPipes(unique_fd* bulkIn, unique_fd* bulkOut) {
+        int fd[2];
+        if (pipe(fd) != 0) return false;
+        mControlHost.reset(fd[0]);
+        mControl.reset(fd[1]);
+
+        if (pipe(fd) != 0) return false;
+        fcntl(fd[0], F_SETPIPE_SZ, PIPE_SIZE);
+        bulkIn->reset(fd[0]);
+        mBulkIn.reset(fd[1]);
+
+        if (pipe(fd) != 0) return false;
+        fcntl(fd[0], F_SETPIPE_SZ, PIPE_SIZE);
+        bulkOut->reset(fd[1]);
+        mBulkOut.reset(fd[0]);
+
+        if (pipe(fd) != 0) return false;
+        mIntrHost.reset(fd[0]);
+        mIntr.reset(fd[1]);
+        return start(false) == 0;
+    }
+
+private:
+    unique_fd mControlHost;
+    unique_fd mIntrHost;
+};
+
+static void fillFile(int fd, size_t size) {
+    std::vector<char> data(size, 'm');
+    if (!base::WriteFully(fd, data.data(), size)) {
+        abort();
+    }
+}
+
+// Reads what the device sends until the handle is closed.
+static void drain(int fd) {
+    std::vector<char> buf(PIPE_SIZE);
+    while (TEMP_FAILURE_RETRY(::read(fd, buf.data(), buf.size())) > 0) {
+    }
+}
+
+static void BM_SendFile(benchmark::State& state) {
+    const size_t size = state.range(0);
+    TemporaryFile file;
+    fillFile(file.fd, size);
+
+    BenchmarkHandle handle;
+    unique_fd bulkIn, bulkOut;
+    if (!handle.openPipes(&bulkIn, &bulkOut)) {
+        state.SkipWithError("cannot set up the endpoints");
+        return;
+    }
+    std::thread host(drain, bulkIn.get());
+
+    mtp_file_range mfr = {};
+    mfr.fd = file.fd;
+    mfr.offset = 0;
+    mfr.length = size;
+    mfr.command = MTP_OPERATION_GET_OBJECT;
+    for (auto _ : state) {
+        if (handle.sendFile(mfr) != 0) {
+            state.SkipWithError("sendFile failed");
+            break;
+        }
+    }
+    handle.close();
+    host.join();
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+static void BM_ReceiveFile(benchmark::State& state) {
+    const size_t size = state.range(0);
+    TemporaryFile file;
+
+    BenchmarkHandle handle;
+    unique_fd bulkIn, bulkOut;
+    if (!handle.openPipes(&bulkIn, &bulkOut)) {
+        state.SkipWithError("cannot set up the endpoints");
+        return;
+    }
+    // A failed receive leaves the host writing to a closed pipe.
+    signal(SIGPIPE, SIG_IGN);
+    // The host sends every file up front, the pipe holds back what is not received yet.
+    const int64_t files = state.max_iterations;
+    std::thread host([&bulkOut, size, files] {
+        std::vector<char> data(size, 'm');
+        for (int64_t i = 0; i < files; i++) {
+            if (!base::WriteFully(bulkOut.get(), data.data(), size)) break;
+        }
+    });
+
+    mtp_file_range mfr = {};
+    mfr.fd = file.fd;
+    mfr.offset = 0;
+    mfr.length = size;
+    for (auto _ : state) {
+        if (handle.receiveFile(mfr, false) != 0) {
+            state.SkipWithError("receiveFile failed");
+            break;
+        }
+    }
+    handle.close();
+    host.join();
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+// Sizes are not multiples of the packet size, so that no zero length packet is expected.
+BENCHMARK(BM_SendFile)->Arg(1000)->Arg(100000)->Arg(4000000)->Arg(64000100)->UseRealTime();
+BENCHMARK(BM_ReceiveFile)->Arg(1000)->Arg(100000)->Arg(4000000)->Arg(64000100)->UseRealTime();
+
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -731,6 +731,27 @@ media_status_t AMediaCodec_queueInputBuffer(AMediaCodec *mData,
     return translate_error(ret);
 }
 
+EXPORT
+media_status_t AMediaCodec_queueInputBuffers(AMediaCodec *mData,
+        size_t idx, const AMediaCodecBufferInfo *infos, size_t count) {
+    if (infos == nullptr || count == 0) {
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    std::vector<AccessUnitInfo> accessUnits;
+    accessUnits.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (infos[i].offset < 0 || infos[i].size < 0) {
+            return AMEDIA_ERROR_INVALID_PARAMETER;
+        }
+        accessUnits.push_back({(size_t)infos[i].offset, (size_t)infos[i].size,
+                infos[i].presentationTimeUs, infos[i].flags});
+    }
+
+    AString errorMsg;
+    status_t ret = mData->mCodec->queueInputBuffers(idx, accessUnits, &errorMsg);
+    return translate_error(ret);
+}
+
 EXPORT
 ssize_t AMediaCodec_dequeueOutputBuffer(AMediaCodec *mData,
         AMediaCodecBufferInfo *info, int64_t timeoutUs) {
@@ -266,6 +266,24 @@ media_status_t AMediaCodec_queueInputBuffer(AMediaCodec*, size_t idx,
                                             _off_t_compat offset, size_t size,
                                             uint64_t time, uint32_t flags) __INTRODUCED_IN(21);
 
+/**
+ * Send the specified buffer, holding |count| access units back to back, to the
+ * codec for processing. Each access unit is described by one of |infos|, with
+ * its offset in the buffer, size, presentation time and flags. Only
+ * AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG and, on the last access unit,
+ * AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM are allowed.
+ *
+ * This saves a dequeue and queue round trip per access unit, which is useful
+ * for codecs with small access units, such as audio codecs. Returns
+ * AMEDIA_ERROR_UNSUPPORTED if the codec cannot take access units this way,
+ * in which case they must be queued one by one.
+ *
+ * Available since Android T.
+ */
+media_status_t AMediaCodec_queueInputBuffers(AMediaCodec*, size_t idx,
+                                             const AMediaCodecBufferInfo *infos,
+                                             size_t count) __INTRODUCED_IN(__ANDROID_API_T__);
+
 /**
  * Send the specified buffer to the codec for processing.
  *
@@ -87,3 +87,102 @@ void Stats::dumpStatistics(string operation, string inputReference, int64_t dura
     out << rowData;
     out.close();
 }
+
+std::vector<nsecs_t> Stats::getOutputIntervals() {
+    std::vector<nsecs_t> intervals;
+    nsecs_t prevTimeNs = mStartTimeNs;
+    for (nsecs_t timeNs : mOutputTimer) {
+        intervals.push_back(timeNs - prevTimeNs);
+        prevTimeNs = timeNs;
+    }
+    return intervals;
+}
+
+nsecs_t Stats::getPercentile(const std::vector<nsecs_t> &sortedValues, int32_t percent) {
+    if (sortedValues.empty()) return -1;
+    size_t idx = (sortedValues.size() * percent + 99) / 100;
+    return sortedValues.at(idx ? idx - 1 : 0);
+}
+
+static string getJsonPercentiles(std::vector<nsecs_t> values) {
+    std::sort(values.begin(), values.end());
+    string json = "{";
+    json.append("\"p50\": " + to_string(Stats::getPercentile(values, 50)) + ", ");
+    json.append("\"p90\": " + to_string(Stats::getPercentile(values, 90)) + ", ");
+    json.append("\"p99\": " + to_string(Stats::getPercentile(values, 99)) + ", ");
+    json.append("\"max\": " + to_string(values.empty() ? -1 : values.back()) + "}");
+    return json;
+}
+
+/**
+ * Returns the stats of one instance as a JSON object. The per-frame times are
+ * the intervals between outputs, as for the minimum and maximum in the CSV.
+ */
+string Stats::getJsonStatistics() {
+    int64_t size = std::accumulate(mFrameSizes.begin(), mFrameSizes.end(), (int64_t)0);
+    nsecs_t timeToFirstFrameNs = mOutputTimer.empty() ? -1 : mOutputTimer.front() - mStartTimeNs;
+    string json = "{";
+    json.append("\"setupTimeNs\": " + to_string(mInitTimeNs) + ", ");
+    json.append("\"destroyTimeNs\": " + to_string(mDeInitTimeNs) + ", ");
+    json.append("\"timeToFirstFrameNs\": " + to_string(timeToFirstFrameNs) + ", ");
+    json.append("\"totalTimeNs\": " + to_string(getTotalTime()) + ", ");
+    json.append("\"frames\": " + to_string(mOutputTimer.size()) + ", ");
+    json.append("\"totalSizeInBytes\": " + to_string(size) + ", ");
+    json.append("\"frameTimeNs\": " + getJsonPercentiles(getOutputIntervals()) + "}");
+    return json;
+}
+
+/**
+ * Dumps the stats of instances of an operation that ran concurrently on the
+ * same input media, as one JSON object per line of the file.
+ *
+ * \param instances      the stats of each of the instances.
+ * \param wallTimeNs     time from the start of the first to the end of the last instance.
+ * \param cpuTimeNs      CPU time used by this process while the instances ran. It does
+ *                       not include the time of the codecs hosted by the media services.
+ * \param jsonFile       the file where the stats data is to be appended.
+ */
+void Stats::dumpConcurrentStatistics(const std::vector<Stats *> &instances, string operation,
+                                     string inputReference, int64_t durationUs,
+                                     string componentName, string mode, nsecs_t wallTimeNs,
+                                     nsecs_t cpuTimeNs, string jsonFile) {
+    ALOGV("In %s", __func__);
+    int64_t frames = 0;
+    std::vector<nsecs_t> frameTimes;
+    string instanceData = "";
+    for (Stats *stats : instances) {
+        frames += stats->mOutputTimer.size();
+        std::vector<nsecs_t> intervals = stats->getOutputIntervals();
+        frameTimes.insert(frameTimes.end(), intervals.begin(), intervals.end());
+        if (!instanceData.empty()) instanceData.append(", ");
+        instanceData.append(stats->getJsonStatistics());
+    }
+    if (!frames || wallTimeNs <= 0) {
+        ALOGE("No output produced");
+        return;
+    }
+
+    string json = "{";
+    json.append("\"currentTime\": " + to_string(systemTime(CLOCK_MONOTONIC)) + ", ");
+    json.append("\"fileName\": \"" + inputReference + "\", ");
+    json.append("\"operation\": \"" + operation + "\", ");
+    json.append("\"componentName\": \"" + componentName + "\", ");
+    json.append("\"mode\": \"" + mode + "\", ");
+    json.append("\"instances\": " + to_string(instances.size()) + ", ");
+    json.append("\"durationUs\": " + to_string(durationUs) + ", ");
+    json.append("\"wallTimeNs\": " + to_string(wallTimeNs) + ", ");
+    json.append("\"frames\": " + to_string(frames) + ", ");
+    json.append("\"framesPerSec\": " + to_string(frames * 1000000000 / wallTimeNs) + ", ");
+    json.append("\"cpuTimeNsPerFrame\": " + to_string(cpuTimeNs / frames) + ", ");
+    json.append("\"peakRssKb\": " + to_string(getPeakRssKb()) + ", ");
+    json.append("\"frameTimeNs\": " + getJsonPercentiles(frameTimes) + ", ");
+    json.append("\"perInstance\": [" + instanceData + "]}\n");
+
+    ofstream out(jsonFile, ios::out | ios::app);
+    if (out.bad()) {
+        ALOGE("Failed to open stats file for writing!");
+        return;
+    }
+    out << json;
+    out.close();
+}
@@ -39,9 +39,11 @@
 #endif
 #endif  // ALOG
 
+#include <sys/resource.h>
 #include <sys/time.h>
 #include <algorithm>
 #include <numeric>
+#include <string>
 #include <vector>
 
 // Include local copy of Timers taken from system/core/libutils
@@ -102,8 +104,32 @@ class Stats {
         return (*(mOutputTimer.end() - 1) - mStartTimeNs);
     }
 
+    // Intervals between consecutive outputs, the first one from the start time.
+    std::vector<nsecs_t> getOutputIntervals();
+
+    // Returns the value below which the given percentage of the sorted values fall.
+    static nsecs_t getPercentile(const std::vector<nsecs_t> &sortedValues, int32_t percent);
+
+    // CPU time used by all the threads of this process so far.
+    static nsecs_t getProcessCpuTime() { return systemTime(SYSTEM_TIME_PROCESS); }
+
+    // Peak resident set size of this process, in kilobytes.
+    static int64_t getPeakRssKb() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage)) return -1;
+        return usage.ru_maxrss;
+    }
+
     void dumpStatistics(string operation, string inputReference, int64_t duarationUs,
                         string codecName = "", string mode = "", string statsFile = "");
+
+    string getJsonStatistics();
+
+    static void dumpConcurrentStatistics(const std::vector<Stats *> &instances,
+                                         string operation, string inputReference,
+                                         int64_t durationUs, string componentName,
+                                         string mode, nsecs_t wallTimeNs, nsecs_t cpuTimeNs,
+                                         string jsonFile);
 };
 
 #endif  // __STATS_H__
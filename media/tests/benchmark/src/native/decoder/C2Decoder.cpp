@@ -19,6 +19,7 @@
 #include <log/log.h>
 
 #include "C2Decoder.h"
+#include <algorithm>
 #include <iostream>
 
 int32_t C2Decoder::createCodec2Component(string compName, AMediaFormat *format) {
@@ -65,6 +66,10 @@ int32_t C2Decoder::createCodec2Component(string compName, AMediaFormat *format)
         return -1;
     }
 
+    C2PortMaxAccessUnitCountInfo::input maxAccessUnitCount(1u);
+    (void)mComponent->query({&maxAccessUnitCount}, {}, C2_DONT_BLOCK, nullptr);
+    mMaxAccessUnitCount = maxAccessUnitCount ? std::max(maxAccessUnitCount.value, 1u) : 1u;
+
     status |= mComponent->start();
     int64_t eTime = mStats->getCurTime();
     int64_t timeTaken = mStats->getTimeDiff(sTime, eTime);
@@ -95,17 +100,28 @@ int32_t C2Decoder::decodeFrames(uint8_t *inputBuffer, vector<AMediaCodecBufferIn
         }
 
         uint32_t flags = frameInfo[mNumInputFrame].flags;
+        // Consecutive frames other than codec config share a work, up to the access units
+        // per work requested and supported by the component.
+        size_t numFrames = 1;
+        int size = frameInfo[mNumInputFrame].size;
         if (flags == AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) {
             flags = C2FrameData::FLAG_CODEC_CONFIG;
+        } else {
+            size_t maxFrames = std::min(mAccessUnitsPerWork, (size_t)mMaxAccessUnitCount);
+            while (numFrames < maxFrames && mNumInputFrame + numFrames < frameInfo.size() &&
+                   frameInfo[mNumInputFrame + numFrames].flags !=
+                           AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) {
+                size += frameInfo[mNumInputFrame + numFrames].size;
+                numFrames++;
+            }
         }
-        if (mNumInputFrame == (frameInfo.size() - 1)) {
+        if (mNumInputFrame + numFrames == frameInfo.size()) {
             flags |= C2FrameData::FLAG_END_OF_STREAM;
         }
         work->input.flags = (C2FrameData::flags_t)flags;
         work->input.ordinal.timestamp = frameInfo[mNumInputFrame].presentationTimeUs;
         work->input.ordinal.frameIndex = mNumInputFrame;
         work->input.buffers.clear();
-        int size = frameInfo[mNumInputFrame].size;
         int alignedSize = ALIGN(size, PAGE_SIZE);
         if (size) {
             std::shared_ptr<C2LinearBlock> block;
@@ -122,7 +138,16 @@ int32_t C2Decoder::decodeFrames(uint8_t *inputBuffer, vector<AMediaCodecBufferIn
                 return view.error();
             }
             memcpy(view.base(), inputBuffer + mOffset, size);
-            work->input.buffers.emplace_back(new LinearBuffer(block, size));
+            std::shared_ptr<C2Buffer> buffer(new LinearBuffer(block, size));
+            if (numFrames > 1) {
+                std::vector<C2AccessUnitInfosStruct> infos;
+                for (size_t i = 0; i < numFrames; i++) {
+                    const AMediaCodecBufferInfo &frame = frameInfo[mNumInputFrame + i];
+                    infos.emplace_back(0u, frame.size, frame.presentationTimeUs);
+                }
+                buffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(infos, 0u));
+            }
+            work->input.buffers.push_back(buffer);
             mStats->addFrameSize(size);
         }
         work->worklets.clear();
@@ -136,8 +161,8 @@ int32_t C2Decoder::decodeFrames(uint8_t *inputBuffer, vector<AMediaCodecBufferIn
             ALOGE("queue failed");
             return status;
         }
-        ALOGV("Frame #%d size = %d queued", mNumInputFrame, size);
-        mNumInputFrame++;
+        ALOGV("Frame #%d size = %d, %zu frames queued", mNumInputFrame, size, numFrames);
+        mNumInputFrame += numFrames;
         mOffset += size;
     }
     return status;
@@ -159,12 +184,13 @@ void C2Decoder::deInitCodec() {
 void C2Decoder::dumpStatistics(string inputReference, int64_t durationUs, string componentName,
                                string statsFile) {
     string operation = "c2decode";
-    string mode = "async";
+    string mode = mAccessUnitsPerWork > 1 && mMaxAccessUnitCount > 1 ? "async-multi-au" : "async";
     mStats->dumpStatistics(operation, inputReference, durationUs, componentName, mode, statsFile);
 }
 
 void C2Decoder::resetDecoder() {
     mOffset = 0;
     mNumInputFrame = 0;
+    mEos = false;
     if (mStats) mStats->reset();
 }
@@ -23,7 +23,12 @@
 
 class C2Decoder : public BenchmarkC2Common {
   public:
-    C2Decoder() : mOffset(0), mNumInputFrame(0), mComponent(nullptr) {}
+    C2Decoder()
+        : mOffset(0),
+          mNumInputFrame(0),
+          mAccessUnitsPerWork(1),
+          mMaxAccessUnitCount(1),
+          mComponent(nullptr) {}
 
     int32_t createCodec2Component(string codecName, AMediaFormat *format);
 
@@ -36,9 +41,19 @@ class C2Decoder : public BenchmarkC2Common {
 
     void resetDecoder();
 
+    // Frames queued per work, if the component takes several access units per work.
+    void setAccessUnitsPerWork(size_t accessUnitsPerWork) {
+        mAccessUnitsPerWork = accessUnitsPerWork;
+    }
+
+    // Access units the component takes per work, valid after createCodec2Component().
+    uint32_t getMaxAccessUnitCount() const { return mMaxAccessUnitCount; }
+
   private:
     int32_t mOffset;
     int32_t mNumInputFrame;
+    size_t mAccessUnitsPerWork;
+    uint32_t mMaxAccessUnitCount;
     vector<AMediaCodecBufferInfo> mFrameMetaData;
 
     std::shared_ptr<android::Codec2Client::Listener> mListener;
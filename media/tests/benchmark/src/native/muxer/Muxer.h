@@ -33,7 +33,9 @@ typedef enum {
 
 class Muxer {
   public:
-    Muxer() : mFormat(nullptr), mMuxer(nullptr), mStats(nullptr) { mExtractor = new Extractor(); }
+    Muxer() : mFormat(nullptr), mMuxer(nullptr), mStats(nullptr), mTrackCount(0) {
+        mExtractor = new Extractor();
+    }
 
     virtual ~Muxer() {
         if (mStats) delete mStats;
@@ -44,7 +46,9 @@ class Muxer {
     Extractor *getExtractor() { return mExtractor; }
 
     /* Muxer related utilities */
-    int32_t initMuxer(int32_t fd, MUXER_OUTPUT_T outputFormat);
+    // Adds trackCount tracks of the extractor's format, which mux() writes the
+    // same samples to, to measure multi-track interleaving.
+    int32_t initMuxer(int32_t fd, MUXER_OUTPUT_T outputFormat, int32_t trackCount = 1);
     void deInitMuxer();
     void resetMuxer();
 
@@ -58,6 +62,7 @@ class Muxer {
     AMediaMuxer *mMuxer;
     Extractor *mExtractor;
     Stats *mStats;
+    int32_t mTrackCount;
 };
 
 #endif  // __MUXER_H__
@@ -27,7 +27,8 @@ class BenchmarkTestEnvironment : public ::testing::Environment {
   public:
     BenchmarkTestEnvironment()
         : res("/data/local/tmp/MediaBenchmark/res/"),
-          statsFile("/data/local/tmp/MediaBenchmark/res/stats.csv") {}
+          statsFile("/data/local/tmp/MediaBenchmark/res/stats.csv"),
+          instances(1) {}
 
     // Parses the command line argument
     int initFromOptions(int argc, char **argv);
@@ -42,17 +43,31 @@ class BenchmarkTestEnvironment : public ::testing::Environment {
 
     bool writeStatsHeader();
 
+    void setInstances(int32_t _instances) { instances = _instances; }
+
+    int32_t getInstances() const { return instances; }
+
+    void setJsonFile(const char *_jsonFile) { jsonFile = _jsonFile; }
+
+    // Empty unless the concurrent tests are to be run.
+    const string getJsonFile() const { return jsonFile; }
+
   private:
     string res;
     string statsFile;
+    int32_t instances;
+    string jsonFile;
 };
 
 int BenchmarkTestEnvironment::initFromOptions(int argc, char **argv) {
-    static struct option options[] = {{"path", required_argument, 0, 'P'}, {0, 0, 0, 0}};
+    static struct option options[] = {{"path", required_argument, 0, 'P'},
+                                      {"instances", required_argument, 0, 'N'},
+                                      {"json", required_argument, 0, 'J'},
+                                      {0, 0, 0, 0}};
 
     while (true) {
         int index = 0;
-        int c = getopt_long(argc, argv, "P:", options, &index);
+        int c = getopt_long(argc, argv, "P:N:J:", options, &index);
         if (c == -1) {
             break;
         }
@@ -62,17 +77,33 @@ int BenchmarkTestEnvironment::initFromOptions(int argc, char **argv) {
                 setRes(optarg);
                 break;
             }
+            case 'N': {
+                setInstances(atoi(optarg));
+                break;
+            }
+            case 'J': {
+                setJsonFile(optarg);
+                break;
+            }
             default:
                 break;
         }
     }
 
+    if (instances < 1) {
+        fprintf(stderr, "invalid number of instances: %d\n", instances);
+        return 2;
+    }
+
     if (optind < argc) {
         fprintf(stderr,
                 "unrecognized option: %s\n\n"
                 "usage: %s <gtest options> <test options>\n\n"
                 "test options are:\n\n"
-                "-P, --path: Resource files directory location\n",
+                "-P, --path: Resource files directory location\n"
+                "-N, --instances: Number of instances run concurrently, default 1\n"
+                "-J, --json: File the concurrent test results are appended to as JSON,\n"
+                "            the concurrent tests only run when it is given\n",
                 argv[optind ?: 1], argv[0]);
         return 2;
     }
@@ -27,6 +27,8 @@
 
 static BenchmarkTestEnvironment *gEnv = nullptr;
 
+constexpr size_t kAccessUnitsPerWork = 8;
+
 class C2DecoderTest : public ::testing::TestWithParam<pair<string, string>> {
   public:
     C2DecoderTest() : mDecoder(nullptr) {}
@@ -123,22 +125,32 @@ TEST_P(C2DecoderTest, Codec2Decode) {
         for (string codecName : mCodecList) {
             if (codecName.find(GetParam().second) != string::npos &&
                 codecName.find("secure") == string::npos) {
-                status = mDecoder->createCodec2Component(codecName, format);
-                ASSERT_EQ(status, 0) << "Create component failed for " << codecName;
-
-                // Send the inputs to C2 Decoder and wait till all buffers are returned.
-                status = mDecoder->decodeFrames(inputBuffer, frameInfo);
-                ASSERT_EQ(status, 0) << "Decoder failed for " << codecName;
-
-                mDecoder->waitOnInputConsumption();
-                ASSERT_TRUE(mDecoder->mEos) << "Test Failed. Didn't receive EOS \n";
-
-                mDecoder->deInitCodec();
-                int64_t durationUs = extractor->getClipDuration();
-                ALOGV("codec : %s", codecName.c_str());
-                mDecoder->dumpStatistics(GetParam().first, durationUs, codecName,
-                                         gEnv->getStatsFile());
-                mDecoder->resetDecoder();
+                // Decode again with several access units per work, if supported, to compare
+                // the frames per second with the default of one.
+                for (size_t accessUnitsPerWork : {(size_t)1, kAccessUnitsPerWork}) {
+                    status = mDecoder->createCodec2Component(codecName, format);
+                    ASSERT_EQ(status, 0) << "Create component failed for " << codecName;
+                    if (accessUnitsPerWork > 1 && mDecoder->getMaxAccessUnitCount() == 1) {
+                        mDecoder->deInitCodec();
+                        mDecoder->resetDecoder();
+                        break;
+                    }
+                    mDecoder->setAccessUnitsPerWork(accessUnitsPerWork);
+
+                    // Send the inputs to C2 Decoder and wait till all buffers are returned.
+                    status = mDecoder->decodeFrames(inputBuffer, frameInfo);
+                    ASSERT_EQ(status, 0) << "Decoder failed for " << codecName;
+
+                    mDecoder->waitOnInputConsumption();
+                    ASSERT_TRUE(mDecoder->mEos) << "Test Failed. Didn't receive EOS \n";
+
+                    mDecoder->deInitCodec();
+                    int64_t durationUs = extractor->getClipDuration();
+                    ALOGV("codec : %s", codecName.c_str());
+                    mDecoder->dumpStatistics(GetParam().first, durationUs, codecName,
+                                             gEnv->getStatsFile());
+                    mDecoder->resetDecoder();
+                }
             }
         }
         free(inputBuffer);
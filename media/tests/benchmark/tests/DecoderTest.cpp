@@ -96,6 +96,107 @@ TEST_P(DecoderTest, Decode) {
     delete decoder;
 }
 
+// An instance of the concurrent decode test, with its own extractor and codec.
+struct DecodeInstance {
+    FILE *inputFp = nullptr;
+    Decoder *decoder = nullptr;
+    uint8_t *inputBuffer = nullptr;
+    vector<AMediaCodecBufferInfo> frameInfo;
+    string codecName;
+    int32_t status = AMEDIA_OK;
+    bool decoded = false;
+};
+
+// Reads the frames of the first track into the instance, ready to be decoded.
+static void setupDecodeInstance(const string &inputFile, DecodeInstance *instance) {
+    instance->inputFp = fopen(inputFile.c_str(), "rb");
+    ASSERT_NE(instance->inputFp, nullptr) << "Unable to open " << inputFile << " file for reading";
+
+    instance->decoder = new Decoder();
+    Extractor *extractor = instance->decoder->getExtractor();
+    ASSERT_NE(extractor, nullptr) << "Extractor creation failed";
+
+    struct stat buf;
+    stat(inputFile.c_str(), &buf);
+    int32_t trackCount = extractor->initExtractor(fileno(instance->inputFp), buf.st_size);
+    ASSERT_GT(trackCount, 0) << "initExtractor failed";
+    ASSERT_EQ(extractor->setupTrackFormat(0), 0) << "Track Format invalid";
+
+    instance->inputBuffer = (uint8_t *)malloc(kMaxBufferSize);
+    ASSERT_NE(instance->inputBuffer, nullptr) << "Insufficient memory";
+
+    AMediaCodecBufferInfo info;
+    uint32_t inputBufferOffset = 0;
+    while (!extractor->getFrameSample(info) && info.size) {
+        ASSERT_LE(inputBufferOffset + info.size, kMaxBufferSize)
+                << "Memory allocated not sufficient";
+        memcpy(instance->inputBuffer + inputBufferOffset, extractor->getFrameBuf(), info.size);
+        instance->frameInfo.push_back(info);
+        inputBufferOffset += info.size;
+    }
+    instance->decoder->setupDecoder();
+}
+
+static void releaseDecodeInstance(DecodeInstance *instance) {
+    if (instance->decoder) {
+        if (!instance->decoded) instance->decoder->deInitCodec();
+        instance->decoder->resetDecoder();
+        instance->decoder->getExtractor()->deInitExtractor();
+        delete instance->decoder;
+    }
+    if (instance->inputBuffer) free(instance->inputBuffer);
+    if (instance->inputFp) fclose(instance->inputFp);
+}
+
+// Decodes the first track with the given number of instances at the same time,
+// to measure how the throughput and the per-frame times scale with the load.
+TEST_P(DecoderTest, DecodeConcurrent) {
+    if (gEnv->getJsonFile().empty()) {
+        GTEST_SKIP() << "No JSON file given for the concurrent test results";
+    }
+    tuple<string /* InputFile */, string /* CodecName */, bool /* asyncMode */> params = GetParam();
+    string inputReference = get<0>(params);
+    bool asyncMode = get<2>(params);
+
+    vector<DecodeInstance> instances(gEnv->getInstances());
+    for (DecodeInstance &instance : instances) {
+        instance.codecName = get<1>(params);
+        setupDecodeInstance(gEnv->getRes() + inputReference, &instance);
+        if (HasFatalFailure()) break;
+    }
+
+    if (!HasFatalFailure()) {
+        nsecs_t cpuTimeNs = Stats::getProcessCpuTime();
+        nsecs_t startTimeNs = systemTime(CLOCK_MONOTONIC);
+        vector<thread> threads;
+        for (DecodeInstance &instance : instances) {
+            threads.emplace_back([&instance, asyncMode]() {
+                instance.status = instance.decoder->decode(
+                        instance.inputBuffer, instance.frameInfo, instance.codecName, asyncMode);
+            });
+        }
+        for (thread &decodeThread : threads) decodeThread.join();
+        nsecs_t wallTimeNs = systemTime(CLOCK_MONOTONIC) - startTimeNs;
+        cpuTimeNs = Stats::getProcessCpuTime() - cpuTimeNs;
+
+        vector<Stats *> stats;
+        for (DecodeInstance &instance : instances) {
+            EXPECT_EQ(instance.status, AMEDIA_OK) << "Decoder failed for " << instance.codecName;
+            instance.decoder->deInitCodec();
+            instance.decoded = true;
+            stats.push_back(instance.decoder->getStats());
+        }
+        if (!HasFailure()) {
+            Stats::dumpConcurrentStatistics(
+                    stats, "decode", inputReference,
+                    instances[0].decoder->getExtractor()->getClipDuration(),
+                    instances[0].codecName, (asyncMode ? "async" : "sync"), wallTimeNs, cpuTimeNs,
+                    gEnv->getJsonFile());
+        }
+    }
+    for (DecodeInstance &instance : instances) releaseDecodeInstance(&instance);
+}
+
 // TODO: (b/140549596)
 // Add wav files
 INSTANTIATE_TEST_SUITE_P(
@@ -49,13 +49,12 @@ static MUXER_OUTPUT_T getMuxerOutFormat(string fmt) {
     return format;
 }
 
-TEST_P(MuxerTest, Mux) {
-    ALOGV("Mux the samples given by extractor");
-    string inputFile = gEnv->getRes() + GetParam().first;
+// Muxes each track of inputFileName into its own file, as trackCount identical tracks.
+static void muxTracks(const string &inputFileName, const string &fmt, int32_t trackCount) {
+    string inputFile = gEnv->getRes() + inputFileName;
     FILE *inputFp = fopen(inputFile.c_str(), "rb");
     ASSERT_NE(inputFp, nullptr) << "Unable to open " << inputFile << " file for reading";
 
-    string fmt = GetParam().second;
     MUXER_OUTPUT_T outputFormat = getMuxerOutFormat(fmt);
     ASSERT_NE(outputFormat, MUXER_OUTPUT_FORMAT_INVALID) << "Invalid muxer output format";
 
@@ -106,14 +105,18 @@ TEST_P(MuxerTest, Mux) {
                 << "Unable to open output file" << outputFileName << " for writing";
 
         int32_t fd = fileno(outputFp);
-        status = muxerObj->initMuxer(fd, outputFormat);
+        status = muxerObj->initMuxer(fd, outputFormat, trackCount);
         ASSERT_EQ(status, 0) << "initMuxer failed";
 
         status = muxerObj->mux(inputBuffer, frameInfos);
         ASSERT_EQ(status, 0) << "Mux failed";
 
         muxerObj->deInitMuxer();
-        muxerObj->dumpStatistics(GetParam().first + "." + fmt.c_str(), fmt, gEnv->getStatsFile());
+        string reference = inputFileName + "." + fmt;
+        if (trackCount > 1) {
+            reference += "." + to_string(trackCount) + "tracks";
+        }
+        muxerObj->dumpStatistics(reference, fmt, gEnv->getStatsFile());
         free(inputBuffer);
         fclose(outputFp);
         muxerObj->resetMuxer();
@@ -123,6 +126,18 @@ TEST_P(MuxerTest, Mux) {
     delete muxerObj;
 }
 
+TEST_P(MuxerTest, Mux) {
+    ALOGV("Mux the samples given by extractor");
+    muxTracks(GetParam().first, GetParam().second, 1);
+}
+
+class MuxerMultiTrackTest : public ::testing::TestWithParam<pair<string, int32_t>> {};
+
+TEST_P(MuxerMultiTrackTest, Mux) {
+    ALOGV("Mux the samples given by extractor into several tracks at once");
+    muxTracks(GetParam().first, "mp4", GetParam().second);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         MuxerTestAll, MuxerTest,
         ::testing::Values(make_pair("crowd_1920x1080_25fps_4000kbps_vp8.webm", "webm"),
@@ -145,6 +160,13 @@ INSTANTIATE_TEST_SUITE_P(
                           make_pair("bbb_8000hz_1ch_8kbps_amrnb_5mins.3gp", "3gpp"),
                           make_pair("bbb_16000hz_1ch_9kbps_amrwb_5mins.3gp", "3gpp")));
 
+INSTANTIATE_TEST_SUITE_P(
+        MuxerMultiTrackTestAll, MuxerMultiTrackTest,
+        ::testing::Values(make_pair("crowd_1920x1080_25fps_6700kbps_h264.ts", 2),
+                          make_pair("crowd_1920x1080_25fps_6700kbps_h264.ts", 4),
+                          make_pair("bbb_44100hz_2ch_128kbps_aac_5mins.mp4", 4),
+                          make_pair("bbb_44100hz_2ch_128kbps_aac_5mins.mp4", 8)));
+
 int main(int argc, char **argv) {
     gEnv = new BenchmarkTestEnvironment();
     ::testing::AddGlobalTestEnvironment(gEnv);
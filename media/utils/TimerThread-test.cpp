@@ -16,6 +16,7 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mediautils/TimerThread.h>
 
@@ -209,6 +210,61 @@ INSTANTIATE_TEST_CASE_P(
         ::testing::Values(0.f, 0.5f, 1.f)
         );
 
+TEST(TimerThread, CancelFromOtherThread) {
+    std::atomic<bool> taskRan = false;
+    TimerThread thread;
+    TimerThread::Handle handle =
+            thread.scheduleTask("CancelFromOtherThread",
+                    [&taskRan](TimerThread::Handle handle __unused) {
+                            taskRan = true; }, 100ms, 0ms);
+    bool cancelled = false;
+    std::thread([&] { cancelled = thread.cancelTask(handle); }).join();
+    ASSERT_TRUE(cancelled);
+    ASSERT_FALSE(thread.cancelTask(handle));
+    ASSERT_EQ(0, countChars(thread.pendingToString(), REQUEST_START));
+    std::this_thread::sleep_for(100ms + kJitter);
+    ASSERT_FALSE(taskRan);
+    ASSERT_EQ(1, countChars(thread.retiredToString(), REQUEST_START));
+}
+
+TEST(TimerThread, ManyTasks) {
+    // Timeouts in each level of the timer wheel, cancelled by many threads.
+    constexpr size_t kThreads = 4;
+    constexpr size_t kTasks = 1000;
+    std::atomic<size_t> taskRan = 0;
+    TimerThread thread;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < kTasks; ++j) {
+                TimerThread::Handle handles[] = {
+                    thread.scheduleTask("Level0", [&taskRan](TimerThread::Handle) {
+                            ++taskRan; }, 200ms, 0ms),
+                    thread.scheduleTask("Level1", [&taskRan](TimerThread::Handle) {
+                            ++taskRan; }, 10s, 0ms),
+                    thread.scheduleTask("Overflow", [&taskRan](TimerThread::Handle) {
+                            ++taskRan; }, 60s, 0ms),
+                };
+                for (auto handle : handles) {
+                    ASSERT_TRUE(thread.cancelTask(handle));
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0, countChars(thread.pendingToString(), REQUEST_START));
+
+    // a task scheduled after is still run on time.
+    thread.scheduleTask("Last", [&taskRan](TimerThread::Handle) {
+            ++taskRan; }, 300ms, 0ms);
+    std::this_thread::sleep_for(300ms - kJitter);
+    ASSERT_EQ(0u, taskRan);
+    std::this_thread::sleep_for(2 * kJitter);
+    ASSERT_EQ(1u, taskRan);
+}
+
 TEST(TimerThread, TrackedTasks) {
     TimerThread thread;
 
@@ -16,6 +16,7 @@
 
 #define LOG_TAG "TimerThread"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
 #include <unistd.h>
@@ -274,8 +275,13 @@ void TimerThread::NoTimeoutMap::copyRequests(
     }
 }
 
+//static
+thread_local std::vector<std::shared_ptr<TimerThread::MonitorThread::Entry>>
+        TimerThread::MonitorThread::tScheduled;
+
 TimerThread::MonitorThread::MonitorThread(RequestQueue& timeoutQueue)
-        : mTimeoutQueue(timeoutQueue)
+        : mCurrentTick(toTick(std::chrono::steady_clock::now()))
+        , mTimeoutQueue(timeoutQueue)
         , mThread([this] { threadFunc(); }) {
      pthread_setname_np(mThread.native_handle(), "TimerThread");
      pthread_setschedprio(mThread.native_handle(), PRIORITY_URGENT_AUDIO);
@@ -288,139 +294,283 @@ TimerThread::MonitorThread::~MonitorThread() {
         mCond.notify_all();
     }
     mThread.join();
+
+    // Entries may still be referenced by the threads that scheduled them,
+    // make sure they can no longer be cancelled.
+    std::vector<std::shared_ptr<Entry>> released;
+    std::lock_guard _l(mMutex);
+    drainIncoming_l(released);
+    forEachEntry_l([](const std::shared_ptr<Entry>& entry) {
+        entry->state = State::CANCELLED;
+    });
+}
+
+TimerThread::Handle TimerThread::MonitorThread::getUniqueHandle(Duration timeout) {
+    constexpr int64_t kSequenceMask = (int64_t{1} << kHandleSequenceBits) - 1;
+    const int64_t sequence = mHandleSequence.fetch_add(1, std::memory_order_relaxed);
+    const int64_t deadline =
+            (std::chrono::steady_clock::now() + timeout).time_since_epoch().count();
+    return Handle(Duration((deadline & ~kSequenceMask)
+            | ((sequence << 1) & kSequenceMask)  // above the handle type bit.
+            | (int64_t)enum_as_value(HANDLE_TYPE::TIMEOUT)));
 }
 
 void TimerThread::MonitorThread::threadFunc() {
+    // Entries released (cancelled or timed out) are destroyed outside of the lock.
+    std::vector<std::shared_ptr<Entry>> expired;
+    std::vector<std::shared_ptr<Entry>> released;
     std::unique_lock _l(mMutex);
     while (!mShouldExit) {
-        Handle nextDeadline = INVALID_HANDLE;
-        Handle now = INVALID_HANDLE;
-        if (!mMonitorRequests.empty()) {
-            nextDeadline = mMonitorRequests.begin()->first;
-            now = std::chrono::steady_clock::now();
-            if (nextDeadline < now) {
-                auto node = mMonitorRequests.extract(mMonitorRequests.begin());
-                // Deadline has expired, handle the request.
-                auto secondChanceDuration = node.mapped().first->secondChanceDuration;
-                if (secondChanceDuration.count() != 0) {
-                    // We now apply the second chance duration to find the clock
-                    // monotonic second deadline.  The unique key is then the
-                    // pair<second_deadline, first_deadline>.
-                    //
-                    // The second chance prevents a false timeout should there be
-                    // any clock monotonic advancement during suspend.
-                    auto newHandle = now + secondChanceDuration;
-                    ALOGD("%s: TimeCheck second chance applied for %s",
-                            __func__, node.mapped().first->tag.c_str()); // should be rare event.
-                    mSecondChanceRequests.emplace_hint(mSecondChanceRequests.end(),
-                            std::make_pair(newHandle, nextDeadline),
-                            std::move(node.mapped()));
-                    // increment second chance counter.
-                    mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
-                } else {
-                    {
-                        _l.unlock();
-                        // We add Request to retired queue early so that it can be dumped out.
-                        mTimeoutQueue.add(std::move(node.mapped().first));
-                        node.mapped().second(nextDeadline);
-                        // Caution: we don't hold lock when we call TimerCallback,
-                        // but this is the timeout case!  We will crash soon,
-                        // maybe before returning.
-                        // anything left over is released here outside lock.
-                    }
-                    // reacquire the lock - if something was added, we loop immediately to check.
-                    _l.lock();
-                }
-                // always process expiring monitor requests first.
-                continue;
+        drainIncoming_l(released);
+        const Handle now = std::chrono::steady_clock::now();
+        // process all ticks that have completely elapsed.
+        advance_l(toTick(now) - 1, now, expired, released);
+        if (!expired.empty() || !released.empty()) {
+            _l.unlock();
+            for (auto& entry : expired) {
+                // We add Request to retired queue early so that it can be dumped out.
+                mTimeoutQueue.add(entry->request);
+                entry->func(entry->handle);
+                // Caution: we don't hold lock when we call TimerCallback,
+                // but this is the timeout case!  We will crash soon,
+                // maybe before returning.
             }
+            // anything left over is released here outside lock.
+            expired.clear();
+            released.clear();
+            // reacquire the lock - if something was added, we loop immediately to check.
+            _l.lock();
+            continue;
         }
-        // now process any second chance requests.
-        if (!mSecondChanceRequests.empty()) {
-            Handle secondDeadline = mSecondChanceRequests.begin()->first.first;
-            if (now == INVALID_HANDLE) now = std::chrono::steady_clock::now();
-            if (secondDeadline < now) {
-                auto node = mSecondChanceRequests.extract(mSecondChanceRequests.begin());
-                {
-                    _l.unlock();
-                    // We add Request to retired queue early so that it can be dumped out.
-                    mTimeoutQueue.add(std::move(node.mapped().first));
-                    const Handle originalHandle = node.key().second;
-                    node.mapped().second(originalHandle);
-                    // Caution: we don't hold lock when we call TimerCallback.
-                    // This is benign issue - we permit concurrent operations
-                    // while in the callback to the MonitorQueue.
-                    //
-                    // Anything left over is released here outside lock.
-                }
-                // reacquire the lock - if something was added, we loop immediately to check.
-                _l.lock();
-                continue;
-            }
-            // update the deadline.
-            if (nextDeadline == INVALID_HANDLE) {
-                nextDeadline = secondDeadline;
+
+        const int64_t wakeupTick = getWakeupTick_l();
+        mWakeupTick = wakeupTick;
+        // requests added since the drain may need an earlier wakeup.
+        if (mIncoming.load() != nullptr) continue;
+        if (wakeupTick != INT64_MAX) {
+            mCond.wait_until(_l, fromTick(wakeupTick));
+        } else {
+            mCond.wait(_l);
+        }
+    }
+}
+
+void TimerThread::MonitorThread::drainIncoming_l(std::vector<std::shared_ptr<Entry>>& released) {
+    mIncomingCount = 0;
+    Entry* next = mIncoming.exchange(nullptr);
+    while (next != nullptr) {
+        std::shared_ptr<Entry> entry = std::move(next->self);
+        next = entry->next;
+        entry->next = nullptr;
+        if (entry->state == State::PENDING) {
+            insert_l(std::move(entry));
+        } else {
+            // cancelled before it reached the wheel, the common case.
+            released.emplace_back(std::move(entry));
+        }
+    }
+}
+
+void TimerThread::MonitorThread::insert_l(std::shared_ptr<Entry> entry) {
+    // A deadline already passed is handled with the next tick.
+    const int64_t tick = std::max(toTick(entry->deadline), mCurrentTick + 1);
+    if (tick - mCurrentTick < kWheel0Slots) {
+        mWheel0[tick & (kWheel0Slots - 1)].emplace_back(std::move(entry));
+    } else if ((tick >> kWheel0Bits) - (mCurrentTick >> kWheel0Bits) < kWheel1Slots) {
+        mWheel1[(tick >> kWheel0Bits) & (kWheel1Slots - 1)].emplace_back(std::move(entry));
+    } else {
+        mOverflow.emplace_back(std::move(entry));
+    }
+}
+
+void TimerThread::MonitorThread::advance_l(int64_t tick, Handle now,
+        std::vector<std::shared_ptr<Entry>>& expired,
+        std::vector<std::shared_ptr<Entry>>& released) {
+    std::vector<std::shared_ptr<Entry>> entries;
+    if (tick - mCurrentTick > kWheel0Slots * kWheel1Slots) {
+        // A long time has passed (e.g. suspend), rather than every tick
+        // we go through every entry.
+        forEachEntry_l([&entries](const std::shared_ptr<Entry>& entry) {
+            entries.emplace_back(entry);
+        });
+        for (auto& slot : mWheel0) slot.clear();
+        for (auto& slot : mWheel1) slot.clear();
+        mOverflow.clear();
+        mCurrentTick = tick;
+        for (auto& entry : entries) {
+            if (toTick(entry->deadline) <= tick) {
+                expire_l(std::move(entry), now, expired, released);
             } else {
-                nextDeadline = std::min(nextDeadline, secondDeadline);
+                insert_l(std::move(entry));
             }
         }
-        if (nextDeadline != INVALID_HANDLE) {
-            mCond.wait_until(_l, nextDeadline);
-        } else {
-            mCond.wait(_l);
+        return;
+    }
+    while (mCurrentTick < tick) {
+        const int64_t current = ++mCurrentTick;
+        if ((current & (kWheel0Slots - 1)) == 0) {
+            const int64_t block = current >> kWheel0Bits;
+            if ((block & (kWheel1Slots - 1)) == 0) {
+                // rescan the overflow once per revolution of the second level.
+                entries.swap(mOverflow);
+                for (auto& entry : entries) insert_l(std::move(entry));
+                entries.clear();
+            }
+            // cascade the block starting now into the first level.
+            entries.swap(mWheel1[block & (kWheel1Slots - 1)]);
+            for (auto& entry : entries) insert_l(std::move(entry));
+            entries.clear();
         }
+        entries.swap(mWheel0[current & (kWheel0Slots - 1)]);
+        for (auto& entry : entries) expire_l(std::move(entry), now, expired, released);
+        entries.clear();
+    }
+}
+
+void TimerThread::MonitorThread::expire_l(std::shared_ptr<Entry> entry, Handle now,
+        std::vector<std::shared_ptr<Entry>>& expired,
+        std::vector<std::shared_ptr<Entry>>& released) {
+    if (entry->state != State::PENDING) {
+        released.emplace_back(std::move(entry));
+        return;
+    }
+    // Deadline has expired, handle the request.
+    const auto secondChanceDuration = entry->request->secondChanceDuration;
+    if (!entry->secondChance && secondChanceDuration.count() != 0) {
+        // We now apply the second chance duration to find the clock
+        // monotonic second deadline.
+        //
+        // The second chance prevents a false timeout should there be
+        // any clock monotonic advancement during suspend.
+        ALOGD("%s: TimeCheck second chance applied for %s",
+                __func__, entry->request->tag.c_str()); // should be rare event.
+        entry->secondChance = true;
+        entry->deadline = now + secondChanceDuration;
+        insert_l(std::move(entry));
+        // increment second chance counter.
+        mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
+        return;
+    }
+    State pending = State::PENDING;
+    if (entry->state.compare_exchange_strong(pending, State::TIMED_OUT)) {
+        expired.emplace_back(std::move(entry));
+    } else {
+        released.emplace_back(std::move(entry));  // cancelled concurrently.
+    }
+}
+
+int64_t TimerThread::MonitorThread::getWakeupTick_l() const {
+    // A tick is processed once it has completely elapsed, so we wake up on the next one.
+    for (int64_t tick = mCurrentTick + 1; tick < mCurrentTick + kWheel0Slots; ++tick) {
+        if (!mWheel0[tick & (kWheel0Slots - 1)].empty()) return tick + 1;
     }
+    const int64_t currentBlock = mCurrentTick >> kWheel0Bits;
+    for (int64_t block = currentBlock + 1; block < currentBlock + kWheel1Slots; ++block) {
+        if (!mWheel1[block & (kWheel1Slots - 1)].empty()) return (block << kWheel0Bits) + 1;
+    }
+    if (!mOverflow.empty()) {
+        const int64_t block = (currentBlock | (kWheel1Slots - 1)) + 1;
+        return (block << kWheel0Bits) + 1;
+    }
+    return INT64_MAX;
+}
+
+template <typename F>
+void TimerThread::MonitorThread::forEachEntry_l(F f) const {
+    for (const auto& slot : mWheel0) {
+        for (const auto& entry : slot) f(entry);
+    }
+    for (const auto& slot : mWheel1) {
+        for (const auto& entry : slot) f(entry);
+    }
+    for (const auto& entry : mOverflow) f(entry);
 }
 
 TimerThread::Handle TimerThread::MonitorThread::add(
         std::shared_ptr<const Request> request, TimerCallback&& func, Duration timeout) {
-    std::lock_guard _l(mMutex);
-    const Handle handle = getUniqueHandle_l(timeout);
-    mMonitorRequests.emplace_hint(mMonitorRequests.end(),
-            handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
+    const Handle handle = getUniqueHandle(timeout);
+    auto entry = std::make_shared<Entry>(this, handle, std::move(request), std::move(func));
+
+    // Keep the entry for cancellation by this thread, forgetting those
+    // no longer pending (cancelled by another thread or timed out).
+    if (tScheduled.size() >= kMaxScheduledPerThread) {
+        tScheduled.erase(std::remove_if(tScheduled.begin(), tScheduled.end(),
+                [](const std::shared_ptr<Entry>& scheduled) {
+                    return scheduled->state != State::PENDING; }),
+                tScheduled.end());
+        if (tScheduled.size() >= kMaxScheduledPerThread) {
+            tScheduled.erase(tScheduled.begin());  // will be cancelled with the lock.
+        }
+    }
+    tScheduled.emplace_back(entry);
+
+    // Push to the incoming list.
+    Entry* const raw = entry.get();
+    raw->self = std::move(entry);
+    raw->next = mIncoming.load(std::memory_order_relaxed);
+    while (!mIncoming.compare_exchange_weak(raw->next, raw)) {}
+
+    // Wake the monitor thread if it would sleep past our deadline,
+    // or to drain a batch of requests.
+    if (toTick(handle) + 1 < mWakeupTick.load()
+            || mIncomingCount.fetch_add(1) + 1 >= kIncomingBatch) {
+        std::lock_guard _l(mMutex);
+        mCond.notify_all();
+    }
     return handle;
 }
 
 std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(Handle handle) {
-    std::pair<std::shared_ptr<const Request>, TimerCallback> data;
-    std::unique_lock ul(mMutex);
-    if (const auto it = mMonitorRequests.find(handle);
-        it != mMonitorRequests.end()) {
-        data = std::move(it->second);
-        mMonitorRequests.erase(it);
-        ul.unlock();  // manually release lock here so func (data.second)
-                      // is released outside of lock.
-        return data.first;  // request
+    State pending = State::PENDING;
+
+    // Lock-free, when cancelled by the thread that scheduled the request.
+    // Search from the back, as requests nest.
+    for (auto it = tScheduled.rbegin(); it != tScheduled.rend(); ++it) {
+        if ((*it)->owner == this && (*it)->handle == handle) {
+            std::shared_ptr<Entry> entry = std::move(*it);
+            tScheduled.erase(std::next(it).base());
+            if (!entry->state.compare_exchange_strong(pending, State::CANCELLED)) {
+                return {};  // timed out already.
+            }
+            return entry->request;
+        }
     }
 
-    // this check is O(N), but since the second chance requests are ordered
-    // in terms of earliest expiration time, we would expect better than average results.
-    for (auto it = mSecondChanceRequests.begin(); it != mSecondChanceRequests.end(); ++it) {
-        if (it->first.second == handle) {
-            data = std::move(it->second);
-            mSecondChanceRequests.erase(it);
-            ul.unlock();  // manually release lock here so func (data.second)
-                          // is released outside of lock.
-            return data.first; // request
+    // Otherwise look for the request with the lock.
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard _l(mMutex);
+        for (Entry* next = mIncoming.load(); next != nullptr; next = next->next) {
+            if (next->handle == handle) {
+                entry = next->self;
+                break;
+            }
         }
+        if (!entry) {
+            forEachEntry_l([&entry, handle](const std::shared_ptr<Entry>& e) {
+                if (e->handle == handle) entry = e;
+            });
+        }
+    }
+    if (!entry || !entry->state.compare_exchange_strong(pending, State::CANCELLED)) {
+        return {};
     }
-    return {};
+    return entry->request;
 }
 
 void TimerThread::MonitorThread::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
     std::lock_guard lg(mMutex);
-    for (const auto &[deadline, monitorpair] : mMonitorRequests) {
-        requests.emplace_back(monitorpair.first);
-    }
-    // we combine the second map with the first map - this is
-    // everything that is pending on the monitor thread.
-    // The second map will be older than the first map so this
-    // is in order.
-    for (const auto &[deadline, monitorpair] : mSecondChanceRequests) {
-        requests.emplace_back(monitorpair.first);
+    // Requests on the incoming list can only be removed by the monitor thread,
+    // which holds the lock.
+    for (Entry* next = mIncoming.load(); next != nullptr; next = next->next) {
+        if (next->state == State::PENDING) requests.emplace_back(next->request);
     }
+    // this is everything that is pending on the monitor thread,
+    // including requests given a second chance.
+    forEachEntry_l([&requests](const std::shared_ptr<Entry>& entry) {
+        if (entry->state == State::PENDING) requests.emplace_back(entry->request);
+    });
 }
 
 }  // namespace android::mediautils
@@ -16,8 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -26,6 +33,87 @@
 
 namespace android::mediautils {
 
+/**
+ * LatencyHistogram counts execution times in HDR histogram style buckets.
+ *
+ * Each power of 2 (in microseconds) is split into kSubBuckets linear
+ * sub-buckets, so a reported percentile is within 1 / (2 * kSubBuckets)
+ * of the recorded value, over a range of 1us to 2^32us (~71 minutes).
+ *
+ * Not thread-safe, the owner provides the locking.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr size_t kMaxValueBits = 32;
+    static constexpr size_t kBuckets = kSubBuckets * (kMaxValueBits - kSubBucketBits + 1);
+
+    void add(float executeMs) {
+        const float us = executeMs * 1000.f;
+        const uint64_t value = !(us > 0.f) ? 0  // includes NaN
+                : us >= (float)UINT32_MAX ? UINT32_MAX : (uint64_t)us;
+        ++mCounts[getBucket(value)];
+        ++mTotal;
+    }
+
+    void add(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBuckets; ++i) {
+            mCounts[i] += other.mCounts[i];
+        }
+        mTotal += other.mTotal;
+    }
+
+    uint64_t getTotal() const { return mTotal; }
+
+    /**
+     * Returns the value in ms below which percentile % of the values lie,
+     * or 0 if there are no values.
+     */
+    float getPercentile(float percentile) const {
+        if (mTotal == 0) return 0.f;
+        const uint64_t rank = std::clamp<uint64_t>(
+                (uint64_t)std::ceil(percentile / 100.f * mTotal), 1, mTotal);
+        uint64_t count = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            count += mCounts[i];
+            if (count >= rank) {
+                // report the middle of the bucket.
+                const auto [lower, width] = getBucketRange(i);
+                return (lower + (width - 1) * 0.5f) * 1e-3f;
+            }
+        }
+        return 0.f; // not reached.
+    }
+
+    std::string toString() const {
+        std::stringstream ss;
+        ss << "p50=" << getPercentile(50.f)
+                << " p99=" << getPercentile(99.f)
+                << " p99.9=" << getPercentile(99.9f);
+        return ss.str();
+    }
+
+    static size_t getBucket(uint64_t value) {
+        if (value < kSubBuckets) return value;
+        const size_t msb = 63 - __builtin_clzll(value);
+        const size_t shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + ((value >> shift) & (kSubBuckets - 1));
+    }
+
+    // Returns the lowest value and the number of values in the bucket.
+    static std::pair<uint64_t, uint64_t> getBucketRange(size_t bucket) {
+        if (bucket < kSubBuckets) return { bucket, 1 };
+        const size_t shift = bucket / kSubBuckets - 1;
+        const uint64_t sub = bucket % kSubBuckets;
+        return { (kSubBuckets + sub) << shift, uint64_t(1) << shift };
+    }
+
+private:
+    std::array<uint64_t, kBuckets> mCounts{};
+    uint64_t mTotal = 0;
+};
+
 /**
  * MethodStatistics is used to associate Binder codes
  * with a method name and execution time statistics.
@@ -35,6 +123,10 @@ namespace android::mediautils {
  *
  * Here, Code is the enumeration type for the method
  * lookup.
+ *
+ * Events are recorded in one of kShards shards, selected per calling thread,
+ * so binder threads do not contend on a single lock.  The shards are merged
+ * when the statistics are read.
  */
 template <typename Code>
 class MethodStatistics {
@@ -42,6 +134,26 @@ public:
     using FloatType = float;
     using StatsType = audio_utils::Statistics<FloatType>;
 
+    static constexpr size_t kShards = 8;
+
+    /**
+     * Execution time statistics and histogram for a method.
+     */
+    struct MethodData {
+        StatsType stats;
+        LatencyHistogram histogram;
+
+        void add(FloatType executeMs) {
+            stats.add(executeMs);
+            histogram.add(executeMs);
+        }
+
+        void add(const MethodData& other) {
+            stats.add(other.stats);
+            histogram.add(other.histogram);
+        }
+    };
+
     /**
      * Method statistics.
      *
@@ -57,15 +169,13 @@ public:
      */
     template <typename C>
     void event(C&& code, FloatType executeMs) {
-        std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.lower_bound(code);
-        if (it != mStatisticsMap.end() && it->first == code) {
-            it->second.add(executeMs);
-        } else {
-            // StatsType ctor takes an optional array of data for initialization.
-            FloatType dataArray[1] = { executeMs };
-            mStatisticsMap.emplace_hint(it, std::forward<C>(code), dataArray);
+        Shard& shard = mShards[getShardIndex()];
+        std::lock_guard lg(shard.mLock);
+        auto it = shard.mMethodDataMap.lower_bound(code);
+        if (it == shard.mMethodDataMap.end() || it->first != code) {
+            it = shard.mMethodDataMap.emplace_hint(it, std::forward<C>(code), MethodData{});
         }
+        it->second.add(executeMs);
     }
 
     /**
@@ -80,18 +190,50 @@ public:
      * Returns the number of times the method was invoked by event().
      */
     size_t getMethodCount(const Code& code) const {
-        std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? 0 : it->second.getN();
+        return getMethodData(code).stats.getN();
     }
 
     /**
      * Returns the statistics object for the method.
      */
     StatsType getStatistics(const Code& code) const {
-        std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? StatsType{} : it->second;
+        return getMethodData(code).stats;
+    }
+
+    /**
+     * Returns the execution time in ms below which percentile % of the
+     * method invocations completed, or 0 if the method was not invoked.
+     */
+    FloatType getPercentile(const Code& code, FloatType percentile) const {
+        return getMethodData(code).histogram.getPercentile(percentile);
+    }
+
+    /**
+     * Returns the merged statistics and histogram for the method.
+     */
+    MethodData getMethodData(const Code& code) const {
+        MethodData data;
+        for (const auto& shard : mShards) {
+            std::lock_guard lg(shard.mLock);
+            auto it = shard.mMethodDataMap.find(code);
+            if (it != shard.mMethodDataMap.end()) data.add(it->second);
+        }
+        return data;
+    }
+
+    /**
+     * Calls f(name, MethodData) with the merged data for each method invoked,
+     * for example to export the statistics.
+     */
+    template <typename F>
+    void forEachMethod(F&& f) const {
+        for (const auto &[code, data] : getAllMethodData()) {
+            if constexpr (std::is_same_v<Code, std::string>) {
+                f(code, data);
+            } else /* constexpr */ {
+                f(getMethodForCode(code), data);
+            }
+        }
     }
 
     /**
@@ -99,26 +241,46 @@ public:
      */
     std::string dump() const {
         std::stringstream ss;
-        std::lock_guard lg(mLock);
-        if constexpr (std::is_same_v<Code, std::string>) {
-            for (const auto &[code, stats] : mStatisticsMap) {
-                ss << code <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
-            }
-        } else /* constexpr */ {
-            for (const auto &[code, stats] : mStatisticsMap) {
-                ss << int(code) << " " << getMethodForCode(code) <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+        for (const auto &[code, data] : getAllMethodData()) {
+            if constexpr (std::is_same_v<Code, std::string>) {
+                ss << code;
+            } else /* constexpr */ {
+                ss << int(code) << " " << getMethodForCode(code);
             }
+            ss << " n=" << data.stats.getN() << " " << data.stats.toString()
+                    << " " << data.histogram.toString() << "\n";
         }
         return ss.str();
     }
 
 private:
+    struct alignas(64) Shard { // avoid false sharing between shards.
+        mutable std::mutex mLock;
+        std::map<Code, MethodData, std::less<>> mMethodDataMap GUARDED_BY(mLock);
+    };
+
+    // Threads are assigned to shards in turn on their first event.
+    static size_t getShardIndex() {
+        static std::atomic<size_t> nextIndex{};
+        thread_local const size_t index =
+                nextIndex.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return index;
+    }
+
+    std::map<Code, MethodData, std::less<>> getAllMethodData() const {
+        std::map<Code, MethodData, std::less<>> merged;
+        for (const auto& shard : mShards) {
+            std::lock_guard lg(shard.mLock);
+            for (const auto &[code, data] : shard.mMethodDataMap) {
+                merged[code].add(data);
+            }
+        }
+        return merged;
+    }
+
     // Note: we use a transparent comparator std::less<> for heterogeneous key lookup.
     const std::map<Code, std::string, std::less<>> mMethodMap;
-    mutable std::mutex mLock;
-    std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
+    std::array<Shard, kShards> mShards;
 };
 
 // Managed Statistics support.
@@ -16,14 +16,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <map>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 
@@ -276,26 +279,80 @@ class TimerThread {
     // This thread manages shared pointers to Requests and a function to
     // call on timeout.
     // This class is thread-safe.
+    //
+    // Requests are kept in a hierarchical timer wheel, which only the monitor
+    // thread modifies.  Scheduling does not take the lock: requests are pushed
+    // to a lock-free incoming list that the monitor thread drains in batches.
+    // The scheduling thread keeps its pending requests in a thread local list,
+    // so that the usual cancellation (by the thread that scheduled, as TimeCheck
+    // does) is also lock-free; requests cancelled that way are dropped when the
+    // monitor thread next reaches them.
     class MonitorThread {
+        enum class State : int {
+            PENDING,
+            CANCELLED,
+            TIMED_OUT,
+        };
+
+        struct Entry {
+            Entry(const MonitorThread* _owner, Handle _handle,
+                    std::shared_ptr<const Request> _request, TimerCallback&& _func)
+                : owner(_owner)
+                , handle(_handle)
+                , deadline(_handle)
+                , request(std::move(_request))
+                , func(std::move(_func))
+                {}
+
+            const MonitorThread* const owner;  // for matching, never dereferenced.
+            const Handle handle;               // the original deadline.
+            Handle deadline;                   // monitor thread only, moved by a second chance.
+            bool secondChance = false;         // monitor thread only.
+            const std::shared_ptr<const Request> request;
+            TimerCallback func;                // monitor thread only.
+            std::atomic<State> state{State::PENDING};
+
+            // While on the incoming list, the entry refers to itself.
+            std::shared_ptr<Entry> self;
+            Entry* next = nullptr;
+        };
+
+        // Timer wheel geometry: 1ms ticks, 256 ticks in the first level (256ms)
+        // and 64 blocks of 256 ticks in the second level (16.384s).
+        // Longer timeouts wait in an overflow list, rescanned every 64 blocks.
+        // Requests expire in the tick after their deadline, so up to 1ms late.
+        static constexpr Duration kTick = std::chrono::milliseconds(1);
+        static constexpr int64_t kWheel0Bits = 8;
+        static constexpr int64_t kWheel0Slots = 1 << kWheel0Bits;
+        static constexpr int64_t kWheel1Bits = 6;
+        static constexpr int64_t kWheel1Slots = 1 << kWheel1Bits;
+
+        // The monitor thread is woken to drain this many incoming requests,
+        // even if none of them is due earlier than what it is waiting for.
+        static constexpr size_t kIncomingBatch = 64;
+
+        // Pending requests kept per scheduling thread for lock-free cancellation.
+        static constexpr size_t kMaxScheduledPerThread = 16;
+        static thread_local std::vector<std::shared_ptr<Entry>> tScheduled;
+
+        // Handles carry a sequence number above the handle type bit, to keep
+        // them unique without a lookup. This moves the deadline less than 66us earlier.
+        static constexpr int64_t kHandleSequenceBits = 16;
+        std::atomic<int64_t> mHandleSequence{};
+
         std::atomic<size_t> mSecondChanceCount{};
         mutable std::mutex mMutex;
         mutable std::condition_variable mCond GUARDED_BY(mMutex);
 
-        // Ordered map of requests based on time of deadline.
-        //
-        std::map<Handle, std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                mMonitorRequests GUARDED_BY(mMutex);
+        std::atomic<Entry*> mIncoming{};
+        std::atomic<size_t> mIncomingCount{};
+        // The tick at which the monitor thread will next wake up.
+        std::atomic<int64_t> mWakeupTick{INT64_MAX};
 
-        // Due to monotonic/steady clock inaccuracies during suspend,
-        // we allow an additional second chance waiting time to prevent
-        // false removal.
-
-        // This mSecondChanceRequests queue is almost always empty.
-        // Using a pair with the original handle allows lookup and keeps
-        // the Key unique.
-        std::map<std::pair<Handle /* new */, Handle /* original */>,
-                std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                        mSecondChanceRequests GUARDED_BY(mMutex);
+        int64_t mCurrentTick GUARDED_BY(mMutex);  // the last tick processed.
+        std::array<std::vector<std::shared_ptr<Entry>>, kWheel0Slots> mWheel0 GUARDED_BY(mMutex);
+        std::array<std::vector<std::shared_ptr<Entry>>, kWheel1Slots> mWheel1 GUARDED_BY(mMutex);
+        std::vector<std::shared_ptr<Entry>> mOverflow GUARDED_BY(mMutex);
 
         RequestQueue& mTimeoutQueue; // locked internally, added to when request times out.
 
@@ -306,13 +363,26 @@ class TimerThread {
         // mThread should be initialized last as the thread is launched immediately.
         std::thread mThread;
 
-        void threadFunc();
-        Handle getUniqueHandle_l(Duration timeout) REQUIRES(mMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::TIMEOUT)>(
-                mMonitorRequests, timeout);
+        static int64_t toTick(Handle time) {
+            return time.time_since_epoch() / kTick;
+        }
+        static Handle fromTick(int64_t tick) {
+            return Handle(tick * kTick);
         }
 
+        void threadFunc();
+        Handle getUniqueHandle(Duration timeout);
+        void drainIncoming_l(std::vector<std::shared_ptr<Entry>>& released) REQUIRES(mMutex);
+        void insert_l(std::shared_ptr<Entry> entry) REQUIRES(mMutex);
+        void advance_l(int64_t tick, Handle now, std::vector<std::shared_ptr<Entry>>& expired,
+                std::vector<std::shared_ptr<Entry>>& released) REQUIRES(mMutex);
+        void expire_l(std::shared_ptr<Entry> entry, Handle now,
+                std::vector<std::shared_ptr<Entry>>& expired,
+                std::vector<std::shared_ptr<Entry>>& released) REQUIRES(mMutex);
+        int64_t getWakeupTick_l() const REQUIRES(mMutex);
+        template <typename F>
+        void forEachEntry_l(F f) const REQUIRES(mMutex);
+
       public:
         MonitorThread(RequestQueue &timeoutQueue);
         ~MonitorThread();
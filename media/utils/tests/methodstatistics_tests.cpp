@@ -20,7 +20,9 @@
 
 #include <atomic>
 #include <gtest/gtest.h>
+#include <thread>
 #include <utils/Log.h>
+#include <vector>
 
 using namespace android::mediautils;
 using CodeType = size_t;
@@ -70,3 +72,73 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+TEST(methodstatistics_tests, histogram_buckets) {
+    using H = LatencyHistogram;
+    // bucket ranges are contiguous and contain the values mapped to them.
+    uint64_t next = 0;
+    for (size_t i = 0; i < H::kBuckets; ++i) {
+        const auto [lower, width] = H::getBucketRange(i);
+        ASSERT_EQ(next, lower);
+        ASSERT_EQ(i, H::getBucket(lower));
+        ASSERT_EQ(i, H::getBucket(lower + width - 1));
+        next = lower + width;
+    }
+    ASSERT_EQ((uint64_t)UINT32_MAX + 1, next);
+}
+
+TEST(methodstatistics_tests, percentiles) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+    };
+
+    ASSERT_EQ(0.f, methodStatistics.getPercentile(HELLO_CODE, 50.f));
+
+    // 1ms to 1000ms.
+    for (int i = 1; i <= 1000; ++i) {
+        methodStatistics.event(HELLO_CODE, (float)i);
+    }
+    const auto expectNear = [&](float expected, float percentile) {
+        const float value = methodStatistics.getPercentile(HELLO_CODE, percentile);
+        EXPECT_NEAR(expected, value, expected / LatencyHistogram::kSubBuckets)
+                << "percentile " << percentile;
+    };
+    expectNear(500.f, 50.f);
+    expectNear(990.f, 99.f);
+    expectNear(999.f, 99.9f);
+    ASSERT_NE(std::string::npos, methodStatistics.dump().find("p99.9="));
+}
+
+TEST(methodstatistics_tests, threads) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+    };
+
+    // events from many threads are merged across the shards.
+    constexpr size_t kThreads = MethodStatistics<CodeType>::kShards * 2;
+    constexpr size_t kEvents = 1000;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&methodStatistics, i] {
+            for (size_t j = 0; j < kEvents; ++j) {
+                methodStatistics.event(i % 2 ? HELLO_CODE : WORLD_CODE, 2.f);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(kThreads / 2 * kEvents, methodStatistics.getMethodCount(HELLO_CODE));
+    ASSERT_EQ(kThreads / 2 * kEvents, methodStatistics.getMethodCount(WORLD_CODE));
+    ASSERT_EQ(2.f, methodStatistics.getStatistics(HELLO_CODE).getMean());
+
+    size_t methods = 0;
+    methodStatistics.forEachMethod([&](const std::string& name, const auto& data) {
+        ASSERT_TRUE(name == HELLO_NAME || name == WORLD_NAME);
+        ASSERT_EQ(kThreads / 2 * kEvents, data.histogram.getTotal());
+        ++methods;
+    });
+    ASSERT_EQ(2U, methods);
+}
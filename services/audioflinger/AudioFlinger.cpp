@@ -248,6 +248,33 @@ static auto& getIAudioFlingerStatistics() {
     return methodStatistics;
 }
 
+// singleton for the time spent in each phase of AudioFlinger::createTrack()
+static auto& getCreateTrackStatistics() {
+    static mediautils::MethodStatistics<std::string> methodStatistics;
+    return methodStatistics;
+}
+
+static float elapsedMs(nsecs_t startNs) {
+    return (systemTime() - startNs) * 1e-6f;
+}
+
+// Exports the binder execution time percentiles, one mediametrics item per method.
+template <typename Code>
+static void logMethodStatistics(
+        const mediautils::MethodStatistics<Code>& methodStatistics, const std::string& interface) {
+    methodStatistics.forEachMethod([&interface](const std::string& method, const auto& data) {
+        mediametrics::LogItem(std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_BINDER)
+                .append(interface).append(".").append(method))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONCOUNT, (int64_t)data.stats.getN())
+            .set(AMEDIAMETRICS_PROP_EXECUTIONMEANMS, (double)data.stats.getMean())
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP50MS, (double)data.histogram.getPercentile(50.f))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP99MS, (double)data.histogram.getPercentile(99.f))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP999MS,
+                    (double)data.histogram.getPercentile(99.9f))
+            .record();
+    });
+}
+
 class DevicesFactoryHalCallbackImpl : public DevicesFactoryHalCallback {
   public:
     void onNewDevicesAvailable() override {
@@ -948,11 +975,18 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
             std::string timeCheckStats = getIAudioFlingerStatistics().dump();
             dprintf(fd, "\nIAudioFlinger binder call profile:\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
+            logMethodStatistics(getIAudioFlingerStatistics(), "IAudioFlinger");
+
+            timeCheckStats = getCreateTrackStatistics().dump();
+            dprintf(fd, "\ncreateTrack phase profile:\n");
+            write(fd, timeCheckStats.c_str(), timeCheckStats.size());
+            logMethodStatistics(getCreateTrackStatistics(), "IAudioFlinger.createTrack");
 
             extern mediautils::MethodStatistics<int>& getIEffectStatistics();
             timeCheckStats = getIEffectStatistics().dump();
             dprintf(fd, "\nIEffect binder call profile:\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
+            logMethodStatistics(getIEffectStatistics(), "IEffect");
 
             // Automatically fetch HIDL statistics.
             std::shared_ptr<std::vector<std::string>> hidlClassNames =
@@ -1075,6 +1109,8 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
     audio_io_handle_t effectThreadId = AUDIO_IO_HANDLE_NONE;
     std::vector<int> effectIds;
     audio_attributes_t localAttr = input.attr;
+    const nsecs_t startNs = systemTime();
+    nsecs_t phaseStartNs;
 
     AttributionSourceState adjAttributionSource = input.clientInfo.attributionSource;
     if (!isAudioServerOrMediaServerOrSystemServerOrRootUid(callingUid)) {
@@ -1107,10 +1143,12 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
     output.sessionId = sessionId;
     output.outputId = AUDIO_IO_HANDLE_NONE;
     output.selectedDeviceId = input.selectedDeviceId;
+    phaseStartNs = systemTime();
     lStatus = AudioSystem::getOutputForAttr(&localAttr, &output.outputId, sessionId, &streamType,
                                             adjAttributionSource, &input.config, input.flags,
                                             &output.selectedDeviceId, &portId, &secondaryOutputs,
                                             &isSpatialized);
+    getCreateTrackStatistics().event("getOutputForAttr", elapsedMs(phaseStartNs));
 
     if (lStatus != NO_ERROR || output.outputId == AUDIO_IO_HANDLE_NONE) {
         ALOGE("createTrack() getOutputForAttr() return error %d or invalid output handle", lStatus);
@@ -1138,8 +1176,10 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
         goto Exit;
     }
 
+    phaseStartNs = systemTime();
     {
         Mutex::Autolock _l(mLock);
+        getCreateTrackStatistics().event("lock", elapsedMs(phaseStartNs));
         PlaybackThread *thread = checkPlaybackThread_l(output.outputId);
         if (thread == NULL) {
             ALOGE("no playback thread found for output handle %d", output.outputId);
@@ -1147,7 +1187,9 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
             goto Exit;
         }
 
+        phaseStartNs = systemTime();
         client = registerPid(clientPid);
+        getCreateTrackStatistics().event("registerPid", elapsedMs(phaseStartNs));
 
         PlaybackThread *effectThread = NULL;
         // check if an effect chain with the same session ID is present on another
@@ -1170,6 +1212,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
         output.flags = input.flags;
         output.streamType = streamType;
 
+        phaseStartNs = systemTime();
         track = thread->createTrack_l(client, streamType, localAttr, &output.sampleRate,
                                       input.config.format, input.config.channel_mask,
                                       &output.frameCount, &output.notificationFrameCount,
@@ -1177,6 +1220,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
                                       input.sharedBuffer, sessionId, &output.flags,
                                       callingPid, adjAttributionSource, input.clientInfo.clientTid,
                                       &lStatus, portId, input.audioTrackCallback, isSpatialized);
+        getCreateTrackStatistics().event("createTrack_l", elapsedMs(phaseStartNs));
         LOG_ALWAYS_FATAL_IF((lStatus == NO_ERROR) && (track == 0));
         // we don't abort yet if lStatus != NO_ERROR; there is still work to be done regardless
 
@@ -1258,6 +1302,8 @@ Exit:
     if (lStatus != NO_ERROR && output.outputId != AUDIO_IO_HANDLE_NONE) {
         AudioSystem::releaseOutput(portId);
     }
+    getCreateTrackStatistics().event(lStatus == NO_ERROR ? "total" : "failed",
+            elapsedMs(startNs));
     return lStatus;
 }
 
@@ -24,6 +24,7 @@
 #include <chrono>
 #include <deque>
 #include <map>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <set>
@@ -666,12 +666,32 @@ bool AudioFlinger::EffectModule::updateState() {
     return started;
 }
 
-void AudioFlinger::EffectModule::process()
+bool AudioFlinger::EffectModule::process(bool int16InputPending, bool keepInt16Output)
 {
     Mutex::Autolock _l(mLock);
 
+#ifdef FLOAT_EFFECT_CHAIN
+    // The int16 engine path can take its input from, or leave its output for, an adjacent
+    // int16 effect sharing the conversion buffer, see EffectChain::process_l().
+    const bool int16Path = isInt16Foldable() && isProcessEnabled() && isProcessImplemented();
+    if (int16InputPending && !int16Path) {
+        // complete the conversion to float skipped by the previous effect.
+        if (mInBuffer != 0 && mInConversionBuffer != 0) {
+            memcpy_to_float_from_i16(
+                    mInBuffer->audioBuffer()->f32,
+                    mInConversionBuffer->audioBuffer()->s16,
+                    mInChannelCountRequested * mConfig.inputCfg.buffer.frameCount);
+        }
+        int16InputPending = false;
+    }
+    keepInt16Output = keepInt16Output && int16Path;
+#else
+    (void)int16InputPending;
+    keepInt16Output = false;
+#endif
+
     if (mState == DESTROYED || mEffectInterface == 0 || mInBuffer == 0 || mOutBuffer == 0) {
-        return;
+        return false;
     }
 
     const uint32_t inChannelCount =
@@ -776,7 +796,7 @@ void AudioFlinger::EffectModule::process()
                 outBuffer = mOutConversionBuffer;
             }
             if (!mSupportsFloat) { // convert input to int16_t as effect doesn't support float.
-                if (!auxType) {
+                if (!auxType && !int16InputPending) {
                     if (mInConversionBuffer == nullptr) {
                         ALOGW("%s: mInConversionBuffer is null, bypassing", __func__);
                         goto data_bypass;
@@ -802,7 +822,7 @@ void AudioFlinger::EffectModule::process()
 #endif
             ret = mEffectInterface->process();
 #ifdef FLOAT_EFFECT_CHAIN
-            if (!mSupportsFloat) { // convert output int16_t back to float.
+            if (!mSupportsFloat && !keepInt16Output) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
                         mOutChannelCountRequested != outChannelCount
                         ? mOutConversionBuffer : mOutBuffer;
@@ -864,6 +884,7 @@ void AudioFlinger::EffectModule::process()
             }
         }
     }
+    return keepInt16Output;
 }
 
 void AudioFlinger::EffectModule::reset_l()
@@ -1372,6 +1393,57 @@ void AudioFlinger::EffectModule::setInBuffer(const sp<EffectBufferHalInterface>&
 #endif
 }
 
+bool AudioFlinger::EffectModule::isInt16Foldable() const
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    return !mSupportsFloat
+            && (mDescriptor.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_INSERT
+            && mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_WRITE
+            && mInChannelCountRequested == mOutChannelCountRequested
+            && mInChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.inputCfg.channels)
+            && mOutChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.outputCfg.channels)
+            && mInConversionBuffer != nullptr && mOutConversionBuffer != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool AudioFlinger::EffectModule::canPassInt16To(const sp<EffectModule>& next) const
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    return isInt16Foldable() && next->isInt16Foldable()
+            && mOutBuffer == next->mInBuffer
+            && mOutConversionBuffer == next->mInConversionBuffer
+            && next->isProcessEnabled();
+#else
+    (void)next;
+    return false;
+#endif
+}
+
+void AudioFlinger::EffectModule::shareInConversionBuffer(const sp<EffectModule>& previous)
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    Mutex::Autolock _l(mLock);
+    if (!isInt16Foldable() || !previous->isInt16Foldable()
+            || previous->mOutBuffer != mInBuffer
+            || previous->mOutConversionBuffer == mInConversionBuffer
+            || previous->mOutConversionBuffer->getSize() < mInConversionBuffer->getSize()) {
+        return;
+    }
+    // The conversion buffers are only used within process(), so the previous effect
+    // int16 output buffer can also be our int16 input buffer.
+    ALOGV("%s: effect %p shares input conversion buffer of %p",
+            __func__, this, previous.get());
+    mInConversionBuffer = previous->mOutConversionBuffer;
+    mEffectInterface->setInBuffer(mInConversionBuffer);
+#else
+    (void)previous;
+#endif
+}
+
 void AudioFlinger::EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>& buffer) {
     ALOGVV("setOutBuffer %p",(&buffer));
 
@@ -2232,8 +2304,12 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
         }
+        // Adjacent int16 effects pass their output in the shared conversion buffer
+        // rather than converting it to float and back, see shareConversionBuffers_l().
+        bool int16Pending = false;
         for (size_t i = 0; i < size; i++) {
-            mEffects[i]->process();
+            const bool keepInt16 = i + 1 < size && mEffects[i]->canPassInt16To(mEffects[i + 1]);
+            int16Pending = mEffects[i]->process(int16Pending, keepInt16);
         }
         mInBuffer->commit();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
@@ -2355,10 +2431,19 @@ status_t AudioFlinger::EffectChain::addEffect_ll(const sp<EffectModule>& effect)
                 __func__, effect.get(), this, idx_insert);
     }
     effect->configure();
+    shareConversionBuffers_l();
 
     return NO_ERROR;
 }
 
+// shareConversionBuffers_l() must be called with EffectChain::mLock held
+void AudioFlinger::EffectChain::shareConversionBuffers_l()
+{
+    for (size_t i = 1; i < mEffects.size(); i++) {
+        mEffects[i]->shareInConversionBuffer(mEffects[i - 1]);
+    }
+}
+
 ssize_t AudioFlinger::EffectChain::getInsertIndex(const effect_descriptor_t& desc) {
     // Insert effects are inserted at the end of mEffects vector as they are processed
     //  after track and auxiliary effects.
@@ -2470,6 +2555,8 @@ size_t AudioFlinger::EffectChain::removeEffect_l(const sp<EffectModule>& effect,
                 mEffects[0]->updateAccessMode();      // reconfig if neeeded.
             }
 
+            shareConversionBuffers_l();
+
             ALOGV("removeEffect_l() effect %p, removed from chain %p at rank %zu", effect.get(),
                     this, i);
             break;
@@ -227,7 +227,11 @@ public:
                     audio_port_handle_t deviceId);
     virtual ~EffectModule();
 
-    void process();
+    // If int16InputPending, the previous effect in the chain left its output as int16 in
+    // our shared input conversion buffer, see EffectChain::shareConversionBuffers_l().
+    // If keepInt16Output, our output may be left as int16 for the next effect.
+    // Returns true if the output was left as int16 and not converted to float.
+    bool process(bool int16InputPending = false, bool keepInt16Output = false);
     bool updateState();
     status_t command(int32_t cmdCode,
                      const std::vector<uint8_t>& cmdData,
@@ -255,6 +259,13 @@ public:
         return mOutBuffer != 0 ? reinterpret_cast<int16_t*>(mOutBuffer->ptr()) : NULL;
     }
 
+    // Returns true if this effect output can be passed as int16 to next, the following
+    // effect in the chain, when it shares our output conversion buffer.
+    bool        canPassInt16To(const sp<EffectModule>& next) const;
+    // Uses the output conversion buffer of previous as our input conversion buffer
+    // if both effects process int16 in place.
+    void        shareInConversionBuffer(const sp<EffectModule>& previous);
+
     // Updates the access mode if it is out of date.  May issue a new effect configure.
     void        updateAccessMode() {
                     if (requiredEffectBufferAccessMode() != mConfig.outputCfg.accessMode) {
@@ -297,6 +308,9 @@ private:
     status_t stop_l();
     status_t removeEffectFromHal_l();
     status_t sendSetAudioDevicesCommand(const AudioDeviceTypeAddrVector &devices, uint32_t cmdCode);
+    // true if the effect engine runs in place on int16 through the conversion buffers,
+    // without channel adjustment.
+    bool isInt16Foldable() const;
     effect_buffer_access_e requiredEffectBufferAccessMode() const {
         return mConfig.inputCfg.buffer.raw == mConfig.outputCfg.buffer.raw
                 ? EFFECT_BUFFER_ACCESS_WRITE : EFFECT_BUFFER_ACCESS_ACCUMULATE;
@@ -657,6 +671,9 @@ private:
 
     void clearInputBuffer_l();
 
+    // shares conversion buffers between adjacent int16 effects, see EffectModule::process().
+    void shareConversionBuffers_l();
+
     void setThread(const sp<ThreadBase>& thread);
 
     // true if any effect module within the chain has volume control
@@ -20,6 +20,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <audio_utils/clock.h>
@@ -72,9 +73,13 @@ FastThread::FastThread(const char *cycleMs, const char *loadUs) : Thread(false /
 #if 0
     frameCount(0),
 #endif
-    mAttemptedWrite(false)
+    mAttemptedWrite(false),
     // mCycleMs(cycleMs)
     // mLoadUs(loadUs)
+    // mCycleHistogram
+    // mCycleSummary
+    mCycleSummaryStartNs(0),
+    mCycleSummaryEndNs(0)
 {
     mOldTs.tv_sec = 0;
     mOldTs.tv_nsec = 0;
@@ -82,6 +87,8 @@ FastThread::FastThread(const char *cycleMs, const char *loadUs) : Thread(false /
     mMeasuredWarmupTs.tv_nsec = 0;
     strlcpy(mCycleMs, cycleMs, sizeof(mCycleMs));
     strlcpy(mLoadUs, loadUs, sizeof(mLoadUs));
+    memset(mCycleHistogram, 0, sizeof(mCycleHistogram));
+    memset(&mCycleSummary, 0, sizeof(mCycleSummary));
 }
 
 FastThread::~FastThread()
@@ -272,6 +279,7 @@ bool FastThread::threadLoop()
                         ALOGV("underrun: time since last cycle %d.%03ld sec",
                                 (int) sec, nsec / 1000000L);
                         mDumpState->mUnderruns++;
+                        mCycleSummary.mUnderruns++;
                         LOG_UNDERRUN(audio_utils_ns_from_timespec(&newTs));
                         mIgnoreNextOverrun = true;
                     } else if (nsec < mOverrunNs) {
@@ -282,6 +290,7 @@ bool FastThread::threadLoop()
                             ALOGV("overrun: time since last cycle %d.%03ld sec",
                                     (int) sec, nsec / 1000000L);
                             mDumpState->mOverruns++;
+                            mCycleSummary.mOverruns++;
                             LOG_OVERRUN(audio_utils_ns_from_timespec(&newTs));
                         }
                         // This forces a minimum cycle time. It:
@@ -294,6 +303,9 @@ bool FastThread::threadLoop()
                     } else {
                         mIgnoreNextOverrun = false;
                     }
+                    const int64_t cycleNs = sec * 1000000000LL + nsec;
+                    updateCycleSummary(audio_utils_ns_from_timespec(&newTs),
+                            (uint32_t) std::min(cycleNs, (int64_t) UINT32_MAX));
                 }
 #ifdef FAST_THREAD_STATISTICS
                 if (mIsWarm) {
@@ -345,6 +357,7 @@ bool FastThread::threadLoop()
                     mDumpState->mMonotonicNs[i] = monotonicNs;
                     LOG_WORK_TIME(monotonicNs);
                     mDumpState->mLoadNs[i] = loadNs;
+                    mCycleSummary.mLoadTotalNs += loadNs;
 #ifdef CPU_FREQUENCY_STATISTICS
                     mDumpState->mCpukHz[i] = kHz;
 #endif
@@ -373,4 +386,61 @@ bool FastThread::threadLoop()
     // never return 'true'; Thread::_threadLoop() locks mutex which can result in priority inversion
 }
 
+void FastThread::updateCycleSummary(int64_t nowNs, uint32_t cycleNs)
+{
+    if (nowNs >= mCycleSummaryEndNs) {
+        publishCycleSummary(nowNs);
+    }
+    const uint32_t bin = std::min(cycleNs / kCycleHistogramBinNs, kCycleHistogramBins - 1);
+    ++mCycleHistogram[bin];
+    ++mCycleSummary.mCycles;
+    mCycleSummary.mCycleMaxNs = std::max(mCycleSummary.mCycleMaxNs, cycleNs);
+    mCycleSummary.mCycleTotalNs += cycleNs;
+}
+
+void FastThread::publishCycleSummary(int64_t nowNs)
+{
+    if (mCycleSummary.mCycles > 0) {
+        // percentiles are reported as the upper bound of the histogram bin.
+        const uint32_t cycles = mCycleSummary.mCycles;
+        const uint32_t p50 = (cycles + 1) / 2;
+        const uint32_t p90 = cycles - cycles / 10;
+        const uint32_t p99 = cycles - cycles / 100;
+        uint32_t count = 0;
+        for (uint32_t bin = 0; bin < kCycleHistogramBins; ++bin) {
+            const uint32_t prior = count;
+            count += mCycleHistogram[bin];
+            const uint32_t ns = std::min((bin + 1) * kCycleHistogramBinNs,
+                    mCycleSummary.mCycleMaxNs);
+            if (prior < p50 && count >= p50) mCycleSummary.mCycleP50Ns = ns;
+            if (prior < p90 && count >= p90) mCycleSummary.mCycleP90Ns = ns;
+            if (prior < p99 && count >= p99) mCycleSummary.mCycleP99Ns = ns;
+        }
+        // an interval cut short by idle or a missed deadline is reported with its actual end.
+        mCycleSummary.mDurationNs = std::min(nowNs, mCycleSummaryEndNs) - mCycleSummaryStartNs;
+
+        // single writer, so the rear can be read back without a barrier.
+        const int32_t rear = mDumpState->mCycleSummaryRear;
+        mDumpState->mCycleSummary[rear & (FastThreadDumpState::kCycleSummaryN - 1)] =
+                mCycleSummary;
+        android_atomic_release_store(rear + 1, &mDumpState->mCycleSummaryRear);
+    }
+    memset(mCycleHistogram, 0, sizeof(mCycleHistogram));
+    memset(&mCycleSummary, 0, sizeof(mCycleSummary));
+
+    // align the interval end to a multiple of the interval in CLOCK_REALTIME,
+    // which mediametrics uses to timestamp items.
+    struct timespec realTs;
+    if (clock_gettime(CLOCK_REALTIME, &realTs) == 0) {
+        const int64_t realNs = audio_utils_ns_from_timespec(&realTs);
+        constexpr int64_t kIntervalNs = FastThreadDumpState::kCycleSummaryIntervalNs;
+        const int64_t endRealNs = (realNs / kIntervalNs + 1) * kIntervalNs;
+        mCycleSummary.mEndRealtimeNs = endRealNs;
+        mCycleSummaryEndNs = nowNs + (endRealNs - realNs);
+    } else {
+        mCycleSummaryEndNs = nowNs + FastThreadDumpState::kCycleSummaryIntervalNs;
+    }
+    mCycleSummaryStartNs = nowNs;
+}
+
 }   // namespace android
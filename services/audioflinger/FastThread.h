@@ -22,6 +22,7 @@
 #include <cpustats/ThreadCpuUsage.h>
 #endif
 #include <utils/Thread.h>
+#include "FastThreadDumpState.h"
 #include "FastThreadState.h"
 
 namespace android {
@@ -48,6 +49,12 @@ protected:
     virtual void onStateChange() = 0;
     virtual void onWork() = 0;
 
+    // Accumulates one warm cycle into mCycleSummary, and publishes the summary
+    // to mDumpState at the end of each FastThreadDumpState::kCycleSummaryIntervalNs.
+    void updateCycleSummary(int64_t nowNs, uint32_t cycleNs);
+    // Publishes mCycleSummary if it has any cycles and starts the next interval.
+    void publishCycleSummary(int64_t nowNs);
+
     // FIXME these former local variables need comments
     const FastThreadState*  mPrevious;
     const FastThreadState*  mCurrent;
@@ -90,6 +97,15 @@ protected:
     char            mCycleMs[16];   // cycle_ms + suffix
     char            mLoadUs[16];    // load_us + suffix
 
+    // Cycle timing summary for the current interval, see FastThreadDumpState::mCycleSummary.
+    // Percentiles are computed from a histogram, the last bin is used for all longer cycles.
+    static const uint32_t kCycleHistogramBinNs = 250000;    // 0.25 ms
+    static const uint32_t kCycleHistogramBins = 80;         // 20 ms
+    uint32_t        mCycleHistogram[kCycleHistogramBins];
+    FastThreadCycleSummary mCycleSummary;
+    int64_t         mCycleSummaryStartNs;   // CLOCK_MONOTONIC start of the interval
+    int64_t         mCycleSummaryEndNs;     // CLOCK_MONOTONIC end of the interval, 0 if none
+
 };  // class FastThread
 
 }   // android
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <string.h>
 #include <audio_utils/roundup.h>
+#include <cutils/atomic.h>
 #include "FastThreadDumpState.h"
 
 namespace android {
@@ -22,13 +25,14 @@ namespace android {
 FastThreadDumpState::FastThreadDumpState() :
     mCommand(FastThreadState::INITIAL), mUnderruns(0), mOverruns(0),
     /* mMeasuredWarmupTs({0, 0}), */
-    mWarmupCycles(0)
+    mWarmupCycles(0), mCycleSummaryRear(0)
 #ifdef FAST_THREAD_STATISTICS
     , mSamplingN(0), mBounds(0)
 #endif
 {
     mMeasuredWarmupTs.tv_sec = 0;
     mMeasuredWarmupTs.tv_nsec = 0;
+    memset(mCycleSummary, 0, sizeof(mCycleSummary));
 #ifdef FAST_THREAD_STATISTICS
     increaseSamplingN(1);
 #endif
@@ -38,6 +42,29 @@ FastThreadDumpState::~FastThreadDumpState()
 {
 }
 
+size_t FastThreadDumpState::readCycleSummaries(uint32_t *front,
+        FastThreadCycleSummary *summaries, size_t count) const
+{
+    const uint32_t rear = (uint32_t) android_atomic_acquire_load(&mCycleSummaryRear);
+    uint32_t first = *front;
+    if (rear - first > kCycleSummaryN) {
+        first = rear - kCycleSummaryN; // the reader fell behind
+    }
+    size_t n = 0;
+    for (uint32_t i = first; i != rear && n < count; ++i) {
+        summaries[n++] = mCycleSummary[i & (kCycleSummaryN - 1)];
+    }
+    // discard any summary that the writer overwrote while it was being copied.
+    const uint32_t newRear = (uint32_t) android_atomic_acquire_load(&mCycleSummaryRear);
+    size_t lost = 0;
+    if (newRear - first > kCycleSummaryN) {
+        lost = std::min((size_t) (newRear - first - kCycleSummaryN), n);
+        memmove(summaries, summaries + lost, (n - lost) * sizeof(summaries[0]));
+    }
+    *front = first + n;
+    return n - lost;
+}
+
 #ifdef FAST_THREAD_STATISTICS
 void FastThreadDumpState::increaseSamplingN(uint32_t samplingN)
 {
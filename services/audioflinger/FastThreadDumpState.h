@@ -22,6 +22,23 @@
 
 namespace android {
 
+// FastThreadCycleSummary summarizes the FastThread cycle timing over one interval
+// of FastThreadDumpState::kCycleSummaryIntervalNs, for logging to mediametrics.
+// Cycle times are quantized to FastThread::kCycleHistogramBinNs.
+struct FastThreadCycleSummary {
+    int64_t  mEndRealtimeNs;    // CLOCK_REALTIME end of interval, multiple of the interval
+    int64_t  mDurationNs;       // CLOCK_MONOTONIC duration of interval, may be partial
+    uint32_t mCycles;           // number of warm cycles in the interval
+    uint32_t mCycleP50Ns;       // cycle time percentiles
+    uint32_t mCycleP90Ns;
+    uint32_t mCycleP99Ns;
+    uint32_t mCycleMaxNs;       // not quantized
+    uint32_t mUnderruns;        // underruns in the interval
+    uint32_t mOverruns;         // overruns in the interval
+    int64_t  mCycleTotalNs;     // sum of cycle times
+    int64_t  mLoadTotalNs;      // sum of thread CPU time, 0 without FAST_THREAD_STATISTICS
+};
+
 // The FastThreadDumpState keeps a cache of FastThread statistics that can be logged by dumpsys.
 // Each individual native word-sized field is accessed atomically.  But the
 // overall structure is non-atomic, that is there may be an inconsistency between fields.
@@ -38,6 +55,21 @@ struct FastThreadDumpState {
     struct timespec mMeasuredWarmupTs;  // measured warmup time
     uint32_t mWarmupCycles;     // number of loop cycles required to warmup
 
+    // Most recent cycle summaries, one per kCycleSummaryIntervalNs of active time.
+    // Unlike the fields above, this is a single writer (FastThread) single reader queue:
+    // the writer fills mCycleSummary[mCycleSummaryRear % kCycleSummaryN] and then
+    // increments mCycleSummaryRear with a release store.  Read with readCycleSummaries().
+    static const uint32_t kCycleSummaryN = 8;   // must be a power of 2
+    static constexpr int64_t kCycleSummaryIntervalNs = 10000000000LL;   // 10 seconds
+    FastThreadCycleSummary mCycleSummary[kCycleSummaryN];
+    volatile int32_t mCycleSummaryRear;
+
+    // Copies up to count summaries published since *front to summaries, and advances *front.
+    // Summaries that were overwritten before they could be read are skipped.
+    // Returns the number of summaries copied.
+    size_t  readCycleSummaries(uint32_t *front, FastThreadCycleSummary *summaries,
+                               size_t count) const;
+
 #ifdef FAST_THREAD_STATISTICS
     // Recently collected samples of per-cycle monotonic time, thread CPU time, and CPU frequency.
     // kSamplingN is max size of sampling frame (statistics), and must be a power of 2 <= 0x8000.
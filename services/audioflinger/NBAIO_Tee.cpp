@@ -23,11 +23,17 @@
 #include <dirent.h>
 #include <future>
 #include <list>
+#include <thread>
 #include <vector>
 
 #include <audio_utils/format.h>
 #include <audio_utils/sndfile.h>
+#include <cutils/properties.h>
 #include <media/nbaio/PipeReader.h>
+#include <system/thread_defs.h>
+#include <utils/AndroidThreads.h>
+
+#include "FLAC/stream_encoder.h"
 
 #include "Configuration.h"
 #include "NBAIO_Tee.h"
@@ -59,13 +65,24 @@ namespace android {
   aftee_20180424_153825_149_13_F_DUMP.wav
   aftee_20180424_153842_125_62_59_R_REMOVE.wav
   aftee_20180424_153842_168_62_C_DTOR.wav
+
+ Rolling capture files are generated as follows:
+
+ "afroll_Date_..._ROLL.flac"
+
+ with the same fields as above, and only the most recent files are kept.
 */
 
 static constexpr char DEFAULT_PREFIX[] = "aftee_";
 static constexpr char DEFAULT_DIRECTORY[] = "/data/misc/audioserver";
 static constexpr size_t DEFAULT_THREADPOOL_SIZE = 8;
 
-/** AudioFileHandler manages temporary audio wav files with a least recently created
+static constexpr char ROLLING_PREFIX[] = "afroll_";
+// The rolling thread writes the files itself, at background priority.
+static constexpr size_t ROLLING_THREADPOOL_SIZE = 1;
+static constexpr unsigned ROLLING_FLAC_COMPRESSION_LEVEL = 5;
+
+/** AudioFileHandler manages temporary audio wav or flac files with a least recently created
     retention policy.
 
     The temporary filenames are systematically generated. A common filename prefix,
@@ -82,9 +99,12 @@ static constexpr size_t DEFAULT_THREADPOOL_SIZE = 8;
 class AudioFileHandler {
 public:
 
-    AudioFileHandler(const std::string &prefix, const std::string &directory, size_t pool)
+    AudioFileHandler(const std::string &prefix, const std::string &directory, size_t pool,
+            bool flac = false)
         : mThreadPool(pool)
         , mPrefix(prefix)
+        , mFlac(flac)
+        , mExtension(flac ? ".flac" : ".wav")
     {
         (void)setDirectory(directory);
     }
@@ -116,6 +136,15 @@ private:
             audio_format_t format,
             const std::string &filename);
 
+    /** writes a flac file at path from a reader functor, returns frames written. */
+    static ssize_t writeFlac(
+            std::function<ssize_t /* frames_read */
+                        (void * /* buffer */, size_t /* size_in_frames */)> reader,
+            uint32_t sampleRate,
+            uint32_t channelCount,
+            audio_format_t format,
+            const std::string &path);
+
     static bool isDirectoryValid(const std::string &directory) {
         return directory.size() > 0 && directory[0] == '/';
     }
@@ -130,7 +159,7 @@ private:
             "incorrect fileTime buffer");
         char msec[4];
         (void)snprintf(msec, sizeof(msec), "%03d", (int)(tv.tv_usec / 1000));
-        return mPrefix + fileTime + msec + suffix + ".wav";
+        return mPrefix + fileTime + msec + suffix + mExtension;
     }
 
     bool isManagedFilename(const char *name) {
@@ -138,12 +167,13 @@ private:
             + 1 + 2 + 2 + 2 // _H%M%S
             + 1 + 3; //_MSEC
         const size_t prefixLen = mPrefix.size();
+        const size_t extensionLen = mExtension.size();
         const size_t nameLen = strlen(name);
 
-        // reject on size, prefix, and .wav
-        if (nameLen < prefixLen + FILENAME_LEN_DATE + 4 /* .wav */
+        // reject on size, prefix, and extension
+        if (nameLen < prefixLen + FILENAME_LEN_DATE + extensionLen
              || strncmp(name, mPrefix.c_str(), prefixLen) != 0
-             || strcmp(name + nameLen - 4, ".wav") != 0) {
+             || strcmp(name + nameLen - extensionLen, mExtension.c_str()) != 0) {
             return false;
         }
 
@@ -176,6 +206,8 @@ private:
     } mThreadPool;
 
     const std::string mPrefix;
+    const bool mFlac;
+    const std::string mExtension;
     std::mutex mLock;
     std::string mDirectory;         // GUARDED_BY(mLock)
     std::deque<std::string> mFiles; // GUARDED_BY(mLock)  sorted list of files by creation time
@@ -187,11 +219,14 @@ private:
 
 /* static */
 void NBAIO_Tee::NBAIO_TeeImpl::dumpTee(
-        int fd, const NBAIO_SinkSource &sinkSource, const std::string &suffix)
+        int fd, const NBAIO_SinkSource &sinkSource, const std::string &suffix, bool rolling)
 {
-    // Singleton. Constructed thread-safe on first call, never destroyed.
-    static AudioFileHandler audioFileHandler(
+    // Singletons. Constructed thread-safe on first call, never destroyed.
+    static AudioFileHandler dumpFileHandler(
             DEFAULT_PREFIX, DEFAULT_DIRECTORY, DEFAULT_THREADPOOL_SIZE);
+    static AudioFileHandler rollingFileHandler(
+            ROLLING_PREFIX, DEFAULT_DIRECTORY, ROLLING_THREADPOOL_SIZE, true /* flac */);
+    AudioFileHandler &audioFileHandler = rolling ? rollingFileHandler : dumpFileHandler;
 
     auto &source = sinkSource.second;
     if (source.get() == nullptr) {
@@ -222,6 +257,31 @@ void NBAIO_Tee::NBAIO_TeeImpl::dumpTee(
     }
 }
 
+/* static */
+int32_t NBAIO_Tee::NBAIO_TeeImpl::getRollingMs()
+{
+    static const int32_t rollingMs = property_get_bool("ro.debuggable", false)
+            ? std::max(property_get_int32("af.tee_rolling_ms", 0), 0) : 0;
+    return rollingMs;
+}
+
+/* static */
+void NBAIO_Tee::NBAIO_TeeImpl::startRolling(int32_t rollingMs)
+{
+    static std::once_flag once;
+    std::call_once(once, [rollingMs]() {
+        // Never joined, the RunningTees singleton is never destroyed.
+        std::thread([rollingMs]() {
+            (void)pthread_setname_np(pthread_self(), "afTeeRoll");
+            (void)androidSetThreadPriority(0 /* tid */, ANDROID_PRIORITY_BACKGROUND);
+            for (;;) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(rollingMs));
+                getRunningTees().roll();
+            }
+        }).detach();
+    });
+}
+
 /* static */
 NBAIO_Tee::NBAIO_TeeImpl::NBAIO_SinkSource NBAIO_Tee::NBAIO_TeeImpl::makeSinkSource(
         const NBAIO_Format &format, size_t frames, bool *enabled)
@@ -435,6 +495,20 @@ status_t AudioFileHandler::createInternal(
 
     const std::string path = dirPrefix + filename;
 
+    if (mFlac) {
+        const ssize_t written = writeFlac(reader, sampleRate, channelCount, format, path);
+        if (written <= 0) {
+            (void)unlink(path.c_str());
+            return written < 0 ? (status_t)written : NOT_ENOUGH_DATA;
+        }
+        std::lock_guard<std::mutex> _l(mLock);
+        // weak synchronization - only update mFiles if the directory hasn't changed.
+        if (mDirectory == directory) {
+            mFiles.emplace_back(filename);  // add to the end to preserve sort.
+        }
+        return NO_ERROR;
+    }
+
     /* const */ SF_INFO info = {
         .frames = 0,
         .samplerate = (int)sampleRate,
@@ -512,6 +586,93 @@ status_t AudioFileHandler::createInternal(
     return NO_ERROR; // return full path
 }
 
+/* static */
+ssize_t AudioFileHandler::writeFlac(
+        std::function<ssize_t /* frames_read */
+                    (void * /* buffer */, size_t /* size_in_frames */)> reader,
+        uint32_t sampleRate,
+        uint32_t channelCount,
+        audio_format_t format,
+        const std::string &path)
+{
+    // FLAC takes 32 bit integer samples of up to 24 significant bits,
+    // so we convert through PCM_16 or PCM_32 and shift down as needed.
+    audio_format_t writeFormat;
+    unsigned bitsPerSample;
+    switch (format) {
+    case AUDIO_FORMAT_PCM_8_BIT:
+    case AUDIO_FORMAT_PCM_16_BIT:
+        writeFormat = AUDIO_FORMAT_PCM_16_BIT;
+        bitsPerSample = 16;
+        break;
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+    case AUDIO_FORMAT_PCM_32_BIT:
+    case AUDIO_FORMAT_PCM_FLOAT:
+        writeFormat = AUDIO_FORMAT_PCM_32_BIT;
+        bitsPerSample = 24;
+        break;
+    default:
+        return BAD_VALUE;
+    }
+
+    FLAC__StreamEncoder *encoder = FLAC__stream_encoder_new();
+    if (encoder == nullptr) {
+        return NO_MEMORY;
+    }
+    FLAC__bool ok = FLAC__stream_encoder_set_channels(encoder, channelCount)
+            && FLAC__stream_encoder_set_sample_rate(encoder, sampleRate)
+            && FLAC__stream_encoder_set_bits_per_sample(encoder, bitsPerSample)
+            && FLAC__stream_encoder_set_compression_level(
+                    encoder, ROLLING_FLAC_COMPRESSION_LEVEL)
+            && FLAC__stream_encoder_set_verify(encoder, false);
+    if (!ok || FLAC__stream_encoder_init_file(encoder, path.c_str(),
+            nullptr /* progress_callback */, nullptr /* client_data */)
+                    != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        ALOGW("%s: %s cannot initialize encoder", __func__, path.c_str());
+        FLAC__stream_encoder_delete(encoder);
+        return INVALID_OPERATION;
+    }
+
+    const size_t samplesPerRead = FRAMES_PER_READ * channelCount;
+    std::vector<uint8_t> buffer(samplesPerRead * std::max(
+            audio_bytes_per_sample(writeFormat), audio_bytes_per_sample(format)));
+    std::vector<FLAC__int32> samples(samplesPerRead);
+    ssize_t total = 0;
+
+    for (;;) {
+        const ssize_t actualRead = reader(buffer.data(), FRAMES_PER_READ);
+        if (actualRead <= 0) {
+            break;
+        }
+        const size_t sampleCount = actualRead * channelCount;
+
+        // Convert input format to writeFormat as needed.
+        if (format != writeFormat) {
+            memcpy_by_audio_format(
+                    buffer.data(), writeFormat, buffer.data(), format, sampleCount);
+        }
+        if (writeFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            const int16_t *src = (const int16_t *)buffer.data();
+            std::copy(src, src + sampleCount, samples.begin());
+        } else {
+            const int32_t *src = (const int32_t *)buffer.data();
+            std::transform(src, src + sampleCount, samples.begin(),
+                    [](int32_t sample) { return sample >> 8; });
+        }
+
+        if (!FLAC__stream_encoder_process_interleaved(encoder, samples.data(), actualRead)) {
+            ALOGW("%s: %s encoder error: %d", __func__, path.c_str(),
+                    FLAC__stream_encoder_get_state(encoder));
+            break;
+        }
+        total += actualRead;
+    }
+    (void)FLAC__stream_encoder_finish(encoder);
+    FLAC__stream_encoder_delete(encoder);
+    return total;
+}
+
 } // namespace android
 
 #endif // TEE_SINK
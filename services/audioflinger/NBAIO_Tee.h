@@ -20,6 +20,7 @@
 
 #ifdef TEE_SINK
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <set>
@@ -78,6 +79,14 @@ namespace android {
  * 2) The mechanism is on the AudioBufferProvider release() so large static Track
  *    playback may not show any Tee data depending on when it is released.
  * 3) When a track becomes inactive, the Thread will trigger a dump.
+ *
+ * Rolling capture:
+ * 1) If the af.tee_rolling_ms property is set, the default Tee pipe only holds two
+ *    rolling periods of audio instead of DEFAULT_TEE_FRAMES.
+ * 2) A background priority thread drains all Tees every rolling period into
+ *    FLAC files "afroll_Date_..._ROLL.flac", keeping only the most recent ones.
+ *    The write() into the Tee is unchanged, so the audio threads are not affected.
+ * 3) dump() still works and writes the data not yet drained to a WAV file.
  */
 
 class NBAIO_Tee {
@@ -197,9 +206,15 @@ private:
             }
 
             // determine number of frames for Tee
+            const int32_t rollingMs = getRollingMs();
             if (frames == 0) {
                 // TODO: consider varying frame count based on type.
                 frames = DEFAULT_TEE_FRAMES;
+                if (rollingMs > 0) {
+                    // Two periods, so the pipe does not overrun between drains.
+                    frames = std::min(frames,
+                            (size_t) Format_sampleRate(format) * rollingMs * 2 / 1000);
+                }
             }
 
             // TODO: should we check minimum number of frames?
@@ -222,6 +237,9 @@ private:
                 mFrames = frames;
                 mSinkSource = std::move(sinksource);
                 mEnabled.store(true);
+                if (rollingMs > 0) {
+                    startRolling(rollingMs);
+                }
                 return NO_ERROR;
             }
             return BAD_VALUE;
@@ -232,7 +250,7 @@ private:
             mId = id;
         }
 
-        void dump(int fd, const std::string &reason) {
+        void dump(int fd, const std::string &reason, bool rolling = false) {
             if (!mDataReady.exchange(false)) return;
             std::string suffix;
             NBAIO_SinkSource sinkSource;
@@ -241,7 +259,7 @@ private:
                 suffix = mId + reason;
                 sinkSource = mSinkSource;
             }
-            dumpTee(fd, sinkSource, suffix);
+            dumpTee(fd, sinkSource, suffix, rolling);
         }
 
         void write(const void *buffer, size_t frameCount) {
@@ -255,7 +273,14 @@ private:
         // because PipeReader holds a naked reference (not a strong or weak pointer) to Pipe.
         using NBAIO_SinkSource = std::pair<sp<NBAIO_Sink>, sp<NBAIO_Source>>;
 
-        static void dumpTee(int fd, const NBAIO_SinkSource& sinkSource, const std::string& suffix);
+        static void dumpTee(int fd, const NBAIO_SinkSource& sinkSource, const std::string& suffix,
+                bool rolling);
+
+        /** returns the af.tee_rolling_ms property if debuggable, 0 if rolling capture is off. */
+        static int32_t getRollingMs();
+
+        /** starts the thread draining all Tees every rollingMs, if not already running. */
+        static void startRolling(int32_t rollingMs);
 
         static NBAIO_SinkSource makeSinkSource(
                 const NBAIO_Format &format, size_t frames, bool *enabled);
@@ -303,6 +328,18 @@ private:
             }
         }
 
+        /** drains all tees to rolling capture files. */
+        void roll() {
+            std::vector<std::shared_ptr<NBAIO_TeeImpl>> tees; // safe snapshot of tees
+            {
+                std::lock_guard<std::mutex> _l(mLock);
+                tees.insert(tees.end(), mTees.begin(), mTees.end());
+            }
+            for (const auto &tee : tees) {
+                tee->dump(-1 /* fd */, "_ROLL", true /* rolling */);
+            }
+        }
+
     private:
         std::mutex mLock;
         std::set<std::shared_ptr<NBAIO_TeeImpl>> mTees; // GUARDED_BY(mLock)
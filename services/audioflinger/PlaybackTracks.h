@@ -296,6 +296,27 @@ protected:
     int                 mAuxEffectId;
     bool                mHasVolumeController;
 
+    // Parameters last set for this track in the AudioMixer by MixerThread::prepareTracks_l(),
+    // which only sets the ones that changed. Valid while mMixerParamsGeneration is the
+    // generation of the thread's AudioMixer, see MixerThread::mAudioMixerGeneration.
+    struct MixerParams {
+        float               volume[2];
+        float               auxLevel;
+        audio_format_t      format;
+        audio_channel_mask_t channelMask;
+        audio_channel_mask_t mixerChannelMask;
+        uint32_t            sampleRate;
+        AudioPlaybackRate   playbackRate;
+        audio_format_t      mixerFormat;
+        void                *mainBuffer;
+        void                *auxBuffer;
+        bool                hapticPlaybackEnabled;
+        os::HapticScale     hapticIntensity;
+        float               hapticMaxAmplitude;
+    };
+    MixerParams         mMixerParams{};
+    uint32_t            mMixerParamsGeneration = 0;
+
     // access these three variables only when holding thread lock.
     LinearMap<int64_t> mFrameMap;           // track frame to server frame mapping
 
@@ -374,7 +395,7 @@ public:
 
     class Buffer : public AudioBufferProvider::Buffer {
     public:
-        void *mBuffer;
+        std::shared_ptr<int8_t[]> mData;    // keeps raw valid, may be shared with other tracks
     };
 
                         OutputTrack(PlaybackThread *thread,
@@ -390,8 +411,16 @@ public:
                                     AudioSystem::SYNC_EVENT_NONE,
                              audio_session_t triggerSession = AUDIO_SESSION_NONE);
     virtual void        stop();
-            ssize_t     write(void* data, uint32_t frames);
-            bool        bufferQueueEmpty() const { return mBufferQueue.size() == 0; }
+    /** Writes frames of data, queueing what does not fit in the track buffer.
+     *
+     * All output tracks of a DuplicatingThread have the same format and channel mask, and are
+     * written the same data in a cycle. The first track that needs to queue data copies all
+     * of it into overflowData, and the other tracks then queue a reference to that copy
+     * instead of a copy of their own. overflowData must be empty for each new data.
+     */
+            ssize_t     write(void* data, uint32_t frames,
+                              std::shared_ptr<int8_t[]>& overflowData);
+            bool        bufferQueueEmpty() const { return mBufferQueue.empty(); }
             bool        isActive() const { return mActive; }
     const wp<ThreadBase>& thread() const { return mThread; }
 
@@ -421,7 +450,7 @@ private:
     // Maximum number of pending buffers allocated by OutputTrack::write()
     static const uint8_t kMaxOverFlowBuffers = 10;
 
-    Vector < Buffer* >          mBufferQueue;
+    std::deque<Buffer>          mBufferQueue;
     AudioBufferProvider::Buffer mOutBuffer;
     bool                        mActive;
     DuplicatingThread* const    mSourceThread; // for waitTimeMs() in write()
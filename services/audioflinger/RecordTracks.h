@@ -118,6 +118,9 @@ private:
 
             // used by the record thread to convert frames to proper destination format
             RecordBufferConverter              *mRecordBufferConverter;
+            // true if the converter was not used while the track copied the output
+            // of another track with the same configuration, see RecordThread::convertShared().
+            bool                               mConverterStale = false;
             audio_input_flags_t                mFlags;
 
             bool                               mSilenced;
@@ -212,7 +215,7 @@ private:
     sp<StreamInHalInterface> obtainStream(sp<ThreadBase>* thread);
 
     PatchRecordAudioBufferProvider mPatchRecordAudioBufferProvider;
-    std::unique_ptr<void, decltype(free)*> mSinkBuffer;  // frame size aligned continuous buffer
+    std::unique_ptr<void, decltype(free)*> mSinkBuffer;  // used on patch buffer wraparound
     std::unique_ptr<void, decltype(free)*> mStubBuffer;  // buffer used for AudioBufferProvider
     size_t mUnconsumedFrames = 0;
     std::mutex mReadLock;
@@ -98,6 +98,9 @@ private:
         {
         }
 
+        // Called with each complete data burst, already framed and byte swapped by
+        // SPDIFEncoder in libaudiospdif. The burst buffer is handed to the HAL as is,
+        // so the framing cost is entirely in the encoder.
         virtual ssize_t writeOutput(const void* buffer, size_t bytes)
         {
             return mSpdifStreamOut->writeDataBurst(buffer, bytes);
@@ -19,6 +19,10 @@
 
 #include <mutex>
 
+#include <cpustats/ThreadCpuSampler.h>
+
+#include "FastThreadDumpState.h"
+
 namespace android {
 
 /**
@@ -128,6 +132,60 @@ public:
         mUnderrunFrames += frames;
     }
 
+    // Called periodically from the threadLoop of an offload thread with the number of
+    // threadLoop cycles, each one an AP wakeup, during durationNs of playback.
+    void logWakeups(uint32_t wakeups, int64_t durationNs) {
+        if (durationNs <= 0) return;
+        mediametrics::LogItem(mMetricsId)
+            .set(AMEDIAMETRICS_PROP_WAKEUPSPERMIN, wakeups * 60e9 / durationNs)
+            .record();
+        std::lock_guard l(mLock);
+        mWakeups += wakeups;
+        mWakeupDurationNs += durationNs;
+    }
+
+    // Called periodically from the threadLoop of a thread with a FastMixer or FastCapture
+    // to deliver the FastThread cycle summaries published since the last call.
+    void logFastThreadCycleSummaries(const FastThreadDumpState& dumpState) {
+        FastThreadCycleSummary summaries[FastThreadDumpState::kCycleSummaryN];
+        const size_t count = dumpState.readCycleSummaries(
+                &mFastThreadCycleSummaryFront, summaries, FastThreadDumpState::kCycleSummaryN);
+        for (size_t i = 0; i < count; ++i) {
+            const FastThreadCycleSummary& summary = summaries[i];
+            mediametrics::LogItem(mMetricsId)
+                .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADCYCLES)
+                .set(AMEDIAMETRICS_PROP_INTERVALENDNS, summary.mEndRealtimeNs)
+                .set(AMEDIAMETRICS_PROP_DURATIONNS, summary.mDurationNs)
+                .set(AMEDIAMETRICS_PROP_CYCLECOUNT, (int32_t)summary.mCycles)
+                .set(AMEDIAMETRICS_PROP_CYCLEMEANMS,
+                        summary.mCycleTotalNs * 1e-6 / summary.mCycles)
+                .set(AMEDIAMETRICS_PROP_CYCLEP50MS, summary.mCycleP50Ns * 1e-6)
+                .set(AMEDIAMETRICS_PROP_CYCLEP90MS, summary.mCycleP90Ns * 1e-6)
+                .set(AMEDIAMETRICS_PROP_CYCLEP99MS, summary.mCycleP99Ns * 1e-6)
+                .set(AMEDIAMETRICS_PROP_CYCLEMAXMS, summary.mCycleMaxNs * 1e-6)
+                .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)summary.mUnderruns)
+                .set(AMEDIAMETRICS_PROP_OVERRUN, (int32_t)summary.mOverruns)
+                .set(AMEDIAMETRICS_PROP_LOADPERCENT, summary.mCycleTotalNs > 0
+                        ? summary.mLoadTotalNs * 100. / summary.mCycleTotalNs : 0.)
+                .record();
+        }
+    }
+
+    // Called from the threadLoop when it starts, with its handle in ThreadCpuSampler,
+    // and with -1 before it exits.  The CPU load sampled for the thread is delivered
+    // with the cumulative metrics of each interval group.
+    void logCpuSamplerHandle(int handle) {
+        std::lock_guard l(mLock);
+        if (handle < 0 && mCpuSamplerHandle >= 0) {
+            // keep the load sampled until exit for the interval group still open.
+            ThreadCpuSampler::getInstance().getLoad(mCpuSamplerHandle, &mCpuLoad);
+        } else if (handle >= 0) {
+            ThreadCpuSampler::getInstance().resetLoad(handle);
+            mCpuLoad.reset();
+        }
+        mCpuSamplerHandle = handle;
+    }
+
     const std::string& getMetricsId() const {
         return mMetricsId;
     }
@@ -163,6 +221,20 @@ private:
                 item.set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)mUnderrunCount)
                     .set(AMEDIAMETRICS_PROP_UNDERRUNFRAMES, (int64_t)mUnderrunFrames);
             }
+            if (mWakeupDurationNs > 0) {
+                item.set(AMEDIAMETRICS_PROP_WAKEUPSPERMIN, mWakeups * 60e9 / mWakeupDurationNs);
+            }
+            ThreadCpuSampler::Load load;
+            if (getCpuLoad_l(&load) && load.mPercent.n() > 0) {
+                std::string histogram;
+                for (int i = 0; i < ThreadCpuSampler::kLoadBuckets; ++i) {
+                    if (i > 0) histogram.append(",");
+                    histogram.append(std::to_string(load.mHistogram[i]));
+                }
+                item.set(AMEDIAMETRICS_PROP_CPULOADMEANPERCENT, load.mPercent.mean())
+                    .set(AMEDIAMETRICS_PROP_CPULOADMAXPERCENT, load.mPercent.maximum())
+                    .set(AMEDIAMETRICS_PROP_CPULOADHISTOGRAM, histogram.c_str());
+            }
             item.record();
         }
     }
@@ -180,11 +252,28 @@ private:
         mLastUnderrun = false;
         mUnderrunCount = 0;
         mUnderrunFrames = 0;
+
+        mWakeups = 0;
+        mWakeupDurationNs = 0;
+
+        ThreadCpuSampler::getInstance().resetLoad(mCpuSamplerHandle);
+        mCpuLoad.reset();
+    }
+
+    bool getCpuLoad_l(ThreadCpuSampler::Load *load) const REQUIRES(mLock) {
+        if (mCpuSamplerHandle >= 0) {
+            return ThreadCpuSampler::getInstance().getLoad(mCpuSamplerHandle, load);
+        }
+        *load = mCpuLoad;
+        return true;
     }
 
     const std::string mMetricsId;
     const bool        mIsOut;  // if true, than a playback track, otherwise used for record.
 
+    // only accessed from the threadLoop, see logFastThreadCycleSummaries().
+    uint32_t          mFastThreadCycleSummaryFront = 0;
+
     mutable           std::mutex mLock;
 
     // Devices in the interval group.
@@ -205,6 +294,15 @@ private:
     bool              mLastUnderrun GUARDED_BY(mLock) = false; // checks consecutive underruns
     int64_t           mUnderrunCount GUARDED_BY(mLock) = 0;    // number of consecutive underruns
     int64_t           mUnderrunFrames GUARDED_BY(mLock) = 0;   // total estimated frames underrun
+
+    // offload thread wakeups and the playback time they were counted over
+    int64_t           mWakeups GUARDED_BY(mLock) = 0;
+    int64_t           mWakeupDurationNs GUARDED_BY(mLock) = 0;
+
+    // CPU load of the threadLoop, sampled by ThreadCpuSampler while the handle is valid,
+    // otherwise kept in mCpuLoad from when the threadLoop exited.
+    int               mCpuSamplerHandle GUARDED_BY(mLock) = -1;
+    ThreadCpuSampler::Load mCpuLoad GUARDED_BY(mLock);
 };
 
 } // namespace android
@@ -21,12 +21,14 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <math.h>
 #include <fcntl.h>
 #include <memory>
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <linux/futex.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
@@ -87,6 +89,7 @@
 
 #ifdef DEBUG_CPU_USAGE
 #include <audio_utils/Statistics.h>
+#include <cpustats/ThreadCpuSampler.h>
 #include <cpustats/ThreadCpuUsage.h>
 #endif
 
@@ -179,6 +182,14 @@ static const nsecs_t kOffloadStandbyDelayNs = seconds(1);
 // Direct output thread minimum sleep time in idle or active(underrun) state
 static const nsecs_t kDirectMinSleepTimeUs = 10000;
 
+// Offload thread predictive writes: audio left in the DSP when the next write is due, and the
+// longest sleep between two checks.
+static const int64_t kPredictiveWriteMarginUs = 250000;
+static const int64_t kMaxPredictiveSleepUs = 1000000;
+
+// Interval at which offload thread wakeups are reported to ThreadMetrics during playback.
+static const nsecs_t kWakeupReportIntervalNs = seconds(60);
+
 // Minimum amount of time between checking to see if the timestamp is advancing
 // for underrun detection. If we check too frequently, we may not detect a
 // timestamp update and will falsely detect underrun.
@@ -3771,6 +3782,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
     CpuStats cpuStats;
     const String8 myName(String8::format("thread %p type %d TID %d", this, mType, gettid()));
 
+    ThreadCpuSampler::Scoped cpuSampler(mThreadName);
+    mThreadMetrics.logCpuSamplerHandle(cpuSampler.handle());
+
     acquireWakeLock();
 
     // mNBLogWriter logging APIs can only be called by a single thread, typically the
@@ -4376,6 +4390,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
     releaseWakeLock();
 
+    mThreadMetrics.logCpuSamplerHandle(-1);
     ALOGV("Thread %p type %d exiting", this, mType);
     return false;
 }
@@ -4777,6 +4792,8 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    mParallelMixThreads = std::max(0, property_get_int32("af.mixer.parallel_threads", 0));
+    mAudioMixer->setParallelMixThreads(mParallelMixThreads);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -4994,6 +5011,7 @@ ssize_t AudioFlinger::MixerThread::threadLoop_write()
     // FIXME we should only do one push per cycle; confirm this is true
     // Start the fast mixer if it's not already running
     if (mFastMixer != 0) {
+        mThreadMetrics.logFastThreadCycleSummaries(mFastMixerDumpState);
         FastMixerStateQueue *sq = mFastMixer->sq();
         FastMixerState *state = sq->begin();
         if (state->mCommand != FastMixerState::MIX_WRITE &&
@@ -5191,6 +5209,8 @@ void AudioFlinger::MixerThread::threadLoop_sleepTime()
 AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTracks_l(
         Vector< sp<Track> > *tracksToRemove)
 {
+    const nsecs_t startNs = systemTime();
+
     // clean up deleted track ids in AudioMixer before allocating new tracks
     (void)mTracks.processDeletedTrackIds([this](int trackId) {
         // for each trackId, destroy it in the AudioMixer
@@ -5507,6 +5527,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                 track->invalidate(); // consider it dead.
                 continue;
             }
+            track->mMixerParamsGeneration = 0; // set all parameters of the new mixer track
         }
 
         // make sure that we have enough frames to mix one full buffer.
@@ -5662,31 +5683,40 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             mAudioMixer->setBufferProvider(trackId, track);
             mAudioMixer->enable(trackId);
 
-            mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME0, &vlf);
-            mAudioMixer->setParameter(trackId, param, AudioMixer::VOLUME1, &vrf);
-            mAudioMixer->setParameter(trackId, param, AudioMixer::AUXLEVEL, &vaf);
-            mAudioMixer->setParameter(
-                trackId,
+            // Only set the parameters that changed since they were last set for this track,
+            // as each AudioMixer::setParameter() looks up the track. Equal volumes are ignored by
+            // the AudioMixer whether ramped or not, so skipping them does not change the mix.
+            Track::MixerParams& lastParams = track->mMixerParams;
+            const bool setAllParams = track->mMixerParamsGeneration != mAudioMixerGeneration;
+            track->mMixerParamsGeneration = mAudioMixerGeneration;
+            const auto setParameterIfChanged = [&](auto& last, std::decay_t<decltype(last)> value,
+                    int target, int name, void *arg) {
+                if (setAllParams || memcmp(&last, &value, sizeof(last)) != 0) {
+                    last = value;
+                    mAudioMixer->setParameter(trackId, target, name, arg);
+                    mMixerParamsSet++;
+                } else {
+                    mMixerParamsSkipped++;
+                }
+            };
+
+            setParameterIfChanged(lastParams.volume[0], vlf, param, AudioMixer::VOLUME0, &vlf);
+            setParameterIfChanged(lastParams.volume[1], vrf, param, AudioMixer::VOLUME1, &vrf);
+            setParameterIfChanged(lastParams.auxLevel, vaf, param, AudioMixer::AUXLEVEL, &vaf);
+            setParameterIfChanged(lastParams.format, track->format(),
                 AudioMixer::TRACK,
                 AudioMixer::FORMAT, (void *)track->format());
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.channelMask, track->channelMask(),
                 AudioMixer::TRACK,
                 AudioMixer::CHANNEL_MASK, (void *)(uintptr_t)track->channelMask());
 
-            if (mType == SPATIALIZER && !track->isSpatialized()) {
-                mAudioMixer->setParameter(
-                    trackId,
-                    AudioMixer::TRACK,
-                    AudioMixer::MIXER_CHANNEL_MASK,
-                    (void *)(uintptr_t)(mChannelMask | mHapticChannelMask));
-            } else {
-                mAudioMixer->setParameter(
-                    trackId,
-                    AudioMixer::TRACK,
-                    AudioMixer::MIXER_CHANNEL_MASK,
-                    (void *)(uintptr_t)(mMixerChannelMask | mHapticChannelMask));
-            }
+            const audio_channel_mask_t mixerChannelMask =
+                    mType == SPATIALIZER && !track->isSpatialized()
+                            ? (audio_channel_mask_t)(mChannelMask | mHapticChannelMask)
+                            : (audio_channel_mask_t)(mMixerChannelMask | mHapticChannelMask);
+            setParameterIfChanged(lastParams.mixerChannelMask, mixerChannelMask,
+                AudioMixer::TRACK,
+                AudioMixer::MIXER_CHANNEL_MASK, (void *)(uintptr_t)mixerChannelMask);
 
             // limit track sample rate to 2 x output sample rate, which changes at re-configuration
             uint32_t maxSampleRate = mSampleRate * AUDIO_RESAMPLER_DOWN_RATIO_MAX;
@@ -5696,15 +5726,13 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             } else if (reqSampleRate > maxSampleRate) {
                 reqSampleRate = maxSampleRate;
             }
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.sampleRate, reqSampleRate,
                 AudioMixer::RESAMPLE,
                 AudioMixer::SAMPLE_RATE,
                 (void *)(uintptr_t)reqSampleRate);
 
             AudioPlaybackRate playbackRate = proxy->getPlaybackRate();
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.playbackRate, playbackRate,
                 AudioMixer::TIMESTRETCH,
                 AudioMixer::PLAYBACK_RATE,
                 &playbackRate);
@@ -5721,54 +5749,41 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
              * into it.
              *
              */
+            audio_format_t mixerFormat;
+            void *mainBuffer;
             if (mMixerBufferEnabled
                     && (track->mainBuffer() == mSinkBuffer
                             || track->mainBuffer() == mMixerBuffer)) {
                 if (mType == SPATIALIZER && !track->isSpatialized()) {
-                    mAudioMixer->setParameter(
-                            trackId,
-                            AudioMixer::TRACK,
-                            AudioMixer::MIXER_FORMAT, (void *)mEffectBufferFormat);
-                    mAudioMixer->setParameter(
-                            trackId,
-                            AudioMixer::TRACK,
-                            AudioMixer::MAIN_BUFFER, (void *)mPostSpatializerBuffer);
+                    mixerFormat = mEffectBufferFormat;
+                    mainBuffer = mPostSpatializerBuffer;
                 } else {
-                    mAudioMixer->setParameter(
-                            trackId,
-                            AudioMixer::TRACK,
-                            AudioMixer::MIXER_FORMAT, (void *)mMixerBufferFormat);
-                    mAudioMixer->setParameter(
-                            trackId,
-                            AudioMixer::TRACK,
-                            AudioMixer::MAIN_BUFFER, (void *)mMixerBuffer);
+                    mixerFormat = mMixerBufferFormat;
+                    mainBuffer = mMixerBuffer;
                     // TODO: override track->mainBuffer()?
                     mMixerBufferValid = true;
                 }
             } else {
-                mAudioMixer->setParameter(
-                        trackId,
-                        AudioMixer::TRACK,
-                        AudioMixer::MIXER_FORMAT, (void *)EFFECT_BUFFER_FORMAT);
-                mAudioMixer->setParameter(
-                        trackId,
-                        AudioMixer::TRACK,
-                        AudioMixer::MAIN_BUFFER, (void *)track->mainBuffer());
+                mixerFormat = EFFECT_BUFFER_FORMAT;
+                mainBuffer = track->mainBuffer();
             }
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.mixerFormat, mixerFormat,
+                    AudioMixer::TRACK,
+                    AudioMixer::MIXER_FORMAT, (void *)mixerFormat);
+            setParameterIfChanged(lastParams.mainBuffer, mainBuffer,
+                    AudioMixer::TRACK,
+                    AudioMixer::MAIN_BUFFER, mainBuffer);
+            setParameterIfChanged(lastParams.auxBuffer, (void *)track->auxBuffer(),
                 AudioMixer::TRACK,
                 AudioMixer::AUX_BUFFER, (void *)track->auxBuffer());
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.hapticPlaybackEnabled,
+                track->getHapticPlaybackEnabled(),
                 AudioMixer::TRACK,
                 AudioMixer::HAPTIC_ENABLED, (void *)(uintptr_t)track->getHapticPlaybackEnabled());
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.hapticIntensity, track->getHapticIntensity(),
                 AudioMixer::TRACK,
                 AudioMixer::HAPTIC_INTENSITY, (void *)(uintptr_t)track->getHapticIntensity());
-            mAudioMixer->setParameter(
-                trackId,
+            setParameterIfChanged(lastParams.hapticMaxAmplitude, track->mHapticMaxAmplitude,
                 AudioMixer::TRACK,
                 AudioMixer::HAPTIC_MAX_AMPLITUDE, (void *)(&(track->mHapticMaxAmplitude)));
 
@@ -5963,6 +5978,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     if (fastTracks > 0) {
         mixerStatus = MIXER_TRACKS_READY;
     }
+    mPrepareTracksUs.add((systemTime() - startNs) * 1e-3);
     return mixerStatus;
 }
 
@@ -6089,6 +6105,8 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            mAudioMixerGeneration++;
+            mAudioMixer->setParallelMixThreads(mParallelMixThreads);
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 status_t status = mAudioMixer->create(
@@ -6115,6 +6133,15 @@ void AudioFlinger::MixerThread::dumpInternals_l(int fd, const Vector<String16>&
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    if (mPrepareTracksUs.getN() > 0) {
+        dprintf(fd, "  prepareTracks_l time us stats: %s\n", mPrepareTracksUs.toString().c_str());
+    }
+    dprintf(fd, "  AudioMixer parameters set: %llu  unchanged: %llu\n",
+            (unsigned long long)mMixerParamsSet, (unsigned long long)mMixerParamsSkipped);
+    if (mParallelMixThreads > 1) {
+        dprintf(fd, "  AudioMixer parallel mix threads: %zu\n%s", mParallelMixThreads,
+                mAudioMixer->parallelMixTimingToString().c_str());
+    }
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6809,7 +6836,9 @@ void AudioFlinger::AsyncCallbackThread::setAsyncError()
 AudioFlinger::OffloadThread::OffloadThread(const sp<AudioFlinger>& audioFlinger,
         AudioStreamOut* output, audio_io_handle_t id, bool systemReady)
     :   DirectOutputThread(audioFlinger, output, id, OFFLOAD, systemReady),
-        mPausedWriteLength(0), mPausedBytesRemaining(0), mKeepWakeLock(true)
+        mPausedWriteLength(0), mPausedBytesRemaining(0), mKeepWakeLock(true),
+        mPredictiveWrite(property_get_bool("af.offload.predictive_write",
+                false /* default_value */))
 {
     //FIXME: mStandby should be set to true by ThreadBase constructo
     mStandby = true;
@@ -6843,6 +6872,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
     bool doHwResume = false;
 
     ALOGV("OffloadThread::prepareTracks_l active tracks %zu", count);
+    mPredictedSleepUs = 0;
 
     // find out which tracks need to be processed
     for (const sp<Track> &t : mActiveTracks) {
@@ -6968,8 +6998,18 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
                 } else {
                     track->mRetryCount = kMaxTrackRetriesOffload;
                 }
-                mActiveTrack = t;
-                mixerStatus = MIXER_TRACKS_READY;
+                if (mPredictiveWrite && mBytesRemaining == 0 && !track->isStopping_1()
+                        && track->framesReady() < mFrameCount) {
+                    mPredictedSleepUs = predictiveSleepTimeUs();
+                }
+                if (mPredictedSleepUs > 0) {
+                    // Less than a full write is ready and the DSP holds plenty: wait for more
+                    // data rather than waking the DSP up for a short write.
+                    mixerStatus = MIXER_TRACKS_ENABLED;
+                } else {
+                    mActiveTrack = t;
+                    mixerStatus = MIXER_TRACKS_READY;
+                }
             }
         } else {
             ALOGVV("OffloadThread: track(%d) s=%08x [NOT READY]", track->id(), cblk->mServer);
@@ -7040,6 +7080,10 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
                     }
                 } else if (last){
                     mixerStatus = MIXER_TRACKS_ENABLED;
+                    if (mPredictiveWrite) {
+                        // no need to poll for data while the DSP holds plenty
+                        mPredictedSleepUs = predictiveSleepTimeUs();
+                    }
                 }
             }
         }
@@ -7068,9 +7112,117 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
     // remove all the tracks that need to be...
     removeTracks_l(*tracksToRemove);
 
+    logWakeup(mixerStatus);
     return mixerStatus;
 }
 
+void AudioFlinger::OffloadThread::threadLoop_sleepTime()
+{
+    DirectOutputThread::threadLoop_sleepTime();
+    if (mPredictedSleepUs > mSleepTimeUs && !mHwPaused && mMixerStatus == MIXER_TRACKS_ENABLED) {
+        mSleepTimeUs = mPredictedSleepUs;
+    }
+}
+
+ssize_t AudioFlinger::OffloadThread::threadLoop_write()
+{
+    const size_t offered = mBytesRemaining;
+    const ssize_t bytesWritten = DirectOutputThread::threadLoop_write();
+    if (mPredictiveWrite && bytesWritten >= 0 && (size_t)bytesWritten < offered) {
+        // The HAL took less than offered, so its buffer is full.
+        onHalBufferFull(mBytesWritten + bytesWritten);
+    }
+    return bytesWritten;
+}
+
+void AudioFlinger::OffloadThread::onHalBufferFull(int64_t bytesWritten)
+{
+    uint64_t position;
+    struct timespec timestamp;
+    if (mOutput->getPresentationPosition(&position, &timestamp) != NO_ERROR) {
+        return;
+    }
+    const int64_t frames = (int64_t)position;
+    if (mRateRefFrames < 0 || frames < mRateRefFrames || bytesWritten < mRateRefBytes) {
+        mRateRefBytes = bytesWritten;
+        mRateRefFrames = frames;
+    } else if (frames - mRateRefFrames >= (int64_t)mSampleRate) {
+        // The HAL was full at both ends of the window, so all that was written in between has
+        // been consumed.
+        const double rate = (double)(bytesWritten - mRateRefBytes) * mSampleRate
+                / (frames - mRateRefFrames);
+        mBytesPerSecond = mBytesPerSecond > 0 ? 0.75 * mBytesPerSecond + 0.25 * rate : rate;
+        mRateRefBytes = bytesWritten;
+        mRateRefFrames = frames;
+        ALOGV("%s: DSP consumes %.0f bytes/s", __func__, mBytesPerSecond);
+    }
+    mFullBytes = bytesWritten;
+    mFullFrames = frames;
+}
+
+int64_t AudioFlinger::OffloadThread::predictBufferedUs()
+{
+    // mBytesWritten is reset on standby
+    if (mBytesPerSecond <= 0 || mFullFrames < 0 || mBytesWritten < mFullBytes) {
+        return -1;
+    }
+    uint64_t position;
+    struct timespec timestamp;
+    if (mOutput->getPresentationPosition(&position, &timestamp) != NO_ERROR) {
+        return -1;
+    }
+    int64_t frames = (int64_t)position;
+    if (!mHwPaused) {
+        // extrapolate the position to now
+        const nsecs_t elapsedNs = systemTime()
+                - (timestamp.tv_sec * NANOS_PER_SECOND + timestamp.tv_nsec);
+        frames += std::max<nsecs_t>(elapsedNs, 0) * mSampleRate / NANOS_PER_SECOND;
+    }
+    if (frames < mFullFrames) {
+        return -1;
+    }
+    // When the HAL was full, at least the last sink buffer was queued.
+    const double consumed = (double)(frames - mFullFrames) * mBytesPerSecond / mSampleRate;
+    const double buffered = (double)mSinkBufferSize + (mBytesWritten - mFullBytes) - consumed;
+    return buffered > 0 ? (int64_t)(buffered * 1000000 / mBytesPerSecond) : 0;
+}
+
+uint32_t AudioFlinger::OffloadThread::predictiveSleepTimeUs()
+{
+    const int64_t bufferedUs = predictBufferedUs();
+    if (bufferedUs <= kPredictiveWriteMarginUs + kDirectMinSleepTimeUs) {
+        return 0;
+    }
+    return (uint32_t)std::min(bufferedUs - kPredictiveWriteMarginUs, kMaxPredictiveSleepUs);
+}
+
+void AudioFlinger::OffloadThread::resetPrediction()
+{
+    mBytesPerSecond = 0;
+    mRateRefBytes = -1;
+    mRateRefFrames = -1;
+    mFullBytes = -1;
+    mFullFrames = -1;
+    mPredictedSleepUs = 0;
+}
+
+void AudioFlinger::OffloadThread::logWakeup(mixer_state mixerStatus)
+{
+    const nsecs_t now = systemTime();
+    const bool playing = !mStandby && !mHwPaused
+            && (mixerStatus == MIXER_TRACKS_READY || mixerStatus == MIXER_TRACKS_ENABLED);
+    if (playing && mLastWakeupNs != 0) {
+        mWakeups++;
+        mWakeupActiveNs += now - mLastWakeupNs;
+    }
+    mLastWakeupNs = playing ? now : 0;
+    if (mWakeupActiveNs >= kWakeupReportIntervalNs || (!playing && mWakeupActiveNs > 0)) {
+        mThreadMetrics.logWakeups(mWakeups, mWakeupActiveNs);
+        mWakeups = 0;
+        mWakeupActiveNs = 0;
+    }
+}
+
 // must be called with thread mutex locked
 bool AudioFlinger::OffloadThread::waitingAsyncCallback_l()
 {
@@ -7098,6 +7250,7 @@ void AudioFlinger::OffloadThread::flushHw_l()
     mPausedBytesRemaining = 0;
     // reset bytes written count to reflect that DSP buffers are empty after flush.
     mBytesWritten = 0;
+    resetPrediction();
 
     if (mUseAsyncWrite) {
         // discard any pending drain or write ack by incrementing sequence
@@ -7175,8 +7328,11 @@ void AudioFlinger::DuplicatingThread::threadLoop_sleepTime()
 
 ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 {
+    // Output tracks that cannot take all of mSinkBuffer share a single copy of it.
+    std::shared_ptr<int8_t[]> overflowData;
     for (size_t i = 0; i < outputTracks.size(); i++) {
-        const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+        const ssize_t actualWritten =
+                outputTracks[i]->write(mSinkBuffer, writeFrames, overflowData);
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
@@ -7737,6 +7893,9 @@ bool AudioFlinger::RecordThread::threadLoop()
 {
     nsecs_t lastWarning = 0;
 
+    ThreadCpuSampler::Scoped cpuSampler(mThreadName);
+    mThreadMetrics.logCpuSamplerHandle(cpuSampler.handle());
+
     inputStandBy();
 
 reacquire_wakelock:
@@ -7982,6 +8141,10 @@ reacquire_wakelock:
         // now run the fast track destructor with thread mutex unlocked
         fastTrackToRemove.clear();
 
+        if (mFastCapture != 0) {
+            mThreadMetrics.logFastThreadCycleSummaries(mFastCaptureDumpState);
+        }
+
         // Read from HAL to keep up with fastest client if multiple active tracks, not slowest one.
         // Only the client(s) that are too slow will overrun. But if even the fastest client is too
         // slow, then this RecordThread will overrun by not calling HAL read often enough.
@@ -8131,6 +8294,25 @@ reacquire_wakelock:
 
         size = activeTracks.size();
 
+        // Tracks with the same output configuration and read position convert identical
+        // data. Group them so that only the first track of a group (the leader) runs its
+        // RecordBufferConverter, and the result is copied to each track of the group.
+        mConversionLeaders.assign(size, -1);
+        for (size_t i = 0; i < size; i++) {
+            const sp<RecordTrack> &track = activeTracks[i];
+            if (track->isFastTrack() || track->isDirect()) {
+                continue;
+            }
+            mConversionLeaders[i] = i;
+            for (size_t j = 0; j < i; j++) {
+                if ((size_t) mConversionLeaders[j] == j
+                        && canShareConversion(activeTracks[j], track)) {
+                    mConversionLeaders[i] = j;
+                    break;
+                }
+            }
+        }
+
         // loop over each active track
         for (size_t i = 0; i < size; i++) {
             activeTrack = activeTracks[i];
@@ -8140,14 +8322,35 @@ reacquire_wakelock:
                 continue;
             }
 
+            // skip followers, as those are handled with their leader
+            if (mConversionLeaders[i] >= 0 && (size_t) mConversionLeaders[i] != i) {
+                continue;
+            }
+            mConversionGroup.clear();
+            for (size_t j = i + 1; j < size; j++) {
+                if ((size_t) mConversionLeaders[j] == i) {
+                    if (mConversionGroup.empty()) {
+                        mConversionGroup.push_back({activeTrack});
+                    }
+                    mConversionGroup.push_back({activeTracks[j]});
+                }
+            }
+            if (!mConversionGroup.empty()) {
+                convertShared(&lastWarning);
+                mConversionGroup.clear();
+                continue;
+            }
+
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
-            enum {
-                OVERRUN_UNKNOWN,
-                OVERRUN_TRUE,
-                OVERRUN_FALSE
-            } overrun = OVERRUN_UNKNOWN;
+            if (activeTrack->mConverterStale) {
+                // the converter was not used while the track followed another one.
+                activeTrack->mRecordBufferConverter->reset();
+                activeTrack->mConverterStale = false;
+            }
+
+            OverrunState overrun = OVERRUN_UNKNOWN;
 
             // loop over getNextBuffer to handle circular sink
             for (;;) {
@@ -8208,67 +8411,14 @@ reacquire_wakelock:
                     overrun = OVERRUN_FALSE;
                 }
 
-                if (activeTrack->mFramesToDrop == 0) {
-                    if (framesOut > 0) {
-                        activeTrack->mSink.frameCount = framesOut;
-                        // Sanitize before releasing if the track has no access to the source data
-                        // An idle UID receives silence from non virtual devices until active
-                        if (activeTrack->isSilenced()) {
-                            memset(activeTrack->mSink.raw, 0, framesOut * activeTrack->frameSize());
-                        }
-                        activeTrack->releaseBuffer(&activeTrack->mSink);
-                    }
-                } else {
-                    // FIXME could do a partial drop of framesOut
-                    if (activeTrack->mFramesToDrop > 0) {
-                        activeTrack->mFramesToDrop -= (ssize_t)framesOut;
-                        if (activeTrack->mFramesToDrop <= 0) {
-                            activeTrack->clearSyncStartEvent();
-                        }
-                    } else {
-                        activeTrack->mFramesToDrop += framesOut;
-                        if (activeTrack->mFramesToDrop >= 0 || activeTrack->mSyncStartEvent == 0 ||
-                                activeTrack->mSyncStartEvent->isCancelled()) {
-                            ALOGW("Synced record %s, session %d, trigger session %d",
-                                  (activeTrack->mFramesToDrop >= 0) ? "timed out" : "cancelled",
-                                  activeTrack->sessionId(),
-                                  (activeTrack->mSyncStartEvent != 0) ?
-                                          activeTrack->mSyncStartEvent->triggerSession() :
-                                          AUDIO_SESSION_NONE);
-                            activeTrack->clearSyncStartEvent();
-                        }
-                    }
-                }
+                releaseConverted(activeTrack, framesOut);
 
                 if (framesOut == 0) {
                     break;
                 }
             }
 
-            switch (overrun) {
-            case OVERRUN_TRUE:
-                // client isn't retrieving buffers fast enough
-                if (!activeTrack->setOverflow()) {
-                    nsecs_t now = systemTime();
-                    // FIXME should lastWarning per track?
-                    if ((now - lastWarning) > kWarningThrottleNs) {
-                        ALOGW("RecordThread: buffer overflow");
-                        lastWarning = now;
-                    }
-                }
-                break;
-            case OVERRUN_FALSE:
-                activeTrack->clearOverflow();
-                break;
-            case OVERRUN_UNKNOWN:
-                break;
-            }
-
-            // update frame information and push timestamp out
-            activeTrack->updateTrackFrameInfo(
-                    activeTrack->mServerProxy->framesReleased(),
-                    mTimestamp.mPosition[ExtendedTimestamp::LOCATION_SERVER],
-                    mSampleRate, mTimestamp);
+            updateTrackState(activeTrack, overrun, &lastWarning);
         }
 
 unlock:
@@ -8308,10 +8458,163 @@ unlock:
 
     releaseWakeLock();
 
+    mThreadMetrics.logCpuSamplerHandle(-1);
     ALOGV("RecordThread %p exiting", this);
     return false;
 }
 
+bool AudioFlinger::RecordThread::canShareConversion(
+        const sp<RecordTrack>& leader, const sp<RecordTrack>& track) const
+{
+    return leader->sampleRate() == track->sampleRate()
+            && leader->format() == track->format()
+            && leader->channelMask() == track->channelMask()
+            && leader->mResamplerBufferProvider->getFront()
+                    == track->mResamplerBufferProvider->getFront();
+}
+
+void AudioFlinger::RecordThread::convertShared(nsecs_t *lastWarning)
+{
+    // The leader converter and buffer provider are used for the whole group.
+    // A track which has no room left in its buffer leaves the group at its current
+    // position, and continues with its own converter on the next threadLoop() pass.
+    const sp<RecordTrack> leader = mConversionGroup[0].track;
+    ResamplerBufferProvider * const provider = leader->mResamplerBufferProvider;
+    const size_t frameSize = leader->frameSize();
+    if (leader->mConverterStale) {
+        leader->mRecordBufferConverter->reset();
+        leader->mConverterStale = false;
+    }
+    for (size_t i = 1; i < mConversionGroup.size(); i++) {
+        mConversionGroup[i].track->mConverterStale = true;
+    }
+
+    for (;;) {
+        bool hasOverrun;
+        size_t framesIn;
+        provider->sync(&framesIn, &hasOverrun);
+        if (framesIn == 0 && !hasOverrun) {
+            break;
+        }
+        size_t framesOut = destinationFramesPossible(framesIn, mSampleRate, leader->mSampleRate);
+        bool attached = false;
+        for (auto &member : mConversionGroup) {
+            if (member.detached) continue;
+            if (hasOverrun) {
+                member.overrun = OVERRUN_TRUE;
+            }
+            if (framesIn == 0) continue;
+            const sp<RecordTrack> &track = member.track;
+            track->mSink.frameCount = ~0;
+            status_t status = track->getNextBuffer(&track->mSink);
+            LOG_ALWAYS_FATAL_IF((status == OK) != (track->mSink.frameCount > 0));
+            if (track->mSink.frameCount == 0) {
+                member.detached = true;
+                member.front = provider->getFront();
+                track->mConverterStale = true;
+                continue;
+            }
+            framesOut = min(framesOut, track->mSink.frameCount);
+            attached = true;
+        }
+        if (framesIn == 0 || !attached || framesOut == 0) {
+            break;
+        }
+
+        if (mConversionBuffer.size() < framesOut * frameSize) {
+            mConversionBuffer.resize(framesOut * frameSize);
+        }
+        framesOut = leader->mRecordBufferConverter->convert(
+                mConversionBuffer.data(), provider, framesOut);
+
+        for (auto &member : mConversionGroup) {
+            if (member.detached) continue;
+            if (framesOut > 0) {
+                memcpy(member.track->mSink.raw, mConversionBuffer.data(), framesOut * frameSize);
+                if (member.overrun == OVERRUN_UNKNOWN) {
+                    member.overrun = OVERRUN_FALSE;
+                }
+            }
+            releaseConverted(member.track, framesOut);
+        }
+
+        if (framesOut == 0) {
+            break;
+        }
+    }
+
+    const int32_t front = provider->getFront();
+    for (auto &member : mConversionGroup) {
+        member.track->mResamplerBufferProvider->setFront(member.detached ? member.front : front);
+        updateTrackState(member.track, member.overrun, lastWarning);
+    }
+}
+
+void AudioFlinger::RecordThread::releaseConverted(
+        const sp<RecordTrack>& activeTrack, size_t framesOut)
+{
+    if (activeTrack->mFramesToDrop == 0) {
+        if (framesOut > 0) {
+            activeTrack->mSink.frameCount = framesOut;
+            // Sanitize before releasing if the track has no access to the source data
+            // An idle UID receives silence from non virtual devices until active
+            if (activeTrack->isSilenced()) {
+                memset(activeTrack->mSink.raw, 0, framesOut * activeTrack->frameSize());
+            }
+            activeTrack->releaseBuffer(&activeTrack->mSink);
+        }
+    } else {
+        // FIXME could do a partial drop of framesOut
+        if (activeTrack->mFramesToDrop > 0) {
+            activeTrack->mFramesToDrop -= (ssize_t)framesOut;
+            if (activeTrack->mFramesToDrop <= 0) {
+                activeTrack->clearSyncStartEvent();
+            }
+        } else {
+            activeTrack->mFramesToDrop += framesOut;
+            if (activeTrack->mFramesToDrop >= 0 || activeTrack->mSyncStartEvent == 0 ||
+                    activeTrack->mSyncStartEvent->isCancelled()) {
+                ALOGW("Synced record %s, session %d, trigger session %d",
+                      (activeTrack->mFramesToDrop >= 0) ? "timed out" : "cancelled",
+                      activeTrack->sessionId(),
+                      (activeTrack->mSyncStartEvent != 0) ?
+                              activeTrack->mSyncStartEvent->triggerSession() :
+                              AUDIO_SESSION_NONE);
+                activeTrack->clearSyncStartEvent();
+            }
+        }
+    }
+}
+
+void AudioFlinger::RecordThread::updateTrackState(
+        const sp<RecordTrack>& activeTrack, OverrunState overrun, nsecs_t *lastWarning)
+{
+    switch (overrun) {
+    case OVERRUN_TRUE:
+        // client isn't retrieving buffers fast enough
+        if (!activeTrack->setOverflow()) {
+            nsecs_t now = systemTime();
+            // FIXME should lastWarning per track?
+            if ((now - *lastWarning) > kWarningThrottleNs) {
+                ALOGW("RecordThread: buffer overflow");
+                *lastWarning = now;
+            }
+        }
+        break;
+    case OVERRUN_FALSE:
+        activeTrack->clearOverflow();
+        break;
+    case OVERRUN_UNKNOWN:
+        break;
+    }
+
+    // update frame information and push timestamp out
+    activeTrack->updateTrackFrameInfo(
+            activeTrack->mServerProxy->framesReleased(),
+            mTimestamp.mPosition[ExtendedTimestamp::LOCATION_SERVER],
+            mSampleRate, mTimestamp);
+}
+
 void AudioFlinger::RecordThread::standbyIfNotAlreadyInStandby()
 {
     if (!mStandby) {
@@ -8660,6 +8963,7 @@ status_t AudioFlinger::RecordThread::start(RecordThread::RecordTrack* recordTrac
         if (!recordTrack->isDirect()) {
             // clear any converter state as new data will be discontinuous
             recordTrack->mRecordBufferConverter->reset();
+            recordTrack->mConverterStale = false;
         }
         recordTrack->mState = TrackBase::STARTING_2;
         // signal thread to start
@@ -1506,6 +1506,18 @@ private:
                 int32_t     mFastMixerFutex;    // for cold idle
 
                 std::atomic_bool mMasterMono;
+
+                // number of threads mixing resampled tracks of the normal mixer,
+                // from "af.mixer.parallel_threads", 0 or 1 to mix on this thread only.
+                size_t      mParallelMixThreads = 0;
+
+                // Incremented when mAudioMixer is replaced, which invalidates the parameters
+                // cached in each Track::mMixerParams. Never 0, the initial track generation.
+                uint32_t    mAudioMixerGeneration = 1;
+                // updated by prepareTracks_l()
+                audio_utils::Statistics<double> mPrepareTracksUs{0.995 /* alpha */};
+                uint64_t    mMixerParamsSet = 0;      // AudioMixer::setParameter() calls
+                uint64_t    mMixerParamsSkipped = 0;  // unchanged parameters not set
 public:
     virtual     bool        hasFastMixer() const { return mFastMixer != 0; }
     virtual     FastTrackUnderruns getFastTrackUnderruns(size_t fastIndex) const {
@@ -1635,10 +1647,41 @@ protected:
 
     virtual     bool        keepWakeLock() const { return (mKeepWakeLock || (mDrainSequence & 1)); }
 
+    virtual     void        threadLoop_sleepTime();
+    virtual     ssize_t     threadLoop_write();
+
 private:
+    // Predictive writes (af.offload.predictive_write): the DSP consumption rate is learned from
+    // the presentation position between writes that filled the HAL, and writes smaller than a
+    // full sink buffer are deferred, and underrun polling slowed down, while the DSP is
+    // predicted to hold more than a safety margin of audio.
+                void        onHalBufferFull(int64_t bytesWritten);
+                // Returns the predicted time of audio buffered in the DSP, or -1 if unknown.
+                int64_t     predictBufferedUs();
+                // Returns how long the thread may sleep without the DSP running low, 0 if not
+                // longer than usual.
+                uint32_t    predictiveSleepTimeUs();
+                void        resetPrediction();
+                // Counts thread loop cycles while playing, reported as wakeups per minute.
+                void        logWakeup(mixer_state mixerStatus);
+
     size_t      mPausedWriteLength;     // length in bytes of write interrupted by pause
     size_t      mPausedBytesRemaining;  // bytes still waiting in mixbuffer after resume
     bool        mKeepWakeLock;          // keep wake lock while waiting for write callback
+
+    // Predictive writes, only accessed from the threadLoop.
+    const bool  mPredictiveWrite;
+    double      mBytesPerSecond = 0;        // learned DSP consumption, 0 if unknown
+    int64_t     mRateRefBytes = -1;         // mBytesWritten at the start of the rate window
+    int64_t     mRateRefFrames = -1;        // presented frames at the start of the rate window
+    int64_t     mFullBytes = -1;            // mBytesWritten after the last write filling the HAL
+    int64_t     mFullFrames = -1;           // presented frames at that time
+    uint32_t    mPredictedSleepUs = 0;      // set by prepareTracks_l() for this cycle
+
+    // Wakeup metrics, only accessed from the threadLoop.
+    nsecs_t     mLastWakeupNs = 0;
+    uint32_t    mWakeups = 0;
+    nsecs_t     mWakeupActiveNs = 0;
 };
 
 class AsyncCallbackThread : public Thread {
@@ -1980,6 +2023,24 @@ private:
             int32_t getOldestFront_l();
             void    updateFronts_l(int32_t offset);
 
+            // Client buffer overrun state of a RecordTrack for one threadLoop() pass.
+            enum OverrunState {
+                OVERRUN_UNKNOWN,
+                OVERRUN_TRUE,
+                OVERRUN_FALSE
+            };
+
+            // returns true if track would convert the same data as leader.
+            bool    canShareConversion(const sp<RecordTrack>& leader,
+                                       const sp<RecordTrack>& track) const;
+            // converts once for all tracks of mConversionGroup, mConversionGroup[0] is the leader.
+            void    convertShared(nsecs_t *lastWarning);
+            // releases or drops framesOut frames converted into the track mSink.
+            void    releaseConverted(const sp<RecordTrack>& track, size_t framesOut);
+            // updates the track overflow state and frame information at end of a pass.
+            void    updateTrackState(const sp<RecordTrack>& track, OverrunState overrun,
+                                     nsecs_t *lastWarning);
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector < sp<RecordTrack> >    mTracks;
@@ -2050,6 +2111,17 @@ private:
             std::string                         mSharedAudioPackageName = {};
             int32_t                             mSharedAudioStartFrames = -1;
             audio_session_t                     mSharedAudioSessionId = AUDIO_SESSION_NONE;
+
+            // accessible only within the threadLoop(), no locks required
+            struct ConversionMember {
+                sp<RecordTrack>                 track;
+                OverrunState                    overrun = OVERRUN_UNKNOWN;
+                bool                            detached = false;
+                int32_t                         front = 0;  // input position when detached
+            };
+            std::vector<ssize_t>                mConversionLeaders; // per active track, or -1
+            std::vector<ConversionMember>       mConversionGroup;
+            std::vector<uint8_t>                mConversionBuffer;  // shared converted frames
 };
 
 class MmapThread : public ThreadBase
@@ -2042,7 +2042,8 @@ void AudioFlinger::PlaybackThread::OutputTrack::stop()
     mActive = false;
 }
 
-ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t frames)
+ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t frames,
+                                                         std::shared_ptr<int8_t[]>& overflowData)
 {
     Buffer *pInBuffer;
     Buffer inBuffer;
@@ -2057,8 +2058,8 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
 
     while (waitTimeLeftMs) {
         // First write pending buffers, then new data
-        if (mBufferQueue.size()) {
-            pInBuffer = mBufferQueue.itemAt(0);
+        if (!mBufferQueue.empty()) {
+            pInBuffer = &mBufferQueue.front();
         } else {
             pInBuffer = &inBuffer;
         }
@@ -2103,12 +2104,8 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
         mOutBuffer.raw = (int8_t *)mOutBuffer.raw + outFrames * mFrameSize;
 
         if (pInBuffer->frameCount == 0) {
-            if (mBufferQueue.size()) {
-                mBufferQueue.removeAt(0);
-                free(pInBuffer->mBuffer);
-                if (pInBuffer != &inBuffer) {
-                    delete pInBuffer;
-                }
+            if (!mBufferQueue.empty()) {
+                mBufferQueue.pop_front();
                 ALOGV("%s(%d): thread %d released overflow buffer %zu",
                         __func__, mId,
                         (int)mThreadIoHandle, mBufferQueue.size());
@@ -2118,17 +2115,20 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
         }
     }
 
-    // If we could not write all frames, allocate a buffer and queue it for next time.
+    // If we could not write all frames, queue them for next time.
     if (inBuffer.frameCount) {
         sp<ThreadBase> thread = mThread.promote();
         if (thread != 0 && !thread->standby()) {
             if (mBufferQueue.size() < kMaxOverFlowBuffers) {
-                pInBuffer = new Buffer;
-                pInBuffer->mBuffer = malloc(inBuffer.frameCount * mFrameSize);
-                pInBuffer->frameCount = inBuffer.frameCount;
-                pInBuffer->raw = pInBuffer->mBuffer;
-                memcpy(pInBuffer->raw, inBuffer.raw, inBuffer.frameCount * mFrameSize);
-                mBufferQueue.add(pInBuffer);
+                if (overflowData == nullptr) {
+                    // The other output tracks of the cycle reuse this copy.
+                    overflowData.reset(new int8_t[frames * mFrameSize]);
+                    memcpy(overflowData.get(), data, frames * mFrameSize);
+                }
+                Buffer& overflow = mBufferQueue.emplace_back();
+                overflow.mData = overflowData;
+                overflow.frameCount = inBuffer.frameCount;
+                overflow.raw = overflowData.get() + (frames - inBuffer.frameCount) * mFrameSize;
                 ALOGV("%s(%d): thread %d adding overflow buffer %zu", __func__, mId,
                         (int)mThreadIoHandle, mBufferQueue.size());
                 // audio data is consumed (stored locally); set frameCount to 0.
@@ -2143,7 +2143,7 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
 
     // Calling write() with a 0 length buffer means that no more data will be written:
     // We rely on stop() to set the appropriate flags to allow the remaining frames to play out.
-    if (frames == 0 && mBufferQueue.size() == 0 && mActive) {
+    if (frames == 0 && mBufferQueue.empty() && mActive) {
         stop();
     }
 
@@ -2181,18 +2181,16 @@ status_t AudioFlinger::PlaybackThread::OutputTrack::obtainBuffer(
 
 void AudioFlinger::PlaybackThread::OutputTrack::clearBufferQueue()
 {
-    size_t size = mBufferQueue.size();
-
-    for (size_t i = 0; i < size; i++) {
-        Buffer *pBuffer = mBufferQueue.itemAt(i);
-        free(pBuffer->mBuffer);
-        delete pBuffer;
-    }
     mBufferQueue.clear();
 }
 
 void AudioFlinger::PlaybackThread::OutputTrack::restartIfDisabled()
 {
+    // This runs after every buffer handed to the downstream thread. Only read the flags,
+    // which the downstream thread also updates, unless the track was disabled.
+    if ((mCblk->mFlags & CBLK_DISABLED) == 0) {
+        return;
+    }
     int32_t flags = android_atomic_and(~CBLK_DISABLED, &mCblk->mFlags);
     if (mActive && (flags & CBLK_DISABLED)) {
         start();
@@ -2963,11 +2961,29 @@ status_t AudioFlinger::RecordThread::PassthruPatchRecord::obtainBuffer(
 
     status_t result = NO_ERROR;
     size_t bytesRead = 0;
+    // Read from HAL directly into the patch buffer when the requested frames are contiguous,
+    // which is the usual case as reads and writes have the same size. Otherwise read into
+    // mSinkBuffer and copy, as a HAL read should not be cut at the buffer wraparound.
+    AudioBufferProvider::Buffer patchBuffer;
+    patchBuffer.frameCount = framesToRead;
+    if (mPatchRecordAudioBufferProvider.getNextBuffer(&patchBuffer) != NO_ERROR) {
+        patchBuffer.frameCount = 0;
+    } else if (patchBuffer.frameCount != framesToRead) {
+        patchBuffer.frameCount = 0;
+        mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+    }
     {
         ATRACE_NAME("read");
-        result = stream->read(mSinkBuffer.get(), framesToRead * mFrameSize, &bytesRead);
-        if (result != NO_ERROR) goto stream_error;
-        if (bytesRead == 0) return NO_ERROR;
+        void * const sink = patchBuffer.frameCount != 0 ? patchBuffer.raw : mSinkBuffer.get();
+        result = stream->read(sink, framesToRead * mFrameSize, &bytesRead);
+        if (result != NO_ERROR || bytesRead == 0) {
+            if (patchBuffer.frameCount != 0) {
+                patchBuffer.frameCount = 0;
+                mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+            }
+            if (result != NO_ERROR) goto stream_error;
+            return NO_ERROR;
+        }
     }
 
     {
@@ -2976,13 +2992,20 @@ status_t AudioFlinger::RecordThread::PassthruPatchRecord::obtainBuffer(
         mReadError = NO_ERROR;
     }
     mReadCV.notify_one();
-    // writeFrames handles wraparound and should write all the provided frames.
-    // If it couldn't, there is something wrong with the client/server buffer of the software patch.
-    buffer->mFrameCount = writeFrames(
-            &mPatchRecordAudioBufferProvider,
-            mSinkBuffer.get(), bytesRead / mFrameSize, mFrameSize);
-    ALOGW_IF(buffer->mFrameCount < bytesRead / mFrameSize,
-            "Lost %zu frames obtained from HAL", bytesRead / mFrameSize - buffer->mFrameCount);
+    if (patchBuffer.frameCount != 0) {
+        patchBuffer.frameCount = bytesRead / mFrameSize;
+        buffer->mFrameCount = patchBuffer.frameCount;
+        mPatchRecordAudioBufferProvider.releaseBuffer(&patchBuffer);
+    } else {
+        // writeFrames handles wraparound and should write all the provided frames.
+        // If it couldn't, there is something wrong with the client/server buffer of the
+        // software patch.
+        buffer->mFrameCount = writeFrames(
+                &mPatchRecordAudioBufferProvider,
+                mSinkBuffer.get(), bytesRead / mFrameSize, mFrameSize);
+        ALOGW_IF(buffer->mFrameCount < bytesRead / mFrameSize,
+                "Lost %zu frames obtained from HAL", bytesRead / mFrameSize - buffer->mFrameCount);
+    }
     mUnconsumedFrames = buffer->mFrameCount;
     struct timespec newTimeOut;
     if (startTimeNs) {
@@ -21,6 +21,11 @@
 namespace android {
 
 status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config);
+// Same as deserializeAudioPolicyFile(), but first tries a binary snapshot of a previous
+// deserialization stored in cacheFile, which is only used if none of the XML files it was
+// made from have changed. After parsing the XML, the snapshot is (re)written for the next time.
+status_t deserializeAudioPolicyFileCached(const char *fileName, const char *cacheFile,
+        AudioPolicyConfig *config, bool *cacheHit = nullptr);
 // In VTS mode all vendor extensions are ignored. This is done because
 // VTS tests are built using AOSP code and thus can not use vendor overlays
 // of system libraries.
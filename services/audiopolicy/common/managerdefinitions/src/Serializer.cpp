@@ -17,11 +17,22 @@
 #define LOG_TAG "APM::Serializer"
 //#define LOG_NDEBUG 0
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
+#include <vector>
 
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <cutils/properties.h>
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
 #include <media/convert.h>
@@ -240,6 +251,9 @@ public:
     std::variant<status_t, typename Trait::Element> deserialize(const xmlNode *cur,
             typename Trait::PtrSerializingCtx serializingContext);
 
+    /** @return the configuration file and the files it includes, valid after deserialize(). */
+    const std::vector<std::string>& getSourceFiles() const { return mSourceFiles; }
+
 private:
     static constexpr const char *rootName = "audioPolicyConfiguration";
     static constexpr const char *versionAttribute = "version";
@@ -250,6 +264,7 @@ private:
     std::string mChannelMasksSeparator = ",";
     std::string mSamplingRatesSeparator = ",";
     std::string mFlagsSeparator = "|";
+    std::vector<std::string> mSourceFiles;
 
     // Children: ModulesTraits, VolumeTraits, SurroundSoundTraits (optional)
 };
@@ -291,6 +306,34 @@ std::string getXmlAttribute(const xmlNode *cur, const char *attribute)
     return value;
 }
 
+/** Gains are indexed in creation order, across all the ports of all the modules. */
+uint32_t nextAudioGainIndex()
+{
+    static uint32_t index = 0;
+    return index++;
+}
+
+/** Appends the files referenced by the XInclude elements under cur, resolved against the doc. */
+void collectXIncludes(const xmlNode *cur, std::vector<std::string> *files)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type != XML_ELEMENT_NODE) continue;
+        if (cur->ns != NULL && !xmlStrcmp(cur->name, XINCLUDE_NODE) &&
+                (!xmlStrcmp(cur->ns->href, XINCLUDE_NS) ||
+                        !xmlStrcmp(cur->ns->href, XINCLUDE_OLD_NS))) {
+            auto href = make_xmlUnique(xmlGetProp(cur, XINCLUDE_HREF));
+            if (href != nullptr) {
+                auto uri = make_xmlUnique(xmlBuildURI(href.get(), cur->doc->URL));
+                if (uri != nullptr) {
+                    files->push_back(reinterpret_cast<const char*>(uri.get()));
+                }
+            }
+            continue;
+        }
+        collectXIncludes(cur->children, files);
+    }
+}
+
 template <class Trait>
 const xmlNode* getReference(const xmlNode *cur, const std::string &refName)
 {
@@ -353,8 +396,7 @@ std::variant<status_t, AudioGainTraits::Element> PolicySerializer::deserialize<A
 {
     using Attributes = AudioGainTraits::Attributes;
 
-    static uint32_t index = 0;
-    AudioGainTraits::Element gain = new AudioGain(index++, true);
+    AudioGainTraits::Element gain = new AudioGain(nextAudioGainIndex(), true);
 
     std::string mode = getXmlAttribute(cur, Attributes::mode);
     if (!mode.empty()) {
@@ -861,6 +903,8 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
         ALOGE("%s: Could not parse %s document: empty.", __func__, configFile);
         return BAD_VALUE;
     }
+    mSourceFiles = { configFile };
+    collectXIncludes(root, &mSourceFiles);
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
@@ -901,6 +945,501 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     return android::OK;
 }
 
+/**
+ * Binary snapshot of a deserialized AudioPolicyConfig.
+ *
+ * Parsing the XML configuration and converting its literals is a noticeable part of the
+ * audioserver start up. The result of a successful parse is stored in a flat, versioned
+ * format which can be reloaded with a single pass over a mapped file. The snapshot records
+ * the size and hash of every source file (the configuration and its XIncludes) and the build
+ * fingerprint; it is only used while they all match, otherwise the XML is parsed again.
+ */
+class PolicyConfigCache
+{
+public:
+    static status_t load(const char *cacheFile, const char *configFile,
+            AudioPolicyConfig *config);
+    static status_t store(const char *cacheFile, const std::vector<std::string> &sourceFiles,
+            const AudioPolicyConfig &config);
+
+private:
+    static constexpr uint32_t kMagic = 0x43504141; // "AAPC"
+    // Increment whenever the layout written by store() changes.
+    static constexpr uint32_t kVersion = 1;
+
+    class Writer {
+    public:
+        template <typename T>
+        void write(const T &value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            mData.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        void write(const std::string &value) {
+            write<uint32_t>(value.size());
+            mData.append(value);
+        }
+        const std::string &data() const { return mData; }
+    private:
+        std::string mData;
+    };
+
+    // Reads fail (and keep failing) once past the end, leaving the value zero initialized.
+    class Reader {
+    public:
+        Reader(const uint8_t *data, size_t size) : mData(data), mSize(size) {}
+        template <typename T>
+        T read() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value{};
+            if (!mOk || mSize < sizeof(T)) {
+                mOk = false;
+                return value;
+            }
+            memcpy(&value, mData, sizeof(T));
+            mData += sizeof(T);
+            mSize -= sizeof(T);
+            return value;
+        }
+        std::string readString() {
+            const uint32_t size = read<uint32_t>();
+            if (!mOk || mSize < size) {
+                mOk = false;
+                return {};
+            }
+            std::string value(reinterpret_cast<const char*>(mData), size);
+            mData += size;
+            mSize -= size;
+            return value;
+        }
+        // Element counts are bounded by the remaining size, so that a corrupted count
+        // can not cause a large allocation or a long loop.
+        uint32_t readCount() {
+            const uint32_t count = read<uint32_t>();
+            if (count > mSize) mOk = false;
+            return mOk ? count : 0;
+        }
+        bool ok() const { return mOk; }
+        bool atEnd() const { return mOk && mSize == 0; }
+    private:
+        const uint8_t *mData;
+        size_t mSize;
+        bool mOk = true;
+    };
+
+    struct SourceFile {
+        uint64_t size;
+        uint64_t hash;
+    };
+
+    static bool hashFile(const std::string &path, SourceFile *file);
+    static std::string getBuildFingerprint();
+
+    static void writeProfiles(Writer *w, const AudioProfileVector &profiles);
+    static void writeGains(Writer *w, const AudioGains &gains);
+    static void writeModule(Writer *w, const sp<HwModule> &module);
+    static AudioProfileVector readProfiles(Reader *r);
+    static AudioGains readGains(Reader *r);
+    static sp<HwModule> readModule(Reader *r);
+    static status_t readConfig(Reader *r, const char *configFile, AudioPolicyConfig *config);
+};
+
+bool PolicyConfigCache::hashFile(const std::string &path, SourceFile *file)
+{
+    std::string content;
+    if (!base::ReadFileToString(path, &content)) {
+        return false;
+    }
+    // FNV-1a, the files are small and this only needs to detect changes.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : content) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    file->size = content.size();
+    file->hash = hash;
+    return true;
+}
+
+std::string PolicyConfigCache::getBuildFingerprint()
+{
+    // Enum values can change across builds without any change to the XML literals.
+    char fingerprint[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", fingerprint, "");
+    return fingerprint;
+}
+
+void PolicyConfigCache::writeProfiles(Writer *w, const AudioProfileVector &profiles)
+{
+    w->write<uint32_t>(profiles.size());
+    for (const auto &profile : profiles) {
+        w->write<uint32_t>(profile->getFormat());
+        w->write<uint32_t>(profile->getEncapsulationType());
+        w->write<uint8_t>(profile->isDynamicFormat());
+        w->write<uint8_t>(profile->isDynamicChannels());
+        w->write<uint8_t>(profile->isDynamicRate());
+        w->write<uint32_t>(profile->getChannels().size());
+        for (const auto channelMask : profile->getChannels()) {
+            w->write<uint32_t>(channelMask);
+        }
+        w->write<uint32_t>(profile->getSampleRates().size());
+        for (const auto rate : profile->getSampleRates()) {
+            w->write<uint32_t>(rate);
+        }
+    }
+}
+
+AudioProfileVector PolicyConfigCache::readProfiles(Reader *r)
+{
+    AudioProfileVector profiles;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const auto format = static_cast<audio_format_t>(r->read<uint32_t>());
+        const auto encapsulationType =
+                static_cast<audio_encapsulation_type_t>(r->read<uint32_t>());
+        const bool dynamicFormat = r->read<uint8_t>();
+        const bool dynamicChannels = r->read<uint8_t>();
+        const bool dynamicRate = r->read<uint8_t>();
+        ChannelMaskSet channelMasks;
+        for (uint32_t masks = r->readCount(); masks > 0 && r->ok(); --masks) {
+            channelMasks.insert(static_cast<audio_channel_mask_t>(r->read<uint32_t>()));
+        }
+        SampleRateSet samplingRates;
+        for (uint32_t rates = r->readCount(); rates > 0 && r->ok(); --rates) {
+            samplingRates.insert(r->read<uint32_t>());
+        }
+        sp<AudioProfile> profile =
+                new AudioProfile(format, channelMasks, samplingRates, encapsulationType);
+        profile->setDynamicFormat(dynamicFormat);
+        profile->setDynamicChannels(dynamicChannels);
+        profile->setDynamicRate(dynamicRate);
+        profiles.add(profile);
+    }
+    return profiles;
+}
+
+void PolicyConfigCache::writeGains(Writer *w, const AudioGains &gains)
+{
+    w->write<uint32_t>(gains.size());
+    for (const auto &gain : gains) {
+        w->write<uint32_t>(gain->getMode());
+        w->write<uint32_t>(gain->getChannelMask());
+        w->write<int32_t>(gain->getMinValueInMb());
+        w->write<int32_t>(gain->getMaxValueInMb());
+        w->write<int32_t>(gain->getDefaultValueInMb());
+        w->write<int32_t>(gain->getStepValueInMb());
+        w->write<int32_t>(gain->getMinRampInMs());
+        w->write<int32_t>(gain->getMaxRampInMs());
+        w->write<uint8_t>(gain->canUseForVolume());
+    }
+}
+
+AudioGains PolicyConfigCache::readGains(Reader *r)
+{
+    AudioGains gains;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        sp<AudioGain> gain = new AudioGain(nextAudioGainIndex(), true);
+        gain->setMode(static_cast<audio_gain_mode_t>(r->read<uint32_t>()));
+        gain->setChannelMask(static_cast<audio_channel_mask_t>(r->read<uint32_t>()));
+        gain->setMinValueInMb(r->read<int32_t>());
+        gain->setMaxValueInMb(r->read<int32_t>());
+        gain->setDefaultValueInMb(r->read<int32_t>());
+        gain->setStepValueInMb(r->read<int32_t>());
+        gain->setMinRampInMs(r->read<int32_t>());
+        gain->setMaxRampInMs(r->read<int32_t>());
+        gain->setUseForVolume(r->read<uint8_t>());
+        gains.push_back(gain);
+    }
+    return gains;
+}
+
+void PolicyConfigCache::writeModule(Writer *w, const sp<HwModule> &module)
+{
+    w->write(std::string(module->getName()));
+    w->write<uint32_t>(module->getHalVersionMajor());
+    w->write<uint32_t>(module->getHalVersionMinor());
+
+    w->write<uint32_t>(module->getOutputProfiles().size() + module->getInputProfiles().size());
+    for (const auto *profiles : { &module->getOutputProfiles(), &module->getInputProfiles() }) {
+        for (const auto &mixPort : *profiles) {
+            w->write(mixPort->getName());
+            w->write<uint32_t>(mixPort->getRole());
+            w->write<uint32_t>(mixPort->getFlags());
+            w->write<uint32_t>(mixPort->maxOpenCount);
+            w->write<uint32_t>(mixPort->maxActiveCount);
+            w->write<uint32_t>(mixPort->recommendedMuteDurationMs);
+            writeProfiles(w, mixPort->getAudioProfiles());
+            writeGains(w, mixPort->getGains());
+        }
+    }
+
+    const DeviceVector &devicePorts = module->getDeclaredDevices();
+    w->write<uint32_t>(devicePorts.size());
+    for (const auto &device : devicePorts) {
+        w->write(device->getTagName());
+        w->write<uint32_t>(device->type());
+        w->write(device->address());
+        w->write<uint32_t>(device->encodedFormats().size());
+        for (const auto format : device->encodedFormats()) {
+            w->write<uint32_t>(format);
+        }
+        writeProfiles(w, device->getAudioProfiles());
+        writeGains(w, device->getGains());
+    }
+
+    const AudioRouteVector &routes = module->getRoutes();
+    w->write<uint32_t>(routes.size());
+    for (const auto &route : routes) {
+        w->write<uint32_t>(route->getType());
+        w->write(route->getSink()->getTagName());
+        w->write<uint32_t>(route->getSources().size());
+        for (const auto &source : route->getSources()) {
+            w->write(source->getTagName());
+        }
+    }
+}
+
+sp<HwModule> PolicyConfigCache::readModule(Reader *r)
+{
+    const std::string name = r->readString();
+    const uint32_t versionMajor = r->read<uint32_t>();
+    const uint32_t versionMinor = r->read<uint32_t>();
+    sp<HwModule> module = new HwModule(name.c_str(), versionMajor, versionMinor);
+
+    IOProfileCollection mixPorts;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const std::string portName = r->readString();
+        const auto role = static_cast<audio_port_role_t>(r->read<uint32_t>());
+        sp<IOProfile> mixPort = new IOProfile(portName, role);
+        const uint32_t flags = r->read<uint32_t>();
+        if (flags != 0) {
+            mixPort->setFlags(flags);
+        }
+        mixPort->maxOpenCount = r->read<uint32_t>();
+        mixPort->maxActiveCount = r->read<uint32_t>();
+        mixPort->recommendedMuteDurationMs = r->read<uint32_t>();
+        mixPort->setAudioProfiles(readProfiles(r));
+        mixPort->setGains(readGains(r));
+        mixPorts.add(mixPort);
+    }
+    module->setProfiles(mixPorts);
+
+    DeviceVector devicePorts;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const std::string tagName = r->readString();
+        const auto type = static_cast<audio_devices_t>(r->read<uint32_t>());
+        const std::string address = r->readString();
+        FormatVector encodedFormats;
+        for (uint32_t formats = r->readCount(); formats > 0 && r->ok(); --formats) {
+            encodedFormats.push_back(static_cast<audio_format_t>(r->read<uint32_t>()));
+        }
+        sp<DeviceDescriptor> device =
+                new DeviceDescriptor(type, tagName, address, encodedFormats);
+        device->setAudioProfiles(readProfiles(r));
+        device->setGains(readGains(r));
+        devicePorts.add(device);
+    }
+    module->setDeclaredDevices(devicePorts);
+
+    AudioRouteVector routes;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        sp<AudioRoute> route = new AudioRoute(static_cast<audio_route_type_t>(
+                r->read<uint32_t>()));
+        sp<PolicyAudioPort> sink = module->findPortByTagName(r->readString());
+        PolicyAudioPortVector sources;
+        for (uint32_t tags = r->readCount(); tags > 0 && r->ok(); --tags) {
+            sp<PolicyAudioPort> source = module->findPortByTagName(r->readString());
+            if (source == nullptr) {
+                return nullptr;
+            }
+            sources.add(source);
+        }
+        if (sink == nullptr) {
+            return nullptr;
+        }
+        route->setSink(sink);
+        sink->addRoute(route);
+        for (const auto &source : sources) {
+            source->addRoute(route);
+        }
+        route->setSources(sources);
+        routes.add(route);
+    }
+    module->setRoutes(routes);
+    return r->ok() ? module : nullptr;
+}
+
+status_t PolicyConfigCache::store(const char *cacheFile,
+        const std::vector<std::string> &sourceFiles, const AudioPolicyConfig &config)
+{
+    Writer w;
+    w.write(kMagic);
+    w.write(kVersion);
+    w.write(getBuildFingerprint());
+    w.write<uint32_t>(sourceFiles.size());
+    for (const auto &path : sourceFiles) {
+        SourceFile file{};
+        if (!hashFile(path, &file)) {
+            ALOGW("%s: could not read %s", __func__, path.c_str());
+            return BAD_VALUE;
+        }
+        w.write(path);
+        w.write(file.size);
+        w.write(file.hash);
+    }
+
+    const HwModuleCollection modules = config.getHwModules();
+    w.write<uint32_t>(modules.size());
+    for (const auto &module : modules) {
+        writeModule(&w, module);
+    }
+
+    // Devices are referred to by module index and tag name.
+    auto writeDeviceRef = [&](const sp<DeviceDescriptor> &device) {
+        for (size_t i = 0; i < modules.size(); i++) {
+            if (modules[i]->getDeclaredDevices().contains(device)) {
+                w.write<int32_t>(i);
+                w.write(device->getTagName());
+                return;
+            }
+        }
+        w.write<int32_t>(-1);
+    };
+    w.write<uint32_t>(config.getOutputDevices().size() + config.getInputDevices().size());
+    for (const auto *devices : { &config.getOutputDevices(), &config.getInputDevices() }) {
+        for (const auto &device : *devices) {
+            writeDeviceRef(device);
+        }
+    }
+    writeDeviceRef(config.getDefaultOutputDevice());
+
+    w.write<uint8_t>(config.isSpeakerDrcEnabled());
+    w.write<uint8_t>(config.isCallScreenModeSupported());
+    w.write(config.getEngineLibraryNameSuffix());
+
+    const AudioPolicyConfig::SurroundFormats &surroundFormats = config.getSurroundFormats();
+    w.write<uint32_t>(surroundFormats.size());
+    for (const auto &[format, subformats] : surroundFormats) {
+        w.write<uint32_t>(format);
+        w.write<uint32_t>(subformats.size());
+        for (const auto subformat : subformats) {
+            w.write<uint32_t>(subformat);
+        }
+    }
+
+    // Write then rename, so that a reader never sees a partial file.
+    const std::string tmpFile = std::string(cacheFile) + ".tmp";
+    if (!base::WriteStringToFile(w.data(), tmpFile) ||
+            rename(tmpFile.c_str(), cacheFile) != 0) {
+        ALOGW("%s: could not write %s: %s", __func__, cacheFile, strerror(errno));
+        unlink(tmpFile.c_str());
+        return INVALID_OPERATION;
+    }
+    ALOGV("%s: %zu bytes written to %s", __func__, w.data().size(), cacheFile);
+    return NO_ERROR;
+}
+
+status_t PolicyConfigCache::load(const char *cacheFile, const char *configFile,
+        AudioPolicyConfig *config)
+{
+    base::unique_fd fd(open(cacheFile, O_RDONLY | O_CLOEXEC));
+    if (fd.get() < 0) {
+        return NAME_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0 || st.st_size == 0) {
+        return BAD_VALUE;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGW("%s: could not map %s: %s", __func__, cacheFile, strerror(errno));
+        return BAD_VALUE;
+    }
+    Reader r(static_cast<const uint8_t*>(data), st.st_size);
+    const status_t status = readConfig(&r, configFile, config);
+    munmap(data, st.st_size);
+    return status;
+}
+
+status_t PolicyConfigCache::readConfig(Reader *r, const char *configFile,
+        AudioPolicyConfig *config)
+{
+    if (r->read<uint32_t>() != kMagic || r->read<uint32_t>() != kVersion ||
+            r->readString() != getBuildFingerprint()) {
+        return BAD_VALUE;
+    }
+    const uint32_t sourceCount = r->readCount();
+    for (uint32_t i = 0; i < sourceCount && r->ok(); i++) {
+        const std::string path = r->readString();
+        SourceFile expected{};
+        expected.size = r->read<uint64_t>();
+        expected.hash = r->read<uint64_t>();
+        SourceFile file{};
+        // The first source is the configuration file itself.
+        if ((i == 0 && path != configFile) || !hashFile(path, &file) ||
+                file.size != expected.size || file.hash != expected.hash) {
+            ALOGV("%s: %s changed", __func__, path.c_str());
+            return BAD_VALUE;
+        }
+    }
+    if (sourceCount == 0) {
+        return BAD_VALUE;
+    }
+
+    // Everything is built aside and only handed to the config once fully read.
+    HwModuleCollection modules;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        sp<HwModule> module = readModule(r);
+        if (module == nullptr) {
+            return BAD_VALUE;
+        }
+        modules.add(module);
+    }
+
+    auto readDeviceRef = [&]() -> sp<DeviceDescriptor> {
+        const int32_t index = r->read<int32_t>();
+        if (index < 0 || static_cast<size_t>(index) >= modules.size()) {
+            return nullptr;
+        }
+        return modules[index]->getDeclaredDevices().getDeviceFromTagName(r->readString());
+    };
+    std::vector<sp<DeviceDescriptor>> attachedDevices;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        sp<DeviceDescriptor> device = readDeviceRef();
+        if (device == nullptr) {
+            return BAD_VALUE;
+        }
+        attachedDevices.push_back(device);
+    }
+    sp<DeviceDescriptor> defaultOutputDevice = readDeviceRef();
+
+    const bool speakerDrcEnabled = r->read<uint8_t>();
+    const bool callScreenModeSupported = r->read<uint8_t>();
+    const std::string engineLibraryNameSuffix = r->readString();
+
+    AudioPolicyConfig::SurroundFormats surroundFormats;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const auto format = static_cast<audio_format_t>(r->read<uint32_t>());
+        auto &subformats = surroundFormats[format];
+        for (uint32_t subcount = r->readCount(); subcount > 0 && r->ok(); --subcount) {
+            subformats.insert(static_cast<audio_format_t>(r->read<uint32_t>()));
+        }
+    }
+    if (!r->atEnd()) {
+        return BAD_VALUE;
+    }
+
+    config->setHwModules(modules);
+    for (const auto &device : attachedDevices) {
+        config->addDevice(device);
+    }
+    if (defaultOutputDevice != nullptr) {
+        config->setDefaultOutputDevice(defaultOutputDevice);
+    }
+    config->setSpeakerDrcEnabled(speakerDrcEnabled);
+    config->setCallScreenModeSupported(callScreenModeSupported);
+    config->setEngineLibraryNameSuffix(engineLibraryNameSuffix);
+    config->setSurroundFormats(surroundFormats);
+    return NO_ERROR;
+}
+
 }  // namespace
 
 status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
@@ -911,6 +1450,27 @@ status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *con
     return status;
 }
 
+status_t deserializeAudioPolicyFileCached(const char *fileName, const char *cacheFile,
+        AudioPolicyConfig *config, bool *cacheHit)
+{
+    if (cacheHit != nullptr) *cacheHit = false;
+    status_t status = PolicyConfigCache::load(cacheFile, fileName, config);
+    if (status == NO_ERROR) {
+        ALOGV("%s: loaded %s from %s", __func__, fileName, cacheFile);
+        if (cacheHit != nullptr) *cacheHit = true;
+        return status;
+    }
+    PolicySerializer serializer;
+    status = serializer.deserialize(fileName, config);
+    if (status != OK) {
+        config->clear();
+        return status;
+    }
+    // Failing to write the cache only costs the next start up a full parse.
+    PolicyConfigCache::store(cacheFile, serializer.getSourceFiles(), *config);
+    return status;
+}
+
 status_t deserializeAudioPolicyFileForVts(const char *fileName, AudioPolicyConfig *config)
 {
     PolicySerializer serializer;
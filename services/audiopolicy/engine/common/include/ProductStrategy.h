@@ -19,6 +19,7 @@
 #include "VolumeGroup.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -121,7 +122,9 @@ class ProductStrategyMap : public std::map<product_strategy_t, sp<ProductStrateg
 {
 public:
     /**
-     * @brief initialize: set default product strategy in cache.
+     * @brief initialize: set default product strategy in cache, and build the attributes and
+     * stream lookup tables. Shall be called again whenever the strategies or their attributes
+     * change.
      */
     void initialize();
     /**
@@ -167,7 +170,45 @@ public:
     void dump(String8 *dst, int spaces = 0) const;
 
 private:
+    /**
+     * Attributes of all the strategies, flattened in matching order (strategies by id, then
+     * attributes in the order of the configuration).
+     */
+    struct AttributesEntry {
+        audio_attributes_t mAttributes;
+        product_strategy_t mStrategy;
+        volume_group_t mVolumeGroup;
+        audio_stream_type_t mStream;
+        bool mHasTags;
+    };
+    /** Precomputed results of the stream based queries, for each stream of the strategies. */
+    struct StreamEntry {
+        product_strategy_t mStrategy = PRODUCT_STRATEGY_NONE;
+        volume_group_t mVolumeGroup = VOLUME_GROUP_NONE;
+        audio_attributes_t mAttributes = {};
+    };
+    using AttributesKey = std::pair<audio_usage_t, audio_content_type_t>;
+
+    void buildLookupTables();
+
+    /**
+     * @return the indexes in mAttributesEntries of the entries which may match attributes of
+     * the given usage and content type, in matching order. Flags and tags are left to check.
+     */
+    const std::vector<size_t> &getCandidates(const audio_attributes_t &attr) const;
+    bool candidateMatches(size_t index, const audio_attributes_t &attr) const;
+
     product_strategy_t mDefaultStrategy = PRODUCT_STRATEGY_NONE;
+
+    // Lookup tables, only valid after initialize().
+    bool mLookupTablesValid = false;
+    std::vector<AttributesEntry> mAttributesEntries;
+    // Usages and content types a configured attributes entry explicitly requires. Any other
+    // value can only match entries leaving that field unknown, so is looked up as unknown.
+    std::set<audio_usage_t> mUsages;
+    std::set<audio_content_type_t> mContentTypes;
+    std::map<AttributesKey, std::vector<size_t>> mCandidates;
+    std::map<audio_stream_type_t, StreamEntry> mStreamEntries;
 };
 
 using ProductStrategyDevicesRoleMap =
@@ -23,6 +23,7 @@
 #include <media/TypeConverter.h>
 #include <utils/String8.h>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include <log/log.h>
@@ -167,9 +168,17 @@ void ProductStrategy::dump(String8 *dst, int spaces) const
 product_strategy_t ProductStrategyMap::getProductStrategyForAttributes(
         const audio_attributes_t &attr, bool fallbackOnDefault) const
 {
-    for (const auto &iter : *this) {
-        if (iter.second->matches(attr)) {
-            return iter.second->getId();
+    if (mLookupTablesValid) {
+        for (size_t index : getCandidates(attr)) {
+            if (candidateMatches(index, attr)) {
+                return mAttributesEntries[index].mStrategy;
+            }
+        }
+    } else {
+        for (const auto &iter : *this) {
+            if (iter.second->matches(attr)) {
+                return iter.second->getId();
+            }
         }
     }
     ALOGV("%s: No matching product strategy for attributes %s, return default", __FUNCTION__,
@@ -179,10 +188,16 @@ product_strategy_t ProductStrategyMap::getProductStrategyForAttributes(
 
 audio_attributes_t ProductStrategyMap::getAttributesForStreamType(audio_stream_type_t stream) const
 {
-    for (const auto &iter : *this) {
-        const auto strategy = iter.second;
-        if (strategy->supportStreamType(stream)) {
-            return strategy->getAttributesForStreamType(stream);
+    if (mLookupTablesValid) {
+        if (const auto iter = mStreamEntries.find(stream); iter != mStreamEntries.end()) {
+            return iter->second.mAttributes;
+        }
+    } else {
+        for (const auto &iter : *this) {
+            const auto strategy = iter.second;
+            if (strategy->supportStreamType(stream)) {
+                return strategy->getAttributesForStreamType(stream);
+            }
         }
     }
     ALOGV("%s: No product strategy for stream %s, using default", __FUNCTION__,
@@ -193,10 +208,19 @@ audio_attributes_t ProductStrategyMap::getAttributesForStreamType(audio_stream_t
 audio_stream_type_t ProductStrategyMap::getStreamTypeForAttributes(
         const audio_attributes_t &attr) const
 {
-    for (const auto &iter : *this) {
-        audio_stream_type_t stream = iter.second->getStreamTypeForAttributes(attr);
-        if (stream != AUDIO_STREAM_DEFAULT) {
-            return stream;
+    if (mLookupTablesValid) {
+        for (size_t index : getCandidates(attr)) {
+            if (candidateMatches(index, attr)) {
+                const audio_stream_type_t stream = mAttributesEntries[index].mStream;
+                return stream != AUDIO_STREAM_DEFAULT ? stream : AUDIO_STREAM_MUSIC;
+            }
+        }
+    } else {
+        for (const auto &iter : *this) {
+            audio_stream_type_t stream = iter.second->getStreamTypeForAttributes(attr);
+            if (stream != AUDIO_STREAM_DEFAULT) {
+                return stream;
+            }
         }
     }
     ALOGV("%s: No product strategy for attributes %s, using default (aka MUSIC)", __FUNCTION__,
@@ -231,9 +255,15 @@ audio_attributes_t ProductStrategyMap::getAttributesForProductStrategy(
 
 product_strategy_t ProductStrategyMap::getProductStrategyForStream(audio_stream_type_t stream) const
 {
-    for (const auto &iter : *this) {
-        if (iter.second->supportStreamType(stream)) {
-            return iter.second->getId();
+    if (mLookupTablesValid) {
+        if (const auto iter = mStreamEntries.find(stream); iter != mStreamEntries.end()) {
+            return iter->second.mStrategy;
+        }
+    } else {
+        for (const auto &iter : *this) {
+            if (iter.second->supportStreamType(stream)) {
+                return iter.second->getId();
+            }
         }
     }
     ALOGV("%s: No product strategy for stream %d, using default", __FUNCTION__, stream);
@@ -271,10 +301,25 @@ std::string ProductStrategyMap::getDeviceAddressForProductStrategy(product_strat
 volume_group_t ProductStrategyMap::getVolumeGroupForAttributes(
         const audio_attributes_t &attr, bool fallbackOnDefault) const
 {
-    for (const auto &iter : *this) {
-        volume_group_t group = iter.second->getVolumeGroupForAttributes(attr);
-        if (group != VOLUME_GROUP_NONE) {
-            return group;
+    if (mLookupTablesValid) {
+        // Only the first matching attributes of a strategy give its volume group.
+        product_strategy_t matchedStrategy = PRODUCT_STRATEGY_NONE;
+        for (size_t index : getCandidates(attr)) {
+            const AttributesEntry &entry = mAttributesEntries[index];
+            if (entry.mStrategy == matchedStrategy || !candidateMatches(index, attr)) {
+                continue;
+            }
+            if (entry.mVolumeGroup != VOLUME_GROUP_NONE) {
+                return entry.mVolumeGroup;
+            }
+            matchedStrategy = entry.mStrategy;
+        }
+    } else {
+        for (const auto &iter : *this) {
+            volume_group_t group = iter.second->getVolumeGroupForAttributes(attr);
+            if (group != VOLUME_GROUP_NONE) {
+                return group;
+            }
         }
     }
     return fallbackOnDefault ? getDefaultVolumeGroup() : VOLUME_GROUP_NONE;
@@ -283,10 +328,17 @@ volume_group_t ProductStrategyMap::getVolumeGroupForAttributes(
 volume_group_t ProductStrategyMap::getVolumeGroupForStreamType(
         audio_stream_type_t stream, bool fallbackOnDefault) const
 {
-    for (const auto &iter : *this) {
-        volume_group_t group = iter.second->getVolumeGroupForStreamType(stream);
-        if (group != VOLUME_GROUP_NONE) {
-            return group;
+    if (mLookupTablesValid) {
+        if (const auto iter = mStreamEntries.find(stream);
+                iter != mStreamEntries.end() && iter->second.mVolumeGroup != VOLUME_GROUP_NONE) {
+            return iter->second.mVolumeGroup;
+        }
+    } else {
+        for (const auto &iter : *this) {
+            volume_group_t group = iter.second->getVolumeGroupForStreamType(stream);
+            if (group != VOLUME_GROUP_NONE) {
+                return group;
+            }
         }
     }
     ALOGW("%s: no volume group for %s, using default", __func__, toString(stream).c_str());
@@ -304,8 +356,92 @@ volume_group_t ProductStrategyMap::getDefaultVolumeGroup() const
 
 void ProductStrategyMap::initialize()
 {
+    mDefaultStrategy = PRODUCT_STRATEGY_NONE;
     mDefaultStrategy = getDefault();
     ALOG_ASSERT(mDefaultStrategy != PRODUCT_STRATEGY_NONE, "No default product strategy found");
+    buildLookupTables();
+}
+
+void ProductStrategyMap::buildLookupTables()
+{
+    mAttributesEntries.clear();
+    mUsages.clear();
+    mContentTypes.clear();
+    mCandidates.clear();
+    mStreamEntries.clear();
+
+    std::set<std::pair<audio_stream_type_t, product_strategy_t>> streamsOfStrategies;
+    for (const auto &iter : *this) {
+        const product_strategy_t strategy = iter.second->getId();
+        for (const auto &attributes : iter.second->listAudioAttributes()) {
+            const AttributesEntry entry = {
+                attributes.getAttributes(), strategy, attributes.getGroupId(),
+                attributes.getStreamType(), strlen(attributes.getAttributes().tags) != 0 };
+            mAttributesEntries.push_back(entry);
+
+            // Same results as the ProductStrategy stream queries, see getVolumeGroupForStreamType.
+            auto [streamIter, added] = mStreamEntries.try_emplace(entry.mStream);
+            StreamEntry &streamEntry = streamIter->second;
+            if (added) {
+                streamEntry.mStrategy = strategy;
+                streamEntry.mAttributes = entry.mAttributes;
+            }
+            if (streamsOfStrategies.insert({entry.mStream, strategy}).second &&
+                    streamEntry.mVolumeGroup == VOLUME_GROUP_NONE) {
+                streamEntry.mVolumeGroup = entry.mVolumeGroup;
+            }
+
+            if (entry.mAttributes.usage != AUDIO_USAGE_UNKNOWN) {
+                mUsages.insert(entry.mAttributes.usage);
+            }
+            if (entry.mAttributes.content_type != AUDIO_CONTENT_TYPE_UNKNOWN) {
+                mContentTypes.insert(entry.mAttributes.content_type);
+            }
+        }
+    }
+
+    std::vector<audio_usage_t> usages(mUsages.begin(), mUsages.end());
+    usages.push_back(AUDIO_USAGE_UNKNOWN);
+    std::vector<audio_content_type_t> contentTypes(mContentTypes.begin(), mContentTypes.end());
+    contentTypes.push_back(AUDIO_CONTENT_TYPE_UNKNOWN);
+    for (const auto usage : usages) {
+        for (const auto contentType : contentTypes) {
+            std::vector<size_t> &candidates = mCandidates[{usage, contentType}];
+            for (size_t index = 0; index < mAttributesEntries.size(); ++index) {
+                const audio_attributes_t &ref = mAttributesEntries[index].mAttributes;
+                // The default attributes never match, see AudioProductStrategy::attributesMatches.
+                if (ref == AUDIO_ATTRIBUTES_INITIALIZER) {
+                    continue;
+                }
+                if ((ref.usage == AUDIO_USAGE_UNKNOWN || ref.usage == usage) &&
+                        (ref.content_type == AUDIO_CONTENT_TYPE_UNKNOWN ||
+                                ref.content_type == contentType)) {
+                    candidates.push_back(index);
+                }
+            }
+        }
+    }
+    mLookupTablesValid = true;
+}
+
+const std::vector<size_t> &ProductStrategyMap::getCandidates(const audio_attributes_t &attr) const
+{
+    const audio_usage_t usage =
+            mUsages.count(attr.usage) != 0 ? attr.usage : AUDIO_USAGE_UNKNOWN;
+    const audio_content_type_t contentType = mContentTypes.count(attr.content_type) != 0 ?
+            attr.content_type : AUDIO_CONTENT_TYPE_UNKNOWN;
+    return mCandidates.at({usage, contentType});
+}
+
+bool ProductStrategyMap::candidateMatches(size_t index, const audio_attributes_t &attr) const
+{
+    // Usage and content type are matched by getCandidates(), the rest is as
+    // AudioProductStrategy::attributesMatches, with the tags compared only if required.
+    const AttributesEntry &entry = mAttributesEntries[index];
+    const audio_flags_mask_t flags = entry.mAttributes.flags;
+    return (flags == AUDIO_FLAG_NONE ||
+                    (attr.flags != AUDIO_FLAG_NONE && (attr.flags & flags) == flags)) &&
+            (!entry.mHasTags || strcmp(attr.tags, entry.mAttributes.tags) == 0);
 }
 
 void ProductStrategyMap::dump(String8 *dst, int spaces) const
@@ -314,6 +450,11 @@ void ProductStrategyMap::dump(String8 *dst, int spaces) const
     for (const auto &iter : *this) {
         iter.second->dump(dst, spaces + 2);
     }
+    if (mLookupTablesValid) {
+        dst->appendFormat("\n%*sLookup tables: %zu attributes, %zu usage/content type keys,"
+                " %zu streams\n", spaces + 2, "", mAttributesEntries.size(), mCandidates.size(),
+                mStreamEntries.size());
+    }
 }
 
 void dumpProductStrategyDevicesRoleMap(
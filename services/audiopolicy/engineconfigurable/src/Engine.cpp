@@ -207,7 +207,7 @@ status_t Engine::loadAudioPolicyEngineConfig()
 
 DeviceVector Engine::getDevicesForProductStrategy(product_strategy_t ps) const
 {
-    const auto productStrategies = getProductStrategies();
+    const auto &productStrategies = getProductStrategies();
     if (productStrategies.find(ps) == productStrategies.end()) {
         ALOGE("%s: Trying to get device on invalid strategy %d", __FUNCTION__, ps);
         return {};
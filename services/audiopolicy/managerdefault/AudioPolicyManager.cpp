@@ -181,6 +181,9 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(audio_devices_t deviceT
 status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescriptor> &device,
                                                          audio_policy_dev_state_t state)
 {
+    // device availability and supported formats change the outputs matching a device.
+    invalidateOutputSelectionCache();
+
     // handle output devices
     if (audio_is_output_device(device->type())) {
         SortedVector <audio_io_handle_t> outputs;
@@ -918,6 +921,7 @@ void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
         ALOGW("setForceUse() could not set force cfg %d for usage %d", config, usage);
         return;
     }
+    invalidateOutputSelectionCache();
     bool forceVolumeReeval = (usage == AUDIO_POLICY_FORCE_FOR_COMMUNICATION) ||
             (usage == AUDIO_POLICY_FORCE_FOR_DOCK) ||
             (usage == AUDIO_POLICY_FORCE_FOR_SYSTEM);
@@ -1543,12 +1547,10 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
     if (audio_is_linear_pcm(config->format)) {
         // get which output is suitable for the specified stream. The actual
         // routing change will happen when startOutput() will be called
-        SortedVector<audio_io_handle_t> outputs = getOutputsForDevices(devices, mOutputs);
-
         // at this stage we should ignore the DIRECT flag as no direct output could be found earlier
         *flags = (audio_output_flags_t)(*flags & ~AUDIO_OUTPUT_FLAG_DIRECT);
-        output = selectOutput(
-                outputs, *flags, config->format, channelMask, config->sample_rate, session);
+        output = selectOutputForDevices(
+                devices, *flags, config->format, channelMask, config->sample_rate, session);
     }
     ALOGW_IF((output == 0), "getOutputForDevices() could not find output for stream %d, "
             "sampling rate %d, format %#x, channels %#x, flags %#x",
@@ -1557,6 +1559,51 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
     return output;
 }
 
+audio_io_handle_t AudioPolicyManager::selectOutputForDevices(const DeviceVector &devices,
+                                                             audio_output_flags_t flags,
+                                                             audio_format_t format,
+                                                             audio_channel_mask_t channelMask,
+                                                             uint32_t samplingRate,
+                                                             audio_session_t sessionId)
+{
+    // selectOutput() prefers the output of a haptic generator effect on the session,
+    // which depends on the session and is not cached.
+    if (sessionId != AUDIO_SESSION_NONE &&
+            mEffects.getIoForSession(sessionId, FX_IID_HAPTICGENERATOR) != AUDIO_IO_HANDLE_NONE) {
+        return selectOutput(getOutputsForDevices(devices, mOutputs),
+                flags, format, channelMask, samplingRate, sessionId);
+    }
+
+    OutputSelectionKey key{{}, flags, format, channelMask, samplingRate};
+    key.deviceIds.reserve(devices.size());
+    for (const auto &device : devices) {
+        key.deviceIds.push_back(device->getId());
+    }
+    auto it = mOutputSelectionCache.find(key);
+    if (it != mOutputSelectionCache.end() && mOutputs.indexOfKey(it->second) >= 0) {
+        ++mOutputSelectionCacheHits;
+        return it->second;
+    }
+    ++mOutputSelectionCacheMisses;
+    const audio_io_handle_t output = selectOutput(getOutputsForDevices(devices, mOutputs),
+            flags, format, channelMask, samplingRate, AUDIO_SESSION_NONE);
+    if (output != AUDIO_IO_HANDLE_NONE) {
+        if (mOutputSelectionCache.size() >= kOutputSelectionCacheMaxSize) {
+            mOutputSelectionCache.clear();
+        }
+        mOutputSelectionCache[std::move(key)] = output;
+    }
+    return output;
+}
+
+void AudioPolicyManager::invalidateOutputSelectionCache()
+{
+    if (!mOutputSelectionCache.empty()) {
+        mOutputSelectionCache.clear();
+        ++mOutputSelectionCacheInvalidations;
+    }
+}
+
 sp<DeviceDescriptor> AudioPolicyManager::getMsdAudioInDevice() const {
     auto msdInDevices = mHwModules.getAvailableDevicesFromModuleName(AUDIO_HARDWARE_MODULE_ID_MSD,
                                                                      mAvailableInputDevices);
@@ -3375,6 +3422,7 @@ bool AudioPolicyManager::isSourceActive(audio_source_t source) const
 status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 {
     ALOGV("registerPolicyMixes() %zu mix(es)", mixes.size());
+    invalidateOutputSelectionCache();
     status_t res = NO_ERROR;
     bool checkOutputs = false;
     sp<HwModule> rSubmixModule;
@@ -3512,6 +3560,7 @@ status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 status_t AudioPolicyManager::unregisterPolicyMixes(Vector<AudioMix> mixes)
 {
     ALOGV("unregisterPolicyMixes() num mixes %zu", mixes.size());
+    invalidateOutputSelectionCache();
     status_t res = NO_ERROR;
     bool checkOutputs = false;
     sp<HwModule> rSubmixModule;
@@ -3876,6 +3925,13 @@ void AudioPolicyManager::dump(String8 *dst) const
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig.getSource().c_str()); // getConfig not const
+    const uint64_t outputSelections = mOutputSelectionCacheHits + mOutputSelectionCacheMisses;
+    dst->appendFormat(" Output selection cache: entries=%zu hits=%llu misses=%llu"
+            " invalidations=%llu hit rate=%.1f%%\n",
+            mOutputSelectionCache.size(), (unsigned long long)mOutputSelectionCacheHits,
+            (unsigned long long)mOutputSelectionCacheMisses,
+            (unsigned long long)mOutputSelectionCacheInvalidations,
+            outputSelections == 0 ? 0. : 100. * mOutputSelectionCacheHits / outputSelections);
 
     dst->append("\n");
     mAvailableOutputDevices.dump(dst, String8("Available output"), 1);
@@ -5564,11 +5620,19 @@ uint32_t AudioPolicyManager::nextAudioPortGeneration()
     return mAudioPortGeneration++;
 }
 
+// Binary snapshot of the last parsed configuration, to skip the XML parsing at start up.
+static constexpr const char *kAudioPolicyConfigCacheFile =
+        "/data/misc/audioserver/audio_policy_configuration.cache";
+
 static status_t deserializeAudioPolicyXmlConfig(AudioPolicyConfig &config) {
     if (std::string audioPolicyXmlConfigFile = audio_get_audio_policy_config_file();
             !audioPolicyXmlConfigFile.empty()) {
-        status_t ret = deserializeAudioPolicyFile(audioPolicyXmlConfigFile.c_str(), &config);
+        bool cacheHit = false;
+        status_t ret = deserializeAudioPolicyFileCached(audioPolicyXmlConfigFile.c_str(),
+                kAudioPolicyConfigCacheFile, &config, &cacheHit);
         if (ret == NO_ERROR) {
+            ALOGI("%s: %s loaded%s", __func__, audioPolicyXmlConfigFile.c_str(),
+                    cacheHit ? " from cache" : "");
             config.setSource(audioPolicyXmlConfigFile);
         }
         return ret;
@@ -5849,6 +5913,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
     mOutputs.add(output, outputDesc);
+    invalidateOutputSelectionCache();
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
@@ -5862,6 +5927,7 @@ void AudioPolicyManager::removeOutput(audio_io_handle_t output)
         mPrimaryOutput = nullptr;
     }
     mOutputs.removeItem(output);
+    invalidateOutputSelectionCache();
     selectOutputForMusicEffects();
 }
 
@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <unordered_set>
 
@@ -753,6 +754,21 @@ protected:
                                        audio_channel_mask_t channelMask = AUDIO_CHANNEL_NONE,
                                        uint32_t samplingRate = 0,
                                        audio_session_t sessionId = AUDIO_SESSION_NONE);
+
+        /**
+         * @brief selectOutputForDevices: selectOutput() among the open outputs supporting
+         *      the devices, memoized in mOutputSelectionCache.
+         * The result only depends on the open outputs and the available devices, so the cache
+         * is cleared by invalidateOutputSelectionCache() whenever either may change.
+         */
+        audio_io_handle_t selectOutputForDevices(const DeviceVector &devices,
+                                                 audio_output_flags_t flags,
+                                                 audio_format_t format,
+                                                 audio_channel_mask_t channelMask,
+                                                 uint32_t samplingRate,
+                                                 audio_session_t sessionId);
+        void invalidateOutputSelectionCache();
+
         // samplingRate, format, channelMask are in/out and so may be modified
         sp<IOProfile> getInputProfile(const sp<DeviceDescriptor> & device,
                                       uint32_t& samplingRate,
@@ -916,6 +932,27 @@ protected:
         sp<SwAudioOutputDescriptor> mSpatializerOutput;
 
         SwAudioOutputCollection mOutputs;
+
+        // memoized selectOutputForDevices() results.
+        struct OutputSelectionKey {
+            std::vector<audio_port_handle_t> deviceIds;
+            audio_output_flags_t flags;
+            audio_format_t format;
+            audio_channel_mask_t channelMask;
+            uint32_t samplingRate;
+
+            bool operator<(const OutputSelectionKey &other) const {
+                return std::tie(deviceIds, flags, format, channelMask, samplingRate) <
+                        std::tie(other.deviceIds, other.flags, other.format, other.channelMask,
+                                other.samplingRate);
+            }
+        };
+        static constexpr size_t kOutputSelectionCacheMaxSize = 64;
+        std::map<OutputSelectionKey, audio_io_handle_t> mOutputSelectionCache;
+        uint64_t mOutputSelectionCacheHits = 0;
+        uint64_t mOutputSelectionCacheMisses = 0;
+        uint64_t mOutputSelectionCacheInvalidations = 0;
+
         // copy of mOutputs before setDeviceConnectionState() opens new outputs
         // reset to mOutputs when updateDevicesAndOutputs() is called.
         SwAudioOutputCollection mPreviousOutputs;
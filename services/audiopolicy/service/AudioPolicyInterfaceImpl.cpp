@@ -479,6 +479,7 @@ Status AudioPolicyService::startOutput(int32_t portIdAidl)
     if (status == NO_ERROR) {
         client->active = true;
         onUpdateActiveSpatializerTracks_l();
+        bumpStateGeneration();
     }
     return binderStatusFromStatusT(status);
 }
@@ -517,6 +518,7 @@ status_t  AudioPolicyService::doStopOutput(audio_port_handle_t portId)
     if (status == NO_ERROR) {
         client->active = false;
         onUpdateActiveSpatializerTracks_l();
+        bumpStateGeneration();
     }
     return status;
 }
@@ -553,6 +555,7 @@ void AudioPolicyService::doReleaseOutput(audio_port_handle_t portId)
     mAudioPlaybackClients.removeItem(portId);
     // called from internal thread: no need to clear caller identity
     mAudioPolicyManager->releaseOutput(portId);
+    bumpStateGeneration();
 }
 
 Status AudioPolicyService::getInputForAttr(const media::AudioAttributesInternal& attrAidl,
@@ -2378,4 +2381,11 @@ Status AudioPolicyService::getDirectProfilesForAttributes(
     return Status::ok();
 }
 
+Status AudioPolicyService::getStateGeneration(
+        std::optional<media::SharedFileRegion>* _aidl_return) {
+    *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
+            legacy2aidl_NullableIMemory_SharedFileRegion(mStateGenerationMemory));
+    return Status::ok();
+}
+
 } // namespace android
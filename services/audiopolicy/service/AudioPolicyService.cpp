@@ -22,6 +22,7 @@
 #define __STDINT_LIMITS
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <dlfcn.h>
 
@@ -156,6 +157,7 @@ BINDER_METHOD_ENTRY(getSpatializer) \
 BINDER_METHOD_ENTRY(canBeSpatialized) \
 BINDER_METHOD_ENTRY(getDirectPlaybackSupport) \
 BINDER_METHOD_ENTRY(getDirectProfilesForAttributes) \
+BINDER_METHOD_ENTRY(getStateGeneration) \
 
 // singleton for Binder Method Statistics for IAudioPolicyService
 static auto& getIAudioPolicyServiceStatistics() {
@@ -175,6 +177,22 @@ static auto& getIAudioPolicyServiceStatistics() {
     return methodStatistics;
 }
 
+// Exports the binder execution time percentiles, one mediametrics item per method.
+static void logIAudioPolicyServiceStatistics() {
+    getIAudioPolicyServiceStatistics().forEachMethod(
+            [](const std::string& method, const auto& data) {
+        mediametrics::LogItem(std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_BINDER)
+                .append("IAudioPolicyService.").append(method))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONCOUNT, (int64_t)data.stats.getN())
+            .set(AMEDIAMETRICS_PROP_EXECUTIONMEANMS, (double)data.stats.getMean())
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP50MS, (double)data.histogram.getPercentile(50.f))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP99MS, (double)data.histogram.getPercentile(99.f))
+            .set(AMEDIAMETRICS_PROP_EXECUTIONP999MS,
+                    (double)data.histogram.getPercentile(99.9f))
+            .record();
+    });
+}
+
 // ----------------------------------------------------------------------------
 
 static AudioPolicyInterface* createAudioPolicyManager(AudioPolicyClientInterface *clientInterface)
@@ -237,6 +255,19 @@ void AudioPolicyService::onFirstRef()
             .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_CTOR)
             .set(AMEDIAMETRICS_PROP_EXECUTIONTIMENS, (int64_t)(systemTime() - beginNs))
             .record(); });
+
+    // the generation is published before any policy state exists, starting at 1 as clients
+    // take 0 to mean that they do not know it.
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(
+            sizeof(std::atomic<uint32_t>), MemoryHeapBase::READ_ONLY, "AudioPolicyGeneration");
+    if (heap->getBase() != MAP_FAILED) {
+        mStateGeneration = new (heap->getBase()) std::atomic<uint32_t>(1);
+        mStateGenerationMemory = new MemoryBase(heap, 0, sizeof(std::atomic<uint32_t>));
+    } else {
+        ALOGW("%s: cannot publish the state generation, clients will not cache queries",
+              __func__);
+    }
+
     {
         Mutex::Autolock _l(mLock);
 
@@ -396,8 +427,16 @@ void AudioPolicyService::removeNotificationClient(uid_t uid, pid_t pid)
     }
 }
 
+void AudioPolicyService::bumpStateGeneration()
+{
+    if (mStateGeneration != nullptr) {
+        mStateGeneration->fetch_add(1, std::memory_order_release);
+    }
+}
+
 void AudioPolicyService::onAudioPortListUpdate()
 {
+    bumpStateGeneration();
     mOutputCommandThread->updateAudioPortListCommand();
 }
 
@@ -411,6 +450,7 @@ void AudioPolicyService::doOnAudioPortListUpdate()
 
 void AudioPolicyService::onAudioPatchListUpdate()
 {
+    bumpStateGeneration();
     mOutputCommandThread->updateAudioPatchListCommand();
 }
 
@@ -424,6 +464,7 @@ void AudioPolicyService::doOnAudioPatchListUpdate()
 
 void AudioPolicyService::onAudioVolumeGroupChanged(volume_group_t group, int flags)
 {
+    bumpStateGeneration();
     mOutputCommandThread->changeAudioVolumeGroupCommand(group, flags);
 }
 
@@ -483,6 +524,7 @@ void AudioPolicyService::doOnRecordingConfigurationUpdate(
 
 void AudioPolicyService::onRoutingUpdated()
 {
+    bumpStateGeneration();
     mOutputCommandThread->routingChangedCommand();
 }
 
@@ -1229,6 +1271,7 @@ status_t AudioPolicyService::dump(int fd, const Vector<String16>& args __unused)
             std::string timeCheckStats = getIAudioPolicyServiceStatistics().dump();
             dprintf(fd, "\nIAudioPolicyService binder call profile\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
+            logIAudioPolicyServiceStatistics();
         }
     }
     return NO_ERROR;
@@ -1379,7 +1422,31 @@ status_t AudioPolicyService::onTransact(
         }
     }
 
-    return BnAudioPolicyService::onTransact(code, data, reply, flags);
+    status_t status = BnAudioPolicyService::onTransact(code, data, reply, flags);
+
+    // Any transaction from a client may change the policy state, except for these queries.
+    // Transactions from AudioFlinger do not come through here, so the methods it calls bump the
+    // generation themselves.
+    switch (code) {
+        case TRANSACTION_getDeviceConnectionState:
+        case TRANSACTION_getForceUse:
+        case TRANSACTION_getStreamVolumeIndex:
+        case TRANSACTION_getVolumeIndexForAttributes:
+        case TRANSACTION_getMinVolumeIndexForAttributes:
+        case TRANSACTION_getMaxVolumeIndexForAttributes:
+        case TRANSACTION_getDevicesForAttributes:
+        case TRANSACTION_isStreamActive:
+        case TRANSACTION_isStreamActiveRemotely:
+        case TRANSACTION_isSourceActive:
+        case TRANSACTION_getStreamVolumeDB:
+        case TRANSACTION_getPhoneState:
+        case TRANSACTION_getStateGeneration:
+            break;
+        default:
+            bumpStateGeneration();
+            break;
+    }
+    return status;
 }
 
 // ------------------- Shell command implementation -------------------
@@ -1991,6 +2058,10 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
                     command->mStatus = AudioSystem::setStreamVolume(data->mStream,
                                                                     data->mVolume,
                                                                     data->mIO);
+                    svc = mService.promote();
+                    if (svc != 0) {
+                        svc->bumpStateGeneration();
+                    }
                     mLock.lock();
                     }break;
                 case SET_PARAMETERS: {
@@ -31,6 +31,8 @@
 #include <binder/AppOpsManager.h>
 #include <binder/BinderService.h>
 #include <binder/IUidObserver.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
 #include <system/audio.h>
 #include <system/audio_policy.h>
 #include <media/ToneGenerator.h>
@@ -44,6 +46,7 @@
 #include <android/hardware/BnSensorPrivacyListener.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <atomic>
 #include <unordered_map>
 
 namespace android {
@@ -277,6 +280,9 @@ public:
     binder::Status getDirectProfilesForAttributes(const media::AudioAttributesInternal& attr,
                         std::vector<media::audio::common::AudioProfile>* _aidl_return) override;
 
+    binder::Status getStateGeneration(
+            std::optional<media::SharedFileRegion>* _aidl_return) override;
+
     status_t onTransact(uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags) override;
 
     // IBinder::DeathRecipient
@@ -346,6 +352,11 @@ public:
     void onVolumeRangeInitRequest();
     void doOnVolumeRangeInitRequest();
 
+    // Tells clients that the results of their cached policy and flinger queries may be stale.
+    // Called after the state changed, so that a client reading the previous generation before
+    // a query does not keep a result that predates the change.
+    void bumpStateGeneration();
+
     /**
      * Spatializer SpatializerPolicyCallback implementation.
      * onCheckSpatializer() sends an event on mOutputCommandThread which executes
@@ -1063,6 +1074,11 @@ private:
     // created in onFirstRef() and never cleared: does not need to be guarded by mLock
     sp<Spatializer> mSpatializer;
 
+    // created in onFirstRef() and never cleared: the counter returned by getStateGeneration(),
+    // in shared memory that clients map read only.
+    sp<IMemory> mStateGenerationMemory;
+    std::atomic<uint32_t> *mStateGeneration = nullptr;
+
     void *mLibraryHandle = nullptr;
     CreateAudioPolicyManagerInstance mCreateAudioPolicyManager;
     DestroyAudioPolicyManagerInstance mDestroyAudioPolicyManager;
@@ -38,6 +38,8 @@ class AudioPolicyTestManager : public AudioPolicyManager {
     using AudioPolicyManager::setDeviceConnectionState;
     using AudioPolicyManager::deviceToAudioPort;
     uint32_t getAudioPortGeneration() const { return mAudioPortGeneration; }
+    uint64_t getOutputSelectionCacheHits() const { return mOutputSelectionCacheHits; }
+    uint64_t getOutputSelectionCacheMisses() const { return mOutputSelectionCacheMisses; }
 };
 
 }  // namespace android
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <ProductStrategy.h>
+
+using namespace android;
+
+// Strategies in the order and with the attributes of the default engine configuration.
+static ProductStrategyMap createStrategies(bool lookupTables) {
+    const std::vector<std::vector<std::pair<audio_stream_type_t, audio_attributes_t>>> config = {
+        {{AUDIO_STREAM_VOICE_CALL, {.usage = AUDIO_USAGE_VOICE_COMMUNICATION}},
+         {AUDIO_STREAM_BLUETOOTH_SCO, {.flags = AUDIO_FLAG_SCO}}},
+        {{AUDIO_STREAM_RING, {.usage = AUDIO_USAGE_NOTIFICATION_TELEPHONY_RINGTONE}},
+         {AUDIO_STREAM_ALARM, {.usage = AUDIO_USAGE_ALARM}}},
+        {{AUDIO_STREAM_ENFORCED_AUDIBLE, {.flags = AUDIO_FLAG_AUDIBILITY_ENFORCED}}},
+        {{AUDIO_STREAM_ACCESSIBILITY, {.usage = AUDIO_USAGE_ASSISTANCE_ACCESSIBILITY}}},
+        {{AUDIO_STREAM_NOTIFICATION, {.usage = AUDIO_USAGE_NOTIFICATION}},
+         {AUDIO_STREAM_NOTIFICATION, {.usage = AUDIO_USAGE_NOTIFICATION_EVENT}}},
+        {{AUDIO_STREAM_ASSISTANT, {.content_type = AUDIO_CONTENT_TYPE_SPEECH,
+                                   .usage = AUDIO_USAGE_ASSISTANT}},
+         {AUDIO_STREAM_MUSIC, {.usage = AUDIO_USAGE_MEDIA}},
+         {AUDIO_STREAM_MUSIC, {.usage = AUDIO_USAGE_GAME}},
+         {AUDIO_STREAM_MUSIC, {.usage = AUDIO_USAGE_ASSISTANT}},
+         {AUDIO_STREAM_MUSIC, {.usage = AUDIO_USAGE_ASSISTANCE_NAVIGATION_GUIDANCE}},
+         {AUDIO_STREAM_MUSIC, AUDIO_ATTRIBUTES_INITIALIZER},
+         {AUDIO_STREAM_SYSTEM, {.usage = AUDIO_USAGE_ASSISTANCE_SONIFICATION}}},
+        {{AUDIO_STREAM_DTMF, {.usage = AUDIO_USAGE_VOICE_COMMUNICATION_SIGNALLING}}},
+        {{AUDIO_STREAM_CALL_ASSISTANT, {.usage = AUDIO_USAGE_CALL_ASSISTANT}}},
+        {{AUDIO_STREAM_TTS, {.flags = AUDIO_FLAG_BEACON}}},
+    };
+    ProductStrategyMap strategies;
+    volume_group_t group = 0;
+    for (const auto &attributesGroups : config) {
+        sp<ProductStrategy> strategy = new ProductStrategy("strategy");
+        for (const auto &[stream, attributes] : attributesGroups) {
+            strategy->addAttributes({stream, group++, attributes});
+        }
+        strategies[strategy->getId()] = strategy;
+    }
+    if (lookupTables) {
+        strategies.initialize();
+    }
+    return strategies;
+}
+
+// Attributes of typical clients, the last ones only matching the default strategy.
+static const std::vector<audio_attributes_t> kAttributes = {
+    {.content_type = AUDIO_CONTENT_TYPE_MUSIC, .usage = AUDIO_USAGE_MEDIA},
+    {.content_type = AUDIO_CONTENT_TYPE_SONIFICATION, .usage = AUDIO_USAGE_GAME},
+    {.content_type = AUDIO_CONTENT_TYPE_SPEECH, .usage = AUDIO_USAGE_VOICE_COMMUNICATION},
+    {.content_type = AUDIO_CONTENT_TYPE_SONIFICATION, .usage = AUDIO_USAGE_NOTIFICATION},
+    {.usage = AUDIO_USAGE_ASSISTANCE_SONIFICATION},
+    {.usage = AUDIO_USAGE_MEDIA, .flags = AUDIO_FLAG_LOW_LATENCY},
+    {.content_type = AUDIO_CONTENT_TYPE_MOVIE, .usage = AUDIO_USAGE_UNKNOWN},
+    {.usage = AUDIO_USAGE_VIRTUAL_SOURCE},
+};
+
+static void BM_GetProductStrategyForAttributes(benchmark::State& state) {
+    const ProductStrategyMap strategies = createStrategies(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strategies.getProductStrategyForAttributes(
+                kAttributes[i++ % kAttributes.size()]));
+    }
+}
+
+static void BM_GetVolumeGroupForAttributes(benchmark::State& state) {
+    const ProductStrategyMap strategies = createStrategies(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strategies.getVolumeGroupForAttributes(
+                kAttributes[i++ % kAttributes.size()]));
+    }
+}
+
+static void BM_GetStreamTypeForAttributes(benchmark::State& state) {
+    const ProductStrategyMap strategies = createStrategies(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strategies.getStreamTypeForAttributes(
+                kAttributes[i++ % kAttributes.size()]));
+    }
+}
+
+static void BM_GetProductStrategyForStream(benchmark::State& state) {
+    const ProductStrategyMap strategies = createStrategies(state.range(0));
+    int stream = AUDIO_STREAM_MIN;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strategies.getProductStrategyForStream(
+                static_cast<audio_stream_type_t>(stream++ % AUDIO_STREAM_PUBLIC_CNT)));
+    }
+}
+
+static void BM_GetVolumeGroupForStreamType(benchmark::State& state) {
+    const ProductStrategyMap strategies = createStrategies(state.range(0));
+    int stream = AUDIO_STREAM_MIN;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strategies.getVolumeGroupForStreamType(
+                static_cast<audio_stream_type_t>(stream++ % AUDIO_STREAM_PUBLIC_CNT)));
+    }
+}
+
+// Arg(0) matches by scanning all the strategies, Arg(1) with the lookup tables.
+BENCHMARK(BM_GetProductStrategyForAttributes)->Arg(0)->Arg(1);
+BENCHMARK(BM_GetVolumeGroupForAttributes)->Arg(0)->Arg(1);
+BENCHMARK(BM_GetStreamTypeForAttributes)->Arg(0)->Arg(1);
+BENCHMARK(BM_GetProductStrategyForStream)->Arg(0)->Arg(1);
+BENCHMARK(BM_GetVolumeGroupForStreamType)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
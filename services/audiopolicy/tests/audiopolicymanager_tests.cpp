@@ -89,6 +89,85 @@ TEST(AudioPolicyManagerTestInit, ConfigLoadingIsTransactional) {
     EXPECT_FALSE(manager.getConfig().getOutputDevices().isEmpty());
 }
 
+static void expectSameConfig(const AudioPolicyConfig& expected, const AudioPolicyConfig& actual) {
+    const HwModuleCollection expectedModules = expected.getHwModules();
+    const HwModuleCollection actualModules = actual.getHwModules();
+    ASSERT_EQ(expectedModules.size(), actualModules.size());
+    for (size_t i = 0; i < expectedModules.size(); ++i) {
+        const sp<HwModule>& expectedModule = expectedModules[i];
+        const sp<HwModule>& actualModule = actualModules[i];
+        SCOPED_TRACE(expectedModule->getName());
+        EXPECT_STREQ(expectedModule->getName(), actualModule->getName());
+        EXPECT_EQ(expectedModule->getHalVersionMajor(), actualModule->getHalVersionMajor());
+        EXPECT_EQ(expectedModule->getRoutes().size(), actualModule->getRoutes().size());
+        for (const bool output : { true, false }) {
+            const IOProfileCollection& expectedProfiles = output ?
+                    expectedModule->getOutputProfiles() : expectedModule->getInputProfiles();
+            const IOProfileCollection& actualProfiles = output ?
+                    actualModule->getOutputProfiles() : actualModule->getInputProfiles();
+            ASSERT_EQ(expectedProfiles.size(), actualProfiles.size());
+            for (size_t j = 0; j < expectedProfiles.size(); ++j) {
+                EXPECT_EQ(expectedProfiles[j]->getName(), actualProfiles[j]->getName());
+                EXPECT_EQ(expectedProfiles[j]->getFlags(), actualProfiles[j]->getFlags());
+                EXPECT_EQ(expectedProfiles[j]->maxActiveCount, actualProfiles[j]->maxActiveCount);
+                EXPECT_EQ(expectedProfiles[j]->getAudioProfiles().size(),
+                        actualProfiles[j]->getAudioProfiles().size());
+                EXPECT_EQ(expectedProfiles[j]->getSupportedDevices().size(),
+                        actualProfiles[j]->getSupportedDevices().size());
+            }
+        }
+        const DeviceVector& expectedDevices = expectedModule->getDeclaredDevices();
+        ASSERT_EQ(expectedDevices.size(), actualModule->getDeclaredDevices().size());
+        for (const auto& device : expectedDevices) {
+            sp<DeviceDescriptor> actualDevice =
+                    actualModule->getDeclaredDevices().getDeviceFromTagName(device->getTagName());
+            ASSERT_NE(nullptr, actualDevice) << device->getTagName();
+            EXPECT_EQ(device->type(), actualDevice->type());
+            EXPECT_EQ(device->address(), actualDevice->address());
+            EXPECT_EQ(device->getGains().size(), actualDevice->getGains().size());
+        }
+    }
+    EXPECT_EQ(expected.getOutputDevices().size(), actual.getOutputDevices().size());
+    EXPECT_EQ(expected.getInputDevices().size(), actual.getInputDevices().size());
+    ASSERT_NE(nullptr, actual.getDefaultOutputDevice());
+    EXPECT_EQ(expected.getDefaultOutputDevice()->getTagName(),
+            actual.getDefaultOutputDevice()->getTagName());
+    EXPECT_EQ(expected.getEngineLibraryNameSuffix(), actual.getEngineLibraryNameSuffix());
+    EXPECT_EQ(expected.getSurroundFormats(), actual.getSurroundFormats());
+}
+
+TEST(AudioPolicyManagerTestInit, ConfigCacheMatchesXml) {
+    const std::string configFile =
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml";
+    TemporaryDir cacheDir;
+    const std::string cacheFile = std::string(cacheDir.path) + "/config.cache";
+    AudioPolicyTestClient client;
+    bool cacheHit = true;
+
+    AudioPolicyTestManager fromXml(&client);
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile.c_str(), &fromXml.getConfig(), &cacheHit));
+    EXPECT_FALSE(cacheHit);
+
+    AudioPolicyTestManager fromCache(&client);
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile.c_str(), &fromCache.getConfig(), &cacheHit));
+    EXPECT_TRUE(cacheHit);
+    expectSameConfig(fromXml.getConfig(), fromCache.getConfig());
+
+    // A corrupted cache falls back to the XML, and is rewritten.
+    ASSERT_TRUE(base::WriteStringToFile("not a cache", cacheFile));
+    AudioPolicyTestManager afterCorruption(&client);
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile.c_str(), &afterCorruption.getConfig(), &cacheHit));
+    EXPECT_FALSE(cacheHit);
+    expectSameConfig(fromXml.getConfig(), afterCorruption.getConfig());
+    AudioPolicyTestManager afterRewrite(&client);
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile.c_str(), &afterRewrite.getConfig(), &cacheHit));
+    EXPECT_TRUE(cacheHit);
+}
+
 
 class PatchCountCheck {
   public:
@@ -321,6 +400,32 @@ TEST_F(AudioPolicyManagerTest, Dump) {
     dumpToLog();
 }
 
+TEST_F(AudioPolicyManagerTest, OutputSelectionCache) {
+    const uint64_t hits = mManager->getOutputSelectionCacheHits();
+    const uint64_t misses = mManager->getOutputSelectionCacheMisses();
+    audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t output1 = AUDIO_IO_HANDLE_NONE;
+    audio_io_handle_t output2 = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE, &output1);
+    EXPECT_EQ(misses + 1, mManager->getOutputSelectionCacheMisses());
+
+    // the same request is served from the cache.
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE, &output2);
+    EXPECT_EQ(output1, output2);
+    EXPECT_EQ(hits + 1, mManager->getOutputSelectionCacheHits());
+
+    // a force use change invalidates the cache.
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, AUDIO_POLICY_FORCE_NO_BT_A2DP);
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE, &output2);
+    EXPECT_EQ(output1, output2);
+    EXPECT_EQ(misses + 2, mManager->getOutputSelectionCacheMisses());
+}
+
 TEST_F(AudioPolicyManagerTest, CreateAudioPatchFailure) {
     audio_patch patch{};
     audio_patch_handle_t handle = AUDIO_PATCH_HANDLE_NONE;
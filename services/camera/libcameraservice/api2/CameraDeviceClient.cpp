@@ -18,6 +18,8 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <inttypes.h>
+
 #include <cutils/properties.h>
 #include <utils/CameraThreadState.h>
 #include <utils/Log.h>
@@ -1779,6 +1781,7 @@ binder::Status CameraDeviceClient::switchToOffline(
     binder::Status res;
     if (!(res = checkPidStatus(__FUNCTION__)).isOk()) return res;
 
+    nsecs_t switchStartNs = systemTime();
     Mutex::Autolock icl(mBinderSerializationLock);
 
     if (!mDevice.get()) {
@@ -1870,6 +1873,11 @@ binder::Status CameraDeviceClient::switchToOffline(
         Mutex::Autolock l(mCompositeLock);
         mCompositeStreamMap.clear();
         mInputStream = {false, 0, 0, 0, 0};
+
+        mOfflineSwitchStartNs = switchStartNs;
+        ALOGI("%s: Camera %s: switched %zu streams to offline in %" PRId64 " ms", __FUNCTION__,
+                mCameraIdStr.string(), offlineStreamIds.size(),
+                ns2ms(systemTime() - switchStartNs));
     } else {
         switch(ret) {
             case BAD_VALUE:
@@ -1926,6 +1934,13 @@ status_t CameraDeviceClient::dumpClient(int fd, const Vector<String16>& args) {
     // TODO: print dynamic/request section from most recent requests
     mFrameProcessor->dump(fd, args);
 
+    {
+        Mutex::Autolock l(mCompositeLock);
+        for (size_t i = 0; i < mCompositeStreamMap.size(); i++) {
+            mCompositeStreamMap.valueAt(i)->dump(fd);
+        }
+    }
+
     return dumpDevice(fd, args);
 }
 
@@ -2080,8 +2095,17 @@ void CameraDeviceClient::detachDevice() {
 
     Camera2ClientBase::detachDevice();
 
-    int32_t closeLatencyMs = ns2ms(systemTime() - startTime);
+    nsecs_t endTime = systemTime();
+    int32_t closeLatencyMs = ns2ms(endTime - startTime);
     CameraServiceProxyWrapper::logClose(mCameraIdStr, closeLatencyMs);
+
+    if (mOfflineSwitchStartNs != 0) {
+        // The camera can only be reopened once the online device is closed, while the
+        // offline session may still be processing.
+        ALOGI("%s: Camera %s: closed %" PRId64 " ms after switching to offline (close took %d ms)",
+                __FUNCTION__, mCameraIdStr.string(), ns2ms(endTime - mOfflineSwitchStartNs),
+                closeLatencyMs);
+    }
 }
 
 /** Device-related methods */
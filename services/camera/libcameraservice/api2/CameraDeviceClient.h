@@ -333,6 +333,10 @@ private:
     int32_t mRequestIdCounter;
     bool mPrivilegedClient;
 
+    // Start of a successful switchToOffline, 0 if the device was never switched to offline.
+    // Used to log how long the camera stays unavailable to other clients after the switch.
+    nsecs_t mOfflineSwitchStartNs = 0;
+
     std::vector<std::string> mPhysicalCameraIds;
 
     // The list of output streams whose surfaces are deferred. We have to track them separately
@@ -18,6 +18,8 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <inttypes.h>
+
 #include "CameraOfflineSessionClient.h"
 #include "utils/CameraThreadState.h"
 #include <utils/Trace.h>
@@ -108,6 +110,9 @@ status_t CameraOfflineSessionClient::dumpClient(int fd, const Vector<String16>&
         return NO_ERROR;
     }
 
+    result = String8::format("    %s\n", getDrainStats().string());
+    write(fd, result.string(), result.size());
+
     mFrameProcessor->dump(fd, args);
 
     auto res = mOfflineSession->dump(fd);
@@ -163,8 +168,8 @@ binder::Status CameraOfflineSessionClient::disconnect() {
     mFrameProcessor->join();
 
     finishCameraOps();
-    ALOGI("%s: Disconnected client for offline camera %s for PID %d", __FUNCTION__,
-            mCameraIdStr.string(), mClientPid);
+    ALOGI("%s: Disconnected client for offline camera %s for PID %d: %s", __FUNCTION__,
+            mCameraIdStr.string(), mClientPid, getDrainStats().string());
 
     // client shouldn't be able to call into us anymore
     mClientPid = 0;
@@ -275,6 +280,12 @@ void CameraOfflineSessionClient::onResultAvailable(const CaptureResult& result)
     ATRACE_CALL();
     ALOGV("%s", __FUNCTION__);
 
+    nsecs_t now = systemTime();
+    if (mResultCount++ == 0) {
+        mFirstResultNs = now;
+    }
+    mLastResultNs = now;
+
     if (mRemoteCallback.get() != NULL) {
         mRemoteCallback->onResultReceived(result.mMetadata, result.mResultExtras,
                 result.mPhysicalMetadatas);
@@ -285,6 +296,16 @@ void CameraOfflineSessionClient::onResultAvailable(const CaptureResult& result)
     }
 }
 
+String8 CameraOfflineSessionClient::getDrainStats() const {
+    int64_t resultCount = mResultCount;
+    if (resultCount == 0) {
+        return String8::format("no results in %" PRId64 " ms", ns2ms(systemTime() - mCreatedNs));
+    }
+    return String8::format("%" PRId64 " results, first after %" PRId64 " ms, last after %"
+            PRId64 " ms", resultCount, ns2ms(mFirstResultNs - mCreatedNs),
+            ns2ms(mLastResultNs - mCreatedNs));
+}
+
 void CameraOfflineSessionClient::notifyShutter(const CaptureResultExtras& resultExtras,
         nsecs_t timestamp) {
 
@@ -17,6 +17,8 @@
 #ifndef ANDROID_SERVERS_CAMERA_PHOTOGRAPHY_CAMERAOFFLINESESSIONCLIENT_H
 #define ANDROID_SERVERS_CAMERA_PHOTOGRAPHY_CAMERAOFFLINESESSIONCLIENT_H
 
+#include <atomic>
+
 #include <android/hardware/camera2/BnCameraOfflineSession.h>
 #include <android/hardware/camera2/ICameraDeviceCallbacks.h>
 #include "common/FrameProcessorBase.h"
@@ -59,7 +61,7 @@ public:
                     cameraIdStr, cameraFacing, sensorOrientation, clientPid, clientUid, servicePid,
                     /*overrideToPortrait*/false),
             mRemoteCallback(remoteCallback), mOfflineSession(session),
-            mCompositeStreamMap(offlineCompositeStreamMap) {}
+            mCompositeStreamMap(offlineCompositeStreamMap), mCreatedNs(systemTime()) {}
 
     virtual ~CameraOfflineSessionClient() {}
 
@@ -126,6 +128,15 @@ private:
 
     // Offline composite stream map, output surface -> composite stream
     KeyedVector<sp<IBinder>, sp<CompositeStream>> mCompositeStreamMap;
+
+    // How long the offline session takes to drain, from the switch to offline.
+    // Results are only delivered by the frame processor thread.
+    const nsecs_t mCreatedNs;
+    std::atomic<int64_t> mResultCount{0};
+    std::atomic<nsecs_t> mFirstResultNs{0};
+    std::atomic<nsecs_t> mLastResultNs{0};
+
+    String8 getDrainStats() const;
 };
 
 } // namespace android
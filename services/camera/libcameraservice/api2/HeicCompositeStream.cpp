@@ -71,7 +71,15 @@ HeicCompositeStream::HeicCompositeStream(sp<CameraDeviceBase> device,
         mCodecOutputCounter(0),
         mQuality(-1),
         mGridTimestampUs(0),
-        mStatusId(StatusTracker::NO_STATUS_ID) {
+        mStatusId(StatusTracker::NO_STATUS_ID),
+        mImageCount(0),
+        mLastImageTime(0),
+        mEncodeCount(0),
+        mTotalEncodeTime(0),
+        mMaxEncodeTime(0),
+        mShotToShotCount(0),
+        mTotalShotToShotTime(0),
+        mMaxShotToShotTime(0) {
 }
 
 HeicCompositeStream::~HeicCompositeStream() {
@@ -157,7 +165,7 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
     }
 
     if (!mUseGrid) {
-        res = mCodec->createInputSurface(&producer);
+        res = mCodecs[0]->createInputSurface(&producer);
         if (res != OK) {
             ALOGE("%s: Failed to create input surface for Heic codec: %s (%d)",
                     __FUNCTION__, strerror(-res), res);
@@ -171,11 +179,13 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
     }
     mMainImageSurface = new Surface(producer);
 
-    res = mCodec->start();
-    if (res != OK) {
-        ALOGE("%s: Failed to start codec: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
+    for (auto& codec : mCodecs) {
+        res = codec->start();
+        if (res != OK) {
+            ALOGE("%s: Failed to start codec: %s (%d)", __FUNCTION__,
+                    strerror(-res), res);
+            return res;
+        }
     }
 
     std::vector<int> sourceSurfaceId;
@@ -389,38 +399,48 @@ void HeicCompositeStream::onHeicOutputFrameAvailable(
         const CodecOutputBufferInfo& outputBufferInfo) {
     Mutex::Autolock l(mMutex);
 
-    ALOGV("%s: index %d, offset %d, size %d, time %" PRId64 ", flags 0x%x",
-            __FUNCTION__, outputBufferInfo.index, outputBufferInfo.offset,
-            outputBufferInfo.size, outputBufferInfo.timeUs, outputBufferInfo.flags);
+    ALOGV("%s: codec %zu, index %d, offset %d, size %d, time %" PRId64 ", flags 0x%x",
+            __FUNCTION__, outputBufferInfo.codecIndex, outputBufferInfo.index,
+            outputBufferInfo.offset, outputBufferInfo.size, outputBufferInfo.timeUs,
+            outputBufferInfo.flags);
 
+    if (outputBufferInfo.codecIndex >= mCodecs.size()) {
+        ALOGE("%s: Invalid codec index %zu", __FUNCTION__, outputBufferInfo.codecIndex);
+        return;
+    }
+    const sp<MediaCodec>& codec = mCodecs[outputBufferInfo.codecIndex];
     if (!mErrorState) {
         if ((outputBufferInfo.size > 0) &&
                 ((outputBufferInfo.flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0)) {
-            mCodecOutputBuffers.push_back(outputBufferInfo);
+            mCodecOutputBuffers[outputBufferInfo.codecIndex].push_back(outputBufferInfo);
             mInputReadyCondition.signal();
         } else {
             ALOGV("%s: Releasing output buffer: size %d flags: 0x%x ", __FUNCTION__,
                 outputBufferInfo.size, outputBufferInfo.flags);
-            mCodec->releaseOutputBuffer(outputBufferInfo.index);
+            codec->releaseOutputBuffer(outputBufferInfo.index);
         }
     } else {
-        mCodec->releaseOutputBuffer(outputBufferInfo.index);
+        codec->releaseOutputBuffer(outputBufferInfo.index);
     }
 }
 
-void HeicCompositeStream::onHeicInputFrameAvailable(int32_t index) {
+void HeicCompositeStream::onHeicInputFrameAvailable(int32_t index, size_t codecIndex) {
     Mutex::Autolock l(mMutex);
 
     if (!mUseGrid) {
         ALOGE("%s: Codec YUV input mode must only be used for Hevc tiling mode", __FUNCTION__);
         return;
     }
+    if (codecIndex >= mCodecInputBuffers.size()) {
+        ALOGE("%s: Invalid codec index %zu", __FUNCTION__, codecIndex);
+        return;
+    }
 
-    mCodecInputBuffers.push_back(index);
+    mCodecInputBuffers[codecIndex].push_back(index);
     mInputReadyCondition.signal();
 }
 
-void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat) {
+void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat, size_t codecIndex) {
     if (newFormat == nullptr) {
         ALOGE("%s: newFormat must not be null!", __FUNCTION__);
         return;
@@ -428,6 +448,20 @@ void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat) {
 
     Mutex::Autolock l(mMutex);
 
+    // The tiles from all the codecs are muxed into one image item with a single
+    // set of parameter sets, so the codecs, configured the same way, must agree
+    // on them.
+    sp<ABuffer> csd, currentCsd;
+    if (mCodecs.size() > 1 && mFormat != nullptr &&
+            newFormat->findBuffer("csd-0", &csd) && mFormat->findBuffer("csd-0", &currentCsd) &&
+            (csd->size() != currentCsd->size() ||
+             memcmp(csd->data(), currentCsd->data(), csd->size()) != 0)) {
+        ALOGE("%s: Codec %zu parameter sets differ from the other tile encoders",
+                __FUNCTION__, codecIndex);
+        mErrorState = true;
+        return;
+    }
+
     AString mime;
     AString mimeHeic(MIMETYPE_IMAGE_ANDROID_HEIC);
     newFormat->findString(KEY_MIME, &mime);
@@ -685,14 +719,22 @@ void HeicCompositeStream::compilePendingInputLocked() {
             mMainImageConsumer->unlockBuffer(imgBuffer);
         } else {
             mPendingInputFrames[frameNumber].yuvBuffer = imgBuffer;
+            mPendingInputFrames[frameNumber].encodeStartTime = systemTime();
             mYuvBufferAcquired = true;
         }
         mInputYuvBuffers.erase(it);
         mMainImageFrameNumbers.pop();
     }
 
+    // Codec outputs are taken in tile order, tile i of each image coming from
+    // codec i % mCodecs.size(), so that they are muxed in order.
     while (!mCodecOutputBuffers.empty()) {
-        auto it = mCodecOutputBuffers.begin();
+        auto& codecOutputBuffers =
+                mCodecOutputBuffers[mCodecOutputCounter % mCodecOutputBuffers.size()];
+        if (codecOutputBuffers.empty()) {
+            break;
+        }
+        auto it = codecOutputBuffers.begin();
         // Assume encoder input to output is FIFO, use a queue to look up
         // frameNumber when handling codec outputs.
         int64_t bufferFrameNumber = -1;
@@ -712,7 +754,7 @@ void HeicCompositeStream::compilePendingInputLocked() {
             ALOGV("%s: [%" PRId64 "]: Pushing codecOutputBuffers (frameNumber %" PRId64 ")",
                     __FUNCTION__, bufferFrameNumber, it->timeUs);
         }
-        mCodecOutputBuffers.erase(it);
+        codecOutputBuffers.erase(it);
     }
 
     while (!mCaptureResults.empty()) {
@@ -758,21 +800,25 @@ void HeicCompositeStream::compilePendingInputLocked() {
         it = mExifErrorFrameNumbers.erase(it);
     }
 
-    // Distribute codec input buffers to be filled out from YUV output
+    // Distribute codec input buffers to be filled out from YUV output, tile i
+    // of each image going to codec i % mCodecs.size().
     for (auto it = mPendingInputFrames.begin();
             it != mPendingInputFrames.end() && mCodecInputBuffers.size() > 0; it++) {
         InputFrame& inputFrame(it->second);
         if (inputFrame.codecInputCounter < mGridRows * mGridCols) {
             // Available input tiles that are required for the current input
-            // image.
-            size_t newInputTiles = std::min(mCodecInputBuffers.size(),
-                    mGridRows * mGridCols - inputFrame.codecInputCounter);
-            for (size_t i = 0; i < newInputTiles; i++) {
-                CodecInputBufferInfo inputInfo =
-                        { mCodecInputBuffers[0], mGridTimestampUs++, inputFrame.codecInputCounter };
+            // image, as long as the codec of the next tile has an input buffer.
+            while (inputFrame.codecInputCounter < mGridRows * mGridCols) {
+                size_t codecIndex = inputFrame.codecInputCounter % mCodecInputBuffers.size();
+                auto& codecInputBuffers = mCodecInputBuffers[codecIndex];
+                if (codecInputBuffers.empty()) {
+                    break;
+                }
+                CodecInputBufferInfo inputInfo = { codecInputBuffers[0], mGridTimestampUs++,
+                        inputFrame.codecInputCounter, codecIndex };
                 inputFrame.codecInputBuffers.push_back(inputInfo);
 
-                mCodecInputBuffers.erase(mCodecInputBuffers.begin());
+                codecInputBuffers.erase(codecInputBuffers.begin());
                 inputFrame.codecInputCounter++;
             }
             break;
@@ -1047,8 +1093,9 @@ status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame
 
 status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
     for (auto& inputBuffer : inputFrame.codecInputBuffers) {
+        const sp<MediaCodec>& codec = mCodecs[inputBuffer.codecIndex];
         sp<MediaCodecBuffer> buffer;
-        auto res = mCodec->getInputBuffer(inputBuffer.index, &buffer);
+        auto res = codec->getInputBuffer(inputBuffer.index, &buffer);
         if (res != OK) {
             ALOGE("%s: Error getting codec input buffer: %s (%d)", __FUNCTION__,
                     strerror(-res), res);
@@ -1075,7 +1122,7 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
             return res;
         }
 
-        res = mCodec->queueInputBuffer(inputBuffer.index, 0, buffer->capacity(),
+        res = codec->queueInputBuffer(inputBuffer.index, 0, buffer->capacity(),
                 inputBuffer.timeUs, 0, nullptr /*errorDetailMsg*/);
         if (res != OK) {
             ALOGE("%s: Failed to queueInputBuffer to Codec: %s (%d)",
@@ -1091,8 +1138,9 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
 status_t HeicCompositeStream::processOneCodecOutputFrame(int64_t frameNumber,
         InputFrame &inputFrame) {
     auto it = inputFrame.codecOutputBuffers.begin();
+    const sp<MediaCodec>& codec = mCodecs[it->codecIndex];
     sp<MediaCodecBuffer> buffer;
-    status_t res = mCodec->getOutputBuffer(it->index, &buffer);
+    status_t res = codec->getOutputBuffer(it->index, &buffer);
     if (res != OK) {
         ALOGE("%s: Error getting Heic codec output buffer at index %d: %s (%d)",
                 __FUNCTION__, it->index, strerror(-res), res);
@@ -1113,7 +1161,7 @@ status_t HeicCompositeStream::processOneCodecOutputFrame(int64_t frameNumber,
         return res;
     }
 
-    mCodec->releaseOutputBuffer(it->index);
+    codec->releaseOutputBuffer(it->index);
     if (inputFrame.pendingOutputTiles == 0) {
         ALOGW("%s: Codec generated more tiles than expected!", __FUNCTION__);
     } else {
@@ -1204,8 +1252,9 @@ void HeicCompositeStream::releaseInputFrameLocked(int64_t frameNumber,
 
     while (!inputFrame->codecOutputBuffers.empty()) {
         auto it = inputFrame->codecOutputBuffers.begin();
-        ALOGV("%s: releaseOutputBuffer index %d", __FUNCTION__, it->index);
-        mCodec->releaseOutputBuffer(it->index);
+        ALOGV("%s: releaseOutputBuffer codec %zu index %d", __FUNCTION__, it->codecIndex,
+                it->index);
+        mCodecs[it->codecIndex]->releaseOutputBuffer(it->index);
         inputFrame->codecOutputBuffers.erase(it);
     }
 
@@ -1246,6 +1295,9 @@ void HeicCompositeStream::releaseInputFramesLocked() {
         auto& inputFrame = it->second;
         if (inputFrame.error ||
                 (inputFrame.appSegmentWritten && inputFrame.pendingOutputTiles == 0)) {
+            if (!inputFrame.error) {
+                updateImageStatsLocked(inputFrame);
+            }
             releaseInputFrameLocked(it->first, &inputFrame);
             it = mPendingInputFrames.erase(it);
             inputFrameDone = true;
@@ -1297,17 +1349,6 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
         return NO_INIT;
     }
 
-    // Create HEIC/HEVC codec.
-    if (mUseHeic) {
-        mCodec = MediaCodec::CreateByType(mCodecLooper, desiredMime, true /*encoder*/);
-    } else {
-        mCodec = MediaCodec::CreateByComponentName(mCodecLooper, hevcName);
-    }
-    if (mCodec == nullptr) {
-        ALOGE("%s: Failed to create codec for %s", __FUNCTION__, desiredMime);
-        return NO_INIT;
-    }
-
     // Create Looper and handler for Codec callback.
     mCodecCallbackHandler = new CodecCallbackHandler(this);
     if (mCodecCallbackHandler == nullptr) {
@@ -1327,14 +1368,6 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
     }
     mCallbackLooper->registerHandler(mCodecCallbackHandler);
 
-    mAsyncNotify = new AMessage(kWhatCallbackNotify, mCodecCallbackHandler);
-    res = mCodec->setCallback(mAsyncNotify);
-    if (res != OK) {
-        ALOGE("%s: Failed to set MediaCodec callback: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
-    }
-
     // Create output format and configure the Codec.
     sp<AMessage> outputFormat = new AMessage();
     outputFormat->setString(KEY_MIME, desiredMime);
@@ -1364,22 +1397,36 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
         gridCols = 1;
     }
 
+    // With framework tiling, the tiles can be encoded by several HEVC encoders
+    // in parallel, each encoding every codecCount-th tile.
+    size_t codecCount = 1;
+    if (useGrid) {
+        codecCount = std::min(
+                static_cast<size_t>(HeicEncoderInfoManager::getInstance().getMaxTileEncoders()),
+                static_cast<size_t>(gridRows * gridCols));
+    }
+    int32_t tilesPerCodec = (gridRows * gridCols + codecCount - 1) / codecCount;
+
     outputFormat->setInt32(KEY_WIDTH, !useGrid ? width : gridWidth);
     outputFormat->setInt32(KEY_HEIGHT, !useGrid ? height : gridHeight);
     outputFormat->setInt32(KEY_I_FRAME_INTERVAL, 0);
     outputFormat->setInt32(KEY_COLOR_FORMAT,
             useGrid ? COLOR_FormatYUV420Flexible : COLOR_FormatSurface);
-    outputFormat->setInt32(KEY_FRAME_RATE, useGrid ? gridRows * gridCols : kNoGridOpRate);
+    outputFormat->setInt32(KEY_FRAME_RATE, useGrid ? tilesPerCodec : kNoGridOpRate);
     // This only serves as a hint to encoder when encoding is not real-time.
     outputFormat->setInt32(KEY_OPERATING_RATE, useGrid ? kGridOpRate : kNoGridOpRate);
 
-    res = mCodec->configure(outputFormat, nullptr /*nativeWindow*/,
-            nullptr /*crypto*/, CONFIGURE_FLAG_ENCODE);
-    if (res != OK) {
-        ALOGE("%s: Failed to configure codec: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
+    // Create HEIC/HEVC codecs.
+    for (size_t i = 0; i < codecCount; i++) {
+        sp<MediaCodec> codec = createCodec(desiredMime, hevcName, outputFormat, i);
+        if (codec == nullptr) {
+            return NO_INIT;
+        }
+        mCodecs.push_back(codec);
     }
+    mCodecInputBuffers.assign(codecCount, std::vector<int32_t>());
+    mCodecOutputBuffers.assign(codecCount, std::vector<CodecOutputBufferInfo>());
+    ALOGV("%s: %zu codec(s) for %d x %d tiles", __FUNCTION__, codecCount, gridCols, gridRows);
 
     mGridWidth = gridWidth;
     mGridHeight = gridHeight;
@@ -1396,13 +1443,48 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
     return OK;
 }
 
+sp<MediaCodec> HeicCompositeStream::createCodec(const char* mime, const AString& hevcName,
+        const sp<AMessage>& outputFormat, size_t codecIndex) {
+    sp<MediaCodec> codec;
+    if (mUseHeic) {
+        codec = MediaCodec::CreateByType(mCodecLooper, mime, true /*encoder*/);
+    } else {
+        codec = MediaCodec::CreateByComponentName(mCodecLooper, hevcName);
+    }
+    if (codec == nullptr) {
+        ALOGE("%s: Failed to create codec %zu for %s", __FUNCTION__, codecIndex, mime);
+        return nullptr;
+    }
+
+    sp<AMessage> asyncNotify = new AMessage(kWhatCallbackNotify, mCodecCallbackHandler);
+    asyncNotify->setSize("codecIndex", codecIndex);
+    status_t res = codec->setCallback(asyncNotify);
+    if (res != OK) {
+        ALOGE("%s: Failed to set MediaCodec callback: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+        codec->release();
+        return nullptr;
+    }
+
+    // Each codec gets its own copy, as configure() adds to the format.
+    res = codec->configure(outputFormat->dup(), nullptr /*nativeWindow*/,
+            nullptr /*crypto*/, CONFIGURE_FLAG_ENCODE);
+    if (res != OK) {
+        ALOGE("%s: Failed to configure codec: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+        codec->release();
+        return nullptr;
+    }
+    return codec;
+}
+
 void HeicCompositeStream::deinitCodec() {
     ALOGV("%s", __FUNCTION__);
-    if (mCodec != nullptr) {
-        mCodec->stop();
-        mCodec->release();
-        mCodec.clear();
+    for (auto& codec : mCodecs) {
+        codec->stop();
+        codec->release();
     }
+    mCodecs.clear();
 
     if (mCodecLooper != nullptr) {
         mCodecLooper->stop();
@@ -1414,7 +1496,6 @@ void HeicCompositeStream::deinitCodec() {
         mCallbackLooper.clear();
     }
 
-    mAsyncNotify.clear();
     mFormat.clear();
 }
 
@@ -1647,13 +1728,15 @@ void HeicCompositeStream::updateCodecQualityLocked(int32_t quality) {
     if (quality != mQuality) {
         sp<AMessage> qualityParams = new AMessage;
         qualityParams->setInt32(PARAMETER_KEY_VIDEO_BITRATE, quality);
-        status_t res = mCodec->setParameters(qualityParams);
-        if (res != OK) {
-            ALOGE("%s: Failed to set codec quality: %s (%d)",
-                    __FUNCTION__, strerror(-res), res);
-        } else {
-            mQuality = quality;
+        for (auto& codec : mCodecs) {
+            status_t res = codec->setParameters(qualityParams);
+            if (res != OK) {
+                ALOGE("%s: Failed to set codec quality: %s (%d)",
+                        __FUNCTION__, strerror(-res), res);
+                return;
+            }
         }
+        mQuality = quality;
     }
 }
 
@@ -1721,6 +1804,40 @@ bool HeicCompositeStream::threadLoop() {
     return true;
 }
 
+void HeicCompositeStream::updateImageStatsLocked(const InputFrame& inputFrame) {
+    nsecs_t now = systemTime();
+    if (mLastImageTime > 0) {
+        nsecs_t shotToShotTime = now - mLastImageTime;
+        mShotToShotCount++;
+        mTotalShotToShotTime += shotToShotTime;
+        mMaxShotToShotTime = std::max(mMaxShotToShotTime, shotToShotTime);
+    }
+    mImageCount++;
+    mLastImageTime = now;
+
+    if (inputFrame.encodeStartTime >= 0) {
+        nsecs_t encodeTime = now - inputFrame.encodeStartTime;
+        mEncodeCount++;
+        mTotalEncodeTime += encodeTime;
+        mMaxEncodeTime = std::max(mMaxEncodeTime, encodeTime);
+        ALOGV("%s: Image encoded in %" PRId64 " ms", __FUNCTION__, ns2ms(encodeTime));
+    }
+}
+
+void HeicCompositeStream::dump(int fd) {
+    Mutex::Autolock l(mMutex);
+    dprintf(fd, "    HEIC composite stream %d: %zu codec(s), %zu x %zu tiles\n",
+            mMainImageStreamId, mCodecs.size(), mGridCols, mGridRows);
+    dprintf(fd, "      Images: %" PRId64 ", shot to shot avg %" PRId64 " ms max %" PRId64 " ms\n",
+            mImageCount,
+            mShotToShotCount > 0 ? ns2ms(mTotalShotToShotTime / mShotToShotCount) : 0,
+            ns2ms(mMaxShotToShotTime));
+    if (mEncodeCount > 0) {
+        dprintf(fd, "      Encode time avg %" PRId64 " ms max %" PRId64 " ms\n",
+                ns2ms(mTotalEncodeTime / mEncodeCount), ns2ms(mMaxEncodeTime));
+    }
+}
+
 void HeicCompositeStream::flagAnExifErrorFrameNumber(int64_t frameNumber) {
     Mutex::Autolock l(mMutex);
     mExifErrorFrameNumbers.emplace(frameNumber);
@@ -1799,6 +1916,8 @@ void HeicCompositeStream::markTrackerIdle() {
         statusTracker->markComponentIdle(mStatusId, Fence::NO_FENCE);
         ALOGV("%s: Mark component as idle", __FUNCTION__);
     }
+    // The next image starts a new burst, don't count the idle time as shot to shot.
+    mLastImageTime = 0;
 }
 
 void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMessage> &msg) {
@@ -1813,7 +1932,13 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                  break;
              }
 
-             ALOGV("kWhatCallbackNotify: cbID = %d", cbID);
+             size_t codecIndex;
+             if (!msg->findSize("codecIndex", &codecIndex)) {
+                 ALOGE("kWhatCallbackNotify: codecIndex is expected.");
+                 break;
+             }
+
+             ALOGV("kWhatCallbackNotify: cbID = %d, codec %zu", cbID, codecIndex);
 
              switch (cbID) {
                  case MediaCodec::CB_INPUT_AVAILABLE: {
@@ -1822,7 +1947,7 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                          ALOGE("CB_INPUT_AVAILABLE: index is expected.");
                          break;
                      }
-                     parent->onHeicInputFrameAvailable(index);
+                     parent->onHeicInputFrameAvailable(index, codecIndex);
                      break;
                  }
 
@@ -1859,7 +1984,8 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                          (int32_t)offset,
                          (int32_t)size,
                          timeUs,
-                         (uint32_t)flags};
+                         (uint32_t)flags,
+                         codecIndex};
 
                      parent->onHeicOutputFrameAvailable(bufferInfo);
                      break;
@@ -1877,7 +2003,7 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                      if (format != nullptr) {
                          formatCopy = format->dup();
                      }
-                     parent->onHeicFormatChanged(formatCopy);
+                     parent->onHeicFormatChanged(formatCopy, codecIndex);
                      break;
                  }
 
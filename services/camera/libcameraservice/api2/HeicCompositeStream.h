@@ -71,6 +71,8 @@ public:
     // CpuConsumer listener implementation
     void onFrameAvailable(const BufferItem& item) override;
 
+    void dump(int fd) override;
+
     // Return stream information about the internal camera streams
     static status_t getCompositeStreamInfo(const OutputStreamInfo &streamInfo,
             const CameraMetadata& ch, std::vector<OutputStreamInfo>* compositeOutput /*out*/);
@@ -95,12 +97,14 @@ private:
         int32_t size;
         int64_t timeUs;
         uint32_t flags;
+        size_t codecIndex;
     };
 
     struct CodecInputBufferInfo {
         int32_t index;
         int64_t timeUs;
         size_t tileIndex;
+        size_t codecIndex;
     };
 
     class CodecCallbackHandler : public AHandler {
@@ -118,10 +122,12 @@ private:
     };
 
     bool              mUseHeic;
-    sp<MediaCodec>    mCodec;
+    // With framework tiling, the tiles may be spread across several encoder
+    // instances: tile i is encoded by mCodecs[i % mCodecs.size()]. Otherwise
+    // there is a single codec.
+    std::vector<sp<MediaCodec>> mCodecs;
     sp<ALooper>       mCodecLooper, mCallbackLooper;
     sp<CodecCallbackHandler> mCodecCallbackHandler;
-    sp<AMessage>      mAsyncNotify;
     sp<AMessage>      mFormat;
     size_t            mNumOutputTiles;
 
@@ -136,12 +142,15 @@ private:
     static const int32_t kGridOpRate = 120;
 
     void onHeicOutputFrameAvailable(const CodecOutputBufferInfo& bufferInfo);
-    void onHeicInputFrameAvailable(int32_t index);  // Only called for YUV input mode.
-    void onHeicFormatChanged(sp<AMessage>& newFormat);
+    // Only called for YUV input mode.
+    void onHeicInputFrameAvailable(int32_t index, size_t codecIndex);
+    void onHeicFormatChanged(sp<AMessage>& newFormat, size_t codecIndex);
     void onHeicCodecError();
 
     status_t initializeCodec(uint32_t width, uint32_t height,
             const sp<CameraDeviceBase>& cameraDevice);
+    sp<MediaCodec> createCodec(const char* mime, const AString& hevcName,
+            const sp<AMessage>& outputFormat, size_t codecIndex);
     void deinitCodec();
 
     //
@@ -174,11 +183,12 @@ private:
         bool                      appSegmentWritten;
         size_t                    pendingOutputTiles;
         size_t                    codecInputCounter;
+        nsecs_t                   encodeStartTime; // When the YUV buffer was acquired.
 
         InputFrame() : orientation(0), quality(kDefaultJpegQuality), error(false),
                        exifError(false), timestamp(-1), requestId(-1), fenceFd(-1),
                        fileFd(-1), trackIndex(-1), anb(nullptr), appSegmentWritten(false),
-                       pendingOutputTiles(0), codecInputCounter(0) { }
+                       pendingOutputTiles(0), codecInputCounter(0), encodeStartTime(-1) { }
     };
 
     void compilePendingInputLocked();
@@ -256,16 +266,17 @@ private:
     // Keep all incoming APP segment Blob buffer pending further processing.
     std::vector<int64_t> mInputAppSegmentBuffers;
 
-    // Keep all incoming HEIC blob buffer pending further processing.
-    std::vector<CodecOutputBufferInfo> mCodecOutputBuffers;
+    // Keep all incoming HEIC blob buffer pending further processing, per codec.
+    std::vector<std::vector<CodecOutputBufferInfo>> mCodecOutputBuffers;
     std::queue<int64_t> mCodecOutputBufferFrameNumbers;
+    // Output tiles of the oldest frame so far, also the index of its next tile.
     size_t mCodecOutputCounter;
     int32_t mQuality;
 
     // Keep all incoming Yuv buffer pending tiling and encoding (for HEVC YUV tiling only)
     std::vector<int64_t> mInputYuvBuffers;
-    // Keep all codec input buffers ready to be filled out (for HEVC YUV tiling only)
-    std::vector<int32_t> mCodecInputBuffers;
+    // Keep all codec input buffers ready to be filled out, per codec (for HEVC YUV tiling only)
+    std::vector<std::vector<int32_t>> mCodecInputBuffers;
 
     // Artificial strictly incremental YUV grid timestamp to make encoder happy.
     int64_t mGridTimestampUs;
@@ -283,6 +294,17 @@ private:
     // The status id for tracking the active/idle status of this composite stream
     int mStatusId;
     void markTrackerIdle();
+
+    // Statistics of the completed images, guarded by mMutex.
+    void updateImageStatsLocked(const InputFrame& inputFrame);
+    int64_t mImageCount;
+    nsecs_t mLastImageTime;
+    // From the YUV buffer to the HEIC image, with framework tiling only.
+    int64_t mEncodeCount;
+    nsecs_t mTotalEncodeTime, mMaxEncodeTime;
+    // Between consecutive completed images of a burst.
+    int64_t mShotToShotCount;
+    nsecs_t mTotalShotToShotTime, mMaxShotToShotTime;
 };
 
 }; // namespace camera3
@@ -17,6 +17,7 @@
 #define LOG_TAG "HeicEncoderInfoManager"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <cstdint>
 #include <regex>
 
@@ -39,7 +40,8 @@ HeicEncoderInfoManager::HeicEncoderInfoManager() :
         mMaxSizeHeic(INT32_MAX, INT32_MAX),
         mHasHEVC(false),
         mHasHEIC(false),
-        mDisableGrid(false) {
+        mDisableGrid(false),
+        mMaxTileEncoders(1) {
     if (initialize() == OK) {
         mIsInited = true;
     }
@@ -337,6 +339,7 @@ bool HeicEncoderInfoManager::getHevcCodecDetails(
         mMinSizeHevc = minSizeHevc;
         mMaxSizeHevc = maxSizeHevc;
         mHevcFrameRateMaps = hevcFrameRateMaps;
+        mMaxTileEncoders = queryMaxTileEncoders(details);
 
         found = true;
         break;
@@ -345,5 +348,23 @@ bool HeicEncoderInfoManager::getHevcCodecDetails(
     return found;
 }
 
+int32_t HeicEncoderInfoManager::queryMaxTileEncoders(sp<AMessage> details) {
+    int32_t tileEncoders = property_get_int32("camera.heic.tile_encoders", 1);
+    if (tileEncoders <= 1) {
+        return 1;
+    }
+
+    // Leave one instance for the other users of the encoder, such as a
+    // concurrent video recording.
+    AString maxInstances;
+    if (details->findString("max-concurrent-instances", &maxInstances) ||
+            details->findString("max-supported-instances", &maxInstances)) {
+        int32_t instances = atoi(maxInstances.c_str()) - 1;
+        tileEncoders = std::min(tileEncoders, std::max(instances, 1));
+    }
+    ALOGV("%s: [%s] %d tile encoders", __FUNCTION__, mHevcName.c_str(), tileEncoders);
+    return tileEncoders;
+}
+
 } //namespace camera3
 } // namespace android
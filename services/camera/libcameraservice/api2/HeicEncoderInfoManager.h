@@ -38,6 +38,11 @@ public:
     bool isSizeSupported(int32_t width, int32_t height,
             bool* useHeic, bool* useGrid, int64_t* stall, AString* hevcName) const;
 
+    // The number of HEVC encoder instances the tiles of a grid image can be
+    // encoded with in parallel. Limited by the concurrent instances the encoder
+    // supports, and by the camera.heic.tile_encoders property, which defaults to 1.
+    int32_t getMaxTileEncoders() const { return mMaxTileEncoders; }
+
     // kGridWidth and kGridHeight should be 2^n
     static const auto kGridWidth = 512;
     static const auto kGridHeight = 512;
@@ -63,6 +68,7 @@ private:
             int32_t width, int32_t height) const;
     sp<AMessage> getCodecDetails(sp<IMediaCodecList> codecsList, const char* name);
     bool getHevcCodecDetails(sp<IMediaCodecList> codecsList, const char* mime);
+    int32_t queryMaxTileEncoders(sp<AMessage> details);
 
     bool mIsInited;
     std::pair<int32_t, int32_t> mMinSizeHeic, mMaxSizeHeic;
@@ -71,6 +77,7 @@ private:
     AString mHevcName;
     FrameRateMaps mHeicFrameRateMaps, mHevcFrameRateMaps;
     bool mDisableGrid;
+    int32_t mMaxTileEncoders;
 
 };
 
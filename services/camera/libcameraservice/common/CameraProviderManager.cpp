@@ -55,7 +55,18 @@ using hardware::camera2::utils::CameraIdAndSessionConfiguration;
 
 namespace {
 const bool kEnableLazyHal(property_get_bool("ro.camera.enableLazyHal", false));
+const bool kEnableStaticInfoCache(property_get_bool("ro.camera.enableStaticInfoCache", false));
+const char* kStaticInfoCacheDir = "/data/misc/cameraserver/static_info";
 const std::string kExternalProviderName = "external/0";
+
+// Static info cache entries are only valid for the build they were written with.
+std::string getBuildFingerprint() {
+    char fingerprint[PROPERTY_VALUE_MAX];
+    char vendorFingerprint[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", fingerprint, "");
+    property_get("ro.vendor.build.fingerprint", vendorFingerprint, "");
+    return std::string(fingerprint) + "|" + vendorFingerprint;
+}
 } // anonymous namespace
 
 const float CameraProviderManager::kDepthARTolerance = .1f;
@@ -159,6 +170,10 @@ status_t CameraProviderManager::initialize(wp<CameraProviderManager::StatusListe
     }
     mListener = listener;
     mDeviceState = 0;
+    if (kEnableStaticInfoCache && mStaticInfoCache == nullptr) {
+        mStaticInfoCache = std::make_shared<CameraStaticInfoCache>(kStaticInfoCacheDir,
+                getBuildFingerprint());
+    }
     auto res = tryToInitAndAddHidlProvidersLocked(hidlProxy);
     if (res != OK) {
         // Logging done in called function;
@@ -838,6 +853,10 @@ hardware::Return<void> CameraProviderManager::onRegistration(
 status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
+    if (mStaticInfoCache != nullptr) {
+        dprintf(fd, "== Camera static info cache: %zu hits, %zu misses ==\n",
+                mStaticInfoCache->getHitCount(), mStaticInfoCache->getMissCount());
+    }
     for (auto& provider : mProviders) {
         provider->dump(fd, args);
     }
@@ -846,9 +865,29 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
-    for (auto& device : devices) {
+    // Querying the information of a device takes several provider round trips. Do it for all
+    // devices in parallel, then add them in the order reported by the provider. With lazy HALs
+    // the provider interface is (re)started on demand, which is not safe to do concurrently.
+    std::vector<std::future<std::unique_ptr<DeviceInfo>>> deviceInfos;
+    if (!kEnableLazyHal && devices.size() > 1) {
+        for (auto& device : devices) {
+            deviceInfos.push_back(std::async(std::launch::async,
+                    [this, device]() -> std::unique_ptr<DeviceInfo> {
+                uint16_t major, minor;
+                std::string type, id;
+                if (parseDeviceName(device, &major, &minor, &type, &id) != OK) {
+                    return nullptr;
+                }
+                return initializeDeviceInfo(device, mProviderTagid, id, minor);
+            }));
+        }
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        const std::string& device = devices[i];
         std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id,
+                i < deviceInfos.size() ? deviceInfos[i].get() : nullptr);
         if (res != OK) {
             ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
                     __FUNCTION__, device.c_str(), strerror(-res), res);
@@ -1867,9 +1906,18 @@ const std::string& CameraProviderManager::ProviderInfo::getType() const {
     return mType;
 }
 
+std::shared_ptr<CameraStaticInfoCache>
+CameraProviderManager::ProviderInfo::getStaticInfoCache() const {
+    // External cameras can be swapped behind the same device name, never cache them.
+    if (mType == "external") {
+        return nullptr;
+    }
+    return mManager->mStaticInfoCache;
+}
+
 status_t CameraProviderManager::ProviderInfo::addDevice(
         const std::string& name, CameraDeviceStatus initialStatus,
-        /*out*/ std::string* parsedId) {
+        /*out*/ std::string* parsedId, std::unique_ptr<DeviceInfo> deviceInfo) {
 
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
@@ -1893,7 +1941,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
             switch (major) {
@@ -1917,7 +1964,9 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    if (deviceInfo == nullptr) {
+        deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    }
     if (deviceInfo == nullptr) return BAD_VALUE;
     deviceInfo->notifyDeviceStateChange(getDeviceState());
     deviceInfo->mStatus = initialStatus;
@@ -2130,8 +2179,17 @@ status_t CameraProviderManager::ProviderInfo::cameraDeviceStatusChangeLocked(
                 mProviderName.c_str(), cameraDeviceName.c_str());
             return BAD_VALUE;
         }
+        // The provider changed its device list, don't trust previously cached information.
+        auto staticInfoCache = getStaticInfoCache();
+        if (staticInfoCache != nullptr) {
+            staticInfoCache->invalidate(mProviderName, cameraDeviceName);
+        }
         addDevice(cameraDeviceName, newStatus, &cameraId);
     } else if (newStatus == CameraDeviceStatus::NOT_PRESENT) {
+        auto staticInfoCache = getStaticInfoCache();
+        if (staticInfoCache != nullptr) {
+            staticInfoCache->invalidate(mProviderName, cameraDeviceName);
+        }
         removeDevice(cameraId);
     } else if (isExternalLazyHAL()) {
         // Do not notify CameraService for PRESENT->PRESENT (lazy HAL restart)
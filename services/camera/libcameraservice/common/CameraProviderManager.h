@@ -33,6 +33,7 @@
 #include <android/hardware/ICameraService.h>
 #include <utils/IPCTransport.h>
 #include <utils/SessionConfigurationUtils.h>
+#include <utils/CameraStaticInfoCache.h>
 #include <aidl/android/hardware/camera/provider/ICameraProvider.h>
 #include <android/hardware/camera/common/1.0/types.h>
 #include <android/hardware/camera/provider/2.5/ICameraProvider.h>
@@ -532,6 +533,12 @@ private:
          */
         bool isExternalLazyHAL() const;
 
+        /**
+         * On-disk cache for the static characteristics of this provider's devices, or nullptr
+         * if the characteristics must always be queried from the provider.
+         */
+        std::shared_ptr<CameraStaticInfoCache> getStaticInfoCache() const;
+
         // Basic device information, common to all camera devices
         struct DeviceInfo {
             const std::string mName;  // Full instance name
@@ -749,9 +756,12 @@ private:
         // Generate vendor tag id
         static metadata_vendor_id_t generateVendorTagId(const std::string &name);
 
+        // If deviceInfo is given, it is used instead of querying the provider for the
+        // device information again.
         status_t addDevice(
                 const std::string& name, CameraDeviceStatus initialStatus,
-                /*out*/ std::string* parsedId);
+                /*out*/ std::string* parsedId,
+                std::unique_ptr<DeviceInfo> deviceInfo = nullptr);
 
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
@@ -830,6 +840,8 @@ private:
 
     size_t mProviderInstanceId = 0;
     std::vector<sp<ProviderInfo>> mProviders;
+    // Only set up at initialize() time, read-only afterwards.
+    std::shared_ptr<CameraStaticInfoCache> mStaticInfoCache;
     // Provider names of AIDL providers with retrieved binders.
     std::set<std::string> mAidlProviderWithBinders;
 
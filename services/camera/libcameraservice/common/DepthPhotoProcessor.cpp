@@ -35,6 +35,8 @@
 #include <libexif/exif-data.h>
 #include <libexif/exif-system.h>
 #include <math.h>
+#include <algorithm>
+#include <future>
 #include <sstream>
 #include <utils/Errors.h>
 #include <utils/ExifUtils.h>
@@ -42,6 +44,10 @@
 #include <xmpmeta/xmp_data.h>
 #include <xmpmeta/xmp_writer.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #ifndef __unused
 #define __unused __attribute__((__unused__))
 #endif
@@ -239,102 +245,159 @@ status_t encodeGrayscaleJpeg(size_t width, size_t height, uint8_t *in, void *out
     return ret;
 }
 
-inline void unpackDepth16(uint16_t value, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    // Android densely packed depth map. The units for the range are in
-    // millimeters and need to be scaled to meters.
-    // The confidence value is encoded in the 3 most significant bits.
-    // The confidence data needs to be additionally normalized with
-    // values 1.0f, 0.0f representing maximum and minimum confidence
-    // respectively.
-    auto point = static_cast<float>(value & 0x1FFF) / 1000.f;
-    points->push_back(point);
+// Android densely packed depth samples hold the range in millimeters in the 13 least
+// significant bits and the confidence in the 3 most significant bits.
+static const uint16_t DEPTH_RANGE_MASK = 0x1FFF;
+static const int DEPTH_CONFIDENCE_SHIFT = 13;
+static const uint16_t DEPTH_CONFIDENCE_VALUES = 8;
 
-    auto conf = (value >> 13) & 0x7;
-    float normConfidence = (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
-    confidence->push_back(normConfidence);
-    if (normConfidence < CONFIDENCE_THRESHOLD) {
-        return;
-    }
+// The confidence data needs to be normalized with values 1.0f, 0.0f representing
+// maximum and minimum confidence respectively.
+inline float normalizeConfidence(uint16_t conf) {
+    return (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
+}
 
-    if (*near > point) {
-        *near = point;
-    }
-    if (*far < point) {
-        *far = point;
+// Bit 'n' is set if samples with confidence value 'n' are above CONFIDENCE_THRESHOLD, so
+// that the kernels below can test the confidence without any floating point math.
+uint16_t getConfidentMask() {
+    uint16_t mask = 0;
+    for (uint16_t conf = 0; conf < DEPTH_CONFIDENCE_VALUES; conf++) {
+        if (normalizeConfidence(conf) >= CONFIDENCE_THRESHOLD) {
+            mask |= 1 << conf;
+        }
     }
+    return mask;
 }
 
-// Trivial case, read forward from top,left corner.
-void rotate0AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+// Trivial case, copy forward from top,left corner.
+void rotate0AndCopy(const DepthPhotoInputFrame &inputFrame, uint16_t *depth /*out*/) {
     for (size_t i = 0; i < inputFrame.mDepthMapHeight; i++) {
-        for (size_t j = 0; j < inputFrame.mDepthMapWidth; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
-        }
+        memcpy(depth, inputFrame.mDepthMapBuffer + i*inputFrame.mDepthMapStride,
+                inputFrame.mDepthMapWidth * sizeof(uint16_t));
+        depth += inputFrame.mDepthMapWidth;
     }
 }
 
 // 90 degrees CW rotation can be applied by starting to read from bottom, left corner
 // transposing rows and columns.
-void rotate90AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate90AndCopy(const DepthPhotoInputFrame &inputFrame, uint16_t *depth /*out*/) {
     for (size_t i = 0; i < inputFrame.mDepthMapWidth; i++) {
         for (ssize_t j = inputFrame.mDepthMapHeight-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
+            *depth++ = inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i];
         }
     }
 }
 
 // 180 CW degrees rotation can be applied by starting to read backwards from bottom, right corner.
-void rotate180AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate180AndCopy(const DepthPhotoInputFrame &inputFrame, uint16_t *depth /*out*/) {
     for (ssize_t i = inputFrame.mDepthMapHeight-1; i >= 0; i--) {
-        for (ssize_t j = inputFrame.mDepthMapWidth-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
-        }
+        std::reverse_copy(inputFrame.mDepthMapBuffer + i*inputFrame.mDepthMapStride,
+                inputFrame.mDepthMapBuffer + i*inputFrame.mDepthMapStride +
+                inputFrame.mDepthMapWidth, depth);
+        depth += inputFrame.mDepthMapWidth;
     }
 }
 
 // 270 degrees CW rotation can be applied by starting to read from top, right corner
 // transposing rows and columns.
-void rotate270AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate270AndCopy(const DepthPhotoInputFrame &inputFrame, uint16_t *depth /*out*/) {
     for (ssize_t i = inputFrame.mDepthMapWidth-1; i >= 0; i--) {
         for (size_t j = 0; j < inputFrame.mDepthMapHeight; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
+            *depth++ = inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i];
         }
     }
 }
 
-bool rotateAndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+bool rotateAndCopy(const DepthPhotoInputFrame &inputFrame, uint16_t *depth /*out*/) {
     switch (inputFrame.mOrientation) {
         case DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES:
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
+            rotate0AndCopy(inputFrame, depth);
             return false;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_90_DEGREES:
-            rotate90AndUnpack(inputFrame, points, confidence, near, far);
+            rotate90AndCopy(inputFrame, depth);
             return true;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_180_DEGREES:
-            rotate180AndUnpack(inputFrame, points, confidence, near, far);
+            rotate180AndCopy(inputFrame, depth);
             return false;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_270_DEGREES:
-            rotate270AndUnpack(inputFrame, points, confidence, near, far);
+            rotate270AndCopy(inputFrame, depth);
             return true;
         default:
             ALOGE("%s: Unsupported depth photo rotation: %d, default to 0", __FUNCTION__,
                     inputFrame.mOrientation);
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
+            rotate0AndCopy(inputFrame, depth);
     }
 
     return false;
 }
 
+// Finds the smallest and largest range of the samples above the confidence threshold.
+// 'nearRaw' stays at UINT16_MAX and 'farRaw' at 0 if there are no such samples.
+void findDepthRange(const uint16_t *depth, size_t count, uint16_t confidentMask,
+        uint16_t *nearRaw /*out*/, uint16_t *farRaw /*out*/) {
+    uint16_t nearest = UINT16_MAX;
+    uint16_t farthest = 0;
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    const uint16x8_t rangeMask = vdupq_n_u16(DEPTH_RANGE_MASK);
+    const uint16x8_t confidentBits = vdupq_n_u16(confidentMask);
+    const uint16x8_t one = vdupq_n_u16(1);
+    const uint16x8_t maxRange = vdupq_n_u16(UINT16_MAX);
+    uint16x8_t nearVec = maxRange;
+    uint16x8_t farVec = vdupq_n_u16(0);
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t value = vld1q_u16(depth + i);
+        uint16x8_t range = vandq_u16(value, rangeMask);
+        int16x8_t conf = vreinterpretq_s16_u16(vshrq_n_u16(value, DEPTH_CONFIDENCE_SHIFT));
+        // Shifting the mask right by the confidence value moves its bit into lane bit 0.
+        uint16x8_t confident = vtstq_u16(vshlq_u16(confidentBits, vnegq_s16(conf)), one);
+        nearVec = vminq_u16(nearVec, vbslq_u16(confident, range, maxRange));
+        farVec = vmaxq_u16(farVec, vandq_u16(confident, range));
+    }
+    uint16_t lanes[8];
+    vst1q_u16(lanes, nearVec);
+    for (auto lane : lanes) {
+        nearest = std::min(nearest, lane);
+    }
+    vst1q_u16(lanes, farVec);
+    for (auto lane : lanes) {
+        farthest = std::max(farthest, lane);
+    }
+#endif
+    for (; i < count; i++) {
+        if ((confidentMask >> (depth[i] >> DEPTH_CONFIDENCE_SHIFT)) & 1) {
+            uint16_t range = depth[i] & DEPTH_RANGE_MASK;
+            nearest = std::min(nearest, range);
+            farthest = std::max(farthest, range);
+        }
+    }
+
+    *nearRaw = nearest;
+    *farRaw = farthest;
+}
+
+// Range inverse coding of the depth samples. The loop is kept free of branches so that
+// the compiler can vectorize it.
+void quantizeDepth(const uint16_t *depth, size_t count, uint16_t confidentMask, float near,
+        float far, uint8_t *out /*out*/) {
+    for (size_t i = 0; i < count; i++) {
+        // The units for the range are in millimeters and need to be scaled to meters.
+        float point = static_cast<float>(depth[i] & DEPTH_RANGE_MASK) / 1000.f;
+        bool confident = (confidentMask >> (depth[i] >> DEPTH_CONFIDENCE_SHIFT)) & 1;
+        float clamped = std::clamp(point, near, far);
+        point = confident ? point : clamped;
+        out[i] = floorf(((far * (point - near)) / (point * (far - near))) * 255.0f);
+    }
+}
+
+void quantizeConfidence(const uint16_t *depth, size_t count, uint8_t *out /*out*/) {
+    for (size_t i = 0; i < count; i++) {
+        // Same as floorf(normalizeConfidence(conf) * 255.0f), in integer math.
+        uint16_t conf = depth[i] >> DEPTH_CONFIDENCE_SHIFT;
+        out[i] = (conf == 0) ? 255 : ((conf - 1) * 255) / 7;
+    }
+}
+
 std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFrame inputFrame,
         ExifOrientation exifOrientation, std::vector<std::unique_ptr<Item>> *items /*out*/,
         bool *switchDimensions /*out*/) {
@@ -342,21 +405,16 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         return nullptr;
     }
 
-    std::vector<float> points, confidence;
-
     size_t pointCount = inputFrame.mDepthMapWidth * inputFrame.mDepthMapHeight;
-    points.reserve(pointCount);
-    confidence.reserve(pointCount);
-    float near = UINT16_MAX;
-    float far = .0f;
+    std::vector<uint16_t> depth(pointCount);
     *switchDimensions = false;
     // Physical rotation of depth and confidence maps may be needed in case
     // the EXIF orientation is set to 0 degrees and the depth photo orientation
     // (source color image) has some different value.
     if (exifOrientation == ExifOrientation::ORIENTATION_0_DEGREES) {
-        *switchDimensions = rotateAndUnpack(inputFrame, &points, &confidence, &near, &far);
+        *switchDimensions = rotateAndCopy(inputFrame, depth.data());
     } else {
-        rotate0AndUnpack(inputFrame, &points, &confidence, &near, &far);
+        rotate0AndCopy(inputFrame, depth.data());
     }
 
     size_t width = inputFrame.mDepthMapWidth;
@@ -366,32 +424,36 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         height = inputFrame.mDepthMapWidth;
     }
 
+    // The confidence map does not depend on the depth range, so it is quantized and
+    // compressed on a separate thread while the depth map is processed on this one.
+    std::vector<uint8_t> confidenceJpeg(inputFrame.mMaxJpegSize);
+    size_t confidenceJpegSize = 0;
+    auto confidenceResult = std::async(std::launch::async, [&]() {
+        std::vector<uint8_t> confidenceQuantized(pointCount);
+        quantizeConfidence(depth.data(), pointCount, confidenceQuantized.data());
+        return encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                confidenceJpeg.data(), inputFrame.mMaxJpegSize, inputFrame.mJpegQuality,
+                exifOrientation, confidenceJpegSize);
+    });
+
+    uint16_t confidentMask = getConfidentMask();
+    uint16_t nearRaw, farRaw;
+    findDepthRange(depth.data(), pointCount, confidentMask, &nearRaw, &farRaw);
+    float near = (nearRaw == UINT16_MAX) ? UINT16_MAX : static_cast<float>(nearRaw) / 1000.f;
+    float far = static_cast<float>(farRaw) / 1000.f;
     if (near == far) {
         ALOGE("%s: Near and far range values must not match!", __FUNCTION__);
         return nullptr;
     }
 
-    std::vector<uint8_t> pointsQuantized, confidenceQuantized;
-    pointsQuantized.reserve(pointCount); confidenceQuantized.reserve(pointCount);
-    auto pointIt = points.begin();
-    auto confidenceIt = confidence.begin();
-    while ((pointIt != points.end()) && (confidenceIt != confidence.end())) {
-        auto point = *pointIt;
-        if ((*confidenceIt) < CONFIDENCE_THRESHOLD) {
-            point = std::clamp(point, near, far);
-        }
-        pointsQuantized.push_back(floorf(((far * (point - near)) /
-                (point * (far - near))) * 255.0f));
-        confidenceQuantized.push_back(floorf(*confidenceIt * 255.0f));
-        confidenceIt++; pointIt++;
-    }
+    std::vector<uint8_t> pointsQuantized(pointCount);
+    quantizeDepth(depth.data(), pointCount, confidentMask, near, far, pointsQuantized.data());
 
     DepthMapParams depthParams(DepthFormat::kRangeInverse, near, far, DepthUnits::kMeters,
             "android/depthmap");
     depthParams.confidence_uri = "android/confidencemap";
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
-    depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
     size_t actualJpegSize;
     auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
             depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
@@ -402,14 +464,13 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
     }
     depthParams.depth_image_data.resize(actualJpegSize);
 
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
+    ret = confidenceResult.get();
     if (ret != NO_ERROR) {
         ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.confidence_data.assign(confidenceJpeg.begin(),
+            confidenceJpeg.begin() + confidenceJpegSize);
 
     return DepthMap::FromData(depthParams, items);
 }
@@ -449,9 +449,19 @@ AidlProviderInfo::AidlDeviceInfo3::AidlDeviceInfo3(
         std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice> interface) :
         DeviceInfo3(name, tagId, id, minorVersion, resourceCost, parentProvider, publicCameraIds) {
 
-    // Get camera characteristics and initialize flash unit availability
+    // Get camera characteristics and initialize flash unit availability. Use the on-disk copy
+    // if there is one, to save the provider round trip.
+    std::shared_ptr<CameraStaticInfoCache> staticInfoCache = parentProvider->getStaticInfoCache();
+    const std::string& providerName = parentProvider->mProviderName;
     aidl::android::hardware::camera::device::CameraMetadata chars;
-    ::ndk::ScopedAStatus status = interface->getCameraCharacteristics(&chars);
+    ::ndk::ScopedAStatus status = ::ndk::ScopedAStatus::ok();
+    if (staticInfoCache == nullptr ||
+            !staticInfoCache->read(providerName, name, "", &chars.metadata)) {
+        status = interface->getCameraCharacteristics(&chars);
+        if (status.isOk() && staticInfoCache != nullptr) {
+            staticInfoCache->write(providerName, name, "", chars.metadata);
+        }
+    }
     std::vector<uint8_t> &metadata = chars.metadata;
     camera_metadata_t *buffer = reinterpret_cast<camera_metadata_t*>(metadata.data());
     size_t expectedSize = metadata.size();
@@ -581,7 +591,13 @@ AidlProviderInfo::AidlDeviceInfo3::AidlDeviceInfo3(
             }
 
             aidl::android::hardware::camera::device::CameraMetadata pChars;
-            status = interface->getPhysicalCameraCharacteristics(id, &pChars);
+            if (staticInfoCache == nullptr ||
+                    !staticInfoCache->read(providerName, name, id, &pChars.metadata)) {
+                status = interface->getPhysicalCameraCharacteristics(id, &pChars);
+                if (status.isOk() && staticInfoCache != nullptr) {
+                    staticInfoCache->write(providerName, name, id, pChars.metadata);
+                }
+            }
             if (!status.isOk()) {
                 ALOGE("%s: Transaction error getting physical camera %s characteristics for %s: %s",
                         __FUNCTION__, id.c_str(), id.c_str(), status.getMessage());
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-BufferPrefetcher"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <vector>
+
+#include <utils/Log.h>
+#include <utils/String8.h>
+#include <utils/Trace.h>
+
+#include "BufferPrefetcher.h"
+
+namespace android {
+
+namespace camera3 {
+
+BufferPrefetcher::BufferPrefetcher(int streamId, sp<Surface> consumer,
+        size_t maxPrefetchedBuffers) :
+        mStreamId(streamId),
+        mConsumer(consumer),
+        mMaxPrefetchedBuffers(maxPrefetchedBuffers) {
+}
+
+BufferPrefetcher::~BufferPrefetcher() {
+}
+
+bool BufferPrefetcher::takeBuffer(ANativeWindowBuffer** anb, int* fenceFd) {
+    Mutex::Autolock l(mLock);
+    if (mBuffers.empty()) {
+        mMissedCount++;
+        // The stream dequeues the buffer itself, which the prefetcher must leave room for
+        // until the next requestRefill().
+        if (mMaxDequeued > 0) {
+            mMaxDequeued--;
+        }
+        return false;
+    }
+    *anb = mBuffers.front().buffer;
+    *fenceFd = mBuffers.front().fenceFd;
+    mBuffers.pop_front();
+    mTakenCount++;
+    return true;
+}
+
+void BufferPrefetcher::onDequeueLatency(nsecs_t latency) {
+    Mutex::Autolock l(mLock);
+    updateLatencyLocked(latency);
+}
+
+void BufferPrefetcher::setFrameDuration(nsecs_t duration) {
+    Mutex::Autolock l(mLock);
+    mFrameDuration = duration;
+}
+
+void BufferPrefetcher::requestRefill(size_t maxDequeued) {
+    Mutex::Autolock l(mLock);
+    mMaxDequeued = maxDequeued;
+    if (mBuffers.size() < std::min(getTargetCountLocked(), mMaxDequeued)) {
+        mRefillCond.signal();
+    }
+}
+
+void BufferPrefetcher::cancelBuffers() {
+    std::vector<Surface::BatchBuffer> buffers;
+    {
+        Mutex::Autolock l(mLock);
+        mGeneration++;
+        mMaxDequeued = 0;
+        buffers.assign(mBuffers.begin(), mBuffers.end());
+        mBuffers.clear();
+    }
+
+    if (buffers.size() > 0) {
+        ALOGV("%s: Stream %d: cancelling %zu prefetched buffers", __FUNCTION__, mStreamId,
+                buffers.size());
+        mConsumer->cancelBuffers(buffers);
+    }
+}
+
+bool BufferPrefetcher::threadLoop() {
+    Mutex::Autolock l(mLock);
+    if (exitPending()) {
+        return false;
+    }
+    if (mBuffers.size() >= std::min(getTargetCountLocked(), mMaxDequeued)) {
+        mRefillCond.waitRelative(mLock, kWaitDuration);
+        return !exitPending();
+    }
+
+    uint32_t generation = mGeneration;
+    ANativeWindowBuffer* anb = nullptr;
+    int fenceFd = -1;
+    mLock.unlock();
+
+    nsecs_t dequeueStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    status_t res;
+    {
+        ATRACE_NAME("prefetchBuffer");
+        sp<ANativeWindow> anw = mConsumer;
+        res = anw->dequeueBuffer(anw.get(), &anb, &fenceFd);
+    }
+    nsecs_t dequeueEnd = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    mLock.lock();
+    updateLatencyLocked(dequeueEnd - dequeueStart);
+    if (res != OK) {
+        // Let the stream see and handle the error on its own next dequeue.
+        ALOGV("%s: Stream %d: dequeueBuffer failed: %s (%d)", __FUNCTION__, mStreamId,
+                strerror(-res), res);
+        mMaxDequeued = 0;
+        return !exitPending();
+    }
+    if (generation != mGeneration || exitPending()) {
+        bool exit = exitPending();
+        mLock.unlock();
+        sp<ANativeWindow> anw = mConsumer;
+        anw->cancelBuffer(anw.get(), anb, fenceFd);
+        mLock.lock();
+        return !exit;
+    }
+    mBuffers.push_back({anb, fenceFd});
+    return true;
+}
+
+void BufferPrefetcher::requestExit() {
+    // Call parent to set up shutdown
+    Thread::requestExit();
+    // Exit from other possible wait
+    mRefillCond.signal();
+}
+
+void BufferPrefetcher::dump(int fd) const {
+    String8 lines;
+    Mutex::Autolock l(mLock);
+    lines.appendFormat("      Buffer prefetch: %zu prefetched, target %zu, peak dequeue latency %"
+            PRId64 " us, %zu buffers taken, %zu missed\n", mBuffers.size(),
+            getTargetCountLocked(), ns2us(mPeakLatency), mTakenCount, mMissedCount);
+    write(fd, lines.string(), lines.size());
+}
+
+void BufferPrefetcher::updateLatencyLocked(nsecs_t latency) {
+    // Rise with the latency at once, and decay by 1/16 per dequeue, so that a slow
+    // consumer is remembered for a few dozens of frames.
+    mPeakLatency = std::max(latency, mPeakLatency - mPeakLatency / 16);
+}
+
+size_t BufferPrefetcher::getTargetCountLocked() const {
+    nsecs_t frameDuration = mFrameDuration > 0 ? mFrameDuration : kDefaultFrameDuration;
+    if (mPeakLatency < frameDuration / kMinLatencyRatio) {
+        return 0;
+    }
+    size_t target = 1 + static_cast<size_t>(mPeakLatency / frameDuration);
+    return std::min(target, mMaxPrefetchedBuffers);
+}
+
+}; //namespace camera3
+}; //namespace android
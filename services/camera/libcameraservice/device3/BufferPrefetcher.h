@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_BUFFERPREFETCHER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_BUFFERPREFETCHER_H
+
+#include <deque>
+
+#include <gui/Surface.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * Keeps a few buffers of an output stream dequeued ahead of the capture requests
+ * that need them, so that a slow dequeueBuffer (e.g. a consumer that is late
+ * releasing buffers) is absorbed off the request thread.
+ *
+ * The number of prefetched buffers adapts to the recent dequeueBuffer latency:
+ * none while dequeueing is much faster than a frame, and one more buffer per frame
+ * interval that a dequeue may take, up to the configured maximum. The stream bounds
+ * the prefetch by the buffers it may still hand out, so that prefetched and handed
+ * out buffers never exceed what the HAL may hold.
+ */
+class BufferPrefetcher : public Thread {
+  public:
+    BufferPrefetcher(int streamId, sp<Surface> consumer, size_t maxPrefetchedBuffers);
+    virtual ~BufferPrefetcher();
+
+    // Take the oldest prefetched buffer. Returns false if none is ready.
+    bool takeBuffer(ANativeWindowBuffer** anb, int* fenceFd);
+
+    // Record the latency of a dequeueBuffer done by the stream itself.
+    void onDequeueLatency(nsecs_t latency);
+
+    // Set the expected interval between buffer requests, 0 if unknown.
+    void setFrameDuration(nsecs_t duration);
+
+    // Refill the prefetched buffers, with at most maxDequeued buffers dequeued by the
+    // prefetcher at a time.
+    void requestRefill(size_t maxDequeued);
+
+    // Cancel all prefetched buffers back to the consumer, and stop refilling until the
+    // next requestRefill().
+    void cancelBuffers();
+
+    bool threadLoop() override;
+    void requestExit() override;
+
+    void dump(int fd) const;
+
+  private:
+    void updateLatencyLocked(nsecs_t latency);
+    size_t getTargetCountLocked() const;
+
+    const int mStreamId;
+    const sp<Surface> mConsumer;
+    const size_t mMaxPrefetchedBuffers;
+
+    mutable Mutex mLock;
+    Condition mRefillCond;
+
+    std::deque<Surface::BatchBuffer> mBuffers;
+    // Buffers the prefetcher may keep dequeued, including one being dequeued
+    size_t mMaxDequeued = 0;
+    bool mDequeueing = false;
+    // Incremented by cancelBuffers(), so that a dequeue in flight is cancelled too
+    uint32_t mGeneration = 0;
+
+    nsecs_t mFrameDuration = 0;
+    // Decaying peak of the dequeueBuffer latency
+    nsecs_t mPeakLatency = 0;
+    size_t mTakenCount = 0;
+    size_t mMissedCount = 0;
+
+    static constexpr nsecs_t kWaitDuration = 50000000LL; // 50ms
+    // Don't prefetch while dequeueing takes less than 1/kMinLatencyRatio of a frame
+    static constexpr nsecs_t kMinLatencyRatio = 8;
+    // Frame duration assumed until the stream knows its own: 30fps
+    static constexpr nsecs_t kDefaultFrameDuration = 33333333LL;
+};
+
+}; //namespace camera3
+}; //namespace android
+
+#endif
@@ -33,6 +33,8 @@ Camera3BufferManager::Camera3BufferManager() {
 }
 
 Camera3BufferManager::~Camera3BufferManager() {
+    Mutex::Autolock l(mLock);
+    trimBufferPoolLocked(/*budgetBytes*/0);
 }
 
 status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
@@ -285,22 +287,29 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
     if (mGrallocVersion < HARDWARE_DEVICE_API_VERSION(1,0)) {
         const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
         GraphicBufferEntry buffer;
-        buffer.fenceFd = -1;
-        buffer.graphicBuffer = new GraphicBuffer(
-                info.width, info.height, PixelFormat(info.format), info.combinedUsage,
-                std::string("Camera3BufferManager pid [") +
-                        std::to_string(getpid()) + "]");
-        status_t res = buffer.graphicBuffer->initCheck();
-
-        ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
-                __FUNCTION__, info.width, info.height, info.format,
-                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
-        if (res < 0) {
-            ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
-                    __FUNCTION__, res, strerror(-res));
-            return res;
+        status_t res = OK;
+        if (takeBufferFromPoolLocked(info, &buffer)) {
+            ALOGV("%s: reusing pooled graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+        } else {
+            buffer.fenceFd = -1;
+            buffer.graphicBuffer = new GraphicBuffer(
+                    info.width, info.height, PixelFormat(info.format), info.combinedUsage,
+                    std::string("Camera3BufferManager pid [") +
+                            std::to_string(getpid()) + "]");
+            res = buffer.graphicBuffer->initCheck();
+
+            ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+            if (res < 0) {
+                ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
+                        __FUNCTION__, res, strerror(-res));
+                return res;
+            }
+            ALOGV("%s: allocation done", __FUNCTION__);
         }
-        ALOGV("%s: allocation done", __FUNCTION__);
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
         bufferCount++;
@@ -451,12 +460,97 @@ status_t Camera3BufferManager::onBuffersRemoved(int streamId, int streamSetId,
     return OK;
 }
 
+status_t Camera3BufferManager::returnBufferToPool(int streamId, int streamSetId,
+        bool isMultiRes, const sp<GraphicBuffer>& gb, int fenceFd) {
+    ATRACE_CALL();
+    Mutex::Autolock l(mLock);
+
+    StreamSetKey streamSetKey = {streamSetId, isMultiRes};
+    if (gb == nullptr || !checkIfStreamRegisteredLocked(streamId, streamSetKey)) {
+        ALOGE("%s: invalid buffer returned to pool for stream %d with set id %d(%d)",
+                __FUNCTION__, streamId, streamSetId, isMultiRes);
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        return BAD_VALUE;
+    }
+
+    const StreamInfo& info = mStreamSetMap.valueFor(streamSetKey).streamInfoMap.valueFor(streamId);
+    size_t sizeBytes = estimateBufferSize(info, gb);
+    if (sizeBytes > kBufferPoolBudgetBytes) {
+        ALOGV("%s: buffer of %zu bytes doesn't fit in the pool", __FUNCTION__, sizeBytes);
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        return OK;
+    }
+
+    trimBufferPoolLocked(kBufferPoolBudgetBytes - sizeBytes);
+    mBufferPool.push_back({BufferPoolKey(info), GraphicBufferEntry(gb, fenceFd), sizeBytes});
+    mBufferPoolSizeBytes += sizeBytes;
+    ALOGV("%s: stream %d pooled buffer %p, pool size now %zu bytes", __FUNCTION__, streamId,
+            gb.get(), mBufferPoolSizeBytes);
+    return OK;
+}
+
+bool Camera3BufferManager::takeBufferFromPoolLocked(const StreamInfo& info,
+        GraphicBufferEntry* buffer) {
+    BufferPoolKey key(info);
+    // Reuse the most recently pooled buffer first.
+    for (auto it = mBufferPool.rbegin(); it != mBufferPool.rend(); it++) {
+        if (it->key == key) {
+            *buffer = it->entry;
+            mBufferPoolSizeBytes -= it->sizeBytes;
+            mBufferPool.erase(std::next(it).base());
+            mBufferPoolHitCount++;
+            return true;
+        }
+    }
+    mBufferPoolMissCount++;
+    return false;
+}
+
+void Camera3BufferManager::trimBufferPoolLocked(size_t budgetBytes) {
+    while (mBufferPoolSizeBytes > budgetBytes && !mBufferPool.empty()) {
+        PooledBuffer& oldest = mBufferPool.front();
+        if (oldest.entry.fenceFd >= 0) {
+            close(oldest.entry.fenceFd);
+        }
+        mBufferPoolSizeBytes -= oldest.sizeBytes;
+        mBufferPool.pop_front();
+    }
+}
+
+size_t Camera3BufferManager::estimateBufferSize(const StreamInfo& info,
+        const sp<GraphicBuffer>& gb) {
+    size_t stride = std::max(gb->getStride(), gb->getWidth());
+    size_t pixelCount = stride * gb->getHeight();
+    switch (info.format) {
+        case HAL_PIXEL_FORMAT_BLOB:
+            // Blob buffers are allocated as width bytes by 1 row.
+            return pixelCount;
+        case HAL_PIXEL_FORMAT_YCbCr_420_888:
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+        case HAL_PIXEL_FORMAT_YV12:
+            return pixelCount * 3 / 2;
+        case HAL_PIXEL_FORMAT_RAW16:
+        case HAL_PIXEL_FORMAT_Y16:
+            return pixelCount * 2;
+        default:
+            // Implementation defined and RGB formats: assume 4 bytes per pixel as upper bound.
+            return pixelCount * 4;
+    }
+}
+
 void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
     Mutex::Autolock l(mLock);
 
     (void) args;
     String8 lines;
     lines.appendFormat("      Total stream sets: %zu\n", mStreamSetMap.size());
+    lines.appendFormat("      Buffer pool: %zu buffers, %zu bytes (budget %zu), %zu hits,"
+            " %zu misses\n", mBufferPool.size(), mBufferPoolSizeBytes, kBufferPoolBudgetBytes,
+            mBufferPoolHitCount, mBufferPoolMissCount);
     for (size_t i = 0; i < mStreamSetMap.size(); i++) {
         lines.appendFormat("        Stream set %d(%d) has below streams:\n",
                 mStreamSetMap.keyAt(i).id, mStreamSetMap.keyAt(i).isMultiRes);
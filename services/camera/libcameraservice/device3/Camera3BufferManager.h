@@ -180,6 +180,29 @@ public:
      */
     void notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes);
 
+    /**
+     * This method hands a free buffer of a stream that is being torn down back to this buffer
+     * manager, so that it can be reused by a stream with the same buffer properties after the
+     * next stream configuration (e.g. when switching between photo and video mode), instead of
+     * being freed and reallocated.
+     *
+     * The buffer is kept in a pool keyed by (size, format, usage, dataspace) of the stream it
+     * was allocated for, and handed out by getBufferForStream() to a matching stream before a
+     * new buffer is allocated. The pool is bounded by kBufferPoolBudgetBytes; the least recently
+     * pooled buffers are freed first. The buffer manager takes ownership of fenceFd.
+     *
+     * This must be called before the stream is unregistered.
+     *
+     * Return values:
+     *
+     *  OK:        The buffer was added to the pool, or freed if it doesn't fit in the budget.
+     *  BAD_VALUE: stream ID or streamSetId are invalid, or stream ID and stream set ID
+     *             combination doesn't match what was registered, or this stream wasn't registered
+     *             to this buffer manager before, or the buffer is null.
+     */
+    status_t returnBufferToPool(int streamId, int streamSetId, bool isMultiRes,
+            const sp<GraphicBuffer>& gb, int fenceFd);
+
     /**
      * Dump the buffer manager statistics.
      */
@@ -205,6 +228,11 @@ private:
 
     static const size_t kMaxBufferCount = BufferQueueDefs::NUM_BUFFER_SLOTS;
 
+    /**
+     * Max total (estimated) size of the buffers kept in the pool across stream configurations.
+     */
+    static const size_t kBufferPoolBudgetBytes = 64 * 1024 * 1024;
+
     struct GraphicBufferEntry {
         sp<GraphicBuffer> graphicBuffer;
         int fenceFd;
@@ -309,6 +337,44 @@ private:
     KeyedVector<StreamSetKey, StreamSet> mStreamSetMap;
     KeyedVector<StreamId, wp<Camera3OutputStream>> mStreamMap;
 
+    /**
+     * Buffer properties a pooled buffer must match to be reused by a stream.
+     */
+    struct BufferPoolKey {
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint64_t usage;
+        android_dataspace dataSpace;
+
+        explicit BufferPoolKey(const StreamInfo& info) :
+                width(info.width),
+                height(info.height),
+                format(info.format),
+                usage(info.combinedUsage),
+                dataSpace(info.dataSpace) {}
+
+        inline bool operator==(const BufferPoolKey& other) const {
+            return width == other.width && height == other.height &&
+                    format == other.format && usage == other.usage &&
+                    dataSpace == other.dataSpace;
+        }
+    };
+
+    struct PooledBuffer {
+        BufferPoolKey key;
+        GraphicBufferEntry entry;
+        size_t sizeBytes;
+    };
+
+    /**
+     * Free buffers kept across stream configurations, least recently pooled first.
+     */
+    std::list<PooledBuffer> mBufferPool;
+    size_t mBufferPoolSizeBytes = 0;
+    size_t mBufferPoolHitCount = 0;
+    size_t mBufferPoolMissCount = 0;
+
     // TODO: There is no easy way to query the Gralloc version in this code yet, we have different
     // code paths for different Gralloc versions, hardcode something here for now.
     const uint32_t mGrallocVersion = GRALLOC_DEVICE_API_VERSION_0_1;
@@ -324,6 +390,21 @@ private:
      * free one if so.
      */
     status_t checkAndFreeBufferOnOtherStreamsLocked(int streamId, StreamSetKey streamSetKey);
+
+    /**
+     * Take a buffer matching the stream info out of the pool. Returns false if there is none.
+     */
+    bool takeBufferFromPoolLocked(const StreamInfo& info, GraphicBufferEntry* buffer);
+
+    /**
+     * Free the least recently pooled buffers until the pool fits in budgetBytes.
+     */
+    void trimBufferPoolLocked(size_t budgetBytes);
+
+    /**
+     * Estimated size of a buffer allocated for the given stream info.
+     */
+    static size_t estimateBufferSize(const StreamInfo& info, const sp<GraphicBuffer>& gb);
 };
 
 } // namespace camera3
@@ -583,12 +583,20 @@ status_t Camera3Device::dump(int fd, const Vector<String16> &args) {
                         r.numBuffersLeft);
             }
         }
+        lines.appendFormat("      In-flight latency: %zu requests, avg %" PRId64 " us,"
+                " max %" PRId64 " us\n", mInFlightMap.getLatencyCount(),
+                ns2us(mInFlightMap.getAverageLatencyNs()), ns2us(mInFlightMap.getMaxLatencyNs()));
         mInFlightLock.unlock();
     } else {
         lines.append("      Failed to acquire In-flight lock!\n");
     }
+    lines.appendFormat("    Result metadata buffers: %zu allocated, %zu reused\n",
+            mResultMetadataPool->getAllocationCount(), mResultMetadataPool->getReuseCount());
     write(fd, lines.string(), lines.size());
 
+    collectPreviewSpacingLatency();
+    mSessionStatsBuilder.dump(fd);
+
     if (mRequestThread != NULL) {
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
@@ -1924,6 +1932,7 @@ void Camera3Device::notifyStatus(bool idle) {
             int64_t requestCount, resultErrorCount;
             bool deviceError;
             std::map<int, StreamStats> streamStatsMap;
+            collectPreviewSpacingLatency();
             mSessionStatsBuilder.buildAndReset(&requestCount, &resultErrorCount,
                     &deviceError, &streamStatsMap);
             for (size_t i = 0; i < streamIds.size(); i++) {
@@ -1954,6 +1963,15 @@ void Camera3Device::notifyStatus(bool idle) {
     }
 }
 
+void Camera3Device::collectPreviewSpacingLatency() {
+    for (int streamId : mOutputStreams.getStreamIds()) {
+        sp<Camera3OutputStreamInterface> stream = mOutputStreams.get(streamId);
+        if (stream == nullptr) continue;
+        mSessionStatsBuilder.addPreviewSpacingLatency(streamId,
+                stream->getAndResetPreviewSpacingLatency());
+    }
+}
+
 status_t Camera3Device::setConsumerSurfaces(int streamId,
         const std::vector<sp<Surface>>& consumers, std::vector<int> *surfaceIds) {
     ATRACE_CALL();
@@ -2746,6 +2764,11 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
             outputSurfaces));
     if (res < 0) return res;
 
+    nsecs_t submitTimeNs = systemTime();
+    mInFlightMap.editValueAt(res).submitTimeNs = submitTimeNs;
+    mSessionStatsBuilder.addStageLatency(LATENCY_STAGE_REQUEST_SUBMIT,
+            submitTimeNs - requestTimeNs);
+
     if (mInFlightMap.size() == 1) {
         // Hold a separate dedicated tracker lock to prevent race with disconnect and also
         // avoid a deadlock during reprocess requests.
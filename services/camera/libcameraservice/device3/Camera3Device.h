@@ -315,6 +315,9 @@ class Camera3Device :
 
     float getMaxPreviewFps(sp<camera3::Camera3OutputStreamInterface> stream);
 
+    // Move the preview spacing latency histograms of the output streams into the session stats
+    void collectPreviewSpacingLatency();
+
     static const size_t        kDumpLockAttempts  = 10;
     static const size_t        kDumpSleepDuration = 100000; // 0.10 sec
     static const nsecs_t       kActiveTimeout     = 500000000;  // 500 ms
@@ -1203,6 +1206,8 @@ class Camera3Device :
     uint32_t               mNextZslStillShutterFrameNumber;
     std::list<CaptureResult>    mResultQueue;
     std::condition_variable  mResultSignal;
+    // Recycled buffers for the metadata of the results in mResultQueue
+    sp<CameraMetadataBufferPool> mResultMetadataPool = new CameraMetadataBufferPool();
     wp<NotificationListener> mListener;
 
     /**** End scope for mOutputLock ****/
@@ -103,6 +103,9 @@ class Camera3FakeStream :
     virtual void onMinDurationChanged(nsecs_t /*duration*/, bool /*fixedFps*/) {}
 
     virtual void setStreamUseCase(int64_t /*streamUseCase*/) {}
+
+    virtual std::array<int64_t, StageLatencyHistogram::BIN_COUNT>
+            getAndResetPreviewSpacingLatency() override { return {}; }
   protected:
 
     /**
@@ -27,6 +27,7 @@
 
 #include <android-base/unique_fd.h>
 #include <cutils/properties.h>
+#include <ui/Fence.h>
 #include <ui/GraphicBuffer.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
@@ -533,6 +534,14 @@ void Camera3OutputStream::dump(int fd, const Vector<String16> &args) const {
 
     mDequeueBufferLatency.dump(fd,
         "      DequeueBuffer latency histogram:");
+
+    if (mPreviewFrameSpacer != nullptr) {
+        mPreviewFrameSpacer->dump(fd);
+    }
+
+    if (mBufferPrefetcher != nullptr) {
+        mBufferPrefetcher->dump(fd);
+    }
 }
 
 status_t Camera3OutputStream::setTransform(int transform, bool mayChangeMirror) {
@@ -798,6 +807,20 @@ status_t Camera3OutputStream::configureConsumerQueueLocked(bool allowPreviewResp
         }
     }
 
+    int32_t maxPrefetchedBuffers = property_get_int32("camera.stream_prefetch.max_buffers",
+            kDefaultMaxPrefetchedBuffers);
+    if (allowPreviewRespace && !mUseBufferManager && maxPrefetchedBuffers > 0 &&
+            (isConsumedByHWComposer() || isConsumedByHWTexture() || isVideoStream())) {
+        mBufferPrefetcher = new BufferPrefetcher(mId, mConsumer, maxPrefetchedBuffers);
+        mBufferPrefetcher->setFrameDuration(mMinExpectedDuration);
+        res = mBufferPrefetcher->run(String8::format("BufPrefetch-%d", mId).string());
+        if (res != OK) {
+            // Not fatal, buffers are then only dequeued on demand.
+            ALOGW("%s: Unable to start buffer prefetcher for stream %d", __FUNCTION__, mId);
+            mBufferPrefetcher.clear();
+        }
+    }
+
     return OK;
 }
 
@@ -856,14 +879,24 @@ status_t Camera3OutputStream::getBufferLockedCommon(ANativeWindowBuffer** anb, i
         sp<Surface> consumer = mConsumer;
         size_t remainingBuffers = (mState == STATE_PREPARING ? mTotalBufferCount :
                                    camera_stream::max_buffers) - mHandoutTotalBufferCount;
+        sp<BufferPrefetcher> prefetcher =
+                (mState == STATE_PREPARING) ? nullptr : mBufferPrefetcher;
         mLock.unlock();
 
         nsecs_t dequeueStart = systemTime(SYSTEM_TIME_MONOTONIC);
 
         size_t batchSize = mBatchSize.load();
         if (batchSize == 1) {
-            sp<ANativeWindow> anw = consumer;
-            res = anw->dequeueBuffer(anw.get(), anb, fenceFd);
+            if (prefetcher != nullptr && prefetcher->takeBuffer(anb, fenceFd)) {
+                res = OK;
+            } else {
+                sp<ANativeWindow> anw = consumer;
+                res = anw->dequeueBuffer(anw.get(), anb, fenceFd);
+                if (prefetcher != nullptr) {
+                    prefetcher->onDequeueLatency(
+                            systemTime(SYSTEM_TIME_MONOTONIC) - dequeueStart);
+                }
+            }
         } else {
             std::unique_lock<std::mutex> batchLock(mBatchLock);
             res = OK;
@@ -943,6 +976,14 @@ status_t Camera3OutputStream::getBufferLockedCommon(ANativeWindowBuffer** anb, i
 
     if (res == OK) {
         checkRemovedBuffersLocked();
+
+        if (mBufferPrefetcher != nullptr && mBatchSize.load() == 1 &&
+                mState != STATE_PREPARING) {
+            // The buffer just dequeued isn't counted as handed out yet.
+            size_t handedOut = mHandoutTotalBufferCount + 1;
+            mBufferPrefetcher->requestRefill(camera_stream::max_buffers > handedOut ?
+                    camera_stream::max_buffers - handedOut : 0);
+        }
     }
 
     return res;
@@ -1000,12 +1041,38 @@ status_t Camera3OutputStream::disconnectLocked() {
         return OK;
     }
 
+    if (mBufferPrefetcher != nullptr) {
+        mBufferPrefetcher->requestExit();
+    }
+
     returnPrefetchedBuffersLocked();
+    mBufferPrefetcher.clear();
 
     if (mPreviewFrameSpacer != nullptr) {
         mPreviewFrameSpacer->requestExit();
     }
 
+    // Hand the free buffers over to the buffer manager so that a compatible stream of the next
+    // stream configuration can reuse them instead of allocating new ones.
+    if (mUseBufferManager) {
+        size_t pooledCount = 0;
+        while (true) {
+            sp<GraphicBuffer> buffer;
+            sp<Fence> fence;
+            res = mConsumer->detachNextBuffer(&buffer, &fence);
+            if (res != OK || buffer == nullptr) {
+                break;
+            }
+            int fenceFd = (fence != nullptr && fence->isValid()) ? fence->dup() : -1;
+            if (mBufferManager->returnBufferToPool(getId(), getStreamSetId(),
+                    isMultiResolution(), buffer, fenceFd) == OK) {
+                pooledCount++;
+            }
+        }
+        ALOGV("%s: stream %d returned %zu buffers to the buffer manager pool", __FUNCTION__,
+                getId(), pooledCount);
+    }
+
     ALOGV("%s: disconnecting stream %d from native window", __FUNCTION__, getId());
 
     res = native_window_api_disconnect(mConsumer.get(),
@@ -1390,6 +1457,9 @@ void Camera3OutputStream::onMinDurationChanged(nsecs_t duration, bool fixedFps)
     Mutex::Autolock l(mLock);
     mMinExpectedDuration = duration;
     mFixedFps = fixedFps;
+    if (mBufferPrefetcher != nullptr) {
+        mBufferPrefetcher->setFrameDuration(duration);
+    }
 }
 
 void Camera3OutputStream::setStreamUseCase(int64_t streamUseCase) {
@@ -1397,6 +1467,30 @@ void Camera3OutputStream::setStreamUseCase(int64_t streamUseCase) {
     camera_stream::use_case = streamUseCase;
 }
 
+std::array<int64_t, StageLatencyHistogram::BIN_COUNT>
+        Camera3OutputStream::getAndResetPreviewSpacingLatency() {
+    sp<PreviewFrameSpacer> spacer;
+    {
+        Mutex::Autolock l(mLock);
+        spacer = mPreviewFrameSpacer;
+    }
+    if (spacer == nullptr) {
+        return {};
+    }
+    return spacer->getAndResetAddedLatency();
+}
+
+nsecs_t Camera3OutputStream::getDisplayFrameInterval() {
+    ParcelableVsyncEventData parcelableVsyncEventData;
+    auto res = mDisplayEventReceiver.getLatestVsyncEventData(&parcelableVsyncEventData);
+    if (res != OK) {
+        ALOGE("%s: Stream %d: Error getting latest vsync event data: %s (%d)",
+                __FUNCTION__, mId, strerror(-res), res);
+        return 0;
+    }
+    return parcelableVsyncEventData.vsync.frameInterval;
+}
+
 void Camera3OutputStream::returnPrefetchedBuffersLocked() {
     std::vector<Surface::BatchBuffer> batchedBuffers;
 
@@ -1412,6 +1506,10 @@ void Camera3OutputStream::returnPrefetchedBuffersLocked() {
     if (batchedBuffers.size() > 0) {
         mConsumer->cancelBuffers(batchedBuffers);
     }
+
+    if (mBufferPrefetcher != nullptr) {
+        mBufferPrefetcher->cancelBuffers();
+    }
 }
 
 nsecs_t Camera3OutputStream::syncTimestampToDisplayLocked(nsecs_t t) {
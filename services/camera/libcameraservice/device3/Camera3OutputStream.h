@@ -29,6 +29,7 @@
 #include "Camera3IOStreamBase.h"
 #include "Camera3OutputStreamInterface.h"
 #include "Camera3BufferManager.h"
+#include "BufferPrefetcher.h"
 #include "PreviewFrameSpacer.h"
 
 namespace android {
@@ -257,6 +258,9 @@ class Camera3OutputStream :
      */
     virtual void setStreamUseCase(int64_t streamUseCase) override;
 
+    virtual std::array<int64_t, StageLatencyHistogram::BIN_COUNT>
+            getAndResetPreviewSpacingLatency() override;
+
     /**
      * Apply ZSL related consumer usage quirk.
      */
@@ -265,6 +269,8 @@ class Camera3OutputStream :
     void setImageDumpMask(int mask) { mImageDumpMask = mask; }
     bool shouldLogError(status_t res);
     void onCachedBufferQueued();
+    // The display refresh interval, or 0 if unknown
+    nsecs_t getDisplayFrameInterval();
 
   protected:
     Camera3OutputStream(int id, camera_stream_type_t type,
@@ -444,6 +450,12 @@ class Camera3OutputStream :
     // the same cadence as capture. Default is on for SurfaceTexture bound
     // streams.
     sp<PreviewFrameSpacer> mPreviewFrameSpacer;
+
+    // Dequeue buffers ahead of the requests for preview and video streams, as many as
+    // the recent dequeueBuffer latency calls for. Up to camera.stream_prefetch.max_buffers
+    // buffers (0 disables it), and never with batched dequeues or the buffer manager.
+    sp<BufferPrefetcher> mBufferPrefetcher;
+    static constexpr int32_t kDefaultMaxPrefetchedBuffers = 2;
 }; // class Camera3OutputStream
 
 } // namespace camera3
@@ -18,6 +18,7 @@
 #define ANDROID_SERVERS_CAMERA3_OUTPUT_STREAM_INTERFACE_H
 
 #include "Camera3StreamInterface.h"
+#include "utils/SessionStatsBuilder.h"
 #include <utils/KeyedVector.h>
 
 namespace android {
@@ -122,6 +123,13 @@ class Camera3OutputStreamInterface : public virtual Camera3StreamInterface {
      * Modify the stream use case for this output.
      */
     virtual void setStreamUseCase(int64_t streamUseCase) = 0;
+
+    /**
+     * Return the histogram of the latency added by preview frame spacing since the last
+     * call, and reset it. All counts are 0 if the stream doesn't space preview frames.
+     */
+    virtual std::array<int64_t, StageLatencyHistogram::BIN_COUNT>
+            getAndResetPreviewSpacingLatency() = 0;
 };
 
 // Helper class to organize a synchronized mapping of stream IDs to stream instances
@@ -128,6 +128,29 @@ status_t fixupMonochromeTags(
     return res;
 }
 
+// Copy result metadata from the HAL into a buffer from the result metadata pool. The buffer
+// has room for the given partial results, and the tags added by the framework, so that
+// completing the result doesn't need to grow it.
+CameraMetadata copyResultMetadata(CaptureOutputStates& states, const camera_metadata_t* result,
+        const CameraMetadata* partials = nullptr) {
+    // ANDROID_REQUEST_FRAME_COUNT, ANDROID_REQUEST_ID, and the fixed up or remapped tags
+    const size_t kExtraEntries = 8;
+    const size_t kExtraData = 64;
+
+    size_t entryCount = get_camera_metadata_entry_count(result) + kExtraEntries;
+    size_t dataCount = get_camera_metadata_data_count(result) + kExtraData;
+    if (partials != nullptr && !partials->isEmpty()) {
+        const camera_metadata_t* partialBuffer = partials->getAndLock();
+        entryCount += get_camera_metadata_entry_count(partialBuffer);
+        dataCount += get_camera_metadata_data_count(partialBuffer);
+        partials->unlock(partialBuffer);
+    }
+
+    CameraMetadata metadata(states.resultMetadataPool, entryCount, dataCount);
+    metadata.append(result);
+    return metadata;
+}
+
 void insertResultLocked(CaptureOutputStates& states, CaptureResult *result, uint32_t frameNumber) {
     if (result == nullptr) return;
 
@@ -155,9 +178,9 @@ void insertResultLocked(CaptureOutputStates& states, CaptureResult *result, uint
         physicalMetadata.mPhysicalCameraMetadata.unlock(pmeta);
     }
 
-    // Valid result, insert into queue
+    // Valid result, move into queue
     std::list<CaptureResult>::iterator queuedResult =
-            states.resultQueue.insert(states.resultQueue.end(), CaptureResult(*result));
+            states.resultQueue.insert(states.resultQueue.end(), std::move(*result));
     ALOGV("%s: result requestId = %" PRId32 ", frameNumber = %" PRId64
            ", burstId = %" PRId32, __FUNCTION__,
            queuedResult->mResultExtras.requestId,
@@ -176,7 +199,7 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
 
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
-    captureResult.mMetadata = partialResult;
+    captureResult.mMetadata = copyResultMetadata(states, partialResult);
 
     // Fix up result metadata for monochrome camera.
     status_t res = fixupMonochromeTags(states, states.deviceInfo, captureResult.mMetadata);
@@ -258,7 +281,8 @@ void sendCaptureResult(
 
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
-    captureResult.mMetadata = pendingMetadata;
+    // The pending metadata isn't needed after the result is sent
+    captureResult.mMetadata.acquire(pendingMetadata);
     captureResult.mPhysicalMetadatas = physicalMetadatas;
 
     // Append any previous partials to form a complete result
@@ -364,14 +388,17 @@ void sendCaptureResult(
         }
     }
 
-    std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
-    for (auto& m : physicalMetadatas) {
-        monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
-                CameraMetadata(m.mPhysicalCameraMetadata));
+    // Skip copying the physical metadata unless it's monitored
+    if (states.tagMonitor.isMonitoringEnabled()) {
+        std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
+        for (auto& m : physicalMetadatas) {
+            monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
+                    CameraMetadata(m.mPhysicalCameraMetadata));
+        }
+        states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
+                frameNumber, sensorTimestamp, captureResult.mMetadata,
+                monitoredPhysicalMetadata);
     }
-    states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
-            frameNumber, sensorTimestamp, captureResult.mMetadata,
-            monitoredPhysicalMetadata);
 
     insertResultLocked(states, &captureResult, frameNumber);
 }
@@ -430,7 +457,7 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx) {
             /*requested*/true, request.requestTimeNs, states.sessionStatsBuilder,
             /*timestampIncreasing*/true,
             request.outputSurfaces, request.resultExtras,
-            request.errorBufStrategy, request.transform);
+            request.errorBufStrategy, request.transform, request.shutterReceivedNs);
 
         // Note down the just completed frame number
         if (request.hasInputBuffer) {
@@ -670,11 +697,14 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                         physicalMetadata});
             }
             if (shutterTimestamp == 0) {
-                request.pendingMetadata = result->result;
-                request.collectedPartialResult = collectedPartialResult;
+                request.pendingMetadata = copyResultMetadata(states, result->result,
+                        &collectedPartialResult);
+                if (!collectedPartialResult.isEmpty()) {
+                    request.collectedPartialResult.acquire(collectedPartialResult);
+                }
             } else if (request.hasCallback) {
-                CameraMetadata metadata;
-                metadata = result->result;
+                CameraMetadata metadata = copyResultMetadata(states, result->result,
+                        &collectedPartialResult);
                 sendCaptureResult(states, metadata, request.resultExtras,
                     collectedPartialResult, frameNumber,
                     hasInputBufferInRequest, request.zslCapture && request.stillCapture,
@@ -713,7 +743,7 @@ void returnOutputBuffers(
         nsecs_t requestTimeNs, SessionStatsBuilder& sessionStatsBuilder,
         bool timestampIncreasing, const SurfaceMap& outputSurfaces,
         const CaptureResultExtras &inResultExtras,
-        ERROR_BUF_STRATEGY errorBufStrategy, int32_t transform) {
+        ERROR_BUF_STRATEGY errorBufStrategy, int32_t transform, nsecs_t shutterReceivedNs) {
 
     for (size_t i = 0; i < numBuffers; i++)
     {
@@ -748,6 +778,12 @@ void returnOutputBuffers(
 
         const auto& it = outputSurfaces.find(streamId);
         status_t res = OK;
+        nsecs_t bufferReturnLatencyNs = -1;
+        nsecs_t consumerQueueLatencyNs = -1;
+        nsecs_t bufferReturnTimeNs = systemTime();
+        if (shutterReceivedNs != 0) {
+            bufferReturnLatencyNs = bufferReturnTimeNs - shutterReceivedNs;
+        }
 
         // Do not return the buffer if the buffer status is error, and the error
         // buffer strategy is CACHE.
@@ -762,6 +798,7 @@ void returnOutputBuffers(
                         outputBuffers[i], timestamp, readoutTimestamp, timestampIncreasing,
                         std::vector<size_t> (), inResultExtras.frameNumber, transform);
             }
+            consumerQueueLatencyNs = systemTime() - bufferReturnTimeNs;
         }
         // Note: stream may be deallocated at this point, if this buffer was
         // the last reference to it.
@@ -780,7 +817,8 @@ void returnOutputBuffers(
         if (requested) {
             nsecs_t bufferTimeNs = systemTime();
             int32_t captureLatencyMs = ns2ms(bufferTimeNs - requestTimeNs);
-            sessionStatsBuilder.incCounter(streamId, dropped, captureLatencyMs);
+            sessionStatsBuilder.incCounter(streamId, dropped, captureLatencyMs,
+                    bufferReturnLatencyNs, dropped ? -1 : consumerQueueLatencyNs);
         }
 
         // Long processing consumers can cause returnBuffer timeout for shared stream
@@ -818,7 +856,7 @@ void returnAndRemovePendingOutputBuffers(bool useHalBufManager,
             request.shutterTimestamp, readoutTimestamp,
             /*requested*/true, request.requestTimeNs, sessionStatsBuilder, timestampIncreasing,
             request.outputSurfaces, request.resultExtras,
-            request.errorBufStrategy, request.transform);
+            request.errorBufStrategy, request.transform, request.shutterReceivedNs);
 
     // Remove error buffers that are not cached.
     for (auto iter = request.pendingOutputBuffers.begin();
@@ -877,6 +915,11 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
             }
 
             r.shutterTimestamp = msg.timestamp;
+            r.shutterReceivedNs = systemTime();
+            if (r.submitTimeNs != 0) {
+                states.sessionStatsBuilder.addStageLatency(LATENCY_STAGE_SHUTTER,
+                        r.shutterReceivedNs - r.submitTimeNs);
+            }
             if (msg.readout_timestamp_valid) {
                 r.resultExtras.hasReadoutTimestamp = true;
                 r.resultExtras.readoutTimestamp = msg.readout_timestamp;
@@ -58,7 +58,9 @@ namespace camera3 {
             // Used to send buffer error callback when failing to return buffer
             const CaptureResultExtras &resultExtras = CaptureResultExtras{},
             ERROR_BUF_STRATEGY errorBufStrategy = ERROR_BUF_RETURN,
-            int32_t transform = -1);
+            int32_t transform = -1,
+            // Time the shutter notification was received, used for stage latency stats
+            nsecs_t shutterReceivedNs = 0);
 
     // helper function to return the output buffers to output streams, and
     // remove the returned buffers from the inflight request's pending buffers
@@ -109,6 +111,8 @@ namespace camera3 {
         bool& isFixedFps;
         bool overrideToPortrait;
         std::string &activePhysicalId;
+        // Recycled buffers for result metadata
+        sp<CameraMetadataBufferPool> resultMetadataPool;
     };
 
     void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result);
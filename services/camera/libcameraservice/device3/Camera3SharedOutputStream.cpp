@@ -271,6 +271,15 @@ status_t Camera3SharedOutputStream::disconnectLocked() {
     return res;
 }
 
+void Camera3SharedOutputStream::dump(int fd, const Vector<String16> &args) const {
+    Camera3OutputStream::dump(fd, args);
+
+    sp<Camera3StreamSplitter> splitter = mStreamSplitter;
+    if (splitter != nullptr) {
+        splitter->dump(fd);
+    }
+}
+
 status_t Camera3SharedOutputStream::getEndpointUsage(uint64_t *usage) const {
 
     status_t res = OK;
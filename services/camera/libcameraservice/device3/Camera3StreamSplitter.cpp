@@ -142,8 +142,14 @@ void Camera3StreamSplitter::disconnect() {
     mOutputs.clear();
     mOutputSurfaces.clear();
     mOutputSlots.clear();
+    mOutputSlotIndex.clear();
     mConsumerBufferCount.clear();
 
+    for (auto& latency : mQueueBufferLatency) {
+        latency.second.log("Surface %zu queueBuffer latency histogram", latency.first);
+    }
+    mQueueBufferLatency.clear();
+
     if (mConsumer.get() != nullptr) {
         mConsumer->consumerDisconnect();
     }
@@ -159,6 +165,16 @@ void Camera3StreamSplitter::disconnect() {
     SP_LOGV("%s: Disconnected", __FUNCTION__);
 }
 
+void Camera3StreamSplitter::dump(int fd) {
+    Mutex::Autolock lock(mMutex);
+
+    for (const auto& latency : mQueueBufferLatency) {
+        String8 name = String8::format("      Surface %zu queueBuffer latency histogram:",
+                latency.first);
+        latency.second.dump(fd, name.string());
+    }
+}
+
 Camera3StreamSplitter::Camera3StreamSplitter(bool useHalBufManager) :
         mUseHalBufManager(useHalBufManager) {}
 
@@ -271,6 +287,9 @@ status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surfa
     }
     mNotifiers[gbp] = listener;
     mOutputSlots[gbp] = std::make_unique<OutputSlots>(totalBufferCount);
+    mOutputSlotIndex[gbp].clear();
+    mQueueBufferLatency.erase(surfaceId);
+    mQueueBufferLatency.emplace(surfaceId, CameraLatencyHistogram(kQueueLatencyBinSize));
 
     mMaxConsumerBuffers += maxConsumerBuffers;
     return NO_ERROR;
@@ -324,6 +343,12 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     mOutputs[surfaceId] = nullptr;
     mOutputSurfaces[surfaceId] = nullptr;
     mOutputSlots[gbp] = nullptr;
+    mOutputSlotIndex.erase(gbp);
+    auto latency = mQueueBufferLatency.find(surfaceId);
+    if (latency != mQueueBufferLatency.end()) {
+        latency->second.log("Surface %zu queueBuffer latency histogram", surfaceId);
+        mQueueBufferLatency.erase(latency);
+    }
     for (const auto &id : pendingBufferIds) {
         decrementBufRefCountLocked(id, surfaceId);
     }
@@ -347,62 +372,96 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     return res;
 }
 
-status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-        const BufferItem& bufferItem, size_t surfaceId) {
+status_t Camera3StreamSplitter::outputBuffersLocked(const BufferItem& bufferItem,
+        const std::vector<size_t>& surfaceIds) {
     ATRACE_CALL();
-    status_t res;
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
             bufferItem.mDataSpace, bufferItem.mCrop,
             static_cast<int32_t>(bufferItem.mScalingMode),
             bufferItem.mTransform, bufferItem.mFence);
 
-    IGraphicBufferProducer::QueueBufferOutput queueOutput;
+    struct PendingQueue {
+        size_t surfaceId;
+        sp<IGraphicBufferProducer> output;
+        int slot;
+        IGraphicBufferProducer::QueueBufferOutput queueOutput;
+        status_t res;
+        nsecs_t startTime;
+        nsecs_t endTime;
+    };
+    std::vector<PendingQueue> pendingQueues;
+    pendingQueues.reserve(surfaceIds.size());
 
     uint64_t bufferId = bufferItem.mGraphicBuffer->getId();
     const BufferTracker& tracker = *(mBuffers[bufferId]);
-    int slot = getSlotForOutputLocked(output, tracker.getBuffer());
+    for (const auto surfaceId : surfaceIds) {
+        sp<IGraphicBufferProducer> output = mOutputs[surfaceId];
+        if (output == nullptr) {
+            //Output surface got likely removed by client.
+            continue;
+        }
+        int slot = getSlotForOutputLocked(output, tracker.getBuffer());
 
-    if (mOutputSurfaces[surfaceId] != nullptr) {
-        sp<ANativeWindow> anw = mOutputSurfaces[surfaceId];
-        camera3::Camera3Stream::queueHDRMetadata(
-                bufferItem.mGraphicBuffer->getNativeBuffer()->handle, anw, mDynamicRangeProfile);
-    } else {
-        SP_LOGE("%s: Invalid surface id: %zu!", __FUNCTION__, surfaceId);
+        if (mOutputSurfaces[surfaceId] != nullptr) {
+            sp<ANativeWindow> anw = mOutputSurfaces[surfaceId];
+            camera3::Camera3Stream::queueHDRMetadata(
+                    bufferItem.mGraphicBuffer->getNativeBuffer()->handle, anw,
+                    mDynamicRangeProfile);
+        } else {
+            SP_LOGE("%s: Invalid surface id: %zu!", __FUNCTION__, surfaceId);
+        }
+
+        pendingQueues.push_back({surfaceId, output, slot, {}, OK, 0, 0});
     }
 
     // In case the output BufferQueue has its own lock, if we hold splitter lock while calling
     // queueBuffer (which will try to acquire the output lock), the output could be holding its
     // own lock calling releaseBuffer (which  will try to acquire the splitter lock), running into
-    // circular lock situation.
+    // circular lock situation. Release the lock once for all outputs rather than per output.
     mMutex.unlock();
-    res = output->queueBuffer(slot, queueInput, &queueOutput);
+    for (auto& pending : pendingQueues) {
+        pending.startTime = systemTime();
+        pending.res = pending.output->queueBuffer(pending.slot, queueInput,
+                &pending.queueOutput);
+        pending.endTime = systemTime();
+    }
     mMutex.lock();
 
-    SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
-            __FUNCTION__, output.get(), slot, res);
-    //During buffer queue 'mMutex' is not held which makes the removal of
-    //"output" possible. Check whether this is the case and return.
-    if (mOutputSlots[output] == nullptr) {
-        return res;
-    }
-    if (res != OK) {
-        if (res != NO_INIT && res != DEAD_OBJECT) {
-            SP_LOGE("Queuing buffer to output failed (%d)", res);
+    status_t res = OK;
+    for (const auto& pending : pendingQueues) {
+        SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
+                __FUNCTION__, pending.output.get(), pending.slot, pending.res);
+        //During buffer queue 'mMutex' is not held which makes the removal of
+        //"output" possible. Check whether this is the case and skip it.
+        if (mOutputSlots[pending.output] == nullptr) {
+            continue;
         }
-        // If we just discovered that this output has been abandoned, note
-        // that, increment the release count so that we still release this
-        // buffer eventually, and move on to the next output
-        onAbandonedLocked();
-        decrementBufRefCountLocked(bufferItem.mGraphicBuffer->getId(), surfaceId);
-        return res;
-    }
 
-    // If the queued buffer replaces a pending buffer in the async
-    // queue, no onBufferReleased is called by the buffer queue.
-    // Proactively trigger the callback to avoid buffer loss.
-    if (queueOutput.bufferReplaced) {
-        onBufferReplacedLocked(output, surfaceId);
+        auto latency = mQueueBufferLatency.find(pending.surfaceId);
+        if (latency != mQueueBufferLatency.end()) {
+            latency->second.add(pending.startTime, pending.endTime);
+        }
+
+        if (pending.res != OK) {
+            if (pending.res != NO_INIT && pending.res != DEAD_OBJECT) {
+                SP_LOGE("Queuing buffer to output failed (%d)", pending.res);
+            }
+            // If we just discovered that this output has been abandoned, note
+            // that, increment the release count so that we still release this
+            // buffer eventually, and move on to the next output
+            onAbandonedLocked();
+            decrementBufRefCountLocked(bufferId, pending.surfaceId);
+            res = pending.res;
+            continue;
+        }
+
+        // If the queued buffer replaces a pending buffer in the async
+        // queue, no onBufferReleased is called by the buffer queue.
+        // Proactively trigger the callback to avoid buffer loss.
+        if (pending.queueOutput.bufferReplaced) {
+            onBufferReplacedLocked(pending.output, pending.surfaceId);
+        }
     }
 
     return res;
@@ -438,6 +497,13 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
     // Initialize buffer tracker for this input buffer
     auto tracker = std::make_unique<BufferTracker>(gb, surface_ids);
 
+    struct PendingAttach {
+        size_t surfaceId;
+        sp<IGraphicBufferProducer> gbp;
+        int slot;
+        status_t res;
+    };
+    std::vector<PendingAttach> pendingAttaches;
     for (auto& surface_id : surface_ids) {
         sp<IGraphicBufferProducer>& gbp = mOutputs[surface_id];
         if (gbp.get() == nullptr) {
@@ -449,42 +515,63 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
             //Buffer is already attached to this output surface.
             continue;
         }
+        pendingAttaches.push_back({surface_id, gbp, BufferItem::INVALID_BUFFER_SLOT, OK});
+    }
+
+    if (!pendingAttaches.empty()) {
         //Temporarly Unlock the mutex when trying to attachBuffer to the output
-        //queue, because attachBuffer could block in case of a slow consumer. If
+        //queues, because attachBuffer could block in case of a slow consumer. If
         //we block while holding the lock, onFrameAvailable and onBufferReleased
-        //will block as well because they need to acquire the same lock.
+        //will block as well because they need to acquire the same lock. All
+        //attaches are issued while unlocked so the lock is only re-acquired once.
         mMutex.unlock();
-        res = gbp->attachBuffer(&slot, gb);
+        for (auto& pending : pendingAttaches) {
+            pending.res = pending.gbp->attachBuffer(&pending.slot, gb);
+        }
         mMutex.lock();
-        if (res != OK) {
+    }
+
+    for (const auto& pending : pendingAttaches) {
+        if (pending.res != OK) {
             SP_LOGE("%s: Cannot attachBuffer from GraphicBufferProducer %p: %s (%d)",
-                    __FUNCTION__, gbp.get(), strerror(-res), res);
+                    __FUNCTION__, pending.gbp.get(), strerror(-pending.res), pending.res);
             // TODO: might need to detach/cleanup the already attached buffers before return?
-            return res;
+            res = pending.res;
+            continue;
         }
-        if ((slot < 0) || (slot > BufferQueue::NUM_BUFFER_SLOTS)) {
+        if ((pending.slot < 0) || (pending.slot > BufferQueue::NUM_BUFFER_SLOTS)) {
             SP_LOGE("%s: Slot received %d either bigger than expected maximum %d or negative!",
-                    __FUNCTION__, slot, BufferQueue::NUM_BUFFER_SLOTS);
-            return BAD_VALUE;
+                    __FUNCTION__, pending.slot, BufferQueue::NUM_BUFFER_SLOTS);
+            res = BAD_VALUE;
+            continue;
         }
         //During buffer attach 'mMutex' is not held which makes the removal of
         //"gbp" possible. Check whether this is the case and continue.
-        if (mOutputSlots[gbp] == nullptr) {
+        if (mOutputSlots[pending.gbp] == nullptr) {
             continue;
         }
-        auto& outputSlots = *mOutputSlots[gbp];
-        if (static_cast<size_t> (slot + 1) > outputSlots.size()) {
-            outputSlots.resize(slot + 1);
+        auto& outputSlots = *mOutputSlots[pending.gbp];
+        if (static_cast<size_t> (pending.slot + 1) > outputSlots.size()) {
+            outputSlots.resize(pending.slot + 1);
         }
-        if (outputSlots[slot] != nullptr) {
+        if (outputSlots[pending.slot] != nullptr) {
             // If the buffer is attached to a slot which already contains a buffer,
             // the previous buffer will be removed from the output queue. Decrement
             // the reference count accordingly.
-            decrementBufRefCountLocked(outputSlots[slot]->getId(), surface_id);
+            decrementBufRefCountLocked(outputSlots[pending.slot]->getId(), pending.surfaceId);
+            //The mutex may have been temporarily released while returning the
+            //previous buffer to the input, check again whether "gbp" got removed.
+            if (mOutputSlots[pending.gbp] == nullptr) {
+                continue;
+            }
         }
         SP_LOGV("%s: Attached buffer %p to slot %d on output %p.",__FUNCTION__, gb.get(),
-                slot, gbp.get());
-        outputSlots[slot] = gb;
+                pending.slot, pending.gbp.get());
+        setOutputSlotLocked(pending.gbp, pending.slot, gb);
+    }
+
+    if (res != OK) {
+        return res;
     }
 
     mBuffers[bufferId] = std::move(tracker);
@@ -538,21 +625,11 @@ void Camera3StreamSplitter::onFrameAvailable(const BufferItem& /*item*/) {
 
     SP_LOGV("%s: BufferTracker for buffer %" PRId64 ", number of requests %zu",
            __FUNCTION__, bufferItem.mGraphicBuffer->getId(), tracker.requestedSurfaces().size());
-    for (const auto id : tracker.requestedSurfaces()) {
-
-        if (mOutputs[id] == nullptr) {
-            //Output surface got likely removed by client.
-            continue;
-        }
-
-        res = outputBufferLocked(mOutputs[id], bufferItem, id);
-        if (res != OK) {
-            SP_LOGE("%s: outputBufferLocked failed %d", __FUNCTION__, res);
-            mOnFrameAvailableRes.store(res);
-            // If we fail to send buffer to certain output, keep sending to
-            // other outputs.
-            continue;
-        }
+    // If we fail to send buffer to certain output, keep sending to other
+    // outputs.
+    res = outputBuffersLocked(bufferItem, tracker.requestedSurfaces());
+    if (res != OK) {
+        SP_LOGE("%s: outputBuffersLocked failed %d", __FUNCTION__, res);
     }
 
     mOnFrameAvailableRes.store(res);
@@ -698,7 +775,7 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
         return;
     }
 
-    auto outputSlots = *mOutputSlots[from];
+    auto& outputSlots = *mOutputSlots[from];
     buffer = outputSlots[slot];
     BufferTracker& tracker = *(mBuffers[buffer->getId()]);
     // Merge the release fence of the incoming buffer so that the fence we send
@@ -712,7 +789,7 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
     if (detach) {
         auto res = from->detachBuffer(slot);
         if (res == NO_ERROR) {
-            outputSlots[slot] = nullptr;
+            setOutputSlotLocked(from, slot, nullptr);
         } else {
             SP_LOGE("%s: detach buffer from output failed (%d)", __FUNCTION__, res);
         }
@@ -758,11 +835,11 @@ void Camera3StreamSplitter::onAbandonedLocked() {
 
 int Camera3StreamSplitter::getSlotForOutputLocked(const sp<IGraphicBufferProducer>& gbp,
         const sp<GraphicBuffer>& gb) {
-    auto& outputSlots = *mOutputSlots[gbp];
-
-    for (size_t i = 0; i < outputSlots.size(); i++) {
-        if (outputSlots[i] == gb) {
-            return (int)i;
+    auto slotIndex = mOutputSlotIndex.find(gbp);
+    if (slotIndex != mOutputSlotIndex.end()) {
+        auto slot = slotIndex->second.find(gb->getId());
+        if (slot != slotIndex->second.end()) {
+            return slot->second;
         }
     }
 
@@ -771,6 +848,19 @@ int Camera3StreamSplitter::getSlotForOutputLocked(const sp<IGraphicBufferProduce
     return BufferItem::INVALID_BUFFER_SLOT;
 }
 
+void Camera3StreamSplitter::setOutputSlotLocked(const sp<IGraphicBufferProducer>& gbp, int slot,
+        const sp<GraphicBuffer>& gb) {
+    auto& outputSlots = *mOutputSlots[gbp];
+    auto& slotIndex = mOutputSlotIndex[gbp];
+    if (outputSlots[slot] != nullptr) {
+        slotIndex.erase(outputSlots[slot]->getId());
+    }
+    outputSlots[slot] = gb;
+    if (gb != nullptr) {
+        slotIndex[gb->getId()] = slot;
+    }
+}
+
 Camera3StreamSplitter::OutputListener::OutputListener(
         wp<Camera3StreamSplitter> splitter,
         wp<IGraphicBufferProducer> output)
@@ -30,6 +30,8 @@
 #include <utils/StrongPointer.h>
 #include <utils/Timers.h>
 
+#include "utils/LatencyHistogram.h"
+
 #define SP_LOGV(x, ...) ALOGV("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
 #define SP_LOGI(x, ...) ALOGI("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
 #define SP_LOGW(x, ...) ALOGW("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
@@ -82,7 +84,9 @@ public:
     status_t notifyBufferReleased(const sp<GraphicBuffer>& buffer);
 
     // Attach a buffer to the specified outputs. This call reserves a buffer
-    // slot in the output queue.
+    // slot in the output queue. Outputs which already hold the buffer in one of
+    // their slots are skipped, and all remaining attaches are issued in one
+    // pass without re-acquiring the splitter lock in between.
     status_t attachBufferToOutputs(ANativeWindowBuffer* anb,
             const std::vector<size_t>& surface_ids);
 
@@ -94,6 +98,9 @@ public:
     // Disconnect the buffer queue from output surfaces.
     void disconnect();
 
+    // Dump the per-output queueBuffer latency histograms.
+    void dump(int fd);
+
 private:
     // From IConsumerListener
     //
@@ -215,11 +222,13 @@ private:
 
     status_t removeOutputLocked(size_t surfaceId);
 
-    // Send a buffer to particular output, and increment the reference count
-    // of the buffer. If this output is abandoned, the buffer's reference count
-    // won't be incremented.
-    status_t outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-            const BufferItem& bufferItem, size_t surfaceId);
+    // Send a buffer to the given outputs. All queueBuffer calls are issued in
+    // one pass with the splitter lock released. If an output is abandoned, the
+    // buffer's reference count for that output is decremented right away.
+    // Returns the last error encountered, or OK if the buffer got queued to
+    // all outputs.
+    status_t outputBuffersLocked(const BufferItem& bufferItem,
+            const std::vector<size_t>& surfaceIds);
 
     // Get unique name for the buffer queue consumer
     String8 getUniqueConsumerName();
@@ -228,6 +237,10 @@ private:
     int getSlotForOutputLocked(const sp<IGraphicBufferProducer>& gbp,
             const sp<GraphicBuffer>& gb);
 
+    // Update the slot of an output, keeping the buffer id -> slot index in sync.
+    void setOutputSlotLocked(const sp<IGraphicBufferProducer>& gbp, int slot,
+            const sp<GraphicBuffer>& gb);
+
     // Sum of max consumer buffers for all outputs
     size_t mMaxConsumerBuffers = 0;
     size_t mMaxHalBuffers = 0;
@@ -279,6 +292,16 @@ private:
     std::unordered_map<sp<IGraphicBufferProducer>, std::unique_ptr<OutputSlots>,
             GBPHash> mOutputSlots;
 
+    // Persistent graphic buffer id -> slot mapping of each output. Buffers stay
+    // attached to an output slot after being released by the consumer, so a
+    // buffer that cycles back only needs a lookup here instead of a new attach.
+    typedef std::unordered_map<uint64_t, int> OutputSlotIndex;
+    std::unordered_map<sp<IGraphicBufferProducer>, OutputSlotIndex, GBPHash> mOutputSlotIndex;
+
+    // Map surface ids -> latency of queueing a buffer to that output
+    static const int32_t kQueueLatencyBinSize = 1; // in ms
+    std::unordered_map<size_t, CameraLatencyHistogram> mQueueBufferLatency;
+
     //A set of buffers that could potentially stay in some of the outputs after removal
     //and therefore should be detached from the input queue.
     std::unordered_set<uint64_t> mDetachedBuffers;
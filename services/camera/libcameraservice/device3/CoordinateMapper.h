@@ -17,9 +17,12 @@
 #ifndef ANDROID_SERVERS_COORDINATEMAPPER_H
 #define ANDROID_SERVERS_COORDINATEMAPPER_H
 
+#include <algorithm>
 #include <array>
 #include <set>
 
+#include <utils/Errors.h>
+
 namespace android {
 
 namespace camera3 {
@@ -48,6 +51,91 @@ protected:
     virtual void initRemappedKeys() = 0;
     std::set<uint32_t> mRemappedKeys;
 
+    // Number of (x, y) pairs transformed per call by the batched helpers below
+    static constexpr size_t kCoordBatchSize = 32;
+
+    /**
+     * Apply a batched (x, y) transform to the corners of all metering regions
+     * (xmin, ymin, xmax, ymax, weight) with a non-zero weight. The corners are gathered into
+     * batches so that the transform runs over contiguous arrays instead of once per region.
+     *
+     *   regions: the metering regions, transformed in-place
+     *   count: number of int32_t values in regions
+     *   maxCornerOffset: subtracted from the max corner before the transform and added back
+     *       after it, e.g. 1 to transform the exclusive max corner as an inclusive pixel
+     *   transform: status_t(int32_t* coordPairs, int coordCount)
+     */
+    template<typename Transform>
+    static status_t transformMeteringRegions(int32_t* regions, size_t count,
+            int32_t maxCornerOffset, Transform&& transform) {
+        std::array<int32_t, kCoordBatchSize * 2> coords;
+        std::array<size_t, kCoordBatchSize / 2> regionIdx;
+        size_t j = 0;
+        while (j + 5 <= count) {
+            size_t regionCount = 0;
+            for (; j + 5 <= count && regionCount < regionIdx.size(); j += 5) {
+                if (regions[j + 4] == 0) {
+                    continue;
+                }
+                int32_t* c = coords.data() + regionCount * 4;
+                c[0] = regions[j];
+                c[1] = regions[j + 1];
+                c[2] = regions[j + 2] - maxCornerOffset;
+                c[3] = regions[j + 3] - maxCornerOffset;
+                regionIdx[regionCount++] = j;
+            }
+            if (regionCount == 0) {
+                break;
+            }
+            status_t res = transform(coords.data(), static_cast<int>(regionCount * 2));
+            if (res != OK) return res;
+            for (size_t i = 0; i < regionCount; i++) {
+                const int32_t* c = coords.data() + i * 4;
+                int32_t* region = regions + regionIdx[i];
+                region[0] = c[0];
+                region[1] = c[1];
+                region[2] = c[2] + maxCornerOffset;
+                region[3] = c[3] + maxCornerOffset;
+            }
+        }
+        return OK;
+    }
+
+    /**
+     * Apply a batched (x, y) transform to the corners of (left, top, width, height)
+     * rectangles. The corners are transformed as inclusive pixels.
+     *
+     *   rects: the rectangles, transformed in-place
+     *   rectCount: number of rectangles
+     *   transform: status_t(int32_t* coordPairs, int coordCount)
+     */
+    template<typename Transform>
+    static status_t transformRects(int32_t* rects, int rectCount, Transform&& transform) {
+        std::array<int32_t, kCoordBatchSize * 2> coords;
+        const int batchRects = kCoordBatchSize / 2;
+        for (int first = 0; first < rectCount; first += batchRects) {
+            int n = std::min(batchRects, rectCount - first);
+            int32_t* r = rects + first * 4;
+            // Map from (l, t, width, height) to (l, t, r, b)
+            for (int i = 0; i < n * 4; i += 4) {
+                coords[i] = r[i];
+                coords[i + 1] = r[i + 1];
+                coords[i + 2] = r[i] + r[i + 2] - 1;
+                coords[i + 3] = r[i + 1] + r[i + 3] - 1;
+            }
+            status_t res = transform(coords.data(), n * 2);
+            if (res != OK) return res;
+            // Map back to (l, t, width, height)
+            for (int i = 0; i < n * 4; i += 4) {
+                r[i] = coords[i];
+                r[i + 1] = coords[i + 1];
+                r[i + 2] = coords[i + 2] - coords[i] + 1;
+                r[i + 3] = coords[i + 3] - coords[i + 1] + 1;
+            }
+        }
+        return OK;
+    }
+
 }; // class CoordinateMapper
 
 } // namespace camera3
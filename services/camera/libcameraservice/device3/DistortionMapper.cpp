@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "device3/DistortionMapper.h"
 #include "utils/SessionConfigurationUtilsHost.h"
@@ -141,16 +142,13 @@ status_t DistortionMapper::correctCaptureRequest(CameraMetadata *request) {
     camera_metadata_entry_t e;
     e = request->find(ANDROID_DISTORTION_CORRECTION_MODE);
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
+        auto mapToRaw = [this, mapperInfo](int32_t* coordPairs, int coordCount) {
+            return mapCorrectedToRaw(coordPairs, coordCount, mapperInfo, /*clamp*/true);
+        };
         for (auto region : kMeteringRegionsToCorrect) {
             e = request->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapCorrectedToRaw(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
+            res = transformMeteringRegions(e.data.i32, e.count, /*maxCornerOffset*/0, mapToRaw);
+            if (res != OK) return res;
         }
         for (auto rect : kRectsToCorrect) {
             e = request->find(rect);
@@ -180,16 +178,14 @@ status_t DistortionMapper::correctCaptureResult(CameraMetadata *result) {
     camera_metadata_entry_t e;
     e = result->find(ANDROID_DISTORTION_CORRECTION_MODE);
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
+        auto mapToCorrected = [this, mapperInfo](int32_t* coordPairs, int coordCount) {
+            return mapRawToCorrected(coordPairs, coordCount, mapperInfo, /*clamp*/true);
+        };
         for (auto region : kMeteringRegionsToCorrect) {
             e = result->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapRawToCorrected(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
+            res = transformMeteringRegions(e.data.i32, e.count, /*maxCornerOffset*/0,
+                    mapToCorrected);
+            if (res != OK) return res;
         }
         for (auto rect : kRectsToCorrect) {
             e = result->find(rect);
@@ -278,7 +274,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -350,25 +346,15 @@ status_t DistortionMapper::mapRawToCorrectedSimple(int32_t *coordPairs, int coor
 status_t DistortionMapper::mapRawRectToCorrected(int32_t *rects, int rectCount,
        DistortionMapperInfo *mapperInfo, bool clamp, bool simple) {
     if (!mapperInfo->mValidMapping) return INVALID_OPERATION;
-    for (int i = 0; i < rectCount * 4; i += 4) {
-        // Map from (l, t, width, height) to (l, t, r, b)
-        int32_t coords[4] = {
-            rects[i],
-            rects[i + 1],
-            rects[i] + rects[i + 2] - 1,
-            rects[i + 1] + rects[i + 3] - 1
-        };
-
-        mapRawToCorrected(coords, 2, mapperInfo, clamp, simple);
 
-        // Map back to (l, t, width, height)
-        rects[i] = coords[0];
-        rects[i + 1] = coords[1];
-        rects[i + 2] = coords[2] - coords[0] + 1;
-        rects[i + 3] = coords[3] - coords[1] + 1;
-    }
-
-    return OK;
+    // Corners that can't be mapped are left as they are, without affecting the other corners
+    return transformRects(rects, rectCount,
+            [&](int32_t* coordPairs, int coordCount) {
+                for (int i = 0; i < coordCount * 2; i += 2) {
+                    mapRawToCorrected(coordPairs + i, 1, mapperInfo, clamp, simple);
+                }
+                return OK;
+            });
 }
 
 status_t DistortionMapper::mapCorrectedToRaw(int32_t *coordPairs, int coordCount,
@@ -437,25 +423,11 @@ status_t DistortionMapper::mapCorrectedRectToRaw(int32_t *rects, int rectCount,
        const DistortionMapperInfo *mapperInfo, bool clamp, bool simple) const {
     if (!mapperInfo->mValidMapping) return INVALID_OPERATION;
 
-    for (int i = 0; i < rectCount * 4; i += 4) {
-        // Map from (l, t, width, height) to (l, t, r, b)
-        int32_t coords[4] = {
-            rects[i],
-            rects[i + 1],
-            rects[i] + rects[i + 2] - 1,
-            rects[i + 1] + rects[i + 3] - 1
-        };
-
-        mapCorrectedToRaw(coords, 2, mapperInfo, clamp, simple);
-
-        // Map back to (l, t, width, height)
-        rects[i] = coords[0];
-        rects[i + 1] = coords[1];
-        rects[i + 2] = coords[2] - coords[0] + 1;
-        rects[i + 3] = coords[3] - coords[1] + 1;
-    }
-
-    return OK;
+    return transformRects(rects, rectCount,
+            [&](int32_t* coordPairs, int coordCount) {
+                mapCorrectedToRaw(coordPairs, coordCount, mapperInfo, clamp, simple);
+                return OK;
+            });
 }
 
 status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
@@ -488,47 +460,142 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    buildQuadLookup(mapperInfo);
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+void DistortionMapper::buildQuadLookup(DistortionMapperInfo *mapperInfo) {
+    const std::vector<GridQuad>& grid = mapperInfo->mDistortedGrid;
+
+    // Bounding box of each distorted quad, and of the whole grid
+    std::vector<std::array<float, 4>> bounds(grid.size());
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < grid.size(); i++) {
+        const auto& c = grid[i].coords;
+        bounds[i] = {
+            std::min({c[0], c[2], c[4], c[6]}), std::min({c[1], c[3], c[5], c[7]}),
+            std::max({c[0], c[2], c[4], c[6]}), std::max({c[1], c[3], c[5], c[7]})
+        };
+        minX = std::min(minX, bounds[i][0]);
+        minY = std::min(minY, bounds[i][1]);
+        maxX = std::max(maxX, bounds[i][2]);
+        maxY = std::max(maxY, bounds[i][3]);
+    }
+
+    mapperInfo->mLookupMinX = minX;
+    mapperInfo->mLookupMinY = minY;
+    mapperInfo->mLookupMaxX = maxX;
+    mapperInfo->mLookupMaxY = maxY;
+    mapperInfo->mLookupInvCellWidth = kLookupSize / std::max(maxX - minX, kFloatFuzz);
+    mapperInfo->mLookupInvCellHeight = kLookupSize / std::max(maxY - minY, kFloatFuzz);
+
+    // Register every quad in all the cells its bounding box overlaps, in grid order, so that
+    // the first enclosing candidate of a cell is also the first enclosing quad of the grid.
+    std::vector<std::vector<uint16_t>> cells(kLookupSize * kLookupSize);
+    for (size_t i = 0; i < grid.size(); i++) {
+        size_t x0 = getLookupCell(bounds[i][0], minX, mapperInfo->mLookupInvCellWidth);
+        size_t y0 = getLookupCell(bounds[i][1], minY, mapperInfo->mLookupInvCellHeight);
+        size_t x1 = getLookupCell(bounds[i][2], minX, mapperInfo->mLookupInvCellWidth);
+        size_t y1 = getLookupCell(bounds[i][3], minY, mapperInfo->mLookupInvCellHeight);
+        for (size_t y = y0; y <= y1; y++) {
+            for (size_t x = x0; x <= x1; x++) {
+                cells[y * kLookupSize + x].push_back(static_cast<uint16_t>(i));
+            }
+        }
+    }
+
+    mapperInfo->mLookupOffsets.resize(cells.size() + 1);
+    mapperInfo->mLookupQuads.clear();
+    for (size_t i = 0; i < cells.size(); i++) {
+        mapperInfo->mLookupOffsets[i] = mapperInfo->mLookupQuads.size();
+        mapperInfo->mLookupQuads.insert(mapperInfo->mLookupQuads.end(),
+                cells[i].begin(), cells[i].end());
+    }
+    mapperInfo->mLookupOffsets[cells.size()] = mapperInfo->mLookupQuads.size();
+}
+
+size_t DistortionMapper::getLookupCell(float coord, float min, float invCellSize) {
+    float cell = (coord - min) * invCellSize;
+    if (!(cell > 0)) return 0;
+    return std::min(static_cast<size_t>(cell), kLookupSize - 1);
+}
+
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    const std::vector<GridQuad>& grid = mapperInfo.mDistortedGrid;
+    if (mapperInfo.mLookupOffsets.size() != kLookupSize * kLookupSize + 1) {
+        return findEnclosingQuad(pt, grid);
+    }
+
+    const float x = pt[0];
+    const float y = pt[1];
+    // Outside of the bounding box of all quads
+    if (x < mapperInfo.mLookupMinX || x > mapperInfo.mLookupMaxX ||
+            y < mapperInfo.mLookupMinY || y > mapperInfo.mLookupMaxY) {
+        return nullptr;
+    }
+
+    size_t cellX = getLookupCell(x, mapperInfo.mLookupMinX, mapperInfo.mLookupInvCellWidth);
+    size_t cellY = getLookupCell(y, mapperInfo.mLookupMinY, mapperInfo.mLookupInvCellHeight);
+    size_t cell = cellY * kLookupSize + cellX;
+    for (size_t i = mapperInfo.mLookupOffsets[cell]; i < mapperInfo.mLookupOffsets[cell + 1];
+            i++) {
+        const GridQuad& quad = grid[mapperInfo.mLookupQuads[i]];
+        if (isInsideQuad(x, y, quad)) {
+            return &quad;
+        }
+    }
+    return nullptr;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (isInsideQuad(x, y, quad)) {
+            return &quad;
+        }
     }
     return nullptr;
 }
 
+bool DistortionMapper::isInsideQuad(float x, float y, const GridQuad& quad) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 float DistortionMapper::calculateUorV(const int32_t pt[2], const GridQuad& quad, bool calculateU) {
     const float x = pt[0];
     const float y = pt[1];
@@ -155,12 +155,25 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Uniform lookup grid over the bounding box of mDistortedGrid. Cell i lists the
+        // indices of the distorted quads overlapping it, in mLookupQuads[mLookupOffsets[i]]
+        // to mLookupQuads[mLookupOffsets[i + 1]].
+        float mLookupMinX, mLookupMinY, mLookupMaxX, mLookupMaxY;
+        float mLookupInvCellWidth, mLookupInvCellHeight;
+        std::vector<uint32_t> mLookupOffsets;
+        std::vector<uint16_t> mLookupQuads;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Same as above for the distorted grid, only testing the quads of the lookup cell that
+    // contains the point. Returns the same quad as a search through the whole grid.
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -188,6 +201,8 @@ class DistortionMapper : public CoordinateMapper {
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
     constexpr static float kFloatFuzz = 1e-4;
+    // Number of cells in each dimension of the distorted quad lookup grid
+    constexpr static size_t kLookupSize = 16;
 
     bool mMaxResolution = false;
 
@@ -209,6 +224,15 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Bin the distorted grid quads into the lookup grid
+    static void buildQuadLookup(DistortionMapperInfo *mapperInfo);
+
+    // Lookup grid cell of a coordinate, clamped to the grid
+    static size_t getLookupCell(float coord, float min, float invCellSize);
+
+    // Point-in-quad test, for quads with clockwise corners
+    static bool isInsideQuad(float x, float y, const GridQuad& quad);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
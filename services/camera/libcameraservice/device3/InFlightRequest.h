@@ -17,10 +17,15 @@
 #ifndef ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
+#include <algorithm>
+#include <map>
+#include <optional>
 #include <set>
+#include <vector>
 
 #include <camera/CaptureResult.h>
 #include <camera/CameraMetadata.h>
+#include <utils/Errors.h>
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
@@ -188,6 +193,12 @@ struct InFlightRequest {
     // Time of capture request (from systemTime) in Ns
     nsecs_t requestTimeNs;
 
+    // Time the request was registered for submission to the HAL (from systemTime) in Ns
+    nsecs_t submitTimeNs;
+
+    // Time the shutter notification was received (from systemTime) in Ns
+    nsecs_t shutterReceivedNs;
+
     // What shared surfaces an output should go to
     SurfaceMap outputSurfaces;
 
@@ -215,6 +226,8 @@ struct InFlightRequest {
             zslCapture(false),
             rotateAndCropAuto(false),
             requestTimeNs(0),
+            submitTimeNs(0),
+            shutterReceivedNs(0),
             transform(-1) {
     }
 
@@ -242,13 +255,179 @@ struct InFlightRequest {
             rotateAndCropAuto(rotateAndCropAuto),
             cameraIdsWithZoom(idsWithZoom),
             requestTimeNs(requestNs),
+            submitTimeNs(0),
+            shutterReceivedNs(0),
             outputSurfaces(outSurfaces),
             transform(-1) {
     }
 };
 
-// Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+// Map from frame number to the in-flight request state.
+//
+// Frame numbers in flight are close to each other, so requests are stored in a ring of slots
+// indexed by frame number, and lookups by frame number don't need to search. Entries are never
+// moved on insertion or removal; only a sorted list of frame numbers is kept to iterate in frame
+// order. The index based accessors follow KeyedVector semantics: index i refers to the i-th
+// smallest frame number in flight.
+//
+// The ring grows when two frame numbers in flight map to the same slot, up to kMaxCapacity.
+// Past that (e.g. one request stuck in the HAL for a long time), colliding requests are kept in
+// an ordered overflow map instead.
+//
+// The map also keeps track of the in-flight latency, from registration to removal of each
+// request, for dumpsys.
+class InFlightRequestMap {
+  public:
+    static constexpr size_t kDefaultCapacity = 64;
+    static constexpr size_t kMaxCapacity = 1024;
+
+    explicit InFlightRequestMap(size_t capacity = kDefaultCapacity) :
+            mSlots(roundUpToPowerOfTwo(std::min(capacity, kMaxCapacity))) {}
+
+    size_t size() const { return mKeys.size(); }
+    bool isEmpty() const { return mKeys.empty(); }
+
+    ssize_t indexOfKey(uint32_t frameNumber) const {
+        if (find(frameNumber) == nullptr) {
+            return NAME_NOT_FOUND;
+        }
+        // Results mostly complete in order, so the oldest request is the common case.
+        if (mKeys.front() == frameNumber) {
+            return 0;
+        }
+        return std::lower_bound(mKeys.begin(), mKeys.end(), frameNumber) - mKeys.begin();
+    }
+
+    uint32_t keyAt(size_t index) const { return mKeys[index]; }
+
+    const InFlightRequest& valueAt(size_t index) const {
+        return *find(mKeys[index])->request;
+    }
+
+    InFlightRequest& editValueAt(size_t index) {
+        return *find(mKeys[index])->request;
+    }
+
+    // Returns the index of the new entry, or ALREADY_EXISTS if the frame number is in flight.
+    ssize_t add(uint32_t frameNumber, const InFlightRequest& request) {
+        if (find(frameNumber) != nullptr) {
+            return ALREADY_EXISTS;
+        }
+        while (slotFor(frameNumber).request.has_value() && mSlots.size() < kMaxCapacity) {
+            grow();
+        }
+        Slot* slot = &slotFor(frameNumber);
+        if (slot->request.has_value()) {
+            slot = &mOverflow[frameNumber];
+        }
+        slot->frameNumber = frameNumber;
+        slot->registeredNs = systemTime();
+        slot->request.emplace(request);
+
+        // Frame numbers are normally registered in increasing order.
+        auto it = mKeys.end();
+        if (!mKeys.empty() && mKeys.back() > frameNumber) {
+            it = std::lower_bound(mKeys.begin(), mKeys.end(), frameNumber);
+        }
+        it = mKeys.insert(it, frameNumber);
+        return it - mKeys.begin();
+    }
+
+    ssize_t removeItemsAt(size_t index, size_t count = 1) {
+        if (index + count > mKeys.size()) {
+            return BAD_INDEX;
+        }
+        nsecs_t now = systemTime();
+        for (size_t i = index; i < index + count; i++) {
+            Slot* slot = find(mKeys[i]);
+            nsecs_t latency = now - slot->registeredNs;
+            mLatencyCount++;
+            mLatencyTotalNs += latency;
+            mLatencyMaxNs = std::max(mLatencyMaxNs, latency);
+            if (slot == &slotFor(mKeys[i])) {
+                slot->request.reset();
+            } else {
+                mOverflow.erase(mKeys[i]);
+            }
+        }
+        mKeys.erase(mKeys.begin() + index, mKeys.begin() + index + count);
+        return index;
+    }
+
+    void clear() {
+        for (uint32_t frameNumber : mKeys) {
+            Slot& slot = slotFor(frameNumber);
+            if (slot.frameNumber == frameNumber) {
+                slot.request.reset();
+            }
+        }
+        mOverflow.clear();
+        mKeys.clear();
+    }
+
+    // In-flight latency of the requests removed so far. Requests dropped by clear() are not
+    // accounted for.
+    size_t getLatencyCount() const { return mLatencyCount; }
+    nsecs_t getAverageLatencyNs() const {
+        return mLatencyCount == 0 ? 0 : mLatencyTotalNs / static_cast<nsecs_t>(mLatencyCount);
+    }
+    nsecs_t getMaxLatencyNs() const { return mLatencyMaxNs; }
+
+  private:
+    struct Slot {
+        uint32_t frameNumber = 0;
+        nsecs_t registeredNs = 0;
+        std::optional<InFlightRequest> request;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    Slot& slotFor(uint32_t frameNumber) {
+        return mSlots[frameNumber & (mSlots.size() - 1)];
+    }
+    const Slot& slotFor(uint32_t frameNumber) const {
+        return mSlots[frameNumber & (mSlots.size() - 1)];
+    }
+
+    const Slot* find(uint32_t frameNumber) const {
+        const Slot& slot = slotFor(frameNumber);
+        if (slot.request.has_value() && slot.frameNumber == frameNumber) {
+            return &slot;
+        }
+        auto it = mOverflow.find(frameNumber);
+        return it == mOverflow.end() ? nullptr : &it->second;
+    }
+    Slot* find(uint32_t frameNumber) {
+        return const_cast<Slot*>(static_cast<const InFlightRequestMap*>(this)->find(frameNumber));
+    }
+
+    // Doubles the ring. Requests that didn't collide before can't collide after.
+    void grow() {
+        std::vector<Slot> slots(mSlots.size() * 2);
+        slots.swap(mSlots);
+        for (Slot& oldSlot : slots) {
+            if (oldSlot.request.has_value()) {
+                Slot& newSlot = slotFor(oldSlot.frameNumber);
+                newSlot.frameNumber = oldSlot.frameNumber;
+                newSlot.registeredNs = oldSlot.registeredNs;
+                newSlot.request = std::move(oldSlot.request);
+            }
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    std::map<uint32_t, Slot> mOverflow;
+    // Frame numbers in flight, in increasing order.
+    std::vector<uint32_t> mKeys;
+
+    size_t mLatencyCount = 0;
+    nsecs_t mLatencyTotalNs = 0;
+    nsecs_t mLatencyMaxNs = 0;
+};
 
 } // namespace camera3
 
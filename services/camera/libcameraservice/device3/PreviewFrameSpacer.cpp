@@ -18,6 +18,10 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+#include <cstdlib>
+
+#include <cutils/properties.h>
 #include <utils/Log.h>
 
 #include "PreviewFrameSpacer.h"
@@ -27,9 +31,74 @@ namespace android {
 
 namespace camera3 {
 
+PreviewPacingModel::PreviewPacingModel(int jitterPercentile) :
+        mJitterPercentile(std::clamp(jitterPercentile, 0, 100)) {
+    mLatencies.fill(0);
+}
+
+void PreviewPacingModel::reset() {
+    mLatencyCount = 0;
+    mNextLatency = 0;
+    mTargetLatency = 0;
+    mFrameInterval = 0;
+}
+
+void PreviewPacingModel::onFrameArrived(nsecs_t readoutTime, nsecs_t arrivalTime) {
+    if (mLastReadoutTime > 0) {
+        nsecs_t interval = readoutTime - mLastReadoutTime;
+        if (interval <= 0 || interval >= kMaxFrameInterval) {
+            // Out of order readout, or the stream was paused
+            reset();
+        } else if (mFrameInterval == 0 ||
+                std::abs(interval - mFrameInterval) > mFrameInterval / kFrameIntervalChangeRatio) {
+            // The sensor frame rate changed, and with it the pipeline latency
+            mLatencyCount = 0;
+            mNextLatency = 0;
+            mFrameInterval = interval;
+        } else {
+            mFrameInterval += (interval - mFrameInterval) / 8;
+        }
+    }
+    mLastReadoutTime = readoutTime;
+
+    mLatencies[mNextLatency] = arrivalTime - readoutTime;
+    mNextLatency = (mNextLatency + 1) % kLatencyWindow;
+    mLatencyCount = std::min(mLatencyCount + 1, kLatencyWindow);
+
+    std::array<nsecs_t, kLatencyWindow> latencies;
+    std::copy_n(mLatencies.begin(), mLatencyCount, latencies.begin());
+    size_t index = (mLatencyCount - 1) * mJitterPercentile / 100;
+    std::nth_element(latencies.begin(), latencies.begin() + index,
+            latencies.begin() + mLatencyCount);
+    mTargetLatency = latencies[index];
+}
+
+void PreviewPacingModel::setDisplayFrameInterval(nsecs_t interval) {
+    mDisplayFrameInterval = interval;
+}
+
+bool PreviewPacingModel::isValid() const {
+    return mFrameInterval > 0 && mTargetLatency >= 0 && mTargetLatency < kMaxPipelineLatency;
+}
+
+nsecs_t PreviewPacingModel::getTargetQueueTime(nsecs_t readoutTime,
+        nsecs_t lastQueueTime) const {
+    nsecs_t targetTime = readoutTime + mTargetLatency - kQueueOverhead;
+    // Frames queued faster than the display refresh are dropped anyway, so only keep
+    // frames apart when the camera doesn't outrun the display.
+    if (mDisplayFrameInterval > 0 && lastQueueTime > 0 &&
+            mFrameInterval >= mDisplayFrameInterval) {
+        targetTime = std::max(targetTime, lastQueueTime + mDisplayFrameInterval / 2);
+    }
+    return targetTime;
+}
+
 PreviewFrameSpacer::PreviewFrameSpacer(wp<Camera3OutputStream> parent, sp<Surface> consumer) :
         mParent(parent),
-        mConsumer(consumer) {
+        mConsumer(consumer),
+        mAdaptive(property_get_bool("camera.preview_spacer.adaptive", false)),
+        mPacingModel(property_get_int32("camera.preview_spacer.jitter_percentile",
+                PreviewPacingModel::kDefaultJitterPercentile)) {
 }
 
 PreviewFrameSpacer::~PreviewFrameSpacer() {
@@ -38,7 +107,12 @@ PreviewFrameSpacer::~PreviewFrameSpacer() {
 status_t PreviewFrameSpacer::queuePreviewBuffer(nsecs_t timestamp, nsecs_t readoutTimestamp,
         int32_t transform, ANativeWindowBuffer* anwBuffer, int releaseFence) {
     Mutex::Autolock l(mLock);
-    mPendingBuffers.emplace(timestamp, readoutTimestamp, transform, anwBuffer, releaseFence);
+    nsecs_t arrivalTime = systemTime();
+    mPendingBuffers.emplace(timestamp, readoutTimestamp, arrivalTime, transform, anwBuffer,
+            releaseFence);
+    if (mAdaptive) {
+        mPacingModel.onFrameArrived(readoutTimestamp, arrivalTime);
+    }
     ALOGV("%s: mPendingBuffers size %zu, timestamp %" PRId64 ", readoutTime %" PRId64,
             __FUNCTION__, mPendingBuffers.size(), timestamp, readoutTimestamp);
 
@@ -47,6 +121,10 @@ status_t PreviewFrameSpacer::queuePreviewBuffer(nsecs_t timestamp, nsecs_t reado
 }
 
 bool PreviewFrameSpacer::threadLoop() {
+    if (mAdaptive) {
+        updateDisplayFrameInterval(systemTime());
+    }
+
     Mutex::Autolock l(mLock);
     if (mPendingBuffers.size() == 0) {
         mBufferCond.waitRelative(mLock, kWaitDuration);
@@ -68,11 +146,17 @@ bool PreviewFrameSpacer::threadLoop() {
         return true;
     }
 
-    // Cache the frame to match readout time interval, for up to kMaxFrameWaitTime
-    // Because the code between here and queueBuffer() takes time to execute, make sure the
-    // presentationInterval is slightly shorter than readoutInterval.
-    nsecs_t expectedQueueTime = mLastCameraPresentTime + readoutInterval - kFrameAdjustThreshold;
-    nsecs_t frameWaitTime = std::min(kMaxFrameWaitTime, expectedQueueTime - currentTime);
+    nsecs_t frameWaitTime;
+    if (mAdaptive && mPacingModel.isValid()) {
+        frameWaitTime = getAdaptiveWaitTimeLocked(buffer, currentTime);
+    } else {
+        // Cache the frame to match readout time interval, for up to kMaxFrameWaitTime
+        // Because the code between here and queueBuffer() takes time to execute, make sure
+        // the presentationInterval is slightly shorter than readoutInterval.
+        nsecs_t expectedQueueTime =
+                mLastCameraPresentTime + readoutInterval - kFrameAdjustThreshold;
+        frameWaitTime = std::min(kMaxFrameWaitTime, expectedQueueTime - currentTime);
+    }
     if (frameWaitTime > 0 && mPendingBuffers.size() < 2) {
         mBufferCond.waitRelative(mLock, frameWaitTime);
         if (exitPending()) {
@@ -88,6 +172,53 @@ bool PreviewFrameSpacer::threadLoop() {
     return true;
 }
 
+nsecs_t PreviewFrameSpacer::getAdaptiveWaitTimeLocked(const BufferHolder& bufferHolder,
+        nsecs_t currentTime) const {
+    nsecs_t targetTime = mPacingModel.getTargetQueueTime(bufferHolder.readoutTimestamp,
+            mLastCameraPresentTime);
+    // Never hold a buffer for longer than a frame, so that the spacer doesn't fall behind
+    nsecs_t maxWaitTime = std::min(kMaxAdaptiveFrameWaitTime, mPacingModel.getFrameInterval());
+    return std::min(targetTime, bufferHolder.arrivalTime + maxWaitTime) - currentTime;
+}
+
+void PreviewFrameSpacer::updateDisplayFrameInterval(nsecs_t currentTime) {
+    // The display refresh rate can change at any time, but querying it is a binder call
+    if (currentTime - mLastDisplayQueryTime < kDisplayQueryInterval) {
+        return;
+    }
+    mLastDisplayQueryTime = currentTime;
+
+    sp<Camera3OutputStream> parent = mParent.promote();
+    if (parent == nullptr) {
+        return;
+    }
+    nsecs_t displayFrameInterval = parent->getDisplayFrameInterval();
+
+    Mutex::Autolock l(mLock);
+    mPacingModel.setDisplayFrameInterval(displayFrameInterval);
+}
+
+std::array<int64_t, StageLatencyHistogram::BIN_COUNT>
+        PreviewFrameSpacer::getAndResetAddedLatency() {
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> counts = mAddedLatency.getCounts();
+    mAddedLatency.reset();
+    return counts;
+}
+
+void PreviewFrameSpacer::dump(int fd) const {
+    String8 lines;
+    Mutex::Autolock l(mLock);
+    if (mAdaptive) {
+        lines.appendFormat("      Preview spacer: adaptive, frame interval %" PRId64
+                " us, target latency %" PRId64 " us\n",
+                ns2us(mPacingModel.getFrameInterval()),
+                ns2us(mPacingModel.getTargetLatency()));
+    } else {
+        lines.append("      Preview spacer: fixed\n");
+    }
+    write(fd, lines.string(), lines.size());
+}
+
 void PreviewFrameSpacer::requestExit() {
     // Call parent to set up shutdown
     Thread::requestExit();
@@ -125,6 +256,7 @@ void PreviewFrameSpacer::queueBufferToClientLocked(
     }
 
     parent->onCachedBufferQueued();
+    mAddedLatency.add(currentTime - bufferHolder.arrivalTime);
     mLastCameraPresentTime = currentTime;
     mLastCameraReadoutTime = bufferHolder.readoutTimestamp;
 }
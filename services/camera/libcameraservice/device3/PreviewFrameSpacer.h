@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA3_PREVIEWFRAMESPACER_H
 #define ANDROID_SERVERS_CAMERA_CAMERA3_PREVIEWFRAMESPACER_H
 
+#include <array>
 #include <queue>
 
 #include <gui/Surface.h>
@@ -25,12 +26,67 @@
 #include <utils/Thread.h>
 #include <utils/Timers.h>
 
+#include "utils/SessionStatsBuilder.h"
+
 namespace android {
 
 namespace camera3 {
 
 class Camera3OutputStream;
 
+/**
+ * Timing model for the adaptive mode of PreviewFrameSpacer
+ *
+ * Learns the camera frame interval from the readout timestamps, and the
+ * distribution of the latency between readout and the buffer reaching the
+ * spacer. Buffers are scheduled at a fixed latency after their readout, chosen
+ * as the given percentile of the recent latencies: a higher percentile smooths
+ * out more of the jitter at the cost of more added latency. If the camera runs
+ * no faster than the display, consecutive buffers are also kept at least half a
+ * display frame apart so that they don't land on the same vsync.
+ */
+class PreviewPacingModel {
+  public:
+    explicit PreviewPacingModel(int jitterPercentile = kDefaultJitterPercentile);
+
+    // Record a buffer read out at readoutTime and handed to the spacer at arrivalTime
+    void onFrameArrived(nsecs_t readoutTime, nsecs_t arrivalTime);
+    void setDisplayFrameInterval(nsecs_t interval);
+
+    // The time at which the buffer read out at readoutTime should be queued, given the time
+    // the previous buffer was queued.
+    nsecs_t getTargetQueueTime(nsecs_t readoutTime, nsecs_t lastQueueTime) const;
+
+    // Whether enough consistent frames have been seen to schedule buffers
+    bool isValid() const;
+    nsecs_t getFrameInterval() const { return mFrameInterval; }
+    nsecs_t getTargetLatency() const { return mTargetLatency; }
+
+    static constexpr int kDefaultJitterPercentile = 90;
+    // Number of recent frames the latency percentile is computed from
+    static constexpr size_t kLatencyWindow = 32;
+    // A frame interval change larger than 1/kFrameIntervalChangeRatio restarts the estimate
+    static constexpr nsecs_t kFrameIntervalChangeRatio = 4;
+    // A readout gap longer than this means the stream was paused
+    static constexpr nsecs_t kMaxFrameInterval = 80000000LL; // 80ms
+    // Readout to spacer latencies beyond this mean the timestamps can't be trusted
+    static constexpr nsecs_t kMaxPipelineLatency = 1000000000LL; // 1s
+    // Time spent between the target queue time and the actual queueBuffer call
+    static constexpr nsecs_t kQueueOverhead = 2000000LL; // 2ms
+
+  private:
+    void reset();
+
+    const int mJitterPercentile;
+    std::array<nsecs_t, kLatencyWindow> mLatencies;
+    size_t mLatencyCount = 0;
+    size_t mNextLatency = 0;
+    nsecs_t mTargetLatency = 0;
+    nsecs_t mFrameInterval = 0;
+    nsecs_t mLastReadoutTime = 0;
+    nsecs_t mDisplayFrameInterval = 0;
+};
+
 /***
  * Preview stream spacer for better frame spacing
  *
@@ -46,6 +102,11 @@ class Camera3OutputStream;
  * - Queue frame buffers in the same cadence as the camera readout time.
  * - Maintain at most 1 queue-able buffer. If the 2nd preview buffer becomes
  *   available, queue the oldest cached buffer to the buffer queue.
+ *
+ * By default, buffers are spaced with fixed timing parameters. When the
+ * camera.preview_spacer.adaptive property is set, PreviewPacingModel adapts the
+ * spacing to the measured frame interval, pipeline latency and display refresh
+ * rate instead.
  */
 class PreviewFrameSpacer : public Thread {
   public:
@@ -59,21 +120,32 @@ class PreviewFrameSpacer : public Thread {
     bool threadLoop() override;
     void requestExit() override;
 
+    // Return the histogram of the latency added by the spacer since the last call, and
+    // reset it.
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> getAndResetAddedLatency();
+    void dump(int fd) const;
+
   private:
     // structure holding cached preview buffer info
     struct BufferHolder {
         nsecs_t timestamp;
         nsecs_t readoutTimestamp;
+        nsecs_t arrivalTime;
         int32_t transform;
         sp<ANativeWindowBuffer> anwBuffer;
         int releaseFence;
 
-        BufferHolder(nsecs_t t, nsecs_t readoutT, int32_t tr, ANativeWindowBuffer* anwb, int rf) :
-                timestamp(t), readoutTimestamp(readoutT), transform(tr), anwBuffer(anwb),
-                releaseFence(rf) {}
+        BufferHolder(nsecs_t t, nsecs_t readoutT, nsecs_t arrivalT, int32_t tr,
+                ANativeWindowBuffer* anwb, int rf) :
+                timestamp(t), readoutTimestamp(readoutT), arrivalTime(arrivalT), transform(tr),
+                anwBuffer(anwb), releaseFence(rf) {}
     };
 
     void queueBufferToClientLocked(const BufferHolder& bufferHolder, nsecs_t currentTime);
+    // Time to wait before queueing the buffer in the adaptive mode
+    nsecs_t getAdaptiveWaitTimeLocked(const BufferHolder& bufferHolder,
+            nsecs_t currentTime) const;
+    void updateDisplayFrameInterval(nsecs_t currentTime);
 
     wp<Camera3OutputStream> mParent;
     sp<ANativeWindow> mConsumer;
@@ -87,6 +159,15 @@ class PreviewFrameSpacer : public Thread {
     static constexpr nsecs_t kFrameIntervalThreshold = 80000000LL; // 80ms
     static constexpr nsecs_t kMaxFrameWaitTime = 10000000LL; // 10ms
     static constexpr nsecs_t kFrameAdjustThreshold = 2000000LL; // 2ms
+
+    const bool mAdaptive;
+    PreviewPacingModel mPacingModel;
+    // Only accessed from the spacer thread
+    nsecs_t mLastDisplayQueryTime = 0;
+    // Latency between the buffer reaching the spacer and being queued to the consumer
+    StageLatencyHistogram mAddedLatency;
+    static constexpr nsecs_t kMaxAdaptiveFrameWaitTime = 33000000LL; // 33ms
+    static constexpr nsecs_t kDisplayQueryInterval = 1000000000LL; // 1s
 };
 
 }; //namespace camera3
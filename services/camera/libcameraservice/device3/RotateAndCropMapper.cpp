@@ -160,15 +160,17 @@ status_t RotateAndCropMapper::updateCaptureRequest(CameraMetadata *request) {
         }
     }
 
+    auto transform = [&](int32_t* coordPairs, int coordCount) {
+        transformPoints(coordPairs, coordCount, transformMat, xShift, yShift, cx, cy);
+        return OK;
+    };
     for (auto regionTag : kMeteringRegionsToCorrect) {
         entry = request->find(regionTag);
-        for (size_t i = 0; i < entry.count; i += 5) {
-            int32_t weight = entry.data.i32[i + 4];
-            if (weight == 0) {
-                continue;
+        transformMeteringRegions(entry.data.i32, entry.count, /*maxCornerOffset*/0, transform);
+        for (size_t i = 0; i + 5 <= entry.count; i += 5) {
+            if (entry.data.i32[i + 4] != 0) {
+                swapRectToMinFirst(entry.data.i32 + i);
             }
-            transformPoints(entry.data.i32 + i, 2, transformMat, xShift, yShift, cx, cy);
-            swapRectToMinFirst(entry.data.i32 + i);
         }
     }
 
@@ -289,15 +291,17 @@ status_t RotateAndCropMapper::updateCaptureResult(CameraMetadata *result) {
         }
     }
 
+    auto transform = [&](int32_t* coordPairs, int coordCount) {
+        transformPoints(coordPairs, coordCount, transformMat, xShift, yShift, rx, ry);
+        return OK;
+    };
     for (auto regionTag : kMeteringRegionsToCorrect) {
         entry = result->find(regionTag);
-        for (size_t i = 0; i < entry.count; i += 5) {
-            int32_t weight = entry.data.i32[i + 4];
-            if (weight == 0) {
-                continue;
+        transformMeteringRegions(entry.data.i32, entry.count, /*maxCornerOffset*/0, transform);
+        for (size_t i = 0; i + 5 <= entry.count; i += 5) {
+            if (entry.data.i32[i + 4] != 0) {
+                swapRectToMinFirst(entry.data.i32 + i);
             }
-            transformPoints(entry.data.i32 + i, 2, transformMat, xShift, yShift, rx, ry);
-            swapRectToMinFirst(entry.data.i32 + i);
         }
     }
 
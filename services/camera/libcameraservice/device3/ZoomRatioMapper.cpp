@@ -346,40 +346,7 @@ status_t ZoomRatioMapper::separateZoomFromCropLocked(CameraMetadata* metadata, b
     }
 
     // Scale regions using zoomRatio
-    camera_metadata_entry_t entry;
-    for (auto region : kMeteringRegionsToCorrect) {
-        entry = metadata->find(region);
-        for (size_t j = 0; j < entry.count; j += 5) {
-            int32_t weight = entry.data.i32[j + 4];
-            if (weight == 0) {
-                continue;
-            }
-            // Top left (inclusive)
-            scaleCoordinates(entry.data.i32 + j, 1, zoomRatio, true /*clamp*/, arrayWidth,
-                    arrayHeight);
-            // Bottom right (exclusive): Use adjacent inclusive pixel to
-            // calculate.
-            entry.data.i32[j+2] -= 1;
-            entry.data.i32[j+3] -= 1;
-            scaleCoordinates(entry.data.i32 + j + 2, 1, zoomRatio, true /*clamp*/, arrayWidth,
-                    arrayHeight);
-            entry.data.i32[j+2] += 1;
-            entry.data.i32[j+3] += 1;
-        }
-    }
-
-    for (auto rect : kRectsToCorrect) {
-        entry = metadata->find(rect);
-        scaleRects(entry.data.i32, entry.count / 4, zoomRatio, arrayWidth, arrayHeight);
-    }
-
-    if (isResult) {
-        for (auto pts : kResultPointsToCorrectNoClamp) {
-            entry = metadata->find(pts);
-            scaleCoordinates(entry.data.i32, entry.count / 2, zoomRatio, false /*clamp*/,
-                    arrayWidth, arrayHeight);
-        }
-    }
+    scaleMetadataLocked(metadata, isResult, zoomRatio, arrayWidth, arrayHeight);
 
     return OK;
 }
@@ -394,45 +361,45 @@ status_t ZoomRatioMapper::combineZoomAndCropLocked(CameraMetadata* metadata, boo
     }
 
     // Unscale regions with zoomRatio
+    scaleMetadataLocked(metadata, isResult, 1.0 / zoomRatio, arrayWidth, arrayHeight);
+
+    zoomRatio = 1.0;
+    status_t res = metadata->update(ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1);
+    if (res != OK) {
+        return res;
+    }
+
+    return OK;
+}
+
+void ZoomRatioMapper::scaleMetadataLocked(CameraMetadata* metadata, bool isResult,
+        float scaleRatio, int32_t arrayWidth, int32_t arrayHeight) {
+    auto scaleClamped = [this, scaleRatio, arrayWidth, arrayHeight](int32_t* coordPairs,
+            int coordCount) {
+        scaleCoordinates(coordPairs, coordCount, scaleRatio, true /*clamp*/, arrayWidth,
+                arrayHeight);
+        return OK;
+    };
+
+    camera_metadata_entry_t entry;
     for (auto region : kMeteringRegionsToCorrect) {
         entry = metadata->find(region);
-        for (size_t j = 0; j < entry.count; j += 5) {
-            int32_t weight = entry.data.i32[j + 4];
-            if (weight == 0) {
-                continue;
-            }
-            // Top-left (inclusive)
-            scaleCoordinates(entry.data.i32 + j, 1, 1.0 / zoomRatio, true /*clamp*/, arrayWidth,
-                    arrayHeight);
-            // Bottom-right (exclusive): Use adjacent inclusive pixel to
-            // calculate.
-            entry.data.i32[j+2] -= 1;
-            entry.data.i32[j+3] -= 1;
-            scaleCoordinates(entry.data.i32 + j + 2, 1, 1.0 / zoomRatio, true /*clamp*/, arrayWidth,
-                    arrayHeight);
-            entry.data.i32[j+2] += 1;
-            entry.data.i32[j+3] += 1;
-        }
+        // Top-left is inclusive, bottom-right is exclusive: use the adjacent inclusive
+        // pixel to calculate.
+        transformMeteringRegions(entry.data.i32, entry.count, /*maxCornerOffset*/1,
+                scaleClamped);
     }
     for (auto rect : kRectsToCorrect) {
         entry = metadata->find(rect);
-        scaleRects(entry.data.i32, entry.count / 4, 1.0 / zoomRatio, arrayWidth, arrayHeight);
+        scaleRects(entry.data.i32, entry.count / 4, scaleRatio, arrayWidth, arrayHeight);
     }
     if (isResult) {
         for (auto pts : kResultPointsToCorrectNoClamp) {
             entry = metadata->find(pts);
-            scaleCoordinates(entry.data.i32, entry.count / 2, 1.0 / zoomRatio, false /*clamp*/,
+            scaleCoordinates(entry.data.i32, entry.count / 2, scaleRatio, false /*clamp*/,
                     arrayWidth, arrayHeight);
         }
     }
-
-    zoomRatio = 1.0;
-    status_t res = metadata->update(ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1);
-    if (res != OK) {
-        return res;
-    }
-
-    return OK;
 }
 
 void ZoomRatioMapper::scaleCoordinates(int32_t* coordPairs, int coordCount,
@@ -446,53 +413,42 @@ void ZoomRatioMapper::scaleCoordinates(int32_t* coordPairs, int coordCount,
     // the active array (shifted by 0.5 pixel as well).
     // 3. Shift the coordinate system back by directly using the pixel center
     // coordinate.
+    // The loops below carry no dependency between pairs so that they can be vectorized.
+    const float centerX = (arrayWidth - 2) / 2;
+    const float centerY = (arrayHeight - 2) / 2;
     for (int i = 0; i < coordCount * 2; i += 2) {
-        float x = coordPairs[i];
-        float y = coordPairs[i + 1];
-        float xCentered = x - (arrayWidth - 2) / 2;
-        float yCentered = y - (arrayHeight - 2) / 2;
-        float scaledX = xCentered * scaleRatio;
-        float scaledY = yCentered * scaleRatio;
-        scaledX += (arrayWidth - 2) / 2;
-        scaledY += (arrayHeight - 2) / 2;
+        // Keep the multiply and add separate so they are rounded the same as before
+        float scaledX = (coordPairs[i] - centerX) * scaleRatio;
+        float scaledY = (coordPairs[i + 1] - centerY) * scaleRatio;
+        scaledX += centerX;
+        scaledY += centerY;
         coordPairs[i] = static_cast<int32_t>(std::round(scaledX));
         coordPairs[i+1] = static_cast<int32_t>(std::round(scaledY));
-        // Clamp to within activeArray/preCorrectionActiveArray
-        if (clamp) {
-            int32_t right = arrayWidth - 1;
-            int32_t bottom = arrayHeight - 1;
-            coordPairs[i] =
-                    std::min(right, std::max(0, coordPairs[i]));
-            coordPairs[i+1] =
-                    std::min(bottom, std::max(0, coordPairs[i+1]));
+    }
+    // Clamp to within activeArray/preCorrectionActiveArray
+    if (clamp) {
+        const int32_t right = arrayWidth - 1;
+        const int32_t bottom = arrayHeight - 1;
+        for (int i = 0; i < coordCount * 2; i += 2) {
+            coordPairs[i] = std::min(right, std::max(0, coordPairs[i]));
+            coordPairs[i+1] = std::min(bottom, std::max(0, coordPairs[i+1]));
         }
+    }
+    for (int i = 0; i < coordCount * 2; i += 2) {
         ALOGV("%s: coordinates: %d, %d", __FUNCTION__, coordPairs[i], coordPairs[i+1]);
     }
 }
 
 void ZoomRatioMapper::scaleRects(int32_t* rects, int rectCount,
         float scaleRatio, int32_t arrayWidth, int32_t arrayHeight) {
-    for (int i = 0; i < rectCount * 4; i += 4) {
-        // Map from (l, t, width, height) to (l, t, l+width-1, t+height-1),
-        // where both top-left and bottom-right are inclusive.
-        int32_t coords[4] = {
-            rects[i],
-            rects[i + 1],
-            rects[i] + rects[i + 2] - 1,
-            rects[i + 1] + rects[i + 3] - 1
-        };
-
-        // top-left
-        scaleCoordinates(coords, 1, scaleRatio, true /*clamp*/, arrayWidth, arrayHeight);
-        // bottom-right
-        scaleCoordinates(coords+2, 1, scaleRatio, true /*clamp*/, arrayWidth, arrayHeight);
-
-        // Map back to (l, t, width, height)
-        rects[i] = coords[0];
-        rects[i + 1] = coords[1];
-        rects[i + 2] = coords[2] - coords[0] + 1;
-        rects[i + 3] = coords[3] - coords[1] + 1;
-    }
+    // Both top-left and bottom-right are inclusive
+    auto scaleClamped = [this, scaleRatio, arrayWidth, arrayHeight](int32_t* coordPairs,
+            int coordCount) {
+        scaleCoordinates(coordPairs, coordCount, scaleRatio, true /*clamp*/, arrayWidth,
+                arrayHeight);
+        return OK;
+    };
+    transformRects(rects, rectCount, scaleClamped);
 }
 
 } // namespace camera3
@@ -91,6 +91,9 @@ class ZoomRatioMapper : public CoordinateMapper {
             int arrayHeight);
     status_t combineZoomAndCropLocked(CameraMetadata* metadata, bool isResult, int arrayWidth,
             int arrayHeight);
+    // Scale the metering regions, rectangles and (for results) points of the metadata
+    void scaleMetadataLocked(CameraMetadata* metadata, bool isResult, float scaleRatio,
+            int32_t arrayWidth, int32_t arrayHeight);
     status_t getArrayDimensionsToBeUsed(const CameraMetadata *settings, int32_t *arrayWidth,
             int32_t *arrayHeight);
 };
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "CameraMetadataBufferPoolTest"
+
+#include <gtest/gtest.h>
+
+#include <camera/CameraMetadata.h>
+
+using namespace android;
+
+TEST(CameraMetadataBufferPoolTest, ReuseBuffers) {
+    sp<CameraMetadataBufferPool> pool = new CameraMetadataBufferPool();
+    int32_t frameCount = 1;
+
+    for (int i = 0; i < 10; i++) {
+        CameraMetadata metadata(pool, 4, 16);
+        ASSERT_TRUE(metadata.isEmpty());
+        ASSERT_EQ(metadata.update(ANDROID_REQUEST_FRAME_COUNT, &frameCount, 1), OK);
+        ASSERT_EQ(metadata.entryCount(), 1u);
+    }
+    ASSERT_EQ(pool->getAllocationCount(), 1u);
+    ASSERT_EQ(pool->getReuseCount(), 9u);
+}
+
+TEST(CameraMetadataBufferPoolTest, GrowToTypicalSize) {
+    sp<CameraMetadataBufferPool> pool = new CameraMetadataBufferPool();
+    int64_t timestamp = 1;
+    int32_t frameCount = 1;
+    {
+        CameraMetadata metadata(pool, 1, 0);
+        // Growing the buffer keeps using the pool
+        ASSERT_EQ(metadata.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1), OK);
+        ASSERT_EQ(metadata.update(ANDROID_REQUEST_FRAME_COUNT, &frameCount, 1), OK);
+        ASSERT_EQ(metadata.entryCount(), 2u);
+    }
+    size_t allocationCount = pool->getAllocationCount();
+
+    // The larger buffer fits the next request
+    CameraMetadata metadata(pool, 1, 0);
+    ASSERT_EQ(pool->getAllocationCount(), allocationCount);
+    ASSERT_EQ(pool->getReuseCount(), 1u);
+
+    // Buffers smaller than the largest request are not reused
+    CameraMetadata large(pool, 64, 1024);
+    ASSERT_EQ(pool->getAllocationCount(), allocationCount + 1);
+}
+
+TEST(CameraMetadataBufferPoolTest, MoveAndRelease) {
+    sp<CameraMetadataBufferPool> pool = new CameraMetadataBufferPool();
+    int32_t frameCount = 1;
+
+    CameraMetadata metadata(pool, 4, 16);
+    ASSERT_EQ(metadata.update(ANDROID_REQUEST_FRAME_COUNT, &frameCount, 1), OK);
+
+    // The pool follows the buffer
+    CameraMetadata moved(std::move(metadata));
+    ASSERT_TRUE(metadata.isEmpty());
+    ASSERT_EQ(moved.entryCount(), 1u);
+    moved.clear();
+    CameraMetadata reused(pool, 4, 16);
+    ASSERT_EQ(pool->getReuseCount(), 1u);
+
+    // Released buffers are owned by the caller
+    camera_metadata_t* buffer = reused.release();
+    ASSERT_NE(buffer, nullptr);
+    free_camera_metadata(buffer);
+    CameraMetadata copy(pool, 4, 16);
+    ASSERT_EQ(pool->getReuseCount(), 1u);
+    ASSERT_EQ(pool->getAllocationCount(), 2u);
+}
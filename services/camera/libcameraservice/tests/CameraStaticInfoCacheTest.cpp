@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "CameraStaticInfoCacheTest"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../utils/CameraStaticInfoCache.h"
+
+using namespace android;
+
+namespace {
+
+const std::string kProvider = "internal/0";
+const std::string kDevice = "device@1.1/internal/0";
+const std::string kOtherDevice = "device@1.1/internal/01";
+
+std::string makeTempDir() {
+    char dirTemplate[] = "/data/local/tmp/CameraStaticInfoCacheTest.XXXXXX";
+    char* dir = mkdtemp(dirTemplate);
+    return dir != nullptr ? std::string(dir) : std::string("/data/local/tmp");
+}
+
+} // anonymous namespace
+
+TEST(CameraStaticInfoCacheTest, ReadWrite) {
+    std::string dir = makeTempDir();
+    CameraStaticInfoCache cache(dir, "fingerprint");
+    std::vector<uint8_t> metadata;
+
+    ASSERT_FALSE(cache.read(kProvider, kDevice, "", &metadata));
+    ASSERT_EQ(cache.getMissCount(), 1u);
+
+    std::vector<uint8_t> chars = {1, 2, 3, 4, 5};
+    std::vector<uint8_t> physicalChars = {6, 7};
+    ASSERT_EQ(cache.write(kProvider, kDevice, "", chars), OK);
+    ASSERT_EQ(cache.write(kProvider, kDevice, "2", physicalChars), OK);
+
+    ASSERT_TRUE(cache.read(kProvider, kDevice, "", &metadata));
+    ASSERT_EQ(metadata, chars);
+    ASSERT_TRUE(cache.read(kProvider, kDevice, "2", &metadata));
+    ASSERT_EQ(metadata, physicalChars);
+    ASSERT_EQ(cache.getHitCount(), 2u);
+
+    // A new build must not see entries written by an older one
+    CameraStaticInfoCache newBuildCache(dir, "new_fingerprint");
+    ASSERT_FALSE(newBuildCache.read(kProvider, kDevice, "", &metadata));
+    ASSERT_TRUE(metadata.empty());
+
+    cache.invalidate(kProvider, kDevice);
+    rmdir(dir.c_str());
+}
+
+TEST(CameraStaticInfoCacheTest, Invalidate) {
+    std::string dir = makeTempDir();
+    CameraStaticInfoCache cache(dir, "fingerprint");
+    std::vector<uint8_t> chars = {1, 2, 3};
+    std::vector<uint8_t> metadata;
+
+    ASSERT_EQ(cache.write(kProvider, kDevice, "", chars), OK);
+    ASSERT_EQ(cache.write(kProvider, kDevice, "2", chars), OK);
+    ASSERT_EQ(cache.write(kProvider, kOtherDevice, "", chars), OK);
+
+    cache.invalidate(kProvider, kDevice);
+    ASSERT_FALSE(cache.read(kProvider, kDevice, "", &metadata));
+    ASSERT_FALSE(cache.read(kProvider, kDevice, "2", &metadata));
+    // Devices sharing the name prefix are left alone
+    ASSERT_TRUE(cache.read(kProvider, kOtherDevice, "", &metadata));
+    ASSERT_EQ(metadata, chars);
+
+    cache.invalidate(kProvider, kOtherDevice);
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/DistortionMapper.h"
+#include "../device3/ZoomRatioMapper.h"
+
+using namespace android;
+using namespace android::camera3;
+using DistortionMapperInfo = android::camera3::DistortionMapper::DistortionMapperInfo;
+
+static int32_t kActiveArray[] = {100, 100, 4000, 3000};
+static int32_t kPreCorrActiveArray[] = {90, 90, 4020, 3020};
+static float kIntrinsics[] = {3000.f, 3000.f, 2000.f, 1500.f, 0.f};
+static float kDistortion[] = {0.1f, -0.003f, 0.004f, 0.02f, 0.01f};
+
+static std::vector<int32_t> randomCoords(size_t pairCount) {
+    std::default_random_engine gen(0xC0FFEE);
+    std::uniform_int_distribution<int32_t> x_dist(0, kActiveArray[2] - 1);
+    std::uniform_int_distribution<int32_t> y_dist(0, kActiveArray[3] - 1);
+    std::vector<int32_t> coords(pairCount * 2);
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        coords[i] = x_dist(gen);
+        coords[i + 1] = y_dist(gen);
+    }
+    return coords;
+}
+
+static void setupDistortionMapper(DistortionMapper* m) {
+    CameraMetadata deviceInfo;
+    deviceInfo.update(ANDROID_SENSOR_INFO_PRE_CORRECTION_ACTIVE_ARRAY_SIZE,
+            kPreCorrActiveArray, 4);
+    deviceInfo.update(ANDROID_SENSOR_INFO_ACTIVE_ARRAY_SIZE, kActiveArray, 4);
+    deviceInfo.update(ANDROID_LENS_INTRINSIC_CALIBRATION, kIntrinsics, 5);
+    deviceInfo.update(ANDROID_LENS_DISTORTION, kDistortion, 5);
+    m->setupStaticInfo(deviceInfo);
+}
+
+// Map points back and forth, the way face landmarks are mapped for a request and a result
+static void BM_DistortionMapper_RoundTrip(benchmark::State& state) {
+    DistortionMapper m;
+    setupDistortionMapper(&m);
+    DistortionMapperInfo* mapperInfo = m.getMapperInfo();
+
+    const std::vector<int32_t> input = randomCoords(state.range(0));
+    std::vector<int32_t> coords;
+    for (auto _ : state) {
+        coords = input;
+        m.mapCorrectedToRaw(coords.data(), state.range(0), mapperInfo, /*clamp*/true,
+                /*simple*/false);
+        m.mapRawToCorrected(coords.data(), state.range(0), mapperInfo, /*clamp*/true,
+                /*simple*/false);
+        benchmark::DoNotOptimize(coords.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Inverse grid search through the lookup grid
+static void BM_DistortionMapper_FindQuadLookup(benchmark::State& state) {
+    DistortionMapper m;
+    setupDistortionMapper(&m);
+    DistortionMapperInfo* mapperInfo = m.getMapperInfo();
+    std::vector<int32_t> coords = randomCoords(state.range(0));
+    // Build the grids
+    std::vector<int32_t> point = randomCoords(1);
+    m.mapRawToCorrected(point.data(), 1, mapperInfo, /*clamp*/true, /*simple*/false);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < coords.size(); i += 2) {
+            benchmark::DoNotOptimize(
+                    DistortionMapper::findEnclosingQuad(coords.data() + i, *mapperInfo));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Inverse grid search through all the grid quads, for comparison
+static void BM_DistortionMapper_FindQuadLinear(benchmark::State& state) {
+    DistortionMapper m;
+    setupDistortionMapper(&m);
+    DistortionMapperInfo* mapperInfo = m.getMapperInfo();
+    std::vector<int32_t> coords = randomCoords(state.range(0));
+    // Build the grids
+    std::vector<int32_t> point = randomCoords(1);
+    m.mapRawToCorrected(point.data(), 1, mapperInfo, /*clamp*/true, /*simple*/false);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < coords.size(); i += 2) {
+            benchmark::DoNotOptimize(DistortionMapper::findEnclosingQuad(coords.data() + i,
+                    mapperInfo->mDistortedGrid));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ZoomRatioMapper_ScaleCoordinates(benchmark::State& state) {
+    ZoomRatioMapper m;
+    const std::vector<int32_t> input = randomCoords(state.range(0));
+    std::vector<int32_t> coords;
+    for (auto _ : state) {
+        coords = input;
+        m.scaleCoordinates(coords.data(), state.range(0), 2.0f, /*clamp*/true,
+                kActiveArray[2], kActiveArray[3]);
+        benchmark::DoNotOptimize(coords.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Point counts of a few metering regions up to 10 faces with their landmarks
+BENCHMARK(BM_DistortionMapper_RoundTrip)->Arg(4)->Arg(32)->Arg(128);
+BENCHMARK(BM_DistortionMapper_FindQuadLookup)->Arg(4)->Arg(32)->Arg(128);
+BENCHMARK(BM_DistortionMapper_FindQuadLinear)->Arg(4)->Arg(32)->Arg(128);
+BENCHMARK(BM_ZoomRatioMapper_ScaleCoordinates)->Arg(4)->Arg(32)->Arg(128);
+
+BENCHMARK_MAIN();
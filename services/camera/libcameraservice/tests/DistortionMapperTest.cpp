@@ -348,6 +348,32 @@ TEST(DistortionMapperTest, LargeTransform) {
     RandomTransformTest(this, testActiveArray, m, /*clamp*/false, /*simple*/false);
 }
 
+TEST(DistortionMapperTest, QuadLookupMatchesLinearSearch) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+
+    // Build the grids
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    std::array<int32_t, 2> coord = {testActiveArray[2] / 2, testActiveArray[3] / 2};
+    ASSERT_EQ(m.mapRawToCorrected(coord.data(), 1, mapperInfo, /*clamp*/false,
+            /*simple*/false), OK);
+
+    std::default_random_engine gen(0xBADF00D);
+    // Include points outside of the pre-correction array
+    std::uniform_int_distribution<int32_t> x_dist(-100, testPreCorrActiveArray[2] + 100);
+    std::uniform_int_distribution<int32_t> y_dist(-100, testPreCorrActiveArray[3] + 100);
+    for (int i = 0; i < 10000; i++) {
+        int32_t pt[2] = {x_dist(gen), y_dist(gen)};
+        EXPECT_EQ(DistortionMapper::findEnclosingQuad(pt, *mapperInfo),
+                DistortionMapper::findEnclosingQuad(pt, mapperInfo->mDistortedGrid))
+                << "Mismatched quad for (" << pt[0] << ", " << pt[1] << ")";
+    }
+}
+
 // Compare against values calculated by OpenCV
 // undistortPoints() method, which is the same as mapRawToCorrected
 // Ignore clamping
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "InFlightRequestMapTest"
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+static InFlightRequest makeRequest(int numBuffers) {
+    InFlightRequest r;
+    r.numBuffersLeft = numBuffers;
+    return r;
+}
+
+TEST(InFlightRequestMapTest, OrderedAccess) {
+    InFlightRequestMap map(4);
+
+    for (uint32_t frameNumber = 10; frameNumber < 14; frameNumber++) {
+        ASSERT_EQ(map.add(frameNumber, makeRequest(frameNumber)), (ssize_t)(frameNumber - 10));
+    }
+    ASSERT_EQ(map.add(12, makeRequest(0)), ALREADY_EXISTS);
+    ASSERT_EQ(map.size(), 4u);
+
+    // Out-of-order removal keeps the remaining entries in frame order.
+    ssize_t idx = map.indexOfKey(12);
+    ASSERT_EQ(idx, 2);
+    map.removeItemsAt(idx, 1);
+    ASSERT_EQ(map.indexOfKey(12), NAME_NOT_FOUND);
+    ASSERT_EQ(map.size(), 3u);
+    ASSERT_EQ(map.keyAt(0), 10u);
+    ASSERT_EQ(map.keyAt(1), 11u);
+    ASSERT_EQ(map.keyAt(2), 13u);
+    ASSERT_EQ(map.valueAt(2).numBuffersLeft, 13);
+
+    map.editValueAt(map.indexOfKey(11)).numBuffersLeft = 0;
+    ASSERT_EQ(map.valueAt(1).numBuffersLeft, 0);
+
+    map.removeItemsAt(0, 1);
+    ASSERT_EQ(map.indexOfKey(13), 1);
+    ASSERT_EQ(map.getLatencyCount(), 2u);
+    ASSERT_GE(map.getMaxLatencyNs(), map.getAverageLatencyNs());
+
+    map.clear();
+    ASSERT_TRUE(map.isEmpty());
+    ASSERT_EQ(map.indexOfKey(13), NAME_NOT_FOUND);
+}
+
+TEST(InFlightRequestMapTest, Collisions) {
+    InFlightRequestMap map(4);
+
+    // More requests in flight than the initial capacity.
+    for (uint32_t frameNumber = 0; frameNumber < 100; frameNumber++) {
+        ASSERT_EQ(map.add(frameNumber, makeRequest(frameNumber)), (ssize_t)frameNumber);
+    }
+    for (uint32_t frameNumber = 0; frameNumber < 100; frameNumber++) {
+        ssize_t idx = map.indexOfKey(frameNumber);
+        ASSERT_EQ(idx, (ssize_t)frameNumber);
+        ASSERT_EQ(map.valueAt(idx).numBuffersLeft, (int)frameNumber);
+    }
+
+    // A request stuck in flight while frame numbers move far ahead.
+    InFlightRequestMap stuckMap(4);
+    ASSERT_EQ(stuckMap.add(0, makeRequest(0)), 0);
+    for (uint32_t frameNumber = 1; frameNumber < 10 * InFlightRequestMap::kMaxCapacity;
+            frameNumber++) {
+        ASSERT_EQ(stuckMap.add(frameNumber, makeRequest(frameNumber)), 1);
+        ASSERT_EQ(stuckMap.keyAt(1), frameNumber);
+        stuckMap.removeItemsAt(1, 1);
+    }
+    ASSERT_EQ(stuckMap.size(), 1u);
+    ASSERT_EQ(stuckMap.indexOfKey(0), 0);
+
+    // Frame numbers colliding at the maximum capacity.
+    ASSERT_EQ(stuckMap.add(InFlightRequestMap::kMaxCapacity, makeRequest(1)), 1);
+    ASSERT_EQ(stuckMap.add(2 * InFlightRequestMap::kMaxCapacity, makeRequest(2)), 2);
+    ASSERT_EQ(stuckMap.valueAt(stuckMap.indexOfKey(InFlightRequestMap::kMaxCapacity))
+            .numBuffersLeft, 1);
+    ASSERT_EQ(stuckMap.valueAt(stuckMap.indexOfKey(2 * InFlightRequestMap::kMaxCapacity))
+            .numBuffersLeft, 2);
+    stuckMap.removeItemsAt(0, 2);
+    ASSERT_EQ(stuckMap.size(), 1u);
+    ASSERT_EQ(stuckMap.keyAt(0), 2 * InFlightRequestMap::kMaxCapacity);
+}
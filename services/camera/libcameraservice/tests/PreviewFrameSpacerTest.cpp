@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "PreviewFrameSpacerTest"
+
+#include <gtest/gtest.h>
+
+#include "../device3/PreviewFrameSpacer.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+const nsecs_t kFrameInterval30Fps = 33333333;
+const nsecs_t kFrameInterval60Fps = 16666667;
+
+// Feed frames at the given interval, with a pipeline latency of baseLatency, and of
+// baseLatency + jitter for one frame out of jitterPeriod.
+nsecs_t feedFrames(PreviewPacingModel* model, nsecs_t startTime, size_t count,
+        nsecs_t interval, nsecs_t baseLatency, nsecs_t jitter, size_t jitterPeriod) {
+    nsecs_t readoutTime = startTime;
+    for (size_t i = 0; i < count; i++) {
+        nsecs_t latency = (i % jitterPeriod == 0) ? baseLatency + jitter : baseLatency;
+        model->onFrameArrived(readoutTime, readoutTime + latency);
+        readoutTime += interval;
+    }
+    return readoutTime;
+}
+
+} // anonymous namespace
+
+TEST(PreviewPacingModelTest, TargetsLatencyPercentile) {
+    PreviewPacingModel model(/*jitterPercentile*/90);
+    ASSERT_FALSE(model.isValid());
+
+    // 1 frame out of 4 arrives 8ms late
+    feedFrames(&model, ms2ns(1000), PreviewPacingModel::kLatencyWindow, kFrameInterval30Fps,
+            ms2ns(20), ms2ns(8), /*jitterPeriod*/4);
+    ASSERT_TRUE(model.isValid());
+    EXPECT_NEAR(model.getFrameInterval(), kFrameInterval30Fps, us2ns(10));
+    // The late frames are more than 10% of the frames, so they are smoothed out
+    EXPECT_EQ(model.getTargetLatency(), ms2ns(28));
+
+    // 1 frame out of 16 arriving late is left out of the 90th percentile
+    PreviewPacingModel lowJitterModel(/*jitterPercentile*/90);
+    feedFrames(&lowJitterModel, ms2ns(1000), PreviewPacingModel::kLatencyWindow,
+            kFrameInterval30Fps, ms2ns(20), ms2ns(8), /*jitterPeriod*/16);
+    EXPECT_EQ(lowJitterModel.getTargetLatency(), ms2ns(20));
+
+    nsecs_t readoutTime = ms2ns(5000);
+    EXPECT_EQ(lowJitterModel.getTargetQueueTime(readoutTime, /*lastQueueTime*/0),
+            readoutTime + ms2ns(20) - PreviewPacingModel::kQueueOverhead);
+}
+
+TEST(PreviewPacingModelTest, FollowsFrameRateChanges) {
+    PreviewPacingModel model;
+    nsecs_t readoutTime = feedFrames(&model, ms2ns(1000), 10, kFrameInterval30Fps, ms2ns(30),
+            0, /*jitterPeriod*/1);
+    EXPECT_EQ(model.getTargetLatency(), ms2ns(30));
+
+    // Switching to 60fps restarts the estimates right away
+    feedFrames(&model, readoutTime, 2, kFrameInterval60Fps, ms2ns(15), 0, /*jitterPeriod*/1);
+    EXPECT_EQ(model.getFrameInterval(), kFrameInterval60Fps);
+    EXPECT_EQ(model.getTargetLatency(), ms2ns(15));
+
+    // A pause in the stream invalidates the model until the next frame
+    PreviewPacingModel pausedModel;
+    readoutTime = feedFrames(&pausedModel, ms2ns(1000), 10, kFrameInterval30Fps, ms2ns(30), 0,
+            /*jitterPeriod*/1);
+    pausedModel.onFrameArrived(readoutTime + ms2ns(500), readoutTime + ms2ns(530));
+    EXPECT_FALSE(pausedModel.isValid());
+}
+
+TEST(PreviewPacingModelTest, SpacesFramesForDisplay) {
+    PreviewPacingModel model;
+    nsecs_t readoutTime = feedFrames(&model, ms2ns(1000), 10, kFrameInterval30Fps, ms2ns(20),
+            0, /*jitterPeriod*/1);
+    nsecs_t expectedTime = readoutTime + ms2ns(20) - PreviewPacingModel::kQueueOverhead;
+
+    // The previous frame was queued late, less than half a display frame ago
+    nsecs_t lastQueueTime = expectedTime - ms2ns(2);
+    EXPECT_EQ(model.getTargetQueueTime(readoutTime, lastQueueTime), expectedTime);
+    model.setDisplayFrameInterval(kFrameInterval60Fps);
+    EXPECT_EQ(model.getTargetQueueTime(readoutTime, lastQueueTime),
+            lastQueueTime + kFrameInterval60Fps / 2);
+
+    // No spacing when the camera runs faster than the display
+    PreviewPacingModel fastModel;
+    readoutTime = feedFrames(&fastModel, ms2ns(1000), 10, kFrameInterval60Fps, ms2ns(20), 0,
+            /*jitterPeriod*/1);
+    fastModel.setDisplayFrameInterval(kFrameInterval30Fps);
+    expectedTime = readoutTime + ms2ns(20) - PreviewPacingModel::kQueueOverhead;
+    EXPECT_EQ(fastModel.getTargetQueueTime(readoutTime, expectedTime - ms2ns(2)), expectedTime);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "SessionStatsBuilderTest"
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../utils/SessionStatsBuilder.h"
+
+using namespace android;
+
+TEST(SessionStatsBuilderTest, StageLatencyBins) {
+    ASSERT_EQ(StageLatencyHistogram::getBinIndex(0), 0u);
+    ASSERT_EQ(StageLatencyHistogram::getBinIndex(499999), 0u);
+    ASSERT_EQ(StageLatencyHistogram::getBinIndex(500000), 1u);
+    ASSERT_EQ(StageLatencyHistogram::getBinIndex(ms2ns(40)), 7u);
+    ASSERT_EQ(StageLatencyHistogram::getBinIndex(ms2ns(1000)),
+            (size_t)StageLatencyHistogram::BIN_COUNT - 1);
+}
+
+TEST(SessionStatsBuilderTest, StreamStageLatency) {
+    SessionStatsBuilder builder;
+    ASSERT_EQ(builder.addStream(0), OK);
+
+    builder.addStageLatency(LATENCY_STAGE_SHUTTER, ms2ns(40));
+    builder.incCounter(0, /*dropped*/false, /*captureLatencyMs*/50,
+            /*bufferReturnLatencyNs*/ms2ns(3), /*consumerQueueLatencyNs*/us2ns(100));
+    // Unknown stage latencies are not accounted for.
+    builder.incCounter(0, /*dropped*/true, /*captureLatencyMs*/50);
+
+    int64_t requestCount, errorResultCount;
+    bool deviceError;
+    std::map<int, StreamStats> statsMap;
+    builder.buildAndReset(&requestCount, &errorResultCount, &deviceError, &statsMap);
+    ASSERT_EQ(statsMap.size(), 1u);
+    const StreamStats& stats = statsMap[0];
+    ASSERT_EQ(stats.mRequestedFrameCount, 2);
+    ASSERT_EQ(stats.mBufferReturnLatencyHistogram[3], 1);
+    ASSERT_EQ(stats.mConsumerQueueLatencyHistogram[0], 1);
+    int64_t total = 0;
+    for (int64_t count : stats.mBufferReturnLatencyHistogram) total += count;
+    ASSERT_EQ(total, 1);
+
+    // Stats are reset after being built.
+    builder.buildAndReset(&requestCount, &errorResultCount, &deviceError, &statsMap);
+    ASSERT_EQ(statsMap[0].mBufferReturnLatencyHistogram[3], 0);
+}
+
+TEST(SessionStatsBuilderTest, PreviewSpacingLatency) {
+    SessionStatsBuilder builder;
+    ASSERT_EQ(builder.addStream(0), OK);
+
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> counts{};
+    counts[2] = 3;
+    builder.addPreviewSpacingLatency(0, counts);
+    builder.addPreviewSpacingLatency(0, counts);
+    // Unknown streams are ignored.
+    builder.addPreviewSpacingLatency(1, counts);
+
+    int64_t requestCount, errorResultCount;
+    bool deviceError;
+    std::map<int, StreamStats> statsMap;
+    builder.buildAndReset(&requestCount, &errorResultCount, &deviceError, &statsMap);
+    ASSERT_EQ(statsMap.size(), 1u);
+    ASSERT_EQ(statsMap[0].mPreviewSpacingLatencyHistogram[2], 6);
+
+    builder.buildAndReset(&requestCount, &errorResultCount, &deviceError, &statsMap);
+    ASSERT_EQ(statsMap[0].mPreviewSpacingLatencyHistogram[2], 0);
+}
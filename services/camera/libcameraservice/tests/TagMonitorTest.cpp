@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "TagMonitorTest"
+
+#include <gtest/gtest.h>
+
+#include "../utils/TagMonitor.h"
+
+using namespace android;
+
+namespace {
+
+const std::unordered_map<std::string, CameraMetadata> kNoPhysicalMetadata;
+
+CameraMetadata makeResult(uint8_t afState) {
+    CameraMetadata metadata;
+    metadata.update(ANDROID_CONTROL_AF_STATE, &afState, 1);
+    return metadata;
+}
+
+} // anonymous namespace
+
+TEST(TagMonitorTest, RecordsChanges) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor(String8("android.control.afState"));
+    ASSERT_TRUE(monitor.isMonitoringEnabled());
+
+    monitor.monitorMetadata(TagMonitor::RESULT, 1, 1000, makeResult(0), kNoPhysicalMetadata);
+    // Unchanged value, not recorded
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, 2000, makeResult(0), kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 3, 3000, makeResult(1), kNoPhysicalMetadata);
+    // Removed value
+    monitor.monitorMetadata(TagMonitor::RESULT, 4, 4000, CameraMetadata(), kNoPhysicalMetadata);
+
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    ASSERT_EQ(events.size(), 3u);
+    // Most recent first
+    EXPECT_EQ(events[0].find("f4:4000ns"), 0u);
+    EXPECT_NE(events[0].find("(Removed)"), std::string::npos);
+    EXPECT_EQ(events[1].find("f3:3000ns"), 0u);
+    EXPECT_NE(events[1].find("android.control.afState"), std::string::npos);
+    EXPECT_EQ(events[2].find("f1:1000ns"), 0u);
+}
+
+TEST(TagMonitorTest, KeepsLatestEvents) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor(String8("android.control.afState"));
+
+    const int kFrameCount = 1000;
+    for (int i = 1; i <= kFrameCount; i++) {
+        monitor.monitorMetadata(TagMonitor::RESULT, i, i * 1000, makeResult(i % 2),
+                kNoPhysicalMetadata);
+    }
+
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    ASSERT_FALSE(events.empty());
+    ASSERT_LT(events.size(), static_cast<size_t>(kFrameCount));
+    std::string latest = "f" + std::to_string(kFrameCount) + ":";
+    EXPECT_EQ(events[0].find(latest), 0u);
+    std::string oldest = "f" + std::to_string(kFrameCount - events.size() + 1) + ":";
+    EXPECT_EQ(events.back().find(oldest), 0u);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CameraStaticInfoCache"
+//#define LOG_NDEBUG 0
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include <utils/Log.h>
+
+#include "CameraStaticInfoCache.h"
+
+namespace android {
+
+const char* CameraStaticInfoCache::kFileSuffix = ".bin";
+
+namespace {
+
+// Keep file names free of path separators and other special characters.
+std::string sanitize(const std::string& name) {
+    std::string ret = name;
+    for (auto& c : ret) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '_') {
+            c = '_';
+        }
+    }
+    return ret;
+}
+
+std::string getKey(const std::string& providerName, const std::string& deviceName,
+        const std::string& physicalId) {
+    return providerName + "/" + deviceName + "/" + physicalId;
+}
+
+bool readU32(std::ifstream& in, uint32_t* value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(value), sizeof(*value)));
+}
+
+bool readString(std::ifstream& in, std::string* value) {
+    uint32_t size = 0;
+    if (!readU32(in, &size) || size > PATH_MAX) {
+        return false;
+    }
+    value->resize(size);
+    return static_cast<bool>(in.read(value->data(), size));
+}
+
+void writeU32(std::ofstream& out, uint32_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::ofstream& out, const std::string& value) {
+    writeU32(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+} // anonymous namespace
+
+CameraStaticInfoCache::CameraStaticInfoCache(const std::string& directory,
+        const std::string& buildFingerprint) :
+        mDirectory(directory),
+        mBuildFingerprint(buildFingerprint) {
+}
+
+std::string CameraStaticInfoCache::getDevicePrefix(const std::string& providerName,
+        const std::string& deviceName) {
+    return sanitize(providerName) + "-" + sanitize(deviceName);
+}
+
+std::string CameraStaticInfoCache::getPath(const std::string& providerName,
+        const std::string& deviceName, const std::string& physicalId) const {
+    std::string path = mDirectory + "/" + getDevicePrefix(providerName, deviceName);
+    if (!physicalId.empty()) {
+        path += "-" + sanitize(physicalId);
+    }
+    return path + kFileSuffix;
+}
+
+bool CameraStaticInfoCache::read(const std::string& providerName, const std::string& deviceName,
+        const std::string& physicalId, std::vector<uint8_t>* metadata) {
+    if (metadata == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    std::string path = getPath(providerName, deviceName, physicalId);
+    std::ifstream in(path, std::ios::binary);
+    uint32_t magic = 0, version = 0, size = 0;
+    std::string fingerprint, key;
+    bool valid = in.is_open() && readU32(in, &magic) && magic == kMagic &&
+            readU32(in, &version) && version == kVersion &&
+            readString(in, &fingerprint) && fingerprint == mBuildFingerprint &&
+            readString(in, &key) && key == getKey(providerName, deviceName, physicalId) &&
+            readU32(in, &size);
+    if (valid) {
+        metadata->resize(size);
+        valid = static_cast<bool>(in.read(reinterpret_cast<char*>(metadata->data()), size));
+    }
+
+    if (!valid) {
+        ALOGV("%s: No valid cache entry for %s", __FUNCTION__, path.c_str());
+        metadata->clear();
+        mMissCount++;
+        return false;
+    }
+    mHitCount++;
+    return true;
+}
+
+status_t CameraStaticInfoCache::write(const std::string& providerName,
+        const std::string& deviceName, const std::string& physicalId,
+        const std::vector<uint8_t>& metadata) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mkdir(mDirectory.c_str(), 0700) != 0 && errno != EEXIST) {
+        ALOGE("%s: Unable to create cache directory %s: %s", __FUNCTION__, mDirectory.c_str(),
+                strerror(errno));
+        return -errno;
+    }
+
+    // Write to a temporary file first, so that a reader never sees a partial entry.
+    std::string path = getPath(providerName, deviceName, physicalId);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            ALOGE("%s: Unable to open %s", __FUNCTION__, tmpPath.c_str());
+            return INVALID_OPERATION;
+        }
+        writeU32(out, kMagic);
+        writeU32(out, kVersion);
+        writeString(out, mBuildFingerprint);
+        writeString(out, getKey(providerName, deviceName, physicalId));
+        writeU32(out, metadata.size());
+        out.write(reinterpret_cast<const char*>(metadata.data()), metadata.size());
+        if (!out.good()) {
+            ALOGE("%s: Unable to write %s", __FUNCTION__, tmpPath.c_str());
+            out.close();
+            unlink(tmpPath.c_str());
+            return INVALID_OPERATION;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOGE("%s: Unable to rename %s: %s", __FUNCTION__, tmpPath.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return INVALID_OPERATION;
+    }
+    return OK;
+}
+
+void CameraStaticInfoCache::invalidate(const std::string& providerName,
+        const std::string& deviceName) {
+    std::lock_guard<std::mutex> lock(mLock);
+    DIR* dir = opendir(mDirectory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+
+    std::string prefix = getDevicePrefix(providerName, deviceName);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name(entry->d_name);
+        if (name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        // Only match the device's own entry and its physical camera entries.
+        std::string rest = name.substr(prefix.size());
+        if (rest != kFileSuffix && rest.compare(0, 1, "-") != 0) {
+            continue;
+        }
+        std::string path = mDirectory + "/" + name;
+        ALOGV("%s: Removing %s", __FUNCTION__, path.c_str());
+        unlink(path.c_str());
+    }
+    closedir(dir);
+}
+
+size_t CameraStaticInfoCache::getHitCount() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mHitCount;
+}
+
+size_t CameraStaticInfoCache::getMissCount() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mMissCount;
+}
+
+}; // namespace android
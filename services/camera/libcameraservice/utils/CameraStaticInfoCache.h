@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_STATIC_INFO_CACHE_H_
+#define ANDROID_SERVERS_CAMERA_STATIC_INFO_CACHE_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <utils/Errors.h>
+
+namespace android {
+
+/**
+ * On-disk cache of the static characteristics returned by camera provider HALs.
+ *
+ * Entries are keyed by provider name, camera device name (which carries the device HAL
+ * version) and an optional physical camera id. Every entry also records the build
+ * fingerprint it was written with; entries from a different build are treated as misses,
+ * so HAL updates always go back to the provider.
+ *
+ * The cache stores the raw metadata buffers as received from the HAL, before any framework
+ * side fixups, and it does not validate them. Callers must validate the metadata structure
+ * of a cache hit the same way as a HAL result.
+ */
+class CameraStaticInfoCache {
+public:
+    CameraStaticInfoCache(const std::string& directory, const std::string& buildFingerprint);
+
+    // Read the cached characteristics. Returns false if there is no valid entry.
+    bool read(const std::string& providerName, const std::string& deviceName,
+            const std::string& physicalId, std::vector<uint8_t>* metadata);
+
+    // Store characteristics received from the provider.
+    status_t write(const std::string& providerName, const std::string& deviceName,
+            const std::string& physicalId, const std::vector<uint8_t>& metadata);
+
+    // Drop the entries of a camera device, including those of its physical cameras.
+    void invalidate(const std::string& providerName, const std::string& deviceName);
+
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+
+private:
+    static const uint32_t kMagic = 0x43534943; // 'CSIC'
+    static const uint32_t kVersion = 1;
+    static const char* kFileSuffix;
+
+    // File name prefix shared by all entries of a camera device.
+    static std::string getDevicePrefix(const std::string& providerName,
+            const std::string& deviceName);
+    std::string getPath(const std::string& providerName, const std::string& deviceName,
+            const std::string& physicalId) const;
+
+    const std::string mDirectory;
+    const std::string mBuildFingerprint;
+
+    mutable std::mutex mLock;
+    size_t mHitCount = 0;
+    size_t mMissCount = 0;
+}; // class CameraStaticInfoCache
+
+}; // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_STATIC_INFO_CACHE_H_
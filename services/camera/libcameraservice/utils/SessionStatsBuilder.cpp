@@ -21,6 +21,7 @@
 #include <numeric>
 
 #include <inttypes.h>
+#include <unistd.h>
 #include <utils/Log.h>
 
 #include "SessionStatsBuilder.h"
@@ -33,6 +34,11 @@ namespace android {
 const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1> StreamStats::mCaptureLatencyBins {
         { 100, 200, 300, 400, 500, 700, 900, 1300, 2100 } };
 
+// Bins for pipeline stage latency: [0, 0.5], [0.5, 1], [1, 2], ... [50, 100], [100, inf].
+// Stage latency is in the unit of microsecond.
+const std::array<int32_t, StageLatencyHistogram::BIN_COUNT-1> StageLatencyHistogram::mBinsUs {
+        { 500, 1000, 2000, 5000, 10000, 20000, 33000, 50000, 100000 } };
+
 status_t SessionStatsBuilder::addStream(int id) {
     std::lock_guard<std::mutex> l(mLock);
     StreamStats stats;
@@ -70,6 +76,12 @@ void SessionStatsBuilder::buildAndReset(int64_t* requestCount,
 
         std::fill(streamStat.mCaptureLatencyHistogram.begin(),
                 streamStat.mCaptureLatencyHistogram.end(), 0);
+        streamStat.mBufferReturnLatencyHistogram.fill(0);
+        streamStat.mConsumerQueueLatencyHistogram.fill(0);
+        streamStat.mPreviewSpacingLatencyHistogram.fill(0);
+    }
+    for (auto& stageLatency : mStageLatency) {
+        stageLatency.reset();
     }
 }
 
@@ -84,7 +96,8 @@ void SessionStatsBuilder::stopCounter(int id) {
     streamStat.mCounterStopped = true;
 }
 
-void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatencyMs) {
+void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatencyMs,
+        nsecs_t bufferReturnLatencyNs, nsecs_t consumerQueueLatencyNs) {
     std::lock_guard<std::mutex> l(mLock);
 
     auto it = mStatsMap.find(id);
@@ -102,6 +115,29 @@ void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatenc
     }
 
     streamStat.updateLatencyHistogram(captureLatencyMs);
+
+    if (bufferReturnLatencyNs >= 0) {
+        streamStat.mBufferReturnLatencyHistogram[
+                StageLatencyHistogram::getBinIndex(bufferReturnLatencyNs)]++;
+        mStageLatency[LATENCY_STAGE_BUFFER_RETURN].add(bufferReturnLatencyNs);
+    }
+    if (consumerQueueLatencyNs >= 0) {
+        streamStat.mConsumerQueueLatencyHistogram[
+                StageLatencyHistogram::getBinIndex(consumerQueueLatencyNs)]++;
+        mStageLatency[LATENCY_STAGE_CONSUMER_QUEUE].add(consumerQueueLatencyNs);
+    }
+}
+
+void SessionStatsBuilder::addPreviewSpacingLatency(int id,
+        const std::array<int64_t, StageLatencyHistogram::BIN_COUNT>& counts) {
+    std::lock_guard<std::mutex> l(mLock);
+
+    auto it = mStatsMap.find(id);
+    if (it == mStatsMap.end()) return;
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        it->second.mPreviewSpacingLatencyHistogram[i] += counts[i];
+    }
 }
 
 void SessionStatsBuilder::stopCounter() {
@@ -125,6 +161,95 @@ void SessionStatsBuilder::onDeviceError() {
     mDeviceError = true;
 }
 
+void SessionStatsBuilder::addStageLatency(LatencyStage stage, nsecs_t latencyNs) {
+    mStageLatency[stage].add(latencyNs);
+}
+
+void SessionStatsBuilder::dump(int fd) {
+    static const char* kStageNames[LATENCY_STAGE_COUNT] = {
+        "Request queue -> HAL submit",
+        "HAL submit -> shutter",
+        "Shutter -> buffer return",
+        "Buffer return -> consumer queue",
+    };
+
+    String8 lines;
+    lines.append("    Pipeline stage latency histograms (bins in us):\n");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        StageLatencyHistogram::format(lines, kStageNames[stage],
+                mStageLatency[stage].getCounts());
+    }
+
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        for (const auto& streamStats : mStatsMap) {
+            String8 name = String8::format("Stream %d: %s", streamStats.first,
+                    kStageNames[LATENCY_STAGE_BUFFER_RETURN]);
+            StageLatencyHistogram::format(lines, name.c_str(),
+                    streamStats.second.mBufferReturnLatencyHistogram);
+            name = String8::format("Stream %d: %s", streamStats.first,
+                    kStageNames[LATENCY_STAGE_CONSUMER_QUEUE]);
+            StageLatencyHistogram::format(lines, name.c_str(),
+                    streamStats.second.mConsumerQueueLatencyHistogram);
+            name = String8::format("Stream %d: Preview spacing", streamStats.first);
+            StageLatencyHistogram::format(lines, name.c_str(),
+                    streamStats.second.mPreviewSpacingLatencyHistogram);
+        }
+    }
+    write(fd, lines.string(), lines.size());
+}
+
+size_t StageLatencyHistogram::getBinIndex(nsecs_t latencyNs) {
+    int64_t latencyUs = ns2us(latencyNs);
+    size_t i;
+    for (i = 0; i < mBinsUs.size(); i++) {
+        if (latencyUs < mBinsUs[i]) {
+            break;
+        }
+    }
+    return i;
+}
+
+void StageLatencyHistogram::add(nsecs_t latencyNs) {
+    mCounts[getBinIndex(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void StageLatencyHistogram::reset() {
+    for (auto& count : mCounts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::array<int64_t, StageLatencyHistogram::BIN_COUNT> StageLatencyHistogram::getCounts() const {
+    std::array<int64_t, BIN_COUNT> counts;
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = mCounts[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+void StageLatencyHistogram::format(String8& lines, const char* name,
+        const std::array<int64_t, BIN_COUNT>& counts) {
+    int64_t total = std::accumulate(counts.begin(), counts.end(), int64_t(0));
+    if (total == 0) {
+        return;
+    }
+
+    lines.appendFormat("      %s (%" PRId64 ") samples\n       ", name, total);
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (i == counts.size() - 1) {
+            lines.append("      inf");
+        } else {
+            lines.appendFormat("%9d", mBinsUs[i]);
+        }
+    }
+    lines.append("\n       ");
+    for (size_t i = 0; i < counts.size(); i++) {
+        lines.appendFormat("%9.2f", 100.0 * counts[i] / total);
+    }
+    lines.append(" (%)\n");
+}
+
 void StreamStats::updateLatencyHistogram(int32_t latencyMs) {
     size_t i;
     for (i = 0; i < mCaptureLatencyBins.size(); i++) {
@@ -18,13 +18,49 @@
 #define ANDROID_SERVICE_UTILS_SESSION_STATS_BUILDER_H
 
 #include <utils/Errors.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
 
 #include <array>
+#include <atomic>
 #include <map>
 #include <mutex>
 
 namespace android {
 
+// Stages of the capture pipeline whose latency is tracked
+enum LatencyStage {
+    // Request inserted into the request queue -> submitted to the HAL
+    LATENCY_STAGE_REQUEST_SUBMIT = 0,
+    // Request submitted to the HAL -> shutter notification
+    LATENCY_STAGE_SHUTTER,
+    // Shutter notification -> output buffer returned by the HAL (per stream)
+    LATENCY_STAGE_BUFFER_RETURN,
+    // Output buffer returned by the HAL -> queued to the consumer (per stream)
+    LATENCY_STAGE_CONSUMER_QUEUE,
+    LATENCY_STAGE_COUNT
+};
+
+// Helper class for pipeline stage latency histograms. Updates don't take any lock, so
+// that they can be done from the request and result paths.
+struct StageLatencyHistogram {
+    const static int BIN_COUNT = 10;
+    // Boundary values separating between adjacent bins, in microseconds, excluding 0 and
+    // infinity.
+    const static std::array<int32_t, BIN_COUNT-1> mBinsUs;
+    std::array<std::atomic<int64_t>, BIN_COUNT> mCounts;
+
+    StageLatencyHistogram() : mCounts{} {}
+
+    static size_t getBinIndex(nsecs_t latencyNs);
+    void add(nsecs_t latencyNs);
+    void reset();
+    std::array<int64_t, BIN_COUNT> getCounts() const;
+
+    static void format(String8& lines, const char* name,
+            const std::array<int64_t, BIN_COUNT>& counts);
+};
+
 // Helper class to build stream stats
 struct StreamStats {
     // Fields for buffer drop
@@ -43,11 +79,20 @@ struct StreamStats {
     // Counter values for all histogram bins. One more entry than mCaptureLatencyBins.
     std::array<int64_t, LATENCY_BIN_COUNT> mCaptureLatencyHistogram;
 
+    // Fields for per-stream pipeline stage latencies
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> mBufferReturnLatencyHistogram;
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> mConsumerQueueLatencyHistogram;
+    // Latency added by preview frame spacing
+    std::array<int64_t, StageLatencyHistogram::BIN_COUNT> mPreviewSpacingLatencyHistogram;
+
     StreamStats() : mRequestedFrameCount(0),
                      mDroppedFrameCount(0),
                      mCounterStopped(false),
                      mStartLatencyMs(0),
-                     mCaptureLatencyHistogram{}
+                     mCaptureLatencyHistogram{},
+                     mBufferReturnLatencyHistogram{},
+                     mConsumerQueueLatencyHistogram{},
+                     mPreviewSpacingLatencyHistogram{}
                   {}
 
     void updateLatencyHistogram(int32_t latencyMs);
@@ -69,13 +114,26 @@ public:
     // Stream specific counter
     void startCounter(int streamId);
     void stopCounter(int streamId);
-    void incCounter(int streamId, bool dropped, int32_t captureLatencyMs);
+    // bufferReturnLatencyNs and consumerQueueLatencyNs are the buffer's latencies for the
+    // LATENCY_STAGE_BUFFER_RETURN and LATENCY_STAGE_CONSUMER_QUEUE stages, or -1 if unknown.
+    void incCounter(int streamId, bool dropped, int32_t captureLatencyMs,
+            nsecs_t bufferReturnLatencyNs = -1, nsecs_t consumerQueueLatencyNs = -1);
+
+    // Accumulate the histogram of latency added by preview frame spacing for a stream
+    void addPreviewSpacingLatency(int streamId,
+            const std::array<int64_t, StageLatencyHistogram::BIN_COUNT>& counts);
 
     // Session specific counter
     void stopCounter();
     void incResultCounter(bool dropped);
     void onDeviceError();
 
+    // Session wide stage latency, doesn't take the stats lock
+    void addStageLatency(LatencyStage stage, nsecs_t latencyNs);
+
+    // Dump the stage latency histograms collected since the last buildAndReset().
+    void dump(int fd);
+
     SessionStatsBuilder() : mRequestCount(0), mErrorResultCount(0),
              mCounterStopped(false), mDeviceError(false) {}
 private:
@@ -87,6 +145,8 @@ private:
     std::string mUserTag;
     // Map from stream id to stream statistics
     std::map<int, StreamStats> mStatsMap;
+    // Session wide latency of each pipeline stage
+    std::array<StageLatencyHistogram, LATENCY_STAGE_COUNT> mStageLatency;
 };
 
 }; // namespace android
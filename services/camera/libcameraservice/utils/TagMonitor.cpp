@@ -21,6 +21,9 @@
 #include "TagMonitor.h"
 
 #include <inttypes.h>
+
+#include <algorithm>
+
 #include <utils/Log.h>
 #include <camera/VendorTagDescriptor.h>
 #include <camera_metadata_hidden.h>
@@ -31,8 +34,13 @@ namespace android {
 TagMonitor::TagMonitor():
         mMonitoringEnabled(false),
         mMonitoringEvents(kMaxMonitorEvents),
+        mCameraIds(1),
         mVendorTagId(CAMERA_METADATA_INVALID_VENDOR_ID)
-{}
+{
+    for (auto& event : mMonitoringEvents) {
+        event.newData.reserve(kEventDataCapacity);
+    }
+}
 
 TagMonitor::TagMonitor(const TagMonitor& other):
         mMonitoringEnabled(other.mMonitoringEnabled.load()),
@@ -42,7 +50,14 @@ TagMonitor::TagMonitor(const TagMonitor& other):
         mLastMonitoredPhysicalRequestKeys(other.mLastMonitoredPhysicalRequestKeys),
         mLastMonitoredPhysicalResultKeys(other.mLastMonitoredPhysicalResultKeys),
         mMonitoringEvents(other.mMonitoringEvents),
-        mVendorTagId(other.mVendorTagId) {}
+        mNextEventIdx(other.mNextEventIdx),
+        mEventCount(other.mEventCount),
+        mCameraIds(other.mCameraIds),
+        mVendorTagId(other.mVendorTagId) {
+    for (auto& event : mMonitoringEvents) {
+        event.newData.reserve(kEventDataCapacity);
+    }
+}
 
 const String16 TagMonitor::kMonitorOption = String16("-m");
 
@@ -129,27 +144,55 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
     if (timestamp == 0) {
         timestamp = systemTime(SYSTEM_TIME_BOOTTIME);
     }
-    std::unordered_set<int32_t> outputStreamIds;
+    mStreamIds.clear();
     for (size_t i = 0; i < numOutputBuffers; i++) {
         const camera3::camera_stream_buffer_t *src = outputBuffers + i;
-        int32_t streamId = camera3::Camera3Stream::cast(src->stream)->getId();
-        outputStreamIds.emplace(streamId);
+        mStreamIds.push_back(camera3::Camera3Stream::cast(src->stream)->getId());
     }
-    std::string emptyId;
+    std::sort(mStreamIds.begin(), mStreamIds.end());
+    mStreamIds.erase(std::unique(mStreamIds.begin(), mStreamIds.end()), mStreamIds.end());
+
+    const std::string& logicalId = mCameraIds[0];
     for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata,
-                outputStreamIds, inputStreamId);
+        monitorSingleMetadata(source, frameNumber, timestamp, logicalId, tag, metadata,
+                inputStreamId);
 
         for (auto& m : physicalMetadata) {
             monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second,
-                    outputStreamIds, inputStreamId);
+                    inputStreamId);
         }
     }
 }
 
+TagMonitor::MonitorEvent& TagMonitor::nextEventLocked(eventSource source,
+        MonitorEvent::eventKind kind, int64_t frameNumber, nsecs_t timestamp,
+        const std::string& cameraId) {
+    auto it = std::find(mCameraIds.begin(), mCameraIds.end(), cameraId);
+    if (it == mCameraIds.end()) {
+        it = mCameraIds.insert(mCameraIds.end(), cameraId);
+    }
+
+    MonitorEvent& event = mMonitoringEvents[mNextEventIdx];
+    mNextEventIdx = (mNextEventIdx + 1) % kMaxMonitorEvents;
+    mEventCount = std::min(mEventCount + 1, kMaxMonitorEvents);
+
+    event.source = source;
+    event.kind = kind;
+    event.type = 0;
+    event.cameraIdx = static_cast<uint16_t>(it - mCameraIds.begin());
+    event.frameNumber = frameNumber;
+    event.timestamp = timestamp;
+    event.tag = 0;
+    event.inputStreamId = -1;
+    event.count = 0;
+    event.newData.clear();
+    event.outputStreamIds.clear();
+    return event;
+}
+
 void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
         const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata,
-        const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId) {
+        int32_t inputStreamId) {
 
     CameraMetadata &lastValues = (source == REQUEST) ?
             (cameraId.empty() ? mLastMonitoredRequestValues :
@@ -174,15 +217,17 @@ void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber,
     // stream ids.
     if (source == REQUEST) {
         if (inputStreamId != mLastInputStreamId) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, std::unordered_set<int>(), inputStreamId);
+            MonitorEvent& event = nextEventLocked(source, MonitorEvent::INPUT_STREAM,
+                    frameNumber, timestamp, cameraId);
+            event.inputStreamId = inputStreamId;
             mLastInputStreamId = inputStreamId;
         }
 
-        if (outputStreamIds != mLastStreamIds) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, outputStreamIds, -1);
-            mLastStreamIds = outputStreamIds;
+        if (mStreamIds != mLastStreamIds) {
+            MonitorEvent& event = nextEventLocked(source, MonitorEvent::OUTPUT_STREAMS,
+                    frameNumber, timestamp, cameraId);
+            event.outputStreamIds.assign(mStreamIds.begin(), mStreamIds.end());
+            mLastStreamIds = mStreamIds;
         }
     }
     if (entry.count > 0) {
@@ -212,8 +257,13 @@ void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber,
                   get_local_camera_metadata_tag_name_vendor_id(
                           tag, mVendorTagId));
             lastValues.update(entry);
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                      std::unordered_set<int>(), -1);
+            MonitorEvent& event = nextEventLocked(source, MonitorEvent::TAG_VALUE,
+                    frameNumber, timestamp, cameraId);
+            event.tag = tag;
+            event.type = entry.type;
+            event.count = entry.count;
+            event.newData.assign(entry.data.u8,
+                    entry.data.u8 + camera_metadata_type_size[entry.type] * entry.count);
         }
     } else if (lastEntry.count > 0) {
         // Value has been removed
@@ -221,14 +271,12 @@ void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber,
               get_local_camera_metadata_tag_name_vendor_id(
                       tag, mVendorTagId));
         lastValues.erase(tag);
-        entry.tag = tag;
-        entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
-                mVendorTagId);
-        entry.count = 0;
         mLastInputStreamId = inputStreamId;
-        mLastStreamIds = outputStreamIds;
-        mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                  std::unordered_set<int>(), -1);
+        mLastStreamIds = mStreamIds;
+        MonitorEvent& event = nextEventLocked(source, MonitorEvent::TAG_VALUE,
+                frameNumber, timestamp, cameraId);
+        event.tag = tag;
+        event.type = get_local_camera_metadata_tag_type_vendor_id(tag, mVendorTagId);
     }
 }
 
@@ -248,7 +296,7 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
         dprintf(fd, "     Tag monitoring disabled (enable with -m <name1,..,nameN>)\n");
     }
 
-    if (mMonitoringEvents.size() == 0) { return; }
+    if (mEventCount == 0) { return; }
 
     dprintf(fd, "     Monitored tag event log:\n");
 
@@ -265,17 +313,18 @@ void TagMonitor::getLatestMonitoredTagEvents(std::vector<std::string> &out) {
 }
 
 void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &vec) {
-    if (mMonitoringEvents.size() == 0) { return; }
-
-    for (const auto& event : mMonitoringEvents) {
+    // Most recent event first
+    for (size_t i = 0; i < mEventCount; i++) {
+        const MonitorEvent& event = mMonitoringEvents[
+                (mNextEventIdx + kMaxMonitorEvents - 1 - i) % kMaxMonitorEvents];
         int indentation = (event.source == REQUEST) ? 15 : 30;
         String8 eventString = String8::format("f%d:%" PRId64 "ns:%*s%*s",
                 event.frameNumber, event.timestamp,
-                2, event.cameraId.c_str(),
+                2, mCameraIds[event.cameraIdx].c_str(),
                 indentation,
                 event.source == REQUEST ? "REQ:" : "RES:");
 
-        if (!event.outputStreamIds.empty()) {
+        if (event.kind == MonitorEvent::OUTPUT_STREAMS) {
             eventString += " output stream ids:";
             for (const auto& id : event.outputStreamIds) {
                 eventString.appendFormat(" %d", id);
@@ -285,7 +334,7 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
             continue;
         }
 
-        if (event.inputStreamId != -1) {
+        if (event.kind == MonitorEvent::INPUT_STREAM) {
             eventString.appendFormat(" input stream id: %d\n", event.inputStreamId);
             vec.emplace_back(eventString.string());
             continue;
@@ -296,12 +345,11 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
                 get_local_camera_metadata_section_name_vendor_id(event.tag, mVendorTagId),
                 get_local_camera_metadata_tag_name_vendor_id(event.tag, mVendorTagId));
 
-        if (event.newData.empty()) {
+        if (event.count == 0) {
             eventString += " (Removed)\n";
         } else {
             eventString += getEventDataString(
-                    event.newData.data(), event.tag, event.type,
-                    event.newData.size() / camera_metadata_type_size[event.type], indentation + 18);
+                    event.newData.data(), event.tag, event.type, event.count, indentation + 18);
         }
         vec.emplace_back(eventString.string());
     }
@@ -386,22 +434,4 @@ String8 TagMonitor::getEventDataString(const uint8_t* data_ptr, uint32_t tag, in
     return returnStr;
 }
 
-template<typename T>
-TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-        const T &value, const std::string& cameraId,
-        const std::unordered_set<int32_t> &outputStreamIds,
-        int32_t inputStreamId) :
-        source(src),
-        frameNumber(frameNumber),
-        timestamp(timestamp),
-        cameraId(cameraId),
-        tag(value.tag),
-        type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
-        outputStreamIds(outputStreamIds),
-        inputStreamId(inputStreamId) {}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
-}
-
 } // namespace android
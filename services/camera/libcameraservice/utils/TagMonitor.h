@@ -26,7 +26,6 @@
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
-#include <media/RingBuffer.h>
 #include <system/camera_metadata.h>
 #include <system/camera_vendor_tags.h>
 #include <camera/CameraMetadata.h>
@@ -37,7 +36,10 @@ namespace android {
 /**
  * A monitor for camera metadata values.
  * Tracks changes to specified metadata values over time, keeping a circular
- * buffer log that can be dumped at will. */
+ * buffer log that can be dumped at will.
+ *
+ * The log is a preallocated ring of raw values, only formatted when dumped, so that
+ * monitoring doesn't allocate per event and can be left enabled. */
 class TagMonitor {
   public:
 
@@ -64,6 +66,9 @@ class TagMonitor {
     // Disable monitoring; does not clear the event log
     void disableMonitoring();
 
+    // Whether any tags are being monitored
+    bool isMonitoringEnabled() const { return mMonitoringEnabled; }
+
     // Scan through the metadata and update the monitoring information
     void monitorMetadata(eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,
@@ -90,8 +95,7 @@ class TagMonitor {
 
     void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata, const std::unordered_set<int32_t> &outputStreamIds,
-            int32_t inputStreamId);
+            const CameraMetadata& metadata, int32_t inputStreamId);
 
     std::atomic<bool> mMonitoringEnabled;
     std::mutex mMonitorMutex;
@@ -107,37 +111,53 @@ class TagMonitor {
     std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalResultKeys;
 
     int32_t mLastInputStreamId = -1;
-    std::unordered_set<int32_t> mLastStreamIds;
+    // Sorted output stream ids of the last request, and of the current one
+    std::vector<int32_t> mLastStreamIds;
+    std::vector<int32_t> mStreamIds;
 
     /**
      * A monitoring event
-     * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
+     * Stores a new metadata field value and the timestamp at which it changed, or a change
+     * of the request's streams. Events live in reused slots of mMonitoringEvents, and their
+     * storage keeps its capacity across reuse.
      */
     struct MonitorEvent {
-        template<typename T>
-        MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-                const T &newValue, const std::string& cameraId,
-                const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId);
-        ~MonitorEvent();
+        enum eventKind : uint8_t {
+            TAG_VALUE,
+            OUTPUT_STREAMS,
+            INPUT_STREAM
+        };
 
         eventSource source;
+        eventKind kind;
+        // Metadata type of the value
+        uint8_t type;
+        // Index of the camera id in mCameraIds
+        uint16_t cameraIdx;
         uint32_t frameNumber;
         nsecs_t timestamp;
-        std::string cameraId;
         uint32_t tag;
-        uint8_t type;
+        int32_t inputStreamId;
+        // Number of values in newData, 0 if the tag was removed
+        uint32_t count;
         std::vector<uint8_t> newData;
-        // NOTE: We want to print changes to outputStreamIds and inputStreamId in their own lines.
-        // So any MonitorEvent where these fields are not the default value will have garbage
-        // values for all fields other than source, frameNumber, timestamp, and cameraId.
-        std::unordered_set<int32_t> outputStreamIds;
-        int32_t inputStreamId = -1;
+        std::vector<int32_t> outputStreamIds;
     };
 
+    // Claim the slot of the next event, overwriting the oldest event if the ring is full
+    MonitorEvent& nextEventLocked(eventSource source, MonitorEvent::eventKind kind,
+            int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId);
+
     // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
-    static const int kMaxMonitorEvents = 100;
-    RingBuffer<MonitorEvent> mMonitoringEvents;
+    static constexpr size_t kMaxMonitorEvents = 100;
+    // Value bytes reserved per event; larger values grow the slot once
+    static constexpr size_t kEventDataCapacity = 64;
+    std::vector<MonitorEvent> mMonitoringEvents;
+    size_t mNextEventIdx = 0;
+    size_t mEventCount = 0;
+
+    // Camera ids of the events; the logical camera is at index 0 with an empty id
+    std::vector<std::string> mCameraIds;
 
     // 3A fields to use with the "3a" option
     static const char *k3aTags;
@@ -131,35 +131,14 @@ int32_t AudioPowerUsage::deviceFromStringPairs(const std::string& device_strings
     return deviceMask;
 }
 
-void AudioPowerUsage::sendItem(const std::shared_ptr<const mediametrics::Item>& item) const
+void AudioPowerUsage::sendUsage(int32_t audio_device, int32_t type, const Usage& usage) const
 {
-    int32_t type;
-    if (!item->getInt32(AUDIO_POWER_USAGE_PROP_TYPE, &type)) return;
-
-    int32_t audio_device;
-    if (!item->getInt32(AUDIO_POWER_USAGE_PROP_DEVICE, &audio_device)) return;
-
-    int64_t duration_ns;
-    if (!item->getInt64(AUDIO_POWER_USAGE_PROP_DURATION_NS, &duration_ns)) return;
-
-    double volume;
-    if (!item->getDouble(AUDIO_POWER_USAGE_PROP_VOLUME, &volume)) return;
-
-    int64_t min_volume_duration_ns;
-    if (!item->getInt64(AUDIO_POWER_USAGE_PROP_MIN_VOLUME_DURATION_NS, &min_volume_duration_ns)) {
-        return;
-    }
-
-    double min_volume;
-    if (!item->getDouble(AUDIO_POWER_USAGE_PROP_MIN_VOLUME, &min_volume)) return;
-
-    int64_t max_volume_duration_ns;
-    if (!item->getInt64(AUDIO_POWER_USAGE_PROP_MAX_VOLUME_DURATION_NS, &max_volume_duration_ns)) {
-        return;
-    }
-
-    double max_volume;
-    if (!item->getDouble(AUDIO_POWER_USAGE_PROP_MAX_VOLUME, &max_volume)) return;
+    const int64_t duration_ns = usage.durationNs;
+    const double volume = usage.volume;
+    const int64_t min_volume_duration_ns = usage.minVolumeDurationNs;
+    const double min_volume = usage.minVolume;
+    const int64_t max_volume_duration_ns = usage.maxVolumeDurationNs;
+    const double max_volume = usage.maxVolume;
 
     const int32_t duration_secs = (int32_t)(duration_ns / NANOS_PER_SECOND);
     const int32_t min_volume_duration_secs = (int32_t)(min_volume_duration_ns / NANOS_PER_SECOND);
@@ -190,6 +169,34 @@ void AudioPowerUsage::sendItem(const std::shared_ptr<const mediametrics::Item>&
     mStatsdLog->log(android::util::AUDIO_POWER_USAGE_DATA_REPORTED, log.str());
 }
 
+// Durations saturate rather than overflow, whatever the uptime.
+static int64_t saturatingAdd(int64_t a, int64_t b)
+{
+    int64_t sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return b < 0 ? INT64_MIN : INT64_MAX;
+    }
+    return sum;
+}
+
+/* static */
+int AudioPowerUsage::deviceToSlot(int32_t device)
+{
+    const bool isInput = (device & INPUT_DEVICE_BIT) != 0;
+    const int32_t bits = device & ~INPUT_DEVICE_BIT;
+    if (bits == 0) return -1;
+    const size_t bit = __builtin_ctz(bits);
+    if (bit >= (isInput ? kInputDeviceSlots : kOutputDeviceSlots)) return -1;
+    return isInput ? kOutputDeviceSlots + bit : bit;
+}
+
+/* static */
+int32_t AudioPowerUsage::slotToDevice(size_t slot)
+{
+    return slot < kOutputDeviceSlots ? 1 << slot
+            : INPUT_DEVICE_BIT | 1 << (slot - kOutputDeviceSlots);
+}
+
 void AudioPowerUsage::updateMinMaxVolumeAndDuration(
             const int64_t cur_max_volume_duration_ns, const double cur_max_volume,
             const int64_t cur_min_volume_duration_ns, const double cur_min_volume,
@@ -200,17 +207,19 @@ void AudioPowerUsage::updateMinMaxVolumeAndDuration(
         f_min_volume = cur_min_volume;
         f_min_volume_duration_ns = cur_min_volume_duration_ns;
     } else if (f_min_volume == cur_min_volume) {
-        f_min_volume_duration_ns += cur_min_volume_duration_ns;
+        f_min_volume_duration_ns =
+                saturatingAdd(f_min_volume_duration_ns, cur_min_volume_duration_ns);
     }
     if (f_max_volume < cur_max_volume) {
         f_max_volume = cur_max_volume;
         f_max_volume_duration_ns = cur_max_volume_duration_ns;
     } else if (f_max_volume == cur_max_volume) {
-        f_max_volume_duration_ns += cur_max_volume_duration_ns;
+        f_max_volume_duration_ns =
+                saturatingAdd(f_max_volume_duration_ns, cur_max_volume_duration_ns);
     }
 }
 
-bool AudioPowerUsage::saveAsItem_l(
+bool AudioPowerUsage::saveUsage_l(
         int32_t device, int64_t duration_ns, int32_t type, double average_vol,
         int64_t max_volume_duration_ns, double max_volume,
         int64_t min_volume_duration_ns, double min_volume)
@@ -223,77 +232,47 @@ bool AudioPowerUsage::saveAsItem_l(
     if (device == 0) {
         return true; //ignore unknown device
     }
+    const int slot = deviceToSlot(device);
+    if (slot < 0 || type < 0 || (size_t)type >= kTypes) {
+        ALOGD("%s: ignoring device %#x type %d", __func__, device, type);
+        return true;
+    }
 
-    for (const auto& item : mItems) {
-        int32_t item_type = 0, item_device = 0;
-        double item_volume = 0.;
-        int64_t item_duration_ns = 0;
-        item->getInt32(AUDIO_POWER_USAGE_PROP_DEVICE, &item_device);
-        item->getInt64(AUDIO_POWER_USAGE_PROP_DURATION_NS, &item_duration_ns);
-        item->getInt32(AUDIO_POWER_USAGE_PROP_TYPE, &item_type);
-        item->getDouble(AUDIO_POWER_USAGE_PROP_VOLUME, &item_volume);
-
-        // aggregate by device and type
-        if (item_device == device && item_type == type) {
-            int64_t final_duration_ns = item_duration_ns + duration_ns;
-            double final_volume = (device & INPUT_DEVICE_BIT) ? 1.0:
-                            ((item_volume * (double)item_duration_ns +
-                            average_vol * (double)duration_ns) / (double)final_duration_ns);
-
-            item->setInt64(AUDIO_POWER_USAGE_PROP_DURATION_NS, final_duration_ns);
-            item->setDouble(AUDIO_POWER_USAGE_PROP_VOLUME, final_volume);
-            item->setTimestamp(systemTime(SYSTEM_TIME_REALTIME));
-
-            // Update the max/min volume and duration
-            int64_t final_min_volume_duration_ns;
-            int64_t final_max_volume_duration_ns;
-            double final_min_volume;
-            double final_max_volume;
-
-            item->getInt64(AUDIO_POWER_USAGE_PROP_MIN_VOLUME_DURATION_NS,
-                           &final_min_volume_duration_ns);
-            item->getDouble(AUDIO_POWER_USAGE_PROP_MIN_VOLUME, &final_min_volume);
-            item->getInt64(AUDIO_POWER_USAGE_PROP_MAX_VOLUME_DURATION_NS,
-                           &final_max_volume_duration_ns);
-            item->getDouble(AUDIO_POWER_USAGE_PROP_MAX_VOLUME, &final_max_volume);
-            updateMinMaxVolumeAndDuration(max_volume_duration_ns, max_volume,
-                                          min_volume_duration_ns, min_volume,
-                                          final_max_volume_duration_ns, final_max_volume,
-                                          final_min_volume_duration_ns, final_min_volume);
-            item->setInt64(AUDIO_POWER_USAGE_PROP_MIN_VOLUME_DURATION_NS,
-                           final_min_volume_duration_ns);
-            item->setDouble(AUDIO_POWER_USAGE_PROP_MIN_VOLUME, final_min_volume);
-            item->setInt64(AUDIO_POWER_USAGE_PROP_MAX_VOLUME_DURATION_NS,
-                           final_max_volume_duration_ns);
-            item->setDouble(AUDIO_POWER_USAGE_PROP_MAX_VOLUME, final_max_volume);
-
-            ALOGV("%s: update (%#x, %d, %lld, %f) --> (%lld, %f) min(%lld, %f) max(%lld, %f)",
-                  __func__,
-                  device, type,
-                  (long long)item_duration_ns, item_volume,
-                  (long long)final_duration_ns, final_volume,
-                  (long long)final_min_volume_duration_ns, final_min_volume,
-                  (long long)final_max_volume_duration_ns, final_max_volume);
-
-            return true;
-        }
+    // aggregate by device and type
+    Usage& usage = mUsage[slot][type];
+    if (usage.durationNs != 0) {
+        const int64_t final_duration_ns = saturatingAdd(usage.durationNs, duration_ns);
+        const double final_volume = (device & INPUT_DEVICE_BIT) ? 1.0:
+                        ((usage.volume * (double)usage.durationNs +
+                        average_vol * (double)duration_ns) / (double)final_duration_ns);
+        ALOGV("%s: update (%#x, %d, %lld, %f) --> (%lld, %f)", __func__,
+              device, type,
+              (long long)usage.durationNs, usage.volume,
+              (long long)final_duration_ns, final_volume);
+
+        usage.timestampNs = systemTime(SYSTEM_TIME_REALTIME);
+        usage.durationNs = final_duration_ns;
+        usage.volume = final_volume;
+
+        // Update the max/min volume and duration
+        updateMinMaxVolumeAndDuration(max_volume_duration_ns, max_volume,
+                                      min_volume_duration_ns, min_volume,
+                                      usage.maxVolumeDurationNs, usage.maxVolume,
+                                      usage.minVolumeDurationNs, usage.minVolume);
+        return true;
     }
 
-    auto sitem = std::make_shared<mediametrics::Item>(AUDIO_POWER_USAGE_KEY_AUDIO_USAGE);
-    sitem->setTimestamp(systemTime(SYSTEM_TIME_REALTIME));
-    sitem->setInt32(AUDIO_POWER_USAGE_PROP_DEVICE, device);
-    sitem->setInt64(AUDIO_POWER_USAGE_PROP_DURATION_NS, duration_ns);
-    sitem->setInt32(AUDIO_POWER_USAGE_PROP_TYPE, type);
-    sitem->setDouble(AUDIO_POWER_USAGE_PROP_VOLUME, average_vol);
-    sitem->setInt64(AUDIO_POWER_USAGE_PROP_MIN_VOLUME_DURATION_NS, min_volume_duration_ns);
-    sitem->setDouble(AUDIO_POWER_USAGE_PROP_MIN_VOLUME, min_volume);
-    sitem->setInt64(AUDIO_POWER_USAGE_PROP_MAX_VOLUME_DURATION_NS, max_volume_duration_ns);
-    sitem->setDouble(AUDIO_POWER_USAGE_PROP_MAX_VOLUME, max_volume);
-    mItems.emplace_back(sitem);
+    usage.timestampNs = systemTime(SYSTEM_TIME_REALTIME);
+    usage.durationNs = duration_ns;
+    usage.volume = average_vol;
+    usage.minVolumeDurationNs = min_volume_duration_ns;
+    usage.minVolume = min_volume;
+    usage.maxVolumeDurationNs = max_volume_duration_ns;
+    usage.maxVolume = max_volume;
     return true;
 }
 
-bool AudioPowerUsage::saveAsItems_l(
+bool AudioPowerUsage::saveUsages_l(
         int32_t device, int64_t duration_ns, int32_t type, double average_vol,
         int64_t max_volume_duration, double max_volume,
         int64_t min_volume_duration, double min_volume)
@@ -315,9 +294,9 @@ bool AudioPowerUsage::saveAsItems_l(
         int32_t tmp_device = device_bits & -device_bits; // get lowest bit
         device_bits ^= tmp_device;  // clear lowest bit
         tmp_device |= input_bit;    // restore input bit
-        ret = saveAsItem_l(tmp_device, duration_ns, type, average_vol,
-                           max_volume_duration, max_volume,
-                           min_volume_duration, min_volume);
+        ret = saveUsage_l(tmp_device, duration_ns, type, average_vol,
+                          max_volume_duration, max_volume,
+                          min_volume_duration, min_volume);
 
         ALOGV("%s: device %#x recorded, remaining device_bits = %#x", __func__,
             tmp_device, device_bits);
@@ -389,8 +368,8 @@ void AudioPowerUsage::checkTrackRecord(
         ALOGV("device = %s => %d", device_strings.c_str(), device);
     }
     std::lock_guard l(mLock);
-    saveAsItems_l(device, deviceTimeNs, type, deviceVolume,
-                  maxVolumeDurationNs, maxVolume, minVolumeDurationNs, minVolume);
+    saveUsages_l(device, deviceTimeNs, type, deviceVolume,
+                 maxVolumeDurationNs, maxVolume, minVolumeDurationNs, minVolume);
 }
 
 void AudioPowerUsage::checkMode(const std::shared_ptr<const mediametrics::Item>& item)
@@ -412,9 +391,9 @@ void AudioPowerUsage::checkMode(const std::shared_ptr<const mediametrics::Item>&
                           volumeDurationNs, mVoiceVolume,
                           mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
                           mMinVoiceVolumeDurationNs, mMinVoiceVolume);
-            saveAsItems_l(mPrimaryDevice, durationNs, VOICE_CALL_TYPE, mDeviceVolume,
-                          mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
-                          mMinVoiceVolumeDurationNs, mMinVoiceVolume);
+            saveUsages_l(mPrimaryDevice, durationNs, VOICE_CALL_TYPE, mDeviceVolume,
+                         mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
+                         mMinVoiceVolumeDurationNs, mMinVoiceVolume);
         }
     } else if (mode == "AUDIO_MODE_IN_CALL") { // entering call mode
         mStartCallNs = item->getTimestamp(); // advisory only
@@ -483,9 +462,9 @@ void AudioPowerUsage::checkCreatePatch(const std::shared_ptr<const mediametrics:
                           volumeDurationNs, mVoiceVolume,
                           mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
                           mMinVoiceVolumeDurationNs, mMinVoiceVolume);
-            saveAsItems_l(mPrimaryDevice, durationNs, VOICE_CALL_TYPE, mDeviceVolume,
-                          mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
-                          mMinVoiceVolumeDurationNs, mMinVoiceVolume);
+            saveUsages_l(mPrimaryDevice, durationNs, VOICE_CALL_TYPE, mDeviceVolume,
+                         mMaxVoiceVolumeDurationNs, mMaxVoiceVolume,
+                         mMinVoiceVolumeDurationNs, mMinVoiceVolume);
         }
         // reset statistics
         mDeviceVolume = 0;
@@ -520,16 +499,20 @@ AudioPowerUsage::~AudioPowerUsage()
 void AudioPowerUsage::clear()
 {
     std::lock_guard _l(mLock);
-    mItems.clear();
+    mUsage = {};
 }
 
 void AudioPowerUsage::collect()
 {
     std::lock_guard _l(mLock);
-    for (const auto &item : mItems) {
-        sendItem(item);
+    for (size_t slot = 0; slot < kDeviceSlots; ++slot) {
+        for (size_t type = 0; type < kTypes; ++type) {
+            if (mUsage[slot][type].durationNs != 0) {
+                sendUsage(slotToDevice(slot), type, mUsage[slot][type]);
+            }
+        }
     }
-    mItems.clear();
+    mUsage = {};
     mAudioAnalytics->mTimedAction.postIn(
         mIntervalHours <= 0 ? std::chrono::seconds(5) : std::chrono::hours(mIntervalHours),
         [this](){ collect(); });
@@ -543,21 +526,36 @@ std::pair<std::string, int32_t> AudioPowerUsage::dump(int limit) const {
     if (mDisabled) {
         return {"AudioPowerUsage disabled\n", 1};
     }
-    if (mItems.empty()) {
-        return {"AudioPowerUsage empty\n", 1};
-    }
 
     int slot = 1;
     std::stringstream ss;
     ss << "AudioPowerUsage:\n";
-    for (const auto &item : mItems) {
-        if (slot >= limit - 1) {
-            ss << "-- AudioPowerUsage may be truncated!\n";
-            ++slot;
-            break;
+    for (size_t device = 0; device < kDeviceSlots; ++device) {
+        for (size_t type = 0; type < kTypes; ++type) {
+            const Usage& usage = mUsage[device][type];
+            if (usage.durationNs == 0) continue;
+            if (slot >= limit - 1) {
+                ss << "-- AudioPowerUsage may be truncated!\n";
+                return { ss.str(), slot + 1 };
+            }
+            ss << " " << slot << " " << AUDIO_POWER_USAGE_KEY_AUDIO_USAGE
+                    << " timestamp:" << usage.timestampNs
+                    << " " << AUDIO_POWER_USAGE_PROP_DEVICE << ":" << slotToDevice(device)
+                    << " " << AUDIO_POWER_USAGE_PROP_TYPE << ":" << type
+                    << " " << AUDIO_POWER_USAGE_PROP_DURATION_NS << ":" << usage.durationNs
+                    << " " << AUDIO_POWER_USAGE_PROP_VOLUME << ":" << usage.volume
+                    << " " << AUDIO_POWER_USAGE_PROP_MIN_VOLUME_DURATION_NS << ":"
+                    << usage.minVolumeDurationNs
+                    << " " << AUDIO_POWER_USAGE_PROP_MIN_VOLUME << ":" << usage.minVolume
+                    << " " << AUDIO_POWER_USAGE_PROP_MAX_VOLUME_DURATION_NS << ":"
+                    << usage.maxVolumeDurationNs
+                    << " " << AUDIO_POWER_USAGE_PROP_MAX_VOLUME << ":" << usage.maxVolume
+                    << "\n";
+            slot++;
         }
-        ss << " " << slot << " " << item->toString() << "\n";
-        slot++;
+    }
+    if (slot == 1) {
+        return {"AudioPowerUsage empty\n", 1};
     }
     return { ss.str(), slot };
 }
@@ -35,6 +35,7 @@
 #include <private/android_filesystem_config.h> // UID
 #include <statslog.h>
 
+#include <algorithm>
 #include <set>
 
 namespace android {
@@ -62,6 +63,17 @@ static constexpr size_t kMaxExpiredAtOnce = 50;
 
 // TODO: need to look at tuning kMaxRecords and friends for low-memory devices
 
+// Items are processed (analytics, statsd, saved) off the binder thread on
+// ingestion workers, sharded by key prefix.  0 processes items inline.
+#define PROP_INGEST_SHARDS "media.metrics.ingest_shards"
+static constexpr int32_t kIngestShardsDefault = 4;
+static constexpr int32_t kIngestShardsMax = 16;
+
+static size_t getIngestShards() {
+    return (size_t)std::clamp(
+            property_get_int32(PROP_INGEST_SHARDS, kIngestShardsDefault), 0, kIngestShardsMax);
+}
+
 /* static */
 nsecs_t MediaMetricsService::roundTime(nsecs_t timeNs)
 {
@@ -106,7 +118,8 @@ MediaMetricsService::getSanitizedPackageNameAndVersionCode(uid_t uid) {
 MediaMetricsService::MediaMetricsService()
         : mMaxRecords(kMaxRecords),
           mMaxRecordAgeNs(kMaxRecordAgeNs),
-          mMaxRecordsExpiredAtOnce(kMaxExpiredAtOnce)
+          mMaxRecordsExpiredAtOnce(kMaxExpiredAtOnce),
+          mIngestionQueue(getIngestShards())
 {
     ALOGD("%s", __func__);
 }
@@ -114,6 +127,8 @@ MediaMetricsService::MediaMetricsService()
 MediaMetricsService::~MediaMetricsService()
 {
     ALOGD("%s", __func__);
+    // the ingestion workers refer to the members below, stop them first.
+    mIngestionQueue.quit();
     // the class destructor clears anyhow, but we enforce clearing items first.
     mItemsDiscarded += (int64_t)mItems.size();
     mItems.clear();
@@ -214,13 +229,43 @@ status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool rele
         }
     }
 
-    (void)mAudioAnalytics.submit(sitem, isTrusted);
-
-    (void)dump2Statsd(sitem, mStatsdLog);  // failure should be logged in function.
-    saveItem(sitem);
+    // the item is accepted; the remaining work does not affect the (one-way) result.
+    mIngestionQueue.post(sitem->getKey(), [this, sitem, isTrusted] {
+        processItem(sitem, isTrusted);
+    });
     return NO_ERROR;
 }
 
+void MediaMetricsService::processItem(
+        const std::shared_ptr<const mediametrics::Item>& item, bool isTrusted)
+{
+    (void)mAudioAnalytics.submit(item, isTrusted);
+
+    (void)dump2Statsd(item, mStatsdLog);  // failure should be logged in function.
+    saveItem(item);
+}
+
+status_t MediaMetricsService::submitBatch(const char *buffer, size_t length)
+{
+    status_t result = NO_ERROR;
+    size_t offset = 0;
+    while (offset < length) {
+        // each item byte string starts with its total size
+        uint32_t size;
+        if (length - offset < sizeof(size)) return BAD_VALUE;
+        memcpy(&size, buffer + offset, sizeof(size));
+        if (size < sizeof(size) || size > length - offset) {
+            ALOGW("%s: invalid item size %u at offset %zu of %zu",
+                    __func__, size, offset, length);
+            return BAD_VALUE;
+        }
+        const status_t status = submitBuffer(buffer + offset, size);
+        if (result == NO_ERROR) result = status;
+        offset += size;
+    }
+    return result;
+}
+
 status_t MediaMetricsService::dump(int fd, const Vector<String16>& args)
 {
     if (checkCallingPermission(String16("android.permission.DUMP")) == false) {
@@ -309,6 +354,7 @@ status_t MediaMetricsService::dump(int fd, const Vector<String16>& args)
             result << StringPrintf("Dump of the %s process:\n", kServiceName);
             const char *prefixptr = prefix.size() > 0 ? prefix.c_str() : nullptr;
             result << dumpHeaders(sinceNs, prefixptr);
+            result << mIngestionQueue.dump().first;
             result << dumpQueue(sinceNs, prefixptr);
 
             // TODO: maybe consider a better way of dumping audio analytics info.
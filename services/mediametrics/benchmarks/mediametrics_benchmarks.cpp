@@ -14,7 +14,14 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/AudioAnalytics.h>
+#include <mediametricsservice/HeatMap.h>
+#include <mediametricsservice/TimeMachine.h>
+#include <mediametricsservice/TransactionLog.h>
 #include <benchmark/benchmark.h>
 
 class MyItem : public android::mediametrics::BaseItem {
@@ -42,6 +49,130 @@ static void BM_SubmitBuffer(benchmark::State& state)
     }
 }
 
+// Measures the cost of recording a typical item on the calling thread, with the flush
+// latency in milliseconds as the argument (0 submits each item directly.)
+static void BM_SelfRecord(benchmark::State& state)
+{
+    const int32_t previousLatencyMs = android::mediametrics::BaseItem::getBatchFlushLatencyMs();
+    android::mediametrics::BaseItem::setBatchFlushLatencyMs(state.range(0));
+    while (state.KeepRunning()) {
+        bool ok = android::mediametrics::Item("audiotrack")
+                .setInt32("sampleRate", 48000)
+                .setInt64("frames", 1024)
+                .setCString("event", "underrun")
+                .selfrecord();
+        if (ok == false) {
+            state.SkipWithError("failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    android::mediametrics::BaseItem::setBatchFlushLatencyMs(previousLatencyMs);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Returns the resident set size of this process in KB, or 0 if unknown.
+static int64_t getRssKb()
+{
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == nullptr) return 0;
+    long long size = 0;
+    long long resident = 0;
+    const int matched = fscanf(file, "%lld %lld", &size, &resident);
+    fclose(file);
+    return matched == 2 ? resident * sysconf(_SC_PAGESIZE) / 1024 : 0;
+}
+
+// Measures putting items with many properties, as from AudioTrack, into the TimeMachine
+// and TransactionLog of the service, with the number of distinct keys as the argument.
+// Reports the estimated memory used and the RSS before and after.
+static void BM_AnalyticsStateMemory(benchmark::State& state)
+{
+    const int64_t rssBeforeKb = getRssKb();
+    android::mediametrics::TimeMachine timeMachine;
+    android::mediametrics::TransactionLog transactionLog;
+    int64_t time = 1;
+    while (state.KeepRunning()) {
+        const std::string key = "audio.track." + std::to_string(time % state.range(0));
+        auto item = std::make_shared<android::mediametrics::Item>(key.c_str());
+        (*item).set("encoding", "AUDIO_FORMAT_PCM_16_BIT")
+                .set("channelMask", (int32_t)3)
+                .set("sampleRate", (int32_t)48000)
+                .set("frameCount", (int32_t)(time % 4096))
+                .set("underrun", (int32_t)(time % 7))
+                .set("latencyMs", (double)(time % 100))
+                .set("event", "start")
+                .setTimestamp(time++);
+        timeMachine.put(item, true /* isTrusted */);
+        transactionLog.put(item);
+    }
+    const int64_t rssAfterKb = getRssKb();
+    state.counters["rssBeforeKb"] = rssBeforeKb;
+    state.counters["rssAfterKb"] = rssAfterKb;
+    state.counters["timeMachineKb"] = timeMachine.getBytes() / 1024;
+    state.counters["transactionLogKb"] = transactionLog.getBytes() / 1024;
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Measures adding a status to the HeatMap, with the number of distinct keys as the argument.
+static void BM_HeatMapAdd(benchmark::State& state)
+{
+    android::mediametrics::HeatMap heatMap{100 /* maxSize */};
+    static const char * const events[] = { "create", "start", "pause", "flush", "stop" };
+    static const char * const statuses[] = {
+            AMEDIAMETRICS_PROP_STATUS_VALUE_OK, AMEDIAMETRICS_PROP_STATUS_VALUE_ARGUMENT };
+    int64_t i = 0;
+    while (state.KeepRunning()) {
+        heatMap.add("audio.track." + std::to_string(i % state.range(0)), "" /* suffix */,
+                events[i % 5], statuses[i % 7 == 0], 0 /* uid */, "" /* message */,
+                0 /* subCode */);
+        ++i;
+    }
+    state.counters["rejected"] = heatMap.rejected();
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Measures the submit path of AudioAnalytics for AudioTrack items that end an interval group,
+// which update the HeatMap and AudioPowerUsage, with the number of distinct tracks
+// as the argument.
+static void BM_AudioAnalyticsSubmit(benchmark::State& state)
+{
+    auto statsdLog = std::make_shared<android::mediametrics::StatsdLog>(10);
+    android::mediametrics::AudioAnalytics audioAnalytics{statsdLog};
+    static const char * const devices[] = {
+            "AUDIO_DEVICE_OUT_SPEAKER", "AUDIO_DEVICE_OUT_WIRED_HEADSET",
+            "AUDIO_DEVICE_OUT_BLUETOOTH_A2DP" };
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        const std::string key = "audio.track." + std::to_string(i);
+        auto item = std::make_shared<android::mediametrics::Item>(key.c_str());
+        (*item).set(AMEDIAMETRICS_PROP_STREAMTYPE, "AUDIO_STREAM_MUSIC")
+                .set(AMEDIAMETRICS_PROP_OUTPUTDEVICES, devices[i % 3])
+                .setTimestamp(1);
+        audioAnalytics.submit(item, true /* isTrusted */);
+    }
+    int64_t time = 2;
+    while (state.KeepRunning()) {
+        const std::string key = "audio.track." + std::to_string(time % state.range(0));
+        auto item = std::make_shared<android::mediametrics::Item>(key.c_str());
+        (*item).set(AMEDIAMETRICS_PROP_EVENT,
+                        AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP)
+                .set(AMEDIAMETRICS_PROP_STATUS, (int32_t)0)
+                .set(AMEDIAMETRICS_PROP_DEVICETIMENS, (int64_t)1000000000)
+                .set(AMEDIAMETRICS_PROP_DEVICEVOLUME, 0.5)
+                .set(AMEDIAMETRICS_PROP_DEVICEMAXVOLUMEDURATIONNS, (int64_t)500000000)
+                .set(AMEDIAMETRICS_PROP_DEVICEMAXVOLUME, 0.75)
+                .set(AMEDIAMETRICS_PROP_DEVICEMINVOLUMEDURATIONNS, (int64_t)500000000)
+                .set(AMEDIAMETRICS_PROP_DEVICEMINVOLUME, 0.25)
+                .setTimestamp(time++);
+        audioAnalytics.submit(item, true /* isTrusted */);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
+BENCHMARK(BM_SelfRecord)->Arg(0)->Arg(20)->Iterations(4000);
+BENCHMARK(BM_AnalyticsStateMemory)->Arg(100)->Arg(10000)->Iterations(100000);
+BENCHMARK(BM_HeatMapAdd)->Arg(10)->Arg(1000);
+BENCHMARK(BM_AudioAnalyticsSubmit)->Arg(10)->Arg(1000);
 
 BENCHMARK_MAIN();
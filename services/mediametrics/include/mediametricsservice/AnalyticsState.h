@@ -93,7 +93,8 @@ public:
         int32_t ll = lines;
 
         if (ll > 0) {
-            ss << "TransactionLog: gc(" << mTransactionLog.getGarbageCollectionCount() << ")\n";
+            ss << "TransactionLog: gc(" << mTransactionLog.getGarbageCollectionCount() << ")"
+                    << " bytes(" << mTransactionLog.getBytes() << ")\n";
             --ll;
         }
         if (ll > 0) {
@@ -102,7 +103,8 @@ public:
             ll -= l;
         }
         if (ll > 0) {
-            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount() << ")\n";
+            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount() << ")"
+                    << " bytes(" << mTimeMachine.getBytes() << ")\n";
             --ll;
         }
         if (ll > 0) {
@@ -17,7 +17,7 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
-#include <deque>
+#include <array>
 #include <media/MediaMetricsItem.h>
 #include <mutex>
 #include <thread>
@@ -84,13 +84,35 @@ public:
     static bool deviceFromString(const std::string& device_string, int32_t& device);
     static int32_t deviceFromStringPairs(const std::string& device_strings);
 private:
-    bool saveAsItem_l(int32_t device, int64_t duration, int32_t type, double average_vol,
-                      int64_t max_volume_duration, double max_volume,
-                      int64_t min_volume_duration, double min_volume)
-                      REQUIRES(mLock);
-    void sendItem(const std::shared_ptr<const mediametrics::Item>& item) const;
+    // The usage accumulated for one device and type since the last collect().
+    struct Usage {
+        int64_t timestampNs = 0;        // realtime of the last update
+        int64_t durationNs = 0;         // saturating, 0 if there is no usage
+        double volume = 0.;             // average over durationNs
+        int64_t maxVolumeDurationNs = 0;
+        double maxVolume = AMEDIAMETRICS_INITIAL_MAX_VOLUME;
+        int64_t minVolumeDurationNs = 0;
+        double minVolume = AMEDIAMETRICS_INITIAL_MIN_VOLUME;
+    };
+
+    // Usage is accumulated in a fixed array indexed by device bit and type,
+    // instead of being looked up among items by property name.
+    static constexpr size_t kOutputDeviceSlots = 7;  // OUTPUT_EARPIECE to OUTPUT_SPEAKER_SAFE
+    static constexpr size_t kInputDeviceSlots = 5;   // INPUT_BUILTIN_MIC to INPUT_BLUETOOTH_SCO
+    static constexpr size_t kDeviceSlots = kOutputDeviceSlots + kInputDeviceSlots;
+    static constexpr size_t kTypes = RECORD_TYPE + 1;
+
+    // Returns the slot of a device with a single device bit, or -1 if it has none.
+    static int deviceToSlot(int32_t device);
+    static int32_t slotToDevice(size_t slot);
+
+    bool saveUsage_l(int32_t device, int64_t duration, int32_t type, double average_vol,
+                     int64_t max_volume_duration, double max_volume,
+                     int64_t min_volume_duration, double min_volume)
+                     REQUIRES(mLock);
+    void sendUsage(int32_t device, int32_t type, const Usage& usage) const;
     void collect();
-    bool saveAsItems_l(int32_t device, int64_t duration, int32_t type, double average_vol,
+    bool saveUsages_l(int32_t device, int64_t duration, int32_t type, double average_vol,
                       int64_t max_volume_duration, double max_volume,
                       int64_t min_volume_duration, double min_volume)
                       REQUIRES(mLock);
@@ -105,7 +127,7 @@ private:
     const int32_t mIntervalHours;
 
     mutable std::mutex mLock;
-    std::deque<std::shared_ptr<mediametrics::Item>> mItems GUARDED_BY(mLock);
+    std::array<std::array<Usage, kTypes>, kDeviceSlots> mUsage GUARDED_BY(mLock);
 
     double mVoiceVolume GUARDED_BY(mLock) = 0.;
     double mDeviceVolume GUARDED_BY(mLock) = 0.;
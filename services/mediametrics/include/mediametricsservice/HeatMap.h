@@ -16,31 +16,93 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <deque>
 #include <iomanip>
-#include <map>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 #include "MediaMetricsConstants.h"
 
 namespace android::mediametrics {
 
+/**
+ * HeatNames interns the event and status names of all heat maps into small indices,
+ * so that HeatData stores and compares indices instead of strings.
+ *
+ * There are few distinct events and statuses, but to bound memory the table holds
+ * at most kMaxNames names; further names are counted under the first name, "other".
+ * Names are never removed, so an index and the name it refers to remain valid
+ * for the life of the process.
+ *
+ * HeatNames is thread safe.
+ */
+class HeatNames {
+public:
+    using Index = uint16_t;
+    static constexpr size_t kMaxNames = 256;
+    static constexpr Index kOtherIndex = 0;
+
+    static HeatNames& getInstance() {
+        static HeatNames *names = new HeatNames(); // never deleted
+        return *names;
+    }
+
+    /** Returns the index of name, adding it if there is space, otherwise kOtherIndex. */
+    Index intern(const std::string& name) {
+        std::lock_guard l(mLock);
+        auto it = mIndices.find(name);
+        if (it != mIndices.end()) return it->second;
+        if (mNames.size() == kMaxNames) return kOtherIndex;
+        const Index index = mNames.size();
+        mNames.emplace_back(name);
+        mIndices.emplace(name, index);
+        return index;
+    }
+
+    /** Returns the name of an index returned by intern(). */
+    const std::string& name(Index index) const {
+        std::lock_guard l(mLock);
+        return mNames[index]; // elements of a deque do not move when it grows.
+    }
+
+    size_t size() const {
+        std::lock_guard l(mLock);
+        return mNames.size();
+    }
+
+private:
+    HeatNames() {
+        mNames.emplace_back("other");
+        mIndices.emplace(mNames.back(), kOtherIndex);
+    }
+
+    mutable std::mutex mLock;
+    std::deque<std::string> mNames GUARDED_BY(mLock);
+    std::unordered_map<std::string, Index> mIndices GUARDED_BY(mLock);
+};
+
 /**
  * HeatData accumulates statistics on the status reported for a given key.
  *
  * HeatData is a helper class used by HeatMap to represent statistics.  We expose it
  * here for testing purposes currently.
  *
+ * The counts are kept in a fixed array of kMaxEntries (event, status) pairs, with
+ * names interned in HeatNames, so that the memory of a key does not grow with uptime.
+ * Counts saturate; reports for new pairs once the array is full are only counted
+ * in dropped().
+ *
  * Note: This class is not thread safe, so mutual exclusion should be obtained by the caller
  * which in this case is HeatMap.  HeatMap getData() returns a local copy of HeatData, so use
  * of that is thread-safe.
  */
 class HeatData {
-    /* HeatData for a key is stored in a map based on the event (e.g. "start", "pause", create)
-     * and then another map based on the status (e.g. "ok", "argument", "state").
-     */
-    std::map<std::string /* event */,
-             std::map<std::string /* status name */, size_t /* count, nonzero */>> mMap;
-
 public:
+    static constexpr size_t kMaxEntries = 32;
+
     /**
      * Add status data.
      *
@@ -57,39 +119,81 @@ public:
         (void)uid;
         (void)message;
         (void)subCode;
-        ++mMap[event][status];
+        HeatNames& names = HeatNames::getInstance();
+        add(names.intern(event), names.intern(status));
+    }
+
+    /** Add status data for an event and status interned in HeatNames. */
+    void add(HeatNames::Index event, HeatNames::Index status) {
+        for (size_t i = 0; i < mSize; ++i) {
+            Entry& entry = mEntries[i];
+            if (entry.event == event && entry.status == status) {
+                if (entry.count != UINT32_MAX) ++entry.count;
+                return;
+            }
+        }
+        if (mSize == kMaxEntries) {
+            if (mDropped != SIZE_MAX) ++mDropped;
+            return;
+        }
+        // Keep the entries ordered by event name then status name, as they are dumped.
+        // This is only done for the first report of a pair.
+        const HeatNames& names = HeatNames::getInstance();
+        const std::string& eventName = names.name(event);
+        const std::string& statusName = names.name(status);
+        size_t i = mSize;
+        for (; i > 0; --i) {
+            const Entry& previous = mEntries[i - 1];
+            const int compare = names.name(previous.event).compare(eventName);
+            if (compare < 0 || (compare == 0 && names.name(previous.status) < statusName)) {
+                break;
+            }
+            mEntries[i] = previous;
+        }
+        mEntries[i] = { event, status, 1 /* count */ };
+        ++mSize;
     }
 
     /** Returns the number of event names with status. */
     size_t size() const {
-        return mMap.size();
+        size_t events = 0;
+        for (size_t i = 0; i < mSize; ++i) {
+            if (i == 0 || mEntries[i].event != mEntries[i - 1].event) ++events;
+        }
+        return events;
+    }
+
+    /** Returns the number of reports not counted as the entries were full. */
+    size_t dropped() const {
+        return mDropped;
     }
 
     /**
      * Returns a deque with pairs indicating the count of Oks and Errors.
-     * The first pair is total, the other pairs are in order of mMap.
+     * The first pair is total, the other pairs are in order of the event names.
      *
      * Example return value of {ok, error} pairs:
      *     total     key1      key2
      * { { 2, 1 }, { 1, 0 }, { 1, 1 } }
      */
     std::deque<std::pair<size_t /* oks */, size_t /* errors */>> heatCount() const {
+        const HeatNames::Index ok =
+                HeatNames::getInstance().intern(AMEDIAMETRICS_PROP_STATUS_VALUE_OK);
         size_t totalOk = 0;
         size_t totalError = 0;
         std::deque<std::pair<size_t /* oks */, size_t /* errors */>> heat;
-        for (const auto &eventPair : mMap) {
-            size_t ok = 0;
-            size_t error = 0;
-            for (const auto &[name, count] : eventPair.second) {
-                if (name == AMEDIAMETRICS_PROP_STATUS_VALUE_OK) {
-                    ok += count;
-                } else {
-                    error += count;
-                }
+        for (size_t i = 0; i < mSize; ++i) {
+            const Entry& entry = mEntries[i];
+            if (i == 0 || entry.event != mEntries[i - 1].event) {
+                heat.emplace_back(0, 0);
+            }
+            if (entry.status == ok) {
+                heat.back().first += entry.count;
+                totalOk += entry.count;
+            } else {
+                heat.back().second += entry.count;
+                totalError += entry.count;
             }
-            totalOk += ok;
-            totalError += error;
-            heat.emplace_back(ok, error);
         }
         heat.emplace_front(totalOk, totalError);
         return heat;
@@ -102,6 +206,7 @@ public:
 
     /** Returns the HeatMap information in a single line string. */
     std::string dump() const {
+        const HeatNames& names = HeatNames::getInstance();
         const auto heat = heatCount();
         auto it = heat.begin();
         std::stringstream ss;
@@ -110,20 +215,34 @@ public:
         if (errorFraction > 0.f) {
             ss << std::fixed << std::setprecision(2) << errorFraction << " ";
         }
-        for (const auto &eventPair : mMap) {
-            ss << eventPair.first << ": { ";
-            errorFraction = fraction(*it++);
-            if (errorFraction > 0.f) {
-                ss << std::fixed << std::setprecision(2) << errorFraction << " ";
-            }
-            for (const auto &[name, count]: eventPair.second) {
-                ss << "[ " << name << " : " << count << " ] ";
+        for (size_t i = 0; i < mSize; ++i) {
+            const Entry& entry = mEntries[i];
+            if (i == 0 || entry.event != mEntries[i - 1].event) {
+                if (i > 0) ss << "} ";
+                ss << names.name(entry.event) << ": { ";
+                errorFraction = fraction(*it++);
+                if (errorFraction > 0.f) {
+                    ss << std::fixed << std::setprecision(2) << errorFraction << " ";
+                }
             }
-            ss << "} ";
+            ss << "[ " << names.name(entry.status) << " : " << entry.count << " ] ";
         }
+        if (mSize > 0) ss << "} ";
+        if (mDropped > 0) ss << "dropped: " << mDropped << " ";
         ss << " }";
         return ss.str();
     }
+
+private:
+    struct Entry {
+        HeatNames::Index event;
+        HeatNames::Index status;
+        uint32_t count; // nonzero, saturating
+    };
+
+    std::array<Entry, kMaxEntries> mEntries;
+    size_t mSize = 0;
+    size_t mDropped = 0;
 };
 
 /**
@@ -141,7 +260,10 @@ class HeatMap {
     const size_t mMaxSize;
     mutable std::mutex mLock;
     size_t mRejected GUARDED_BY(mLock) = 0;
-    std::map<std::string, HeatData> mMap GUARDED_BY(mLock);
+    // The HeatData of each key, allocated up to mMaxSize at construction
+    // and found through mIndices.
+    std::vector<std::pair<std::string /* key */, HeatData>> mData GUARDED_BY(mLock);
+    std::unordered_map<std::string, size_t> mIndices GUARDED_BY(mLock);
 
 public:
     /**
@@ -150,18 +272,21 @@ public:
      * \param maxSize the maximum number of elements that are tracked.
      */
     explicit HeatMap(size_t maxSize) : mMaxSize(maxSize) {
+        mData.reserve(mMaxSize);
+        mIndices.reserve(mMaxSize);
     }
 
     /** Returns the number of keys. */
     size_t size() const {
         std::lock_guard l(mLock);
-        return mMap.size();
+        return mData.size();
     }
 
     /** Clears error history. */
     void clear() {
         std::lock_guard l(mLock);
-        return mMap.clear();
+        mData.clear();
+        mIndices.clear();
     }
 
     /** Returns number of keys rejected due to space. */
@@ -173,7 +298,8 @@ public:
     /** Returns a copy of the heat data associated with key. */
     HeatData getData(const std::string& key) const {
         std::lock_guard l(mLock);
-        return mMap.count(key) == 0 ? HeatData{} : mMap.at(key);
+        auto it = mIndices.find(key);
+        return it == mIndices.end() ? HeatData{} : mData[it->second].second;
     }
 
     /**
@@ -187,15 +313,28 @@ public:
      */
     void add(const std::string& key, const std::string& suffix, const std::string& event,
             const std::string& status, uid_t uid, const std::string& message, int32_t subCode) {
-        std::lock_guard l(mLock);
+        (void)suffix;
+        (void)uid;
+        (void)message;
+        (void)subCode;
+        // Intern outside of our lock.
+        HeatNames& names = HeatNames::getInstance();
+        const HeatNames::Index eventIndex = names.intern(event);
+        const HeatNames::Index statusIndex = names.intern(status);
 
-        // Hard limit on heat map entries.
-        // TODO: have better GC.
-        if (mMap.size() == mMaxSize && mMap.count(key) == 0) {
-            ++mRejected;
-            return;
+        std::lock_guard l(mLock);
+        auto it = mIndices.find(key);
+        if (it == mIndices.end()) {
+            // Hard limit on heat map entries.
+            // TODO: have better GC.
+            if (mData.size() == mMaxSize) {
+                ++mRejected;
+                return;
+            }
+            it = mIndices.emplace(key, mData.size()).first;
+            mData.emplace_back(key, HeatData{});
         }
-        mMap[key].add(suffix, event, status, uid, message, subCode);
+        mData[it->second].second.add(eventIndex, statusIndex);
     }
 
     /**
@@ -210,9 +349,16 @@ public:
             --ll;
         }
         // TODO: restriction is implemented alphabetically not on priority.
-        for (const auto& [name, data] : mMap) {
+        std::vector<const std::pair<std::string, HeatData>*> sorted;
+        sorted.reserve(mData.size());
+        for (const auto& entry : mData) {
+            sorted.push_back(&entry);
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                [](const auto *a, const auto *b) { return a->first < b->first; });
+        for (const auto *entry : sorted) {
             if (ll <= 0) break;
-            ss << name << ": " << data.dump() << "\n";
+            ss << entry->first << ": " << entry->second.dump() << "\n";
             --ll;
         }
         return { ss.str(), lines - ll };
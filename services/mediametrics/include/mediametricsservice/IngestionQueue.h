@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/stringprintf.h>
+#include <android-base/thread_annotations.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace android::mediametrics {
+
+/**
+ * IngestionQueue moves work off the submitting (binder) threads.
+ *
+ * Work is posted with a key, and the part of the key before the first '.'
+ * selects one of a fixed number of shards.  Each shard has its own lock,
+ * queue and worker thread, so producers of different key prefixes do not
+ * contend with each other, and work for the same prefix (e.g. all "audio."
+ * items) is executed in the order posted.
+ *
+ * With zero shards, work is executed inline on the posting thread.
+ */
+class IngestionQueue {
+public:
+    explicit IngestionQueue(size_t shards) {
+        for (size_t i = 0; i < shards; ++i) {
+            mShards.emplace_back(std::make_unique<Shard>());
+        }
+        // start the threads after all the shards exist.
+        for (auto& shard : mShards) {
+            Shard* const s = shard.get();
+            s->mThread = std::thread([s](){ s->threadLoop(); });
+        }
+    }
+
+    ~IngestionQueue() {
+        quit();
+    }
+
+    static size_t shardForKey(const std::string& key, size_t shards) {
+        if (shards <= 1) return 0;
+        const size_t dot = key.find('.');
+        return std::hash<std::string_view>{}(
+                std::string_view(key).substr(0, dot)) % shards;
+    }
+
+    void post(const std::string& key, std::function<void()> f) {
+        if (mShards.empty()) {
+            f();
+            return;
+        }
+        mShards[shardForKey(key, mShards.size())]->post(std::move(f));
+    }
+
+    /**
+     * Waits until all work posted before the call has executed.
+     */
+    void flush() {
+        for (auto& shard : mShards) shard->flush();
+    }
+
+    /**
+     * Executes any remaining work, then stops the worker threads.
+     * Work posted after quit() is executed inline.
+     */
+    void quit() {
+        for (auto& shard : mShards) shard->quit();
+    }
+
+    size_t shards() const {
+        return mShards.size();
+    }
+
+    size_t size() const {
+        size_t size = 0;
+        for (const auto& shard : mShards) size += shard->size();
+        return size;
+    }
+
+    std::pair<std::string, int32_t> dump(int32_t lines = INT32_MAX) const {
+        std::stringstream ss;
+        int32_t ll = lines;
+        if (ll > 0) {
+            ss << "Ingestion shards: " << mShards.size() << "\n";
+            --ll;
+        }
+        for (size_t i = 0; i < mShards.size() && ll > 0; ++i, --ll) {
+            ss << " " << i << ": " << mShards[i]->dump() << "\n";
+        }
+        return { ss.str(), lines - ll };
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    class Shard {
+    public:
+        void post(std::function<void()> f) {
+            {
+                std::lock_guard l(mLock);
+                if (!mQuit) {
+                    mQueue.push_back({Clock::now(), std::move(f)});
+                    if (mQueue.size() > mMaxQueued) mMaxQueued = mQueue.size();
+                    if (mQueue.size() == 1) mCondition.notify_all();
+                    return;
+                }
+            }
+            f(); // the worker is gone, execute inline.
+        }
+
+        void flush() NO_THREAD_SAFETY_ANALYSIS { // thread safety doesn't cover unique_lock
+            std::unique_lock l(mLock);
+            const int64_t target = mExecuted + (int64_t)mQueue.size() + mExecuting;
+            mCondition.wait(l, [&] { return mExecuted >= target || mQuit; });
+        }
+
+        void quit() {
+            {
+                std::lock_guard l(mLock);
+                if (mQuit) return;
+                mQuit = true;
+                mCondition.notify_all();
+            }
+            mThread.join();
+        }
+
+        size_t size() const {
+            std::lock_guard l(mLock);
+            return mQueue.size();
+        }
+
+        std::string dump() const {
+            std::lock_guard l(mLock);
+            const int64_t avgDelayUs = mExecuted == 0 ? 0 : mTotalDelayUs / mExecuted;
+            return base::StringPrintf(
+                    "executed:%lld queued:%zu maxQueued:%zu"
+                    " delayUs(avg:%lld max:%lld last:%lld)",
+                    (long long)mExecuted, mQueue.size(), mMaxQueued,
+                    (long long)avgDelayUs, (long long)mMaxDelayUs,
+                    (long long)mLastDelayUs);
+        }
+
+        void threadLoop() NO_THREAD_SAFETY_ANALYSIS { // thread safety doesn't cover unique_lock
+            std::unique_lock l(mLock);
+            while (true) {
+                if (mQueue.empty()) {
+                    if (mQuit) break;
+                    mCondition.wait(l);
+                    continue;
+                }
+                // remaining work is executed even after quit, so nothing posted is lost.
+                Entry entry = std::move(mQueue.front());
+                mQueue.pop_front();
+                const int64_t delayUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - entry.mPostTime).count();
+                mExecuting = true;
+                l.unlock();
+                entry.mFunction();
+                entry.mFunction = nullptr; // release captures outside of the lock.
+                l.lock();
+                mExecuting = false;
+                ++mExecuted;
+                mTotalDelayUs += delayUs;
+                mLastDelayUs = delayUs;
+                if (delayUs > mMaxDelayUs) mMaxDelayUs = delayUs;
+                mCondition.notify_all(); // for flush().
+            }
+        }
+
+        std::thread mThread; // set once by the IngestionQueue constructor.
+
+    private:
+        struct Entry {
+            Clock::time_point mPostTime;
+            std::function<void()> mFunction;
+        };
+
+        mutable std::mutex mLock;
+        std::condition_variable mCondition GUARDED_BY(mLock);
+        bool mQuit GUARDED_BY(mLock) = false;
+        bool mExecuting GUARDED_BY(mLock) = false;
+        std::deque<Entry> mQueue GUARDED_BY(mLock);
+
+        // statistics, all delays are from post() to start of execution.
+        int64_t mExecuted GUARDED_BY(mLock) = 0; // executed by the worker.
+        int64_t mTotalDelayUs GUARDED_BY(mLock) = 0;
+        int64_t mMaxDelayUs GUARDED_BY(mLock) = 0;
+        int64_t mLastDelayUs GUARDED_BY(mLock) = 0;
+        size_t mMaxQueued GUARDED_BY(mLock) = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> mShards; // fixed after construction.
+};
+
+} // namespace android::mediametrics
@@ -30,6 +30,7 @@
 #include <utils/String8.h>
 
 #include "AudioAnalytics.h"
+#include "IngestionQueue.h"
 
 namespace android {
 
@@ -56,12 +57,34 @@ public:
         return submitInternal(item, false /* release */);
     }
 
+    binder::Status submitBatch(const std::vector<uint8_t>& buffer) override {
+        status_t status = submitBatch((char *)buffer.data(), buffer.size());
+        return binder::Status::fromStatusT(status);
+    }
+
     status_t submitBuffer(const char *buffer, size_t length) {
         mediametrics::Item *item = new mediametrics::Item();
         return item->readFromByteString(buffer, length)
                 ?: submitInternal(item, true /* release */);
     }
 
+    /**
+     * Submits the items in a batch, which is the concatenation of their byte strings.
+     *
+     * \return the first failure, or BAD_VALUE if the batch cannot be split into items.
+     *         Items after a failed item are still submitted, as long as the batch
+     *         can be split.
+     */
+    status_t submitBatch(const char *buffer, size_t length);
+
+    /**
+     * Waits until the items submitted so far have been processed.
+     * Items are processed asynchronously on the ingestion workers.
+     */
+    void flushIngestion() {
+        mIngestionQueue.flush();
+    }
+
     status_t dump(int fd, const Vector<String16>& args) override;
 
     static constexpr const char * const kServiceName = "media.metrics";
@@ -95,6 +118,8 @@ private:
     // input validation after arrival from client
     static bool isContentValid(const mediametrics::Item *item, bool isTrusted);
     bool isRateLimited(mediametrics::Item *) const;
+    // called on an ingestion worker for each accepted item
+    void processItem(const std::shared_ptr<const mediametrics::Item>& item, bool isTrusted);
     void saveItem(const std::shared_ptr<const mediametrics::Item>& item);
 
     bool expirations(const std::shared_ptr<const mediametrics::Item>& item) REQUIRES(mLock);
@@ -153,6 +178,10 @@ private:
     using ItemKey = std::string;
     using WeakItemQueue = std::deque<std::weak_ptr<const mediametrics::Item>>;
     std::unordered_map<ItemKey, WeakItemQueue> mPullableItems GUARDED_BY(mLock);
+
+    // mIngestionQueue is locked internally.
+    // Its workers use the members above, so it is declared (and started) last.
+    mediametrics::IngestionQueue mIngestionQueue;
 };
 
 } // namespace android
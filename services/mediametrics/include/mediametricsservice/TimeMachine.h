@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -54,6 +56,158 @@ std::ostream & operator<< (std::ostream& s,
     return s;
 }
 
+/**
+ * The StringPool shares the storage of equal strings, such as the property
+ * names which are repeated in every key of the same kind.
+ *
+ * A string is released once the last handle to it is gone.
+ *
+ * The StringPool is thread safe.
+ */
+class StringPool {
+public:
+    using Handle = std::shared_ptr<const std::string>;
+
+    // Returns the pool used for TimeMachine property names.
+    static StringPool& propertyNames() {
+        static StringPool *pool = new StringPool(); // never deleted
+        return *pool;
+    }
+
+    Handle intern(const std::string& s) {
+        std::lock_guard lock(mLock);
+        auto it = mStrings.find(s);
+        if (it != mStrings.end()) {
+            Handle handle = it->second.lock();
+            if (handle == nullptr) {
+                handle = std::make_shared<const std::string>(s);
+                it->second = handle;
+            }
+            return handle;
+        }
+        if (mStrings.size() >= mSweepSize) {
+            // remove released strings, amortized over the insertions.
+            for (auto it2 = mStrings.begin(); it2 != mStrings.end();) {
+                it2 = it2->second.expired() ? mStrings.erase(it2) : std::next(it2);
+            }
+            mSweepSize = std::max(kMinSweepSize, mStrings.size() * 2);
+        }
+        Handle handle = std::make_shared<const std::string>(s);
+        mStrings.emplace(s, handle);
+        return handle;
+    }
+
+    size_t size() const {
+        std::lock_guard lock(mLock);
+        return mStrings.size();
+    }
+
+private:
+    static inline constexpr size_t kMinSweepSize = 256;
+
+    mutable std::mutex mLock;
+    std::map<std::string, std::weak_ptr<const std::string>> mStrings GUARDED_BY(mLock);
+    size_t mSweepSize GUARDED_BY(mLock) = kMinSweepSize;
+};
+
+/**
+ * The TimeSequence is a ring buffer of the most recent values of a property,
+ * ordered by time.  Times and values are stored in separate arrays so that
+ * time searches do not touch the values.
+ *
+ * The TimeSequence is NOT thread safe.
+ */
+template <typename E>
+class TimeSequence {
+public:
+    explicit TimeSequence(size_t capacity) : mCapacity(capacity) {}
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+
+    // element accessors in time order, where index 0 is the oldest element.
+    int64_t timeAt(size_t i) const { return mTimes[physical(i)]; }
+    const E& valueAt(size_t i) const { return mValues[physical(i)]; }
+    const E& back() const { return valueAt(mSize - 1); }
+
+    // Returns the index of the first element with a time greater than |time|.
+    size_t upperBound(int64_t time) const {
+        size_t lo = 0;
+        size_t hi = mSize;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (timeAt(mid) <= time) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    // Returns the index of the first element with a time not less than |time|.
+    size_t lowerBound(int64_t time) const {
+        size_t lo = 0;
+        size_t hi = mSize;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (timeAt(mid) < time) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    /**
+     * Inserts an element after the elements with the same or earlier time,
+     * discarding the oldest element if the TimeSequence is full.
+     */
+    void insert(int64_t time, E&& e) {
+        const size_t position = upperBound(time);
+        if (mSize == mCapacity) {
+            if (position == 0) return; // older than everything we keep.
+            releaseBytes(mValues[mHead]);
+            mTimes[mHead] = time;
+            mValues[mHead] = std::move(e);
+            mHead = (mHead + 1) % mCapacity;
+            retainBytes(back());
+            // move the new element down to its position (oldest was discarded).
+            for (size_t i = mSize - 1; i > position - 1; --i) swap(i, i - 1);
+            return;
+        }
+        // not full, so the elements are not wrapped and mHead is 0.
+        mTimes.insert(mTimes.begin() + position, time);
+        mValues.insert(mValues.begin() + position, std::move(e));
+        ++mSize;
+        retainBytes(mValues[position]);
+    }
+
+    // Returns the estimated memory used by the elements.
+    size_t getBytes() const {
+        return mTimes.capacity() * sizeof(int64_t) + mValues.capacity() * sizeof(E)
+                + mExtraBytes;
+    }
+
+private:
+    size_t physical(size_t i) const {
+        return mHead + i < mCapacity ? mHead + i : mHead + i - mCapacity;
+    }
+
+    void swap(size_t i, size_t j) {
+        std::swap(mTimes[physical(i)], mTimes[physical(j)]);
+        std::swap(mValues[physical(i)], mValues[physical(j)]);
+    }
+
+    // string values are stored outside of the element.
+    void retainBytes(const E& e) {
+        if (const auto *s = std::get_if<std::string>(&e)) mExtraBytes += s->capacity();
+    }
+    void releaseBytes(const E& e) {
+        if (const auto *s = std::get_if<std::string>(&e)) mExtraBytes -= s->capacity();
+    }
+
+    const size_t mCapacity;
+    size_t mHead = 0;        // physical index of the oldest element.
+    size_t mSize = 0;
+    size_t mExtraBytes = 0;
+    std::vector<int64_t> mTimes;
+    std::vector<E> mValues;
+};
+
 /**
  * The TimeMachine is used to record timing changes of MediaAnalyticItem
  * properties.
@@ -61,12 +215,16 @@ std::ostream & operator<< (std::ostream& s,
  * Any URL that ends with '#' (AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED)
  * will have a time sequence that keeps duplicates.
  *
+ * Property names are interned, and each property keeps a bounded TimeSequence.
+ * Besides the number of keys, the TimeMachine limits the estimated memory used,
+ * evicting the least recently modified keys when it is exceeded.
+ *
  * The TimeMachine is NOT thread safe.
  */
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
+    using PropertyHistory = TimeSequence<Elem>;
 
 private:
 
@@ -81,6 +239,7 @@ private:
             , mAllowUid(allowUid)
             , mCreationTime(time)
             , mLastModificationTime(time)
+            , mBytes(sizeof(KeyHistory) + mKey.capacity())
         {
             (void)mCreationTime; // suppress unused warning.
 
@@ -111,11 +270,9 @@ private:
             const auto tsptr = mPropertyMap.find(property);
             if (tsptr == mPropertyMap.end()) return BAD_VALUE;
             const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const size_t index = timeSequence.upperBound(time);
+            if (index == 0) return BAD_VALUE;
+            const T* vptr = std::get_if<T>(&timeSequence.valueAt(index - 1));
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
@@ -140,23 +297,25 @@ private:
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             mLastModificationTime = time;
-            if (mPropertyMap.size() >= kKeyMaxProperties &&
-                    !mPropertyMap.count(property)) {
-                ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
-                return;
+            auto tsptr = mPropertyMap.find(property);
+            if (tsptr == mPropertyMap.end()) {
+                if (mPropertyMap.size() >= kKeyMaxProperties) {
+                    ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
+                    return;
+                }
+                tsptr = mPropertyMap.emplace(StringPool::propertyNames().intern(property),
+                        PropertyHistory(kTimeSequenceMaxElements)).first;
+                mBytes += kPropertyOverheadBytes + tsptr->second.getBytes();
             }
-            auto& timeSequence = mPropertyMap[property];
+            auto& timeSequence = tsptr->second;
             Elem el{std::forward<T>(e)};
             if (timeSequence.empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
-                    ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
-                            __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
-                }
+                    || timeSequence.back() != el) { // value changed
+                // restricts maximum elements (discarding oldest).
+                const size_t bytes = timeSequence.getBytes();
+                timeSequence.insert(time, std::move(el));
+                mBytes += timeSequence.getBytes() - bytes;
             }
         }
 
@@ -179,29 +338,37 @@ private:
             return mLastModificationTime;
         }
 
+        // Returns the estimated memory used by the KeyHistory.
+        // Interned property names are not included.
+        size_t getBytes() const REQUIRES(mPseudoKeyHistoryLock) {
+            return mBytes;
+        }
+
     private:
-        static std::string dump(
-                const std::string &key,
-                const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
-                int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
+        // map node and string handle for each property, an estimate.
+        static inline constexpr size_t kPropertyOverheadBytes = 64;
+
+        template <typename P>
+        static std::string dump(const std::string &key, const P& tsPair, int64_t time) {
+            const auto& timeSequence = tsPair.second;
+            size_t index = timeSequence.lowerBound(time);
+            if (index == timeSequence.size()) {
                 return {}; // don't dump anything. tsPair.first + "={};\n";
             }
             std::stringstream ss;
-            ss << key << "." << tsPair.first << "={";
+            ss << key << "." << *tsPair.first << "={";
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const time_string_t timestring =
+                        mediametrics::timeStringFromNs(timeSequence.timeAt(index));
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << timeSequence.valueAt(index);
+                if (++index == timeSequence.size()) {
                     break;
                 }
                 ss << ", ";
@@ -214,8 +381,19 @@ private:
         const uid_t mAllowUid;
         const int64_t mCreationTime;
 
+        // orders interned property names by value, and allows lookup by std::string.
+        struct PropertyNameLess {
+            using is_transparent = void;
+            static const std::string& name(const StringPool::Handle& h) { return *h; }
+            static const std::string& name(const std::string& s) { return s; }
+            template <typename A, typename B>
+            bool operator()(const A& a, const B& b) const { return name(a) < name(b); }
+        };
+
         int64_t mLastModificationTime;
-        std::map<std::string /* property */, PropertyHistory> mPropertyMap;
+        size_t mBytes;
+        std::map<StringPool::Handle /* property */, PropertyHistory, PropertyNameLess>
+                mPropertyMap;
     };
 
     using History = std::map<std::string /* key */, std::shared_ptr<KeyHistory>>;
@@ -224,15 +402,19 @@ private:
     static inline constexpr size_t kKeyMaxProperties = 50;
     static inline constexpr size_t kKeyLowWaterMark = 400;
     static inline constexpr size_t kKeyHighWaterMark = 500;
+    static inline constexpr size_t kMemoryBudgetBytes = 2 * 1024 * 1024;
 
-    // Estimated max data space usage is 3KB * kKeyHighWaterMark.
+    // Estimated max data space usage is 3KB * kKeyHighWaterMark,
+    // and is further restricted by kMemoryBudgetBytes.
 
 public:
 
     TimeMachine() = default;
-    TimeMachine(size_t keyLowWaterMark, size_t keyHighWaterMark)
+    TimeMachine(size_t keyLowWaterMark, size_t keyHighWaterMark,
+            size_t memoryBudgetBytes = kMemoryBudgetBytes)
         : mKeyLowWaterMark(keyLowWaterMark)
-        , mKeyHighWaterMark(keyHighWaterMark) {
+        , mKeyHighWaterMark(keyHighWaterMark)
+        , mMemoryBudgetBytes(memoryBudgetBytes) {
         LOG_ALWAYS_FATAL_IF(keyHighWaterMark <= keyLowWaterMark,
               "%s: required that keyHighWaterMark:%zu > keyLowWaterMark:%zu",
                   __func__, keyHighWaterMark, keyLowWaterMark);
@@ -257,13 +439,16 @@ public:
             mHistory = other.mHistory;
             mGarbageCollectionCount = other.mGarbageCollectionCount.load();
         }
+        size_t bytes = 0;
 
         // Now that we safely have our own shared pointers, let's dup them
         // to ensure they are decoupled.  We do this by acquiring the other lock.
         for (const auto &[lkey, lhist] : mHistory) {
             std::lock_guard lock2(other.getLockForKey(lkey));
             mHistory[lkey] = std::make_shared<KeyHistory>(*lhist);
+            bytes += lhist->getBytes();
         }
+        mBytes = bytes;
         return *this;
     }
 
@@ -278,6 +463,7 @@ public:
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
                 key.c_str(), (int)isTrusted, item->count());
         std::shared_ptr<KeyHistory> keyHistory;
+        bool created = false;
         {
             std::vector<std::any> garbage;
             std::lock_guard lock(mLock);
@@ -296,6 +482,7 @@ public:
                 keyHistory = std::make_shared<KeyHistory>(
                     key, allowUid, time);
                 mHistory[key] = keyHistory;
+                created = true;
             } else {
                 keyHistory = it->second;
             }
@@ -310,6 +497,7 @@ public:
                 status_t status = keyHistory->checkPermission(item->getUid());
                 if (status != NO_ERROR) return status;
             }
+            const size_t bytes = created ? 0 : keyHistory->getBytes();
 
             for (const auto &prop : *item) {
                 const std::string &name = prop.getName();
@@ -323,6 +511,7 @@ public:
                     keyHistory->putProp(name, prop, time);
                 }
             }
+            mBytes += keyHistory->getBytes() - bytes;
         }
 
         // handle remote properties, if any
@@ -342,8 +531,11 @@ public:
                 remoteKeyHistory = it->second;
             }
             std::lock_guard lock(getLockForKey(remoteKey));
+            const size_t bytes = remoteKeyHistory->getBytes();
             remoteKeyHistory->putProp(remoteName, prop, time);
+            mBytes += remoteKeyHistory->getBytes() - bytes;
         }
+        gcIfOverBudget();
         return NO_ERROR;
     }
 
@@ -375,8 +567,13 @@ public:
             getKeyHistoryFromUrl(url, &key, &prop);
         if (keyHistory == nullptr) return BAD_VALUE;
         if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
-        std::lock_guard lock(getLockForKey(key));
-        keyHistory->putValue(prop, std::forward<T>(e), time);
+        {
+            std::lock_guard lock(getLockForKey(key));
+            const size_t bytes = keyHistory->getBytes();
+            keyHistory->putValue(prop, std::forward<T>(e), time);
+            mBytes += keyHistory->getBytes() - bytes;
+        }
+        gcIfOverBudget();
         return NO_ERROR;
     }
 
@@ -422,6 +619,7 @@ public:
         std::lock_guard lock(mLock);
         mHistory.clear();
         mGarbageCollectionCount = 0;
+        mBytes = 0;
     }
 
     /**
@@ -459,6 +657,13 @@ public:
         return mGarbageCollectionCount;
     }
 
+    /**
+     * Returns the estimated memory used by the TimeMachine.
+     */
+    size_t getBytes() const {
+        return mBytes;
+    }
+
 private:
 
     // Obtains the lock for a KeyHistory.
@@ -500,12 +705,14 @@ private:
      */
     bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
         // TODO: something better than this for garbage collection.
-        if (mHistory.size() < mKeyHighWaterMark) return false;
+        if (mHistory.size() < mKeyHighWaterMark && mBytes <= mMemoryBudgetBytes) return false;
 
         // erase everything explicitly expired.
-        std::multimap<int64_t, std::string> accessList;
+        std::multimap<int64_t, std::pair<std::string, size_t /* bytes */>> accessList;
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<KeyHistory>> stale;
+        // recount the memory used, as keys may have been modified after being removed.
+        size_t bytes = 0;
 
         for (auto it = mHistory.begin(); it != mHistory.end();) {
             const std::string& key = it->first;
@@ -517,36 +724,51 @@ private:
                 stale.emplace_back(std::move(it->second));
                 it = mHistory.erase(it);
             } else {
-                accessList.emplace(keyHist->getLastModificationTime(), key);
+                accessList.emplace(keyHist->getLastModificationTime(),
+                        std::make_pair(key, keyHist->getBytes()));
+                bytes += keyHist->getBytes();
                 ++it;
             }
         }
 
-        if (mHistory.size() > mKeyLowWaterMark) {
-           const size_t toDelete = mHistory.size() - mKeyLowWaterMark;
-           auto it = accessList.begin();
-           for (size_t i = 0; i < toDelete; ++i) {
-               auto it2 = mHistory.find(it->second);
-               stale.emplace_back(std::move(it2->second));
-               mHistory.erase(it2);
-               ++it;
-           }
+        // evict the least recently modified keys until below both the low water mark
+        // and the low water memory budget.
+        const size_t lowWaterBytes = mMemoryBudgetBytes / 4 * 3;
+        for (auto it = accessList.begin(); it != accessList.end()
+                && (mHistory.size() > mKeyLowWaterMark || bytes > lowWaterBytes); ++it) {
+            auto it2 = mHistory.find(it->second.first);
+            bytes -= it->second.second;
+            stale.emplace_back(std::move(it2->second));
+            mHistory.erase(it2);
         }
+        mBytes = bytes;
         garbage.emplace_back(std::move(accessList));
         garbage.emplace_back(std::move(stale));
 
-        ALOGD("%s(%zu, %zu): key size:%zu",
-                __func__, mKeyLowWaterMark, mKeyHighWaterMark,
-                mHistory.size());
+        ALOGD("%s(%zu, %zu, %zu): key size:%zu bytes:%zu",
+                __func__, mKeyLowWaterMark, mKeyHighWaterMark, mMemoryBudgetBytes,
+                mHistory.size(), mBytes.load());
 
         ++mGarbageCollectionCount;
         return true;
     }
 
+    // Garbage collects if the estimated memory exceeds the budget.
+    void gcIfOverBudget() {
+        if (mBytes <= mMemoryBudgetBytes) return;
+        std::vector<std::any> garbage;
+        std::lock_guard lock(mLock);
+        (void)gc(garbage);
+    }
+
     const size_t mKeyLowWaterMark = kKeyLowWaterMark;
     const size_t mKeyHighWaterMark = kKeyHighWaterMark;
+    const size_t mMemoryBudgetBytes = kMemoryBudgetBytes;
 
     std::atomic<size_t> mGarbageCollectionCount{};
+    // Estimated memory used by the KeyHistories, updated under the key locks
+    // and recounted by gc().
+    std::atomic<size_t> mBytes{};
 
     /**
      * Locking Strategy
@@ -20,6 +20,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <string.h>
 
 #include <android-base/thread_annotations.h>
 #include <media/MediaMetricsItem.h>
@@ -35,6 +36,9 @@ namespace android::mediametrics {
  *
  * These Views have a cost in shared pointer storage, so they aren't quite free.
  *
+ * Besides the number of items, the TransactionLog limits the estimated memory used
+ * by the items, discarding the oldest items when it is exceeded.
+ *
  * The TransactionLog is NOT thread safe.
  */
 class TransactionLog final { // made final as we have copy constructor instead of dup() override.
@@ -47,13 +51,19 @@ public:
     // high water mark
     static inline constexpr size_t kLogItemsHighWater = 2000;
 
-    // Estimated max data usage is 1KB * kLogItemsHighWater.
+    // memory budget
+    static inline constexpr size_t kMemoryBudgetBytes = 2 * 1024 * 1024;
+
+    // Estimated max data usage is 1KB * kLogItemsHighWater,
+    // and is further restricted by kMemoryBudgetBytes.
 
     TransactionLog() = default;
 
-    TransactionLog(size_t lowWaterMark, size_t highWaterMark)
+    TransactionLog(size_t lowWaterMark, size_t highWaterMark,
+            size_t memoryBudgetBytes = kMemoryBudgetBytes)
         : mLowWaterMark(lowWaterMark)
-        , mHighWaterMark(highWaterMark) {
+        , mHighWaterMark(highWaterMark)
+        , mMemoryBudgetBytes(memoryBudgetBytes) {
         LOG_ALWAYS_FATAL_IF(highWaterMark <= lowWaterMark,
               "%s: required that highWaterMark:%zu > lowWaterMark:%zu",
                   __func__, highWaterMark, lowWaterMark);
@@ -80,6 +90,7 @@ public:
         mLog = other.mLog;
         mItemMap = other.mItemMap;
         mGarbageCollectionCount = other.mGarbageCollectionCount.load();
+        mBytes = other.mBytes;
 
         return *this;
     }
@@ -94,6 +105,7 @@ public:
         std::vector<std::any> garbage;  // objects destroyed after lock.
         std::lock_guard lock(mLock);
 
+        mBytes += estimateBytes(*item);
         (void)gc(garbage);
         mLog.emplace_hint(mLog.end(), time, item);
         mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
@@ -183,12 +195,21 @@ public:
         mLog.clear();
         mItemMap.clear();
         mGarbageCollectionCount = 0;
+        mBytes = 0;
     }
 
     size_t getGarbageCollectionCount() const {
         return mGarbageCollectionCount;
     }
 
+    /**
+     * Returns the estimated memory used by the TransactionLog.
+     */
+    size_t getBytes() const {
+        std::lock_guard lock(mLock);
+        return mBytes;
+    }
+
 private:
     using MapTimeItem =
             std::multimap<int64_t /* time */, std::shared_ptr<const mediametrics::Item>>;
@@ -220,27 +241,32 @@ private:
      * \return true if garbage collection was done.
      */
     bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
-        if (mLog.size() < mHighWaterMark) return false;
+        if (mLog.size() < mHighWaterMark && mBytes <= mMemoryBudgetBytes) return false;
+        if (mLog.empty()) return false;
 
         auto eraseEnd = mLog.begin();
-        size_t toRemove = mLog.size() - mLowWaterMark;
-        // remove at least those elements.
+        size_t toRemove = mLog.size() > mLowWaterMark ? mLog.size() - mLowWaterMark : 0;
+        const size_t lowWaterBytes = mMemoryBudgetBytes / 4 * 3;
+        // remove at least those elements, and enough to be below the low water memory.
 
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<const mediametrics::Item>> stale;
 
-        for (size_t i = 0; i < toRemove; ++i) {
+        for (size_t i = 0; eraseEnd != mLog.end() && (i < toRemove || mBytes > lowWaterBytes);
+                ++i) {
+            mBytes -= estimateBytes(*eraseEnd->second);
             stale.emplace_back(std::move(eraseEnd->second));
             ++eraseEnd; // amortized O(1)
         }
         // ensure that eraseEnd is an lower bound on timeToErase.
-        const int64_t timeToErase = eraseEnd->first;
+        const int64_t timeToErase = eraseEnd != mLog.end() ? eraseEnd->first : INT64_MAX;
         while (eraseEnd != mLog.end()) {
             auto it = eraseEnd;
             --it;  // amortized O(1)
             if (it->first != timeToErase) {
                 break;  // eraseEnd represents a unique time jump.
             }
+            mBytes -= estimateBytes(*eraseEnd->second);
             stale.emplace_back(std::move(eraseEnd->second));
             ++eraseEnd;
         }
@@ -266,13 +292,29 @@ private:
 
         garbage.emplace_back(std::move(stale));
 
-        ALOGD("%s(%zu, %zu): log size:%zu item map size:%zu, item map items:%zu",
-                __func__, mLowWaterMark, mHighWaterMark,
-                mLog.size(), mItemMap.size(), itemMapCount);
+        ALOGD("%s(%zu, %zu, %zu): log size:%zu item map size:%zu, item map items:%zu bytes:%zu",
+                __func__, mLowWaterMark, mHighWaterMark, mMemoryBudgetBytes,
+                mLog.size(), mItemMap.size(), itemMapCount, mBytes);
         ++mGarbageCollectionCount;
         return true;
     }
 
+    // Returns the estimated memory used by an item in the TransactionLog,
+    // including its entries in mLog and mItemMap.
+    static size_t estimateBytes(const mediametrics::Item& item) {
+        // map node overhead, an estimate.
+        constexpr size_t kMapNodeBytes = 48;
+        size_t bytes = 2 * kMapNodeBytes + sizeof(mediametrics::Item)
+                + item.getKey().capacity();
+        for (const auto &prop : item) {
+            bytes += kMapNodeBytes + sizeof(prop) + strlen(prop.getName());
+            if (const auto *s = std::get_if<std::string>(&prop.get())) {
+                bytes += s->capacity();
+            }
+        }
+        return bytes;
+    }
+
     static std::vector<std::shared_ptr<const mediametrics::Item>> getItemsInRange(
             const MapTimeItem& map,
             int64_t startTime = 0, int64_t endTime = INT64_MAX) {
@@ -291,11 +333,13 @@ private:
 
     const size_t mLowWaterMark = kLogItemsLowWater;
     const size_t mHighWaterMark = kLogItemsHighWater;
+    const size_t mMemoryBudgetBytes = kMemoryBudgetBytes;
 
     std::atomic<size_t> mGarbageCollectionCount{};
 
     mutable std::mutex mLock;
 
+    size_t mBytes GUARDED_BY(mLock) = 0;  // estimated memory used by the items.
     MapTimeItem mLog GUARDED_BY(mLock);
     std::map<std::string /* item_key */, MapTimeItem> mItemMap GUARDED_BY(mLock);
 };
@@ -84,6 +84,10 @@ bool statsd_extractor(const std::shared_ptr<const mediametrics::Item>& item,
       metrics_proto.set_entry_point(entry_point);
     }
 
+    // not in ExtractorData yet, so only logged below
+    int64_t open_time_us = -1;
+    (void)item->getInt64("android.media.mediaextractor.openTimeUs", &open_time_us);
+
     std::string log_session_id;
     if (item->getString("android.media.mediaextractor.logSessionId", &log_session_id)) {
         log_session_id = mediametrics::ValidateId::get()->validateId(log_session_id);
@@ -115,6 +119,7 @@ bool statsd_extractor(const std::shared_ptr<const mediametrics::Item>& item,
             << " tracks:" << tracks
             << " entry_point:" << entry_point_string << "(" << entry_point << ")"
             << " log_session_id:" << log_session_id
+            << " open_time_us:" << open_time_us
             << " }";
     statsdLog->log(android::util::MEDIAMETRICS_EXTRACTOR_REPORTED, log.str());
     return true;
@@ -19,7 +19,11 @@
 
 
 #include <stdio.h>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <media/MediaMetricsItem.h>
@@ -223,6 +227,7 @@ TEST(mediametrics_tests, instantiate) {
   audiotrack_key->addInt32("foo", 10);
   status = mediaMetrics->submit(audiotrack_key.get());
   ASSERT_EQ(NO_ERROR, status);
+  mediaMetrics->flushIngestion();
 
 
   /*
@@ -438,6 +443,32 @@ TEST(mediametrics_tests, item_byteserialization) {
   free(data);
 }
 
+TEST(mediametrics_tests, submit_batch) {
+  sp mediaMetrics = new MediaMetricsService();
+
+  mediametrics::Item audiotrack("audiotrack");
+  audiotrack.setInt32("foo", 10);
+  mediametrics::Item audiorecord("audiorecord");
+  audiorecord.setInt64("bar", 20).setCString("baz", "abc");
+
+  std::vector<char> batch;
+  for (const mediametrics::Item *item : {&audiotrack, &audiorecord}) {
+    char *data;
+    size_t length;
+    ASSERT_EQ(NO_ERROR, item->writeToByteString(&data, &length));
+    batch.insert(batch.end(), data, data + length);
+    free(data);
+  }
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBatch(batch.data(), batch.size()));
+
+  // a truncated item cannot be split from the batch
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBatch(batch.data(), batch.size() - 1));
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBatch(batch.data(), 2));
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBatch(batch.data(), 0));
+  mediaMetrics->flushIngestion();
+  mediaMetrics->dump(fileno(stdout), {} /* args */);
+}
+
 TEST(mediametrics_tests, item_iteration) {
   mediametrics::Item item;
   item.setInt32("i32", 1)
@@ -710,6 +741,55 @@ TEST(mediametrics_tests, time_machine_gc) {
   printf("After\n%s\n", timeMachine.dump().first.c_str());
 }
 
+TEST(mediametrics_tests, time_machine_time_sequence) {
+  android::mediametrics::TimeMachine timeMachine;
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  (*item).set("value", (int32_t)0).setTimestamp(10);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+
+  // values are ordered by time, even if put out of order.
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", (int32_t)30, 30));
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", (int32_t)20, 20));
+  int32_t i32;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 25));
+  ASSERT_EQ(20, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 35));
+  ASSERT_EQ(30, i32);
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 5));
+
+  // only the most recent values are kept.
+  for (int32_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", i, 100 + i));
+  }
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 150));
+  ASSERT_EQ(50, i32);
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 120));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 1000));
+  ASSERT_EQ(99, i32);
+}
+
+TEST(mediametrics_tests, time_machine_memory_budget) {
+  constexpr size_t kBudget = 16 * 1024;
+  android::mediametrics::TimeMachine timeMachine(1000, 2000, kBudget);
+
+  for (int32_t i = 0; i < 100; ++i) {
+    auto item = std::make_shared<mediametrics::Item>(("Key" + std::to_string(i)).c_str());
+    (*item).set("string", std::string(200, 'a'))
+           .set("i32", i)
+           .setTimestamp(10 + i);
+    ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+  }
+  ASSERT_LE(timeMachine.getBytes(), kBudget);
+  ASSERT_LT(timeMachine.size(), (size_t)100);
+  ASSERT_GT(timeMachine.getGarbageCollectionCount(), (size_t)0);
+
+  // the least recently modified keys are evicted.
+  int32_t i32;
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key0.i32", &i32, -1));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key99.i32", &i32, -1));
+  ASSERT_EQ(99, i32);
+}
+
 TEST(mediametrics_tests, transaction_log_gc) {
   auto item = std::make_shared<mediametrics::Item>("Key1");
   (*item).set("one", (int32_t)1)
@@ -740,6 +820,29 @@ TEST(mediametrics_tests, transaction_log_gc) {
   ASSERT_EQ((size_t)2, transactionLog.size());
 }
 
+TEST(mediametrics_tests, transaction_log_memory_budget) {
+  constexpr size_t kBudget = 16 * 1024;
+  android::mediametrics::TransactionLog transactionLog(1000, 2000, kBudget);
+
+  for (int32_t i = 0; i < 100; ++i) {
+    auto item = std::make_shared<mediametrics::Item>("Key");
+    (*item).set("string", std::string(200, 'a'))
+           .setTimestamp(10 + i);
+    ASSERT_EQ(NO_ERROR, transactionLog.put(item));
+  }
+  ASSERT_LE(transactionLog.getBytes(), kBudget);
+  ASSERT_LT(transactionLog.size(), (size_t)100);
+
+  // the oldest items are discarded.
+  auto items = transactionLog.get("Key");
+  ASSERT_EQ(transactionLog.size(), items.size());
+  ASSERT_EQ(10 + 99, items.back()->getTimestamp());
+  ASSERT_GT(items.front()->getTimestamp(), 10);
+
+  transactionLog.clear();
+  ASSERT_EQ((size_t)0, transactionLog.getBytes());
+}
+
 TEST(mediametrics_tests, analytics_actions) {
   mediametrics::AnalyticsActions analyticsActions;
   bool action1 = false;
@@ -945,6 +1048,55 @@ TEST(mediametrics_tests, timed_action) {
     ASSERT_EQ((size_t)1, timedAction.size());
 }
 
+TEST(mediametrics_tests, ingestion_queue) {
+    // the same key prefix always maps to the same shard.
+    using android::mediametrics::IngestionQueue;
+    ASSERT_EQ(IngestionQueue::shardForKey("audio.track.10", 4),
+            IngestionQueue::shardForKey("audio.flinger", 4));
+    ASSERT_EQ(IngestionQueue::shardForKey("audio", 4),
+            IngestionQueue::shardForKey("audio.record.1", 4));
+    ASSERT_EQ((size_t)0, IngestionQueue::shardForKey("audio.track.10", 1));
+
+    // work for the same prefix executes in order, from many producers.
+    constexpr size_t THREADS = 4;
+    constexpr size_t ITERATIONS = 1000;
+    IngestionQueue queue(3);
+    std::mutex lock;
+    std::map<std::string, std::vector<size_t>> executed; // prefix -> producer iterations
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&, i] {
+            const std::string prefix = "prefix" + std::to_string(i);
+            for (size_t j = 0; j < ITERATIONS; ++j) {
+                queue.post(prefix + ".key", [&, prefix, j] {
+                    std::lock_guard l(lock);
+                    executed[prefix].push_back(j);
+                });
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    queue.flush();
+    ASSERT_EQ((size_t)0, queue.size());
+    ASSERT_EQ(THREADS, executed.size());
+    for (const auto& [prefix, iterations] : executed) {
+        ASSERT_EQ(ITERATIONS, iterations.size());
+        for (size_t j = 0; j < ITERATIONS; ++j) {
+            ASSERT_EQ(j, iterations[j]);
+        }
+    }
+
+    // work posted after quit, or without shards, executes inline.
+    queue.quit();
+    int value = 0;
+    queue.post("audio.track", [&value] { ++value; });
+    ASSERT_EQ(1, value);
+    IngestionQueue inlineQueue(0);
+    inlineQueue.post("audio.track", [&value] { ++value; });
+    ASSERT_EQ(2, value);
+    ALOGD("%s", inlineQueue.dump().first.c_str());
+}
+
 // Ensure we don't introduce unexpected duplicates into our maps.
 TEST(mediametrics_tests, audio_types_tables) {
     using namespace android::mediametrics::types;
@@ -1293,3 +1445,25 @@ TEST(mediametrics_tests, HeatMap) {
     heatMap.clear();
     ASSERT_EQ((size_t)0, heatMap.size());
 }
+
+TEST(mediametrics_tests, HeatData_fixed_capacity) {
+    android::mediametrics::HeatData heatData;
+    constexpr size_t EXTRA = 3;
+    const size_t entries = android::mediametrics::HeatData::kMaxEntries;
+
+    // Each event has a single status, so an entry per event.
+    for (size_t i = 0; i < entries + EXTRA; ++i) {
+        heatData.add("", "event" + std::to_string(i), AMEDIAMETRICS_PROP_STATUS_VALUE_OK,
+                0 /* uid */, "", 0 /* subCode */);
+    }
+    ASSERT_EQ(entries, heatData.size());
+    ASSERT_EQ(EXTRA, heatData.dropped());
+
+    // Events already present are still counted.
+    heatData.add("", "event0", AMEDIAMETRICS_PROP_STATUS_VALUE_OK, 0 /* uid */, "", 0);
+    auto count = heatData.heatCount();
+    ASSERT_EQ(entries + 1, count.size());
+    ASSERT_EQ(entries + 1, count[0].first);
+    ASSERT_EQ((size_t)0, count[0].second);
+    ASSERT_EQ(EXTRA, heatData.dropped());
+}
@@ -151,24 +151,16 @@ static bool hasResourceType(MediaResource::Type type, MediaResource::SubType sub
     return false;
 }
 
-static bool hasResourceType(MediaResource::Type type, MediaResource::SubType subType,
-        const ResourceList& resources) {
-    for (auto it = resources.begin(); it != resources.end(); it++) {
-        if (hasResourceType(type, subType, it->second)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static bool hasResourceType(MediaResource::Type type, MediaResource::SubType subType,
-        const ResourceInfos& infos) {
-    for (size_t i = 0; i < infos.size(); ++i) {
-        if (hasResourceType(type, subType, infos[i].resources)) {
-            return true;
-        }
+// The key under which a resource is kept in the ResourceIndex, matching hasResourceType().
+static ResourceIndexKey getResourceIndexKey(MediaResource::Type type,
+        MediaResource::SubType subType) {
+    switch (type) {
+        case MediaResource::Type::kSecureCodec:
+        case MediaResource::Type::kNonSecureCodec:
+            return {type, subType};
+        default:
+            return {type, MediaResource::SubType::kUnspecifiedSubType};
     }
-    return false;
 }
 
 static ResourceInfos& getResourceInfosForEdit(int pid, PidResourceInfosMap& map) {
@@ -334,6 +326,7 @@ ResourceManagerService::ResourceManagerService(const sp<ProcessInfoInterface> &p
       mServiceLog(new ServiceLog()),
       mSupportsMultipleSecureCodecs(true),
       mSupportsSecureWithNonSecureCodec(true),
+      mPriorityCacheEnabled(false),
       mCpuBoostCount(0),
       mDeathRecipient(AIBinder_DeathRecipient_new(DeathNotifier::BinderDiedCallback)) {
     mSystemCB->noteResetVideo();
@@ -471,6 +464,7 @@ Status ResourceManagerService::addResource(int32_t pid, int32_t uid, int64_t cli
             }
             onFirstAdded(res, info);
             info.resources[resType] = res;
+            addToResourceIndex_l(pid, clientId, res);
         } else {
             mergeResources(info.resources[resType], res);
         }
@@ -538,6 +532,7 @@ Status ResourceManagerService::removeResource(int32_t pid, int64_t clientId,
             } else {
                 onLastRemoved(res, info);
                 actualRemoved.value = resource.value;
+                removeFromResourceIndex_l(pid, clientId, res);
                 info.resources.erase(resType);
             }
 
@@ -593,6 +588,7 @@ Status ResourceManagerService::removeResource(int pid, int64_t clientId, bool ch
     }
 
     removeCookieAndUnlink_l(info.client, info.cookie);
+    removeFromResourceIndex_l(pid, info);
 
     if (mObserverService != nullptr && !info.resources.empty()) {
         mObserverService->onResourceRemoved(info.uid, pid, info.resources);
@@ -623,6 +619,7 @@ Status ResourceManagerService::reclaimResource(int32_t callingPid,
     Vector<std::shared_ptr<IResourceManagerClient>> clients;
     {
         Mutex::Autolock lock(mLock);
+        PriorityCache priorityCache(this);
         if (!mProcessInfo->isPidTrusted(callingPid)) {
             pid_t actualCallingPid = IPCThreadState::self()->getCallingPid();
             ALOGW("%s called with untrusted pid %d, using actual calling pid %d", __FUNCTION__,
@@ -740,6 +737,7 @@ bool ResourceManagerService::reclaimUnconditionallyFrom(
             ResourceInfos &infos = mMap.editValueAt(i);
             for (size_t j = 0; j < infos.size();) {
                 if (infos[j].client == failedClient) {
+                    removeFromResourceIndex_l(mMap.keyAt(i), infos[j]);
                     j = infos.removeItemsAt(j);
                     found = true;
                 } else {
@@ -952,6 +950,14 @@ Status ResourceManagerService::reclaimResourcesFromClientsPendingRemoval(int32_t
 }
 
 bool ResourceManagerService::getPriority_l(int pid, int* priority) {
+    if (mPriorityCacheEnabled) {
+        auto it = mPriorityCache.find(pid);
+        if (it != mPriorityCache.end()) {
+            *priority = it->second;
+            return true;
+        }
+    }
+
     int newPid = pid;
 
     if (mOverridePidMap.find(pid) != mOverridePidMap.end()) {
@@ -960,24 +966,74 @@ bool ResourceManagerService::getPriority_l(int pid, int* priority) {
                 newPid, pid);
     }
 
-    return mProcessInfo->getPriority(newPid, priority);
+    if (!mProcessInfo->getPriority(newPid, priority)) {
+        return false;
+    }
+    if (mPriorityCacheEnabled) {
+        mPriorityCache[pid] = *priority;
+    }
+    return true;
+}
+
+void ResourceManagerService::addToResourceIndex_l(int pid, int64_t clientId,
+        const MediaResourceParcel& res) {
+    ++mResourceIndex[getResourceIndexKey(res.type, res.subType)][pid][clientId];
+}
+
+void ResourceManagerService::removeFromResourceIndex_l(int pid, int64_t clientId,
+        const MediaResourceParcel& res) {
+    auto holders = mResourceIndex.find(getResourceIndexKey(res.type, res.subType));
+    if (holders == mResourceIndex.end()) {
+        return;
+    }
+    auto clients = holders->second.find(pid);
+    if (clients == holders->second.end()) {
+        return;
+    }
+    auto count = clients->second.find(clientId);
+    if (count == clients->second.end()) {
+        return;
+    }
+    if (--count->second > 0) {
+        return;
+    }
+    clients->second.erase(count);
+    if (clients->second.empty()) {
+        holders->second.erase(clients);
+        if (holders->second.empty()) {
+            mResourceIndex.erase(holders);
+        }
+    }
+}
+
+void ResourceManagerService::removeFromResourceIndex_l(int pid, const ResourceInfo& info) {
+    for (auto it = info.resources.begin(); it != info.resources.end(); it++) {
+        removeFromResourceIndex_l(pid, info.clientId, it->second);
+    }
+}
+
+const ResourceHolders* ResourceManagerService::getResourceHolders_l(MediaResource::Type type,
+        MediaResource::SubType subType) const {
+    auto it = mResourceIndex.find(getResourceIndexKey(type, subType));
+    return it == mResourceIndex.end() ? nullptr : &it->second;
 }
 
 bool ResourceManagerService::getAllClients_l(int callingPid, MediaResource::Type type,
         MediaResource::SubType subType, Vector<std::shared_ptr<IResourceManagerClient>> *clients) {
     Vector<std::shared_ptr<IResourceManagerClient>> temp;
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        ResourceInfos &infos = mMap.editValueAt(i);
-        for (size_t j = 0; j < infos.size(); ++j) {
-            if (hasResourceType(type, subType, infos[j].resources)) {
-                if (!isCallingPriorityHigher_l(callingPid, mMap.keyAt(i))) {
-                    // some higher/equal priority process owns the resource,
-                    // this request can't be fulfilled.
-                    ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
-                            asString(type), mMap.keyAt(i));
-                    return false;
-                }
-                temp.push_back(infos[j].client);
+    const ResourceHolders *holders = getResourceHolders_l(type, subType);
+    if (holders != nullptr) {
+        for (const auto& [pid, clientIds] : *holders) {
+            if (!isCallingPriorityHigher_l(callingPid, pid)) {
+                // some higher/equal priority process owns the resource,
+                // this request can't be fulfilled.
+                ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
+                        asString(type), pid);
+                return false;
+            }
+            const ResourceInfos &infos = mMap.valueFor(pid);
+            for (const auto& [clientId, count] : clientIds) {
+                temp.push_back(infos.valueFor(clientId).client);
             }
         }
     }
@@ -1025,16 +1081,12 @@ bool ResourceManagerService::getLowestPriorityPid_l(MediaResource::Type type,
         MediaResource::SubType subType, int *lowestPriorityPid, int *lowestPriority) {
     int pid = -1;
     int priority = -1;
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        if (mMap.valueAt(i).size() == 0) {
-            // no client on this process.
-            continue;
-        }
-        if (!hasResourceType(type, subType, mMap.valueAt(i))) {
-            // doesn't have the requested resource type
-            continue;
-        }
-        int tempPid = mMap.keyAt(i);
+    const ResourceHolders *holders = getResourceHolders_l(type, subType);
+    if (holders == nullptr) {
+        // no process has the requested resource type
+        return false;
+    }
+    for (const auto& [tempPid, clientIds] : *holders) {
         int tempPriority;
         if (!getPriority_l(tempPid, &tempPriority)) {
             ALOGV("getLowestPriorityPid_l: can't get priority of pid %d, skipped", tempPid);
@@ -1086,17 +1138,21 @@ bool ResourceManagerService::getBiggestClient_l(int pid, MediaResource::Type typ
     std::shared_ptr<IResourceManagerClient> clientTemp;
     uint64_t largestValue = 0;
     const ResourceInfos &infos = mMap.valueAt(index);
-    for (size_t i = 0; i < infos.size(); ++i) {
-        const ResourceList &resources = infos[i].resources;
-        if (pendingRemovalOnly && !infos[i].pendingRemoval) {
-            continue;
-        }
-        for (auto it = resources.begin(); it != resources.end(); it++) {
-            const MediaResourceParcel &resource = it->second;
-            if (hasResourceType(type, subType, resource)) {
-                if (resource.value > largestValue) {
-                    largestValue = resource.value;
-                    clientTemp = infos[i].client;
+    const ResourceHolders *holders = getResourceHolders_l(type, subType);
+    if (holders != nullptr && holders->count(pid) > 0) {
+        // only the clients of the pid that hold this resource type
+        for (const auto& [clientId, count] : holders->at(pid)) {
+            const ResourceInfo &info = infos.valueFor(clientId);
+            if (pendingRemovalOnly && !info.pendingRemoval) {
+                continue;
+            }
+            for (auto it = info.resources.begin(); it != info.resources.end(); it++) {
+                const MediaResourceParcel &resource = it->second;
+                if (hasResourceType(type, subType, resource)) {
+                    if (resource.value > largestValue) {
+                        largestValue = resource.value;
+                        clientTemp = info.client;
+                    }
                 }
             }
         }
@@ -61,6 +61,14 @@ struct ResourceInfo {
 typedef KeyedVector<int64_t, ResourceInfo> ResourceInfos;
 typedef KeyedVector<int, ResourceInfos> PidResourceInfosMap;
 
+// Secondary index of PidResourceInfosMap, from the kind of a resource to the
+// clients holding it, so that reclaim does not scan every client of every pid.
+// Codec resources are indexed by type and subtype, other resources by type only.
+// The innermost value counts the resource entries (ids) of that kind of the client.
+typedef std::pair<MediaResource::Type, MediaResource::SubType> ResourceIndexKey;
+typedef std::map<int, std::map<int64_t, int>> ResourceHolders;
+typedef std::map<ResourceIndexKey, ResourceHolders> ResourceIndex;
+
 class ResourceManagerService : public BnResourceManagerService {
 public:
     struct SystemCallbackInterface : public RefBase {
@@ -163,6 +171,31 @@ private:
     // Get priority from process's pid
     bool getPriority_l(int pid, int* priority);
 
+    // Keep mResourceIndex in sync with the resources of the clients in mMap.
+    void addToResourceIndex_l(int pid, int64_t clientId, const MediaResourceParcel& res);
+    void removeFromResourceIndex_l(int pid, int64_t clientId, const MediaResourceParcel& res);
+    void removeFromResourceIndex_l(int pid, const ResourceInfo& info);
+
+    // Returns the pids and clients holding the specified resource type, or nullptr if none.
+    const ResourceHolders* getResourceHolders_l(MediaResource::Type type,
+            MediaResource::SubType subType) const;
+
+    // Caches process priorities while in scope, as each lookup may be an IPC and
+    // a reclaim looks up the same processes many times. Priorities can change at
+    // any time, so the cache does not outlive a single locked operation.
+    class PriorityCache {
+    public:
+        explicit PriorityCache(ResourceManagerService* service) : mService(service) {
+            mService->mPriorityCacheEnabled = true;
+        }
+        ~PriorityCache() {
+            mService->mPriorityCacheEnabled = false;
+            mService->mPriorityCache.clear();
+        }
+    private:
+        ResourceManagerService* const mService;
+    };
+
     void removeProcessInfoOverride(int pid);
 
     void removeProcessInfoOverride_l(int pid);
@@ -176,6 +209,9 @@ private:
     sp<SystemCallbackInterface> mSystemCB;
     sp<ServiceLog> mServiceLog;
     PidResourceInfosMap mMap;
+    ResourceIndex mResourceIndex;
+    bool mPriorityCacheEnabled;
+    std::map<int, int> mPriorityCache;
     bool mSupportsMultipleSecureCodecs;
     bool mSupportsSecureWithNonSecureCodec;
     int32_t mCpuBoostCount;
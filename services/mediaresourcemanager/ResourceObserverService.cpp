@@ -109,7 +109,17 @@ std::shared_ptr<ResourceObserverService> ResourceObserverService::instantiate()
 }
 
 ResourceObserverService::ResourceObserverService()
-    : mDeathRecipient(AIBinder_DeathRecipient_new(BinderDiedCallback)) {}
+    : mDeathRecipient(AIBinder_DeathRecipient_new(BinderDiedCallback)),
+      mNotifierThread(&ResourceObserverService::notifierLoop, this) {}
+
+ResourceObserverService::~ResourceObserverService() {
+    {
+        std::scoped_lock lock{mNotificationLock};
+        mStopNotifier = true;
+    }
+    mNotificationCondition.notify_all();
+    mNotifierThread.join();
+}
 
 binder_status_t ResourceObserverService::dump(
         int fd, const char** /*args*/, uint32_t /*numArgs*/) {
@@ -148,6 +158,13 @@ binder_status_t ResourceObserverService::dump(
         }
     }
 
+    {
+        std::scoped_lock lock{mNotificationLock};
+
+        result.appendFormat("  Notifications: %zu pending, %llu delivered\n",
+                mPendingNotifications.size(), (unsigned long long)mDeliveredCount);
+    }
+
     write(fd, result.string(), result.size());
     return OK;
 }
@@ -308,13 +325,69 @@ void ResourceObserverService::notifyObservers(
         }
     }
 
-    // Finally call the observers about the status change.
-    for (auto &calleeInfo : calleeList) {
-        calleeInfo.second.observer->onStatusChanged(
-                event, uid, pid, calleeInfo.second.monitors);
+    if (calleeList.empty()) {
+        return;
+    }
+
+    // Finally queue the status change for the notifier thread to call the observers.
+    {
+        std::scoped_lock lock{mNotificationLock};
+
+        for (auto &calleeInfo : calleeList) {
+            mPendingNotifications.push_back({calleeInfo.first, calleeInfo.second.observer,
+                    event, uid, pid, std::move(calleeInfo.second.monitors)});
+        }
+        mQueuedCount += calleeList.size();
+    }
+    mNotificationCondition.notify_all();
+}
+
+void ResourceObserverService::notifierLoop() {
+    std::unique_lock lock{mNotificationLock};
+    while (true) {
+        mNotificationCondition.wait(lock, [this] {
+            return mStopNotifier || !mPendingNotifications.empty();
+        });
+        if (mPendingNotifications.empty()) {
+            return;
+        }
+
+        // Deliver everything queued since the last wakeup in one batch.
+        std::deque<Notification> batch;
+        batch.swap(mPendingNotifications);
+        lock.unlock();
+
+        {
+            std::scoped_lock observerLock{mObserverLock};
+
+            // Skip the observers unregistered since the notification was queued.
+            for (auto &notification : batch) {
+                if (mObserverInfoMap.find(notification.key) == mObserverInfoMap.end()) {
+                    notification.observer = nullptr;
+                }
+            }
+        }
+        for (auto &notification : batch) {
+            if (notification.observer != nullptr) {
+                notification.observer->onStatusChanged(notification.event,
+                        notification.uid, notification.pid, notification.observables);
+            }
+        }
+
+        lock.lock();
+        mDeliveredCount += batch.size();
+        mNotificationCondition.notify_all();
     }
 }
 
+void ResourceObserverService::flushNotifications() {
+    std::unique_lock lock{mNotificationLock};
+    const uint64_t queuedCount = mQueuedCount;
+    mNotificationCondition.wait(lock, [this, queuedCount] {
+        return mDeliveredCount >= queuedCount;
+    });
+}
+
 void ResourceObserverService::onResourceAdded(
         int uid, int pid, const ResourceList &resources) {
     notifyObservers(MediaObservableEvent::kBusy, uid, pid, resources);
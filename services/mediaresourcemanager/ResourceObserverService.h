@@ -18,7 +18,10 @@
 #ifndef ANDROID_MEDIA_RESOURCE_OBSERVER_SERVICE_H
 #define ANDROID_MEDIA_RESOURCE_OBSERVER_SERVICE_H
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <thread>
 
 #include <aidl/android/media/BnResourceObserverService.h>
 #include "ResourceManagerService.h"
@@ -43,7 +46,7 @@ public:
             int /*fd*/, const char** /*args*/, uint32_t /*numArgs*/);
 
     ResourceObserverService();
-    virtual ~ResourceObserverService() {}
+    virtual ~ResourceObserverService();
 
     // IResourceObserverService interface
     Status registerObserver(const std::shared_ptr<IResourceObserver>& in_observer,
@@ -58,6 +61,9 @@ public:
     // Called by ResourceManagerService when resources are removed.
     void onResourceRemoved(int uid, int pid, const ResourceList &resources);
 
+    // Blocks until the notifications queued before the call have been delivered.
+    void flushNotifications();
+
 private:
     struct ObserverInfo {
         ::ndk::SpAIBinder binder;
@@ -65,6 +71,14 @@ private:
         std::vector<MediaObservableFilter> filters;
     };
     struct DeathRecipient;
+    struct Notification {
+        uintptr_t key;
+        std::shared_ptr<IResourceObserver> observer;
+        MediaObservableEvent event;
+        int uid;
+        int pid;
+        std::vector<MediaObservableParcel> observables;
+    };
 
     // Below maps are all keyed on the observer's binder ptr value.
     using ObserverInfoMap = std::map<uintptr_t, ObserverInfo>;
@@ -87,6 +101,18 @@ private:
 
     void notifyObservers(MediaObservableEvent event,
             int uid, int pid, const ResourceList &resources);
+
+    // Observers are called on mNotifierThread, so that ResourceManagerService doesn't wait
+    // for the binder calls while holding its lock.
+    std::mutex mNotificationLock;
+    std::condition_variable mNotificationCondition;
+    std::deque<Notification> mPendingNotifications GUARDED_BY(mNotificationLock);
+    uint64_t mQueuedCount GUARDED_BY(mNotificationLock) = 0;
+    uint64_t mDeliveredCount GUARDED_BY(mNotificationLock) = 0;
+    bool mStopNotifier GUARDED_BY(mNotificationLock) = false;
+    std::thread mNotifierThread;
+
+    void notifierLoop();
 };
 
 // ----------------------------------------------------------------------------
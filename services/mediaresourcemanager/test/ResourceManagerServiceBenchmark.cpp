@@ -0,0 +1,97 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "ResourceManagerServiceTestUtils.h"
+
+using namespace android;
+
+// A client that agrees to every reclaim but keeps its resources, so the
+// service state is the same on every iteration.
+struct BenchmarkClient : public BnResourceManagerClient {
+    Status reclaimResource(bool* _aidl_return) override {
+        *_aidl_return = true;
+        return Status::ok();
+    }
+
+    Status getName(::std::string* _aidl_return) override {
+        *_aidl_return = "benchmark_client";
+        return Status::ok();
+    }
+};
+
+// |clients| codec clients spread over pids of decreasing priority, as on TV and
+// transcoding devices, each holding a codec and some graphic memory.
+static std::shared_ptr<ResourceManagerService> makeService(size_t clients,
+        std::vector<std::shared_ptr<IResourceManagerClient>> *holders) {
+    std::shared_ptr<ResourceManagerService> service =
+            ::ndk::SharedRefBase::make<ResourceManagerService>(
+                    new TestProcessInfo, new TestSystemCallback());
+    for (size_t i = 0; i < clients; ++i) {
+        std::shared_ptr<IResourceManagerClient> client =
+                ::ndk::SharedRefBase::make<BenchmarkClient>();
+        std::vector<MediaResourceParcel> resources;
+        resources.push_back(MediaResource(MediaResource::Type::kNonSecureCodec,
+                i % 3 == 0 ? MediaResource::SubType::kAudioCodec
+                           : MediaResource::SubType::kVideoCodec, 1));
+        resources.push_back(MediaResource(MediaResource::Type::kGraphicMemory,
+                (int64_t)(100 + i)));
+        // TestProcessInfo uses the pid as priority, lower is higher priority.
+        const int pid = 100 + (int)(i / 4);
+        service->addResource(pid, 10000 + pid, getId(client), client, resources);
+        holders->push_back(client);
+    }
+    return service;
+}
+
+// Selection of the client to reclaim from, by a caller of higher priority than all clients.
+static void BM_ReclaimResource(benchmark::State& state) {
+    std::vector<std::shared_ptr<IResourceManagerClient>> clients;
+    std::shared_ptr<ResourceManagerService> service = makeService(state.range(0), &clients);
+    std::vector<MediaResourceParcel> resources;
+    resources.push_back(MediaResource(MediaResource::Type::kNonSecureCodec,
+            MediaResource::SubType::kVideoCodec, 1));
+    for (auto _ : state) {
+        bool result;
+        service->reclaimResource(kHighPriorityPid, resources, &result);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+// As above, with a secure codec that cannot coexist with others, so that every
+// client of the conflicting type is collected.
+static void BM_ReclaimResourceAllClients(benchmark::State& state) {
+    std::vector<std::shared_ptr<IResourceManagerClient>> clients;
+    std::shared_ptr<ResourceManagerService> service = makeService(state.range(0), &clients);
+    std::vector<MediaResourcePolicyParcel> policies;
+    policies.push_back(MediaResourcePolicy(
+            MediaResourcePolicy::kPolicySupportsSecureWithNonSecureCodec(), "false"));
+    service->config(policies);
+    std::vector<MediaResourceParcel> resources;
+    resources.push_back(MediaResource(MediaResource::Type::kSecureCodec,
+            MediaResource::SubType::kVideoCodec, 1));
+    for (auto _ : state) {
+        bool result;
+        service->reclaimResource(kHighPriorityPid, resources, &result);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_ReclaimResource)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK(BM_ReclaimResourceAllClients)->Arg(8)->Arg(64)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -449,6 +449,51 @@ public:
         EXPECT_EQ(mTestClient1, clients[1]);
     }
 
+    void testResourceIndex() {
+        addResource();
+        const ResourceIndex &index = mService->mResourceIndex;
+        const ResourceIndexKey secureCodec = {MediaResource::Type::kSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType};
+        const ResourceIndexKey nonSecureCodec = {MediaResource::Type::kNonSecureCodec,
+                MediaResource::SubType::kUnspecifiedSubType};
+        const ResourceIndexKey graphicMemory = {MediaResource::Type::kGraphicMemory,
+                MediaResource::SubType::kUnspecifiedSubType};
+        EXPECT_EQ(3u, index.size());
+        EXPECT_EQ(2u, index.at(secureCodec).size());
+        EXPECT_EQ(1u, index.at(secureCodec).at(kTestPid1).count(getId(mTestClient1)));
+        EXPECT_EQ(1u, index.at(secureCodec).at(kTestPid2).count(getId(mTestClient3)));
+        EXPECT_EQ(1u, index.at(nonSecureCodec).size());
+        EXPECT_EQ(2u, index.at(graphicMemory).at(kTestPid2).size());
+
+        // codec resources are indexed by subtype, other resources are not.
+        std::vector<MediaResourceParcel> resources;
+        resources.push_back(createNonSecureVideoCodecResource());
+        resources.push_back(MediaResource(MediaResource::Type::kGraphicMemory,
+                MediaResource::SubType::kVideoCodec, 100));
+        mService->addResource(kTestPid1, kTestUid1, getId(mTestClient1), mTestClient1, resources);
+        EXPECT_EQ(1u, index.count({MediaResource::Type::kNonSecureCodec,
+                MediaResource::SubType::kVideoCodec}));
+        EXPECT_EQ(0u, index.count({MediaResource::Type::kGraphicMemory,
+                MediaResource::SubType::kVideoCodec}));
+
+        // partial removal keeps the client indexed, full removal does not.
+        resources.clear();
+        resources.push_back(MediaResource(MediaResource::Type::kGraphicMemory, 100));
+        mService->removeResource(kTestPid2, getId(mTestClient2), resources);
+        EXPECT_EQ(1u, index.at(graphicMemory).at(kTestPid2).count(getId(mTestClient2)));
+        resources.clear();
+        resources.push_back(MediaResource(MediaResource::Type::kNonSecureCodec, 1));
+        mService->removeResource(kTestPid2, getId(mTestClient2), resources);
+        EXPECT_EQ(0u, index.count(nonSecureCodec));
+
+        mService->removeClient(kTestPid2, getId(mTestClient2));
+        mService->removeClient(kTestPid2, getId(mTestClient3));
+        EXPECT_EQ(1u, index.at(secureCodec).size());
+        EXPECT_EQ(0u, index.at(graphicMemory).count(kTestPid2));
+        mService->removeClient(kTestPid1, getId(mTestClient1));
+        EXPECT_TRUE(index.empty());
+    }
+
     void testReclaimResourceSecure() {
         std::vector<MediaResourceParcel> resources;
         resources.push_back(MediaResource(MediaResource::Type::kSecureCodec, 1));
@@ -1186,6 +1231,10 @@ TEST_F(ResourceManagerServiceTest, removeClient) {
     testRemoveClient();
 }
 
+TEST_F(ResourceManagerServiceTest, resourceIndex) {
+    testResourceIndex();
+}
+
 TEST_F(ResourceManagerServiceTest, reclaimResource) {
     testReclaimResourceSecure();
     testReclaimResourceNonSecure();
@@ -191,6 +191,12 @@ public:
         EXPECT_TRUE(mObserverService->registerObserver(mTestObserver3, filters3).isOk());
     }
 
+    // Pop 1 event of the observer, once the notifications queued so far are delivered.
+    const EventTracker::Event& pop(const std::shared_ptr<TestObserver>& observer) {
+        mObserverService->flushNotifications();
+        return observer->pop();
+    }
+
 protected:
     std::shared_ptr<ResourceObserverService> mObserverService;
     std::shared_ptr<TestObserver> mTestObserver1;
@@ -255,32 +261,32 @@ TEST_F(ResourceObserverServiceTest, testAddResourceBasic) {
     // Add secure video codec.
     resources = {createSecureVideoCodecResource()};
     mService->addResource(kTestPid1, kTestUid1, getId(mTestClient1), mTestClient1, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
 
     // Add non-secure video codec.
     resources = {createNonSecureVideoCodecResource()};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient2), mTestClient2, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
 
     // Add secure & non-secure video codecs.
     resources = {createSecureVideoCodecResource(),
                  createNonSecureVideoCodecResource()};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient3), mTestClient3, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
 
     // Add additional audio codecs, should be ignored.
     resources.push_back(createSecureAudioCodecResource());
     resources.push_back(createNonSecureAudioCodecResource());
     mService->addResource(kTestPid1, kTestUid1, getId(mTestClient1), mTestClient1, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid1, kTestPid1, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid1, kTestPid1, observables3));
 }
 
 TEST_F(ResourceObserverServiceTest, testAddResourceMultiple) {
@@ -304,9 +310,9 @@ TEST_F(ResourceObserverServiceTest, testAddResourceMultiple) {
     observables3 = {{MediaObservableType::kVideoSecureCodec, 2},
                    {MediaObservableType::kVideoNonSecureCodec, 3}};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient3), mTestClient3, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
 }
 
 TEST_F(ResourceObserverServiceTest, testRemoveResourceBasic) {
@@ -322,46 +328,46 @@ TEST_F(ResourceObserverServiceTest, testRemoveResourceBasic) {
     // Add secure video codec to client1.
     resources = {createSecureVideoCodecResource()};
     mService->addResource(kTestPid1, kTestUid1, getId(mTestClient1), mTestClient1, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid1, kTestPid1, observables1));
     // Remove secure video codec. observer 1&3 should receive updates.
     mService->removeResource(kTestPid1, getId(mTestClient1), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Idle(kTestUid1, kTestPid1, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Idle(kTestUid1, kTestPid1, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid1, kTestPid1, observables1));
     // Remove secure video codec again, should have no event.
     mService->removeResource(kTestPid1, getId(mTestClient1), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::NoEvent);
     // Remove client1, should have no event.
     mService->removeClient(kTestPid1, getId(mTestClient1));
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::NoEvent);
 
     // Add non-secure video codec to client2.
     resources = {createNonSecureVideoCodecResource()};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient2), mTestClient2, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
     // Remove client2, observer 2&3 should receive updates.
     mService->removeClient(kTestPid2, getId(mTestClient2));
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
     // Remove non-secure codec after client2 removed, should have no event.
     mService->removeResource(kTestPid2, getId(mTestClient2), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::NoEvent);
     // Remove client2 again, should have no event.
     mService->removeClient(kTestPid2, getId(mTestClient2));
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::NoEvent);
 
     // Add secure & non-secure video codecs, plus audio codecs (that's ignored).
     resources = {createSecureVideoCodecResource(),
@@ -369,28 +375,28 @@ TEST_F(ResourceObserverServiceTest, testRemoveResourceBasic) {
                  createSecureAudioCodecResource(),
                  createNonSecureAudioCodecResource()};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient3), mTestClient3, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
     // Remove one audio codec, should have no event.
     resources = {createSecureAudioCodecResource()};
     mService->removeResource(kTestPid2, getId(mTestClient3), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::NoEvent);
     // Remove the other audio codec and the secure video codec, only secure video codec
     // removal should be reported.
     resources = {createNonSecureAudioCodecResource(),
                  createSecureVideoCodecResource()};
     mService->removeResource(kTestPid2, getId(mTestClient3), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
     // Remove client3 entirely. Non-secure video codec removal should be reported.
     mService->removeClient(kTestPid2, getId(mTestClient3));
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
 }
 
 TEST_F(ResourceObserverServiceTest, testRemoveResourceMultiple) {
@@ -415,9 +421,9 @@ TEST_F(ResourceObserverServiceTest, testRemoveResourceMultiple) {
     observables2 = {{MediaObservableType::kVideoNonSecureCodec, 4}};
     observables3 = {{MediaObservableType::kVideoSecureCodec, 1},
                     {MediaObservableType::kVideoNonSecureCodec, 4}};
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables3));
     // Remove one audio codec, 2 secure video codecs and 2 non-secure video codecs.
     // 1 secure video codec removal and 2 non-secure video codec removals should be reported.
     resources = {createNonSecureAudioCodecResource(),
@@ -429,14 +435,14 @@ TEST_F(ResourceObserverServiceTest, testRemoveResourceMultiple) {
     observables2 = {{MediaObservableType::kVideoNonSecureCodec, 2}};
     observables3 = {{MediaObservableType::kVideoSecureCodec, 1},
                     {MediaObservableType::kVideoNonSecureCodec, 2}};
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables3));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables3));
     // Remove client3 entirely. 2 non-secure video codecs removal should be reported.
     mService->removeClient(kTestPid2, getId(mTestClient3));
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
 }
 
 TEST_F(ResourceObserverServiceTest, testEventFilters) {
@@ -466,15 +472,15 @@ TEST_F(ResourceObserverServiceTest, testEventFilters) {
     resources = {createSecureVideoCodecResource(),
                  createNonSecureVideoCodecResource()};
     mService->addResource(kTestPid2, kTestUid2, getId(mTestClient3), mTestClient3, resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::Busy(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Busy(kTestUid2, kTestPid2, observables2));
 
     // Remove secure & non-secure video codecs.
     mService->removeResource(kTestPid2, getId(mTestClient3), resources);
-    EXPECT_EQ(mTestObserver1->pop(), EventTracker::NoEvent);
-    EXPECT_EQ(mTestObserver2->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
-    EXPECT_EQ(mTestObserver3->pop(), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
+    EXPECT_EQ(pop(mTestObserver1), EventTracker::NoEvent);
+    EXPECT_EQ(pop(mTestObserver2), EventTracker::Idle(kTestUid2, kTestPid2, observables2));
+    EXPECT_EQ(pop(mTestObserver3), EventTracker::Idle(kTestUid2, kTestPid2, observables1));
 }
 
 } // namespace android
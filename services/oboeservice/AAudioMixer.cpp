@@ -20,9 +20,16 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
 #include <utils/Trace.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "AAudioMixer.h"
 
 #ifndef AAUDIO_MIXER_ATRACE_ENABLED
@@ -46,25 +53,83 @@ void AAudioMixer::clear() {
 }
 
 int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool allowUnderflow) {
-    WrappingBuffer wrappingBuffer;
-    float *destination = mOutputBuffer.get();
-
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_BEGIN("aaMix");
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
-    // Gather the data from the client. May be in two parts.
-    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&wrappingBuffer);
+    Source source{std::move(fifo), allowUnderflow};
+    mixSources(&source, 1, streamIndex);
+
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_END();
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+
+    return source.framesRead;
+}
+
+void AAudioMixer::mix(std::vector<Source> &sources) {
 #if AAUDIO_MIXER_ATRACE_ENABLED
-    if (ATRACE_ENABLED()) {
-        char rdyText[] = "aaMixRdy#";
-        char letter = 'A' + (streamIndex % 26);
-        rdyText[sizeof(rdyText) - 2] = letter;
-        ATRACE_INT(rdyText, fullFrames);
+    ATRACE_BEGIN("aaMix");
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+
+    const int32_t numSources = static_cast<int32_t>(sources.size());
+    for (int32_t first = 0; first < numSources; first += kMaxSourcesPerPass) {
+        mixSources(&sources[first], std::min(kMaxSourcesPerPass, numSources - first), first);
     }
+
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_END();
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+}
+
+void AAudioMixer::mixSources(Source *sources, int32_t numSources, int firstStreamIndex) {
+    WrappingBuffer wrappingBuffers[kMaxSourcesPerPass];
+    // Offsets in the output buffer where the data from a source wraps or ends.
+    int32_t edges[2 * kMaxSourcesPerPass];
+    int32_t numEdges = 0;
+
+    // Gather up to one burst of data from each client, in place. May be in two parts.
+    for (int32_t i = 0; i < numSources; i++) {
+        sources[i].framesRead = sources[i].fifo->acquireRead(&wrappingBuffers[i],
+                                                             mFramesPerBurst);
+#if AAUDIO_MIXER_ATRACE_ENABLED
+        if (ATRACE_ENABLED()) {
+            char rdyText[] = "aaMixRdy#";
+            char letter = 'A' + ((firstStreamIndex + i) % 26);
+            rdyText[sizeof(rdyText) - 2] = letter;
+            ATRACE_INT(rdyText, sources[i].framesRead);
+        }
 #else /* MIXER_ATRACE_ENABLED */
-    (void) trackIndex;
+        (void) firstStreamIndex;
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+        edges[numEdges++] = wrappingBuffers[i].numFrames[0];
+        edges[numEdges++] = sources[i].framesRead;
+    }
+    std::sort(edges, edges + numEdges);
+
+    // Between two edges each source has either no data or one contiguous part,
+    // so all of them can be added in one pass over the output.
+    const float *parts[kMaxSourcesPerPass];
+    int32_t start = 0;
+    for (int32_t edgeIndex = 0; edgeIndex < numEdges; edgeIndex++) {
+        const int32_t end = edges[edgeIndex];
+        if (end <= start) {
+            continue;
+        }
+        int32_t numParts = 0;
+        for (int32_t i = 0; i < numSources; i++) {
+            const WrappingBuffer &wrappingBuffer = wrappingBuffers[i];
+            if (start < wrappingBuffer.numFrames[0]) {
+                parts[numParts++] = (const float *) wrappingBuffer.data[0]
+                        + start * mSamplesPerFrame;
+            } else if (start < sources[i].framesRead) {
+                parts[numParts++] = (const float *) wrappingBuffer.data[1]
+                        + (start - wrappingBuffer.numFrames[0]) * mSamplesPerFrame;
+            }
+        }
+        mixPart(mOutputBuffer.get() + start * mSamplesPerFrame, parts, numParts, end - start);
+        start = end;
+    }
 
     // If allowUnderflow then always advance by one burst even if we do not have the data.
     // Otherwise the stream timing will drift whenever there is an underflow.
@@ -72,43 +137,57 @@ int32_t AAudioMixer::mix(int streamIndex, std::shared_ptr<FifoBuffer> fifo, bool
     //
     // Generally, allowUnderflow will be false when stopping a stream and we want to
     // use up whatever data is in the queue.
-    fifo_frames_t framesDesired = mFramesPerBurst;
-    if (!allowUnderflow && fullFrames < framesDesired) {
-        framesDesired = fullFrames; // just use what is available then stop
+    for (int32_t i = 0; i < numSources; i++) {
+        sources[i].fifo->commitRead(sources[i].allowUnderflow
+                                    ? mFramesPerBurst : sources[i].framesRead);
     }
+}
 
-    // Mix data in one or two parts.
-    int partIndex = 0;
-    int32_t framesLeft = framesDesired;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToMixFromPart = framesLeft;
-        fifo_frames_t framesAvailableFromPart = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailableFromPart > 0) {
-            if (framesToMixFromPart > framesAvailableFromPart) {
-                framesToMixFromPart = framesAvailableFromPart;
-            }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
-
-            destination += framesToMixFromPart * mSamplesPerFrame;
-            framesLeft -= framesToMixFromPart;
+namespace {
+
+// Add N sources to the destination, loading and storing the destination only once.
+// The sources are added in order so the result matches mixing them one at a time.
+template <int N>
+void accumulate(float *destination, const float * const *sources, int32_t numSamples) {
+    int32_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; i + 4 <= numSamples; i += 4) {
+        float32x4_t sum = vld1q_f32(destination + i);
+        for (int s = 0; s < N; s++) {
+            sum = vaddq_f32(sum, vld1q_f32(sources[s] + i));
         }
-        partIndex++;
+        vst1q_f32(destination + i, sum);
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 sum = _mm_loadu_ps(destination + i);
+        for (int s = 0; s < N; s++) {
+            sum = _mm_add_ps(sum, _mm_loadu_ps(sources[s] + i));
+        }
+        _mm_storeu_ps(destination + i, sum);
+    }
+#endif
+    for (; i < numSamples; i++) {
+        float sum = destination[i];
+        for (int s = 0; s < N; s++) {
+            sum += sources[s][i];
+        }
+        destination[i] = sum;
     }
-    fifo->advanceReadIndex(framesDesired);
-
-#if AAUDIO_MIXER_ATRACE_ENABLED
-    ATRACE_END();
-#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
-
-    return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+} // namespace
+
+void AAudioMixer::mixPart(float *destination, const float * const *sources, int32_t numSources,
+                          int32_t numFrames) {
+    static_assert(kMaxSourcesPerPass == 4);
+    const int32_t numSamples = numFrames * mSamplesPerFrame;
+    switch (numSources) {
+        case 1: accumulate<1>(destination, sources, numSamples); break;
+        case 2: accumulate<2>(destination, sources, numSamples); break;
+        case 3: accumulate<3>(destination, sources, numSamples); break;
+        case 4: accumulate<4>(destination, sources, numSamples); break;
+        default: break;
     }
 }
 
@@ -17,13 +17,26 @@
 #ifndef AAUDIO_AAUDIO_MIXER_H
 #define AAUDIO_AAUDIO_MIXER_H
 
+#include <memory>
 #include <stdint.h>
+#include <vector>
 
 #include <aaudio/AAudio.h>
 #include <fifo/FifoBuffer.h>
 
 class AAudioMixer {
 public:
+    /**
+     * A FIFO to be mixed by mix(std::vector<Source>&).
+     */
+    struct Source {
+        std::shared_ptr<android::FifoBuffer> fifo;
+        // If true then allow mixer to advance read index past the write index.
+        bool allowUnderflow = true;
+        // Set by the mixer to the frames read from this FIFO.
+        int32_t framesRead = 0;
+    };
+
     AAudioMixer() {}
 
     void allocate(int32_t samplesPerFrame, int32_t framesPerBurst);
@@ -39,12 +52,25 @@ public:
      */
     int32_t mix(int streamIndex, std::shared_ptr<android::FifoBuffer> fifo, bool allowUnderflow);
 
+    /**
+     * Mix one burst from each FIFO.
+     * Up to kMaxSourcesPerPass FIFOs are summed in each pass over the output buffer.
+     * The index of a source in the vector is used to mark its variables in systrace.
+     * @param sources to read from, framesRead is set for each one
+     */
+    void mix(std::vector<Source> &sources);
+
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
+    static constexpr int32_t kMaxSourcesPerPass = 4;
+
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    void mixSources(Source *sources, int32_t numSources, int firstStreamIndex);
+
+    void mixPart(float *destination, const float * const *sources, int32_t numSources,
+                 int32_t numFrames);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
@@ -21,6 +21,7 @@
 #include <assert.h>
 #include <map>
 #include <mutex>
+#include <sstream>
 #include <media/AudioSystem.h>
 #include <utils/Singleton.h>
 
@@ -63,6 +64,14 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+std::string AAudioServiceEndpointPlay::dump() const {
+    std::stringstream result;
+    result << AAudioServiceEndpointShared::dump();
+    result << "    Mix Time per Burst: average = " << mMixTimeNanos.getAverageNanos() / 1000
+           << " us, max = " << mMixTimeNanos.getMaxNanos() / 1000 << " us\n";
+    return result.str();
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
@@ -75,12 +84,13 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
         mMixer.clear();
 
         { // brackets are for lock_guard
-            int index = 0;
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
+            mMixStreams.clear();
+            mMixSources.clear();
+            mMixLocks.clear();
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -97,38 +107,48 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                 sp<AAudioServiceStreamShared> streamShared =
                         static_cast<AAudioServiceStreamShared *>(clientStream.get());
 
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
+                // Lock the AudioFifo to protect against close until it has been mixed.
+                std::unique_lock<std::mutex> fifoLock(streamShared->audioDataQueueLock);
+                std::shared_ptr<SharedRingBuffer> audioDataQueue
+                        = streamShared->getAudioDataQueue_l();
+                std::shared_ptr<FifoBuffer> fifo;
+                if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+                    // Determine offset between framePosition in client's stream
+                    // vs the underlying MMAP stream.
+                    int64_t clientFramesRead = fifo->getReadCounter();
+                    // These two indices refer to the same frame.
+                    int64_t positionOffset = mmapFramesWritten - clientFramesRead;
+                    streamShared->setTimestampPositionOffset(positionOffset);
+
+                    mMixStreams.push_back(streamShared);
+                    mMixSources.push_back({std::move(fifo), allowUnderflow});
+                    mMixLocks.push_back(std::move(fifoLock));
+                }
+            }
+
+            // Mix all the streams, several at a time in each pass over the output.
+            const int64_t mixStartNanos = AudioClock::getNanoseconds();
+            mMixer.mix(mMixSources);
+            mMixTimeNanos.record(AudioClock::getNanoseconds() - mixStartNanos);
+
+            for (size_t i = 0; i < mMixStreams.size(); i++) {
+                const sp<AAudioServiceStreamShared> &streamShared = mMixStreams[i];
+                const AAudioMixer::Source &source = mMixSources[i];
+                int32_t framesMixed = source.framesRead;
+                if (streamShared->isFlowing()) {
+                    // Consider it an underflow if we got less than a burst
+                    // after the data started flowing.
+                    bool underflowed = source.allowUnderflow
+                                       && framesMixed < mMixer.getFramesPerBurst();
+                    if (underflowed) {
+                        streamShared->incrementXRunCount();
                     }
+                } else if (framesMixed > 0) {
+                    // Mark beginning of data flow after a start.
+                    streamShared->setFlowing(true);
                 }
+                int64_t clientFramesRead = source.fifo->getReadCounter();
+                mMixLocks[i].unlock();
 
                 if (clientFramesRead > 0) {
                     // This timestamp represents the completion of data being read out of the
@@ -137,8 +157,6 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                     Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
                     streamShared->markTransferTime(timestamp);
                 }
-
-                index++; // just used for labelling tracks in systrace
             }
         }
 
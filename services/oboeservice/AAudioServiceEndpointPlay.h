@@ -20,6 +20,7 @@
 #include <atomic>
 #include <functional>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "client/AudioStreamInternal.h"
@@ -44,9 +45,46 @@ public:
 
     void *callbackLoop() override;
 
+    std::string dump() const override;
+
 private:
+    /**
+     * Time spent mixing each burst.
+     * Recorded by the mixer thread and read by dump().
+     */
+    class MixTime {
+    public:
+        void record(int64_t nanos) {
+            mTotalNanos += nanos;
+            mCount++;
+            if (nanos > mMaxNanos) {
+                mMaxNanos = nanos;
+            }
+        }
+
+        int64_t getAverageNanos() const {
+            const int64_t count = mCount;
+            return (count == 0) ? 0 : mTotalNanos / count;
+        }
+
+        int64_t getMaxNanos() const {
+            return mMaxNanos;
+        }
+
+    private:
+        std::atomic<int64_t> mTotalNanos{0};
+        std::atomic<int64_t> mCount{0};
+        std::atomic<int64_t> mMaxNanos{0};
+    };
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+    MixTime                  mMixTimeNanos;
+
+    // Used by callbackLoop() for each burst, kept here to avoid reallocating them.
+    std::vector<android::sp<AAudioServiceStreamShared>> mMixStreams;
+    std::vector<AAudioMixer::Source> mMixSources;
+    std::vector<std::unique_lock<std::mutex>> mMixLocks;
 };
 
 } /* namespace aaudio */
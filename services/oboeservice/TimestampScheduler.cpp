@@ -32,9 +32,12 @@ int64_t TimestampScheduler::nextAbsoluteTime() {
     // It starts out sending a timestamp on every period because we want to
     // get an accurate picture when the stream starts. Then it slows down
     // to the occasional timestamps needed to detect a slow drift.
+    // Once the client has had time to estimate the drift of the clock it needs
+    // even fewer, so the last step saves waking up the client so often.
     int64_t minPeriodsToDelay = (periodsElapsed < 10) ? 1 :
         (periodsElapsed < 100) ? 3 :
-        (periodsElapsed < 1000) ? 10 : 50;
+        (periodsElapsed < 1000) ? 10 :
+        (periodsElapsed < 10000) ? 50 : 200;
     int64_t sleepTime = minPeriodsToDelay * mBurstPeriod;
     // Generate a random rectangular distribution one burst wide so that we get
     // an uncorrelated sampling of the MMAP pointer.
@@ -37,6 +37,7 @@ TunerDvr::TunerDvr(shared_ptr<IDvr> dvr, DvrType type) {
 }
 
 TunerDvr::~TunerDvr() {
+    mRecorder = nullptr;
     mDvr = nullptr;
 }
 
@@ -102,6 +103,32 @@ TunerDvr::~TunerDvr() {
     return mDvr->detachFilter(halFilter);
 }
 
+::ndk::ScopedAStatus TunerDvr::setRecordFd(const ::ndk::ScopedFileDescriptor& in_fd) {
+    if (mDvr == nullptr) {
+        ALOGE("IDvr is not initialized");
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNAVAILABLE));
+    }
+
+    if (mType != DvrType::RECORD || in_fd.get() < 0) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::INVALID_ARGUMENT));
+    }
+
+    AidlMQDesc desc;
+    auto status = mDvr->getQueueDesc(&desc);
+    if (!status.isOk()) {
+        return status;
+    }
+
+    mRecorder = TunerDvrRecorder::create(desc, in_fd.get());
+    if (mRecorder == nullptr) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNKNOWN_ERROR));
+    }
+    return ::ndk::ScopedAStatus::ok();
+}
+
 ::ndk::ScopedAStatus TunerDvr::start() {
     if (mDvr == nullptr) {
         ALOGE("IDvr is not initialized");
@@ -109,7 +136,11 @@ TunerDvr::~TunerDvr() {
                 static_cast<int32_t>(Result::UNAVAILABLE));
     }
 
-    return mDvr->start();
+    auto status = mDvr->start();
+    if (status.isOk() && mRecorder != nullptr) {
+        mRecorder->start();
+    }
+    return status;
 }
 
 ::ndk::ScopedAStatus TunerDvr::stop() {
@@ -119,7 +150,11 @@ TunerDvr::~TunerDvr() {
                 static_cast<int32_t>(Result::UNAVAILABLE));
     }
 
-    return mDvr->stop();
+    auto status = mDvr->stop();
+    if (mRecorder != nullptr) {
+        mRecorder->stop();
+    }
+    return status;
 }
 
 ::ndk::ScopedAStatus TunerDvr::flush() {
@@ -139,6 +174,7 @@ TunerDvr::~TunerDvr() {
                 static_cast<int32_t>(Result::UNAVAILABLE));
     }
 
+    mRecorder = nullptr;
     auto status = mDvr->close();
     mDvr = nullptr;
 
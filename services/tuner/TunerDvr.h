@@ -26,6 +26,7 @@
 #include <aidl/android/media/tv/tuner/BnTunerDvr.h>
 #include <aidl/android/media/tv/tuner/ITunerDvrCallback.h>
 
+#include "TunerDvrRecorder.h"
 #include "TunerFilter.h"
 
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
@@ -57,6 +58,7 @@ public:
     ::ndk::ScopedAStatus configure(const DvrSettings& in_settings) override;
     ::ndk::ScopedAStatus attachFilter(const shared_ptr<ITunerFilter>& in_filter) override;
     ::ndk::ScopedAStatus detachFilter(const shared_ptr<ITunerFilter>& in_filter) override;
+    ::ndk::ScopedAStatus setRecordFd(const ::ndk::ScopedFileDescriptor& in_fd) override;
     ::ndk::ScopedAStatus start() override;
     ::ndk::ScopedAStatus stop() override;
     ::ndk::ScopedAStatus flush() override;
@@ -76,6 +78,7 @@ public:
 private:
     shared_ptr<IDvr> mDvr;
     DvrType mType;
+    unique_ptr<TunerDvrRecorder> mRecorder;
 };
 
 }  // namespace tuner
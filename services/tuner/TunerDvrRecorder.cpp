@@ -0,0 +1,203 @@
+/**
+ * Copyright 2022, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "TunerDvrRecorder"
+
+#include "TunerDvrRecorder.h"
+
+#include <aidl/android/hardware/tv/tuner/DemuxQueueNotifyBits.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include <utils/SystemClock.h>
+
+using ::aidl::android::hardware::tv::tuner::DemuxQueueNotifyBits;
+
+namespace aidl {
+namespace android {
+namespace media {
+namespace tv {
+namespace tuner {
+
+// static
+unique_ptr<TunerDvrRecorder> TunerDvrRecorder::create(const AidlMQDesc& desc, int fd) {
+    unique_fd dupFd(dup(fd));
+    if (dupFd.get() < 0) {
+        ALOGE("Failed to dup the record fd: %s", strerror(errno));
+        return nullptr;
+    }
+
+    // The queue was set up by the HAL, so its pointers are not reset here.
+    unique_ptr<AidlMQ> queue = make_unique<AidlMQ>(desc, false /* resetPointers */);
+    if (!queue->isValid()) {
+        ALOGE("Failed to map the DVR queue");
+        return nullptr;
+    }
+
+    EventFlag* eventFlag = nullptr;
+    if (EventFlag::createEventFlag(queue->getEventFlagWord(), &eventFlag) != ::android::OK) {
+        ALOGE("Failed to create the DVR queue event flag");
+        return nullptr;
+    }
+
+    return unique_ptr<TunerDvrRecorder>(
+            new TunerDvrRecorder(std::move(queue), eventFlag, std::move(dupFd)));
+}
+
+TunerDvrRecorder::TunerDvrRecorder(unique_ptr<AidlMQ> queue, EventFlag* eventFlag, unique_fd fd)
+      : mQueue(std::move(queue)),
+        mEventFlag(eventFlag),
+        mFd(std::move(fd)),
+        mStarted(false),
+        mQuit(false),
+        mBytesWritten(0),
+        mWrites(0),
+        mTotalWriteUs(0),
+        mMaxWriteUs(0),
+        mMaxQueued(0),
+        mLastWriteMs(0) {}
+
+TunerDvrRecorder::~TunerDvrRecorder() {
+    stop();
+    EventFlag::deleteEventFlag(&mEventFlag);
+}
+
+void TunerDvrRecorder::start() {
+    lock_guard<mutex> lock(mLock);
+    if (mStarted) {
+        return;
+    }
+    mStarted = true;
+    mQuit = false;
+    mLastWriteMs = ::android::uptimeMillis();
+    mThread = thread([this] { threadLoop(); });
+}
+
+void TunerDvrRecorder::stop() {
+    lock_guard<mutex> lock(mLock);
+    if (!mStarted) {
+        return;
+    }
+    mStarted = false;
+    mQuit = true;
+    // wakes the recording thread, which drains the queue before it exits.
+    mEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY));
+    mThread.join();
+    logStats();
+}
+
+void TunerDvrRecorder::threadLoop() {
+    while (!mQuit) {
+        uint32_t efState = 0;
+        mEventFlag->wait(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY), &efState,
+                         kMaxWriteDelayMs * 1000000 /* timeoutNanoSeconds */, true /* retry */);
+        if (!drain(false /* all */)) {
+            return;  // the recording stops, until stop() and start() again.
+        }
+    }
+    drain(true /* all */);
+}
+
+bool TunerDvrRecorder::drain(bool all) {
+    size_t available = mQueue->availableToRead();
+    if (available > mMaxQueued) {
+        mMaxQueued = available;
+    }
+
+    size_t size = available;
+    if (!all) {
+        if (available < kMinWriteSize
+                && ::android::uptimeMillis() - mLastWriteMs < kMaxWriteDelayMs) {
+            return true;
+        }
+        size -= size % kWriteAlignment;
+    }
+    if (size == 0) {
+        return true;
+    }
+
+    AidlMQ::MemTransaction tx;
+    if (!mQueue->beginRead(size, &tx)) {
+        ALOGE("Failed to begin reading %zu bytes from the DVR queue", size);
+        return false;
+    }
+    bool ok = writeRegions(tx, size);
+    mQueue->commitRead(size);
+    // the HAL may be waiting for room in the queue.
+    mEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED));
+    return ok;
+}
+
+bool TunerDvrRecorder::writeRegions(const AidlMQ::MemTransaction& tx, size_t size) {
+    // the data wraps around the end of the queue in at most two regions.
+    const AidlMQ::MemRegion& first = tx.getFirstRegion();
+    const AidlMQ::MemRegion& second = tx.getSecondRegion();
+    iovec iov[2] = {
+            {first.getAddress(), first.getLength()},
+            {second.getAddress(), second.getLength()},
+    };
+    int iovCount = second.getLength() > 0 ? 2 : 1;
+
+    const int64_t startUs = ::android::elapsedRealtimeNano() / 1000;
+    size_t remaining = size;
+    iovec* next = iov;
+    while (remaining > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(writev(mFd.get(), next, iovCount));
+        if (written < 0) {
+            ALOGE("Failed to write the recording: %s", strerror(errno));
+            return false;
+        }
+        remaining -= written;
+        // skip over what was written, for a partial write.
+        while (iovCount > 0 && (size_t)written >= next->iov_len) {
+            written -= next->iov_len;
+            ++next;
+            --iovCount;
+        }
+        if (iovCount > 0) {
+            next->iov_base = (int8_t*)next->iov_base + written;
+            next->iov_len -= written;
+        }
+    }
+    const int64_t writeUs = ::android::elapsedRealtimeNano() / 1000 - startUs;
+
+    mBytesWritten += size;
+    ++mWrites;
+    mTotalWriteUs += writeUs;
+    if (writeUs > mMaxWriteUs) {
+        mMaxWriteUs = writeUs;
+    }
+    mLastWriteMs = ::android::uptimeMillis();
+    return true;
+}
+
+void TunerDvrRecorder::logStats() {
+    const size_t capacity = mQueue->getQuantumCount();
+    ALOGI("Recorded %lld bytes in %lld writes, write latency avg %lld us max %lld us, "
+          "queue fill max %zu of %zu bytes (%zu%%)",
+          (long long)mBytesWritten, (long long)mWrites,
+          (long long)(mWrites == 0 ? 0 : mTotalWriteUs / mWrites), (long long)mMaxWriteUs,
+          mMaxQueued, capacity, capacity == 0 ? 0 : mMaxQueued * 100 / capacity);
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace media
+}  // namespace android
+}  // namespace aidl
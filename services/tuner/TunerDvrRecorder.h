@@ -0,0 +1,103 @@
+/**
+ * Copyright 2022, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_TUNERDVRRECORDER_H
+#define ANDROID_MEDIA_TUNERDVRRECORDER_H
+
+#include <aidl/android/hardware/common/fmq/MQDescriptor.h>
+#include <aidl/android/hardware/common/fmq/SynchronizedReadWrite.h>
+#include <android-base/unique_fd.h>
+#include <fmq/AidlMessageQueue.h>
+#include <fmq/EventFlag.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using ::aidl::android::hardware::common::fmq::MQDescriptor;
+using ::aidl::android::hardware::common::fmq::SynchronizedReadWrite;
+using ::android::AidlMessageQueue;
+using ::android::base::unique_fd;
+using ::android::hardware::EventFlag;
+
+using namespace std;
+
+namespace aidl {
+namespace android {
+namespace media {
+namespace tv {
+namespace tuner {
+
+using AidlMQDesc = MQDescriptor<int8_t, SynchronizedReadWrite>;
+using AidlMQ = AidlMessageQueue<int8_t, SynchronizedReadWrite>;
+
+/**
+ * Drains the FMQ of a record DVR into a file descriptor from the service, so
+ * that the recording does not need to be read into the client and written
+ * back out. The data is written straight from the shared memory of the queue,
+ * in large page aligned writes while recording, with the tail written on stop.
+ */
+class TunerDvrRecorder {
+public:
+    static unique_ptr<TunerDvrRecorder> create(const AidlMQDesc& desc, int fd);
+    ~TunerDvrRecorder();
+
+    void start();
+    // Writes out what is left in the queue and reports the statistics.
+    void stop();
+
+private:
+    TunerDvrRecorder(unique_ptr<AidlMQ> queue, EventFlag* eventFlag, unique_fd fd);
+
+    void threadLoop();
+    // Writes out the queue, down to a multiple of kWriteAlignment unless |all|.
+    // Returns false on a write error.
+    bool drain(bool all);
+    bool writeRegions(const AidlMQ::MemTransaction& tx, size_t size);
+    void logStats();
+
+    // Writes are at least this large while recording, unless the queue was not
+    // read for kMaxWriteDelayMs.
+    static const size_t kMinWriteSize = 256 * 1024;
+    static const size_t kWriteAlignment = 4096;
+    static const int64_t kMaxWriteDelayMs = 100;
+
+    unique_ptr<AidlMQ> mQueue;
+    EventFlag* mEventFlag;
+    unique_fd mFd;
+
+    mutex mLock;
+    bool mStarted;  // guarded by mLock
+    thread mThread;
+    atomic<bool> mQuit;
+
+    // statistics, only accessed from the recording thread while it runs.
+    int64_t mBytesWritten;
+    int64_t mWrites;
+    int64_t mTotalWriteUs;
+    int64_t mMaxWriteUs;
+    size_t mMaxQueued;
+    int64_t mLastWriteMs;
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace media
+}  // namespace android
+}  // namespace aidl
+
+#endif  // ANDROID_MEDIA_TUNERDVRRECORDER_H
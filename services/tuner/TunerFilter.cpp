@@ -20,6 +20,8 @@
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
 #include <binder/IPCThreadState.h>
+#include <stdio.h>
+#include <utils/SystemClock.h>
 
 #include "TunerHelper.h"
 #include "TunerService.h"
@@ -419,6 +421,25 @@ TunerFilter::~TunerFilter() {
     return mFilter->setDelayHint(in_hint);
 }
 
+::ndk::ScopedAStatus TunerFilter::setEventCoalescing(int32_t in_maxEvents, int32_t in_maxDelayMs) {
+    Mutex::Autolock _l(mLock);
+    if (mFilter == nullptr) {
+        ALOGE("IFilter is not initialized");
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNAVAILABLE));
+    }
+
+    if (in_maxEvents < 0 || in_maxDelayMs < 0) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::INVALID_ARGUMENT));
+    }
+
+    if (mFilterCallback != nullptr) {
+        mFilterCallback->setEventCoalescing(in_maxEvents, in_maxDelayMs);
+    }
+    return ::ndk::ScopedAStatus::ok();
+}
+
 bool TunerFilter::isSharedFilterAllowed(int callingPid) {
     return mShared && mClientPid != callingPid;
 }
@@ -434,6 +455,56 @@ shared_ptr<IFilter> TunerFilter::getHalFilter() {
 }
 
 /////////////// FilterCallback ///////////////////////
+atomic<int64_t> TunerFilter::FilterCallback::sEvents(0);
+atomic<int64_t> TunerFilter::FilterCallback::sCallbacks(0);
+atomic<int64_t> TunerFilter::FilterCallback::sStalls(0);
+
+namespace {
+
+// Media events carry a native handle, which can not be copied; false for those.
+bool copyFilterEvent(const DemuxFilterEvent& event, DemuxFilterEvent* copy) {
+    switch (event.getTag()) {
+    case DemuxFilterEvent::Tag::section:
+        copy->set<DemuxFilterEvent::Tag::section>(event.get<DemuxFilterEvent::Tag::section>());
+        return true;
+    case DemuxFilterEvent::Tag::pes:
+        copy->set<DemuxFilterEvent::Tag::pes>(event.get<DemuxFilterEvent::Tag::pes>());
+        return true;
+    case DemuxFilterEvent::Tag::tsRecord:
+        copy->set<DemuxFilterEvent::Tag::tsRecord>(event.get<DemuxFilterEvent::Tag::tsRecord>());
+        return true;
+    case DemuxFilterEvent::Tag::mmtpRecord:
+        copy->set<DemuxFilterEvent::Tag::mmtpRecord>(
+                event.get<DemuxFilterEvent::Tag::mmtpRecord>());
+        return true;
+    case DemuxFilterEvent::Tag::download:
+        copy->set<DemuxFilterEvent::Tag::download>(event.get<DemuxFilterEvent::Tag::download>());
+        return true;
+    case DemuxFilterEvent::Tag::ipPayload:
+        copy->set<DemuxFilterEvent::Tag::ipPayload>(
+                event.get<DemuxFilterEvent::Tag::ipPayload>());
+        return true;
+    case DemuxFilterEvent::Tag::temi:
+        copy->set<DemuxFilterEvent::Tag::temi>(event.get<DemuxFilterEvent::Tag::temi>());
+        return true;
+    case DemuxFilterEvent::Tag::monitorEvent:
+        copy->set<DemuxFilterEvent::Tag::monitorEvent>(
+                event.get<DemuxFilterEvent::Tag::monitorEvent>());
+        return true;
+    case DemuxFilterEvent::Tag::startId:
+        copy->set<DemuxFilterEvent::Tag::startId>(event.get<DemuxFilterEvent::Tag::startId>());
+        return true;
+    default:
+        return false;
+    }
+}
+
+}  // namespace
+
+TunerFilter::FilterCallback::~FilterCallback() {
+    stopCoalescing();
+}
+
 ::ndk::ScopedAStatus TunerFilter::FilterCallback::onFilterStatus(DemuxFilterStatus status) {
     Mutex::Autolock _l(mCallbackLock);
     if (mTunerFilterCallback != nullptr) {
@@ -444,13 +515,131 @@ shared_ptr<IFilter> TunerFilter::getHalFilter() {
 
 ::ndk::ScopedAStatus TunerFilter::FilterCallback::onFilterEvent(
         const vector<DemuxFilterEvent>& events) {
-    Mutex::Autolock _l(mCallbackLock);
-    if (mTunerFilterCallback != nullptr) {
-        mTunerFilterCallback->onFilterEvent(events);
+    sEvents += events.size();
+    {
+        unique_lock<mutex> lock(mPendingLock);
+        if (mMaxEvents > 0) {
+            vector<DemuxFilterEvent> copies(events.size());
+            bool copied = true;
+            for (size_t i = 0; i < events.size() && copied; i++) {
+                copied = copyFilterEvent(events[i], &copies[i]);
+            }
+            if (copied) {
+                if (mPending.empty()) {
+                    mDeadline = chrono::steady_clock::now() + mMaxDelay;
+                }
+                mPending.insert(mPending.end(), make_move_iterator(copies.begin()),
+                                make_move_iterator(copies.end()));
+                mPendingCondition.notify_all();
+                // The client is behind, hold the HAL back until it catches up.
+                if (mPending.size() >= kMaxPendingBatches * mMaxEvents) {
+                    ++sStalls;
+                    mPendingCondition.wait(lock, [this] {
+                        return mQuit || mPending.size() < kMaxPendingBatches * mMaxEvents;
+                    });
+                }
+                return ::ndk::ScopedAStatus::ok();
+            }
+        }
     }
+    // Not coalesced, the pending events go first to keep the order.
+    deliver(&events);
     return ::ndk::ScopedAStatus::ok();
 }
 
+void TunerFilter::FilterCallback::deliver(const vector<DemuxFilterEvent>* events) {
+    Mutex::Autolock _l(mCallbackLock);
+    vector<DemuxFilterEvent> pending;
+    {
+        lock_guard<mutex> lock(mPendingLock);
+        pending.swap(mPending);
+        mPendingCondition.notify_all();
+    }
+    if (mTunerFilterCallback == nullptr) {
+        return;
+    }
+    if (!pending.empty()) {
+        mTunerFilterCallback->onFilterEvent(pending);
+        ++sCallbacks;
+    }
+    if (events != nullptr) {
+        mTunerFilterCallback->onFilterEvent(*events);
+        ++sCallbacks;
+    }
+}
+
+void TunerFilter::FilterCallback::coalescingLoop() {
+    unique_lock<mutex> lock(mPendingLock);
+    while (!mQuit) {
+        if (mPending.empty()) {
+            mPendingCondition.wait(lock);
+            continue;
+        }
+        if (mPending.size() < mMaxEvents
+                && mPendingCondition.wait_until(lock, mDeadline) == cv_status::no_timeout) {
+            continue;
+        }
+        // mCallbackLock is taken before mPendingLock.
+        lock.unlock();
+        deliver(nullptr);
+        lock.lock();
+    }
+    lock.unlock();
+    deliver(nullptr);
+}
+
+void TunerFilter::FilterCallback::setEventCoalescing(int32_t maxEvents, int32_t maxDelayMs) {
+    stopCoalescing();
+    if (maxEvents == 0 || maxDelayMs == 0) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mPendingLock);
+    mMaxEvents = maxEvents;
+    mMaxDelay = chrono::milliseconds(maxDelayMs);
+    mQuit = false;
+    mThread = thread([this] { coalescingLoop(); });
+}
+
+void TunerFilter::FilterCallback::stopCoalescing() {
+    {
+        lock_guard<mutex> lock(mPendingLock);
+        if (mMaxEvents == 0) {
+            return;
+        }
+        mMaxEvents = 0;
+        mQuit = true;
+        mPendingCondition.notify_all();
+    }
+    // the thread delivers what is pending before it exits.
+    mThread.join();
+}
+
+// static
+void TunerFilter::FilterCallback::dumpStats(int fd) {
+    static mutex sDumpLock;
+    static int64_t sLastDumpMs = 0;
+    static int64_t sLastEvents = 0;
+    static int64_t sLastCallbacks = 0;
+
+    lock_guard<mutex> lock(sDumpLock);
+    const int64_t nowMs = ::android::uptimeMillis();
+    const int64_t events = sEvents;
+    const int64_t callbacks = sCallbacks;
+    const double seconds = sLastDumpMs == 0 ? 0 : (nowMs - sLastDumpMs) / 1000.0;
+    dprintf(fd, "  filter events: %lld in %lld callbacks (%.1f events per callback), "
+            "%lld stalls\n",
+            (long long)events, (long long)callbacks,
+            callbacks == 0 ? 0.0 : (double)events / callbacks, (long long)sStalls.load());
+    if (seconds > 0) {
+        dprintf(fd, "  since last dump: %.1f events/s, %.1f callbacks/s\n",
+                (events - sLastEvents) / seconds, (callbacks - sLastCallbacks) / seconds);
+    }
+    sLastDumpMs = nowMs;
+    sLastEvents = events;
+    sLastCallbacks = callbacks;
+}
+
 void TunerFilter::FilterCallback::sendSharedFilterStatus(int32_t status) {
     Mutex::Autolock _l(mCallbackLock);
     if (mTunerFilterCallback != nullptr && mOriginalCallback != nullptr) {
@@ -474,6 +663,7 @@ void TunerFilter::FilterCallback::detachSharedFilterCallback() {
 }
 
 void TunerFilter::FilterCallback::detachCallbacks() {
+    stopCoalescing();
     Mutex::Autolock _l(mCallbackLock);
     mOriginalCallback = nullptr;
     mTunerFilterCallback = nullptr;
@@ -29,6 +29,12 @@
 #include <aidl/android/media/tv/tuner/ITunerFilterCallback.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using ::aidl::android::hardware::common::NativeHandle;
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
 using ::aidl::android::hardware::common::fmq::SynchronizedReadWrite;
@@ -60,6 +66,7 @@ public:
     public:
         FilterCallback(const shared_ptr<ITunerFilterCallback>& tunerFilterCallback)
               : mTunerFilterCallback(tunerFilterCallback), mOriginalCallback(nullptr){};
+        ~FilterCallback();
 
         ::ndk::ScopedAStatus onFilterEvent(const vector<DemuxFilterEvent>& events) override;
         ::ndk::ScopedAStatus onFilterStatus(DemuxFilterStatus status) override;
@@ -68,11 +75,36 @@ public:
         void attachSharedFilterCallback(const shared_ptr<ITunerFilterCallback>& in_cb);
         void detachSharedFilterCallback();
         void detachCallbacks();
+        void setEventCoalescing(int32_t maxEvents, int32_t maxDelayMs);
+
+        // Event and callback counts of all the filters, for the service dump.
+        static void dumpStats(int fd);
 
     private:
+        // Up to this many batches are pending before the HAL callback waits.
+        static const size_t kMaxPendingBatches = 4;
+
+        void coalescingLoop();
+        // Delivers the pending events, then |events| if not null.
+        void deliver(const vector<DemuxFilterEvent>* events);
+        void stopCoalescing();
+
         shared_ptr<ITunerFilterCallback> mTunerFilterCallback;
         shared_ptr<ITunerFilterCallback> mOriginalCallback;
-        Mutex mCallbackLock;
+        Mutex mCallbackLock;  // held while delivering, which keeps events in order.
+
+        mutex mPendingLock;
+        condition_variable mPendingCondition;
+        vector<DemuxFilterEvent> mPending;
+        chrono::steady_clock::time_point mDeadline;
+        size_t mMaxEvents = 0;
+        chrono::milliseconds mMaxDelay{0};
+        bool mQuit = false;
+        thread mThread;
+
+        static atomic<int64_t> sEvents;
+        static atomic<int64_t> sCallbacks;
+        static atomic<int64_t> sStalls;
     };
 
     TunerFilter(shared_ptr<IFilter> filter, shared_ptr<FilterCallback> cb, DemuxFilterType type);
@@ -98,6 +130,8 @@ public:
     ::ndk::ScopedAStatus freeSharedFilterToken(const string& in_filterToken) override;
     ::ndk::ScopedAStatus getFilterType(DemuxFilterType* _aidl_return) override;
     ::ndk::ScopedAStatus setDelayHint(const FilterDelayHint& in_hint) override;
+    ::ndk::ScopedAStatus setEventCoalescing(int32_t in_maxEvents,
+                                            int32_t in_maxDelayMs) override;
 
     bool isSharedFilterAllowed(int32_t pid);
     void attachSharedFilterCallback(const shared_ptr<ITunerFilterCallback>& in_cb);
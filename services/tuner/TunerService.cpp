@@ -308,6 +308,16 @@ void TunerService::removeSharedFilter(const shared_ptr<TunerFilter>& sharedFilte
     mSharedFilters.erase(to_string(reinterpret_cast<std::uintptr_t>(sharedFilter.get())));
 }
 
+binder_status_t TunerService::dump(int fd, const char** /* args */, uint32_t /* numArgs */) {
+    dprintf(fd, "TunerService: HAL version %d\n", mTunerVersion);
+    {
+        Mutex::Autolock _l(mSharedFiltersLock);
+        dprintf(fd, "  shared filters: %zu\n", mSharedFilters.size());
+    }
+    TunerFilter::FilterCallback::dumpStats(fd);
+    return STATUS_OK;
+}
+
 void TunerService::updateTunerResources() {
     if (!hasITuner()) {
         ALOGE("Failed to updateTunerResources");
@@ -86,6 +86,8 @@ public:
     string addFilterToShared(const shared_ptr<TunerFilter>& sharedFilter);
     void removeSharedFilter(const shared_ptr<TunerFilter>& sharedFilter);
 
+    binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+
     static shared_ptr<TunerService> getTunerService();
 
 private:
@@ -140,6 +140,32 @@ TunerHidlDvr::~TunerHidlDvr() {
     return ::ndk::ScopedAStatus::ok();
 }
 
+::ndk::ScopedAStatus TunerHidlDvr::setRecordFd(const ::ndk::ScopedFileDescriptor& in_fd) {
+    if (mDvr == nullptr) {
+        ALOGE("IDvr is not initialized");
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNAVAILABLE));
+    }
+
+    if (mType != DvrType::RECORD || in_fd.get() < 0) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::INVALID_ARGUMENT));
+    }
+
+    AidlMQDesc desc;
+    auto status = getQueueDesc(&desc);
+    if (!status.isOk()) {
+        return status;
+    }
+
+    mRecorder = TunerDvrRecorder::create(desc, in_fd.get());
+    if (mRecorder == nullptr) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNKNOWN_ERROR));
+    }
+    return ::ndk::ScopedAStatus::ok();
+}
+
 ::ndk::ScopedAStatus TunerHidlDvr::start() {
     if (mDvr == nullptr) {
         ALOGE("IDvr is not initialized");
@@ -151,6 +177,9 @@ TunerHidlDvr::~TunerHidlDvr() {
     if (res != HidlResult::SUCCESS) {
         return ::ndk::ScopedAStatus::fromServiceSpecificError(static_cast<int32_t>(res));
     }
+    if (mRecorder != nullptr) {
+        mRecorder->start();
+    }
     return ::ndk::ScopedAStatus::ok();
 }
 
@@ -162,6 +191,9 @@ TunerHidlDvr::~TunerHidlDvr() {
     }
 
     HidlResult res = mDvr->stop();
+    if (mRecorder != nullptr) {
+        mRecorder->stop();
+    }
     if (res != HidlResult::SUCCESS) {
         return ::ndk::ScopedAStatus::fromServiceSpecificError(static_cast<int32_t>(res));
     }
@@ -189,6 +221,7 @@ TunerHidlDvr::~TunerHidlDvr() {
                 static_cast<int32_t>(Result::UNAVAILABLE));
     }
 
+    mRecorder = nullptr;
     HidlResult res = mDvr->close();
     mDvr = nullptr;
 
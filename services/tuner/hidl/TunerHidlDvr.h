@@ -24,6 +24,7 @@
 #include <android/hardware/tv/tuner/1.0/IDvr.h>
 #include <android/hardware/tv/tuner/1.0/IDvrCallback.h>
 
+#include "TunerDvrRecorder.h"
 #include "TunerHidlFilter.h"
 
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
@@ -59,6 +60,7 @@ public:
     ::ndk::ScopedAStatus configure(const DvrSettings& in_settings) override;
     ::ndk::ScopedAStatus attachFilter(const shared_ptr<ITunerFilter>& in_filter) override;
     ::ndk::ScopedAStatus detachFilter(const shared_ptr<ITunerFilter>& in_filter) override;
+    ::ndk::ScopedAStatus setRecordFd(const ::ndk::ScopedFileDescriptor& in_fd) override;
     ::ndk::ScopedAStatus start() override;
     ::ndk::ScopedAStatus stop() override;
     ::ndk::ScopedAStatus flush() override;
@@ -80,6 +82,7 @@ private:
 
     sp<HidlIDvr> mDvr;
     DvrType mType;
+    unique_ptr<TunerDvrRecorder> mRecorder;
 };
 
 }  // namespace tuner
@@ -188,6 +188,8 @@ public:
     ::ndk::ScopedAStatus freeSharedFilterToken(const string& in_filterToken) override;
     ::ndk::ScopedAStatus getFilterType(DemuxFilterType* _aidl_return) override;
     ::ndk::ScopedAStatus setDelayHint(const FilterDelayHint& in_hint) override;
+    ::ndk::ScopedAStatus setEventCoalescing(int32_t in_maxEvents,
+                                            int32_t in_maxDelayMs) override;
 
     bool isSharedFilterAllowed(int32_t pid);
     void attachSharedFilterCallback(const shared_ptr<ITunerFilterCallback>& in_cb);